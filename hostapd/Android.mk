@@ -137,6 +137,10 @@ NEED_SHA1=y
 OBJS += src/drivers/drivers.c
 L_CFLAGS += -DHOSTAPD
 
+ifdef CONFIG_TESTING_OPTIONS
+OBJS += src/ap/mgmt_replay.c
+endif
+
 ifdef CONFIG_WPA_TRACE
 L_CFLAGS += -DWPA_TRACE
 OBJS += src/utils/trace.c
@@ -157,10 +161,23 @@ ifdef CONFIG_ELOOP_POLL
 L_CFLAGS += -DCONFIG_ELOOP_POLL
 endif
 
+ifdef CONFIG_WPABUF_POOL
+L_CFLAGS += -DCONFIG_WPABUF_POOL
+endif
+
+ifdef CONFIG_MEMSTAT
+L_CFLAGS += -DCONFIG_MEMSTAT
+OBJS += src/utils/memstat.c
+endif
+
 ifdef CONFIG_ELOOP_EPOLL
 L_CFLAGS += -DCONFIG_ELOOP_EPOLL
 endif
 
+ifdef CONFIG_ELOOP_IO_URING
+L_CFLAGS += -DCONFIG_ELOOP_IO_URING
+endif
+
 OBJS += src/utils/common.c
 OBJS += src/utils/wpa_debug.c
 OBJS += src/utils/wpabuf.c
@@ -197,6 +214,7 @@ ifdef CONFIG_NO_ACCOUNTING
 L_CFLAGS += -DCONFIG_NO_ACCOUNTING
 else
 OBJS += src/ap/accounting.c
+OBJS += src/ap/acct_spool.c
 endif
 
 ifdef CONFIG_NO_VLAN
@@ -271,6 +289,18 @@ L_CFLAGS += -DCONFIG_ETH_P_OUI
 OBJS += src/ap/eth_p_oui.c
 endif
 
+ifdef CONFIG_PMKSA_SYNC
+L_CFLAGS += -DCONFIG_PMKSA_SYNC
+OBJS += src/ap/pmksa_sync.c
+NEED_AES_SIV=y
+endif
+
+ifdef CONFIG_STATUS_SHM
+L_CFLAGS += -DCONFIG_STATUS_SHM
+OBJS += src/ap/ap_status_shm.c
+OBJS += src/common/status_shm.c
+endif
+
 ifdef CONFIG_SAE
 L_CFLAGS += -DCONFIG_SAE
 OBJS += src/common/sae.c
@@ -900,6 +930,7 @@ endif
 endif
 SHA1OBJS += src/crypto/sha1-prf.c
 ifdef CONFIG_INTERNAL_SHA1
+L_CFLAGS += -DCONFIG_INTERNAL_SHA1
 SHA1OBJS += src/crypto/sha1-internal.c
 ifdef NEED_FIPS186_2_PRF
 SHA1OBJS += src/crypto/fips_prf_internal.c
@@ -1111,6 +1142,9 @@ endif
 
 ifdef CONFIG_PROXYARP
 L_CFLAGS += -DCONFIG_PROXYARP
+ifdef CONFIG_L2_PACKET_RX_RING
+L_CFLAGS += -DCONFIG_L2_PACKET_RX_RING
+endif
 OBJS += src/ap/x_snoop.c
 OBJS += src/ap/dhcp_snoop.c
 ifdef CONFIG_IPV6
@@ -1138,6 +1172,14 @@ ifdef CONFIG_DEBUG_LINUX_TRACING
 L_CFLAGS += -DCONFIG_DEBUG_LINUX_TRACING
 endif
 
+ifdef CONFIG_DEBUG_RING
+L_CFLAGS += -DCONFIG_DEBUG_RING
+endif
+
+ifdef CONFIG_DEBUG_MIN_LEVEL
+L_CFLAGS += -DWPA_DEBUG_MIN_LEVEL=$(CONFIG_DEBUG_MIN_LEVEL)
+endif
+
 ifdef CONFIG_DEBUG_FILE
 L_CFLAGS += -DCONFIG_DEBUG_FILE
 endif
@@ -42,6 +42,9 @@ extern "C"
 // TOOD(b/71872409): Add unit tests for this.
 namespace {
 constexpr char kConfFileNameFmt[] = "/data/vendor/wifi/hostapd/hostapd_%s.conf";
+// Client connect/disconnect indications are collected for this long before
+// being delivered to the callbacks.
+constexpr unsigned int kClientChangeBatchUsec = 500000;
 
 using android::base::RemoveFileIfExists;
 using android::base::StringPrintf;
@@ -969,6 +972,11 @@ Hostapd::Hostapd(struct hapd_interfaces* interfaces)
 	death_notifier_ = AIBinder_DeathRecipient_new(onDeath);
 }
 
+Hostapd::~Hostapd()
+{
+	eloop_cancel_timeout(flushClientChangesTimeout, this, nullptr);
+}
+
 ::ndk::ScopedAStatus Hostapd::addAccessPoint(
 	const IfaceParams& iface_params, const NetworkParams& nw_params)
 {
@@ -986,6 +994,8 @@ Hostapd::Hostapd(struct hapd_interfaces* interfaces)
 	// Clear the callback to avoid IPCThreadState shutdown during the
 	// callback event.
 	callbacks_.clear();
+	pending_client_changes_.clear();
+	eloop_cancel_timeout(flushClientChangesTimeout, this, nullptr);
 	eloop_terminate();
 	return ndk::ScopedAStatus::ok();
 }
@@ -1163,12 +1173,7 @@ std::vector<uint8_t>  generateRandomOweSsid()
 		info.apIfaceInstance = iface_hapd->conf->iface;
 		info.clientAddress.assign(mac_addr, mac_addr + ETH_ALEN);
 		info.isConnected = authorized;
-		for (const auto &callback : callbacks_) {
-			auto status = callback->onConnectedClientsChanged(info);
-			if (!status.isOk()) {
-				wpa_printf(MSG_ERROR, "Failed to invoke onConnectedClientsChanged");
-			}
-		}
+		queueClientChange(info);
 		};
 
 	// Register for wpa_event which used to get channel switch event
@@ -1181,6 +1186,9 @@ std::vector<uint8_t>  generateRandomOweSsid()
 					strlen(AP_EVENT_ENABLED)) == 0 ||
 			os_strncmp(txt, WPA_EVENT_CHANNEL_SWITCH,
 					strlen(WPA_EVENT_CHANNEL_SWITCH)) == 0) {
+			// Keep client changes ordered with the AP state
+			// indications.
+			flushClientChanges();
 			ApInfo info;
 			info.ifaceName = strlen(iface_hapd->conf->bridge) > 0 ?
 				iface_hapd->conf->bridge : iface_hapd->conf->iface,
@@ -1200,6 +1208,7 @@ std::vector<uint8_t>  generateRandomOweSsid()
 		} else if (os_strncmp(txt, AP_EVENT_DISABLED, strlen(AP_EVENT_DISABLED)) == 0
                            || os_strncmp(txt, INTERFACE_DISABLED, strlen(INTERFACE_DISABLED)) == 0)
 		{
+			flushClientChanges();
 			// Invoke the failure callback on all registered clients.
 			for (const auto& callback : callbacks_) {
 				auto status = callback->onFailure(strlen(iface_hapd->conf->bridge) > 0 ?
@@ -1234,6 +1243,8 @@ std::vector<uint8_t>  generateRandomOweSsid()
 	std::vector<std::string> interfaces;
 	bool is_error = false;
 
+	flushClientChanges();
+
 	const auto it = br_interfaces_.find(iface_name);
 	if (it != br_interfaces_.end()) {
 		// In case bridge, remove managed interfaces
@@ -1319,6 +1330,52 @@ std::vector<uint8_t>  generateRandomOweSsid()
 	return ndk::ScopedAStatus::ok();
 }
 
+void Hostapd::queueClientChange(const ClientInfo& info)
+{
+	// A client that reconnects (or disconnects again) before the pending
+	// change was delivered has not changed its state as far as the
+	// framework is concerned, so the two changes cancel each other out.
+	for (auto it = pending_client_changes_.begin();
+	     it != pending_client_changes_.end(); ++it) {
+		if (it->apIfaceInstance == info.apIfaceInstance &&
+		    it->clientAddress == info.clientAddress) {
+			if (it->isConnected != info.isConnected)
+				pending_client_changes_.erase(it);
+			return;
+		}
+	}
+	pending_client_changes_.push_back(info);
+	if (!eloop_is_timeout_registered(flushClientChangesTimeout, this,
+					 nullptr))
+		eloop_register_timeout(0, kClientChangeBatchUsec,
+				       flushClientChangesTimeout, this,
+				       nullptr);
+}
+
+void Hostapd::flushClientChanges()
+{
+	if (pending_client_changes_.empty())
+		return;
+	eloop_cancel_timeout(flushClientChangesTimeout, this, nullptr);
+	wpa_printf(MSG_DEBUG, "Deliver %zu client change(s)",
+		   pending_client_changes_.size());
+	std::vector<ClientInfo> changes;
+	changes.swap(pending_client_changes_);
+	for (const auto& info : changes) {
+		for (const auto& callback : callbacks_) {
+			auto status = callback->onConnectedClientsChanged(info);
+			if (!status.isOk()) {
+				wpa_printf(MSG_ERROR, "Failed to invoke onConnectedClientsChanged");
+			}
+		}
+	}
+}
+
+void Hostapd::flushClientChangesTimeout(void* eloop_ctx, void* timeout_ctx)
+{
+	static_cast<Hostapd*>(eloop_ctx)->flushClientChanges();
+}
+
 }  // namespace hostapd
 }  // namespace wifi
 }  // namespace hardware
@@ -11,10 +11,12 @@
 
 #include <map>
 #include <string>
+#include <vector>
 
 #include <android-base/macros.h>
 
 #include <aidl/android/hardware/wifi/hostapd/BnHostapd.h>
+#include <aidl/android/hardware/wifi/hostapd/ClientInfo.h>
 
 extern "C"
 {
@@ -41,7 +43,7 @@ class Hostapd : public BnHostapd
 {
 public:
 	Hostapd(hapd_interfaces* interfaces);
-	~Hostapd() override = default;
+	~Hostapd() override;
 
 	// Aidl methods exposed.
 	::ndk::ScopedAStatus addAccessPoint(
@@ -78,6 +80,12 @@ private:
 	    Ieee80211ReasonCode reason_code);
 	::ndk::ScopedAStatus setDebugParamsInternal(DebugLevel level);
 
+	// Batching of client connect/disconnect indications.
+	void queueClientChange(const ClientInfo& info);
+	void flushClientChanges();
+	static void flushClientChangesTimeout(void* eloop_ctx,
+					      void* timeout_ctx);
+
 	// Raw pointer to the global structure maintained by the core.
 	struct hapd_interfaces* interfaces_;
 	// Callbacks registered.
@@ -86,6 +94,8 @@ private:
 	AIBinder_DeathRecipient* death_notifier_;
 	// Bridge and its managed interfaces.
 	std::map<std::string, std::vector<std::string>> br_interfaces_;
+	// Client changes not yet delivered to the callbacks.
+	std::vector<ClientInfo> pending_client_changes_;
 	DISALLOW_COPY_AND_ASSIGN(Hostapd);
 };
 }  // namespace hostapd
@@ -16,7 +16,9 @@
 #include "utils/crc32.h"
 #include "common/ieee802_11_defs.h"
 #include "common/sae.h"
+#include "crypto/crypto.h"
 #include "crypto/sha256.h"
+#include "crypto/ms_funcs.h"
 #include "crypto/tls.h"
 #include "drivers/driver.h"
 #include "eap_server/eap.h"
@@ -115,11 +117,53 @@ static int hostapd_config_read_vlan_file(struct hostapd_bss_config *bss,
 
 	return 0;
 }
+
+
+static int hostapd_config_parse_vlan_precreate(struct hostapd_bss_config *bss,
+					       const char *val)
+{
+	const char *pos = val;
+	char *end;
+	int start, stop, vlan_id;
+
+	os_free(bss->ssid.vlan_precreate);
+	bss->ssid.vlan_precreate = NULL;
+
+	while (*pos) {
+		while (*pos == ' ')
+			pos++;
+		if (*pos == '\0')
+			break;
+		start = strtol(pos, &end, 10);
+		if (end == pos)
+			return -1;
+		stop = start;
+		pos = end;
+		if (*pos == '-') {
+			pos++;
+			stop = strtol(pos, &end, 10);
+			if (end == pos)
+				return -1;
+			pos = end;
+		}
+		if ((*pos != ' ' && *pos != '\0') || start < 1 ||
+		    stop > MAX_VLAN_ID || start > stop)
+			return -1;
+		for (vlan_id = start; vlan_id <= stop; vlan_id++) {
+			int_array_add_unique(&bss->ssid.vlan_precreate,
+					     vlan_id);
+			if (!bss->ssid.vlan_precreate)
+				return -1;
+		}
+	}
+
+	return 0;
+}
 #endif /* CONFIG_NO_VLAN */
 
 
-static int hostapd_config_read_maclist(const char *fname,
-				       struct mac_acl_entry **acl, int *num)
+int hostapd_config_read_maclist(const char *fname,
+				struct mac_acl_entry **acl, int *num)
 {
 	FILE *f;
 	char buf[128], *pos;
@@ -248,6 +292,19 @@ static int hostapd_config_eap_user_salted(struct hostapd_eap_user *user,
 }
 
 
+#ifdef EAP_SERVER_MSCHAPV2
+/* Cache NtPasswordHash so that it is not derived for each authentication */
+static void hostapd_config_eap_user_nt_hash(struct hostapd_eap_user *user)
+{
+	if (!user->password || user->password_hash || user->salt)
+		return;
+	if (nt_password_hash(user->password, user->password_len,
+			     user->nt_hash) == 0)
+		user->nt_hash_set = 1;
+}
+#endif /* EAP_SERVER_MSCHAPV2 */
+
+
 static int hostapd_config_read_eap_user(const char *fname,
 					struct hostapd_bss_config *conf)
 {
@@ -550,6 +607,9 @@ static int hostapd_config_read_eap_user(const char *fname,
 		}
 
 	done:
+#ifdef EAP_SERVER_MSCHAPV2
+		hostapd_config_eap_user_nt_hash(user);
+#endif /* EAP_SERVER_MSCHAPV2 */
 		if (tail == NULL) {
 			tail = new_user = user;
 		} else {
@@ -568,8 +628,10 @@ static int hostapd_config_read_eap_user(const char *fname,
 	fclose(f);
 
 	if (ret == 0) {
+		hostapd_eap_user_index_free(conf);
 		hostapd_config_free_eap_users(conf->eap_user);
 		conf->eap_user = new_user;
+		hostapd_eap_user_index_update(conf);
 	} else {
 		hostapd_config_free_eap_users(new_user);
 	}
@@ -972,6 +1034,7 @@ static int add_r0kh(struct hostapd_bss_config *bss, char *value)
 
 	r0kh->next = bss->r0kh_list;
 	bss->r0kh_list = r0kh;
+	bss->rxkh_gen++;
 
 	return 0;
 }
@@ -1017,6 +1080,7 @@ static int add_r1kh(struct hostapd_bss_config *bss, char *value)
 
 	r1kh->next = bss->r1kh_list;
 	bss->r1kh_list = r1kh;
+	bss->rxkh_gen++;
 
 	return 0;
 }
@@ -2550,6 +2614,16 @@ static int hostapd_config_fill(struct hostapd_config *conf,
 			return 1;
 		}
 		bss->macaddr_acl = acl;
+	} else if (os_strcmp(buf, "radius_acl_cache_size") == 0) {
+		int val = atoi(pos);
+
+		if (val < 1) {
+			wpa_printf(MSG_ERROR,
+				   "Line %d: invalid radius_acl_cache_size %d",
+				   line, val);
+			return 1;
+		}
+		bss->radius_acl_cache_size = val;
 	} else if (os_strcmp(buf, "accept_mac_file") == 0) {
 		if (hostapd_config_read_maclist(pos, &bss->accept_mac,
 						&bss->num_accept_mac)) {
@@ -2572,6 +2646,26 @@ static int hostapd_config_fill(struct hostapd_config *conf,
 		bss->isolate = atoi(pos);
 	} else if (os_strcmp(buf, "ap_max_inactivity") == 0) {
 		bss->ap_max_inactivity = atoi(pos);
+	} else if (os_strcmp(buf, "ap_inactivity_slack") == 0) {
+		int val = atoi(pos);
+
+		if (val < 0) {
+			wpa_printf(MSG_ERROR,
+				   "Line %d: invalid ap_inactivity_slack %d",
+				   line, val);
+			return 1;
+		}
+		bss->ap_inactivity_slack = val;
+	} else if (os_strcmp(buf, "sta_stats_interval") == 0) {
+		int val = atoi(pos);
+
+		if (val < 0) {
+			wpa_printf(MSG_ERROR,
+				   "Line %d: invalid sta_stats_interval %d",
+				   line, val);
+			return 1;
+		}
+		bss->sta_stats_interval = val;
 	} else if (os_strcmp(buf, "skip_inactivity_poll") == 0) {
 		bss->skip_inactivity_poll = atoi(pos);
 	} else if (os_strcmp(buf, "bss_max_idle") == 0) {
@@ -2679,6 +2773,11 @@ static int hostapd_config_fill(struct hostapd_config *conf,
 		bss->crl_reload_interval = atoi(pos);
 	} else if (os_strcmp(buf, "tls_session_lifetime") == 0) {
 		bss->tls_session_lifetime = atoi(pos);
+	} else if (os_strcmp(buf, "tls_session_cache_size") == 0) {
+		bss->tls_session_cache_size = atoi(pos);
+	} else if (os_strcmp(buf, "tls_session_ticket_keys") == 0) {
+		os_free(bss->tls_session_ticket_keys);
+		bss->tls_session_ticket_keys = os_strdup(pos);
 	} else if (os_strcmp(buf, "tls_flags") == 0) {
 		bss->tls_flags = parse_tls_flags(pos);
 	} else if (os_strcmp(buf, "max_auth_rounds") == 0) {
@@ -2915,6 +3014,17 @@ static int hostapd_config_fill(struct hostapd_config *conf,
 		os_free(bss->radius->auth_server->shared_secret);
 		bss->radius->auth_server->shared_secret = (u8 *) os_strdup(pos);
 		bss->radius->auth_server->shared_secret_len = len;
+	} else if (bss->radius->auth_server &&
+		   os_strcmp(buf, "auth_server_weight") == 0) {
+		int val = atoi(pos);
+
+		if (val < 1) {
+			wpa_printf(MSG_ERROR,
+				   "Line %d: invalid auth_server_weight %d",
+				   line, val);
+			return 1;
+		}
+		bss->radius->auth_server->weight = val;
 	} else if (bss->radius->auth_server &&
 		   os_strcmp(buf, "auth_server_type") == 0) {
 		if (os_strcmp(pos, "UDP") == 0) {
@@ -3013,11 +3123,85 @@ static int hostapd_config_fill(struct hostapd_config *conf,
 #endif /* CONFIG_RADIUS_TLS */
 	} else if (os_strcmp(buf, "radius_retry_primary_interval") == 0) {
 		bss->radius->retry_primary_interval = atoi(pos);
+	} else if (os_strcmp(buf, "radius_auth_sockets") == 0) {
+		int val = atoi(pos);
+
+		if (val < 1 || val > RADIUS_CLIENT_MAX_AUTH_SOCKS) {
+			wpa_printf(MSG_ERROR,
+				   "Line %d: invalid radius_auth_sockets %d (allowed range 1..%d)",
+				   line, val, RADIUS_CLIENT_MAX_AUTH_SOCKS);
+			return 1;
+		}
+		bss->radius->num_auth_socks = val;
+	} else if (os_strcmp(buf, "radius_max_pending") == 0) {
+		int val = atoi(pos);
+
+		if (val < 1) {
+			wpa_printf(MSG_ERROR,
+				   "Line %d: invalid radius_max_pending %d",
+				   line, val);
+			return 1;
+		}
+		bss->radius->max_pending = val;
+	} else if (os_strcmp(buf, "radius_auth_load_balance") == 0) {
+		int val = atoi(pos);
+
+		if (val < RADIUS_AUTH_LB_FAILOVER ||
+		    val > RADIUS_AUTH_LB_LEAST_PENDING) {
+			wpa_printf(MSG_ERROR,
+				   "Line %d: invalid radius_auth_load_balance %d",
+				   line, val);
+			return 1;
+		}
+		bss->radius->auth_load_balance = val;
 	} else if (os_strcmp(buf,
 			     "radius_require_message_authenticator") == 0) {
 		bss->radius_require_message_authenticator = atoi(pos);
 	} else if (os_strcmp(buf, "radius_acct_interim_interval") == 0) {
 		bss->acct_interim_interval = atoi(pos);
+	} else if (os_strcmp(buf, "radius_acct_interim_jitter") == 0) {
+		int val = atoi(pos);
+
+		if (val < 0) {
+			wpa_printf(MSG_ERROR,
+				   "Line %d: invalid radius_acct_interim_jitter %d",
+				   line, val);
+			return 1;
+		}
+		bss->acct_interim_jitter = val;
+	} else if (os_strcmp(buf, "radius_acct_interim_slack") == 0) {
+		int val = atoi(pos);
+
+		if (val < 0) {
+			wpa_printf(MSG_ERROR,
+				   "Line %d: invalid radius_acct_interim_slack %d",
+				   line, val);
+			return 1;
+		}
+		bss->acct_interim_slack = val;
+	} else if (os_strcmp(buf, "radius_acct_spool_file") == 0) {
+		os_free(bss->acct_spool_file);
+		bss->acct_spool_file = os_strdup(pos);
+	} else if (os_strcmp(buf, "radius_acct_spool_max") == 0) {
+		int val = atoi(pos);
+
+		if (val < 1) {
+			wpa_printf(MSG_ERROR,
+				   "Line %d: invalid radius_acct_spool_max %d",
+				   line, val);
+			return 1;
+		}
+		bss->acct_spool_max = val;
+	} else if (os_strcmp(buf, "radius_acct_spool_rate") == 0) {
+		int val = atoi(pos);
+
+		if (val < 1 || val > 1000) {
+			wpa_printf(MSG_ERROR,
+				   "Line %d: invalid radius_acct_spool_rate %d",
+				   line, val);
+			return 1;
+		}
+		bss->acct_spool_rate = val;
 	} else if (os_strcmp(buf, "radius_request_cui") == 0) {
 		bss->radius_request_cui = atoi(pos);
 	} else if (os_strcmp(buf, "radius_auth_req_attr") == 0) {
@@ -3127,6 +3311,8 @@ static int hostapd_config_fill(struct hostapd_config *conf,
 			return 1;
 		}
 		bss->wpa_group_update_count = (u32) val;
+	} else if (os_strcmp(buf, "wpa_group_update_rate") == 0) {
+		bss->wpa_group_update_rate = atoi(pos);
 	} else if (os_strcmp(buf, "wpa_pairwise_update_count") == 0) {
 		char *endp;
 		unsigned long val = strtoul(pos, &endp, 0);
@@ -3177,6 +3363,14 @@ static int hostapd_config_fill(struct hostapd_config *conf,
 				   line);
 			return 1;
 		}
+	} else if (os_strcmp(buf, "wpa_psk_cache") == 0) {
+		os_free(bss->ssid.wpa_psk_cache);
+		bss->ssid.wpa_psk_cache = os_strdup(pos);
+		if (!bss->ssid.wpa_psk_cache) {
+			wpa_printf(MSG_ERROR, "Line %d: allocation failed",
+				   line);
+			return 1;
+		}
 	} else if (os_strcmp(buf, "wpa_key_mgmt") == 0) {
 		bss->wpa_key_mgmt = hostapd_config_parse_key_mgmt(line, pos);
 		if (bss->wpa_key_mgmt == -1)
@@ -3338,11 +3532,20 @@ static int hostapd_config_fill(struct hostapd_config *conf,
 		}
 	} else if (os_strcmp(buf, "pmk_r1_push") == 0) {
 		bss->pmk_r1_push = atoi(pos);
+	} else if (os_strcmp(buf, "pmk_r1_push_count") == 0) {
+		bss->pmk_r1_push_count = atoi(pos);
+	} else if (os_strcmp(buf, "pmk_r1_push_batch") == 0) {
+		bss->pmk_r1_push_batch = atoi(pos);
 	} else if (os_strcmp(buf, "ft_over_ds") == 0) {
 		bss->ft_over_ds = atoi(pos);
 	} else if (os_strcmp(buf, "ft_psk_generate_local") == 0) {
 		bss->ft_psk_generate_local = atoi(pos);
 #endif /* CONFIG_IEEE80211R_AP */
+#ifdef CONFIG_STATUS_SHM
+	} else if (os_strcmp(buf, "status_shm_dir") == 0) {
+		os_free(bss->status_shm_dir);
+		bss->status_shm_dir = os_strdup(pos);
+#endif /* CONFIG_STATUS_SHM */
 #ifndef CONFIG_NO_CTRL_IFACE
 	} else if (os_strcmp(buf, "ctrl_interface") == 0) {
 		os_free(bss->ctrl_interface);
@@ -3384,6 +3587,16 @@ static int hostapd_config_fill(struct hostapd_config *conf,
 		bss->radius_server_acct_port = atoi(pos);
 	} else if (os_strcmp(buf, "radius_server_ipv6") == 0) {
 		bss->radius_server_ipv6 = atoi(pos);
+	} else if (os_strcmp(buf, "radius_server_workers") == 0) {
+		int val = atoi(pos);
+
+		if (val < 0 || val > 64) {
+			wpa_printf(MSG_ERROR,
+				   "Line %d: invalid radius_server_workers %d (allowed range 0..64)",
+				   line, val);
+			return 1;
+		}
+		bss->radius_server_workers = val;
 #endif /* RADIUS_SERVER */
 	} else if (os_strcmp(buf, "use_pae_group_addr") == 0) {
 		bss->use_pae_group_addr = atoi(pos);
@@ -3460,6 +3673,18 @@ static int hostapd_config_fill(struct hostapd_config *conf,
 		conf->acs_exclude_6ghz_non_psc = atoi(pos);
 	} else if (os_strcmp(buf, "enable_background_radar") == 0) {
 		conf->enable_background_radar = atoi(pos);
+	} else if (os_strcmp(buf, "background_radar_precac") == 0) {
+		int val = atoi(pos);
+
+		if (val < 0 || val > HOSTAPD_DFS_MAX_PRECAC) {
+			wpa_printf(MSG_ERROR,
+				   "Line %d: invalid background_radar_precac value %d",
+				   line, val);
+			return 1;
+		}
+		conf->background_radar_precac = val;
+	} else if (os_strcmp(buf, "background_radar_precac_lifetime") == 0) {
+		conf->background_radar_precac_lifetime = atoi(pos);
 	} else if (os_strcmp(buf, "min_tx_power") == 0) {
 		int val = atoi(pos);
 
@@ -3499,6 +3724,21 @@ static int hostapd_config_fill(struct hostapd_config *conf,
 				   line);
 			return -1;
 		}
+	} else if (os_strcmp(buf, "acs_model_file") == 0) {
+		os_free(conf->acs_model_file);
+		conf->acs_model_file = os_strdup(pos);
+	} else if (os_strcmp(buf, "acs_reeval_interval") == 0) {
+		conf->acs_reeval_interval = atoi(pos);
+	} else if (os_strcmp(buf, "acs_reeval_threshold") == 0) {
+		int val = atoi(pos);
+
+		if (val < 0 || val > 1000) {
+			wpa_printf(MSG_ERROR,
+				   "Line %d: invalid acs_reeval_threshold %d (expected 0..1000)",
+				   line, val);
+			return 1;
+		}
+		conf->acs_reeval_threshold = val;
 #endif /* CONFIG_ACS */
 	} else if (os_strcmp(buf, "dtim_period") == 0) {
 		int val = atoi(pos);
@@ -3556,6 +3796,8 @@ static int hostapd_config_fill(struct hostapd_config *conf,
 			return 1;
 		}
 		bss->send_probe_response = val;
+	} else if (os_strcmp(buf, "probe_req_ssid_filter") == 0) {
+		bss->probe_req_ssid_filter = atoi(pos);
 	} else if (os_strcmp(buf, "supported_rates") == 0) {
 		if (hostapd_parse_intlist(&conf->supported_rates, pos)) {
 			wpa_printf(MSG_ERROR, "Line %d: invalid rate list",
@@ -3661,6 +3903,23 @@ static int hostapd_config_fill(struct hostapd_config *conf,
 				   line, bss->ssid.vlan_naming);
 			return 1;
 		}
+	} else if (os_strcmp(buf, "vlan_teardown_delay") == 0) {
+		int val = atoi(pos);
+
+		if (val < 0 || val > 3600) {
+			wpa_printf(MSG_ERROR,
+				   "Line %d: invalid vlan_teardown_delay %d",
+				   line, val);
+			return 1;
+		}
+		bss->ssid.vlan_teardown_delay = val;
+	} else if (os_strcmp(buf, "vlan_precreate") == 0) {
+		if (hostapd_config_parse_vlan_precreate(bss, pos)) {
+			wpa_printf(MSG_ERROR,
+				   "Line %d: invalid vlan_precreate '%s'",
+				   line, pos);
+			return 1;
+		}
 #ifdef CONFIG_FULL_DYNAMIC_VLAN
 	} else if (os_strcmp(buf, "vlan_tagged_interface") == 0) {
 		os_free(bss->ssid.vlan_tagged_interface);
@@ -3971,6 +4230,39 @@ static int hostapd_config_fill(struct hostapd_config *conf,
 		bss->disable_pmksa_caching = atoi(pos);
 	} else if (os_strcmp(buf, "okc") == 0) {
 		bss->okc = atoi(pos);
+	} else if (os_strcmp(buf, "pmksa_cache_size") == 0) {
+		int val = atoi(pos);
+
+		if (val <= 0) {
+			wpa_printf(MSG_ERROR,
+				   "Line %d: invalid pmksa_cache_size %d",
+				   line, val);
+			return 1;
+		}
+		bss->pmksa_cache_size = val;
+	} else if (os_strcmp(buf, "pmksa_cache_shared") == 0) {
+		bss->pmksa_cache_shared = atoi(pos);
+#ifdef CONFIG_PMKSA_SYNC
+	} else if (os_strcmp(buf, "pmksa_sync_port") == 0) {
+		bss->pmksa_sync_port = atoi(pos);
+	} else if (os_strcmp(buf, "pmksa_sync_addr") == 0) {
+		if (hostapd_parse_ip_addr(pos, &bss->pmksa_sync_addr) ||
+		    bss->pmksa_sync_addr.af != AF_INET) {
+			wpa_printf(MSG_ERROR,
+				   "Line %d: invalid IPv4 address '%s'",
+				   line, pos);
+			return 1;
+		}
+	} else if (os_strcmp(buf, "pmksa_sync_key") == 0) {
+		if (os_strlen(pos) != 2 * sizeof(bss->pmksa_sync_key) ||
+		    hexstr2bin(pos, bss->pmksa_sync_key,
+			       sizeof(bss->pmksa_sync_key))) {
+			wpa_printf(MSG_ERROR, "Line %d: Invalid pmksa_sync_key",
+				   line);
+			return 1;
+		}
+		bss->pmksa_sync_key_set = true;
+#endif /* CONFIG_PMKSA_SYNC */
 #ifdef CONFIG_WPS
 	} else if (os_strcmp(buf, "wps_state") == 0) {
 		bss->wps_state = atoi(pos);
@@ -4063,6 +4355,26 @@ static int hostapd_config_fill(struct hostapd_config *conf,
 		bss->wps_cred_processing = atoi(pos);
 	} else if (os_strcmp(buf, "wps_cred_add_sae") == 0) {
 		bss->wps_cred_add_sae = atoi(pos);
+	} else if (os_strcmp(buf, "wps_dh_pool_size") == 0) {
+		int val = atoi(pos);
+
+		if (val < 0 || val > 64) {
+			wpa_printf(MSG_ERROR,
+				   "Line %d: invalid wps_dh_pool_size %d",
+				   line, val);
+			return 1;
+		}
+		bss->wps_dh_pool_size = val;
+	} else if (os_strcmp(buf, "wps_max_sessions_per_sec") == 0) {
+		int val = atoi(pos);
+
+		if (val < 0) {
+			wpa_printf(MSG_ERROR,
+				   "Line %d: invalid wps_max_sessions_per_sec %d",
+				   line, val);
+			return 1;
+		}
+		bss->wps_max_sessions_per_sec = val;
 	} else if (os_strcmp(buf, "ap_settings") == 0) {
 		os_free(bss->ap_settings);
 		bss->ap_settings =
@@ -4649,6 +4961,16 @@ static int hostapd_config_fill(struct hostapd_config *conf,
 	} else if (os_strcmp(buf, "sae_anti_clogging_threshold") == 0 ||
 		   os_strcmp(buf, "anti_clogging_threshold") == 0) {
 		bss->anti_clogging_threshold = atoi(pos);
+	} else if (os_strcmp(buf, "sae_cpu_budget") == 0) {
+		int val = atoi(pos);
+
+		if (val < 0 || val > 1000) {
+			wpa_printf(MSG_ERROR,
+				   "Line %d: Invalid sae_cpu_budget value %d",
+				   line, val);
+			return 1;
+		}
+		bss->sae_cpu_budget = val;
 	} else if (os_strcmp(buf, "sae_sync") == 0) {
 		bss->sae_sync = atoi(pos);
 	} else if (os_strcmp(buf, "sae_groups") == 0) {
@@ -4986,6 +5308,32 @@ static int hostapd_config_fill(struct hostapd_config *conf,
 			return 1;
 		}
 #endif /* CONFIG_AIRTIME_POLICY */
+#ifdef CONFIG_STEERING
+	} else if (os_strcmp(buf, "steering_chan_util") == 0) {
+		int val = atoi(pos);
+
+		if (val < 0 || val > 255) {
+			wpa_printf(MSG_ERROR,
+				   "Line %d: Invalid steering_chan_util (must be 0..255)",
+				   line);
+			return 1;
+		}
+		conf->steering_chan_util = val;
+	} else if (os_strcmp(buf, "steering_min_rssi") == 0) {
+		conf->steering_min_rssi = atoi(pos);
+	} else if (os_strcmp(buf, "steering_interval") == 0) {
+		int val = atoi(pos);
+
+		if (val <= 0) {
+			wpa_printf(MSG_ERROR,
+				   "Line %d: Invalid steering_interval (must be positive)",
+				   line);
+			return 1;
+		}
+		conf->steering_interval = val;
+	} else if (os_strcmp(buf, "steering_backoff") == 0) {
+		conf->steering_backoff = atoi(pos);
+#endif /* CONFIG_STEERING */
 #ifdef CONFIG_MACSEC
 	} else if (os_strcmp(buf, "macsec_policy") == 0) {
 		int macsec_policy = atoi(pos);
@@ -5115,6 +5463,16 @@ static int hostapd_config_fill(struct hostapd_config *conf,
 		bss->pasn_comeback_after = atoi(pos);
 	} else if (os_strcmp(buf, "pasn_noauth") == 0) {
 		bss->pasn_noauth = atoi(pos);
+	} else if (os_strcmp(buf, "ptksa_cache_size") == 0) {
+		int val = atoi(pos);
+
+		if (val <= 0) {
+			wpa_printf(MSG_ERROR,
+				   "Line %d: invalid ptksa_cache_size %d",
+				   line, val);
+			return 1;
+		}
+		bss->ptksa_cache_size = val;
 #endif /* CONFIG_PASN */
 	} else if (os_strcmp(buf, "ext_capa_mask") == 0) {
 		if (get_hex_config(bss->ext_capa_mask, EXT_CAPA_MAX_LEN,
@@ -5198,6 +5556,71 @@ static int hostapd_config_fill(struct hostapd_config *conf,
  * @fname: Configuration file name (including path, if needed)
  * Returns: Allocated configuration data structure
  */
+static const char * const hostapd_config_psk_fields[] = {
+	"wpa_passphrase", "wpa_psk", "wpa_psk_file", "sae_password",
+	"sae_password_file", NULL
+};
+
+static const char * const hostapd_config_beacon_fields[] = {
+	"vendor_elements", "assocresp_elements", "ignore_broadcast_ssid",
+	"dtim_period", NULL
+};
+
+
+static bool hostapd_config_field_in(const char * const *fields,
+				    const char *name)
+{
+	for (; *fields; fields++) {
+		if (os_strcmp(*fields, name) == 0)
+			return true;
+	}
+	return false;
+}
+
+
+/*
+ * Add a configuration line to the digest of its class. The contents of files
+ * named with *_file parameters are included so that changes to them are noticed
+ * even if the file name stays the same.
+ */
+static void hostapd_config_digest_line(struct hostapd_bss_config *bss,
+				       const char *name, const char *value)
+{
+	enum hostapd_config_class class = HOSTAPD_CONFIG_CLASS_FULL;
+	u8 prev[HOSTAPD_CONFIG_DIGEST_LEN];
+	const u8 *addr[5];
+	size_t len[5], name_len;
+	char *file = NULL;
+	size_t file_len = 0;
+
+	if (os_strcmp(name, "config_id") == 0)
+		return;
+
+	if (hostapd_config_field_in(hostapd_config_psk_fields, name))
+		class = HOSTAPD_CONFIG_CLASS_PSK;
+	else if (hostapd_config_field_in(hostapd_config_beacon_fields, name))
+		class = HOSTAPD_CONFIG_CLASS_BEACON;
+
+	name_len = os_strlen(name);
+	if (name_len > 5 && os_strcmp(name + name_len - 5, "_file") == 0)
+		file = os_readfile(value, &file_len);
+
+	os_memcpy(prev, bss->config_digest[class], sizeof(prev));
+	addr[0] = prev;
+	len[0] = sizeof(prev);
+	addr[1] = (const u8 *) name;
+	len[1] = name_len + 1;
+	addr[2] = (const u8 *) value;
+	len[2] = os_strlen(value) + 1;
+	addr[3] = (const u8 *) &file_len;
+	len[3] = sizeof(file_len);
+	addr[4] = (const u8 *) file;
+	len[4] = file_len;
+	sha256_vector(file ? 5 : 4, addr, len, bss->config_digest[class]);
+	bin_clear_free(file, file_len);
+}
+
+
 struct hostapd_config * hostapd_config_read(const char *fname)
 {
 	struct hostapd_config *conf;
@@ -5260,12 +5683,15 @@ struct hostapd_config * hostapd_config_read(const char *fname)
 		*pos = '\0';
 		pos++;
 		errors += hostapd_config_fill(conf, bss, buf, pos, line);
+		hostapd_config_digest_line(conf->last_bss, buf, pos);
 	}
 
 	fclose(f);
 
-	for (i = 0; i < conf->num_bss; i++)
+	for (i = 0; i < conf->num_bss; i++) {
+		conf->bss[i]->config_digest_set = true;
 		hostapd_set_security_params(conf->bss[i], 1);
+	}
 
 	if (hostapd_config_check(conf, 1))
 		errors++;
@@ -10,6 +10,8 @@
 #define CONFIG_FILE_H
 
 struct hostapd_config * hostapd_config_read(const char *fname);
+int hostapd_config_read_maclist(const char *fname,
+				struct mac_acl_entry **acl, int *num);
 int hostapd_config_read_rxkh_file(struct hostapd_bss_config *conf,
 				  const char *fname);
 int hostapd_set_iface(struct hostapd_config *conf,
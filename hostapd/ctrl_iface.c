@@ -29,6 +29,7 @@
 
 #include "utils/common.h"
 #include "utils/eloop.h"
+#include "utils/memstat.h"
 #include "utils/module_tests.h"
 #include "common/version.h"
 #include "common/ieee802_11_defs.h"
@@ -56,6 +57,7 @@
 #include "ap/wps_hostapd.h"
 #include "ap/ctrl_iface_ap.h"
 #include "ap/ap_drv_ops.h"
+#include "ap/authsrv.h"
 #include "ap/hs20.h"
 #include "ap/wnm_ap.h"
 #include "ap/wpa_auth.h"
@@ -65,6 +67,9 @@
 #include "ap/dpp_hostapd.h"
 #include "ap/dfs.h"
 #include "ap/nan_usd_ap.h"
+#include "ap/steering.h"
+#include "ap/gas_serv.h"
+#include "ap/mgmt_replay.h"
 #include "wps/wps_defs.h"
 #include "wps/wps.h"
 #include "fst/fst_ctrl_iface.h"
@@ -1305,6 +1310,10 @@ static int hostapd_ctrl_iface_set(struct hostapd_data *hapd, char *cmd)
 		if (ret)
 			return ret;
 
+#ifdef CONFIG_INTERWORKING
+		gas_serv_anqp_cache_flush(hapd);
+#endif /* CONFIG_INTERWORKING */
+
 		if (os_strcasecmp(cmd, "deny_mac_file") == 0) {
 			hostapd_disassoc_deny_mac(hapd);
 		} else if (os_strcasecmp(cmd, "accept_mac_file") == 0) {
@@ -1421,42 +1430,6 @@ static int hostapd_ctrl_iface_disable(struct hostapd_iface *iface)
 }
 
 
-static int
-hostapd_ctrl_iface_kick_mismatch_psk_sta_iter(struct hostapd_data *hapd,
-					      struct sta_info *sta, void *ctx)
-{
-	struct hostapd_wpa_psk *psk;
-	const u8 *pmk;
-	int pmk_len;
-	int pmk_match;
-	int sta_match;
-	int bss_match;
-	int reason;
-
-	pmk = wpa_auth_get_pmk(sta->wpa_sm, &pmk_len);
-
-	for (psk = hapd->conf->ssid.wpa_psk; pmk && psk; psk = psk->next) {
-		pmk_match = PMK_LEN == pmk_len &&
-			os_memcmp(psk->psk, pmk, pmk_len) == 0;
-		sta_match = psk->group == 0 &&
-			ether_addr_equal(sta->addr, psk->addr);
-		bss_match = psk->group == 1;
-
-		if (pmk_match && (sta_match || bss_match))
-			return 0;
-	}
-
-	wpa_printf(MSG_INFO, "STA " MACSTR
-		   " PSK/passphrase no longer valid - disconnect",
-		   MAC2STR(sta->addr));
-	reason = WLAN_REASON_PREV_AUTH_NOT_VALID;
-	hostapd_drv_sta_deauth(hapd, sta->addr, reason);
-	ap_sta_deauthenticate(hapd, sta, reason);
-
-	return 0;
-}
-
-
 static int hostapd_ctrl_iface_reload_wpa_psk(struct hostapd_data *hapd)
 {
 	struct hostapd_bss_config *conf = hapd->conf;
@@ -1471,8 +1444,7 @@ static int hostapd_ctrl_iface_reload_wpa_psk(struct hostapd_data *hapd)
 		return -1;
 	}
 
-	ap_for_each_sta(hapd, hostapd_ctrl_iface_kick_mismatch_psk_sta_iter,
-			NULL);
+	hostapd_kick_mismatch_psk_stas(hapd);
 
 	return 0;
 }
@@ -4035,6 +4007,41 @@ fail:
 #endif /* CONFIG_NAN_USD */
 
 
+static int hostapd_ctrl_iface_acl_replace(struct mac_acl_entry **acl,
+					  int *num, const char *fname)
+{
+	struct mac_acl_entry *new_acl = NULL;
+	int new_num = 0;
+
+	/* Keep the current list if the new one cannot be read completely */
+	if (hostapd_config_read_maclist(fname, &new_acl, &new_num) < 0) {
+		os_free(new_acl);
+		return -1;
+	}
+
+	wpa_printf(MSG_DEBUG, "CTRL: Replace MAC ACL (%d -> %d entries)",
+		   *num, new_num);
+	os_free(*acl);
+	*acl = new_acl;
+	*num = new_num;
+	return 0;
+}
+
+
+
+static int hostapd_ctrl_iface_eloop_stats(const char *cmd)
+{
+	/* START [<slow handler threshold in msec>] or STOP */
+	if (os_strncmp(cmd, "START", 5) == 0 &&
+	    (cmd[5] == '\0' || cmd[5] == ' '))
+		return eloop_stats_enable(atoi(cmd + 5) * 1000);
+	if (os_strcmp(cmd, "STOP") == 0) {
+		eloop_stats_disable();
+		return 0;
+	}
+	return -1;
+}
+
 static int hostapd_ctrl_iface_receive_process(struct hostapd_data *hapd,
 					      char *buf, char *reply,
 					      int reply_size,
@@ -4052,8 +4059,16 @@ static int hostapd_ctrl_iface_receive_process(struct hostapd_data *hapd,
 	} else if (os_strncmp(buf, "RELOG", 5) == 0) {
 		if (wpa_debug_reopen_file() < 0)
 			reply_len = -1;
+	} else if (os_strcmp(buf, "LOG_RING_DUMP") == 0) {
+		if (wpa_debug_ring_dump() < 0)
+			reply_len = -1;
 	} else if (os_strcmp(buf, "CLOSE_LOG") == 0) {
 		wpa_debug_stop_log();
+	} else if (os_strcmp(buf, "ELOOP_STATS") == 0) {
+		reply_len = eloop_stats_get(reply, reply_size);
+	} else if (os_strncmp(buf, "ELOOP_STATS ", 12) == 0) {
+		if (hostapd_ctrl_iface_eloop_stats(buf + 12) < 0)
+			reply_len = -1;
 	} else if (os_strncmp(buf, "NOTE ", 5) == 0) {
 		wpa_printf(MSG_INFO, "NOTE: %s", buf + 5);
 	} else if (os_strcmp(buf, "STATUS") == 0) {
@@ -4102,6 +4117,12 @@ static int hostapd_ctrl_iface_receive_process(struct hostapd_data *hapd,
 	} else if (os_strncmp(buf, "STA-NEXT ", 9) == 0) {
 		reply_len = hostapd_ctrl_iface_sta_next(hapd, buf + 9, reply,
 							reply_size);
+	} else if (os_strcmp(buf, "STA-DUMP") == 0) {
+		reply_len = hostapd_ctrl_iface_sta_dump(hapd, NULL, reply,
+							reply_size);
+	} else if (os_strncmp(buf, "STA-DUMP ", 9) == 0) {
+		reply_len = hostapd_ctrl_iface_sta_dump(hapd, buf + 9, reply,
+							reply_size);
 	} else if (os_strcmp(buf, "ATTACH") == 0) {
 		if (hostapd_ctrl_iface_attach(hapd, from, fromlen, NULL))
 			reply_len = -1;
@@ -4210,6 +4231,13 @@ static int hostapd_ctrl_iface_receive_process(struct hostapd_data *hapd,
 		if (hostapd_ctrl_iface_coloc_intf_req(hapd, buf + 15))
 			reply_len = -1;
 #endif /* CONFIG_WNM_AP */
+#ifdef CONFIG_STEERING
+	} else if (os_strcmp(buf, "STEERING_STATUS") == 0) {
+		reply_len = steering_ctrl_status(hapd, reply, reply_size);
+	} else if (os_strncmp(buf, "STEER_STA ", 10) == 0) {
+		if (steering_ctrl_steer_sta(hapd, buf + 10))
+			reply_len = -1;
+#endif /* CONFIG_STEERING */
 	} else if (os_strcmp(buf, "GET_CONFIG") == 0) {
 		reply_len = hostapd_ctrl_iface_get_config(hapd, reply,
 							  reply_size);
@@ -4225,6 +4253,12 @@ static int hostapd_ctrl_iface_receive_process(struct hostapd_data *hapd,
 	} else if (os_strcmp(buf, "RELOAD_WPA_PSK") == 0) {
 		if (hostapd_ctrl_iface_reload_wpa_psk(hapd))
 			reply_len = -1;
+	} else if (os_strcmp(buf, "RELOAD_TLS_TICKET_KEYS") == 0) {
+		if (authsrv_reload_ticket_keys(hapd))
+			reply_len = -1;
+	} else if (os_strncmp(buf, "SET_TLS_TICKET_KEYS ", 20) == 0) {
+		if (authsrv_set_ticket_keys(hapd, buf + 20))
+			reply_len = -1;
 #ifdef CONFIG_IEEE80211R_AP
 	} else if (os_strcmp(buf, "GET_RXKHS") == 0) {
 		reply_len = hostapd_ctrl_iface_get_rxkhs(hapd, reply,
@@ -4239,6 +4273,9 @@ static int hostapd_ctrl_iface_receive_process(struct hostapd_data *hapd,
 	} else if (os_strcmp(buf, "RELOAD_CONFIG") == 0) {
 		if (hostapd_reload_config(hapd->iface))
 			reply_len = -1;
+	} else if (os_strcmp(buf, "APPLY_CONFIG") == 0) {
+		reply_len = hostapd_apply_config(hapd->iface, reply,
+						 reply_size);
 	} else if (os_strcmp(buf, "RELOAD") == 0) {
 		if (hostapd_ctrl_iface_reload(hapd->iface))
 			reply_len = -1;
@@ -4262,6 +4299,9 @@ static int hostapd_ctrl_iface_receive_process(struct hostapd_data *hapd,
 	} else if (os_strncmp(buf, "MGMT_RX_PROCESS ", 16) == 0) {
 		if (hostapd_ctrl_iface_mgmt_rx_process(hapd, buf + 16) < 0)
 			reply_len = -1;
+	} else if (os_strncmp(buf, "MGMT_REPLAY ", 12) == 0) {
+		reply_len = hostapd_mgmt_replay(hapd, buf + 12, reply,
+						reply_size);
 	} else if (os_strncmp(buf, "EAPOL_RX ", 9) == 0) {
 		if (hostapd_ctrl_iface_eapol_rx(hapd, buf + 9) < 0)
 			reply_len = -1;
@@ -4356,6 +4396,10 @@ static int hostapd_ctrl_iface_receive_process(struct hostapd_data *hapd,
 	} else if (os_strcmp(buf, "PMKSA") == 0) {
 		reply_len = hostapd_ctrl_iface_pmksa_list(hapd, reply,
 							  reply_size);
+#ifdef CONFIG_MEMSTAT
+	} else if (os_strcmp(buf, "MEMSTAT") == 0) {
+		reply_len = memstat_print(reply, reply_size);
+#endif /* CONFIG_MEMSTAT */
 	} else if (os_strcmp(buf, "PMKSA_FLUSH") == 0) {
 		hostapd_ctrl_iface_pmksa_flush(hapd);
 	} else if (os_strncmp(buf, "PMKSA_ADD ", 10) == 0) {
@@ -4404,6 +4448,13 @@ static int hostapd_ctrl_iface_receive_process(struct hostapd_data *hapd,
 			    hostapd_set_acl(hapd) ||
 			    hostapd_disassoc_accept_mac(hapd))
 				reply_len = -1;
+		} else if (os_strncmp(buf + 11, "REPLACE ", 8) == 0) {
+			if (hostapd_ctrl_iface_acl_replace(
+				    &hapd->conf->accept_mac,
+				    &hapd->conf->num_accept_mac, buf + 19) ||
+			    hostapd_set_acl(hapd) ||
+			    hostapd_disassoc_accept_mac(hapd))
+				reply_len = -1;
 		} else if (os_strcmp(buf + 11, "SHOW") == 0) {
 			reply_len = hostapd_ctrl_iface_acl_show_mac(
 				hapd->conf->accept_mac,
@@ -4432,6 +4483,13 @@ static int hostapd_ctrl_iface_receive_process(struct hostapd_data *hapd,
 				    &hapd->conf->num_deny_mac, buf + 17) ||
 			    hostapd_set_acl(hapd))
 				reply_len = -1;
+		} else if (os_strncmp(buf + 9, "REPLACE ", 8) == 0) {
+			if (hostapd_ctrl_iface_acl_replace(
+				    &hapd->conf->deny_mac,
+				    &hapd->conf->num_deny_mac, buf + 17) ||
+			    hostapd_set_acl(hapd) ||
+			    hostapd_disassoc_deny_mac(hapd))
+				reply_len = -1;
 		} else if (os_strcmp(buf + 9, "SHOW") == 0) {
 			reply_len = hostapd_ctrl_iface_acl_show_mac(
 				hapd->conf->deny_mac,
@@ -4572,6 +4630,9 @@ static int hostapd_ctrl_iface_receive_process(struct hostapd_data *hapd,
 			reply_len = -1;
 	} else if (os_strcmp(buf, "DPP_CONTROLLER_STOP") == 0) {
 		dpp_controller_stop(hapd->iface->interfaces->dpp);
+	} else if (os_strcmp(buf, "DPP_CONTROLLER_STATS") == 0) {
+		reply_len = dpp_controller_get_stats(
+			hapd->iface->interfaces->dpp, reply, reply_size);
 	} else if (os_strncmp(buf, "DPP_CHIRP ", 10) == 0) {
 		if (hostapd_dpp_chirp(hapd, buf + 9) < 0)
 			reply_len = -1;
@@ -4611,6 +4672,8 @@ static int hostapd_ctrl_iface_receive_process(struct hostapd_data *hapd,
 	} else if (os_strncmp(buf, "NAN_TRANSMIT ", 13) == 0) {
 		if (hostapd_ctrl_nan_transmit(hapd, buf + 13) < 0)
 			reply_len = -1;
+	} else if (os_strcmp(buf, "NAN_STATS") == 0) {
+		reply_len = hostapd_nan_usd_stats(hapd, reply, reply_size);
 #endif /* CONFIG_NAN_USD */
 #ifdef RADIUS_SERVER
 	} else if (os_strncmp(buf, "DAC_REQUEST ", 12) == 0) {
@@ -4623,7 +4686,15 @@ static int hostapd_ctrl_iface_receive_process(struct hostapd_data *hapd,
 #ifdef CONFIG_PASN
 	} else if (os_strcmp(buf, "PTKSA_CACHE_LIST") == 0) {
 		reply_len = ptksa_cache_list(hapd->ptksa, reply, reply_size);
+	} else if (os_strcmp(buf, "PTKSA_CACHE_STATS") == 0) {
+		reply_len = ptksa_cache_stats(hapd->ptksa, reply, reply_size);
+	} else if (os_strcmp(buf, "PASN_STATS") == 0) {
+		reply_len = hostapd_pasn_stats(hapd, reply, reply_size);
 #endif /* CONFIG_PASN */
+#ifdef CONFIG_SAE
+	} else if (os_strcmp(buf, "SAE_STATS") == 0) {
+		reply_len = hostapd_sae_stats(hapd, reply, reply_size);
+#endif /* CONFIG_SAE */
 #ifdef ANDROID
 	} else if (os_strncmp(buf, "DRIVER ", 7) == 0) {
 		reply_len = hostapd_ctrl_iface_driver_cmd(hapd, buf + 7, reply,
@@ -4725,7 +4796,10 @@ static void hostapd_ctrl_iface_receive(int sock, void *eloop_ctx,
 
 	if (os_strcmp(pos, "PING") == 0)
 		level = MSG_EXCESSIVE;
-	wpa_hexdump_ascii(level, "RX ctrl_iface", pos, res);
+	if (os_strncmp(pos, "SET_TLS_TICKET_KEYS ", 20) == 0)
+		wpa_hexdump_ascii_key(level, "RX ctrl_iface", pos, res);
+	else
+		wpa_hexdump_ascii(level, "RX ctrl_iface", pos, res);
 
 	reply_len = hostapd_ctrl_iface_receive_process(hapd, pos,
 						       reply, reply_size,
@@ -5834,6 +5908,9 @@ static void hostapd_global_ctrl_iface_receive(int sock, void *eloop_ctx,
 	} else if (os_strncmp(buf, "RELOG", 5) == 0) {
 		if (wpa_debug_reopen_file() < 0)
 			reply_len = -1;
+	} else if (os_strcmp(buf, "LOG_RING_DUMP") == 0) {
+		if (wpa_debug_ring_dump() < 0)
+			reply_len = -1;
 	} else if (os_strcmp(buf, "FLUSH") == 0) {
 		hostapd_ctrl_iface_flush(interfaces);
 	} else if (os_strncmp(buf, "ADD ", 4) == 0) {
@@ -6169,14 +6246,15 @@ void hostapd_global_ctrl_iface_deinit(struct hapd_interfaces *interfaces)
 
 
 static int hostapd_ctrl_check_event_enabled(struct wpa_ctrl_dst *dst,
-					    const char *buf)
+					    const char *buf, size_t len)
 {
 	/* Enable Probe Request events based on explicit request.
 	 * Other events are enabled by default.
 	 */
-	if (str_starts(buf, RX_PROBE_REQUEST))
-		return !!(dst->events & WPA_EVENT_RX_PROBE_REQUEST);
-	return 1;
+	if (str_starts(buf, RX_PROBE_REQUEST) &&
+	    !(dst->events & WPA_EVENT_RX_PROBE_REQUEST))
+		return 0;
+	return ctrl_iface_event_wanted(dst, buf, len);
 }
 
 
@@ -6221,7 +6299,7 @@ static void hostapd_ctrl_iface_send_internal(int sock, struct dl_list *ctrl_dst,
 	idx = 0;
 	dl_list_for_each_safe(dst, next, ctrl_dst, struct wpa_ctrl_dst, list) {
 		if ((level >= dst->debug_level) &&
-		     hostapd_ctrl_check_event_enabled(dst, buf)) {
+		     hostapd_ctrl_check_event_enabled(dst, buf, len)) {
 			sockaddr_print(MSG_DEBUG, "CTRL_IFACE monitor send",
 				       &dst->addr, dst->addrlen);
 			msg.msg_name = &dst->addr;
@@ -10,9 +10,431 @@
 
 #include "utils/common.h"
 #include "utils/module_tests.h"
+#include "ap/ap_config.h"
+#ifdef CONFIG_TAXONOMY
+#include "ap/hostapd.h"
+#include "ap/sta_info.h"
+#include "ap/taxonomy.h"
+#endif /* CONFIG_TAXONOMY */
+#ifdef CONFIG_TESTING_OPTIONS
+#include "ap/mgmt_replay.h"
+#endif /* CONFIG_TESTING_OPTIONS */
+
+
+static int wpa_psk_index_tests(void)
+{
+	struct hostapd_bss_config *conf;
+	struct hostapd_wpa_psk *psk;
+	const u8 sta[ETH_ALEN] = { 0x02, 0x00, 0x00, 0x00, 0x00, 0x01 };
+	const u8 other[ETH_ALEN] = { 0x02, 0x00, 0x00, 0x00, 0x00, 0x02 };
+	const u8 *found[10], *pos;
+	unsigned int i, num, num_idx;
+	int ret = -1, vlan_id;
+
+	wpa_printf(MSG_INFO, "WPA PSK index tests");
+
+	conf = os_zalloc(sizeof(*conf));
+	if (!conf)
+		return -1;
+
+	/* Six wildcard and two per-STA entries, one of which is for another
+	 * STA */
+	for (i = 0; i < 8; i++) {
+		psk = os_zalloc(sizeof(*psk));
+		if (!psk)
+			goto fail;
+		os_memset(psk->psk, i + 1, PMK_LEN);
+		psk->vlan_id = i + 1;
+		if (i == 2)
+			os_memcpy(psk->addr, sta, ETH_ALEN);
+		else if (i == 5)
+			os_memcpy(psk->addr, other, ETH_ALEN);
+		else
+			psk->group = 1;
+		psk->next = conf->ssid.wpa_psk;
+		conf->ssid.wpa_psk = psk;
+	}
+
+	/* Without the index */
+	num = 0;
+	for (pos = NULL; num < ARRAY_SIZE(found); found[num++] = pos) {
+		pos = hostapd_get_psk(conf, sta, NULL, pos, NULL);
+		if (!pos)
+			break;
+	}
+	if (num != 7) {
+		wpa_printf(MSG_ERROR, "Unexpected number of PSKs: %u", num);
+		goto fail;
+	}
+
+	if (hostapd_wpa_psk_index_update(&conf->ssid) < 0 ||
+	    !conf->ssid.wpa_psk_index)
+		goto fail;
+
+	/* Per-STA entry first, then all wildcard entries */
+	num_idx = 0;
+	for (pos = NULL; num_idx < ARRAY_SIZE(found); num_idx++) {
+		pos = hostapd_get_psk(conf, sta, NULL, pos, &vlan_id);
+		if (!pos)
+			break;
+		if (num_idx == 0 && (pos[0] != 3 || vlan_id != 3)) {
+			wpa_printf(MSG_ERROR, "Per-STA PSK not returned first");
+			goto fail;
+		}
+		if (pos[0] == 6) {
+			wpa_printf(MSG_ERROR, "PSK for another STA returned");
+			goto fail;
+		}
+	}
+	if (num_idx != num) {
+		wpa_printf(MSG_ERROR, "Unexpected number of indexed PSKs: %u",
+			   num_idx);
+		goto fail;
+	}
+
+	/* The last matching PSK is tried first on the next association */
+	for (psk = conf->ssid.wpa_psk; psk; psk = psk->next) {
+		if (psk->psk[0] == 1)
+			break;
+	}
+	hostapd_psk_matched(conf, sta, psk->psk);
+	pos = hostapd_get_psk(conf, sta, NULL, NULL, NULL);
+	if (pos != psk->psk) {
+		wpa_printf(MSG_ERROR, "Last matching PSK not returned first");
+		goto fail;
+	}
+	num_idx = 1;
+	while ((pos = hostapd_get_psk(conf, sta, NULL, pos, NULL))) {
+		if (pos == psk->psk) {
+			wpa_printf(MSG_ERROR, "Last matching PSK repeated");
+			goto fail;
+		}
+		num_idx++;
+	}
+	if (num_idx != num) {
+		wpa_printf(MSG_ERROR,
+			   "Unexpected number of PSKs after match: %u",
+			   num_idx);
+		goto fail;
+	}
+
+	/* Continue from an entry other than the latest returned one */
+	pos = hostapd_get_psk(conf, sta, NULL, found[3], NULL);
+	if (!pos || hostapd_get_psk(conf, other, NULL, NULL, NULL)[0] != 6) {
+		wpa_printf(MSG_ERROR, "Unexpected PSK iteration result");
+		goto fail;
+	}
+
+	ret = 0;
+fail:
+	hostapd_config_clear_wpa_psk(&conf->ssid.wpa_psk);
+	hostapd_wpa_psk_index_free(&conf->ssid);
+	os_free(conf);
+	return ret;
+}
+
+
+static int eap_user_index_tests(void)
+{
+	struct hostapd_bss_config *conf;
+	struct hostapd_eap_user *user, **tail, *entry[8], *expected[2][8];
+	const struct {
+		const char *identity;
+		int phase2;
+		bool prefix;
+	} users[] = {
+		{ "alice", 0, false },
+		{ "bob", 0, true },
+		{ "bobby", 0, false }, /* shadowed by the prefix entry */
+		{ "alice", 1, false },
+		{ "alice", 0, false }, /* duplicate */
+		{ NULL, 0, false },
+		{ "carol", 0, false }, /* shadowed by the wildcard entry */
+		{ "carol", 1, false },
+	};
+	const char *ids[] = {
+		"alice", "bob", "bobby", "bo", "carol", "dave", "", "alic"
+	};
+	unsigned int i, phase2;
+	int ret = -1;
+
+	wpa_printf(MSG_INFO, "EAP user index tests");
+
+	conf = os_zalloc(sizeof(*conf));
+	if (!conf)
+		return -1;
+
+	tail = &conf->eap_user;
+	for (i = 0; i < ARRAY_SIZE(users); i++) {
+		user = os_zalloc(sizeof(*user));
+		if (!user)
+			goto fail;
+		*tail = user;
+		tail = &user->next;
+		entry[i] = user;
+		if (users[i].identity) {
+			user->identity_len = os_strlen(users[i].identity);
+			user->identity = os_memdup(users[i].identity,
+						   user->identity_len);
+			if (!user->identity)
+				goto fail;
+		}
+		user->phase2 = users[i].phase2;
+		user->wildcard_prefix = users[i].prefix;
+	}
+
+	/* Without the index */
+	for (phase2 = 0; phase2 < 2; phase2++) {
+		for (i = 0; i < ARRAY_SIZE(ids); i++)
+			expected[phase2][i] = hostapd_config_get_eap_user(
+				conf, (const u8 *) ids[i], os_strlen(ids[i]),
+				phase2);
+	}
+	if (expected[0][0] != entry[0] || expected[0][2] != entry[1] ||
+	    expected[0][4] != entry[5] || expected[1][4] != entry[7] ||
+	    expected[1][5]) {
+		wpa_printf(MSG_ERROR, "Unexpected EAP user list match");
+		goto fail;
+	}
+
+	if (hostapd_eap_user_index_update(conf) < 0 || !conf->eap_user_index)
+		goto fail;
+
+	/* The same first matching entry as from the list */
+	for (phase2 = 0; phase2 < 2; phase2++) {
+		for (i = 0; i < ARRAY_SIZE(ids); i++) {
+			if (hostapd_config_get_eap_user(
+				    conf, (const u8 *) ids[i],
+				    os_strlen(ids[i]), phase2) ==
+			    expected[phase2][i])
+				continue;
+			wpa_printf(MSG_ERROR,
+				   "Indexed EAP user mismatch for '%s' phase2=%u",
+				   ids[i], phase2);
+			goto fail;
+		}
+	}
+
+	ret = 0;
+fail:
+	hostapd_eap_user_index_free(conf);
+	hostapd_config_free_eap_users(conf->eap_user);
+	os_free(conf);
+	return ret;
+}
+
+
+static int acl_maclist_tests(void)
+{
+	struct mac_acl_entry *acl = NULL;
+	struct vlan_description vlan_id;
+	u8 addr[ETH_ALEN] = { 0x02, 0x00, 0x00, 0x00, 0x00, 0x00 };
+	const u8 order[] = { 5, 1, 9, 3, 7, 0, 8, 2, 6, 4 };
+	unsigned int i;
+	int num = 0, ret = -1;
+
+	wpa_printf(MSG_INFO, "MAC ACL list tests");
+
+	for (i = 0; i < ARRAY_SIZE(order); i++) {
+		addr[5] = order[i];
+		if (hostapd_insert_acl_mac(&acl, &num, order[i], addr) < 0)
+			goto fail;
+	}
+	/* Already in the list; the VLAN ID is not changed */
+	addr[5] = 3;
+	if (hostapd_insert_acl_mac(&acl, &num, 100, addr) < 0 ||
+	    num != (int) ARRAY_SIZE(order))
+		goto fail;
+
+	for (i = 0; i < (unsigned int) num; i++) {
+		if (acl[i].addr[5] != i || acl[i].vlan_id.untagged != (int) i) {
+			wpa_printf(MSG_ERROR, "MAC ACL list not sorted");
+			goto fail;
+		}
+	}
+
+	addr[5] = 0;
+	if (hostapd_delete_acl_mac(&acl, &num, addr) != 1)
+		goto fail;
+	addr[5] = 9;
+	if (hostapd_delete_acl_mac(&acl, &num, addr) != 1)
+		goto fail;
+	addr[5] = 4;
+	if (hostapd_delete_acl_mac(&acl, &num, addr) != 1 ||
+	    hostapd_delete_acl_mac(&acl, &num, addr) != 0 ||
+	    num != 7)
+		goto fail;
+	if (hostapd_maclist_found(acl, num, addr, NULL))
+		goto fail;
+	addr[5] = 5;
+	if (!hostapd_maclist_found(acl, num, addr, &vlan_id) ||
+	    vlan_id.untagged != 5)
+		goto fail;
+	for (i = 1; i < (unsigned int) num; i++) {
+		if (hostapd_acl_comp(&acl[i - 1], &acl[i]) >= 0) {
+			wpa_printf(MSG_ERROR,
+				   "MAC ACL list not sorted after delete");
+			goto fail;
+		}
+	}
+
+	hostapd_free_acl_maclist(&acl, &num);
+	if (acl || num)
+		goto fail;
+
+	ret = 0;
+fail:
+	if (ret)
+		wpa_printf(MSG_ERROR, "MAC ACL list test failed");
+	os_free(acl);
+	return ret;
+}
+
+
+#ifdef CONFIG_TAXONOMY
+static int taxonomy_tests(void)
+{
+	const u8 probe[] = {
+		WLAN_EID_SSID, 0,
+		WLAN_EID_SUPP_RATES, 4, 0x02, 0x04, 0x0b, 0x16,
+		WLAN_EID_HT_CAP, 7, 0x6f, 0x01, 0x1b, 0xff, 0xff, 0x00, 0x00,
+		WLAN_EID_EXT_CAPAB, 3, 0x04, 0x00, 0x08,
+		WLAN_EID_VENDOR_SPECIFIC, 2, 0x00, 0x50,
+		WLAN_EID_VENDOR_SPECIFIC, 14, 0x00, 0x50, 0xf2, 0x04,
+		0x10, 0x23, 0x00, 0x06, 'N', 'e', 'x', 'u', 's', ' ',
+	};
+	const u8 assoc[] = {
+		WLAN_EID_SSID, 0,
+		WLAN_EID_PWR_CAPABILITY, 2, 0x00, 0x14,
+		WLAN_EID_VENDOR_SPECIFIC, 7, 0x00, 0x50, 0xf2, 0x02, 0, 1, 0,
+		WLAN_EID_VHT_CAP, 12, 0x32, 0x71, 0x80, 0x03, 0xfa, 0xff,
+		0x00, 0x00, 0xfa, 0xff, 0x00, 0x00,
+		WLAN_EID_HT_CAP, 5, 0x00, 0x00, 0x00, 0x00, 0x00,
+	};
+	const char *expected = "wifi4|probe:0,1,45,127,221,221(0050f2,4),"
+		"htcap:016f,htagg:1b,htmcs:0000ffff,extcap:040008,wps:Nexus_"
+		"|assoc:0,33,221(0050f2,2),191,45,htcap:0000,htagg:00,"
+		"vhtcap:03807132,vhtrxmcs:0000fffa,vhttxmcs:0000fffa,txpow:1400";
+	struct sta_info sta;
+	char buf[300];
+	int ret = -1;
+
+	wpa_printf(MSG_INFO, "taxonomy tests");
+
+	os_memset(&sta, 0, sizeof(sta));
+	if (retrieve_sta_taxonomy(NULL, &sta, buf, sizeof(buf)) != 0)
+		goto fail;
+
+	taxonomy_sta_info_probe_req(NULL, &sta, assoc, sizeof(assoc));
+	taxonomy_sta_info_probe_req(NULL, &sta, probe, sizeof(probe));
+	taxonomy_sta_info_assoc_req(NULL, &sta, assoc, sizeof(assoc));
+	if (retrieve_sta_taxonomy(NULL, &sta, buf, sizeof(buf)) !=
+	    (int) os_strlen(expected) ||
+	    os_strcmp(buf, expected) != 0)
+		goto fail;
+
+	/* The IEs are left out if they do not fit */
+	if (retrieve_sta_taxonomy(NULL, &sta, buf, 60) != 19 ||
+	    os_strcmp(buf, "wifi4|probe:|assoc:") != 0)
+		goto fail;
+
+	ret = 0;
+fail:
+	if (ret)
+		wpa_printf(MSG_ERROR, "taxonomy test failed: %s", buf);
+	os_free(sta.probe_taxonomy);
+	os_free(sta.assoc_taxonomy);
+	return ret;
+}
+#endif /* CONFIG_TAXONOMY */
+
+
+#ifdef CONFIG_TESTING_OPTIONS
+static int mgmt_replay_tests(void)
+{
+	/* Big endian radiotap pcap file with three records: a frame with FCS,
+	 * a frame with bad FCS, and a truncated capture */
+	static const u8 pcap[] = {
+		0xa1, 0xb2, 0xc3, 0xd4, 0x00, 0x02, 0x00, 0x04,
+		0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+		0x00, 0x00, 0xff, 0xff, 0x00, 0x00, 0x00, 0x7f,
+		/* record 1: 9 + 24 + 4 octets */
+		0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+		0x00, 0x00, 0x00, 0x25, 0x00, 0x00, 0x00, 0x25,
+		0x00, 0x00, 0x09, 0x00, 0x02, 0x00, 0x00, 0x00, 0x10,
+		0x40, 0x00, 0x00, 0x00, 0xff, 0xff, 0xff, 0xff,
+		0xff, 0xff, 0x02, 0x00, 0x00, 0x00, 0x00, 0x01,
+		0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x00, 0x00,
+		0x11, 0x22, 0x33, 0x44,
+		/* record 2: bad FCS */
+		0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+		0x00, 0x00, 0x00, 0x09, 0x00, 0x00, 0x00, 0x09,
+		0x00, 0x00, 0x09, 0x00, 0x02, 0x00, 0x00, 0x00, 0x40,
+		/* record 3: incl_len < orig_len */
+		0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+		0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x40,
+		0x00,
+	};
+	struct mgmt_replay_iter iter;
+	const u8 *frame;
+	size_t len;
+	int errors = 0;
+
+	wpa_printf(MSG_INFO, "mgmt_replay tests");
+
+	if (mgmt_replay_iter_init(&iter, pcap, 23) == 0 ||
+	    mgmt_replay_iter_init(&iter, pcap, sizeof(pcap)) < 0)
+		return -1;
+
+	if (mgmt_replay_iter_next(&iter, &frame, &len) != 1 ||
+	    frame != &pcap[24 + 16 + 9] || len != 24 || frame[0] != 0x40)
+		errors++;
+	if (mgmt_replay_iter_next(&iter, &frame, &len) != 1 || frame)
+		errors++;
+	if (mgmt_replay_iter_next(&iter, &frame, &len) != 1 || frame)
+		errors++;
+	if (mgmt_replay_iter_next(&iter, &frame, &len) != 0)
+		errors++;
+
+	/* Record header claiming more data than is available */
+	if (mgmt_replay_iter_init(&iter, pcap, 24 + 16 + 20) < 0 ||
+	    mgmt_replay_iter_next(&iter, &frame, &len) != -1)
+		errors++;
+
+	if (errors) {
+		wpa_printf(MSG_ERROR, "%d mgmt_replay test(s) failed", errors);
+		return -1;
+	}
+
+	return 0;
+}
+#endif /* CONFIG_TESTING_OPTIONS */
+
 
 int hapd_module_tests(void)
 {
+	int ret = 0;
+
 	wpa_printf(MSG_INFO, "hostapd module tests");
-	return 0;
+
+	if (wpa_psk_index_tests() < 0)
+		ret = -1;
+
+	if (eap_user_index_tests() < 0)
+		ret = -1;
+
+	if (acl_maclist_tests() < 0)
+		ret = -1;
+
+#ifdef CONFIG_TAXONOMY
+	if (taxonomy_tests() < 0)
+		ret = -1;
+#endif /* CONFIG_TAXONOMY */
+
+#ifdef CONFIG_TESTING_OPTIONS
+	if (mgmt_replay_tests() < 0)
+		ret = -1;
+#endif /* CONFIG_TESTING_OPTIONS */
+
+	return ret;
 }
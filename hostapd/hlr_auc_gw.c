@@ -81,6 +81,7 @@ static struct gsm_triplet *gsm_db = NULL, *gsm_db_pos = NULL;
 /* OPc and AMF parameters for Milenage (Example algorithms for AKA). */
 struct milenage_parameters {
 	struct milenage_parameters *next;
+	struct milenage_parameters *hnext; /* next entry in the IMSI hash */
 	char imsi[20];
 	u8 ki[16];
 	u8 opc[16];
@@ -92,6 +93,9 @@ struct milenage_parameters {
 
 static struct milenage_parameters *milenage_db = NULL;
 
+#define MILENAGE_HASH_SIZE 1024
+static struct milenage_parameters *milenage_hash[MILENAGE_HASH_SIZE];
+
 #define EAP_SIM_MAX_CHAL 3
 
 #define EAP_AKA_RAND_LEN 16
@@ -384,12 +388,40 @@ static struct gsm_triplet * get_gsm_triplet(const char *imsi)
 }
 
 
+static unsigned int milenage_imsi_hash(const char *imsi, size_t imsi_len)
+{
+	unsigned int hash = 0;
+
+	while (imsi_len--)
+		hash = hash * 31 + (u8) *imsi++;
+	return hash % MILENAGE_HASH_SIZE;
+}
+
+
+static struct milenage_parameters * milenage_db_get(const char *imsi,
+						    size_t imsi_len)
+{
+	struct milenage_parameters *m;
+
+	m = milenage_hash[milenage_imsi_hash(imsi, imsi_len)];
+	while (m) {
+		if (strncmp(m->imsi, imsi, imsi_len) == 0 &&
+		    m->imsi[imsi_len] == '\0')
+			break;
+		m = m->hnext;
+	}
+
+	return m;
+}
+
+
 static int read_milenage(const char *fname)
 {
 	FILE *f;
 	char buf[200], *pos, *pos2;
 	struct milenage_parameters *m = NULL;
 	int line, ret = 0;
+	unsigned int hash;
 
 	if (fname == NULL)
 		return -1;
@@ -483,6 +515,9 @@ static int read_milenage(const char *fname)
 
 		m->next = milenage_db;
 		milenage_db = m;
+		hash = milenage_imsi_hash(m->imsi, os_strlen(m->imsi));
+		m->hnext = milenage_hash[hash];
+		milenage_hash[hash] = m;
 		m = NULL;
 	}
 	os_free(m);
@@ -525,12 +560,7 @@ static void update_milenage_file(const char *fname)
 
 		imsi_len = pos - buf;
 
-		for (m = milenage_db; m; m = m->next) {
-			if (strncmp(buf, m->imsi, imsi_len) == 0 &&
-			    m->imsi[imsi_len] == '\0')
-				break;
-		}
-
+		m = milenage_db_get(buf, imsi_len);
 		if (!m)
 			goto no_update;
 
@@ -569,13 +599,9 @@ static void update_milenage_file(const char *fname)
 
 static struct milenage_parameters * get_milenage(const char *imsi)
 {
-	struct milenage_parameters *m = milenage_db;
+	struct milenage_parameters *m;
 
-	while (m) {
-		if (strcmp(m->imsi, imsi) == 0)
-			break;
-		m = m->next;
-	}
+	m = milenage_db_get(imsi, os_strlen(imsi));
 
 #ifdef CONFIG_SQLITE
 	if (!m)
@@ -260,6 +260,20 @@ static int hostapd_cli_cmd_relog(struct wpa_ctrl *ctrl, int argc, char *argv[])
 }
 
 
+static int hostapd_cli_cmd_log_ring_dump(struct wpa_ctrl *ctrl, int argc,
+					 char *argv[])
+{
+	return wpa_ctrl_command(ctrl, "LOG_RING_DUMP");
+}
+
+
+static int hostapd_cli_cmd_eloop_stats(struct wpa_ctrl *ctrl, int argc,
+				       char *argv[])
+{
+	return hostapd_cli_cmd(ctrl, "ELOOP_STATS", 0, argc, argv);
+}
+
+
 static int hostapd_cli_cmd_close_log(struct wpa_ctrl *ctrl, int argc,
 				     char *argv[])
 {
@@ -735,6 +749,20 @@ static int hostapd_cli_cmd_bss_tm_req(struct wpa_ctrl *ctrl, int argc,
 }
 
 
+static int hostapd_cli_cmd_steering_status(struct wpa_ctrl *ctrl, int argc,
+					   char *argv[])
+{
+	return wpa_ctrl_command(ctrl, "STEERING_STATUS");
+}
+
+
+static int hostapd_cli_cmd_steer_sta(struct wpa_ctrl *ctrl, int argc,
+				     char *argv[])
+{
+	return hostapd_cli_cmd(ctrl, "STEER_STA", 1, argc, argv);
+}
+
+
 static int hostapd_cli_cmd_get_config(struct wpa_ctrl *ctrl, int argc,
 				      char *argv[])
 {
@@ -794,6 +822,53 @@ static int hostapd_cli_cmd_all_sta(struct wpa_ctrl *ctrl, int argc,
 }
 
 
+static int hostapd_cli_cmd_dump_sta(struct wpa_ctrl *ctrl, int argc,
+				    char *argv[])
+{
+	char buf[4096], addr[32], cmd[64], *pos, *last;
+	size_t len;
+	int ret;
+
+	if (ctrl_conn == NULL) {
+		printf("Not connected to hostapd - command dropped.\n");
+		return -1;
+	}
+
+	os_strlcpy(cmd, "STA-DUMP", sizeof(cmd));
+	for (;;) {
+		len = sizeof(buf) - 1;
+		ret = wpa_ctrl_request(ctrl, cmd, os_strlen(cmd), buf, &len,
+				       hostapd_cli_msg_cb);
+		if (ret == -2) {
+			printf("'%s' command timed out.\n", cmd);
+			return -2;
+		} else if (ret < 0) {
+			printf("'%s' command failed.\n", cmd);
+			return -1;
+		}
+		buf[len] = '\0';
+		if (len == 0)
+			break;
+		if (os_strncmp(buf, "FAIL", 4) == 0)
+			return -1;
+		printf("%s", buf);
+
+		/* Continue from the address on the last line */
+		if (buf[len - 1] == '\n')
+			buf[--len] = '\0';
+		last = os_strrchr(buf, '\n');
+		last = last ? last + 1 : buf;
+		pos = os_strchr(last, ' ');
+		if (pos)
+			*pos = '\0';
+		os_strlcpy(addr, last, sizeof(addr));
+		os_snprintf(cmd, sizeof(cmd), "STA-DUMP %s", addr);
+	}
+
+	return 0;
+}
+
+
 static int hostapd_cli_cmd_list_sta(struct wpa_ctrl *ctrl, int argc,
 				    char *argv[])
 {
@@ -1259,6 +1334,13 @@ static int hostapd_cli_cmd_reload_config(struct wpa_ctrl *ctrl, int argc,
 }
 
 
+static int hostapd_cli_cmd_apply_config(struct wpa_ctrl *ctrl, int argc,
+					char *argv[])
+{
+	return wpa_ctrl_command(ctrl, "APPLY_CONFIG");
+}
+
+
 static int hostapd_cli_cmd_disable(struct wpa_ctrl *ctrl, int argc,
 				   char *argv[])
 {
@@ -1372,6 +1454,13 @@ static int hostapd_cli_cmd_pmksa(struct wpa_ctrl *ctrl, int argc, char *argv[])
 }
 
 
+static int hostapd_cli_cmd_memstat(struct wpa_ctrl *ctrl, int argc,
+				   char *argv[])
+{
+	return wpa_ctrl_command(ctrl, "MEMSTAT");
+}
+
+
 static int hostapd_cli_cmd_pmksa_flush(struct wpa_ctrl *ctrl, int argc,
 				       char *argv[])
 {
@@ -1584,6 +1673,13 @@ static int hostapd_cli_cmd_dpp_controller_stop(struct wpa_ctrl *ctrl, int argc,
 }
 
 
+static int hostapd_cli_cmd_dpp_controller_stats(struct wpa_ctrl *ctrl,
+						int argc, char *argv[])
+{
+	return wpa_ctrl_command(ctrl, "DPP_CONTROLLER_STATS");
+}
+
+
 static int hostapd_cli_cmd_dpp_chirp(struct wpa_ctrl *ctrl, int argc,
 				     char *argv[])
 {
@@ -1652,6 +1748,20 @@ static int hostapd_cli_cmd_reload_wpa_psk(struct wpa_ctrl *ctrl, int argc,
 }
 
 
+static int hostapd_cli_cmd_reload_tls_ticket_keys(struct wpa_ctrl *ctrl,
+						  int argc, char *argv[])
+{
+	return wpa_ctrl_command(ctrl, "RELOAD_TLS_TICKET_KEYS");
+}
+
+
+static int hostapd_cli_cmd_set_tls_ticket_keys(struct wpa_ctrl *ctrl,
+					       int argc, char *argv[])
+{
+	return hostapd_cli_cmd(ctrl, "SET_TLS_TICKET_KEYS", 1, argc, argv);
+}
+
+
 #ifdef CONFIG_IEEE80211R_AP
 
 static int hostapd_cli_cmd_get_rxkhs(struct wpa_ctrl *ctrl, int argc,
@@ -1686,6 +1796,10 @@ static const struct hostapd_cli_cmd hostapd_cli_commands[] = {
 	  "= reload/truncate debug log output file" },
 	{ "close_log", hostapd_cli_cmd_close_log, NULL,
 	  "= disable debug log output file" },
+	{ "log_ring_dump", hostapd_cli_cmd_log_ring_dump, NULL,
+	  "= write debug ring buffer into the file specified with -F" },
+	{ "eloop_stats", hostapd_cli_cmd_eloop_stats, NULL,
+	  "[START [<slow msec>]|STOP] = show or control event loop handler statistics" },
 	{ "status", hostapd_cli_cmd_status, NULL,
 	  "= show interface status info" },
 	{ "sta", hostapd_cli_cmd_sta, hostapd_complete_stations,
@@ -1694,6 +1808,8 @@ static const struct hostapd_cli_cmd hostapd_cli_commands[] = {
 	   "= get MIB variables for all stations" },
 	{ "list_sta", hostapd_cli_cmd_list_sta, NULL,
 	   "= list all stations" },
+	{ "dump_sta", hostapd_cli_cmd_dump_sta, NULL,
+	   "= get compact information for all stations" },
 	{ "new_sta", hostapd_cli_cmd_new_sta, NULL,
 	  "<addr> = add a new station" },
 	{ "deauthenticate", hostapd_cli_cmd_deauthenticate,
@@ -1740,6 +1856,10 @@ static const struct hostapd_cli_cmd hostapd_cli_commands[] = {
 	  "= send ESS Dissassociation Imminent notification" },
 	{ "bss_tm_req", hostapd_cli_cmd_bss_tm_req, NULL,
 	  "= send BSS Transition Management Request" },
+	{ "steering_status", hostapd_cli_cmd_steering_status, NULL,
+	  "= show load based steering status" },
+	{ "steer_sta", hostapd_cli_cmd_steer_sta, hostapd_complete_stations,
+	  "<addr> = steer a station to the least busy other radio" },
 	{ "get_config", hostapd_cli_cmd_get_config, NULL,
 	  "= show current configuration" },
 	{ "help", hostapd_cli_cmd_help, hostapd_cli_complete_help,
@@ -1798,6 +1918,8 @@ static const struct hostapd_cli_cmd hostapd_cli_commands[] = {
 	  "= reload configuration for current BSS" },
 	{ "reload_config", hostapd_cli_cmd_reload_config, NULL,
 	  "= reload configuration for current interface" },
+	{ "apply_config", hostapd_cli_cmd_apply_config, NULL,
+	  "= apply only the changed configuration for current interface" },
 	{ "disable", hostapd_cli_cmd_disable, NULL,
 	  "= disable hostapd on current interface" },
 	{ "enable_mld", hostapd_cli_cmd_enable_mld, NULL,
@@ -1816,6 +1938,8 @@ static const struct hostapd_cli_cmd hostapd_cli_commands[] = {
 	  " = show PMKSA cache entries" },
 	{ "pmksa_flush", hostapd_cli_cmd_pmksa_flush, NULL,
 	  " = flush PMKSA cache" },
+	{ "memstat", hostapd_cli_cmd_memstat, NULL,
+	  " = show memory accounting per subsystem" },
 	{ "set_neighbor", hostapd_cli_cmd_set_neighbor, NULL,
 	  "<addr> <ssid=> <nr=> [lci=] [civic=] [stat]\n"
 	  "  = add AP to neighbor database" },
@@ -1866,9 +1990,11 @@ static const struct hostapd_cli_cmd hostapd_cli_commands[] = {
 	  "*|<id> = remove DPP pkex information" },
 #ifdef CONFIG_DPP2
 	{ "dpp_controller_start", hostapd_cli_cmd_dpp_controller_start, NULL,
-	  "[tcp_port=<port>] [role=..] = start DPP controller" },
+	  "[tcp_port=<port>] [role=..] [max_conn=<num>] = start DPP controller" },
 	{ "dpp_controller_stop", hostapd_cli_cmd_dpp_controller_stop, NULL,
 	  "= stop DPP controller" },
+	{ "dpp_controller_stats", hostapd_cli_cmd_dpp_controller_stats, NULL,
+	  "= show DPP controller connection and throughput statistics" },
 	{ "dpp_chirp", hostapd_cli_cmd_dpp_chirp, NULL,
 	  "own=<BI ID> iter=<count> = start DPP chirp" },
 	{ "dpp_stop_chirp", hostapd_cli_cmd_dpp_stop_chirp, NULL,
@@ -1880,9 +2006,9 @@ static const struct hostapd_cli_cmd hostapd_cli_commands[] = {
 #endif /* CONFIG_DPP3 */
 #endif /* CONFIG_DPP */
 	{ "accept_acl", hostapd_cli_cmd_accept_macacl, NULL,
-	  "=Add/Delete/Show/Clear accept MAC ACL" },
+	  "=Add/Delete/Replace/Show/Clear accept MAC ACL" },
 	{ "deny_acl", hostapd_cli_cmd_deny_macacl, NULL,
-	  "=Add/Delete/Show/Clear deny MAC ACL" },
+	  "=Add/Delete/Replace/Show/Clear deny MAC ACL" },
 	{ "poll_sta", hostapd_cli_cmd_poll_sta, hostapd_complete_stations,
 	  "<addr> = poll a STA to check connectivity with a QoS null frame" },
 	{ "req_beacon", hostapd_cli_cmd_req_beacon, NULL,
@@ -1891,6 +2017,10 @@ static const struct hostapd_cli_cmd hostapd_cli_commands[] = {
 	  "<addr> = send a link measurement report request to a station"},
 	{ "reload_wpa_psk", hostapd_cli_cmd_reload_wpa_psk, NULL,
 	  "= reload wpa_psk_file only" },
+	{ "reload_tls_ticket_keys", hostapd_cli_cmd_reload_tls_ticket_keys,
+	  NULL, "= reload tls_session_ticket_keys file" },
+	{ "set_tls_ticket_keys", hostapd_cli_cmd_set_tls_ticket_keys, NULL,
+	  "<key> [<key>...] = set TLS session ticket keys" },
 #ifdef CONFIG_IEEE80211R_AP
 	{ "reload_rxkhs", hostapd_cli_cmd_reload_rxkhs, NULL,
 	  "= reload R0KHs and R1KHs" },
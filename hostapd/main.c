@@ -601,6 +601,12 @@ static void usage(void)
 		"   -T   record to Linux tracing in addition to logging\n"
 		"        (records all messages regardless of debug verbosity)\n"
 #endif /* CONFIG_DEBUG_LINUX_TRACING */
+#ifdef CONFIG_DEBUG_RING
+		"   -F   record debug messages into an in-memory ring buffer\n"
+		"        that is written to the given file on crash or on\n"
+		"        LOG_RING_DUMP (records messages regardless of debug\n"
+		"        verbosity)\n"
+#endif /* CONFIG_DEBUG_RING */
 		"   -i   list of interface names to use\n"
 #ifdef CONFIG_DEBUG_SYSLOG
 		"   -s   log output to syslog instead of stdout\n"
@@ -787,6 +793,9 @@ int main(int argc, char *argv[])
 #ifdef CONFIG_DEBUG_LINUX_TRACING
 	int enable_trace_dbg = 0;
 #endif /* CONFIG_DEBUG_LINUX_TRACING */
+#ifdef CONFIG_DEBUG_RING
+	const char *ring_file = NULL;
+#endif /* CONFIG_DEBUG_RING */
 	int start_ifaces_in_sync = 0;
 	char **if_names = NULL;
 	size_t if_names_size = 0;
@@ -827,7 +836,7 @@ int main(int argc, char *argv[])
 #endif /* CONFIG_DPP */
 
 	for (;;) {
-		c = getopt(argc, argv, "b:Bde:f:hi:KP:sSTtu:vg:G:j:q");
+		c = getopt(argc, argv, "b:Bde:f:F:hi:KP:sSTtu:vg:G:j:q");
 		if (c < 0)
 			break;
 		switch (c) {
@@ -848,6 +857,11 @@ int main(int argc, char *argv[])
 		case 'f':
 			log_file = optarg;
 			break;
+#ifdef CONFIG_DEBUG_RING
+		case 'F':
+			ring_file = optarg;
+			break;
+#endif /* CONFIG_DEBUG_RING */
 		case 'K':
 			wpa_debug_show_keys++;
 			break;
@@ -939,6 +953,12 @@ int main(int argc, char *argv[])
 		}
 	}
 #endif /* CONFIG_DEBUG_LINUX_TRACING */
+#ifdef CONFIG_DEBUG_RING
+	if (ring_file && wpa_debug_ring_open(ring_file) < 0) {
+		wpa_printf(MSG_ERROR, "Failed to enable debug ring buffer");
+		return -1;
+	}
+#endif /* CONFIG_DEBUG_RING */
 
 	interfaces.count = argc - optind;
 	if (interfaces.count || num_bss_configs) {
@@ -1082,6 +1102,7 @@ int main(int argc, char *argv[])
 	if (log_file)
 		wpa_debug_close_file();
 	wpa_debug_close_linux_tracing();
+	wpa_debug_ring_close();
 
 	os_free(bss_config);
 
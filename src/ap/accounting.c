@@ -19,6 +19,7 @@
 #include "ap_config.h"
 #include "sta_info.h"
 #include "ap_drv_ops.h"
+#include "acct_spool.h"
 #include "accounting.h"
 
 
@@ -27,6 +28,11 @@
  * input/output octets and updates Acct-{Input,Output}-Gigawords. */
 #define ACCT_DEFAULT_UPDATE_INTERVAL 300
 
+/* The accounting server is considered reachable for this many seconds after a
+ * response and spooled messages are retried at this interval otherwise. */
+#define ACCT_SPOOL_ALIVE_TIME 10
+#define ACCT_SPOOL_RETRY_INTERVAL 60
+
 static void accounting_sta_interim(struct hostapd_data *hapd,
 				   struct sta_info *sta);
 
@@ -169,10 +175,18 @@ static struct radius_msg * accounting_msg(struct hostapd_data *hapd,
 
 static int accounting_sta_update_stats(struct hostapd_data *hapd,
 				       struct sta_info *sta,
-				       struct hostap_sta_driver_data *data)
+				       struct hostap_sta_driver_data *data,
+				       bool bulk)
 {
-	if (hostapd_drv_read_sta_data(hapd, data, sta->addr))
+	/* With coalesced interim updates, use a single driver request for
+	 * all the stations whose updates are due at the same time. */
+	if (bulk) {
+		if (ap_sta_read_drv_data(hapd, sta, data,
+					 AP_STA_DRV_DATA_ANY_AGE, NULL) < 0)
+			return -1;
+	} else if (hostapd_drv_read_sta_data(hapd, data, sta->addr)) {
 		return -1;
+	}
 
 	if (!data->bytes_64bit) {
 		/* Extend 32-bit counters from the driver to 64-bit counters */
@@ -198,6 +212,52 @@ static int accounting_sta_update_stats(struct hostapd_data *hapd,
 }
 
 
+static void accounting_interim_update(void *eloop_ctx, void *timeout_ctx);
+
+
+/**
+ * accounting_register_interim_timer - Register interim update timer
+ * @hapd: hostapd BSS data
+ * @sta: The station
+ * @sec: Number of seconds until the next update
+ * @first: Whether this is the first update of the session
+ *
+ * The first update is delayed by a random jitter of up to
+ * radius_acct_interim_jitter seconds. With radius_acct_interim_slack, the
+ * expiration time is rounded up to the next multiple of the slack so that
+ * the updates that fall within the same window are processed together and
+ * can share a single driver request for the station counters.
+ */
+static void accounting_register_interim_timer(struct hostapd_data *hapd,
+					      struct sta_info *sta,
+					      unsigned int sec, bool first)
+{
+	unsigned int slack = hapd->conf->acct_interim_slack;
+	unsigned int jitter = hapd->conf->acct_interim_jitter;
+	unsigned int usec = 0;
+	struct os_reltime now;
+	os_time_t expire;
+
+	if (first && jitter)
+		sec += os_random() % (jitter + 1);
+
+	if (slack > 1) {
+		os_get_reltime(&now);
+		expire = now.sec + sec;
+		expire = (expire + slack - 1) / slack * slack;
+		if (expire <= now.sec)
+			expire += slack;
+		sec = expire - now.sec;
+		if (now.usec) {
+			sec--;
+			usec = 1000000 - now.usec;
+		}
+	}
+
+	eloop_register_timeout(sec, usec, accounting_interim_update, hapd, sta);
+}
+
+
 static void accounting_interim_update(void *eloop_ctx, void *timeout_ctx)
 {
 	struct hostapd_data *hapd = eloop_ctx;
@@ -209,12 +269,12 @@ static void accounting_interim_update(void *eloop_ctx, void *timeout_ctx)
 		interval = sta->acct_interim_interval;
 	} else {
 		struct hostap_sta_driver_data data;
-		accounting_sta_update_stats(hapd, sta, &data);
+		accounting_sta_update_stats(hapd, sta, &data,
+					    hapd->conf->acct_interim_slack > 1);
 		interval = ACCT_DEFAULT_UPDATE_INTERVAL;
 	}
 
-	eloop_register_timeout(interval, 0, accounting_interim_update,
-			       hapd, sta);
+	accounting_register_interim_timer(hapd, sta, interval, false);
 }
 
 
@@ -250,8 +310,7 @@ void accounting_sta_start(struct hostapd_data *hapd, struct sta_info *sta)
 		interval = sta->acct_interim_interval;
 	else
 		interval = ACCT_DEFAULT_UPDATE_INTERVAL;
-	eloop_register_timeout(interval, 0, accounting_interim_update,
-			       hapd, sta);
+	accounting_register_interim_timer(hapd, sta, interval, true);
 
 	msg = accounting_msg(hapd, sta, RADIUS_ACCT_STATUS_TYPE_START);
 	if (msg &&
@@ -290,7 +349,9 @@ static void accounting_sta_report(struct hostapd_data *hapd,
 		goto fail;
 	}
 
-	if (accounting_sta_update_stats(hapd, sta, &data) == 0) {
+	if (accounting_sta_update_stats(hapd, sta, &data,
+					!stop &&
+					hapd->conf->acct_interim_slack > 1) == 0) {
 		if (!radius_msg_add_attr_int32(msg,
 					       RADIUS_ATTR_ACCT_INPUT_PACKETS,
 					       data.rx_packets)) {
@@ -399,6 +460,119 @@ int accounting_sta_get_id(struct hostapd_data *hapd, struct sta_info *sta)
 }
 
 
+static void accounting_spool_drain(void *eloop_ctx, void *timeout_ctx)
+{
+	struct hostapd_data *hapd = eloop_ctx;
+	struct acct_spool *spool = hapd->acct_spool;
+	unsigned int rate = hapd->conf->acct_spool_rate;
+	struct acct_spool_entry *entry;
+	struct radius_msg *msg;
+	struct os_reltime now;
+	struct os_time wall;
+	u8 *delay;
+	size_t delay_len;
+	bool alive;
+
+	os_get_reltime(&now);
+	alive = os_reltime_initialized(&hapd->acct_last_rx) &&
+		!os_reltime_expired(&now, &hapd->acct_last_rx,
+				    ACCT_SPOOL_ALIVE_TIME);
+
+	/* Send only a single probe message while the accounting server is not
+	 * known to be reachable and limit the number of unacknowledged
+	 * messages to one second's worth of messages otherwise. Responses and
+	 * dropped messages reschedule the drain. */
+	if (acct_spool_num_inflight(spool) >= (alive ? rate : 1))
+		return;
+
+	entry = acct_spool_next(spool);
+	if (!entry)
+		return;
+
+	msg = radius_msg_parse(wpabuf_head(entry->msg),
+			       wpabuf_len(entry->msg));
+	if (!msg) {
+		wpa_printf(MSG_INFO,
+			   "RADIUS spool: Invalid spooled message - drop it");
+		acct_spool_done(spool, entry);
+		goto next;
+	}
+
+	radius_msg_get_hdr(msg)->identifier =
+		radius_client_get_id(hapd->radius);
+	if (radius_msg_get_attr_ptr(msg, RADIUS_ATTR_ACCT_DELAY_TIME,
+				    &delay, &delay_len, NULL) == 0 &&
+	    delay_len == 4) {
+		os_get_time(&wall);
+		WPA_PUT_BE32(delay, entry->delay +
+			     (wall.sec > entry->spooled ?
+			      wall.sec - entry->spooled : 0));
+	}
+
+	if (radius_client_send(hapd->radius, msg, RADIUS_ACCT, NULL) < 0) {
+		radius_msg_free(msg);
+		eloop_register_timeout(ACCT_SPOOL_RETRY_INTERVAL, 0,
+				       accounting_spool_drain, hapd, NULL);
+		return;
+	}
+	acct_spool_set_inflight(spool, entry, msg);
+
+next:
+	if (alive)
+		eloop_register_timeout(0, 1000000 / rate,
+				       accounting_spool_drain, hapd, NULL);
+}
+
+
+static void accounting_spool_ack(struct hostapd_data *hapd,
+				 struct radius_msg *req)
+{
+	struct acct_spool_entry *entry;
+
+	os_get_reltime(&hapd->acct_last_rx);
+	entry = acct_spool_get_inflight(hapd->acct_spool, req);
+	if (entry)
+		acct_spool_done(hapd->acct_spool, entry);
+
+	/* The accounting server is reachable, so start sending the spooled
+	 * messages if that is not already in progress. */
+	if (acct_spool_next(hapd->acct_spool) &&
+	    eloop_deplete_timeout(0, 0, accounting_spool_drain, hapd,
+				  NULL) < 0)
+		eloop_register_timeout(0, 0, accounting_spool_drain, hapd,
+				       NULL);
+}
+
+
+static void accounting_drop_cb(struct radius_msg *msg, unsigned int queued,
+			       void *ctx)
+{
+	struct hostapd_data *hapd = ctx;
+	struct acct_spool_entry *entry;
+	u32 status;
+
+	if (!hapd->acct_spool)
+		return;
+
+	entry = acct_spool_get_inflight(hapd->acct_spool, msg);
+	if (entry) {
+		/* Keep the existing spool entry for another attempt */
+		acct_spool_set_inflight(hapd->acct_spool, entry, NULL);
+	} else if (radius_msg_get_attr_int32(msg, RADIUS_ATTR_ACCT_STATUS_TYPE,
+					     &status) == 0 &&
+		   status != RADIUS_ACCT_STATUS_TYPE_ACCOUNTING_ON &&
+		   status != RADIUS_ACCT_STATUS_TYPE_ACCOUNTING_OFF) {
+		acct_spool_add(hapd->acct_spool, radius_msg_get_buf(msg),
+			       queued);
+	}
+
+	if (acct_spool_count(hapd->acct_spool) &&
+	    !eloop_is_timeout_registered(accounting_spool_drain, hapd, NULL))
+		eloop_register_timeout(ACCT_SPOOL_RETRY_INTERVAL, 0,
+				       accounting_spool_drain, hapd, NULL);
+}
+
+
 /**
  * accounting_receive - Process the RADIUS frames from Accounting Server
  * @msg: RADIUS response message
@@ -413,6 +587,8 @@ accounting_receive(struct radius_msg *msg, struct radius_msg *req,
 		   const u8 *shared_secret, size_t shared_secret_len,
 		   void *data)
 {
+	struct hostapd_data *hapd = data;
+
 	if (radius_msg_get_hdr(msg)->code != RADIUS_CODE_ACCOUNTING_RESPONSE) {
 		wpa_printf(MSG_INFO, "Unknown RADIUS message code");
 		return RADIUS_RX_UNKNOWN;
@@ -423,6 +599,9 @@ accounting_receive(struct radius_msg *msg, struct radius_msg *req,
 		return RADIUS_RX_INVALID_AUTHENTICATOR;
 	}
 
+	if (hapd->acct_spool)
+		accounting_spool_ack(hapd, req);
+
 	return RADIUS_RX_PROCESSED;
 }
 
@@ -531,6 +710,21 @@ int accounting_init(struct hostapd_data *hapd)
 	radius_client_set_interim_error_cb(hapd->radius,
 					   accounting_interim_error_cb, hapd);
 
+	if (hapd->conf->acct_spool_file) {
+		hapd->acct_spool = acct_spool_init(hapd->conf->acct_spool_file,
+						   hapd->conf->acct_spool_max);
+		if (!hapd->acct_spool)
+			return -1;
+		radius_client_set_acct_drop_cb(hapd->radius,
+					       accounting_drop_cb, hapd);
+		/* The response to Accounting-On starts the drain earlier if
+		 * the server is reachable. */
+		if (acct_spool_count(hapd->acct_spool))
+			eloop_register_timeout(ACCT_SPOOL_RETRY_INTERVAL, 0,
+					       accounting_spool_drain, hapd,
+					       NULL);
+	}
+
 	accounting_report_state(hapd, 1);
 
 	return 0;
@@ -544,4 +738,13 @@ int accounting_init(struct hostapd_data *hapd)
 void accounting_deinit(struct hostapd_data *hapd)
 {
 	accounting_report_state(hapd, 0);
+
+	if (hapd->acct_spool) {
+		/* Spool the messages that are still waiting for a response */
+		eloop_cancel_timeout(accounting_spool_drain, hapd, NULL);
+		radius_client_flush_acct(hapd->radius);
+		radius_client_set_acct_drop_cb(hapd->radius, NULL, NULL);
+		acct_spool_deinit(hapd->acct_spool);
+		hapd->acct_spool = NULL;
+	}
 }
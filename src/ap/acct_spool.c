@@ -0,0 +1,487 @@
+/*
+ * hostapd / Persistent RADIUS accounting spool
+ *
+ * This software may be distributed under the terms of the BSD license.
+ * See README for more details.
+ */
+
+#include "utils/includes.h"
+
+#include "utils/common.h"
+#include "utils/crc32.h"
+#include "utils/eloop.h"
+#include "acct_spool.h"
+
+/*
+ * The spool file is an append-only log of records, each one consisting of a
+ * 32-bit little endian payload length and a CRC-32 of the payload followed by
+ * the payload. A record that was not completely written (e.g., due to a power
+ * failure) is detected with the length and the CRC and is ignored together
+ * with anything after it. The file is rewritten with only the pending entries
+ * when it is loaded and when the log has grown to be considerably longer than
+ * the number of pending entries.
+ *
+ * Payload:
+ * type (ACCT_SPOOL_MSG/ACCT_SPOOL_DONE), sequence number (le64)
+ * ACCT_SPOOL_MSG continues with:
+ * spool time (le64, wall clock), Acct-Delay-Time (le32), RADIUS message
+ *
+ * ACCT_SPOOL_DONE marks the message with the same sequence number as
+ * delivered. MSG records are synced to disk before acct_spool_add() returns;
+ * a lost DONE record only results in the message being sent again.
+ */
+
+#define ACCT_SPOOL_MSG 1
+#define ACCT_SPOOL_DONE 2
+
+#define ACCT_SPOOL_HDR_LEN 8
+#define ACCT_SPOOL_MAX_LEN (1 + 8 + 8 + 4 + 4096)
+#define ACCT_SPOOL_COMPACT_MIN 64
+
+struct acct_spool {
+	char *file;
+	struct dl_list entries; /* struct acct_spool_entry; oldest first */
+	unsigned int count;
+	unsigned int num_inflight;
+	unsigned int max_entries;
+	unsigned int records; /* number of records in the file */
+	u64 next_seq;
+};
+
+
+static void acct_spool_compact_timeout(void *eloop_ctx, void *timeout_ctx);
+
+
+static void acct_spool_entry_free(struct acct_spool *spool,
+				  struct acct_spool_entry *entry)
+{
+	dl_list_del(&entry->list);
+	spool->count--;
+	if (entry->inflight)
+		spool->num_inflight--;
+	wpabuf_free(entry->msg);
+	os_free(entry);
+}
+
+
+static int acct_spool_write(FILE *f, u8 type, struct acct_spool_entry *entry,
+			    u64 seq)
+{
+	struct wpabuf *buf;
+	size_t len;
+	u8 *payload;
+	int ret = 0;
+
+	len = 1 + 8;
+	if (type == ACCT_SPOOL_MSG)
+		len += 8 + 4 + wpabuf_len(entry->msg);
+	buf = wpabuf_alloc(ACCT_SPOOL_HDR_LEN + len);
+	if (!buf)
+		return -1;
+
+	wpabuf_put_le32(buf, len);
+	wpabuf_put(buf, 4); /* CRC-32 */
+	payload = wpabuf_put(buf, 0);
+	wpabuf_put_u8(buf, type);
+	wpabuf_put_le64(buf, seq);
+	if (type == ACCT_SPOOL_MSG) {
+		wpabuf_put_le64(buf, entry->spooled);
+		wpabuf_put_le32(buf, entry->delay);
+		wpabuf_put_buf(buf, entry->msg);
+	}
+	WPA_PUT_LE32(wpabuf_mhead_u8(buf) + 4, ieee80211_crc32(payload, len));
+
+	if (fwrite(wpabuf_head(buf), wpabuf_len(buf), 1, f) != 1)
+		ret = -1;
+	wpabuf_free(buf);
+	return ret;
+}
+
+
+static int acct_spool_sync(FILE *f)
+{
+	if (fflush(f) != 0 || fsync(fileno(f)) < 0)
+		return -1;
+	return 0;
+}
+
+
+static int acct_spool_append(struct acct_spool *spool, u8 type,
+			     struct acct_spool_entry *entry, u64 seq)
+{
+	FILE *f;
+	int ret;
+
+	f = fopen(spool->file, "ab");
+	if (!f) {
+		wpa_printf(MSG_INFO, "RADIUS spool: Failed to open %s: %s",
+			   spool->file, strerror(errno));
+		return -1;
+	}
+	ret = acct_spool_write(f, type, entry, seq);
+	if (ret == 0 && type == ACCT_SPOOL_MSG)
+		ret = acct_spool_sync(f);
+	if (fclose(f) != 0)
+		ret = -1;
+	if (ret < 0)
+		wpa_printf(MSG_INFO, "RADIUS spool: Failed to write to %s",
+			   spool->file);
+	else
+		spool->records++;
+
+	if (!eloop_is_timeout_registered(acct_spool_compact_timeout, spool,
+					 NULL) &&
+	    ((spool->count == 0 && spool->records > 0) ||
+	     spool->records > 2 * spool->count + ACCT_SPOOL_COMPACT_MIN))
+		eloop_register_timeout(0, 0, acct_spool_compact_timeout, spool,
+				       NULL);
+
+	return ret;
+}
+
+
+static int acct_spool_compact(struct acct_spool *spool)
+{
+	struct acct_spool_entry *entry;
+	char *tmp;
+	size_t tmp_len;
+	FILE *f;
+	int ret = 0;
+
+	tmp_len = os_strlen(spool->file) + 5;
+	tmp = os_malloc(tmp_len);
+	if (!tmp)
+		return -1;
+	os_snprintf(tmp, tmp_len, "%s.tmp", spool->file);
+
+	f = fopen(tmp, "wb");
+	if (!f) {
+		wpa_printf(MSG_INFO, "RADIUS spool: Failed to open %s: %s",
+			   tmp, strerror(errno));
+		os_free(tmp);
+		return -1;
+	}
+
+	dl_list_for_each(entry, &spool->entries, struct acct_spool_entry,
+			 list) {
+		if (acct_spool_write(f, ACCT_SPOOL_MSG, entry, entry->seq) < 0)
+			ret = -1;
+	}
+
+	if (ret == 0)
+		ret = acct_spool_sync(f);
+	if (fclose(f) != 0)
+		ret = -1;
+	if (ret == 0 && rename(tmp, spool->file) < 0)
+		ret = -1;
+	if (ret < 0) {
+		wpa_printf(MSG_INFO, "RADIUS spool: Failed to rewrite %s",
+			   spool->file);
+		unlink(tmp);
+	} else {
+		wpa_printf(MSG_DEBUG, "RADIUS spool: Wrote %u entries to %s",
+			   spool->count, spool->file);
+		spool->records = spool->count;
+	}
+	os_free(tmp);
+
+	return ret;
+}
+
+
+static void acct_spool_compact_timeout(void *eloop_ctx, void *timeout_ctx)
+{
+	acct_spool_compact(eloop_ctx);
+}
+
+
+static struct acct_spool_entry * acct_spool_get(struct acct_spool *spool,
+						u64 seq)
+{
+	struct acct_spool_entry *entry;
+
+	dl_list_for_each(entry, &spool->entries, struct acct_spool_entry,
+			 list) {
+		if (entry->seq == seq)
+			return entry;
+	}
+
+	return NULL;
+}
+
+
+static int acct_spool_parse(struct acct_spool *spool, const u8 *pos,
+			    size_t len)
+{
+	struct acct_spool_entry *entry;
+	u8 type;
+	u64 seq;
+
+	if (len < 1 + 8)
+		return -1;
+	type = *pos++;
+	seq = WPA_GET_LE64(pos);
+	pos += 8;
+	len -= 1 + 8;
+	if (seq >= spool->next_seq)
+		spool->next_seq = seq + 1;
+
+	if (type == ACCT_SPOOL_DONE) {
+		entry = acct_spool_get(spool, seq);
+		if (entry)
+			acct_spool_entry_free(spool, entry);
+		return 0;
+	}
+
+	if (type != ACCT_SPOOL_MSG || len < 8 + 4)
+		return -1;
+
+	entry = os_zalloc(sizeof(*entry));
+	if (!entry)
+		return -1;
+	entry->seq = seq;
+	entry->spooled = WPA_GET_LE64(pos);
+	entry->delay = WPA_GET_LE32(pos + 8);
+	entry->msg = wpabuf_alloc_copy(pos + 8 + 4, len - 8 - 4);
+	if (!entry->msg) {
+		os_free(entry);
+		return -1;
+	}
+	dl_list_add_tail(&spool->entries, &entry->list);
+	spool->count++;
+	return 0;
+}
+
+
+static void acct_spool_load(struct acct_spool *spool)
+{
+	u8 hdr[ACCT_SPOOL_HDR_LEN], *buf;
+	size_t len;
+	FILE *f;
+
+	f = fopen(spool->file, "rb");
+	if (!f)
+		return;
+
+	buf = os_malloc(ACCT_SPOOL_MAX_LEN);
+	while (buf && fread(hdr, sizeof(hdr), 1, f) == 1) {
+		len = WPA_GET_LE32(hdr);
+		if (len > ACCT_SPOOL_MAX_LEN || fread(buf, len, 1, f) != 1 ||
+		    ieee80211_crc32(buf, len) != WPA_GET_LE32(hdr + 4)) {
+			wpa_printf(MSG_INFO,
+				   "RADIUS spool: Ignoring truncated or invalid record in %s",
+				   spool->file);
+			break;
+		}
+		if (acct_spool_parse(spool, buf, len) < 0) {
+			wpa_printf(MSG_INFO,
+				   "RADIUS spool: Ignoring unknown record in %s",
+				   spool->file);
+			continue;
+		}
+	}
+	os_free(buf);
+	fclose(f);
+
+	while (spool->count > spool->max_entries)
+		acct_spool_entry_free(spool,
+				      dl_list_first(&spool->entries,
+						    struct acct_spool_entry,
+						    list));
+
+	wpa_printf(MSG_DEBUG, "RADIUS spool: Loaded %u entries from %s",
+		   spool->count, spool->file);
+}
+
+
+/**
+ * acct_spool_init - Open a RADIUS accounting spool
+ * @file: Spool file
+ * @max_entries: Maximum number of pending messages
+ * Returns: Pointer to the spool or %NULL on failure
+ *
+ * The messages that were pending when the spool was last closed are loaded
+ * from the file.
+ */
+struct acct_spool * acct_spool_init(const char *file,
+				    unsigned int max_entries)
+{
+	struct acct_spool *spool;
+
+	spool = os_zalloc(sizeof(*spool));
+	if (!spool)
+		return NULL;
+	spool->file = os_strdup(file);
+	if (!spool->file) {
+		os_free(spool);
+		return NULL;
+	}
+	dl_list_init(&spool->entries);
+	spool->max_entries = max_entries;
+	spool->next_seq = 1;
+
+	acct_spool_load(spool);
+	if (acct_spool_compact(spool) < 0) {
+		acct_spool_deinit(spool);
+		return NULL;
+	}
+
+	return spool;
+}
+
+
+void acct_spool_deinit(struct acct_spool *spool)
+{
+	struct acct_spool_entry *entry, *tmp;
+
+	if (!spool)
+		return;
+
+	if (eloop_is_timeout_registered(acct_spool_compact_timeout, spool,
+					NULL)) {
+		eloop_cancel_timeout(acct_spool_compact_timeout, spool, NULL);
+		acct_spool_compact(spool);
+	}
+
+	dl_list_for_each_safe(entry, tmp, &spool->entries,
+			      struct acct_spool_entry, list)
+		acct_spool_entry_free(spool, entry);
+	os_free(spool->file);
+	os_free(spool);
+}
+
+
+/**
+ * acct_spool_add - Add a message to the spool
+ * @spool: Pointer to the spool from acct_spool_init()
+ * @msg: RADIUS accounting message
+ * @delay: Time in seconds since the message was first sent
+ * Returns: 0 on success, -1 on failure
+ *
+ * The message is written to the spool file before this function returns.
+ */
+int acct_spool_add(struct acct_spool *spool, const struct wpabuf *msg,
+		   u32 delay)
+{
+	struct acct_spool_entry *entry;
+	struct os_time now;
+
+	if (spool->count >= spool->max_entries) {
+		wpa_printf(MSG_INFO,
+			   "RADIUS spool: Spool full (%u messages) - dropping accounting message",
+			   spool->count);
+		return -1;
+	}
+
+	entry = os_zalloc(sizeof(*entry));
+	if (!entry)
+		return -1;
+	entry->msg = wpabuf_dup(msg);
+	if (!entry->msg) {
+		os_free(entry);
+		return -1;
+	}
+	os_get_time(&now);
+	entry->seq = spool->next_seq++;
+	entry->spooled = now.sec;
+	entry->delay = delay;
+	dl_list_add_tail(&spool->entries, &entry->list);
+	spool->count++;
+
+	wpa_printf(MSG_DEBUG, "RADIUS spool: Added message %llu (%u pending)",
+		   (unsigned long long) entry->seq, spool->count);
+
+	/* Keep the entry in memory even if it could not be written to the
+	 * file so that it can still be sent while hostapd is running. */
+	return acct_spool_append(spool, ACCT_SPOOL_MSG, entry, entry->seq);
+}
+
+
+/**
+ * acct_spool_done - Remove a delivered message from the spool
+ * @spool: Pointer to the spool from acct_spool_init()
+ * @entry: Spool entry
+ */
+void acct_spool_done(struct acct_spool *spool, struct acct_spool_entry *entry)
+{
+	u64 seq = entry->seq;
+
+	acct_spool_entry_free(spool, entry);
+	wpa_printf(MSG_DEBUG,
+		   "RADIUS spool: Message %llu delivered (%u pending)",
+		   (unsigned long long) seq, spool->count);
+	acct_spool_append(spool, ACCT_SPOOL_DONE, NULL, seq);
+}
+
+
+/**
+ * acct_spool_next - Get the oldest message that is not being sent
+ * @spool: Pointer to the spool from acct_spool_init()
+ * Returns: Pointer to the spool entry or %NULL if none
+ */
+struct acct_spool_entry * acct_spool_next(struct acct_spool *spool)
+{
+	struct acct_spool_entry *entry;
+
+	dl_list_for_each(entry, &spool->entries, struct acct_spool_entry,
+			 list) {
+		if (!entry->inflight)
+			return entry;
+	}
+
+	return NULL;
+}
+
+
+/**
+ * acct_spool_get_inflight - Find the entry that is being sent as a message
+ * @spool: Pointer to the spool from acct_spool_init()
+ * @msg: The RADIUS message that was passed to acct_spool_set_inflight()
+ * Returns: Pointer to the spool entry or %NULL if not found
+ */
+struct acct_spool_entry * acct_spool_get_inflight(struct acct_spool *spool,
+						  const void *msg)
+{
+	struct acct_spool_entry *entry;
+
+	if (!spool->num_inflight)
+		return NULL;
+
+	dl_list_for_each(entry, &spool->entries, struct acct_spool_entry,
+			 list) {
+		if (entry->inflight == msg)
+			return entry;
+	}
+
+	return NULL;
+}
+
+
+/**
+ * acct_spool_set_inflight - Mark a spool entry as being sent or not
+ * @spool: Pointer to the spool from acct_spool_init()
+ * @entry: Spool entry
+ * @msg: The RADIUS message that is being sent or %NULL if not being sent
+ */
+void acct_spool_set_inflight(struct acct_spool *spool,
+			     struct acct_spool_entry *entry,
+			     const void *msg)
+{
+	if (entry->inflight && !msg)
+		spool->num_inflight--;
+	else if (!entry->inflight && msg)
+		spool->num_inflight++;
+	entry->inflight = msg;
+}
+
+
+unsigned int acct_spool_count(struct acct_spool *spool)
+{
+	return spool->count;
+}
+
+
+unsigned int acct_spool_num_inflight(struct acct_spool *spool)
+{
+	return spool->num_inflight;
+}
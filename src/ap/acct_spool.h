@@ -0,0 +1,40 @@
+/*
+ * hostapd / Persistent RADIUS accounting spool
+ *
+ * This software may be distributed under the terms of the BSD license.
+ * See README for more details.
+ */
+
+#ifndef ACCT_SPOOL_H
+#define ACCT_SPOOL_H
+
+#include "utils/list.h"
+
+struct acct_spool_entry {
+	struct dl_list list;
+	u64 seq;
+	os_time_t spooled; /* wall clock time when the entry was added */
+	u32 delay; /* Acct-Delay-Time when the entry was added */
+	struct wpabuf *msg;
+	/* RADIUS message that is currently being sent or %NULL */
+	const void *inflight;
+};
+
+struct acct_spool;
+
+struct acct_spool * acct_spool_init(const char *file,
+				    unsigned int max_entries);
+void acct_spool_deinit(struct acct_spool *spool);
+int acct_spool_add(struct acct_spool *spool, const struct wpabuf *msg,
+		   u32 delay);
+void acct_spool_done(struct acct_spool *spool, struct acct_spool_entry *entry);
+struct acct_spool_entry * acct_spool_next(struct acct_spool *spool);
+struct acct_spool_entry * acct_spool_get_inflight(struct acct_spool *spool,
+						  const void *msg);
+void acct_spool_set_inflight(struct acct_spool *spool,
+			     struct acct_spool_entry *entry,
+			     const void *msg);
+unsigned int acct_spool_count(struct acct_spool *spool);
+unsigned int acct_spool_num_inflight(struct acct_spool *spool);
+
+#endif /* ACCT_SPOOL_H */
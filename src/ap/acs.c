@@ -44,11 +44,22 @@
  * 3. ideal channel is picked depending on channel width by using adjacent
  *    channel interference factors
  *
+ * Interference model
+ * ------------------
+ * The interference factors of the channels are kept after the selection and
+ * form a simple model of the environment. Background surveys while the AP is
+ * operating (acs_reeval_interval) are merged into the model as an exponential
+ * moving average and the AP is moved to a clearly better channel with CSA.
+ * The model can be stored in a file (acs_model_file) so that the channel can
+ * be selected without the startup scans the next time.
+ *
  * Known limitations
  * -----------------
- * - Current implementation depends heavily on the amount of time willing to
- *   spend gathering survey data during hostapd startup. Short traffic bursts
- *   may be missed and a suboptimal channel may be picked.
+ * - Without a stored model, the implementation depends heavily on the amount
+ *   of time willing to spend gathering survey data during hostapd startup.
+ *   Short traffic bursts may be missed and a suboptimal channel may be picked.
+ * - Background surveys of the operating channel include the traffic of the
+ *   associated stations.
  * - Ideal channel may end up overlapping a channel with 40 MHz intolerant BSS
  *
  * Todo / Ideas
@@ -58,9 +69,6 @@
  *   - spectral scan based
  *   (should be possibly to hook this up with current ACS scans)
  * - add wpa_supplicant support (for P2P)
- * - collect a histogram of interference over time allowing more educated
- *   guess about an ideal channel (perhaps CSA could be used to migrate AP to a
- *   new "better" channel while running)
  * - include neighboring BSS scan to avoid conflicts with 40 MHz intolerant BSSs
  *   when choosing the ideal channel
  *
@@ -306,9 +314,15 @@ static const struct bw_item *bw_desc[] = {
 };
 
 
+/* Weight of the previous model value when merging a new survey */
+#define ACS_MODEL_OLD_WEIGHT 3
+
 static int acs_request_scan(struct hostapd_iface *iface);
 static int acs_survey_is_sufficient(struct freq_survey *survey);
 static void acs_scan_retry(void *eloop_data, void *user_data);
+static void acs_model_start(void *eloop_data, void *user_data);
+static void acs_reeval_timeout(void *eloop_data, void *user_data);
+static void acs_reeval_scan_complete(struct hostapd_iface *iface);
 
 
 static void acs_clean_chan_surveys(struct hostapd_channel_data *chan)
@@ -356,6 +370,10 @@ void acs_cleanup(struct hostapd_iface *iface)
 	iface->acs_num_completed_scans = 0;
 	iface->acs_num_retries = 0;
 	eloop_cancel_timeout(acs_scan_retry, iface, NULL);
+	eloop_cancel_timeout(acs_model_start, iface, NULL);
+	eloop_cancel_timeout(acs_reeval_timeout, iface, NULL);
+	if (iface->scan_cb == acs_reeval_scan_complete)
+		iface->scan_cb = NULL;
 }
 
 
@@ -404,15 +422,13 @@ acs_survey_chan_interference_factor(struct hostapd_iface *iface,
 {
 	struct freq_survey *survey;
 	unsigned int i = 0;
-	long double int_factor = 0;
+	long double int_factor = 0, factor = 0;
 	unsigned count = 0;
 
 	if (dl_list_empty(&chan->survey_list) ||
 	    (chan->flag & HOSTAPD_CHAN_DISABLED))
 		return;
 
-	chan->interference_factor = 0;
-
 	dl_list_for_each(survey, &chan->survey_list, struct freq_survey, list)
 	{
 		i++;
@@ -425,7 +441,7 @@ acs_survey_chan_interference_factor(struct hostapd_iface *iface,
 		count++;
 		int_factor = acs_survey_interference_factor(survey,
 							    iface->lowest_nf);
-		chan->interference_factor += int_factor;
+		factor += int_factor;
 		wpa_printf(MSG_DEBUG, "ACS: %d: min_nf=%d interference_factor=%Lg nf=%d time=%lu busy=%lu rx=%lu",
 			   i, chan->min_nf, int_factor,
 			   survey->nf, (unsigned long) survey->channel_time,
@@ -433,8 +449,21 @@ acs_survey_chan_interference_factor(struct hostapd_iface *iface,
 			   (unsigned long) survey->channel_time_rx);
 	}
 
-	if (count)
-		chan->interference_factor /= count;
+	if (!count)
+		return;
+	factor /= count;
+
+	if (chan->interference_model_valid) {
+		chan->interference_factor =
+			(ACS_MODEL_OLD_WEIGHT * chan->interference_factor +
+			 factor) / (ACS_MODEL_OLD_WEIGHT + 1);
+		wpa_printf(MSG_DEBUG,
+			   "ACS: Merged survey into model: %Lg",
+			   chan->interference_factor);
+	} else {
+		chan->interference_factor = factor;
+		chan->interference_model_valid = true;
+	}
 }
 
 
@@ -557,9 +586,12 @@ static int acs_surveys_are_sufficient(struct hostapd_iface *iface)
 
 static int acs_usable_chan(struct hostapd_channel_data *chan)
 {
-	return !dl_list_empty(&chan->survey_list) &&
-		!(chan->flag & HOSTAPD_CHAN_DISABLED) &&
-		acs_survey_list_is_sufficient(chan);
+	if (chan->flag & HOSTAPD_CHAN_DISABLED)
+		return 0;
+	if (!dl_list_empty(&chan->survey_list) &&
+	    acs_survey_list_is_sufficient(chan))
+		return 1;
+	return chan->interference_model_valid;
 }
 
 
@@ -697,6 +729,182 @@ acs_find_chan(struct hostapd_iface *iface, int freq)
 	return NULL;
 }
 
+/*
+ * Channel lookup table for one hardware mode. The channels are indexed on the
+ * 5 MHz raster and the interference factors of the usable channels are summed
+ * along 20 MHz steps, so that the total of a bandwidth segment is the
+ * difference of two entries instead of a walk through the channels of the
+ * segment.
+ */
+struct acs_chan_slot {
+	struct hostapd_channel_data *chan;
+	long double factor_sum;
+	int num_usable;
+	int num_allowed; /* channels that allow the bandwidth as secondary */
+};
+
+struct acs_chan_map {
+	int first_freq;
+	int num_slots;
+	struct acs_chan_slot *slot;
+};
+
+#define ACS_SLOT_STEP (20 / 5)
+
+
+static void acs_free_chan_maps(struct hostapd_iface *iface,
+			       struct acs_chan_map *maps)
+{
+	int i;
+
+	if (!maps)
+		return;
+	for (i = 0; i < iface->num_hw_features; i++)
+		os_free(maps[i].slot);
+	os_free(maps);
+}
+
+
+static int acs_build_chan_map(struct hostapd_hw_modes *mode, u32 bw,
+			      struct acs_chan_map *map)
+{
+	struct hostapd_channel_data *chan;
+	struct acs_chan_slot *slot, *prev;
+	int i, s, min_freq = 0, max_freq = 0;
+
+	for (i = 0; i < mode->num_channels; i++) {
+		chan = &mode->channels[i];
+		if ((chan->flag & HOSTAPD_CHAN_DISABLED) || chan->freq % 5)
+			continue;
+		if (!min_freq || chan->freq < min_freq)
+			min_freq = chan->freq;
+		if (chan->freq > max_freq)
+			max_freq = chan->freq;
+	}
+	if (!min_freq)
+		return 0;
+
+	map->first_freq = min_freq;
+	map->num_slots = (max_freq - min_freq) / 5 + 1;
+	map->slot = os_calloc(map->num_slots, sizeof(*map->slot));
+	if (!map->slot)
+		return -1;
+
+	for (i = 0; i < mode->num_channels; i++) {
+		chan = &mode->channels[i];
+		if ((chan->flag & HOSTAPD_CHAN_DISABLED) || chan->freq % 5)
+			continue;
+		slot = &map->slot[(chan->freq - min_freq) / 5];
+		if (!slot->chan)
+			slot->chan = chan;
+	}
+
+	for (s = 0; s < map->num_slots; s++) {
+		slot = &map->slot[s];
+		chan = slot->chan;
+		if (chan && acs_usable_chan(chan)) {
+			slot->factor_sum = chan->interference_factor;
+			slot->num_usable = 1;
+		}
+		if (chan && chan_bw_allowed(chan, bw, 1, 0))
+			slot->num_allowed = 1;
+		if (s < ACS_SLOT_STEP)
+			continue;
+		prev = &map->slot[s - ACS_SLOT_STEP];
+		slot->factor_sum += prev->factor_sum;
+		slot->num_usable += prev->num_usable;
+		slot->num_allowed += prev->num_allowed;
+	}
+
+	return 0;
+}
+
+
+static struct acs_chan_map *
+acs_build_chan_maps(struct hostapd_iface *iface, u32 bw)
+{
+	struct acs_chan_map *maps;
+	int i;
+
+	maps = os_calloc(iface->num_hw_features, sizeof(*maps));
+	if (!maps)
+		return NULL;
+
+	for (i = 0; i < iface->num_hw_features; i++) {
+		struct hostapd_hw_modes *mode = &iface->hw_features[i];
+
+		if (!hostapd_hw_skip_mode(iface, mode) &&
+		    acs_build_chan_map(mode, bw, &maps[i]) < 0) {
+			acs_free_chan_maps(iface, maps);
+			return NULL;
+		}
+	}
+
+	return maps;
+}
+
+
+/* Same as acs_find_chan(), but using the lookup tables if available */
+static struct hostapd_channel_data *
+acs_lookup_chan(struct hostapd_iface *iface, const struct acs_chan_map *maps,
+		int freq)
+{
+	const struct acs_chan_map *map;
+	int i;
+
+	if (!maps || freq % 5)
+		return acs_find_chan(iface, freq);
+
+	for (i = 0; i < iface->num_hw_features; i++) {
+		map = &maps[i];
+		if (!map->slot || freq < map->first_freq ||
+		    freq >= map->first_freq + map->num_slots * 5)
+			continue;
+		if (map->slot[(freq - map->first_freq) / 5].chan)
+			return map->slot[(freq - map->first_freq) / 5].chan;
+	}
+
+	return NULL;
+}
+
+
+/*
+ * Sum the secondary channels of the segment that starts from primary channel
+ * freq and extends n_chans - 1 steps of 20 MHz in the direction dir (1 or -1).
+ * Returns false if the segment is not fully covered by the lookup table.
+ */
+static bool acs_chan_map_segment(const struct acs_chan_map *map, int freq,
+				 int n_chans, int dir, long double *factor,
+				 int *num_usable, int *num_allowed)
+{
+	const struct acs_chan_slot *hi, *lo;
+	int pri, first, last;
+
+	if (!map || !map->slot || n_chans < 2 || freq % 5 ||
+	    freq < map->first_freq)
+		return false;
+
+	pri = (freq - map->first_freq) / 5;
+	if (dir > 0) {
+		first = pri + ACS_SLOT_STEP;
+		last = pri + (n_chans - 1) * ACS_SLOT_STEP;
+	} else {
+		first = pri - (n_chans - 1) * ACS_SLOT_STEP;
+		last = pri - ACS_SLOT_STEP;
+	}
+	if (first < 0 || last >= map->num_slots)
+		return false;
+
+	hi = &map->slot[last];
+	lo = first >= ACS_SLOT_STEP ? &map->slot[first - ACS_SLOT_STEP] : NULL;
+	*factor = hi->factor_sum - (lo ? lo->factor_sum : 0);
+	*num_usable = hi->num_usable - (lo ? lo->num_usable : 0);
+	*num_allowed = hi->num_allowed - (lo ? lo->num_allowed : 0);
+
+	return true;
+}
+
+
 
 static int is_24ghz_mode(enum hostapd_hw_mode mode)
 {
@@ -731,6 +939,7 @@ static int is_common_24ghz_chan(int chan)
 
 #ifdef CONFIG_IEEE80211BE
 static void acs_update_puncturing_bitmap(struct hostapd_iface *iface,
+					 const struct acs_chan_map *maps,
 					 struct hostapd_hw_modes *mode, u32 bw,
 					 int n_chans,
 					 struct hostapd_channel_data *chan,
@@ -764,7 +973,7 @@ static void acs_update_puncturing_bitmap(struct hostapd_iface *iface,
 		else
 			adj_freq = chan->freq - (index_primary - i) * 20;
 
-		adj_chan = acs_find_chan(iface, adj_freq);
+		adj_chan = acs_lookup_chan(iface, maps, adj_freq);
 		if (!adj_chan) {
 			chan->punct_bitmap = 0;
 			return;
@@ -822,15 +1031,17 @@ acs_usable_bw320_chan(struct hostapd_iface *iface,
 
 static void
 acs_find_ideal_chan_mode(struct hostapd_iface *iface,
+			 const struct acs_chan_map *maps,
 			 struct hostapd_hw_modes *mode,
 			 int n_chans, u32 bw,
 			 struct hostapd_channel_data **rand_chan,
 			 struct hostapd_channel_data **ideal_chan,
-			 long double *ideal_factor)
+			 long double *ideal_factor, long double *cur_factor)
 {
-	struct hostapd_channel_data *chan, *adj_chan = NULL, *best;
-	long double factor;
-	int i, j;
+	struct hostapd_channel_data *chan, *adj_chan = NULL, *best, *pri_chan;
+	const struct acs_chan_map *map = NULL;
+	long double factor, seg_factor;
+	int i, j, seg_usable, seg_allowed;
 	int bw320_offset = 0, ideal_bw320_offset = 0;
 	unsigned int k;
 	int secondary_channel = 1, freq_offset;
@@ -841,11 +1052,14 @@ acs_find_ideal_chan_mode(struct hostapd_iface *iface,
 	if (is_24ghz_mode(mode->mode))
 		secondary_channel = iface->conf->secondary_channel;
 
+	if (maps)
+		map = &maps[mode - iface->hw_features];
+
 	for (i = 0; i < mode->num_channels; i++) {
 		double total_weight = 0;
 		struct acs_bias *bias, tmp_bias;
 
-		chan = &mode->channels[i];
+		chan = pri_chan = &mode->channels[i];
 
 		/* Since in the current ACS implementation the first channel is
 		 * always a primary channel, skip channels not available as
@@ -935,9 +1149,38 @@ acs_find_ideal_chan_mode(struct hostapd_iface *iface,
 			best = chan;
 		}
 
-		for (j = 1; j < n_chans; j++) {
-			adj_chan = acs_find_chan(iface, chan->freq +
-						 j * secondary_channel * 20);
+		if (acs_chan_map_segment(map, chan->freq, n_chans,
+					 secondary_channel, &seg_factor,
+					 &seg_usable, &seg_allowed) &&
+		    seg_allowed == n_chans - 1) {
+			/* All secondary channels exist and allow the
+			 * bandwidth, so the totals from the lookup table can be
+			 * used. The best channel is needed only for 5 GHz and
+			 * 6 GHz. */
+			int pri_slot = (chan->freq - map->first_freq) / 5;
+
+			factor += seg_factor;
+			total_weight += seg_usable;
+			for (j = 1; seg_usable && iface->current_mode &&
+				     iface->current_mode->mode ==
+				     HOSTAPD_MODE_IEEE80211A && j < n_chans;
+			     j++) {
+				adj_chan = map->slot[pri_slot +
+						     j * secondary_channel *
+						     ACS_SLOT_STEP].chan;
+				if (acs_usable_chan(adj_chan) &&
+				    (!best || adj_chan->interference_factor <
+				     best->interference_factor))
+					best = adj_chan;
+			}
+			j = n_chans;
+		} else {
+			j = 1;
+		}
+
+		for (; j < n_chans; j++) {
+			adj_chan = acs_lookup_chan(iface, maps, chan->freq +
+						   j * secondary_channel * 20);
 			if (!adj_chan)
 				break;
 
@@ -987,32 +1230,36 @@ acs_find_ideal_chan_mode(struct hostapd_iface *iface,
 		if (is_24ghz_mode(mode->mode)) {
 			for (j = 0; j < n_chans; j++) {
 				freq_offset = j * 20 * secondary_channel;
-				adj_chan = acs_find_chan(iface, chan->freq +
-							 freq_offset - 5);
+				adj_chan = acs_lookup_chan(iface, maps,
+							   chan->freq +
+							   freq_offset - 5);
 				if (adj_chan && acs_usable_chan(adj_chan)) {
 					factor += ACS_ADJ_WEIGHT *
 						adj_chan->interference_factor;
 					total_weight += ACS_ADJ_WEIGHT;
 				}
 
-				adj_chan = acs_find_chan(iface, chan->freq +
-							 freq_offset - 10);
+				adj_chan = acs_lookup_chan(iface, maps,
+							   chan->freq +
+							   freq_offset - 10);
 				if (adj_chan && acs_usable_chan(adj_chan)) {
 					factor += ACS_NEXT_ADJ_WEIGHT *
 						adj_chan->interference_factor;
 					total_weight += ACS_NEXT_ADJ_WEIGHT;
 				}
 
-				adj_chan = acs_find_chan(iface, chan->freq +
-							 freq_offset + 5);
+				adj_chan = acs_lookup_chan(iface, maps,
+							   chan->freq +
+							   freq_offset + 5);
 				if (adj_chan && acs_usable_chan(adj_chan)) {
 					factor += ACS_ADJ_WEIGHT *
 						adj_chan->interference_factor;
 					total_weight += ACS_ADJ_WEIGHT;
 				}
 
-				adj_chan = acs_find_chan(iface, chan->freq +
-							 freq_offset + 10);
+				adj_chan = acs_lookup_chan(iface, maps,
+							   chan->freq +
+							   freq_offset + 10);
 				if (adj_chan && acs_usable_chan(adj_chan)) {
 					factor += ACS_NEXT_ADJ_WEIGHT *
 						adj_chan->interference_factor;
@@ -1052,6 +1299,13 @@ acs_find_ideal_chan_mode(struct hostapd_iface *iface,
 				   chan->chan, factor);
 		}
 
+		/* Total interference of the segment of the operating channel */
+		if (cur_factor && acs_usable_chan(chan) &&
+		    (pri_chan->freq == iface->freq ||
+		     chan->freq == iface->freq) &&
+		    (*cur_factor < 0 || factor < *cur_factor))
+			*cur_factor = factor;
+
 		if (acs_usable_chan(chan) &&
 		    (!*ideal_chan || factor < *ideal_factor)) {
 			/* Reset puncturing bitmap for the previous ideal
@@ -1065,7 +1319,8 @@ acs_find_ideal_chan_mode(struct hostapd_iface *iface,
 
 #ifdef CONFIG_IEEE80211BE
 			if (iface->conf->ieee80211be)
-				acs_update_puncturing_bitmap(iface, mode, bw,
+				acs_update_puncturing_bitmap(iface, maps,
+							     mode, bw,
 							     n_chans, chan,
 							     factor,
 							     index_primary);
@@ -1088,9 +1343,13 @@ acs_find_ideal_chan_mode(struct hostapd_iface *iface,
  * This function should be reusable regardless of interference computation
  * option (survey, BSS, spectral, ...). chan->interference factor must be
  * summable (i.e., must be always greater than zero).
+ *
+ * If cur_factor is not %NULL, it is set to the total interference factor of
+ * the segment of the current operating channel or to -1 if not known.
  */
 static struct hostapd_channel_data *
-acs_find_ideal_chan(struct hostapd_iface *iface)
+acs_find_ideal_chan(struct hostapd_iface *iface, long double *factor_out,
+		    long double *cur_factor)
 {
 	struct hostapd_channel_data *ideal_chan = NULL,
 		*rand_chan = NULL;
@@ -1099,6 +1358,8 @@ acs_find_ideal_chan(struct hostapd_iface *iface)
 	int n_chans = 1;
 	u32 bw;
 	struct hostapd_hw_modes *mode;
+	struct acs_chan_map *maps;
+	struct os_reltime start, end, diff;
 
 	if (is_6ghz_op_class(iface->conf->op_class)) {
 		bw = op_class_to_bandwidth(iface->conf->op_class);
@@ -1135,14 +1396,26 @@ bw_selected:
 	wpa_printf(MSG_DEBUG,
 		   "ACS: Survey analysis for selected bandwidth %d MHz", bw);
 
+	os_get_reltime(&start);
+	/* Without the lookup tables, the channels are searched one by one */
+	maps = acs_build_chan_maps(iface, bw);
+	if (cur_factor)
+		*cur_factor = -1;
 	for (i = 0; i < iface->num_hw_features; i++) {
 		mode = &iface->hw_features[i];
 		if (!hostapd_hw_skip_mode(iface, mode))
-			acs_find_ideal_chan_mode(iface, mode, n_chans, bw,
-						 &rand_chan, &ideal_chan,
-						 &ideal_factor);
+			acs_find_ideal_chan_mode(iface, maps, mode, n_chans,
+						 bw, &rand_chan, &ideal_chan,
+						 &ideal_factor, cur_factor);
 	}
-
+	acs_free_chan_maps(iface, maps);
+	os_get_reltime(&end);
+	os_reltime_sub(&end, &start, &diff);
+	wpa_printf(MSG_DEBUG, "ACS: Survey analysis took %ld usec",
+		   (long) (diff.sec * 1000000 + diff.usec));
+
+	if (factor_out)
+		*factor_out = ideal_chan ? ideal_factor : -1;
 	if (ideal_chan) {
 		wpa_printf(MSG_DEBUG, "ACS: Ideal channel is %d (%d MHz) with total interference factor of %Lg",
 			   ideal_chan->chan, ideal_chan->freq, ideal_factor);
@@ -1266,18 +1539,119 @@ static int acs_study_options(struct hostapd_iface *iface)
 }
 
 
-static void acs_study(struct hostapd_iface *iface)
+static void acs_model_save(struct hostapd_iface *iface)
+{
+	const char *fname = iface->conf->acs_model_file;
+	struct hostapd_hw_modes *mode;
+	struct hostapd_channel_data *chan;
+	char *tmp;
+	size_t len;
+	FILE *f;
+	int i, j, ret = 0;
+
+	if (!fname)
+		return;
+
+	len = os_strlen(fname) + 5;
+	tmp = os_malloc(len);
+	if (!tmp)
+		return;
+	os_snprintf(tmp, len, "%s.tmp", fname);
+
+	f = fopen(tmp, "w");
+	if (!f) {
+		wpa_printf(MSG_INFO, "ACS: Could not write model file '%s': %s",
+			   tmp, strerror(errno));
+		os_free(tmp);
+		return;
+	}
+	if (fprintf(f, "# hostapd ACS interference model\n") < 0)
+		ret = -1;
+	for (i = 0; i < iface->num_hw_features; i++) {
+		mode = &iface->hw_features[i];
+		for (j = 0; j < mode->num_channels; j++) {
+			chan = &mode->channels[j];
+			if (chan->interference_model_valid &&
+			    fprintf(f, "%d %Lg\n", chan->freq,
+				    chan->interference_factor) < 0)
+				ret = -1;
+		}
+	}
+	if (fclose(f) != 0)
+		ret = -1;
+
+	if (ret < 0 || rename(tmp, fname) < 0) {
+		wpa_printf(MSG_INFO, "ACS: Could not update model file '%s'",
+			   fname);
+		unlink(tmp);
+	}
+	os_free(tmp);
+}
+
+
+static int acs_model_load(struct hostapd_iface *iface)
+{
+	struct hostapd_channel_data *chan;
+	long double factor;
+	char buf[100];
+	int freq, num = 0;
+	FILE *f;
+
+	if (!iface->conf->acs_model_file)
+		return 0;
+
+	f = fopen(iface->conf->acs_model_file, "r");
+	if (!f)
+		return 0;
+
+	while (fgets(buf, sizeof(buf), f)) {
+		if (buf[0] == '#' ||
+		    sscanf(buf, "%d %Lg", &freq, &factor) != 2 ||
+		    !(factor > 0))
+			continue;
+		chan = acs_find_chan(iface, freq);
+		if (!chan || (chan->flag & HOSTAPD_CHAN_DISABLED))
+			continue;
+		chan->interference_factor = factor;
+		chan->interference_model_valid = true;
+		num++;
+	}
+	fclose(f);
+
+	wpa_printf(MSG_DEBUG,
+		   "ACS: Loaded interference model for %d channels from '%s'",
+		   num, iface->conf->acs_model_file);
+	return num;
+}
+
+
+static void acs_reeval_schedule(struct hostapd_iface *iface)
+{
+	eloop_cancel_timeout(acs_reeval_timeout, iface, NULL);
+	if (iface->conf->acs_reeval_interval)
+		eloop_register_timeout(iface->conf->acs_reeval_interval, 0,
+				       acs_reeval_timeout, iface, NULL);
+}
+
+
+static void acs_study(struct hostapd_iface *iface, bool use_model)
 {
 	struct hostapd_channel_data *ideal_chan;
 	int err;
 
-	err = acs_study_options(iface);
-	if (err < 0) {
-		wpa_printf(MSG_ERROR, "ACS: All study options have failed");
-		goto fail;
+	if (use_model) {
+		wpa_printf(MSG_DEBUG, "ACS: Using stored interference model");
+	} else {
+		err = acs_study_options(iface);
+		if (err < 0) {
+			wpa_printf(MSG_ERROR,
+				   "ACS: All study options have failed");
+			goto fail;
+		}
+		acs_model_save(iface);
 	}
 
-	ideal_chan = acs_find_ideal_chan(iface);
+	ideal_chan = acs_find_ideal_chan(iface, NULL, NULL);
 	if (!ideal_chan) {
 		wpa_printf(MSG_ERROR, "ACS: Failed to compute ideal channel");
 		err = -1;
@@ -1313,6 +1687,7 @@ fail:
 	 */
 	if (hostapd_acs_completed(iface, err) == HOSTAPD_CHAN_VALID) {
 		acs_cleanup(iface);
+		acs_reeval_schedule(iface);
 		return;
 	}
 
@@ -1349,7 +1724,7 @@ static void acs_scan_complete(struct hostapd_iface *iface)
 		return;
 	}
 
-	acs_study(iface);
+	acs_study(iface, false);
 	return;
 fail:
 	hostapd_acs_completed(iface, 1);
@@ -1391,15 +1766,12 @@ static int * acs_request_scan_add_freqs(struct hostapd_iface *iface,
 }
 
 
-static int acs_request_scan(struct hostapd_iface *iface)
+static int * acs_scan_freqs(struct hostapd_iface *iface)
 {
-	struct wpa_driver_scan_params params;
-	int i, *freq, ret;
+	int i, *freqs, *freq;
 	int num_channels;
 	struct hostapd_hw_modes *mode;
 
-	os_memset(&params, 0, sizeof(params));
-
 	num_channels = 0;
 	for (i = 0; i < iface->num_hw_features; i++) {
 		mode = &iface->hw_features[i];
@@ -1407,11 +1779,11 @@ static int acs_request_scan(struct hostapd_iface *iface)
 			num_channels += mode->num_channels;
 	}
 
-	params.freqs = os_calloc(num_channels + 1, sizeof(params.freqs[0]));
-	if (params.freqs == NULL)
-		return -1;
+	freqs = os_calloc(num_channels + 1, sizeof(freqs[0]));
+	if (!freqs)
+		return NULL;
 
-	freq = params.freqs;
+	freq = freqs;
 
 	for (i = 0; i < iface->num_hw_features; i++) {
 		mode = &iface->hw_features[i];
@@ -1421,12 +1793,26 @@ static int acs_request_scan(struct hostapd_iface *iface)
 
 	*freq = 0;
 
-	if (params.freqs == freq) {
+	if (freqs == freq) {
 		wpa_printf(MSG_ERROR, "ACS: No available channels found");
-		os_free(params.freqs);
-		return -1;
+		os_free(freqs);
+		return NULL;
 	}
 
+	return freqs;
+}
+
+
+static int acs_request_scan(struct hostapd_iface *iface)
+{
+	struct wpa_driver_scan_params params;
+	int ret;
+
+	os_memset(&params, 0, sizeof(params));
+	params.freqs = acs_scan_freqs(iface);
+	if (!params.freqs)
+		return -1;
+
 	if (!iface->acs_num_retries)
 		wpa_printf(MSG_DEBUG, "ACS: Scanning %d / %d",
 			   iface->acs_num_completed_scans + 1,
@@ -1471,6 +1857,208 @@ static int acs_request_scan(struct hostapd_iface *iface)
 }
 
 
+static int acs_reeval_segment_has_radar(struct hostapd_iface *iface,
+					int center_freq)
+{
+	struct hostapd_channel_data *chan;
+	int bw, freq;
+
+	switch (hostapd_get_oper_chwidth(iface->conf)) {
+	case CONF_OPER_CHWIDTH_80MHZ:
+		bw = 80;
+		break;
+	case CONF_OPER_CHWIDTH_160MHZ:
+		bw = 160;
+		break;
+	case CONF_OPER_CHWIDTH_320MHZ:
+		bw = 320;
+		break;
+	default:
+		bw = iface->conf->secondary_channel ? 40 : 20;
+		break;
+	}
+
+	for (freq = center_freq - bw / 2 + 10; freq < center_freq + bw / 2;
+	     freq += 20) {
+		chan = acs_find_chan(iface, freq);
+		if (!chan || (chan->flag & HOSTAPD_CHAN_RADAR))
+			return 1;
+	}
+
+	return 0;
+}
+
+
+static void acs_reeval_switch(struct hostapd_iface *iface,
+			      struct hostapd_channel_data *chan)
+{
+	struct hostapd_config *conf = iface->conf;
+	struct hostapd_hw_modes *cmode = iface->current_mode;
+	struct csa_settings settings;
+	int old_freq = iface->freq, old_sec = conf->secondary_channel;
+	u8 old_chan = conf->channel;
+	u8 old_seg0 = hostapd_get_oper_centr_freq_seg0_idx(conf);
+	int sec, center_freq;
+	u8 seg0;
+	unsigned int i, num_err = 0;
+
+	if (!cmode)
+		return;
+
+	/* Use the same adjustments as the initial selection and restore the
+	 * current parameters since they are updated only once the CSA has
+	 * been completed. */
+	conf->channel = chan->chan;
+	iface->freq = chan->freq;
+	if (conf->ieee80211ac || conf->ieee80211ax || conf->ieee80211be) {
+		acs_adjust_secondary(iface);
+		acs_adjust_center_freq(iface);
+	}
+	sec = conf->secondary_channel;
+	seg0 = hostapd_get_oper_centr_freq_seg0_idx(conf);
+	conf->channel = old_chan;
+	iface->freq = old_freq;
+	conf->secondary_channel = old_sec;
+	hostapd_set_oper_centr_freq_seg0_idx(conf, old_seg0);
+
+	if (!seg0 ||
+	    hostapd_get_oper_chwidth(conf) == CONF_OPER_CHWIDTH_USE_HT)
+		center_freq = chan->freq + sec * 10;
+	else if (is_6ghz_freq(chan->freq))
+		center_freq = 5950 + seg0 * 5;
+	else
+		center_freq = 5000 + seg0 * 5;
+	if (acs_reeval_segment_has_radar(iface, center_freq)) {
+		wpa_printf(MSG_DEBUG,
+			   "ACS: Do not move to DFS channel %d in background",
+			   chan->chan);
+		return;
+	}
+
+	os_memset(&settings, 0, sizeof(settings));
+	settings.cs_count = 5;
+	settings.link_id = -1;
+#ifdef CONFIG_IEEE80211BE
+	if (iface->bss[0]->conf->mld_ap)
+		settings.link_id = iface->bss[0]->mld_link_id;
+#endif /* CONFIG_IEEE80211BE */
+	if (hostapd_set_freq_params(&settings.freq_params, conf->hw_mode,
+				    chan->freq, chan->chan,
+				    conf->enable_edmg, conf->edmg_channel,
+				    conf->ieee80211n, conf->ieee80211ac,
+				    conf->ieee80211ax, conf->ieee80211be,
+				    sec, hostapd_get_oper_chwidth(conf),
+				    seg0, 0, cmode->vht_capab,
+				    &cmode->he_capab[IEEE80211_MODE_AP],
+				    &cmode->eht_capab[IEEE80211_MODE_AP],
+				    0)) {
+		wpa_printf(MSG_DEBUG,
+			   "ACS: Failed to calculate CSA freq params");
+		return;
+	}
+
+	wpa_msg(iface->bss[0]->msg_ctx, MSG_INFO, ACS_EVENT_RESELECTED
+		"freq=%d channel=%d", chan->freq, chan->chan);
+	for (i = 0; i < iface->num_bss; i++) {
+		if (hostapd_switch_channel(iface->bss[i], &settings))
+			num_err++;
+	}
+	if (num_err)
+		wpa_printf(MSG_INFO,
+			   "ACS: Failed to schedule CSA on %u BSS(s)", num_err);
+}
+
+
+static void acs_reeval_scan_complete(struct hostapd_iface *iface)
+{
+	struct hostapd_channel_data *ideal_chan;
+	long double ideal_factor, cur_factor;
+#ifdef CONFIG_IEEE80211BE
+	u8 bw320_offset = iface->conf->eht_bw320_offset;
+#endif /* CONFIG_IEEE80211BE */
+
+	iface->scan_cb = NULL;
+
+	if (hostapd_drv_get_survey(iface->bss[0], 0) || !iface->chans_surveyed) {
+		wpa_printf(MSG_DEBUG, "ACS: No background survey data");
+		goto out;
+	}
+
+	acs_survey_all_chans_interference_factor(iface);
+	acs_model_save(iface);
+
+	ideal_chan = acs_find_ideal_chan(iface, &ideal_factor, &cur_factor);
+#ifdef CONFIG_IEEE80211BE
+	/* The operating channel is changed only through the CSA */
+	iface->conf->eht_bw320_offset = bw320_offset;
+#endif /* CONFIG_IEEE80211BE */
+	if (!ideal_chan || ideal_factor < 0 || cur_factor < 0 ||
+	    ideal_chan->freq == iface->freq)
+		goto out;
+
+	wpa_printf(MSG_DEBUG,
+		   "ACS: Background evaluation: current %d MHz %Lg, best %d MHz %Lg",
+		   iface->freq, cur_factor, ideal_chan->freq, ideal_factor);
+	if (ideal_factor * (100 + iface->conf->acs_reeval_threshold) <
+	    cur_factor * 100 && !hostapd_csa_in_progress(iface))
+		acs_reeval_switch(iface, ideal_chan);
+
+out:
+	acs_cleanup(iface);
+	acs_reeval_schedule(iface);
+}
+
+
+static void acs_reeval_timeout(void *eloop_data, void *user_data)
+{
+	struct hostapd_iface *iface = eloop_data;
+	struct wpa_driver_scan_params params;
+	int ret;
+
+	if (iface->state != HAPD_IFACE_ENABLED || iface->scan_cb ||
+	    hostapd_csa_in_progress(iface)) {
+		acs_reeval_schedule(iface);
+		return;
+	}
+
+	acs_cleanup(iface);
+	os_memset(&params, 0, sizeof(params));
+	params.freqs = acs_scan_freqs(iface);
+	if (!params.freqs) {
+		acs_reeval_schedule(iface);
+		return;
+	}
+
+	wpa_printf(MSG_DEBUG, "ACS: Background survey scan");
+	ret = hostapd_driver_scan(iface->bss[0], &params);
+	os_free(params.freqs);
+	if (ret < 0) {
+		wpa_printf(MSG_DEBUG, "ACS: Background scan failed: %d", ret);
+		acs_reeval_schedule(iface);
+		return;
+	}
+
+	iface->scan_cb = acs_reeval_scan_complete;
+}
+
+
+static void acs_model_start(void *eloop_data, void *user_data)
+{
+	struct hostapd_iface *iface = eloop_data;
+	long double factor;
+
+	if (acs_find_ideal_chan(iface, &factor, NULL) && factor >= 0) {
+		acs_study(iface, true);
+		return;
+	}
+
+	wpa_printf(MSG_DEBUG,
+		   "ACS: No usable channel in the stored model - scan");
+	if (acs_request_scan(iface) < 0)
+		acs_fail(iface);
+}
+
+
 static void acs_scan_retry(void *eloop_data, void *user_data)
 {
 	struct hostapd_iface *iface = eloop_data;
@@ -1508,8 +2096,13 @@ enum hostapd_chan_status acs_init(struct hostapd_iface *iface)
 
 	acs_cleanup(iface);
 
-	if (acs_request_scan(iface) < 0)
+	if (acs_model_load(iface) > 0) {
+		/* Select the channel based on the model without scanning.
+		 * The result is reported from the eloop like after scans. */
+		eloop_register_timeout(0, 0, acs_model_start, iface, NULL);
+	} else if (acs_request_scan(iface) < 0) {
 		return HOSTAPD_CHAN_INVALID;
+	}
 
 	hostapd_set_state(iface, HAPD_IFACE_ACS);
 	wpa_msg(iface->bss[0]->msg_ctx, MSG_INFO, ACS_EVENT_STARTED);
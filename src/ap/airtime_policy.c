@@ -34,6 +34,7 @@
  */
 
 static int get_airtime_policy_update_timeout(struct hostapd_iface *iface,
+					     unsigned int factor,
 					     unsigned int *sec,
 					     unsigned int *usec)
 {
@@ -46,6 +47,7 @@ static int get_airtime_policy_update_timeout(struct hostapd_iface *iface,
 		return -1;
 	}
 
+	update_int *= factor;
 	*sec = update_int / 1000;
 	*usec = (update_int % 1000) * 1000;
 
@@ -70,15 +72,28 @@ static void set_new_backlog_time(struct hostapd_data *hapd,
 static void count_backlogged_sta(struct hostapd_data *hapd)
 {
 	struct sta_info *sta;
-	struct hostap_sta_driver_data data = {};
+	struct hostap_sta_driver_data data = {}, *drv_data;
 	unsigned int num_backlogged = 0;
 	struct os_reltime now;
+	bool bulk;
+
+	/* Fetch the queue status of all stations with a single driver
+	 * request when possible instead of polling each station separately.
+	 * Since this is done just before the polling would be done, the
+	 * fresh results are also available to other users of the cache. */
+	bulk = hapd->sta_list && ap_sta_refresh_drv_data(hapd, true) == 0;
 
 	os_get_reltime(&now);
 
 	for (sta = hapd->sta_list; sta; sta = sta->next) {
-		if (hostapd_drv_read_sta_data(hapd, &data, sta->addr))
+		if (bulk) {
+			drv_data = ap_sta_get_drv_data(hapd, sta);
+			if (!drv_data)
+				continue;
+			data = *drv_data;
+		} else if (hostapd_drv_read_sta_data(hapd, &data, sta->addr)) {
 			continue;
+		}
 #ifdef CONFIG_TESTING_OPTIONS
 		if (hapd->force_backlog_bytes)
 			data.backlog_bytes = 1;
@@ -219,7 +234,13 @@ static void update_airtime_weights(void *eloop_data, void *user_data)
 		set_sta_weights(bss, bss->airtime_weight * quantum);
 	}
 
-	if (get_airtime_policy_update_timeout(iface, &sec, &usec) < 0)
+	/* All stations have unit weights while none of them is backlogged, so
+	 * there is nothing to rebalance until traffic starts. Poll less
+	 * frequently in that state to avoid waking up the driver for each
+	 * station every interval on an idle AP. */
+	if (get_airtime_policy_update_timeout(
+		    iface, num_bss ? 1 : AIRTIME_IDLE_UPDATE_FACTOR,
+		    &sec, &usec) < 0)
 		return;
 
 	eloop_register_timeout(sec, usec, update_airtime_weights, iface,
@@ -259,7 +280,7 @@ int airtime_policy_update_init(struct hostapd_iface *iface)
 	if (iface->conf->airtime_mode < AIRTIME_MODE_DYNAMIC)
 		return 0;
 
-	if (get_airtime_policy_update_timeout(iface, &sec, &usec) < 0)
+	if (get_airtime_policy_update_timeout(iface, 1, &sec, &usec) < 0)
 		return -1;
 
 	eloop_register_timeout(sec, usec, update_airtime_weights, iface, NULL);
@@ -15,6 +15,8 @@ struct hostapd_iface;
 
 #define AIRTIME_DEFAULT_UPDATE_INTERVAL 200 /* ms */
 #define AIRTIME_BACKLOG_EXPIRY_FACTOR 2500 /* 2.5 intervals + convert to usec */
+/* update interval multiplier when no station is backlogged */
+#define AIRTIME_IDLE_UPDATE_FACTOR 4
 
 /* scale quantum so this becomes the effective quantum after applying the max
  * weight, but never go below min or above max */
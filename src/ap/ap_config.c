@@ -7,9 +7,11 @@
  */
 
 #include "utils/includes.h"
+#include <sys/stat.h>
 
 #include "utils/common.h"
 #include "crypto/sha1.h"
+#include "crypto/sha256.h"
 #include "crypto/tls.h"
 #include "radius/radius_client.h"
 #include "common/ieee802_11_defs.h"
@@ -22,6 +24,7 @@
 #include "wpa_auth.h"
 #include "sta_info.h"
 #include "airtime_policy.h"
+#include "steering.h"
 #include "ap_config.h"
 
 
@@ -84,6 +87,7 @@ void hostapd_config_defaults_bss(struct hostapd_bss_config *bss)
 	bss->rsn_pairwise = 0;
 
 	bss->max_num_sta = MAX_STA_COUNT;
+	bss->radius_acl_cache_size = 1024;
 
 	bss->dtim_period = 2;
 
@@ -92,6 +96,9 @@ void hostapd_config_defaults_bss(struct hostapd_bss_config *bss)
 	bss->eap_sim_id = 3;
 	bss->eap_sim_aka_fast_reauth_limit = 1000;
 	bss->ap_max_inactivity = AP_MAX_INACTIVITY;
+	bss->sta_stats_interval = AP_STA_DRV_DATA_DEFAULT_INTERVAL;
+	bss->acct_spool_max = ACCT_SPOOL_DEFAULT_MAX;
+	bss->acct_spool_rate = ACCT_SPOOL_DEFAULT_RATE;
 	bss->bss_max_idle = 1;
 	bss->eapol_version = EAPOL_VERSION;
 
@@ -118,6 +125,7 @@ void hostapd_config_defaults_bss(struct hostapd_bss_config *bss)
 	bss->rkh_neg_timeout = 60;
 	bss->rkh_pull_timeout = 1000;
 	bss->rkh_pull_retries = 4;
+	bss->pmk_r1_push_count = 3;
 	bss->r0_key_lifetime = 1209600;
 #endif /* CONFIG_IEEE80211R_AP */
 
@@ -273,6 +281,7 @@ struct hostapd_config * hostapd_config_defaults(void)
 	conf->acs_ch_list.num = 0;
 #ifdef CONFIG_ACS
 	conf->acs_num_scans = 5;
+	conf->acs_reeval_threshold = 50;
 #endif /* CONFIG_ACS */
 
 #ifdef CONFIG_IEEE80211AX
@@ -305,6 +314,11 @@ struct hostapd_config * hostapd_config_defaults(void)
 #ifdef CONFIG_AIRTIME_POLICY
 	conf->airtime_update_interval = AIRTIME_DEFAULT_UPDATE_INTERVAL;
 #endif /* CONFIG_AIRTIME_POLICY */
+#ifdef CONFIG_STEERING
+	conf->steering_min_rssi = STEERING_DEFAULT_MIN_RSSI;
+	conf->steering_interval = STEERING_DEFAULT_INTERVAL;
+	conf->steering_backoff = STEERING_DEFAULT_BACKOFF;
+#endif /* CONFIG_STEERING */
 
 	hostapd_set_and_check_bw320_offset(conf, 0);
 
@@ -318,6 +332,221 @@ int hostapd_mac_comp(const void *a, const void *b)
 }
 
 
+/*
+ * Persistent cache of PSKs derived from wpa_psk_file passphrases. The file
+ * consists of HOSTAPD_PSK_CACHE_MAGIC followed by records sorted by key. Each
+ * record is SHA-256(ssid_len | ssid | passphrase) followed by the PSK, so
+ * that a reload needs to run PBKDF2 only for new or changed lines.
+ */
+#define HOSTAPD_PSK_CACHE_MAGIC "hapdpsk1"
+#define HOSTAPD_PSK_CACHE_MAGIC_LEN 8
+#define HOSTAPD_PSK_CACHE_KEY_LEN SHA256_MAC_LEN
+#define HOSTAPD_PSK_CACHE_REC_LEN (HOSTAPD_PSK_CACHE_KEY_LEN + PMK_LEN)
+
+struct hostapd_psk_cache {
+	u8 *recs;
+	size_t num;
+	size_t alloc;
+	char *buf; /* file contents backing recs for a loaded cache */
+};
+
+
+static int hostapd_psk_cache_cmp(const void *a, const void *b)
+{
+	return os_memcmp(a, b, HOSTAPD_PSK_CACHE_KEY_LEN);
+}
+
+
+static void hostapd_psk_cache_load(struct hostapd_psk_cache *cache,
+				   const char *fname)
+{
+	size_t len;
+	char *buf;
+
+	os_memset(cache, 0, sizeof(*cache));
+	if (!fname)
+		return;
+
+	buf = os_readfile(fname, &len);
+	if (!buf)
+		return;
+	if (len < HOSTAPD_PSK_CACHE_MAGIC_LEN ||
+	    os_memcmp(buf, HOSTAPD_PSK_CACHE_MAGIC,
+		      HOSTAPD_PSK_CACHE_MAGIC_LEN) != 0 ||
+	    (len - HOSTAPD_PSK_CACHE_MAGIC_LEN) %
+	    HOSTAPD_PSK_CACHE_REC_LEN) {
+		wpa_printf(MSG_INFO, "Ignoring invalid PSK cache file '%s'",
+			   fname);
+		bin_clear_free(buf, len);
+		return;
+	}
+
+	cache->buf = buf;
+	cache->recs = (u8 *) buf + HOSTAPD_PSK_CACHE_MAGIC_LEN;
+	cache->num = (len - HOSTAPD_PSK_CACHE_MAGIC_LEN) /
+		HOSTAPD_PSK_CACHE_REC_LEN;
+}
+
+
+static void hostapd_psk_cache_deinit(struct hostapd_psk_cache *cache)
+{
+	if (cache->buf)
+		bin_clear_free(cache->buf, HOSTAPD_PSK_CACHE_MAGIC_LEN +
+			       cache->num * HOSTAPD_PSK_CACHE_REC_LEN);
+	else
+		bin_clear_free(cache->recs,
+			       cache->alloc * HOSTAPD_PSK_CACHE_REC_LEN);
+	os_memset(cache, 0, sizeof(*cache));
+}
+
+
+static const u8 * hostapd_psk_cache_get(struct hostapd_psk_cache *cache,
+					const u8 *key)
+{
+	const u8 *rec;
+
+	if (!cache->num)
+		return NULL;
+	rec = bsearch(key, cache->recs, cache->num, HOSTAPD_PSK_CACHE_REC_LEN,
+		      hostapd_psk_cache_cmp);
+	return rec ? rec + HOSTAPD_PSK_CACHE_KEY_LEN : NULL;
+}
+
+
+static int hostapd_psk_cache_add(struct hostapd_psk_cache *cache,
+				 const u8 *key, const u8 *psk)
+{
+	u8 *rec;
+
+	if (cache->num == cache->alloc) {
+		size_t alloc = cache->alloc ? cache->alloc * 2 : 16;
+		u8 *n;
+
+		n = os_calloc(alloc, HOSTAPD_PSK_CACHE_REC_LEN);
+		if (!n)
+			return -1;
+		if (cache->recs)
+			os_memcpy(n, cache->recs,
+				  cache->num * HOSTAPD_PSK_CACHE_REC_LEN);
+		bin_clear_free(cache->recs,
+			       cache->alloc * HOSTAPD_PSK_CACHE_REC_LEN);
+		cache->recs = n;
+		cache->alloc = alloc;
+	}
+
+	rec = cache->recs + cache->num * HOSTAPD_PSK_CACHE_REC_LEN;
+	os_memcpy(rec, key, HOSTAPD_PSK_CACHE_KEY_LEN);
+	os_memcpy(rec + HOSTAPD_PSK_CACHE_KEY_LEN, psk, PMK_LEN);
+	cache->num++;
+	return 0;
+}
+
+
+static void hostapd_psk_cache_write(struct hostapd_psk_cache *cache,
+				    const char *fname)
+{
+	FILE *f;
+	char *tmp;
+	size_t len, i, num;
+	int ret = 0;
+
+	/* Sort and drop duplicate keys so that the cache can be searched
+	 * with bsearch() when it is loaded. */
+	if (cache->num)
+		qsort(cache->recs, cache->num, HOSTAPD_PSK_CACHE_REC_LEN,
+		      hostapd_psk_cache_cmp);
+	for (i = 1, num = cache->num ? 1 : 0; i < cache->num; i++) {
+		u8 *prev = cache->recs + (num - 1) * HOSTAPD_PSK_CACHE_REC_LEN;
+		u8 *rec = cache->recs + i * HOSTAPD_PSK_CACHE_REC_LEN;
+
+		if (hostapd_psk_cache_cmp(prev, rec) == 0)
+			continue;
+		if (i != num)
+			os_memcpy(prev + HOSTAPD_PSK_CACHE_REC_LEN, rec,
+				  HOSTAPD_PSK_CACHE_REC_LEN);
+		num++;
+	}
+	cache->num = num;
+
+	len = os_strlen(fname) + 5;
+	tmp = os_malloc(len);
+	if (!tmp)
+		return;
+	os_snprintf(tmp, len, "%s.tmp", fname);
+
+	f = fopen(tmp, "wb");
+	if (!f) {
+		wpa_printf(MSG_INFO, "Could not write PSK cache file '%s': %s",
+			   tmp, strerror(errno));
+		os_free(tmp);
+		return;
+	}
+	if (chmod(tmp, S_IRUSR | S_IWUSR) < 0)
+		ret = -1;
+	if (fwrite(HOSTAPD_PSK_CACHE_MAGIC, HOSTAPD_PSK_CACHE_MAGIC_LEN, 1,
+		   f) != 1 ||
+	    (cache->num &&
+	     fwrite(cache->recs, HOSTAPD_PSK_CACHE_REC_LEN, cache->num,
+		    f) != cache->num))
+		ret = -1;
+	if (fclose(f) != 0)
+		ret = -1;
+
+	if (ret < 0 || rename(tmp, fname) < 0) {
+		wpa_printf(MSG_INFO, "Could not update PSK cache file '%s'",
+			   fname);
+		unlink(tmp);
+	} else {
+		wpa_printf(MSG_DEBUG, "PSK cache '%s' updated with %zu entries",
+			   fname, cache->num);
+	}
+	os_free(tmp);
+}
+
+
+static int hostapd_config_psk_from_passphrase(const char *passphrase,
+					      struct hostapd_ssid *ssid,
+					      struct hostapd_psk_cache *old,
+					      struct hostapd_psk_cache *new,
+					      u8 *psk, unsigned int *derived)
+{
+	u8 key[HOSTAPD_PSK_CACHE_KEY_LEN];
+	u8 ssid_len = ssid->ssid_len;
+	const u8 *addr[3];
+	size_t len[3];
+	const u8 *cached;
+
+	if (!ssid->wpa_psk_cache)
+		return pbkdf2_sha1(passphrase, ssid->ssid, ssid->ssid_len,
+				   4096, psk, PMK_LEN);
+
+	addr[0] = &ssid_len;
+	len[0] = 1;
+	addr[1] = ssid->ssid;
+	len[1] = ssid->ssid_len;
+	addr[2] = (const u8 *) passphrase;
+	len[2] = os_strlen(passphrase);
+	if (sha256_vector(3, addr, len, key) < 0)
+		return -1;
+
+	cached = hostapd_psk_cache_get(old, key);
+	if (cached) {
+		os_memcpy(psk, cached, PMK_LEN);
+	} else {
+		if (pbkdf2_sha1(passphrase, ssid->ssid, ssid->ssid_len,
+				4096, psk, PMK_LEN) < 0)
+			return -1;
+		(*derived)++;
+	}
+
+	/* Failure to remember the entry only costs a derivation on the next
+	 * reload. */
+	hostapd_psk_cache_add(new, key, psk);
+	forced_memzero(key, sizeof(key));
+	return 0;
+}
+
+
 static int hostapd_config_read_wpa_psk(const char *fname,
 				       struct hostapd_ssid *ssid)
 {
@@ -332,6 +561,8 @@ static int hostapd_config_read_wpa_psk(const char *fname,
 	int line = 0, ret = 0, len, ok;
 	u8 addr[ETH_ALEN];
 	struct hostapd_wpa_psk *psk;
+	struct hostapd_psk_cache old_cache, new_cache;
+	unsigned int derived = 0;
 
 	if (!fname)
 		return 0;
@@ -342,6 +573,9 @@ static int hostapd_config_read_wpa_psk(const char *fname,
 		return -1;
 	}
 
+	hostapd_psk_cache_load(&old_cache, ssid->wpa_psk_cache);
+	os_memset(&new_cache, 0, sizeof(new_cache));
+
 	while (fgets(buf, sizeof(buf), f)) {
 		int vlan_id = 0;
 		int wps = 0;
@@ -428,8 +662,9 @@ static int hostapd_config_read_wpa_psk(const char *fname,
 		    hexstr2bin(pos, psk->psk, PMK_LEN) == 0)
 			ok = 1;
 		else if (len >= 8 && len < 64 &&
-			 pbkdf2_sha1(pos, ssid->ssid, ssid->ssid_len,
-				     4096, psk->psk, PMK_LEN) == 0)
+			 hostapd_config_psk_from_passphrase(
+				 pos, ssid, &old_cache, &new_cache, psk->psk,
+				 &derived) == 0)
 			ok = 1;
 		if (!ok) {
 			wpa_printf(MSG_ERROR,
@@ -460,6 +695,17 @@ static int hostapd_config_read_wpa_psk(const char *fname,
 
 	fclose(f);
 
+	if (ret == 0 && ssid->wpa_psk_cache) {
+		wpa_printf(MSG_DEBUG,
+			   "WPA PSK file '%s': %u of %zu passphrase PSKs derived",
+			   fname, derived, new_cache.num);
+		if (derived || new_cache.num != old_cache.num)
+			hostapd_psk_cache_write(&new_cache,
+						ssid->wpa_psk_cache);
+	}
+	hostapd_psk_cache_deinit(&old_cache);
+	hostapd_psk_cache_deinit(&new_cache);
+
 	return ret;
 }
 
@@ -493,6 +739,7 @@ int hostapd_setup_sae_pt(struct hostapd_bss_config *conf)
 #ifdef CONFIG_SAE
 	struct hostapd_ssid *ssid = &conf->ssid;
 	struct sae_password_entry *pw;
+	struct sae_pt *old_pt;
 	int *groups = conf->sae_groups;
 	int default_groups[] = { 19, 0, 0 };
 
@@ -516,23 +763,26 @@ int hostapd_setup_sae_pt(struct hostapd_bss_config *conf)
 			default_groups[1] = 20;
 	}
 
-	sae_deinit_pt(ssid->pt);
+	/* Derive the new PT before releasing the old one so that an unchanged
+	 * PT can be taken from the SAE PT cache. */
+	old_pt = ssid->pt;
 	ssid->pt = NULL;
-	if (ssid->wpa_passphrase) {
+	if (ssid->wpa_passphrase)
 		ssid->pt = sae_derive_pt(groups, ssid->ssid, ssid->ssid_len,
 					 (const u8 *) ssid->wpa_passphrase,
 					 os_strlen(ssid->wpa_passphrase),
 					 NULL);
-		if (!ssid->pt)
-			return -1;
-	}
+	sae_deinit_pt(old_pt);
+	if (ssid->wpa_passphrase && !ssid->pt)
+		return -1;
 
 	for (pw = conf->sae_passwords; pw; pw = pw->next) {
-		sae_deinit_pt(pw->pt);
+		old_pt = pw->pt;
 		pw->pt = sae_derive_pt(groups, ssid->ssid, ssid->ssid_len,
 				       (const u8 *) pw->password,
 				       os_strlen(pw->password),
 				       pw->identifier);
+		sae_deinit_pt(old_pt);
 		if (!pw->pt)
 			return -1;
 	}
@@ -546,6 +796,8 @@ int hostapd_setup_wpa_psk(struct hostapd_bss_config *conf)
 {
 	struct hostapd_ssid *ssid = &conf->ssid;
 
+	hostapd_wpa_psk_index_free(ssid);
+
 	if (hostapd_setup_sae_pt(conf) < 0)
 		return -1;
 
@@ -562,7 +814,14 @@ int hostapd_setup_wpa_psk(struct hostapd_bss_config *conf)
 		ssid->wpa_psk->group = 1;
 	}
 
-	return hostapd_config_read_wpa_psk(ssid->wpa_psk_file, &conf->ssid);
+	if (hostapd_config_read_wpa_psk(ssid->wpa_psk_file, &conf->ssid) < 0)
+		return -1;
+
+	/* The index is only an optimization; hostapd_get_psk() falls back to
+	 * a list search without it. */
+	hostapd_wpa_psk_index_update(ssid);
+
+	return 0;
 }
 
 
@@ -681,6 +940,7 @@ void hostapd_config_free_eap_user(struct hostapd_eap_user *user)
 	os_free(user->identity);
 	bin_clear_free(user->password, user->password_len);
 	bin_clear_free(user->salt, user->salt_len);
+	forced_memzero(user->nt_hash, sizeof(user->nt_hash));
 	os_free(user);
 }
 
@@ -697,6 +957,188 @@ void hostapd_config_free_eap_users(struct hostapd_eap_user *user)
 }
 
 
+struct hostapd_eap_user_index {
+	const struct hostapd_eap_user *head; /* list the index was built for */
+	struct hostapd_eap_user **hash; /* first exact match entries */
+	size_t hash_mask;
+	struct hostapd_eap_user **wildcard; /* in list order */
+	size_t num_wildcard;
+};
+
+
+static size_t hostapd_eap_user_hash(const u8 *identity, size_t identity_len)
+{
+	size_t hash = 5381;
+
+	while (identity_len--)
+		hash = hash * 33 + *identity++;
+	return hash;
+}
+
+
+static bool hostapd_eap_user_match(const struct hostapd_eap_user *user,
+				   const u8 *identity, size_t identity_len,
+				   int phase2)
+{
+	if (!phase2 && !user->identity) {
+		/* Wildcard match */
+		return true;
+	}
+
+	if (user->phase2 == !!phase2 && user->wildcard_prefix &&
+	    identity_len >= user->identity_len &&
+	    os_memcmp(user->identity, identity, user->identity_len) == 0) {
+		/* Wildcard prefix match */
+		return true;
+	}
+
+	return user->phase2 == !!phase2 &&
+		user->identity_len == identity_len &&
+		os_memcmp(user->identity, identity, identity_len) == 0;
+}
+
+
+void hostapd_eap_user_index_free(struct hostapd_bss_config *conf)
+{
+	struct hostapd_eap_user_index *index = conf->eap_user_index;
+
+	if (!index)
+		return;
+	os_free(index->hash);
+	os_free(index->wildcard);
+	os_free(index);
+	conf->eap_user_index = NULL;
+}
+
+
+/**
+ * hostapd_eap_user_index_update - Index the EAP user list
+ * @conf: BSS configuration
+ * Returns: 0 on success, -1 on failure
+ *
+ * This needs to be called whenever conf->eap_user is replaced. Identities
+ * that can only match exactly are hashed while the wildcard entries are
+ * kept in list order, so that hostapd_config_get_eap_user() returns the
+ * same first matching entry as a scan through the list would. Without an
+ * up-to-date index, the list is scanned.
+ */
+int hostapd_eap_user_index_update(struct hostapd_bss_config *conf)
+{
+	struct hostapd_eap_user_index *index;
+	struct hostapd_eap_user *user, **tail;
+	size_t num_exact = 0, num_wildcard = 0, hash_size, i;
+	unsigned int pos = 0;
+
+	hostapd_eap_user_index_free(conf);
+	if (!conf->eap_user)
+		return 0;
+
+	for (user = conf->eap_user; user; user = user->next) {
+		if (!user->identity || user->wildcard_prefix)
+			num_wildcard++;
+		else
+			num_exact++;
+	}
+
+	index = os_zalloc(sizeof(*index));
+	if (!index)
+		return -1;
+	for (hash_size = 16; hash_size < num_exact; hash_size <<= 1)
+		;
+	index->hash = os_calloc(hash_size, sizeof(*index->hash));
+	if (num_wildcard)
+		index->wildcard = os_calloc(num_wildcard,
+					    sizeof(*index->wildcard));
+	if (!index->hash || (num_wildcard && !index->wildcard)) {
+		os_free(index->hash);
+		os_free(index->wildcard);
+		os_free(index);
+		return -1;
+	}
+	index->hash_mask = hash_size - 1;
+
+	for (user = conf->eap_user; user; user = user->next) {
+		user->hnext = NULL;
+		user->list_pos = pos++;
+		if (!user->identity || user->wildcard_prefix) {
+			index->wildcard[index->num_wildcard++] = user;
+			continue;
+		}
+
+		/* Only the first entry for an identity can ever match */
+		i = hostapd_eap_user_hash(user->identity, user->identity_len) &
+			index->hash_mask;
+		for (tail = &index->hash[i]; *tail; tail = &(*tail)->hnext) {
+			if ((*tail)->phase2 == user->phase2 &&
+			    (*tail)->identity_len == user->identity_len &&
+			    os_memcmp((*tail)->identity, user->identity,
+				      user->identity_len) == 0)
+				break;
+		}
+		if (!*tail)
+			*tail = user;
+	}
+
+	index->head = conf->eap_user;
+	conf->eap_user_index = index;
+	wpa_printf(MSG_DEBUG,
+		   "EAP user index: %zu exact and %zu wildcard entries",
+		   num_exact, num_wildcard);
+	return 0;
+}
+
+
+/**
+ * hostapd_config_get_eap_user - Find the first matching EAP user entry
+ * @conf: BSS configuration
+ * @identity: Identity
+ * @identity_len: Length of the identity
+ * @phase2: Whether this is a Phase 2 identity
+ * Returns: The first entry of conf->eap_user that matches or %NULL if none
+ */
+struct hostapd_eap_user *
+hostapd_config_get_eap_user(const struct hostapd_bss_config *conf,
+			    const u8 *identity, size_t identity_len,
+			    int phase2)
+{
+	struct hostapd_eap_user_index *index = conf->eap_user_index;
+	struct hostapd_eap_user *user, *exact = NULL;
+	size_t i;
+
+	if (!index || index->head != conf->eap_user) {
+		for (user = conf->eap_user; user; user = user->next) {
+			if (hostapd_eap_user_match(user, identity, identity_len,
+						   phase2))
+				return user;
+		}
+		return NULL;
+	}
+
+	for (user = index->hash[hostapd_eap_user_hash(identity, identity_len) &
+				index->hash_mask];
+	     user; user = user->hnext) {
+		if (user->phase2 == !!phase2 &&
+		    user->identity_len == identity_len &&
+		    os_memcmp(user->identity, identity, identity_len) == 0) {
+			exact = user;
+			break;
+		}
+	}
+
+	/* A wildcard entry earlier in the list takes precedence */
+	for (i = 0; i < index->num_wildcard; i++) {
+		user = index->wildcard[i];
+		if (exact && user->list_pos > exact->list_pos)
+			break;
+		if (hostapd_eap_user_match(user, identity, identity_len,
+					   phase2))
+			return user;
+	}
+
+	return exact;
+}
+
+
 #ifdef CONFIG_WEP
 static void hostapd_config_free_wep(struct hostapd_wep_keys *keys)
 {
@@ -729,6 +1171,7 @@ void hostapd_config_clear_rxkhs(struct hostapd_bss_config *conf)
 	struct ft_remote_r0kh *r0kh, *r0kh_prev;
 	struct ft_remote_r1kh *r1kh, *r1kh_prev;
 
+	conf->rxkh_gen++;
 	r0kh = conf->r0kh_list;
 	conf->r0kh_list = NULL;
 	while (r0kh) {
@@ -742,6 +1185,7 @@ void hostapd_config_clear_rxkhs(struct hostapd_bss_config *conf)
 	while (r1kh) {
 		r1kh_prev = r1kh;
 		r1kh = r1kh->next;
+		wpabuf_clear_free(r1kh_prev->push_batch);
 		os_free(r1kh_prev);
 	}
 }
@@ -825,9 +1269,12 @@ void hostapd_config_free_bss(struct hostapd_bss_config *conf)
 
 	str_clear_free(conf->ssid.wpa_passphrase);
 	os_free(conf->ssid.wpa_psk_file);
+	os_free(conf->ssid.wpa_psk_cache);
+	hostapd_wpa_psk_index_free(&conf->ssid);
 #ifdef CONFIG_WEP
 	hostapd_config_free_wep(&conf->ssid.wep);
 #endif /* CONFIG_WEP */
+	os_free(conf->ssid.vlan_precreate);
 #ifdef CONFIG_FULL_DYNAMIC_VLAN
 	os_free(conf->ssid.vlan_tagged_interface);
 #endif /* CONFIG_FULL_DYNAMIC_VLAN */
@@ -835,6 +1282,7 @@ void hostapd_config_free_bss(struct hostapd_bss_config *conf)
 	sae_deinit_pt(conf->ssid.pt);
 #endif /* CONFIG_SAE */
 
+	hostapd_eap_user_index_free(conf);
 	hostapd_config_free_eap_users(conf->eap_user);
 	os_free(conf->eap_user_sqlite);
 
@@ -852,9 +1300,13 @@ void hostapd_config_free_bss(struct hostapd_bss_config *conf)
 	}
 	hostapd_config_free_radius_attr(conf->radius_auth_req_attr);
 	hostapd_config_free_radius_attr(conf->radius_acct_req_attr);
+	os_free(conf->acct_spool_file);
 	os_free(conf->radius_req_attr_sqlite);
 	os_free(conf->rsn_preauth_interfaces);
 	os_free(conf->ctrl_interface);
+#ifdef CONFIG_STATUS_SHM
+	os_free(conf->status_shm_dir);
+#endif /* CONFIG_STATUS_SHM */
 	os_free(conf->config_id);
 	os_free(conf->ca_cert);
 	os_free(conf->server_cert);
@@ -868,6 +1320,7 @@ void hostapd_config_free_bss(struct hostapd_bss_config *conf)
 	os_free(conf->ocsp_stapling_response_multi);
 	os_free(conf->dh_file);
 	os_free(conf->openssl_ciphers);
+	os_free(conf->tls_session_ticket_keys);
 	os_free(conf->openssl_ecdh_curves);
 	os_free(conf->pac_opaque_encr_key);
 	os_free(conf->eap_fast_a_id);
@@ -1054,6 +1507,7 @@ void hostapd_config_free(struct hostapd_config *conf)
 	os_free(conf->driver_params);
 #ifdef CONFIG_ACS
 	os_free(conf->acs_chan_bias);
+	os_free(conf->acs_model_file);
 #endif /* CONFIG_ACS */
 	wpabuf_free(conf->lci);
 	wpabuf_free(conf->civic);
@@ -1062,18 +1516,8 @@ void hostapd_config_free(struct hostapd_config *conf)
 }
 
 
-/**
- * hostapd_maclist_found - Find a MAC address from a list
- * @list: MAC address list
- * @num_entries: Number of addresses in the list
- * @addr: Address to search for
- * @vlan_id: Buffer for returning VLAN ID or %NULL if not needed
- * Returns: 1 if address is in the list or 0 if not.
- *
- * Perform a binary search for given MAC address from a pre-sorted list.
- */
-int hostapd_maclist_found(struct mac_acl_entry *list, int num_entries,
-			  const u8 *addr, struct vlan_description *vlan_id)
+static int hostapd_maclist_pos(const struct mac_acl_entry *list,
+			       int num_entries, const u8 *addr, int *pos)
 {
 	int start, end, middle, res;
 
@@ -1084,8 +1528,7 @@ int hostapd_maclist_found(struct mac_acl_entry *list, int num_entries,
 		middle = (start + end) / 2;
 		res = os_memcmp(list[middle].addr, addr, ETH_ALEN);
 		if (res == 0) {
-			if (vlan_id)
-				*vlan_id = list[middle].vlan_id;
+			*pos = middle;
 			return 1;
 		}
 		if (res < 0)
@@ -1094,10 +1537,34 @@ int hostapd_maclist_found(struct mac_acl_entry *list, int num_entries,
 			end = middle - 1;
 	}
 
+	*pos = start;
 	return 0;
 }
 
 
+/**
+ * hostapd_maclist_found - Find a MAC address from a list
+ * @list: MAC address list
+ * @num_entries: Number of addresses in the list
+ * @addr: Address to search for
+ * @vlan_id: Buffer for returning VLAN ID or %NULL if not needed
+ * Returns: 1 if address is in the list or 0 if not.
+ *
+ * Perform a binary search for given MAC address from a pre-sorted list.
+ */
+int hostapd_maclist_found(struct mac_acl_entry *list, int num_entries,
+			  const u8 *addr, struct vlan_description *vlan_id)
+{
+	int pos;
+
+	if (!hostapd_maclist_pos(list, num_entries, addr, &pos))
+		return 0;
+	if (vlan_id)
+		*vlan_id = list[pos].vlan_id;
+	return 1;
+}
+
+
 int hostapd_rate_found(int *list, int rate)
 {
 	int i;
@@ -1152,6 +1619,235 @@ const char * hostapd_get_vlan_id_ifname(struct hostapd_vlan *vlan, int vlan_id)
 }
 
 
+/*
+ * Index of the PSK list for hostapd_get_psk(). Per-STA entries are hashed by
+ * MAC address and wildcard entries are kept in an array in list order. The
+ * last PSK that matched for a STA is remembered and tried first so that a
+ * reassociating STA needs only a single MIC check even with a large number
+ * of wildcard PSKs.
+ */
+#define HOSTAPD_PSK_LAST_MATCH_SIZE 256
+
+struct hostapd_psk_iter {
+	int phase; /* 0 = last match, 1 = per-STA entries, 2 = wildcards */
+	struct hostapd_wpa_psk *pos;
+	size_t idx;
+};
+
+struct hostapd_wpa_psk_index {
+	const struct hostapd_wpa_psk *head; /* list the index was built for */
+	struct hostapd_wpa_psk **hash;
+	size_t hash_mask;
+	struct hostapd_wpa_psk **wildcard;
+	size_t num_wildcard;
+	struct {
+		u8 addr[ETH_ALEN];
+		struct hostapd_wpa_psk *psk;
+	} last[HOSTAPD_PSK_LAST_MATCH_SIZE];
+
+	/* Position of the latest hostapd_get_psk() return value to avoid
+	 * searching for prev_psk when iterating over the candidates */
+	u8 cursor_addr[ETH_ALEN];
+	const u8 *cursor_psk;
+	struct hostapd_psk_iter cursor;
+};
+
+
+static size_t hostapd_psk_addr_hash(const u8 *addr)
+{
+	return (addr[3] << 16) | (addr[4] << 8) | addr[5];
+}
+
+
+void hostapd_wpa_psk_index_free(struct hostapd_ssid *ssid)
+{
+	struct hostapd_wpa_psk_index *index = ssid->wpa_psk_index;
+
+	if (!index)
+		return;
+	os_free(index->hash);
+	os_free(index->wildcard);
+	os_free(index);
+	ssid->wpa_psk_index = NULL;
+}
+
+
+int hostapd_wpa_psk_index_update(struct hostapd_ssid *ssid)
+{
+	struct hostapd_wpa_psk_index *index;
+	struct hostapd_wpa_psk *psk, **tail;
+	size_t num_addr = 0, num_wildcard = 0, hash_size, i;
+
+	hostapd_wpa_psk_index_free(ssid);
+	if (!ssid->wpa_psk)
+		return 0;
+
+	for (psk = ssid->wpa_psk; psk; psk = psk->next) {
+		if (psk->group)
+			num_wildcard++;
+		else
+			num_addr++;
+	}
+
+	index = os_zalloc(sizeof(*index));
+	if (!index)
+		return -1;
+	for (hash_size = 16; hash_size < num_addr; hash_size <<= 1)
+		;
+	index->hash = os_calloc(hash_size, sizeof(*index->hash));
+	if (num_wildcard)
+		index->wildcard = os_calloc(num_wildcard,
+					    sizeof(*index->wildcard));
+	if (!index->hash || (num_wildcard && !index->wildcard)) {
+		os_free(index->hash);
+		os_free(index->wildcard);
+		os_free(index);
+		return -1;
+	}
+	index->hash_mask = hash_size - 1;
+
+	for (psk = ssid->wpa_psk; psk; psk = psk->next) {
+		psk->hnext = NULL;
+		if (psk->group) {
+			index->wildcard[index->num_wildcard++] = psk;
+			continue;
+		}
+
+		/* Append to keep the list order within a bucket */
+		i = hostapd_psk_addr_hash(psk->addr) & index->hash_mask;
+		for (tail = &index->hash[i]; *tail; tail = &(*tail)->hnext)
+			;
+		*tail = psk;
+	}
+
+	index->head = ssid->wpa_psk;
+	ssid->wpa_psk_index = index;
+	wpa_printf(MSG_DEBUG,
+		   "WPA PSK index: %zu per-STA and %zu wildcard entries",
+		   num_addr, num_wildcard);
+	return 0;
+}
+
+
+static struct hostapd_wpa_psk *
+hostapd_psk_last_match(struct hostapd_wpa_psk_index *index, const u8 *addr)
+{
+	size_t i = hostapd_psk_addr_hash(addr) % HOSTAPD_PSK_LAST_MATCH_SIZE;
+
+	if (index->last[i].psk && ether_addr_equal(index->last[i].addr, addr))
+		return index->last[i].psk;
+	return NULL;
+}
+
+
+static struct hostapd_wpa_psk *
+hostapd_psk_iter_next(struct hostapd_wpa_psk_index *index, const u8 *addr,
+		      struct hostapd_psk_iter *iter)
+{
+	struct hostapd_wpa_psk *last = hostapd_psk_last_match(index, addr);
+	struct hostapd_wpa_psk *psk;
+
+	switch (iter->phase) {
+	case 0:
+		iter->phase = 1;
+		iter->pos = index->hash[hostapd_psk_addr_hash(addr) &
+					index->hash_mask];
+		if (last)
+			return last;
+		/* fall through */
+	case 1:
+		while (iter->pos) {
+			psk = iter->pos;
+			iter->pos = psk->hnext;
+			if (psk != last && ether_addr_equal(psk->addr, addr))
+				return psk;
+		}
+		iter->phase = 2;
+		iter->idx = 0;
+		/* fall through */
+	case 2:
+		while (iter->idx < index->num_wildcard) {
+			psk = index->wildcard[iter->idx++];
+			if (psk != last)
+				return psk;
+		}
+		break;
+	}
+
+	return NULL;
+}
+
+
+static struct hostapd_wpa_psk *
+hostapd_get_psk_indexed(struct hostapd_wpa_psk_index *index, const u8 *addr,
+			const u8 *prev_psk)
+{
+	struct hostapd_psk_iter iter;
+	struct hostapd_wpa_psk *psk;
+
+	os_memset(&iter, 0, sizeof(iter));
+	if (prev_psk && prev_psk == index->cursor_psk &&
+	    ether_addr_equal(addr, index->cursor_addr)) {
+		iter = index->cursor;
+	} else if (prev_psk) {
+		/* Not continuing from the latest returned entry, so find
+		 * prev_psk among the candidates. */
+		do {
+			psk = hostapd_psk_iter_next(index, addr, &iter);
+		} while (psk && psk->psk != prev_psk);
+		if (!psk)
+			return NULL;
+	}
+
+	psk = hostapd_psk_iter_next(index, addr, &iter);
+	if (psk) {
+		os_memcpy(index->cursor_addr, addr, ETH_ALEN);
+		index->cursor_psk = psk->psk;
+		index->cursor = iter;
+	} else {
+		index->cursor_psk = NULL;
+	}
+	return psk;
+}
+
+
+void hostapd_psk_matched(const struct hostapd_bss_config *conf,
+			 const u8 *addr, const u8 *psk)
+{
+	struct hostapd_wpa_psk_index *index = conf->ssid.wpa_psk_index;
+	struct hostapd_wpa_psk *entry;
+	size_t i;
+
+	if (!index || index->head != conf->ssid.wpa_psk)
+		return;
+
+	/* Only entries from the list are remembered; psk may also point to,
+	 * e.g., a RADIUS provided PSK stored for the STA. */
+	i = hostapd_psk_addr_hash(addr) % HOSTAPD_PSK_LAST_MATCH_SIZE;
+	entry = index->last[i].psk;
+	if (entry && entry->psk == psk &&
+	    ether_addr_equal(index->last[i].addr, addr))
+		return;
+	for (entry = index->hash[hostapd_psk_addr_hash(addr) &
+				 index->hash_mask];
+	     entry; entry = entry->hnext) {
+		if (entry->psk == psk)
+			goto found;
+	}
+	for (i = 0; i < index->num_wildcard; i++) {
+		entry = index->wildcard[i];
+		if (entry->psk == psk)
+			goto found;
+	}
+	return;
+
+found:
+	i = hostapd_psk_addr_hash(addr) % HOSTAPD_PSK_LAST_MATCH_SIZE;
+	os_memcpy(index->last[i].addr, addr, ETH_ALEN);
+	index->last[i].psk = entry;
+}
+
+
 const u8 * hostapd_get_psk(const struct hostapd_bss_config *conf,
 			   const u8 *addr, const u8 *p2p_dev_addr,
 			   const u8 *prev_psk, int *vlan_id)
@@ -1173,6 +1869,17 @@ const u8 * hostapd_get_psk(const struct hostapd_bss_config *conf,
 			   MAC2STR(addr), prev_psk);
 	}
 
+	if (addr && conf->ssid.wpa_psk_index &&
+	    conf->ssid.wpa_psk_index->head == conf->ssid.wpa_psk) {
+		psk = hostapd_get_psk_indexed(conf->ssid.wpa_psk_index, addr,
+					      prev_psk);
+		if (!psk)
+			return NULL;
+		if (vlan_id)
+			*vlan_id = psk->vlan_id;
+		return psk->psk;
+	}
+
 	for (psk = conf->ssid.wpa_psk; psk != NULL; psk = psk->next) {
 		if (next_ok &&
 		    (psk->group ||
@@ -1806,3 +2513,72 @@ void hostapd_remove_acl_mac(struct mac_acl_entry **acl, int *num,
 		}
 	}
 }
+
+
+/**
+ * hostapd_insert_acl_mac - Add a MAC address to a sorted list
+ * @acl: Pointer to the sorted MAC address list
+ * @num: Pointer to the number of addresses in the list
+ * @vlan_id: VLAN ID for the address or 0 if not used
+ * @addr: Address to add
+ * Returns: 0 on success (including the address already being in the list) or
+ * -1 on failure
+ *
+ * The list remains sorted, so it does not need to be sorted again with
+ * hostapd_acl_comp() after this call. The VLAN ID of an address that is
+ * already in the list is not changed.
+ */
+int hostapd_insert_acl_mac(struct mac_acl_entry **acl, int *num,
+			   int vlan_id, const u8 *addr)
+{
+	int pos;
+
+	if (hostapd_maclist_pos(*acl, *num, addr, &pos))
+		return 0;
+
+	if (hostapd_add_acl_maclist(acl, num, vlan_id, addr) < 0)
+		return -1;
+	if (pos < *num - 1) {
+		struct mac_acl_entry entry = (*acl)[*num - 1];
+
+		os_memmove(&(*acl)[pos + 1], &(*acl)[pos],
+			   (*num - 1 - pos) * sizeof(**acl));
+		(*acl)[pos] = entry;
+	}
+
+	return 0;
+}
+
+
+/**
+ * hostapd_delete_acl_mac - Remove a MAC address from a sorted list
+ * @acl: Pointer to the sorted MAC address list
+ * @num: Pointer to the number of addresses in the list
+ * @addr: Address to remove
+ * Returns: 1 if the address was removed or 0 if it was not in the list
+ */
+int hostapd_delete_acl_mac(struct mac_acl_entry **acl, int *num,
+			   const u8 *addr)
+{
+	int pos;
+
+	if (!hostapd_maclist_pos(*acl, *num, addr, &pos))
+		return 0;
+
+	os_remove_in_array(*acl, *num, sizeof(**acl), pos);
+	(*num)--;
+	return 1;
+}
+
+
+/**
+ * hostapd_free_acl_maclist - Remove all MAC addresses from a list
+ * @acl: Pointer to the MAC address list
+ * @num: Pointer to the number of addresses in the list
+ */
+void hostapd_free_acl_maclist(struct mac_acl_entry **acl, int *num)
+{
+	os_free(*acl);
+	*acl = NULL;
+	*num = 0;
+}
@@ -62,6 +62,8 @@ struct mesh_conf {
 
 #define MAX_STA_COUNT 2007
 #define MAX_VLAN_ID 4094
+#define ACCT_SPOOL_DEFAULT_MAX 1000
+#define ACCT_SPOOL_DEFAULT_RATE 10
 
 typedef u8 macaddr[ETH_ALEN];
 
@@ -111,6 +113,8 @@ struct hostapd_ssid {
 	struct hostapd_wpa_psk *wpa_psk;
 	char *wpa_passphrase;
 	char *wpa_psk_file;
+	char *wpa_psk_cache;
+	struct hostapd_wpa_psk_index *wpa_psk_index;
 	struct sae_pt *pt;
 
 #ifdef CONFIG_WEP
@@ -126,6 +130,8 @@ struct hostapd_ssid {
 #define DYNAMIC_VLAN_NAMING_END 2
 	int vlan_naming;
 	int per_sta_vif;
+	int vlan_teardown_delay; /* seconds */
+	int *vlan_precreate; /* zero terminated list of VLAN IDs */
 #ifdef CONFIG_FULL_DYNAMIC_VLAN
 	char *vlan_tagged_interface;
 #endif /* CONFIG_FULL_DYNAMIC_VLAN */
@@ -161,6 +167,24 @@ struct hostapd_sta_wpa_psk_short {
 	int ref; /* (number of references held) - 1 */
 };
 
+/**
+ * enum hostapd_config_class - Classes of configuration parameters by reload
+ * @HOSTAPD_CONFIG_CLASS_FULL: Changes require the stations to be
+ *	disconnected
+ * @HOSTAPD_CONFIG_CLASS_PSK: PSKs and SAE passwords; stations using a
+ *	removed one are disconnected
+ * @HOSTAPD_CONFIG_CLASS_BEACON: Changes only need the Beacon and Probe
+ *	Response frames to be updated
+ */
+enum hostapd_config_class {
+	HOSTAPD_CONFIG_CLASS_FULL,
+	HOSTAPD_CONFIG_CLASS_PSK,
+	HOSTAPD_CONFIG_CLASS_BEACON,
+	HOSTAPD_CONFIG_CLASSES
+};
+
+#define HOSTAPD_CONFIG_DIGEST_LEN 32
+
 struct hostapd_wpa_psk {
 	struct hostapd_wpa_psk *next;
 	int group;
@@ -170,8 +194,11 @@ struct hostapd_wpa_psk {
 	u8 addr[ETH_ALEN];
 	u8 p2p_dev_addr[ETH_ALEN];
 	int vlan_id;
+	struct hostapd_wpa_psk *hnext; /* next entry in wpa_psk_index bucket */
 };
 
+struct hostapd_wpa_psk_index;
+
 struct hostapd_eap_user {
 	struct hostapd_eap_user *next;
 	u8 *identity;
@@ -189,13 +216,19 @@ struct hostapd_eap_user {
 	unsigned int wildcard_prefix:1;
 	unsigned int password_hash:1; /* whether password is hashed with
 				       * nt_password_hash() */
+	unsigned int nt_hash_set:1; /* whether nt_hash is valid */
 	unsigned int remediation:1;
 	unsigned int macacl:1;
+	u8 nt_hash[16]; /* nt_password_hash() of a plaintext password */
 	int ttls_auth; /* EAP_TTLS_AUTH_* bitfield */
 	struct hostapd_radius_attr *accept_attr;
 	u32 t_c_timestamp;
+	struct hostapd_eap_user *hnext; /* next entry in eap_user_index bucket */
+	unsigned int list_pos; /* position in the list for eap_user_index */
 };
 
+struct hostapd_eap_user_index;
+
 struct hostapd_radius_attr {
 	u8 type;
 	struct wpabuf *val;
@@ -302,6 +335,7 @@ struct hostapd_bss_config {
 	int eap_server; /* Use internal EAP server instead of external
 			 * RADIUS server */
 	struct hostapd_eap_user *eap_user;
+	struct hostapd_eap_user_index *eap_user_index;
 	char *eap_user_sqlite;
 	char *eap_sim_db;
 	unsigned int eap_sim_db_timeout;
@@ -311,6 +345,11 @@ struct hostapd_bss_config {
 	struct hostapd_radius_servers *radius;
 	int radius_require_message_authenticator;
 	int acct_interim_interval;
+	int acct_interim_jitter;
+	int acct_interim_slack;
+	char *acct_spool_file;
+	int acct_spool_max;
+	int acct_spool_rate; /* messages per second */
 	int radius_request_cui;
 	struct hostapd_radius_attr *radius_auth_req_attr;
 	struct hostapd_radius_attr *radius_acct_req_attr;
@@ -344,6 +383,7 @@ struct hostapd_bss_config {
 #endif /* CONFIG_TESTING_OPTIONS */
 
 	enum macaddr_acl macaddr_acl;
+	unsigned int radius_acl_cache_size;
 	struct mac_acl_entry *accept_mac;
 	int num_accept_mac;
 	struct mac_acl_entry *deny_mac;
@@ -388,6 +428,7 @@ struct hostapd_bss_config {
 	int wpa_ptk_rekey;
 	enum ptk0_rekey_handling wpa_deny_ptk0_rekey;
 	u32 wpa_group_update_count;
+	unsigned int wpa_group_update_rate;
 	u32 wpa_pairwise_update_count;
 	int wpa_disable_eapol_key_retries;
 	int rsn_pairwise;
@@ -410,7 +451,10 @@ struct hostapd_bss_config {
 	u32 reassociation_deadline;
 	struct ft_remote_r0kh *r0kh_list;
 	struct ft_remote_r1kh *r1kh_list;
+	unsigned int rxkh_gen; /* incremented on r0kh_list/r1kh_list changes */
 	int pmk_r1_push;
+	int pmk_r1_push_count;
+	int pmk_r1_push_batch; /* ms */
 	int ft_over_ds;
 	int ft_psk_generate_local;
 	int r1_max_key_lifetime;
@@ -422,6 +466,9 @@ struct hostapd_bss_config {
 	gid_t ctrl_interface_gid;
 #endif /* CONFIG_NATIVE_WINDOWS */
 	int ctrl_interface_gid_set;
+#ifdef CONFIG_STATUS_SHM
+	char *status_shm_dir; /* directory for shared memory status pages */
+#endif /* CONFIG_STATUS_SHM */
 
 	char *ca_cert;
 	char *server_cert;
@@ -435,6 +482,8 @@ struct hostapd_bss_config {
 	int check_crl_strict;
 	unsigned int crl_reload_interval;
 	unsigned int tls_session_lifetime;
+	unsigned int tls_session_cache_size;
+	char *tls_session_ticket_keys;
 	unsigned int tls_flags;
 	unsigned int max_auth_rounds;
 	unsigned int max_auth_rounds_short;
@@ -467,6 +516,7 @@ struct hostapd_bss_config {
 	int radius_server_auth_port;
 	int radius_server_acct_port;
 	int radius_server_ipv6;
+	int radius_server_workers;
 
 	int use_pae_group_addr; /* Whether to send EAPOL frames to PAE group
 				 * address instead of individual address
@@ -474,6 +524,8 @@ struct hostapd_bss_config {
 				 */
 
 	int ap_max_inactivity;
+	int ap_inactivity_slack;
+	unsigned int sta_stats_interval; /* in milliseconds; 0 = disabled */
 	int bss_max_idle;
 	int max_acceptable_idle_period;
 	bool no_disconnect_on_group_keyerror;
@@ -496,6 +548,14 @@ struct hostapd_bss_config {
 
 	int disable_pmksa_caching;
 	int okc; /* Opportunistic Key Caching */
+	int pmksa_cache_shared;
+	unsigned int pmksa_cache_size;
+#ifdef CONFIG_PMKSA_SYNC
+	int pmksa_sync_port; /* UDP port; 0 = disabled */
+	struct hostapd_ip_addr pmksa_sync_addr;
+	u8 pmksa_sync_key[32];
+	bool pmksa_sync_key_set;
+#endif /* CONFIG_PMKSA_SYNC */
 
 	int wps_state;
 #ifdef CONFIG_WPS
@@ -518,6 +578,8 @@ struct hostapd_bss_config {
 	int wps_cred_processing;
 	int wps_cred_add_sae;
 	int force_per_enrollee_psk;
+	unsigned int wps_dh_pool_size;
+	unsigned int wps_max_sessions_per_sec;
 	u8 *ap_settings;
 	size_t ap_settings_len;
 	struct hostapd_ssid multi_ap_backhaul_ssid;
@@ -683,6 +745,7 @@ struct hostapd_bss_config {
 	struct wpabuf *assocresp_elements;
 
 	unsigned int anti_clogging_threshold;
+	unsigned int sae_cpu_budget; /* msec per second; 0 = disabled */
 	unsigned int sae_sync;
 	int sae_require_mfp;
 	int sae_confirm_immediate;
@@ -813,6 +876,7 @@ struct hostapd_bss_config {
 	int coloc_intf_reporting;
 
 	u8 send_probe_response;
+	bool probe_req_ssid_filter;
 
 	u8 transition_disable;
 
@@ -945,6 +1009,8 @@ struct hostapd_bss_config {
 #ifdef CONFIG_PASN
 	/* Whether to allow PASN-UNAUTH */
 	int pasn_noauth;
+	/* Maximum number of PTKSA cache entries; 0 = default */
+	unsigned int ptksa_cache_size;
 
 #ifdef CONFIG_TESTING_OPTIONS
 	/*
@@ -973,6 +1039,13 @@ struct hostapd_bss_config {
 
 	u8 rnr;
 	char *config_id;
+
+	/* Digests of the configuration file lines of this BSS; one for each
+	 * class of changes that is applied in a different way when the
+	 * configuration is reloaded with hostapd_apply_config() */
+	u8 config_digest[HOSTAPD_CONFIG_CLASSES][HOSTAPD_CONFIG_DIGEST_LEN];
+	bool config_digest_set;
+
 	bool xrates_supported;
 
 	bool ssid_protection;
@@ -1066,6 +1139,9 @@ struct hostapd_config {
 	bool hw_mode_set;
 	int acs_exclude_6ghz_non_psc;
 	int enable_background_radar;
+#define HOSTAPD_DFS_MAX_PRECAC 8
+	int background_radar_precac;
+	unsigned int background_radar_precac_lifetime;
 	enum {
 		LONG_PREAMBLE = 0,
 		SHORT_PREAMBLE = 1
@@ -1165,6 +1241,9 @@ struct hostapd_config {
 		double bias;
 	} *acs_chan_bias;
 	unsigned int num_acs_chan_bias;
+	char *acs_model_file;
+	unsigned int acs_reeval_interval;
+	unsigned int acs_reeval_threshold;
 #endif /* CONFIG_ACS */
 
 	struct wpabuf *lci;
@@ -1227,6 +1306,13 @@ struct hostapd_config {
 #define AIRTIME_MODE_MAX (__AIRTIME_MODE_MAX - 1)
 #endif /* CONFIG_AIRTIME_POLICY */
 
+#ifdef CONFIG_STEERING
+	int steering_chan_util; /* 0 = steering disabled */
+	int steering_min_rssi;
+	unsigned int steering_interval; /* seconds */
+	unsigned int steering_backoff; /* seconds */
+#endif /* CONFIG_STEERING */
+
 	int ieee80211be;
 #ifdef CONFIG_IEEE80211BE
 	enum oper_chan_width eht_oper_chwidth;
@@ -1396,6 +1482,16 @@ int hostapd_rate_found(int *list, int rate);
 const u8 * hostapd_get_psk(const struct hostapd_bss_config *conf,
 			   const u8 *addr, const u8 *p2p_dev_addr,
 			   const u8 *prev_psk, int *vlan_id);
+void hostapd_psk_matched(const struct hostapd_bss_config *conf,
+			 const u8 *addr, const u8 *psk);
+int hostapd_wpa_psk_index_update(struct hostapd_ssid *ssid);
+void hostapd_wpa_psk_index_free(struct hostapd_ssid *ssid);
+int hostapd_eap_user_index_update(struct hostapd_bss_config *conf);
+void hostapd_eap_user_index_free(struct hostapd_bss_config *conf);
+struct hostapd_eap_user *
+hostapd_config_get_eap_user(const struct hostapd_bss_config *conf,
+			    const u8 *identity, size_t identity_len,
+			    int phase2);
 int hostapd_setup_wpa_psk(struct hostapd_bss_config *conf);
 int hostapd_vlan_valid(struct hostapd_vlan *vlan,
 		       struct vlan_description *vlan_desc);
@@ -1416,5 +1512,10 @@ int hostapd_add_acl_maclist(struct mac_acl_entry **acl, int *num,
 			    int vlan_id, const u8 *addr);
 void hostapd_remove_acl_mac(struct mac_acl_entry **acl, int *num,
 			    const u8 *addr);
+int hostapd_insert_acl_mac(struct mac_acl_entry **acl, int *num,
+			   int vlan_id, const u8 *addr);
+int hostapd_delete_acl_mac(struct mac_acl_entry **acl, int *num,
+			   const u8 *addr);
+void hostapd_free_acl_maclist(struct mac_acl_entry **acl, int *num);
 
 #endif /* HOSTAPD_CONFIG_H */
@@ -229,6 +229,18 @@ static inline int hostapd_drv_read_sta_data(
 	return hapd->driver->read_sta_data(hapd->drv_priv, data, addr);
 }
 
+static inline int hostapd_drv_read_all_sta_data(
+	struct hostapd_data *hapd,
+	void (*cb)(void *ctx, const u8 *addr,
+		   struct hostap_sta_driver_data *data),
+	void *ctx)
+{
+	if (!hapd->driver || !hapd->driver->read_all_sta_data ||
+	    !hapd->drv_priv)
+		return -1;
+	return hapd->driver->read_all_sta_data(hapd->drv_priv, cb, ctx);
+}
+
 static inline int hostapd_drv_sta_clear_stats(struct hostapd_data *hapd,
 					      const u8 *addr)
 {
@@ -321,6 +333,9 @@ static inline int hostapd_drv_switch_channel(struct hostapd_data *hapd,
 	    hapd->drv_priv == NULL)
 		return -1;
 
+	/* The driver replaces the Beacon frame contents on its own */
+	wpabuf_free(hapd->beacon_sig);
+	hapd->beacon_sig = NULL;
 	return hapd->driver->switch_channel(hapd->drv_priv, settings);
 }
 
@@ -331,6 +346,8 @@ static inline int hostapd_drv_switch_color(struct hostapd_data *hapd,
 	if (!hapd->driver || !hapd->driver->switch_color || !hapd->drv_priv)
 		return -1;
 
+	wpabuf_free(hapd->beacon_sig);
+	hapd->beacon_sig = NULL;
 	return hapd->driver->switch_color(hapd->drv_priv, settings);
 }
 #endif /* CONFIG_IEEE80211AX */
@@ -402,6 +419,9 @@ static inline int hostapd_drv_stop_ap(struct hostapd_data *hapd)
 
 	if (!hapd->driver || !hapd->driver->stop_ap || !hapd->drv_priv)
 		return 0;
+	/* The next set_ap() has to be passed to the driver in full */
+	wpabuf_free(hapd->beacon_sig);
+	hapd->beacon_sig = NULL;
 #ifdef CONFIG_IEEE80211BE
 	if (hapd->conf->mld_ap)
 		link_id = hapd->mld_link_id;
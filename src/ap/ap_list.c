@@ -168,12 +168,15 @@ static struct ap_info * ap_ap_add(struct hostapd_iface *iface, const u8 *addr)
 
 void ap_list_process_beacon(struct hostapd_iface *iface,
 			    const struct ieee80211_mgmt *mgmt,
-			    struct ieee802_11_elems *elems,
+			    const struct ieee802_11_elem_index *elems,
 			    struct hostapd_frame_info *fi)
 {
 	struct ap_info *ap;
 	int new_ap = 0;
 	int set_beacon = 0;
+	const u8 *supp_rates, *ext_supp_rates, *erp, *ds, *ht_oper;
+	u8 supp_rates_len = 0, ext_supp_rates_len = 0, erp_len, ds_len;
+	u8 ht_oper_len, ht_cap_len;
 
 	if (iface->conf->ap_table_max_size < 1)
 		return;
@@ -189,23 +192,33 @@ void ap_list_process_beacon(struct hostapd_iface *iface,
 		new_ap = 1;
 	}
 
+	supp_rates = ieee802_11_index_get(elems, WLAN_EID_SUPP_RATES,
+					  &supp_rates_len);
+	ext_supp_rates = ieee802_11_index_get(elems, WLAN_EID_EXT_SUPP_RATES,
+					      &ext_supp_rates_len);
 	merge_byte_arrays(ap->supported_rates, WLAN_SUPP_RATES_MAX,
-			  elems->supp_rates, elems->supp_rates_len,
-			  elems->ext_supp_rates, elems->ext_supp_rates_len);
+			  supp_rates, supp_rates_len,
+			  ext_supp_rates, ext_supp_rates_len);
 
-	if (elems->erp_info)
-		ap->erp = elems->erp_info[0];
+	erp = ieee802_11_index_get(elems, WLAN_EID_ERP_INFO, &erp_len);
+	if (erp && erp_len >= 1)
+		ap->erp = erp[0];
 	else
 		ap->erp = -1;
 
-	if (elems->ds_params)
-		ap->channel = elems->ds_params[0];
-	else if (elems->ht_operation)
-		ap->channel = elems->ht_operation[0];
+	ds = ieee802_11_index_get(elems, WLAN_EID_DS_PARAMS, &ds_len);
+	ht_oper = ieee802_11_index_get(elems, WLAN_EID_HT_OPERATION,
+				       &ht_oper_len);
+	if (ds && ds_len >= 1)
+		ap->channel = ds[0];
+	else if (ht_oper &&
+		 ht_oper_len >= sizeof(struct ieee80211_ht_operation))
+		ap->channel = ht_oper[0];
 	else if (fi)
 		ap->channel = fi->channel;
 
-	if (elems->ht_capabilities)
+	if (ieee802_11_index_get(elems, WLAN_EID_HT_CAP, &ht_cap_len) &&
+	    ht_cap_len >= sizeof(struct ieee80211_ht_capabilities))
 		ap->ht_support = 1;
 	else
 		ap->ht_support = 0;
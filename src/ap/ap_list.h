@@ -29,12 +29,12 @@ struct ap_info {
 	struct os_reltime last_beacon;
 };
 
-struct ieee802_11_elems;
+struct ieee802_11_elem_index;
 struct hostapd_frame_info;
 
 void ap_list_process_beacon(struct hostapd_iface *iface,
 			    const struct ieee80211_mgmt *mgmt,
-			    struct ieee802_11_elems *elems,
+			    const struct ieee802_11_elem_index *elems,
 			    struct hostapd_frame_info *fi);
 #ifdef NEED_AP_MLME
 int ap_list_init(struct hostapd_iface *iface);
@@ -0,0 +1,84 @@
+/*
+ * hostapd / Shared memory status page
+ *
+ * This software may be distributed under the terms of the BSD license.
+ * See README for more details.
+ */
+
+#include "utils/includes.h"
+
+#include "utils/common.h"
+#include "common/status_shm.h"
+#include "hostapd.h"
+#include "ap_config.h"
+#include "ap_status_shm.h"
+
+
+/**
+ * hostapd_status_shm_init - Create the status page of a BSS
+ * @hapd: Pointer to BSS data
+ * Returns: 0 on success (or if not configured), -1 on failure
+ */
+int hostapd_status_shm_init(struct hostapd_data *hapd)
+{
+	if (!hapd->conf->status_shm_dir || hapd->status_shm)
+		return 0;
+
+	hapd->status_shm = status_shm_open(hapd->conf->status_shm_dir,
+					   hapd->conf->iface,
+					   STATUS_SHM_TYPE_AP,
+					   sizeof(struct status_shm_ap));
+	if (!hapd->status_shm)
+		return -1;
+	hostapd_status_shm_update(hapd);
+	return 0;
+}
+
+
+void hostapd_status_shm_deinit(struct hostapd_data *hapd)
+{
+	status_shm_close(hapd->status_shm);
+	hapd->status_shm = NULL;
+}
+
+
+/**
+ * hostapd_status_shm_update - Update the status page of a BSS
+ * @hapd: Pointer to BSS data
+ */
+void hostapd_status_shm_update(struct hostapd_data *hapd)
+{
+	struct status_shm_ap *ap;
+	struct hostapd_ssid *ssid = &hapd->conf->ssid;
+	struct os_reltime now;
+
+	if (!hapd->status_shm)
+		return;
+
+	os_get_reltime(&now);
+	ap = status_shm_write_begin(hapd->status_shm);
+	ap->updated_ms = (u64) now.sec * 1000 + now.usec / 1000;
+	ap->state = hapd->iface->state;
+	ap->freq = hapd->iface->freq;
+	os_memcpy(ap->bssid, hapd->own_addr, ETH_ALEN);
+	if (ssid->ssid_len <= sizeof(ap->ssid)) {
+		ap->ssid_len = ssid->ssid_len;
+		os_memcpy(ap->ssid, ssid->ssid, ssid->ssid_len);
+	}
+	ap->channel_utilization = hapd->iface->channel_utilization;
+	ap->num_sta = hapd->num_sta;
+	status_shm_write_end(hapd->status_shm);
+}
+
+
+/**
+ * hostapd_status_shm_update_iface - Update the status pages of all BSSs
+ * @iface: Pointer to interface data
+ */
+void hostapd_status_shm_update_iface(struct hostapd_iface *iface)
+{
+	size_t i;
+
+	for (i = 0; i < iface->num_bss; i++)
+		hostapd_status_shm_update(iface->bss[i]);
+}
@@ -0,0 +1,42 @@
+/*
+ * hostapd / Shared memory status page
+ *
+ * This software may be distributed under the terms of the BSD license.
+ * See README for more details.
+ */
+
+#ifndef AP_STATUS_SHM_H
+#define AP_STATUS_SHM_H
+
+struct hostapd_data;
+struct hostapd_iface;
+
+#ifdef CONFIG_STATUS_SHM
+
+int hostapd_status_shm_init(struct hostapd_data *hapd);
+void hostapd_status_shm_deinit(struct hostapd_data *hapd);
+void hostapd_status_shm_update(struct hostapd_data *hapd);
+void hostapd_status_shm_update_iface(struct hostapd_iface *iface);
+
+#else /* CONFIG_STATUS_SHM */
+
+static inline int hostapd_status_shm_init(struct hostapd_data *hapd)
+{
+	return 0;
+}
+
+static inline void hostapd_status_shm_deinit(struct hostapd_data *hapd)
+{
+}
+
+static inline void hostapd_status_shm_update(struct hostapd_data *hapd)
+{
+}
+
+static inline void hostapd_status_shm_update_iface(struct hostapd_iface *iface)
+{
+}
+
+#endif /* CONFIG_STATUS_SHM */
+
+#endif /* AP_STATUS_SHM_H */
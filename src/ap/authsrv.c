@@ -78,6 +78,11 @@ static int hostapd_radius_get_eap_user(void *ctx, const u8 *identity,
 			goto out;
 		user->password_len = eap_user->password_len;
 		user->password_hash = eap_user->password_hash;
+		if (eap_user->nt_hash_set) {
+			os_memcpy(user->nt_hash, eap_user->nt_hash,
+				  sizeof(user->nt_hash));
+			user->nt_hash_set = 1;
+		}
 		if (eap_user->salt && eap_user->salt_len) {
 			user->salt = os_memdup(eap_user->salt,
 					       eap_user->salt_len);
@@ -128,6 +133,7 @@ static int hostapd_setup_radius_srv(struct hostapd_data *hapd)
 	srv.acct_port = conf->radius_server_acct_port;
 	srv.conf_ctx = hapd;
 	srv.ipv6 = conf->radius_server_ipv6;
+	srv.num_workers = conf->radius_server_workers;
 	srv.get_eap_user = hostapd_radius_get_eap_user;
 	srv.eap_req_id_text = conf->eap_req_id_text;
 	srv.eap_req_id_text_len = conf->eap_req_id_text_len;
@@ -206,6 +212,7 @@ static struct eap_config * authsrv_eap_config(struct hostapd_data *hapd)
 	cfg->msg_ctx = hapd->msg_ctx;
 	cfg->eap_sim_db_priv = hapd->eap_sim_db_priv;
 	cfg->tls_session_lifetime = hapd->conf->tls_session_lifetime;
+	cfg->tls_session_tickets = !!hapd->conf->tls_session_ticket_keys;
 	cfg->tls_flags = hapd->conf->tls_flags;
 	cfg->max_auth_rounds = hapd->conf->max_auth_rounds;
 	cfg->max_auth_rounds_short = hapd->conf->max_auth_rounds_short;
@@ -295,6 +302,8 @@ int authsrv_init(struct hostapd_data *hapd)
 
 		os_memset(&conf, 0, sizeof(conf));
 		conf.tls_session_lifetime = hapd->conf->tls_session_lifetime;
+		conf.tls_session_cache_size =
+			hapd->conf->tls_session_cache_size;
 		if (hapd->conf->crl_reload_interval > 0 &&
 		    hapd->conf->check_crl <= 0) {
 			wpa_printf(MSG_INFO,
@@ -345,6 +354,12 @@ int authsrv_init(struct hostapd_data *hapd)
 			authsrv_deinit(hapd);
 			return -1;
 		}
+
+		if (hapd->conf->tls_session_ticket_keys &&
+		    authsrv_reload_ticket_keys(hapd) < 0) {
+			authsrv_deinit(hapd);
+			return -1;
+		}
 	}
 #endif /* EAP_TLS_FUNCS */
 
@@ -443,3 +458,106 @@ void authsrv_deinit(struct hostapd_data *hapd)
 	eap_server_config_free(hapd->eap_cfg);
 	hapd->eap_cfg = NULL;
 }
+
+
+/**
+ * authsrv_set_ticket_keys - Set TLS session ticket keys
+ * @hapd: Pointer to BSS data
+ * @keys: Key ring as whitespace separated hex strings; the first key is used
+ *	for issuing new tickets and '#' starts a comment that ends at the end of
+ *	the line
+ * Returns: 0 on success, -1 on failure
+ */
+int authsrv_set_ticket_keys(struct hostapd_data *hapd, const char *keys)
+{
+#ifdef EAP_TLS_FUNCS
+	const char *pos = keys, *end;
+	u8 *ring = NULL, *tmp;
+	size_t num = 0;
+	int ret;
+
+	if (!hapd->ssl_ctx)
+		return -1;
+
+	while (*pos) {
+		if (isspace((unsigned char) *pos)) {
+			pos++;
+			continue;
+		}
+		if (*pos == '#') {
+			while (*pos && *pos != '\n')
+				pos++;
+			continue;
+		}
+
+		end = pos;
+		while (*end && !isspace((unsigned char) *end))
+			end++;
+		tmp = os_realloc_array(ring, num + 1,
+				       TLS_SESSION_TICKET_KEY_LEN);
+		if (!tmp)
+			goto fail;
+		ring = tmp;
+		if (end - pos != 2 * TLS_SESSION_TICKET_KEY_LEN ||
+		    hexstr2bin(pos, &ring[num * TLS_SESSION_TICKET_KEY_LEN],
+			       TLS_SESSION_TICKET_KEY_LEN) < 0) {
+			wpa_printf(MSG_ERROR,
+				   "Invalid TLS session ticket key #%u",
+				   (unsigned int) num + 1);
+			goto fail;
+		}
+		num++;
+		pos = end;
+	}
+
+	if (!num) {
+		wpa_printf(MSG_ERROR, "No TLS session ticket keys found");
+		goto fail;
+	}
+
+	ret = tls_set_session_ticket_keys(hapd->ssl_ctx, ring, num);
+	bin_clear_free(ring, num * TLS_SESSION_TICKET_KEY_LEN);
+	if (ret == 0)
+		wpa_printf(MSG_DEBUG, "Configured %u TLS session ticket key(s)",
+			   (unsigned int) num);
+	return ret;
+
+fail:
+	bin_clear_free(ring, num * TLS_SESSION_TICKET_KEY_LEN);
+	return -1;
+#else /* EAP_TLS_FUNCS */
+	return -1;
+#endif /* EAP_TLS_FUNCS */
+}
+
+
+/**
+ * authsrv_reload_ticket_keys - Reload TLS session ticket keys from file
+ * @hapd: Pointer to BSS data
+ * Returns: 0 on success, -1 on failure
+ */
+int authsrv_reload_ticket_keys(struct hostapd_data *hapd)
+{
+	char *buf, *keys;
+	size_t len;
+	int ret;
+
+	if (!hapd->conf->tls_session_ticket_keys)
+		return -1;
+
+	buf = os_readfile(hapd->conf->tls_session_ticket_keys, &len);
+	if (!buf) {
+		wpa_printf(MSG_ERROR,
+			   "Could not read TLS session ticket keys from '%s'",
+			   hapd->conf->tls_session_ticket_keys);
+		return -1;
+	}
+
+	keys = dup_binstr(buf, len);
+	bin_clear_free(buf, len);
+	if (!keys)
+		return -1;
+	ret = authsrv_set_ticket_keys(hapd, keys);
+	bin_clear_free(keys, len);
+	return ret;
+}
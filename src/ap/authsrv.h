@@ -11,5 +11,7 @@
 
 int authsrv_init(struct hostapd_data *hapd);
 void authsrv_deinit(struct hostapd_data *hapd);
+int authsrv_set_ticket_keys(struct hostapd_data *hapd, const char *keys);
+int authsrv_reload_ticket_keys(struct hostapd_data *hapd);
 
 #endif /* AUTHSRV_H */
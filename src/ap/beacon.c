@@ -257,16 +257,12 @@ static u8 * hostapd_fill_subband_triplets(struct hostapd_data *hapd, u8 *pos,
 }
 
 
-static u8 * hostapd_eid_country(struct hostapd_data *hapd, u8 *eid,
-				int max_len)
+static u8 * hostapd_eid_country_build(struct hostapd_data *hapd, u8 *eid,
+				      int max_len)
 {
 	u8 *pos = eid;
 	u8 *end = eid + max_len;
 
-	if (!hapd->iconf->ieee80211d || max_len < 6 ||
-	    hapd->iface->current_mode == NULL)
-		return eid;
-
 	*pos++ = WLAN_EID_COUNTRY;
 	pos++; /* length will be set later */
 	os_memcpy(pos, hapd->iconf->country, 3); /* e.g., 'US ' */
@@ -305,6 +301,41 @@ static u8 * hostapd_eid_country(struct hostapd_data *hapd, u8 *eid,
 }
 
 
+static u8 * hostapd_eid_country(struct hostapd_data *hapd, u8 *eid,
+				int max_len)
+{
+	struct hostapd_iface *iface = hapd->iface;
+	struct hostapd_config *iconf = hapd->iconf;
+
+	if (!iconf->ieee80211d || max_len < 6 || iface->current_mode == NULL)
+		return eid;
+
+	/* The element depends only on the radio configuration and channel
+	 * data, so build it once and share it between the BSSs and frames. */
+	if (!iface->country_elem.len ||
+	    iface->country_elem.mode != iface->current_mode ||
+	    iface->country_elem.hw_features_gen != iface->hw_features_gen ||
+	    iface->country_elem.op_class != iconf->op_class ||
+	    os_memcmp(iface->country_elem.country, iconf->country, 3) != 0) {
+		u8 *end;
+
+		end = hostapd_eid_country_build(
+			hapd, iface->country_elem.elem,
+			sizeof(iface->country_elem.elem));
+		iface->country_elem.len = end - iface->country_elem.elem;
+		iface->country_elem.mode = iface->current_mode;
+		iface->country_elem.hw_features_gen = iface->hw_features_gen;
+		iface->country_elem.op_class = iconf->op_class;
+		os_memcpy(iface->country_elem.country, iconf->country, 3);
+	}
+
+	if (iface->country_elem.len > (size_t) max_len)
+		return hostapd_eid_country_build(hapd, eid, max_len);
+	os_memcpy(eid, iface->country_elem.elem, iface->country_elem.len);
+	return eid + iface->country_elem.len;
+}
+
+
 const u8 * hostapd_wpa_ie(struct hostapd_data *hapd, u8 eid)
 {
 	const u8 *ies;
@@ -571,13 +602,76 @@ static u8 * hostapd_eid_supported_op_classes(struct hostapd_data *hapd, u8 *eid)
 }
 
 
+static int hostapd_mbssid_dup_elems(const u8 *elem, size_t len,
+				    u8 *const *offset, size_t count,
+				    size_t slots, u8 **elem_copy,
+				    u8 ***offset_copy)
+{
+	size_t i;
+
+	*elem_copy = os_memdup(elem, len);
+	*offset_copy = os_calloc(slots, sizeof(u8 *));
+	if (!*elem_copy || !*offset_copy) {
+		os_free(*elem_copy);
+		*elem_copy = NULL;
+		os_free(*offset_copy);
+		*offset_copy = NULL;
+		return -1;
+	}
+
+	for (i = 0; i < count; i++)
+		(*offset_copy)[i] = *elem_copy + (offset[i] - elem);
+
+	return 0;
+}
+
+
+static void hostapd_mbssid_batch_clear(struct hostapd_iface *iface)
+{
+	os_free(iface->mbssid_batch.elem);
+	os_free(iface->mbssid_batch.elem_offset);
+	os_free(iface->mbssid_batch.rnr_elem);
+	os_free(iface->mbssid_batch.rnr_elem_offset);
+	os_memset(&iface->mbssid_batch, 0, sizeof(iface->mbssid_batch));
+}
+
+
+static void hostapd_mbssid_batch_store(struct hostapd_iface *iface,
+				       const u8 *elem, size_t elem_len,
+				       u8 elem_count, u8 *const *elem_offset,
+				       const u8 *rnr_elem, size_t rnr_elem_len,
+				       u8 rnr_elem_count,
+				       u8 *const *rnr_elem_offset)
+{
+	if (hostapd_mbssid_dup_elems(elem, elem_len, elem_offset, elem_count,
+				     elem_count, &iface->mbssid_batch.elem,
+				     &iface->mbssid_batch.elem_offset))
+		return;
+
+	if (rnr_elem &&
+	    hostapd_mbssid_dup_elems(rnr_elem, rnr_elem_len, rnr_elem_offset,
+				     rnr_elem_count, elem_count + 1,
+				     &iface->mbssid_batch.rnr_elem,
+				     &iface->mbssid_batch.rnr_elem_offset)) {
+		hostapd_mbssid_batch_clear(iface);
+		iface->mbssid_batch.active = true;
+		return;
+	}
+
+	iface->mbssid_batch.elem_len = elem_len;
+	iface->mbssid_batch.elem_count = elem_count;
+	iface->mbssid_batch.rnr_elem_len = rnr_elem_len;
+	iface->mbssid_batch.rnr_elem_count = rnr_elem_count;
+}
+
+
 static int
 ieee802_11_build_ap_params_mbssid(struct hostapd_data *hapd,
 				  struct wpa_driver_ap_params *params)
 {
 	struct hostapd_iface *iface = hapd->iface;
 	struct hostapd_data *tx_bss;
-	size_t len, rnr_len = 0;
+	size_t len, rnr_len = 0, elem_len;
 	u8 elem_count = 0, *elem = NULL, **elem_offset = NULL, *end;
 	u8 rnr_elem_count = 0, *rnr_elem = NULL, **rnr_elem_offset = NULL;
 	size_t i;
@@ -588,6 +682,32 @@ ieee802_11_build_ap_params_mbssid(struct hostapd_data *hapd,
 	     !iface->ema_max_periodicity))
 		goto fail;
 
+	if (iface->mbssid_batch.elem) {
+		/* The elements describe the transmitting BSS and all its
+		 * nontransmitted profiles, so they are the same for every BSS
+		 * of the set; only the copy is needed here. */
+		tx_bss = hostapd_mbssid_get_tx_bss(hapd);
+		elem_count = iface->mbssid_batch.elem_count;
+		elem_len = iface->mbssid_batch.elem_len;
+		if (hostapd_mbssid_dup_elems(iface->mbssid_batch.elem,
+					     elem_len,
+					     iface->mbssid_batch.elem_offset,
+					     elem_count, elem_count,
+					     &elem, &elem_offset))
+			goto fail;
+
+		rnr_len = iface->mbssid_batch.rnr_elem_len;
+		rnr_elem_count = iface->mbssid_batch.rnr_elem_count;
+		if (iface->mbssid_batch.rnr_elem &&
+		    hostapd_mbssid_dup_elems(iface->mbssid_batch.rnr_elem,
+					     rnr_len,
+					     iface->mbssid_batch.rnr_elem_offset,
+					     rnr_elem_count, elem_count + 1,
+					     &rnr_elem, &rnr_elem_offset))
+			goto fail;
+		goto out;
+	}
+
 	/* Make sure bss->xrates_supported is set for all BSSs to know whether
 	 * it need to be non-inherited. */
 	for (i = 0; i < iface->num_bss; i++) {
@@ -624,11 +744,18 @@ ieee802_11_build_ap_params_mbssid(struct hostapd_data *hapd,
 	end = hostapd_eid_mbssid(tx_bss, elem, elem + len, WLAN_FC_STYPE_BEACON,
 				 elem_count, elem_offset, NULL, 0, rnr_elem,
 				 &rnr_elem_count, rnr_elem_offset, rnr_len);
+	elem_len = end - elem;
+
+	if (iface->mbssid_batch.active)
+		hostapd_mbssid_batch_store(iface, elem, elem_len, elem_count,
+					   elem_offset, rnr_elem, rnr_len,
+					   rnr_elem_count, rnr_elem_offset);
 
+out:
 	params->mbssid_tx_iface = tx_bss->conf->iface;
 	params->mbssid_index = hostapd_mbssid_get_bss_index(hapd);
 	params->mbssid_elem = elem;
-	params->mbssid_elem_len = end - elem;
+	params->mbssid_elem_len = elem_len;
 	params->mbssid_elem_count = elem_count;
 	params->mbssid_elem_offset = elem_offset;
 	params->rnr_elem = rnr_elem;
@@ -707,11 +834,14 @@ struct probe_resp_params {
 	/* Generated IEs will be included inside an ML element */
 	struct hostapd_data *mld_ap;
 	struct mld_info *mld_info;
+	u16 links;
 
 	struct ieee80211_mgmt *resp;
 	size_t resp_len;
+	bool from_tmpl; /* resp is owned by hapd->probe_resp_tmpl[] */
 	u8 *csa_pos;
 	u8 *ecsa_pos;
+	u8 *bss_load_pos;
 	const u8 *known_bss;
 	u8 known_bss_len;
 
@@ -840,7 +970,17 @@ static u8 * hostapd_probe_resp_fill_elems(struct hostapd_data *hapd,
 	pos = hostapd_eid_ext_supp_rates(hapd, pos);
 
 	pos = hostapd_get_rsne(hapd, pos, epos - pos);
+
+	/* BSS Load element; the dynamic fields are updated in templates */
+	params->bss_load_pos = pos;
 	pos = hostapd_eid_bss_load(hapd, pos, epos - pos);
+	if (pos == params->bss_load_pos)
+		params->bss_load_pos = NULL;
+#ifdef CONFIG_TESTING_OPTIONS
+	if (hapd->conf->bss_load_test_set)
+		params->bss_load_pos = NULL;
+#endif /* CONFIG_TESTING_OPTIONS */
+
 	pos = hostapd_eid_mbssid(hapd, pos, epos, WLAN_FC_STYPE_PROBE_RESP, 0,
 				 NULL, params->known_bss, params->known_bss_len,
 				 NULL, NULL, NULL, 0);
@@ -1005,6 +1145,23 @@ static u8 * hostapd_probe_resp_fill_elems(struct hostapd_data *hapd,
 }
 
 
+static void hostapd_probe_resp_set_da(struct hostapd_data *hapd,
+				      struct probe_resp_params *params)
+{
+	/* Unicast the response to all requests on bands other than 6 GHz. For
+	 * the 6 GHz, unicast is used only if the actual SSID is not included in
+	 * the Beacon frames. Otherwise, broadcast response is used per IEEE
+	 * Std 802.11ax-2021, 26.17.2.3.2. Broadcast address is also used for
+	 * the Probe Response frame template for the unsolicited (i.e., not as
+	 * a response to a specific request) case. */
+	if (params->req && (!is_6ghz_op_class(hapd->iconf->op_class) ||
+		    hapd->conf->ignore_broadcast_ssid))
+		os_memcpy(params->resp->da, params->req->sa, ETH_ALEN);
+	else
+		os_memset(params->resp->da, 0xff, ETH_ALEN);
+}
+
+
 static void hostapd_gen_probe_resp(struct hostapd_data *hapd,
 				   struct probe_resp_params *params)
 {
@@ -1024,17 +1181,7 @@ static void hostapd_gen_probe_resp(struct hostapd_data *hapd,
 
 	params->resp->frame_control = IEEE80211_FC(WLAN_FC_TYPE_MGMT,
 						   WLAN_FC_STYPE_PROBE_RESP);
-	/* Unicast the response to all requests on bands other than 6 GHz. For
-	 * the 6 GHz, unicast is used only if the actual SSID is not included in
-	 * the Beacon frames. Otherwise, broadcast response is used per IEEE
-	 * Std 802.11ax-2021, 26.17.2.3.2. Broadcast address is also used for
-	 * the Probe Response frame template for the unsolicited (i.e., not as
-	 * a response to a specific request) case. */
-	if (params->req && (!is_6ghz_op_class(hapd->iconf->op_class) ||
-		    hapd->conf->ignore_broadcast_ssid))
-		os_memcpy(params->resp->da, params->req->sa, ETH_ALEN);
-	else
-		os_memset(params->resp->da, 0xff, ETH_ALEN);
+	hostapd_probe_resp_set_da(hapd, params);
 	os_memcpy(params->resp->sa, hapd->own_addr, ETH_ALEN);
 
 	os_memcpy(params->resp->bssid, hapd->own_addr, ETH_ALEN);
@@ -1053,6 +1200,123 @@ static void hostapd_gen_probe_resp(struct hostapd_data *hapd,
 }
 
 
+void hostapd_flush_probe_resp_tmpl(struct hostapd_data *hapd)
+{
+	unsigned int i;
+
+	for (i = 0; i < HOSTAPD_PROBE_RESP_TMPL_MAX; i++) {
+		os_free(hapd->probe_resp_tmpl[i].resp);
+		hapd->probe_resp_tmpl[i].resp = NULL;
+	}
+	hapd->probe_resp_tmpl_next = 0;
+}
+
+
+static bool hostapd_probe_resp_tmpl_usable(struct hostapd_data *hapd,
+					   struct probe_resp_params *params)
+{
+	/* The templates are flushed whenever the Beacon frame is updated, so
+	 * they cannot be used before the first update or while the frame
+	 * contents are changing every Beacon interval. */
+	if (!hapd->beacon_set_done || hapd->csa_in_progress)
+		return false;
+#ifdef CONFIG_IEEE80211AX
+	if (hapd->cca_in_progress)
+		return false;
+#endif /* CONFIG_IEEE80211AX */
+
+	/* The Multiple BSSID element and the Extended Capabilities element
+	 * depend on the list of BSSes known by the STA. */
+	return params->known_bss_len == 0;
+}
+
+
+static struct hostapd_probe_resp_tmpl *
+hostapd_probe_resp_tmpl_find(struct hostapd_data *hapd,
+			     struct probe_resp_params *params)
+{
+	unsigned int i;
+	bool ml = !!params->mld_info;
+
+	for (i = 0; i < HOSTAPD_PROBE_RESP_TMPL_MAX; i++) {
+		struct hostapd_probe_resp_tmpl *tmpl = &hapd->probe_resp_tmpl[i];
+
+		if (!tmpl->resp || tmpl->is_p2p != params->is_p2p ||
+		    tmpl->ml != ml)
+			continue;
+		if (ml && (tmpl->mld_ap != params->mld_ap ||
+			   tmpl->links != params->links))
+			continue;
+		return tmpl;
+	}
+
+	return NULL;
+}
+
+
+/*
+ * Use a pre-built Probe Response frame, if one is available, with the
+ * per-request fields updated. On success, params->resp points to the template
+ * buffer which must not be freed by the caller.
+ */
+static bool hostapd_probe_resp_from_tmpl(struct hostapd_data *hapd,
+					 struct probe_resp_params *params)
+{
+	struct hostapd_probe_resp_tmpl *tmpl;
+
+	hapd = hostapd_mbssid_get_tx_bss(hapd);
+	if (!hostapd_probe_resp_tmpl_usable(hapd, params))
+		return false;
+
+	tmpl = hostapd_probe_resp_tmpl_find(hapd, params);
+	if (!tmpl)
+		return false;
+
+	params->resp = (struct ieee80211_mgmt *) tmpl->resp;
+	params->resp_len = tmpl->resp_len;
+	params->from_tmpl = true;
+	hostapd_probe_resp_set_da(hapd, params);
+	if (tmpl->bss_load_offs) {
+		u8 *bss_load = tmpl->resp + tmpl->bss_load_offs;
+
+		WPA_PUT_LE16(&bss_load[2], hapd->num_sta);
+		bss_load[4] = hapd->iface->channel_utilization;
+	}
+
+	return true;
+}
+
+
+/* Take over a generated Probe Response frame as a template for later use */
+static void hostapd_probe_resp_tmpl_store(struct hostapd_data *hapd,
+					  struct probe_resp_params *params)
+{
+	struct hostapd_probe_resp_tmpl *tmpl;
+
+	hapd = hostapd_mbssid_get_tx_bss(hapd);
+	if (!params->resp || !hostapd_probe_resp_tmpl_usable(hapd, params))
+		return;
+
+	tmpl = hostapd_probe_resp_tmpl_find(hapd, params);
+	if (!tmpl) {
+		tmpl = &hapd->probe_resp_tmpl[hapd->probe_resp_tmpl_next];
+		hapd->probe_resp_tmpl_next = (hapd->probe_resp_tmpl_next + 1) %
+			HOSTAPD_PROBE_RESP_TMPL_MAX;
+	}
+
+	os_free(tmpl->resp);
+	tmpl->resp = (u8 *) params->resp;
+	tmpl->resp_len = params->resp_len;
+	tmpl->bss_load_offs = params->bss_load_pos ?
+		params->bss_load_pos - tmpl->resp : 0;
+	tmpl->is_p2p = params->is_p2p;
+	tmpl->ml = !!params->mld_info;
+	tmpl->mld_ap = params->mld_ap;
+	tmpl->links = params->links;
+	params->from_tmpl = true;
+}
+
+
 #ifdef CONFIG_IEEE80211BE
 static void hostapd_fill_probe_resp_ml_params(struct hostapd_data *hapd,
 					      struct probe_resp_params *params,
@@ -1065,6 +1329,7 @@ static void hostapd_fill_probe_resp_ml_params(struct hostapd_data *hapd,
 	params->mld_info = os_zalloc(sizeof(*params->mld_info));
 	if (!params->mld_info)
 		return;
+	params->links = links;
 
 	wpa_printf(MSG_DEBUG,
 		   "MLD: Got ML probe request with AP MLD ID %d for links %04x",
@@ -1225,8 +1490,8 @@ void sta_track_expire(struct hostapd_iface *iface, int force)
 }
 
 
-static struct hostapd_sta_info * sta_track_get(struct hostapd_iface *iface,
-					       const u8 *addr)
+struct hostapd_sta_info * sta_track_get(struct hostapd_iface *iface,
+					const u8 *addr)
 {
 	struct hostapd_sta_info *info;
 
@@ -1249,6 +1514,12 @@ void sta_track_add(struct hostapd_iface *iface, const u8 *addr, int ssi_signal)
 		dl_list_add_tail(&iface->sta_seen, &info->list);
 		os_get_reltime(&info->last_seen);
 		info->ssi_signal = ssi_signal;
+		if (!ssi_signal)
+			return;
+		if (info->ssi_avg)
+			info->ssi_avg = (3 * info->ssi_avg + ssi_signal) / 4;
+		else
+			info->ssi_avg = ssi_signal;
 		return;
 	}
 
@@ -1259,6 +1530,7 @@ void sta_track_add(struct hostapd_iface *iface, const u8 *addr, int ssi_signal)
 	os_memcpy(info->addr, addr, ETH_ALEN);
 	os_get_reltime(&info->last_seen);
 	info->ssi_signal = ssi_signal;
+	info->ssi_avg = ssi_signal;
 
 	if (iface->num_sta_seen >= iface->conf->track_sta_max_num) {
 		/* Expire oldest entry to make room for a new one */
@@ -1300,7 +1572,7 @@ sta_track_seen_on(struct hostapd_iface *iface, const u8 *addr,
 
 #ifdef CONFIG_TAXONOMY
 void sta_track_claim_taxonomy_info(struct hostapd_iface *iface, const u8 *addr,
-				   struct wpabuf **probe_ie_taxonomy)
+				   struct taxonomy_info **probe_taxonomy)
 {
 	struct hostapd_sta_info *info;
 
@@ -1308,9 +1580,9 @@ void sta_track_claim_taxonomy_info(struct hostapd_iface *iface, const u8 *addr,
 	if (!info)
 		return;
 
-	wpabuf_free(*probe_ie_taxonomy);
-	*probe_ie_taxonomy = info->probe_ie_taxonomy;
-	info->probe_ie_taxonomy = NULL;
+	os_free(*probe_taxonomy);
+	*probe_taxonomy = info->probe_taxonomy;
+	info->probe_taxonomy = NULL;
 }
 #endif /* CONFIG_TAXONOMY */
 
@@ -1665,7 +1937,10 @@ void handle_probe_req(struct hostapd_data *hapd,
 	params.known_bss = elems.mbssid_known_bss;
 	params.known_bss_len = elems.mbssid_known_bss_len;
 
-	hostapd_gen_probe_resp(hapd, &params);
+	if (!hostapd_probe_resp_from_tmpl(hapd, &params)) {
+		hostapd_gen_probe_resp(hapd, &params);
+		hostapd_probe_resp_tmpl_store(hapd, &params);
+	}
 
 	hostapd_free_probe_resp_params(&params);
 
@@ -1697,7 +1972,8 @@ void handle_probe_req(struct hostapd_data *hapd,
 	if (ret < 0)
 		wpa_printf(MSG_INFO, "handle_probe_req: send failed");
 
-	os_free(params.resp);
+	if (!params.from_tmpl)
+		os_free(params.resp);
 
 	wpa_printf(MSG_EXCESSIVE, "STA " MACSTR " sent probe request for %s "
 		   "SSID", MAC2STR(mgmt->sa),
@@ -1800,8 +2076,8 @@ u8 * hostapd_unsol_bcast_probe_resp(struct hostapd_data *hapd,
 void sta_track_del(struct hostapd_sta_info *info)
 {
 #ifdef CONFIG_TAXONOMY
-	wpabuf_free(info->probe_ie_taxonomy);
-	info->probe_ie_taxonomy = NULL;
+	os_free(info->probe_taxonomy);
+	info->probe_taxonomy = NULL;
 #endif /* CONFIG_TAXONOMY */
 	os_free(info);
 }
@@ -2146,6 +2422,26 @@ static u8 * hostapd_fils_discovery(struct hostapd_data *hapd,
 #endif /* CONFIG_FILS */
 
 
+/* Whether Probe Request frames for foreign SSIDs can be dropped by the driver */
+static bool hostapd_probe_req_ssid_filter(struct hostapd_data *hapd)
+{
+	if (!hapd->conf->probe_req_ssid_filter ||
+	    !hapd->conf->send_probe_response)
+		return false;
+
+	/* These need to see all Probe Request frames */
+	if (hapd->num_probereq_cb || hapd->iconf->track_sta_max_num ||
+	    hapd->conf->notify_mgmt_frames)
+		return false;
+#ifdef CONFIG_P2P
+	if (hapd->conf->p2p & P2P_ENABLED)
+		return false;
+#endif /* CONFIG_P2P */
+
+	return true;
+}
+
+
 int ieee802_11_build_ap_params(struct hostapd_data *hapd,
 			       struct wpa_driver_ap_params *params)
 {
@@ -2547,6 +2843,7 @@ int ieee802_11_build_ap_params(struct hostapd_data *hapd,
 		params->hide_ssid = HIDDEN_SSID_ZERO_CONTENTS;
 		break;
 	}
+	params->probe_req_ssid_filter = hostapd_probe_req_ssid_filter(hapd);
 	params->isolate = hapd->conf->isolate;
 #ifdef NEED_AP_MLME
 	params->cts_protect = !!(ieee802_11_erp_info(hapd) &
@@ -2635,6 +2932,99 @@ void ieee802_11_free_ap_params(struct wpa_driver_ap_params *params)
 }
 
 
+#define BEACON_SIG_PARTS 20
+
+/* Source of unique values for hostapd_data::beacon_gen */
+static unsigned int beacon_gen_counter;
+
+/*
+ * Build a serialized copy of everything that set_ap() passes to the driver so
+ * that an update that would not change anything can be skipped. Pointers are
+ * replaced with the data they point to; if a pointer field is ever missed
+ * here, the signature differs on each call and the update is just not
+ * skipped.
+ */
+static struct wpabuf *
+hostapd_beacon_sig(const struct wpa_driver_ap_params *params)
+{
+	struct wpa_driver_ap_params scalars;
+	const void *data[BEACON_SIG_PARTS];
+	size_t data_len[BEACON_SIG_PARTS];
+	struct wpabuf *buf;
+	size_t len = 0, count;
+	int i, n = 1;
+
+	os_memcpy(&scalars, params, sizeof(scalars));
+	scalars.head = NULL;
+	scalars.tail = NULL;
+	scalars.basic_rates = NULL;
+	scalars.proberesp = NULL;
+	scalars.ssid = NULL;
+	scalars.beacon_ies = NULL;
+	scalars.proberesp_ies = NULL;
+	scalars.assocresp_ies = NULL;
+	scalars.hessid = NULL;
+	scalars.freq = NULL;
+	scalars.lci = NULL;
+	scalars.civic = NULL;
+	scalars.fd_frame_tmpl = NULL;
+	scalars.mbssid_tx_iface = NULL;
+	scalars.mbssid_elem = NULL;
+	scalars.mbssid_elem_offset = NULL;
+	scalars.rnr_elem = NULL;
+	scalars.rnr_elem_offset = NULL;
+	scalars.ubpr.unsol_bcast_probe_resp_tmpl = NULL;
+	scalars.allowed_freqs = NULL;
+	scalars.sae_password = NULL;
+	data[0] = &scalars;
+	data_len[0] = sizeof(scalars);
+
+#define SIG_ADD(d, l) \
+	do { data[n] = (d); data_len[n] = (d) ? (l) : 0; n++; } while (0)
+#define SIG_ADD_BUF(b) SIG_ADD((b) ? wpabuf_head(b) : NULL, wpabuf_len(b))
+	SIG_ADD(params->head, params->head_len);
+	SIG_ADD(params->tail, params->tail_len);
+	SIG_ADD(params->proberesp, params->proberesp_len);
+	SIG_ADD(params->ssid, params->ssid_len);
+	SIG_ADD_BUF(params->beacon_ies);
+	SIG_ADD_BUF(params->proberesp_ies);
+	SIG_ADD_BUF(params->assocresp_ies);
+	SIG_ADD(params->hessid, ETH_ALEN);
+	SIG_ADD(params->freq, sizeof(*params->freq));
+	SIG_ADD_BUF(params->lci);
+	SIG_ADD_BUF(params->civic);
+	SIG_ADD(params->fd_frame_tmpl, params->fd_frame_tmpl_len);
+	SIG_ADD(params->mbssid_tx_iface, os_strlen(params->mbssid_tx_iface));
+	SIG_ADD(params->mbssid_elem, params->mbssid_elem_len);
+	SIG_ADD(params->rnr_elem, params->rnr_elem_len);
+	SIG_ADD(params->ubpr.unsol_bcast_probe_resp_tmpl,
+		params->ubpr.unsol_bcast_probe_resp_tmpl_len);
+	SIG_ADD(params->sae_password, os_strlen(params->sae_password));
+	for (count = 0; params->allowed_freqs &&
+		     params->allowed_freqs[count]; count++)
+		;
+	SIG_ADD(params->allowed_freqs, count * sizeof(int));
+	for (count = 0; params->basic_rates &&
+		     params->basic_rates[count] >= 0; count++)
+		;
+	SIG_ADD(params->basic_rates, count * sizeof(int));
+#undef SIG_ADD_BUF
+#undef SIG_ADD
+
+	for (i = 0; i < n; i++)
+		len += sizeof(u32) + data_len[i];
+	buf = wpabuf_alloc(len);
+	if (!buf)
+		return NULL;
+	for (i = 0; i < n; i++) {
+		wpabuf_put_le32(buf, data_len[i]);
+		wpabuf_put_data(buf, data[i], data_len[i]);
+	}
+
+	return buf;
+}
+
+
 static int __ieee802_11_set_beacon(struct hostapd_data *hapd)
 {
 	struct wpa_driver_ap_params params;
@@ -2642,11 +3032,16 @@ static int __ieee802_11_set_beacon(struct hostapd_data *hapd)
 	struct hostapd_iface *iface = hapd->iface;
 	struct hostapd_config *iconf = iface->conf;
 	struct hostapd_hw_modes *cmode = iface->current_mode;
-	struct wpabuf *beacon, *proberesp, *assocresp;
-	bool twt_he_responder = false;
+	struct wpabuf *beacon, *proberesp, *assocresp, *sig;
+	bool twt_he_responder = false, unchanged;
 	int res, ret = -1, i;
 	struct hostapd_hw_modes *mode;
 
+	/* Any pending change to the frame contents invalidates the pre-built
+	 * Probe Response frames even if the update itself fails. */
+	hostapd_flush_probe_resp_tmpl(hapd);
+	hostapd_flush_probe_resp_tmpl(hostapd_mbssid_get_tx_bss(hapd));
+
 	if (!hapd->drv_priv) {
 		wpa_printf(MSG_ERROR, "Interface is disabled");
 		return -1;
@@ -2742,12 +3137,33 @@ static int __ieee802_11_set_beacon(struct hostapd_data *hapd)
 						 true, &params.allowed_freqs);
 	}
 
-	res = hostapd_drv_set_ap(hapd, &params);
+	sig = hostapd_beacon_sig(&params);
+	unchanged = sig && hapd->beacon_sig &&
+		wpabuf_len(sig) == wpabuf_len(hapd->beacon_sig) &&
+		os_memcmp(wpabuf_head(sig), wpabuf_head(hapd->beacon_sig),
+			  wpabuf_len(sig)) == 0;
+	if (!unchanged)
+		hapd->beacon_gen = ++beacon_gen_counter;
+	if (unchanged && !params.reenable) {
+		/* E.g., a BSS Load or MBSSID/MLD partner update that did not
+		 * change anything for this BSS */
+		wpa_printf(MSG_DEBUG,
+			   "%s: Beacon parameters unchanged - skip driver update",
+			   hapd->conf->iface);
+		res = 0;
+	} else {
+		res = hostapd_drv_set_ap(hapd, &params);
+	}
 	hostapd_free_ap_extra_ies(hapd, beacon, proberesp, assocresp);
-	if (res)
+	wpabuf_free(hapd->beacon_sig);
+	hapd->beacon_sig = NULL;
+	if (res) {
 		wpa_printf(MSG_ERROR, "Failed to set beacon parameters");
-	else
+		wpabuf_free(sig);
+	} else {
+		hapd->beacon_sig = sig;
 		ret = 0;
+	}
 fail:
 	ieee802_11_free_ap_params(&params);
 	return ret;
@@ -3086,6 +3502,19 @@ static u8 * hostapd_gen_sta_profile(struct ieee80211_mgmt *link_data,
 }
 
 
+static bool hostapd_sta_profile_current(struct hostapd_data *hapd,
+					struct hostapd_data *link_bss)
+{
+	struct mld_link_info *link_info =
+		&hapd->partner_links[link_bss->mld_link_id];
+
+	return link_info->valid && link_info->resp_sta_profile &&
+		hapd->beacon_gen && link_bss->beacon_gen &&
+		link_info->own_gen == hapd->beacon_gen &&
+		link_info->link_gen == link_bss->beacon_gen;
+}
+
+
 static void hostapd_gen_per_sta_profiles(struct hostapd_data *hapd)
 {
 	bool tx_vap = hapd == hostapd_mbssid_get_tx_bss(hapd);
@@ -3098,10 +3527,29 @@ static void hostapd_gen_per_sta_profiles(struct hostapd_data *hapd)
 	struct mld_link_info *link_info;
 	struct hostapd_data *link_bss;
 	u8 link_id, *sta_profile;
+	bool dirty = false;
 
 	if (!hapd->conf->mld_ap)
 		return;
 
+	/* A profile only needs to be rebuilt if the frame contents of either
+	 * of the two APs have changed since it was generated. */
+	for_each_mld_link(link_bss, hapd) {
+		if (link_bss == hapd || !link_bss->started ||
+		    link_bss->mld_link_id >= MAX_NUM_MLD_LINKS)
+			continue;
+		if (!hostapd_sta_profile_current(hapd, link_bss)) {
+			dirty = true;
+			break;
+		}
+	}
+	if (!dirty) {
+		wpa_printf(MSG_DEBUG,
+			   "MLD: Per STA profiles for MLD %s are up to date",
+			   hapd->conf->iface);
+		return;
+	}
+
 	wpa_printf(MSG_DEBUG, "MLD: Generating per STA profiles for MLD %s",
 		   hapd->conf->iface);
 
@@ -3128,6 +3576,10 @@ static void hostapd_gen_per_sta_profiles(struct hostapd_data *hapd)
 		if (link_id >= MAX_NUM_MLD_LINKS)
 			continue;
 
+		link_info = &hapd->partner_links[link_id];
+		if (hostapd_sta_profile_current(hapd, link_bss))
+			continue;
+
 		sta_profile = NULL;
 		sta_profile_len = 0;
 
@@ -3156,8 +3608,9 @@ static void hostapd_gen_per_sta_profiles(struct hostapd_data *hapd)
 			continue;
 		}
 
-		link_info = &hapd->partner_links[link_id];
 		link_info->valid = true;
+		link_info->own_gen = hapd->beacon_gen;
+		link_info->link_gen = link_bss->beacon_gen;
 
 		os_free(link_info->resp_sta_profile);
 		link_info->resp_sta_profile_len = sta_profile_len;
@@ -3245,16 +3698,33 @@ int ieee802_11_set_beacon(struct hostapd_data *hapd)
 }
 
 
+/* Share the MBSSID and RNR elements of the transmitting BSS between the
+ * Beacon frames of all the BSSs updated in one pass over the interface. */
+static bool hostapd_mbssid_batch_begin(struct hostapd_iface *iface)
+{
+	if (iface->mbssid_batch.active || !iface->conf->mbssid ||
+	    iface->num_bss <= 1)
+		return false;
+
+	iface->mbssid_batch.active = true;
+	return true;
+}
+
+
 int ieee802_11_set_beacons(struct hostapd_iface *iface)
 {
 	size_t i;
 	int ret = 0;
+	bool batch;
 
+	batch = hostapd_mbssid_batch_begin(iface);
 	for (i = 0; i < iface->num_bss; i++) {
 		if (iface->bss[i]->started &&
 		    ieee802_11_set_beacon(iface->bss[i]) < 0)
 			ret = -1;
 	}
+	if (batch)
+		hostapd_mbssid_batch_clear(iface);
 
 	return ret;
 }
@@ -3265,12 +3735,16 @@ int ieee802_11_update_beacons(struct hostapd_iface *iface)
 {
 	size_t i;
 	int ret = 0;
+	bool batch;
 
+	batch = hostapd_mbssid_batch_begin(iface);
 	for (i = 0; i < iface->num_bss; i++) {
 		if (iface->bss[i]->beacon_set_done && iface->bss[i]->started &&
 		    ieee802_11_set_beacon(iface->bss[i]) < 0)
 			ret = -1;
 	}
+	if (batch)
+		hostapd_mbssid_batch_clear(iface);
 
 	return ret;
 }
@@ -11,10 +11,12 @@
 #define BEACON_H
 
 struct ieee80211_mgmt;
+struct taxonomy_info;
 
 void handle_probe_req(struct hostapd_data *hapd,
 		      const struct ieee80211_mgmt *mgmt, size_t len,
 		      int ssi_signal);
+void hostapd_flush_probe_resp_tmpl(struct hostapd_data *hapd);
 void ieee802_11_set_beacon_per_bss_only(struct hostapd_data *hapd);
 int ieee802_11_set_beacon(struct hostapd_data *hapd);
 int ieee802_11_set_beacons(struct hostapd_iface *iface);
@@ -25,11 +27,13 @@ void ieee802_11_free_ap_params(struct wpa_driver_ap_params *params);
 void sta_track_add(struct hostapd_iface *iface, const u8 *addr, int ssi_signal);
 void sta_track_del(struct hostapd_sta_info *info);
 void sta_track_expire(struct hostapd_iface *iface, int force);
+struct hostapd_sta_info * sta_track_get(struct hostapd_iface *iface,
+					const u8 *addr);
 struct hostapd_data *
 sta_track_seen_on(struct hostapd_iface *iface, const u8 *addr,
 		  const char *ifname);
 void sta_track_claim_taxonomy_info(struct hostapd_iface *iface, const u8 *addr,
-				   struct wpabuf **probe_ie_taxonomy);
+				   struct taxonomy_info **probe_taxonomy);
 
 const u8 * hostapd_wpa_ie(struct hostapd_data *hapd, u8 eid);
 
@@ -82,18 +82,20 @@ static int hostapd_get_sta_info(struct hostapd_data *hapd,
 				char *buf, size_t buflen)
 {
 	struct hostap_sta_driver_data data;
+	unsigned int age_ms;
 	int ret;
 	int len = 0;
 
-	if (hostapd_drv_read_sta_data(hapd, &data, sta->addr) < 0)
+	if (ap_sta_read_drv_data(hapd, sta, &data, AP_STA_DRV_DATA_ANY_AGE,
+				 &age_ms) < 0)
 		return 0;
 
 	ret = os_snprintf(buf, buflen, "rx_packets=%lu\ntx_packets=%lu\n"
 			  "rx_bytes=%llu\ntx_bytes=%llu\ninactive_msec=%lu\n"
-			  "signal=%d\n",
+			  "signal=%d\ndrv_data_age_ms=%u\n",
 			  data.rx_packets, data.tx_packets,
 			  data.rx_bytes, data.tx_bytes, data.inactive_msec,
-			  data.signal);
+			  data.signal, age_ms);
 	if (os_snprintf_error(buflen, ret))
 		return 0;
 	len += ret;
@@ -474,14 +476,14 @@ static int hostapd_ctrl_iface_sta_mib(struct hostapd_data *hapd,
 	}
 
 #ifdef CONFIG_IEEE80211BE
-	if (sta->mld_info.mld_sta) {
+	if (sta->mld_info && sta->mld_info->mld_sta) {
 		for (i = 0; i < MAX_NUM_MLD_LINKS; ++i) {
-			if (!sta->mld_info.links[i].valid)
+			if (!sta->mld_info->links[i].valid)
 				continue;
 			ret = os_snprintf(
 				buf + len, buflen - len,
 				"peer_addr[%d]=" MACSTR "\n",
-				i, MAC2STR(sta->mld_info.links[i].peer_addr));
+				i, MAC2STR(sta->mld_info->links[i].peer_addr));
 			if (!os_snprintf_error(buflen - len, ret))
 				len += ret;
 		}
@@ -495,6 +497,10 @@ static int hostapd_ctrl_iface_sta_mib(struct hostapd_data *hapd,
 int hostapd_ctrl_iface_sta_first(struct hostapd_data *hapd,
 				 char *buf, size_t buflen)
 {
+	/* Fetch the driver data for all stations at once so that the
+	 * following STA-NEXT commands can use the cached copy. */
+	if (hapd->sta_list && hapd->sta_list->next)
+		ap_sta_refresh_drv_data(hapd, true);
 	return hostapd_ctrl_iface_sta_mib(hapd, hapd->sta_list, buf, buflen);
 }
 
@@ -563,6 +569,117 @@ int hostapd_ctrl_iface_sta_next(struct hostapd_data *hapd, const char *txtaddr,
 }
 
 
+static int hostapd_ctrl_iface_sta_dump_entry(struct hostapd_data *hapd,
+					     struct sta_info *sta,
+					     bool bulk_ok,
+					     char *buf, size_t buflen)
+{
+	struct hostap_sta_driver_data data, *cached;
+	struct os_reltime age;
+	int ret, len = 0;
+
+	ret = os_snprintf(buf, buflen, MACSTR " aid=%u flags=",
+			  MAC2STR(sta->addr), sta->aid);
+	if (os_snprintf_error(buflen, ret))
+		return -1;
+	len += ret;
+
+	ret = ap_sta_flags_txt(sta->flags, buf + len, buflen - len);
+	if (ret < 0)
+		return -1;
+	len += ret;
+
+	if (sta->connected_time.sec) {
+		os_reltime_age(&sta->connected_time, &age);
+		ret = os_snprintf(buf + len, buflen - len,
+				  " connected_time=%lu",
+				  (unsigned long) age.sec);
+		if (os_snprintf_error(buflen - len, ret))
+			return -1;
+		len += ret;
+	}
+
+	cached = bulk_ok ? ap_sta_get_drv_data(hapd, sta) : NULL;
+	if (cached)
+		os_memcpy(&data, cached, sizeof(data));
+	if (cached || hostapd_drv_read_sta_data(hapd, &data, sta->addr) == 0) {
+		ret = os_snprintf(buf + len, buflen - len,
+				  " inactive_msec=%lu rx_packets=%lu tx_packets=%lu rx_bytes=%llu tx_bytes=%llu signal=%d rx_rate_info=%lu tx_rate_info=%lu",
+				  data.inactive_msec,
+				  data.rx_packets, data.tx_packets,
+				  data.rx_bytes, data.tx_bytes, data.signal,
+				  data.current_rx_rate / 100,
+				  data.current_tx_rate / 100);
+		if (os_snprintf_error(buflen - len, ret))
+			return -1;
+		len += ret;
+	}
+
+	ret = os_snprintf(buf + len, buflen - len, "\n");
+	if (os_snprintf_error(buflen - len, ret))
+		return -1;
+	len += ret;
+
+	return len;
+}
+
+
+/**
+ * hostapd_ctrl_iface_sta_dump - Dump compact information for many stations
+ * @hapd: Pointer to BSS data
+ * @txtaddr: Address of the last station from the previous reply or %NULL to
+ *	start from the beginning of the station list
+ * @buf: Buffer for the reply
+ * @buflen: Length of the buffer
+ * Returns: Length of the reply
+ *
+ * Each station is reported on a single line starting with its address. As
+ * many stations as fit into the buffer are included in a reply; the caller
+ * continues with the address from the last line until an empty reply is
+ * returned. The driver data is fetched for all stations of the BSS with a
+ * single request when the driver supports that.
+ */
+int hostapd_ctrl_iface_sta_dump(struct hostapd_data *hapd, const char *txtaddr,
+				char *buf, size_t buflen)
+{
+	u8 addr[ETH_ALEN];
+	struct sta_info *sta;
+	bool bulk_ok;
+	int ret, len = 0;
+
+	if (txtaddr) {
+		if (hwaddr_aton(txtaddr, addr) ||
+		    !(sta = ap_get_sta(hapd, addr))) {
+			ret = os_snprintf(buf, buflen, "FAIL\n");
+			if (os_snprintf_error(buflen, ret))
+				return 0;
+			return ret;
+		}
+		sta = sta->next;
+	} else {
+		sta = hapd->sta_list;
+	}
+
+	if (!sta)
+		return 0;
+
+	/* Take a new snapshot for the first page and reuse it for the
+	 * following ones while it is still fresh. */
+	bulk_ok = ap_sta_refresh_drv_data(hapd, !txtaddr) == 0;
+
+	for (; sta; sta = sta->next) {
+		ret = hostapd_ctrl_iface_sta_dump_entry(hapd, sta, bulk_ok,
+							buf + len,
+							buflen - len);
+		if (ret < 0)
+			break;
+		len += ret;
+	}
+
+	return len;
+}
+
+
 #ifdef CONFIG_P2P_MANAGER
 static int p2p_manager_disconnect(struct hostapd_data *hapd, u16 stype,
 				  u8 minor_reason_code, const u8 *addr)
@@ -1518,7 +1635,6 @@ int hostapd_ctrl_iface_acl_del_mac(struct mac_acl_entry **acl, int *num,
 				   const char *txtaddr)
 {
 	u8 addr[ETH_ALEN];
-	struct vlan_description vlan_id;
 
 	if (!(*num))
 		return 0;
@@ -1526,8 +1642,7 @@ int hostapd_ctrl_iface_acl_del_mac(struct mac_acl_entry **acl, int *num,
 	if (hwaddr_aton(txtaddr, addr))
 		return -1;
 
-	if (hostapd_maclist_found(*acl, *num, addr, &vlan_id))
-		hostapd_remove_acl_mac(acl, num, addr);
+	hostapd_delete_acl_mac(acl, num, addr);
 
 	return 0;
 }
@@ -1536,8 +1651,7 @@ int hostapd_ctrl_iface_acl_del_mac(struct mac_acl_entry **acl, int *num,
 void hostapd_ctrl_iface_acl_clear_list(struct mac_acl_entry **acl,
 				       int *num)
 {
-	while (*num)
-		hostapd_remove_acl_mac(acl, num, (*acl)[0].addr);
+	hostapd_free_acl_maclist(acl, num);
 }
 
 
@@ -1567,8 +1681,7 @@ int hostapd_ctrl_iface_acl_add_mac(struct mac_acl_entry **acl, int *num,
 				   const char *cmd)
 {
 	u8 addr[ETH_ALEN];
-	struct vlan_description vlan_id;
-	int ret = 0, vlanid = 0;
+	int vlanid = 0;
 	const char *pos;
 
 	if (hwaddr_aton(cmd, addr))
@@ -1578,13 +1691,7 @@ int hostapd_ctrl_iface_acl_add_mac(struct mac_acl_entry **acl, int *num,
 	if (pos)
 		vlanid = atoi(pos + 8);
 
-	if (!hostapd_maclist_found(*acl, *num, addr, &vlan_id)) {
-		ret = hostapd_add_acl_maclist(acl, num, vlanid, addr);
-		if (ret != -1 && *acl)
-			qsort(*acl, *num, sizeof(**acl), hostapd_acl_comp);
-	}
-
-	return ret < 0 ? -1 : 0;
+	return hostapd_insert_acl_mac(acl, num, vlanid, addr);
 }
 
 
@@ -622,6 +622,191 @@ dfs_get_valid_channel(struct hostapd_iface *iface,
 }
 
 
+static bool dfs_precac_enabled(struct hostapd_iface *iface)
+{
+	/* Outside ETSI, the CAC result is dropped shortly after the channel is
+	 * no longer monitored by the background chain. */
+	return dfs_use_radar_background(iface) &&
+		iface->conf->background_radar_precac > 0 &&
+		iface->dfs_domain == HOSTAPD_DFS_REGION_ETSI &&
+		hostapd_get_oper_chwidth(iface->conf) !=
+		CONF_OPER_CHWIDTH_80P80MHZ;
+}
+
+
+static bool dfs_precac_valid(struct hostapd_iface *iface,
+			     struct hostapd_dfs_precac *entry)
+{
+	struct hostapd_channel_data *chan;
+	struct os_reltime now;
+	int i, n_chans, n_chans1;
+
+	if (iface->conf->background_radar_precac_lifetime) {
+		os_get_reltime(&now);
+		if (os_reltime_before(&entry->expires, &now))
+			return false;
+	}
+
+	n_chans = dfs_get_used_n_chans(iface, &n_chans1);
+	if (!iface->current_mode || entry->n_chans != n_chans)
+		return false;
+
+	for (i = 0; i < n_chans; i++) {
+		chan = dfs_get_chan_data(iface->current_mode,
+					 entry->freq + i * 20, 0);
+		if (!chan || !dfs_channel_available(chan, DFS_AVAILABLE))
+			return false;
+	}
+
+	return true;
+}
+
+
+/* Remove the entries that can no longer be used and return the number of the
+ * remaining ones */
+static unsigned int dfs_precac_purge(struct hostapd_iface *iface, int freq)
+{
+	struct hostapd_dfs_precac *precac = iface->radar_background.precac;
+	unsigned int i = 0;
+
+	while (i < iface->radar_background.num_precac) {
+		if (precac[i].freq != freq &&
+		    dfs_precac_valid(iface, &precac[i])) {
+			i++;
+			continue;
+		}
+
+		wpa_printf(MSG_DEBUG,
+			   "DFS: Remove pre-cleared channel %d (%d MHz)",
+			   precac[i].channel, precac[i].freq);
+		os_memmove(&precac[i], &precac[i + 1],
+			   (iface->radar_background.num_precac - i - 1) *
+			   sizeof(precac[0]));
+		iface->radar_background.num_precac--;
+	}
+
+	return iface->radar_background.num_precac;
+}
+
+
+static void dfs_precac_add(struct hostapd_iface *iface)
+{
+	struct hostapd_dfs_precac *entry;
+	int n_chans1;
+
+	if (dfs_precac_purge(iface, iface->radar_background.freq) >=
+	    HOSTAPD_DFS_MAX_PRECAC) {
+		/* Drop the oldest entry */
+		os_memmove(&iface->radar_background.precac[0],
+			   &iface->radar_background.precac[1],
+			   (HOSTAPD_DFS_MAX_PRECAC - 1) *
+			   sizeof(iface->radar_background.precac[0]));
+		iface->radar_background.num_precac--;
+	}
+
+	entry = &iface->radar_background.precac[
+		iface->radar_background.num_precac++];
+	entry->channel = iface->radar_background.channel;
+	entry->freq = iface->radar_background.freq;
+	entry->secondary_channel = iface->radar_background.secondary_channel;
+	entry->centr_freq_seg0_idx =
+		iface->radar_background.centr_freq_seg0_idx;
+	entry->centr_freq_seg1_idx =
+		iface->radar_background.centr_freq_seg1_idx;
+	entry->n_chans = dfs_get_used_n_chans(iface, &n_chans1);
+	os_get_reltime(&entry->expires);
+	entry->expires.sec += iface->conf->background_radar_precac_lifetime;
+
+	wpa_printf(MSG_DEBUG,
+		   "DFS: Channel %d (%d MHz) pre-cleared (%u/%d)",
+		   entry->channel, entry->freq,
+		   iface->radar_background.num_precac,
+		   iface->conf->background_radar_precac);
+}
+
+
+/* Sum of the ACS interference factors of the channel range starting from chan
+ * or -1 if not known for all the channels */
+static long double dfs_precac_interference(struct hostapd_iface *iface,
+					   struct hostapd_channel_data *chan,
+					   int n_chans)
+{
+#ifdef CONFIG_ACS
+	struct hostapd_channel_data *c;
+	long double factor = 0;
+	int i;
+
+	for (i = 0; i < n_chans; i++) {
+		c = dfs_get_chan_data(iface->current_mode, chan->freq + i * 20,
+				      0);
+		if (!c || !c->interference_model_valid)
+			return -1;
+		factor += c->interference_factor;
+	}
+
+	return factor;
+#else /* CONFIG_ACS */
+	return -1;
+#endif /* CONFIG_ACS */
+}
+
+
+/*
+ * Select the next channel for CAC on the background chain. The channel with the
+ * least interference according to the ACS interference model is preferred and a
+ * random channel is used if the model does not cover the candidates.
+ */
+static struct hostapd_channel_data *
+dfs_get_precac_channel(struct hostapd_iface *iface, int *secondary_channel,
+		       u8 *oper_centr_freq_seg0_idx,
+		       u8 *oper_centr_freq_seg1_idx)
+{
+	struct hostapd_channel_data *chan, *best = NULL;
+	long double factor, best_factor = 0;
+	int i, num, n_chans, n_chans1;
+
+	if (!iface->current_mode ||
+	    iface->current_mode->mode != HOSTAPD_MODE_IEEE80211A)
+		return NULL;
+
+	n_chans = dfs_get_used_n_chans(iface, &n_chans1);
+	num = dfs_find_channel(iface, NULL, 0, DFS_NO_CAC_YET);
+	for (i = 0; i < num; i++) {
+		chan = NULL;
+		dfs_find_channel(iface, &chan, i, DFS_NO_CAC_YET);
+		if (!chan)
+			continue;
+		factor = dfs_precac_interference(iface, chan, n_chans);
+		if (factor < 0) {
+			best = NULL;
+			break;
+		}
+		if (!best || factor < best_factor) {
+			best = chan;
+			best_factor = factor;
+		}
+	}
+
+	if (!best)
+		return dfs_get_valid_channel(iface, secondary_channel,
+					     oper_centr_freq_seg0_idx,
+					     oper_centr_freq_seg1_idx,
+					     DFS_NO_CAC_YET);
+
+	wpa_printf(MSG_DEBUG,
+		   "DFS: Pre-CAC candidate %d (%d MHz) with interference %Lg",
+		   best->chan, best->freq, best_factor);
+	*secondary_channel = iface->conf->secondary_channel ? 1 : 0;
+	*oper_centr_freq_seg0_idx = 0;
+	*oper_centr_freq_seg1_idx = 0;
+	dfs_adjust_center_freq(iface, best, *secondary_channel, -1,
+			       oper_centr_freq_seg0_idx,
+			       oper_centr_freq_seg1_idx);
+
+	return best;
+}
+
+
 static int dfs_set_valid_channel(struct hostapd_iface *iface, int skip_radar)
 {
 	struct hostapd_channel_data *channel;
@@ -1076,9 +1261,15 @@ static void hostapd_dfs_update_background_chain(struct hostapd_iface *iface)
 	if (iface->dfs_domain == HOSTAPD_DFS_REGION_ETSI)
 		channel_type = DFS_ANY_CHANNEL;
 
-	channel = dfs_get_valid_channel(iface, &sec, &oper_centr_freq_seg0_idx,
-					&oper_centr_freq_seg1_idx,
-					channel_type);
+	if (dfs_precac_enabled(iface))
+		channel = dfs_get_precac_channel(iface, &sec,
+						 &oper_centr_freq_seg0_idx,
+						 &oper_centr_freq_seg1_idx);
+	else
+		channel = dfs_get_valid_channel(iface, &sec,
+						&oper_centr_freq_seg0_idx,
+						&oper_centr_freq_seg1_idx,
+						channel_type);
 	if (!channel ||
 	    channel->chan == iface->conf->channel ||
 	    channel->chan == iface->radar_background.channel)
@@ -1113,6 +1304,21 @@ static void hostapd_dfs_update_background_chain(struct hostapd_iface *iface)
 }
 
 
+/* Move the background chain to the next candidate if more channels are to be
+ * pre-cleared */
+static void hostapd_dfs_precac_schedule(struct hostapd_iface *iface)
+{
+	if (!dfs_precac_enabled(iface) ||
+	    iface->radar_background.cac_started ||
+	    dfs_precac_purge(iface, 0) >=
+	    (unsigned int) iface->conf->background_radar_precac ||
+	    !dfs_find_channel(iface, NULL, 0, DFS_NO_CAC_YET))
+		return;
+
+	hostapd_dfs_update_background_chain(iface);
+}
+
+
 static bool
 hostapd_dfs_is_background_event(struct hostapd_iface *iface, int freq)
 {
@@ -1136,6 +1342,7 @@ hostapd_dfs_start_channel_switch_background(struct hostapd_iface *iface)
 	hostapd_set_oper_centr_freq_seg1_idx(
 		iface->conf, iface->radar_background.centr_freq_seg1_idx);
 
+	dfs_precac_purge(iface, iface->freq);
 	hostapd_dfs_update_background_chain(iface);
 
 	return hostapd_dfs_request_channel_switch(
@@ -1184,8 +1391,14 @@ int hostapd_dfs_complete_cac(struct hostapd_iface *iface, int success, int freq,
 			 */
 			if (hostapd_dfs_is_background_event(iface, freq)) {
 				iface->radar_background.cac_started = 0;
-				if (!iface->radar_background.temp_ch)
+				if (!iface->radar_background.temp_ch) {
+					if (dfs_precac_enabled(iface)) {
+						dfs_precac_add(iface);
+						hostapd_dfs_precac_schedule(
+							iface);
+					}
 					return 0;
+				}
 
 				iface->radar_background.temp_ch = 0;
 				return hostapd_dfs_start_channel_switch_background(iface);
@@ -1231,6 +1444,7 @@ int hostapd_dfs_pre_cac_expired(struct hostapd_iface *iface, int freq,
 
 	set_dfs_state(iface, freq, ht_enabled, chan_offset, chan_width,
 		      cf1, cf2, HOSTAPD_CHAN_DFS_USABLE);
+	hostapd_dfs_precac_schedule(iface);
 
 	return 0;
 }
@@ -1356,6 +1570,26 @@ hostapd_dfs_background_start_channel_switch(struct hostapd_iface *iface,
 	if (iface->radar_background.channel == -1)
 		return -1; /* Background radar chain not available. */
 
+	if (iface->radar_background.cac_started &&
+	    dfs_precac_enabled(iface) && dfs_precac_purge(iface, 0)) {
+		struct hostapd_dfs_precac entry;
+
+		/*
+		 * Background chain is busy with the next candidate. Switch to
+		 * a channel it has already cleared.
+		 */
+		entry = iface->radar_background.precac[0];
+		dfs_precac_purge(iface, entry.freq);
+		wpa_printf(MSG_DEBUG,
+			   "DFS: Switch to pre-cleared channel %d (%d MHz)",
+			   entry.channel, entry.freq);
+		return hostapd_dfs_request_channel_switch(
+			iface, entry.channel, entry.freq,
+			entry.secondary_channel,
+			hostapd_get_oper_chwidth(iface->conf),
+			entry.centr_freq_seg0_idx, entry.centr_freq_seg1_idx);
+	}
+
 	if (iface->radar_background.cac_started) {
 		/*
 		 * Background channel not available yet. Perform CAC on the
@@ -29,12 +29,56 @@ static const char * ipaddr_str(u32 addr)
 }
 
 
+static unsigned int ipaddr_hash(be32 addr)
+{
+	/* Fibonacci hashing of the address */
+	return (be_to_host32(addr) * 0x9e3779b1U) >> 24 & (STA_HASH_SIZE - 1);
+}
+
+
+static struct sta_info * ipaddr_get_sta(struct hostapd_data *hapd, be32 addr)
+{
+	struct sta_info *sta;
+
+	sta = hapd->ipaddr_hash[ipaddr_hash(addr)];
+	while (sta && sta->ipaddr != addr)
+		sta = sta->ipaddr_hnext;
+	return sta;
+}
+
+
+static void ipaddr_hash_del(struct hostapd_data *hapd, struct sta_info *sta)
+{
+	struct sta_info **s;
+
+	for (s = &hapd->ipaddr_hash[ipaddr_hash(sta->ipaddr)]; *s;
+	     s = &(*s)->ipaddr_hnext) {
+		if (*s == sta) {
+			*s = sta->ipaddr_hnext;
+			break;
+		}
+	}
+	sta->ipaddr_hnext = NULL;
+	sta->ipaddr = 0;
+}
+
+
+void sta_ipaddr_del(struct hostapd_data *hapd, struct sta_info *sta)
+{
+	if (!sta->ipaddr)
+		return;
+	hostapd_drv_br_delete_ip_neigh(hapd, 4, (u8 *) &sta->ipaddr);
+	ipaddr_hash_del(hapd, sta);
+}
+
+
 static void handle_dhcp(void *ctx, const u8 *src_addr, const u8 *buf,
 			size_t len)
 {
 	struct hostapd_data *hapd = ctx;
 	const struct bootp_pkt *b;
-	struct sta_info *sta;
+	struct sta_info *sta, *old;
+	unsigned int idx;
 	int exten_len;
 	const u8 *end, *pos;
 	int res, msgtype = 0, prefixlen = 32;
@@ -89,14 +133,8 @@ static void handle_dhcp(void *ctx, const u8 *src_addr, const u8 *buf,
 	}
 
 #ifdef CONFIG_HS20
-	if (hapd->conf->disable_dgaf && is_broadcast_ether_addr(buf)) {
-		for (sta = hapd->sta_list; sta; sta = sta->next) {
-			if (!(sta->flags & WLAN_STA_AUTHORIZED))
-				continue;
-			x_snoop_mcast_to_ucast_convert_send(hapd, sta,
-							    (u8 *) buf, len);
-		}
-	}
+	if (hapd->conf->disable_dgaf && is_broadcast_ether_addr(buf))
+		x_snoop_mcast_to_ucast_fan_out(hapd, buf, len);
 #endif /* CONFIG_HS20 */
 
 	if (msgtype == DHCPACK) {
@@ -121,8 +159,18 @@ static void handle_dhcp(void *ctx, const u8 *src_addr, const u8 *buf,
 			wpa_printf(MSG_DEBUG,
 				   "dhcp_snoop: Removing IPv4 address %s from the ip neigh table",
 				   ipaddr_str(be_to_host32(sta->ipaddr)));
-			hostapd_drv_br_delete_ip_neigh(hapd, 4,
-						       (u8 *) &sta->ipaddr);
+			sta_ipaddr_del(hapd, sta);
+		}
+
+		/* The address was reassigned from another STA; do not remove
+		 * the new ip neigh entry when that STA leaves. */
+		old = ipaddr_get_sta(hapd, b->your_ip);
+		if (old) {
+			wpa_printf(MSG_DEBUG,
+				   "dhcp_snoop: IPv4 address %s moved from "
+				   MACSTR, ipaddr_str(be_to_host32(b->your_ip)),
+				   MAC2STR(old->addr));
+			ipaddr_hash_del(hapd, old);
 		}
 
 		res = hostapd_drv_br_add_ip_neigh(hapd, 4, (u8 *) &b->your_ip,
@@ -134,6 +182,9 @@ static void handle_dhcp(void *ctx, const u8 *src_addr, const u8 *buf,
 			return;
 		}
 		sta->ipaddr = b->your_ip;
+		idx = ipaddr_hash(sta->ipaddr);
+		sta->ipaddr_hnext = hapd->ipaddr_hash[idx];
+		hapd->ipaddr_hash[idx] = sta;
 	}
 }
 
@@ -13,6 +13,7 @@
 
 int dhcp_snoop_init(struct hostapd_data *hapd);
 void dhcp_snoop_deinit(struct hostapd_data *hapd);
+void sta_ipaddr_del(struct hostapd_data *hapd, struct sta_info *sta);
 
 #else /* CONFIG_PROXYARP */
 
@@ -25,6 +26,11 @@ static inline void dhcp_snoop_deinit(struct hostapd_data *hapd)
 {
 }
 
+static inline void sta_ipaddr_del(struct hostapd_data *hapd,
+				  struct sta_info *sta)
+{
+}
+
 #endif /* CONFIG_PROXYARP */
 
 #endif /* DHCP_SNOOP_H */
@@ -3575,6 +3575,10 @@ int hostapd_dpp_controller_start(struct hostapd_data *hapd, const char *cmd)
 		}
 
 		config.qr_mutual = os_strstr(cmd, " qr=mutual") != NULL;
+
+		pos = os_strstr(cmd, " max_conn=");
+		if (pos)
+			config.max_conn = atoi(pos + 10);
 	}
 	config.configurator_params = hapd->dpp_configurator_params;
 	return dpp_controller_start(hapd->iface->interfaces->dpp, &config);
@@ -44,6 +44,7 @@
 #include "fils_hlp.h"
 #include "neighbor_db.h"
 #include "nan_usd_ap.h"
+#include "ap_status_shm.h"
 
 
 #ifdef CONFIG_FILS
@@ -145,7 +146,7 @@ static int hostapd_update_sta_links_status(struct hostapd_data *hapd,
 					   const u8 *resp_ies,
 					   size_t resp_ies_len)
 {
-	struct mld_info *info = &sta->mld_info;
+	struct mld_info *info = sta->mld_info;
 	struct wpabuf *mlebuf;
 	const u8 *mle, *pos;
 	struct ieee802_11_elems elems;
@@ -408,11 +409,15 @@ int hostapd_notif_assoc(struct hostapd_data *hapd, const u8 *addr,
 
 #ifdef CONFIG_IEEE80211BE
 	if (link_addr) {
-		struct mld_info *info = &sta->mld_info;
+		struct mld_info *info;
 		int i, num_valid_links = 0;
 		u8 link_id = hapd->mld_link_id;
 
-		ap_sta_set_mld(sta, true);
+		if (ap_sta_set_mld(sta, true) < 0) {
+			reason = WLAN_REASON_UNSPECIFIED;
+			goto fail;
+		}
+		info = sta->mld_info;
 		sta->mld_assoc_link_id = link_id;
 		os_memcpy(info->common_info.mld_addr, addr, ETH_ALEN);
 		info->links[link_id].valid = true;
@@ -570,7 +575,7 @@ int hostapd_notif_assoc(struct hostapd_data *hapd, const u8 *addr,
 				   "MLD: Set ML info in RSN Authenticator");
 			wpa_auth_set_ml_info(sta->wpa_sm,
 					     sta->mld_assoc_link_id,
-					     &sta->mld_info);
+					     sta->mld_info);
 		}
 #endif /* CONFIG_IEEE80211BE */
 		res = wpa_validate_wpa_ie(hapd->wpa_auth, sta->wpa_sm,
@@ -987,7 +992,7 @@ static void hostapd_notif_disassoc_mld(struct hostapd_data *assoc_hapd,
 
 	/* Remove STA entry in non-assoc links */
 	for (link_id = 0; link_id < MAX_NUM_MLD_LINKS; link_id++) {
-		if (!sta->mld_info.links[link_id].valid)
+		if (!sta->mld_info->links[link_id].valid)
 			continue;
 
 		for (i = 0; i < interfaces->count; i++) {
@@ -1053,14 +1058,15 @@ void hostapd_notif_disassoc(struct hostapd_data *hapd, const u8 *addr)
 
 				sta = ap_get_sta(h_hapd, addr);
 				if (sta) {
-					if (!sta->mld_info.mld_sta) {
+					if (!sta->mld_info ||
+					    !sta->mld_info->mld_sta) {
 						hapd = h_hapd;
 						goto legacy;
 					}
 					break;
 				}
 			}
-		} else if (!sta->mld_info.mld_sta) {
+		} else if (!sta->mld_info || !sta->mld_info->mld_sta) {
 			goto legacy;
 		}
 		if (!sta) {
@@ -1882,13 +1888,18 @@ static struct hostapd_data * get_hapd_bssid(struct hostapd_iface *iface,
 		if (!hapd->conf->mld_ap)
 			continue;
 
+		if (link_id >= 0 && link_id < MAX_NUM_MLD_LINKS &&
+		    ether_addr_equal(bssid, hapd->mld->mld_addr)) {
+			p_hapd = hapd->mld->link_bss[link_id];
+			if (p_hapd)
+				return p_hapd;
+		}
+
 		for_each_mld_link(p_hapd, hapd) {
 			if (p_hapd == hapd)
 				continue;
 
-			if (ether_addr_equal(bssid, p_hapd->own_addr) ||
-			    (ether_addr_equal(bssid, p_hapd->mld->mld_addr) &&
-			     link_id == p_hapd->mld_link_id))
+			if (ether_addr_equal(bssid, p_hapd->own_addr))
 				return p_hapd;
 		}
 #endif /* CONFIG_IEEE80211BE */
@@ -2166,6 +2177,7 @@ static void hostapd_single_channel_get_survey(struct hostapd_iface *iface,
 		iface->channel_utilization = dividend * 255 / divisor;
 		wpa_printf(MSG_DEBUG, "Channel Utilization: %d",
 			   iface->channel_utilization);
+		hostapd_status_shm_update_iface(iface);
 	}
 	iface->last_channel_time = survey->channel_time;
 	iface->last_channel_time_busy = survey->channel_time_busy;
@@ -2365,10 +2377,14 @@ static int hostapd_notif_update_dh_ie(struct hostapd_data *hapd,
 
 #ifdef CONFIG_IEEE80211BE
 	if (link_addr) {
-		struct mld_info *info = &sta->mld_info;
+		struct mld_info *info;
 		u8 link_id = hapd->mld_link_id;
 
-		ap_sta_set_mld(sta, true);
+		if (ap_sta_set_mld(sta, true) < 0) {
+			status = WLAN_STATUS_UNSPECIFIED_FAILURE;
+			goto err;
+		}
+		info = sta->mld_info;
 		sta->mld_assoc_link_id = link_id;
 		os_memcpy(info->common_info.mld_addr, peer, ETH_ALEN);
 		info->links[link_id].valid = true;
@@ -131,15 +131,106 @@ static int get_wildcard_cb(void *ctx, int argc, char *argv[], char *col[])
 }
 
 
+/* Maximum number of result columns passed to the row callbacks */
+#define EAP_USER_SQLITE_MAX_COLUMNS 32
+
+/* Run a prepared statement with a sqlite3_exec() style row callback */
+static int eap_user_sqlite_exec(sqlite3_stmt *stmt,
+				int (*cb)(void *ctx, int argc, char *argv[],
+					  char *col[]),
+				void *ctx)
+{
+	char *argv[EAP_USER_SQLITE_MAX_COLUMNS];
+	char *col[EAP_USER_SQLITE_MAX_COLUMNS];
+	int argc, i, res;
+
+	argc = sqlite3_column_count(stmt);
+	if (argc > EAP_USER_SQLITE_MAX_COLUMNS)
+		argc = EAP_USER_SQLITE_MAX_COLUMNS;
+	for (i = 0; i < argc; i++)
+		col[i] = (char *) sqlite3_column_name(stmt, i);
+
+	while ((res = sqlite3_step(stmt)) == SQLITE_ROW) {
+		for (i = 0; i < argc; i++)
+			argv[i] = (char *) sqlite3_column_text(stmt, i);
+		if (cb(ctx, argc, argv, col))
+			break;
+	}
+
+	sqlite3_reset(stmt);
+	sqlite3_clear_bindings(stmt);
+	return res == SQLITE_DONE || res == SQLITE_ROW ? 0 : -1;
+}
+
+
+/**
+ * hostapd_eap_user_sqlite_deinit - Close the EAP user database
+ * @hapd: Pointer to BSS data
+ */
+void hostapd_eap_user_sqlite_deinit(struct hostapd_data *hapd)
+{
+	sqlite3_finalize(hapd->eap_user_stmt);
+	hapd->eap_user_stmt = NULL;
+	sqlite3_finalize(hapd->eap_wildcard_stmt);
+	hapd->eap_wildcard_stmt = NULL;
+	if (hapd->eap_user_db) {
+		sqlite3_close(hapd->eap_user_db);
+		hapd->eap_user_db = NULL;
+	}
+	os_free(hapd->eap_user_db_path);
+	hapd->eap_user_db_path = NULL;
+}
+
+
+/* The database is kept open with the lookup statements prepared, since the
+ * users are looked up for every EAP authentication. */
+static int eap_user_sqlite_open(struct hostapd_data *hapd)
+{
+	const char *path = hapd->conf->eap_user_sqlite;
+
+	if (hapd->eap_user_db && hapd->eap_user_db_path &&
+	    os_strcmp(hapd->eap_user_db_path, path) == 0)
+		return 0;
+
+	hostapd_eap_user_sqlite_deinit(hapd);
+	if (sqlite3_open(path, &hapd->eap_user_db)) {
+		wpa_printf(MSG_INFO, "DB: Failed to open database %s: %s",
+			   path, sqlite3_errmsg(hapd->eap_user_db));
+		goto fail;
+	}
+
+	if (sqlite3_prepare_v2(hapd->eap_user_db,
+			       "SELECT * FROM users WHERE identity=? AND phase2=?;",
+			       -1, &hapd->eap_user_stmt, NULL) != SQLITE_OK ||
+	    sqlite3_prepare_v2(hapd->eap_user_db,
+			       "SELECT identity,methods FROM wildcards;",
+			       -1, &hapd->eap_wildcard_stmt, NULL) !=
+	    SQLITE_OK) {
+		wpa_printf(MSG_DEBUG,
+			   "DB: Failed to prepare SQL statement: %s  db: %s",
+			   sqlite3_errmsg(hapd->eap_user_db), path);
+		goto fail;
+	}
+
+	hapd->eap_user_db_path = os_strdup(path);
+	if (!hapd->eap_user_db_path)
+		goto fail;
+
+	return 0;
+
+fail:
+	hostapd_eap_user_sqlite_deinit(hapd);
+	return -1;
+}
+
+
 static const struct hostapd_eap_user *
 eap_user_sqlite_get(struct hostapd_data *hapd, const u8 *identity,
 		    size_t identity_len, int phase2)
 {
-	sqlite3 *db;
 	struct hostapd_eap_user *user = NULL;
-	char id_str[256], cmd[300];
+	char id_str[256];
 	size_t i;
-	int res;
 
 	if (identity_len >= sizeof(id_str)) {
 		wpa_printf(MSG_DEBUG, "%s: identity len too big: %d >= %d",
@@ -177,37 +268,34 @@ eap_user_sqlite_get(struct hostapd_data *hapd, const u8 *identity,
 	os_memcpy(hapd->tmp_eap_user.identity, identity, identity_len);
 	hapd->tmp_eap_user.identity_len = identity_len;
 
-	if (sqlite3_open(hapd->conf->eap_user_sqlite, &db)) {
-		wpa_printf(MSG_INFO, "DB: Failed to open database %s: %s",
-			   hapd->conf->eap_user_sqlite, sqlite3_errmsg(db));
-		sqlite3_close(db);
+	if (eap_user_sqlite_open(hapd) < 0)
 		return NULL;
-	}
-
-	res = os_snprintf(cmd, sizeof(cmd),
-			  "SELECT * FROM users WHERE identity='%s' AND phase2=%d;",
-			  id_str, phase2);
-	if (os_snprintf_error(sizeof(cmd), res))
-		goto fail;
 
-	wpa_printf(MSG_DEBUG, "DB: %s", cmd);
-	if (sqlite3_exec(db, cmd, get_user_cb, &hapd->tmp_eap_user, NULL) !=
-	    SQLITE_OK) {
+	wpa_printf(MSG_DEBUG,
+		   "DB: SELECT * FROM users WHERE identity='%s' AND phase2=%d;",
+		   id_str, phase2);
+	if (sqlite3_bind_text(hapd->eap_user_stmt, 1, id_str, identity_len,
+			      SQLITE_STATIC) != SQLITE_OK ||
+	    sqlite3_bind_int(hapd->eap_user_stmt, 2, phase2) != SQLITE_OK ||
+	    eap_user_sqlite_exec(hapd->eap_user_stmt, get_user_cb,
+				 &hapd->tmp_eap_user) < 0) {
 		wpa_printf(MSG_DEBUG,
 			   "DB: Failed to complete SQL operation: %s  db: %s",
-			   sqlite3_errmsg(db), hapd->conf->eap_user_sqlite);
+			   sqlite3_errmsg(hapd->eap_user_db),
+			   hapd->conf->eap_user_sqlite);
+		sqlite3_reset(hapd->eap_user_stmt);
+		sqlite3_clear_bindings(hapd->eap_user_stmt);
 	} else if (hapd->tmp_eap_user.next)
 		user = &hapd->tmp_eap_user;
 
 	if (user == NULL && !phase2) {
-		os_snprintf(cmd, sizeof(cmd),
-			    "SELECT identity,methods FROM wildcards;");
-		wpa_printf(MSG_DEBUG, "DB: %s", cmd);
-		if (sqlite3_exec(db, cmd, get_wildcard_cb, &hapd->tmp_eap_user,
-				 NULL) != SQLITE_OK) {
+		wpa_printf(MSG_DEBUG, "DB: SELECT identity,methods FROM wildcards;");
+		if (eap_user_sqlite_exec(hapd->eap_wildcard_stmt,
+					 get_wildcard_cb,
+					 &hapd->tmp_eap_user) < 0) {
 			wpa_printf(MSG_DEBUG,
 				   "DB: Failed to complete SQL operation: %s  db: %s",
-				   sqlite3_errmsg(db),
+				   sqlite3_errmsg(hapd->eap_user_db),
 				   hapd->conf->eap_user_sqlite);
 		} else if (hapd->tmp_eap_user.next) {
 			user = &hapd->tmp_eap_user;
@@ -219,9 +307,6 @@ eap_user_sqlite_get(struct hostapd_data *hapd, const u8 *identity,
 		}
 	}
 
-fail:
-	sqlite3_close(db);
-
 	return user;
 }
 
@@ -233,7 +318,7 @@ hostapd_get_eap_user(struct hostapd_data *hapd, const u8 *identity,
 		     size_t identity_len, int phase2)
 {
 	const struct hostapd_bss_config *conf = hapd->conf;
-	struct hostapd_eap_user *user = conf->eap_user;
+	struct hostapd_eap_user *user;
 
 #ifdef CONFIG_WPS
 	if (conf->wps_state && identity_len == WSC_ID_ENROLLEE_LEN &&
@@ -258,26 +343,7 @@ hostapd_get_eap_user(struct hostapd_data *hapd, const u8 *identity,
 	}
 #endif /* CONFIG_WPS */
 
-	while (user) {
-		if (!phase2 && user->identity == NULL) {
-			/* Wildcard match */
-			break;
-		}
-
-		if (user->phase2 == !!phase2 && user->wildcard_prefix &&
-		    identity_len >= user->identity_len &&
-		    os_memcmp(user->identity, identity, user->identity_len) ==
-		    0) {
-			/* Wildcard prefix match */
-			break;
-		}
-
-		if (user->phase2 == !!phase2 &&
-		    user->identity_len == identity_len &&
-		    os_memcmp(user->identity, identity, identity_len) == 0)
-			break;
-		user = user->next;
-	}
+	user = hostapd_config_get_eap_user(conf, identity, identity_len, phase2);
 
 #ifdef CONFIG_SQLITE
 	if (user == NULL && conf->eap_user_sqlite) {
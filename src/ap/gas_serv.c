@@ -574,6 +574,13 @@ static void anqp_add_nai_realm(struct hostapd_data *hapd, struct wpabuf *buf,
 }
 
 
+static void anqp_add_nai_realm_list(struct hostapd_data *hapd,
+				    struct wpabuf *buf)
+{
+	anqp_add_nai_realm(hapd, buf, NULL, 0, 1, 0);
+}
+
+
 static void anqp_add_3gpp_cellular_network(struct hostapd_data *hapd,
 					   struct wpabuf *buf)
 {
@@ -951,6 +958,142 @@ static void anqp_add_mbo_cell_data_conn_pref(struct hostapd_data *hapd,
 #endif /* CONFIG_MBO */
 
 
+#define ANQP_MAX_EXTRA_REQ 20
+#define ANQP_CACHE_RESP_SIZE 4
+
+/*
+ * ANQP-elements and full responses are built from the BSS configuration, so
+ * the same bytes are generated again for each station that queries them. The
+ * cache stores the elements that do not depend on the query (keyed by the
+ * ANQP_REQ_* bit) and the last few full responses (keyed by the query). The
+ * cache is flushed when the configuration changes.
+ */
+struct anqp_cache_elem {
+	struct dl_list list;
+	unsigned int req; /* ANQP_REQ_* */
+	struct wpabuf *data;
+};
+
+struct anqp_cache_resp {
+	unsigned int request;
+	u16 extra_req[ANQP_MAX_EXTRA_REQ];
+	unsigned int num_extra_req;
+	struct wpabuf *payload;
+};
+
+struct anqp_cache {
+	struct dl_list elems; /* struct anqp_cache_elem */
+	struct anqp_cache_resp resp[ANQP_CACHE_RESP_SIZE];
+	unsigned int next_resp;
+};
+
+
+/**
+ * gas_serv_anqp_cache_flush - Flush cached ANQP responses
+ * @hapd: Pointer to BSS data
+ *
+ * This needs to be called when the configuration of the BSS is modified or
+ * replaced.
+ */
+void gas_serv_anqp_cache_flush(struct hostapd_data *hapd)
+{
+	struct anqp_cache *cache = hapd->anqp_cache;
+	struct anqp_cache_elem *elem, *prev;
+	unsigned int i;
+
+	if (!cache)
+		return;
+
+	dl_list_for_each_safe(elem, prev, &cache->elems, struct anqp_cache_elem,
+			      list) {
+		dl_list_del(&elem->list);
+		wpabuf_free(elem->data);
+		os_free(elem);
+	}
+	for (i = 0; i < ANQP_CACHE_RESP_SIZE; i++) {
+		wpabuf_free(cache->resp[i].payload);
+		cache->resp[i].payload = NULL;
+	}
+	cache->next_resp = 0;
+}
+
+
+static struct anqp_cache * anqp_cache_get(struct hostapd_data *hapd)
+{
+	struct anqp_cache *cache = hapd->anqp_cache;
+
+	if (!cache) {
+		cache = os_zalloc(sizeof(*cache));
+		if (!cache)
+			return NULL;
+		dl_list_init(&cache->elems);
+		hapd->anqp_cache = cache;
+	}
+
+	return cache;
+}
+
+
+static void anqp_add_cached(struct hostapd_data *hapd, struct wpabuf *buf,
+			    unsigned int req,
+			    void (*add)(struct hostapd_data *hapd,
+					struct wpabuf *buf))
+{
+	struct anqp_cache *cache = anqp_cache_get(hapd);
+	struct anqp_cache_elem *elem;
+	size_t start = wpabuf_len(buf);
+
+	if (!cache) {
+		add(hapd, buf);
+		return;
+	}
+
+	dl_list_for_each(elem, &cache->elems, struct anqp_cache_elem, list) {
+		if (elem->req == req) {
+			if (wpabuf_tailroom(buf) >= wpabuf_len(elem->data))
+				wpabuf_put_buf(buf, elem->data);
+			return;
+		}
+	}
+
+	add(hapd, buf);
+
+	elem = os_zalloc(sizeof(*elem));
+	if (!elem)
+		return;
+	elem->req = req;
+	elem->data = wpabuf_alloc_copy(wpabuf_head_u8(buf) + start,
+				       wpabuf_len(buf) - start);
+	if (!elem->data) {
+		os_free(elem);
+		return;
+	}
+	dl_list_add(&cache->elems, &elem->list);
+}
+
+
+static struct anqp_cache_resp *
+anqp_cache_find_resp(struct anqp_cache *cache, unsigned int request,
+		     const u16 *extra_req, unsigned int num_extra_req)
+{
+	struct anqp_cache_resp *resp;
+	unsigned int i;
+
+	for (i = 0; i < ANQP_CACHE_RESP_SIZE; i++) {
+		resp = &cache->resp[i];
+		if (resp->payload && resp->request == request &&
+		    resp->num_extra_req == num_extra_req &&
+		    (!num_extra_req ||
+		     os_memcmp(resp->extra_req, extra_req,
+			       num_extra_req * sizeof(u16)) == 0))
+			return resp;
+	}
+
+	return NULL;
+}
+
+
+
 static size_t anqp_get_required_len(struct hostapd_data *hapd,
 				    const u16 *infoid,
 				    unsigned int num_infoid)
@@ -978,9 +1121,24 @@ gas_serv_build_gas_resp_payload(struct hostapd_data *hapd,
 				unsigned int num_extra_req)
 {
 	struct wpabuf *buf;
+	struct anqp_cache *cache = NULL;
+	struct anqp_cache_resp *resp;
 	size_t len;
 	unsigned int i;
 
+	/* Responses to home realm and icon queries depend on the query */
+	if (!(request & (ANQP_REQ_NAI_HOME_REALM | ANQP_REQ_ICON_REQUEST)) &&
+	    num_extra_req <= ANQP_MAX_EXTRA_REQ)
+		cache = anqp_cache_get(hapd);
+	if (cache) {
+		resp = anqp_cache_find_resp(cache, request, extra_req,
+					    num_extra_req);
+		if (resp) {
+			wpa_printf(MSG_DEBUG, "ANQP: Use cached response");
+			return wpabuf_dup(resp->payload);
+		}
+	}
+
 	len = 1400;
 	if (request & (ANQP_REQ_NAI_REALM | ANQP_REQ_NAI_HOME_REALM))
 		len += 1000;
@@ -997,23 +1155,32 @@ gas_serv_build_gas_resp_payload(struct hostapd_data *hapd,
 		return NULL;
 
 	if (request & ANQP_REQ_CAPABILITY_LIST)
-		anqp_add_capab_list(hapd, buf);
+		anqp_add_cached(hapd, buf, ANQP_REQ_CAPABILITY_LIST,
+				anqp_add_capab_list);
 	if (request & ANQP_REQ_VENUE_NAME)
-		anqp_add_venue_name(hapd, buf);
+		anqp_add_cached(hapd, buf, ANQP_REQ_VENUE_NAME,
+				anqp_add_venue_name);
 	if (request & ANQP_REQ_EMERGENCY_CALL_NUMBER)
 		anqp_add_elem(hapd, buf, ANQP_EMERGENCY_CALL_NUMBER);
 	if (request & ANQP_REQ_NETWORK_AUTH_TYPE)
-		anqp_add_network_auth_type(hapd, buf);
+		anqp_add_cached(hapd, buf, ANQP_REQ_NETWORK_AUTH_TYPE,
+				anqp_add_network_auth_type);
 	if (request & ANQP_REQ_ROAMING_CONSORTIUM)
-		anqp_add_roaming_consortium(hapd, buf);
+		anqp_add_cached(hapd, buf, ANQP_REQ_ROAMING_CONSORTIUM,
+				anqp_add_roaming_consortium);
 	if (request & ANQP_REQ_IP_ADDR_TYPE_AVAILABILITY)
-		anqp_add_ip_addr_type_availability(hapd, buf);
-	if (request & (ANQP_REQ_NAI_REALM | ANQP_REQ_NAI_HOME_REALM))
+		anqp_add_cached(hapd, buf, ANQP_REQ_IP_ADDR_TYPE_AVAILABILITY,
+				anqp_add_ip_addr_type_availability);
+	if (request & ANQP_REQ_NAI_HOME_REALM)
 		anqp_add_nai_realm(hapd, buf, home_realm, home_realm_len,
 				   request & ANQP_REQ_NAI_REALM,
 				   request & ANQP_REQ_NAI_HOME_REALM);
+	else if (request & ANQP_REQ_NAI_REALM)
+		anqp_add_cached(hapd, buf, ANQP_REQ_NAI_REALM,
+				anqp_add_nai_realm_list);
 	if (request & ANQP_REQ_3GPP_CELLULAR_NETWORK)
-		anqp_add_3gpp_cellular_network(hapd, buf);
+		anqp_add_cached(hapd, buf, ANQP_REQ_3GPP_CELLULAR_NETWORK,
+				anqp_add_3gpp_cellular_network);
 	if (request & ANQP_REQ_AP_GEOSPATIAL_LOCATION)
 		anqp_add_elem(hapd, buf, ANQP_AP_GEOSPATIAL_LOCATION);
 	if (request & ANQP_REQ_AP_CIVIC_LOCATION)
@@ -1021,7 +1188,8 @@ gas_serv_build_gas_resp_payload(struct hostapd_data *hapd,
 	if (request & ANQP_REQ_AP_LOCATION_PUBLIC_URI)
 		anqp_add_elem(hapd, buf, ANQP_AP_LOCATION_PUBLIC_URI);
 	if (request & ANQP_REQ_DOMAIN_NAME)
-		anqp_add_domain_name(hapd, buf);
+		anqp_add_cached(hapd, buf, ANQP_REQ_DOMAIN_NAME,
+				anqp_add_domain_name);
 	if (request & ANQP_REQ_EMERGENCY_ALERT_URI)
 		anqp_add_elem(hapd, buf, ANQP_EMERGENCY_ALERT_URI);
 	if (request & ANQP_REQ_TDLS_CAPABILITY)
@@ -1045,23 +1213,30 @@ gas_serv_build_gas_resp_payload(struct hostapd_data *hapd,
 
 #ifdef CONFIG_HS20
 	if (request & ANQP_REQ_HS_CAPABILITY_LIST)
-		anqp_add_hs_capab_list(hapd, buf);
+		anqp_add_cached(hapd, buf, ANQP_REQ_HS_CAPABILITY_LIST,
+				anqp_add_hs_capab_list);
 	if (request & ANQP_REQ_OPERATOR_FRIENDLY_NAME)
-		anqp_add_operator_friendly_name(hapd, buf);
+		anqp_add_cached(hapd, buf, ANQP_REQ_OPERATOR_FRIENDLY_NAME,
+				anqp_add_operator_friendly_name);
 	if (request & ANQP_REQ_WAN_METRICS)
 		anqp_add_wan_metrics(hapd, buf);
 	if (request & ANQP_REQ_CONNECTION_CAPABILITY)
-		anqp_add_connection_capability(hapd, buf);
+		anqp_add_cached(hapd, buf, ANQP_REQ_CONNECTION_CAPABILITY,
+				anqp_add_connection_capability);
 	if (request & ANQP_REQ_OPERATING_CLASS)
-		anqp_add_operating_class(hapd, buf);
+		anqp_add_cached(hapd, buf, ANQP_REQ_OPERATING_CLASS,
+				anqp_add_operating_class);
 	if (request & ANQP_REQ_OSU_PROVIDERS_LIST)
-		anqp_add_osu_providers_list(hapd, buf);
+		anqp_add_cached(hapd, buf, ANQP_REQ_OSU_PROVIDERS_LIST,
+				anqp_add_osu_providers_list);
 	if (request & ANQP_REQ_ICON_REQUEST)
 		anqp_add_icon_binary_file(hapd, buf, icon_name, icon_name_len);
 	if (request & ANQP_REQ_OPERATOR_ICON_METADATA)
-		anqp_add_operator_icon_metadata(hapd, buf);
+		anqp_add_cached(hapd, buf, ANQP_REQ_OPERATOR_ICON_METADATA,
+				anqp_add_operator_icon_metadata);
 	if (request & ANQP_REQ_OSU_PROVIDERS_NAI_LIST)
-		anqp_add_osu_providers_nai_list(hapd, buf);
+		anqp_add_cached(hapd, buf, ANQP_REQ_OSU_PROVIDERS_NAI_LIST,
+				anqp_add_osu_providers_nai_list);
 #endif /* CONFIG_HS20 */
 
 #ifdef CONFIG_MBO
@@ -1069,12 +1244,23 @@ gas_serv_build_gas_resp_payload(struct hostapd_data *hapd,
 		anqp_add_mbo_cell_data_conn_pref(hapd, buf);
 #endif /* CONFIG_MBO */
 
+	if (cache) {
+		resp = &cache->resp[cache->next_resp];
+		cache->next_resp = (cache->next_resp + 1) %
+			ANQP_CACHE_RESP_SIZE;
+		wpabuf_free(resp->payload);
+		resp->payload = wpabuf_dup(buf);
+		resp->request = request;
+		resp->num_extra_req = num_extra_req;
+		if (num_extra_req)
+			os_memcpy(resp->extra_req, extra_req,
+				  num_extra_req * sizeof(u16));
+	}
+
 	return buf;
 }
 
 
-#define ANQP_MAX_EXTRA_REQ 20
-
 struct anqp_query_info {
 	unsigned int request;
 	const u8 *home_realm_query;
@@ -1892,4 +2078,7 @@ int gas_serv_init(struct hostapd_data *hapd)
 
 void gas_serv_deinit(struct hostapd_data *hapd)
 {
+	gas_serv_anqp_cache_flush(hapd);
+	os_free(hapd->anqp_cache);
+	hapd->anqp_cache = NULL;
 }
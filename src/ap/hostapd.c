@@ -55,6 +55,8 @@
 #include "acs.h"
 #include "hs20.h"
 #include "airtime_policy.h"
+#include "steering.h"
+#include "ap_status_shm.h"
 #include "wpa_auth_kay.h"
 #include "hw_features.h"
 
@@ -221,6 +223,161 @@ static void hostapd_clear_old_bss(struct hostapd_data *bss)
 }
 
 
+static int hostapd_kick_mismatch_psk_sta_iter(struct hostapd_data *hapd,
+					      struct sta_info *sta, void *ctx)
+{
+	struct hostapd_wpa_psk *psk;
+	const u8 *pmk;
+	int pmk_len;
+	int pmk_match;
+	int sta_match;
+	int bss_match;
+	int reason;
+
+	pmk = wpa_auth_get_pmk(sta->wpa_sm, &pmk_len);
+
+	for (psk = hapd->conf->ssid.wpa_psk; pmk && psk; psk = psk->next) {
+		pmk_match = PMK_LEN == pmk_len &&
+			os_memcmp(psk->psk, pmk, pmk_len) == 0;
+		sta_match = psk->group == 0 &&
+			ether_addr_equal(sta->addr, psk->addr);
+		bss_match = psk->group == 1;
+
+		if (pmk_match && (sta_match || bss_match))
+			return 0;
+	}
+
+	wpa_printf(MSG_INFO, "STA " MACSTR
+		   " PSK/passphrase no longer valid - disconnect",
+		   MAC2STR(sta->addr));
+	reason = WLAN_REASON_PREV_AUTH_NOT_VALID;
+	hostapd_drv_sta_deauth(hapd, sta->addr, reason);
+	ap_sta_deauthenticate(hapd, sta, reason);
+
+	return 0;
+}
+
+
+/**
+ * hostapd_kick_mismatch_psk_stas - Disconnect stations with a removed PSK
+ * @hapd: Pointer to BSS data
+ *
+ * This is used after the PSKs of the BSS have been reloaded to disconnect the
+ * stations that are using a PSK or passphrase that is not valid anymore.
+ */
+void hostapd_kick_mismatch_psk_stas(struct hostapd_data *hapd)
+{
+	ap_for_each_sta(hapd, hostapd_kick_mismatch_psk_sta_iter, NULL);
+}
+
+
+static unsigned int
+hostapd_bss_conf_changes(const struct hostapd_bss_config *oldconf,
+			 const struct hostapd_bss_config *newconf)
+{
+	unsigned int changes = 0;
+	int i;
+
+	if (!oldconf->config_digest_set || !newconf->config_digest_set)
+		return BIT(HOSTAPD_CONFIG_CLASS_FULL);
+
+	for (i = 0; i < HOSTAPD_CONFIG_CLASSES; i++) {
+		if (os_memcmp(oldconf->config_digest[i],
+			      newconf->config_digest[i],
+			      HOSTAPD_CONFIG_DIGEST_LEN) != 0)
+			changes |= BIT(i);
+	}
+
+	return changes;
+}
+
+
+/*
+ * Take a new configuration of a BSS into use when only the PSKs or the
+ * Beacon frame contents changed (or nothing changed) without disconnecting
+ * the stations or replacing the group keys. The parameters that the new
+ * configuration shares with the old one do not need to be applied again.
+ */
+static void hostapd_reload_bss_changes(struct hostapd_data *hapd,
+				       struct hostapd_bss_config *oldconf,
+				       unsigned int changes)
+{
+	struct hostapd_ssid *ssid = &hapd->conf->ssid;
+	struct hostapd_ssid *old = &oldconf->ssid;
+
+	if (!hapd->started)
+		return;
+
+	if (hapd->conf->wmm_enabled < 0)
+		hapd->conf->wmm_enabled = hapd->iconf->ieee80211n |
+			hapd->iconf->ieee80211ax;
+
+#ifndef CONFIG_NO_RADIUS
+	radius_client_reconfig(hapd->radius, hapd->conf->radius);
+#endif /* CONFIG_NO_RADIUS */
+
+	/* Take over the PSK derived from the unchanged passphrase */
+	if (!(changes & BIT(HOSTAPD_CONFIG_CLASS_PSK)) && !ssid->wpa_psk &&
+	    ssid->wpa_passphrase && !old->wpa_psk_set && old->wpa_psk &&
+	    !old->wpa_psk->next) {
+		hostapd_wpa_psk_index_free(old);
+		ssid->wpa_psk = old->wpa_psk;
+		old->wpa_psk = NULL;
+	}
+	if (hostapd_setup_wpa_psk(hapd->conf)) {
+		wpa_printf(MSG_ERROR, "Failed to re-configure WPA PSK "
+			   "after reloading configuration");
+	}
+	if (changes & BIT(HOSTAPD_CONFIG_CLASS_PSK))
+		hostapd_kick_mismatch_psk_stas(hapd);
+
+	if (changes) {
+		hostapd_neighbor_sync_own_report(hapd);
+		ieee802_11_set_beacon(hapd);
+	}
+	hostapd_update_wps(hapd);
+
+	wpa_printf(MSG_DEBUG, "Applied configuration changes to %s",
+		   hapd->conf->iface);
+}
+
+
+static void hostapd_apply_report(char **pos, char *end, const char *ifname,
+				 const char *changes)
+{
+	int ret;
+
+	if (!*pos)
+		return;
+	ret = os_snprintf(*pos, end - *pos, "%s=%s\n", ifname, changes);
+	if (!os_snprintf_error(end - *pos, ret))
+		*pos += ret;
+}
+
+
+static void hostapd_apply_report_changes(char **pos, char *end,
+					 const char *ifname,
+					 unsigned int changes)
+{
+	char buf[30];
+
+	if (changes & BIT(HOSTAPD_CONFIG_CLASS_FULL))
+		os_strlcpy(buf, "full", sizeof(buf));
+	else if (!changes)
+		os_strlcpy(buf, "none", sizeof(buf));
+	else
+		os_snprintf(buf, sizeof(buf), "%s%s%s",
+			    changes & BIT(HOSTAPD_CONFIG_CLASS_PSK) ?
+			    "psk" : "",
+			    changes == (BIT(HOSTAPD_CONFIG_CLASS_PSK) |
+					BIT(HOSTAPD_CONFIG_CLASS_BEACON)) ?
+			    "," : "",
+			    changes & BIT(HOSTAPD_CONFIG_CLASS_BEACON) ?
+			    "beacon" : "");
+	hostapd_apply_report(pos, end, ifname, buf);
+}
+
+
 static void hostapd_clear_old(struct hostapd_iface *iface)
 {
 	size_t j;
@@ -248,18 +405,28 @@ static int hostapd_iface_conf_changed(struct hostapd_config *newconf,
 }
 
 
-int hostapd_reload_config(struct hostapd_iface *iface)
+/*
+ * Reload the configuration file of an interface. With apply, the changes of
+ * each BSS are compared to the current configuration and only the needed
+ * actions are taken. pos is used to report the changes and may be %NULL.
+ */
+static int hostapd_reload_config_changes(struct hostapd_iface *iface,
+					 bool apply, char **pos, char *end)
 {
 	struct hapd_interfaces *interfaces = iface->interfaces;
 	struct hostapd_data *hapd = iface->bss[0];
 	struct hostapd_config *newconf, *oldconf;
+	unsigned int changes;
 	size_t j;
 
 	if (iface->config_fname == NULL) {
 		/* Only in-memory config in use - assume it has been updated */
 		hostapd_clear_old(iface);
-		for (j = 0; j < iface->num_bss; j++)
+		for (j = 0; j < iface->num_bss; j++) {
 			hostapd_reload_bss(iface->bss[j]);
+			hostapd_apply_report(pos, end,
+					     iface->bss[j]->conf->iface, "full");
+		}
 		return 0;
 	}
 
@@ -279,6 +446,7 @@ int hostapd_reload_config(struct hostapd_iface *iface)
 
 		wpa_printf(MSG_DEBUG,
 			   "Configuration changes include interface/BSS modification - force full disable+enable sequence");
+		hostapd_apply_report(pos, end, hapd->conf->iface, "restart");
 		fname = os_strdup(iface->config_fname);
 		if (!fname) {
 			hostapd_config_free(newconf);
@@ -305,10 +473,17 @@ int hostapd_reload_config(struct hostapd_iface *iface)
 	iface->conf = newconf;
 
 	for (j = 0; j < iface->num_bss; j++) {
+		struct hostapd_bss_config *oldbss;
+
 		hapd = iface->bss[j];
-		if (!hapd->conf->config_id || !newconf->bss[j]->config_id ||
-		    os_strcmp(hapd->conf->config_id,
-			      newconf->bss[j]->config_id) != 0)
+		oldbss = hapd->conf;
+		changes = apply ?
+			hostapd_bss_conf_changes(oldbss, newconf->bss[j]) :
+			BIT(HOSTAPD_CONFIG_CLASS_FULL);
+		if ((changes & BIT(HOSTAPD_CONFIG_CLASS_FULL)) &&
+		    (!hapd->conf->config_id || !newconf->bss[j]->config_id ||
+		     os_strcmp(hapd->conf->config_id,
+			       newconf->bss[j]->config_id) != 0))
 			hostapd_clear_old_bss(hapd);
 		hapd->iconf = newconf;
 		hapd->iconf->channel = oldconf->channel;
@@ -327,7 +502,15 @@ int hostapd_reload_config(struct hostapd_iface *iface)
 			hapd->iconf,
 			hostapd_get_oper_centr_freq_seg1_idx(oldconf));
 		hapd->conf = newconf->bss[j];
-		hostapd_reload_bss(hapd);
+#ifdef CONFIG_INTERWORKING
+		gas_serv_anqp_cache_flush(hapd);
+#endif /* CONFIG_INTERWORKING */
+		hostapd_apply_report_changes(pos, end, hapd->conf->iface,
+					     changes);
+		if (changes & BIT(HOSTAPD_CONFIG_CLASS_FULL))
+			hostapd_reload_bss(hapd);
+		else
+			hostapd_reload_bss_changes(hapd, oldbss, changes);
 	}
 
 	hostapd_config_free(oldconf);
@@ -337,6 +520,39 @@ int hostapd_reload_config(struct hostapd_iface *iface)
 }
 
 
+int hostapd_reload_config(struct hostapd_iface *iface)
+{
+	char *pos = NULL;
+
+	return hostapd_reload_config_changes(iface, false, &pos, NULL);
+}
+
+
+/**
+ * hostapd_apply_config - Reload configuration applying only the changes
+ * @iface: Pointer to interface data
+ * @buf: Buffer for the list of changes
+ * @buflen: Length of the buffer
+ * Returns: Length of the list of changes or -1 on failure
+ *
+ * The configuration file lines of each BSS are compared to the ones that were
+ * used for the current configuration. A BSS without changes keeps its state,
+ * changes to the PSKs and SAE passwords disconnect only the stations using a
+ * removed PSK, and changes only to the Beacon frame contents update the
+ * Beacon frames. Other changes disconnect the stations of the BSS as with
+ * hostapd_reload_config(). The changes are reported as <ifname>=<changes>
+ * lines, e.g., "wlan0=psk,beacon" or "wlan0=none".
+ */
+int hostapd_apply_config(struct hostapd_iface *iface, char *buf, size_t buflen)
+{
+	char *pos = buf;
+
+	if (hostapd_reload_config_changes(iface, true, &pos, buf + buflen) < 0)
+		return -1;
+	return pos - buf;
+}
+
+
 #ifdef CONFIG_WEP
 
 static void hostapd_broadcast_key_clear_iface(struct hostapd_data *hapd,
@@ -458,6 +674,9 @@ void hostapd_free_hapd_data(struct hostapd_data *hapd)
 	os_free(hapd->probereq_cb);
 	hapd->probereq_cb = NULL;
 	hapd->num_probereq_cb = 0;
+	hostapd_flush_probe_resp_tmpl(hapd);
+	wpabuf_free(hapd->beacon_sig);
+	hapd->beacon_sig = NULL;
 
 #ifdef CONFIG_P2P
 	wpabuf_free(hapd->p2p_beacon_ie);
@@ -475,6 +694,7 @@ void hostapd_free_hapd_data(struct hostapd_data *hapd)
 	hapd->beacon_set_done = 0;
 
 	wpa_printf(MSG_DEBUG, "%s(%s)", __func__, hapd->conf->iface);
+	hostapd_status_shm_deinit(hapd);
 	accounting_deinit(hapd);
 	hostapd_deinit_wpa(hapd);
 	vlan_deinit(hapd);
@@ -566,6 +786,7 @@ void hostapd_free_hapd_data(struct hostapd_data *hapd)
 	bin_clear_free(hapd->tmp_eap_user.password,
 		       hapd->tmp_eap_user.password_len);
 	os_memset(&hapd->tmp_eap_user, 0, sizeof(hapd->tmp_eap_user));
+	hostapd_eap_user_sqlite_deinit(hapd);
 #endif /* CONFIG_SQLITE */
 
 #ifdef CONFIG_MESH
@@ -712,6 +933,7 @@ void hostapd_cleanup_iface_partial(struct hostapd_iface *iface)
 	ap_list_deinit(iface);
 	sta_track_deinit(iface);
 	airtime_policy_update_deinit(iface);
+	steering_update_deinit(iface);
 	hostapd_free_multi_hw_info(iface->multi_hw_info);
 	iface->multi_hw_info = NULL;
 	iface->current_hw_info = NULL;
@@ -1373,6 +1595,55 @@ static int hostapd_bss_radius_init(struct hostapd_data *hapd)
 #endif /* CONFIG_NO_RADIUS */
 
 
+/*
+ * Take the PSK that another BSS derived from the same SSID and passphrase,
+ * e.g., when the same network is provided on multiple radios, instead of
+ * running the 4096 iteration PBKDF2 derivation again for each BSS.
+ */
+static void hostapd_reuse_passphrase_psk(struct hostapd_data *hapd)
+{
+	struct hostapd_ssid *ssid = &hapd->conf->ssid;
+	struct hapd_interfaces *interfaces = hapd->iface->interfaces;
+	size_t i, j;
+
+	if (!ssid->wpa_passphrase || ssid->wpa_psk || !interfaces)
+		return;
+
+	for (i = 0; i < interfaces->count; i++) {
+		struct hostapd_iface *iface = interfaces->iface[i];
+
+		for (j = 0; j < iface->num_bss; j++) {
+			struct hostapd_ssid *other;
+
+			if (!iface->bss[j] || iface->bss[j] == hapd)
+				continue;
+			other = &iface->bss[j]->conf->ssid;
+
+			/* Only a PSK that was derived from the passphrase
+			 * without wpa_psk_file entries */
+			if (other->wpa_psk_set || !other->wpa_psk ||
+			    other->wpa_psk->next || !other->wpa_passphrase ||
+			    other->ssid_len != ssid->ssid_len ||
+			    os_memcmp(other->ssid, ssid->ssid,
+				      ssid->ssid_len) != 0 ||
+			    os_strcmp(other->wpa_passphrase,
+				      ssid->wpa_passphrase) != 0)
+				continue;
+
+			ssid->wpa_psk = os_zalloc(sizeof(*ssid->wpa_psk));
+			if (!ssid->wpa_psk)
+				return;
+			os_memcpy(ssid->wpa_psk->psk, other->wpa_psk->psk,
+				  PMK_LEN);
+			wpa_printf(MSG_DEBUG,
+				   "Reusing WPA PSK derived for BSS %s",
+				   iface->bss[j]->conf->iface);
+			return;
+		}
+	}
+}
+
+
 /**
  * hostapd_setup_bss - Per-BSS setup (initialization)
  * @hapd: Pointer to BSS data
@@ -1574,6 +1845,7 @@ setup_mld:
 			   wpa_ssid_txt(conf->ssid.ssid, conf->ssid.ssid_len));
 	}
 
+	hostapd_reuse_passphrase_psk(hapd);
 	if (hostapd_setup_wpa_psk(conf)) {
 		wpa_printf(MSG_ERROR, "WPA-PSK setup failed.");
 		return -1;
@@ -1737,6 +2009,11 @@ setup_mld:
 	if (hapd->wpa_auth && wpa_init_keys(hapd->wpa_auth) < 0)
 		return -1;
 
+	if (hostapd_status_shm_init(hapd)) {
+		wpa_printf(MSG_ERROR, "Status page initialization failed");
+		return -1;
+	}
+
 	return 0;
 }
 
@@ -2724,6 +3001,7 @@ dfs_offload:
 	hostapd_set_state(iface, HAPD_IFACE_ENABLED);
 	hostapd_owe_update_trans(iface);
 	airtime_policy_update_init(iface);
+	steering_update_init(iface);
 	wpa_msg(iface->bss[0]->msg_ctx, MSG_INFO, AP_EVENT_ENABLED);
 	if (hapd->setup_complete_cb)
 		hapd->setup_complete_cb(hapd->setup_complete_cb_ctx);
@@ -2934,8 +3212,9 @@ hostapd_alloc_bss_data(struct hostapd_iface *hapd_iface,
 	if (conf)
 		hapd->driver = conf->driver;
 	hapd->ctrl_sock = -1;
+	ap_sta_hash_init(hapd);
 	dl_list_init(&hapd->ctrl_dst);
-	dl_list_init(&hapd->nr_db);
+	hostapd_neighbor_db_init(hapd);
 	hapd->dhcp_sock = -1;
 #ifdef CONFIG_IEEE80211R_AP
 	dl_list_init(&hapd->l2_queue);
@@ -4122,8 +4401,8 @@ void hostapd_new_assoc_sta(struct hostapd_data *hapd, struct sta_info *sta,
 			   hapd->conf->iface, __func__, MAC2STR(sta->addr),
 			   hapd->conf->ap_max_inactivity);
 		eloop_cancel_timeout(ap_handle_timer, hapd, sta);
-		eloop_register_timeout(hapd->conf->ap_max_inactivity, 0,
-				       ap_handle_timer, hapd, sta);
+		ap_sta_register_inactivity_timer(hapd, sta,
+						 hapd->conf->ap_max_inactivity);
 	}
 
 #ifdef CONFIG_MACSEC
@@ -4167,6 +4446,7 @@ void hostapd_set_state(struct hostapd_iface *iface, enum hostapd_iface_state s)
 		   iface->conf ? iface->conf->bss[0]->iface : "N/A",
 		   hostapd_state_text(iface->state), hostapd_state_text(s));
 	iface->state = s;
+	hostapd_status_shm_update_iface(iface);
 }
 
 
@@ -4887,6 +5167,13 @@ struct hostapd_data * hostapd_mld_get_link_bss(struct hostapd_data *hapd,
 	struct hostapd_data *bss;
 	unsigned int i, j;
 
+	if (hapd->conf->mld_ap && hapd->mld && link_id < MAX_NUM_MLD_LINKS) {
+		bss = hapd->mld->link_bss[link_id];
+		if (bss && bss->drv_priv)
+			return bss;
+	}
+
+	/* Links that are not currently affiliated with the MLD */
 	for (i = 0; i < hapd->iface->interfaces->count; i++) {
 		iface = hapd->iface->interfaces->iface[i];
 		if (!iface)
@@ -4946,6 +5233,8 @@ int hostapd_mld_add_link(struct hostapd_data *hapd)
 
 	dl_list_add_tail(&mld->links, &hapd->link);
 	mld->num_links++;
+	if (hapd->mld_link_id < MAX_NUM_MLD_LINKS)
+		mld->link_bss[hapd->mld_link_id] = hapd;
 
 	wpa_printf(MSG_DEBUG, "AP MLD %s: Link ID %d added. num_links: %d",
 		   mld->name, hapd->mld_link_id, mld->num_links);
@@ -4974,6 +5263,9 @@ int hostapd_mld_remove_link(struct hostapd_data *hapd)
 
 	dl_list_del(&hapd->link);
 	mld->num_links--;
+	if (hapd->mld_link_id < MAX_NUM_MLD_LINKS &&
+	    mld->link_bss[hapd->mld_link_id] == hapd)
+		mld->link_bss[hapd->mld_link_id] = NULL;
 
 	wpa_printf(MSG_DEBUG, "AP MLD %s: Link ID %d removed. num_links: %d",
 		   mld->name, hapd->mld_link_id, mld->num_links);
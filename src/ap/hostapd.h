@@ -153,6 +153,8 @@ struct wps_stat {
 
 struct hostapd_neighbor_entry {
 	struct dl_list list;
+	struct dl_list hash_bssid; /* hostapd_data::nr_db_hash_bssid[] */
+	struct dl_list hash_ssid; /* hostapd_data::nr_db_hash_ssid[] */
 	u8 bssid[ETH_ALEN];
 	struct wpa_ssid_value ssid;
 	struct wpabuf *nr;
@@ -165,6 +167,13 @@ struct hostapd_neighbor_entry {
 	u8 bss_parameters;
 };
 
+/* Neighbor Report elements for one SSID prebuilt from the neighbor DB */
+struct hostapd_neighbor_report_cache {
+	struct dl_list list;
+	struct wpa_ssid_value ssid;
+	struct wpabuf *elems;
+};
+
 struct hostapd_sae_commit_queue {
 	struct dl_list list;
 	int rssi;
@@ -172,6 +181,58 @@ struct hostapd_sae_commit_queue {
 	u8 msg[];
 };
 
+#define PASN_LATENCY_BUCKETS 24
+
+struct hostapd_pasn_stats {
+	unsigned int auth1; /* received PASN Authentication frames 1 */
+	unsigned int comebacks; /* frames 1 answered with a comeback request */
+	unsigned int rejects; /* failed PASN authentications */
+	unsigned int completed; /* completed PASN authentications */
+	/* Time from frame 1 to processed frame 3; bucket i counts latencies
+	 * of [2^i, 2^(i + 1)) usec */
+	unsigned int latency[PASN_LATENCY_BUCKETS];
+	/* Moving average of the time used for processing frame 1 with ECDH
+	 * (usec) */
+	unsigned int auth1_avg_usec;
+	/* Counters for the current rate measurement window and the rates
+	 * (per second) from the previous window */
+	struct os_reltime window_start;
+	unsigned int window_auth1, window_completed;
+	unsigned int auth1_rate, completed_rate;
+};
+
+enum sae_token_reason {
+	SAE_TOKEN_NONE,
+	SAE_TOKEN_ALWAYS, /* anti_clogging_threshold=0 */
+	SAE_TOKEN_SESSIONS, /* open sessions and queued commits */
+	SAE_TOKEN_BACKLOG, /* estimated processing time of the queue */
+	SAE_TOKEN_LOAD, /* CPU time used for SAE (sae_cpu_budget) */
+	SAE_TOKEN_LAG, /* delay in processing queued frames (sae_cpu_budget) */
+	NUM_SAE_TOKEN_REASONS
+};
+
+struct hostapd_sae_stats {
+	unsigned int commits; /* processed queued Authentication frames */
+	/* Number of Authentication frames answered with an anti-clogging token
+	 * request for each enum sae_token_reason */
+	unsigned int token_req[NUM_SAE_TOKEN_REASONS];
+	/* Number of times the processing of the queue was postponed due to the
+	 * CPU budget having been used for the current window */
+	unsigned int rate_limited;
+	/* Moving average of the time used for processing a queued SAE
+	 * Authentication frame (usec) */
+	unsigned int commit_avg_usec;
+	/* Moving average of the delay from the scheduled processing time of
+	 * the queue to the actual processing (usec) */
+	unsigned int lag_avg_usec;
+	struct os_reltime next_process;
+	/* Processing time in the current measurement window and the load
+	 * (usec per second) from the previous window */
+	struct os_reltime window_start;
+	unsigned int window_usec;
+	unsigned int load_usec;
+};
+
 struct mld_link_info {
 	u8 valid:1;
 	u8 nstr_bitmap_len:2;
@@ -185,6 +246,30 @@ struct mld_link_info {
 	u16 status;
 	u16 resp_sta_profile_len;
 	u8 *resp_sta_profile;
+	/* Beacon generations of the reporting and the reported AP that
+	 * resp_sta_profile was built from */
+	unsigned int own_gen;
+	unsigned int link_gen;
+};
+
+#define HOSTAPD_PROBE_RESP_TMPL_MAX 4
+
+/**
+ * struct hostapd_probe_resp_tmpl - Pre-built Probe Response frame
+ *
+ * Probe Response frames that do not depend on the contents of the Probe
+ * Request frame beyond the fields used as the lookup key here are built once
+ * and reused until the Beacon frame contents change. Only the DA and the
+ * dynamic BSS Load element fields are updated for each response.
+ */
+struct hostapd_probe_resp_tmpl {
+	u8 *resp; /* NULL if the entry is not in use */
+	size_t resp_len;
+	size_t bss_load_offs; /* 0 if no BSS Load element is included */
+	bool is_p2p;
+	bool ml; /* response to a Multi-Link probe request */
+	struct hostapd_data *mld_ap;
+	u16 links;
 };
 
 /**
@@ -206,6 +291,15 @@ struct hostapd_data {
 #define STA_HASH_SIZE 256
 #define STA_HASH(sta) (sta[5])
 	struct sta_info *sta_hash[STA_HASH_SIZE];
+	/* Generation and time of the last bulk station data fetch */
+	unsigned int sta_drv_data_gen;
+	struct os_reltime sta_drv_data_time;
+	/* Persistent accounting spool and time of the last response from the
+	 * accounting server */
+	struct acct_spool *acct_spool;
+	struct os_reltime acct_last_rx;
+	/* Random key for the full address hash used to index sta_hash */
+	u64 sta_hash_key[2];
 
 	/*
 	 * Bitfield for indicating which AIDs are allocated. Only AID values
@@ -228,7 +322,7 @@ struct hostapd_data {
 	u64 acct_session_id;
 	struct radius_das_data *radius_das;
 
-	struct hostapd_cached_radius_acl *acl_cache;
+	struct hostapd_acl_cache *acl_cache;
 	struct hostapd_acl_query_data *acl_queries;
 
 	struct wpa_authenticator *wpa_auth;
@@ -236,6 +330,12 @@ struct hostapd_data {
 	struct eap_config *eap_cfg;
 
 	struct rsn_preauth_interface *preauth_iface;
+#ifdef CONFIG_PMKSA_SYNC
+	struct pmksa_sync *pmksa_sync;
+#endif /* CONFIG_PMKSA_SYNC */
+#ifdef CONFIG_STATUS_SHM
+	struct status_shm *status_shm;
+#endif /* CONFIG_STATUS_SHM */
 	struct os_reltime michael_mic_failure;
 	int michael_mic_failures;
 	int tkip_countermeasures;
@@ -274,6 +374,13 @@ struct hostapd_data {
 	struct wps_context *wps;
 
 	int beacon_set_done;
+	/* Contents of the latest successful set_ap() call or %NULL */
+	struct wpabuf *beacon_sig;
+	/* Changed to a new unique value whenever the frame contents change */
+	unsigned int beacon_gen;
+	struct hostapd_probe_resp_tmpl
+	probe_resp_tmpl[HOSTAPD_PROBE_RESP_TMPL_MAX];
+	unsigned int probe_resp_tmpl_next;
 	struct wpabuf *wps_beacon_ie;
 	struct wpabuf *wps_probe_resp_ie;
 #ifdef CONFIG_WPS
@@ -298,6 +405,7 @@ struct hostapd_data {
 	void (*public_action_cb2)(void *ctx, const u8 *buf, size_t len,
 				  int freq);
 	void *public_action_cb2_ctx;
+	struct anqp_cache *anqp_cache; /* ANQP response cache (gas_serv.c) */
 
 	int (*vendor_action_cb)(void *ctx, const u8 *buf, size_t len,
 				int freq);
@@ -363,6 +471,9 @@ struct hostapd_data {
 	struct l2_packet_data *sock_dhcp;
 	struct l2_packet_data *sock_ndisc;
 	bool x_snoop_initialized;
+	/* Snooped IPv4 and IPv6 addresses indexed by the address */
+	struct sta_info *ipaddr_hash[STA_HASH_SIZE];
+	struct ip6addr *ip6addr_hash[STA_HASH_SIZE];
 #endif /* CONFIG_PROXYARP */
 #ifdef CONFIG_MESH
 	int num_plinks;
@@ -376,6 +487,11 @@ struct hostapd_data {
 
 #ifdef CONFIG_SQLITE
 	struct hostapd_eap_user tmp_eap_user;
+	/* eap_user_sqlite database kept open for the lookups */
+	sqlite3 *eap_user_db;
+	char *eap_user_db_path;
+	sqlite3_stmt *eap_user_stmt;
+	sqlite3_stmt *eap_wildcard_stmt;
 #endif /* CONFIG_SQLITE */
 
 #ifdef CONFIG_SAE
@@ -390,8 +506,13 @@ struct hostapd_data {
 	u16 comeback_pending_idx[COMEBACK_PENDING_IDX_SIZE];
 	int dot11RSNASAERetransPeriod; /* msec */
 	struct dl_list sae_commit_queue; /* struct hostapd_sae_commit_queue */
+	struct hostapd_sae_stats sae_stats;
 #endif /* CONFIG_SAE */
 
+#ifdef CONFIG_PASN
+	struct hostapd_pasn_stats pasn_stats;
+#endif /* CONFIG_PASN */
+
 #ifdef CONFIG_TESTING_OPTIONS
 	unsigned int ext_mgmt_frame_handling:1;
 	unsigned int ext_eapol_frame_io:1;
@@ -421,6 +542,11 @@ struct hostapd_data {
 #endif /* CONFIG_MBO */
 
 	struct dl_list nr_db;
+#define NR_DB_HASH_SIZE 64
+	struct dl_list nr_db_hash_bssid[NR_DB_HASH_SIZE];
+	struct dl_list nr_db_hash_ssid[NR_DB_HASH_SIZE];
+	/* struct hostapd_neighbor_report_cache, flushed on DB changes */
+	struct dl_list nr_db_cache;
 
 	u8 beacon_req_token;
 	u8 lci_req_token;
@@ -523,8 +649,12 @@ struct hostapd_sta_info {
 	u8 addr[ETH_ALEN];
 	struct os_reltime last_seen;
 	int ssi_signal;
+	int ssi_avg; /* moving average of ssi_signal; 0 if not known */
+#ifdef CONFIG_STEERING
+	struct os_reltime steer_reject;
+#endif /* CONFIG_STEERING */
 #ifdef CONFIG_TAXONOMY
-	struct wpabuf *probe_ie_taxonomy;
+	struct taxonomy_info *probe_taxonomy;
 #endif /* CONFIG_TAXONOMY */
 };
 
@@ -557,6 +687,8 @@ struct hostapd_mld {
 
 	struct hostapd_data *fbss;
 	struct dl_list links; /* List head of all affiliated links */
+	/* Affiliated links indexed by link ID for per-frame lookups */
+	struct hostapd_data *link_bss[MAX_NUM_MLD_LINKS];
 
 	int ctrl_sock;
 	struct dl_list ctrl_dst;
@@ -566,6 +698,17 @@ struct hostapd_mld {
 #define HOSTAPD_MLD_MAX_REF_COUNT      0xFF
 #endif /* CONFIG_IEEE80211BE */
 
+/* DFS channel cleared by the background radar chain */
+struct hostapd_dfs_precac {
+	int channel;
+	int secondary_channel;
+	int freq;
+	int centr_freq_seg0_idx;
+	int centr_freq_seg1_idx;
+	int n_chans;
+	struct os_reltime expires;
+};
+
 /**
  * struct hostapd_iface - hostapd per-interface data structure
  */
@@ -631,7 +774,19 @@ struct hostapd_iface {
 
 	struct hostapd_hw_modes *hw_features;
 	int num_hw_features;
+	/* Incremented whenever hw_features is replaced */
+	unsigned int hw_features_gen;
 	struct hostapd_hw_modes *current_mode;
+	/* Country element shared by all the BSSs of the radio and the values
+	 * it was built from; see hostapd_eid_country() */
+	struct {
+		u8 elem[2 + 255];
+		size_t len;
+		const struct hostapd_hw_modes *mode;
+		unsigned int hw_features_gen;
+		u8 op_class;
+		char country[3];
+	} country_elem;
 	/* Rates that are currently used (i.e., filtered copy of
 	 * current_mode->channels */
 	int num_rates;
@@ -654,6 +809,10 @@ struct hostapd_iface {
 		unsigned int temp_ch:1;
 		/* CAC started on radar offchain */
 		unsigned int cac_started:1;
+		/* Channels cleared by the background chain that are kept
+		 * for immediate use on radar detection */
+		struct hostapd_dfs_precac precac[HOSTAPD_DFS_MAX_PRECAC];
+		unsigned int num_precac;
 	} radar_background;
 
 	u16 hw_flags;
@@ -729,6 +888,11 @@ struct hostapd_iface {
 #ifdef CONFIG_AIRTIME_POLICY
 	unsigned int airtime_quantum;
 #endif /* CONFIG_AIRTIME_POLICY */
+#ifdef CONFIG_STEERING
+	unsigned int steering_rounds; /* rounds with the threshold exceeded */
+	unsigned int steering_btm_sent;
+	unsigned int steering_auth_rejected;
+#endif /* CONFIG_STEERING */
 
 	/* Previous WMM element information */
 	struct hostapd_wmm_ac_params prev_wmm[WMM_AC_NUM];
@@ -737,6 +901,20 @@ struct hostapd_iface {
 	unsigned int mbssid_max_interfaces;
 	/* Maximum profile periodicity for enhanced MBSSID advertisement */
 	unsigned int ema_max_periodicity;
+	/* MBSSID and RNR elements of the transmitting BSS built once and
+	 * copied to every BSS while ieee802_11_set_beacons() or
+	 * ieee802_11_update_beacons() updates the whole set */
+	struct {
+		bool active;
+		u8 *elem;
+		size_t elem_len;
+		u8 elem_count;
+		u8 **elem_offset;
+		u8 *rnr_elem;
+		size_t rnr_elem_len;
+		u8 rnr_elem_count;
+		u8 **rnr_elem_offset;
+	} mbssid_batch;
 
 	int (*enable_iface_cb)(struct hostapd_iface *iface);
 	int (*disable_iface_cb)(struct hostapd_iface *iface);
@@ -756,6 +934,9 @@ int hostapd_for_each_interface(struct hapd_interfaces *interfaces,
 			       int (*cb)(struct hostapd_iface *iface,
 					 void *ctx), void *ctx);
 int hostapd_reload_config(struct hostapd_iface *iface);
+int hostapd_apply_config(struct hostapd_iface *iface, char *buf,
+			 size_t buflen);
+void hostapd_kick_mismatch_psk_stas(struct hostapd_data *hapd);
 void hostapd_reconfig_encryption(struct hostapd_data *hapd);
 struct hostapd_data *
 hostapd_alloc_bss_data(struct hostapd_iface *hapd_iface,
@@ -839,6 +1020,9 @@ void hostapd_acs_channel_selected(struct hostapd_data *hapd,
 const struct hostapd_eap_user *
 hostapd_get_eap_user(struct hostapd_data *hapd, const u8 *identity,
 		     size_t identity_len, int phase2);
+#ifdef CONFIG_SQLITE
+void hostapd_eap_user_sqlite_deinit(struct hostapd_data *hapd);
+#endif /* CONFIG_SQLITE */
 
 struct hostapd_data * hostapd_get_iface(struct hapd_interfaces *interfaces,
 					const char *ifname);
@@ -116,6 +116,7 @@ int hostapd_get_hw_features(struct hostapd_iface *iface)
 	hostapd_free_hw_features(iface->hw_features, iface->num_hw_features);
 	iface->hw_features = modes;
 	iface->num_hw_features = num_modes;
+	iface->hw_features_gen++;
 
 	for (i = 0; i < num_modes; i++) {
 		struct hostapd_hw_modes *feature = &modes[i];
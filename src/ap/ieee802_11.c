@@ -58,6 +58,8 @@
 #include "gas_query_ap.h"
 #include "comeback_token.h"
 #include "nan_usd_ap.h"
+#include "steering.h"
+#include "dhcp_snoop.h"
 #include "pasn/pasn_common.h"
 
 
@@ -769,13 +771,43 @@ static int auth_sae_send_confirm(struct hostapd_data *hapd,
 
 #if defined(CONFIG_SAE) || defined(CONFIG_PASN)
 
-static int use_anti_clogging(struct hostapd_data *hapd)
+/* Estimated time to process all queued SAE Authentication frames (usec) at
+ * which anti-clogging tokens are required regardless of the number of open
+ * sessions */
+#define SAE_COMMIT_QUEUE_MAX_BACKLOG_USEC 100000
+/* Average delay in getting to process the queued SAE Authentication frames
+ * (usec) at which anti-clogging tokens are required when sae_cpu_budget is
+ * set */
+#define SAE_COMMIT_QUEUE_MAX_LAG_USEC 100000
+
+#ifdef CONFIG_SAE
+static void sae_stats_update_window(struct hostapd_sae_stats *stats,
+				    struct os_reltime *now)
+{
+	struct os_reltime age;
+
+	os_reltime_sub(now, &stats->window_start, &age);
+	if (age.sec < 1)
+		return;
+
+	stats->load_usec = stats->window_usec / age.sec;
+	stats->window_usec = 0;
+	stats->window_start = *now;
+}
+#endif /* CONFIG_SAE */
+
+static enum sae_token_reason use_anti_clogging(struct hostapd_data *hapd)
 {
 	struct sta_info *sta;
 	unsigned int open = 0;
+#ifdef CONFIG_SAE
+	struct hostapd_sae_stats *stats = &hapd->sae_stats;
+	unsigned int queue_len;
+	struct os_reltime now;
+#endif /* CONFIG_SAE */
 
 	if (hapd->conf->anti_clogging_threshold == 0)
-		return 1;
+		return SAE_TOKEN_ALWAYS;
 
 	for (sta = hapd->sta_list; sta; sta = sta->next) {
 #ifdef CONFIG_SAE
@@ -789,19 +821,41 @@ static int use_anti_clogging(struct hostapd_data *hapd)
 			open++;
 #endif /* CONFIG_PASN */
 		if (open >= hapd->conf->anti_clogging_threshold)
-			return 1;
+			return SAE_TOKEN_SESSIONS;
 	}
 
 #ifdef CONFIG_SAE
 	/* In addition to already existing open SAE sessions, check whether
 	 * there are enough pending commit messages in the processing queue to
 	 * potentially result in too many open sessions. */
-	if (open + dl_list_len(&hapd->sae_commit_queue) >=
-	    hapd->conf->anti_clogging_threshold)
-		return 1;
+	queue_len = dl_list_len(&hapd->sae_commit_queue);
+	if (open + queue_len >= hapd->conf->anti_clogging_threshold)
+		return SAE_TOKEN_SESSIONS;
+
+	/* Require a token also when the queued messages would take long enough
+	 * to process to delay other frame processing noticeably, e.g., on a
+	 * slow CPU with expensive groups. */
+	if ((u64) queue_len * stats->commit_avg_usec >=
+	    SAE_COMMIT_QUEUE_MAX_BACKLOG_USEC)
+		return SAE_TOKEN_BACKLOG;
+
+	if (hapd->conf->sae_cpu_budget) {
+		/* Protect the CPU budget before it gets fully used so that
+		 * the rate limiting in the queue processing is needed only
+		 * when tokens are not sufficient, e.g., with a large number of
+		 * real peers. */
+		os_get_reltime(&now);
+		sae_stats_update_window(stats, &now);
+		if (2ULL * MAX(stats->load_usec, stats->window_usec) >=
+		    hapd->conf->sae_cpu_budget * 1000ULL)
+			return SAE_TOKEN_LOAD;
+		if (queue_len &&
+		    stats->lag_avg_usec >= SAE_COMMIT_QUEUE_MAX_LAG_USEC)
+			return SAE_TOKEN_LAG;
+	}
 #endif /* CONFIG_SAE */
 
-	return 0;
+	return SAE_TOKEN_NONE;
 }
 
 #endif /* defined(CONFIG_SAE) || defined(CONFIG_PASN) */
@@ -915,7 +969,7 @@ static void sae_sme_send_external_auth_status(struct hostapd_data *hapd,
 #ifdef CONFIG_IEEE80211BE
 	if (ap_sta_is_mld(hapd, sta))
 		params.bssid =
-			sta->mld_info.links[sta->mld_assoc_link_id].peer_addr;
+			sta->mld_info->links[sta->mld_assoc_link_id].peer_addr;
 #endif /* CONFIG_IEEE80211BE */
 	if (!params.bssid)
 		params.bssid = sta->addr;
@@ -1390,6 +1444,7 @@ static void handle_auth_sae(struct hostapd_data *hapd, struct sta_info *sta,
 		const u8 *token = NULL;
 		size_t token_len = 0;
 		int allow_reuse = 0;
+		enum sae_token_reason token_reason;
 
 		hostapd_logger(hapd, sta->addr, HOSTAPD_MODULE_IEEE80211,
 			       HOSTAPD_LEVEL_DEBUG,
@@ -1536,12 +1591,16 @@ static void handle_auth_sae(struct hostapd_data *hapd, struct sta_info *sta,
 			goto reply;
 		}
 
-		if (!token && use_anti_clogging(hapd) && !allow_reuse) {
+		if (!token && !allow_reuse &&
+		    (token_reason = use_anti_clogging(hapd)) !=
+		    SAE_TOKEN_NONE) {
 			int h2e = 0;
 
 			wpa_printf(MSG_DEBUG,
 				   "SAE: Request anti-clogging token from "
-				   MACSTR, MAC2STR(sta->addr));
+				   MACSTR " (reason %d)", MAC2STR(sta->addr),
+				   token_reason);
+			hapd->sae_stats.token_req[token_reason]++;
 			if (sta->sae->tmp)
 				h2e = sta->sae->h2e;
 			if (status_code == WLAN_STATUS_SAE_HASH_TO_ELEMENT ||
@@ -1691,11 +1750,56 @@ int auth_sae_init_committed(struct hostapd_data *hapd, struct sta_info *sta)
 }
 
 
+static void auth_sae_schedule_commit(struct hostapd_data *hapd,
+				     unsigned int queue_len)
+{
+	struct hostapd_sae_stats *stats = &hapd->sae_stats;
+	unsigned int usec;
+	struct os_reltime now, delay;
+
+	if (eloop_is_timeout_registered(auth_sae_process_commit, hapd, NULL))
+		return;
+
+	os_get_reltime(&now);
+	usec = queue_len * 10000;
+	if (hapd->conf->sae_cpu_budget) {
+		sae_stats_update_window(stats, &now);
+		if (stats->window_usec >= hapd->conf->sae_cpu_budget * 1000) {
+			struct os_reltime window_end;
+
+			/* The budget for this window has been used, so leave
+			 * the rest of the queue for the next window */
+			window_end = stats->window_start;
+			window_end.sec++;
+			os_reltime_sub(&window_end, &now, &delay);
+			if (delay.sec >= 0 &&
+			    delay.sec * 1000000 + delay.usec > usec)
+				usec = delay.sec * 1000000 + delay.usec;
+			stats->rate_limited++;
+			wpa_printf(MSG_DEBUG,
+				   "SAE: CPU budget used - postpone queue processing by %u usec",
+				   usec);
+		}
+	}
+
+	stats->next_process.sec = now.sec + usec / 1000000;
+	stats->next_process.usec = now.usec + usec % 1000000;
+	if (stats->next_process.usec >= 1000000) {
+		stats->next_process.sec++;
+		stats->next_process.usec -= 1000000;
+	}
+	eloop_register_timeout(usec / 1000000, usec % 1000000,
+			       auth_sae_process_commit, hapd, NULL);
+}
+
+
 void auth_sae_process_commit(void *eloop_ctx, void *user_ctx)
 {
 	struct hostapd_data *hapd = eloop_ctx;
+	struct hostapd_sae_stats *stats = &hapd->sae_stats;
 	struct hostapd_sae_commit_queue *q;
-	unsigned int queue_len;
+	unsigned int usec, lag;
+	struct os_reltime start, now, diff;
 
 	q = dl_list_first(&hapd->sae_commit_queue,
 			  struct hostapd_sae_commit_queue, list);
@@ -1704,15 +1808,87 @@ void auth_sae_process_commit(void *eloop_ctx, void *user_ctx)
 	wpa_printf(MSG_DEBUG,
 		   "SAE: Process next available message from queue");
 	dl_list_del(&q->list);
+	os_get_reltime(&start);
+
+	/* How late the queue processing got to run indicates how busy the
+	 * event loop is with other work */
+	if (os_reltime_before(&stats->next_process, &start)) {
+		os_reltime_sub(&start, &stats->next_process, &diff);
+		lag = diff.sec >= 1 ? 1000000 : diff.usec;
+	} else {
+		lag = 0;
+	}
+	stats->lag_avg_usec = (7 * stats->lag_avg_usec + lag) / 8;
+
 	handle_auth(hapd, (const struct ieee80211_mgmt *) q->msg, q->len,
 		    q->rssi, 1);
 	os_free(q);
 
-	if (eloop_is_timeout_registered(auth_sae_process_commit, hapd, NULL))
-		return;
-	queue_len = dl_list_len(&hapd->sae_commit_queue);
-	eloop_register_timeout(0, queue_len * 10000, auth_sae_process_commit,
-			       hapd, NULL);
+	os_get_reltime(&now);
+	os_reltime_sub(&now, &start, &diff);
+	if (diff.sec < 0)
+		usec = 0;
+	else if (diff.sec >= 1)
+		usec = 1000000;
+	else
+		usec = diff.usec;
+	/* Exponentially weighted moving average with weight 1/8 */
+	if (stats->commit_avg_usec)
+		stats->commit_avg_usec = (7 * stats->commit_avg_usec +
+					  usec) / 8;
+	else
+		stats->commit_avg_usec = usec;
+	stats->commits++;
+	sae_stats_update_window(stats, &now);
+	stats->window_usec += usec;
+
+	auth_sae_schedule_commit(hapd, dl_list_len(&hapd->sae_commit_queue));
+}
+
+
+/**
+ * hostapd_sae_stats - Write SAE statistics
+ * @hapd: Pointer to BSS data
+ * @buf: Buffer for the statistics
+ * @buflen: Length of the buffer
+ * Returns: Number of bytes written to the buffer
+ *
+ * This is used for the SAE_STATS control interface command.
+ */
+int hostapd_sae_stats(struct hostapd_data *hapd, char *buf, size_t buflen)
+{
+	struct hostapd_sae_stats *stats = &hapd->sae_stats;
+	struct os_reltime now;
+	int ret;
+
+	os_get_reltime(&now);
+	sae_stats_update_window(stats, &now);
+
+	ret = os_snprintf(buf, buflen,
+			  "commits=%u\n"
+			  "queue_len=%u\n"
+			  "commit_avg_usec=%u\n"
+			  "lag_avg_usec=%u\n"
+			  "load_usec_per_sec=%u\n"
+			  "token_req_always=%u\n"
+			  "token_req_sessions=%u\n"
+			  "token_req_backlog=%u\n"
+			  "token_req_load=%u\n"
+			  "token_req_lag=%u\n"
+			  "rate_limited=%u\n",
+			  stats->commits,
+			  dl_list_len(&hapd->sae_commit_queue),
+			  stats->commit_avg_usec, stats->lag_avg_usec,
+			  MAX(stats->load_usec, stats->window_usec),
+			  stats->token_req[SAE_TOKEN_ALWAYS],
+			  stats->token_req[SAE_TOKEN_SESSIONS],
+			  stats->token_req[SAE_TOKEN_BACKLOG],
+			  stats->token_req[SAE_TOKEN_LOAD],
+			  stats->token_req[SAE_TOKEN_LAG],
+			  stats->rate_limited);
+	if (os_snprintf_error(buflen, ret))
+		return 0;
+	return ret;
 }
 
 
@@ -1767,10 +1943,7 @@ static void auth_sae_queue(struct hostapd_data *hapd,
 	dl_list_add_tail(&hapd->sae_commit_queue, &q->list);
 
 queued:
-	if (eloop_is_timeout_registered(auth_sae_process_commit, hapd, NULL))
-		return;
-	eloop_register_timeout(0, queue_len * 10000, auth_sae_process_commit,
-			       hapd, NULL);
+	auth_sae_schedule_commit(hapd, queue_len);
 }
 
 
@@ -2651,6 +2824,156 @@ static int pasn_wd_handle_fils(struct hostapd_data *hapd, struct sta_info *sta,
 #endif /* CONFIG_FILS */
 
 
+/* Share of each second (usec) that the processing of PASN Authentication
+ * frames 1 can use before comeback tokens are required */
+#define PASN_MAX_LOAD_USEC_PER_SEC 200000
+/* Maximum Comeback After time when scaled based on the load (TUs) */
+#define PASN_MAX_COMEBACK_AFTER 1000
+
+static void pasn_stats_update_window(struct hostapd_pasn_stats *stats,
+				     struct os_reltime *now)
+{
+	struct os_reltime age;
+
+	os_reltime_sub(now, &stats->window_start, &age);
+	if (age.sec < 1)
+		return;
+
+	stats->auth1_rate = stats->window_auth1 / age.sec;
+	stats->completed_rate = stats->window_completed / age.sec;
+	stats->window_auth1 = 0;
+	stats->window_completed = 0;
+	stats->window_start = *now;
+}
+
+
+/* Estimated time used each second for processing PASN frames 1 (usec) */
+static u64 pasn_load_usec(struct hostapd_pasn_stats *stats)
+{
+	unsigned int rate = MAX(stats->auth1_rate, stats->window_auth1);
+
+	return (u64) rate * stats->auth1_avg_usec;
+}
+
+
+static void pasn_stats_auth1_done(struct hostapd_data *hapd,
+				  struct sta_info *sta, int ret)
+{
+	struct hostapd_pasn_stats *stats = &hapd->pasn_stats;
+	struct os_reltime now, diff;
+	unsigned int usec;
+
+	if (sta->pasn->comeback_sent) {
+		stats->comebacks++;
+		return;
+	}
+	if (ret < 0)
+		stats->rejects++;
+	/* Comebacks and early rejections do not indicate the cost of the ECDH
+	 * computation */
+	if (!sta->pasn->ecdh)
+		return;
+
+	os_get_reltime(&now);
+	os_reltime_sub(&now, &sta->pasn_start, &diff);
+	if (diff.sec < 0)
+		usec = 0;
+	else if (diff.sec >= 1)
+		usec = 1000000;
+	else
+		usec = diff.usec;
+	/* Exponentially weighted moving average with weight 1/8 */
+	if (stats->auth1_avg_usec)
+		stats->auth1_avg_usec = (7 * stats->auth1_avg_usec + usec) / 8;
+	else
+		stats->auth1_avg_usec = usec;
+}
+
+
+static void pasn_stats_completed(struct hostapd_data *hapd,
+				 struct sta_info *sta)
+{
+	struct hostapd_pasn_stats *stats = &hapd->pasn_stats;
+	struct os_reltime now, diff;
+	u64 usec;
+	unsigned int i = 0;
+
+	os_get_reltime(&now);
+	pasn_stats_update_window(stats, &now);
+	stats->completed++;
+	stats->window_completed++;
+
+	os_reltime_sub(&now, &sta->pasn_start, &diff);
+	usec = diff.sec < 0 ? 0 : (u64) diff.sec * 1000000 + diff.usec;
+	while (i < PASN_LATENCY_BUCKETS - 1 && usec >= (2ULL << i))
+		i++;
+	stats->latency[i]++;
+}
+
+
+static unsigned int
+pasn_latency_percentile(const struct hostapd_pasn_stats *stats,
+			unsigned int percent)
+{
+	unsigned int i, count = 0, target;
+
+	if (!stats->completed)
+		return 0;
+	target = ((u64) stats->completed * percent + 99) / 100;
+	for (i = 0; i < PASN_LATENCY_BUCKETS; i++) {
+		count += stats->latency[i];
+		if (count >= target)
+			break;
+	}
+	/* Report the upper bound of the bucket */
+	return 1U << (i + 1);
+}
+
+
+/**
+ * hostapd_pasn_stats - Write PASN responder statistics
+ * @hapd: Pointer to BSS data
+ * @buf: Buffer for the statistics
+ * @buflen: Length of the buffer
+ * Returns: Number of bytes written to the buffer
+ *
+ * This is used for the PASN_STATS control interface command. The latency
+ * percentiles are upper bounds with power of two granularity.
+ */
+int hostapd_pasn_stats(struct hostapd_data *hapd, char *buf, size_t buflen)
+{
+	struct hostapd_pasn_stats *stats = &hapd->pasn_stats;
+	struct os_reltime now;
+	int ret;
+
+	os_get_reltime(&now);
+	pasn_stats_update_window(stats, &now);
+
+	ret = os_snprintf(buf, buflen,
+			  "auth1=%u\n"
+			  "comebacks=%u\n"
+			  "rejects=%u\n"
+			  "completed=%u\n"
+			  "auth1_per_sec=%u\n"
+			  "completed_per_sec=%u\n"
+			  "auth1_avg_usec=%u\n"
+			  "load_usec_per_sec=%llu\n"
+			  "latency_p50_usec=%u\n"
+			  "latency_p90_usec=%u\n"
+			  "latency_p99_usec=%u\n",
+			  stats->auth1, stats->comebacks, stats->rejects,
+			  stats->completed, stats->auth1_rate,
+			  stats->completed_rate, stats->auth1_avg_usec,
+			  (unsigned long long) pasn_load_usec(stats),
+			  pasn_latency_percentile(stats, 50),
+			  pasn_latency_percentile(stats, 90),
+			  pasn_latency_percentile(stats, 99));
+	if (os_snprintf_error(buflen, ret))
+		return 0;
+	return ret;
+}
+
+
 static int hapd_pasn_send_mlme(void *ctx, const u8 *data, size_t data_len,
 			       int noack, unsigned int freq, unsigned int wait)
 {
@@ -2664,6 +2987,7 @@ static void hapd_initialize_pasn(struct hostapd_data *hapd,
 				 struct sta_info *sta)
 {
 	struct pasn_data *pasn = sta->pasn;
+	u64 load, comeback_after;
 
 	pasn_register_callbacks(pasn, hapd, hapd_pasn_send_mlme, NULL);
 	pasn_set_bssid(pasn, hapd->own_addr);
@@ -2681,7 +3005,7 @@ static void hapd_initialize_pasn(struct hostapd_data *hapd,
 	if (hapd->conf->force_kdk_derivation)
 		pasn_enable_kdk_derivation(pasn);
 #endif /* CONFIG_TESTING_OPTIONS */
-	pasn->use_anti_clogging = use_anti_clogging(hapd);
+	pasn->use_anti_clogging = use_anti_clogging(hapd) != SAE_TOKEN_NONE;
 	pasn_set_password(pasn, sae_get_password(hapd, sta, NULL, NULL,
 						 &pasn->pt, NULL));
 	pasn->rsn_ie = wpa_auth_get_wpa_ie(hapd->wpa_auth, &pasn->rsn_ie_len);
@@ -2691,6 +3015,17 @@ static void hapd_initialize_pasn(struct hostapd_data *hapd,
 				 wpa_auth_get_pmksa_cache(hapd->wpa_auth));
 
 	pasn->comeback_after = hapd->conf->pasn_comeback_after;
+	load = pasn_load_usec(&hapd->pasn_stats);
+	if (load >= PASN_MAX_LOAD_USEC_PER_SEC) {
+		/* Require comeback tokens when PASN authentication would use
+		 * too large a share of the CPU time and ask the peers to come
+		 * back later the larger the load is. */
+		pasn->use_anti_clogging = 1;
+		comeback_after = (u64) pasn->comeback_after * load /
+			PASN_MAX_LOAD_USEC_PER_SEC;
+		pasn->comeback_after = MIN(comeback_after,
+					   PASN_MAX_COMEBACK_AFTER);
+	}
 	pasn->comeback_idx = hapd->comeback_idx;
 	pasn->comeback_key =  hapd->comeback_key;
 	pasn->comeback_pending_idx = hapd->comeback_pending_idx;
@@ -2876,6 +3211,11 @@ static void handle_auth_pasn(struct hostapd_data *hapd, struct sta_info *sta,
 			return;
 		}
 
+		os_get_reltime(&sta->pasn_start);
+		pasn_stats_update_window(&hapd->pasn_stats, &sta->pasn_start);
+		hapd->pasn_stats.auth1++;
+		hapd->pasn_stats.window_auth1++;
+
 		hapd_initialize_pasn(hapd, sta);
 
 		hapd_pasn_update_params(hapd, sta, mgmt, len);
@@ -2883,6 +3223,7 @@ static void handle_auth_pasn(struct hostapd_data *hapd, struct sta_info *sta,
 					 mgmt, len, false);
 		wpabuf_free(sta->pasn->frame);
 		sta->pasn->frame = NULL;
+		pasn_stats_auth1_done(hapd, sta, ret);
 		if (ret < 0)
 			ap_free_sta(hapd, sta);
 	} else if (trans_seq == 3) {
@@ -2895,12 +3236,16 @@ static void handle_auth_pasn(struct hostapd_data *hapd, struct sta_info *sta,
 		if (status != WLAN_STATUS_SUCCESS) {
 			wpa_printf(MSG_DEBUG,
 				   "PASN: Failure status in transaction == 3");
+			hapd->pasn_stats.rejects++;
 			ap_free_sta_pasn(hapd, sta);
 			return;
 		}
 
 		if (handle_auth_pasn_3(sta->pasn, hapd->own_addr,
-				       sta->addr, mgmt, len) == 0) {
+				       sta->addr, mgmt, len) < 0) {
+			hapd->pasn_stats.rejects++;
+		} else {
+			pasn_stats_completed(hapd, sta);
 			ptksa_cache_add(hapd->ptksa, hapd->own_addr, sta->addr,
 					pasn_get_cipher(sta->pasn), 43200,
 					pasn_get_ptk(sta->pasn), NULL, NULL,
@@ -2921,6 +3266,53 @@ static void handle_auth_pasn(struct hostapd_data *hapd, struct sta_info *sta,
 #endif /* CONFIG_PASN */
 
 
+/**
+ * hostapd_eid_neighbor_report_bss - Add a Neighbor Report element for a BSS
+ * @hapd: BSS to describe
+ * @eid: Buffer for the element; at least 2 + 13 octets
+ * Returns: Pointer to the end of the added element
+ */
+u8 * hostapd_eid_neighbor_report_bss(struct hostapd_data *hapd, u8 *eid)
+{
+	u8 *pos = eid;
+	u32 info;
+	u8 op_class, channel, phytype;
+
+	*pos++ = WLAN_EID_NEIGHBOR_REPORT;
+	*pos++ = 13;
+	os_memcpy(pos, hapd->own_addr, ETH_ALEN);
+	pos += ETH_ALEN;
+	info = 0; /* TODO: BSSID Information */
+	WPA_PUT_LE32(pos, info);
+	pos += 4;
+	if (hapd->iconf->hw_mode == HOSTAPD_MODE_IEEE80211AD)
+		phytype = 8; /* dmg */
+	else if (hapd->iconf->ieee80211ac)
+		phytype = 9; /* vht */
+	else if (hapd->iconf->ieee80211n)
+		phytype = 7; /* ht */
+	else if (hapd->iconf->hw_mode == HOSTAPD_MODE_IEEE80211A)
+		phytype = 4; /* ofdm */
+	else if (hapd->iconf->hw_mode == HOSTAPD_MODE_IEEE80211G)
+		phytype = 6; /* erp */
+	else
+		phytype = 5; /* hrdsss */
+	if (ieee80211_freq_to_channel_ext(
+		    hostapd_hw_get_freq(hapd, hapd->iconf->channel),
+		    hapd->iconf->secondary_channel,
+		    hapd->iconf->ieee80211ac,
+		    &op_class, &channel) == NUM_HOSTAPD_MODES) {
+		op_class = 0;
+		channel = hapd->iconf->channel;
+	}
+	*pos++ = op_class;
+	*pos++ = channel;
+	*pos++ = phytype;
+
+	return pos;
+}
+
+
 static void handle_auth(struct hostapd_data *hapd,
 			const struct ieee80211_mgmt *mgmt, size_t len,
 			int rssi, int from_queue)
@@ -3077,55 +3469,23 @@ static void handle_auth(struct hostapd_data *hapd,
 		other = sta_track_seen_on(hapd->iface, sa,
 					  hapd->conf->no_auth_if_seen_on);
 		if (other) {
-			u8 *pos;
-			u32 info;
-			u8 op_class, channel, phytype;
-
 			wpa_printf(MSG_DEBUG, "%s: Reject authentication from "
 				   MACSTR " since STA has been seen on %s",
 				   hapd->conf->iface, MAC2STR(sa),
 				   hapd->conf->no_auth_if_seen_on);
 
 			resp = WLAN_STATUS_REJECTED_WITH_SUGGESTED_BSS_TRANSITION;
-			pos = &resp_ies[0];
-			*pos++ = WLAN_EID_NEIGHBOR_REPORT;
-			*pos++ = 13;
-			os_memcpy(pos, other->own_addr, ETH_ALEN);
-			pos += ETH_ALEN;
-			info = 0; /* TODO: BSSID Information */
-			WPA_PUT_LE32(pos, info);
-			pos += 4;
-			if (other->iconf->hw_mode == HOSTAPD_MODE_IEEE80211AD)
-				phytype = 8; /* dmg */
-			else if (other->iconf->ieee80211ac)
-				phytype = 9; /* vht */
-			else if (other->iconf->ieee80211n)
-				phytype = 7; /* ht */
-			else if (other->iconf->hw_mode ==
-				 HOSTAPD_MODE_IEEE80211A)
-				phytype = 4; /* ofdm */
-			else if (other->iconf->hw_mode ==
-				 HOSTAPD_MODE_IEEE80211G)
-				phytype = 6; /* erp */
-			else
-				phytype = 5; /* hrdsss */
-			if (ieee80211_freq_to_channel_ext(
-				    hostapd_hw_get_freq(other,
-							other->iconf->channel),
-				    other->iconf->secondary_channel,
-				    other->iconf->ieee80211ac,
-				    &op_class, &channel) == NUM_HOSTAPD_MODES) {
-				op_class = 0;
-				channel = other->iconf->channel;
-			}
-			*pos++ = op_class;
-			*pos++ = channel;
-			*pos++ = phytype;
-			resp_ies_len = pos - &resp_ies[0];
+			resp_ies_len = hostapd_eid_neighbor_report_bss(
+				other, resp_ies) - resp_ies;
 			goto fail;
 		}
 	}
 
+	if (steering_reject_auth(hapd, sa, resp_ies, &resp_ies_len)) {
+		resp = WLAN_STATUS_REJECTED_WITH_SUGGESTED_BSS_TRANSITION;
+		goto fail;
+	}
+
 	res = ieee802_11_allowed_address(hapd, sa, (const u8 *) mgmt, len,
 					 &rad_info);
 	if (res == HOSTAPD_ACL_REJECT) {
@@ -3212,24 +3572,26 @@ static void handle_auth(struct hostapd_data *hapd,
 	 * peer_addr based on mgmt->sa which would have been translated to the
 	 * MLD MAC address. */
 	if (!sta->added_unassoc && auth_transaction == 1) {
-		ap_sta_free_sta_profile(&sta->mld_info);
-		os_memset(&sta->mld_info, 0, sizeof(sta->mld_info));
+		ap_sta_free_mld_info(sta);
 
 		if (mld_sta) {
 			u8 link_id = hapd->mld_link_id;
 
-			ap_sta_set_mld(sta, true);
+			if (ap_sta_set_mld(sta, true) < 0) {
+				resp = WLAN_STATUS_UNSPECIFIED_FAILURE;
+				goto fail;
+			}
 			sta->mld_assoc_link_id = link_id;
 
 			/*
 			 * Set the MLD address as the station address and the
 			 * station addresses.
 			 */
-			os_memcpy(sta->mld_info.common_info.mld_addr, sa,
+			os_memcpy(sta->mld_info->common_info.mld_addr, sa,
 				  ETH_ALEN);
-			os_memcpy(sta->mld_info.links[link_id].peer_addr,
+			os_memcpy(sta->mld_info->links[link_id].peer_addr,
 				  mgmt->sa, ETH_ALEN);
-			os_memcpy(sta->mld_info.links[link_id].local_addr,
+			os_memcpy(sta->mld_info->links[link_id].local_addr,
 				  hapd->own_addr, ETH_ALEN);
 		}
 	}
@@ -3418,13 +3780,13 @@ static u32 hostapd_get_aid_word(struct hostapd_data *hapd,
 
 	/* Do not assign an AID that is in use on any of the affiliated links
 	 * when finding an AID for a non-AP MLD. */
-	if (hapd->conf->mld_ap && sta->mld_info.mld_sta) {
+	if (ap_sta_is_mld(hapd, sta)) {
 		int j;
 
 		for (j = 0; j < MAX_NUM_MLD_LINKS; j++) {
 			struct hostapd_data *link_bss;
 
-			if (!sta->mld_info.links[j].valid)
+			if (!sta->mld_info->links[j].valid)
 				continue;
 
 			link_bss = hostapd_mld_get_link_bss(hapd, j);
@@ -3887,7 +4249,7 @@ u16 owe_process_rsn_ie(struct hostapd_data *hapd,
 #ifdef CONFIG_IEEE80211BE
 	if (ap_sta_is_mld(hapd, sta))
 		wpa_auth_set_ml_info(sta->wpa_sm,
-				     sta->mld_assoc_link_id, &sta->mld_info);
+				     sta->mld_assoc_link_id, sta->mld_info);
 #endif /* CONFIG_IEEE80211BE */
 	rsn_ie -= 2;
 	rsn_ie_len += 2;
@@ -4150,7 +4512,7 @@ static int __check_assoc_ies(struct hostapd_data *hapd, struct sta_info *sta,
 	if (hapd->conf->wpa && wpa_ie) {
 		enum wpa_validate_result res;
 #ifdef CONFIG_IEEE80211BE
-		struct mld_info *info = &sta->mld_info;
+		struct mld_info *info = sta->mld_info;
 		bool init = !sta->wpa_sm;
 #endif /* CONFIG_IEEE80211BE */
 
@@ -4615,11 +4977,14 @@ static int ieee80211_ml_process_link(struct hostapd_data *hapd,
 		goto out;
 	}
 
-	ap_sta_set_mld(sta, true);
+	if (ap_sta_set_mld(sta, true) < 0) {
+		status = WLAN_STATUS_UNSPECIFIED_FAILURE;
+		goto out;
+	}
 
-	os_memcpy(&sta->mld_info, &origin_sta->mld_info, sizeof(sta->mld_info));
+	os_memcpy(sta->mld_info, origin_sta->mld_info, sizeof(*sta->mld_info));
 	for (i = 0; i < MAX_NUM_MLD_LINKS; i++) {
-		struct mld_link_info *li = &sta->mld_info.links[i];
+		struct mld_link_info *li = &sta->mld_info->links[i];
 
 		li->resp_sta_profile = NULL;
 		li->resp_sta_profile_len = 0;
@@ -4705,29 +5070,18 @@ int hostapd_process_assoc_ml_info(struct hostapd_data *hapd,
 #ifdef CONFIG_IEEE80211BE
 	unsigned int i;
 
-	if (!hostapd_is_mld_ap(hapd))
+	if (!hostapd_is_mld_ap(hapd) || !sta->mld_info)
 		return 0;
 
 	for (i = 0; i < MAX_NUM_MLD_LINKS; i++) {
-		struct hostapd_data *bss = NULL;
-		struct mld_link_info *link = &sta->mld_info.links[i];
-		bool link_bss_found = false;
+		struct hostapd_data *bss;
+		struct mld_link_info *link = &sta->mld_info->links[i];
 
 		if (!link->valid || i == sta->mld_assoc_link_id)
 			continue;
 
-		for_each_mld_link(bss, hapd) {
-			if (bss == hapd)
-				continue;
-
-			if (bss->mld_link_id != i)
-				continue;
-
-			link_bss_found = true;
-			break;
-		}
-
-		if (!link_bss_found || TEST_FAIL()) {
+		bss = hapd->mld->link_bss[i];
+		if (!bss || bss == hapd || TEST_FAIL()) {
 			wpa_printf(MSG_DEBUG,
 				   "MLD: No link match for link_id=%u", i);
 
@@ -4790,7 +5144,7 @@ static int add_associated_sta(struct hostapd_data *hapd,
 		u8 mld_link_id = hapd->mld_link_id;
 
 		mld_link_sta = sta->mld_assoc_link_id != mld_link_id;
-		mld_link_addr = sta->mld_info.links[mld_link_id].peer_addr;
+		mld_link_addr = sta->mld_info->links[mld_link_id].peer_addr;
 
 		if (hapd->mld_link_id != sta->mld_assoc_link_id)
 			set = 0;
@@ -5867,8 +6221,7 @@ static void hostapd_disassoc_sta(struct hostapd_data *hapd,
 	 * authenticated. */
 	accounting_sta_stop(hapd, sta);
 	ieee802_1x_free_station(hapd, sta);
-	if (sta->ipaddr)
-		hostapd_drv_br_delete_ip_neigh(hapd, 4, (u8 *) &sta->ipaddr);
+	sta_ipaddr_del(hapd, sta);
 	ap_sta_ip6addr_del(hapd, sta);
 	hostapd_drv_sta_remove(hapd, sta->addr);
 	sta->added_unassoc = 0;
@@ -5922,22 +6275,17 @@ static bool hostapd_ml_handle_disconnect(struct hostapd_data *hapd,
 		if (tmp_hapd == assoc_hapd)
 			continue;
 
-		if (!assoc_sta->mld_info.links[tmp_hapd->mld_link_id].valid)
+		if (!assoc_sta->mld_info->links[tmp_hapd->mld_link_id].valid)
 			continue;
 
-		for (tmp_sta = tmp_hapd->sta_list; tmp_sta;
-		     tmp_sta = tmp_sta->next) {
-			if (tmp_sta->mld_assoc_link_id !=
-			    assoc_sta->mld_assoc_link_id ||
-			    tmp_sta->aid != assoc_sta->aid)
-				continue;
+		tmp_sta = ap_get_mld_link_sta(tmp_hapd, assoc_sta);
+		if (!tmp_sta)
+			continue;
 
-			if (!disassoc)
-				hostapd_deauth_sta(tmp_hapd, tmp_sta, mgmt);
-			else
-				hostapd_disassoc_sta(tmp_hapd, tmp_sta, mgmt);
-			break;
-		}
+		if (!disassoc)
+			hostapd_deauth_sta(tmp_hapd, tmp_sta, mgmt);
+		else
+			hostapd_disassoc_sta(tmp_hapd, tmp_sta, mgmt);
 	}
 
 	/* Remove the station on which the association was performed. */
@@ -6014,7 +6362,7 @@ static void handle_beacon(struct hostapd_data *hapd,
 			  const struct ieee80211_mgmt *mgmt, size_t len,
 			  struct hostapd_frame_info *fi)
 {
-	struct ieee802_11_elems elems;
+	struct ieee802_11_elem_index elems;
 
 	if (len < IEEE80211_HDRLEN + sizeof(mgmt->u.beacon)) {
 		wpa_printf(MSG_INFO, "handle_beacon - too short payload (len=%lu)",
@@ -6022,10 +6370,11 @@ static void handle_beacon(struct hostapd_data *hapd,
 		return;
 	}
 
-	(void) ieee802_11_parse_elems(mgmt->u.beacon.variable,
+	/* Only a few elements are needed for the AP list, so do not decode
+	 * the full set of elements for every received Beacon frame. */
+	(void) ieee802_11_index_elems(mgmt->u.beacon.variable,
 				      len - (IEEE80211_HDRLEN +
-					     sizeof(mgmt->u.beacon)), &elems,
-				      0);
+					     sizeof(mgmt->u.beacon)), &elems);
 
 	ap_list_process_beacon(hapd->iface, mgmt, &elems, fi);
 }
@@ -6568,7 +6917,7 @@ static void hostapd_ml_handle_assoc_cb(struct hostapd_data *hapd,
 #ifdef CONFIG_IEEE80211BE
 	struct hostapd_data *tmp_hapd;
 
-	if (!hostapd_is_mld_ap(hapd))
+	if (!hostapd_is_mld_ap(hapd) || !sta->mld_info)
 		return;
 
 	for_each_mld_link(tmp_hapd, hapd) {
@@ -6578,22 +6927,14 @@ static void hostapd_ml_handle_assoc_cb(struct hostapd_data *hapd,
 		if (tmp_hapd == hapd)
 			continue;
 
-		link = &sta->mld_info.links[tmp_hapd->mld_link_id];
+		link = &sta->mld_info->links[tmp_hapd->mld_link_id];
 		if (!link->valid)
 			continue;
 
-		for (tmp_sta = tmp_hapd->sta_list; tmp_sta;
-		     tmp_sta = tmp_sta->next) {
-			if (tmp_sta == sta ||
-			    tmp_sta->mld_assoc_link_id !=
-			    sta->mld_assoc_link_id ||
-			    tmp_sta->aid != sta->aid)
-				continue;
-
+		tmp_sta = ap_get_mld_link_sta(tmp_hapd, sta);
+		if (tmp_sta)
 			ieee80211_ml_link_sta_assoc_cb(tmp_hapd, tmp_sta, link,
 						       ok);
-			break;
-		}
 	}
 #endif /* CONFIG_IEEE80211BE */
 }
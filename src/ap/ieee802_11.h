@@ -162,6 +162,8 @@ static inline void sae_clear_retransmit_timer(struct hostapd_data *hapd,
 }
 #endif /* CONFIG_SAE */
 
+int hostapd_pasn_stats(struct hostapd_data *hapd, char *buf, size_t buflen);
+
 #ifdef CONFIG_MBO
 
 u8 * hostapd_eid_mbo(struct hostapd_data *hapd, u8 *eid, size_t len);
@@ -224,6 +226,7 @@ int get_tx_parameters(struct sta_info *sta, int ap_max_chanwidth,
 		      int ap_seg1_idx, int *bandwidth, int *seg1_idx);
 
 void auth_sae_process_commit(void *eloop_ctx, void *user_ctx);
+int hostapd_sae_stats(struct hostapd_data *hapd, char *buf, size_t buflen);
 u8 * hostapd_eid_rsnxe(struct hostapd_data *hapd, u8 *eid, size_t len);
 u16 check_ext_capab(struct hostapd_data *hapd, struct sta_info *sta,
 		    const u8 *ext_capab_ie, size_t ext_capab_ie_len);
@@ -231,6 +234,7 @@ size_t hostapd_eid_rnr_len(struct hostapd_data *hapd, u32 type,
 			   bool include_mld_params);
 u8 * hostapd_eid_rnr(struct hostapd_data *hapd, u8 *eid, u32 type,
 		     bool include_mld_params);
+u8 * hostapd_eid_neighbor_report_bss(struct hostapd_data *hapd, u8 *eid);
 int ieee802_11_set_radius_info(struct hostapd_data *hapd, struct sta_info *sta,
 			       int res, struct radius_sta *info);
 size_t hostapd_eid_eht_capab_len(struct hostapd_data *hapd,
@@ -15,6 +15,7 @@
 
 #include "utils/common.h"
 #include "utils/eloop.h"
+#include "utils/list.h"
 #include "radius/radius.h"
 #include "radius/radius_client.h"
 #include "hostapd.h"
@@ -27,13 +28,17 @@
 #include "ieee802_11_auth.h"
 
 #define RADIUS_ACL_TIMEOUT 30
+#define RADIUS_ACL_HASH_SIZE 256
+#define RADIUS_ACL_HASH(addr) ((addr)[5])
 
 
 struct hostapd_cached_radius_acl {
 	struct os_reltime timestamp;
 	macaddr addr;
 	int accepted; /* HOSTAPD_ACL_* */
-	struct hostapd_cached_radius_acl *next;
+	struct hostapd_cached_radius_acl *hnext;
+	struct dl_list list; /* in the order of addition */
+	struct dl_list lru; /* least recently used first */
 	struct radius_sta info;
 };
 
@@ -45,6 +50,7 @@ struct hostapd_acl_query_data {
 	u8 *auth_msg; /* IEEE 802.11 authentication frame from station */
 	size_t auth_msg_len;
 	struct hostapd_acl_query_data *next;
+	struct hostapd_acl_query_data *hnext;
 	bool radius_psk;
 	int akm;
 	u8 *anonce;
@@ -54,6 +60,30 @@ struct hostapd_acl_query_data {
 
 
 #ifndef CONFIG_NO_RADIUS
+/* RADIUS ACL results and pending queries hashed by the STA address */
+struct hostapd_acl_cache {
+	struct hostapd_cached_radius_acl *hash[RADIUS_ACL_HASH_SIZE];
+	struct dl_list list; /* struct hostapd_cached_radius_acl::list */
+	struct dl_list lru; /* struct hostapd_cached_radius_acl::lru */
+	unsigned int num;
+	struct hostapd_acl_query_data *query_hash[RADIUS_ACL_HASH_SIZE];
+};
+
+
+static struct hostapd_acl_cache *
+hostapd_acl_cache_ctx(struct hostapd_data *hapd)
+{
+	if (!hapd->acl_cache) {
+		hapd->acl_cache = os_zalloc(sizeof(*hapd->acl_cache));
+		if (!hapd->acl_cache)
+			return NULL;
+		dl_list_init(&hapd->acl_cache->list);
+		dl_list_init(&hapd->acl_cache->lru);
+	}
+	return hapd->acl_cache;
+}
+
+
 static void hostapd_acl_cache_free_entry(struct hostapd_cached_radius_acl *e)
 {
 	os_free(e->info.identity);
@@ -63,15 +93,49 @@ static void hostapd_acl_cache_free_entry(struct hostapd_cached_radius_acl *e)
 }
 
 
-static void hostapd_acl_cache_free(struct hostapd_cached_radius_acl *acl_cache)
+static void hostapd_acl_cache_del(struct hostapd_acl_cache *cache,
+				  struct hostapd_cached_radius_acl *entry)
+{
+	struct hostapd_cached_radius_acl **pos;
+
+	for (pos = &cache->hash[RADIUS_ACL_HASH(entry->addr)]; *pos;
+	     pos = &(*pos)->hnext) {
+		if (*pos == entry) {
+			*pos = entry->hnext;
+			break;
+		}
+	}
+	dl_list_del(&entry->list);
+	dl_list_del(&entry->lru);
+	cache->num--;
+	hostapd_acl_cache_free_entry(entry);
+}
+
+
+static void hostapd_acl_cache_free(struct hostapd_acl_cache *cache)
+{
+	struct hostapd_cached_radius_acl *entry, *n;
+
+	if (!cache)
+		return;
+	dl_list_for_each_safe(entry, n, &cache->list,
+			      struct hostapd_cached_radius_acl, list)
+		hostapd_acl_cache_free_entry(entry);
+	os_free(cache);
+}
+
+
+static struct hostapd_cached_radius_acl *
+hostapd_acl_cache_find(struct hostapd_acl_cache *cache, const u8 *addr)
 {
-	struct hostapd_cached_radius_acl *prev;
+	struct hostapd_cached_radius_acl *entry;
 
-	while (acl_cache) {
-		prev = acl_cache;
-		acl_cache = acl_cache->next;
-		hostapd_acl_cache_free_entry(prev);
+	for (entry = cache->hash[RADIUS_ACL_HASH(addr)]; entry;
+	     entry = entry->hnext) {
+		if (ether_addr_equal(entry->addr, addr))
+			return entry;
 	}
+	return NULL;
 }
 
 
@@ -81,21 +145,96 @@ static int hostapd_acl_cache_get(struct hostapd_data *hapd, const u8 *addr,
 	struct hostapd_cached_radius_acl *entry;
 	struct os_reltime now;
 
+	if (!hapd->acl_cache)
+		return -1;
+	entry = hostapd_acl_cache_find(hapd->acl_cache, addr);
+	if (!entry)
+		return -1;
+
 	os_get_reltime(&now);
+	if (os_reltime_expired(&now, &entry->timestamp, RADIUS_ACL_TIMEOUT))
+		return -1; /* entry has expired */
+	*out = entry->info;
 
-	for (entry = hapd->acl_cache; entry; entry = entry->next) {
-		if (!ether_addr_equal(entry->addr, addr))
-			continue;
+	dl_list_del(&entry->lru);
+	dl_list_add_tail(&hapd->acl_cache->lru, &entry->lru);
 
-		if (os_reltime_expired(&now, &entry->timestamp,
-				       RADIUS_ACL_TIMEOUT))
-			return -1; /* entry has expired */
-		*out = entry->info;
+	return entry->accepted;
+}
 
-		return entry->accepted;
+
+static void hostapd_acl_cache_add(struct hostapd_data *hapd,
+				  struct hostapd_acl_cache *cache,
+				  struct hostapd_cached_radius_acl *entry)
+{
+	struct hostapd_cached_radius_acl *old;
+	unsigned int hash = RADIUS_ACL_HASH(entry->addr);
+
+	/* Replace a previous, possibly expired, result for the STA */
+	old = hostapd_acl_cache_find(cache, entry->addr);
+	if (old)
+		hostapd_acl_cache_del(cache, old);
+
+	while (cache->num >= hapd->conf->radius_acl_cache_size) {
+		old = dl_list_first(&cache->lru,
+				    struct hostapd_cached_radius_acl, lru);
+		if (!old)
+			break;
+		wpa_printf(MSG_DEBUG, "Cache full - drop ACL entry for "
+			   MACSTR, MAC2STR(old->addr));
+		hostapd_drv_set_radius_acl_expire(hapd, old->addr);
+		hostapd_acl_cache_del(cache, old);
 	}
 
-	return -1;
+	entry->hnext = cache->hash[hash];
+	cache->hash[hash] = entry;
+	dl_list_add_tail(&cache->list, &entry->list);
+	dl_list_add_tail(&cache->lru, &entry->lru);
+	cache->num++;
+}
+
+
+static struct hostapd_acl_query_data *
+hostapd_acl_query_get(struct hostapd_data *hapd, const u8 *addr)
+{
+	struct hostapd_acl_query_data *query;
+
+	if (!hapd->acl_cache)
+		return NULL;
+	for (query = hapd->acl_cache->query_hash[RADIUS_ACL_HASH(addr)];
+	     query; query = query->hnext) {
+		if (ether_addr_equal(query->addr, addr))
+			return query;
+	}
+	return NULL;
+}
+
+
+static void hostapd_acl_query_add(struct hostapd_data *hapd,
+				  struct hostapd_acl_cache *cache,
+				  struct hostapd_acl_query_data *query)
+{
+	unsigned int hash = RADIUS_ACL_HASH(query->addr);
+
+	query->next = hapd->acl_queries;
+	hapd->acl_queries = query;
+	query->hnext = cache->query_hash[hash];
+	cache->query_hash[hash] = query;
+}
+
+
+static void hostapd_acl_query_hash_del(struct hostapd_acl_cache *cache,
+				       struct hostapd_acl_query_data *query)
+{
+	struct hostapd_acl_query_data **pos;
+
+	for (pos = &cache->query_hash[RADIUS_ACL_HASH(query->addr)]; *pos;
+	     pos = &(*pos)->hnext) {
+		if (*pos == query) {
+			*pos = query->hnext;
+			break;
+		}
+	}
 }
 #endif /* CONFIG_NO_RADIUS */
 
@@ -264,6 +403,7 @@ int hostapd_allowed_address(struct hostapd_data *hapd, const u8 *addr,
 		return HOSTAPD_ACL_REJECT;
 #else /* CONFIG_NO_RADIUS */
 		struct hostapd_acl_query_data *query;
+		struct hostapd_acl_cache *cache;
 
 		if (is_probe_req) {
 			/* Skip RADIUS queries for Probe Request frames to avoid
@@ -282,19 +422,32 @@ int hostapd_allowed_address(struct hostapd_data *hapd, const u8 *addr,
 		if (res == HOSTAPD_ACL_REJECT)
 			return HOSTAPD_ACL_REJECT;
 
-		query = hapd->acl_queries;
-		while (query) {
-			if (ether_addr_equal(query->addr, addr)) {
-				/* pending query in RADIUS retransmit queue;
-				 * do not generate a new one */
-				return HOSTAPD_ACL_PENDING;
+		query = hostapd_acl_query_get(hapd, addr);
+		if (query) {
+			u8 *auth_msg;
+
+			/* pending query in RADIUS retransmit queue;
+			 * do not generate a new one, but process the latest
+			 * authentication frame once the response arrives */
+			wpa_printf(MSG_DEBUG, "ACL query for " MACSTR
+				   " already pending (id=%d)",
+				   MAC2STR(addr), query->radius_id);
+			auth_msg = query->auth_msg ? os_memdup(msg, len) : NULL;
+			if (auth_msg) {
+				os_free(query->auth_msg);
+				query->auth_msg = auth_msg;
+				query->auth_msg_len = len;
 			}
-			query = query->next;
+			return HOSTAPD_ACL_PENDING;
 		}
 
 		if (!hapd->conf->radius->auth_server)
 			return HOSTAPD_ACL_REJECT;
 
+		cache = hostapd_acl_cache_ctx(hapd);
+		if (!cache)
+			return HOSTAPD_ACL_REJECT;
+
 		/* No entry in the cache - query external RADIUS server */
 		query = os_zalloc(sizeof(*query));
 		if (!query) {
@@ -318,8 +471,7 @@ int hostapd_allowed_address(struct hostapd_data *hapd, const u8 *addr,
 			return HOSTAPD_ACL_REJECT;
 		}
 		query->auth_msg_len = len;
-		query->next = hapd->acl_queries;
-		hapd->acl_queries = query;
+		hostapd_acl_query_add(hapd, cache, query);
 
 		/* Queued data will be processed in hostapd_acl_recv_radius()
 		 * when RADIUS server replies to the sent Access-Request. */
@@ -335,29 +487,24 @@ int hostapd_allowed_address(struct hostapd_data *hapd, const u8 *addr,
 static void hostapd_acl_expire_cache(struct hostapd_data *hapd,
 				     struct os_reltime *now)
 {
-	struct hostapd_cached_radius_acl *prev, *entry, *tmp;
-
-	prev = NULL;
-	entry = hapd->acl_cache;
+	struct hostapd_acl_cache *cache = hapd->acl_cache;
+	struct hostapd_cached_radius_acl *entry;
 
-	while (entry) {
-		if (os_reltime_expired(now, &entry->timestamp,
-				       RADIUS_ACL_TIMEOUT)) {
-			wpa_printf(MSG_DEBUG, "Cached ACL entry for " MACSTR
-				   " has expired.", MAC2STR(entry->addr));
-			if (prev)
-				prev->next = entry->next;
-			else
-				hapd->acl_cache = entry->next;
-			hostapd_drv_set_radius_acl_expire(hapd, entry->addr);
-			tmp = entry;
-			entry = entry->next;
-			hostapd_acl_cache_free_entry(tmp);
-			continue;
-		}
+	if (!cache)
+		return;
 
-		prev = entry;
-		entry = entry->next;
+	/* The entries are in the order of addition, so the expired ones are
+	 * at the head of the list. */
+	while ((entry = dl_list_first(&cache->list,
+				      struct hostapd_cached_radius_acl,
+				      list))) {
+		if (!os_reltime_expired(now, &entry->timestamp,
+					RADIUS_ACL_TIMEOUT))
+			break;
+		wpa_printf(MSG_DEBUG, "Cached ACL entry for " MACSTR
+			   " has expired.", MAC2STR(entry->addr));
+		hostapd_drv_set_radius_acl_expire(hapd, entry->addr);
+		hostapd_acl_cache_del(cache, entry);
 	}
 }
 
@@ -379,6 +526,7 @@ static void hostapd_acl_expire_queries(struct hostapd_data *hapd,
 				prev->next = entry->next;
 			else
 				hapd->acl_queries = entry->next;
+			hostapd_acl_query_hash_del(hapd->acl_cache, entry);
 
 			tmp = entry;
 			entry = entry->next;
@@ -490,6 +638,7 @@ hostapd_acl_recv_radius(struct radius_msg *msg, struct radius_msg *req,
 	struct hostapd_data *hapd = data;
 	struct hostapd_acl_query_data *query, *prev;
 	struct hostapd_cached_radius_acl *cache;
+	struct hostapd_acl_cache *acl_cache;
 	struct radius_sta *info;
 	struct radius_hdr *hdr = radius_msg_get_hdr(msg);
 
@@ -503,6 +652,7 @@ hostapd_acl_recv_radius(struct radius_msg *msg, struct radius_msg *req,
 	}
 	if (!query)
 		return RADIUS_RX_UNKNOWN;
+	acl_cache = hapd->acl_cache;
 
 	wpa_printf(MSG_DEBUG,
 		   "Found matching Access-Request for RADIUS message (id=%d)",
@@ -596,8 +746,7 @@ hostapd_acl_recv_radius(struct radius_msg *msg, struct radius_msg *req,
 			cache->accepted = HOSTAPD_ACL_REJECT;
 	} else
 		cache->accepted = HOSTAPD_ACL_REJECT;
-	cache->next = hapd->acl_cache;
-	hapd->acl_cache = cache;
+	hostapd_acl_cache_add(hapd, acl_cache, cache);
 
 	if (query->radius_psk) {
 		struct sta_info *sta;
@@ -640,6 +789,7 @@ hostapd_acl_recv_radius(struct radius_msg *msg, struct radius_msg *req,
 		hapd->acl_queries = query->next;
 	else
 		prev->next = query->next;
+	hostapd_acl_query_hash_del(acl_cache, query);
 
 	hostapd_acl_query_free(query);
 
@@ -723,7 +873,11 @@ void hostapd_acl_req_radius_psk(struct hostapd_data *hapd, const u8 *addr,
 				const u8 *eapol, size_t eapol_len)
 {
 	struct hostapd_acl_query_data *query;
+	struct hostapd_acl_cache *cache;
 
+	cache = hostapd_acl_cache_ctx(hapd);
+	if (!cache)
+		return;
 	query = os_zalloc(sizeof(*query));
 	if (!query)
 		return;
@@ -745,7 +899,6 @@ void hostapd_acl_req_radius_psk(struct hostapd_data *hapd, const u8 *addr,
 		return;
 	}
 
-	query->next = hapd->acl_queries;
-	hapd->acl_queries = query;
+	hostapd_acl_query_add(hapd, cache, query);
 }
 #endif /* CONFIG_NO_RADIUS */
@@ -797,9 +797,9 @@ u8 * hostapd_eid_eht_ml_assoc(struct hostapd_data *hapd, struct sta_info *info,
 	if (!ap_sta_is_mld(hapd, info))
 		return eid;
 
-	eid = hostapd_eid_eht_basic_ml_common(hapd, eid, &info->mld_info,
+	eid = hostapd_eid_eht_basic_ml_common(hapd, eid, info->mld_info,
 					      false);
-	ap_sta_free_sta_profile(&info->mld_info);
+	ap_sta_free_sta_profile(info->mld_info);
 	return hostapd_eid_eht_reconf_ml(hapd, eid);
 }
 
@@ -928,11 +928,11 @@ sae_confirm_skip_fixed_fields(struct hostapd_data *hapd,
 		for (sta = hapd->sta_list; sta; sta = sta->next) {
 			int link_id = hapd->mld_link_id;
 
-			if (!sta->mld_info.mld_sta ||
-			    sta->mld_info.links[link_id].valid ||
+			if (!sta->mld_info || !sta->mld_info->mld_sta ||
+			    sta->mld_info->links[link_id].valid ||
 			    !ether_addr_equal(
 				    mgmt->sa,
-				    sta->mld_info.links[link_id].peer_addr))
+				    sta->mld_info->links[link_id].peer_addr))
 				continue;
 			wpa_printf(MSG_DEBUG,
 				   "SAE: Found MLD STA for SAE confirm based on link address");
@@ -1059,7 +1059,7 @@ static int hostapd_mld_validate_assoc_info(struct hostapd_data *hapd,
 					   struct sta_info *sta)
 {
 	u8 link_id;
-	struct mld_info *info = &sta->mld_info;
+	struct mld_info *info = sta->mld_info;
 
 	if (!ap_sta_is_mld(hapd, sta)) {
 		wpa_printf(MSG_DEBUG, "MLD: Not a non-AP MLD");
@@ -1162,7 +1162,7 @@ u16 hostapd_process_ml_assoc_req(struct hostapd_data *hapd,
 	const struct eht_ml_basic_common_info *common_info;
 	size_t ml_len, common_info_len;
 	struct mld_link_info *link_info;
-	struct mld_info *info = &sta->mld_info;
+	struct mld_info *info = sta->mld_info;
 	const u8 *pos, *end;
 	int ret = -1;
 	u16 ml_control;
@@ -1172,6 +1172,12 @@ u16 hostapd_process_ml_assoc_req(struct hostapd_data *hapd,
 	if (!mlbuf)
 		return WLAN_STATUS_SUCCESS;
 
+	if (!info) {
+		wpa_printf(MSG_DEBUG,
+			   "MLD: Multi-Link element from a STA that did not authenticate as a non-AP MLD");
+		goto out;
+	}
+
 	ml = wpabuf_head(mlbuf);
 	ml_len = wpabuf_len(mlbuf);
 	ml_end = ((const u8 *) ml) + ml_len;
@@ -1404,7 +1410,8 @@ u16 hostapd_process_ml_assoc_req(struct hostapd_data *hapd,
 out:
 	wpabuf_free(mlbuf);
 	if (ret) {
-		os_memset(info, 0, sizeof(*info));
+		if (info)
+			os_memset(info, 0, sizeof(*info));
 		return WLAN_STATUS_UNSPECIFIED_FAILURE;
 	}
 
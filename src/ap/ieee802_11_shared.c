@@ -1219,16 +1219,11 @@ struct sta_info * hostapd_ml_get_assoc_sta(struct hostapd_data *hapd,
 		return sta;
 	}
 
-	/*
-	 * Iterate over the stations and find the one with the matching link ID
-	 * and association ID.
-	 */
-	for (tmp_sta = other_hapd->sta_list; tmp_sta; tmp_sta = tmp_sta->next) {
-		if (tmp_sta->mld_assoc_link_id == sta->mld_assoc_link_id &&
-		    tmp_sta->aid == sta->aid) {
-			*assoc_hapd = other_hapd;
-			return tmp_sta;
-		}
+	/* Find the station with the matching link ID and association ID */
+	tmp_sta = ap_get_mld_link_sta(other_hapd, sta);
+	if (tmp_sta && tmp_sta->mld_info) {
+		*assoc_hapd = other_hapd;
+		return tmp_sta;
 	}
 #endif /* CONFIG_IEEE80211BE */
 
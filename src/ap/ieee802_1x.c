@@ -151,7 +151,7 @@ static void ieee802_1x_ml_set_sta_authorized(struct hostapd_data *hapd,
 #ifdef CONFIG_IEEE80211BE
 	unsigned int i, link_id;
 
-	if (!hostapd_is_mld_ap(hapd))
+	if (!hostapd_is_mld_ap(hapd) || !sta->mld_info)
 		return;
 
 	/*
@@ -162,7 +162,7 @@ static void ieee802_1x_ml_set_sta_authorized(struct hostapd_data *hapd,
 		return;
 
 	for (link_id = 0; link_id < MAX_NUM_MLD_LINKS; link_id++) {
-		struct mld_link_info *link = &sta->mld_info.links[link_id];
+		struct mld_link_info *link = &sta->mld_info->links[link_id];
 
 		if (!link->valid)
 			continue;
@@ -2388,6 +2388,11 @@ static int ieee802_1x_get_eap_user(void *ctx, const u8 *identity,
 			goto out;
 		user->password_len = eap_user->password_len;
 		user->password_hash = eap_user->password_hash;
+		if (eap_user->nt_hash_set) {
+			os_memcpy(user->nt_hash, eap_user->nt_hash,
+				  sizeof(user->nt_hash));
+			user->nt_hash_set = 1;
+		}
 		if (eap_user->salt && eap_user->salt_len) {
 			user->salt = os_memdup(eap_user->salt,
 					       eap_user->salt_len);
@@ -2728,7 +2733,7 @@ int ieee802_1x_eapol_tx_status(struct hostapd_data *hapd, struct sta_info *sta,
 		if (wpa->type == EAPOL_KEY_TYPE_RSN ||
 		    wpa->type == EAPOL_KEY_TYPE_WPA)
 			wpa_auth_eapol_key_tx_status(hapd->wpa_auth,
-						     sta->wpa_sm, ack);
+						     sta->wpa_sm, ack, wpa);
 	}
 
 	/* EAPOL EAP-Packet packets are eventually re-sent by either Supplicant
@@ -0,0 +1,469 @@
+/*
+ * hostapd / Replay of recorded frames for performance measurements
+ *
+ * This software may be distributed under the terms of the BSD license.
+ * See README for more details.
+ *
+ * The frames from a pcap file (IEEE 802.11 or radiotap link type) are fed to
+ * the same processing path that is used for frames received from the driver.
+ * Management frames go through EVENT_RX_MGMT and unprotected EAPOL frames
+ * through ieee802_1x_receive(). The destination and BSSID are rewritten to
+ * match the local BSS and the source address can be varied for each round of
+ * the replay to emulate a large number of stations with a trace recorded from
+ * a single station. Responses are sent through the driver, so this should be
+ * used with driver=none or another driver that does not transmit frames.
+ */
+
+#include "utils/includes.h"
+
+#include "utils/common.h"
+#include "common/ieee802_11_defs.h"
+#include "drivers/driver.h"
+#include "hostapd.h"
+#include "ieee802_1x.h"
+#include "mgmt_replay.h"
+
+#define PCAP_MAGIC 0xa1b2c3d4
+#define PCAP_MAGIC_NSEC 0xa1b23c4d
+#define LINKTYPE_IEEE802_11 105
+#define LINKTYPE_IEEE802_11_RADIOTAP 127
+
+#define RADIOTAP_PRESENT_TSFT BIT(0)
+#define RADIOTAP_PRESENT_FLAGS BIT(1)
+#define RADIOTAP_PRESENT_EXT BIT(31)
+#define RADIOTAP_F_FCS 0x10
+#define RADIOTAP_F_BADFCS 0x40
+
+enum mgmt_replay_type {
+	MGMT_REPLAY_PROBE_REQ,
+	MGMT_REPLAY_AUTH,
+	MGMT_REPLAY_ASSOC_REQ,
+	MGMT_REPLAY_ACTION,
+	MGMT_REPLAY_DEAUTH,
+	MGMT_REPLAY_OTHER_MGMT,
+	MGMT_REPLAY_EAPOL,
+	NUM_MGMT_REPLAY_TYPES
+};
+
+static const char * const mgmt_replay_type_names[NUM_MGMT_REPLAY_TYPES] = {
+	"probe_req", "auth", "assoc_req", "action", "deauth", "other_mgmt",
+	"eapol"
+};
+
+struct mgmt_replay_latency {
+	unsigned int *usec;
+	size_t count;
+	size_t alloc;
+};
+
+
+static u32 mgmt_replay_get32(const struct mgmt_replay_iter *iter,
+			     const u8 *pos)
+{
+	return iter->swapped ? WPA_GET_BE32(pos) : WPA_GET_LE32(pos);
+}
+
+
+/**
+ * mgmt_replay_iter_init - Start iterating over the frames of a pcap file
+ * @iter: Iterator to initialize
+ * @data: Contents of the pcap file
+ * @len: Length of data in octets
+ * Returns: 0 on success or -1 if the file format is not supported
+ */
+int mgmt_replay_iter_init(struct mgmt_replay_iter *iter, const u8 *data,
+			  size_t len)
+{
+	u32 magic;
+
+	os_memset(iter, 0, sizeof(*iter));
+	if (len < 24)
+		return -1;
+
+	magic = WPA_GET_LE32(data);
+	if (magic == PCAP_MAGIC || magic == PCAP_MAGIC_NSEC) {
+		iter->swapped = false;
+	} else {
+		magic = WPA_GET_BE32(data);
+		if (magic != PCAP_MAGIC && magic != PCAP_MAGIC_NSEC)
+			return -1;
+		iter->swapped = true;
+	}
+
+	iter->linktype = mgmt_replay_get32(iter, data + 20) & 0xffff;
+	if (iter->linktype != LINKTYPE_IEEE802_11 &&
+	    iter->linktype != LINKTYPE_IEEE802_11_RADIOTAP)
+		return -1;
+
+	iter->pos = data + 24;
+	iter->end = data + len;
+	return 0;
+}
+
+
+static int mgmt_replay_strip_radiotap(const u8 **frame, size_t *frame_len)
+{
+	const u8 *pos = *frame;
+	size_t len = *frame_len, hdr_len, offset = 4;
+	u32 present, word;
+	u8 flags = 0;
+
+	if (len < 8)
+		return -1;
+	hdr_len = WPA_GET_LE16(pos + 2);
+	if (hdr_len < 8 || hdr_len > len)
+		return -1;
+
+	/* Skip the possible extended presence bitmaps */
+	present = WPA_GET_LE32(pos + 4);
+	word = present;
+	while (word & RADIOTAP_PRESENT_EXT) {
+		offset += 4;
+		if (offset + 4 > hdr_len)
+			return -1;
+		word = WPA_GET_LE32(pos + offset);
+	}
+	offset += 4;
+
+	if (present & RADIOTAP_PRESENT_TSFT)
+		offset = ((offset + 7) & ~7) + 8;
+	if ((present & RADIOTAP_PRESENT_FLAGS) && offset < hdr_len)
+		flags = pos[offset];
+
+	if (flags & RADIOTAP_F_BADFCS)
+		return -1;
+	len -= hdr_len;
+	if (flags & RADIOTAP_F_FCS) {
+		if (len < 4)
+			return -1;
+		len -= 4;
+	}
+
+	*frame = pos + hdr_len;
+	*frame_len = len;
+	return 0;
+}
+
+
+/**
+ * mgmt_replay_iter_next - Get the next frame from a pcap file
+ * @iter: Iterator from mgmt_replay_iter_init()
+ * @frame: Buffer for returning a pointer to the IEEE 802.11 frame
+ * @frame_len: Buffer for returning the length of the frame without FCS
+ * Returns: 1 if a frame was returned, 0 at the end of the file, -1 on error
+ *
+ * Records that do not include a valid IEEE 802.11 frame, e.g., because of
+ * truncation or a bad FCS, are returned with *frame set to %NULL.
+ */
+int mgmt_replay_iter_next(struct mgmt_replay_iter *iter, const u8 **frame,
+			  size_t *frame_len)
+{
+	u32 incl_len, orig_len;
+
+	if (iter->pos == iter->end)
+		return 0;
+	if (iter->end - iter->pos < 16)
+		return -1;
+
+	incl_len = mgmt_replay_get32(iter, iter->pos + 8);
+	orig_len = mgmt_replay_get32(iter, iter->pos + 12);
+	iter->pos += 16;
+	if (incl_len > (size_t) (iter->end - iter->pos))
+		return -1;
+
+	*frame = iter->pos;
+	*frame_len = incl_len;
+	iter->pos += incl_len;
+
+	if (incl_len < orig_len ||
+	    (iter->linktype == LINKTYPE_IEEE802_11_RADIOTAP &&
+	     mgmt_replay_strip_radiotap(frame, frame_len) < 0) ||
+	    *frame_len < 24)
+		*frame = NULL;
+
+	return 1;
+}
+
+
+static enum mgmt_replay_type mgmt_replay_mgmt_type(u16 stype)
+{
+	switch (stype) {
+	case WLAN_FC_STYPE_PROBE_REQ:
+		return MGMT_REPLAY_PROBE_REQ;
+	case WLAN_FC_STYPE_AUTH:
+		return MGMT_REPLAY_AUTH;
+	case WLAN_FC_STYPE_ASSOC_REQ:
+	case WLAN_FC_STYPE_REASSOC_REQ:
+		return MGMT_REPLAY_ASSOC_REQ;
+	case WLAN_FC_STYPE_ACTION:
+	case WLAN_FC_STYPE_ACTION_NO_ACK:
+		return MGMT_REPLAY_ACTION;
+	case WLAN_FC_STYPE_DEAUTH:
+	case WLAN_FC_STYPE_DISASSOC:
+		return MGMT_REPLAY_DEAUTH;
+	default:
+		return MGMT_REPLAY_OTHER_MGMT;
+	}
+}
+
+
+/* Returns the offset of the EAPOL frame or 0 if this is not an unprotected
+ * EAPOL frame from a station to the AP */
+static size_t mgmt_replay_eapol_offset(const u8 *frame, size_t len)
+{
+	static const u8 snap_eapol[] = {
+		0xaa, 0xaa, 0x03, 0x00, 0x00, 0x00, 0x88, 0x8e
+	};
+	u16 fc = WPA_GET_LE16(frame);
+	size_t hdr_len = 24;
+
+	if ((fc & (WLAN_FC_TODS | WLAN_FC_FROMDS | WLAN_FC_ISWEP)) !=
+	    WLAN_FC_TODS)
+		return 0;
+	if (WLAN_FC_GET_STYPE(fc) & 0x08)
+		hdr_len += 2; /* QoS Control */
+	if ((WLAN_FC_GET_STYPE(fc) & 0x08) && (fc & WLAN_FC_HTC))
+		hdr_len += 4;
+	if (len < hdr_len + sizeof(snap_eapol) ||
+	    os_memcmp(frame + hdr_len, snap_eapol, sizeof(snap_eapol)) != 0)
+		return 0;
+	return hdr_len + sizeof(snap_eapol);
+}
+
+
+static void mgmt_replay_record(struct mgmt_replay_latency *lat,
+			       struct os_reltime *start)
+{
+	struct os_reltime now, diff;
+	unsigned int *n;
+
+	os_get_reltime(&now);
+	if (lat->count == lat->alloc) {
+		n = os_realloc_array(lat->usec, lat->alloc ? 2 * lat->alloc : 64,
+				     sizeof(unsigned int));
+		if (!n)
+			return;
+		lat->usec = n;
+		lat->alloc = lat->alloc ? 2 * lat->alloc : 64;
+	}
+	os_reltime_sub(&now, start, &diff);
+	lat->usec[lat->count++] = diff.sec < 0 ? 0 :
+		diff.sec * 1000000 + diff.usec;
+}
+
+
+static int mgmt_replay_cmp(const void *a, const void *b)
+{
+	unsigned int ua = *(const unsigned int *) a;
+	unsigned int ub = *(const unsigned int *) b;
+
+	return ua < ub ? -1 : ua > ub;
+}
+
+
+static unsigned int mgmt_replay_percentile(struct mgmt_replay_latency *lat,
+					   unsigned int percent)
+{
+	size_t idx;
+
+	idx = (lat->count * percent + 99) / 100;
+	return lat->usec[idx ? idx - 1 : 0];
+}
+
+
+static int mgmt_replay_process(struct hostapd_data *hapd, const u8 *frame,
+			       size_t len, unsigned int round,
+			       struct mgmt_replay_latency *lat)
+{
+	struct ieee80211_hdr *hdr;
+	union wpa_event_data event;
+	struct os_reltime start;
+	enum mgmt_replay_type type;
+	size_t eapol = 0;
+	u8 *buf;
+	u16 fc;
+
+	fc = WPA_GET_LE16(frame);
+	if (WLAN_FC_GET_TYPE(fc) == WLAN_FC_TYPE_MGMT) {
+		type = mgmt_replay_mgmt_type(WLAN_FC_GET_STYPE(fc));
+	} else if (WLAN_FC_GET_TYPE(fc) == WLAN_FC_TYPE_DATA) {
+		eapol = mgmt_replay_eapol_offset(frame, len);
+		if (!eapol)
+			return -1;
+		type = MGMT_REPLAY_EAPOL;
+	} else {
+		return -1;
+	}
+
+	buf = os_memdup(frame, len);
+	if (!buf)
+		return -1;
+	hdr = (struct ieee80211_hdr *) buf;
+	if (!is_broadcast_ether_addr(hdr->addr1))
+		os_memcpy(hdr->addr1, hapd->own_addr, ETH_ALEN);
+	if (!is_broadcast_ether_addr(hdr->addr3))
+		os_memcpy(hdr->addr3, hapd->own_addr, ETH_ALEN);
+	hdr->addr2[3] ^= round >> 16;
+	hdr->addr2[4] ^= round >> 8;
+	hdr->addr2[5] ^= round;
+
+	os_get_reltime(&start);
+	if (type == MGMT_REPLAY_EAPOL) {
+		ieee802_1x_receive(hapd, hdr->addr2, buf + eapol, len - eapol,
+				   FRAME_NOT_ENCRYPTED);
+	} else {
+		os_memset(&event, 0, sizeof(event));
+		event.rx_mgmt.freq = hapd->iface->freq;
+		event.rx_mgmt.frame = buf;
+		event.rx_mgmt.frame_len = len;
+		wpa_supplicant_event(hapd, EVENT_RX_MGMT, &event);
+	}
+	mgmt_replay_record(&lat[type], &start);
+
+	os_free(buf);
+	return 0;
+}
+
+
+/**
+ * hostapd_mgmt_replay - Replay frames from a pcap file and report the cost
+ * @hapd: Pointer to BSS data
+ * @cmd: <pcap file> [loops=<count>] [vary_sa=<0/1>]
+ * @buf: Buffer for the results
+ * @buflen: Length of the buffer
+ * Returns: Number of bytes written to the buffer or -1 on failure
+ *
+ * This is used for the MGMT_REPLAY control interface command. With vary_sa=1,
+ * the source address is modified for each loop so that each loop appears to
+ * come from a different set of stations.
+ */
+int hostapd_mgmt_replay(struct hostapd_data *hapd, const char *cmd,
+			char *buf, size_t buflen)
+{
+	struct mgmt_replay_latency lat[NUM_MGMT_REPLAY_TYPES];
+	struct mgmt_replay_iter iter;
+	struct os_reltime start, now, diff;
+	char *fname, *data, *pos, *end;
+	const char *param;
+	const u8 *frame;
+	size_t len, frame_len;
+	unsigned int loops = 1, i, frames = 0, skipped = 0;
+	unsigned int ext_mgmt_frame_handling;
+	bool vary_sa = false;
+	u64 usec;
+#ifdef WPA_TRACE
+	unsigned long allocs;
+#endif /* WPA_TRACE */
+	int res, ret = -1;
+
+	fname = os_strdup(cmd);
+	if (!fname)
+		return -1;
+	pos = os_strchr(fname, ' ');
+	if (pos)
+		*pos = '\0';
+
+	param = os_strstr(cmd, " loops=");
+	if (param) {
+		loops = atoi(param + 7);
+		if (loops < 1 || loops > 0xffffff) {
+			os_free(fname);
+			return -1;
+		}
+	}
+	param = os_strstr(cmd, " vary_sa=");
+	if (param)
+		vary_sa = atoi(param + 9);
+
+	data = os_readfile(fname, &len);
+	if (!data) {
+		wpa_printf(MSG_INFO, "MGMT_REPLAY: Could not read '%s'", fname);
+		os_free(fname);
+		return -1;
+	}
+	os_free(fname);
+	if (mgmt_replay_iter_init(&iter, (const u8 *) data, len) < 0) {
+		wpa_printf(MSG_INFO, "MGMT_REPLAY: Unsupported file format");
+		os_free(data);
+		return -1;
+	}
+
+	os_memset(lat, 0, sizeof(lat));
+	ext_mgmt_frame_handling = hapd->ext_mgmt_frame_handling;
+	hapd->ext_mgmt_frame_handling = 0;
+#ifdef WPA_TRACE
+	allocs = os_alloc_count();
+#endif /* WPA_TRACE */
+	os_get_reltime(&start);
+
+	for (i = 0; i < loops; i++) {
+		mgmt_replay_iter_init(&iter, (const u8 *) data, len);
+		while ((res = mgmt_replay_iter_next(&iter, &frame,
+						    &frame_len)) > 0) {
+			if (frame &&
+			    mgmt_replay_process(hapd, frame, frame_len,
+						vary_sa ? i : 0, lat) == 0)
+				frames++;
+			else
+				skipped++;
+		}
+		if (res < 0) {
+			wpa_printf(MSG_INFO,
+				   "MGMT_REPLAY: Truncated pcap file");
+			goto fail;
+		}
+	}
+
+	os_get_reltime(&now);
+	os_reltime_sub(&now, &start, &diff);
+	usec = (u64) diff.sec * 1000000 + diff.usec;
+
+	pos = buf;
+	end = buf + buflen;
+	res = os_snprintf(pos, end - pos,
+			  "frames=%u\n"
+			  "skipped=%u\n"
+			  "duration_usec=%llu\n"
+			  "frames_per_sec=%llu\n"
+			  "num_sta=%d\n",
+			  frames, skipped, (unsigned long long) usec,
+			  usec ? (unsigned long long) frames * 1000000 / usec :
+			  0ULL, hapd->num_sta);
+	if (os_snprintf_error(end - pos, res))
+		goto fail;
+	pos += res;
+
+#ifdef WPA_TRACE
+	allocs = os_alloc_count() - allocs;
+	res = os_snprintf(pos, end - pos, "allocs=%lu\nallocs_per_frame=%lu\n",
+			  allocs, frames ? allocs / frames : 0);
+	if (os_snprintf_error(end - pos, res))
+		goto fail;
+	pos += res;
+#endif /* WPA_TRACE */
+
+	for (i = 0; i < NUM_MGMT_REPLAY_TYPES; i++) {
+		if (!lat[i].count)
+			continue;
+		qsort(lat[i].usec, lat[i].count, sizeof(unsigned int),
+		      mgmt_replay_cmp);
+		res = os_snprintf(pos, end - pos,
+				  "%s count=%zu p50_usec=%u p90_usec=%u p99_usec=%u max_usec=%u\n",
+				  mgmt_replay_type_names[i], lat[i].count,
+				  mgmt_replay_percentile(&lat[i], 50),
+				  mgmt_replay_percentile(&lat[i], 90),
+				  mgmt_replay_percentile(&lat[i], 99),
+				  lat[i].usec[lat[i].count - 1]);
+		if (os_snprintf_error(end - pos, res))
+			goto fail;
+		pos += res;
+	}
+	ret = pos - buf;
+
+fail:
+	hapd->ext_mgmt_frame_handling = ext_mgmt_frame_handling;
+	for (i = 0; i < NUM_MGMT_REPLAY_TYPES; i++)
+		os_free(lat[i].usec);
+	os_free(data);
+	return ret;
+}
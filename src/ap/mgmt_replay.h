@@ -0,0 +1,27 @@
+/*
+ * hostapd / Replay of recorded frames for performance measurements
+ *
+ * This software may be distributed under the terms of the BSD license.
+ * See README for more details.
+ */
+
+#ifndef MGMT_REPLAY_H
+#define MGMT_REPLAY_H
+
+struct hostapd_data;
+
+struct mgmt_replay_iter {
+	const u8 *pos;
+	const u8 *end;
+	u32 linktype;
+	bool swapped; /* pcap file written with the other byte order */
+};
+
+int mgmt_replay_iter_init(struct mgmt_replay_iter *iter, const u8 *data,
+			  size_t len);
+int mgmt_replay_iter_next(struct mgmt_replay_iter *iter, const u8 **frame,
+			  size_t *frame_len);
+int hostapd_mgmt_replay(struct hostapd_data *hapd, const char *cmd,
+			char *buf, size_t buflen);
+
+#endif /* MGMT_REPLAY_H */
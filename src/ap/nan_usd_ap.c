@@ -192,6 +192,14 @@ void hostapd_nan_usd_flush(struct hostapd_data *hapd)
 }
 
 
+int hostapd_nan_usd_stats(struct hostapd_data *hapd, char *buf, size_t buflen)
+{
+	if (!hapd->nan_de)
+		return -1;
+	return nan_de_stats(hapd->nan_de, buf, buflen);
+}
+
+
 int hostapd_nan_usd_publish(struct hostapd_data *hapd, const char *service_name,
 			    enum nan_service_protocol_type srv_proto_type,
 			    const struct wpabuf *ssi,
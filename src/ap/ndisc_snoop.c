@@ -22,6 +22,8 @@
 struct ip6addr {
 	struct in6_addr addr;
 	struct dl_list list;
+	struct ip6addr *hnext; /* next entry in hapd->ip6addr_hash */
+	struct sta_info *sta;
 };
 
 struct icmpv6_ndmsg {
@@ -38,59 +40,75 @@ struct icmpv6_ndmsg {
 #define NEIGHBOR_ADVERTISEMENT	136
 #define SOURCE_LL_ADDR		1
 
-static int sta_ip6addr_add(struct sta_info *sta, struct in6_addr *addr)
+static unsigned int ip6addr_hash(const struct in6_addr *addr)
 {
-	struct ip6addr *ip6addr;
+	u32 val;
 
-	ip6addr = os_zalloc(sizeof(*ip6addr));
-	if (!ip6addr)
-		return -1;
+	/* Fibonacci hashing of the folded address */
+	val = addr->s6_addr32[0] ^ addr->s6_addr32[1] ^ addr->s6_addr32[2] ^
+		addr->s6_addr32[3];
+	return (val * 0x9e3779b1U) >> 24 & (STA_HASH_SIZE - 1);
+}
 
-	os_memcpy(&ip6addr->addr, addr, sizeof(*addr));
 
-	dl_list_add_tail(&sta->ip6addr, &ip6addr->list);
+static struct ip6addr * ip6addr_get(struct hostapd_data *hapd,
+				    const struct in6_addr *addr)
+{
+	struct ip6addr *ip6addr;
 
-	return 0;
+	ip6addr = hapd->ip6addr_hash[ip6addr_hash(addr)];
+	while (ip6addr && os_memcmp(&ip6addr->addr, addr, sizeof(*addr)) != 0)
+		ip6addr = ip6addr->hnext;
+	return ip6addr;
 }
 
 
-void sta_ip6addr_del(struct hostapd_data *hapd, struct sta_info *sta)
+static void ip6addr_free(struct hostapd_data *hapd, struct ip6addr *ip6addr)
 {
-	struct ip6addr *ip6addr, *prev;
+	struct ip6addr **pos;
 
-	dl_list_for_each_safe(ip6addr, prev, &sta->ip6addr, struct ip6addr,
-			      list) {
-		hostapd_drv_br_delete_ip_neigh(hapd, 6, (u8 *) &ip6addr->addr);
-		dl_list_del(&ip6addr->list);
-		os_free(ip6addr);
+	for (pos = &hapd->ip6addr_hash[ip6addr_hash(&ip6addr->addr)]; *pos;
+	     pos = &(*pos)->hnext) {
+		if (*pos == ip6addr) {
+			*pos = ip6addr->hnext;
+			break;
+		}
 	}
+	dl_list_del(&ip6addr->list);
+	os_free(ip6addr);
 }
 
 
-static int sta_has_ip6addr(struct sta_info *sta, struct in6_addr *addr)
+static int sta_ip6addr_add(struct hostapd_data *hapd, struct sta_info *sta,
+			   struct in6_addr *addr)
 {
 	struct ip6addr *ip6addr;
+	unsigned int idx;
 
-	dl_list_for_each(ip6addr, &sta->ip6addr, struct ip6addr, list) {
-		if (ip6addr->addr.s6_addr32[0] == addr->s6_addr32[0] &&
-		    ip6addr->addr.s6_addr32[1] == addr->s6_addr32[1] &&
-		    ip6addr->addr.s6_addr32[2] == addr->s6_addr32[2] &&
-		    ip6addr->addr.s6_addr32[3] == addr->s6_addr32[3])
-			return 1;
-	}
+	ip6addr = os_zalloc(sizeof(*ip6addr));
+	if (!ip6addr)
+		return -1;
+
+	os_memcpy(&ip6addr->addr, addr, sizeof(*addr));
+	ip6addr->sta = sta;
+
+	dl_list_add_tail(&sta->ip6addr, &ip6addr->list);
+	idx = ip6addr_hash(addr);
+	ip6addr->hnext = hapd->ip6addr_hash[idx];
+	hapd->ip6addr_hash[idx] = ip6addr;
 
 	return 0;
 }
 
 
-static void ucast_to_stas(struct hostapd_data *hapd, const u8 *buf, size_t len)
+void sta_ip6addr_del(struct hostapd_data *hapd, struct sta_info *sta)
 {
-	struct sta_info *sta;
+	struct ip6addr *ip6addr, *prev;
 
-	for (sta = hapd->sta_list; sta; sta = sta->next) {
-		if (!(sta->flags & WLAN_STA_AUTHORIZED))
-			continue;
-		x_snoop_mcast_to_ucast_convert_send(hapd, sta, (u8 *) buf, len);
+	dl_list_for_each_safe(ip6addr, prev, &sta->ip6addr, struct ip6addr,
+			      list) {
+		hostapd_drv_br_delete_ip_neigh(hapd, 6, (u8 *) &ip6addr->addr);
+		ip6addr_free(hapd, ip6addr);
 	}
 }
 
@@ -102,6 +120,7 @@ static void handle_ndisc(void *ctx, const u8 *src_addr, const u8 *buf,
 	struct icmpv6_ndmsg *msg;
 	struct in6_addr saddr;
 	struct sta_info *sta;
+	struct ip6addr *ip6addr;
 	int res;
 	char addrtxt[INET6_ADDRSTRLEN + 1];
 
@@ -128,12 +147,22 @@ static void handle_ndisc(void *ctx, const u8 *src_addr, const u8 *buf,
 			if (!sta)
 				return;
 
-			if (sta_has_ip6addr(sta, &saddr))
+			ip6addr = ip6addr_get(hapd, &saddr);
+			if (ip6addr && ip6addr->sta == sta)
 				return;
 
 			if (inet_ntop(AF_INET6, &saddr, addrtxt,
 				      sizeof(addrtxt)) == NULL)
 				addrtxt[0] = '\0';
+			if (ip6addr) {
+				/* Do not remove the new ip neigh entry when
+				 * the previous STA leaves */
+				wpa_printf(MSG_DEBUG,
+					   "ndisc_snoop: IPv6 address %s moved from "
+					   MACSTR, addrtxt,
+					   MAC2STR(ip6addr->sta->addr));
+				ip6addr_free(hapd, ip6addr);
+			}
 			wpa_printf(MSG_DEBUG, "ndisc_snoop: Learned new IPv6 address %s for "
 				   MACSTR, addrtxt, MAC2STR(sta->addr));
 			hostapd_drv_br_delete_ip_neigh(hapd, 6, (u8 *) &saddr);
@@ -147,19 +176,19 @@ static void handle_ndisc(void *ctx, const u8 *src_addr, const u8 *buf,
 				return;
 			}
 
-			if (sta_ip6addr_add(sta, &saddr))
+			if (sta_ip6addr_add(hapd, sta, &saddr))
 				return;
 		}
 		break;
 #ifdef CONFIG_HS20
 	case ROUTER_ADVERTISEMENT:
 		if (hapd->conf->disable_dgaf)
-			ucast_to_stas(hapd, buf, len);
+			x_snoop_mcast_to_ucast_fan_out(hapd, buf, len);
 		break;
 #endif /* CONFIG_HS20 */
 	case NEIGHBOR_ADVERTISEMENT:
 		if (hapd->conf->na_mcast_to_ucast)
-			ucast_to_stas(hapd, buf, len);
+			x_snoop_mcast_to_ucast_fan_out(hapd, buf, len);
 		break;
 	default:
 		break;
@@ -16,14 +16,127 @@
 #include "neighbor_db.h"
 
 
+static unsigned int hostapd_neighbor_hash_bssid(const u8 *bssid)
+{
+	unsigned int i, hash = 0;
+
+	for (i = 0; i < ETH_ALEN; i++)
+		hash = hash * 31 + bssid[i];
+
+	return (hash ^ (hash >> 8)) & (NR_DB_HASH_SIZE - 1);
+}
+
+
+static unsigned int hostapd_neighbor_hash_ssid(u32 short_ssid)
+{
+	return (short_ssid ^ (short_ssid >> 16)) & (NR_DB_HASH_SIZE - 1);
+}
+
+
+void hostapd_neighbor_db_init(struct hostapd_data *hapd)
+{
+	unsigned int i;
+
+	dl_list_init(&hapd->nr_db);
+	for (i = 0; i < NR_DB_HASH_SIZE; i++) {
+		dl_list_init(&hapd->nr_db_hash_bssid[i]);
+		dl_list_init(&hapd->nr_db_hash_ssid[i]);
+	}
+	dl_list_init(&hapd->nr_db_cache);
+}
+
+
+/**
+ * hostapd_neighbor_ssid_list - Get the neighbor DB hash chain for an SSID
+ * @hapd: Pointer to BSS data
+ * @ssid: SSID
+ * Returns: List of struct hostapd_neighbor_entry linked through hash_ssid
+ *
+ * The list contains all entries for the SSID in the order of hapd->nr_db,
+ * but it may also contain entries for other SSIDs.
+ */
+struct dl_list * hostapd_neighbor_ssid_list(struct hostapd_data *hapd,
+					    const struct wpa_ssid_value *ssid)
+{
+	u32 short_ssid = ieee80211_crc32(ssid->ssid, ssid->ssid_len);
+
+	return &hapd->nr_db_hash_ssid[hostapd_neighbor_hash_ssid(short_ssid)];
+}
+
+
+static void hostapd_neighbor_cache_flush(struct hostapd_data *hapd)
+{
+	struct hostapd_neighbor_report_cache *c, *tmp;
+
+	dl_list_for_each_safe(c, tmp, &hapd->nr_db_cache,
+			      struct hostapd_neighbor_report_cache, list) {
+		dl_list_del(&c->list);
+		wpabuf_free(c->elems);
+		os_free(c);
+	}
+}
+
+
+/**
+ * hostapd_neighbor_cache_get - Get prebuilt Neighbor Report elements
+ * @hapd: Pointer to BSS data
+ * @ssid: SSID of the reported neighbors
+ * Returns: Neighbor Report elements or %NULL if not cached
+ */
+struct wpabuf * hostapd_neighbor_cache_get(struct hostapd_data *hapd,
+					   const struct wpa_ssid_value *ssid)
+{
+	struct hostapd_neighbor_report_cache *c;
+
+	dl_list_for_each(c, &hapd->nr_db_cache,
+			 struct hostapd_neighbor_report_cache, list) {
+		if (c->ssid.ssid_len == ssid->ssid_len &&
+		    os_memcmp(c->ssid.ssid, ssid->ssid, ssid->ssid_len) == 0)
+			return c->elems;
+	}
+
+	return NULL;
+}
+
+
+/**
+ * hostapd_neighbor_cache_add - Store prebuilt Neighbor Report elements
+ * @hapd: Pointer to BSS data
+ * @ssid: SSID of the reported neighbors
+ * @elems: Neighbor Report elements; the cache takes ownership of the buffer
+ * Returns: 0 on success, -1 on failure (@elems is freed)
+ *
+ * The cached elements are dropped whenever the neighbor DB changes.
+ */
+int hostapd_neighbor_cache_add(struct hostapd_data *hapd,
+			       const struct wpa_ssid_value *ssid,
+			       struct wpabuf *elems)
+{
+	struct hostapd_neighbor_report_cache *c;
+
+	c = os_zalloc(sizeof(*c));
+	if (!c) {
+		wpabuf_free(elems);
+		return -1;
+	}
+
+	os_memcpy(&c->ssid, ssid, sizeof(c->ssid));
+	c->elems = elems;
+	dl_list_add(&hapd->nr_db_cache, &c->list);
+
+	return 0;
+}
+
+
 struct hostapd_neighbor_entry *
 hostapd_neighbor_get(struct hostapd_data *hapd, const u8 *bssid,
 		     const struct wpa_ssid_value *ssid)
 {
 	struct hostapd_neighbor_entry *nr;
 
-	dl_list_for_each(nr, &hapd->nr_db, struct hostapd_neighbor_entry,
-			 list) {
+	dl_list_for_each(nr,
+			 &hapd->nr_db_hash_bssid[hostapd_neighbor_hash_bssid(bssid)],
+			 struct hostapd_neighbor_entry, hash_bssid) {
 		if (ether_addr_equal(bssid, nr->bssid) &&
 		    (!ssid ||
 		     (ssid->ssid_len == nr->ssid.ssid_len &&
@@ -107,15 +220,23 @@ static void hostapd_neighbor_clear_entry(struct hostapd_neighbor_entry *nr)
 
 
 static struct hostapd_neighbor_entry *
-hostapd_neighbor_add(struct hostapd_data *hapd)
+hostapd_neighbor_add(struct hostapd_data *hapd, const u8 *bssid,
+		     const struct wpa_ssid_value *ssid)
 {
 	struct hostapd_neighbor_entry *nr;
+	u32 short_ssid = ieee80211_crc32(ssid->ssid, ssid->ssid_len);
 
 	nr = os_zalloc(sizeof(struct hostapd_neighbor_entry));
 	if (!nr)
 		return NULL;
 
 	dl_list_add(&hapd->nr_db, &nr->list);
+	/* The BSSID and SSID of an entry do not change after this */
+	dl_list_add(&hapd->nr_db_hash_bssid[hostapd_neighbor_hash_bssid(bssid)],
+		    &nr->hash_bssid);
+	dl_list_add(&hapd->nr_db_hash_ssid[hostapd_neighbor_hash_ssid(
+							   short_ssid)],
+		    &nr->hash_ssid);
 
 	return nr;
 }
@@ -129,9 +250,11 @@ int hostapd_neighbor_set(struct hostapd_data *hapd, const u8 *bssid,
 {
 	struct hostapd_neighbor_entry *entry;
 
+	hostapd_neighbor_cache_flush(hapd);
+
 	entry = hostapd_neighbor_get(hapd, bssid, ssid);
 	if (!entry)
-		entry = hostapd_neighbor_add(hapd);
+		entry = hostapd_neighbor_add(hapd, bssid, ssid);
 	if (!entry)
 		return -1;
 
@@ -172,6 +295,8 @@ static void hostapd_neighbor_free(struct hostapd_neighbor_entry *nr)
 {
 	hostapd_neighbor_clear_entry(nr);
 	dl_list_del(&nr->list);
+	dl_list_del(&nr->hash_bssid);
+	dl_list_del(&nr->hash_ssid);
 	os_free(nr);
 }
 
@@ -185,6 +310,7 @@ int hostapd_neighbor_remove(struct hostapd_data *hapd, const u8 *bssid,
 	if (!nr)
 		return -1;
 
+	hostapd_neighbor_cache_flush(hapd);
 	hostapd_neighbor_free(nr);
 
 	return 0;
@@ -195,6 +321,7 @@ void hostapd_free_neighbor_db(struct hostapd_data *hapd)
 {
 	struct hostapd_neighbor_entry *nr, *prev;
 
+	hostapd_neighbor_cache_flush(hapd);
 	dl_list_for_each_safe(nr, prev, &hapd->nr_db,
 			      struct hostapd_neighbor_entry, list) {
 		hostapd_neighbor_free(nr);
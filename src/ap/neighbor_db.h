@@ -10,6 +10,7 @@
 #ifndef NEIGHBOR_DB_H
 #define NEIGHBOR_DB_H
 
+void hostapd_neighbor_db_init(struct hostapd_data *hapd);
 struct hostapd_neighbor_entry *
 hostapd_neighbor_get(struct hostapd_data *hapd, const u8 *bssid,
 		     const struct wpa_ssid_value *ssid);
@@ -24,5 +25,12 @@ int hostapd_neighbor_sync_own_report(struct hostapd_data *hapd);
 int hostapd_neighbor_remove(struct hostapd_data *hapd, const u8 *bssid,
 			    const struct wpa_ssid_value *ssid);
 void hostapd_free_neighbor_db(struct hostapd_data *hapd);
+struct dl_list * hostapd_neighbor_ssid_list(struct hostapd_data *hapd,
+					    const struct wpa_ssid_value *ssid);
+struct wpabuf * hostapd_neighbor_cache_get(struct hostapd_data *hapd,
+					   const struct wpa_ssid_value *ssid);
+int hostapd_neighbor_cache_add(struct hostapd_data *hapd,
+			       const struct wpa_ssid_value *ssid,
+			       struct wpabuf *elems);
 
 #endif /* NEIGHBOR_DB_H */
@@ -10,6 +10,7 @@
 
 #include "utils/common.h"
 #include "utils/eloop.h"
+#include "utils/memstat.h"
 #include "eapol_auth/eapol_auth_sm.h"
 #include "eapol_auth/eapol_auth_sm_i.h"
 #include "radius/radius_das.h"
@@ -18,17 +19,26 @@
 #include "pmksa_cache_auth.h"
 
 
-static const int pmksa_cache_max_entries = 1024;
+static const unsigned int pmksa_cache_max_entries = 1024;
 static const int dot11RSNAConfigPMKLifetime = 43200;
 
+/* Minimum number of hash buckets and number of entries per bucket at full
+ * cache */
+#define PMKSA_HASH_MIN_SIZE 128
+#define PMKSA_HASH_LOAD 4
+
 struct rsn_pmksa_cache {
-#define PMKID_HASH_SIZE 128
-#define PMKID_HASH(pmkid) (unsigned int) ((pmkid)[0] & 0x7f)
-	struct rsn_pmksa_cache_entry *pmkid[PMKID_HASH_SIZE];
-	struct rsn_pmksa_cache_entry *pmksa;
-	int pmksa_count;
+	struct rsn_pmksa_cache_entry **pmkid; /* hash table by PMKID */
+	struct rsn_pmksa_cache_entry **spa; /* hash table by SPA */
+	unsigned int hash_mask; /* hash table size - 1 */
+	struct rsn_pmksa_cache_entry *pmksa; /* ordered by expiration */
+	struct rsn_pmksa_cache_entry *pmksa_tail;
+	struct dl_list lru; /* least recently used entry first */
+	unsigned int pmksa_count;
+	unsigned int max_entries;
 
 	void (*free_cb)(struct rsn_pmksa_cache_entry *entry, void *ctx);
+	void (*add_cb)(struct rsn_pmksa_cache_entry *entry, void *ctx);
 	void *ctx;
 };
 
@@ -36,6 +46,35 @@ struct rsn_pmksa_cache {
 static void pmksa_cache_set_expiration(struct rsn_pmksa_cache *pmksa);
 
 
+static unsigned int pmksa_cache_pmkid_hash(struct rsn_pmksa_cache *pmksa,
+					   const u8 *pmkid)
+{
+	return WPA_GET_LE24(pmkid) & pmksa->hash_mask;
+}
+
+
+static unsigned int pmksa_cache_spa_hash(struct rsn_pmksa_cache *pmksa,
+					 const u8 *spa)
+{
+	return (WPA_GET_BE24(&spa[3]) ^ (spa[0] << 4)) & pmksa->hash_mask;
+}
+
+
+static void pmksa_cache_hash_link(struct rsn_pmksa_cache *pmksa,
+				  struct rsn_pmksa_cache_entry *entry)
+{
+	unsigned int hash;
+
+	hash = pmksa_cache_pmkid_hash(pmksa, entry->pmkid);
+	entry->hnext = pmksa->pmkid[hash];
+	pmksa->pmkid[hash] = entry;
+
+	hash = pmksa_cache_spa_hash(pmksa, entry->spa);
+	entry->snext = pmksa->spa[hash];
+	pmksa->spa[hash] = entry;
+}
+
+
 static void _pmksa_cache_free_entry(struct rsn_pmksa_cache_entry *entry)
 {
 	os_free(entry->vlan_desc);
@@ -52,44 +91,38 @@ static void _pmksa_cache_free_entry(struct rsn_pmksa_cache_entry *entry)
 void pmksa_cache_free_entry(struct rsn_pmksa_cache *pmksa,
 			    struct rsn_pmksa_cache_entry *entry)
 {
-	struct rsn_pmksa_cache_entry *pos, *prev;
-	unsigned int hash;
+	struct rsn_pmksa_cache_entry **pos;
 
 	pmksa->pmksa_count--;
+	memstat_free(MEMSTAT_PMKSA, sizeof(*entry));
 
 	if (pmksa->free_cb)
 		pmksa->free_cb(entry, pmksa->ctx);
 
-	/* unlink from hash list */
-	hash = PMKID_HASH(entry->pmkid);
-	pos = pmksa->pmkid[hash];
-	prev = NULL;
-	while (pos) {
-		if (pos == entry) {
-			if (prev != NULL)
-				prev->hnext = entry->hnext;
-			else
-				pmksa->pmkid[hash] = entry->hnext;
-			break;
-		}
-		prev = pos;
-		pos = pos->hnext;
-	}
+	/* unlink from hash lists */
+	pos = &pmksa->pmkid[pmksa_cache_pmkid_hash(pmksa, entry->pmkid)];
+	while (*pos && *pos != entry)
+		pos = &(*pos)->hnext;
+	if (*pos)
+		*pos = entry->hnext;
+
+	pos = &pmksa->spa[pmksa_cache_spa_hash(pmksa, entry->spa)];
+	while (*pos && *pos != entry)
+		pos = &(*pos)->snext;
+	if (*pos)
+		*pos = entry->snext;
 
 	/* unlink from entry list */
-	pos = pmksa->pmksa;
-	prev = NULL;
-	while (pos) {
-		if (pos == entry) {
-			if (prev != NULL)
-				prev->next = entry->next;
-			else
-				pmksa->pmksa = entry->next;
-			break;
-		}
-		prev = pos;
-		pos = pos->next;
-	}
+	if (entry->prev)
+		entry->prev->next = entry->next;
+	else
+		pmksa->pmksa = entry->next;
+	if (entry->next)
+		entry->next->prev = entry->prev;
+	else
+		pmksa->pmksa_tail = entry->prev;
+
+	dl_list_del(&entry->lru);
 
 	_pmksa_cache_free_entry(entry);
 }
@@ -222,21 +255,37 @@ void pmksa_cache_to_eapol_data(struct hostapd_data *hapd,
 }
 
 
-static void pmksa_cache_link_entry(struct rsn_pmksa_cache *pmksa,
-				   struct rsn_pmksa_cache_entry *entry)
+static void pmksa_cache_make_room(struct rsn_pmksa_cache *pmksa)
 {
-	struct rsn_pmksa_cache_entry *pos, *prev;
-	int hash;
-
-	/* Add the new entry; order by expiration time */
-	pos = pmksa->pmksa;
-	prev = NULL;
-	while (pos) {
-		if (pos->expiration > entry->expiration)
+	struct rsn_pmksa_cache_entry *entry;
+
+	while (pmksa->pmksa_count >= pmksa->max_entries) {
+		/* Remove the least recently used entry to make room for the
+		 * new entry */
+		entry = dl_list_first(&pmksa->lru, struct rsn_pmksa_cache_entry,
+				      lru);
+		if (!entry)
 			break;
-		prev = pos;
-		pos = pos->next;
+		wpa_printf(MSG_DEBUG, "RSN: removed the least recently used "
+			   "PMKSA cache entry (for " MACSTR
+			   ") to make room for new one",
+			   MAC2STR(entry->spa));
+		pmksa_cache_free_entry(pmksa, entry);
 	}
+}
+
+
+static void pmksa_cache_link_entry(struct rsn_pmksa_cache *pmksa,
+				   struct rsn_pmksa_cache_entry *entry)
+{
+	struct rsn_pmksa_cache_entry *prev;
+
+	/* Add the new entry; order by expiration time. New entries normally
+	 * expire last, so search for the position from the end of the list. */
+	prev = pmksa->pmksa_tail;
+	while (prev && prev->expiration > entry->expiration)
+		prev = prev->prev;
+	entry->prev = prev;
 	if (prev == NULL) {
 		entry->next = pmksa->pmksa;
 		pmksa->pmksa = entry;
@@ -244,12 +293,16 @@ static void pmksa_cache_link_entry(struct rsn_pmksa_cache *pmksa,
 		entry->next = prev->next;
 		prev->next = entry;
 	}
+	if (entry->next)
+		entry->next->prev = entry;
+	else
+		pmksa->pmksa_tail = entry;
 
-	hash = PMKID_HASH(entry->pmkid);
-	entry->hnext = pmksa->pmkid[hash];
-	pmksa->pmkid[hash] = entry;
+	pmksa_cache_hash_link(pmksa, entry);
+	dl_list_add_tail(&pmksa->lru, &entry->lru);
 
 	pmksa->pmksa_count++;
+	memstat_alloc(MEMSTAT_PMKSA, sizeof(*entry));
 	if (prev == NULL)
 		pmksa_cache_set_expiration(pmksa);
 	wpa_printf(MSG_DEBUG, "RSN: added PMKSA cache entry for " MACSTR,
@@ -383,14 +436,48 @@ int pmksa_cache_auth_add_entry(struct rsn_pmksa_cache *pmksa,
 	if (pos)
 		pmksa_cache_free_entry(pmksa, pos);
 
-	if (pmksa->pmksa_count >= pmksa_cache_max_entries && pmksa->pmksa) {
-		/* Remove the oldest entry to make room for the new entry */
-		wpa_printf(MSG_DEBUG, "RSN: removed the oldest PMKSA cache "
-			   "entry (for " MACSTR ") to make room for new one",
-			   MAC2STR(pmksa->pmksa->spa));
-		pmksa_cache_free_entry(pmksa, pmksa->pmksa);
+	pmksa_cache_make_room(pmksa);
+	pmksa_cache_link_entry(pmksa, entry);
+
+	if (pmksa->add_cb)
+		pmksa->add_cb(entry, pmksa->ctx);
+
+	return 0;
+}
+
+
+/**
+ * pmksa_cache_auth_add_remote - Add a PMKSA cache entry from another AP
+ * @pmksa: Pointer to PMKSA cache data from pmksa_cache_auth_init()
+ * @entry: Pointer to PMKSA cache entry from pmksa_cache_auth_create_entry()
+ * Returns: 0 on success, -1 on failure
+ *
+ * This function adds a PMKSA cache entry that was created by another
+ * authenticator. Unlike pmksa_cache_auth_add_entry(), this does not replace
+ * a locally created entry for the same Supplicant since the Supplicant may
+ * still use that one; only older opportunistic entries for the Supplicant are
+ * removed. The entry is marked opportunistic and the add callback is not
+ * called for it.
+ */
+int pmksa_cache_auth_add_remote(struct rsn_pmksa_cache *pmksa,
+				struct rsn_pmksa_cache_entry *entry)
+{
+	struct rsn_pmksa_cache_entry *pos, *next;
+
+	if (!entry)
+		return -1;
+
+	for (pos = pmksa->spa[pmksa_cache_spa_hash(pmksa, entry->spa)]; pos;
+	     pos = next) {
+		next = pos->snext;
+		if (pos->opportunistic &&
+		    ether_addr_equal(pos->spa, entry->spa))
+			pmksa_cache_free_entry(pmksa, pos);
 	}
 
+	pmksa_cache_make_room(pmksa);
+
+	entry->opportunistic = 1;
 	pmksa_cache_link_entry(pmksa, entry);
 
 	return 0;
@@ -450,7 +537,6 @@ pmksa_cache_add_okc(struct rsn_pmksa_cache *pmksa,
 void pmksa_cache_auth_deinit(struct rsn_pmksa_cache *pmksa)
 {
 	struct rsn_pmksa_cache_entry *entry, *prev;
-	int i;
 
 	if (pmksa == NULL)
 		return;
@@ -459,17 +545,26 @@ void pmksa_cache_auth_deinit(struct rsn_pmksa_cache *pmksa)
 	while (entry) {
 		prev = entry;
 		entry = entry->next;
+		memstat_free(MEMSTAT_PMKSA, sizeof(*prev));
 		_pmksa_cache_free_entry(prev);
 	}
 	eloop_cancel_timeout(pmksa_cache_expire, pmksa, NULL);
 	pmksa->pmksa_count = 0;
 	pmksa->pmksa = NULL;
-	for (i = 0; i < PMKID_HASH_SIZE; i++)
-		pmksa->pmkid[i] = NULL;
+	os_free(pmksa->pmkid);
+	os_free(pmksa->spa);
 	os_free(pmksa);
 }
 
 
+static void pmksa_cache_touch(struct rsn_pmksa_cache *pmksa,
+			      struct rsn_pmksa_cache_entry *entry)
+{
+	dl_list_del(&entry->lru);
+	dl_list_add_tail(&pmksa->lru, &entry->lru);
+}
+
+
 /**
  * pmksa_cache_auth_get - Fetch a PMKSA cache entry
  * @pmksa: Pointer to PMKSA cache data from pmksa_cache_auth_init()
@@ -484,22 +579,27 @@ pmksa_cache_auth_get(struct rsn_pmksa_cache *pmksa,
 	struct rsn_pmksa_cache_entry *entry;
 
 	if (pmkid) {
-		for (entry = pmksa->pmkid[PMKID_HASH(pmkid)]; entry;
-		     entry = entry->hnext) {
+		for (entry = pmksa->pmkid[pmksa_cache_pmkid_hash(pmksa, pmkid)];
+		     entry; entry = entry->hnext) {
 			if ((spa == NULL ||
 			     ether_addr_equal(entry->spa, spa)) &&
 			    os_memcmp(entry->pmkid, pmkid, PMKID_LEN) == 0)
-				return entry;
+				break;
 		}
-	} else {
-		for (entry = pmksa->pmksa; entry; entry = entry->next) {
-			if (spa == NULL ||
-			    ether_addr_equal(entry->spa, spa))
-				return entry;
+	} else if (spa) {
+		for (entry = pmksa->spa[pmksa_cache_spa_hash(pmksa, spa)];
+		     entry; entry = entry->snext) {
+			if (ether_addr_equal(entry->spa, spa))
+				break;
 		}
+	} else {
+		entry = pmksa->pmksa;
 	}
 
-	return NULL;
+	if (entry)
+		pmksa_cache_touch(pmksa, entry);
+
+	return entry;
 }
 
 
@@ -520,13 +620,14 @@ struct rsn_pmksa_cache_entry * pmksa_cache_get_okc(
 	struct rsn_pmksa_cache_entry *entry;
 	u8 new_pmkid[PMKID_LEN];
 
-	for (entry = pmksa->pmksa; entry; entry = entry->next) {
+	for (entry = pmksa->spa[pmksa_cache_spa_hash(pmksa, spa)]; entry;
+	     entry = entry->snext) {
 		if (!ether_addr_equal(entry->spa, spa))
 			continue;
 		if (wpa_key_mgmt_sae(entry->akmp) ||
 		    wpa_key_mgmt_fils(entry->akmp)) {
 			if (os_memcmp(entry->pmkid, pmkid, PMKID_LEN) == 0)
-				return entry;
+				break;
 			continue;
 		}
 		if (entry->akmp == WPA_KEY_MGMT_IEEE8021X_SUITE_B_192 &&
@@ -541,9 +642,13 @@ struct rsn_pmksa_cache_entry * pmksa_cache_get_okc(
 			rsn_pmkid(entry->pmk, entry->pmk_len, aa, spa,
 				  new_pmkid, entry->akmp);
 		if (os_memcmp(new_pmkid, pmkid, PMKID_LEN) == 0)
-			return entry;
+			break;
 	}
-	return NULL;
+
+	if (entry)
+		pmksa_cache_touch(pmksa, entry);
+
+	return entry;
 }
 
 
@@ -560,15 +665,89 @@ pmksa_cache_auth_init(void (*free_cb)(struct rsn_pmksa_cache_entry *entry,
 	struct rsn_pmksa_cache *pmksa;
 
 	pmksa = os_zalloc(sizeof(*pmksa));
-	if (pmksa) {
-		pmksa->free_cb = free_cb;
-		pmksa->ctx = ctx;
+	if (!pmksa)
+		return NULL;
+	pmksa->free_cb = free_cb;
+	pmksa->ctx = ctx;
+	dl_list_init(&pmksa->lru);
+	if (pmksa_cache_auth_set_max_entries(pmksa, 0) < 0) {
+		os_free(pmksa);
+		return NULL;
 	}
 
 	return pmksa;
 }
 
 
+/**
+ * pmksa_cache_auth_set_max_entries - Set maximum number of PMKSA cache entries
+ * @pmksa: Pointer to PMKSA cache data from pmksa_cache_auth_init()
+ * @max_entries: Maximum number of entries or 0 to use the default value
+ * Returns: 0 on success, -1 on failure
+ *
+ * The hash tables are resized to keep lookups constant time for the new
+ * maximum size. If the cache has more entries than the new maximum, the least
+ * recently used entries are removed.
+ */
+int pmksa_cache_auth_set_max_entries(struct rsn_pmksa_cache *pmksa,
+				     unsigned int max_entries)
+{
+	struct rsn_pmksa_cache_entry **pmkid, **spa, *entry;
+	unsigned int size = PMKSA_HASH_MIN_SIZE;
+
+	if (!max_entries)
+		max_entries = pmksa_cache_max_entries;
+
+	while (size < max_entries / PMKSA_HASH_LOAD && size < 0x1000000)
+		size <<= 1;
+
+	if (!pmksa->pmkid || size != pmksa->hash_mask + 1) {
+		pmkid = os_calloc(size, sizeof(*pmkid));
+		spa = os_calloc(size, sizeof(*spa));
+		if (!pmkid || !spa) {
+			os_free(pmkid);
+			os_free(spa);
+			return -1;
+		}
+		os_free(pmksa->pmkid);
+		os_free(pmksa->spa);
+		pmksa->pmkid = pmkid;
+		pmksa->spa = spa;
+		pmksa->hash_mask = size - 1;
+		for (entry = pmksa->pmksa; entry; entry = entry->next)
+			pmksa_cache_hash_link(pmksa, entry);
+	}
+
+	pmksa->max_entries = max_entries;
+	while (pmksa->pmksa_count > max_entries) {
+		entry = dl_list_first(&pmksa->lru, struct rsn_pmksa_cache_entry,
+				      lru);
+		wpa_printf(MSG_DEBUG,
+			   "RSN: Remove PMKSA cache entry for " MACSTR
+			   " to reduce cache size", MAC2STR(entry->spa));
+		pmksa_cache_free_entry(pmksa, entry);
+	}
+	pmksa_cache_set_expiration(pmksa);
+
+	return 0;
+}
+
+
+/**
+ * pmksa_cache_auth_set_add_cb - Set callback for added PMKSA cache entries
+ * @pmksa: Pointer to PMKSA cache data from pmksa_cache_auth_init()
+ * @add_cb: Callback function to be called when a new PMKSA cache entry is
+ *	added with pmksa_cache_auth_add_entry(); called with the ctx pointer
+ *	given to pmksa_cache_auth_init()
+ */
+void pmksa_cache_auth_set_add_cb(struct rsn_pmksa_cache *pmksa,
+				 void (*add_cb)(struct rsn_pmksa_cache_entry *entry,
+						void *ctx))
+{
+	pmksa->add_cb = add_cb;
+}
+
+
 static int das_attr_match(struct rsn_pmksa_cache_entry *entry,
 			  struct radius_das_attrs *attr)
 {
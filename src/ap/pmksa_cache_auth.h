@@ -9,13 +9,17 @@
 #ifndef PMKSA_CACHE_H
 #define PMKSA_CACHE_H
 
+#include "utils/list.h"
 #include "radius/radius.h"
 
 /**
  * struct rsn_pmksa_cache_entry - PMKSA cache entry
  */
 struct rsn_pmksa_cache_entry {
-	struct rsn_pmksa_cache_entry *next, *hnext;
+	struct rsn_pmksa_cache_entry *next, *prev; /* ordered by expiration */
+	struct rsn_pmksa_cache_entry *hnext; /* PMKID hash */
+	struct rsn_pmksa_cache_entry *snext; /* SPA hash */
+	struct dl_list lru;
 	u8 pmkid[PMKID_LEN];
 	u8 pmk[PMK_LEN_MAX];
 	size_t pmk_len;
@@ -44,6 +48,11 @@ struct radius_das_attrs;
 struct rsn_pmksa_cache *
 pmksa_cache_auth_init(void (*free_cb)(struct rsn_pmksa_cache_entry *entry,
 				      void *ctx), void *ctx);
+void pmksa_cache_auth_set_add_cb(struct rsn_pmksa_cache *pmksa,
+				 void (*add_cb)(struct rsn_pmksa_cache_entry *entry,
+						void *ctx));
+int pmksa_cache_auth_set_max_entries(struct rsn_pmksa_cache *pmksa,
+				     unsigned int max_entries);
 void pmksa_cache_auth_deinit(struct rsn_pmksa_cache *pmksa);
 struct rsn_pmksa_cache_entry *
 pmksa_cache_auth_get(struct rsn_pmksa_cache *pmksa,
@@ -64,6 +73,8 @@ pmksa_cache_auth_create_entry(const u8 *pmk, size_t pmk_len, const u8 *pmkid,
 			      struct eapol_state_machine *eapol, int akmp);
 int pmksa_cache_auth_add_entry(struct rsn_pmksa_cache *pmksa,
 			       struct rsn_pmksa_cache_entry *entry);
+int pmksa_cache_auth_add_remote(struct rsn_pmksa_cache *pmksa,
+				struct rsn_pmksa_cache_entry *entry);
 struct rsn_pmksa_cache_entry *
 pmksa_cache_add_okc(struct rsn_pmksa_cache *pmksa,
 		    const struct rsn_pmksa_cache_entry *old_entry,
@@ -0,0 +1,369 @@
+/*
+ * hostapd - PMKSA cache synchronization between APs
+ *
+ * This software may be distributed under the terms of the BSD license.
+ * See README for more details.
+ *
+ * PMKSA cache entries created in a BSS are sent to other APs (and other
+ * hostapd processes) serving the same SSID in AES-SIV protected UDP messages.
+ * Received entries are added to the local PMKSA cache as opportunistic
+ * entries so that they can be used with exact PMKID matches (e.g., SAE, FILS)
+ * and with OKC.
+ */
+
+#include "utils/includes.h"
+
+#ifdef CONFIG_PMKSA_SYNC
+
+#include "utils/common.h"
+#include "utils/eloop.h"
+#include "crypto/aes.h"
+#include "crypto/aes_siv.h"
+#include "common/wpa_common.h"
+#include "hostapd.h"
+#include "ap_config.h"
+#include "wpa_auth.h"
+#include "pmksa_cache_auth.h"
+#include "pmksa_sync.h"
+
+#define PMKSA_SYNC_VERSION 1
+#define PMKSA_SYNC_MSG_ADD 1
+
+/*
+ * Message layout
+ *  u8 version (PMKSA_SYNC_VERSION)
+ *  u8 type (PMKSA_SYNC_MSG_*)
+ *  AES-SIV encrypted payload (AAD: version and type):
+ *   u8 ssid_len, ssid
+ *   SPA (6), AA (6), PMKID (16)
+ *   le32 akmp (WPA_KEY_MGMT_*)
+ *   le32 expiration (wall clock time in seconds)
+ *   u8 pmk_len, pmk
+ *   le16 untagged VLAN ID (0 = none)
+ *   u8 eap_type_authsrv
+ *   u8 identity_len, identity
+ */
+#define PMKSA_SYNC_HDR_LEN 2
+
+struct pmksa_sync {
+	struct hostapd_data *hapd;
+	int sock;
+	struct sockaddr_in dst;
+};
+
+
+static int pmksa_sync_parse(struct hostapd_data *hapd, const u8 *pos,
+			    size_t len)
+{
+	const u8 *end = pos + len;
+	const u8 *ssid, *spa, *aa, *pmkid, *pmk, *identity;
+	size_t ssid_len, pmk_len, identity_len;
+	int akmp, vlan_id, lifetime;
+	u8 eap_type;
+	os_time_t expiration;
+	struct os_time now;
+	struct rsn_pmksa_cache *pmksa;
+	struct rsn_pmksa_cache_entry *entry;
+
+	if (end - pos < 1)
+		return -1;
+	ssid_len = *pos++;
+	if ((size_t) (end - pos) < ssid_len + 2 * ETH_ALEN + PMKID_LEN + 8 + 1)
+		return -1;
+	ssid = pos;
+	pos += ssid_len;
+	spa = pos;
+	pos += ETH_ALEN;
+	aa = pos;
+	pos += ETH_ALEN;
+	pmkid = pos;
+	pos += PMKID_LEN;
+	akmp = WPA_GET_LE32(pos);
+	pos += 4;
+	expiration = WPA_GET_LE32(pos);
+	pos += 4;
+	pmk_len = *pos++;
+	if (pmk_len > PMK_LEN_MAX || (size_t) (end - pos) < pmk_len + 2 + 1 + 1)
+		return -1;
+	pmk = pos;
+	pos += pmk_len;
+	vlan_id = WPA_GET_LE16(pos);
+	pos += 2;
+	eap_type = *pos++;
+	identity_len = *pos++;
+	if ((size_t) (end - pos) < identity_len)
+		return -1;
+	identity = pos;
+
+	if (ssid_len != hapd->conf->ssid.ssid_len ||
+	    os_memcmp(ssid, hapd->conf->ssid.ssid, ssid_len) != 0) {
+		wpa_printf(MSG_DEBUG, "PMKSA sync: Ignore entry for SSID %s",
+			   wpa_ssid_txt(ssid, ssid_len));
+		return 0;
+	}
+
+	if (ether_addr_equal(aa, hapd->own_addr) ||
+	    hapd->conf->disable_pmksa_caching)
+		return 0;
+
+	os_get_time(&now);
+	if (expiration <= now.sec) {
+		wpa_printf(MSG_DEBUG,
+			   "PMKSA sync: Ignore expired entry for " MACSTR,
+			   MAC2STR(spa));
+		return 0;
+	}
+	lifetime = expiration - now.sec;
+
+	pmksa = wpa_auth_get_pmksa_cache(hapd->wpa_auth);
+	if (!pmksa)
+		return -1;
+
+	entry = pmksa_cache_auth_create_entry(pmk, pmk_len, pmkid, NULL, 0,
+					      aa, spa, lifetime, NULL, akmp);
+	if (!entry) {
+		wpa_printf(MSG_DEBUG,
+			   "PMKSA sync: Could not create entry for " MACSTR
+			   " (akmp=0x%x)", MAC2STR(spa), akmp);
+		return -1;
+	}
+	entry->eap_type_authsrv = eap_type;
+	if (identity_len) {
+		entry->identity = os_memdup(identity, identity_len);
+		if (entry->identity)
+			entry->identity_len = identity_len;
+	}
+	if (vlan_id) {
+		entry->vlan_desc = os_zalloc(sizeof(*entry->vlan_desc));
+		if (entry->vlan_desc) {
+			entry->vlan_desc->notempty = 1;
+			entry->vlan_desc->untagged = vlan_id;
+		}
+	}
+
+	wpa_printf(MSG_DEBUG, "PMKSA sync: Add entry for " MACSTR " from AA "
+		   MACSTR " (lifetime %d s)", MAC2STR(spa), MAC2STR(aa),
+		   lifetime);
+	return pmksa_cache_auth_add_remote(pmksa, entry);
+}
+
+
+static void pmksa_sync_receive(int sock, void *eloop_ctx, void *sock_ctx)
+{
+	struct pmksa_sync *sync = eloop_ctx;
+	struct hostapd_data *hapd = sync->hapd;
+	u8 buf[1500], plain[1500];
+	struct sockaddr_in from;
+	socklen_t fromlen = sizeof(from);
+	const u8 *ad[1];
+	size_t ad_len[1];
+	int len;
+
+	len = recvfrom(sock, buf, sizeof(buf), 0, (struct sockaddr *) &from,
+		       &fromlen);
+	if (len < 0) {
+		wpa_printf(MSG_INFO, "PMKSA sync: recvfrom failed: %s",
+			   strerror(errno));
+		return;
+	}
+
+	if (len < PMKSA_SYNC_HDR_LEN + AES_BLOCK_SIZE ||
+	    buf[0] != PMKSA_SYNC_VERSION || buf[1] != PMKSA_SYNC_MSG_ADD) {
+		wpa_printf(MSG_DEBUG,
+			   "PMKSA sync: Drop unknown %d octet message from %s",
+			   len, inet_ntoa(from.sin_addr));
+		return;
+	}
+
+	ad[0] = buf;
+	ad_len[0] = PMKSA_SYNC_HDR_LEN;
+	if (aes_siv_decrypt(hapd->conf->pmksa_sync_key,
+			    sizeof(hapd->conf->pmksa_sync_key),
+			    buf + PMKSA_SYNC_HDR_LEN, len - PMKSA_SYNC_HDR_LEN,
+			    1, ad, ad_len, plain) < 0) {
+		wpa_printf(MSG_INFO,
+			   "PMKSA sync: Failed to decrypt message from %s",
+			   inet_ntoa(from.sin_addr));
+		return;
+	}
+
+	if (pmksa_sync_parse(hapd, plain, len - PMKSA_SYNC_HDR_LEN -
+			     AES_BLOCK_SIZE) < 0)
+		wpa_printf(MSG_DEBUG,
+			   "PMKSA sync: Invalid message from %s",
+			   inet_ntoa(from.sin_addr));
+	forced_memzero(plain, sizeof(plain));
+}
+
+
+void pmksa_sync_entry_added(struct hostapd_data *hapd,
+			    struct rsn_pmksa_cache_entry *entry)
+{
+	struct pmksa_sync *sync = hapd->pmksa_sync;
+	struct hostapd_ssid *ssid = &hapd->conf->ssid;
+	struct wpabuf *plain;
+	struct os_reltime now;
+	struct os_time wall;
+	const u8 *ad[1];
+	size_t ad_len[1];
+	u8 *msg;
+	size_t identity_len;
+	int vlan_id = 0;
+
+	if (!sync || entry->opportunistic)
+		return;
+
+	identity_len = entry->identity_len <= 255 ? entry->identity_len : 0;
+	if (entry->vlan_desc && entry->vlan_desc->notempty)
+		vlan_id = entry->vlan_desc->untagged;
+
+	plain = wpabuf_alloc(1 + ssid->ssid_len + 2 * ETH_ALEN + PMKID_LEN +
+			     8 + 1 + entry->pmk_len + 2 + 1 + 1 + identity_len);
+	msg = os_malloc(PMKSA_SYNC_HDR_LEN + AES_BLOCK_SIZE +
+			(plain ? wpabuf_size(plain) : 0));
+	if (!plain || !msg)
+		goto out;
+
+	os_get_reltime(&now);
+	os_get_time(&wall);
+	wpabuf_put_u8(plain, ssid->ssid_len);
+	wpabuf_put_data(plain, ssid->ssid, ssid->ssid_len);
+	wpabuf_put_data(plain, entry->spa, ETH_ALEN);
+	wpabuf_put_data(plain, hapd->own_addr, ETH_ALEN);
+	wpabuf_put_data(plain, entry->pmkid, PMKID_LEN);
+	wpabuf_put_le32(plain, entry->akmp);
+	wpabuf_put_le32(plain, wall.sec + (entry->expiration - now.sec));
+	wpabuf_put_u8(plain, entry->pmk_len);
+	wpabuf_put_data(plain, entry->pmk, entry->pmk_len);
+	wpabuf_put_le16(plain, vlan_id);
+	wpabuf_put_u8(plain, entry->eap_type_authsrv);
+	wpabuf_put_u8(plain, identity_len);
+	wpabuf_put_data(plain, entry->identity, identity_len);
+
+	msg[0] = PMKSA_SYNC_VERSION;
+	msg[1] = PMKSA_SYNC_MSG_ADD;
+	ad[0] = msg;
+	ad_len[0] = PMKSA_SYNC_HDR_LEN;
+	if (aes_siv_encrypt(hapd->conf->pmksa_sync_key,
+			    sizeof(hapd->conf->pmksa_sync_key),
+			    wpabuf_head(plain), wpabuf_len(plain), 1, ad, ad_len,
+			    msg + PMKSA_SYNC_HDR_LEN) < 0) {
+		wpa_printf(MSG_INFO, "PMKSA sync: Failed to encrypt message");
+		goto out;
+	}
+
+	wpa_printf(MSG_DEBUG, "PMKSA sync: Send entry for " MACSTR " to %s:%d",
+		   MAC2STR(entry->spa), inet_ntoa(sync->dst.sin_addr),
+		   ntohs(sync->dst.sin_port));
+	if (sendto(sync->sock, msg, PMKSA_SYNC_HDR_LEN + AES_BLOCK_SIZE +
+		   wpabuf_len(plain), 0, (struct sockaddr *) &sync->dst,
+		   sizeof(sync->dst)) < 0)
+		wpa_printf(MSG_INFO, "PMKSA sync: sendto failed: %s",
+			   strerror(errno));
+
+out:
+	wpabuf_clear_free(plain);
+	os_free(msg);
+}
+
+
+int pmksa_sync_init(struct hostapd_data *hapd)
+{
+	struct hostapd_bss_config *conf = hapd->conf;
+	struct pmksa_sync *sync;
+	struct sockaddr_in addr;
+	int val = 1;
+
+	if (!conf->pmksa_sync_port || hapd->pmksa_sync)
+		return 0;
+
+	if (!conf->pmksa_sync_key_set ||
+	    conf->pmksa_sync_addr.af != AF_INET) {
+		wpa_printf(MSG_ERROR,
+			   "PMKSA sync: pmksa_sync_addr and pmksa_sync_key are required");
+		return -1;
+	}
+
+	sync = os_zalloc(sizeof(*sync));
+	if (!sync)
+		return -1;
+	sync->hapd = hapd;
+	sync->dst.sin_family = AF_INET;
+	sync->dst.sin_addr = conf->pmksa_sync_addr.u.v4;
+	sync->dst.sin_port = htons(conf->pmksa_sync_port);
+
+	sync->sock = socket(PF_INET, SOCK_DGRAM, 0);
+	if (sync->sock < 0) {
+		wpa_printf(MSG_ERROR, "PMKSA sync: socket: %s",
+			   strerror(errno));
+		os_free(sync);
+		return -1;
+	}
+
+	if (setsockopt(sync->sock, SOL_SOCKET, SO_REUSEADDR, &val,
+		       sizeof(val)) < 0 ||
+	    setsockopt(sync->sock, SOL_SOCKET, SO_BROADCAST, &val,
+		       sizeof(val)) < 0)
+		wpa_printf(MSG_DEBUG, "PMKSA sync: setsockopt: %s",
+			   strerror(errno));
+
+	os_memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = htonl(INADDR_ANY);
+	addr.sin_port = htons(conf->pmksa_sync_port);
+	if (bind(sync->sock, (struct sockaddr *) &addr, sizeof(addr)) < 0) {
+		wpa_printf(MSG_ERROR, "PMKSA sync: bind: %s", strerror(errno));
+		goto fail;
+	}
+
+	if (IN_MULTICAST(ntohl(sync->dst.sin_addr.s_addr))) {
+		struct ip_mreq mreq;
+		u8 loop = 0;
+
+		os_memset(&mreq, 0, sizeof(mreq));
+		mreq.imr_multiaddr = sync->dst.sin_addr;
+		mreq.imr_interface.s_addr = htonl(INADDR_ANY);
+		if (setsockopt(sync->sock, IPPROTO_IP, IP_ADD_MEMBERSHIP,
+			       &mreq, sizeof(mreq)) < 0) {
+			wpa_printf(MSG_ERROR,
+				   "PMKSA sync: IP_ADD_MEMBERSHIP: %s",
+				   strerror(errno));
+			goto fail;
+		}
+		setsockopt(sync->sock, IPPROTO_IP, IP_MULTICAST_LOOP, &loop,
+			   sizeof(loop));
+	}
+
+	if (eloop_register_read_sock(sync->sock, pmksa_sync_receive, sync,
+				     NULL)) {
+		wpa_printf(MSG_ERROR,
+			   "PMKSA sync: Could not register read socket");
+		goto fail;
+	}
+
+	wpa_printf(MSG_DEBUG, "PMKSA sync: Enabled on port %d (peer %s)",
+		   conf->pmksa_sync_port, inet_ntoa(sync->dst.sin_addr));
+	hapd->pmksa_sync = sync;
+	return 0;
+
+fail:
+	close(sync->sock);
+	os_free(sync);
+	return -1;
+}
+
+
+void pmksa_sync_deinit(struct hostapd_data *hapd)
+{
+	struct pmksa_sync *sync = hapd->pmksa_sync;
+
+	if (!sync)
+		return;
+
+	eloop_unregister_read_sock(sync->sock);
+	close(sync->sock);
+	os_free(sync);
+	hapd->pmksa_sync = NULL;
+}
+
+#endif /* CONFIG_PMKSA_SYNC */
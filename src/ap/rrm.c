@@ -196,30 +196,16 @@ static size_t hostapd_neighbor_report_len(struct wpabuf *buf,
 }
 
 
-static void hostapd_send_nei_report_resp(struct hostapd_data *hapd,
-					 const u8 *addr, u8 dialog_token,
+static void hostapd_put_nei_report_elems(struct hostapd_data *hapd,
+					 struct wpabuf *buf,
 					 struct wpa_ssid_value *ssid, u8 lci,
 					 u8 civic, u16 lci_max_age)
 {
 	struct hostapd_neighbor_entry *nr;
-	struct wpabuf *buf;
 	u8 *msmt_token;
 
-	/*
-	 * The number and length of the Neighbor Report elements in a Neighbor
-	 * Report frame is limited by the maximum allowed MMPDU size; + 3 bytes
-	 * of RRM header.
-	 */
-	buf = wpabuf_alloc(3 + IEEE80211_MAX_MMPDU_SIZE);
-	if (!buf)
-		return;
-
-	wpabuf_put_u8(buf, WLAN_ACTION_RADIO_MEASUREMENT);
-	wpabuf_put_u8(buf, WLAN_RRM_NEIGHBOR_REPORT_RESPONSE);
-	wpabuf_put_u8(buf, dialog_token);
-
-	dl_list_for_each(nr, &hapd->nr_db, struct hostapd_neighbor_entry,
-			 list) {
+	dl_list_for_each(nr, hostapd_neighbor_ssid_list(hapd, ssid),
+			 struct hostapd_neighbor_entry, hash_ssid) {
 		int send_lci;
 		size_t len;
 
@@ -268,6 +254,48 @@ static void hostapd_send_nei_report_resp(struct hostapd_data *hapd,
 			*msmt_token = civic;
 		}
 	}
+}
+
+
+static void hostapd_send_nei_report_resp(struct hostapd_data *hapd,
+					 const u8 *addr, u8 dialog_token,
+					 struct wpa_ssid_value *ssid, u8 lci,
+					 u8 civic, u16 lci_max_age)
+{
+	struct wpabuf *buf, *elems;
+
+	/*
+	 * The number and length of the Neighbor Report elements in a Neighbor
+	 * Report frame is limited by the maximum allowed MMPDU size; + 3 bytes
+	 * of RRM header.
+	 */
+	buf = wpabuf_alloc(3 + IEEE80211_MAX_MMPDU_SIZE);
+	if (!buf)
+		return;
+
+	wpabuf_put_u8(buf, WLAN_ACTION_RADIO_MEASUREMENT);
+	wpabuf_put_u8(buf, WLAN_RRM_NEIGHBOR_REPORT_RESPONSE);
+	wpabuf_put_u8(buf, dialog_token);
+
+	if (lci || civic) {
+		/* LCI and civic measurement tokens differ between requests */
+		hostapd_put_nei_report_elems(hapd, buf, ssid, lci, civic,
+					     lci_max_age);
+	} else {
+		elems = hostapd_neighbor_cache_get(hapd, ssid);
+		if (!elems) {
+			elems = wpabuf_alloc(IEEE80211_MAX_MMPDU_SIZE);
+			if (elems) {
+				hostapd_put_nei_report_elems(hapd, elems, ssid,
+							     0, 0, 0);
+				if (hostapd_neighbor_cache_add(hapd, ssid,
+							       elems) < 0)
+					elems = NULL;
+			}
+		}
+		if (elems)
+			wpabuf_put_buf(buf, elems);
+	}
 
 	hostapd_drv_send_action(hapd, hapd->iface->freq, 0, addr,
 				wpabuf_head(buf), wpabuf_len(buf));
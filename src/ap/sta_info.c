@@ -10,6 +10,7 @@
 
 #include "utils/common.h"
 #include "utils/eloop.h"
+#include "utils/memstat.h"
 #include "common/ieee802_11_defs.h"
 #include "common/wpa_ctrl.h"
 #include "common/sae.h"
@@ -35,10 +36,12 @@
 #include "gas_serv.h"
 #include "wnm_ap.h"
 #include "mbo_ap.h"
+#include "dhcp_snoop.h"
 #include "ndisc_snoop.h"
 #include "sta_info.h"
 #include "vlan.h"
 #include "wps_hostapd.h"
+#include "ap_status_shm.h"
 
 static void ap_sta_remove_in_other_bss(struct hostapd_data *hapd,
 				       struct sta_info *sta);
@@ -66,11 +69,43 @@ int ap_for_each_sta(struct hostapd_data *hapd,
 }
 
 
+/*
+ * The hash covers the full address and uses a random per-BSS key, so that
+ * locally administered (randomized) addresses with poorly distributed last
+ * octets or addresses picked to collide do not result in long hash chains.
+ * This is multiply-shift hashing of the 48-bit address value.
+ */
+static unsigned int ap_sta_hash(struct hostapd_data *hapd, const u8 *addr)
+{
+	u64 val;
+
+	val = ((u64) WPA_GET_BE16(addr) << 32) | WPA_GET_BE32(addr + 2);
+	val = val * hapd->sta_hash_key[0] + hapd->sta_hash_key[1];
+
+	/* Use the most significant bits of the product */
+	return (val >> 56) & (STA_HASH_SIZE - 1);
+}
+
+
+void ap_sta_hash_init(struct hostapd_data *hapd)
+{
+	if (os_get_random((u8 *) hapd->sta_hash_key,
+			  sizeof(hapd->sta_hash_key)) < 0) {
+		wpa_printf(MSG_DEBUG,
+			   "AP: Could not get random data for STA hash key");
+		hapd->sta_hash_key[0] = 0x9e3779b97f4a7c15ULL;
+		hapd->sta_hash_key[1] = 0;
+	}
+	/* Multiplier needs to be odd */
+	hapd->sta_hash_key[0] |= 1;
+}
+
+
 struct sta_info * ap_get_sta(struct hostapd_data *hapd, const u8 *sta)
 {
 	struct sta_info *s;
 
-	s = hapd->sta_hash[STA_HASH(sta)];
+	s = hapd->sta_hash[ap_sta_hash(hapd, sta)];
 	while (s != NULL && os_memcmp(s->addr, sta, 6) != 0)
 		s = s->hnext;
 	return s;
@@ -101,41 +136,77 @@ struct sta_info * ap_get_sta_p2p(struct hostapd_data *hapd, const u8 *addr)
 #endif /* CONFIG_P2P */
 
 
-static void ap_sta_list_del(struct hostapd_data *hapd, struct sta_info *sta)
+/**
+ * ap_get_mld_link_sta - Get the STA entry of the same non-AP MLD on a link
+ * @link_hapd: BSS of the affiliated link
+ * @sta: STA entry of the non-AP MLD on another link
+ * Returns: The STA entry of the same association on link_hapd or %NULL
+ *
+ * The STA entries of a non-AP MLD use the MLD MAC address on all the links,
+ * so this uses the hash table of the link instead of walking its STA list.
+ */
+struct sta_info * ap_get_mld_link_sta(struct hostapd_data *link_hapd,
+				      struct sta_info *sta)
 {
-	struct sta_info *tmp;
+#ifdef CONFIG_IEEE80211BE
+	struct sta_info *lsta;
 
-	if (hapd->sta_list == sta) {
-		hapd->sta_list = sta->next;
-		return;
-	}
+	lsta = ap_get_sta(link_hapd, sta->addr);
+	if (lsta && lsta != sta &&
+	    lsta->mld_assoc_link_id == sta->mld_assoc_link_id &&
+	    lsta->aid == sta->aid)
+		return lsta;
+#endif /* CONFIG_IEEE80211BE */
+
+	return NULL;
+}
+
+
+static void ap_sta_list_add(struct hostapd_data *hapd, struct sta_info *sta)
+{
+	sta->prev = NULL;
+	sta->next = hapd->sta_list;
+	if (sta->next)
+		sta->next->prev = sta;
+	hapd->sta_list = sta;
+}
 
-	tmp = hapd->sta_list;
-	while (tmp != NULL && tmp->next != sta)
-		tmp = tmp->next;
-	if (tmp == NULL) {
+
+static void ap_sta_list_del(struct hostapd_data *hapd, struct sta_info *sta)
+{
+	if (sta->prev) {
+		sta->prev->next = sta->next;
+	} else if (hapd->sta_list == sta) {
+		hapd->sta_list = sta->next;
+	} else {
 		wpa_printf(MSG_DEBUG, "Could not remove STA " MACSTR " from "
 			   "list.", MAC2STR(sta->addr));
-	} else
-		tmp->next = sta->next;
+		return;
+	}
+	if (sta->next)
+		sta->next->prev = sta->prev;
+	sta->next = sta->prev = NULL;
 }
 
 
 void ap_sta_hash_add(struct hostapd_data *hapd, struct sta_info *sta)
 {
-	sta->hnext = hapd->sta_hash[STA_HASH(sta->addr)];
-	hapd->sta_hash[STA_HASH(sta->addr)] = sta;
+	unsigned int idx = ap_sta_hash(hapd, sta->addr);
+
+	sta->hnext = hapd->sta_hash[idx];
+	hapd->sta_hash[idx] = sta;
 }
 
 
 static void ap_sta_hash_del(struct hostapd_data *hapd, struct sta_info *sta)
 {
 	struct sta_info *s;
+	unsigned int idx = ap_sta_hash(hapd, sta->addr);
 
-	s = hapd->sta_hash[STA_HASH(sta->addr)];
+	s = hapd->sta_hash[idx];
 	if (s == NULL) return;
 	if (os_memcmp(s->addr, sta->addr, 6) == 0) {
-		hapd->sta_hash[STA_HASH(sta->addr)] = s->hnext;
+		hapd->sta_hash[idx] = s->hnext;
 		return;
 	}
 
@@ -239,8 +310,7 @@ void ap_free_sta(struct hostapd_data *hapd, struct sta_info *sta)
 	     !(sta->flags & WLAN_STA_WPS)))
 		hostapd_set_wds_sta(hapd, NULL, sta->addr, sta->aid, 0);
 
-	if (sta->ipaddr)
-		hostapd_drv_br_delete_ip_neigh(hapd, 4, (u8 *) &sta->ipaddr);
+	sta_ipaddr_del(hapd, sta);
 	ap_sta_ip6addr_del(hapd, sta);
 
 	if (!hapd->iface->driver_ap_teardown &&
@@ -257,6 +327,7 @@ void ap_free_sta(struct hostapd_data *hapd, struct sta_info *sta)
 			~BIT((sta->aid - 1) % 32);
 
 	hapd->num_sta--;
+	hostapd_status_shm_update(hapd);
 	if (sta->nonerp_set) {
 		sta->nonerp_set = 0;
 		hapd->iface->num_sta_non_erp--;
@@ -298,10 +369,10 @@ void ap_free_sta(struct hostapd_data *hapd, struct sta_info *sta)
 	}
 
 #ifdef CONFIG_TAXONOMY
-	wpabuf_free(sta->probe_ie_taxonomy);
-	sta->probe_ie_taxonomy = NULL;
-	wpabuf_free(sta->assoc_ie_taxonomy);
-	sta->assoc_ie_taxonomy = NULL;
+	os_free(sta->probe_taxonomy);
+	sta->probe_taxonomy = NULL;
+	os_free(sta->assoc_taxonomy);
+	sta->assoc_taxonomy = NULL;
 #endif /* CONFIG_TAXONOMY */
 
 	ht40_intolerant_remove(hapd->iface, sta);
@@ -409,6 +480,7 @@ void ap_free_sta(struct hostapd_data *hapd, struct sta_info *sta)
 	wpabuf_free(sta->mb_ies);
 #endif /* CONFIG_FST */
 
+	os_free(sta->drv_data);
 	os_free(sta->ht_capabilities);
 	os_free(sta->vht_capabilities);
 	os_free(sta->vht_operation);
@@ -466,7 +538,7 @@ void ap_free_sta(struct hostapd_data *hapd, struct sta_info *sta)
 	os_free(sta->ifname_wds);
 
 #ifdef CONFIG_IEEE80211BE
-	ap_sta_free_sta_profile(&sta->mld_info);
+	ap_sta_free_mld_info(sta);
 #endif /* CONFIG_IEEE80211BE */
 
 #ifdef CONFIG_TESTING_OPTIONS
@@ -474,6 +546,7 @@ void ap_free_sta(struct hostapd_data *hapd, struct sta_info *sta)
 	forced_memzero(sta->last_tk, WPA_TK_MAX_LEN);
 #endif /* CONFIG_TESTING_OPTIONS */
 
+	memstat_free(MEMSTAT_STA_INFO, sizeof(*sta));
 	os_free(sta);
 }
 
@@ -519,6 +592,184 @@ void hostapd_free_link_stas(struct hostapd_data *hapd)
 #endif /* CONFIG_IEEE80211BE */
 
 
+static void ap_sta_drv_data_cb(void *ctx, const u8 *addr,
+			       struct hostap_sta_driver_data *data)
+{
+	struct hostapd_data *hapd = ctx;
+	struct sta_info *sta;
+
+	sta = ap_get_sta(hapd, addr);
+	if (!sta)
+		return;
+
+	if (!sta->drv_data) {
+		sta->drv_data = os_malloc(sizeof(*sta->drv_data));
+		if (!sta->drv_data)
+			return;
+	}
+	os_memcpy(sta->drv_data, data, sizeof(*data));
+	sta->drv_data_gen = hapd->sta_drv_data_gen;
+}
+
+
+/* Age of the last bulk fetch in milliseconds or -1 if there is no snapshot
+ * within the configured sta_stats_interval */
+static int ap_sta_drv_data_age(struct hostapd_data *hapd)
+{
+	struct os_reltime now, age;
+	unsigned int interval = hapd->conf->sta_stats_interval;
+	unsigned long age_ms;
+
+	if (!interval || !hapd->sta_drv_data_gen ||
+	    !os_reltime_initialized(&hapd->sta_drv_data_time))
+		return -1;
+
+	os_get_reltime(&now);
+	os_reltime_sub(&now, &hapd->sta_drv_data_time, &age);
+	if (age.sec < 0)
+		return -1;
+	age_ms = age.sec * 1000 + age.usec / 1000;
+	if (age_ms >= interval)
+		return -1;
+	return age_ms;
+}
+
+
+/**
+ * ap_sta_refresh_drv_data - Fetch driver data for all stations of a BSS
+ * @hapd: Pointer to BSS data
+ * @force: Whether to fetch the data even if the cached copy is still fresh
+ * Returns: 0 on success, -1 if bulk fetch is not available or failed
+ *
+ * This uses a single driver request to fetch the station data (inactivity,
+ * counters, rates) for all stations of the BSS. The results are cached in
+ * each struct sta_info and can be accessed with ap_sta_get_drv_data() for
+ * sta_stats_interval milliseconds.
+ */
+int ap_sta_refresh_drv_data(struct hostapd_data *hapd, bool force)
+{
+	if (!hapd->conf->sta_stats_interval)
+		return -1;
+
+	if (!force && ap_sta_drv_data_age(hapd) >= 0)
+		return 0;
+
+	hapd->sta_drv_data_gen++;
+	if (!hapd->sta_drv_data_gen)
+		hapd->sta_drv_data_gen++;
+	os_get_reltime(&hapd->sta_drv_data_time);
+	if (hostapd_drv_read_all_sta_data(hapd, ap_sta_drv_data_cb, hapd) < 0) {
+		/* Invalidate any partial results */
+		hapd->sta_drv_data_gen++;
+		if (!hapd->sta_drv_data_gen)
+			hapd->sta_drv_data_gen++;
+		hapd->sta_drv_data_time.sec = 0;
+		hapd->sta_drv_data_time.usec = 0;
+		return -1;
+	}
+
+	return 0;
+}
+
+
+/**
+ * ap_sta_get_drv_data - Get cached driver data for a station
+ * @hapd: Pointer to BSS data
+ * @sta: Pointer to the station
+ * Returns: Pointer to the data from the last bulk fetch or %NULL if no fresh
+ * data is available for the station
+ */
+struct hostap_sta_driver_data *
+ap_sta_get_drv_data(struct hostapd_data *hapd, struct sta_info *sta)
+{
+	if (!sta->drv_data || sta->drv_data_gen != hapd->sta_drv_data_gen ||
+	    ap_sta_drv_data_age(hapd) < 0)
+		return NULL;
+
+	return sta->drv_data;
+}
+
+
+/**
+ * ap_sta_read_drv_data - Get driver data for a station
+ * @hapd: Pointer to BSS data
+ * @sta: Pointer to the station
+ * @data: Buffer for returning the station data
+ * @max_age_ms: Maximum acceptable age of the data in milliseconds or
+ *	AP_STA_DRV_DATA_ANY_AGE to accept anything within sta_stats_interval
+ * @age_ms: Buffer for returning the age of the data in milliseconds or %NULL
+ * Returns: 0 on success, -1 on failure
+ *
+ * The data is served from the snapshot of the last bulk fetch when it is
+ * recent enough. If there is no such snapshot and there are other stations
+ * that are likely to need their data soon, a new snapshot is taken for all
+ * the stations of the BSS with a single driver request. Otherwise, the
+ * driver is queried for this station only.
+ */
+int ap_sta_read_drv_data(struct hostapd_data *hapd, struct sta_info *sta,
+			 struct hostap_sta_driver_data *data,
+			 unsigned int max_age_ms, unsigned int *age_ms)
+{
+	struct hostap_sta_driver_data *cached;
+	int age;
+
+	age = ap_sta_drv_data_age(hapd);
+	if ((age < 0 || (unsigned int) age > max_age_ms) &&
+	    hapd->num_sta > 1 && ap_sta_refresh_drv_data(hapd, true) == 0)
+		age = ap_sta_drv_data_age(hapd);
+	cached = ap_sta_get_drv_data(hapd, sta);
+
+	if (cached && age >= 0 && (unsigned int) age <= max_age_ms) {
+		os_memcpy(data, cached, sizeof(*data));
+		if (age_ms)
+			*age_ms = age;
+		return 0;
+	}
+
+	if (hostapd_drv_read_sta_data(hapd, data, sta->addr) < 0)
+		return -1;
+	if (age_ms)
+		*age_ms = 0;
+	return 0;
+}
+
+
+/**
+ * ap_sta_register_inactivity_timer - Register STA inactivity poll timer
+ * @hapd: Pointer to BSS data
+ * @sta: Pointer to the station
+ * @sec: Number of seconds until the next inactivity check
+ *
+ * With ap_inactivity_slack configured, the expiration time is rounded up to
+ * the next multiple of the slack so that the inactivity checks of all
+ * stations falling within the same window expire at the same instant and get
+ * processed in a single wakeup.
+ */
+void ap_sta_register_inactivity_timer(struct hostapd_data *hapd,
+				      struct sta_info *sta, unsigned int sec)
+{
+	unsigned int slack = hapd->conf->ap_inactivity_slack;
+	struct os_reltime now;
+	os_time_t expire;
+	unsigned int usec = 0;
+
+	if (slack > 1) {
+		os_get_reltime(&now);
+		expire = now.sec + sec;
+		expire = (expire + slack - 1) / slack * slack;
+		if (expire <= now.sec)
+			expire += slack;
+		sec = expire - now.sec;
+		if (now.usec) {
+			sec--;
+			usec = 1000000 - now.usec;
+		}
+	}
+
+	eloop_register_timeout(sec, usec, ap_handle_timer, hapd, sta);
+}
+
+
 /**
  * ap_handle_timer - Per STA timer handler
  * @eloop_ctx: struct hostapd_data *
@@ -559,7 +810,21 @@ void ap_handle_timer(void *eloop_ctx, void *timeout_ctx)
 		 * stations that are idle (but keep re-associating).
 		 */
 		int fuzz = os_random() % 20;
-		inactive_sec = hostapd_drv_get_inact_sec(hapd, sta->addr);
+		struct hostap_sta_driver_data *data = NULL;
+
+		/*
+		 * With coalesced inactivity polls, multiple stations are
+		 * likely to be checked in the same wakeup, so fetch the data
+		 * for all of them with a single driver request.
+		 */
+		if (hapd->conf->ap_inactivity_slack > 1 && hapd->num_sta > 1 &&
+		    ap_sta_refresh_drv_data(hapd, false) == 0)
+			data = ap_sta_get_drv_data(hapd, sta);
+		if (data)
+			inactive_sec = data->inactive_msec / 1000;
+		else
+			inactive_sec = hostapd_drv_get_inact_sec(hapd,
+								 sta->addr);
 		if (inactive_sec == -1) {
 			wpa_msg(hapd->msg_ctx, MSG_DEBUG,
 				"Check inactivity: Could not "
@@ -615,8 +880,11 @@ skip_poll:
 		wpa_printf(MSG_DEBUG, "%s: register ap_handle_timer timeout "
 			   "for " MACSTR " (%lu seconds)",
 			   __func__, MAC2STR(sta->addr), next_time);
-		eloop_register_timeout(next_time, 0, ap_handle_timer, hapd,
-				       sta);
+		if (sta->timeout_next == STA_NULLFUNC)
+			ap_sta_register_inactivity_timer(hapd, sta, next_time);
+		else
+			eloop_register_timeout(next_time, 0, ap_handle_timer,
+					       hapd, sta);
 		return;
 	}
 
@@ -819,6 +1087,7 @@ struct sta_info * ap_sta_add(struct hostapd_data *hapd, const u8 *addr)
 		os_free(sta);
 		return NULL;
 	}
+	memstat_alloc(MEMSTAT_STA_INFO, sizeof(*sta));
 
 	for (i = 0; i < WLAN_SUPP_RATES_MAX; i++) {
 		if (!hapd->iface->basic_rates)
@@ -837,15 +1106,14 @@ struct sta_info * ap_sta_add(struct hostapd_data *hapd, const u8 *addr)
 			   "for " MACSTR " (%d seconds - ap_max_inactivity)",
 			   __func__, MAC2STR(addr),
 			   max_inactivity);
-		eloop_register_timeout(max_inactivity, 0,
-				       ap_handle_timer, hapd, sta);
+		ap_sta_register_inactivity_timer(hapd, sta, max_inactivity);
 	}
 
 	/* initialize STA info data */
 	os_memcpy(sta->addr, addr, ETH_ALEN);
-	sta->next = hapd->sta_list;
-	hapd->sta_list = sta;
+	ap_sta_list_add(hapd, sta);
 	hapd->num_sta++;
+	hostapd_status_shm_update(hapd);
 	ap_sta_hash_add(hapd, sta);
 	ap_sta_remove_in_other_bss(hapd, sta);
 	sta->last_seq_ctrl = WLAN_INVALID_MGMT_SEQ;
@@ -853,7 +1121,7 @@ struct sta_info * ap_sta_add(struct hostapd_data *hapd, const u8 *addr)
 
 #ifdef CONFIG_TAXONOMY
 	sta_track_claim_taxonomy_info(hapd->iface, addr,
-				      &sta->probe_ie_taxonomy);
+				      &sta->probe_taxonomy);
 #endif /* CONFIG_TAXONOMY */
 
 	return sta;
@@ -864,8 +1132,7 @@ static int ap_sta_remove(struct hostapd_data *hapd, struct sta_info *sta)
 {
 	ieee802_1x_notify_port_enabled(sta->eapol_sm, 0);
 
-	if (sta->ipaddr)
-		hostapd_drv_br_delete_ip_neigh(hapd, 4, (u8 *) &sta->ipaddr);
+	sta_ipaddr_del(hapd, sta);
 	ap_sta_ip6addr_del(hapd, sta);
 
 	wpa_printf(MSG_DEBUG, "%s: Removing STA " MACSTR " from kernel driver",
@@ -1044,7 +1311,7 @@ static bool ap_sta_ml_disconnect(struct hostapd_data *hapd,
 	interfaces = assoc_hapd->iface->interfaces;
 
 	for (link_id = 0; link_id < MAX_NUM_MLD_LINKS; link_id++) {
-		if (!assoc_sta->mld_info.links[link_id].valid)
+		if (!assoc_sta->mld_info->links[link_id].valid)
 			continue;
 
 		for (i = 0; i < interfaces->count; i++) {
@@ -1235,8 +1502,7 @@ int ap_sta_set_vlan(struct hostapd_data *hapd, struct sta_info *sta,
 			       HOSTAPD_LEVEL_DEBUG,
 			       "added new dynamic VLAN interface '%s'",
 			       vlan->ifname);
-	} else if (vlan && vlan->dynamic_vlan > 0) {
-		vlan->dynamic_vlan++;
+	} else if (vlan && vlan_hold_dynamic(hapd, vlan)) {
 		hostapd_logger(hapd, sta->addr,
 			       HOSTAPD_MODULE_IEEE80211,
 			       HOSTAPD_LEVEL_DEBUG,
@@ -1305,8 +1571,7 @@ int ap_sta_bind_vlan(struct hostapd_data *hapd, struct sta_info *sta)
 			       sta->vlan_id);
 		ret = -1;
 		goto done;
-	} else if (vlan && vlan->dynamic_vlan > 0) {
-		vlan->dynamic_vlan++;
+	} else if (vlan && vlan_hold_dynamic(hapd, vlan)) {
 		hostapd_logger(hapd, sta->addr,
 			       HOSTAPD_MODULE_IEEE80211,
 			       HOSTAPD_LEVEL_DEBUG,
@@ -1808,15 +2073,9 @@ static void ap_sta_remove_link_sta(struct hostapd_data *hapd,
 		if (hapd == tmp_hapd)
 			continue;
 
-		for (tmp_sta = tmp_hapd->sta_list; tmp_sta;
-		     tmp_sta = tmp_sta->next) {
-			if (tmp_sta == sta ||
-			    !ether_addr_equal(tmp_sta->addr, sta->addr))
-				continue;
-
+		tmp_sta = ap_get_sta(tmp_hapd, sta->addr);
+		if (tmp_sta && tmp_sta != sta)
 			ap_free_sta(tmp_hapd, tmp_sta);
-			break;
-		}
 	}
 }
 #endif /* CONFIG_IEEE80211BE */
@@ -1840,7 +2099,7 @@ int ap_sta_re_add(struct hostapd_data *hapd, struct sta_info *sta)
 		u8 mld_link_id = hapd->mld_link_id;
 
 		mld_link_sta = sta->mld_assoc_link_id != mld_link_id;
-		mld_link_addr = sta->mld_info.links[mld_link_id].peer_addr;
+		mld_link_addr = sta->mld_info->links[mld_link_id].peer_addr;
 
 		/*
 		 * In case the AP is affiliated with an AP MLD, we need to
@@ -1872,7 +2131,47 @@ int ap_sta_re_add(struct hostapd_data *hapd, struct sta_info *sta)
 }
 
 
+/**
+ * ap_sta_set_mld - Mark a STA as a non-AP MLD
+ * @sta: Pointer to the STA entry or %NULL
+ * @mld: Whether the STA is a non-AP MLD
+ * Returns: 0 on success or -1 if the MLD information could not be allocated
+ *
+ * Most STAs are not non-AP MLDs, so struct mld_info is allocated only when a
+ * STA is marked as one. It is kept until the STA entry is freed or
+ * ap_sta_free_mld_info() is called.
+ */
+int ap_sta_set_mld(struct sta_info *sta, bool mld)
+{
 #ifdef CONFIG_IEEE80211BE
+	if (!sta)
+		return 0;
+	if (!sta->mld_info) {
+		if (!mld)
+			return 0;
+		sta->mld_info = os_zalloc(sizeof(*sta->mld_info));
+		if (!sta->mld_info)
+			return -1;
+		memstat_resize(MEMSTAT_STA_INFO, 0, sizeof(*sta->mld_info));
+	}
+	sta->mld_info->mld_sta = mld;
+#endif /* CONFIG_IEEE80211BE */
+	return 0;
+}
+
+
+#ifdef CONFIG_IEEE80211BE
+void ap_sta_free_mld_info(struct sta_info *sta)
+{
+	if (!sta->mld_info)
+		return;
+	ap_sta_free_sta_profile(sta->mld_info);
+	memstat_resize(MEMSTAT_STA_INFO, sizeof(*sta->mld_info), 0);
+	os_free(sta->mld_info);
+	sta->mld_info = NULL;
+}
+
+
 void ap_sta_free_sta_profile(struct mld_info *info)
 {
 	int i;
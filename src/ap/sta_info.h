@@ -85,16 +85,28 @@ struct mld_info {
 };
 
 struct sta_info {
+	/* The fields used for most frames and timeouts are kept together at
+	 * the beginning, within the first 64 octets on 64-bit hosts */
 	struct sta_info *next; /* next entry in sta list */
+	struct sta_info *prev; /* previous entry in sta list */
 	struct sta_info *hnext; /* next entry in hash table list */
 	u8 addr[6];
-	be32 ipaddr;
-	struct dl_list ip6addr; /* list head for struct ip6addr */
 	u16 aid; /* STA's unique AID (1 .. 2007) or 0 if not yet assigned */
-	u16 disconnect_reason_code; /* RADIUS server override */
 	u32 flags; /* Bitfield of WLAN_STA_* */
 	u16 capability;
 	u16 listen_interval; /* or beacon_int for APs */
+	struct wpa_state_machine *wpa_sm;
+	struct eapol_state_machine *eapol_sm; /* IEEE 802.1X related data */
+	enum {
+		STA_NULLFUNC = 0, STA_DISASSOC, STA_DEAUTH, STA_REMOVE,
+		STA_DISASSOC_FROM_CLI
+	} timeout_next;
+	int vlan_id; /* 0: none, >0: VID */
+
+	be32 ipaddr;
+	struct sta_info *ipaddr_hnext; /* next entry in IPv4 address hash */
+	struct dl_list ip6addr; /* list head for struct ip6addr */
+	u16 disconnect_reason_code; /* RADIUS server override */
 	u8 supported_rates[WLAN_SUPP_RATES_MAX];
 	int supported_rates_len;
 	u8 qosinfo; /* Valid when WLAN_STA_WMM is set */
@@ -120,6 +132,8 @@ struct sta_info {
 	size_t igtk_len;
 	u16 igtk_key_id;
 	u8 sae_auth_retry;
+	int mesh_ssi_signal; /* dBm from the peer candidate event; 0 = unknown */
+	unsigned int mesh_auth_pending:1; /* waiting for mesh_auth_rate */
 #endif /* CONFIG_MESH */
 
 	unsigned int nonerp_set:1;
@@ -148,17 +162,9 @@ struct sta_info {
 
 	u16 auth_alg;
 
-	enum {
-		STA_NULLFUNC = 0, STA_DISASSOC, STA_DEAUTH, STA_REMOVE,
-		STA_DISASSOC_FROM_CLI
-	} timeout_next;
-
 	u16 deauth_reason;
 	u16 disassoc_reason;
 
-	/* IEEE 802.1X related data */
-	struct eapol_state_machine *eapol_sm;
-
 	struct pending_eapol_rx *pending_eapol_rx;
 
 	u64 acct_session_id;
@@ -176,10 +182,8 @@ struct sta_info {
 
 	u8 *challenge; /* IEEE 802.11 Shared Key Authentication Challenge */
 
-	struct wpa_state_machine *wpa_sm;
 	struct rsn_preauth_interface *preauth_iface;
 
-	int vlan_id; /* 0: none, >0: VID */
 	struct vlan_description *vlan_desc;
 	int vlan_id_bound; /* updated by ap_sta_bind_vlan() */
 	 /* PSKs from RADIUS authentication server */
@@ -259,8 +263,8 @@ struct sta_info {
 	s8 max_tx_power;
 
 #ifdef CONFIG_TAXONOMY
-	struct wpabuf *probe_ie_taxonomy;
-	struct wpabuf *assoc_ie_taxonomy;
+	struct taxonomy_info *probe_taxonomy;
+	struct taxonomy_info *assoc_taxonomy;
 #endif /* CONFIG_TAXONOMY */
 
 #ifdef CONFIG_FILS
@@ -310,21 +314,37 @@ struct sta_info {
 	unsigned int airtime_weight;
 	struct os_reltime backlogged_until;
 #endif /* CONFIG_AIRTIME_POLICY */
+#ifdef CONFIG_STEERING
+	struct os_reltime steer_last; /* last steering BSS TM Request */
+#endif /* CONFIG_STEERING */
 
 #ifdef CONFIG_PASN
 	struct pasn_data *pasn;
+	struct os_reltime pasn_start; /* reception of PASN frame 1 */
 #endif /* CONFIG_PASN */
 
 #ifdef CONFIG_IEEE80211BE
-	struct mld_info mld_info;
+	struct mld_info *mld_info; /* allocated by ap_sta_set_mld() */
 	u8 mld_assoc_link_id;
 #endif /* CONFIG_IEEE80211BE */
 
 	u16 max_idle_period; /* if nonzero, the granted BSS max idle period in
 			      * units of 1000 TUs */
+
+	/* Driver data from the last bulk fetch for the BSS; valid only while
+	 * drv_data_gen matches hapd->sta_drv_data_gen */
+	struct hostap_sta_driver_data *drv_data;
+	unsigned int drv_data_gen;
 };
 
 
+/* Default maximum age (in milliseconds) of the driver data from a bulk
+ * station fetch (sta_stats_interval) */
+#define AP_STA_DRV_DATA_DEFAULT_INTERVAL 1000
+/* ap_sta_read_drv_data() max_age_ms for accepting any snapshot that is
+ * still within sta_stats_interval */
+#define AP_STA_DRV_DATA_ANY_AGE ((unsigned int) -1)
+
 /* Default value for maximum station inactivity. After AP_MAX_INACTIVITY has
  * passed since last received frame from the station, a nullfunc data frame is
  * sent to the station. If this frame is not acknowledged and no other frames
@@ -347,11 +367,22 @@ int ap_for_each_sta(struct hostapd_data *hapd,
 		    void *ctx);
 struct sta_info * ap_get_sta(struct hostapd_data *hapd, const u8 *sta);
 struct sta_info * ap_get_sta_p2p(struct hostapd_data *hapd, const u8 *addr);
+struct sta_info * ap_get_mld_link_sta(struct hostapd_data *link_hapd,
+				      struct sta_info *sta);
+void ap_sta_hash_init(struct hostapd_data *hapd);
 void ap_sta_hash_add(struct hostapd_data *hapd, struct sta_info *sta);
 void ap_free_sta(struct hostapd_data *hapd, struct sta_info *sta);
 void ap_sta_ip6addr_del(struct hostapd_data *hapd, struct sta_info *sta);
 void hostapd_free_stas(struct hostapd_data *hapd);
 void ap_handle_timer(void *eloop_ctx, void *timeout_ctx);
+int ap_sta_refresh_drv_data(struct hostapd_data *hapd, bool force);
+struct hostap_sta_driver_data *
+ap_sta_get_drv_data(struct hostapd_data *hapd, struct sta_info *sta);
+int ap_sta_read_drv_data(struct hostapd_data *hapd, struct sta_info *sta,
+			 struct hostap_sta_driver_data *data,
+			 unsigned int max_age_ms, unsigned int *age_ms);
+void ap_sta_register_inactivity_timer(struct hostapd_data *hapd,
+				      struct sta_info *sta, unsigned int sec);
 void ap_sta_replenish_timeout(struct hostapd_data *hapd, struct sta_info *sta,
 			      u32 session_timeout);
 void ap_sta_session_timeout(struct hostapd_data *hapd, struct sta_info *sta,
@@ -412,20 +443,15 @@ static inline bool ap_sta_is_mld(struct hostapd_data *hapd,
 				 struct sta_info *sta)
 {
 #ifdef CONFIG_IEEE80211BE
-	return hapd->conf->mld_ap && sta && sta->mld_info.mld_sta;
+	return hapd->conf->mld_ap && sta && sta->mld_info &&
+		sta->mld_info->mld_sta;
 #else /* CONFIG_IEEE80211BE */
 	return false;
 #endif /* CONFIG_IEEE80211BE */
 }
 
-static inline void ap_sta_set_mld(struct sta_info *sta, bool mld)
-{
-#ifdef CONFIG_IEEE80211BE
-	if (sta)
-		sta->mld_info.mld_sta = mld;
-#endif /* CONFIG_IEEE80211BE */
-}
-
+int ap_sta_set_mld(struct sta_info *sta, bool mld);
+void ap_sta_free_mld_info(struct sta_info *sta);
 void ap_sta_free_sta_profile(struct mld_info *info);
 
 void hostapd_free_link_stas(struct hostapd_data *hapd);
@@ -0,0 +1,360 @@
+/*
+ * hostapd / Load based client steering between local BSSs
+ *
+ * This software may be distributed under the terms of the BSD license.
+ * See README for more details.
+ */
+
+#include "utils/includes.h"
+
+#include "utils/common.h"
+#include "utils/eloop.h"
+#include "common/ieee802_11_defs.h"
+#include "hostapd.h"
+#include "ap_config.h"
+#include "sta_info.h"
+#include "beacon.h"
+#include "ieee802_11.h"
+#include "wnm_ap.h"
+#include "steering.h"
+
+/*
+ * Stations are moved away from a radio whose channel utilization exceeds
+ * steering_chan_util to a BSS with the same SSID on another, less busy radio
+ * controlled by this hostapd process. A station is only steered to a radio on
+ * which it has been seen in Probe Request frames (i.e., the station supports
+ * that band) with a high enough average signal strength, so this depends on
+ * track_sta_max_num. The channel utilization is measured with
+ * bss_load_update_period on both radios.
+ *
+ * Associated stations that support BSS transition management are sent a BSS
+ * TM Request from a periodic evaluation, at most one station per round and
+ * per radio. Other stations are rejected once when trying to authenticate to
+ * the busy radio. Both actions are taken at most once per steering_backoff
+ * for a station.
+ */
+
+/* Validity Interval of the steering BSS TM Requests in TBTTs */
+#define STEERING_BTM_VALID_INT 100
+
+
+static unsigned int steering_chan_util(struct hostapd_iface *iface)
+{
+	if (iface->bss[0]->conf->chan_util_avg_period &&
+	    iface->chan_util_average)
+		return iface->chan_util_average;
+	return iface->channel_utilization;
+}
+
+
+static bool steering_overloaded(struct hostapd_iface *iface)
+{
+	return iface->conf->steering_chan_util > 0 &&
+		iface->bss[0]->conf->bss_load_update_period &&
+		steering_chan_util(iface) >=
+		(unsigned int) iface->conf->steering_chan_util;
+}
+
+
+static bool steering_in_backoff(struct hostapd_iface *iface,
+				struct os_reltime *last, struct os_reltime *now)
+{
+	return os_reltime_initialized(last) &&
+		!os_reltime_expired(now, last, iface->conf->steering_backoff);
+}
+
+
+static bool steering_sta_btm(struct hostapd_data *hapd, struct sta_info *sta)
+{
+	const unsigned int bit = WLAN_EXT_CAPAB_BSS_TRANSITION;
+
+	return hapd->conf->bss_transition && sta->ext_capability &&
+		sta->ext_capability[0] > bit / 8 &&
+		(sta->ext_capability[1 + bit / 8] & BIT(bit % 8));
+}
+
+
+/*
+ * Find a BSS with the same SSID on the least busy other radio on which the
+ * station has been seen with a good enough signal. Unless forced, the target
+ * radio needs to be clearly less busy than the current one.
+ */
+static struct hostapd_data * steering_target(struct hostapd_data *hapd,
+					     const u8 *addr, bool force,
+					     int *ssi)
+{
+	struct hostapd_iface *iface = hapd->iface;
+	struct hapd_interfaces *interfaces = iface->interfaces;
+	struct hostapd_data *best = NULL;
+	unsigned int util, best_util = 0;
+	size_t i, j;
+
+	if (!interfaces)
+		return NULL;
+
+	util = steering_chan_util(iface);
+	for (i = 0; i < interfaces->count; i++) {
+		struct hostapd_iface *other = interfaces->iface[i];
+		struct hostapd_sta_info *info;
+		unsigned int other_util;
+
+		if (other == iface || other->state != HAPD_IFACE_ENABLED ||
+		    !other->bss[0]->conf->bss_load_update_period)
+			continue;
+
+		other_util = steering_chan_util(other);
+		if ((!force && other_util + STEERING_UTIL_MARGIN > util) ||
+		    (best && other_util >= best_util))
+			continue;
+
+		info = sta_track_get(other, addr);
+		if (!info || !info->ssi_avg ||
+		    info->ssi_avg < iface->conf->steering_min_rssi)
+			continue;
+
+		for (j = 0; j < other->num_bss; j++) {
+			struct hostapd_data *bss = other->bss[j];
+
+			if (!bss->started ||
+			    bss->conf->ssid.ssid_len !=
+			    hapd->conf->ssid.ssid_len ||
+			    os_memcmp(bss->conf->ssid.ssid,
+				      hapd->conf->ssid.ssid,
+				      hapd->conf->ssid.ssid_len) != 0)
+				continue;
+
+			best = bss;
+			best_util = other_util;
+			*ssi = info->ssi_avg;
+			break;
+		}
+	}
+
+	return best;
+}
+
+
+static int steering_send_btm(struct hostapd_data *hapd, struct sta_info *sta,
+			     struct hostapd_data *target,
+			     struct os_reltime *now)
+{
+	u8 nei_rep[2 + 13 + 3], *pos;
+	u8 mbo[3];
+	size_t mbo_len = 0;
+
+	pos = hostapd_eid_neighbor_report_bss(target, nei_rep);
+	*pos++ = WNM_NEIGHBOR_BSS_TRANSITION_CANDIDATE;
+	*pos++ = 1;
+	*pos++ = 255; /* preference */
+	nei_rep[1] += 3;
+
+#ifdef CONFIG_MBO
+	if (hapd->conf->mbo_enabled) {
+		mbo[0] = MBO_ATTR_ID_TRANSITION_REASON;
+		mbo[1] = 1;
+		mbo[2] = MBO_TRANSITION_REASON_LOAD_BALANCE;
+		mbo_len = 3;
+	}
+#endif /* CONFIG_MBO */
+
+	wpa_printf(MSG_DEBUG,
+		   "Steering: Request " MACSTR " to move from %s to %s ("
+		   MACSTR ")", MAC2STR(sta->addr), hapd->conf->iface,
+		   target->conf->iface, MAC2STR(target->own_addr));
+	if (wnm_send_bss_tm_req(hapd, sta,
+				WNM_BSS_TM_REQ_PREF_CAND_LIST_INCLUDED |
+				WNM_BSS_TM_REQ_ABRIDGED, 0,
+				STEERING_BTM_VALID_INT, NULL, 1, NULL,
+				nei_rep, pos - nei_rep,
+				mbo_len ? mbo : NULL, mbo_len) < 0)
+		return -1;
+
+	sta->steer_last = *now;
+	hapd->iface->steering_btm_sent++;
+	return 0;
+}
+
+
+static void steering_update(void *eloop_ctx, void *timeout_ctx)
+{
+	struct hostapd_iface *iface = eloop_ctx;
+	struct hostapd_data *best_hapd = NULL, *best_target = NULL;
+	struct sta_info *sta, *best_sta = NULL;
+	struct os_reltime now;
+	int ssi, best_ssi = 0;
+	size_t i;
+
+	if (!steering_overloaded(iface))
+		goto out;
+
+	iface->steering_rounds++;
+	os_get_reltime(&now);
+
+	/* Move the station that is expected to do best on the target */
+	for (i = 0; i < iface->num_bss; i++) {
+		struct hostapd_data *hapd = iface->bss[i];
+
+		if (!hapd->started)
+			continue;
+
+		for (sta = hapd->sta_list; sta; sta = sta->next) {
+			struct hostapd_data *target;
+
+			if (!(sta->flags & WLAN_STA_AUTHORIZED) ||
+			    ap_sta_is_mld(hapd, sta) ||
+			    !steering_sta_btm(hapd, sta) ||
+			    steering_in_backoff(iface, &sta->steer_last, &now))
+				continue;
+
+			target = steering_target(hapd, sta->addr, false, &ssi);
+			if (target && (!best_sta || ssi > best_ssi)) {
+				best_hapd = hapd;
+				best_sta = sta;
+				best_target = target;
+				best_ssi = ssi;
+			}
+		}
+	}
+
+	if (best_sta)
+		steering_send_btm(best_hapd, best_sta, best_target, &now);
+
+out:
+	eloop_register_timeout(iface->conf->steering_interval, 0,
+			       steering_update, iface, NULL);
+}
+
+
+/**
+ * steering_reject_auth - Check whether to steer an authenticating station
+ * @hapd: BSS that received the Authentication frame
+ * @addr: Address of the station
+ * @resp_ies: Buffer for the Neighbor Report element of the suggested BSS
+ * @resp_ies_len: Set to the length of the added element
+ * Returns: true if the authentication is to be rejected with a suggested BSS
+ * transition
+ */
+bool steering_reject_auth(struct hostapd_data *hapd, const u8 *addr,
+			  u8 *resp_ies, size_t *resp_ies_len)
+{
+	struct hostapd_iface *iface = hapd->iface;
+	struct hostapd_sta_info *info;
+	struct hostapd_data *target;
+	struct os_reltime now;
+	int ssi;
+
+	if (!steering_overloaded(iface) || ap_get_sta(hapd, addr))
+		return false;
+
+	info = sta_track_get(iface, addr);
+	if (!info)
+		return false;
+
+	os_get_reltime(&now);
+	if (steering_in_backoff(iface, &info->steer_reject, &now))
+		return false;
+
+	target = steering_target(hapd, addr, false, &ssi);
+	if (!target)
+		return false;
+
+	wpa_printf(MSG_DEBUG,
+		   "Steering: Reject authentication from " MACSTR
+		   " on %s and suggest %s (" MACSTR ")",
+		   MAC2STR(addr), hapd->conf->iface, target->conf->iface,
+		   MAC2STR(target->own_addr));
+	info->steer_reject = now;
+	iface->steering_auth_rejected++;
+	*resp_ies_len = hostapd_eid_neighbor_report_bss(target, resp_ies) -
+		resp_ies;
+	return true;
+}
+
+
+/**
+ * steering_ctrl_status - Process STEERING_STATUS control interface command
+ * @hapd: Pointer to BSS data
+ * @buf: Buffer for the response
+ * @buflen: Length of the response buffer
+ * Returns: Length of the response or -1 on failure
+ */
+int steering_ctrl_status(struct hostapd_data *hapd, char *buf, size_t buflen)
+{
+	struct hostapd_iface *iface = hapd->iface;
+	int ret;
+
+	ret = os_snprintf(buf, buflen,
+			  "chan_util=%u\n"
+			  "threshold=%d\n"
+			  "overloaded=%d\n"
+			  "rounds=%u\n"
+			  "btm_sent=%u\n"
+			  "auth_rejected=%u\n",
+			  steering_chan_util(iface),
+			  iface->conf->steering_chan_util,
+			  steering_overloaded(iface),
+			  iface->steering_rounds,
+			  iface->steering_btm_sent,
+			  iface->steering_auth_rejected);
+	if (os_snprintf_error(buflen, ret))
+		return -1;
+	return ret;
+}
+
+
+/**
+ * steering_ctrl_steer_sta - Process STEER_STA control interface command
+ * @hapd: Pointer to BSS data
+ * @cmd: Address of an associated station
+ * Returns: 0 on success, -1 on failure
+ *
+ * This allows an external controller to move a station to the least busy other
+ * radio regardless of the channel utilization thresholds and the backoff.
+ */
+int steering_ctrl_steer_sta(struct hostapd_data *hapd, const char *cmd)
+{
+	u8 addr[ETH_ALEN];
+	struct sta_info *sta;
+	struct hostapd_data *target;
+	struct os_reltime now;
+	int ssi;
+
+	if (hwaddr_aton(cmd, addr))
+		return -1;
+
+	sta = ap_get_sta(hapd, addr);
+	if (!sta || !steering_sta_btm(hapd, sta)) {
+		wpa_printf(MSG_DEBUG,
+			   "Steering: Station " MACSTR
+			   " not found or does not support BSS transition",
+			   MAC2STR(addr));
+		return -1;
+	}
+
+	target = steering_target(hapd, addr, true, &ssi);
+	if (!target) {
+		wpa_printf(MSG_DEBUG, "Steering: No target BSS for " MACSTR,
+			   MAC2STR(addr));
+		return -1;
+	}
+
+	os_get_reltime(&now);
+	return steering_send_btm(hapd, sta, target, &now);
+}
+
+
+int steering_update_init(struct hostapd_iface *iface)
+{
+	if (!iface->conf->steering_chan_util)
+		return 0;
+
+	eloop_register_timeout(iface->conf->steering_interval, 0,
+			       steering_update, iface, NULL);
+	return 0;
+}
+
+
+void steering_update_deinit(struct hostapd_iface *iface)
+{
+	eloop_cancel_timeout(steering_update, iface, NULL);
+}
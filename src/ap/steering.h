@@ -0,0 +1,49 @@
+/*
+ * hostapd / Load based client steering between local BSSs
+ *
+ * This software may be distributed under the terms of the BSD license.
+ * See README for more details.
+ */
+
+#ifndef STEERING_H
+#define STEERING_H
+
+struct hostapd_iface;
+
+#ifdef CONFIG_STEERING
+
+#define STEERING_DEFAULT_MIN_RSSI -70 /* dBm */
+#define STEERING_DEFAULT_INTERVAL 10 /* seconds */
+#define STEERING_DEFAULT_BACKOFF 60 /* seconds */
+
+/* A target radio needs to be at least this much (out of 255) less busy */
+#define STEERING_UTIL_MARGIN 32
+
+int steering_update_init(struct hostapd_iface *iface);
+void steering_update_deinit(struct hostapd_iface *iface);
+bool steering_reject_auth(struct hostapd_data *hapd, const u8 *addr,
+			  u8 *resp_ies, size_t *resp_ies_len);
+int steering_ctrl_status(struct hostapd_data *hapd, char *buf, size_t buflen);
+int steering_ctrl_steer_sta(struct hostapd_data *hapd, const char *cmd);
+
+#else /* CONFIG_STEERING */
+
+static inline int steering_update_init(struct hostapd_iface *iface)
+{
+	return -1;
+}
+
+static inline void steering_update_deinit(struct hostapd_iface *iface)
+{
+}
+
+static inline bool steering_reject_auth(struct hostapd_data *hapd,
+					const u8 *addr, u8 *resp_ies,
+					size_t *resp_ies_len)
+{
+	return false;
+}
+
+#endif /* CONFIG_STEERING */
+
+#endif /* STEERING_H */
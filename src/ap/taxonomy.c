@@ -82,47 +82,55 @@ static int get_wps_name(char *name, size_t name_len,
 }
 
 
-static void ie_to_string(char *fstr, size_t fstr_len, const struct wpabuf *ies)
-{
-	char *fpos = fstr;
-	char *fend = fstr + fstr_len;
-	char htcap[7 + 4 + 1]; /* ",htcap:" + %04hx + trailing NUL */
-	char htagg[7 + 2 + 1]; /* ",htagg:" + %02hx + trailing NUL */
-	char htmcs[7 + 8 + 1]; /* ",htmcs:" + %08x + trailing NUL */
-	char vhtcap[8 + 8 + 1]; /* ",vhtcap:" + %08x + trailing NUL */
-	char vhtrxmcs[10 + 8 + 1]; /* ",vhtrxmcs:" + %08x + trailing NUL */
-	char vhttxmcs[10 + 8 + 1]; /* ",vhttxmcs:" + %08x + trailing NUL */
+/* Compact summary of the IEs of a frame, from which the signature is rendered
+ * in retrieve_sta_taxonomy() */
+struct taxonomy_info {
+#define TAXONOMY_HTCAP		BIT(0)
+#define TAXONOMY_HTAGG		BIT(1)
+#define TAXONOMY_HTMCS		BIT(2)
+#define TAXONOMY_VHTCAP		BIT(3)
+#define TAXONOMY_VHTRXMCS	BIT(4)
+#define TAXONOMY_VHTTXMCS	BIT(5)
+#define TAXONOMY_TXPOW		BIT(6)
+#define TAXONOMY_EXTCAP		BIT(7)
+	u8 present;
+	u8 htagg;
+	u16 htcap;
+	u16 htmcs;
+	u16 txpow;
+	u32 vhtcap;
+	u32 vhtrxmcs;
+	u32 vhttxmcs;
+	u8 extcap_len;
+	u8 wps_len;
+	/* Length of the element list in data[]; each entry is the element ID.
+	 * For Vendor Specific elements, this is followed by one octet
+	 * indicating whether the four octets of vendor OUI and type follow. */
+	u16 elems_len;
+	/* elems_len octets of element list, extcap_len octets of Extended
+	 * Capabilities, and wps_len characters of WPS model name */
+	u8 data[];
+};
+
+
 #define MAX_EXTCAP	254
-	char extcap[8 + 2 * MAX_EXTCAP + 1]; /* ",extcap:" + hex + trailing NUL
-					      */
-	char txpow[7 + 4 + 1]; /* ",txpow:" + %04hx + trailing NUL */
-#define WPS_NAME_LEN		32
-	char wps[WPS_NAME_LEN + 5 + 1]; /* room to prepend ",wps:" + trailing
-					 * NUL */
-	int num = 0;
-	const u8 *ie;
-	size_t ie_len;
-	int ret;
+#define WPS_NAME_LEN	32
 
-	os_memset(htcap, 0, sizeof(htcap));
-	os_memset(htagg, 0, sizeof(htagg));
-	os_memset(htmcs, 0, sizeof(htmcs));
-	os_memset(vhtcap, 0, sizeof(vhtcap));
-	os_memset(vhtrxmcs, 0, sizeof(vhtrxmcs));
-	os_memset(vhttxmcs, 0, sizeof(vhttxmcs));
-	os_memset(extcap, 0, sizeof(extcap));
-	os_memset(txpow, 0, sizeof(txpow));
-	os_memset(wps, 0, sizeof(wps));
-	*fpos = '\0';
+static struct taxonomy_info * taxonomy_parse(const u8 *ies, size_t ies_len)
+{
+	struct taxonomy_info tmp, *info;
+	const u8 *ie = ies, *extcap = NULL;
+	size_t ie_len = ies_len, elems_len = 0;
+	char wps[WPS_NAME_LEN + 1];
+	u8 *elems, *pos;
 
-	if (!ies)
-		return;
-	ie = wpabuf_head(ies);
-	ie_len = wpabuf_len(ies);
+	os_memset(&tmp, 0, sizeof(tmp));
+	elems = os_malloc(ies_len);
+	if (!elems && ies_len)
+		return NULL;
 
 	while (ie_len >= 2) {
 		u8 id, elen;
-		char *sep = (num++ == 0) ? "" : ",";
 
 		id = *ie++;
 		elen = *ie++;
@@ -131,108 +139,181 @@ static void ie_to_string(char *fstr, size_t fstr_len, const struct wpabuf *ies)
 		if (elen > ie_len)
 			break;
 
+		elems[elems_len++] = id;
 		if (id == WLAN_EID_VENDOR_SPECIFIC && elen >= 4) {
 			/* Vendor specific */
 			if (WPA_GET_BE32(ie) == WPS_IE_VENDOR_TYPE) {
 				/* WPS */
 				char model_name[WPS_NAME_LEN + 1];
-				const u8 *data = &ie[4];
-				size_t data_len = elen - 4;
-
-				os_memset(model_name, 0, sizeof(model_name));
-				if (get_wps_name(model_name, WPS_NAME_LEN, data,
-						 data_len)) {
-					os_snprintf(wps, sizeof(wps),
-						    ",wps:%s", model_name);
+				int n;
+
+				n = get_wps_name(model_name, WPS_NAME_LEN,
+						 &ie[4], elen - 4);
+				if (n) {
+					os_memcpy(wps, model_name, n);
+					tmp.wps_len = n;
 				}
 			}
-
-			ret = os_snprintf(fpos, fend - fpos,
-					  "%s%d(%02x%02x%02x,%d)",
-					  sep, id, ie[0], ie[1], ie[2], ie[3]);
+			elems[elems_len++] = 1;
+			os_memcpy(&elems[elems_len], ie, 4);
+			elems_len += 4;
 		} else {
+			if (id == WLAN_EID_VENDOR_SPECIFIC)
+				elems[elems_len++] = 0;
 			if (id == WLAN_EID_HT_CAP && elen >= 2) {
 				/* HT Capabilities (802.11n) */
-				os_snprintf(htcap, sizeof(htcap),
-					    ",htcap:%04hx",
-					    WPA_GET_LE16(ie));
+				tmp.htcap = WPA_GET_LE16(ie);
+				tmp.present |= TAXONOMY_HTCAP;
 			}
 			if (id == WLAN_EID_HT_CAP && elen >= 3) {
 				/* HT Capabilities (802.11n), A-MPDU information
 				 */
-				os_snprintf(htagg, sizeof(htagg),
-					    ",htagg:%02hx", (u16) ie[2]);
+				tmp.htagg = ie[2];
+				tmp.present |= TAXONOMY_HTAGG;
 			}
 			if (id == WLAN_EID_HT_CAP && elen >= 7) {
 				/* HT Capabilities (802.11n), MCS information */
-				os_snprintf(htmcs, sizeof(htmcs),
-					    ",htmcs:%08hx",
-					    (u16) WPA_GET_LE32(ie + 3));
+				tmp.htmcs = (u16) WPA_GET_LE32(ie + 3);
+				tmp.present |= TAXONOMY_HTMCS;
 			}
 			if (id == WLAN_EID_VHT_CAP && elen >= 4) {
 				/* VHT Capabilities (802.11ac) */
-				os_snprintf(vhtcap, sizeof(vhtcap),
-					    ",vhtcap:%08x",
-					    WPA_GET_LE32(ie));
+				tmp.vhtcap = WPA_GET_LE32(ie);
+				tmp.present |= TAXONOMY_VHTCAP;
 			}
 			if (id == WLAN_EID_VHT_CAP && elen >= 8) {
 				/* VHT Capabilities (802.11ac), RX MCS
 				 * information */
-				os_snprintf(vhtrxmcs, sizeof(vhtrxmcs),
-					    ",vhtrxmcs:%08x",
-					    WPA_GET_LE32(ie + 4));
+				tmp.vhtrxmcs = WPA_GET_LE32(ie + 4);
+				tmp.present |= TAXONOMY_VHTRXMCS;
 			}
 			if (id == WLAN_EID_VHT_CAP && elen >= 12) {
 				/* VHT Capabilities (802.11ac), TX MCS
 				 * information */
-				os_snprintf(vhttxmcs, sizeof(vhttxmcs),
-					    ",vhttxmcs:%08x",
-					    WPA_GET_LE32(ie + 8));
+				tmp.vhttxmcs = WPA_GET_LE32(ie + 8);
+				tmp.present |= TAXONOMY_VHTTXMCS;
 			}
 			if (id == WLAN_EID_EXT_CAPAB) {
 				/* Extended Capabilities */
-				int i;
-				int len = (elen < MAX_EXTCAP) ? elen :
+				extcap = ie;
+				tmp.extcap_len = elen < MAX_EXTCAP ? elen :
 					MAX_EXTCAP;
-				char *p = extcap;
-
-				p += os_snprintf(extcap, sizeof(extcap),
-						 ",extcap:");
-				for (i = 0; i < len; i++) {
-					int lim;
-
-					lim = sizeof(extcap) -
-						os_strlen(extcap);
-					if (lim <= 0)
-						break;
-					p += os_snprintf(p, lim, "%02x",
-							 *(ie + i));
-				}
+				tmp.present |= TAXONOMY_EXTCAP;
 			}
 			if (id == WLAN_EID_PWR_CAPABILITY && elen == 2) {
 				/* TX Power */
-				os_snprintf(txpow, sizeof(txpow),
-					    ",txpow:%04hx",
-					    WPA_GET_LE16(ie));
+				tmp.txpow = WPA_GET_LE16(ie);
+				tmp.present |= TAXONOMY_TXPOW;
 			}
+		}
+
+		ie += elen;
+		ie_len -= elen;
+	}
+
+	tmp.elems_len = elems_len;
+	info = os_malloc(sizeof(*info) + elems_len + tmp.extcap_len +
+			 tmp.wps_len);
+	if (info) {
+		*info = tmp;
+		pos = info->data;
+		if (elems_len)
+			os_memcpy(pos, elems, elems_len);
+		pos += elems_len;
+		if (extcap)
+			os_memcpy(pos, extcap, tmp.extcap_len);
+		pos += tmp.extcap_len;
+		os_memcpy(pos, wps, tmp.wps_len);
+	}
+	os_free(elems);
+
+	return info;
+}
+
 
-			ret = os_snprintf(fpos, fend - fpos, "%s%d", sep, id);
+static void taxonomy_update(struct taxonomy_info **info,
+			    const u8 *ie, size_t ie_len)
+{
+	os_free(*info);
+	*info = taxonomy_parse(ie, ie_len);
+}
+
+
+static void info_to_string(char *fstr, size_t fstr_len,
+			   const struct taxonomy_info *info)
+{
+	char *fpos = fstr;
+	char *fend = fstr + fstr_len;
+	const u8 *elem, *end;
+	const char *sep = "";
+	int ret;
+
+	*fpos = '\0';
+
+	if (!info)
+		return;
+
+	elem = info->data;
+	end = elem + info->elems_len;
+	while (elem < end) {
+		if (elem[0] == WLAN_EID_VENDOR_SPECIFIC && elem[1]) {
+			ret = os_snprintf(fpos, fend - fpos,
+					  "%s%d(%02x%02x%02x,%d)",
+					  sep, elem[0], elem[2], elem[3],
+					  elem[4], elem[5]);
+			elem += 6;
+		} else {
+			ret = os_snprintf(fpos, fend - fpos, "%s%d",
+					  sep, elem[0]);
+			elem += elem[0] == WLAN_EID_VENDOR_SPECIFIC ? 2 : 1;
 		}
 		if (os_snprintf_error(fend - fpos, ret))
 			goto fail;
 		fpos += ret;
+		sep = ",";
+	}
 
-		ie += elen;
-		ie_len -= elen;
+#define TAXONOMY_PRINT(flag, fmt, val)					\
+	do {								\
+		if (info->present & (flag)) {				\
+			ret = os_snprintf(fpos, fend - fpos, fmt, val);	\
+			if (os_snprintf_error(fend - fpos, ret))	\
+				goto fail;				\
+			fpos += ret;					\
+		}							\
+	} while (0)
+
+	TAXONOMY_PRINT(TAXONOMY_HTCAP, ",htcap:%04hx", info->htcap);
+	TAXONOMY_PRINT(TAXONOMY_HTAGG, ",htagg:%02hx", (u16) info->htagg);
+	TAXONOMY_PRINT(TAXONOMY_HTMCS, ",htmcs:%08hx", info->htmcs);
+	TAXONOMY_PRINT(TAXONOMY_VHTCAP, ",vhtcap:%08x", info->vhtcap);
+	TAXONOMY_PRINT(TAXONOMY_VHTRXMCS, ",vhtrxmcs:%08x", info->vhtrxmcs);
+	TAXONOMY_PRINT(TAXONOMY_VHTTXMCS, ",vhttxmcs:%08x", info->vhttxmcs);
+	TAXONOMY_PRINT(TAXONOMY_TXPOW, ",txpow:%04hx", info->txpow);
+	TAXONOMY_PRINT(TAXONOMY_EXTCAP, ",extcap:%s", "");
+#undef TAXONOMY_PRINT
+
+	if (info->present & TAXONOMY_EXTCAP) {
+		const u8 *extcap = info->data + info->elems_len;
+
+		if (fend - fpos <= 2 * info->extcap_len)
+			goto fail;
+		fpos += wpa_snprintf_hex(fpos, fend - fpos, extcap,
+					 info->extcap_len);
 	}
 
-	ret = os_snprintf(fpos, fend - fpos, "%s%s%s%s%s%s%s%s%s",
-			  htcap, htagg, htmcs, vhtcap, vhtrxmcs, vhttxmcs,
-			  txpow, extcap, wps);
-	if (os_snprintf_error(fend - fpos, ret)) {
-	fail:
-		fstr[0] = '\0';
+	if (info->wps_len) {
+		ret = os_snprintf(fpos, fend - fpos, ",wps:%.*s",
+				  info->wps_len,
+				  (const char *) info->data + info->elems_len +
+				  info->extcap_len);
+		if (os_snprintf_error(fend - fpos, ret))
+			goto fail;
 	}
+
+	return;
+fail:
+	fstr[0] = '\0';
 }
 
 
@@ -242,7 +323,7 @@ int retrieve_sta_taxonomy(const struct hostapd_data *hapd,
 	int ret;
 	char *pos, *end;
 
-	if (!sta->probe_ie_taxonomy || !sta->assoc_ie_taxonomy)
+	if (!sta->probe_taxonomy || !sta->assoc_taxonomy)
 		return 0;
 
 	ret = os_snprintf(buf, buflen, "wifi4|probe:");
@@ -251,7 +332,7 @@ int retrieve_sta_taxonomy(const struct hostapd_data *hapd,
 	pos = buf + ret;
 	end = buf + buflen;
 
-	ie_to_string(pos, end - pos, sta->probe_ie_taxonomy);
+	info_to_string(pos, end - pos, sta->probe_taxonomy);
 	pos = os_strchr(pos, '\0');
 	if (pos >= end)
 		return 0;
@@ -259,7 +340,7 @@ int retrieve_sta_taxonomy(const struct hostapd_data *hapd,
 	if (os_snprintf_error(end - pos, ret))
 		return 0;
 	pos += ret;
-	ie_to_string(pos, end - pos, sta->assoc_ie_taxonomy);
+	info_to_string(pos, end - pos, sta->assoc_taxonomy);
 	pos = os_strchr(pos, '\0');
 	return pos - buf;
 }
@@ -269,8 +350,7 @@ void taxonomy_sta_info_probe_req(const struct hostapd_data *hapd,
 				 struct sta_info *sta,
 				 const u8 *ie, size_t ie_len)
 {
-	wpabuf_free(sta->probe_ie_taxonomy);
-	sta->probe_ie_taxonomy = wpabuf_alloc_copy(ie, ie_len);
+	taxonomy_update(&sta->probe_taxonomy, ie, ie_len);
 }
 
 
@@ -278,8 +358,7 @@ void taxonomy_hostapd_sta_info_probe_req(const struct hostapd_data *hapd,
 					 struct hostapd_sta_info *info,
 					 const u8 *ie, size_t ie_len)
 {
-	wpabuf_free(info->probe_ie_taxonomy);
-	info->probe_ie_taxonomy = wpabuf_alloc_copy(ie, ie_len);
+	taxonomy_update(&info->probe_taxonomy, ie, ie_len);
 }
 
 
@@ -287,6 +366,5 @@ void taxonomy_sta_info_assoc_req(const struct hostapd_data *hapd,
 				 struct sta_info *sta,
 				 const u8 *ie, size_t ie_len)
 {
-	wpabuf_free(sta->assoc_ie_taxonomy);
-	sta->assoc_ie_taxonomy = wpabuf_alloc_copy(ie, ie_len);
+	taxonomy_update(&sta->assoc_taxonomy, ie, ie_len);
 }
@@ -11,6 +11,7 @@
 #include "utils/includes.h"
 
 #include "utils/common.h"
+#include "utils/eloop.h"
 #include "hostapd.h"
 #include "ap_config.h"
 #include "ap_drv_ops.h"
@@ -130,6 +131,46 @@ static void vlan_dynamic_remove(struct hostapd_data *hapd,
 }
 
 
+static void vlan_precreate(struct hostapd_data *hapd)
+{
+	struct hostapd_vlan *vlan, *wildcard = NULL;
+	struct vlan_description vlan_desc;
+	int *pos;
+
+	if (!hapd->conf->ssid.vlan_precreate || hapd->conf->ssid.per_sta_vif)
+		return;
+
+	for (vlan = hapd->conf->vlan; vlan; vlan = vlan->next) {
+		if (vlan->vlan_id == VLAN_ID_WILDCARD)
+			wildcard = vlan;
+	}
+	if (!wildcard) {
+		wpa_printf(MSG_INFO,
+			   "VLAN: No wildcard VLAN for vlan_precreate");
+		return;
+	}
+
+	for (pos = hapd->conf->ssid.vlan_precreate; *pos; pos++) {
+		for (vlan = hapd->conf->vlan; vlan; vlan = vlan->next) {
+			if (vlan->vlan_id == *pos)
+				break;
+		}
+		if (vlan)
+			continue;
+
+		os_memset(&vlan_desc, 0, sizeof(vlan_desc));
+		vlan_desc.notempty = 1;
+		vlan_desc.untagged = *pos;
+		/* The initial reference is kept until vlan_deinit() so that
+		 * the interface is not removed when stations leave it. */
+		vlan = vlan_add_dynamic(hapd, wildcard, *pos, &vlan_desc);
+		if (!vlan)
+			wpa_printf(MSG_INFO,
+				   "VLAN: Could not pre-create VLAN %d", *pos);
+	}
+}
+
+
 int vlan_init(struct hostapd_data *hapd)
 {
 #ifdef CONFIG_FULL_DYNAMIC_VLAN
@@ -168,12 +209,18 @@ int vlan_init(struct hostapd_data *hapd)
 	if (vlan_dynamic_add(hapd, hapd->conf->vlan))
 		return -1;
 
+	vlan_precreate(hapd);
+
         return 0;
 }
 
 
+static void vlan_teardown_timeout(void *eloop_ctx, void *timeout_ctx);
+
+
 void vlan_deinit(struct hostapd_data *hapd)
 {
+	eloop_cancel_timeout(vlan_teardown_timeout, hapd, ELOOP_ALL_CTX);
 	vlan_dynamic_remove(hapd, hapd->conf->vlan);
 
 #ifdef CONFIG_FULL_DYNAMIC_VLAN
@@ -256,11 +303,71 @@ int vlan_remove_dynamic(struct hostapd_data *hapd, int vlan_id)
 	if (vlan == NULL)
 		return 1;
 
-	if (vlan->dynamic_vlan == 0) {
-		vlan_if_remove(hapd, vlan);
+	if (vlan->dynamic_vlan > 0)
+		return 0;
+
+	if (hapd->conf->ssid.vlan_teardown_delay &&
+	    !hapd->conf->ssid.per_sta_vif) {
+		wpa_printf(MSG_DEBUG,
+			   "VLAN: Remove unused interface %s in %d seconds",
+			   vlan->ifname, hapd->conf->ssid.vlan_teardown_delay);
+		eloop_register_timeout(hapd->conf->ssid.vlan_teardown_delay, 0,
+				       vlan_teardown_timeout, hapd, vlan);
+		return 0;
+	}
+
+	vlan_if_remove(hapd, vlan);
+#ifdef CONFIG_FULL_DYNAMIC_VLAN
+	vlan_dellink(vlan->ifname, hapd);
+#endif /* CONFIG_FULL_DYNAMIC_VLAN */
+
+	return 0;
+}
+
+
+static void vlan_teardown_timeout(void *eloop_ctx, void *timeout_ctx)
+{
+	struct hostapd_data *hapd = eloop_ctx;
+	struct hostapd_vlan *vlan;
+
+	/* The configuration may have been replaced in the meantime */
+	for (vlan = hapd->conf->vlan; vlan; vlan = vlan->next) {
+		if (vlan == timeout_ctx)
+			break;
+	}
+	if (!vlan || vlan->dynamic_vlan > 0)
+		return;
+
+	wpa_printf(MSG_DEBUG, "VLAN: Removing unused interface %s",
+		   vlan->ifname);
+	vlan_if_remove(hapd, vlan);
 #ifdef CONFIG_FULL_DYNAMIC_VLAN
-		vlan_dellink(vlan->ifname, hapd);
+	vlan_dellink(vlan->ifname, hapd);
 #endif /* CONFIG_FULL_DYNAMIC_VLAN */
+}
+
+
+/**
+ * vlan_hold_dynamic - Take a reference to a dynamic VLAN interface
+ * @hapd: Pointer to BSS data
+ * @vlan: VLAN entry
+ * Returns: 1 if a reference was taken, 0 if @vlan is not a dynamic VLAN
+ *
+ * This also takes over an interface that is waiting to be removed after the
+ * last station left it (vlan_teardown_delay).
+ */
+int vlan_hold_dynamic(struct hostapd_data *hapd, struct hostapd_vlan *vlan)
+{
+	if (vlan->dynamic_vlan > 0) {
+		vlan->dynamic_vlan++;
+		return 1;
+	}
+
+	if (eloop_cancel_timeout(vlan_teardown_timeout, hapd, vlan) > 0) {
+		wpa_printf(MSG_DEBUG, "VLAN: Reusing unused interface %s",
+			   vlan->ifname);
+		vlan->dynamic_vlan = 1;
+		return 1;
 	}
 
 	return 0;
@@ -18,6 +18,7 @@ struct hostapd_vlan * vlan_add_dynamic(struct hostapd_data *hapd,
 				       int vlan_id,
 				       struct vlan_description *vlan_desc);
 int vlan_remove_dynamic(struct hostapd_data *hapd, int vlan_id);
+int vlan_hold_dynamic(struct hostapd_data *hapd, struct hostapd_vlan *vlan);
 #else /* CONFIG_NO_VLAN */
 static inline int vlan_init(struct hostapd_data *hapd)
 {
@@ -39,6 +40,12 @@ static inline int vlan_remove_dynamic(struct hostapd_data *hapd, int vlan_id)
 {
 	return -1;
 }
+
+static inline int vlan_hold_dynamic(struct hostapd_data *hapd,
+				    struct hostapd_vlan *vlan)
+{
+	return 0;
+}
 #endif /* CONFIG_NO_VLAN */
 
 #endif /* VLAN_INIT_H */
@@ -1035,7 +1035,7 @@ int wnm_send_bss_tm_req(struct hostapd_data *hapd, struct sta_info *sta,
 			unsigned int links = 0;
 
 			for (i = 0; i < MAX_NUM_MLD_LINKS; i++) {
-				if (sta->mld_info.links[i].valid)
+				if (sta->mld_info->links[i].valid)
 					links++;
 			}
 
@@ -1043,7 +1043,7 @@ int wnm_send_bss_tm_req(struct hostapd_data *hapd, struct sta_info *sta,
 				wpa_printf(MSG_DEBUG,
 					   "WNM: Only terminating one link - other links remains associated for "
 					   MACSTR,
-					   MAC2STR(sta->mld_info.common_info.mld_addr));
+					   MAC2STR(sta->mld_info->common_info.mld_addr));
 				return 0;
 			}
 		}
@@ -73,12 +73,15 @@ static int ieee80211w_kde_len(struct wpa_state_machine *sm);
 static u8 * ieee80211w_kde_add(struct wpa_state_machine *sm, u8 *pos);
 static void wpa_group_update_gtk(struct wpa_authenticator *wpa_auth,
 				 struct wpa_group *group);
+static void wpa_group_update_dequeue(struct wpa_state_machine *sm);
+static void wpa_group_update_flush_queue(struct wpa_authenticator *wpa_auth);
 
 
 static const u32 eapol_key_timeout_first = 100; /* ms */
 static const u32 eapol_key_timeout_subseq = 1000; /* ms */
 static const u32 eapol_key_timeout_first_group = 500; /* ms */
 static const u32 eapol_key_timeout_no_retrans = 4000; /* ms */
+static const u32 eapol_key_timeout_no_ack = 50; /* ms */
 
 /* TODO: make these configurable */
 static const int dot11RSNAConfigPMKLifetime = 43200;
@@ -222,6 +225,15 @@ wpa_get_primary_auth(struct wpa_authenticator *wpa_auth)
 }
 
 
+static inline bool wpa_auth_sta_is_dozing(struct wpa_authenticator *wpa_auth,
+					  const u8 *addr)
+{
+	if (!wpa_auth->cb->sta_is_dozing)
+		return false;
+	return wpa_auth->cb->sta_is_dozing(wpa_auth->cb_ctx, addr);
+}
+
+
 static inline int wpa_auth_mic_failure_report(
 	struct wpa_authenticator *wpa_auth, const u8 *addr)
 {
@@ -239,6 +251,14 @@ static inline void wpa_auth_psk_failure_report(
 }
 
 
+static inline void wpa_auth_psk_matched(struct wpa_authenticator *wpa_auth,
+					const u8 *addr, const u8 *psk)
+{
+	if (wpa_auth->cb->psk_matched)
+		wpa_auth->cb->psk_matched(wpa_auth->cb_ctx, addr, psk);
+}
+
+
 static inline void wpa_auth_set_eapol(struct wpa_authenticator *wpa_auth,
 				      const u8 *addr, wpa_eapol_variable var,
 				      int value)
@@ -640,6 +660,16 @@ static void wpa_auth_pmksa_free_cb(struct rsn_pmksa_cache_entry *entry,
 }
 
 
+static void wpa_auth_pmksa_add_cb(struct rsn_pmksa_cache_entry *entry,
+				  void *ctx)
+{
+	struct wpa_authenticator *wpa_auth = ctx;
+
+	if (wpa_auth->cb->pmksa_added)
+		wpa_auth->cb->pmksa_added(wpa_auth->cb_ctx, entry);
+}
+
+
 static int wpa_group_init_gmk_and_counter(struct wpa_authenticator *wpa_auth,
 					  struct wpa_group *group)
 {
@@ -739,6 +769,8 @@ struct wpa_authenticator * wpa_init(const u8 *addr,
 	wpa_auth = os_zalloc(sizeof(struct wpa_authenticator));
 	if (!wpa_auth)
 		return NULL;
+	dl_list_init(&wpa_auth->gupdate_queue);
+	dl_list_init(&wpa_auth->gupdate_queue_dozing);
 
 	os_memcpy(wpa_auth->addr, addr, ETH_ALEN);
 	os_memcpy(&wpa_auth->conf, conf, sizeof(*conf));
@@ -777,6 +809,9 @@ struct wpa_authenticator * wpa_init(const u8 *addr,
 		os_free(wpa_auth);
 		return NULL;
 	}
+	pmksa_cache_auth_set_add_cb(wpa_auth->pmksa, wpa_auth_pmksa_add_cb);
+	pmksa_cache_auth_set_max_entries(wpa_auth->pmksa,
+					 conf->pmksa_cache_size);
 
 #ifdef CONFIG_IEEE80211R_AP
 	wpa_auth->ft_pmk_cache = wpa_ft_pmk_cache_init();
@@ -871,6 +906,7 @@ void wpa_deinit(struct wpa_authenticator *wpa_auth)
 	/* TODO: Assign ML primary authenticator to next link authenticator and
 	 * start rekey timer. */
 	eloop_cancel_timeout(wpa_rekey_gtk, wpa_auth, NULL);
+	wpa_group_update_flush_queue(wpa_auth);
 
 	pmksa_cache_auth_deinit(wpa_auth->pmksa);
 
@@ -918,6 +954,8 @@ int wpa_reconfig(struct wpa_authenticator *wpa_auth,
 		wpa_printf(MSG_ERROR, "Could not generate WPA IE.");
 		return -1;
 	}
+	pmksa_cache_auth_set_max_entries(wpa_auth->pmksa,
+					 conf->pmksa_cache_size);
 
 	/*
 	 * Reinitialize GTK to make sure it is suitable for the new
@@ -1092,6 +1130,7 @@ void wpa_auth_sta_deinit(struct wpa_state_machine *sm)
 	sm->pending_1_of_4_timeout = 0;
 	eloop_cancel_timeout(wpa_sm_call_step, sm, NULL);
 	eloop_cancel_timeout(wpa_rekey_ptk, wpa_auth, sm);
+	wpa_group_update_dequeue(sm);
 #ifdef CONFIG_IEEE80211R_AP
 	wpa_ft_sta_deinit(sm);
 #endif /* CONFIG_IEEE80211R_AP */
@@ -1331,6 +1370,10 @@ static int wpa_try_alt_snonce(struct wpa_state_machine *sm, u8 *data,
 
 		if (wpa_verify_key_mic(sm->wpa_key_mgmt, pmk_len, &PTK,
 				       data, data_len) == 0) {
+			if (wpa_key_mgmt_wpa_psk(sm->wpa_key_mgmt) &&
+			    !wpa_key_mgmt_sae(sm->wpa_key_mgmt))
+				wpa_auth_psk_matched(sm->wpa_auth, sm->addr,
+						     pmk);
 			if (sm->PMK != pmk) {
 				os_memcpy(sm->PMK, pmk, pmk_len);
 				sm->pmk_len = pmk_len;
@@ -3662,6 +3705,7 @@ SM_STATE(WPA_PTK, PTKCALCNEGOTIATING)
 	SM_ENTRY_MA(WPA_PTK, PTKCALCNEGOTIATING, wpa_ptk);
 	sm->EAPOLKeyReceived = false;
 	sm->update_snonce = false;
+	sm->psk_mic_trials = 0;
 	os_memset(&PTK, 0, sizeof(PTK));
 
 	mic_len = wpa_mic_len(sm->wpa_key_mgmt, sm->pmk_len);
@@ -3681,6 +3725,7 @@ SM_STATE(WPA_PTK, PTKCALCNEGOTIATING)
 			if (!pmk)
 				break;
 			psk_found = 1;
+			sm->psk_mic_trials++;
 #ifdef CONFIG_IEEE80211R_AP
 			if (wpa_key_mgmt_ft_psk(sm->wpa_key_mgmt)) {
 				os_memcpy(sm->xxkey, pmk, pmk_len);
@@ -3709,6 +3754,13 @@ SM_STATE(WPA_PTK, PTKCALCNEGOTIATING)
 		    wpa_verify_key_mic(sm->wpa_key_mgmt, pmk_len, &PTK,
 				       sm->last_rx_eapol_key,
 				       sm->last_rx_eapol_key_len) == 0) {
+			if (psk_found) {
+				wpa_printf(MSG_DEBUG,
+					   "WPA: PSK found after %u MIC trial(s)",
+					   sm->psk_mic_trials);
+				wpa_auth_psk_matched(sm->wpa_auth, sm->addr,
+						     pmk);
+			}
 			if (sm->PMK != pmk) {
 				os_memcpy(sm->PMK, pmk, pmk_len);
 				sm->pmk_len = pmk_len;
@@ -5505,8 +5557,10 @@ SM_STATE(WPA_PTK_GROUP, REKEYESTABLISHED)
 SM_STATE(WPA_PTK_GROUP, KEYERROR)
 {
 	SM_ENTRY_MA(WPA_PTK_GROUP, KEYERROR, wpa_ptk_group);
-	if (sm->GUpdateStationKeys)
+	if (sm->GUpdateStationKeys) {
+		sm->group->rekey_failures++;
 		wpa_gkeydone_sta(sm);
+	}
 	if (sm->wpa_auth->conf.no_disconnect_on_group_keyerror &&
 	    sm->wpa == WPA_VERSION_WPA2) {
 		wpa_auth_vlogger(sm->wpa_auth, wpa_auth_get_spa(sm),
@@ -5531,7 +5585,7 @@ SM_STEP(WPA_PTK_GROUP)
 		sm->PtkGroupInit = false;
 	} else switch (sm->wpa_ptk_group_state) {
 	case WPA_PTK_GROUP_IDLE:
-		if (sm->GUpdateStationKeys ||
+		if ((sm->GUpdateStationKeys && !sm->GUpdateQueued) ||
 		    (sm->wpa == WPA_VERSION_WPA && sm->PInitAKeys))
 			SM_ENTER(WPA_PTK_GROUP, REKEYNEGOTIATING);
 		break;
@@ -5635,6 +5689,92 @@ static void wpa_group_gtk_init(struct wpa_authenticator *wpa_auth,
 }
 
 
+static void wpa_group_update_pace(void *eloop_ctx, void *timeout_ctx)
+{
+	struct wpa_authenticator *wpa_auth = eloop_ctx;
+	unsigned int rate = wpa_auth->conf.wpa_group_update_rate;
+	unsigned int count, msec;
+	struct wpa_state_machine *sm;
+
+	/* Start at most rate/10 Group Key Handshakes every 100 ms or one at a
+	 * time with lower rates */
+	if (!rate)
+		count = (unsigned int) -1;
+	else if (rate >= 10)
+		count = rate / 10;
+	else
+		count = 1;
+
+	while (count--) {
+		sm = dl_list_first(&wpa_auth->gupdate_queue,
+				   struct wpa_state_machine, gupdate_list);
+		if (!sm)
+			sm = dl_list_first(&wpa_auth->gupdate_queue_dozing,
+					   struct wpa_state_machine,
+					   gupdate_list);
+		if (!sm)
+			break;
+		wpa_group_update_dequeue(sm);
+		/* GUpdateStationKeys is cleared if the STA reauthenticated
+		 * while waiting */
+		if (sm->GUpdateStationKeys)
+			wpa_sm_step(sm);
+	}
+
+	if (dl_list_empty(&wpa_auth->gupdate_queue) &&
+	    dl_list_empty(&wpa_auth->gupdate_queue_dozing))
+		return;
+
+	msec = rate >= 10 ? 100 : 1000 / rate;
+	eloop_register_timeout(msec / 1000, (msec % 1000) * 1000,
+			       wpa_group_update_pace, wpa_auth, NULL);
+}
+
+
+static void wpa_group_update_enqueue(struct wpa_state_machine *sm)
+{
+	struct wpa_authenticator *wpa_auth = sm->wpa_auth;
+
+	if (sm->GUpdateQueued)
+		return;
+
+	if (wpa_auth_sta_is_dozing(wpa_auth, sm->addr))
+		dl_list_add_tail(&wpa_auth->gupdate_queue_dozing,
+				 &sm->gupdate_list);
+	else
+		dl_list_add_tail(&wpa_auth->gupdate_queue, &sm->gupdate_list);
+	sm->GUpdateQueued = true;
+
+	if (!eloop_is_timeout_registered(wpa_group_update_pace, wpa_auth,
+					 NULL))
+		eloop_register_timeout(0, 0, wpa_group_update_pace, wpa_auth,
+				       NULL);
+}
+
+
+static void wpa_group_update_dequeue(struct wpa_state_machine *sm)
+{
+	if (!sm->GUpdateQueued)
+		return;
+	dl_list_del(&sm->gupdate_list);
+	sm->GUpdateQueued = false;
+}
+
+
+static void wpa_group_update_flush_queue(struct wpa_authenticator *wpa_auth)
+{
+	struct wpa_state_machine *sm, *n;
+
+	eloop_cancel_timeout(wpa_group_update_pace, wpa_auth, NULL);
+	dl_list_for_each_safe(sm, n, &wpa_auth->gupdate_queue,
+			      struct wpa_state_machine, gupdate_list)
+		wpa_group_update_dequeue(sm);
+	dl_list_for_each_safe(sm, n, &wpa_auth->gupdate_queue_dozing,
+			      struct wpa_state_machine, gupdate_list)
+		wpa_group_update_dequeue(sm);
+}
+
+
 static int wpa_group_update_sta(struct wpa_state_machine *sm, void *ctx)
 {
 	struct wpa_authenticator *wpa_auth = sm->wpa_auth;
@@ -5697,6 +5837,11 @@ static int wpa_group_update_sta(struct wpa_state_machine *sm, void *ctx)
 
 	sm->GUpdateStationKeys = true;
 
+	if (ctx && wpa_auth->conf.wpa_group_update_rate) {
+		wpa_group_update_enqueue(sm);
+		return 0;
+	}
+
 	wpa_sm_step(sm);
 	return 0;
 }
@@ -5891,6 +6036,9 @@ skip_update:
 	wpa_auth_for_each_sta(wpa_auth, wpa_group_update_sta, group);
 	wpa_printf(MSG_DEBUG, "wpa_group_setkeys: GKeyDoneStations=%d",
 		   group->GKeyDoneStations);
+	os_get_reltime(&group->rekey_start);
+	group->rekey_stations = group->GKeyDoneStations;
+	group->rekey_failures = 0;
 }
 
 
@@ -5972,6 +6120,21 @@ static int wpa_group_setkeysdone(struct wpa_authenticator *wpa_auth,
 	wpa_printf(MSG_DEBUG,
 		   "WPA: group state machine entering state SETKEYSDONE (VLAN-ID %d)",
 		   group->vlan_id);
+	if (group->wpa_group_state == WPA_GROUP_SETKEYS) {
+		struct os_reltime now, age;
+
+		os_get_reltime(&now);
+		os_reltime_sub(&now, &group->rekey_start, &age);
+		wpa_auth->gtk_rekeys++;
+		wpa_auth->gtk_rekey_stations = group->rekey_stations;
+		wpa_auth->gtk_rekey_failures = group->rekey_failures;
+		wpa_auth->gtk_rekey_msec = age.sec * 1000 + age.usec / 1000;
+		wpa_printf(MSG_DEBUG,
+			   "WPA: GTK rekey completed for %u STA(s) in %u ms (%u failed)",
+			   wpa_auth->gtk_rekey_stations,
+			   wpa_auth->gtk_rekey_msec,
+			   wpa_auth->gtk_rekey_failures);
+	}
 	group->changed = true;
 	group->wpa_group_state = WPA_GROUP_SETKEYSDONE;
 
@@ -6242,6 +6405,32 @@ int wpa_get_mib(struct wpa_authenticator *wpa_auth, char *buf, size_t buflen)
 		return len;
 	len += ret;
 
+	ret = os_snprintf(buf + len, buflen - len,
+			  "hostapdGTKRekeys=%u\n"
+			  "hostapdGTKRekeyStations=%u\n"
+			  "hostapdGTKRekeyFailures=%u\n"
+			  "hostapdGTKRekeyDurationMs=%u\n",
+			  wpa_auth->gtk_rekeys,
+			  wpa_auth->gtk_rekey_stations,
+			  wpa_auth->gtk_rekey_failures,
+			  wpa_auth->gtk_rekey_msec);
+	if (os_snprintf_error(buflen - len, ret))
+		return len;
+	len += ret;
+
+#ifdef CONFIG_IEEE80211R_AP
+	ret = os_snprintf(buf + len, buflen - len,
+			  "hostapdFTPMKR1Pushes=%u\n"
+			  "hostapdFTPMKR1PushHits=%u\n"
+			  "hostapdFTPMKR1PullFallbacks=%u\n",
+			  wpa_auth->ft_pmk_r1_pushes,
+			  wpa_auth->ft_pmk_r1_push_hits,
+			  wpa_auth->ft_pmk_r1_pull_fallbacks);
+	if (os_snprintf_error(buflen - len, ret))
+		return len;
+	len += ret;
+#endif /* CONFIG_IEEE80211R_AP */
+
 	return len;
 }
 
@@ -6290,12 +6479,14 @@ int wpa_get_mib_sta(struct wpa_state_machine *sm, char *buf, size_t buflen)
 			  "AKMSuiteSelector=" RSN_SUITE "\n"
 			  "hostapdWPAPTKState=%d\n"
 			  "hostapdWPAPTKGroupState=%d\n"
-			  "hostapdMFPR=%d\n",
+			  "hostapdMFPR=%d\n"
+			  "hostapdWPAPSKMICTrials=%u\n",
 			  sm->wpa,
 			  RSN_SUITE_ARG(wpa_akm_to_suite(sm->wpa_key_mgmt)),
 			  sm->wpa_ptk_state,
 			  sm->wpa_ptk_group_state,
-			  sm->mfpr);
+			  sm->mfpr,
+			  sm->psk_mic_trials);
 	if (os_snprintf_error(buflen - len, ret))
 		return len;
 	len += ret;
@@ -6858,12 +7049,42 @@ int wpa_auth_sta_set_vlan(struct wpa_state_machine *sm, int vlan_id)
 
 
 void wpa_auth_eapol_key_tx_status(struct wpa_authenticator *wpa_auth,
-				  struct wpa_state_machine *sm, int ack)
+				  struct wpa_state_machine *sm, int ack,
+				  const struct wpa_eapol_key *key)
 {
+	unsigned int ctr, max_ctr;
+
 	if (!wpa_auth || !sm)
 		return;
 	wpa_printf(MSG_DEBUG, "WPA: EAPOL-Key TX status for STA " MACSTR
 		   " ack=%d", MAC2STR(wpa_auth_get_spa(sm)), ack);
+
+	if (WPA_GET_BE16(key->key_info) & WPA_KEY_INFO_KEY_TYPE) {
+		ctr = sm->TimeoutCtr;
+		max_ctr = wpa_auth->conf.wpa_pairwise_update_count;
+	} else {
+		ctr = sm->GTimeoutCtr;
+		max_ctr = wpa_auth->conf.wpa_group_update_count;
+	}
+	if (!ack && !wpa_auth->conf.wpa_disable_eapol_key_retries &&
+	    ctr < max_ctr && sm->key_replay[0].valid &&
+	    os_memcmp(key->replay_counter, sm->key_replay[0].counter,
+		      WPA_REPLAY_COUNTER_LEN) == 0 &&
+	    eloop_deplete_timeout(0, eapol_key_timeout_no_ack * 1000,
+				  wpa_send_eapol_timeout, wpa_auth, sm) == 1) {
+		/*
+		 * The driver has given up on the latest EAPOL-Key frame, so
+		 * there is no point in waiting for a response for the full
+		 * timeout. Retransmit soon instead unless this was the last
+		 * allowed attempt.
+		 */
+		wpa_printf(MSG_DEBUG,
+			   "WPA: Retransmit unacknowledged EAPOL-Key frame in %u ms (retry counter %u)",
+			   eapol_key_timeout_no_ack, ctr);
+		sm->pending_1_of_4_timeout = 0;
+		return;
+	}
+
 	if (sm->pending_1_of_4_timeout && ack) {
 		/*
 		 * Some deployed supplicant implementations update their SNonce
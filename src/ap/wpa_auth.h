@@ -48,6 +48,7 @@ struct ft_rrb_frame {
 #define FT_PACKET_R0KH_R1KH_PUSH 0x03
 #define FT_PACKET_R0KH_R1KH_SEQ_REQ 0x04
 #define FT_PACKET_R0KH_R1KH_SEQ_RESP 0x05
+#define FT_PACKET_R0KH_R1KH_PUSH_BATCH 0x06
 
 /* packet layout
  *  IEEE 802 extended OUI ethertype frame header
@@ -89,6 +90,9 @@ struct ft_rrb_frame {
 #define FT_RRB_RADIUS_CUI    16
 #define FT_RRB_SESSION_TIMEOUT  17 /* le32 seconds */
 
+/* encrypted TLVs of a single PMK-R1 push (FT_PACKET_R0KH_R1KH_PUSH_BATCH) */
+#define FT_RRB_BATCH_ENTRY   18
+
 struct ft_rrb_tlv {
 	le16 type;
 	le16 len;
@@ -165,6 +169,8 @@ struct ft_remote_r1kh {
 	u8 id[FT_R1KH_ID_LEN];
 	u8 key[32];
 	struct ft_remote_seq *seq;
+	unsigned int roams; /* PMK-R1 pull requests received from this R1KH */
+	struct wpabuf *push_batch; /* pending FT_RRB_BATCH_ENTRY TLVs */
 };
 
 
@@ -183,6 +189,7 @@ struct wpa_auth_config {
 	int wpa_ptk_rekey;
 	int wpa_deny_ptk0_rekey;
 	u32 wpa_group_update_count;
+	unsigned int wpa_group_update_rate; /* STAs/second; 0 = no limit */
 	u32 wpa_pairwise_update_count;
 	int wpa_disable_eapol_key_retries;
 	int rsn_pairwise;
@@ -194,6 +201,8 @@ struct wpa_auth_config {
 	int wmm_uapsd;
 	int disable_pmksa_caching;
 	int okc;
+	int pmksa_cache_shared;
+	unsigned int pmksa_cache_size;
 	int tx_status;
 	enum mfp_options ieee80211w;
 	enum mfp_options rsn_override_mfp;
@@ -220,7 +229,10 @@ struct wpa_auth_config {
 	u32 reassociation_deadline;
 	struct ft_remote_r0kh **r0kh_list;
 	struct ft_remote_r1kh **r1kh_list;
+	unsigned int *rxkh_gen;
 	int pmk_r1_push;
+	int pmk_r1_push_count;
+	int pmk_r1_push_batch; /* ms */
 	int ft_over_ds;
 	int ft_psk_generate_local;
 #endif /* CONFIG_IEEE80211R_AP */
@@ -363,6 +375,7 @@ struct wpa_auth_callbacks {
 	void (*disconnect)(void *ctx, const u8 *addr, u16 reason);
 	int (*mic_failure_report)(void *ctx, const u8 *addr);
 	void (*psk_failure_report)(void *ctx, const u8 *addr);
+	void (*psk_matched)(void *ctx, const u8 *addr, const u8 *psk);
 	void (*set_eapol)(void *ctx, const u8 *addr, wpa_eapol_variable var,
 			  int value);
 	int (*get_eapol)(void *ctx, const u8 *addr, wpa_eapol_variable var);
@@ -381,6 +394,8 @@ struct wpa_auth_callbacks {
 						 void *ctx), void *cb_ctx);
 	int (*for_each_auth)(void *ctx, int (*cb)(struct wpa_authenticator *a,
 						  void *ctx), void *cb_ctx);
+	void (*pmksa_added)(void *ctx, struct rsn_pmksa_cache_entry *entry);
+	bool (*sta_is_dozing)(void *ctx, const u8 *addr);
 	int (*send_ether)(void *ctx, const u8 *dst, u16 proto, const u8 *data,
 			  size_t data_len);
 	int (*send_oui)(void *ctx, const u8 *dst, u8 oui_suffix, const u8 *data,
@@ -417,6 +432,7 @@ struct wpa_auth_callbacks {
 			      const u8 *data, size_t data_len);
 	int (*add_tspec)(void *ctx, const u8 *sta_addr, u8 *tspec_ie,
 			 size_t tspec_ielen);
+	bool (*is_neighbor)(void *ctx, const u8 *bssid);
 #endif /* CONFIG_IEEE80211R_AP */
 #ifdef CONFIG_MESH
 	int (*start_ampe)(void *ctx, const u8 *sta_addr);
@@ -543,7 +559,8 @@ void wpa_auth_pmksa_set_to_sm(struct rsn_pmksa_cache_entry *pmksa,
 			      u8 *pmkid, u8 *pmk, size_t *pmk_len);
 int wpa_auth_sta_set_vlan(struct wpa_state_machine *sm, int vlan_id);
 void wpa_auth_eapol_key_tx_status(struct wpa_authenticator *wpa_auth,
-				  struct wpa_state_machine *sm, int ack);
+				  struct wpa_state_machine *sm, int ack,
+				  const struct wpa_eapol_key *key);
 
 #ifdef CONFIG_IEEE80211R_AP
 u8 * wpa_sm_write_assoc_resp_ies(struct wpa_state_machine *sm, u8 *pos,
@@ -46,6 +46,12 @@ static int wpa_ft_send_rrb_auth_resp(struct wpa_state_machine *sm,
 static void ft_finish_pull(struct wpa_state_machine *sm);
 static void wpa_ft_expire_pull(void *eloop_ctx, void *timeout_ctx);
 static void wpa_ft_rrb_seq_timeout(void *eloop_ctx, void *timeout_ctx);
+static void wpa_ft_rrb_push_batch_timeout(void *eloop_ctx, void *timeout_ctx);
+
+/* Maximum plaintext length of a batched PMK-R1 push; leaves room for the
+ * authenticated TLVs, the AES-SIV tag, and the frame headers within the
+ * Ethernet MTU. */
+#define FT_RRB_BATCH_MAX_LEN 1300
 
 struct tlv_list {
 	u16 type;
@@ -905,6 +911,7 @@ int wpa_write_ftie(struct wpa_auth_config *conf, int key_mgmt, size_t key_len,
 /* A packet to be handled after seq response */
 struct ft_remote_item {
 	struct dl_list list;
+	struct ft_remote_item *pool_next; /* when in wpa_auth->ft_item_pool */
 
 	u8 nonce[FT_RRB_NONCE_LEN];
 	struct os_reltime nonce_ts;
@@ -922,13 +929,56 @@ struct ft_remote_item {
 };
 
 
-static void wpa_ft_rrb_seq_free(struct ft_remote_item *item)
+static struct ft_remote_item *
+wpa_ft_rrb_item_alloc(struct wpa_authenticator *wpa_auth)
+{
+	struct ft_remote_item *item = wpa_auth->ft_item_pool;
+
+	if (!item)
+		return os_zalloc(sizeof(*item));
+
+	wpa_auth->ft_item_pool = item->pool_next;
+	wpa_auth->ft_item_pool_len--;
+	os_memset(item, 0, sizeof(*item));
+	return item;
+}
+
+
+static void wpa_ft_rrb_item_release(struct wpa_authenticator *wpa_auth,
+				    struct ft_remote_item *item)
 {
-	eloop_cancel_timeout(wpa_ft_rrb_seq_timeout, ELOOP_ALL_CTX, item);
-	dl_list_del(&item->list);
 	bin_clear_free(item->enc, item->enc_len);
 	os_free(item->auth);
-	os_free(item);
+	if (wpa_auth->ft_item_pool_len >= ftRRBmaxQueueLen) {
+		os_free(item);
+		return;
+	}
+
+	os_memset(item, 0, sizeof(*item));
+	item->pool_next = wpa_auth->ft_item_pool;
+	wpa_auth->ft_item_pool = item;
+	wpa_auth->ft_item_pool_len++;
+}
+
+
+static void wpa_ft_rrb_item_pool_flush(struct wpa_authenticator *wpa_auth)
+{
+	struct ft_remote_item *item;
+
+	while ((item = wpa_auth->ft_item_pool)) {
+		wpa_auth->ft_item_pool = item->pool_next;
+		os_free(item);
+	}
+	wpa_auth->ft_item_pool_len = 0;
+}
+
+
+static void wpa_ft_rrb_seq_free(struct wpa_authenticator *wpa_auth,
+				struct ft_remote_item *item)
+{
+	eloop_cancel_timeout(wpa_ft_rrb_seq_timeout, ELOOP_ALL_CTX, item);
+	dl_list_del(&item->list);
+	wpa_ft_rrb_item_release(wpa_auth, item);
 }
 
 
@@ -942,16 +992,17 @@ static void wpa_ft_rrb_seq_flush(struct wpa_authenticator *wpa_auth,
 		if (cb && item->cb)
 			item->cb(wpa_auth, item->src_addr, item->enc,
 				 item->enc_len, item->auth, item->auth_len, 1);
-		wpa_ft_rrb_seq_free(item);
+		wpa_ft_rrb_seq_free(wpa_auth, item);
 	}
 }
 
 
 static void wpa_ft_rrb_seq_timeout(void *eloop_ctx, void *timeout_ctx)
 {
+	struct wpa_authenticator *wpa_auth = eloop_ctx;
 	struct ft_remote_item *item = timeout_ctx;
 
-	wpa_ft_rrb_seq_free(item);
+	wpa_ft_rrb_seq_free(wpa_auth, item);
 }
 
 
@@ -989,7 +1040,7 @@ wpa_ft_rrb_seq_req(struct wpa_authenticator *wpa_auth,
 	wpa_printf(MSG_DEBUG, "FT: Send sequence number request from " MACSTR
 		   " to " MACSTR,
 		   MAC2STR(wpa_auth->addr), MAC2STR(src_addr));
-	item = os_zalloc(sizeof(*item));
+	item = wpa_ft_rrb_item_alloc(wpa_auth);
 	if (!item)
 		goto err;
 
@@ -1040,11 +1091,8 @@ wpa_ft_rrb_seq_req(struct wpa_authenticator *wpa_auth,
 	return 0;
 err:
 	wpa_printf(MSG_DEBUG, "FT: Failed to send sequence number request");
-	if (item) {
-		os_free(item->auth);
-		bin_clear_free(item->enc, item->enc_len);
-		os_free(item);
-	}
+	if (item)
+		wpa_ft_rrb_item_release(wpa_auth, item);
 
 	return -1;
 }
@@ -1231,6 +1279,7 @@ struct wpa_ft_pmk_r1_sa {
 	u8 *radius_cui;
 	size_t radius_cui_len;
 	os_time_t session_timeout; /* 0 for no expiration */
+	bool pushed; /* received in a PMK-R1 push and not yet used */
 	/* TODO: radius_class, EAP type */
 };
 
@@ -1447,7 +1496,8 @@ static int wpa_ft_store_pmk_r1(struct wpa_authenticator *wpa_auth,
 			       const struct vlan_description *vlan,
 			       int expires_in, int session_timeout,
 			       const u8 *identity, size_t identity_len,
-			       const u8 *radius_cui, size_t radius_cui_len)
+			       const u8 *radius_cui, size_t radius_cui_len,
+			       bool pushed)
 {
 	struct wpa_ft_pmk_cache *cache = wpa_auth->ft_pmk_cache;
 	int max_expires_in = wpa_auth->conf.r1_max_key_lifetime;
@@ -1493,6 +1543,7 @@ static int wpa_ft_store_pmk_r1(struct wpa_authenticator *wpa_auth,
 	}
 	if (session_timeout > 0)
 		r1->session_timeout = now.sec + session_timeout;
+	r1->pushed = pushed;
 
 	dl_list_add(&cache->pmk_r1, &r1->list);
 
@@ -1548,6 +1599,10 @@ int wpa_ft_fetch_pmk_r1(struct wpa_authenticator *wpa_auth,
 				*session_timeout = 1;
 			else if (session_timeout)
 				*session_timeout = 0;
+			if (r1->pushed) {
+				wpa_auth->ft_pmk_r1_push_hits++;
+				r1->pushed = false;
+			}
 			return 0;
 		}
 	}
@@ -1573,6 +1628,131 @@ static int wpa_ft_rrb_init_r0kh_seq(struct ft_remote_r0kh *r0kh)
 }
 
 
+static u32 wpa_ft_rkh_hash(const u8 *id, size_t id_len)
+{
+	u32 hash = 2166136261U;
+	size_t i;
+
+	/* FNV-1a */
+	for (i = 0; i < id_len; i++) {
+		hash ^= id[i];
+		hash *= 16777619U;
+	}
+
+	return hash;
+}
+
+
+static void wpa_ft_rkh_changed(struct wpa_authenticator *wpa_auth)
+{
+	if (wpa_auth->conf.rxkh_gen)
+		(*wpa_auth->conf.rxkh_gen)++;
+	wpa_auth->rkh_index_valid = false;
+}
+
+
+static void wpa_ft_rkh_index_free(struct wpa_authenticator *wpa_auth)
+{
+	os_free(wpa_auth->r0kh_index);
+	wpa_auth->r0kh_index = NULL;
+	wpa_auth->r0kh_index_size = 0;
+	os_free(wpa_auth->r1kh_index);
+	wpa_auth->r1kh_index = NULL;
+	wpa_auth->r1kh_index_size = 0;
+	wpa_auth->r0kh_wildcard = NULL;
+	wpa_auth->r1kh_wildcard = NULL;
+	wpa_auth->rkh_index_valid = false;
+}
+
+
+static size_t wpa_ft_rkh_index_size(size_t count)
+{
+	size_t size = 8;
+
+	/* Keep the load factor at or below 50% */
+	while (size < 2 * count)
+		size *= 2;
+	return size;
+}
+
+
+/*
+ * Make sure the R0KH/R1KH hash indexes match the current configuration. The
+ * indexes resolve duplicate IDs and multiple wildcard entries to the last one
+ * in the list to match the behavior of a linear scan through the list.
+ */
+static int wpa_ft_rkh_index_update(struct wpa_authenticator *wpa_auth)
+{
+	struct ft_remote_r0kh *r0kh;
+	struct ft_remote_r1kh *r1kh;
+	size_t count, idx, mask;
+
+	if (wpa_auth->rkh_index_valid &&
+	    wpa_auth->rkh_index_r0kh_list == wpa_auth->conf.r0kh_list &&
+	    (!wpa_auth->conf.rxkh_gen ||
+	     wpa_auth->rkh_index_gen == *wpa_auth->conf.rxkh_gen))
+		return 0;
+
+	wpa_ft_rkh_index_free(wpa_auth);
+	if (!wpa_auth->conf.r0kh_list || !wpa_auth->conf.r1kh_list)
+		return -1;
+
+	count = 0;
+	for (r0kh = *wpa_auth->conf.r0kh_list; r0kh; r0kh = r0kh->next)
+		count++;
+	wpa_auth->r0kh_index_size = wpa_ft_rkh_index_size(count);
+	wpa_auth->r0kh_index = os_calloc(wpa_auth->r0kh_index_size,
+					 sizeof(*wpa_auth->r0kh_index));
+
+	count = 0;
+	for (r1kh = *wpa_auth->conf.r1kh_list; r1kh; r1kh = r1kh->next)
+		count++;
+	wpa_auth->r1kh_index_size = wpa_ft_rkh_index_size(count);
+	wpa_auth->r1kh_index = os_calloc(wpa_auth->r1kh_index_size,
+					 sizeof(*wpa_auth->r1kh_index));
+
+	if (!wpa_auth->r0kh_index || !wpa_auth->r1kh_index) {
+		wpa_ft_rkh_index_free(wpa_auth);
+		return -1;
+	}
+
+	mask = wpa_auth->r0kh_index_size - 1;
+	for (r0kh = *wpa_auth->conf.r0kh_list; r0kh; r0kh = r0kh->next) {
+		struct ft_remote_r0kh *cur;
+
+		if (r0kh->id_len == 1 && r0kh->id[0] == '*')
+			wpa_auth->r0kh_wildcard = r0kh;
+		idx = wpa_ft_rkh_hash(r0kh->id, r0kh->id_len) & mask;
+		while ((cur = wpa_auth->r0kh_index[idx]) &&
+		       (cur->id_len != r0kh->id_len ||
+			os_memcmp(cur->id, r0kh->id, r0kh->id_len) != 0))
+			idx = (idx + 1) & mask;
+		wpa_auth->r0kh_index[idx] = r0kh;
+	}
+
+	mask = wpa_auth->r1kh_index_size - 1;
+	for (r1kh = *wpa_auth->conf.r1kh_list; r1kh; r1kh = r1kh->next) {
+		struct ft_remote_r1kh *cur;
+
+		if (is_zero_ether_addr(r1kh->addr) &&
+		    is_zero_ether_addr(r1kh->id))
+			wpa_auth->r1kh_wildcard = r1kh;
+		idx = wpa_ft_rkh_hash(r1kh->id, FT_R1KH_ID_LEN) & mask;
+		while ((cur = wpa_auth->r1kh_index[idx]) &&
+		       os_memcmp(cur->id, r1kh->id, FT_R1KH_ID_LEN) != 0)
+			idx = (idx + 1) & mask;
+		wpa_auth->r1kh_index[idx] = r1kh;
+	}
+
+	wpa_auth->rkh_index_r0kh_list = wpa_auth->conf.r0kh_list;
+	if (wpa_auth->conf.rxkh_gen)
+		wpa_auth->rkh_index_gen = *wpa_auth->conf.rxkh_gen;
+	wpa_auth->rkh_index_valid = true;
+
+	return 0;
+}
+
+
 static void wpa_ft_rrb_lookup_r0kh(struct wpa_authenticator *wpa_auth,
 				   const u8 *f_r0kh_id, size_t f_r0kh_id_len,
 				   struct ft_remote_r0kh **r0kh_out,
@@ -1583,6 +1763,26 @@ static void wpa_ft_rrb_lookup_r0kh(struct wpa_authenticator *wpa_auth,
 	*r0kh_wildcard = NULL;
 	*r0kh_out = NULL;
 
+	if (wpa_ft_rkh_index_update(wpa_auth) == 0) {
+		size_t mask = wpa_auth->r0kh_index_size - 1;
+		size_t idx;
+
+		*r0kh_wildcard = wpa_auth->r0kh_wildcard;
+		if (!f_r0kh_id)
+			goto done;
+		idx = wpa_ft_rkh_hash(f_r0kh_id, f_r0kh_id_len) & mask;
+		while ((r0kh = wpa_auth->r0kh_index[idx])) {
+			if (r0kh->id_len == f_r0kh_id_len &&
+			    os_memcmp_const(f_r0kh_id, r0kh->id,
+					    f_r0kh_id_len) == 0) {
+				*r0kh_out = r0kh;
+				break;
+			}
+			idx = (idx + 1) & mask;
+		}
+		goto done;
+	}
+
 	if (wpa_auth->conf.r0kh_list)
 		r0kh = *wpa_auth->conf.r0kh_list;
 	else
@@ -1595,6 +1795,7 @@ static void wpa_ft_rrb_lookup_r0kh(struct wpa_authenticator *wpa_auth,
 			*r0kh_out = r0kh;
 	}
 
+done:
 	if (!*r0kh_out && !*r0kh_wildcard)
 		wpa_printf(MSG_DEBUG, "FT: No matching R0KH found");
 
@@ -1630,6 +1831,25 @@ static void wpa_ft_rrb_lookup_r1kh(struct wpa_authenticator *wpa_auth,
 	*r1kh_wildcard = NULL;
 	*r1kh_out = NULL;
 
+	if (wpa_ft_rkh_index_update(wpa_auth) == 0) {
+		size_t mask = wpa_auth->r1kh_index_size - 1;
+		size_t idx;
+
+		*r1kh_wildcard = wpa_auth->r1kh_wildcard;
+		if (!f_r1kh_id)
+			goto done;
+		idx = wpa_ft_rkh_hash(f_r1kh_id, FT_R1KH_ID_LEN) & mask;
+		while ((r1kh = wpa_auth->r1kh_index[idx])) {
+			if (os_memcmp_const(r1kh->id, f_r1kh_id,
+					    FT_R1KH_ID_LEN) == 0) {
+				*r1kh_out = r1kh;
+				break;
+			}
+			idx = (idx + 1) & mask;
+		}
+		goto done;
+	}
+
 	if (wpa_auth->conf.r1kh_list)
 		r1kh = *wpa_auth->conf.r1kh_list;
 	else
@@ -1643,6 +1863,7 @@ static void wpa_ft_rrb_lookup_r1kh(struct wpa_authenticator *wpa_auth,
 			*r1kh_out = r1kh;
 	}
 
+done:
 	if (!*r1kh_out && !*r1kh_wildcard)
 		wpa_printf(MSG_DEBUG, "FT: No matching R1KH found");
 
@@ -1693,6 +1914,7 @@ static void wpa_ft_rrb_del_r0kh(void *eloop_ctx, void *timeout_ctx)
 		prev->next = r0kh->next;
 	else
 		*wpa_auth->conf.r0kh_list = r0kh->next;
+	wpa_ft_rkh_changed(wpa_auth);
 	if (r0kh->seq)
 		wpa_ft_rrb_seq_flush(wpa_auth, r0kh->seq, 0);
 	os_free(r0kh->seq);
@@ -1747,6 +1969,7 @@ wpa_ft_rrb_add_r0kh(struct wpa_authenticator *wpa_auth,
 
 	r0kh->next = *wpa_auth->conf.r0kh_list;
 	*wpa_auth->conf.r0kh_list = r0kh;
+	wpa_ft_rkh_changed(wpa_auth);
 
 	if (timeout > 0)
 		eloop_register_timeout(timeout, 0, wpa_ft_rrb_del_r0kh,
@@ -1778,9 +2001,11 @@ static void wpa_ft_rrb_del_r1kh(void *eloop_ctx, void *timeout_ctx)
 		prev->next = r1kh->next;
 	else
 		*wpa_auth->conf.r1kh_list = r1kh->next;
+	wpa_ft_rkh_changed(wpa_auth);
 	if (r1kh->seq)
 		wpa_ft_rrb_seq_flush(wpa_auth, r1kh->seq, 0);
 	os_free(r1kh->seq);
+	wpabuf_clear_free(r1kh->push_batch);
 	os_free(r1kh);
 }
 
@@ -1813,6 +2038,7 @@ wpa_ft_rrb_add_r1kh(struct wpa_authenticator *wpa_auth,
 	os_memcpy(r1kh->key, r1kh_wildcard->key, sizeof(r1kh->key));
 	r1kh->next = *wpa_auth->conf.r1kh_list;
 	*wpa_auth->conf.r1kh_list = r1kh;
+	wpa_ft_rkh_changed(wpa_auth);
 
 	if (timeout > 0)
 		eloop_register_timeout(timeout, 0, wpa_ft_rrb_del_r1kh,
@@ -1855,6 +2081,8 @@ static void wpa_ft_deinit_seq(struct wpa_authenticator *wpa_auth)
 	else
 		r1kh = NULL;
 	for (; r1kh; r1kh = r1kh->next) {
+		wpabuf_clear_free(r1kh->push_batch);
+		r1kh->push_batch = NULL;
 		if (!r1kh->seq)
 			continue;
 		wpa_ft_rrb_seq_flush(wpa_auth, r1kh->seq, 0);
@@ -1906,13 +2134,18 @@ static void wpa_ft_deinit_rkh_tmp(struct wpa_authenticator *wpa_auth)
 		}
 		r1kh = r1kh_next;
 	}
+	wpa_ft_rkh_changed(wpa_auth);
 }
 
 
 void wpa_ft_deinit(struct wpa_authenticator *wpa_auth)
 {
+	eloop_cancel_timeout(wpa_ft_rrb_push_batch_timeout, wpa_auth,
+			     ELOOP_ALL_CTX);
 	wpa_ft_deinit_seq(wpa_auth);
 	wpa_ft_deinit_rkh_tmp(wpa_auth);
+	wpa_ft_rkh_index_free(wpa_auth);
+	wpa_ft_rrb_item_pool_flush(wpa_auth);
 }
 
 
@@ -2199,7 +2432,7 @@ void wpa_auth_ft_store_keys(struct wpa_state_machine *sm, const u8 *pmk_r0,
 	wpa_ft_store_pmk_r1(sm->wpa_auth, sm->addr, pmk_r1, key_len,
 			    sm->pmk_r1_name, sm->pairwise, &vlan,
 			    expires_in, session_timeout, identity,
-			    identity_len, radius_cui, radius_cui_len);
+			    identity_len, radius_cui, radius_cui_len, false);
 }
 
 
@@ -3137,7 +3370,7 @@ static int wpa_ft_local_derive_pmk_r1(struct wpa_authenticator *wpa_auth,
 			    out_pmk_r1_name,
 			    sm->pairwise, r0->vlan, expires_in, session_timeout,
 			    r0->identity, r0->identity_len,
-			    r0->radius_cui, r0->radius_cui_len);
+			    r0->radius_cui, r0->radius_cui_len, false);
 
 	*out_pairwise = sm->pairwise;
 	if (vlan) {
@@ -3297,6 +3530,7 @@ static int wpa_ft_process_auth_req(struct wpa_state_machine *sm,
 		goto pmk_r1_derived;
 	}
 
+	sm->wpa_auth->ft_pmk_r1_pull_fallbacks++;
 	if (wpa_ft_pull_pmk_r1(sm, ies, ies_len, parse.rsn_pmkid) < 0) {
 		wpa_printf(MSG_DEBUG,
 			   "FT: Did not have matching PMK-R1 and either unknown or blocked R0KH-ID or NAK from R0KH");
@@ -3972,9 +4206,13 @@ static int wpa_ft_rrb_build_r0(const u8 *key, const size_t key_len,
 		session_timeout = 0;
 	WPA_PUT_LE32(f_session_timeout, session_timeout);
 
-	ret = wpa_ft_rrb_build(key, key_len, tlvs, sess_tlv, tlv_auth,
-			       pmk_r0->vlan, src_addr, type,
-			       packet, packet_len);
+	if (!tlv_auth) /* unencrypted FT_RRB_BATCH_ENTRY contents */
+		ret = wpa_ft_rrb_lin(tlvs, sess_tlv, pmk_r0->vlan,
+				     packet, packet_len);
+	else
+		ret = wpa_ft_rrb_build(key, key_len, tlvs, sess_tlv, tlv_auth,
+				       pmk_r0->vlan, src_addr, type,
+				       packet, packet_len);
 
 	forced_memzero(pmk_r1, sizeof(pmk_r1));
 
@@ -4069,6 +4307,9 @@ static int wpa_ft_rrb_rx_pull(struct wpa_authenticator *wpa_auth,
 			      msgtype);
 	wpa_ft_rrb_r1kh_replenish(wpa_auth, r1kh,
 				  wpa_auth->conf.rkh_pos_timeout);
+	/* A station roamed to this R1KH without a pushed PMK-R1 */
+	if (r1kh->roams < 0xffff)
+		r1kh->roams++;
 
 	RRB_GET(FT_RRB_PMK_R0_NAME, pmk_r0_name, msgtype, WPA_PMK_NAME_LEN);
 	wpa_hexdump(MSG_DEBUG, "FT: PMKR0Name", f_pmk_r0_name,
@@ -4139,27 +4380,15 @@ out:
  *          -1 on error
  *          -2 if FR_RRB_PAIRWISE is missing
  */
-static int wpa_ft_rrb_rx_r1(struct wpa_authenticator *wpa_auth,
-			    const u8 *src_addr, u8 type,
-			    const u8 *enc, size_t enc_len,
-			    const u8 *auth, size_t auth_len,
-			    const char *msgtype, u8 *s1kh_id_out,
-			    int (*cb)(struct wpa_authenticator *wpa_auth,
-				      const u8 *src_addr,
-				      const u8 *enc, size_t enc_len,
-				      const u8 *auth, size_t auth_len,
-				      int no_defer))
+static int wpa_ft_rrb_rx_r1_entry(struct wpa_authenticator *wpa_auth,
+				  const u8 *src_addr, u8 type,
+				  const u8 *plain, size_t plain_len,
+				  const char *msgtype, u8 *s1kh_id_out)
 {
-	u8 *plain = NULL;
-	size_t plain_len = 0;
-	struct ft_remote_r0kh *r0kh, *r0kh_wildcard;
-	const u8 *key;
-	size_t key_len;
-	int seq_ret;
-	const u8 *f_r1kh_id, *f_s1kh_id, *f_r0kh_id;
+	const u8 *f_s1kh_id;
 	const u8 *f_pmk_r1_name, *f_pairwise, *f_pmk_r1;
 	const u8 *f_expires_in;
-	size_t f_r1kh_id_len, f_s1kh_id_len, f_r0kh_id_len;
+	size_t f_s1kh_id_len;
 	const u8 *f_identity, *f_radius_cui;
 	const u8 *f_session_timeout;
 	size_t f_pmk_r1_name_len, f_pairwise_len, f_pmk_r1_len;
@@ -4173,68 +4402,6 @@ static int wpa_ft_rrb_rx_r1(struct wpa_authenticator *wpa_auth,
 	struct vlan_description vlan;
 	size_t pmk_r1_len;
 
-	RRB_GET_AUTH(FT_RRB_R0KH_ID, r0kh_id, msgtype, -1);
-	wpa_hexdump(MSG_DEBUG, "FT: R0KH-ID", f_r0kh_id, f_r0kh_id_len);
-
-	RRB_GET_AUTH(FT_RRB_R1KH_ID, r1kh_id, msgtype, FT_R1KH_ID_LEN);
-	wpa_printf(MSG_DEBUG, "FT: R1KH-ID=" MACSTR, MAC2STR(f_r1kh_id));
-
-	if (wpa_ft_rrb_check_r1kh(wpa_auth, f_r1kh_id)) {
-		wpa_printf(MSG_DEBUG, "FT: R1KH-ID mismatch");
-		goto out;
-	}
-
-	wpa_ft_rrb_lookup_r0kh(wpa_auth, f_r0kh_id, f_r0kh_id_len, &r0kh,
-			       &r0kh_wildcard);
-	if (r0kh) {
-		key = r0kh->key;
-		key_len = sizeof(r0kh->key);
-	} else if (r0kh_wildcard) {
-		wpa_printf(MSG_DEBUG, "FT: Using wildcard R0KH-ID");
-		key = r0kh_wildcard->key;
-		key_len = sizeof(r0kh_wildcard->key);
-	} else {
-		goto out;
-	}
-
-	seq_ret = FT_RRB_SEQ_DROP;
-	if (r0kh) {
-		seq_ret = wpa_ft_rrb_seq_chk(r0kh->seq, src_addr, enc, enc_len,
-					     auth, auth_len, msgtype,
-					     cb ? 0 : 1);
-	}
-	if (cb && r0kh_wildcard &&
-	    (!r0kh || !ether_addr_equal(r0kh->addr, src_addr))) {
-		/* wildcard: r0kh-id unknown or changed addr -> do a seq req */
-		seq_ret = FT_RRB_SEQ_DEFER;
-	}
-
-	if (seq_ret == FT_RRB_SEQ_DROP)
-		goto out;
-
-	if (wpa_ft_rrb_decrypt(key, key_len, enc, enc_len, auth, auth_len,
-			       src_addr, type, &plain, &plain_len) < 0)
-		goto out;
-
-	if (!r0kh)
-		r0kh = wpa_ft_rrb_add_r0kh(wpa_auth, r0kh_wildcard, src_addr,
-					   f_r0kh_id, f_r0kh_id_len,
-					   wpa_auth->conf.rkh_pos_timeout);
-	if (!r0kh)
-		goto out;
-
-	if (seq_ret == FT_RRB_SEQ_DEFER) {
-		wpa_ft_rrb_seq_req(wpa_auth, r0kh->seq, src_addr, f_r0kh_id,
-				   f_r0kh_id_len, f_r1kh_id, key, key_len,
-				   enc, enc_len, auth, auth_len, cb);
-		goto out;
-	}
-
-	wpa_ft_rrb_seq_accept(wpa_auth, r0kh->seq, src_addr, auth, auth_len,
-			      msgtype);
-	wpa_ft_rrb_r0kh_replenish(wpa_auth, r0kh,
-				  wpa_auth->conf.rkh_pos_timeout);
-
 	RRB_GET(FT_RRB_S1KH_ID, s1kh_id, msgtype, ETH_ALEN);
 	wpa_printf(MSG_DEBUG, "FT: S1KH-ID=" MACSTR, MAC2STR(f_s1kh_id));
 
@@ -4302,15 +4469,135 @@ static int wpa_ft_rrb_rx_r1(struct wpa_authenticator *wpa_auth,
 				f_pmk_r1_name,
 				pairwise, &vlan, expires_in, session_timeout,
 				f_identity, f_identity_len, f_radius_cui,
-				f_radius_cui_len) < 0)
+				f_radius_cui_len,
+				type == FT_PACKET_R0KH_R1KH_PUSH ||
+				type == FT_PACKET_R0KH_R1KH_PUSH_BATCH) < 0)
+		goto out;
+
+	ret = 0;
+out:
+	return ret;
+}
+
+
+static int wpa_ft_rrb_rx_r1(struct wpa_authenticator *wpa_auth,
+			    const u8 *src_addr, u8 type,
+			    const u8 *enc, size_t enc_len,
+			    const u8 *auth, size_t auth_len,
+			    const char *msgtype, u8 *s1kh_id_out,
+			    int (*cb)(struct wpa_authenticator *wpa_auth,
+				      const u8 *src_addr,
+				      const u8 *enc, size_t enc_len,
+				      const u8 *auth, size_t auth_len,
+				      int no_defer))
+{
+	u8 *plain = NULL;
+	size_t plain_len = 0;
+	struct ft_remote_r0kh *r0kh, *r0kh_wildcard;
+	const u8 *key;
+	size_t key_len;
+	int seq_ret;
+	const u8 *f_r1kh_id, *f_r0kh_id;
+	size_t f_r1kh_id_len, f_r0kh_id_len;
+	const struct ft_rrb_tlv *f;
+	const u8 *pos;
+	size_t left, len;
+	int ret = -1;
+
+	RRB_GET_AUTH(FT_RRB_R0KH_ID, r0kh_id, msgtype, -1);
+	wpa_hexdump(MSG_DEBUG, "FT: R0KH-ID", f_r0kh_id, f_r0kh_id_len);
+
+	RRB_GET_AUTH(FT_RRB_R1KH_ID, r1kh_id, msgtype, FT_R1KH_ID_LEN);
+	wpa_printf(MSG_DEBUG, "FT: R1KH-ID=" MACSTR, MAC2STR(f_r1kh_id));
+
+	if (wpa_ft_rrb_check_r1kh(wpa_auth, f_r1kh_id)) {
+		wpa_printf(MSG_DEBUG, "FT: R1KH-ID mismatch");
+		goto out;
+	}
+
+	wpa_ft_rrb_lookup_r0kh(wpa_auth, f_r0kh_id, f_r0kh_id_len, &r0kh,
+			       &r0kh_wildcard);
+	if (r0kh) {
+		key = r0kh->key;
+		key_len = sizeof(r0kh->key);
+	} else if (r0kh_wildcard) {
+		wpa_printf(MSG_DEBUG, "FT: Using wildcard R0KH-ID");
+		key = r0kh_wildcard->key;
+		key_len = sizeof(r0kh_wildcard->key);
+	} else {
 		goto out;
+	}
+
+	seq_ret = FT_RRB_SEQ_DROP;
+	if (r0kh) {
+		seq_ret = wpa_ft_rrb_seq_chk(r0kh->seq, src_addr, enc, enc_len,
+					     auth, auth_len, msgtype,
+					     cb ? 0 : 1);
+	}
+	if (cb && r0kh_wildcard &&
+	    (!r0kh || !ether_addr_equal(r0kh->addr, src_addr))) {
+		/* wildcard: r0kh-id unknown or changed addr -> do a seq req */
+		seq_ret = FT_RRB_SEQ_DEFER;
+	}
+
+	if (seq_ret == FT_RRB_SEQ_DROP)
+		goto out;
+
+	if (wpa_ft_rrb_decrypt(key, key_len, enc, enc_len, auth, auth_len,
+			       src_addr, type, &plain, &plain_len) < 0)
+		goto out;
+
+	if (!r0kh)
+		r0kh = wpa_ft_rrb_add_r0kh(wpa_auth, r0kh_wildcard, src_addr,
+					   f_r0kh_id, f_r0kh_id_len,
+					   wpa_auth->conf.rkh_pos_timeout);
+	if (!r0kh)
+		goto out;
+
+	if (seq_ret == FT_RRB_SEQ_DEFER) {
+		wpa_ft_rrb_seq_req(wpa_auth, r0kh->seq, src_addr, f_r0kh_id,
+				   f_r0kh_id_len, f_r1kh_id, key, key_len,
+				   enc, enc_len, auth, auth_len, cb);
+		goto out;
+	}
+
+	wpa_ft_rrb_seq_accept(wpa_auth, r0kh->seq, src_addr, auth, auth_len,
+			      msgtype);
+	wpa_ft_rrb_r0kh_replenish(wpa_auth, r0kh,
+				  wpa_auth->conf.rkh_pos_timeout);
+
+	if (type != FT_PACKET_R0KH_R1KH_PUSH_BATCH) {
+		ret = wpa_ft_rrb_rx_r1_entry(wpa_auth, src_addr, type,
+					     plain, plain_len, msgtype,
+					     s1kh_id_out);
+		goto out;
+	}
 
 	ret = 0;
+	pos = plain;
+	left = plain_len;
+	while (left >= sizeof(*f)) {
+		f = (const struct ft_rrb_tlv *) pos;
+		len = le_to_host16(f->len);
+		pos += sizeof(*f);
+		left -= sizeof(*f);
+		if (left < len) {
+			wpa_printf(MSG_DEBUG, "FT: RRB message truncated");
+			ret = -1;
+			break;
+		}
+		if (le_to_host16(f->type) == FT_RRB_BATCH_ENTRY &&
+		    wpa_ft_rrb_rx_r1_entry(wpa_auth, src_addr, type, pos, len,
+					   msgtype, NULL) < 0)
+			ret = -1;
+		pos += len;
+		left -= len;
+	}
+
 out:
 	bin_clear_free(plain, plain_len);
 
 	return ret;
-
 }
 
 
@@ -4442,6 +4729,26 @@ static int wpa_ft_rrb_rx_push(struct wpa_authenticator *wpa_auth,
 }
 
 
+static int wpa_ft_rrb_rx_push_batch(struct wpa_authenticator *wpa_auth,
+				    const u8 *src_addr,
+				    const u8 *enc, size_t enc_len,
+				    const u8 *auth, size_t auth_len,
+				    int no_defer)
+{
+	const char *msgtype = "push batch";
+
+	wpa_printf(MSG_DEBUG, "FT: Received PMK-R1 push batch");
+
+	if (wpa_ft_rrb_rx_r1(wpa_auth, src_addr,
+			     FT_PACKET_R0KH_R1KH_PUSH_BATCH,
+			     enc, enc_len, auth, auth_len, msgtype, NULL,
+			     no_defer ? NULL : wpa_ft_rrb_rx_push_batch) < 0)
+		return -1;
+
+	return 0;
+}
+
+
 static int wpa_ft_rrb_rx_seq(struct wpa_authenticator *wpa_auth,
 			     const u8 *src_addr, int type,
 			     const u8 *enc, size_t enc_len,
@@ -4897,6 +5204,10 @@ void wpa_ft_rrb_oui_rx(struct wpa_authenticator *wpa_auth, const u8 *src_addr,
 		wpa_ft_rrb_rx_push(wpa_auth, src_addr, enc, elen, auth, alen,
 				   no_defer);
 		break;
+	case FT_PACKET_R0KH_R1KH_PUSH_BATCH:
+		wpa_ft_rrb_rx_push_batch(wpa_auth, src_addr, enc, elen, auth,
+					 alen, no_defer);
+		break;
 	case FT_PACKET_R0KH_R1KH_SEQ_REQ:
 		wpa_ft_rrb_rx_seq_req(wpa_auth, src_addr, enc, elen, auth, alen,
 				      no_defer);
@@ -4909,6 +5220,142 @@ void wpa_ft_rrb_oui_rx(struct wpa_authenticator *wpa_auth, const u8 *src_addr,
 }
 
 
+static int wpa_ft_rrb_send_push_batch(struct wpa_authenticator *wpa_auth,
+				      struct ft_remote_r1kh *r1kh)
+{
+	struct wpabuf *batch = r1kh->push_batch;
+	struct tlv_list *push = NULL;
+	const struct ft_rrb_tlv *f;
+	const u8 *pos;
+	size_t left, len, num = 0;
+	u8 *packet = NULL;
+	size_t packet_len;
+	struct ft_rrb_seq f_seq;
+	struct tlv_list push_auth[] = {
+		{ .type = FT_RRB_SEQ, .len = sizeof(f_seq),
+		  .data = (u8 *) &f_seq },
+		{ .type = FT_RRB_R0KH_ID,
+		  .len = wpa_auth->conf.r0_key_holder_len,
+		  .data = wpa_auth->conf.r0_key_holder },
+		{ .type = FT_RRB_R1KH_ID, .len = FT_R1KH_ID_LEN,
+		  .data = r1kh->id },
+		{ .type = FT_RRB_LAST_EMPTY, .len = 0, .data = NULL },
+	};
+	int ret = -1;
+
+	r1kh->push_batch = NULL;
+	if (!batch)
+		return 0;
+
+	push = os_calloc(wpabuf_len(batch) / sizeof(*f) + 1, sizeof(*push));
+	if (!push)
+		goto out;
+	pos = wpabuf_head(batch);
+	left = wpabuf_len(batch);
+	while (left >= sizeof(*f)) {
+		f = (const struct ft_rrb_tlv *) pos;
+		len = le_to_host16(f->len);
+		pos += sizeof(*f);
+		left -= sizeof(*f);
+		push[num].type = FT_RRB_BATCH_ENTRY;
+		push[num].len = len;
+		push[num].data = pos;
+		num++;
+		pos += len;
+		left -= len;
+	}
+	push[num].type = FT_RRB_LAST_EMPTY;
+
+	if (wpa_ft_new_seq(r1kh->seq, &f_seq) < 0) {
+		wpa_printf(MSG_DEBUG, "FT: Failed to get seq num");
+		goto out;
+	}
+
+	wpa_printf(MSG_DEBUG, "FT: Send PMK-R1 push batch (%u entries) from "
+		   MACSTR " to remote R0KH address " MACSTR,
+		   (unsigned int) num, MAC2STR(wpa_auth->addr),
+		   MAC2STR(r1kh->addr));
+
+	if (wpa_ft_rrb_build(r1kh->key, sizeof(r1kh->key), push, NULL,
+			     push_auth, NULL, wpa_auth->addr,
+			     FT_PACKET_R0KH_R1KH_PUSH_BATCH,
+			     &packet, &packet_len) < 0)
+		goto out;
+
+	wpa_ft_rrb_oui_send(wpa_auth, r1kh->addr,
+			    FT_PACKET_R0KH_R1KH_PUSH_BATCH,
+			    packet, packet_len);
+	ret = 0;
+
+out:
+	os_free(packet);
+	os_free(push);
+	wpabuf_clear_free(batch);
+	return ret;
+}
+
+
+static void wpa_ft_rrb_push_batch_timeout(void *eloop_ctx, void *timeout_ctx)
+{
+	struct wpa_authenticator *wpa_auth = eloop_ctx;
+	struct ft_remote_r1kh *r1kh;
+
+	if (!wpa_auth->conf.r1kh_list)
+		return;
+
+	for (r1kh = *wpa_auth->conf.r1kh_list; r1kh; r1kh = r1kh->next) {
+		if (r1kh->push_batch)
+			wpa_ft_rrb_send_push_batch(wpa_auth, r1kh);
+	}
+}
+
+
+static int wpa_ft_rrb_queue_push(struct wpa_authenticator *wpa_auth,
+				 struct wpa_ft_pmk_r0_sa *pmk_r0,
+				 struct ft_remote_r1kh *r1kh,
+				 const u8 *s1kh_id,
+				 const struct tlv_list *push)
+{
+	u8 *plain;
+	size_t plain_len;
+	int timeout = wpa_auth->conf.pmk_r1_push_batch;
+
+	if (wpa_ft_rrb_build_r0(NULL, 0, push, pmk_r0, r1kh->id,
+				s1kh_id, NULL, NULL, 0,
+				&plain, &plain_len) < 0)
+		return -1;
+
+	if (r1kh->push_batch &&
+	    wpabuf_tailroom(r1kh->push_batch) <
+	    sizeof(struct ft_rrb_tlv) + plain_len)
+		wpa_ft_rrb_send_push_batch(wpa_auth, r1kh);
+	if (!r1kh->push_batch) {
+		r1kh->push_batch = wpabuf_alloc(FT_RRB_BATCH_MAX_LEN);
+		if (!r1kh->push_batch ||
+		    wpabuf_tailroom(r1kh->push_batch) <
+		    sizeof(struct ft_rrb_tlv) + plain_len) {
+			wpabuf_free(r1kh->push_batch);
+			r1kh->push_batch = NULL;
+			bin_clear_free(plain, plain_len);
+			return -1;
+		}
+	}
+
+	wpabuf_put_le16(r1kh->push_batch, FT_RRB_BATCH_ENTRY);
+	wpabuf_put_le16(r1kh->push_batch, plain_len);
+	wpabuf_put_data(r1kh->push_batch, plain, plain_len);
+	bin_clear_free(plain, plain_len);
+
+	if (!eloop_is_timeout_registered(wpa_ft_rrb_push_batch_timeout,
+					 wpa_auth, NULL))
+		eloop_register_timeout(timeout / 1000, (timeout % 1000) * 1000,
+				       wpa_ft_rrb_push_batch_timeout,
+				       wpa_auth, NULL);
+
+	return 0;
+}
+
+
 static int wpa_ft_generate_pmk_r1(struct wpa_authenticator *wpa_auth,
 				  struct wpa_ft_pmk_r0_sa *pmk_r0,
 				  struct ft_remote_r1kh *r1kh,
@@ -4935,6 +5382,13 @@ static int wpa_ft_generate_pmk_r1(struct wpa_authenticator *wpa_auth,
 		{ .type = FT_RRB_LAST_EMPTY, .len = 0, .data = NULL },
 	};
 
+	if (wpa_auth->conf.pmk_r1_push_batch > 0 &&
+	    wpa_ft_rrb_queue_push(wpa_auth, pmk_r0, r1kh, s1kh_id,
+				  push) == 0) {
+		wpa_auth->ft_pmk_r1_pushes++;
+		return 0;
+	}
+
 	if (wpa_ft_new_seq(r1kh->seq, &f_seq) < 0) {
 		wpa_printf(MSG_DEBUG, "FT: Failed to get seq num");
 		return -1;
@@ -4952,12 +5406,84 @@ static int wpa_ft_generate_pmk_r1(struct wpa_authenticator *wpa_auth,
 
 	wpa_ft_rrb_oui_send(wpa_auth, r1kh->addr, FT_PACKET_R0KH_R1KH_PUSH,
 			    packet, packet_len);
+	wpa_auth->ft_pmk_r1_pushes++;
 
 	os_free(packet);
 	return 0;
 }
 
 
+static unsigned int wpa_ft_r1kh_push_score(struct wpa_authenticator *wpa_auth,
+					   struct ft_remote_r1kh *r1kh)
+{
+	unsigned int score;
+
+	/* Observed roams dominate; neighbor report entries break ties and
+	 * cover R1KHs that have not yet seen a roam from this AP. */
+	score = r1kh->roams * 2;
+	if (wpa_auth->cb->is_neighbor &&
+	    (wpa_auth->cb->is_neighbor(wpa_auth->cb_ctx, r1kh->id) ||
+	     wpa_auth->cb->is_neighbor(wpa_auth->cb_ctx, r1kh->addr)))
+		score++;
+
+	return score;
+}
+
+
+static void wpa_ft_push_pmk_r1_predicted(struct wpa_authenticator *wpa_auth,
+					 struct wpa_ft_pmk_r0_sa *r0,
+					 const u8 *addr)
+{
+	struct ft_remote_r1kh *r1kh, **best;
+	unsigned int *best_score, score;
+	int count = wpa_auth->conf.pmk_r1_push_count;
+	int i, num = 0;
+
+	if (count <= 0)
+		return;
+
+	best = os_calloc(count, sizeof(*best));
+	best_score = os_calloc(count, sizeof(*best_score));
+	if (!best || !best_score)
+		goto out;
+
+	for (r1kh = *wpa_auth->conf.r1kh_list; r1kh; r1kh = r1kh->next) {
+		if (is_zero_ether_addr(r1kh->addr) ||
+		    is_zero_ether_addr(r1kh->id))
+			continue;
+		score = wpa_ft_r1kh_push_score(wpa_auth, r1kh);
+		if (!score)
+			continue;
+
+		/* Insertion into the descending top-count list */
+		if (num == count && score <= best_score[num - 1])
+			continue;
+		if (num < count)
+			num++;
+		for (i = num - 1; i > 0 && best_score[i - 1] < score; i--) {
+			best[i] = best[i - 1];
+			best_score[i] = best_score[i - 1];
+		}
+		best[i] = r1kh;
+		best_score[i] = score;
+	}
+
+	for (i = 0; i < num; i++) {
+		wpa_printf(MSG_DEBUG,
+			   "FT: Predicted R1KH " MACSTR " (roams=%u score=%u)",
+			   MAC2STR(best[i]->addr), best[i]->roams,
+			   best_score[i]);
+		if (wpa_ft_rrb_init_r1kh_seq(best[i]) < 0)
+			continue;
+		wpa_ft_generate_pmk_r1(wpa_auth, r0, best[i], addr);
+	}
+
+out:
+	os_free(best);
+	os_free(best_score);
+}
+
+
 void wpa_ft_push_pmk_r1(struct wpa_authenticator *wpa_auth, const u8 *addr)
 {
 	struct wpa_ft_pmk_cache *cache = wpa_auth->ft_pmk_cache;
@@ -4984,6 +5510,11 @@ void wpa_ft_push_pmk_r1(struct wpa_authenticator *wpa_auth, const u8 *addr)
 	wpa_printf(MSG_DEBUG, "FT: Deriving and pushing PMK-R1 keys to R1KHs "
 		   "for STA " MACSTR, MAC2STR(addr));
 
+	if (wpa_auth->conf.pmk_r1_push == 2) {
+		wpa_ft_push_pmk_r1_predicted(wpa_auth, r0, addr);
+		return;
+	}
+
 	for (r1kh = *wpa_auth->conf.r1kh_list; r1kh; r1kh = r1kh->next) {
 		if (is_zero_ether_addr(r1kh->addr) ||
 		    is_zero_ether_addr(r1kh->id))
@@ -33,6 +33,8 @@
 #include "pmksa_cache_auth.h"
 #include "wpa_auth.h"
 #include "wpa_auth_glue.h"
+#include "neighbor_db.h"
+#include "pmksa_sync.h"
 
 
 static void hostapd_wpa_auth_conf(struct hostapd_bss_config *conf,
@@ -54,6 +56,7 @@ static void hostapd_wpa_auth_conf(struct hostapd_bss_config *conf,
 	wconf->wpa_gmk_rekey = conf->wpa_gmk_rekey;
 	wconf->wpa_ptk_rekey = conf->wpa_ptk_rekey;
 	wconf->wpa_group_update_count = conf->wpa_group_update_count;
+	wconf->wpa_group_update_rate = conf->wpa_group_update_rate;
 	wconf->wpa_disable_eapol_key_retries =
 		conf->wpa_disable_eapol_key_retries;
 	wconf->wpa_pairwise_update_count = conf->wpa_pairwise_update_count;
@@ -73,6 +76,8 @@ static void hostapd_wpa_auth_conf(struct hostapd_bss_config *conf,
 	wconf->ocv = conf->ocv;
 #endif /* CONFIG_OCV */
 	wconf->okc = conf->okc;
+	wconf->pmksa_cache_shared = conf->pmksa_cache_shared;
+	wconf->pmksa_cache_size = conf->pmksa_cache_size;
 	wconf->ieee80211w = conf->ieee80211w;
 	wconf->rsn_override_mfp = conf->rsn_override_mfp;
 	wconf->rsn_override_mfp_2 = conf->rsn_override_mfp_2;
@@ -103,7 +108,10 @@ static void hostapd_wpa_auth_conf(struct hostapd_bss_config *conf,
 	wconf->rkh_pull_retries = conf->rkh_pull_retries;
 	wconf->r0kh_list = &conf->r0kh_list;
 	wconf->r1kh_list = &conf->r1kh_list;
+	wconf->rxkh_gen = &conf->rxkh_gen;
 	wconf->pmk_r1_push = conf->pmk_r1_push;
+	wconf->pmk_r1_push_count = conf->pmk_r1_push_count;
+	wconf->pmk_r1_push_batch = conf->pmk_r1_push_batch;
 	wconf->ft_over_ds = conf->ft_over_ds;
 	wconf->ft_psk_generate_local = conf->ft_psk_generate_local;
 #endif /* CONFIG_IEEE80211R_AP */
@@ -334,6 +342,15 @@ static void hostapd_wpa_auth_psk_failure_report(void *ctx, const u8 *addr)
 }
 
 
+static void hostapd_wpa_auth_psk_matched(void *ctx, const u8 *addr,
+					 const u8 *psk)
+{
+	struct hostapd_data *hapd = ctx;
+
+	hostapd_psk_matched(hapd->conf, addr, psk);
+}
+
+
 static void hostapd_wpa_auth_set_eapol(void *ctx, const u8 *addr,
 				       wpa_eapol_variable var, int value)
 {
@@ -668,6 +685,40 @@ static int wpa_auth_iface_iter(struct hostapd_iface *iface, void *ctx)
 }
 
 
+static void hostapd_wpa_auth_pmksa_added(void *ctx,
+					 struct rsn_pmksa_cache_entry *entry)
+{
+	struct hostapd_data *hapd = ctx;
+
+	pmksa_sync_entry_added(hapd, entry);
+}
+
+
+static bool hostapd_wpa_auth_sta_is_dozing(void *ctx, const u8 *addr)
+{
+	struct hostapd_data *hapd = ctx;
+	struct hostap_sta_driver_data data;
+	struct sta_info *sta;
+	unsigned long dtim_msec;
+
+	sta = ap_get_sta(hapd, addr);
+	if (!sta)
+		return false;
+
+	/* Consider a STA that has not been active during the last DTIM
+	 * interval to likely be in power save mode. The check is done for
+	 * all the stations at the same time when the group key is rekeyed,
+	 * so a snapshot taken a small fraction of the DTIM interval ago is
+	 * accurate enough. */
+	dtim_msec = hapd->iconf->beacon_int * hapd->conf->dtim_period * 1024 /
+		1000;
+	os_memset(&data, 0, sizeof(data));
+	if (ap_sta_read_drv_data(hapd, sta, &data, dtim_msec / 4, NULL) < 0)
+		return false;
+	return data.inactive_msec > dtim_msec;
+}
+
+
 static int hostapd_wpa_auth_for_each_auth(
 	void *ctx, int (*cb)(struct wpa_authenticator *sm, void *ctx),
 	void *cb_ctx)
@@ -1501,6 +1552,14 @@ static int hostapd_wpa_auth_add_tspec(void *ctx, const u8 *sta_addr,
 }
 
 
+static bool hostapd_wpa_auth_is_neighbor(void *ctx, const u8 *bssid)
+{
+	struct hostapd_data *hapd = ctx;
+
+	return hostapd_neighbor_get(hapd, bssid, NULL) != NULL;
+}
+
+
 
 static int hostapd_wpa_register_ft_oui(struct hostapd_data *hapd,
 				       const char *ft_iface)
@@ -1605,7 +1664,6 @@ static int hostapd_wpa_auth_get_ml_key_info(void *ctx,
 	for (i = 0; i < info->n_mld_links; i++) {
 		struct hostapd_data *bss;
 		u8 link_id = info->links[i].link_id;
-		bool link_bss_found = false;
 
 		wpa_printf(MSG_DEBUG,
 			   "WPA_AUTH: MLD: Get link info CB: link_id=%u",
@@ -1620,20 +1678,15 @@ static int hostapd_wpa_auth_get_ml_key_info(void *ctx,
 			continue;
 		}
 
-		for_each_mld_link(bss, hapd) {
-			if (bss == hapd || bss->mld_link_id != link_id)
-				continue;
-
+		bss = link_id < MAX_NUM_MLD_LINKS ?
+			hapd->mld->link_bss[link_id] : NULL;
+		if (bss)
 			wpa_auth_ml_get_key_info(bss->wpa_auth,
 						 &info->links[i],
 						 info->mgmt_frame_prot,
 						 info->beacon_prot,
 						 rekey);
-			link_bss_found = true;
-			break;
-		}
-
-		if (!link_bss_found)
+		else
 			wpa_printf(MSG_DEBUG,
 				   "WPA_AUTH: MLD: link=%u not found", link_id);
 	}
@@ -1666,6 +1719,7 @@ int hostapd_setup_wpa(struct hostapd_data *hapd)
 		.disconnect = hostapd_wpa_auth_disconnect,
 		.mic_failure_report = hostapd_wpa_auth_mic_failure_report,
 		.psk_failure_report = hostapd_wpa_auth_psk_failure_report,
+		.psk_matched = hostapd_wpa_auth_psk_matched,
 		.set_eapol = hostapd_wpa_auth_set_eapol,
 		.get_eapol = hostapd_wpa_auth_get_eapol,
 		.get_psk = hostapd_wpa_auth_get_psk,
@@ -1676,6 +1730,8 @@ int hostapd_setup_wpa(struct hostapd_data *hapd)
 		.get_sta_count = hostapd_wpa_auth_get_sta_count,
 		.for_each_sta = hostapd_wpa_auth_for_each_sta,
 		.for_each_auth = hostapd_wpa_auth_for_each_auth,
+		.pmksa_added = hostapd_wpa_auth_pmksa_added,
+		.sta_is_dozing = hostapd_wpa_auth_sta_is_dozing,
 		.send_ether = hostapd_wpa_auth_send_ether,
 		.send_oui = hostapd_wpa_auth_send_oui,
 		.channel_info = hostapd_channel_info,
@@ -1693,6 +1749,7 @@ int hostapd_setup_wpa(struct hostapd_data *hapd)
 		.add_sta = hostapd_wpa_auth_add_sta,
 		.add_sta_ft = hostapd_wpa_auth_add_sta_ft,
 		.add_tspec = hostapd_wpa_auth_add_tspec,
+		.is_neighbor = hostapd_wpa_auth_is_neighbor,
 		.set_vlan = hostapd_wpa_auth_set_vlan,
 		.get_vlan = hostapd_wpa_auth_get_vlan,
 		.set_identity = hostapd_wpa_auth_set_identity,
@@ -1805,12 +1862,25 @@ int hostapd_setup_wpa(struct hostapd_data *hapd)
 		return -1;
 	}
 
+	if (pmksa_sync_init(hapd)) {
+		wpa_printf(MSG_ERROR,
+			   "Initialization of PMKSA cache synchronization failed.");
+		return -1;
+	}
+
 	if (!hapd->ptksa)
 		hapd->ptksa = ptksa_cache_init();
 	if (!hapd->ptksa) {
 		wpa_printf(MSG_ERROR, "Failed to allocate PTKSA cache");
 		return -1;
 	}
+#ifdef CONFIG_PASN
+	if (ptksa_cache_set_max_entries(hapd->ptksa,
+					hapd->conf->ptksa_cache_size) < 0) {
+		wpa_printf(MSG_ERROR, "Failed to set PTKSA cache size");
+		return -1;
+	}
+#endif /* CONFIG_PASN */
 
 #ifdef CONFIG_IEEE80211R_AP
 	if (!hostapd_drv_none(hapd) &&
@@ -1855,6 +1925,7 @@ void hostapd_deinit_wpa(struct hostapd_data *hapd)
 	hapd->ptksa = NULL;
 
 	rsn_preauth_iface_deinit(hapd);
+	pmksa_sync_deinit(hapd);
 	if (hapd->wpa_auth) {
 		wpa_deinit(hapd->wpa_auth);
 		hapd->wpa_auth = NULL;
@@ -53,6 +53,10 @@ struct wpa_state_machine {
 	bool EAPOLKeyRequest;
 	bool MICVerified;
 	bool GUpdateStationKeys;
+	/* Waiting in wpa_auth->gupdate_queue for a paced Group Key Handshake;
+	 * GUpdateStationKeys is already set */
+	bool GUpdateQueued;
+	struct dl_list gupdate_list;
 	u8 ANonce[WPA_NONCE_LEN];
 	u8 SNonce[WPA_NONCE_LEN];
 	u8 alt_SNonce[WPA_NONCE_LEN];
@@ -125,6 +129,7 @@ struct wpa_state_machine {
 
 	u32 dot11RSNAStatsTKIPLocalMICFailures;
 	u32 dot11RSNAStatsTKIPRemoteMICFailures;
+	unsigned int psk_mic_trials; /* PSK MIC checks in the last msg 2/4 */
 
 	bool rsn_override;
 	bool rsn_override_2;
@@ -227,6 +232,11 @@ struct wpa_group {
 	/* Number of references except those in struct wpa_group->next */
 	unsigned int references;
 	unsigned int num_setup_iface;
+
+	/* Current GTK rekey */
+	struct os_reltime rekey_start;
+	unsigned int rekey_stations;
+	unsigned int rekey_failures;
 };
 
 
@@ -259,8 +269,42 @@ struct wpa_authenticator {
 	struct rsn_pmksa_cache *pmksa;
 	struct wpa_ft_pmk_cache *ft_pmk_cache;
 
+#ifdef CONFIG_IEEE80211R_AP
+	/* Open addressing hash indexes of conf.r0kh_list and conf.r1kh_list;
+	 * rebuilt when *conf.rxkh_gen changes */
+	struct ft_remote_r0kh **r0kh_index;
+	struct ft_remote_r1kh **r1kh_index;
+	size_t r0kh_index_size; /* power of two */
+	size_t r1kh_index_size; /* power of two */
+	struct ft_remote_r0kh *r0kh_wildcard;
+	struct ft_remote_r1kh *r1kh_wildcard;
+	struct ft_remote_r0kh **rkh_index_r0kh_list;
+	unsigned int rkh_index_gen;
+	bool rkh_index_valid;
+
+	/* Recently freed struct ft_remote_item entries for reuse */
+	struct ft_remote_item *ft_item_pool;
+	unsigned int ft_item_pool_len;
+
+	unsigned int ft_pmk_r1_pushes; /* PMK-R1 push messages sent */
+	unsigned int ft_pmk_r1_push_hits; /* FT using a pushed PMK-R1 */
+	unsigned int ft_pmk_r1_pull_fallbacks; /* FT needing PMK-R1 pull */
+#endif /* CONFIG_IEEE80211R_AP */
+
 	bool non_tx_beacon_prot;
 
+	/* STAs waiting for the Group Key Handshake when
+	 * conf.wpa_group_update_rate is used; STAs that are not in power save
+	 * mode are updated first */
+	struct dl_list gupdate_queue;
+	struct dl_list gupdate_queue_dozing;
+
+	/* Statistics of the last completed GTK rekey */
+	unsigned int gtk_rekeys;
+	unsigned int gtk_rekey_stations;
+	unsigned int gtk_rekey_failures;
+	unsigned int gtk_rekey_msec;
+
 #ifdef CONFIG_P2P
 	struct bitfield *ip_pool;
 #endif /* CONFIG_P2P */
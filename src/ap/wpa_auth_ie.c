@@ -850,6 +850,28 @@ static int wpa_auth_okc_iter(struct wpa_authenticator *a, void *ctx)
 }
 
 
+struct wpa_auth_shared_iter_data {
+	struct wpa_authenticator *auth;
+	struct rsn_pmksa_cache_entry *pmksa;
+	const u8 *spa;
+	const u8 *pmkid;
+};
+
+
+static int wpa_auth_shared_iter(struct wpa_authenticator *a, void *ctx)
+{
+	struct wpa_auth_shared_iter_data *data = ctx;
+
+	if (a == data->auth || !a->conf.pmksa_cache_shared ||
+	    a->conf.ssid_len != data->auth->conf.ssid_len ||
+	    os_memcmp(a->conf.ssid, data->auth->conf.ssid,
+		      a->conf.ssid_len) != 0)
+		return 0;
+	data->pmksa = pmksa_cache_auth_get(a->pmksa, data->spa, data->pmkid);
+	return data->pmksa != NULL;
+}
+
+
 enum wpa_validate_result
 wpa_validate_wpa_ie(struct wpa_authenticator *wpa_auth,
 		    struct wpa_state_machine *sm, int freq,
@@ -1256,6 +1278,26 @@ wpa_validate_wpa_ie(struct wpa_authenticator *wpa_auth,
 			break;
 		}
 	}
+	for (i = 0; !sm->pmksa && wpa_auth->conf.pmksa_cache_shared &&
+		     i < data.num_pmkid; i++) {
+		struct wpa_auth_shared_iter_data idata;
+
+		idata.auth = wpa_auth;
+		idata.pmksa = NULL;
+		idata.spa = sm->addr;
+		idata.pmkid = &data.pmkid[i * PMKID_LEN];
+		wpa_auth_for_each_auth(wpa_auth, wpa_auth_shared_iter, &idata);
+		if (idata.pmksa) {
+			wpa_auth_vlogger(wpa_auth, sm->addr, LOGGER_DEBUG,
+					 "Shared PMKSA cache match for PMKID");
+			sm->pmksa = pmksa_cache_add_okc(wpa_auth->pmksa,
+							idata.pmksa,
+							wpa_auth->addr,
+							idata.pmkid);
+			pmkid = idata.pmkid;
+			break;
+		}
+	}
 	for (i = 0; sm->pmksa == NULL && wpa_auth->conf.okc &&
 		     i < data.num_pmkid; i++) {
 		struct wpa_auth_okc_iter_data idata;
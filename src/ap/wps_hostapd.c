@@ -134,6 +134,7 @@ static int hostapd_wps_new_psk_cb(void *ctx, const u8 *mac_addr,
 
 	p->next = ssid->wpa_psk;
 	ssid->wpa_psk = p;
+	hostapd_wpa_psk_index_update(ssid);
 
 	if (ssid->wpa_psk_file) {
 		FILE *f;
@@ -414,6 +415,7 @@ static int hapd_wps_reconfig_in_memory(struct hostapd_data *hapd,
 			bss->sae_require_mfp = 1;
 		}
 
+		hostapd_wpa_psk_index_free(&bss->ssid);
 		if (cred->key_len >= 8 && cred->key_len < 64) {
 			os_free(bss->ssid.wpa_passphrase);
 			bss->ssid.wpa_passphrase = os_zalloc(cred->key_len + 1);
@@ -958,6 +960,7 @@ static void hostapd_wps_clear_ies(struct hostapd_data *hapd, int deinit_only)
 
 	wpabuf_free(hapd->wps_probe_resp_ie);
 	hapd->wps_probe_resp_ie = NULL;
+	hostapd_flush_probe_resp_tmpl(hapd);
 
 	if (deinit_only) {
 		if (hapd->drv_priv)
@@ -1314,6 +1317,8 @@ int hostapd_init_wps(struct hostapd_data *hapd,
 	if (cfg.dualband)
 		wpa_printf(MSG_DEBUG, "WPS: Dualband AP");
 	cfg.force_per_enrollee_psk = conf->force_per_enrollee_psk;
+	cfg.dh_pool_size = conf->wps_dh_pool_size;
+	cfg.max_sessions_per_sec = conf->wps_max_sessions_per_sec;
 
 	wps->registrar = wps_registrar_init(wps, &cfg);
 	if (wps->registrar == NULL) {
@@ -125,6 +125,62 @@ void x_snoop_mcast_to_ucast_convert_send(struct hostapd_data *hapd,
 }
 
 
+/**
+ * x_snoop_mcast_to_ucast_fan_out - Send a multicast frame to all STAs
+ * @hapd: Pointer to BSS data
+ * @buf: Multicast frame including the Ethernet header
+ * @len: Length of the frame
+ *
+ * A unicast copy of the frame is sent to each authorized STA. The frames are
+ * sent in batches when l2_packet supports that.
+ */
+void x_snoop_mcast_to_ucast_fan_out(struct hostapd_data *hapd, const u8 *buf,
+				    size_t len)
+{
+	struct sta_info *sta;
+	u8 *addrs;
+	size_t num = 0;
+	int res;
+
+	if (!(buf[0] & 0x01) || hapd->num_sta <= 0)
+		return;
+
+	addrs = os_malloc(hapd->num_sta * ETH_ALEN);
+	if (!addrs)
+		return;
+	for (sta = hapd->sta_list; sta && num < (size_t) hapd->num_sta;
+	     sta = sta->next) {
+		if (!(sta->flags & WLAN_STA_AUTHORIZED))
+			continue;
+		os_memcpy(&addrs[num * ETH_ALEN], sta->addr, ETH_ALEN);
+		num++;
+	}
+
+	if (num) {
+		wpa_printf(MSG_EXCESSIVE,
+			   "x_snoop: Multicast-to-unicast conversion " MACSTR
+			   " -> %u STAs (len %u)", MAC2STR(buf),
+			   (unsigned int) num, (unsigned int) len);
+		res = l2_packet_send_multi(hapd->sock_dhcp, addrs, num, buf,
+					   len);
+		if (res < 0) {
+			for (sta = hapd->sta_list; sta; sta = sta->next) {
+				if (!(sta->flags & WLAN_STA_AUTHORIZED))
+					continue;
+				x_snoop_mcast_to_ucast_convert_send(
+					hapd, sta, (u8 *) buf, len);
+			}
+		} else if ((size_t) res < num) {
+			wpa_printf(MSG_DEBUG,
+				   "x_snoop: Failed to send mcast to ucast converted packet to %u STAs",
+				   (unsigned int) (num - res));
+		}
+	}
+
+	os_free(addrs);
+}
+
+
 void x_snoop_deinit(struct hostapd_data *hapd)
 {
 	if (!hapd->x_snoop_initialized)
@@ -17,6 +17,8 @@
 #include "gas.h"
 #include "wpa_common.h"
 #include "sae.h"
+#include "ctrl_iface_common.h"
+#include "ptksa_cache.h"
 
 
 struct ieee802_11_parse_test_data {
@@ -146,6 +148,135 @@ static int ieee802_11_parse_tests(void)
 }
 
 
+/* Elements from a captured Beacon frame of a 5 GHz HE AP */
+static const u8 elem_index_beacon[] = {
+	0x00, 0x08, 0x74, 0x65, 0x73, 0x74, 0x2d, 0x61, 0x70, 0x31,
+	0x01, 0x08, 0x8c, 0x12, 0x98, 0x24, 0xb0, 0x48, 0x60, 0x6c,
+	0x03, 0x01, 0x24,
+	0x05, 0x04, 0x00, 0x01, 0x00, 0x00,
+	0x07, 0x06, 0x46, 0x49, 0x20, 0x24, 0x04, 0x17,
+	0x30, 0x14, 0x01, 0x00, 0x00, 0x0f, 0xac, 0x04, 0x01, 0x00,
+	0x00, 0x0f, 0xac, 0x04, 0x01, 0x00, 0x00, 0x0f, 0xac, 0x08,
+	0xc0, 0x00,
+	0x2d, 0x1a, 0xef, 0x09, 0x1b, 0xff, 0xff, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x3d, 0x16, 0x24, 0x05, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00,
+	0x7f, 0x08, 0x04, 0x00, 0x08, 0x00, 0x00, 0x00, 0x00, 0x40,
+	0xbf, 0x0c, 0xb2, 0x79, 0x91, 0x33, 0xfa, 0xff, 0x0c, 0x03,
+	0xfa, 0xff, 0x0c, 0x03,
+	0xc0, 0x05, 0x01, 0x2a, 0x00, 0xfc, 0xff,
+	0xff, 0x19, 0x23, 0x0d, 0x01, 0x08, 0x1a, 0x40, 0x10, 0x0c,
+	0x63, 0x80, 0xfd, 0x09, 0x80, 0x0e, 0xcf, 0xf2, 0x00, 0xfa,
+	0xff, 0xfa, 0xff, 0x61, 0x1c, 0xc7, 0x71,
+	0xff, 0x07, 0x24, 0xf4, 0x3f, 0x00, 0x2a, 0xfc, 0xff,
+	0xdd, 0x18, 0x00, 0x50, 0xf2, 0x02, 0x01, 0x01, 0x80, 0x00,
+	0x03, 0xa4, 0x00, 0x00, 0x27, 0xa4, 0x00, 0x00, 0x42, 0x43,
+	0x5e, 0x00, 0x62, 0x32, 0x2f, 0x00,
+};
+
+static int ieee802_11_index_tests(void)
+{
+	struct ieee802_11_elem_index idx;
+	struct ieee802_11_elems elems;
+	struct os_reltime start, end, full, indexed;
+	const u8 *pos;
+	u8 elen;
+	int i, ret = 0;
+	const int iter = 10000;
+
+	wpa_printf(MSG_INFO, "ieee802_11_index tests");
+
+	for (i = 0; parse_tests[i].data; i++) {
+		ParseRes res;
+
+		res = ieee802_11_index_elems(parse_tests[i].data,
+					     parse_tests[i].len, &idx);
+		if ((res == ParseFailed) !=
+		    (parse_tests[i].result == ParseFailed)) {
+			wpa_printf(MSG_ERROR, "ieee802_11_index test %d failed",
+				   i);
+			ret = -1;
+		}
+	}
+
+	if (ieee802_11_parse_elems(elem_index_beacon,
+				   sizeof(elem_index_beacon), &elems, 1) ==
+	    ParseFailed ||
+	    ieee802_11_index_elems(elem_index_beacon,
+				   sizeof(elem_index_beacon), &idx) !=
+	    ParseOK) {
+		wpa_printf(MSG_ERROR, "ieee802_11_index beacon parse failed");
+		return -1;
+	}
+
+	pos = ieee802_11_index_get(&idx, WLAN_EID_SSID, &elen);
+	if (pos != elems.ssid || elen != elems.ssid_len)
+		ret = -1;
+	pos = ieee802_11_index_get(&idx, WLAN_EID_SUPP_RATES, &elen);
+	if (pos != elems.supp_rates || elen != elems.supp_rates_len)
+		ret = -1;
+	pos = ieee802_11_index_get(&idx, WLAN_EID_RSN, &elen);
+	if (pos != elems.rsn_ie || elen != elems.rsn_ie_len)
+		ret = -1;
+	if (ieee802_11_index_get(&idx, WLAN_EID_HT_CAP, NULL) !=
+	    elems.ht_capabilities ||
+	    ieee802_11_index_get(&idx, WLAN_EID_HT_OPERATION, NULL) !=
+	    elems.ht_operation ||
+	    ieee802_11_index_get(&idx, WLAN_EID_ERP_INFO, NULL))
+		ret = -1;
+	pos = ieee802_11_index_get_ext(&idx, WLAN_EID_EXT_HE_CAPABILITIES,
+				       &elen);
+	if (pos != elems.he_capabilities || elen != elems.he_capabilities_len)
+		ret = -1;
+	pos = ieee802_11_index_get_ext(&idx, WLAN_EID_EXT_HE_OPERATION, &elen);
+	if (pos != elems.he_operation || elen != elems.he_operation_len)
+		ret = -1;
+	pos = ieee802_11_index_get_vendor(&idx, WMM_IE_VENDOR_TYPE, &elen);
+	if (!pos || pos != elems.wmm || elen != elems.wmm_len)
+		ret = -1;
+	if (ieee802_11_index_get_vendor(&idx, WPA_IE_VENDOR_TYPE, NULL))
+		ret = -1;
+	if (ret) {
+		wpa_printf(MSG_ERROR, "ieee802_11_index accessor test failed");
+		return ret;
+	}
+
+	/* Compare against the full parse for the AP list use case */
+	os_get_reltime(&start);
+	for (i = 0; i < iter; i++) {
+		ieee802_11_parse_elems(elem_index_beacon,
+				       sizeof(elem_index_beacon), &elems, 0);
+		if (!elems.supp_rates || !elems.ds_params ||
+		    !elems.ht_capabilities)
+			ret = -1;
+	}
+	os_get_reltime(&end);
+	os_reltime_sub(&end, &start, &full);
+
+	os_get_reltime(&start);
+	for (i = 0; i < iter; i++) {
+		ieee802_11_index_elems(elem_index_beacon,
+				       sizeof(elem_index_beacon), &idx);
+		if (!ieee802_11_index_get(&idx, WLAN_EID_SUPP_RATES, &elen) ||
+		    !ieee802_11_index_get(&idx, WLAN_EID_DS_PARAMS, &elen) ||
+		    !ieee802_11_index_get(&idx, WLAN_EID_HT_CAP, &elen))
+			ret = -1;
+	}
+	os_get_reltime(&end);
+	os_reltime_sub(&end, &start, &indexed);
+
+	wpa_printf(MSG_INFO,
+		   "ieee802_11_index: %d Beacon frames: full parse %ld.%06ld s, index %ld.%06ld s",
+		   iter, (long) full.sec, (long) full.usec,
+		   (long) indexed.sec, (long) indexed.usec);
+
+	return ret;
+}
+
+
 struct rsn_ie_parse_test_data {
 	u8 *data;
 	size_t len;
@@ -385,7 +516,7 @@ static int sae_tests(void)
 		0x1e, 0xac, 0xcf, 0x33, 0x01, 0x99, 0xc1, 0x62
 	};
 	int pt_groups[] = { 19, 20, 21, 25, 26, 28, 29, 30, 15, 0 };
-	struct sae_pt *pt_info, *pt;
+	struct sae_pt *pt_info, *pt, *pt_info2, *pt2;
 	const u8 addr1b[ETH_ALEN] = { 0x00, 0x09, 0x5b, 0x66, 0xec, 0x1e };
 	const u8 addr2b[ETH_ALEN] = { 0x00, 0x0b, 0x6b, 0xd9, 0x02, 0x46 };
 
@@ -501,7 +632,30 @@ static int sae_tests(void)
 		}
 	}
 
+	/* A second derivation with the same parameters is served from the PT
+	 * cache and must give the same PT */
+	pt_info2 = sae_derive_pt(pt_groups,
+				 (const u8 *) ssid, os_strlen(ssid),
+				 (const u8 *) pw, os_strlen(pw), pwid);
+	for (pt = pt_info, pt2 = pt_info2; pt && pt2;
+	     pt = pt->next, pt2 = pt2->next) {
+		if (!pt->cache || pt->cache != pt2->cache ||
+		    (pt->ec && crypto_ec_point_cmp(pt->ec, pt->ecc_pt,
+						   pt2->ecc_pt) != 0) ||
+		    (!pt->ec && crypto_bignum_cmp(pt->ffc_pt,
+						  pt2->ffc_pt) != 0)) {
+			wpa_printf(MSG_ERROR, "SAE: PT cache mismatch");
+			break;
+		}
+	}
+	if (pt || pt2) {
+		sae_deinit_pt(pt_info);
+		sae_deinit_pt(pt_info2);
+		goto fail;
+	}
+
 	sae_deinit_pt(pt_info);
+	sae_deinit_pt(pt_info2);
 
 	ret = 0;
 fail:
@@ -776,6 +930,298 @@ static int pasn_tests(void)
 }
 
 
+static int ptksa_cache_tests(void)
+{
+#ifdef CONFIG_PTKSA_CACHE
+	struct ptksa_cache *ptksa;
+	struct ptksa_cache_stats stats;
+	struct wpa_ptk ptk;
+	u8 addr[ETH_ALEN] = { 0x02, 0x00, 0x00, 0x00, 0x00, 0x00 };
+	int i, ret = -1;
+
+	wpa_printf(MSG_INFO, "ptksa cache tests");
+
+	ptksa = ptksa_cache_init();
+	if (!ptksa || ptksa_cache_set_max_entries(ptksa, 4) < 0)
+		goto fail;
+
+	os_memset(&ptk, 0, sizeof(ptk));
+	ptk.tk_len = 16;
+	for (i = 0; i < 4; i++) {
+		addr[5] = i;
+		if (!ptksa_cache_add(ptksa, NULL, addr, WPA_CIPHER_CCMP, 100,
+				     &ptk, NULL, NULL, 0))
+			goto fail;
+	}
+
+	/* Use the oldest entry so that the second one gets removed when a new
+	 * entry is added to the full cache */
+	addr[5] = 0;
+	if (!ptksa_cache_get(ptksa, addr, WPA_CIPHER_NONE) ||
+	    ptksa_cache_get(ptksa, addr, WPA_CIPHER_GCMP))
+		goto fail;
+	addr[5] = 4;
+	if (!ptksa_cache_add(ptksa, NULL, addr, WPA_CIPHER_CCMP, 50, &ptk,
+			     NULL, NULL, 0))
+		goto fail;
+	addr[5] = 1;
+	if (ptksa_cache_get(ptksa, addr, WPA_CIPHER_NONE))
+		goto fail;
+	for (i = 0; i < 5; i++) {
+		addr[5] = i;
+		if (i != 1 && !ptksa_cache_get(ptksa, addr, WPA_CIPHER_CCMP))
+			goto fail;
+	}
+	if (ptksa_cache_get(ptksa, NULL, WPA_CIPHER_NONE) !=
+	    ptksa_cache_get(ptksa, addr, WPA_CIPHER_NONE))
+		goto fail;
+
+	addr[5] = 2;
+	ptksa_cache_flush(ptksa, addr, WPA_CIPHER_NONE);
+	if (ptksa_cache_get(ptksa, addr, WPA_CIPHER_CCMP))
+		goto fail;
+
+	ptksa_cache_get_stats(ptksa, &stats);
+	if (stats.entries != 3 || stats.max_entries != 4 || stats.hits != 7 ||
+	    stats.misses != 3 || stats.evictions != 1) {
+		wpa_printf(MSG_INFO,
+			   "ptksa cache: Unexpected stats entries=%u hits=%u misses=%u evictions=%u",
+			   stats.entries, stats.hits, stats.misses,
+			   stats.evictions);
+		goto fail;
+	}
+
+	ptksa_cache_flush(ptksa, NULL, WPA_CIPHER_NONE);
+	if (ptksa_cache_get(ptksa, NULL, WPA_CIPHER_NONE))
+		goto fail;
+
+	ret = 0;
+fail:
+	if (ret)
+		wpa_printf(MSG_INFO, "ptksa cache test failed");
+	ptksa_cache_deinit(ptksa);
+	return ret;
+#else /* CONFIG_PTKSA_CACHE */
+	return 0;
+#endif /* CONFIG_PTKSA_CACHE */
+}
+
+
+#ifdef CONFIG_SAE
+
+/* Full SAE commit/confirm exchange between two local instances */
+static int sae_bench_exchange(struct sae_pt *pt, struct wpabuf *buf)
+{
+	struct sae_data sae[2];
+	const u8 addr[2][ETH_ALEN] = {
+		{ 0x02, 0x00, 0x00, 0x00, 0x00, 0x01 },
+		{ 0x02, 0x00, 0x00, 0x00, 0x00, 0x02 }
+	};
+	const char *pw = "benchmark password";
+	int i, ret = -1;
+
+	os_memset(sae, 0, sizeof(sae));
+	for (i = 0; i < 2; i++) {
+		if (sae_set_group(&sae[i], 19) < 0)
+			goto fail;
+		if (pt && sae_prepare_commit_pt(&sae[i], pt, addr[i],
+						addr[!i], NULL, NULL) < 0)
+			goto fail;
+		if (!pt && sae_prepare_commit(addr[i], addr[!i],
+					      (const u8 *) pw, os_strlen(pw),
+					      &sae[i]) < 0)
+			goto fail;
+	}
+
+	for (i = 0; i < 2; i++) {
+		buf->used = 0;
+		if (sae_write_commit(&sae[i], buf, NULL, NULL) < 0 ||
+		    sae_parse_commit(&sae[!i], wpabuf_head(buf),
+				     wpabuf_len(buf), NULL, NULL, NULL, !!pt,
+				     NULL) != WLAN_STATUS_SUCCESS)
+			goto fail;
+	}
+
+	for (i = 0; i < 2; i++) {
+		if (sae_process_commit(&sae[i]) < 0)
+			goto fail;
+	}
+
+	for (i = 0; i < 2; i++) {
+		buf->used = 0;
+		if (sae_write_confirm(&sae[i], buf) < 0 ||
+		    sae_check_confirm(&sae[!i], wpabuf_head(buf),
+				      wpabuf_len(buf), NULL) < 0)
+			goto fail;
+	}
+
+	ret = 0;
+fail:
+	sae_clear_data(&sae[0]);
+	sae_clear_data(&sae[1]);
+	return ret;
+}
+
+#endif /* CONFIG_SAE */
+
+
+static int sae_benchmarks(void)
+{
+#ifdef CONFIG_SAE
+	struct module_bench b;
+	struct wpabuf *buf;
+	struct sae_pt *pt = NULL;
+	int groups[] = { 19, 0 };
+	const char *ssid = "benchmark";
+	const char *pw = "benchmark password";
+	int ret = -1;
+
+	buf = wpabuf_alloc(1000);
+	if (!buf)
+		return -1;
+
+	for (module_bench_start(&b, "SAE group 19 exchange");
+	     module_bench_continue(&b);) {
+		if (sae_bench_exchange(NULL, buf) < 0)
+			goto fail;
+	}
+	module_bench_report(&b);
+
+	/* Derive the PT outside the loop since it is cached per password */
+	pt = sae_derive_pt(groups, (const u8 *) ssid, os_strlen(ssid),
+			   (const u8 *) pw, os_strlen(pw), NULL);
+	if (!pt)
+		goto fail;
+
+	for (module_bench_start(&b, "SAE group 19 H2E exchange");
+	     module_bench_continue(&b);) {
+		if (sae_bench_exchange(pt, buf) < 0)
+			goto fail;
+	}
+	module_bench_report(&b);
+
+	ret = 0;
+fail:
+	if (ret)
+		wpa_printf(MSG_ERROR, "SAE benchmarks failed");
+	sae_deinit_pt(pt);
+	wpabuf_free(buf);
+	return ret;
+#else /* CONFIG_SAE */
+	return 0;
+#endif /* CONFIG_SAE */
+}
+
+
+static int op_class_tests(void)
+{
+	const struct oper_class_map *op;
+	static const struct {
+		const char *country;
+		u8 op_class;
+		u8 chan;
+		int freq;
+	} tests[] = {
+		{ "US", 12, 11, 2462 },
+		{ "CA", 5, 165, 5825 },
+		{ "DE", 17, 169, 5845 },
+		{ "DE", 125, 149, 5745 },
+		{ "de", 17, 169, -1 },
+		{ "JP", 31, 14, 2484 },
+		{ "CN", 3, 165, 5825 },
+		{ "IN", 81, 1, 2412 },
+		{ NULL, 131, 1, 5955 },
+		{ NULL, 12, 11, -1 },
+	};
+	unsigned int i;
+
+	wpa_printf(MSG_INFO, "operating class tests");
+
+	for (op = &global_op_class[0]; op->op_class; op++) {
+		if (get_oper_class(NULL, op->op_class) != op) {
+			wpa_printf(MSG_ERROR, "get_oper_class(%u) failed",
+				   op->op_class);
+			return -1;
+		}
+	}
+
+	if (get_oper_class(NULL, 0) || get_oper_class(NULL, 255) ||
+	    get_oper_class("US", 12) != get_oper_class(NULL, 81) ||
+	    get_oper_class("XX", 12)) {
+		wpa_printf(MSG_ERROR, "get_oper_class() country tests failed");
+		return -1;
+	}
+
+	for (i = 0; i < ARRAY_SIZE(tests); i++) {
+		int freq = ieee80211_chan_to_freq(tests[i].country,
+						  tests[i].op_class,
+						  tests[i].chan);
+
+		if (freq != tests[i].freq) {
+			wpa_printf(MSG_ERROR,
+				   "ieee80211_chan_to_freq(%s, %u, %u) returned %d (expected %d)",
+				   tests[i].country ? tests[i].country : "-",
+				   tests[i].op_class, tests[i].chan, freq,
+				   tests[i].freq);
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+
+static int ctrl_iface_event_filter_tests(void)
+{
+#ifdef CONFIG_CTRL_IFACE_UNIX
+	struct dl_list ctrl_dst;
+	struct sockaddr_storage from;
+	struct wpa_ctrl_dst *dst;
+	char long_filter[7 + WPA_CTRL_EVENT_FILTER_LEN + 1];
+	int ret = -1;
+
+	wpa_printf(MSG_INFO, "ctrl_iface event filter tests");
+
+	dl_list_init(&ctrl_dst);
+	os_memset(&from, 0, sizeof(from));
+	from.ss_family = AF_UNIX;
+	if (ctrl_iface_attach(&ctrl_dst, &from, sizeof(from),
+			      "events=CTRL-EVENT-CONNECTED,,WPS- "
+			      "probe_rx_events=1") < 0)
+		goto fail;
+	dst = dl_list_first(&ctrl_dst, struct wpa_ctrl_dst, list);
+	if (!dst || !(dst->events & WPA_EVENT_RX_PROBE_REQUEST) ||
+	    !ctrl_iface_event_wanted(dst, "CTRL-EVENT-CONNECTED - x", 24) ||
+	    !ctrl_iface_event_wanted(dst, "WPS-SUCCESS", 11) ||
+	    ctrl_iface_event_wanted(dst, "WPS", 3) ||
+	    ctrl_iface_event_wanted(dst, "CTRL-EVENT-BSS-ADDED 1", 22))
+		goto fail;
+
+	/* An empty list removes the filter */
+	if (ctrl_iface_attach(&ctrl_dst, &from, sizeof(from), "events=") < 0 ||
+	    !ctrl_iface_event_wanted(dst, "CTRL-EVENT-BSS-ADDED 1", 22))
+		goto fail;
+
+	os_memcpy(long_filter, "events=", 7);
+	os_memset(long_filter + 7, 'A', WPA_CTRL_EVENT_FILTER_LEN);
+	long_filter[sizeof(long_filter) - 1] = '\0';
+	if (ctrl_iface_attach(&ctrl_dst, &from, sizeof(from),
+			      long_filter) == 0 ||
+	    !ctrl_iface_event_wanted(dst, "CTRL-EVENT-BSS-ADDED 1", 22))
+		goto fail;
+
+	ret = 0;
+fail:
+	if (ret)
+		wpa_printf(MSG_ERROR, "ctrl_iface event filter test failed");
+	ctrl_iface_detach(&ctrl_dst, &from, sizeof(from));
+	return ret;
+#else /* CONFIG_CTRL_IFACE_UNIX */
+	return 0;
+#endif /* CONFIG_CTRL_IFACE_UNIX */
+}
+
+
 int common_module_tests(void)
 {
 	int ret = 0;
@@ -783,11 +1229,16 @@ int common_module_tests(void)
 	wpa_printf(MSG_INFO, "common module tests");
 
 	if (ieee802_11_parse_tests() < 0 ||
+	    ieee802_11_index_tests() < 0 ||
+	    op_class_tests() < 0 ||
 	    gas_tests() < 0 ||
 	    sae_tests() < 0 ||
 	    sae_pk_tests() < 0 ||
 	    pasn_tests() < 0 ||
-	    rsn_ie_parse_tests() < 0)
+	    ptksa_cache_tests() < 0 ||
+	    rsn_ie_parse_tests() < 0 ||
+	    ctrl_iface_event_filter_tests() < 0 ||
+	    sae_benchmarks() < 0)
 		ret = -1;
 
 	return ret;
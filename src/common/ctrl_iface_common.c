@@ -113,18 +113,47 @@ void sockaddr_print(int level, const char *msg, struct sockaddr_storage *sock,
 }
 
 
-static int ctrl_set_events(struct wpa_ctrl_dst *dst, const char *input)
+static int ctrl_set_event_filter(struct wpa_ctrl_dst *dst, const char *value,
+				 size_t len)
+{
+	char *pos = dst->event_filter;
+	char *end = dst->event_filter + sizeof(dst->event_filter) - 2;
+
+	/* Comma separated list of event name prefixes; empty list clears the
+	 * filter */
+	os_memset(dst->event_filter, 0, sizeof(dst->event_filter));
+	for (; len > 0; value++, len--) {
+		if (*value == ',') {
+			if (pos > dst->event_filter && pos[-1] != '\0')
+				pos++;
+			continue;
+		}
+		if (pos >= end) {
+			os_memset(dst->event_filter, 0,
+				  sizeof(dst->event_filter));
+			return -1;
+		}
+		*pos++ = *value;
+	}
+
+	return 0;
+}
+
+
+static int ctrl_set_event(struct wpa_ctrl_dst *dst, const char *input,
+			  size_t len)
 {
 	const char *value;
 	int val;
 
-	if (!input)
-		return 0;
-
 	value = os_strchr(input, '=');
-	if (!value)
+	if (!value || value >= input + len)
 		return -1;
 	value++;
+
+	if (str_starts(input, "events="))
+		return ctrl_set_event_filter(dst, value, input + len - value);
+
 	val = atoi(value);
 	if (val < 0 || val > 1)
 		return -1;
@@ -140,6 +169,55 @@ static int ctrl_set_events(struct wpa_ctrl_dst *dst, const char *input)
 }
 
 
+static int ctrl_set_events(struct wpa_ctrl_dst *dst, const char *input)
+{
+	const char *end;
+	size_t len;
+
+	while (input && *input) {
+		end = os_strchr(input, ' ');
+		len = end ? (size_t) (end - input) : os_strlen(input);
+		if (len && ctrl_set_event(dst, input, len) < 0)
+			return -1;
+		input += len;
+		while (*input == ' ')
+			input++;
+	}
+
+	return 0;
+}
+
+
+/**
+ * ctrl_iface_event_wanted - Check whether a monitor has subscribed to an event
+ * @dst: Control interface monitor
+ * @buf: Event message without the priority level prefix
+ * @len: Length of the event message
+ * Returns: 1 if the event is to be sent to the monitor, 0 if not
+ *
+ * A monitor that was attached with "events=<prefix>[,<prefix>...]" receives
+ * only the events whose name starts with one of the listed prefixes.
+ */
+int ctrl_iface_event_wanted(const struct wpa_ctrl_dst *dst, const char *buf,
+			    size_t len)
+{
+	const char *pos = dst->event_filter;
+	size_t plen;
+
+	if (!*pos)
+		return 1;
+
+	while (*pos) {
+		plen = os_strlen(pos);
+		if (plen <= len && os_memcmp(buf, pos, plen) == 0)
+			return 1;
+		pos += plen + 1;
+	}
+
+	return 0;
+}
+
+
 int ctrl_iface_attach(struct dl_list *ctrl_dst, struct sockaddr_storage *from,
 		      socklen_t fromlen, const char *input)
 {
@@ -159,6 +237,7 @@ int ctrl_iface_attach(struct dl_list *ctrl_dst, struct sockaddr_storage *from,
 	os_memcpy(&dst->addr, from, fromlen);
 	dst->addrlen = fromlen;
 	dst->debug_level = MSG_INFO;
+	dl_list_init(&dst->pending);
 	ctrl_set_events(dst, input);
 	dl_list_add(ctrl_dst, &dst->list);
 
@@ -178,7 +257,7 @@ int ctrl_iface_detach(struct dl_list *ctrl_dst, struct sockaddr_storage *from,
 			sockaddr_print(MSG_DEBUG, "CTRL_IFACE monitor detached",
 				       from, fromlen);
 			dl_list_del(&dst->list);
-			os_free(dst);
+			ctrl_iface_free_dst(dst);
 			return 0;
 		}
 	}
@@ -187,6 +266,19 @@ int ctrl_iface_detach(struct dl_list *ctrl_dst, struct sockaddr_storage *from,
 }
 
 
+void ctrl_iface_free_dst(struct wpa_ctrl_dst *dst)
+{
+	struct wpa_ctrl_msg *msg, *prev;
+
+	dl_list_for_each_safe(msg, prev, &dst->pending, struct wpa_ctrl_msg,
+			      list) {
+		dl_list_del(&msg->list);
+		os_free(msg);
+	}
+	os_free(dst);
+}
+
+
 int ctrl_iface_level(struct dl_list *ctrl_dst, struct sockaddr_storage *from,
 		     socklen_t fromlen, const char *level)
 {
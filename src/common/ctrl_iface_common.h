@@ -14,6 +14,9 @@
 /* Events enable bits (wpa_ctrl_dst::events) */
 #define WPA_EVENT_RX_PROBE_REQUEST BIT(0)
 
+/* Maximum length of the event name prefix list (wpa_ctrl_dst::event_filter) */
+#define WPA_CTRL_EVENT_FILTER_LEN 256
+
 /**
  * struct wpa_ctrl_dst - Data structure of control interface monitors
  *
@@ -27,6 +30,25 @@ struct wpa_ctrl_dst {
 	int debug_level;
 	int errors;
 	u32 events; /* WPA_EVENT_* bitmap */
+	/* Event name prefixes separated by '\0' and terminated by an empty
+	 * string; all events are sent to the monitor if the list is empty */
+	char event_filter[WPA_CTRL_EVENT_FILTER_LEN];
+	/* Event messages (struct wpa_ctrl_msg) waiting to be sent to a
+	 * monitor that is not keeping up */
+	struct dl_list pending;
+	unsigned int num_pending;
+	unsigned int dropped; /* messages dropped since the last report */
+};
+
+
+/**
+ * struct wpa_ctrl_msg - Event message queued for a control interface monitor
+ *
+ * The formatted message (len octets) follows this structure.
+ */
+struct wpa_ctrl_msg {
+	struct dl_list list;
+	size_t len;
 };
 
 void sockaddr_print(int level, const char *msg, struct sockaddr_storage *sock,
@@ -36,7 +58,10 @@ int ctrl_iface_attach(struct dl_list *ctrl_dst, struct sockaddr_storage *from,
 		       socklen_t fromlen, const char *input);
 int ctrl_iface_detach(struct dl_list *ctrl_dst, struct sockaddr_storage *from,
 		      socklen_t fromlen);
+void ctrl_iface_free_dst(struct wpa_ctrl_dst *dst);
 int ctrl_iface_level(struct dl_list *ctrl_dst, struct sockaddr_storage *from,
 		     socklen_t fromlen, const char *level);
+int ctrl_iface_event_wanted(const struct wpa_ctrl_dst *dst, const char *buf,
+			    size_t len);
 
 #endif /* CONTROL_IFACE_COMMON_H */
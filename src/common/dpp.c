@@ -1521,7 +1521,7 @@ void dpp_auth_deinit(struct dpp_authentication *auth)
 	wpabuf_free(auth->net_access_key);
 	dpp_bootstrap_info_free(auth->tmp_own_bi);
 	if (auth->tmp_peer_bi) {
-		dl_list_del(&auth->tmp_peer_bi->list);
+		dpp_bootstrap_unlink(auth->global, auth->tmp_peer_bi);
 		dpp_bootstrap_info_free(auth->tmp_peer_bi);
 	}
 	os_free(auth->e_name);
@@ -1894,11 +1894,21 @@ skip_groups:
 	wpabuf_put_str(buf, signed_conn);
 	wpabuf_put_str(buf, "\"");
 	json_value_sep(buf);
-	if (dpp_build_jwk(buf, "csign", auth->conf->csign, auth->conf->kid,
-			  curve) < 0) {
-		wpa_printf(MSG_DEBUG, "DPP: Failed to build csign JWK");
-		goto fail;
+	if (!auth->conf->csign_jwk) {
+		struct wpabuf *jwk;
+
+		jwk = wpabuf_alloc(100 + 2 * curve->prime_len * 4 / 3 +
+				   os_strlen(auth->conf->kid));
+		if (!jwk ||
+		    dpp_build_jwk(jwk, "csign", auth->conf->csign,
+				  auth->conf->kid, curve) < 0) {
+			wpa_printf(MSG_DEBUG, "DPP: Failed to build csign JWK");
+			wpabuf_free(jwk);
+			goto fail;
+		}
+		auth->conf->csign_jwk = jwk;
 	}
+	wpabuf_put_buf(buf, auth->conf->csign_jwk);
 #ifdef CONFIG_DPP2
 	if (auth->peer_version >= 2 && auth->conf->pp_key) {
 		json_value_sep(buf);
@@ -2008,7 +2018,7 @@ static int dpp_get_peer_bi_id(struct dpp_authentication *auth)
 	if (!bi)
 		return -1;
 	bi->id = dpp_next_id(auth->global);
-	dl_list_add(&auth->global->bootstrap, &bi->list);
+	dpp_bootstrap_add(auth->global, bi);
 	auth->tmp_peer_bi = bi;
 	return bi->id;
 }
@@ -3962,6 +3972,8 @@ void dpp_configurator_free(struct dpp_configurator *conf)
 	os_free(conf->connector);
 	crypto_ec_key_deinit(conf->connector_key);
 	crypto_ec_key_deinit(conf->pp_key);
+	os_free(conf->jws_prot_hdr);
+	wpabuf_free(conf->csign_jwk);
 	os_free(conf);
 }
 
@@ -4394,16 +4406,97 @@ int dpp_get_connector_version(const char *connector)
 #endif /* CONFIG_DPP3 */
 
 
+static unsigned int dpp_bootstrap_hash(struct dpp_global *dpp, const u8 *hash)
+{
+	/* The public key hashes are SHA-256 output and uniformly distributed */
+	return WPA_GET_LE32(hash) & (dpp->bootstrap_hash_size - 1);
+}
+
+
+static void dpp_bootstrap_hash_add(struct dpp_global *dpp,
+				   struct dpp_bootstrap_info *bi)
+{
+	dl_list_add(&dpp->bootstrap_by_id[bi->id &
+					  (dpp->bootstrap_hash_size - 1)],
+		    &bi->id_list);
+	dl_list_add(&dpp->bootstrap_by_pkhash[dpp_bootstrap_hash(
+				    dpp, bi->pubkey_hash)],
+		    &bi->pkhash_list);
+	dl_list_add(&dpp->bootstrap_by_chirp[dpp_bootstrap_hash(
+				    dpp, bi->pubkey_hash_chirp)],
+		    &bi->chirp_list);
+}
+
+
+static int dpp_bootstrap_hash_resize(struct dpp_global *dpp,
+				     unsigned int size)
+{
+	struct dl_list *buckets;
+	struct dpp_bootstrap_info *bi;
+	unsigned int i;
+
+	buckets = os_calloc(3 * size, sizeof(struct dl_list));
+	if (!buckets)
+		return -1;
+	for (i = 0; i < 3 * size; i++)
+		dl_list_init(&buckets[i]);
+
+	os_free(dpp->bootstrap_by_id);
+	dpp->bootstrap_by_id = buckets;
+	dpp->bootstrap_by_pkhash = &buckets[size];
+	dpp->bootstrap_by_chirp = &buckets[2 * size];
+	dpp->bootstrap_hash_size = size;
+
+	/* Keep the order of the main list within each bucket */
+	dl_list_for_each_reverse(bi, &dpp->bootstrap,
+				 struct dpp_bootstrap_info, list)
+		dpp_bootstrap_hash_add(dpp, bi);
+
+	return 0;
+}
+
+
+void dpp_bootstrap_add(struct dpp_global *dpp, struct dpp_bootstrap_info *bi)
+{
+	dl_list_add(&dpp->bootstrap, &bi->list);
+	dpp_bootstrap_hash_add(dpp, bi);
+	dpp->num_bootstrap++;
+	if (dpp->bootstrap_max_id_valid && bi->id > dpp->bootstrap_max_id)
+		dpp->bootstrap_max_id = bi->id;
+
+	if (dpp->num_bootstrap > dpp->bootstrap_hash_size &&
+	    dpp->bootstrap_hash_size < DPP_BOOTSTRAP_HASH_MAX)
+		dpp_bootstrap_hash_resize(dpp, 2 * dpp->bootstrap_hash_size);
+}
+
+
+void dpp_bootstrap_unlink(struct dpp_global *dpp,
+			  struct dpp_bootstrap_info *bi)
+{
+	dl_list_del(&bi->list);
+	dl_list_del(&bi->id_list);
+	dl_list_del(&bi->pkhash_list);
+	dl_list_del(&bi->chirp_list);
+	dpp->num_bootstrap--;
+	if (bi->id == dpp->bootstrap_max_id)
+		dpp->bootstrap_max_id_valid = false;
+}
+
+
 unsigned int dpp_next_id(struct dpp_global *dpp)
 {
 	struct dpp_bootstrap_info *bi;
-	unsigned int max_id = 0;
 
-	dl_list_for_each(bi, &dpp->bootstrap, struct dpp_bootstrap_info, list) {
-		if (bi->id > max_id)
-			max_id = bi->id;
+	if (!dpp->bootstrap_max_id_valid) {
+		dpp->bootstrap_max_id = 0;
+		dl_list_for_each(bi, &dpp->bootstrap,
+				 struct dpp_bootstrap_info, list) {
+			if (bi->id > dpp->bootstrap_max_id)
+				dpp->bootstrap_max_id = bi->id;
+		}
+		dpp->bootstrap_max_id_valid = true;
 	}
-	return max_id + 1;
+	return dpp->bootstrap_max_id + 1;
 }
 
 
@@ -4424,7 +4517,7 @@ static int dpp_bootstrap_del(struct dpp_global *dpp, unsigned int id)
 		if (dpp->remove_bi)
 			dpp->remove_bi(dpp->cb_ctx, bi);
 #endif /* CONFIG_DPP2 */
-		dl_list_del(&bi->list);
+		dpp_bootstrap_unlink(dpp, bi);
 		dpp_bootstrap_info_free(bi);
 	}
 
@@ -4448,7 +4541,7 @@ struct dpp_bootstrap_info * dpp_add_qr_code(struct dpp_global *dpp,
 
 	bi->type = DPP_BOOTSTRAP_QR_CODE;
 	bi->id = dpp_next_id(dpp);
-	dl_list_add(&dpp->bootstrap, &bi->list);
+	dpp_bootstrap_add(dpp, bi);
 	return bi;
 }
 
@@ -4467,7 +4560,7 @@ struct dpp_bootstrap_info * dpp_add_nfc_uri(struct dpp_global *dpp,
 
 	bi->type = DPP_BOOTSTRAP_NFC_URI;
 	bi->id = dpp_next_id(dpp);
-	dl_list_add(&dpp->bootstrap, &bi->list);
+	dpp_bootstrap_add(dpp, bi);
 	return bi;
 }
 
@@ -4560,7 +4653,7 @@ int dpp_bootstrap_gen(struct dpp_global *dpp, const char *cmd)
 		goto fail;
 
 	bi->id = dpp_next_id(dpp);
-	dl_list_add(&dpp->bootstrap, &bi->list);
+	dpp_bootstrap_add(dpp, bi);
 	ret = bi->id;
 	bi = NULL;
 fail:
@@ -4584,7 +4677,10 @@ dpp_bootstrap_get_id(struct dpp_global *dpp, unsigned int id)
 	if (!dpp)
 		return NULL;
 
-	dl_list_for_each(bi, &dpp->bootstrap, struct dpp_bootstrap_info, list) {
+	dl_list_for_each(bi, &dpp->bootstrap_by_id[id &
+						   (dpp->bootstrap_hash_size -
+						    1)],
+			 struct dpp_bootstrap_info, id_list) {
 		if (bi->id == id)
 			return bi;
 	}
@@ -4726,25 +4822,30 @@ void dpp_bootstrap_find_pair(struct dpp_global *dpp, const u8 *i_bootstrap,
 	if (!dpp)
 		return;
 
-	dl_list_for_each(bi, &dpp->bootstrap, struct dpp_bootstrap_info, list) {
-		if (!*own_bi && bi->own &&
+	dl_list_for_each(bi, &dpp->bootstrap_by_pkhash[
+				 dpp_bootstrap_hash(dpp, r_bootstrap)],
+			 struct dpp_bootstrap_info, pkhash_list) {
+		if (bi->own &&
 		    os_memcmp(bi->pubkey_hash, r_bootstrap,
 			      SHA256_MAC_LEN) == 0) {
 			wpa_printf(MSG_DEBUG,
 				   "DPP: Found matching own bootstrapping information");
 			*own_bi = bi;
+			break;
 		}
+	}
 
-		if (!*peer_bi && !bi->own &&
+	dl_list_for_each(bi, &dpp->bootstrap_by_pkhash[
+				 dpp_bootstrap_hash(dpp, i_bootstrap)],
+			 struct dpp_bootstrap_info, pkhash_list) {
+		if (!bi->own &&
 		    os_memcmp(bi->pubkey_hash, i_bootstrap,
 			      SHA256_MAC_LEN) == 0) {
 			wpa_printf(MSG_DEBUG,
 				   "DPP: Found matching peer bootstrapping information");
 			*peer_bi = bi;
-		}
-
-		if (*own_bi && *peer_bi)
 			break;
+		}
 	}
 }
 
@@ -4758,7 +4859,9 @@ struct dpp_bootstrap_info * dpp_bootstrap_find_chirp(struct dpp_global *dpp,
 	if (!dpp)
 		return NULL;
 
-	dl_list_for_each(bi, &dpp->bootstrap, struct dpp_bootstrap_info, list) {
+	dl_list_for_each(bi, &dpp->bootstrap_by_chirp[dpp_bootstrap_hash(dpp,
+									 hash)],
+			 struct dpp_bootstrap_info, chirp_list) {
 		if (!bi->own && os_memcmp(bi->pubkey_hash_chirp, hash,
 					  SHA256_MAC_LEN) == 0)
 			return bi;
@@ -5087,6 +5190,11 @@ struct dpp_global * dpp_global_init(struct dpp_global_config *config)
 #endif /* CONFIG_DPP2 */
 
 	dl_list_init(&dpp->bootstrap);
+	dpp->bootstrap_max_id_valid = true;
+	if (dpp_bootstrap_hash_resize(dpp, DPP_BOOTSTRAP_HASH_MIN) < 0) {
+		os_free(dpp);
+		return NULL;
+	}
 	dl_list_init(&dpp->configurator);
 #ifdef CONFIG_DPP2
 	dl_list_init(&dpp->controllers);
@@ -5116,6 +5224,8 @@ void dpp_global_clear(struct dpp_global *dpp)
 void dpp_global_deinit(struct dpp_global *dpp)
 {
 	dpp_global_clear(dpp);
+	if (dpp)
+		os_free(dpp->bootstrap_by_id);
 	os_free(dpp);
 }
 
@@ -165,6 +165,9 @@ enum dpp_bootstrap_supported_curves {
 
 struct dpp_bootstrap_info {
 	struct dl_list list;
+	struct dl_list id_list; /* dpp_global::bootstrap_by_id[] */
+	struct dl_list pkhash_list; /* dpp_global::bootstrap_by_pkhash[] */
+	struct dl_list chirp_list; /* dpp_global::bootstrap_by_chirp[] */
 	unsigned int id;
 	enum dpp_bootstrap_type type;
 	char *uri;
@@ -426,6 +429,10 @@ struct dpp_configurator {
 	char *connector; /* own Connector for reconfiguration */
 	struct crypto_ec_key *connector_key;
 	struct crypto_ec_key *pp_key;
+	/* Reused across signed Connectors and config objects; built lazily */
+	char *jws_prot_hdr; /* base64url encoded JWS Protected Header */
+	size_t jws_prot_hdr_len;
+	struct wpabuf *csign_jwk; /* "csign" JWK JSON member */
 };
 
 struct dpp_introduction {
@@ -457,6 +464,7 @@ struct dpp_controller_config {
 	u8 allowed_roles;
 	int qr_mutual;
 	enum dpp_netrole netrole;
+	unsigned int max_conn; /* 0 = no limit */
 	void *msg_ctx;
 	void *cb_ctx;
 	int (*process_conf_obj)(void *ctx, struct dpp_authentication *auth);
@@ -780,6 +788,7 @@ int dpp_controller_set_params(struct dpp_global *dpp,
 			      const char *configurator_params);
 void dpp_controller_stop(struct dpp_global *dpp);
 void dpp_controller_stop_for_ctx(struct dpp_global *dpp, void *cb_ctx);
+int dpp_controller_get_stats(struct dpp_global *dpp, char *buf, size_t buflen);
 struct dpp_authentication * dpp_controller_get_auth(struct dpp_global *dpp,
 						    unsigned int id);
 void dpp_controller_new_qr_code(struct dpp_global *dpp,
@@ -1908,7 +1908,7 @@ dpp_build_conn_signature(struct dpp_configurator *conf,
 	char *dot = ".";
 	const u8 *vector[3];
 	size_t vector_len[3];
-	u8 *hash;
+	u8 hash[DPP_MAX_HASH_LEN];
 	int ret;
 
 	vector[0] = (const u8 *) signed1;
@@ -1919,9 +1919,6 @@ dpp_build_conn_signature(struct dpp_configurator *conf,
 	vector_len[2] = signed2_len;
 
 	curve = conf->curve;
-	hash = os_malloc(curve->hash_len);
-	if (!hash)
-		goto fail;
 	if (curve->hash_len == SHA256_MAC_LEN) {
 		ret = sha256_vector(3, vector, vector_len, hash);
 	} else if (curve->hash_len == SHA384_MAC_LEN) {
@@ -1951,7 +1948,6 @@ dpp_build_conn_signature(struct dpp_configurator *conf,
 				    signed3_len);
 
 fail:
-	os_free(hash);
 	wpabuf_free(sig);
 	return signed3;
 }
@@ -1959,14 +1955,23 @@ fail:
 char * dpp_sign_connector(struct dpp_configurator *conf,
 			  const struct wpabuf *dppcon)
 {
-	char *signed1 = NULL, *signed2 = NULL, *signed3 = NULL;
+	char *signed1, *signed2 = NULL, *signed3 = NULL;
 	char *signed_conn = NULL, *pos;
 	size_t signed1_len, signed2_len, signed3_len;
 
-	signed1 = dpp_build_jws_prot_hdr(conf, &signed1_len);
+	/* The protected header depends only on the configurator, so build it
+	 * once and reuse it for all the Connectors signed with this key. */
+	if (!conf->jws_prot_hdr) {
+		conf->jws_prot_hdr = dpp_build_jws_prot_hdr(
+			conf, &conf->jws_prot_hdr_len);
+		if (!conf->jws_prot_hdr)
+			return NULL;
+	}
+	signed1 = conf->jws_prot_hdr;
+	signed1_len = conf->jws_prot_hdr_len;
 	signed2 = base64_url_encode(wpabuf_head(dppcon), wpabuf_len(dppcon),
 				    &signed2_len);
-	if (!signed1 || !signed2)
+	if (!signed2)
 		goto fail;
 
 	signed3 = dpp_build_conn_signature(conf, signed1, signed1_len,
@@ -1989,7 +1994,6 @@ char * dpp_sign_connector(struct dpp_configurator *conf,
 	*pos = '\0';
 
 fail:
-	os_free(signed1);
 	os_free(signed2);
 	os_free(signed3);
 	return signed_conn;
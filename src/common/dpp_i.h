@@ -13,9 +13,21 @@
 
 #ifdef CONFIG_DPP
 
+/* Number of hash buckets for bootstrap entries; doubled as entries are added */
+#define DPP_BOOTSTRAP_HASH_MIN 16
+#define DPP_BOOTSTRAP_HASH_MAX 65536
+
 struct dpp_global {
 	void *msg_ctx;
 	struct dl_list bootstrap; /* struct dpp_bootstrap_info */
+	/* Hash tables of the bootstrap entries, bootstrap_hash_size buckets */
+	struct dl_list *bootstrap_by_id;
+	struct dl_list *bootstrap_by_pkhash;
+	struct dl_list *bootstrap_by_chirp;
+	unsigned int bootstrap_hash_size;
+	unsigned int num_bootstrap;
+	unsigned int bootstrap_max_id;
+	bool bootstrap_max_id_valid;
 	struct dl_list configurator; /* struct dpp_configurator */
 #ifdef CONFIG_DPP2
 	struct dl_list controllers; /* struct dpp_relay_controller */
@@ -41,6 +53,9 @@ struct dpp_global {
 void dpp_build_attr_status(struct wpabuf *msg, enum dpp_status_error status);
 void dpp_build_attr_r_bootstrap_key_hash(struct wpabuf *msg, const u8 *hash);
 unsigned int dpp_next_id(struct dpp_global *dpp);
+void dpp_bootstrap_add(struct dpp_global *dpp, struct dpp_bootstrap_info *bi);
+void dpp_bootstrap_unlink(struct dpp_global *dpp,
+			  struct dpp_bootstrap_info *bi);
 struct wpabuf * dpp_build_conn_status(enum dpp_status_error result,
 				      const u8 *ssid, size_t ssid_len,
 				      const char *channel_list);
@@ -1366,7 +1366,7 @@ dpp_pkex_finish(struct dpp_global *dpp, struct dpp_pkex *pkex, const u8 *peer,
 	os_memcpy(pkex->own_bi->peer_pubkey_hash, bi->pubkey_hash,
 		  SHA256_MAC_LEN);
 	dpp_pkex_free(pkex);
-	dl_list_add(&dpp->bootstrap, &bi->list);
+	dpp_bootstrap_add(dpp, bi);
 	return bi;
 }
 
@@ -85,9 +85,25 @@ struct dpp_controller {
 	void *cb_ctx;
 	int (*process_conf_obj)(void *ctx, struct dpp_authentication *auth);
 	bool (*tcp_msg_sent)(void *ctx, struct dpp_authentication *auth);
+
+	/* Connection limit; new connections wait in the listen backlog */
+	unsigned int max_conn;
+	unsigned int num_conn;
+	bool accept_paused;
+
+	/* Statistics */
+	struct os_reltime started;
+	unsigned int conn_accepted;
+	unsigned int accept_pauses;
+	unsigned int conf_req;
+	unsigned int conf_sent;
+	unsigned int conf_failed;
+	struct os_reltime conf_build_total;
+	struct os_reltime conf_build_max;
 };
 
 static void dpp_controller_rx(int sd, void *eloop_ctx, void *sock_ctx);
+static void dpp_controller_tcp_cb(int sd, void *eloop_ctx, void *sock_ctx);
 static void dpp_conn_tx_ready(int sock, void *eloop_ctx, void *sock_ctx);
 static void dpp_controller_auth_success(struct dpp_connection *conn,
 					int initiator);
@@ -128,10 +144,42 @@ static void dpp_connection_free(struct dpp_connection *conn)
 }
 
 
+static void dpp_controller_conn_removed(struct dpp_controller *ctrl)
+{
+	ctrl->num_conn--;
+	if (!ctrl->accept_paused || ctrl->num_conn >= ctrl->max_conn)
+		return;
+
+	if (eloop_register_sock(ctrl->sock, EVENT_TYPE_READ,
+				dpp_controller_tcp_cb, ctrl, NULL) < 0) {
+		wpa_printf(MSG_INFO,
+			   "DPP: Failed to resume accepting Controller connections");
+		return;
+	}
+	ctrl->accept_paused = false;
+	wpa_printf(MSG_DEBUG, "DPP: Resume accepting Controller connections");
+}
+
+
 static void dpp_connection_remove(struct dpp_connection *conn)
 {
+	struct dpp_controller *ctrl = conn->ctrl;
+
 	dl_list_del(&conn->list);
 	dpp_connection_free(conn);
+	if (ctrl)
+		dpp_controller_conn_removed(ctrl);
+}
+
+
+static void dpp_controller_conf_done(struct dpp_connection *conn, bool ok)
+{
+	if (!conn->ctrl)
+		return;
+	if (ok)
+		conn->ctrl->conf_sent++;
+	else
+		conn->ctrl->conf_failed++;
 }
 
 
@@ -250,6 +298,8 @@ static void dpp_controller_gas_done(struct dpp_connection *conn)
 
 	wpa_msg(conn->msg_ctx, MSG_INFO, DPP_EVENT_CONF_SENT "conf_status=%d",
 		auth->conf_resp_status);
+	dpp_controller_conf_done(conn,
+				 auth->conf_resp_status == DPP_STATUS_OK);
 	dpp_connection_remove(conn);
 }
 
@@ -721,6 +771,7 @@ static void dpp_controller_free(struct dpp_controller *ctrl)
 	if (!ctrl)
 		return;
 
+	ctrl->accept_paused = false;
 	dl_list_for_each_safe(conn, tmp, &ctrl->conn, struct dpp_connection,
 			      list)
 		dpp_connection_remove(conn);
@@ -890,6 +941,7 @@ static int dpp_controller_rx_conf_result(struct dpp_connection *conn,
 	}
 
 	status = dpp_conf_result_rx(auth, hdr, buf, len);
+	dpp_controller_conf_done(conn, status == DPP_STATUS_OK);
 	if (status == DPP_STATUS_OK && auth->send_conn_status) {
 		wpa_msg(msg_ctx, MSG_INFO, DPP_EVENT_CONF_SENT
 			"wait_conn_status=1 conf_resp_status=%d",
@@ -1431,7 +1483,26 @@ static int dpp_controller_rx_gas_req(struct dpp_connection *conn, const u8 *msg,
 	if (slen > end - pos)
 		return -1;
 
-	resp = dpp_conf_req_rx(auth, pos, slen);
+	if (conn->ctrl) {
+		struct dpp_controller *ctrl = conn->ctrl;
+		struct os_reltime start, now, diff;
+
+		os_get_reltime(&start);
+		resp = dpp_conf_req_rx(auth, pos, slen);
+		os_get_reltime(&now);
+		os_reltime_sub(&now, &start, &diff);
+		ctrl->conf_req++;
+		ctrl->conf_build_total.sec += diff.sec;
+		ctrl->conf_build_total.usec += diff.usec;
+		if (ctrl->conf_build_total.usec >= 1000000) {
+			ctrl->conf_build_total.sec++;
+			ctrl->conf_build_total.usec -= 1000000;
+		}
+		if (os_reltime_before(&ctrl->conf_build_max, &diff))
+			ctrl->conf_build_max = diff;
+	} else {
+		resp = dpp_conf_req_rx(auth, pos, slen);
+	}
 	if (!resp && auth->waiting_cert) {
 		wpa_printf(MSG_DEBUG, "DPP: Certificate not yet ready");
 		conn->gas_comeback_in_progress = 1;
@@ -1903,6 +1974,18 @@ static void dpp_controller_tcp_cb(int sd, void *eloop_ctx, void *sock_ctx)
 	/* TODO: eloop timeout to expire connections that do not complete in
 	 * reasonable time */
 	dl_list_add(&ctrl->conn, &conn->list);
+	ctrl->num_conn++;
+	ctrl->conn_accepted++;
+
+	if (ctrl->max_conn && ctrl->num_conn >= ctrl->max_conn) {
+		/* Leave further connections in the listen backlog */
+		wpa_printf(MSG_DEBUG,
+			   "DPP: Connection limit (%u) reached - pause accepting new connections",
+			   ctrl->max_conn);
+		eloop_unregister_sock(ctrl->sock, EVENT_TYPE_READ);
+		ctrl->accept_paused = true;
+		ctrl->accept_pauses++;
+	}
 	return;
 
 fail:
@@ -2153,6 +2236,8 @@ int dpp_controller_start(struct dpp_global *dpp,
 	ctrl->cb_ctx = config->cb_ctx;
 	ctrl->process_conf_obj = config->process_conf_obj;
 	ctrl->tcp_msg_sent = config->tcp_msg_sent;
+	ctrl->max_conn = config->max_conn;
+	os_get_reltime(&ctrl->started);
 
 	ctrl->sock = socket(AF_INET, SOCK_STREAM, 0);
 	if (ctrl->sock < 0)
@@ -2238,6 +2323,58 @@ void dpp_controller_stop_for_ctx(struct dpp_global *dpp, void *cb_ctx)
 }
 
 
+/**
+ * dpp_controller_get_stats - Get Controller connection and throughput stats
+ * @dpp: DPP global context
+ * @buf: Buffer for the text output
+ * @buflen: Length of the buffer
+ * Returns: Number of octets written or -1 if no Controller is running
+ */
+int dpp_controller_get_stats(struct dpp_global *dpp, char *buf, size_t buflen)
+{
+	struct dpp_controller *ctrl;
+	struct os_reltime now, uptime;
+	unsigned int uptime_ms, rate, build_us, avg_us;
+	int ret;
+
+	if (!dpp || !dpp->controller)
+		return -1;
+	ctrl = dpp->controller;
+
+	os_get_reltime(&now);
+	os_reltime_sub(&now, &ctrl->started, &uptime);
+	uptime_ms = uptime.sec * 1000 + uptime.usec / 1000;
+	/* Configurations per second with two decimals */
+	rate = uptime_ms ? (u64) ctrl->conf_sent * 100000 / uptime_ms : 0;
+	build_us = ctrl->conf_build_total.sec * 1000000 +
+		ctrl->conf_build_total.usec;
+	avg_us = ctrl->conf_req ? build_us / ctrl->conf_req : 0;
+
+	ret = os_snprintf(buf, buflen,
+			  "conn_accepted=%u\n"
+			  "conn_active=%u\n"
+			  "max_conn=%u\n"
+			  "accept_paused=%d\n"
+			  "accept_pauses=%u\n"
+			  "conf_req=%u\n"
+			  "conf_sent=%u\n"
+			  "conf_failed=%u\n"
+			  "uptime_ms=%u\n"
+			  "conf_per_sec=%u.%02u\n"
+			  "conf_build_avg_us=%u\n"
+			  "conf_build_max_us=%u\n",
+			  ctrl->conn_accepted, ctrl->num_conn, ctrl->max_conn,
+			  ctrl->accept_paused, ctrl->accept_pauses,
+			  ctrl->conf_req, ctrl->conf_sent, ctrl->conf_failed,
+			  uptime_ms, rate / 100, rate % 100, avg_us,
+			  (unsigned int) (ctrl->conf_build_max.sec * 1000000 +
+					  ctrl->conf_build_max.usec));
+	if (os_snprintf_error(buflen, ret))
+		return -1;
+	return ret;
+}
+
+
 static bool dpp_tcp_peer_id_match(struct dpp_authentication *auth,
 				  unsigned int id)
 {
@@ -165,7 +165,7 @@ int dragonfly_is_quadratic_residue_blind(struct crypto_ec *ec,
 	check = const_time_select_int(mask, -1, 1);
 
 	/* Determine the Legendre symbol on the masked value */
-	res = crypto_bignum_legendre(num, prime);
+	res = crypto_ec_legendre(ec, num);
 	if (res == -2) {
 		res = -1;
 		goto fail;
@@ -733,6 +733,139 @@ ParseRes ieee802_11_parse_elems(const u8 *start, size_t len,
 }
 
 
+/**
+ * ieee802_11_index_elems - Index information elements without decoding them
+ * @start: Pointer to the start of IEs
+ * @len: Length of IE buffer in octets
+ * @idx: Element index to fill in
+ * Returns: ParseOK on success or ParseFailed if the element framing is invalid
+ *
+ * This is a lightweight alternative to ieee802_11_parse_elems() for callers
+ * that need only a few elements. The buffer is walked once and the offset of
+ * the first instance of each element ID is recorded. The element contents are
+ * not validated here; ieee802_11_index_get() and related helpers locate the
+ * element on demand and the caller is responsible for checking the length.
+ */
+ParseRes ieee802_11_index_elems(const u8 *start, size_t len,
+				struct ieee802_11_elem_index *idx)
+{
+	const struct element *elem;
+
+	os_memset(idx->present, 0, sizeof(idx->present));
+	idx->start = start;
+	idx->len = 0;
+
+	if (!start)
+		return ParseOK;
+
+	for_each_element(elem, start, len) {
+		u8 id = elem->id;
+
+		if (!(idx->present[id / 32] & BIT(id % 32))) {
+			idx->present[id / 32] |= BIT(id % 32);
+			idx->offset[id] = (const u8 *) elem - start;
+		}
+
+		if (id == WLAN_EID_MIC) {
+			/* after mic everything is encrypted, so stop. */
+			idx->len = elem->data + elem->datalen - start;
+			return ParseOK;
+		}
+	}
+
+	if (!for_each_element_completed(elem, start, len)) {
+		os_memset(idx->present, 0, sizeof(idx->present));
+		return ParseFailed;
+	}
+
+	idx->len = len;
+	return ParseOK;
+}
+
+
+/**
+ * ieee802_11_index_get - Fetch the first element with the given ID
+ * @idx: Element index from ieee802_11_index_elems()
+ * @eid: Element ID (WLAN_EID_*)
+ * @elen: Buffer for returning the length of the element data or %NULL
+ * Returns: Pointer to the element data or %NULL if the element is not present
+ */
+const u8 * ieee802_11_index_get(const struct ieee802_11_elem_index *idx,
+				u8 eid, u8 *elen)
+{
+	const struct element *elem;
+
+	if (!ieee802_11_index_has(idx, eid))
+		return NULL;
+
+	elem = (const struct element *) (idx->start + idx->offset[eid]);
+	if (elen)
+		*elen = elem->datalen;
+	return elem->data;
+}
+
+
+/**
+ * ieee802_11_index_get_ext - Fetch the first element with the given extension
+ * @idx: Element index from ieee802_11_index_elems()
+ * @ext: Element ID Extension (WLAN_EID_EXT_*)
+ * @elen: Buffer for returning the length of the element data (excluding the
+ *	Element ID Extension field) or %NULL
+ * Returns: Pointer to the element data following the Element ID Extension
+ *	field or %NULL if the element is not present
+ */
+const u8 * ieee802_11_index_get_ext(const struct ieee802_11_elem_index *idx,
+				    u8 ext, u8 *elen)
+{
+	const struct element *elem;
+	size_t off;
+
+	if (!ieee802_11_index_has(idx, WLAN_EID_EXTENSION))
+		return NULL;
+
+	off = idx->offset[WLAN_EID_EXTENSION];
+	for_each_element_extid(elem, ext, idx->start + off, idx->len - off) {
+		if (elen)
+			*elen = elem->datalen - 1;
+		return elem->data + 1;
+	}
+
+	return NULL;
+}
+
+
+/**
+ * ieee802_11_index_get_vendor - Fetch the first vendor specific element
+ * @idx: Element index from ieee802_11_index_elems()
+ * @vendor_type: OUI and OUI type of the element
+ * @elen: Buffer for returning the length of the element data or %NULL
+ * Returns: Pointer to the element data (starting with the OUI) or %NULL if the
+ *	element is not present
+ */
+const u8 * ieee802_11_index_get_vendor(const struct ieee802_11_elem_index *idx,
+				       u32 vendor_type, u8 *elen)
+{
+	const struct element *elem;
+	size_t off;
+
+	if (!ieee802_11_index_has(idx, WLAN_EID_VENDOR_SPECIFIC))
+		return NULL;
+
+	off = idx->offset[WLAN_EID_VENDOR_SPECIFIC];
+	for_each_element_id(elem, WLAN_EID_VENDOR_SPECIFIC, idx->start + off,
+			    idx->len - off) {
+		if (elem->datalen >= 4 &&
+		    vendor_type == WPA_GET_BE32(elem->data)) {
+			if (elen)
+				*elen = elem->datalen;
+			return elem->data;
+		}
+	}
+
+	return NULL;
+}
+
+
 /**
  * ieee802_11_elems_clear_ids - Clear the data for the given element IDs
  * @ids: Array of element IDs for which data should be cleared.
@@ -1695,38 +1828,80 @@ int ieee80211_chaninfo_to_channel(unsigned int freq, enum chan_width chanwidth,
 }
 
 
-static const char *const us_op_class_cc[] = {
-	"US", "CA", NULL
-};
-
-static const char *const eu_op_class_cc[] = {
-	"AL", "AM", "AT", "AZ", "BA", "BE", "BG", "BY", "CH", "CY", "CZ", "DE",
-	"DK", "EE", "EL", "ES", "FI", "FR", "GE", "HR", "HU", "IE", "IS", "IT",
-	"LI", "LT", "LU", "LV", "MD", "ME", "MK", "MT", "NL", "NO", "PL", "PT",
-	"RO", "RS", "RU", "SE", "SI", "SK", "TR", "UA", "UK", NULL
+enum op_class_region {
+	OP_CLASS_REGION_GLOBAL,
+	OP_CLASS_REGION_US,
+	OP_CLASS_REGION_EU,
+	OP_CLASS_REGION_JP,
+	OP_CLASS_REGION_CN,
 };
 
-static const char *const jp_op_class_cc[] = {
-	"JP", NULL
+#define OP_CLASS_CC(a, b) [(a) - 'A'][(b) - 'A']
+
+/* Countries with their own operating class tables; indexed by the two letters
+ * of the country code so that no list needs to be searched per channel */
+static const u8 op_class_region_cc[26][26] = {
+	OP_CLASS_CC('U', 'S') = OP_CLASS_REGION_US,
+	OP_CLASS_CC('C', 'A') = OP_CLASS_REGION_US,
+	OP_CLASS_CC('A', 'L') = OP_CLASS_REGION_EU,
+	OP_CLASS_CC('A', 'M') = OP_CLASS_REGION_EU,
+	OP_CLASS_CC('A', 'T') = OP_CLASS_REGION_EU,
+	OP_CLASS_CC('A', 'Z') = OP_CLASS_REGION_EU,
+	OP_CLASS_CC('B', 'A') = OP_CLASS_REGION_EU,
+	OP_CLASS_CC('B', 'E') = OP_CLASS_REGION_EU,
+	OP_CLASS_CC('B', 'G') = OP_CLASS_REGION_EU,
+	OP_CLASS_CC('B', 'Y') = OP_CLASS_REGION_EU,
+	OP_CLASS_CC('C', 'H') = OP_CLASS_REGION_EU,
+	OP_CLASS_CC('C', 'Y') = OP_CLASS_REGION_EU,
+	OP_CLASS_CC('C', 'Z') = OP_CLASS_REGION_EU,
+	OP_CLASS_CC('D', 'E') = OP_CLASS_REGION_EU,
+	OP_CLASS_CC('D', 'K') = OP_CLASS_REGION_EU,
+	OP_CLASS_CC('E', 'E') = OP_CLASS_REGION_EU,
+	OP_CLASS_CC('E', 'L') = OP_CLASS_REGION_EU,
+	OP_CLASS_CC('E', 'S') = OP_CLASS_REGION_EU,
+	OP_CLASS_CC('F', 'I') = OP_CLASS_REGION_EU,
+	OP_CLASS_CC('F', 'R') = OP_CLASS_REGION_EU,
+	OP_CLASS_CC('G', 'E') = OP_CLASS_REGION_EU,
+	OP_CLASS_CC('H', 'R') = OP_CLASS_REGION_EU,
+	OP_CLASS_CC('H', 'U') = OP_CLASS_REGION_EU,
+	OP_CLASS_CC('I', 'E') = OP_CLASS_REGION_EU,
+	OP_CLASS_CC('I', 'S') = OP_CLASS_REGION_EU,
+	OP_CLASS_CC('I', 'T') = OP_CLASS_REGION_EU,
+	OP_CLASS_CC('L', 'I') = OP_CLASS_REGION_EU,
+	OP_CLASS_CC('L', 'T') = OP_CLASS_REGION_EU,
+	OP_CLASS_CC('L', 'U') = OP_CLASS_REGION_EU,
+	OP_CLASS_CC('L', 'V') = OP_CLASS_REGION_EU,
+	OP_CLASS_CC('M', 'D') = OP_CLASS_REGION_EU,
+	OP_CLASS_CC('M', 'E') = OP_CLASS_REGION_EU,
+	OP_CLASS_CC('M', 'K') = OP_CLASS_REGION_EU,
+	OP_CLASS_CC('M', 'T') = OP_CLASS_REGION_EU,
+	OP_CLASS_CC('N', 'L') = OP_CLASS_REGION_EU,
+	OP_CLASS_CC('N', 'O') = OP_CLASS_REGION_EU,
+	OP_CLASS_CC('P', 'L') = OP_CLASS_REGION_EU,
+	OP_CLASS_CC('P', 'T') = OP_CLASS_REGION_EU,
+	OP_CLASS_CC('R', 'O') = OP_CLASS_REGION_EU,
+	OP_CLASS_CC('R', 'S') = OP_CLASS_REGION_EU,
+	OP_CLASS_CC('R', 'U') = OP_CLASS_REGION_EU,
+	OP_CLASS_CC('S', 'E') = OP_CLASS_REGION_EU,
+	OP_CLASS_CC('S', 'I') = OP_CLASS_REGION_EU,
+	OP_CLASS_CC('S', 'K') = OP_CLASS_REGION_EU,
+	OP_CLASS_CC('T', 'R') = OP_CLASS_REGION_EU,
+	OP_CLASS_CC('U', 'A') = OP_CLASS_REGION_EU,
+	OP_CLASS_CC('U', 'K') = OP_CLASS_REGION_EU,
+	OP_CLASS_CC('J', 'P') = OP_CLASS_REGION_JP,
+	OP_CLASS_CC('C', 'N') = OP_CLASS_REGION_CN,
 };
 
-static const char *const cn_op_class_cc[] = {
-	"CN", NULL
-};
+#undef OP_CLASS_CC
 
 
-static int country_match(const char *const cc[], const char *const country)
+static enum op_class_region country_op_class_region(const char *country)
 {
-	int i;
-
-	if (country == NULL)
-		return 0;
-	for (i = 0; cc[i]; i++) {
-		if (cc[i][0] == country[0] && cc[i][1] == country[1])
-			return 1;
-	}
+	if (!country || country[0] < 'A' || country[0] > 'Z' ||
+	    country[1] < 'A' || country[1] > 'Z')
+		return OP_CLASS_REGION_GLOBAL;
 
-	return 0;
+	return op_class_region_cc[country[0] - 'A'][country[1] - 'A'];
 }
 
 
@@ -2021,29 +2196,25 @@ int ieee80211_chan_to_freq(const char *country, u8 op_class, u8 chan)
 {
 	int freq;
 
-	if (country_match(us_op_class_cc, country)) {
+	switch (country_op_class_region(country)) {
+	case OP_CLASS_REGION_US:
 		freq = ieee80211_chan_to_freq_us(op_class, chan);
-		if (freq > 0)
-			return freq;
-	}
-
-	if (country_match(eu_op_class_cc, country)) {
+		break;
+	case OP_CLASS_REGION_EU:
 		freq = ieee80211_chan_to_freq_eu(op_class, chan);
-		if (freq > 0)
-			return freq;
-	}
-
-	if (country_match(jp_op_class_cc, country)) {
+		break;
+	case OP_CLASS_REGION_JP:
 		freq = ieee80211_chan_to_freq_jp(op_class, chan);
-		if (freq > 0)
-			return freq;
-	}
-
-	if (country_match(cn_op_class_cc, country)) {
+		break;
+	case OP_CLASS_REGION_CN:
 		freq = ieee80211_chan_to_freq_cn(op_class, chan);
-		if (freq > 0)
-			return freq;
+		break;
+	default:
+		freq = -1;
+		break;
 	}
+	if (freq > 0)
+		return freq;
 
 	return ieee80211_chan_to_freq_global(op_class, chan);
 }
@@ -2848,19 +3019,24 @@ u8 country_to_global_op_class(const char *country, u8 op_class)
 	size_t size;
 	u8 g_op_class;
 
-	if (country_match(us_op_class_cc, country)) {
+	switch (country_op_class_region(country)) {
+	case OP_CLASS_REGION_US:
 		country_array = us_op_class;
 		size = ARRAY_SIZE(us_op_class);
-	} else if (country_match(eu_op_class_cc, country)) {
+		break;
+	case OP_CLASS_REGION_EU:
 		country_array = eu_op_class;
 		size = ARRAY_SIZE(eu_op_class);
-	} else if (country_match(jp_op_class_cc, country)) {
+		break;
+	case OP_CLASS_REGION_JP:
 		country_array = jp_op_class;
 		size = ARRAY_SIZE(jp_op_class);
-	} else if (country_match(cn_op_class_cc, country)) {
+		break;
+	case OP_CLASS_REGION_CN:
 		country_array = cn_op_class;
 		size = ARRAY_SIZE(cn_op_class);
-	} else {
+		break;
+	default:
 		/*
 		 * Countries that do not match any of the above countries use
 		 * global operating classes
@@ -2881,19 +3057,26 @@ u8 country_to_global_op_class(const char *country, u8 op_class)
 
 const struct oper_class_map * get_oper_class(const char *country, u8 op_class)
 {
+	/* Position + 1 of each operating class in global_op_class[] */
+	static u8 pos[256];
+	static bool pos_set = false;
 	const struct oper_class_map *op;
 
+	if (!pos_set) {
+		for (op = &global_op_class[0]; op->op_class; op++) {
+			if (!pos[op->op_class])
+				pos[op->op_class] = op - global_op_class + 1;
+		}
+		pos_set = true;
+	}
+
 	if (country)
 		op_class = country_to_global_op_class(country, op_class);
 
-	op = &global_op_class[0];
-	while (op->op_class && op->op_class != op_class)
-		op++;
-
-	if (!op->op_class)
+	if (!pos[op_class])
 		return NULL;
 
-	return op;
+	return &global_op_class[pos[op_class] - 1];
 }
 
 
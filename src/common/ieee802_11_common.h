@@ -206,6 +206,30 @@ typedef enum { ParseOK = 0, ParseUnknown = 1, ParseFailed = -1 } ParseRes;
 ParseRes ieee802_11_parse_elems(const u8 *start, size_t len,
 				struct ieee802_11_elems *elems,
 				int show_errors);
+
+/* Element offsets recorded by ieee802_11_index_elems() */
+struct ieee802_11_elem_index {
+	const u8 *start;
+	size_t len;
+	u32 present[256 / 32]; /* bitmap of element IDs */
+	u32 offset[256]; /* offset of the first element; valid if present */
+};
+
+ParseRes ieee802_11_index_elems(const u8 *start, size_t len,
+				struct ieee802_11_elem_index *idx);
+const u8 * ieee802_11_index_get(const struct ieee802_11_elem_index *idx,
+				u8 eid, u8 *elen);
+const u8 * ieee802_11_index_get_ext(const struct ieee802_11_elem_index *idx,
+				    u8 ext, u8 *elen);
+const u8 * ieee802_11_index_get_vendor(const struct ieee802_11_elem_index *idx,
+				       u32 vendor_type, u8 *elen);
+
+static inline bool
+ieee802_11_index_has(const struct ieee802_11_elem_index *idx, u8 eid)
+{
+	return !!(idx->present[eid / 32] & BIT(eid % 32));
+}
+
 void ieee802_11_elems_clear_ids(struct ieee802_11_elems *elems,
 				const u8 *ids, size_t num);
 void ieee802_11_elems_clear_ext_ids(struct ieee802_11_elems *elems,
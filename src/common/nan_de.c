@@ -62,8 +62,26 @@ struct nan_de_service {
 	struct os_reltime next_publish_chan;
 	unsigned int next_publish_duration;
 	bool is_p2p;
+
+	/* Next service with the same hash of the Service ID */
+	struct nan_de_service *hnext;
+
+	/* Statistics */
+	unsigned int rx_sdf;
+	unsigned int tx_sdf;
+	unsigned int tx_merged; /* SDFs shared with other services */
+	u64 tx_bytes;
+	u64 airtime_usec;
+	unsigned int matches;
+	struct os_reltime first_match;
 };
 
+#define NAN_DE_HASH_SIZE 32
+#define NAN_DE_HASH(id) ((id)[0] & (NAN_DE_HASH_SIZE - 1))
+
+/* Maximum length of the Action frame body of a merged SDF */
+#define NAN_DE_MAX_SDF_LEN 1400
+
 struct nan_de {
 	u8 nmi[ETH_ALEN];
 	bool offload;
@@ -71,6 +89,7 @@ struct nan_de {
 	struct nan_callbacks cb;
 
 	struct nan_de_service *service[NAN_DE_MAX_SERVICE];
+	struct nan_de_service *srv_hash[NAN_DE_HASH_SIZE];
 	unsigned int num_service;
 
 	int next_handle;
@@ -79,6 +98,17 @@ struct nan_de {
 	unsigned int listen_freq;
 	unsigned int tx_wait_status_freq;
 	unsigned int tx_wait_end_freq;
+
+	/* SDF transmissions are merged into a single frame per destination
+	 * while processing a received SDF */
+	bool batch_tx;
+	struct wpabuf *batch;
+	unsigned int batch_freq;
+	unsigned int batch_wait_time;
+	u8 batch_dst[ETH_ALEN];
+	u8 batch_a3[ETH_ALEN];
+	int batch_srv[NAN_DE_MAX_SERVICE];
+	unsigned int batch_num_srv;
 };
 
 
@@ -137,6 +167,9 @@ static void nan_de_service_deinit(struct nan_de *de, struct nan_de_service *srv,
 
 static void nan_de_clear_pending(struct nan_de *de)
 {
+	wpabuf_free(de->batch);
+	de->batch = NULL;
+	de->batch_num_srv = 0;
 	de->listen_freq = 0;
 	de->tx_wait_status_freq = 0;
 	de->tx_wait_end_freq = 0;
@@ -155,6 +188,7 @@ void nan_de_flush(struct nan_de *de)
 				      NAN_DE_REASON_USER_REQUEST);
 		de->service[i] = NULL;
 	}
+	os_memset(de->srv_hash, 0, sizeof(de->srv_hash));
 
 	de->num_service = 0;
 	nan_de_clear_pending(de);
@@ -218,20 +252,50 @@ static int nan_de_tx(struct nan_de *de, unsigned int freq,
 }
 
 
-static void nan_de_tx_sdf(struct nan_de *de, struct nan_de_service *srv,
-			  unsigned int wait_time,
-			  enum nan_service_control_type type,
-			  const u8 *dst, const u8 *a3, u8 req_instance_id,
-			  const struct wpabuf *ssi)
+/* Airtime of an SDF with the specified Action frame body length at 6 Mbps */
+static unsigned int nan_de_sdf_airtime(size_t len)
 {
-	struct wpabuf *buf;
-	size_t len = 0, sda_len, sdea_len;
-	u8 ctrl = type;
-	u16 sdea_ctrl = 0;
+	size_t bits;
+
+	/* SERVICE, MAC header, frame body, FCS, and tail bits */
+	bits = 16 + 8 * (IEEE80211_HDRLEN + len + 4) + 6;
+	/* Preamble and SIGNAL field followed by 4 us symbols of 24 bits */
+	return 20 + 4 * ((bits + 23) / 24);
+}
+
+
+static void nan_de_tx_srv(struct nan_de *de, unsigned int freq,
+			  unsigned int wait_time, const u8 *dst, const u8 *a3,
+			  const struct wpabuf *buf, const int *ids,
+			  unsigned int num_ids)
+{
+	struct nan_de_service *srv;
+	unsigned int i, airtime;
+
+	if (nan_de_tx(de, freq, wait_time, dst, de->nmi, a3, buf) < 0)
+		return;
+
+	airtime = nan_de_sdf_airtime(wpabuf_len(buf));
+	for (i = 0; i < num_ids; i++) {
+		srv = de->service[ids[i] - 1];
+		if (!srv)
+			continue;
+		srv->tx_sdf++;
+		if (num_ids > 1)
+			srv->tx_merged++;
+		srv->tx_bytes += wpabuf_len(buf) / num_ids;
+		srv->airtime_usec += airtime / num_ids;
+	}
+}
+
+
+static size_t nan_de_sdf_attrs_len(struct nan_de_service *srv,
+				   const struct wpabuf *ssi)
+{
+	size_t len = 0, sdea_len;
 
 	/* Service Descriptor attribute */
-	sda_len = NAN_SERVICE_ID_LEN + 1 + 1 + 1;
-	len += NAN_ATTR_HDR_LEN + sda_len;
+	len += NAN_ATTR_HDR_LEN + NAN_SERVICE_ID_LEN + 1 + 1 + 1;
 
 	/* Service Descriptor Extension attribute */
 	sdea_len = 1 + 2;
@@ -243,13 +307,22 @@ static void nan_de_tx_sdf(struct nan_de *de, struct nan_de_service *srv,
 	if (srv->elems)
 		len += NAN_ATTR_HDR_LEN + 1 + wpabuf_len(srv->elems);
 
-	buf = nan_de_alloc_sdf(len);
-	if (!buf)
-		return;
+	return len;
+}
+
+
+static void nan_de_put_sdf_attrs(struct wpabuf *buf,
+				 struct nan_de_service *srv,
+				 enum nan_service_control_type type,
+				 u8 req_instance_id, const struct wpabuf *ssi)
+{
+	size_t sdea_len;
+	u8 ctrl = type;
+	u16 sdea_ctrl = 0;
 
 	/* Service Descriptor attribute */
 	wpabuf_put_u8(buf, NAN_ATTR_SDA);
-	wpabuf_put_le16(buf, sda_len);
+	wpabuf_put_le16(buf, NAN_SERVICE_ID_LEN + 1 + 1 + 1);
 	wpabuf_put_data(buf, srv->service_id, NAN_SERVICE_ID_LEN);
 	wpabuf_put_u8(buf, srv->id); /* Instance ID */
 	wpabuf_put_u8(buf, req_instance_id); /* Requestor Instance ID */
@@ -257,6 +330,9 @@ static void nan_de_tx_sdf(struct nan_de *de, struct nan_de_service *srv,
 
 	/* Service Descriptor Extension attribute */
 	if (srv->type == NAN_DE_PUBLISH || ssi) {
+		sdea_len = 1 + 2;
+		if (ssi)
+			sdea_len += 2 + 4 + wpabuf_len(ssi);
 		wpabuf_put_u8(buf, NAN_ATTR_SDEA);
 		wpabuf_put_le16(buf, sdea_len);
 		wpabuf_put_u8(buf, srv->id); /* Instance ID */
@@ -282,8 +358,87 @@ static void nan_de_tx_sdf(struct nan_de *de, struct nan_de_service *srv,
 		wpabuf_put_u8(buf, 0); /* Map ID */
 		wpabuf_put_buf(buf, srv->elems);
 	}
+}
+
+
+static void nan_de_batch_flush(struct nan_de *de)
+{
+	if (!de->batch)
+		return;
+
+	nan_de_tx_srv(de, de->batch_freq, de->batch_wait_time, de->batch_dst,
+		      de->batch_a3, de->batch, de->batch_srv,
+		      de->batch_num_srv);
+	wpabuf_free(de->batch);
+	de->batch = NULL;
+	de->batch_num_srv = 0;
+}
+
+
+static bool nan_de_batch_match(struct nan_de *de, struct nan_de_service *srv,
+			       const u8 *dst, const u8 *a3, size_t len)
+{
+	unsigned int i;
+
+	if (de->batch_freq != srv->freq ||
+	    !ether_addr_equal(de->batch_dst, dst) ||
+	    !ether_addr_equal(de->batch_a3, a3) ||
+	    wpabuf_len(de->batch) + len > NAN_DE_MAX_SDF_LEN)
+		return false;
+
+	/* The SDEA of each service is matched by its Instance ID, so a
+	 * service can be included only once in an SDF. */
+	for (i = 0; i < de->batch_num_srv; i++) {
+		if (de->batch_srv[i] == srv->id)
+			return false;
+	}
+
+	return true;
+}
+
+
+static void nan_de_tx_sdf(struct nan_de *de, struct nan_de_service *srv,
+			  unsigned int wait_time,
+			  enum nan_service_control_type type,
+			  const u8 *dst, const u8 *a3, u8 req_instance_id,
+			  const struct wpabuf *ssi)
+{
+	struct wpabuf *buf;
+	size_t len;
+
+	len = nan_de_sdf_attrs_len(srv, ssi);
+
+	/* Merge SDFs to the same destination on the same channel into a
+	 * single frame. The Element Container attribute is not merged since
+	 * only one such attribute is processed by the receiver. */
+	if (de->batch_tx && !srv->elems &&
+	    de->batch_num_srv < NAN_DE_MAX_SERVICE) {
+		if (de->batch && !nan_de_batch_match(de, srv, dst, a3, len))
+			nan_de_batch_flush(de);
+		if (!de->batch) {
+			de->batch = nan_de_alloc_sdf(len);
+			if (!de->batch)
+				return;
+			de->batch_freq = srv->freq;
+			de->batch_wait_time = wait_time;
+			os_memcpy(de->batch_dst, dst, ETH_ALEN);
+			os_memcpy(de->batch_a3, a3, ETH_ALEN);
+		} else if (wpabuf_resize(&de->batch, len) < 0) {
+			return;
+		}
+		nan_de_put_sdf_attrs(de->batch, srv, type, req_instance_id,
+				     ssi);
+		if (wait_time > de->batch_wait_time)
+			de->batch_wait_time = wait_time;
+		de->batch_srv[de->batch_num_srv++] = srv->id;
+		return;
+	}
 
-	nan_de_tx(de, srv->freq, wait_time, dst, de->nmi, a3, buf);
+	buf = nan_de_alloc_sdf(len);
+	if (!buf)
+		return;
+	nan_de_put_sdf_attrs(buf, srv, type, req_instance_id, ssi);
+	nan_de_tx_srv(de, srv->freq, wait_time, dst, a3, buf, &srv->id, 1);
 	wpabuf_free(buf);
 }
 
@@ -378,6 +533,7 @@ static void nan_de_tx_multicast(struct nan_de *de, struct nan_de_service *srv,
 
 static void nan_de_add_srv(struct nan_de *de, struct nan_de_service *srv)
 {
+	struct nan_de_service **pos;
 	int ttl;
 
 	os_get_reltime(&srv->time_started);
@@ -390,12 +546,27 @@ static void nan_de_add_srv(struct nan_de *de, struct nan_de_service *srv)
 
 	de->service[srv->id - 1] = srv;
 	de->num_service++;
+
+	/* Keep the hash chain sorted by id to process received SDFs in the
+	 * same order as the services */
+	pos = &de->srv_hash[NAN_DE_HASH(srv->service_id)];
+	while (*pos && (*pos)->id < srv->id)
+		pos = &(*pos)->hnext;
+	srv->hnext = *pos;
+	*pos = srv;
 }
 
 
 static void nan_de_del_srv(struct nan_de *de, struct nan_de_service *srv,
 			   enum nan_de_reason reason)
 {
+	struct nan_de_service **pos;
+
+	pos = &de->srv_hash[NAN_DE_HASH(srv->service_id)];
+	while (*pos && *pos != srv)
+		pos = &(*pos)->hnext;
+	if (*pos)
+		*pos = srv->hnext;
 	de->service[srv->id - 1] = NULL;
 	nan_de_service_deinit(de, srv, reason);
 	de->num_service--;
@@ -823,6 +994,14 @@ static void nan_de_process_elem_container(struct nan_de *de, const u8 *buf,
 }
 
 
+static void nan_de_srv_matched(struct nan_de_service *srv)
+{
+	srv->matches++;
+	if (!os_reltime_initialized(&srv->first_match))
+		os_get_reltime(&srv->first_match);
+}
+
+
 static void nan_de_rx_publish(struct nan_de *de, struct nan_de_service *srv,
 			      const u8 *peer_addr, const u8 *a3, u8 instance_id,
 			      u8 req_instance_id, u16 sdea_control,
@@ -850,6 +1029,7 @@ static void nan_de_rx_publish(struct nan_de *de, struct nan_de_service *srv,
 				instance_id);
 	}
 
+	nan_de_srv_matched(srv);
 	if (de->cb.discovery_result)
 		de->cb.discovery_result(
 			de->cb.ctx, srv->id, srv_proto_type,
@@ -902,10 +1082,6 @@ static void nan_de_rx_subscribe(struct nan_de *de, struct nan_de_service *srv,
 				enum nan_service_protocol_type srv_proto_type,
 				const u8 *ssi, size_t ssi_len)
 {
-	struct wpabuf *buf;
-	size_t len = 0, sda_len, sdea_len;
-	u8 ctrl = 0;
-	u16 sdea_ctrl = 0;
 	const u8 *network_id;
 
 	/* Publish function processing of a receive Subscribe message */
@@ -928,61 +1104,6 @@ static void nan_de_rx_subscribe(struct nan_de *de, struct nan_de_service *srv,
 		goto offload;
 
 	/* Reply with a solicited Publish message */
-	/* Service Descriptor attribute */
-	sda_len = NAN_SERVICE_ID_LEN + 1 + 1 + 1;
-	len += NAN_ATTR_HDR_LEN + sda_len;
-
-	/* Service Descriptor Extension attribute */
-	sdea_len = 1 + 2;
-	if (srv->ssi)
-		sdea_len += 2 + 4 + wpabuf_len(srv->ssi);
-	len += NAN_ATTR_HDR_LEN + sdea_len;
-
-	/* Element Container attribute */
-	if (srv->elems)
-		len += NAN_ATTR_HDR_LEN + 1 + wpabuf_len(srv->elems);
-
-	buf = nan_de_alloc_sdf(len);
-	if (!buf)
-		return;
-
-	/* Service Descriptor attribute */
-	wpabuf_put_u8(buf, NAN_ATTR_SDA);
-	wpabuf_put_le16(buf, sda_len);
-	wpabuf_put_data(buf, srv->service_id, NAN_SERVICE_ID_LEN);
-	wpabuf_put_u8(buf, srv->id); /* Instance ID */
-	wpabuf_put_u8(buf, instance_id); /* Requestor Instance ID */
-	ctrl |= NAN_SRV_CTRL_PUBLISH;
-	wpabuf_put_u8(buf, ctrl);
-
-	/* Service Descriptor Extension attribute */
-	if (srv->type == NAN_DE_PUBLISH || srv->ssi) {
-		wpabuf_put_u8(buf, NAN_ATTR_SDEA);
-		wpabuf_put_le16(buf, sdea_len);
-		wpabuf_put_u8(buf, srv->id); /* Instance ID */
-		if (srv->type == NAN_DE_PUBLISH) {
-			if (srv->publish.fsd)
-				sdea_ctrl |= NAN_SDEA_CTRL_FSD_REQ;
-			if (srv->publish.fsd_gas)
-				sdea_ctrl |= NAN_SDEA_CTRL_FSD_GAS;
-		}
-		wpabuf_put_le16(buf, sdea_ctrl);
-		if (srv->ssi) {
-			wpabuf_put_le16(buf, 4 + wpabuf_len(srv->ssi));
-			wpabuf_put_be24(buf, OUI_WFA);
-			wpabuf_put_u8(buf, srv->srv_proto_type);
-			wpabuf_put_buf(buf, srv->ssi);
-		}
-	}
-
-	/* Element Container attribute */
-	if (srv->elems) {
-		wpabuf_put_u8(buf, NAN_ATTR_ELEM_CONTAINER);
-		wpabuf_put_le16(buf, 1 + wpabuf_len(srv->elems));
-		wpabuf_put_u8(buf, 0); /* Map ID */
-		wpabuf_put_buf(buf, srv->elems);
-	}
-
 	if (srv->is_p2p)
 		network_id = p2p_network_id;
 	else
@@ -991,15 +1112,15 @@ static void nan_de_rx_subscribe(struct nan_de *de, struct nan_de_service *srv,
 	if (srv->publish.solicited_multicast || !a3)
 		a3 = network_id;
 
-	nan_de_tx(de, srv->freq, 100,
-		  srv->publish.solicited_multicast ? network_id : peer_addr,
-		  de->nmi, a3, buf);
-	wpabuf_free(buf);
+	nan_de_tx_sdf(de, srv, 100, NAN_SRV_CTRL_PUBLISH,
+		      srv->publish.solicited_multicast ? network_id : peer_addr,
+		      a3, instance_id, srv->ssi);
 
 	if (!srv->is_p2p)
 		nan_de_pause_state(srv, peer_addr, instance_id);
 
 offload:
+	nan_de_srv_matched(srv);
 	if (!srv->publish.disable_events && de->cb.replied)
 		de->cb.replied(de->cb.ctx, srv->id, peer_addr, instance_id,
 			       srv_proto_type, ssi, ssi_len);
@@ -1031,6 +1152,7 @@ static void nan_de_rx_follow_up(struct nan_de *de, struct nan_de_service *srv,
 	os_memcpy(srv->a3, a3, ETH_ALEN);
 	srv->a3_set = true;
 
+	nan_de_srv_matched(srv);
 	if (de->cb.receive)
 		de->cb.receive(de->cb.ctx, srv->id, instance_id, ssi, ssi_len,
 			       peer_addr);
@@ -1044,7 +1166,9 @@ static void nan_de_rx_sda(struct nan_de *de, const u8 *peer_addr, const u8 *a3,
 	const u8 *service_id;
 	u8 instance_id, req_instance_id, ctrl;
 	u16 sdea_control = 0;
-	unsigned int i;
+	struct nan_de_service *srv;
+	int ids[NAN_DE_MAX_SERVICE];
+	unsigned int i, num_ids = 0;
 	enum nan_service_control_type type = 0;
 	enum nan_service_protocol_type srv_proto_type = 0;
 	const u8 *ssi = NULL;
@@ -1126,11 +1250,10 @@ static void nan_de_rx_sda(struct nan_de *de, const u8 *peer_addr, const u8 *a3,
 		sda += flen;
 	}
 
-	for (i = 0; i < NAN_DE_MAX_SERVICE; i++) {
-		struct nan_de_service *srv = de->service[i];
-
-		if (!srv)
-			continue;
+	/* Collect the matching services first since the services may be
+	 * removed from the callbacks */
+	for (srv = de->srv_hash[NAN_DE_HASH(service_id)]; srv;
+	     srv = srv->hnext) {
 		if (os_memcmp(srv->service_id, service_id,
 			      NAN_SERVICE_ID_LEN) != 0)
 			continue;
@@ -1143,8 +1266,17 @@ static void nan_de_rx_sda(struct nan_de *de, const u8 *peer_addr, const u8 *a3,
 		if (type == NAN_SRV_CTRL_SUBSCRIBE &&
 		    srv->type == NAN_DE_SUBSCRIBE)
 			continue;
+		ids[num_ids++] = srv->id;
+	}
+
+	for (i = 0; i < num_ids; i++) {
+		srv = de->service[ids[i] - 1];
+		if (!srv || os_memcmp(srv->service_id, service_id,
+				      NAN_SERVICE_ID_LEN) != 0)
+			continue;
 		wpa_printf(MSG_DEBUG, "NAN: Received SDF matches service ID %u",
-			   i + 1);
+			   srv->id);
+		srv->rx_sdf++;
 
 		if (first) {
 			first = false;
@@ -1200,6 +1332,7 @@ void nan_de_rx_sdf(struct nan_de *de, const u8 *peer_addr, const u8 *a3,
 
 	wpa_hexdump(MSG_MSGDUMP, "NAN: SDF payload", buf, len);
 
+	de->batch_tx = true;
 	for (skip = 0; ; skip++) {
 		sda = nan_de_get_attr(buf, len, NAN_ATTR_SDA, skip);
 		if (!sda)
@@ -1210,6 +1343,8 @@ void nan_de_rx_sdf(struct nan_de *de, const u8 *peer_addr, const u8 *a3,
 		sda += 2;
 		nan_de_rx_sda(de, peer_addr, a3, freq, buf, len, sda, sda_len);
 	}
+	de->batch_tx = false;
+	nan_de_batch_flush(de);
 }
 
 
@@ -1496,3 +1631,42 @@ int nan_de_transmit(struct nan_de *de, int handle,
 	os_get_reltime(&srv->last_followup);
 	return 0;
 }
+
+
+int nan_de_stats(struct nan_de *de, char *buf, size_t buflen)
+{
+	struct nan_de_service *srv;
+	struct os_reltime diff;
+	char *pos = buf, *end = buf + buflen;
+	unsigned int i;
+	int ret, first_match_ms;
+
+	for (i = 0; i < NAN_DE_MAX_SERVICE; i++) {
+		srv = de->service[i];
+		if (!srv)
+			continue;
+
+		first_match_ms = -1;
+		if (os_reltime_initialized(&srv->first_match)) {
+			os_reltime_sub(&srv->first_match, &srv->time_started,
+				       &diff);
+			first_match_ms = os_reltime_in_ms(&diff);
+		}
+
+		ret = os_snprintf(pos, end - pos,
+				  "id=%d type=%s service_name=%s rx_sdf=%u tx_sdf=%u tx_merged=%u tx_bytes=%llu airtime_usec=%llu matches=%u first_match_ms=%d\n",
+				  srv->id,
+				  srv->type == NAN_DE_PUBLISH ?
+				  "publish" : "subscribe",
+				  srv->service_name, srv->rx_sdf, srv->tx_sdf,
+				  srv->tx_merged,
+				  (unsigned long long) srv->tx_bytes,
+				  (unsigned long long) srv->airtime_usec,
+				  srv->matches, first_match_ms);
+		if (os_snprintf_error(end - pos, ret))
+			break;
+		pos += ret;
+	}
+
+	return pos - buf;
+}
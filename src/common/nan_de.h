@@ -75,6 +75,8 @@ void nan_de_tx_wait_ended(struct nan_de *de);
 void nan_de_rx_sdf(struct nan_de *de, const u8 *peer_addr, const u8 *a3,
 		   unsigned int freq, const u8 *buf, size_t len);
 const u8 * nan_de_get_service_id(struct nan_de *de, int id);
+/* Per-service SDF counters, estimated airtime, and discovery latency */
+int nan_de_stats(struct nan_de *de, char *buf, size_t buflen);
 
 struct nan_publish_params {
 	/* configuration_parameters */
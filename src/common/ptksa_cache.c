@@ -14,9 +14,19 @@
 
 #define PTKSA_CACHE_MAX_ENTRIES 16
 
+/* Minimum number of hash buckets and number of entries per bucket at full
+ * cache */
+#define PTKSA_HASH_MIN_SIZE 16
+#define PTKSA_HASH_LOAD 4
+
 struct ptksa_cache {
-	struct dl_list ptksa;
+	struct dl_list ptksa; /* ordered by expiration */
+	struct dl_list lru; /* least recently used entry first */
+	struct ptksa_cache_entry **hash; /* hash table by peer address */
+	unsigned int hash_mask; /* hash table size - 1 */
 	unsigned int n_ptksa;
+	unsigned int max_entries;
+	struct ptksa_cache_stats stats;
 };
 
 #ifdef CONFIG_PTKSA_CACHE
@@ -24,16 +34,56 @@ struct ptksa_cache {
 static void ptksa_cache_set_expiration(struct ptksa_cache *ptksa);
 
 
+static unsigned int ptksa_cache_hash(struct ptksa_cache *ptksa,
+				     const u8 *addr)
+{
+	return (WPA_GET_BE24(&addr[3]) ^ (addr[0] << 4)) & ptksa->hash_mask;
+}
+
+
 static void ptksa_cache_free_entry(struct ptksa_cache *ptksa,
 				   struct ptksa_cache_entry *entry)
 {
+	struct ptksa_cache_entry **pos;
+
 	ptksa->n_ptksa--;
 
+	pos = &ptksa->hash[ptksa_cache_hash(ptksa, entry->addr)];
+	while (*pos && *pos != entry)
+		pos = &(*pos)->hnext;
+	if (*pos)
+		*pos = entry->hnext;
+
 	dl_list_del(&entry->list);
+	dl_list_del(&entry->lru);
 	bin_clear_free(entry, sizeof(*entry));
 }
 
 
+static void ptksa_cache_evict(struct ptksa_cache *ptksa)
+{
+	struct ptksa_cache_entry *e;
+	unsigned int n_ptksa = ptksa->n_ptksa;
+
+	e = dl_list_first(&ptksa->lru, struct ptksa_cache_entry, lru);
+	if (!e)
+		return;
+
+	wpa_printf(MSG_DEBUG,
+		   "Remove least recently used PTKSA cache entry for " MACSTR,
+		   MAC2STR(e->addr));
+	ptksa->stats.evictions++;
+
+	/* The callback is expected to remove the entry */
+	if (e->cb && e->ctx) {
+		e->cb(e);
+		if (ptksa->n_ptksa < n_ptksa)
+			return;
+	}
+	ptksa_cache_free_entry(ptksa, e);
+}
+
+
 static void ptksa_cache_expire(void *eloop_ctx, void *timeout_ctx)
 {
 	struct ptksa_cache *ptksa = eloop_ctx;
@@ -98,13 +148,65 @@ struct ptksa_cache * ptksa_cache_init(void)
 
 	wpa_printf(MSG_DEBUG, "PTKSA: Initializing");
 
-	if (ptksa)
-		dl_list_init(&ptksa->ptksa);
+	if (!ptksa)
+		return NULL;
+
+	dl_list_init(&ptksa->ptksa);
+	dl_list_init(&ptksa->lru);
+	if (ptksa_cache_set_max_entries(ptksa, 0) < 0) {
+		os_free(ptksa);
+		return NULL;
+	}
 
 	return ptksa;
 }
 
 
+/*
+ * ptksa_cache_set_max_entries - Set the maximum number of PTKSA cache entries
+ * @ptksa: Pointer to PTKSA cache data from ptksa_cache_init()
+ * @max_entries: Maximum number of entries or 0 to use the default value
+ * Returns: 0 on success, -1 on failure
+ *
+ * If the cache has more entries than the new maximum, the least recently used
+ * entries are removed.
+ */
+int ptksa_cache_set_max_entries(struct ptksa_cache *ptksa,
+				unsigned int max_entries)
+{
+	struct ptksa_cache_entry **hash, *e;
+	unsigned int size = PTKSA_HASH_MIN_SIZE, i;
+
+	if (!max_entries)
+		max_entries = PTKSA_CACHE_MAX_ENTRIES;
+
+	while (size < max_entries / PTKSA_HASH_LOAD && size < 0x100000)
+		size <<= 1;
+
+	if (!ptksa->hash || size != ptksa->hash_mask + 1) {
+		hash = os_calloc(size, sizeof(*hash));
+		if (!hash)
+			return -1;
+		os_free(ptksa->hash);
+		ptksa->hash = hash;
+		ptksa->hash_mask = size - 1;
+		dl_list_for_each(e, &ptksa->ptksa, struct ptksa_cache_entry,
+				 list) {
+			i = ptksa_cache_hash(ptksa, e->addr);
+			e->hnext = ptksa->hash[i];
+			ptksa->hash[i] = e;
+		}
+	}
+
+	ptksa->max_entries = max_entries;
+	while (ptksa->n_ptksa > max_entries)
+		ptksa_cache_evict(ptksa);
+	ptksa_cache_set_expiration(ptksa);
+
+	return 0;
+}
+
+
 /*
  * ptksa_cache_deinit - Free all entries in PTKSA cache
  * @ptksa: Pointer to PTKSA cache data from ptksa_cache_init()
@@ -123,6 +225,7 @@ void ptksa_cache_deinit(struct ptksa_cache *ptksa)
 		ptksa_cache_free_entry(ptksa, e);
 
 	eloop_cancel_timeout(ptksa_cache_expire, ptksa, NULL);
+	os_free(ptksa->hash);
 	os_free(ptksa);
 }
 
@@ -137,18 +240,40 @@ void ptksa_cache_deinit(struct ptksa_cache *ptksa)
 struct ptksa_cache_entry * ptksa_cache_get(struct ptksa_cache *ptksa,
 					   const u8 *addr, u32 cipher)
 {
-	struct ptksa_cache_entry *e;
+	struct ptksa_cache_entry *e, *found = NULL;
 
 	if (!ptksa)
 		return NULL;
 
-	dl_list_for_each(e, &ptksa->ptksa, struct ptksa_cache_entry, list) {
-		if ((!addr || ether_addr_equal(e->addr, addr)) &&
-		    (cipher == WPA_CIPHER_NONE || cipher == e->cipher))
-			return e;
+	if (!addr) {
+		dl_list_for_each(e, &ptksa->ptksa, struct ptksa_cache_entry,
+				 list) {
+			if (cipher == WPA_CIPHER_NONE || cipher == e->cipher) {
+				found = e;
+				break;
+			}
+		}
+	} else {
+		/* Return the entry that expires first if there are multiple
+		 * matches */
+		for (e = ptksa->hash[ptksa_cache_hash(ptksa, addr)]; e;
+		     e = e->hnext) {
+			if (ether_addr_equal(e->addr, addr) &&
+			    (cipher == WPA_CIPHER_NONE || cipher == e->cipher) &&
+			    (!found || e->expiration < found->expiration))
+				found = e;
+		}
 	}
 
-	return NULL;
+	if (!found) {
+		ptksa->stats.misses++;
+		return NULL;
+	}
+
+	ptksa->stats.hits++;
+	dl_list_del(&found->lru);
+	dl_list_add_tail(&ptksa->lru, &found->lru);
+	return found;
 }
 
 
@@ -238,16 +363,31 @@ void ptksa_cache_flush(struct ptksa_cache *ptksa, const u8 *addr, u32 cipher)
 	if (!ptksa)
 		return;
 
-	dl_list_for_each_safe(e, next, &ptksa->ptksa, struct ptksa_cache_entry,
-			      list) {
-		if ((!addr || ether_addr_equal(e->addr, addr)) &&
-		    (cipher == WPA_CIPHER_NONE || cipher == e->cipher)) {
-			wpa_printf(MSG_DEBUG,
-				   "Flush PTKSA cache entry for " MACSTR,
-				   MAC2STR(e->addr));
-
-			ptksa_cache_free_entry(ptksa, e);
-			removed = true;
+	if (addr) {
+		e = ptksa->hash[ptksa_cache_hash(ptksa, addr)];
+		while (e) {
+			next = e->hnext;
+			if (ether_addr_equal(e->addr, addr) &&
+			    (cipher == WPA_CIPHER_NONE ||
+			     cipher == e->cipher)) {
+				wpa_printf(MSG_DEBUG,
+					   "Flush PTKSA cache entry for "
+					   MACSTR, MAC2STR(e->addr));
+				ptksa_cache_free_entry(ptksa, e);
+				removed = true;
+			}
+			e = next;
+		}
+	} else {
+		dl_list_for_each_safe(e, next, &ptksa->ptksa,
+				      struct ptksa_cache_entry, list) {
+			if (cipher == WPA_CIPHER_NONE || cipher == e->cipher) {
+				wpa_printf(MSG_DEBUG,
+					   "Flush PTKSA cache entry for "
+					   MACSTR, MAC2STR(e->addr));
+				ptksa_cache_free_entry(ptksa, e);
+				removed = true;
+			}
 		}
 	}
 
@@ -271,7 +411,8 @@ void ptksa_cache_flush(struct ptksa_cache *ptksa, const u8 *addr, u32 cipher)
  *
  * This function creates a PTKSA entry and adds it to the PTKSA cache.
  * If an old entry is already in the cache for the same peer and cipher
- * this entry will be replaced with the new entry.
+ * this entry will be replaced with the new entry. If the cache is full, the
+ * least recently used entry is removed.
  */
 struct ptksa_cache_entry * ptksa_cache_add(struct ptksa_cache *ptksa,
 					   const u8 *own_addr,
@@ -285,6 +426,7 @@ struct ptksa_cache_entry * ptksa_cache_add(struct ptksa_cache *ptksa,
 	struct ptksa_cache_entry *entry, *tmp, *tmp2 = NULL;
 	struct os_reltime now;
 	bool set_expiry = false;
+	unsigned int hash;
 
 	if (!ptksa || !ptk || !addr || !life_time || cipher == WPA_CIPHER_NONE)
 		return NULL;
@@ -292,9 +434,8 @@ struct ptksa_cache_entry * ptksa_cache_add(struct ptksa_cache *ptksa,
 	/* remove a previous entry if present */
 	ptksa_cache_flush(ptksa, addr, cipher);
 
-	/* no place to add another entry */
-	if (ptksa->n_ptksa >= PTKSA_CACHE_MAX_ENTRIES)
-		return NULL;
+	while (ptksa->n_ptksa >= ptksa->max_entries && ptksa->n_ptksa)
+		ptksa_cache_evict(ptksa);
 
 	entry = os_zalloc(sizeof(*entry));
 	if (!entry)
@@ -315,24 +456,32 @@ struct ptksa_cache_entry * ptksa_cache_add(struct ptksa_cache *ptksa,
 	os_get_reltime(&now);
 	entry->expiration = now.sec + life_time;
 
-	dl_list_for_each(tmp, &ptksa->ptksa, struct ptksa_cache_entry, list) {
-		if (tmp->expiration > entry->expiration) {
+	/* Entries are usually added with the same lifetime, so search for the
+	 * position from the end of the list */
+	dl_list_for_each_reverse(tmp, &ptksa->ptksa, struct ptksa_cache_entry,
+				 list) {
+		if (tmp->expiration <= entry->expiration) {
 			tmp2 = tmp;
 			break;
 		}
 	}
 
-	if (dl_list_empty(&entry->list))
-		set_expiry = true;
 	/*
-	 * If the expiration is later then all other or the list is empty
-	 * entries, add it to the end of the list;
-	 * otherwise add it before the relevant entry.
+	 * Add the entry after the last entry that does not expire later or to
+	 * the beginning of the list, in which case the expiration timeout
+	 * needs to be updated.
 	 */
-	if (tmp2)
+	if (tmp2) {
 		dl_list_add(&tmp2->list, &entry->list);
-	else
-		dl_list_add_tail(&ptksa->ptksa, &entry->list);
+	} else {
+		dl_list_add(&ptksa->ptksa, &entry->list);
+		set_expiry = true;
+	}
+
+	hash = ptksa_cache_hash(ptksa, entry->addr);
+	entry->hnext = ptksa->hash[hash];
+	ptksa->hash[hash] = entry;
+	dl_list_add_tail(&ptksa->lru, &entry->lru);
 
 	ptksa->n_ptksa++;
 	wpa_printf(MSG_DEBUG,
@@ -345,6 +494,52 @@ struct ptksa_cache_entry * ptksa_cache_add(struct ptksa_cache *ptksa,
 	return entry;
 }
 
+
+/*
+ * ptksa_cache_get_stats - Get PTKSA cache statistics
+ * @ptksa: Pointer to PTKSA cache data from ptksa_cache_init()
+ * @stats: Buffer for the statistics
+ */
+void ptksa_cache_get_stats(struct ptksa_cache *ptksa,
+			   struct ptksa_cache_stats *stats)
+{
+	os_memcpy(stats, &ptksa->stats, sizeof(*stats));
+	stats->entries = ptksa->n_ptksa;
+	stats->max_entries = ptksa->max_entries;
+}
+
+
+/*
+ * ptksa_cache_stats - Dump text statistics of the PTKSA cache
+ * @ptksa: Pointer to PTKSA cache data from ptksa_cache_init()
+ * @buf: Buffer for the statistics
+ * @len: Length of the buffer
+ * Returns: Number of bytes written to buffer
+ *
+ * This function is used for the ctrl_iface PTKSA_CACHE_STATS command.
+ */
+int ptksa_cache_stats(struct ptksa_cache *ptksa, char *buf, size_t len)
+{
+	struct ptksa_cache_stats stats;
+	int ret;
+
+	if (!ptksa)
+		return 0;
+
+	ptksa_cache_get_stats(ptksa, &stats);
+	ret = os_snprintf(buf, len,
+			  "entries=%u\n"
+			  "max_entries=%u\n"
+			  "hits=%u\n"
+			  "misses=%u\n"
+			  "evictions=%u\n",
+			  stats.entries, stats.max_entries, stats.hits,
+			  stats.misses, stats.evictions);
+	if (os_snprintf_error(len, ret))
+		return 0;
+	return ret;
+}
+
 #else /* CONFIG_PTKSA_CACHE */
 
 struct ptksa_cache * ptksa_cache_init(void)
@@ -384,4 +579,24 @@ void ptksa_cache_flush(struct ptksa_cache *ptksa, const u8 *addr, u32 cipher)
 {
 }
 
+
+int ptksa_cache_set_max_entries(struct ptksa_cache *ptksa,
+				unsigned int max_entries)
+{
+	return 0;
+}
+
+
+void ptksa_cache_get_stats(struct ptksa_cache *ptksa,
+			   struct ptksa_cache_stats *stats)
+{
+	os_memset(stats, 0, sizeof(*stats));
+}
+
+
+int ptksa_cache_stats(struct ptksa_cache *ptksa, char *buf, size_t len)
+{
+	return -1;
+}
+
 #endif /* CONFIG_PTKSA_CACHE */
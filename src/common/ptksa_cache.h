@@ -18,7 +18,9 @@
  * struct ptksa_cache_entry - PTKSA cache entry
  */
 struct ptksa_cache_entry {
-	struct dl_list list;
+	struct dl_list list; /* ordered by expiration */
+	struct dl_list lru;
+	struct ptksa_cache_entry *hnext; /* peer address hash */
 	struct wpa_ptk ptk;
 	os_time_t expiration;
 	u32 cipher;
@@ -29,6 +31,16 @@ struct ptksa_cache_entry {
 	u32 akmp;
 };
 
+/**
+ * struct ptksa_cache_stats - PTKSA cache statistics
+ */
+struct ptksa_cache_stats {
+	unsigned int entries;
+	unsigned int max_entries;
+	unsigned int hits; /* ptksa_cache_get() found an entry */
+	unsigned int misses; /* ptksa_cache_get() did not find an entry */
+	unsigned int evictions; /* entries removed to make room */
+};
 
 struct ptksa_cache;
 
@@ -46,5 +58,10 @@ struct ptksa_cache_entry * ptksa_cache_add(struct ptksa_cache *ptksa,
 					   (struct ptksa_cache_entry *e),
 					   void *ctx, u32 akmp);
 void ptksa_cache_flush(struct ptksa_cache *ptksa, const u8 *addr, u32 cipher);
+int ptksa_cache_set_max_entries(struct ptksa_cache *ptksa,
+				unsigned int max_entries);
+void ptksa_cache_get_stats(struct ptksa_cache *ptksa,
+			   struct ptksa_cache_stats *stats);
+int ptksa_cache_stats(struct ptksa_cache *ptksa, char *buf, size_t len);
 
 #endif /* PTKSA_CACHE_H */
@@ -1039,12 +1039,139 @@ fail:
 }
 
 
+/*
+ * Process-wide cache of derived PTs. Deriving PT is expensive and the same
+ * SSID/password/identifier/group combination is commonly used by multiple
+ * BSSs, network blocks, and interfaces, and is derived again whenever the
+ * configuration is reloaded. Entries are shared by all struct sae_pt instances
+ * derived from the same parameters and are cleared and freed as soon as the
+ * last such instance is freed, i.e., no PT for a password that is no longer
+ * configured remains in memory.
+ */
+struct sae_pt_cache_entry {
+	struct sae_pt_cache_entry *next;
+	unsigned int refcount;
+	int group;
+	u8 key[SHA256_MAC_LEN]; /* hash of SSID, password, and identifier */
+	size_t len;
+	/* followed by len octets of PT: x || y for ECC, element for FFC */
+};
+
+static struct sae_pt_cache_entry *sae_pt_cache = NULL;
+
+
+static int sae_pt_cache_key(const u8 *ssid, size_t ssid_len,
+			    const u8 *password, size_t password_len,
+			    const char *identifier, u8 *key)
+{
+	const u8 *addr[5];
+	size_t len[5];
+	u8 ssid_len_buf[1], password_len_buf[4];
+
+	ssid_len_buf[0] = ssid_len;
+	WPA_PUT_BE32(password_len_buf, password_len);
+	addr[0] = ssid_len_buf;
+	len[0] = sizeof(ssid_len_buf);
+	addr[1] = ssid;
+	len[1] = ssid_len;
+	addr[2] = password_len_buf;
+	len[2] = sizeof(password_len_buf);
+	addr[3] = password;
+	len[3] = password_len;
+	addr[4] = (const u8 *) (identifier ? identifier : "");
+	len[4] = identifier ? os_strlen(identifier) : 0;
+
+	return sha256_vector(5, addr, len, key);
+}
+
+
+static void sae_pt_cache_put(struct sae_pt_cache_entry *entry)
+{
+	struct sae_pt_cache_entry **pos;
+
+	if (!entry || --entry->refcount > 0)
+		return;
+
+	for (pos = &sae_pt_cache; *pos; pos = &(*pos)->next) {
+		if (*pos == entry) {
+			*pos = entry->next;
+			break;
+		}
+	}
+	bin_clear_free(entry, sizeof(*entry) + entry->len);
+}
+
+
+static bool sae_pt_from_cache(struct sae_pt *pt, const u8 *key)
+{
+	struct sae_pt_cache_entry *entry;
+	const u8 *val;
+
+	for (entry = sae_pt_cache; entry; entry = entry->next) {
+		if (entry->group == pt->group &&
+		    os_memcmp(entry->key, key, SHA256_MAC_LEN) == 0)
+			break;
+	}
+	if (!entry)
+		return false;
+
+	val = (const u8 *) (entry + 1);
+	if (pt->ec)
+		pt->ecc_pt = crypto_ec_point_from_bin(pt->ec, val);
+	else
+		pt->ffc_pt = crypto_bignum_init_set(val, entry->len);
+	if (!pt->ecc_pt && !pt->ffc_pt)
+		return false;
+
+	wpa_printf(MSG_DEBUG, "SAE: Use cached PT - group %d", pt->group);
+	entry->refcount++;
+	pt->cache = entry;
+	return true;
+}
+
+
+static void sae_pt_to_cache(struct sae_pt *pt, const u8 *key)
+{
+	struct sae_pt_cache_entry *entry;
+	size_t len;
+	u8 *val;
+
+	if (pt->ec)
+		len = 2 * crypto_ec_prime_len(pt->ec);
+	else
+		len = pt->dh->prime_len;
+
+	entry = os_zalloc(sizeof(*entry) + len);
+	if (!entry)
+		return;
+	val = (u8 *) (entry + 1);
+	if ((pt->ec &&
+	     crypto_ec_point_to_bin(pt->ec, pt->ecc_pt, val,
+				    val + len / 2) < 0) ||
+	    (!pt->ec &&
+	     crypto_bignum_to_bin(pt->ffc_pt, val, len, len) < 0)) {
+		bin_clear_free(entry, sizeof(*entry) + len);
+		return;
+	}
+
+	entry->refcount = 1;
+	entry->group = pt->group;
+	os_memcpy(entry->key, key, SHA256_MAC_LEN);
+	entry->len = len;
+	entry->next = sae_pt_cache;
+	sae_pt_cache = entry;
+	pt->cache = entry;
+}
+
+
 static struct sae_pt *
 sae_derive_pt_group(int group, const u8 *ssid, size_t ssid_len,
 		    const u8 *password, size_t password_len,
 		    const char *identifier)
 {
 	struct sae_pt *pt;
+	u8 key[SHA256_MAC_LEN];
+	bool use_cache;
 
 	wpa_printf(MSG_DEBUG, "SAE: Derive PT - group %d", group);
 
@@ -1060,8 +1187,12 @@ sae_derive_pt_group(int group, const u8 *ssid, size_t ssid_len,
 	pt->ssid_len = ssid_len;
 #endif /* CONFIG_SAE_PK */
 	pt->group = group;
+	use_cache = sae_pt_cache_key(ssid, ssid_len, password, password_len,
+				     identifier, key) == 0;
 	pt->ec = crypto_ec_init(group);
 	if (pt->ec) {
+		if (use_cache && sae_pt_from_cache(pt, key))
+			goto out;
 		pt->ecc_pt = sae_derive_pt_ecc(pt->ec, group, ssid, ssid_len,
 					       password, password_len,
 					       identifier);
@@ -1070,7 +1201,7 @@ sae_derive_pt_group(int group, const u8 *ssid, size_t ssid_len,
 			goto fail;
 		}
 
-		return pt;
+		goto add;
 	}
 
 	pt->dh = dh_groups_get(group);
@@ -1079,6 +1210,8 @@ sae_derive_pt_group(int group, const u8 *ssid, size_t ssid_len,
 		goto fail;
 	}
 
+	if (use_cache && sae_pt_from_cache(pt, key))
+		goto out;
 	pt->ffc_pt = sae_derive_pt_ffc(pt->dh, group, ssid, ssid_len,
 				       password, password_len, identifier);
 	if (!pt->ffc_pt) {
@@ -1086,8 +1219,14 @@ sae_derive_pt_group(int group, const u8 *ssid, size_t ssid_len,
 		goto fail;
 	}
 
+add:
+	if (use_cache)
+		sae_pt_to_cache(pt, key);
+out:
+	forced_memzero(key, sizeof(key));
 	return pt;
 fail:
+	forced_memzero(key, sizeof(key));
 	sae_deinit_pt(pt);
 	return NULL;
 }
@@ -1268,6 +1407,7 @@ void sae_deinit_pt(struct sae_pt *pt)
 		crypto_ec_point_deinit(pt->ecc_pt, 1);
 		crypto_bignum_deinit(pt->ffc_pt, 1);
 		crypto_ec_deinit(pt->ec);
+		sae_pt_cache_put(pt->cache);
 		prev = pt;
 		pt = pt->next;
 		os_free(prev);
@@ -94,6 +94,7 @@ struct sae_pt {
 
 	const struct dh_group *dh;
 	struct crypto_bignum *ffc_pt;
+	struct sae_pt_cache_entry *cache;
 #ifdef CONFIG_SAE_PK
 	u8 ssid[32];
 	size_t ssid_len;
@@ -0,0 +1,159 @@
+/*
+ * Shared memory status page
+ *
+ * This software may be distributed under the terms of the BSD license.
+ * See README for more details.
+ */
+
+#include "utils/includes.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+
+#include "utils/common.h"
+#include "status_shm.h"
+
+
+struct status_shm {
+	struct status_shm_hdr *hdr;
+	size_t size;
+	char *path;
+};
+
+
+/**
+ * status_shm_open - Create a status page
+ * @dir: Directory for the file
+ * @name: File name, e.g., the interface name
+ * @type: Type of the status data
+ * @len: Length of the status data
+ * Returns: Pointer to the status page or %NULL on failure
+ */
+struct status_shm * status_shm_open(const char *dir, const char *name,
+				    enum status_shm_type type, size_t len)
+{
+	struct status_shm *shm;
+	size_t path_len;
+	void *addr;
+	int fd, res;
+
+	shm = os_zalloc(sizeof(*shm));
+	if (!shm)
+		return NULL;
+	path_len = os_strlen(dir) + 1 + os_strlen(name) + 1;
+	shm->path = os_malloc(path_len);
+	if (!shm->path)
+		goto fail;
+	res = os_snprintf(shm->path, path_len, "%s/%s", dir, name);
+	if (os_snprintf_error(path_len, res))
+		goto fail;
+
+	shm->size = sizeof(struct status_shm_hdr) + len;
+	fd = open(shm->path, O_RDWR | O_CREAT | O_TRUNC, 0640);
+	if (fd < 0) {
+		wpa_printf(MSG_INFO, "status_shm: open(%s): %s",
+			   shm->path, strerror(errno));
+		goto fail;
+	}
+	if (ftruncate(fd, shm->size) < 0) {
+		wpa_printf(MSG_INFO, "status_shm: ftruncate(%s): %s",
+			   shm->path, strerror(errno));
+		close(fd);
+		goto fail_unlink;
+	}
+	addr = mmap(NULL, shm->size, PROT_READ | PROT_WRITE, MAP_SHARED, fd,
+		    0);
+	close(fd);
+	if (addr == MAP_FAILED) {
+		wpa_printf(MSG_INFO, "status_shm: mmap(%s): %s",
+			   shm->path, strerror(errno));
+		goto fail_unlink;
+	}
+
+	shm->hdr = addr;
+	shm->hdr->version = STATUS_SHM_VERSION;
+	shm->hdr->type = type;
+	shm->hdr->len = len;
+	/* Readers check the magic last */
+	__atomic_store_n(&shm->hdr->magic, STATUS_SHM_MAGIC, __ATOMIC_RELEASE);
+
+	wpa_printf(MSG_DEBUG, "status_shm: Publishing status in %s",
+		   shm->path);
+	return shm;
+
+fail_unlink:
+	unlink(shm->path);
+fail:
+	os_free(shm->path);
+	os_free(shm);
+	return NULL;
+}
+
+
+/**
+ * status_shm_close - Remove a status page
+ * @shm: Status page from status_shm_open() or %NULL
+ */
+void status_shm_close(struct status_shm *shm)
+{
+	if (!shm)
+		return;
+	munmap(shm->hdr, shm->size);
+	unlink(shm->path);
+	os_free(shm->path);
+	os_free(shm);
+}
+
+
+/**
+ * status_shm_write_begin - Start updating the status data
+ * @shm: Status page from status_shm_open()
+ * Returns: Pointer to the status data
+ *
+ * The data pointed to by the return value can be modified until
+ * status_shm_write_end() is called. The previous values are preserved.
+ */
+void * status_shm_write_begin(struct status_shm *shm)
+{
+	__atomic_store_n(&shm->hdr->seq, shm->hdr->seq + 1, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+	return shm->hdr + 1;
+}
+
+
+/**
+ * status_shm_write_end - Complete updating the status data
+ * @shm: Status page from status_shm_open()
+ */
+void status_shm_write_end(struct status_shm *shm)
+{
+	__atomic_store_n(&shm->hdr->seq, shm->hdr->seq + 1, __ATOMIC_RELEASE);
+}
+
+
+/**
+ * status_shm_read - Read a consistent copy of the status data
+ * @hdr: Mapped status page
+ * @data: Buffer for the status data
+ * @len: Length of the buffer
+ * Returns: 0 on success, -1 if the page is not valid or is being updated
+ *
+ * This is used by readers of the status page. A failed read can be retried.
+ */
+int status_shm_read(const struct status_shm_hdr *hdr, void *data, size_t len)
+{
+	u32 seq;
+
+	if (__atomic_load_n(&hdr->magic, __ATOMIC_ACQUIRE) !=
+	    STATUS_SHM_MAGIC ||
+	    hdr->version != STATUS_SHM_VERSION || hdr->len < len)
+		return -1;
+
+	seq = __atomic_load_n(&hdr->seq, __ATOMIC_ACQUIRE);
+	if (seq & 1)
+		return -1;
+	os_memcpy(data, hdr + 1, len);
+	__atomic_thread_fence(__ATOMIC_ACQUIRE);
+	if (__atomic_load_n(&hdr->seq, __ATOMIC_RELAXED) != seq)
+		return -1;
+	return 0;
+}
@@ -0,0 +1,79 @@
+/*
+ * Shared memory status page
+ *
+ * This software may be distributed under the terms of the BSD license.
+ * See README for more details.
+ */
+
+#ifndef STATUS_SHM_H
+#define STATUS_SHM_H
+
+/*
+ * wpa_supplicant and hostapd can publish the status of each interface in a
+ * file that is mapped into memory, so that other processes can poll the
+ * status without a control interface round trip. The file consists of struct
+ * status_shm_hdr followed by struct status_shm_sta (wpa_supplicant) or
+ * struct status_shm_ap (hostapd).
+ *
+ * The data is protected with a sequence counter. The writer makes the counter
+ * odd before changing the data and even again once the data is consistent. A
+ * reader copies the data and uses the copy only if the counter was even and
+ * did not change while copying; status_shm_read() implements this.
+ */
+
+#define STATUS_SHM_MAGIC 0x53535057 /* "WPSS" in little endian */
+#define STATUS_SHM_VERSION 1
+
+enum status_shm_type {
+	STATUS_SHM_TYPE_STA = 1,
+	STATUS_SHM_TYPE_AP = 2,
+};
+
+struct status_shm_hdr {
+	u32 magic;
+	u16 version;
+	u16 type; /* enum status_shm_type */
+	u32 seq;
+	u32 len; /* length of the data following the header */
+};
+
+struct status_shm_sta {
+	u64 updated_ms; /* monotonic time of the last update */
+	u32 state; /* enum wpa_states */
+	s32 freq; /* MHz, 0 if not associated */
+	u8 bssid[6];
+	u8 ssid_len;
+	u8 ssid[32];
+	u8 reserved;
+	/* Latest signal poll or signal change event; 0 if not known */
+	s32 rssi; /* dBm */
+	s32 avg_rssi; /* dBm */
+	s32 noise; /* dBm */
+	u32 link_speed; /* Mbps */
+	/* Latest packet counter poll */
+	u64 tx_packets;
+	u64 tx_retry_failed;
+	u64 rx_packets;
+} STRUCT_PACKED;
+
+struct status_shm_ap {
+	u64 updated_ms; /* monotonic time of the last update */
+	u32 state; /* enum hostapd_iface_state */
+	s32 freq; /* MHz */
+	u8 bssid[6];
+	u8 ssid_len;
+	u8 ssid[32];
+	u8 channel_utilization; /* out of 255 */
+	u32 num_sta;
+} STRUCT_PACKED;
+
+struct status_shm;
+
+struct status_shm * status_shm_open(const char *dir, const char *name,
+				    enum status_shm_type type, size_t len);
+void status_shm_close(struct status_shm *shm);
+void * status_shm_write_begin(struct status_shm *shm);
+void status_shm_write_end(struct status_shm *shm);
+int status_shm_read(const struct status_shm_hdr *hdr, void *data, size_t len);
+
+#endif /* STATUS_SHM_H */
@@ -594,6 +594,63 @@ retry_send:
 #endif /* CTRL_IFACE_SOCKET */
 
 
+#ifdef CONFIG_CTRL_IFACE_UNIX
+
+int wpa_ctrl_request_async(struct wpa_ctrl *ctrl, unsigned int tag,
+			   const char *cmd, size_t cmd_len)
+{
+	char *buf;
+	size_t len;
+	int res;
+
+	len = 20 + cmd_len;
+	buf = os_malloc(len);
+	if (!buf)
+		return -1;
+	res = os_snprintf(buf, len, "TAG=%u ", tag);
+	if (os_snprintf_error(len, res)) {
+		os_free(buf);
+		return -1;
+	}
+	os_memcpy(buf + res, cmd, cmd_len);
+	res = send(ctrl->s, buf, res + cmd_len, 0);
+	/* The command could include password/key material */
+	os_memset(buf, 0, len);
+	os_free(buf);
+	return res < 0 ? -1 : 0;
+}
+
+
+int wpa_ctrl_recv_reply(struct wpa_ctrl *ctrl, unsigned int *tag,
+			char *reply, size_t *reply_len)
+{
+	unsigned int val = 0;
+	char *pos, *end;
+	int res;
+
+	res = recv(ctrl->s, reply, *reply_len, 0);
+	if (res < 0)
+		return -1;
+	*reply_len = res;
+
+	if (res < 6 || os_strncmp(reply, "TAG=", 4) != 0)
+		return 0;
+	end = reply + res;
+	for (pos = reply + 4; pos < end && *pos >= '0' && *pos <= '9'; pos++)
+		val = val * 10 + *pos - '0';
+	if (pos == reply + 4 || pos == end || *pos != ' ')
+		return 0;
+	pos++;
+
+	*tag = val;
+	*reply_len = end - pos;
+	os_memmove(reply, pos, *reply_len);
+	return 1;
+}
+
+#endif /* CONFIG_CTRL_IFACE_UNIX */
+
+
 static int wpa_ctrl_attach_helper(struct wpa_ctrl *ctrl, int attach)
 {
 	char buf[10];
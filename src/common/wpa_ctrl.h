@@ -26,6 +26,8 @@ extern "C" {
 /* Event messages with fixed prefix */
 /** Authentication completed successfully and data connection enabled */
 #define WPA_EVENT_CONNECTED "CTRL-EVENT-CONNECTED "
+/** Phase durations (usec) of a completed connection attempt */
+#define WPA_EVENT_CONNECT_TRACE "CTRL-EVENT-CONNECT-TRACE "
 /** Disconnected, data connection is not available */
 #define WPA_EVENT_DISCONNECTED "CTRL-EVENT-DISCONNECTED "
 /** Association rejected during connection attempt */
@@ -34,6 +36,9 @@ extern "C" {
 #define WPA_EVENT_AUTH_REJECT "CTRL-EVENT-AUTH-REJECT "
 /** wpa_supplicant is exiting */
 #define WPA_EVENT_TERMINATING "CTRL-EVENT-TERMINATING "
+/** Events were dropped for this control interface monitor since it did not
+ * receive them quickly enough (followed by count=<number of events>) */
+#define WPA_EVENT_MONITOR_DROPPED "CTRL-EVENT-MONITOR-DROPPED "
 /** Password change was completed successfully */
 #define WPA_EVENT_PASSWORD_CHANGED "CTRL-EVENT-PASSWORD-CHANGED "
 /** EAP-Request/Notification received */
@@ -384,6 +389,7 @@ extern "C" {
 #define ACS_EVENT_STARTED "ACS-STARTED "
 #define ACS_EVENT_COMPLETED "ACS-COMPLETED "
 #define ACS_EVENT_FAILED "ACS-FAILED "
+#define ACS_EVENT_RESELECTED "ACS-RESELECTED "
 
 #define DFS_EVENT_RADAR_DETECTED "DFS-RADAR-DETECTED "
 #define DFS_EVENT_NEW_CHANNEL "DFS-NEW-CHANNEL "
@@ -586,6 +592,44 @@ int wpa_ctrl_request(struct wpa_ctrl *ctrl, const char *cmd, size_t cmd_len,
 		     void (*msg_cb)(char *msg, size_t len));
 
 
+#ifdef CONFIG_CTRL_IFACE_UNIX
+/**
+ * wpa_ctrl_request_async - Send a tagged command without waiting for reply
+ * @ctrl: Control interface data from wpa_ctrl_open()
+ * @tag: Caller selected identifier that is included in the reply
+ * @cmd: Command; usually, ASCII text, e.g., "PING"
+ * @cmd_len: Length of the cmd in bytes
+ * Returns: 0 on success, -1 on error
+ *
+ * This function can be used to have multiple commands outstanding on the same
+ * control interface connection. The command is sent as "TAG=<tag> <cmd>" and
+ * wpa_supplicant includes the same prefix in the reply, so the replies can be
+ * matched to the commands with wpa_ctrl_recv_reply() regardless of the order
+ * in which they are received. This is supported on the UNIX domain socket
+ * control interface of wpa_supplicant.
+ */
+int wpa_ctrl_request_async(struct wpa_ctrl *ctrl, unsigned int tag,
+			   const char *cmd, size_t cmd_len);
+
+
+/**
+ * wpa_ctrl_recv_reply - Receive a reply to a tagged command or an event
+ * @ctrl: Control interface data from wpa_ctrl_open()
+ * @tag: Set to the tag of the command if a reply is received
+ * @reply: Buffer for the message data
+ * @reply_len: Length of the reply buffer, set to the length of the data
+ * Returns: 1 if a reply to a tagged command was received (the "TAG=<tag> "
+ * prefix is removed), 0 if another message (e.g., an event) was received, or
+ * -1 on failure
+ *
+ * This function will block until a message is received, so it is normally
+ * used after wpa_ctrl_get_fd() has been reported readable.
+ */
+int wpa_ctrl_recv_reply(struct wpa_ctrl *ctrl, unsigned int *tag,
+			char *reply, size_t *reply_len);
+#endif /* CONFIG_CTRL_IFACE_UNIX */
+
+
 /**
  * wpa_ctrl_attach - Register as an event monitor for the control interface
  * @ctrl: Control interface data from wpa_ctrl_open()
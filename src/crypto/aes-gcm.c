@@ -12,6 +12,7 @@
 #include "common.h"
 #include "aes.h"
 #include "aes_wrap.h"
+#include "aes_hw.h"
 
 static void inc32(u8 *block)
 {
@@ -61,12 +62,120 @@ static void shift_right_block(u8 *v)
 }
 
 
+#ifdef AES_HW_X86
+
+/*
+ * Multiplication in GF(2^128) with PCLMULQDQ on byte reflected operands
+ * followed by the reduction modulo x^128 + x^7 + x^2 + x + 1 as described in
+ * the Intel Carry-Less Multiplication Instruction white paper.
+ */
+static void AES_HW_TARGET_CLMUL gf_mult_hw(const u8 *x, const u8 *y, u8 *z)
+{
+	const __m128i bswap = _mm_set_epi8(0, 1, 2, 3, 4, 5, 6, 7,
+					   8, 9, 10, 11, 12, 13, 14, 15);
+	__m128i a, b, lo, mid, hi, t1, t2, t3;
+
+	a = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *) x), bswap);
+	b = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *) y), bswap);
+
+	/* 256-bit carry-less product hi:lo */
+	lo = _mm_clmulepi64_si128(a, b, 0x00);
+	hi = _mm_clmulepi64_si128(a, b, 0x11);
+	mid = _mm_xor_si128(_mm_clmulepi64_si128(a, b, 0x10),
+			    _mm_clmulepi64_si128(a, b, 0x01));
+	lo = _mm_xor_si128(lo, _mm_slli_si128(mid, 8));
+	hi = _mm_xor_si128(hi, _mm_srli_si128(mid, 8));
+
+	/* Shift the product left by one bit due to the reflected operands */
+	t1 = _mm_srli_epi32(lo, 31);
+	t2 = _mm_srli_epi32(hi, 31);
+	lo = _mm_slli_epi32(lo, 1);
+	hi = _mm_slli_epi32(hi, 1);
+	t3 = _mm_srli_si128(t1, 12);
+	t2 = _mm_slli_si128(t2, 4);
+	t1 = _mm_slli_si128(t1, 4);
+	lo = _mm_or_si128(lo, t1);
+	hi = _mm_or_si128(hi, t2);
+	hi = _mm_or_si128(hi, t3);
+
+	/* Reduce */
+	t1 = _mm_xor_si128(_mm_xor_si128(_mm_slli_epi32(lo, 31),
+					 _mm_slli_epi32(lo, 30)),
+			   _mm_slli_epi32(lo, 25));
+	t2 = _mm_srli_si128(t1, 4);
+	t1 = _mm_slli_si128(t1, 12);
+	lo = _mm_xor_si128(lo, t1);
+	t3 = _mm_xor_si128(_mm_xor_si128(_mm_srli_epi32(lo, 1),
+					 _mm_srli_epi32(lo, 2)),
+			   _mm_srli_epi32(lo, 7));
+	t3 = _mm_xor_si128(t3, t2);
+	lo = _mm_xor_si128(lo, t3);
+	hi = _mm_xor_si128(hi, lo);
+
+	_mm_storeu_si128((__m128i *) z, _mm_shuffle_epi8(hi, bswap));
+}
+
+#endif /* AES_HW_X86 */
+
+
+#ifdef AES_HW_ARM
+
+/*
+ * Multiplication in GF(2^128) with PMULL. Reversing the bits of each octet
+ * maps the GCM bit order to polynomials with the coefficient of x^i in bit i
+ * of the little endian 128-bit value. The 256-bit product W3:W2:W1:W0 (64-bit
+ * words) is reduced with x^128 = x^7 + x^2 + x + 1 (0x87).
+ */
+static void gf_mult_hw(const u8 *x, const u8 *y, u8 *z)
+{
+	uint64x2_t a, b, lo, hi, m1, m2, t, u, v;
+	u64 w0, w1, w2, w3;
+
+	a = vreinterpretq_u64_u8(vrbitq_u8(vld1q_u8(x)));
+	b = vreinterpretq_u64_u8(vrbitq_u8(vld1q_u8(y)));
+
+	lo = vreinterpretq_u64_p128(vmull_p64(vgetq_lane_u64(a, 0),
+					      vgetq_lane_u64(b, 0)));
+	hi = vreinterpretq_u64_p128(vmull_p64(vgetq_lane_u64(a, 1),
+					      vgetq_lane_u64(b, 1)));
+	m1 = vreinterpretq_u64_p128(vmull_p64(vgetq_lane_u64(a, 0),
+					      vgetq_lane_u64(b, 1)));
+	m2 = vreinterpretq_u64_p128(vmull_p64(vgetq_lane_u64(a, 1),
+					      vgetq_lane_u64(b, 0)));
+	m1 = veorq_u64(m1, m2);
+
+	w0 = vgetq_lane_u64(lo, 0);
+	w1 = vgetq_lane_u64(lo, 1) ^ vgetq_lane_u64(m1, 0);
+	w2 = vgetq_lane_u64(hi, 0) ^ vgetq_lane_u64(m1, 1);
+	w3 = vgetq_lane_u64(hi, 1);
+
+	t = vreinterpretq_u64_p128(vmull_p64(w3, 0x87));
+	u = vreinterpretq_u64_p128(vmull_p64(w2, 0x87));
+	v = vreinterpretq_u64_p128(vmull_p64(vgetq_lane_u64(t, 1), 0x87));
+	w0 ^= vgetq_lane_u64(u, 0) ^ vgetq_lane_u64(v, 0);
+	w1 ^= vgetq_lane_u64(t, 0) ^ vgetq_lane_u64(u, 1);
+
+	vst1q_u8(z, vrbitq_u8(vreinterpretq_u8_u64(
+				      vcombine_u64(vcreate_u64(w0),
+						   vcreate_u64(w1)))));
+}
+
+#endif /* AES_HW_ARM */
+
+
 /* Multiplication in GF(2^128) */
 static void gf_mult(const u8 *x, const u8 *y, u8 *z)
 {
 	u8 v[16];
 	int i, j;
 
+#if defined(AES_HW_X86) || defined(AES_HW_ARM)
+	if (aes_hw_features() & AES_HW_CLMUL) {
+		gf_mult_hw(x, y, z);
+		return;
+	}
+#endif /* AES_HW_X86 || AES_HW_ARM */
+
 	os_memset(z, 0, 16); /* Z_0 = 0^128 */
 	os_memcpy(v, y, 16); /* V_0 = Y */
 
@@ -19,6 +19,7 @@
 #include "common.h"
 #include "crypto.h"
 #include "aes_i.h"
+#include "aes_hw.h"
 
 static void rijndaelEncrypt(const u32 rk[], int Nr, const u8 pt[16], u8 ct[16])
 {
@@ -95,6 +96,49 @@ d##3 = TE0(s##3) ^ TE1(s##0) ^ TE2(s##1) ^ TE3(s##2) ^ rk[4 * i + 3]
 }
 
 
+#if defined(AES_HW_X86) || defined(AES_HW_ARM)
+
+/*
+ * The round keys for the CPU instructions are stored in byte order after the
+ * ones used by rijndaelEncrypt().
+ */
+#define AES_ENC_PRIV_SIZE (AES_PRIV_SIZE + 16 * 15)
+
+static void AES_HW_TARGET_AES aes_hw_encrypt(const u8 *rk, int Nr,
+					     const u8 pt[16], u8 ct[16])
+{
+#ifdef AES_HW_X86
+	__m128i s;
+	int r;
+
+	s = _mm_xor_si128(_mm_loadu_si128((const __m128i *) pt),
+			  _mm_loadu_si128((const __m128i *) rk));
+	for (r = 1; r < Nr; r++)
+		s = _mm_aesenc_si128(
+			s, _mm_loadu_si128((const __m128i *) (rk + 16 * r)));
+	s = _mm_aesenclast_si128(
+		s, _mm_loadu_si128((const __m128i *) (rk + 16 * Nr)));
+	_mm_storeu_si128((__m128i *) ct, s);
+#else /* AES_HW_X86 */
+	uint8x16_t s;
+	int r;
+
+	s = vld1q_u8(pt);
+	for (r = 0; r < Nr - 1; r++)
+		s = vaesmcq_u8(vaeseq_u8(s, vld1q_u8(rk + 16 * r)));
+	s = vaeseq_u8(s, vld1q_u8(rk + 16 * (Nr - 1)));
+	s = veorq_u8(s, vld1q_u8(rk + 16 * Nr));
+	vst1q_u8(ct, s);
+#endif /* AES_HW_X86 */
+}
+
+#else /* AES_HW_X86 || AES_HW_ARM */
+
+#define AES_ENC_PRIV_SIZE AES_PRIV_SIZE
+
+#endif /* AES_HW_X86 || AES_HW_ARM */
+
+
 void * aes_encrypt_init(const u8 *key, size_t len)
 {
 	u32 *rk;
@@ -103,7 +147,7 @@ void * aes_encrypt_init(const u8 *key, size_t len)
 	if (TEST_FAIL())
 		return NULL;
 
-	rk = os_malloc(AES_PRIV_SIZE);
+	rk = os_malloc(AES_ENC_PRIV_SIZE);
 	if (rk == NULL)
 		return NULL;
 	res = rijndaelKeySetupEnc(rk, key, len * 8);
@@ -112,6 +156,17 @@ void * aes_encrypt_init(const u8 *key, size_t len)
 		return NULL;
 	}
 	rk[AES_PRIV_NR_POS] = res;
+
+#if defined(AES_HW_X86) || defined(AES_HW_ARM)
+	if (aes_hw_features() & AES_HW_AES) {
+		u8 *hw_rk = (u8 *) rk + AES_PRIV_SIZE;
+		int i;
+
+		for (i = 0; i < 4 * (res + 1); i++)
+			PUTU32(hw_rk + 4 * i, rk[i]);
+	}
+#endif /* AES_HW_X86 || AES_HW_ARM */
+
 	return rk;
 }
 
@@ -119,6 +174,15 @@ void * aes_encrypt_init(const u8 *key, size_t len)
 int aes_encrypt(void *ctx, const u8 *plain, u8 *crypt)
 {
 	u32 *rk = ctx;
+
+#if defined(AES_HW_X86) || defined(AES_HW_ARM)
+	if (aes_hw_features() & AES_HW_AES) {
+		aes_hw_encrypt((const u8 *) ctx + AES_PRIV_SIZE,
+			       rk[AES_PRIV_NR_POS], plain, crypt);
+		return 0;
+	}
+#endif /* AES_HW_X86 || AES_HW_ARM */
+
 	rijndaelEncrypt(ctx, rk[AES_PRIV_NR_POS], plain, crypt);
 	return 0;
 }
@@ -126,6 +190,6 @@ int aes_encrypt(void *ctx, const u8 *plain, u8 *crypt)
 
 void aes_encrypt_deinit(void *ctx)
 {
-	os_memset(ctx, 0, AES_PRIV_SIZE);
+	os_memset(ctx, 0, AES_ENC_PRIV_SIZE);
 	os_free(ctx);
 }
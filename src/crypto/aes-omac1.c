@@ -26,24 +26,57 @@ static void gf_mulx(u8 *pad)
 }
 
 
+struct omac1_ctx {
+	void *aes;
+	u8 k1[AES_BLOCK_SIZE];
+	u8 k2[AES_BLOCK_SIZE];
+};
+
+
 /**
- * omac1_aes_vector - One-Key CBC MAC (OMAC1) hash with AES
+ * omac1_aes_init - Initialize OMAC1 (AES-CMAC) context for a key
  * @key: Key for the hash operation
  * @key_len: Key length in octets
+ * Returns: Pointer to context data or %NULL on failure
+ *
+ * The context stores the expanded AES key and the CMAC subkeys so that the
+ * same key can be used for multiple omac1_aes_ctx_vector() calls without
+ * repeating the key setup.
+ */
+struct omac1_ctx * omac1_aes_init(const u8 *key, size_t key_len)
+{
+	struct omac1_ctx *ctx;
+
+	ctx = os_zalloc(sizeof(*ctx));
+	if (!ctx)
+		return NULL;
+
+	ctx->aes = aes_encrypt_init(key, key_len);
+	if (!ctx->aes ||
+	    aes_encrypt(ctx->aes, ctx->k1, ctx->k1)) {
+		omac1_aes_deinit(ctx);
+		return NULL;
+	}
+	gf_mulx(ctx->k1);
+	os_memcpy(ctx->k2, ctx->k1, AES_BLOCK_SIZE);
+	gf_mulx(ctx->k2);
+
+	return ctx;
+}
+
+
+/**
+ * omac1_aes_ctx_vector - OMAC1 hash with AES using a stored key
+ * @ctx: Context data from omac1_aes_init()
  * @num_elem: Number of elements in the data vector
  * @addr: Pointers to the data areas
  * @len: Lengths of the data blocks
  * @mac: Buffer for MAC (128 bits, i.e., 16 bytes)
  * Returns: 0 on success, -1 on failure
- *
- * This is a mode for using block cipher (AES in this case) for authentication.
- * OMAC1 was standardized with the name CMAC by NIST in a Special Publication
- * (SP) 800-38B.
  */
-int omac1_aes_vector(const u8 *key, size_t key_len, size_t num_elem,
-		     const u8 *addr[], const size_t *len, u8 *mac)
+int omac1_aes_ctx_vector(struct omac1_ctx *ctx, size_t num_elem,
+			 const u8 *addr[], const size_t *len, u8 *mac)
 {
-	void *ctx;
 	u8 cbc[AES_BLOCK_SIZE], pad[AES_BLOCK_SIZE];
 	const u8 *pos, *end;
 	size_t i, e, left, total_len;
@@ -51,9 +84,6 @@ int omac1_aes_vector(const u8 *key, size_t key_len, size_t num_elem,
 	if (TEST_FAIL())
 		return -1;
 
-	ctx = aes_encrypt_init(key, key_len);
-	if (ctx == NULL)
-		return -1;
 	os_memset(cbc, 0, AES_BLOCK_SIZE);
 
 	total_len = 0;
@@ -82,14 +112,10 @@ int omac1_aes_vector(const u8 *key, size_t key_len, size_t num_elem,
 			}
 		}
 		if (left > AES_BLOCK_SIZE)
-			aes_encrypt(ctx, cbc, cbc);
+			aes_encrypt(ctx->aes, cbc, cbc);
 		left -= AES_BLOCK_SIZE;
 	}
 
-	os_memset(pad, 0, AES_BLOCK_SIZE);
-	aes_encrypt(ctx, pad, pad);
-	gf_mulx(pad);
-
 	if (left || total_len == 0) {
 		for (i = 0; i < left; i++) {
 			cbc[i] ^= *pos++;
@@ -106,17 +132,61 @@ int omac1_aes_vector(const u8 *key, size_t key_len, size_t num_elem,
 			}
 		}
 		cbc[left] ^= 0x80;
-		gf_mulx(pad);
+		os_memcpy(pad, ctx->k2, AES_BLOCK_SIZE);
+	} else {
+		os_memcpy(pad, ctx->k1, AES_BLOCK_SIZE);
 	}
 
 	for (i = 0; i < AES_BLOCK_SIZE; i++)
 		pad[i] ^= cbc[i];
-	aes_encrypt(ctx, pad, mac);
-	aes_encrypt_deinit(ctx);
+	aes_encrypt(ctx->aes, pad, mac);
 	return 0;
 }
 
 
+/**
+ * omac1_aes_deinit - Free OMAC1 context data
+ * @ctx: Context data from omac1_aes_init() or %NULL
+ */
+void omac1_aes_deinit(struct omac1_ctx *ctx)
+{
+	if (!ctx)
+		return;
+	if (ctx->aes)
+		aes_encrypt_deinit(ctx->aes);
+	bin_clear_free(ctx, sizeof(*ctx));
+}
+
+
+/**
+ * omac1_aes_vector - One-Key CBC MAC (OMAC1) hash with AES
+ * @key: Key for the hash operation
+ * @key_len: Key length in octets
+ * @num_elem: Number of elements in the data vector
+ * @addr: Pointers to the data areas
+ * @len: Lengths of the data blocks
+ * @mac: Buffer for MAC (128 bits, i.e., 16 bytes)
+ * Returns: 0 on success, -1 on failure
+ *
+ * This is a mode for using block cipher (AES in this case) for authentication.
+ * OMAC1 was standardized with the name CMAC by NIST in a Special Publication
+ * (SP) 800-38B.
+ */
+int omac1_aes_vector(const u8 *key, size_t key_len, size_t num_elem,
+		     const u8 *addr[], const size_t *len, u8 *mac)
+{
+	struct omac1_ctx *ctx;
+	int ret;
+
+	ctx = omac1_aes_init(key, key_len);
+	if (!ctx)
+		return -1;
+	ret = omac1_aes_ctx_vector(ctx, num_elem, addr, len, mac);
+	omac1_aes_deinit(ctx);
+	return ret;
+}
+
+
 /**
  * omac1_aes_128_vector - One-Key CBC MAC (OMAC1) hash with AES-128
  * @key: 128-bit key for the hash operation
@@ -0,0 +1,81 @@
+/*
+ * AES and GF(2^128) multiplication with CPU instructions
+ *
+ * This software may be distributed under the terms of the BSD license.
+ * See README for more details.
+ */
+
+#ifndef AES_HW_H
+#define AES_HW_H
+
+/*
+ * The internal AES implementation and GHASH use the AES-NI and PCLMULQDQ
+ * instructions on x86-64 and the ARMv8 Cryptography Extension on AArch64 when
+ * the CPU supports them. On x86-64, the code paths are compiled with function
+ * specific target attributes and selected based on CPUID at runtime. On
+ * AArch64, they are only built when the compiler targets the Cryptography
+ * Extension (e.g., -march=armv8-a+crypto) and selected based on the hwcaps
+ * of the CPU.
+ */
+
+#if defined(__x86_64__) && defined(__GNUC__) && !defined(CONFIG_NO_AES_HW)
+
+#include <cpuid.h>
+#include <wmmintrin.h>
+#include <tmmintrin.h>
+
+#define AES_HW_X86
+#define AES_HW_TARGET_AES __attribute__((target("aes,sse2")))
+#define AES_HW_TARGET_CLMUL __attribute__((target("pclmul,ssse3")))
+
+#elif defined(__aarch64__) && !defined(__AARCH64EB__) && \
+	(defined(__ARM_FEATURE_CRYPTO) || defined(__ARM_FEATURE_AES)) && \
+	defined(__linux__) && !defined(CONFIG_NO_AES_HW)
+
+#include <arm_neon.h>
+#include <sys/auxv.h>
+#include <asm/hwcap.h>
+
+#define AES_HW_ARM
+#define AES_HW_TARGET_AES
+#define AES_HW_TARGET_CLMUL
+
+#endif
+
+#if defined(AES_HW_X86) || defined(AES_HW_ARM)
+
+#define AES_HW_AES BIT(0)
+#define AES_HW_CLMUL BIT(1)
+
+static inline unsigned int aes_hw_features(void)
+{
+	static int features = -1;
+
+	if (features < 0) {
+#ifdef AES_HW_X86
+		unsigned int eax, ebx, ecx, edx;
+
+		features = 0;
+		if (__get_cpuid(1, &eax, &ebx, &ecx, &edx)) {
+			if (ecx & bit_AES)
+				features |= AES_HW_AES;
+			if ((ecx & bit_PCLMUL) && (ecx & bit_SSSE3))
+				features |= AES_HW_CLMUL;
+		}
+#else /* AES_HW_X86 */
+		unsigned long hwcap = getauxval(AT_HWCAP);
+
+		features = 0;
+		if (hwcap & HWCAP_AES)
+			features |= AES_HW_AES;
+		if (hwcap & HWCAP_PMULL)
+			features |= AES_HW_CLMUL;
+#endif /* AES_HW_X86 */
+	}
+
+	return features;
+}
+
+#endif /* AES_HW_X86 || AES_HW_ARM */
+
+#endif /* AES_HW_H */
@@ -32,6 +32,12 @@ int __must_check omac1_aes_128(const u8 *key, const u8 *data, size_t data_len,
 			       u8 *mac);
 int __must_check omac1_aes_256(const u8 *key, const u8 *data, size_t data_len,
 			       u8 *mac);
+struct omac1_ctx;
+struct omac1_ctx * omac1_aes_init(const u8 *key, size_t key_len);
+int __must_check omac1_aes_ctx_vector(struct omac1_ctx *ctx, size_t num_elem,
+				      const u8 *addr[], const size_t *len,
+				      u8 *mac);
+void omac1_aes_deinit(struct omac1_ctx *ctx);
 int __must_check aes_128_encrypt_block(const u8 *key, const u8 *in, u8 *out);
 int __must_check aes_ctr_encrypt(const u8 *key, size_t key_len, const u8 *nonce,
 				 u8 *data, size_t data_len);
@@ -793,6 +793,18 @@ const struct crypto_bignum * crypto_ec_get_a(struct crypto_ec *e);
  */
 const struct crypto_bignum * crypto_ec_get_b(struct crypto_ec *e);
 
+/**
+ * crypto_ec_legendre - Compute the Legendre symbol modulo the curve's prime
+ * @e: EC context from crypto_ec_init()
+ * @a: Bignum (0 <= a < prime)
+ * Returns: Legendre symbol -1,0,1 on success; -2 on calculation failure
+ *
+ * This is equivalent to crypto_bignum_legendre() with the prime of the curve,
+ * but allows the backend to use precomputed per-group state. The computation
+ * is done in constant time.
+ */
+int crypto_ec_legendre(struct crypto_ec *e, const struct crypto_bignum *a);
+
 /**
  * crypto_ec_get_generator - Get generator point of the EC group's curve
  * @e: EC context from crypto_ec_init()
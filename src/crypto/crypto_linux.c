@@ -54,32 +54,19 @@ static int linux_af_alg_socket(const char *type, const char *name)
 }
 
 
-static int linux_af_alg_hash_vector(const char *alg, const u8 *key,
-				    size_t key_len, size_t num_elem,
-				    const u8 *addr[], const size_t *len,
-				    u8 *mac, size_t mac_len)
+/* Calculate a hash using an AF_ALG socket with the algorithm and key set */
+static int linux_af_alg_hash_op(int s, size_t num_elem, const u8 *addr[],
+				const size_t *len, u8 *mac, size_t mac_len)
 {
-	int s, t;
+	int t;
 	size_t i;
 	ssize_t res;
 	int ret = -1;
 
-	s = linux_af_alg_socket("hash", alg);
-	if (s < 0)
-		return -1;
-
-	if (key && setsockopt(s, SOL_ALG, ALG_SET_KEY, key, key_len) < 0) {
-		wpa_printf(MSG_ERROR, "%s: setsockopt(ALG_SET_KEY) failed: %s",
-			   __func__, strerror(errno));
-		close(s);
-		return -1;
-	}
-
 	t = accept(s, NULL, NULL);
 	if (t < 0) {
 		wpa_printf(MSG_ERROR, "%s: accept on AF_ALG socket failed: %s",
 			   __func__, strerror(errno));
-		close(s);
 		return -1;
 	}
 
@@ -116,6 +103,30 @@ static int linux_af_alg_hash_vector(const char *alg, const u8 *key,
 	ret = 0;
 fail:
 	close(t);
+
+	return ret;
+}
+
+
+static int linux_af_alg_hash_vector(const char *alg, const u8 *key,
+				    size_t key_len, size_t num_elem,
+				    const u8 *addr[], const size_t *len,
+				    u8 *mac, size_t mac_len)
+{
+	int s, ret;
+
+	s = linux_af_alg_socket("hash", alg);
+	if (s < 0)
+		return -1;
+
+	if (key && setsockopt(s, SOL_ALG, ALG_SET_KEY, key, key_len) < 0) {
+		wpa_printf(MSG_ERROR, "%s: setsockopt(ALG_SET_KEY) failed: %s",
+			   __func__, strerror(errno));
+		close(s);
+		return -1;
+	}
+
+	ret = linux_af_alg_hash_op(s, num_elem, addr, len, mac, mac_len);
 	close(s);
 
 	return ret;
@@ -762,6 +773,53 @@ int omac1_aes_vector(const u8 *key, size_t key_len, size_t num_elem,
 }
 
 
+struct omac1_ctx {
+	int s; /* AF_ALG socket with the key set */
+};
+
+
+struct omac1_ctx * omac1_aes_init(const u8 *key, size_t key_len)
+{
+	struct omac1_ctx *ctx;
+
+	ctx = os_zalloc(sizeof(*ctx));
+	if (!ctx)
+		return NULL;
+
+	ctx->s = linux_af_alg_socket("hash", "cmac(aes)");
+	if (ctx->s < 0) {
+		os_free(ctx);
+		return NULL;
+	}
+
+	if (setsockopt(ctx->s, SOL_ALG, ALG_SET_KEY, key, key_len) < 0) {
+		wpa_printf(MSG_ERROR, "%s: setsockopt(ALG_SET_KEY) failed: %s",
+			   __func__, strerror(errno));
+		omac1_aes_deinit(ctx);
+		return NULL;
+	}
+
+	return ctx;
+}
+
+
+int omac1_aes_ctx_vector(struct omac1_ctx *ctx, size_t num_elem,
+			 const u8 *addr[], const size_t *len, u8 *mac)
+{
+	return linux_af_alg_hash_op(ctx->s, num_elem, addr, len, mac,
+				    AES_BLOCK_SIZE);
+}
+
+
+void omac1_aes_deinit(struct omac1_ctx *ctx)
+{
+	if (!ctx)
+		return;
+	close(ctx->s);
+	os_free(ctx);
+}
+
+
 int omac1_aes_128_vector(const u8 *key, size_t num_elem,
 			 const u8 *addr[], const size_t *len, u8 *mac)
 {
@@ -14,6 +14,7 @@
 #include "crypto/aes_wrap.h"
 #include "crypto/aes.h"
 #include "crypto/ms_funcs.h"
+#include "crypto/random.h"
 #include "crypto/crypto.h"
 #include "crypto/sha1.h"
 #include "crypto/sha256.h"
@@ -2572,6 +2573,175 @@ static int test_ms_funcs(void)
 }
 
 
+static int random_benchmarks(void)
+{
+	struct module_bench b;
+	u8 nonce[32];
+
+	/* ANonce/SNonce, SAE rand/mask, and GTK sized requests */
+	for (module_bench_start(&b, "random_get_bytes (32 octets)");
+	     module_bench_continue(&b);) {
+		if (random_get_bytes(nonce, sizeof(nonce)) < 0) {
+			wpa_printf(MSG_ERROR, "random_get_bytes failed");
+			return -1;
+		}
+	}
+	module_bench_report(&b);
+
+	return 0;
+}
+
+
+static int crypto_mod_exp_benchmarks(void)
+{
+	/* RSA public key, WPS DH (group 5), and DH group 14 and 15 sizes */
+	static const struct {
+		const char *name;
+		size_t mod_len, exp_len;
+	} tests[] = {
+		{ "modexp 2048-bit, e=65537", 256, 3 },
+		{ "modexp 1536-bit, 1536-bit exponent", 192, 192 },
+		{ "modexp 2048-bit, 256-bit exponent", 256, 32 },
+		{ "modexp 2048-bit, 2048-bit exponent", 256, 256 },
+		{ "modexp 3072-bit, 256-bit exponent", 384, 32 },
+	};
+	struct module_bench b;
+	u8 mod[384], base[384], exp[384], res[384];
+	size_t i, res_len;
+
+	for (i = 0; i < ARRAY_SIZE(tests); i++) {
+		size_t mod_len = tests[i].mod_len, exp_len = tests[i].exp_len;
+
+		if (os_get_random(mod, mod_len) < 0 ||
+		    os_get_random(base, mod_len) < 0 ||
+		    os_get_random(exp, exp_len) < 0)
+			return -1;
+		/* Full length odd modulus and a base below it */
+		mod[0] |= 0x80;
+		mod[mod_len - 1] |= 0x01;
+		base[0] &= 0x7f;
+		if (exp_len == 3) {
+			exp[0] = 0x01;
+			exp[1] = 0x00;
+			exp[2] = 0x01;
+		}
+
+		for (module_bench_start(&b, tests[i].name);
+		     module_bench_continue(&b);) {
+			res_len = mod_len;
+			if (crypto_mod_exp(base, mod_len, exp, exp_len,
+					   mod, mod_len, res, &res_len) < 0) {
+				wpa_printf(MSG_ERROR,
+					   "crypto_mod_exp benchmark failed");
+				return -1;
+			}
+		}
+		module_bench_report(&b);
+	}
+
+	return 0;
+}
+
+
+static int crypto_benchmarks(void)
+{
+#ifdef CONFIG_ECC
+	struct module_bench b;
+	struct crypto_ec *ec;
+	struct crypto_bignum *val;
+	const struct crypto_bignum *prime;
+	struct crypto_ecdh *ecdh = NULL, *peer;
+	struct wpabuf *pub = NULL, *secret;
+	struct crypto_ec_point *point = NULL, *point2 = NULL;
+	int res, ret = -1;
+
+	for (module_bench_start(&b, "EC group 19 init");
+	     module_bench_continue(&b);) {
+		ec = crypto_ec_init(19);
+		if (!ec)
+			return -1;
+		crypto_ec_deinit(ec);
+	}
+	module_bench_report(&b);
+
+	ec = crypto_ec_init(19);
+	val = crypto_bignum_init();
+	if (!ec || !val)
+		goto fail;
+	prime = crypto_ec_get_prime(ec);
+	if (crypto_bignum_rand(val, prime) < 0)
+		goto fail;
+	res = crypto_bignum_legendre(val, prime);
+
+	for (module_bench_start(&b, "bignum Legendre symbol (group 19)");
+	     module_bench_continue(&b);) {
+		if (crypto_bignum_legendre(val, prime) != res)
+			goto fail;
+	}
+	module_bench_report(&b);
+
+	for (module_bench_start(&b, "EC Legendre symbol (group 19)");
+	     module_bench_continue(&b);) {
+		if (crypto_ec_legendre(ec, val) != res)
+			goto fail;
+	}
+	module_bench_report(&b);
+
+	/* OWE and DPP key agreement */
+	ecdh = crypto_ecdh_init(19);
+	pub = ecdh ? crypto_ecdh_get_pubkey(ecdh, 0) : NULL;
+	if (!pub)
+		goto fail;
+	for (module_bench_start(&b, "ECDH group 19");
+	     module_bench_continue(&b);) {
+		peer = crypto_ecdh_init(19);
+		secret = peer ? crypto_ecdh_set_peerkey(peer, 0, wpabuf_head(pub),
+							wpabuf_len(pub)) :
+			NULL;
+		crypto_ecdh_deinit(peer);
+		if (!secret)
+			goto fail;
+		wpabuf_clear_free(secret);
+	}
+	module_bench_report(&b);
+
+	/* DPP and PKEX fixed-base and SAE variable-base multiplication */
+	point = crypto_ec_point_init(ec);
+	point2 = crypto_ec_point_init(ec);
+	if (!point || !point2)
+		goto fail;
+	for (module_bench_start(&b, "EC generator mul (group 19)");
+	     module_bench_continue(&b);) {
+		if (crypto_ec_point_mul(ec, crypto_ec_get_generator(ec), val,
+					point) < 0)
+			goto fail;
+	}
+	module_bench_report(&b);
+
+	for (module_bench_start(&b, "EC point mul (group 19)");
+	     module_bench_continue(&b);) {
+		if (crypto_ec_point_mul(ec, point, val, point2) < 0)
+			goto fail;
+	}
+	module_bench_report(&b);
+
+	ret = 0;
+fail:
+	if (ret)
+		wpa_printf(MSG_ERROR, "crypto benchmarks failed");
+	crypto_ec_point_deinit(point2, 0);
+	crypto_ec_point_deinit(point, 0);
+	wpabuf_free(pub);
+	crypto_ecdh_deinit(ecdh);
+	crypto_bignum_deinit(val, 1);
+	crypto_ec_deinit(ec);
+	return ret;
+#else /* CONFIG_ECC */
+	return 0;
+#endif /* CONFIG_ECC */
+}
+
+
 int crypto_module_tests(void)
 {
 	int ret = 0;
@@ -2591,7 +2761,10 @@ int crypto_module_tests(void)
 	    test_fips186_2_prf() ||
 	    test_extract_expand_hkdf() ||
 	    test_hpke() ||
-	    test_ms_funcs())
+	    test_ms_funcs() ||
+	    random_benchmarks() ||
+	    crypto_mod_exp_benchmarks() ||
+	    crypto_benchmarks())
 		ret = -1;
 
 	return ret;
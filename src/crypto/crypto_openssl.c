@@ -1876,6 +1876,120 @@ fail:
 }
 
 
+struct omac1_ctx {
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+	EVP_MAC *emac;
+	EVP_MAC_CTX *ctx;
+#else /* OpenSSL version >= 3.0 */
+	CMAC_CTX *ctx;
+#endif /* OpenSSL version >= 3.0 */
+};
+
+
+struct omac1_ctx * omac1_aes_init(const u8 *key, size_t key_len)
+{
+	struct omac1_ctx *ctx;
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+	OSSL_PARAM params[2];
+	char *cipher = NULL;
+#else /* OpenSSL version >= 3.0 */
+	const EVP_CIPHER *cipher = NULL;
+#endif /* OpenSSL version >= 3.0 */
+
+	ctx = os_zalloc(sizeof(*ctx));
+	if (!ctx)
+		return NULL;
+
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+	if (key_len == 32)
+		cipher = "aes-256-cbc";
+	else if (key_len == 24)
+		cipher = "aes-192-cbc";
+	else if (key_len == 16)
+		cipher = "aes-128-cbc";
+
+	params[0] = OSSL_PARAM_construct_utf8_string("cipher", cipher, 0);
+	params[1] = OSSL_PARAM_construct_end();
+
+	ctx->emac = EVP_MAC_fetch(NULL, "CMAC", NULL);
+	if (!ctx->emac || !cipher ||
+	    !(ctx->ctx = EVP_MAC_CTX_new(ctx->emac)) ||
+	    EVP_MAC_init(ctx->ctx, key, key_len, params) != 1)
+		goto fail;
+#else /* OpenSSL version >= 3.0 */
+	if (key_len == 32)
+		cipher = EVP_aes_256_cbc();
+	else if (key_len == 24)
+		cipher = EVP_aes_192_cbc();
+	else if (key_len == 16)
+		cipher = EVP_aes_128_cbc();
+
+	ctx->ctx = CMAC_CTX_new();
+	if (!cipher || !ctx->ctx ||
+	    !CMAC_Init(ctx->ctx, key, key_len, cipher, NULL))
+		goto fail;
+#endif /* OpenSSL version >= 3.0 */
+
+	return ctx;
+fail:
+	omac1_aes_deinit(ctx);
+	return NULL;
+}
+
+
+int omac1_aes_ctx_vector(struct omac1_ctx *ctx, size_t num_elem,
+			 const u8 *addr[], const size_t *len, u8 *mac)
+{
+	size_t outlen, i;
+
+	if (TEST_FAIL())
+		return -1;
+
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+	/* Restart with the key from omac1_aes_init() */
+	if (EVP_MAC_init(ctx->ctx, NULL, 0, NULL) != 1)
+		return -1;
+	for (i = 0; i < num_elem; i++) {
+		if (!EVP_MAC_update(ctx->ctx, addr[i], len[i]))
+			return -1;
+	}
+	if (EVP_MAC_final(ctx->ctx, mac, &outlen, 16) != 1 || outlen != 16)
+		return -1;
+#else /* OpenSSL version >= 3.0 */
+#ifdef OPENSSL_IS_BORINGSSL
+	if (!CMAC_Reset(ctx->ctx))
+		return -1;
+#else /* OPENSSL_IS_BORINGSSL */
+	/* Restart with the key from omac1_aes_init() */
+	if (!CMAC_Init(ctx->ctx, NULL, 0, NULL, NULL))
+		return -1;
+#endif /* OPENSSL_IS_BORINGSSL */
+	for (i = 0; i < num_elem; i++) {
+		if (!CMAC_Update(ctx->ctx, addr[i], len[i]))
+			return -1;
+	}
+	if (!CMAC_Final(ctx->ctx, mac, &outlen) || outlen != 16)
+		return -1;
+#endif /* OpenSSL version >= 3.0 */
+
+	return 0;
+}
+
+
+void omac1_aes_deinit(struct omac1_ctx *ctx)
+{
+	if (!ctx)
+		return;
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+	EVP_MAC_CTX_free(ctx->ctx);
+	EVP_MAC_free(ctx->emac);
+#else /* OpenSSL version >= 3.0 */
+	CMAC_CTX_free(ctx->ctx);
+#endif /* OpenSSL version >= 3.0 */
+	os_free(ctx);
+}
+
+
 int omac1_aes_128_vector(const u8 *key, size_t num_elem,
 			 const u8 *addr[], const size_t *len, u8 *mac)
 {
@@ -2240,15 +2354,39 @@ fail:
 
 #ifdef CONFIG_ECC
 
-struct crypto_ec {
-	EC_GROUP *group;
-	int nid;
+/*
+ * The group and its parameters are immutable and shared by all the contexts
+ * for the same group through a process-wide cache, so that SAE, PASN, and DPP
+ * exchanges do not need to set up the group again for each session. The
+ * cache is only used from the main event loop thread.
+ */
+struct crypto_ec_group {
+	struct crypto_ec_group *next;
+	unsigned int refcount;
 	int iana_group;
-	BN_CTX *bnctx;
+	int nid;
+	EC_GROUP *group;
 	BIGNUM *prime;
 	BIGNUM *order;
 	BIGNUM *a;
 	BIGNUM *b;
+	/* Precomputed state for the Legendre symbol modulo the prime */
+	BN_MONT_CTX *mont;
+	BIGNUM *legendre_exp; /* (prime - 1) / 2 */
+};
+
+static struct crypto_ec_group *crypto_ec_groups;
+
+struct crypto_ec {
+	struct crypto_ec_group *shared;
+	const EC_GROUP *group;
+	int nid;
+	int iana_group;
+	BN_CTX *bnctx; /* per context scratch space */
+	const BIGNUM *prime;
+	const BIGNUM *order;
+	const BIGNUM *a;
+	const BIGNUM *b;
 };
 
 
@@ -2326,31 +2464,139 @@ static const char * crypto_ec_group_2_name(int group)
 #endif /* OpenSSL version >= 3.0 */
 
 
-struct crypto_ec * crypto_ec_init(int group)
+static void crypto_ec_group_free(struct crypto_ec_group *g)
 {
-	struct crypto_ec *e;
+	BN_free(g->legendre_exp);
+	BN_MONT_CTX_free(g->mont);
+	BN_clear_free(g->b);
+	BN_clear_free(g->a);
+	BN_clear_free(g->order);
+	BN_clear_free(g->prime);
+	EC_GROUP_free(g->group);
+	os_free(g);
+}
+
+
+static struct crypto_ec_group * crypto_ec_group_get(int group)
+{
+	struct crypto_ec_group *g;
+	BN_CTX *bnctx;
 	int nid;
 
+	for (g = crypto_ec_groups; g; g = g->next) {
+		if (g->iana_group == group) {
+			g->refcount++;
+			return g;
+		}
+	}
+
 	nid = crypto_ec_group_2_nid(group);
 	if (nid < 0)
 		return NULL;
 
+	g = os_zalloc(sizeof(*g));
+	if (!g)
+		return NULL;
+
+	g->iana_group = group;
+	g->nid = nid;
+	bnctx = BN_CTX_new();
+	g->group = EC_GROUP_new_by_curve_name(nid);
+	g->prime = BN_new();
+	g->order = BN_new();
+	g->a = BN_new();
+	g->b = BN_new();
+	g->mont = BN_MONT_CTX_new();
+	g->legendre_exp = BN_new();
+	if (!g->group || !bnctx || !g->prime || !g->order || !g->a || !g->b ||
+	    !g->mont || !g->legendre_exp ||
+	    !EC_GROUP_get_curve(g->group, g->prime, g->a, g->b, bnctx) ||
+	    !EC_GROUP_get_order(g->group, g->order, bnctx) ||
+	    !BN_MONT_CTX_set(g->mont, g->prime, bnctx) ||
+	    !BN_sub(g->legendre_exp, g->prime, BN_value_one()) ||
+	    !BN_rshift1(g->legendre_exp, g->legendre_exp)) {
+		BN_CTX_free(bnctx);
+		crypto_ec_group_free(g);
+		return NULL;
+	}
+#if OPENSSL_VERSION_NUMBER < 0x10101000L && !defined(LIBRESSL_VERSION_NUMBER)
+	/* Multiples of the generator for the wNAF multiplication; newer
+	 * versions use a constant time ladder or built-in tables instead */
+	if (!EC_GROUP_have_precompute_mult(g->group) &&
+	    !EC_GROUP_precompute_mult(g->group, bnctx))
+		wpa_printf(MSG_DEBUG,
+			   "OpenSSL: Could not precompute generator multiples for group %d",
+			   group);
+#endif /* OpenSSL version < 1.1.1 */
+	BN_CTX_free(bnctx);
+
+	/* The cache holds a reference until crypto_unload() */
+	g->refcount = 2;
+	g->next = crypto_ec_groups;
+	crypto_ec_groups = g;
+	return g;
+}
+
+
+static void crypto_ec_group_put(struct crypto_ec_group *g)
+{
+	struct crypto_ec_group **pos;
+
+	if (--g->refcount > 0)
+		return;
+
+	for (pos = &crypto_ec_groups; *pos; pos = &(*pos)->next) {
+		if (*pos == g) {
+			*pos = g->next;
+			break;
+		}
+	}
+	crypto_ec_group_free(g);
+}
+
+
+static void crypto_ec_groups_deinit(void)
+{
+	struct crypto_ec_group *g, *next;
+
+	g = crypto_ec_groups;
+	crypto_ec_groups = NULL;
+	while (g) {
+		next = g->next;
+		/* Groups still in use are freed with their last context */
+		g->next = NULL;
+		if (--g->refcount == 0)
+			crypto_ec_group_free(g);
+		g = next;
+	}
+}
+
+
+struct crypto_ec * crypto_ec_init(int group)
+{
+	struct crypto_ec *e;
+	struct crypto_ec_group *g;
+
+	g = crypto_ec_group_get(group);
+	if (!g)
+		return NULL;
+
 	e = os_zalloc(sizeof(*e));
-	if (e == NULL)
+	if (e == NULL) {
+		crypto_ec_group_put(g);
 		return NULL;
+	}
 
-	e->nid = nid;
-	e->iana_group = group;
+	e->shared = g;
+	e->nid = g->nid;
+	e->iana_group = g->iana_group;
+	e->group = g->group;
+	e->prime = g->prime;
+	e->order = g->order;
+	e->a = g->a;
+	e->b = g->b;
 	e->bnctx = BN_CTX_new();
-	e->group = EC_GROUP_new_by_curve_name(nid);
-	e->prime = BN_new();
-	e->order = BN_new();
-	e->a = BN_new();
-	e->b = BN_new();
-	if (e->group == NULL || e->bnctx == NULL || e->prime == NULL ||
-	    e->order == NULL || e->a == NULL || e->b == NULL ||
-	    !EC_GROUP_get_curve(e->group, e->prime, e->a, e->b, e->bnctx) ||
-	    !EC_GROUP_get_order(e->group, e->order, e->bnctx)) {
+	if (e->bnctx == NULL) {
 		crypto_ec_deinit(e);
 		e = NULL;
 	}
@@ -2363,12 +2609,8 @@ void crypto_ec_deinit(struct crypto_ec *e)
 {
 	if (e == NULL)
 		return;
-	BN_clear_free(e->b);
-	BN_clear_free(e->a);
-	BN_clear_free(e->order);
-	BN_clear_free(e->prime);
-	EC_GROUP_free(e->group);
 	BN_CTX_free(e->bnctx);
+	crypto_ec_group_put(e->shared);
 	os_free(e);
 }
 
@@ -2425,6 +2667,37 @@ const struct crypto_bignum * crypto_ec_get_b(struct crypto_ec *e)
 }
 
 
+int crypto_ec_legendre(struct crypto_ec *e, const struct crypto_bignum *a)
+{
+	BIGNUM *tmp;
+	int res = -2;
+	unsigned int mask;
+
+	if (TEST_FAIL())
+		return -2;
+
+	/* Same as crypto_bignum_legendre(), but with the precomputed exponent
+	 * and Montgomery context of the prime and the scratch space of the
+	 * context */
+	tmp = BN_new();
+	if (!tmp ||
+	    !BN_mod_exp_mont_consttime(tmp, (const BIGNUM *) a,
+				       e->shared->legendre_exp, e->prime,
+				       e->bnctx, e->shared->mont))
+		goto fail;
+
+	res = -1;
+	mask = const_time_eq(BN_is_word(tmp, 1), 1);
+	res = const_time_select_int(mask, 1, res);
+	mask = const_time_eq(BN_is_zero(tmp), 1);
+	res = const_time_select_int(mask, 0, res);
+
+fail:
+	BN_clear_free(tmp);
+	return res;
+}
+
+
 const struct crypto_ec_point * crypto_ec_get_generator(struct crypto_ec *e)
 {
 	return (const struct crypto_ec_point *)
@@ -2535,6 +2808,12 @@ int crypto_ec_point_mul(struct crypto_ec *e, const struct crypto_ec_point *p,
 {
 	if (TEST_FAIL())
 		return -1;
+	if ((const EC_POINT *) p == EC_GROUP_get0_generator(e->group)) {
+		/* Fixed-base multiplication can use precomputed tables */
+		return EC_POINT_mul(e->group, (EC_POINT *) res,
+				    (const BIGNUM *) b, NULL, NULL, e->bnctx)
+			? 0 : -1;
+	}
 	return EC_POINT_mul(e->group, (EC_POINT *) res, NULL,
 			    (const EC_POINT *) p, (const BIGNUM *) b, e->bnctx)
 		? 0 : -1;
@@ -5580,5 +5859,8 @@ struct wpabuf * hpke_base_open(enum hpke_kem_id kem_id,
 
 void crypto_unload(void)
 {
+#ifdef CONFIG_ECC
+	crypto_ec_groups_deinit();
+#endif /* CONFIG_ECC */
 	openssl_unload_legacy_provider();
 }
@@ -1283,6 +1283,62 @@ int omac1_aes_vector(const u8 *key, size_t key_len, size_t num_elem,
 }
 
 
+struct omac1_ctx {
+	Cmac cmac; /* initialized with the key, copied for each use */
+};
+
+
+struct omac1_ctx * omac1_aes_init(const u8 *key, size_t key_len)
+{
+	struct omac1_ctx *ctx;
+
+	ctx = os_zalloc(sizeof(*ctx));
+	if (!ctx)
+		return NULL;
+
+	if (wc_InitCmac(&ctx->cmac, key, key_len, WC_CMAC_AES, NULL) != 0) {
+		bin_clear_free(ctx, sizeof(*ctx));
+		return NULL;
+	}
+
+	return ctx;
+}
+
+
+int omac1_aes_ctx_vector(struct omac1_ctx *ctx, size_t num_elem,
+			 const u8 *addr[], const size_t *len, u8 *mac)
+{
+	Cmac cmac;
+	size_t i;
+	word32 sz;
+	int ret = -1;
+
+	if (TEST_FAIL())
+		return -1;
+
+	os_memcpy(&cmac, &ctx->cmac, sizeof(cmac));
+
+	for (i = 0; i < num_elem; i++)
+		if (wc_CmacUpdate(&cmac, addr[i], len[i]) != 0)
+			goto fail;
+
+	sz = AES_BLOCK_SIZE;
+	if (wc_CmacFinal(&cmac, mac, &sz) != 0 || sz != AES_BLOCK_SIZE)
+		goto fail;
+
+	ret = 0;
+fail:
+	forced_memzero(&cmac, sizeof(cmac));
+	return ret;
+}
+
+
+void omac1_aes_deinit(struct omac1_ctx *ctx)
+{
+	bin_clear_free(ctx, sizeof(*ctx));
+}
+
+
 int omac1_aes_128_vector(const u8 *key, size_t num_elem,
 			 const u8 *addr[], const size_t *len, u8 *mac)
 {
@@ -1820,6 +1876,12 @@ const struct crypto_bignum * crypto_ec_get_b(struct crypto_ec *e)
 }
 
 
+int crypto_ec_legendre(struct crypto_ec *e, const struct crypto_bignum *a)
+{
+	return crypto_bignum_legendre(a, crypto_ec_get_prime(e));
+}
+
+
 void crypto_ec_point_deinit(struct crypto_ec_point *p, int clear)
 {
 	ecc_point *point = (ecc_point *) p;
@@ -270,16 +270,59 @@ static void cookey(const u32 *raw1, u32 *keyout)
 }
 
 
+/*
+ * PC-2 as lookups of 7-bit chunks of the rotated C and D key halves. PC-2
+ * selects the first 24 bits of each subkey from C and the last 24 bits from D.
+ */
+static u32 pc2_tab[2][4][128];
+static int pc2_tab_ready = 0;
+
+
+static void deskey_init(void)
+{
+	u32 h, q, v, j, pos;
+
+	for (h = 0; h < 2; h++) {
+		for (q = 0; q < 4; q++) {
+			for (v = 0; v < 128; v++) {
+				u32 out = 0;
+
+				for (j = 0; j < 24; j++) {
+					pos = pc2[24 * h + j] - 28 * h;
+					if (pos / 7 == q && (v & BIT(pos % 7)))
+						out |= bigbyte[j];
+				}
+				pc2_tab[h][q][v] = out;
+			}
+		}
+	}
+	pc2_tab_ready = 1;
+}
+
+
+static u32 deskey_pc2(const u32 tab[4][128], u32 half, u32 rot)
+{
+	half = ((half >> rot) | (half << (28 - rot))) & 0x0fffffff;
+	return tab[0][half & 0x7f] | tab[1][(half >> 7) & 0x7f] |
+		tab[2][(half >> 14) & 0x7f] | tab[3][half >> 21];
+}
+
+
 static void deskey(const u8 *key, int decrypt, u32 *keyout)
 {
-	u32 i, j, l, m, n, kn[32];
-	u8 pc1m[56], pcr[56];
+	u32 i, j, l, m, n, kn[32], c = 0, d = 0;
 
-	for (j = 0; j < 56; j++) {
+	if (!pc2_tab_ready)
+		deskey_init();
+
+	/* PC-1 into the C and D halves; bit j is the bit at index j */
+	for (j = 0; j < 28; j++) {
 		l = (u32) pc1[j];
-		m = l & 7;
-		pc1m[j] = (u8)
-			((key[l >> 3U] & bytebit[m]) == bytebit[m] ? 1 : 0);
+		if (key[l >> 3U] & bytebit[l & 7])
+			c |= BIT(j);
+		l = (u32) pc1[j + 28];
+		if (key[l >> 3U] & bytebit[l & 7])
+			d |= BIT(j);
 	}
 
 	for (i = 0; i < 16; i++) {
@@ -288,27 +331,8 @@ static void deskey(const u8 *key, int decrypt, u32 *keyout)
 		else
 			m = i << 1;
 		n = m + 1;
-		kn[m] = kn[n] = 0L;
-		for (j = 0; j < 28; j++) {
-			l = j + (u32) totrot[i];
-			if (l < 28)
-				pcr[j] = pc1m[l];
-			else
-				pcr[j] = pc1m[l - 28];
-		}
-		for (/* j = 28 */; j < 56; j++) {
-			l = j + (u32) totrot[i];
-			if (l < 56)
-				pcr[j] = pc1m[l];
-			else
-				pcr[j] = pc1m[l - 28];
-		}
-		for (j = 0; j < 24; j++) {
-			if ((int) pcr[(int) pc2[j]] != 0)
-				kn[m] |= bigbyte[j];
-			if ((int) pcr[(int) pc2[j + 24]] != 0)
-				kn[n] |= bigbyte[j];
-		}
+		kn[m] = deskey_pc2(pc2_tab[0], c, totrot[i]);
+		kn[n] = deskey_pc2(pc2_tab[1], d, totrot[i]);
 	}
 
 	cookey(kn, keyout);
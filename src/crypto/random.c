@@ -25,6 +25,7 @@
 #include "utils/includes.h"
 #ifdef __linux__
 #include <fcntl.h>
+#include <sys/mman.h>
 #ifdef CONFIG_GETRANDOM
 #include <sys/random.h>
 #endif /* CONFIG_GETRANDOM */
@@ -62,6 +63,29 @@ static char *random_entropy_file = NULL;
 static unsigned int entropy = 0;
 static unsigned int total_collected = 0;
 
+/*
+ * The operating system randomness for small requests, e.g., nonces and SAE
+ * scalars, is fetched in larger chunks to avoid the system calls for each
+ * request. The buffer is in its own mapping that the kernel clears on fork
+ * (MADV_WIPEONFORK), so that two processes never use the same random data,
+ * and each byte is cleared once it has been returned, so the buffer only holds
+ * data that has not been used yet.
+ */
+#if defined(__linux__) && defined(MADV_WIPEONFORK) && \
+	!defined(CONFIG_USE_OPENSSL_RNG)
+#define RANDOM_OS_BUF
+#define RANDOM_OS_BUF_LEN 512
+#define RANDOM_OS_BUF_MAX_REQ 64
+
+struct random_os_buf {
+	size_t avail; /* unused octets at the end of data[] */
+	u8 data[RANDOM_OS_BUF_LEN];
+};
+
+static struct random_os_buf *os_buf = NULL;
+static bool os_buf_unavailable = false;
+#endif /* __linux__ && MADV_WIPEONFORK && !CONFIG_USE_OPENSSL_RNG */
+
 
 static void random_write_entropy(void);
 
@@ -156,6 +180,80 @@ void random_add_randomness(const void *buf, size_t len)
 }
 
 
+#ifdef RANDOM_OS_BUF
+
+static struct random_os_buf * random_os_buf_get(void)
+{
+	void *mem;
+
+	if (os_buf || os_buf_unavailable)
+		return os_buf;
+
+	mem = mmap(NULL, sizeof(*os_buf), PROT_READ | PROT_WRITE,
+		   MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (mem == MAP_FAILED) {
+		os_buf_unavailable = true;
+		return NULL;
+	}
+	if (madvise(mem, sizeof(*os_buf), MADV_WIPEONFORK) < 0) {
+		wpa_printf(MSG_DEBUG,
+			   "random: MADV_WIPEONFORK not supported - do not buffer OS randomness");
+		munmap(mem, sizeof(*os_buf));
+		os_buf_unavailable = true;
+		return NULL;
+	}
+#ifdef MADV_DONTDUMP
+	madvise(mem, sizeof(*os_buf), MADV_DONTDUMP);
+#endif /* MADV_DONTDUMP */
+
+	os_buf = mem;
+	return os_buf;
+}
+
+
+static void random_os_buf_free(void)
+{
+	if (!os_buf)
+		return;
+	forced_memzero(os_buf, sizeof(*os_buf));
+	munmap(os_buf, sizeof(*os_buf));
+	os_buf = NULL;
+}
+
+#endif /* RANDOM_OS_BUF */
+
+
+#ifndef CONFIG_USE_OPENSSL_RNG
+static int random_get_os_bytes(u8 *buf, size_t len)
+{
+#ifdef RANDOM_OS_BUF
+	struct random_os_buf *b = NULL;
+	u8 *pos;
+
+	if (len <= RANDOM_OS_BUF_MAX_REQ)
+		b = random_os_buf_get();
+	if (b) {
+		if (b->avail < len) {
+			b->avail = 0;
+			if (os_get_random(b->data, sizeof(b->data)) < 0) {
+				forced_memzero(b->data, sizeof(b->data));
+				return -1;
+			}
+			b->avail = sizeof(b->data);
+		}
+		pos = &b->data[sizeof(b->data) - b->avail];
+		os_memcpy(buf, pos, len);
+		forced_memzero(pos, len);
+		b->avail -= len;
+		return 0;
+	}
+#endif /* RANDOM_OS_BUF */
+
+	return os_get_random(buf, len);
+}
+#endif /* CONFIG_USE_OPENSSL_RNG */
+
+
 int random_get_bytes(void *buf, size_t len)
 {
 	int ret;
@@ -172,7 +270,7 @@ int random_get_bytes(void *buf, size_t len)
 			buf, len);
 #else /* CONFIG_USE_OPENSSL_RNG */
 	/* Start with assumed strong randomness from OS */
-	ret = os_get_random(buf, len);
+	ret = random_get_os_bytes(buf, len);
 	wpa_hexdump_key(MSG_EXCESSIVE, "random from os_get_random",
 			buf, len);
 #endif /* CONFIG_USE_OPENSSL_RNG */
@@ -482,4 +580,7 @@ void random_deinit(void)
 	random_write_entropy();
 	os_free(random_entropy_file);
 	random_entropy_file = NULL;
+#ifdef RANDOM_OS_BUF
+	random_os_buf_free();
+#endif /* RANDOM_OS_BUF */
 }
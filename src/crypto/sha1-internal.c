@@ -13,10 +13,12 @@
 #include "sha1_i.h"
 #include "md5.h"
 #include "crypto.h"
+#include "sha_hw.h"
 
 typedef struct SHA1Context SHA1_CTX;
 
 void SHA1Transform(u32 state[5], const unsigned char buffer[64]);
+static void SHA1TransformSw(u32 state[5], const unsigned char buffer[64]);
 
 
 #ifdef CONFIG_CRYPTO_INTERNAL
@@ -171,9 +173,154 @@ void SHAPrintContext(SHA1_CTX *context, char *msg)
 }
 #endif
 
-/* Hash a single 512-bit block. This is the core of the algorithm. */
+#ifdef SHA_HW_X86
+
+/*
+ * Four rounds with SHA1RNDS4 and the message schedule for the 16 words needed
+ * four steps later. e is the fifth state word of these rounds, derived from
+ * the state before the previous step with SHA1NEXTE.
+ */
+#define SHA1_HW_RND(j) \
+do { \
+	if ((j) >= 4) \
+		w[(j) & 3] = _mm_sha1msg2_epu32( \
+			_mm_xor_si128(_mm_sha1msg1_epu32(w[(j) & 3], \
+							 w[((j) + 1) & 3]), \
+				      w[((j) + 2) & 3]), \
+			w[((j) + 3) & 3]); \
+	if ((j) == 0) \
+		e = _mm_add_epi32(e_save, w[0]); \
+	else \
+		e = _mm_sha1nexte_epu32(prev, w[(j) & 3]); \
+	prev = abcd; \
+	abcd = _mm_sha1rnds4_epu32(abcd, e, (j) / 5); \
+} while (0)
+
+static void SHA_HW_TARGET SHA1TransformHw(u32 state[5],
+					  const unsigned char *data,
+					  size_t blocks)
+{
+	const __m128i mask = _mm_set_epi64x(0x0001020304050607ULL,
+					    0x08090a0b0c0d0e0fULL);
+	__m128i abcd, abcd_save, e, e_save, prev, w[4];
+	int i;
+
+	abcd = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *) state),
+				 0x1b);
+	e_save = _mm_set_epi32(state[4], 0, 0, 0);
+
+	while (blocks--) {
+		abcd_save = abcd;
+		for (i = 0; i < 4; i++)
+			w[i] = _mm_shuffle_epi8(
+				_mm_loadu_si128((const __m128i *)
+						(data + 16 * i)), mask);
+
+		SHA1_HW_RND(0); SHA1_HW_RND(1); SHA1_HW_RND(2);
+		SHA1_HW_RND(3); SHA1_HW_RND(4); SHA1_HW_RND(5);
+		SHA1_HW_RND(6); SHA1_HW_RND(7); SHA1_HW_RND(8);
+		SHA1_HW_RND(9); SHA1_HW_RND(10); SHA1_HW_RND(11);
+		SHA1_HW_RND(12); SHA1_HW_RND(13); SHA1_HW_RND(14);
+		SHA1_HW_RND(15); SHA1_HW_RND(16); SHA1_HW_RND(17);
+		SHA1_HW_RND(18); SHA1_HW_RND(19);
+
+		e_save = _mm_sha1nexte_epu32(prev, e_save);
+		abcd = _mm_add_epi32(abcd, abcd_save);
+		data += 64;
+	}
+
+	_mm_storeu_si128((__m128i *) state, _mm_shuffle_epi32(abcd, 0x1b));
+	state[4] = _mm_extract_epi32(e_save, 3);
+}
+
+#endif /* SHA_HW_X86 */
+
+#ifdef SHA_HW_ARM
+
+static void SHA_HW_TARGET SHA1TransformHw(u32 state[5],
+					  const unsigned char *data,
+					  size_t blocks)
+{
+	static const u32 k[4] = {
+		0x5A827999, 0x6ED9EBA1, 0x8F1BBCDC, 0xCA62C1D6
+	};
+	uint32x4_t abcd, abcd_save, msg, w[4];
+	u32 e, e_next, e_save;
+	int i, j;
+
+	abcd = vld1q_u32(state);
+	e_save = state[4];
+
+	while (blocks--) {
+		abcd_save = abcd;
+		e = e_save;
+		for (i = 0; i < 4; i++)
+			w[i] = vreinterpretq_u32_u8(
+				vrev32q_u8(vld1q_u8(data + 16 * i)));
+
+		for (j = 0; j < 20; j++) {
+			if (j >= 4)
+				w[j & 3] = vsha1su1q_u32(
+					vsha1su0q_u32(w[j & 3], w[(j + 1) & 3],
+						      w[(j + 2) & 3]),
+					w[(j + 3) & 3]);
+			msg = vaddq_u32(w[j & 3], vdupq_n_u32(k[j / 5]));
+			e_next = vsha1h_u32(vgetq_lane_u32(abcd, 0));
+			if (j < 5)
+				abcd = vsha1cq_u32(abcd, e, msg);
+			else if (j < 10 || j >= 15)
+				abcd = vsha1pq_u32(abcd, e, msg);
+			else
+				abcd = vsha1mq_u32(abcd, e, msg);
+			e = e_next;
+		}
+
+		e_save += e;
+		abcd = vaddq_u32(abcd, abcd_save);
+		data += 64;
+	}
+
+	vst1q_u32(state, abcd);
+	state[4] = e_save;
+}
+
+#endif /* SHA_HW_ARM */
+
+
+/**
+ * SHA1TransformBlocks - Hash a number of consecutive 512-bit blocks
+ * @state: SHA-1 state
+ * @data: Blocks to hash
+ * @blocks: Number of 64 octet blocks in data
+ */
+void SHA1TransformBlocks(u32 state[5], const unsigned char *data,
+			 size_t blocks)
+{
+#if defined(SHA_HW_X86) || defined(SHA_HW_ARM)
+	if (sha_hw_features() & SHA_HW_SHA1) {
+		SHA1TransformHw(state, data, blocks);
+		return;
+	}
+#endif /* SHA_HW_X86 || SHA_HW_ARM */
+
+	while (blocks--) {
+		SHA1TransformSw(state, data);
+		data += 64;
+	}
+}
+
+
+/* Hash a single 512-bit block. */
 
 void SHA1Transform(u32 state[5], const unsigned char buffer[64])
+{
+	SHA1TransformBlocks(state, buffer, 1);
+}
+
+
+/* Hash a single 512-bit block. This is the core of the algorithm. */
+
+static void SHA1TransformSw(u32 state[5], const unsigned char buffer[64])
 {
 	u32 a, b, c, d, e;
 	typedef union {
@@ -260,8 +407,10 @@ void SHA1Update(SHA1_CTX* context, const void *_data, u32 len)
 	if ((j + len) > 63) {
 		os_memcpy(&context->buffer[j], data, (i = 64-j));
 		SHA1Transform(context->state, context->buffer);
-		for ( ; i + 63 < len; i += 64) {
-			SHA1Transform(context->state, &data[i]);
+		if (i + 63 < len) {
+			SHA1TransformBlocks(context->state, &data[i],
+					    (len - i) / 64);
+			i += (len - i) & ~63;
 		}
 		j = 0;
 	}
@@ -10,6 +10,49 @@
 
 #include "common.h"
 #include "sha1.h"
+#ifdef CONFIG_INTERNAL_SHA1
+#include "sha1_i.h"
+
+/*
+ * With the internal SHA1 implementation, the HMAC-SHA1 states after the inner
+ * and outer key pads are computed only once per passphrase. Each of the
+ * remaining iterations is then two SHA1 compression function calls on a
+ * single, pre-padded block instead of four calls and the per call HMAC setup.
+ */
+
+static void pbkdf2_sha1_compress(const u32 *pad_state, u8 *block,
+				 u8 *digest)
+{
+	u32 state[5];
+	int i;
+
+	os_memcpy(state, pad_state, sizeof(state));
+	SHA1Transform(state, block);
+	for (i = 0; i < 5; i++)
+		WPA_PUT_BE32(digest + 4 * i, state[i]);
+	forced_memzero(state, sizeof(state));
+}
+
+
+static void pbkdf2_sha1_pad_state(const u8 *key, size_t key_len, u8 pad,
+				  u32 *state)
+{
+	struct SHA1Context ctx;
+	u8 block[64];
+	size_t i;
+
+	os_memset(block, pad, sizeof(block));
+	for (i = 0; i < key_len; i++)
+		block[i] ^= key[i];
+	SHA1Init(&ctx);
+	SHA1Transform(ctx.state, block);
+	os_memcpy(state, ctx.state, sizeof(ctx.state));
+	forced_memzero(&ctx, sizeof(ctx));
+	forced_memzero(block, sizeof(block));
+}
+
+#endif /* CONFIG_INTERNAL_SHA1 */
+
 
 static int pbkdf2_sha1_f(const char *passphrase, const u8 *ssid,
 			 size_t ssid_len, int iterations, unsigned int count,
@@ -42,6 +85,41 @@ static int pbkdf2_sha1_f(const char *passphrase, const u8 *ssid,
 		return -1;
 	os_memcpy(digest, tmp, SHA1_MAC_LEN);
 
+#ifdef CONFIG_INTERNAL_SHA1
+	if (passphrase_len <= 64) {
+		u32 istate[5], ostate[5];
+		u8 block[64];
+
+		pbkdf2_sha1_pad_state((const u8 *) passphrase, passphrase_len,
+				      0x36, istate);
+		pbkdf2_sha1_pad_state((const u8 *) passphrase, passphrase_len,
+				      0x5c, ostate);
+
+		/* Message of SHA1_MAC_LEN octets after the 64 octet pad block:
+		 * 0x80 terminator, zero padding, and the message length in
+		 * bits ((64 + 20) * 8 = 672) at the end */
+		os_memset(block, 0, sizeof(block));
+		block[SHA1_MAC_LEN] = 0x80;
+		WPA_PUT_BE16(&block[62], (64 + SHA1_MAC_LEN) * 8);
+
+		for (i = 1; i < iterations; i++) {
+			os_memcpy(block, tmp, SHA1_MAC_LEN);
+			pbkdf2_sha1_compress(istate, block, tmp2);
+			os_memcpy(block, tmp2, SHA1_MAC_LEN);
+			pbkdf2_sha1_compress(ostate, block, tmp);
+			for (j = 0; j < SHA1_MAC_LEN; j++)
+				digest[j] ^= tmp[j];
+		}
+
+		forced_memzero(istate, sizeof(istate));
+		forced_memzero(ostate, sizeof(ostate));
+		forced_memzero(block, sizeof(block));
+		forced_memzero(tmp, SHA1_MAC_LEN);
+		forced_memzero(tmp2, SHA1_MAC_LEN);
+		return 0;
+	}
+#endif /* CONFIG_INTERNAL_SHA1 */
+
 	for (i = 1; i < iterations; i++) {
 		if (hmac_sha1((u8 *) passphrase, passphrase_len, tmp,
 			      SHA1_MAC_LEN, tmp2))
@@ -19,5 +19,7 @@ void SHA1Init(struct SHA1Context *context);
 void SHA1Update(struct SHA1Context *context, const void *data, u32 len);
 void SHA1Final(unsigned char digest[20], struct SHA1Context *context);
 void SHA1Transform(u32 state[5], const unsigned char buffer[64]);
+void SHA1TransformBlocks(u32 state[5], const unsigned char *data,
+			 size_t blocks);
 
 #endif /* SHA1_I_H */
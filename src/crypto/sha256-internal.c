@@ -12,6 +12,7 @@
 #include "sha256.h"
 #include "sha256_i.h"
 #include "crypto.h"
+#include "sha_hw.h"
 
 
 /**
@@ -47,7 +48,7 @@ int sha256_vector(size_t num_elem, const u8 *addr[], const size_t *len,
  * public domain by Tom St Denis. */
 
 /* the K array */
-static const unsigned long K[64] = {
+static const u32 K[64] = {
 	0x428a2f98UL, 0x71374491UL, 0xb5c0fbcfUL, 0xe9b5dba5UL, 0x3956c25bUL,
 	0x59f111f1UL, 0x923f82a4UL, 0xab1c5ed5UL, 0xd807aa98UL, 0x12835b01UL,
 	0x243185beUL, 0x550c7dc3UL, 0x72be5d74UL, 0x80deb1feUL, 0x9bdc06a7UL,
@@ -77,6 +78,115 @@ static const unsigned long K[64] = {
 #define Gamma0(x)       (S(x, 7) ^ S(x, 18) ^ R(x, 3))
 #define Gamma1(x)       (S(x, 17) ^ S(x, 19) ^ R(x, 10))
 
+#ifdef SHA_HW_X86
+
+/*
+ * The state is kept as ABEF and CDGH words for SHA256RNDS2. Each step of
+ * SHA256_HW_RND() does four rounds and the message schedule for the 16 words
+ * needed four steps later.
+ */
+#define SHA256_HW_RND(j) \
+do { \
+	if ((j) >= 4) \
+		w[(j) & 3] = _mm_sha256msg2_epu32( \
+			_mm_add_epi32( \
+				_mm_sha256msg1_epu32(w[(j) & 3], \
+						     w[((j) + 1) & 3]), \
+				_mm_alignr_epi8(w[((j) + 3) & 3], \
+						w[((j) + 2) & 3], 4)), \
+			w[((j) + 3) & 3]); \
+	msg = _mm_add_epi32(w[(j) & 3], \
+			    _mm_loadu_si128((const __m128i *) &K[4 * (j)])); \
+	s1 = _mm_sha256rnds2_epu32(s1, s0, msg); \
+	s0 = _mm_sha256rnds2_epu32(s0, s1, _mm_shuffle_epi32(msg, 0x0e)); \
+} while (0)
+
+static void SHA_HW_TARGET sha256_hw_blocks(u32 state[8], const u8 *buf,
+					   size_t blocks)
+{
+	const __m128i mask = _mm_set_epi64x(0x0c0d0e0f08090a0bULL,
+					    0x0405060700010203ULL);
+	__m128i s0, s1, s0_save, s1_save, msg, tmp, w[4];
+	int i;
+
+	tmp = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *) &state[0]),
+				0xb1);
+	s1 = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *) &state[4]),
+			       0x1b);
+	s0 = _mm_alignr_epi8(tmp, s1, 8);
+	s1 = _mm_blend_epi16(s1, tmp, 0xf0);
+
+	while (blocks--) {
+		s0_save = s0;
+		s1_save = s1;
+		for (i = 0; i < 4; i++)
+			w[i] = _mm_shuffle_epi8(
+				_mm_loadu_si128((const __m128i *) (buf + 16 * i)),
+				mask);
+
+		SHA256_HW_RND(0); SHA256_HW_RND(1);
+		SHA256_HW_RND(2); SHA256_HW_RND(3);
+		SHA256_HW_RND(4); SHA256_HW_RND(5);
+		SHA256_HW_RND(6); SHA256_HW_RND(7);
+		SHA256_HW_RND(8); SHA256_HW_RND(9);
+		SHA256_HW_RND(10); SHA256_HW_RND(11);
+		SHA256_HW_RND(12); SHA256_HW_RND(13);
+		SHA256_HW_RND(14); SHA256_HW_RND(15);
+
+		s0 = _mm_add_epi32(s0, s0_save);
+		s1 = _mm_add_epi32(s1, s1_save);
+		buf += SHA256_BLOCK_SIZE;
+	}
+
+	tmp = _mm_shuffle_epi32(s0, 0x1b);
+	s1 = _mm_shuffle_epi32(s1, 0xb1);
+	_mm_storeu_si128((__m128i *) &state[0], _mm_blend_epi16(tmp, s1, 0xf0));
+	_mm_storeu_si128((__m128i *) &state[4], _mm_alignr_epi8(s1, tmp, 8));
+}
+
+#endif /* SHA_HW_X86 */
+
+#ifdef SHA_HW_ARM
+
+static void SHA_HW_TARGET sha256_hw_blocks(u32 state[8], const u8 *buf,
+					   size_t blocks)
+{
+	uint32x4_t s0, s1, s0_save, s1_save, msg, tmp, w[4];
+	int i, j;
+
+	s0 = vld1q_u32(&state[0]);
+	s1 = vld1q_u32(&state[4]);
+
+	while (blocks--) {
+		s0_save = s0;
+		s1_save = s1;
+		for (i = 0; i < 4; i++)
+			w[i] = vreinterpretq_u32_u8(
+				vrev32q_u8(vld1q_u8(buf + 16 * i)));
+
+		for (j = 0; j < 16; j++) {
+			if (j >= 4)
+				w[j & 3] = vsha256su1q_u32(
+					vsha256su0q_u32(w[j & 3],
+							w[(j + 1) & 3]),
+					w[(j + 2) & 3], w[(j + 3) & 3]);
+			msg = vaddq_u32(w[j & 3], vld1q_u32(&K[4 * j]));
+			tmp = s0;
+			s0 = vsha256hq_u32(s0, s1, msg);
+			s1 = vsha256h2q_u32(s1, tmp, msg);
+		}
+
+		s0 = vaddq_u32(s0, s0_save);
+		s1 = vaddq_u32(s1, s1_save);
+		buf += SHA256_BLOCK_SIZE;
+	}
+
+	vst1q_u32(&state[0], s0);
+	vst1q_u32(&state[4], s1);
+}
+
+#endif /* SHA_HW_ARM */
+
 /* compress 512-bits */
 static int sha256_compress(struct sha256_state *md, unsigned char *buf)
 {
@@ -120,6 +230,26 @@ static int sha256_compress(struct sha256_state *md, unsigned char *buf)
 }
 
 
+/* compress a number of consecutive 512-bit blocks */
+static int sha256_compress_blocks(struct sha256_state *md,
+				  const unsigned char *buf, size_t blocks)
+{
+#if defined(SHA_HW_X86) || defined(SHA_HW_ARM)
+	if (sha_hw_features() & SHA_HW_SHA256) {
+		sha256_hw_blocks(md->state, buf, blocks);
+		return 0;
+	}
+#endif /* SHA_HW_X86 || SHA_HW_ARM */
+
+	while (blocks--) {
+		if (sha256_compress(md, (unsigned char *) buf) < 0)
+			return -1;
+		buf += SHA256_BLOCK_SIZE;
+	}
+	return 0;
+}
+
+
 /* Initialize the hash state */
 void sha256_init(struct sha256_state *md)
 {
@@ -152,11 +282,12 @@ int sha256_process(struct sha256_state *md, const unsigned char *in,
 
 	while (inlen > 0) {
 		if (md->curlen == 0 && inlen >= SHA256_BLOCK_SIZE) {
-			if (sha256_compress(md, (unsigned char *) in) < 0)
+			n = inlen / SHA256_BLOCK_SIZE;
+			if (sha256_compress_blocks(md, in, n) < 0)
 				return -1;
-			md->length += SHA256_BLOCK_SIZE * 8;
-			in += SHA256_BLOCK_SIZE;
-			inlen -= SHA256_BLOCK_SIZE;
+			md->length += (u64) n * SHA256_BLOCK_SIZE * 8;
+			in += n * SHA256_BLOCK_SIZE;
+			inlen -= n * SHA256_BLOCK_SIZE;
 		} else {
 			n = MIN(inlen, (SHA256_BLOCK_SIZE - md->curlen));
 			os_memcpy(md->buf + md->curlen, in, n);
@@ -164,7 +295,7 @@ int sha256_process(struct sha256_state *md, const unsigned char *in,
 			in += n;
 			inlen -= n;
 			if (md->curlen == SHA256_BLOCK_SIZE) {
-				if (sha256_compress(md, md->buf) < 0)
+				if (sha256_compress_blocks(md, md->buf, 1) < 0)
 					return -1;
 				md->length += 8 * SHA256_BLOCK_SIZE;
 				md->curlen = 0;
@@ -203,7 +334,7 @@ int sha256_done(struct sha256_state *md, unsigned char *out)
 		while (md->curlen < SHA256_BLOCK_SIZE) {
 			md->buf[md->curlen++] = (unsigned char) 0;
 		}
-		sha256_compress(md, md->buf);
+		sha256_compress_blocks(md, md->buf, 1);
 		md->curlen = 0;
 	}
 
@@ -214,7 +345,7 @@ int sha256_done(struct sha256_state *md, unsigned char *out)
 
 	/* store length */
 	WPA_PUT_BE64(md->buf + 56, md->length);
-	sha256_compress(md, md->buf);
+	sha256_compress_blocks(md, md->buf, 1);
 
 	/* copy output */
 	for (i = 0; i < 8; i++)
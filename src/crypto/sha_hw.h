@@ -0,0 +1,77 @@
+/*
+ * SHA-1 and SHA-256 compression with CPU instructions
+ *
+ * This software may be distributed under the terms of the BSD license.
+ * See README for more details.
+ */
+
+#ifndef SHA_HW_H
+#define SHA_HW_H
+
+/*
+ * The internal SHA-1 and SHA-256 implementations use the SHA extensions on
+ * x86-64 and the ARMv8 Cryptography Extension on AArch64 when the CPU supports
+ * them. This follows the same model as aes_hw.h: on x86-64, the code paths are
+ * compiled with function specific target attributes and selected based on
+ * CPUID at runtime; on AArch64, they are only built when the compiler targets
+ * the SHA instructions (e.g., -march=armv8-a+crypto) and selected based on the
+ * hwcaps of the CPU.
+ */
+
+#if defined(__x86_64__) && defined(__GNUC__) && !defined(CONFIG_NO_SHA_HW)
+
+#include <cpuid.h>
+#include <immintrin.h>
+
+#define SHA_HW_X86
+#define SHA_HW_TARGET __attribute__((target("sha,sse4.1,ssse3")))
+
+#elif defined(__aarch64__) && !defined(__AARCH64EB__) && \
+	(defined(__ARM_FEATURE_CRYPTO) || defined(__ARM_FEATURE_SHA2)) && \
+	defined(__linux__) && !defined(CONFIG_NO_SHA_HW)
+
+#include <arm_neon.h>
+#include <sys/auxv.h>
+#include <asm/hwcap.h>
+
+#define SHA_HW_ARM
+#define SHA_HW_TARGET
+
+#endif
+
+#if defined(SHA_HW_X86) || defined(SHA_HW_ARM)
+
+#define SHA_HW_SHA1 BIT(0)
+#define SHA_HW_SHA256 BIT(1)
+
+static inline unsigned int sha_hw_features(void)
+{
+	static int features = -1;
+
+	if (features < 0) {
+#ifdef SHA_HW_X86
+		unsigned int eax, ebx, ecx, edx;
+
+		features = 0;
+		if (__get_cpuid(1, &eax, &ebx, &ecx, &edx) &&
+		    (ecx & bit_SSSE3) && (ecx & bit_SSE4_1) &&
+		    __get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx) &&
+		    (ebx & bit_SHA))
+			features = SHA_HW_SHA1 | SHA_HW_SHA256;
+#else /* SHA_HW_X86 */
+		unsigned long hwcap = getauxval(AT_HWCAP);
+
+		features = 0;
+		if (hwcap & HWCAP_SHA1)
+			features |= SHA_HW_SHA1;
+		if (hwcap & HWCAP_SHA2)
+			features |= SHA_HW_SHA256;
+#endif /* SHA_HW_X86 */
+	}
+
+	return features;
+}
+
+#endif /* SHA_HW_X86 || SHA_HW_ARM */
+
+#endif /* SHA_HW_H */
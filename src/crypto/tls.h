@@ -93,6 +93,7 @@ struct tls_config {
 	int cert_in_cb;
 	const char *openssl_ciphers;
 	unsigned int tls_session_lifetime;
+	unsigned int tls_session_cache_size;
 	unsigned int crl_reload_interval;
 	unsigned int tls_flags;
 
@@ -656,6 +657,65 @@ tls_connection_get_success_data(struct tls_connection *conn);
 
 void tls_connection_remove_session(struct tls_connection *conn);
 
+/**
+ * tls_connection_set_ticket_data - Set success data for session tickets
+ * @conn: Connection context data from tls_connection_init()
+ * @data: Success data to embed in session tickets issued on this connection
+ *	(the TLS library takes ownership of the buffer)
+ *
+ * This is used on the server side to allow a session resumed from a ticket,
+ * possibly issued by another server sharing the same ticket keys, to be
+ * validated with tls_connection_get_success_data() without a local session
+ * cache entry. The data is embedded in the ticket when the handshake
+ * completes, so it must not depend on anything after the TLS handshake.
+ */
+void tls_connection_set_ticket_data(struct tls_connection *conn,
+				    struct wpabuf *data);
+
+#define TLS_SESSION_TICKET_KEY_NAME_LEN 16
+#define TLS_SESSION_TICKET_KEY_LEN 80
+
+/**
+ * tls_set_session_ticket_keys - Configure session ticket encryption keys
+ * @tls_ctx: TLS context data from tls_init()
+ * @keys: Concatenated keys, TLS_SESSION_TICKET_KEY_LEN octets each, or %NULL
+ * @num_keys: Number of keys; 0 to use keys generated by the TLS library
+ * Returns: 0 on success, -1 on failure
+ *
+ * Each key consists of a 16-octet key name, a 32-octet HMAC-SHA256 key, and a
+ * 32-octet AES-256 key. The first key is used to issue new tickets and all
+ * keys are accepted for resumption, so servers sharing the same key ring can
+ * resume each other's sessions and keys can be rotated without invalidating
+ * all outstanding tickets.
+ */
+int tls_set_session_ticket_keys(void *tls_ctx, const u8 *keys,
+				size_t num_keys);
+
+/**
+ * struct tls_session_cache_stats - TLS session cache statistics
+ * @entries: Number of sessions currently in the cache
+ * @hits: Number of successfully resumed sessions
+ * @misses: Number of resumption attempts that did not find a session
+ * @timeouts: Number of resumption attempts with an expired session
+ * @evictions: Number of sessions removed due to the cache being full
+ */
+struct tls_session_cache_stats {
+	unsigned int entries;
+	unsigned int hits;
+	unsigned int misses;
+	unsigned int timeouts;
+	unsigned int evictions;
+};
+
+/**
+ * tls_get_session_cache_stats - Get server session cache statistics
+ * @tls_ctx: TLS context data from tls_init()
+ * @stats: Buffer for returning the statistics
+ * Returns: 0 on success, -1 if session caching is not in use or not supported
+ */
+int tls_get_session_cache_stats(void *tls_ctx,
+				struct tls_session_cache_stats *stats);
+
 /**
  * tls_get_tls_unique - Fetch "tls-unique" for channel binding
  * @conn: Connection context data from tls_connection_init()
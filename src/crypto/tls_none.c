@@ -231,3 +231,24 @@ tls_connection_get_success_data(struct tls_connection *conn)
 void tls_connection_remove_session(struct tls_connection *conn)
 {
 }
+
+
+void tls_connection_set_ticket_data(struct tls_connection *conn,
+				    struct wpabuf *data)
+{
+	wpabuf_free(data);
+}
+
+
+int tls_set_session_ticket_keys(void *tls_ctx, const u8 *keys,
+				size_t num_keys)
+{
+	return -1;
+}
+
+
+int tls_get_session_cache_stats(void *tls_ctx,
+				struct tls_session_cache_stats *stats)
+{
+	return -1;
+}
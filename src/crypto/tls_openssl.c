@@ -31,6 +31,7 @@
 #include <openssl/x509v3.h>
 #if OPENSSL_VERSION_NUMBER >= 0x30000000L
 #include <openssl/core_names.h>
+#include <openssl/rand.h>
 #include <openssl/decoder.h>
 #include <openssl/param_build.h>
 #else /* OpenSSL version >= 3.0 */
@@ -62,6 +63,11 @@
 #define EAP_FAST_OR_TEAP
 #endif
 
+#if OPENSSL_VERSION_NUMBER >= 0x10100000L && \
+	!defined(LIBRESSL_VERSION_NUMBER) && !defined(OPENSSL_IS_BORINGSSL)
+#define OPENSSL_VERIFY_CACHE
+#endif
+
 
 #if defined(OPENSSL_IS_BORINGSSL)
 /* stack_index_t is the return type of OpenSSL's sk_XXX_num() functions. */
@@ -131,8 +137,11 @@ static const unsigned char * ASN1_STRING_get0_data(const ASN1_STRING *x)
 static int tls_openssl_ref_count = 0;
 static int tls_ex_idx_session = -1;
 
+#define TLS_SESSION_HASH_SIZE 1024
+
 struct tls_session_data {
 	struct dl_list list;
+	struct tls_session_data *hnext;
 	struct wpabuf *buf;
 };
 
@@ -143,6 +152,7 @@ struct tls_context {
 	int cert_in_cb;
 	char *ocsp_stapling_response;
 	struct dl_list sessions; /* struct tls_session_data */
+	struct tls_session_data *session_hash[TLS_SESSION_HASH_SIZE];
 };
 
 struct tls_data {
@@ -155,6 +165,21 @@ struct tls_data {
 	struct os_reltime crl_last_reload;
 	char *check_cert_subject;
 	char *openssl_ciphers;
+	u8 *ticket_keys; /* TLS_SESSION_TICKET_KEY_LEN octets per key */
+	size_t num_ticket_keys;
+	/* Verified server certificate chains and OCSP responses */
+	struct dl_list verify_cache; /* struct tls_verify_cache_entry */
+};
+
+#define TLS_VERIFY_CACHE_SIZE 16
+#define TLS_VERIFY_CACHE_LIFETIME 3600
+
+struct tls_verify_cache_entry {
+	struct dl_list list;
+	u8 hash[SHA256_MAC_LEN];
+	struct os_reltime expires;
+	STACK_OF(X509) *chain; /* verified chain or %NULL for OCSP status */
+	ASN1_GENERALIZEDTIME *next_update; /* OCSP nextUpdate or %NULL */
 };
 
 struct tls_connection {
@@ -178,6 +203,11 @@ struct tls_connection {
 	u8 *session_ticket;
 	size_t session_ticket_len;
 
+	/* Success data to embed in issued session tickets (server) */
+	struct wpabuf *ticket_data;
+	/* Success data restored from a resumed session ticket (server) */
+	struct wpabuf *resumed_ticket_data;
+
 	unsigned int ca_cert_verify:1;
 	unsigned int cert_probe:1;
 	unsigned int server_cert_only:1;
@@ -976,13 +1006,24 @@ static int tls_engine_load_dynamic_opensc(const char *opensc_so_path)
 #endif /* OPENSSL_NO_ENGINE */
 
 
+static unsigned int session_data_hash(const struct wpabuf *buf)
+{
+	uintptr_t val = (uintptr_t) buf;
+
+	val ^= val >> 16;
+	val *= 0x45d9f3b;
+	val ^= val >> 16;
+	return (val >> 4) % TLS_SESSION_HASH_SIZE;
+}
+
+
 static struct tls_session_data * get_session_data(struct tls_context *context,
 						  const struct wpabuf *buf)
 {
 	struct tls_session_data *data;
 
-	dl_list_for_each(data, &context->sessions, struct tls_session_data,
-			 list) {
+	for (data = context->session_hash[session_data_hash(buf)]; data;
+	     data = data->hnext) {
 		if (data->buf == buf)
 			return data;
 	}
@@ -991,6 +1032,147 @@ static struct tls_session_data * get_session_data(struct tls_context *context,
 }
 
 
+static void add_session_data(struct tls_context *context,
+			     struct tls_session_data *data)
+{
+	unsigned int idx = session_data_hash(data->buf);
+
+	data->hnext = context->session_hash[idx];
+	context->session_hash[idx] = data;
+	dl_list_add(&context->sessions, &data->list);
+}
+
+
+static void del_session_data(struct tls_context *context,
+			     struct tls_session_data *data)
+{
+	struct tls_session_data **pos;
+
+	pos = &context->session_hash[session_data_hash(data->buf)];
+	while (*pos && *pos != data)
+		pos = &(*pos)->hnext;
+	if (*pos)
+		*pos = data->hnext;
+	dl_list_del(&data->list);
+	os_free(data);
+}
+
+
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+
+static int tls_ticket_gen_cb(SSL *ssl, void *arg)
+{
+	struct tls_connection *conn = SSL_get_app_data(ssl);
+	SSL_SESSION *sess = SSL_get_session(ssl);
+
+	if (!conn || !conn->ticket_data || !sess)
+		return 1;
+	if (SSL_SESSION_set1_ticket_appdata(
+		    sess, wpabuf_head(conn->ticket_data),
+		    wpabuf_len(conn->ticket_data)) != 1)
+		return 0;
+	return 1;
+}
+
+
+static SSL_TICKET_RETURN tls_ticket_dec_cb(SSL *ssl, SSL_SESSION *sess,
+					   const unsigned char *keyname,
+					   size_t keyname_len,
+					   SSL_TICKET_STATUS status,
+					   void *arg)
+{
+	struct tls_connection *conn = SSL_get_app_data(ssl);
+	void *appdata;
+	size_t appdata_len;
+
+	switch (status) {
+	case SSL_TICKET_SUCCESS:
+	case SSL_TICKET_SUCCESS_RENEW:
+		break;
+	case SSL_TICKET_FATAL_ERR_MALLOC:
+	case SSL_TICKET_FATAL_ERR_OTHER:
+		return SSL_TICKET_RETURN_ABORT;
+	default:
+		return SSL_TICKET_RETURN_IGNORE_RENEW;
+	}
+
+	if (conn &&
+	    SSL_SESSION_get0_ticket_appdata(sess, &appdata, &appdata_len) == 1 &&
+	    appdata_len > 0) {
+		wpabuf_free(conn->resumed_ticket_data);
+		conn->resumed_ticket_data = wpabuf_alloc_copy(appdata,
+							      appdata_len);
+		if (!conn->resumed_ticket_data)
+			return SSL_TICKET_RETURN_ABORT;
+		wpa_printf(MSG_DEBUG,
+			   "OpenSSL: Restored success data from session ticket");
+	}
+
+	return status == SSL_TICKET_SUCCESS_RENEW ?
+		SSL_TICKET_RETURN_USE_RENEW : SSL_TICKET_RETURN_USE;
+}
+
+
+static int tls_ticket_key_cb(SSL *ssl, unsigned char *key_name,
+			     unsigned char *iv, EVP_CIPHER_CTX *ctx,
+			     EVP_MAC_CTX *hctx, int enc)
+{
+	struct tls_connection *conn = SSL_get_app_data(ssl);
+	struct tls_data *data;
+	const EVP_CIPHER *cipher = EVP_aes_256_cbc();
+	OSSL_PARAM params[3];
+	const u8 *key = NULL;
+	size_t i;
+
+	if (!conn)
+		return -1;
+	data = conn->data;
+	if (data->num_ticket_keys == 0)
+		return 0;
+
+	if (enc) {
+		key = data->ticket_keys;
+		os_memcpy(key_name, key, TLS_SESSION_TICKET_KEY_NAME_LEN);
+		if (RAND_bytes(iv, EVP_CIPHER_get_iv_length(cipher)) != 1)
+			return -1;
+		i = 0;
+	} else {
+		for (i = 0; i < data->num_ticket_keys; i++) {
+			key = &data->ticket_keys[i * TLS_SESSION_TICKET_KEY_LEN];
+			if (os_memcmp(key, key_name,
+				      TLS_SESSION_TICKET_KEY_NAME_LEN) == 0)
+				break;
+		}
+		if (i == data->num_ticket_keys) {
+			wpa_printf(MSG_DEBUG,
+				   "OpenSSL: Session ticket with unknown key name");
+			return 0;
+		}
+	}
+
+	params[0] = OSSL_PARAM_construct_octet_string(
+		OSSL_MAC_PARAM_KEY, (void *) (key + 16), 32);
+	params[1] = OSSL_PARAM_construct_utf8_string(OSSL_MAC_PARAM_DIGEST,
+						     "SHA256", 0);
+	params[2] = OSSL_PARAM_construct_end();
+	if (EVP_MAC_CTX_set_params(hctx, params) != 1)
+		return -1;
+
+	if (enc) {
+		if (EVP_EncryptInit_ex(ctx, cipher, NULL, key + 48, iv) != 1)
+			return -1;
+		return 1;
+	}
+
+	if (EVP_DecryptInit_ex(ctx, cipher, NULL, key + 48, iv) != 1)
+		return -1;
+	/* Request a new ticket if this one was issued with an old key */
+	return i == 0 ? 1 : 2;
+}
+
+#endif /* >= 3.0 */
+
+
 static void remove_session_cb(SSL_CTX *ctx, SSL_SESSION *sess)
 {
 	struct wpabuf *buf;
@@ -1017,8 +1199,7 @@ static void remove_session_cb(SSL_CTX *ctx, SSL_SESSION *sess)
 		return;
 	}
 
-	dl_list_del(&found->list);
-	os_free(found);
+	del_session_data(context, found);
 	wpa_printf(MSG_DEBUG,
 		   "OpenSSL: Free application session data %p (sess %p)",
 		   buf, sess);
@@ -1026,6 +1207,87 @@ static void remove_session_cb(SSL_CTX *ctx, SSL_SESSION *sess)
 }
 
 
+static void tls_verify_cache_free(struct tls_verify_cache_entry *entry)
+{
+	dl_list_del(&entry->list);
+	sk_X509_pop_free(entry->chain, X509_free);
+	ASN1_STRING_free(entry->next_update);
+	os_free(entry);
+}
+
+
+static struct tls_verify_cache_entry *
+tls_verify_cache_get(struct tls_data *data, const u8 *hash)
+{
+	struct tls_verify_cache_entry *entry, *tmp;
+	struct os_reltime now;
+
+	os_get_reltime(&now);
+	dl_list_for_each_safe(entry, tmp, &data->verify_cache,
+			      struct tls_verify_cache_entry, list) {
+		if (os_reltime_before(&entry->expires, &now) ||
+		    (entry->next_update &&
+		     X509_cmp_current_time(entry->next_update) <= 0)) {
+			tls_verify_cache_free(entry);
+			continue;
+		}
+		if (os_memcmp(entry->hash, hash, SHA256_MAC_LEN) == 0) {
+			dl_list_del(&entry->list);
+			dl_list_add(&data->verify_cache, &entry->list);
+			return entry;
+		}
+	}
+
+	return NULL;
+}
+
+
+static struct tls_verify_cache_entry *
+tls_verify_cache_add(struct tls_data *data, const u8 *hash)
+{
+	struct tls_verify_cache_entry *entry;
+
+	entry = os_zalloc(sizeof(*entry));
+	if (!entry)
+		return NULL;
+	os_memcpy(entry->hash, hash, SHA256_MAC_LEN);
+	os_get_reltime(&entry->expires);
+	entry->expires.sec += TLS_VERIFY_CACHE_LIFETIME;
+
+	if (dl_list_len(&data->verify_cache) >= TLS_VERIFY_CACHE_SIZE)
+		tls_verify_cache_free(dl_list_last(&data->verify_cache,
+						   struct tls_verify_cache_entry,
+						   list));
+	dl_list_add(&data->verify_cache, &entry->list);
+	return entry;
+}
+
+
+static int tls_verify_cache_put_cert(struct wpabuf **buf, X509 *cert)
+{
+	int len;
+	u8 *pos;
+
+	len = i2d_X509(cert, NULL);
+	if (len <= 0 || wpabuf_resize(buf, len) < 0)
+		return -1;
+	pos = wpabuf_put(*buf, len);
+	i2d_X509(cert, &pos);
+	return 0;
+}
+
+
+static int tls_verify_cache_hash(struct wpabuf *buf, u8 *hash)
+{
+	const u8 *addr[1];
+	size_t len[1];
+
+	addr[0] = wpabuf_head(buf);
+	len[0] = wpabuf_len(buf);
+	return sha256_vector(1, addr, len, hash);
+}
+
+
 void * tls_init(const struct tls_config *conf)
 {
 	struct tls_data *data;
@@ -1136,6 +1398,7 @@ void * tls_init(const struct tls_config *conf)
 		return NULL;
 	}
 	data->ssl = ssl;
+	dl_list_init(&data->verify_cache);
 	if (conf) {
 		data->tls_session_lifetime = conf->tls_session_lifetime;
 		data->crl_reload_interval = conf->crl_reload_interval;
@@ -1165,7 +1428,14 @@ void * tls_init(const struct tls_config *conf)
 		SSL_CTX_set_session_id_context(ssl, (u8 *) "hostapd", 7);
 		SSL_CTX_set_session_cache_mode(ssl, SSL_SESS_CACHE_SERVER);
 		SSL_CTX_set_timeout(ssl, data->tls_session_lifetime);
+		if (conf && conf->tls_session_cache_size)
+			SSL_CTX_sess_set_cache_size(
+				ssl, conf->tls_session_cache_size);
 		SSL_CTX_sess_set_remove_cb(ssl, remove_session_cb);
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+		SSL_CTX_set_session_ticket_cb(ssl, tls_ticket_gen_cb,
+					      tls_ticket_dec_cb, NULL);
+#endif /* >= 3.0 */
 #if OPENSSL_VERSION_NUMBER >= 0x10101000L && \
 	!defined(LIBRESSL_VERSION_NUMBER) && \
 	!defined(OPENSSL_IS_BORINGSSL)
@@ -1226,6 +1496,7 @@ void tls_deinit(void *ssl_ctx)
 	SSL_CTX *ssl = data->ssl;
 	struct tls_context *context = SSL_CTX_get_app_data(ssl);
 	struct tls_session_data *sess_data;
+	struct tls_verify_cache_entry *entry;
 
 	if (data->tls_session_lifetime > 0) {
 		wpa_printf(MSG_DEBUG, "OpenSSL: Flush sessions");
@@ -1238,12 +1509,16 @@ void tls_deinit(void *ssl_ctx)
 			   "OpenSSL: Freeing not-flushed session data %p",
 			   sess_data->buf);
 		wpabuf_free(sess_data->buf);
-		dl_list_del(&sess_data->list);
-		os_free(sess_data);
+		del_session_data(context, sess_data);
 	}
+	while ((entry = dl_list_first(&data->verify_cache,
+				      struct tls_verify_cache_entry, list)))
+		tls_verify_cache_free(entry);
 	if (context != tls_global)
 		os_free(context);
 	os_free(data->ca_cert);
+	bin_clear_free(data->ticket_keys,
+		       data->num_ticket_keys * TLS_SESSION_TICKET_KEY_LEN);
 	SSL_CTX_free(ssl);
 
 	tls_openssl_ref_count--;
@@ -1827,6 +2102,8 @@ void tls_connection_deinit(void *ssl_ctx, struct tls_connection *conn)
 	os_free(conn->domain_match);
 	os_free(conn->check_cert_subject);
 	os_free(conn->session_ticket);
+	wpabuf_free(conn->ticket_data);
+	wpabuf_free(conn->resumed_ticket_data);
 	os_free(conn->peer_subject);
 	os_free(conn);
 }
@@ -2800,6 +3077,124 @@ static int tls_verify_cb(int preverify_ok, X509_STORE_CTX *x509_ctx)
 }
 
 
+#ifdef OPENSSL_VERIFY_CACHE
+
+static int tls_verify_chain_hash(struct tls_connection *conn,
+				 X509_STORE_CTX *x509_ctx, u8 *hash)
+{
+	STACK_OF(X509) *untrusted = X509_STORE_CTX_get0_untrusted(x509_ctx);
+	struct wpabuf *buf;
+	int i, ret = -1;
+
+	buf = wpabuf_alloc(5);
+	if (!buf)
+		return -1;
+	wpabuf_put_u8(buf, 'C');
+	wpabuf_put_be32(buf, conn->flags);
+	if (tls_verify_cache_put_cert(&buf,
+				      X509_STORE_CTX_get0_cert(x509_ctx)) < 0)
+		goto fail;
+	for (i = 0; i < sk_X509_num(untrusted); i++) {
+		if (tls_verify_cache_put_cert(&buf,
+					      sk_X509_value(untrusted, i)) < 0)
+			goto fail;
+	}
+	ret = tls_verify_cache_hash(buf, hash);
+fail:
+	wpabuf_free(buf);
+	return ret;
+}
+
+
+static int tls_verify_cached_chain(struct tls_connection *conn,
+				   X509_STORE_CTX *x509_ctx,
+				   STACK_OF(X509) *chain)
+{
+	X509 *cert, *issuer = NULL;
+	int depth, res;
+
+	/* The trust anchor of the cached chain needs to be in the current
+	 * certificate store and all certificates need to be still valid. */
+	cert = sk_X509_value(chain, sk_X509_num(chain) - 1);
+	if (X509_STORE_CTX_get1_issuer(&issuer, x509_ctx, cert) <= 0)
+		return -1;
+	res = X509_cmp(issuer, cert);
+	X509_free(issuer);
+	if (res)
+		return -1;
+	for (depth = 0; depth < sk_X509_num(chain) &&
+		     !(conn->flags & TLS_CONN_DISABLE_TIME_CHECKS); depth++) {
+		cert = sk_X509_value(chain, depth);
+		if (X509_cmp_current_time(X509_get0_notAfter(cert)) <= 0)
+			return -1;
+	}
+
+	wpa_printf(MSG_DEBUG,
+		   "OpenSSL: Use cached server certificate chain validation result");
+	X509_STORE_CTX_set0_verified_chain(x509_ctx, X509_chain_up_ref(chain));
+	for (depth = sk_X509_num(chain) - 1; depth >= 0; depth--) {
+		X509_STORE_CTX_set_current_cert(x509_ctx,
+						sk_X509_value(chain, depth));
+		X509_STORE_CTX_set_error_depth(x509_ctx, depth);
+		X509_STORE_CTX_set_error(x509_ctx, X509_V_OK);
+		if (!tls_verify_cb(1, x509_ctx)) {
+			X509_STORE_CTX_set_error(x509_ctx,
+						 X509_V_ERR_UNSPECIFIED);
+			return 0;
+		}
+	}
+
+	return 1;
+}
+
+
+/*
+ * Server certificate chain validation with a cache of the chains that have
+ * been validated successfully. On a match, the chain building and signature
+ * checks are skipped, but tls_verify_cb() is still called for each certificate
+ * so that the per-connection checks and certificate events are not affected.
+ */
+static int tls_cert_verify_cb(X509_STORE_CTX *x509_ctx, void *arg)
+{
+	SSL *ssl;
+	struct tls_connection *conn;
+	struct tls_verify_cache_entry *entry;
+	u8 hash[SHA256_MAC_LEN];
+	int res;
+
+	ssl = X509_STORE_CTX_get_ex_data(x509_ctx,
+					 SSL_get_ex_data_X509_STORE_CTX_idx());
+	conn = ssl ? SSL_get_app_data(ssl) : NULL;
+	if (!conn || conn->server || !conn->ca_cert_verify ||
+	    conn->cert_probe || conn->server_cert_only ||
+	    conn->data->check_crl ||
+	    tls_verify_chain_hash(conn, x509_ctx, hash) < 0)
+		return X509_verify_cert(x509_ctx);
+
+	entry = tls_verify_cache_get(conn->data, hash);
+	if (entry) {
+		res = tls_verify_cached_chain(conn, x509_ctx, entry->chain);
+		if (res >= 0)
+			return res;
+		tls_verify_cache_free(entry);
+	}
+
+	res = X509_verify_cert(x509_ctx);
+	if (res > 0) {
+		entry = tls_verify_cache_add(conn->data, hash);
+		if (entry) {
+			entry->chain = X509_STORE_CTX_get1_chain(x509_ctx);
+			if (!entry->chain || sk_X509_num(entry->chain) == 0)
+				tls_verify_cache_free(entry);
+		}
+	}
+
+	return res;
+}
+
+#endif /* OPENSSL_VERIFY_CACHE */
+
+
 #ifndef OPENSSL_NO_STDIO
 static int tls_load_ca_der(struct tls_data *data, const char *ca_cert)
 {
@@ -2855,6 +3250,9 @@ static int tls_connection_ca_cert(struct tls_data *data,
 
 	SSL_set_verify(conn->ssl, SSL_VERIFY_PEER, tls_verify_cb);
 	conn->ca_cert_verify = 1;
+#ifdef OPENSSL_VERIFY_CACHE
+	SSL_CTX_set_cert_verify_callback(ssl_ctx, tls_cert_verify_cb, NULL);
+#endif /* OPENSSL_VERIFY_CACHE */
 
 	if (ca_cert && os_strncmp(ca_cert, "probe://", 8) == 0) {
 		wpa_printf(MSG_DEBUG, "OpenSSL: Probe for server certificate "
@@ -5091,6 +5489,25 @@ static void ocsp_debug_print_resp(OCSP_RESPONSE *rsp)
 }
 
 
+static int tls_ocsp_resp_hash(struct tls_connection *conn,
+			      const u8 *resp, size_t resp_len, u8 *hash)
+{
+	struct wpabuf *buf;
+	int ret = -1;
+
+	buf = wpabuf_alloc(1 + resp_len);
+	if (!buf)
+		return -1;
+	wpabuf_put_u8(buf, 'O');
+	wpabuf_put_data(buf, resp, resp_len);
+	if (tls_verify_cache_put_cert(&buf, conn->peer_cert) == 0 &&
+	    tls_verify_cache_put_cert(&buf, conn->peer_issuer) == 0)
+		ret = tls_verify_cache_hash(buf, hash);
+	wpabuf_free(buf);
+	return ret;
+}
+
+
 static int ocsp_resp_cb(SSL *s, void *arg)
 {
 	struct tls_connection *conn = arg;
@@ -5102,6 +5519,9 @@ static int ocsp_resp_cb(SSL *s, void *arg)
 	ASN1_GENERALIZEDTIME *produced_at, *this_update, *next_update;
 	X509_STORE *store;
 	STACK_OF(X509) *certs = NULL;
+	struct tls_verify_cache_entry *entry;
+	u8 hash[SHA256_MAC_LEN];
+	int use_cache = 0;
 
 	len = SSL_get_tlsext_status_ocsp_resp(s, &p);
 	if (!p) {
@@ -5126,6 +5546,16 @@ static int ocsp_resp_cb(SSL *s, void *arg)
 
 	wpa_hexdump(MSG_DEBUG, "OpenSSL: OCSP response", p, len);
 
+	if (conn->peer_cert && conn->peer_issuer &&
+	    tls_ocsp_resp_hash(conn, p, len, hash) == 0) {
+		use_cache = 1;
+		if (tls_verify_cache_get(conn->data, hash)) {
+			wpa_printf(MSG_DEBUG,
+				   "OpenSSL: Use cached OCSP status for server certificate: good");
+			return 1;
+		}
+	}
+
 	rsp = d2i_OCSP_RESPONSE(NULL, &p, len);
 	if (!rsp) {
 		wpa_printf(MSG_INFO, "OpenSSL: Failed to parse OCSP response");
@@ -5251,6 +5681,17 @@ static int ocsp_resp_cb(SSL *s, void *arg)
 		return 0;
 	}
 
+	/* Only a good status with nextUpdate is cached and it expires at the
+	 * time indicated in nextUpdate. */
+	if (use_cache && status == V_OCSP_CERTSTATUS_GOOD && next_update) {
+		entry = tls_verify_cache_add(conn->data, hash);
+		if (entry) {
+			entry->next_update = ASN1_STRING_dup(next_update);
+			if (!entry->next_update)
+				tls_verify_cache_free(entry);
+		}
+	}
+
 	OCSP_BASICRESP_free(basic);
 	OCSP_RESPONSE_free(rsp);
 
@@ -5816,6 +6257,17 @@ int tls_global_set_params(void *tls_ctx,
 		SSL_CTX_clear_options(ssl_ctx, SSL_OP_NO_TICKET);
 #endif /*  SSL_OP_NO_TICKET */
 
+#ifdef SSL_OP_NO_TX_CERTIFICATE_COMPRESSION
+	/* Compress the certificate chain once instead of in each handshake
+	 * with a TLS 1.3 peer that negotiates certificate compression
+	 * (RFC 8879). This fails if OpenSSL was built without compression
+	 * algorithms in which case the chain is sent uncompressed. */
+	if (params->client_cert &&
+	    !SSL_CTX_compress_certs(ssl_ctx, 0))
+		wpa_printf(MSG_DEBUG,
+			   "OpenSSL: Certificate compression not available");
+#endif /* SSL_OP_NO_TX_CERTIFICATE_COMPRESSION */
+
 #ifdef HAVE_OCSP
 	SSL_CTX_set_tlsext_status_cb(ssl_ctx, ocsp_status_cb);
 	SSL_CTX_set_tlsext_status_arg(ssl_ctx, ssl_ctx);
@@ -5978,8 +6430,7 @@ void tls_connection_set_success_data(struct tls_connection *conn,
 			   "OpenSSL: Replacing old success data %p (sess %p)%s",
 			   old, sess, found ? "" : " (not freeing)");
 		if (found) {
-			dl_list_del(&found->list);
-			os_free(found);
+			del_session_data(conn->context, found);
 			wpabuf_free(old);
 		}
 	}
@@ -5990,7 +6441,7 @@ void tls_connection_set_success_data(struct tls_connection *conn,
 		goto fail;
 
 	sess_data->buf = data;
-	dl_list_add(&conn->context->sessions, &sess_data->list);
+	add_session_data(conn->context, sess_data);
 	wpa_printf(MSG_DEBUG, "OpenSSL: Stored success data %p (sess %p)",
 		   data, sess);
 	conn->success_data = 1;
@@ -6015,11 +6466,53 @@ const struct wpabuf *
 tls_connection_get_success_data(struct tls_connection *conn)
 {
 	SSL_SESSION *sess;
+	const struct wpabuf *buf;
 
 	if (tls_ex_idx_session < 0 ||
 	    !(sess = SSL_get_session(conn->ssl)))
 		return NULL;
-	return SSL_SESSION_get_ex_data(sess, tls_ex_idx_session);
+	buf = SSL_SESSION_get_ex_data(sess, tls_ex_idx_session);
+	if (!buf && SSL_session_reused(conn->ssl))
+		buf = conn->resumed_ticket_data;
+	return buf;
+}
+
+
+void tls_connection_set_ticket_data(struct tls_connection *conn,
+				    struct wpabuf *data)
+{
+	wpabuf_free(conn->ticket_data);
+	conn->ticket_data = data;
+}
+
+
+int tls_set_session_ticket_keys(void *tls_ctx, const u8 *keys,
+				size_t num_keys)
+{
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+	struct tls_data *data = tls_ctx;
+	u8 *copy = NULL;
+
+	if (num_keys) {
+		copy = os_memdup(keys, num_keys * TLS_SESSION_TICKET_KEY_LEN);
+		if (!copy)
+			return -1;
+	}
+
+	bin_clear_free(data->ticket_keys,
+		       data->num_ticket_keys * TLS_SESSION_TICKET_KEY_LEN);
+	data->ticket_keys = copy;
+	data->num_ticket_keys = num_keys;
+	SSL_CTX_set_tlsext_ticket_key_evp_cb(data->ssl, num_keys ?
+					     tls_ticket_key_cb : NULL);
+	wpa_printf(MSG_DEBUG, "OpenSSL: Configured %u session ticket key(s)",
+		   (unsigned int) num_keys);
+	return 0;
+#else /* >= 3.0 */
+	wpa_printf(MSG_INFO,
+		   "OpenSSL: Shared session ticket keys require OpenSSL 3.0 or newer");
+	return -1;
+#endif /* >= 3.0 */
 }
 
 
@@ -6040,6 +6533,24 @@ void tls_connection_remove_session(struct tls_connection *conn)
 }
 
 
+int tls_get_session_cache_stats(void *tls_ctx,
+				struct tls_session_cache_stats *stats)
+{
+	struct tls_data *data = tls_ctx;
+	SSL_CTX *ssl = data->ssl;
+
+	if (data->tls_session_lifetime == 0)
+		return -1;
+
+	stats->entries = SSL_CTX_sess_number(ssl);
+	stats->hits = SSL_CTX_sess_hits(ssl);
+	stats->misses = SSL_CTX_sess_misses(ssl);
+	stats->timeouts = SSL_CTX_sess_timeouts(ssl);
+	stats->evictions = SSL_CTX_sess_cache_full(ssl);
+	return 0;
+}
+
+
 int tls_get_tls_unique(struct tls_connection *conn, u8 *buf, size_t max_len)
 {
 	size_t len;
@@ -159,6 +159,13 @@ struct hostapd_channel_data {
 	 * need to set this)
 	 */
 	long double interference_factor;
+
+	/**
+	 * interference_model_valid - Whether interference_factor holds a
+	 * learned value that is kept between ACS runs (used internally in
+	 * src/ap/acs.c)
+	 */
+	bool interference_model_valid;
 #endif /* CONFIG_ACS */
 
 	/**
@@ -426,11 +433,13 @@ struct wpa_scan_res {
  * @res: Array of pointers to allocated variable length scan result entries
  * @num: Number of entries in the scan result array
  * @fetch_time: Time when the results were fetched from the driver
+ * @arena: Memory blocks holding entries allocated with wpa_scan_res_alloc()
  */
 struct wpa_scan_results {
 	struct wpa_scan_res **res;
 	size_t num;
 	struct os_reltime fetch_time;
+	struct wpa_scan_arena *arena;
 };
 
 /**
@@ -560,6 +569,17 @@ struct wpa_driver_scan_params {
 	 */
 	unsigned int only_new_results:1;
 
+	/**
+	 * filter_freqs - Report only results on the scanned frequencies
+	 *
+	 * This optional parameter can be used with freqs to request the driver
+	 * wrapper to filter scan results to include only BSSes on the
+	 * frequencies that were scanned. This reduces the work needed for
+	 * processing the results of partial scans when the driver maintains a
+	 * large cache of BSSes on other channels.
+	 */
+	unsigned int filter_freqs:1;
+
 	/**
 	 * low_priority - Requests driver to use a lower scan priority
 	 *
@@ -1524,6 +1544,15 @@ struct wpa_driver_ap_params {
 	 */
 	enum hide_ssid hide_ssid;
 
+	/**
+	 * probe_req_ssid_filter - Report only Probe Request frames for @ssid
+	 *
+	 * If set, Probe Request frames are needed only if their SSID element
+	 * is for @ssid or, when @hide_ssid is %NO_SSID_HIDING, for the
+	 * wildcard SSID. The driver may drop the other frames.
+	 */
+	bool probe_req_ssid_filter;
+
 	/**
 	 * pairwise_ciphers - WPA_CIPHER_* bitfield
 	 */
@@ -3685,6 +3714,23 @@ struct wpa_driver_ops {
 	int (*read_sta_data)(void *priv, struct hostap_sta_driver_data *data,
 			     const u8 *addr);
 
+	/**
+	 * read_all_sta_data - Fetch station data for all stations (AP only)
+	 * @priv: Private driver interface data
+	 * @cb: Callback function to be called for each station
+	 * @ctx: Context pointer for the callback
+	 * Returns: 0 on success, -1 on failure
+	 *
+	 * This is an optional bulk version of read_sta_data() that fetches the
+	 * information for all stations of the BSS with a single driver
+	 * request. The data passed to the callback is only valid for the
+	 * duration of the call.
+	 */
+	int (*read_all_sta_data)(void *priv,
+				 void (*cb)(void *ctx, const u8 *addr,
+					    struct hostap_sta_driver_data *data),
+				 void *ctx);
+
 	/**
 	 * tx_control_port - Send a frame over the 802.1X controlled port
 	 * @priv: Private driver interface data
@@ -6820,6 +6866,7 @@ union wpa_event_data {
 	 * @peer: Peer address
 	 * @ies: Beacon IEs
 	 * @ie_len: Length of @ies
+	 * @ssi_signal: Signal strength in dBm (or 0 if not available)
 	 *
 	 * Notification of new candidate mesh peer.
 	 */
@@ -6827,6 +6874,7 @@ union wpa_event_data {
 		const u8 *peer;
 		const u8 *ies;
 		size_t ie_len;
+		int ssi_signal;
 	} mesh_peer;
 
 	/**
@@ -7060,6 +7108,9 @@ static inline void drv_event_eapol_rx2(void *ctx, const u8 *src, const u8 *data,
 
 /* driver_common.c */
 void wpa_scan_results_free(struct wpa_scan_results *res);
+struct wpa_scan_res * wpa_scan_res_alloc(struct wpa_scan_results *res,
+					 size_t ie_len);
+void wpa_scan_res_free(struct wpa_scan_results *res, struct wpa_scan_res *r);
 
 /* Convert wpa_event_type to a string for logging */
 const char * event_to_string(enum wpa_event_type event);
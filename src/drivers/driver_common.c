@@ -10,16 +10,102 @@
 #include "utils/common.h"
 #include "driver.h"
 
+/* Size of the memory blocks that scan result entries are allocated from */
+#define WPA_SCAN_ARENA_BLOCK_SIZE 65536
+
+struct wpa_scan_arena {
+	struct wpa_scan_arena *next;
+	size_t used;
+	size_t size;
+	/* followed by size octets of entry data */
+};
+
+
+static bool wpa_scan_arena_owns(const struct wpa_scan_results *res,
+				const struct wpa_scan_res *r)
+{
+	const struct wpa_scan_arena *a;
+	const u8 *pos = (const u8 *) r;
+
+	for (a = res->arena; a; a = a->next) {
+		if (pos >= (const u8 *) (a + 1) &&
+		    pos < (const u8 *) (a + 1) + a->size)
+			return true;
+	}
+
+	return false;
+}
+
+
+/**
+ * wpa_scan_res_alloc - Allocate a scan result entry
+ * @res: Scan results that the entry is going to be added to
+ * @ie_len: Number of octets of IE data (ie_len + beacon_ie_len) following the
+ *	entry
+ * Returns: Pointer to a zeroed entry or %NULL on failure
+ *
+ * The entry is carved out of memory blocks owned by @res so that a scan
+ * result dump does not need a separate heap allocation for each BSS. The
+ * entry is released by wpa_scan_results_free() together with the rest of the
+ * results.
+ */
+struct wpa_scan_res * wpa_scan_res_alloc(struct wpa_scan_results *res,
+					 size_t ie_len)
+{
+	struct wpa_scan_arena *a = res->arena;
+	size_t len;
+	u8 *pos;
+
+	/* Keep the entries aligned for the u64 fields in struct wpa_scan_res */
+	len = (sizeof(struct wpa_scan_res) + ie_len + 7) & ~((size_t) 7);
+
+	if (!a || a->size - a->used < len) {
+		size_t size = len > WPA_SCAN_ARENA_BLOCK_SIZE ? len :
+			WPA_SCAN_ARENA_BLOCK_SIZE;
+
+		a = os_malloc(sizeof(*a) + size);
+		if (!a)
+			return NULL;
+		a->used = 0;
+		a->size = size;
+		a->next = res->arena;
+		res->arena = a;
+	}
+
+	pos = (u8 *) (a + 1) + a->used;
+	a->used += len;
+	os_memset(pos, 0, sizeof(struct wpa_scan_res) + ie_len);
+	return (struct wpa_scan_res *) pos;
+}
+
+
+/**
+ * wpa_scan_res_free - Free a scan result entry that is removed from results
+ * @res: Scan results that the entry belongs to
+ * @r: Entry allocated with os_malloc() or wpa_scan_res_alloc()
+ */
+void wpa_scan_res_free(struct wpa_scan_results *res, struct wpa_scan_res *r)
+{
+	if (r && !wpa_scan_arena_owns(res, r))
+		os_free(r);
+}
+
+
 void wpa_scan_results_free(struct wpa_scan_results *res)
 {
 	size_t i;
+	struct wpa_scan_arena *a, *next;
 
 	if (res == NULL)
 		return;
 
 	for (i = 0; i < res->num; i++)
-		os_free(res->res[i]);
+		wpa_scan_res_free(res, res->res[i]);
 	os_free(res->res);
+	for (a = res->arena; a; a = next) {
+		next = a->next;
+		os_free(a);
+	}
 	os_free(res);
 }
 
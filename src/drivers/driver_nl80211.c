@@ -493,6 +493,62 @@ out:
 }
 
 
+/* Return the nl80211 command of a message or -1 if it is for another family */
+static int nl80211_msg_cmd(struct nl80211_global *global, struct nl_msg *msg)
+{
+	struct nlmsghdr *hdr = nlmsg_hdr(msg);
+	struct genlmsghdr *gnlh;
+
+	if (hdr->nlmsg_type != global->nl80211_id ||
+	    hdr->nlmsg_len < NLMSG_HDRLEN + GENL_HDRLEN)
+		return -1;
+	gnlh = nlmsg_data(hdr);
+	if (gnlh->cmd > NL80211_CMD_MAX)
+		return -1;
+	return gnlh->cmd;
+}
+
+
+static void nl80211_cmd_stats_update(struct nl80211_global *global, int cmd,
+				     struct os_reltime *start, int err)
+{
+	struct nl80211_cmd_stats *stats;
+	struct os_reltime now, diff;
+	unsigned int usec;
+
+	if (cmd < 0)
+		return;
+	stats = &global->cmd_stats[cmd];
+
+	os_get_reltime(&now);
+	os_reltime_sub(&now, start, &diff);
+	usec = diff.sec * 1000000 + diff.usec;
+
+	stats->count++;
+	if (err < 0)
+		stats->failed++;
+	stats->total_usec += usec;
+	if (usec > stats->max_usec)
+		stats->max_usec = usec;
+}
+
+
+static void nl80211_set_ack_opts(struct nl_sock *nl_handle)
+{
+	int opt;
+
+	/* try to set NETLINK_EXT_ACK to 1, ignoring errors */
+	opt = 1;
+	setsockopt(nl_socket_get_fd(nl_handle), SOL_NETLINK,
+		   NETLINK_EXT_ACK, &opt, sizeof(opt));
+
+	/* try to set NETLINK_CAP_ACK to 1, ignoring errors */
+	opt = 1;
+	setsockopt(nl_socket_get_fd(nl_handle), SOL_NETLINK,
+		   NETLINK_CAP_ACK, &opt, sizeof(opt));
+}
+
+
 int send_and_recv(struct nl80211_global *global,
 		  struct nl_sock *nl_handle, struct nl_msg *msg,
 		  int (*valid_handler)(struct nl_msg *, void *),
@@ -503,28 +559,41 @@ int send_and_recv(struct nl80211_global *global,
 {
 	struct nl_cb *cb, *s_nl_cb;
 	struct nl80211_ack_err_args err;
-	int opt;
+	struct os_reltime start;
+	int cmd;
 
 	if (!msg)
 		return -ENOMEM;
 
 	err.err = -ENOMEM;
 
-	s_nl_cb = nl_socket_get_cb(nl_handle);
-	cb = nl_cb_clone(s_nl_cb);
-	nl_cb_put(s_nl_cb);
-	if (!cb)
-		goto out;
+	if (nl_handle == global->nl && global->nl_cmd_cb &&
+	    !global->nl_cmd_cb_busy) {
+		/* The handlers that differ between commands are all set
+		 * below, so one clone of the socket callbacks can be reused.
+		 * A nested call from one of the handlers uses a temporary
+		 * clone. */
+		cb = global->nl_cmd_cb;
+		global->nl_cmd_cb_busy = true;
+		if (!valid_handler)
+			nl_cb_set(cb, NL_CB_VALID, NL_CB_CUSTOM,
+				  process_global_event, global);
+	} else {
+		s_nl_cb = nl_socket_get_cb(nl_handle);
+		cb = nl_cb_clone(s_nl_cb);
+		nl_cb_put(s_nl_cb);
+		if (!cb)
+			goto out;
+	}
 
-	/* try to set NETLINK_EXT_ACK to 1, ignoring errors */
-	opt = 1;
-	setsockopt(nl_socket_get_fd(nl_handle), SOL_NETLINK,
-		   NETLINK_EXT_ACK, &opt, sizeof(opt));
+	if (nl_handle != global->nl || !global->nl_ack_opts_set) {
+		nl80211_set_ack_opts(nl_handle);
+		if (nl_handle == global->nl)
+			global->nl_ack_opts_set = true;
+	}
 
-	/* try to set NETLINK_CAP_ACK to 1, ignoring errors */
-	opt = 1;
-	setsockopt(nl_socket_get_fd(nl_handle), SOL_NETLINK,
-		   NETLINK_CAP_ACK, &opt, sizeof(opt));
+	cmd = nl80211_msg_cmd(global, msg);
+	os_get_reltime(&start);
 
 	err.err = nl_send_auto_complete(nl_handle, msg);
 	if (err.err < 0) {
@@ -580,8 +649,12 @@ int send_and_recv(struct nl80211_global *global,
 				   __func__, res, nl_geterror(res));
 		}
 	}
+	nl80211_cmd_stats_update(global, cmd, &start, err.err);
  out:
-	nl_cb_put(cb);
+	if (cb && cb == global->nl_cmd_cb)
+		global->nl_cmd_cb_busy = false;
+	else
+		nl_cb_put(cb);
 	/* Always clear the message as it can potentially contain keys */
 	nl80211_nlmsg_clear(msg);
 	nlmsg_free(msg);
@@ -589,6 +662,222 @@ int send_and_recv(struct nl80211_global *global,
 }
 
 
+struct nl80211_async_cmd {
+	struct dl_list list;
+	u32 seq;
+	int cmd;
+	struct os_reltime sent;
+	void (*done)(void *ctx, int err);
+	void *ctx;
+};
+
+
+static void nl80211_async_done(struct nl80211_global *global, u32 seq,
+			       int err)
+{
+	struct nl80211_async_cmd *cmd;
+
+	dl_list_for_each(cmd, &global->async_pending,
+			 struct nl80211_async_cmd, list) {
+		if (cmd->seq != seq)
+			continue;
+		dl_list_del(&cmd->list);
+		nl80211_cmd_stats_update(global, cmd->cmd, &cmd->sent, err);
+		if (cmd->done)
+			cmd->done(cmd->ctx, err);
+		os_free(cmd);
+		return;
+	}
+
+	wpa_printf(MSG_DEBUG,
+		   "nl80211: Ignore completion for unknown async command seq=%u",
+		   seq);
+}
+
+
+static int nl80211_async_ack_handler(struct nl_msg *msg, void *arg)
+{
+	nl80211_async_done(arg, nlmsg_hdr(msg)->nlmsg_seq, 0);
+	return NL_OK;
+}
+
+
+static int nl80211_async_error_handler(struct sockaddr_nl *nla,
+				       struct nlmsgerr *err, void *arg)
+{
+	nl80211_async_done(arg, err->msg.nlmsg_seq, err->error);
+	return NL_SKIP;
+}
+
+
+static void nl80211_async_receive(int sock, void *eloop_ctx, void *handle)
+{
+	struct nl80211_global *global = eloop_ctx;
+	struct nl80211_async_cmd *cmd, *tmp;
+	int res;
+
+	res = nl_recvmsgs(handle, global->nl_async_cb);
+	if (res == -NLE_NOMEM) {
+		/* The socket receive buffer overflowed, so some of the
+		 * completions were lost. Do not wait for them forever. */
+		wpa_printf(MSG_INFO,
+			   "nl80211: Lost async command completions - drop %u pending commands",
+			   dl_list_len(&global->async_pending));
+		dl_list_for_each_safe(cmd, tmp, &global->async_pending,
+				      struct nl80211_async_cmd, list) {
+			dl_list_del(&cmd->list);
+			if (cmd->done)
+				cmd->done(cmd->ctx, -ENOBUFS);
+			os_free(cmd);
+		}
+	} else if (res < 0 && res != -NLE_AGAIN) {
+		wpa_printf(MSG_INFO, "nl80211: %s->nl_recvmsgs failed: %d",
+			   __func__, res);
+	}
+}
+
+
+static int nl80211_init_async(struct nl80211_global *global)
+{
+	int opt;
+
+	dl_list_init(&global->async_pending);
+
+	global->nl_async_cb = nl_cb_alloc(NL_CB_DEFAULT);
+	if (!global->nl_async_cb)
+		return -1;
+	nl_cb_set(global->nl_async_cb, NL_CB_SEQ_CHECK, NL_CB_CUSTOM,
+		  no_seq_check, NULL);
+	nl_cb_set(global->nl_async_cb, NL_CB_ACK, NL_CB_CUSTOM,
+		  nl80211_async_ack_handler, global);
+	nl_cb_err(global->nl_async_cb, NL_CB_CUSTOM,
+		  nl80211_async_error_handler, global);
+
+	global->nl_async = nl_create_handle(global->nl_async_cb, "async");
+	if (!global->nl_async) {
+		nl_cb_put(global->nl_async_cb);
+		global->nl_async_cb = NULL;
+		return -1;
+	}
+
+	/* Do not get the full request, potentially with keys, echoed back
+	 * in error reports */
+	opt = 1;
+	setsockopt(nl_socket_get_fd(global->nl_async), SOL_NETLINK,
+		   NETLINK_CAP_ACK, &opt, sizeof(opt));
+
+	nl80211_register_eloop_read(&global->nl_async, nl80211_async_receive,
+				    global, 1);
+	return 0;
+}
+
+
+static void nl80211_deinit_async(struct nl80211_global *global)
+{
+	struct nl80211_async_cmd *cmd, *tmp;
+
+	if (global->nl_async)
+		nl80211_destroy_eloop_handle(&global->nl_async, 1);
+	nl_cb_put(global->nl_async_cb);
+	global->nl_async_cb = NULL;
+
+	if (!global->async_pending.next)
+		return;
+	dl_list_for_each_safe(cmd, tmp, &global->async_pending,
+			      struct nl80211_async_cmd, list) {
+		dl_list_del(&cmd->list);
+		os_free(cmd);
+	}
+}
+
+
+/**
+ * nl80211_send_async - Send an nl80211 command without waiting for the ACK
+ * @global: nl80211 global data
+ * @msg: Command to send; this is freed by the function
+ * @done: Callback for the result (0 or -errno) of the command or %NULL
+ * @ctx: Context for @done; see nl80211_async_cancel()
+ * Returns: 0 if the command was sent or -errno on failure
+ *
+ * This can be used for commands that do not return any data and for which the
+ * caller would only log a failure. The kernel processes generic netlink
+ * requests at the time they are sent, so the commands remain ordered with the
+ * ones sent with send_and_recv(). The ACKs are processed from eloop, which
+ * allows a burst of commands to be sent without a round-trip for each one.
+ * If the async socket is not available, the command is sent with
+ * send_and_recv() and @done is called before returning.
+ */
+int nl80211_send_async(struct nl80211_global *global, struct nl_msg *msg,
+		       void (*done)(void *ctx, int err), void *ctx)
+{
+	struct nl80211_async_cmd *cmd;
+	int res;
+
+	if (!msg)
+		return -ENOMEM;
+
+	if (!global->nl_async) {
+		res = send_and_recv(global, global->nl, msg, NULL, NULL,
+				    NULL, NULL, NULL);
+		if (done)
+			done(ctx, res);
+		return 0;
+	}
+
+	cmd = os_zalloc(sizeof(*cmd));
+	if (!cmd) {
+		res = -ENOMEM;
+		goto out;
+	}
+	cmd->cmd = nl80211_msg_cmd(global, msg);
+	os_get_reltime(&cmd->sent);
+
+	res = nl_send_auto_complete(global->nl_async, msg);
+	if (res < 0) {
+		wpa_printf(MSG_INFO,
+			   "nl80211: nl_send_auto_complete() failed: %s",
+			   nl_geterror(res));
+		os_free(cmd);
+		res = -EBADF;
+		goto out;
+	}
+	res = 0;
+
+	cmd->seq = nlmsg_hdr(msg)->nlmsg_seq;
+	cmd->done = done;
+	cmd->ctx = ctx;
+	dl_list_add_tail(&global->async_pending, &cmd->list);
+
+out:
+	/* Always clear the message as it can potentially contain keys */
+	nl80211_nlmsg_clear(msg);
+	nlmsg_free(msg);
+	return res;
+}
+
+
+/**
+ * nl80211_async_cancel - Stop waiting for async commands of a context
+ * @global: nl80211 global data
+ * @ctx: Context that was passed to nl80211_send_async()
+ *
+ * The completion callbacks of the pending commands for @ctx will not be called.
+ * This needs to be called before @ctx is freed.
+ */
+void nl80211_async_cancel(struct nl80211_global *global, void *ctx)
+{
+	struct nl80211_async_cmd *cmd;
+
+	if (!global->async_pending.next)
+		return;
+	dl_list_for_each(cmd, &global->async_pending,
+			 struct nl80211_async_cmd, list) {
+		if (cmd->ctx == ctx)
+			cmd->done = NULL;
+	}
+}
+
+
 static int nl80211_put_control_port(struct wpa_driver_nl80211_data *drv,
 				    struct nl_msg *msg)
 {
@@ -2052,6 +2341,14 @@ static int wpa_driver_nl80211_init_nl_global(struct nl80211_global *global)
 				    wpa_driver_nl80211_event_receive,
 				    global->nl_cb, 0);
 
+	/* Created after the socket callbacks are complete, see
+	 * send_and_recv() */
+	global->nl_cmd_cb = nl_cb_clone(global->nl_cb);
+
+	if (nl80211_init_async(global) < 0)
+		wpa_printf(MSG_DEBUG,
+			   "nl80211: Could not create async command socket - use synchronous commands");
+
 	return 0;
 
 err:
@@ -2129,11 +2426,12 @@ static void wpa_driver_nl80211_rfkill_unblocked(void *ctx)
 }
 
 
-static void wpa_driver_nl80211_handle_eapol_tx_status(int sock,
-						      void *eloop_ctx,
-						      void *handle)
+/* Maximum number of TX status reports to process per socket wakeup */
+#define NL80211_EAPOL_TX_STATUS_BATCH 16
+
+static int nl80211_read_eapol_tx_status(struct wpa_driver_nl80211_data *drv,
+					int sock)
 {
-	struct wpa_driver_nl80211_data *drv = eloop_ctx;
 	u8 data[2048];
 	struct msghdr msg;
 	struct iovec entry;
@@ -2150,10 +2448,12 @@ static void wpa_driver_nl80211_handle_eapol_tx_status(int sock,
 	msg.msg_control = &control;
 	msg.msg_controllen = sizeof(control);
 
-	res = recvmsg(sock, &msg, MSG_ERRQUEUE);
-	/* if error or not fitting 802.3 header, return */
+	res = recvmsg(sock, &msg, MSG_ERRQUEUE | MSG_DONTWAIT);
+	if (res < 0)
+		return -1;
+	/* if not fitting 802.3 header, skip */
 	if (res < 14)
-		return;
+		return 0;
 
 	for (cmsg = CMSG_FIRSTHDR(&msg); cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg))
 	{
@@ -2177,7 +2477,7 @@ static void wpa_driver_nl80211_handle_eapol_tx_status(int sock,
 	}
 
 	if (!found_ee || !found_wifi)
-		return;
+		return 0;
 
 	memset(&event, 0, sizeof(event));
 	event.eapol_tx_status.dst = data;
@@ -2185,6 +2485,23 @@ static void wpa_driver_nl80211_handle_eapol_tx_status(int sock,
 	event.eapol_tx_status.data_len = res - 14;
 	event.eapol_tx_status.ack = acked;
 	wpa_supplicant_event(drv->ctx, EVENT_EAPOL_TX_STATUS, &event);
+	return 0;
+}
+
+
+static void wpa_driver_nl80211_handle_eapol_tx_status(int sock,
+						      void *eloop_ctx,
+						      void *handle)
+{
+	struct wpa_driver_nl80211_data *drv = eloop_ctx;
+	int i;
+
+	/* Drain the reports that have queued up for a burst of EAPOL frames,
+	 * e.g., group key updates, in one go. */
+	for (i = 0; i < NL80211_EAPOL_TX_STATUS_BATCH; i++) {
+		if (nl80211_read_eapol_tx_status(drv, sock) < 0)
+			break;
+	}
 }
 
 
@@ -2226,6 +2543,18 @@ static int nl80211_init_bss(struct i802_bss *bss)
 
 static void nl80211_destroy_bss(struct i802_bss *bss)
 {
+	struct nl80211_global *global = bss->drv->global;
+	unsigned int i;
+
+	nl80211_async_cancel(global, bss);
+
+	if (global) {
+		for (i = 0; i < NL80211_EVENT_BSS_CACHE_SIZE; i++) {
+			if (global->event_bss[i] == bss)
+				global->event_bss[i] = NULL;
+		}
+	}
+
 	nl_cb_put(bss->nl_cb);
 	bss->nl_cb = NULL;
 
@@ -2476,11 +2805,55 @@ static int nl80211_alloc_mgmt_handle(struct i802_bss *bss)
 }
 
 
+/* Maximum number of reads from nl_mgmt for a single wakeup */
+#define NL80211_MGMT_RX_BATCH 32
+
+static void nl80211_mgmt_receive(int sock, void *eloop_ctx, void *handle)
+{
+	struct i802_bss *bss = eloop_ctx;
+	struct nl80211_global *global = bss->drv->global;
+	unsigned int n;
+	int res;
+
+	/*
+	 * Drain the queued frames without going through eloop for each one,
+	 * e.g., during a Probe Request flood. The limit keeps the other
+	 * sockets served.
+	 */
+	bss->mgmt_rx_wakeups++;
+	global->mgmt_rx_bss = bss;
+	for (n = 0; n < NL80211_MGMT_RX_BATCH; n++) {
+		res = nl_recvmsgs(handle, bss->nl_cb);
+		if (global->mgmt_rx_bss != bss)
+			return; /* handle closed while processing the frame */
+		if (res == -NLE_NOMEM) {
+			/* ENOBUFS: the receive buffer overflowed */
+			bss->mgmt_rx_overflows++;
+			wpa_printf(MSG_INFO,
+				   "nl80211: Management frames dropped on %s due to socket buffer overflow (%u times)",
+				   bss->ifname, bss->mgmt_rx_overflows);
+			continue;
+		}
+		if (res < 0) {
+			if (res != -NLE_AGAIN)
+				wpa_printf(MSG_INFO,
+					   "nl80211: %s->nl_recvmsgs failed: %d",
+					   __func__, res);
+			break;
+		}
+		bss->mgmt_rx_reads++;
+	}
+	global->mgmt_rx_bss = NULL;
+
+	if (n > bss->mgmt_rx_max_batch)
+		bss->mgmt_rx_max_batch = n;
+}
+
+
 static void nl80211_mgmt_handle_register_eloop(struct i802_bss *bss)
 {
-	nl80211_register_eloop_read(&bss->nl_mgmt,
-				    wpa_driver_nl80211_event_receive,
-				    bss->nl_cb, 0);
+	nl80211_register_eloop_read(&bss->nl_mgmt, nl80211_mgmt_receive,
+				    bss, 0);
 }
 
 
@@ -2611,6 +2984,14 @@ static int nl80211_mgmt_subscribe_non_ap(struct i802_bss *bss)
 	if (nl80211_register_action_frame(bss, (u8 *) "\x12", 1) < 0)
 		ret = -1;
 #endif /* CONFIG_FST */
+#ifdef CONFIG_TESTING_OPTIONS
+	/* TWT Setup */
+	if (nl80211_register_action_frame(bss, (u8 *) "\x17\x06", 2) < 0)
+		ret = -1;
+	/* TWT Teardown */
+	if (nl80211_register_action_frame(bss, (u8 *) "\x17\x07", 2) < 0)
+		ret = -1;
+#endif /* CONFIG_TESTING_OPTIONS */
 
 	/* FT Action frames */
 	if (nl80211_register_action_frame(bss, (u8 *) "\x06", 1) < 0)
@@ -2782,6 +3163,29 @@ static int nl80211_action_subscribe_ap(struct i802_bss *bss)
 }
 
 
+static int nl80211_register_probe_req(struct i802_bss *bss)
+{
+	u16 type = (WLAN_FC_TYPE_MGMT << 2) | (WLAN_FC_STYPE_PROBE_REQ << 4);
+	u8 match[2 + SSID_MAX_LEN];
+
+	if (!bss->probe_req_ssid_len)
+		return nl80211_register_frame(bss, bss->nl_mgmt, type,
+					      NULL, 0, false);
+
+	/* The SSID element is the first element in the frame body, so the
+	 * kernel can drop the frames for other SSIDs based on the match */
+	if (bss->probe_req_wildcard &&
+	    nl80211_register_frame(bss, bss->nl_mgmt, type,
+				   (u8 *) "\x00\x00", 2, false) < 0)
+		return -1;
+	match[0] = WLAN_EID_SSID;
+	match[1] = bss->probe_req_ssid_len;
+	os_memcpy(&match[2], bss->probe_req_ssid, bss->probe_req_ssid_len);
+	return nl80211_register_frame(bss, bss->nl_mgmt, type, match,
+				      2 + bss->probe_req_ssid_len, false);
+}
+
+
 static int nl80211_mgmt_subscribe_ap(struct i802_bss *bss)
 {
 	static const int stypes[] = {
@@ -2790,7 +3194,6 @@ static int nl80211_mgmt_subscribe_ap(struct i802_bss *bss)
 		WLAN_FC_STYPE_REASSOC_REQ,
 		WLAN_FC_STYPE_DISASSOC,
 		WLAN_FC_STYPE_DEAUTH,
-		WLAN_FC_STYPE_PROBE_REQ,
 /* Beacon doesn't work as mac80211 doesn't currently allow
  * it, but it wouldn't really be the right thing anyway as
  * it isn't per interface ... maybe just dump the scan
@@ -2814,6 +3217,9 @@ static int nl80211_mgmt_subscribe_ap(struct i802_bss *bss)
 		}
 	}
 
+	if (nl80211_register_probe_req(bss) < 0)
+		goto out_err;
+
 	if (nl80211_action_subscribe_ap(bss))
 		goto out_err;
 
@@ -2864,6 +3270,8 @@ static void nl80211_mgmt_unsubscribe(struct i802_bss *bss, const char *reason)
 		return;
 	wpa_printf(MSG_DEBUG, "nl80211: Unsubscribe mgmt frames handle %p "
 		   "(%s)", bss->nl_mgmt, reason);
+	if (bss->drv->global->mgmt_rx_bss == bss)
+		bss->drv->global->mgmt_rx_bss = NULL;
 	nl80211_destroy_eloop_handle(&bss->nl_mgmt, 0);
 
 	nl80211_put_wiphy_data_ap(bss);
@@ -3228,6 +3636,7 @@ static void wpa_driver_nl80211_deinit(struct i802_bss *bss)
 	nl80211_destroy_bss(drv->first_bss);
 
 	os_free(drv->filter_ssids);
+	os_free(drv->filter_freqs);
 
 	os_free(drv->auth_ie);
 	os_free(drv->auth_data);
@@ -5126,6 +5535,47 @@ static int nl80211_put_freq_params(struct nl_msg *msg,
 }
 
 
+static void nl80211_set_probe_req_filter(struct i802_bss *bss,
+					 struct wpa_driver_ap_params *params)
+{
+	struct wpa_driver_nl80211_data *drv = bss->drv;
+	u8 ssid_len = 0;
+	bool wildcard = false;
+
+	if (drv->device_ap_sme || drv->use_monitor || !bss->nl_mgmt)
+		return;
+
+	if (params->probe_req_ssid_filter && params->ssid_len &&
+	    params->ssid_len <= SSID_MAX_LEN) {
+		ssid_len = params->ssid_len;
+		wildcard = params->hide_ssid == NO_SSID_HIDING;
+	}
+
+	if (ssid_len == bss->probe_req_ssid_len &&
+	    (!ssid_len ||
+	     (wildcard == bss->probe_req_wildcard &&
+	      os_memcmp(params->ssid, bss->probe_req_ssid, ssid_len) == 0)))
+		return;
+
+	wpa_printf(MSG_DEBUG, "nl80211: %s Probe Request SSID filter on %s%s",
+		   ssid_len ? "Enable" : "Disable", bss->ifname,
+		   ssid_len && !wildcard ? " (no wildcard SSID)" : "");
+	bss->probe_req_ssid_len = ssid_len;
+	bss->probe_req_wildcard = wildcard;
+	os_memcpy(bss->probe_req_ssid, params->ssid, ssid_len);
+
+	/* Frame registrations cannot be removed individually, so replace the
+	 * handle and register for all the AP frames again */
+	if (drv->global->mgmt_rx_bss == bss)
+		drv->global->mgmt_rx_bss = NULL;
+	nl80211_destroy_eloop_handle(&bss->nl_mgmt, 0);
+	if (nl80211_mgmt_subscribe_ap(bss))
+		wpa_printf(MSG_ERROR,
+			   "nl80211: Failed to subscribe to mgmt frames on %s",
+			   bss->ifname);
+}
+
+
 static int wpa_driver_nl80211_set_ap(void *priv,
 				     struct wpa_driver_ap_params *params)
 {
@@ -5520,6 +5970,7 @@ static int wpa_driver_nl80211_set_ap(void *priv,
 				NL80211_DRV_LINK_ID_NA);
 		nl80211_set_multicast_to_unicast(bss,
 						 params->multicast_to_unicast);
+		nl80211_set_probe_req_filter(bss, params);
 		if (beacon_set && params->freq &&
 		    params->freq->bandwidth != link->bandwidth) {
 			wpa_printf(MSG_DEBUG,
@@ -6323,6 +6774,43 @@ static void nl80211_teardown_ap(struct i802_bss *bss)
 }
 
 
+static void nl80211_eapol_tx_add(struct wpa_driver_nl80211_data *drv,
+				 const u8 *addr, u64 cookie, int link_id)
+{
+	unsigned int i;
+
+	/* Only the latest frame to a STA is of interest for the TX status, so
+	 * replace the previous entry of the STA, if any. */
+	for (i = 0; i < MAX_EAPOL_TX_COOKIES; i++) {
+		if (drv->eapol_tx[i].cookie &&
+		    ether_addr_equal(drv->eapol_tx[i].addr, addr))
+			break;
+	}
+	if (i == MAX_EAPOL_TX_COOKIES) {
+		i = drv->eapol_tx_next;
+		drv->eapol_tx_next = (i + 1) % MAX_EAPOL_TX_COOKIES;
+	}
+
+	drv->eapol_tx[i].cookie = cookie;
+	os_memcpy(drv->eapol_tx[i].addr, addr, ETH_ALEN);
+	drv->eapol_tx[i].link_id = link_id;
+}
+
+
+int nl80211_eapol_tx_find(struct wpa_driver_nl80211_data *drv, u64 cookie)
+{
+	int i;
+
+	if (!cookie)
+		return -1;
+	for (i = 0; i < MAX_EAPOL_TX_COOKIES; i++) {
+		if (drv->eapol_tx[i].cookie == cookie)
+			return i;
+	}
+	return -1;
+}
+
+
 static int nl80211_tx_control_port(void *priv, const u8 *dest,
 				   u16 proto, const u8 *buf, size_t len,
 				   int no_encrypt, int link_id)
@@ -6365,8 +6853,7 @@ static int nl80211_tx_control_port(void *priv, const u8 *dest,
 		wpa_printf(MSG_DEBUG,
 			   "nl80211: tx_control_port cookie=0x%llx",
 			   (long long unsigned int) cookie);
-		drv->eapol_tx_cookie = cookie;
-		drv->eapol_tx_link_id = link_id;
+		nl80211_eapol_tx_add(drv, dest, cookie, link_id);
 	}
 
 	return ret;
@@ -6476,6 +6963,17 @@ static int wpa_driver_nl80211_hapd_send_eapol(
 }
 
 
+static void nl80211_sta_set_flags_done(void *ctx, int err)
+{
+	struct i802_bss *bss = ctx;
+
+	if (err)
+		wpa_printf(err == -ENOENT ? MSG_DEBUG : MSG_INFO,
+			   "nl80211: Set STA flags failed - ifname=%s: %d (%s)",
+			   bss->ifname, err, strerror(-err));
+}
+
+
 static int wpa_driver_nl80211_sta_set_flags(void *priv, const u8 *addr,
 					    unsigned int total_flags,
 					    unsigned int flags_or,
@@ -6521,7 +7019,9 @@ static int wpa_driver_nl80211_sta_set_flags(void *priv, const u8 *addr,
 	if (nla_put(msg, NL80211_ATTR_STA_FLAGS2, sizeof(upd), &upd))
 		goto fail;
 
-	return send_and_recv_cmd(bss->drv, msg);
+	/* The callers only log failures, so do not wait for the result */
+	return nl80211_send_async(bss->drv->global, msg,
+				  nl80211_sta_set_flags_done, bss);
 fail:
 	nlmsg_free(msg);
 	return -ENOBUFS;
@@ -8325,6 +8825,53 @@ static int i802_read_sta_data(struct i802_bss *bss,
 }
 
 
+struct nl80211_sta_dump_arg {
+	void (*cb)(void *ctx, const u8 *addr,
+		   struct hostap_sta_driver_data *data);
+	void *ctx;
+};
+
+
+static int get_sta_dump_handler(struct nl_msg *msg, void *arg)
+{
+	struct nl80211_sta_dump_arg *dump = arg;
+	struct nlattr *tb[NL80211_ATTR_MAX + 1];
+	struct genlmsghdr *gnlh = nlmsg_data(nlmsg_hdr(msg));
+	struct hostap_sta_driver_data data;
+
+	nla_parse(tb, NL80211_ATTR_MAX, genlmsg_attrdata(gnlh, 0),
+		  genlmsg_attrlen(gnlh, 0), NULL);
+	if (!tb[NL80211_ATTR_MAC] ||
+	    nla_len(tb[NL80211_ATTR_MAC]) != ETH_ALEN)
+		return NL_SKIP;
+
+	os_memset(&data, 0, sizeof(data));
+	get_sta_handler(msg, &data);
+	dump->cb(dump->ctx, nla_data(tb[NL80211_ATTR_MAC]), &data);
+
+	return NL_SKIP;
+}
+
+
+static int i802_read_all_sta_data(void *priv,
+				  void (*cb)(void *ctx, const u8 *addr,
+					     struct hostap_sta_driver_data *data),
+				  void *ctx)
+{
+	struct i802_bss *bss = priv;
+	struct nl80211_sta_dump_arg dump;
+	struct nl_msg *msg;
+
+	msg = nl80211_bss_msg(bss, NLM_F_DUMP, NL80211_CMD_GET_STATION);
+	if (!msg)
+		return -ENOBUFS;
+
+	dump.cb = cb;
+	dump.ctx = ctx;
+	return send_and_recv_resp(bss->drv, msg, get_sta_dump_handler, &dump);
+}
+
+
 static int i802_set_tx_queue_params(void *priv, int queue, int aifs,
 				    int cw_min, int cw_max, int burst_time,
 				    int link_id)
@@ -10150,6 +10697,7 @@ static void * nl80211_global_init(void *ctx)
 	global->ctx = ctx;
 	global->ioctl_sock = -1;
 	dl_list_init(&global->interfaces);
+	dl_list_init(&global->wiphy_caps);
 	global->if_add_ifindex = -1;
 
 	cfg = os_zalloc(sizeof(*cfg));
@@ -10202,6 +10750,10 @@ static void nl80211_global_deinit(void *priv)
 	if (global->nl_event)
 		nl80211_destroy_eloop_handle(&global->nl_event, 0);
 
+	nl80211_deinit_async(global);
+	nl80211_wiphy_cache_flush(global, -1);
+
+	nl_cb_put(global->nl_cmd_cb);
 	nl_cb_put(global->nl_cb);
 
 	if (global->ioctl_sock >= 0)
@@ -11211,7 +11763,7 @@ static int wpa_driver_nl80211_status(void *priv, char *buf, size_t buflen)
 {
 	struct i802_bss *bss = priv;
 	struct wpa_driver_nl80211_data *drv = bss->drv;
-	int res;
+	int res, i;
 	char *pos, *end;
 	struct nl_msg *msg;
 	char alpha2[3] = { 0, 0, 0 };
@@ -11242,6 +11794,17 @@ static int wpa_driver_nl80211_status(void *priv, char *buf, size_t buflen)
 		return pos - buf;
 	pos += res;
 
+	res = os_snprintf(pos, end - pos,
+			  "mgmt_rx_wakeups=%u\n"
+			  "mgmt_rx_reads=%u\n"
+			  "mgmt_rx_max_batch=%u\n"
+			  "mgmt_rx_overflows=%u\n",
+			  bss->mgmt_rx_wakeups, bss->mgmt_rx_reads,
+			  bss->mgmt_rx_max_batch, bss->mgmt_rx_overflows);
+	if (os_snprintf_error(end - pos, res))
+		return pos - buf;
+	pos += res;
+
 	if (bss->wdev_id_set) {
 		res = os_snprintf(pos, end - pos, "wdev_id=%llu\n",
 				  (unsigned long long) bss->wdev_id);
@@ -11421,6 +11984,24 @@ static int wpa_driver_nl80211_status(void *priv, char *buf, size_t buflen)
 		nlmsg_free(msg);
 	}
 
+	for (i = 0; i <= NL80211_CMD_MAX; i++) {
+		struct nl80211_cmd_stats *stats = &drv->global->cmd_stats[i];
+
+		if (!stats->count)
+			continue;
+		/* Skip the NL80211_CMD_ prefix */
+		res = os_snprintf(pos, end - pos,
+				  "cmd.%s=%u failed=%u avg_usec=%u max_usec=%u\n",
+				  nl80211_command_to_string(i) + 12,
+				  stats->count, stats->failed,
+				  (unsigned int) (stats->total_usec /
+						  stats->count),
+				  stats->max_usec);
+		if (os_snprintf_error(end - pos, res))
+			return pos - buf;
+		pos += res;
+	}
+
 	return pos - buf;
 }
 
@@ -14686,6 +15267,7 @@ const struct wpa_driver_ops wpa_driver_nl80211_ops = {
 	.sta_deauth = i802_sta_deauth,
 	.sta_disassoc = i802_sta_disassoc,
 	.read_sta_data = driver_nl80211_read_sta_data,
+	.read_all_sta_data = i802_read_all_sta_data,
 	.set_freq = i802_set_freq,
 	.send_action = driver_nl80211_send_action,
 	.send_action_cancel_wait = wpa_driver_nl80211_send_action_cancel_wait,
@@ -22,6 +22,13 @@
 	nla_nest_start(msg, NLA_F_NESTED | (attrtype))
 #endif
 
+struct nl80211_cmd_stats {
+	unsigned int count;
+	unsigned int failed;
+	u64 total_usec;
+	unsigned int max_usec;
+};
+
 struct nl80211_global {
 	void *ctx;
 	struct dl_list interfaces;
@@ -37,6 +44,29 @@ struct nl80211_global {
 	int ioctl_sock; /* socket for ioctl() use */
 	struct nl_sock *nl_event;
 	u8 p2p_perm_addr[ETH_ALEN];
+
+	/* Commands whose completion is reported through eloop */
+	struct nl_sock *nl_async;
+	struct nl_cb *nl_async_cb;
+	struct dl_list async_pending; /* struct nl80211_async_cmd::list */
+
+	/* Callbacks reused by send_and_recv() for commands on nl */
+	struct nl_cb *nl_cmd_cb;
+	bool nl_cmd_cb_busy;
+	bool nl_ack_opts_set;
+
+	struct nl80211_cmd_stats cmd_stats[NL80211_CMD_MAX + 1];
+
+	/* BSS whose nl_mgmt handle is being read; cleared if it is closed */
+	struct i802_bss *mgmt_rx_bss;
+
+	/* Cached NL80211_CMD_GET_WIPHY replies of the wiphys in use */
+	struct dl_list wiphy_caps; /* struct nl80211_wiphy_cache::list */
+
+	/* Last BSS that matched an ifindex/wdev directed event; entries are
+	 * validated on use and cleared when the BSS is destroyed */
+#define NL80211_EVENT_BSS_CACHE_SIZE 16
+	struct i802_bss *event_bss[NL80211_EVENT_BSS_CACHE_SIZE];
 };
 
 struct nl80211_wiphy_data {
@@ -91,6 +121,17 @@ struct i802_bss {
 	struct nl_sock *nl_preq, *nl_mgmt, *nl_connect;
 	struct nl_cb *nl_cb;
 
+	/* Probe Request registration filter; probe_req_ssid_len = 0: none */
+	u8 probe_req_ssid[SSID_MAX_LEN];
+	u8 probe_req_ssid_len;
+	bool probe_req_wildcard;
+
+	/* nl_mgmt receive statistics */
+	unsigned int mgmt_rx_wakeups;
+	unsigned int mgmt_rx_reads;
+	unsigned int mgmt_rx_max_batch;
+	unsigned int mgmt_rx_overflows;
+
 	struct nl80211_wiphy_data *wiphy_data;
 	struct dl_list wiphy_list;
 	u8 rand_addr[ETH_ALEN];
@@ -212,13 +253,20 @@ struct wpa_driver_nl80211_data {
 #define MAX_SEND_FRAME_COOKIES 20
 	u64 send_frame_cookies[MAX_SEND_FRAME_COOKIES];
 	unsigned int num_send_frame_cookies;
-	u64 eapol_tx_cookie;
-	int eapol_tx_link_id;
+#define MAX_EAPOL_TX_COOKIES 8
+	/* Control port TX cookies of the latest EAPOL frames per STA */
+	struct {
+		u64 cookie;
+		u8 addr[ETH_ALEN];
+		int link_id;
+	} eapol_tx[MAX_EAPOL_TX_COOKIES];
+	unsigned int eapol_tx_next;
 
 	unsigned int last_mgmt_freq;
 
 	struct wpa_driver_scan_filter *filter_ssids;
 	size_t num_filter_ssids;
+	int *filter_freqs; /* zero terminated list of frequencies (MHz) */
 
 	struct i802_bss *first_bss;
 
@@ -292,6 +340,11 @@ int send_and_recv(struct nl80211_global *global,
 		  void *ack_data,
 		  struct nl80211_err_info *err_info);
 
+const char * nl80211_command_to_string(enum nl80211_commands cmd);
+int nl80211_send_async(struct nl80211_global *global, struct nl_msg *msg,
+		       void (*done)(void *ctx, int err), void *ctx);
+void nl80211_async_cancel(struct nl80211_global *global, void *ctx);
+
 // This function is not used in supplicant anymore. But keeping this wrapper
 // functions for libraries outside wpa_supplicant to build (For eg: lib_driver_cmd_XX)
 static inline int
@@ -360,6 +413,7 @@ int nl80211_send_monitor(struct wpa_driver_nl80211_data *drv,
 			 int encrypt, int noack);
 
 int wpa_driver_nl80211_capa(struct wpa_driver_nl80211_data *drv);
+void nl80211_wiphy_cache_flush(struct nl80211_global *global, int wiphy_idx);
 struct hostapd_hw_modes *
 nl80211_get_hw_feature_data(void *priv, u16 *num_modes, u16 *flags,
 			    u8 *dfs_domain);
@@ -373,6 +427,7 @@ void nl80211_restore_ap_mode(struct i802_bss *bss);
 struct i802_link * nl80211_get_link(struct i802_bss *bss, s8 link_id);
 u8 nl80211_get_link_id_from_link(struct i802_bss *bss, struct i802_link *link);
 int nl80211_remove_link(struct i802_bss *bss, int link_id);
+int nl80211_eapol_tx_find(struct wpa_driver_nl80211_data *drv, u64 cookie);
 
 static inline bool nl80211_link_valid(u16 links, s8 link_id)
 {
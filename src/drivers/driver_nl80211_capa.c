@@ -56,6 +56,196 @@ static u32 get_nl80211_protocol_features(struct wpa_driver_nl80211_data *drv)
 }
 
 
+/* Replies to NL80211_CMD_GET_WIPHY of one wiphy. The interfaces of the same
+ * wiphy get identical replies, so the messages are kept until an event
+ * indicates that the capabilities or channels of the wiphy may have changed.
+ */
+struct nl80211_wiphy_cache {
+	struct dl_list list; /* struct nl80211_global::wiphy_caps */
+	int wiphy_idx;
+	struct wpabuf *dump; /* NLMSG_ALIGN()ed struct nlmsghdr and payload */
+};
+
+struct nl80211_wiphy_record {
+	struct wpabuf *dump;
+	int (*handler)(struct nl_msg *msg, void *arg);
+	void *arg;
+};
+
+
+static int nl80211_wiphy_record_handler(struct nl_msg *msg, void *arg)
+{
+	struct nl80211_wiphy_record *rec = arg;
+	struct nlmsghdr *hdr = nlmsg_hdr(msg);
+	size_t len = NLMSG_ALIGN(hdr->nlmsg_len);
+	int res;
+
+	if (rec->dump && wpabuf_resize(&rec->dump, len) == 0) {
+		wpabuf_put_data(rec->dump, hdr, hdr->nlmsg_len);
+		os_memset(wpabuf_put(rec->dump, len - hdr->nlmsg_len), 0,
+			  len - hdr->nlmsg_len);
+	} else {
+		wpabuf_free(rec->dump);
+		rec->dump = NULL;
+	}
+
+	res = rec->handler(msg, rec->arg);
+	if (res == NL_STOP) {
+		/* Do not store a partial dump */
+		wpabuf_free(rec->dump);
+		rec->dump = NULL;
+	}
+	return res;
+}
+
+
+static int nl80211_wiphy_replay(struct wpabuf *dump,
+				int (*handler)(struct nl_msg *msg, void *arg),
+				void *arg)
+{
+	u8 *pos = wpabuf_mhead_u8(dump);
+	u8 *end = pos + wpabuf_len(dump);
+
+	while (end - pos >= (int) sizeof(struct nlmsghdr)) {
+		struct nlmsghdr *hdr = (struct nlmsghdr *) pos;
+		struct nl_msg *msg;
+		int res;
+
+		msg = nlmsg_convert(hdr);
+		if (!msg)
+			return -ENOMEM;
+		res = handler(msg, arg);
+		nlmsg_free(msg);
+		if (res == NL_STOP)
+			break;
+		pos += NLMSG_ALIGN(hdr->nlmsg_len);
+	}
+
+	return 0;
+}
+
+
+static void nl80211_wiphy_cache_free(struct nl80211_wiphy_cache *cache)
+{
+	dl_list_del(&cache->list);
+	wpabuf_free(cache->dump);
+	os_free(cache);
+}
+
+
+static void nl80211_wiphy_cache_prune(struct nl80211_global *global)
+{
+	struct nl80211_wiphy_cache *cache, *tmp;
+	struct wpa_driver_nl80211_data *drv;
+	bool used;
+
+	/* Keep the entries of the wiphys that have interfaces so that the
+	 * information can be reused when an interface is removed and added
+	 * back. The kernel does not reuse wiphy indexes, so an entry without
+	 * interfaces is most likely for a wiphy that no longer exists. */
+	dl_list_for_each_safe(cache, tmp, &global->wiphy_caps,
+			      struct nl80211_wiphy_cache, list) {
+		used = false;
+		dl_list_for_each(drv, &global->interfaces,
+				 struct wpa_driver_nl80211_data, list) {
+			if ((int) drv->wiphy_idx == cache->wiphy_idx) {
+				used = true;
+				break;
+			}
+		}
+		if (!used)
+			nl80211_wiphy_cache_free(cache);
+	}
+}
+
+
+/**
+ * nl80211_get_wiphy_dump - Process the NL80211_CMD_GET_WIPHY replies
+ * @bss: BSS of the wiphy
+ * @handler: Handler for each reply message
+ * @arg: Context for the handler
+ * Returns: 0 on success or a negative error code on failure
+ *
+ * The replies are fetched from the kernel once per wiphy and fed from the
+ * cache in struct nl80211_global to the later callers until
+ * nl80211_wiphy_cache_flush() is called for the wiphy.
+ */
+static int nl80211_get_wiphy_dump(struct i802_bss *bss,
+				  int (*handler)(struct nl_msg *msg,
+						 void *arg),
+				  void *arg)
+{
+	struct wpa_driver_nl80211_data *drv = bss->drv;
+	struct nl80211_global *global = drv->global;
+	struct nl80211_wiphy_cache *cache;
+	struct nl80211_wiphy_record rec;
+	struct nl_msg *msg;
+	int wiphy_idx = -1, flags = 0, ret;
+	u32 feat;
+
+	if (global)
+		wiphy_idx = nl80211_get_wiphy_index(bss);
+	if (wiphy_idx >= 0) {
+		dl_list_for_each(cache, &global->wiphy_caps,
+				 struct nl80211_wiphy_cache, list) {
+			if (cache->wiphy_idx != wiphy_idx)
+				continue;
+			wpa_printf(MSG_DEBUG,
+				   "nl80211: Use cached information of wiphy %d",
+				   wiphy_idx);
+			return nl80211_wiphy_replay(cache->dump, handler, arg);
+		}
+	}
+
+	feat = get_nl80211_protocol_features(drv);
+	if (feat & NL80211_PROTOCOL_FEATURE_SPLIT_WIPHY_DUMP)
+		flags = NLM_F_DUMP;
+	msg = nl80211_cmd_msg(bss, flags, NL80211_CMD_GET_WIPHY);
+	if (!msg || nla_put_flag(msg, NL80211_ATTR_SPLIT_WIPHY_DUMP)) {
+		nlmsg_free(msg);
+		return -ENOBUFS;
+	}
+
+	if (wiphy_idx < 0)
+		return send_and_recv_resp(drv, msg, handler, arg);
+
+	rec.dump = wpabuf_alloc(4096);
+	rec.handler = handler;
+	rec.arg = arg;
+	ret = send_and_recv_resp(drv, msg, nl80211_wiphy_record_handler, &rec);
+	if (ret == 0 && rec.dump) {
+		nl80211_wiphy_cache_prune(global);
+		cache = os_zalloc(sizeof(*cache));
+		if (cache) {
+			cache->wiphy_idx = wiphy_idx;
+			cache->dump = rec.dump;
+			rec.dump = NULL;
+			dl_list_add(&global->wiphy_caps, &cache->list);
+		}
+	}
+	wpabuf_free(rec.dump);
+
+	return ret;
+}
+
+
+/**
+ * nl80211_wiphy_cache_flush - Drop cached NL80211_CMD_GET_WIPHY replies
+ * @global: nl80211 global data
+ * @wiphy_idx: Index of the wiphy or -1 for all wiphys
+ */
+void nl80211_wiphy_cache_flush(struct nl80211_global *global, int wiphy_idx)
+{
+	struct nl80211_wiphy_cache *cache, *tmp;
+
+	dl_list_for_each_safe(cache, tmp, &global->wiphy_caps,
+			      struct nl80211_wiphy_cache, list) {
+		if (wiphy_idx < 0 || cache->wiphy_idx == wiphy_idx)
+			nl80211_wiphy_cache_free(cache);
+	}
+}
+
+
 struct wiphy_info_data {
 	struct wpa_driver_nl80211_data *drv;
 	struct wpa_driver_capa *capa;
@@ -1196,24 +1386,11 @@ static int wiphy_info_handler(struct nl_msg *msg, void *arg)
 static int wpa_driver_nl80211_get_info(struct wpa_driver_nl80211_data *drv,
 				       struct wiphy_info_data *info)
 {
-	u32 feat;
-	struct nl_msg *msg;
-	int flags = 0;
-
 	os_memset(info, 0, sizeof(*info));
 	info->capa = &drv->capa;
 	info->drv = drv;
 
-	feat = get_nl80211_protocol_features(drv);
-	if (feat & NL80211_PROTOCOL_FEATURE_SPLIT_WIPHY_DUMP)
-		flags = NLM_F_DUMP;
-	msg = nl80211_cmd_msg(drv->first_bss, flags, NL80211_CMD_GET_WIPHY);
-	if (!msg || nla_put_flag(msg, NL80211_ATTR_SPLIT_WIPHY_DUMP)) {
-		nlmsg_free(msg);
-		return -1;
-	}
-
-	if (send_and_recv_resp(drv, msg, wiphy_info_handler, info))
+	if (nl80211_get_wiphy_dump(drv->first_bss, wiphy_info_handler, info))
 		return -1;
 
 	if (info->auth_supported)
@@ -2702,11 +2879,8 @@ struct hostapd_hw_modes *
 nl80211_get_hw_feature_data(void *priv, u16 *num_modes, u16 *flags,
 			    u8 *dfs_domain)
 {
-	u32 feat;
 	struct i802_bss *bss = priv;
 	struct wpa_driver_nl80211_data *drv = bss->drv;
-	int nl_flags = 0;
-	struct nl_msg *msg;
 	struct phy_info_arg result = {
 		.num_modes = num_modes,
 		.modes = NULL,
@@ -2719,16 +2893,7 @@ nl80211_get_hw_feature_data(void *priv, u16 *num_modes, u16 *flags,
 	*flags = 0;
 	*dfs_domain = 0;
 
-	feat = get_nl80211_protocol_features(drv);
-	if (feat & NL80211_PROTOCOL_FEATURE_SPLIT_WIPHY_DUMP)
-		nl_flags = NLM_F_DUMP;
-	if (!(msg = nl80211_cmd_msg(bss, nl_flags, NL80211_CMD_GET_WIPHY)) ||
-	    nla_put_flag(msg, NL80211_ATTR_SPLIT_WIPHY_DUMP)) {
-		nlmsg_free(msg);
-		return NULL;
-	}
-
-	if (send_and_recv_resp(drv, msg, phy_info_handler, &result) == 0) {
+	if (nl80211_get_wiphy_dump(bss, phy_info_handler, &result) == 0) {
 		struct hostapd_hw_modes *modes;
 
 		nl80211_set_regulatory_flags(drv, &result);
@@ -2846,10 +3011,7 @@ out:
 struct hostapd_multi_hw_info *
 nl80211_get_multi_hw_info(struct i802_bss *bss, unsigned int *num_multi_hws)
 {
-	u32 feat;
 	struct wpa_driver_nl80211_data *drv = bss->drv;
-	int nl_flags = 0;
-	struct nl_msg *msg;
 	struct phy_multi_hw_info_arg result = {
 		.failed = false,
 		.num_multi_hws = num_multi_hws,
@@ -2861,17 +3023,8 @@ nl80211_get_multi_hw_info(struct i802_bss *bss, unsigned int *num_multi_hws)
 	if (!drv->has_capability || !(drv->capa.flags2 & WPA_DRIVER_FLAGS2_MLO))
 		return NULL;
 
-	feat = get_nl80211_protocol_features(drv);
-	if (feat & NL80211_PROTOCOL_FEATURE_SPLIT_WIPHY_DUMP)
-		nl_flags = NLM_F_DUMP;
-	if (!(msg = nl80211_cmd_msg(bss, nl_flags, NL80211_CMD_GET_WIPHY)) ||
-	    nla_put_flag(msg, NL80211_ATTR_SPLIT_WIPHY_DUMP)) {
-		nlmsg_free(msg);
-		return NULL;
-	}
-
-	if (send_and_recv_resp(drv, msg, phy_multi_hw_info_handler,
-			       &result) == 0) {
+	if (nl80211_get_wiphy_dump(bss, phy_multi_hw_info_handler,
+				   &result) == 0) {
 		if (result.failed) {
 			os_free(result.multi_hws);
 			*num_multi_hws = 0;
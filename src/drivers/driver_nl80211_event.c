@@ -26,7 +26,7 @@ nl80211_control_port_frame_tx_status(struct i802_bss *bss,
 				     struct nlattr *ack, struct nlattr *cookie);
 
 
-static const char * nl80211_command_to_string(enum nl80211_commands cmd)
+const char * nl80211_command_to_string(enum nl80211_commands cmd)
 {
 #define C2S(x) case x: return #x;
 	switch (cmd) {
@@ -1412,7 +1412,7 @@ static void mlme_event_mgmt_tx_status(struct i802_bss *bss,
 		   WLAN_FC_GET_STYPE(fc), (long long unsigned int) cookie_val,
 		   cookie ? "" : "(N/A)", ack != NULL);
 
-	if (cookie_val && cookie_val == drv->eapol_tx_cookie &&
+	if (nl80211_eapol_tx_find(drv, cookie_val) >= 0 &&
 	    len >= ETH_HLEN &&
 	    WPA_GET_BE16(frame + 2 * ETH_ALEN) == ETH_P_PAE) {
 		wpa_printf(MSG_DEBUG,
@@ -2201,6 +2201,9 @@ static void nl80211_new_peer_candidate(struct wpa_driver_nl80211_data *drv,
 	data.mesh_peer.peer = addr;
 	data.mesh_peer.ies = nla_data(tb[NL80211_ATTR_IE]);
 	data.mesh_peer.ie_len = nla_len(tb[NL80211_ATTR_IE]);
+	if (tb[NL80211_ATTR_RX_SIGNAL_DBM])
+		data.mesh_peer.ssi_signal =
+			(s32) nla_get_u32(tb[NL80211_ATTR_RX_SIGNAL_DBM]);
 	wpa_supplicant_event(drv->ctx, EVENT_NEW_PEER_CANDIDATE, &data);
 }
 
@@ -3821,6 +3824,7 @@ nl80211_control_port_frame_tx_status(struct i802_bss *bss,
 {
 	struct wpa_driver_nl80211_data *drv = bss->drv;
 	union wpa_event_data event;
+	int i;
 
 	if (!cookie || len < ETH_HLEN)
 		return;
@@ -3834,9 +3838,12 @@ nl80211_control_port_frame_tx_status(struct i802_bss *bss,
 	event.eapol_tx_status.data = frame + ETH_HLEN;
 	event.eapol_tx_status.data_len = len - ETH_HLEN;
 	event.eapol_tx_status.ack = ack != NULL;
-	event.eapol_tx_status.link_id =
-		nla_get_u64(cookie) == drv->eapol_tx_cookie ?
-		drv->eapol_tx_link_id : NL80211_DRV_LINK_ID_NA;
+	event.eapol_tx_status.link_id = NL80211_DRV_LINK_ID_NA;
+	i = nl80211_eapol_tx_find(drv, nla_get_u64(cookie));
+	if (i >= 0) {
+		event.eapol_tx_status.link_id = drv->eapol_tx[i].link_id;
+		drv->eapol_tx[i].cookie = 0;
+	}
 
 	wpa_supplicant_event(bss->ctx, EVENT_EAPOL_TX_STATUS, &event);
 }
@@ -4244,6 +4251,16 @@ static bool nl80211_drv_in_list(struct nl80211_global *global,
 }
 
 
+static unsigned int nl80211_event_bss_slot(int ifidx, u64 wdev_id,
+					   int wdev_id_set)
+{
+	if (wdev_id_set)
+		return (unsigned int) (wdev_id ^ (wdev_id >> 32)) %
+			NL80211_EVENT_BSS_CACHE_SIZE;
+	return (unsigned int) ifidx % NL80211_EVENT_BSS_CACHE_SIZE;
+}
+
+
 int process_global_event(struct nl_msg *msg, void *arg)
 {
 	struct nl80211_global *global = arg;
@@ -4256,6 +4273,7 @@ int process_global_event(struct nl_msg *msg, void *arg)
 	int wdev_id_set = 0;
 	int wiphy_idx_set = 0;
 	bool processed = false;
+	unsigned int slot = 0;
 
 	/* Event marker, all prior events have been processed */
 	if (gnlh->cmd == NL80211_CMD_GET_PROTOCOL_FEATURES) {
@@ -4284,6 +4302,21 @@ int process_global_event(struct nl_msg *msg, void *arg)
 	nla_parse(tb, NL80211_ATTR_MAX, genlmsg_attrdata(gnlh, 0),
 		  genlmsg_attrlen(gnlh, 0), NULL);
 
+	switch (gnlh->cmd) {
+	case NL80211_CMD_REG_CHANGE:
+	case NL80211_CMD_WIPHY_REG_CHANGE:
+	case NL80211_CMD_REG_BEACON_HINT:
+	case NL80211_CMD_RADAR_DETECT:
+		/* The channel flags and DFS states are part of the wiphy
+		 * information, so the handlers below need to see fresh data */
+		nl80211_wiphy_cache_flush(
+			global, tb[NL80211_ATTR_WIPHY] ?
+			(int) nla_get_u32(tb[NL80211_ATTR_WIPHY]) : -1);
+		break;
+	default:
+		break;
+	}
+
 	if (tb[NL80211_ATTR_IFINDEX])
 		ifidx = nla_get_u32(tb[NL80211_ATTR_IFINDEX]);
 	else if (tb[NL80211_ATTR_WDEV]) {
@@ -4294,6 +4327,21 @@ int process_global_event(struct nl_msg *msg, void *arg)
 		wiphy_idx_set = 1;
 	}
 
+	/* Events directed to a single interface or wdev go to one BSS only,
+	 * so try the BSS that handled the previous event with the same key
+	 * before walking all interfaces */
+	if (ifidx > 0 || wdev_id_set) {
+		slot = nl80211_event_bss_slot(ifidx, wdev_id, wdev_id_set);
+		bss = global->event_bss[slot];
+		if (bss &&
+		    ((ifidx > 0 && bss->ifindex == ifidx) ||
+		     (wdev_id_set && bss->wdev_id_set &&
+		      bss->wdev_id == wdev_id))) {
+			do_process_drv_event(bss, gnlh->cmd, tb);
+			return NL_SKIP;
+		}
+	}
+
 	dl_list_for_each_safe(drv, tmp, &global->interfaces,
 			      struct wpa_driver_nl80211_data, list) {
 		for (bss = drv->first_bss; bss; bss = bss->next) {
@@ -4305,6 +4353,10 @@ int process_global_event(struct nl_msg *msg, void *arg)
 			    (wdev_id_set && bss->wdev_id_set &&
 			     wdev_id == bss->wdev_id)) {
 				processed = true;
+				/* Stored before processing so that the entry
+				 * is cleared if the event removes the BSS */
+				if (ifidx > 0 || wdev_id_set)
+					global->event_bss[slot] = bss;
 				do_process_drv_event(bss, gnlh->cmd, tb);
 				/* There are two types of events that may need
 				 * to be delivered to multiple interfaces:
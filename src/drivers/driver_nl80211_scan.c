@@ -262,6 +262,11 @@ nl80211_scan_common(struct i802_bss *bss, u8 cmd,
 	params->filter_ssids = NULL;
 	drv->num_filter_ssids = params->num_filter_ssids;
 
+	os_free(drv->filter_freqs);
+	drv->filter_freqs = NULL;
+	if (params->filter_freqs && params->freqs)
+		int_array_concat(&drv->filter_freqs, params->freqs);
+
 	if (!drv->hostapd && is_ap_interface(drv->nlmode)) {
 		wpa_printf(MSG_DEBUG, "nl80211: Add NL80211_SCAN_FLAG_AP");
 		scan_flags |= NL80211_SCAN_FLAG_AP;
@@ -780,7 +785,8 @@ static int nl80211_scan_filtered(struct wpa_driver_nl80211_data *drv,
 
 static struct wpa_scan_res *
 nl80211_parse_bss_info(struct wpa_driver_nl80211_data *drv,
-		       struct nl_msg *msg, const u8 *bssid)
+		       struct nl_msg *msg, const u8 *bssid,
+		       struct wpa_scan_results *res)
 {
 	struct nlattr *tb[NL80211_ATTR_MAX + 1];
 	struct genlmsghdr *gnlh = nlmsg_data(nlmsg_hdr(msg));
@@ -817,6 +823,12 @@ nl80211_parse_bss_info(struct wpa_driver_nl80211_data *drv,
 	if (bssid && bss[NL80211_BSS_BSSID] &&
 	    !ether_addr_equal(bssid, nla_data(bss[NL80211_BSS_BSSID])))
 		return NULL;
+	/* Skip entries on channels that were not covered by the last scan
+	 * before parsing or copying anything else from them. */
+	if (!bssid && drv->filter_freqs && bss[NL80211_BSS_FREQUENCY] &&
+	    !int_array_includes(drv->filter_freqs,
+				nla_get_u32(bss[NL80211_BSS_FREQUENCY])))
+		return NULL;
 	if (bss[NL80211_BSS_INFORMATION_ELEMENTS]) {
 		ie = nla_data(bss[NL80211_BSS_INFORMATION_ELEMENTS]);
 		ie_len = nla_len(bss[NL80211_BSS_INFORMATION_ELEMENTS]);
@@ -836,7 +848,10 @@ nl80211_parse_bss_info(struct wpa_driver_nl80211_data *drv,
 				  ie ? ie_len : beacon_ie_len))
 		return NULL;
 
-	r = os_zalloc(sizeof(*r) + ie_len + beacon_ie_len);
+	if (res)
+		r = wpa_scan_res_alloc(res, ie_len + beacon_ie_len);
+	else
+		r = os_zalloc(sizeof(*r) + ie_len + beacon_ie_len);
 	if (r == NULL)
 		return NULL;
 	if (bss[NL80211_BSS_BSSID])
@@ -921,6 +936,7 @@ nl80211_parse_bss_info(struct wpa_driver_nl80211_data *drv,
 struct nl80211_bss_info_arg {
 	struct wpa_driver_nl80211_data *drv;
 	struct wpa_scan_results *res;
+	size_t res_alloc;
 	const u8 *bssid;
 };
 
@@ -931,22 +947,26 @@ static int bss_info_handler(struct nl_msg *msg, void *arg)
 	struct wpa_scan_res **tmp;
 	struct wpa_scan_res *r;
 
-	r = nl80211_parse_bss_info(_arg->drv, msg, _arg->bssid);
-	if (!r)
+	if (!res)
 		return NL_SKIP;
 
-	if (!res) {
-		os_free(r);
-		return NL_SKIP;
-	}
-	tmp = os_realloc_array(res->res, res->num + 1,
-			       sizeof(struct wpa_scan_res *));
-	if (tmp == NULL) {
-		os_free(r);
+	/* Entries are allocated from the arena in res and are freed together
+	 * with the results, so there is nothing to free on errors here. */
+	r = nl80211_parse_bss_info(_arg->drv, msg, _arg->bssid, res);
+	if (!r)
 		return NL_SKIP;
+
+	if (res->num == _arg->res_alloc) {
+		size_t alloc = _arg->res_alloc ? _arg->res_alloc * 2 : 32;
+
+		tmp = os_realloc_array(res->res, alloc,
+				       sizeof(struct wpa_scan_res *));
+		if (tmp == NULL)
+			return NL_SKIP;
+		res->res = tmp;
+		_arg->res_alloc = alloc;
 	}
-	tmp[res->num++] = r;
-	res->res = tmp;
+	res->res[res->num++] = r;
 
 	return NL_SKIP;
 }
@@ -1049,6 +1069,7 @@ try_again:
 
 	arg.drv = drv;
 	arg.res = res;
+	arg.res_alloc = 0;
 	arg.bssid = bssid;
 	ret = send_and_recv_resp(drv, msg, bss_info_handler, &arg);
 	if (ret == -EAGAIN) {
@@ -1114,7 +1135,7 @@ static int nl80211_dump_scan_handler(struct nl_msg *msg, void *arg)
 	struct nl80211_dump_scan_ctx *ctx = arg;
 	struct wpa_scan_res *r;
 
-	r = nl80211_parse_bss_info(ctx->drv, msg, NULL);
+	r = nl80211_parse_bss_info(ctx->drv, msg, NULL, NULL);
 	if (!r)
 		return NL_SKIP;
 	wpa_printf(MSG_DEBUG, "nl80211: %d " MACSTR " %d%s",
@@ -1262,6 +1283,9 @@ int wpa_driver_nl80211_vendor_scan(struct i802_bss *bss,
 	params->filter_ssids = NULL;
 	drv->num_filter_ssids = params->num_filter_ssids;
 
+	os_free(drv->filter_freqs);
+	drv->filter_freqs = NULL;
+
 	if (params->low_priority && drv->have_low_prio_scan) {
 		wpa_printf(MSG_DEBUG,
 			   "nl80211: Add NL80211_SCAN_FLAG_LOW_PRIORITY");
@@ -18,6 +18,7 @@
 #include "includes.h"
 
 #include "common.h"
+#include "memstat.h"
 #include "pcsc_funcs.h"
 #include "state_machine.h"
 #include "ext_password.h"
@@ -171,6 +172,33 @@ int eap_allowed_method(struct eap_sm *sm, int vendor, u32 method)
 }
 
 
+/**
+ * eap_sm_count_alloc - Account a message buffer allocation
+ * @sm: Pointer to EAP state machine allocated with eap_peer_sm_init()
+ * @len: Number of bytes allocated
+ *
+ * EAP methods call this for buffers that are allocated for assembling or
+ * reassembling EAP messages so that the total for the EAP session can be
+ * reported in the status information.
+ */
+void eap_sm_count_alloc(struct eap_sm *sm, size_t len)
+{
+	sm->msg_allocs++;
+	sm->msg_alloc_bytes += len;
+}
+
+
+static void eap_sm_session_done(struct eap_sm *sm)
+{
+	/* No retransmissions after EAP-Success/Failure */
+	wpabuf_free(sm->lastRespData);
+	sm->lastRespData = NULL;
+	wpa_printf(MSG_DEBUG,
+		   "EAP: Session message buffers: %u allocations, %zu bytes",
+		   sm->msg_allocs, sm->msg_alloc_bytes);
+}
+
+
 #if defined(PCSC_FUNCS) || defined(CONFIG_EAP_PROXY)
 static int eap_sm_append_3gpp_realm(struct eap_sm *sm, char *imsi,
 				    size_t max_len, size_t *imsi_len,
@@ -232,6 +260,8 @@ SM_STATE(EAP, INITIALIZE)
 	sm->allowNotifications = true;
 	sm->decision = DECISION_FAIL;
 	sm->ClientTimeout = EAP_CLIENT_TIMEOUT_DEFAULT;
+	sm->msg_allocs = 0;
+	sm->msg_alloc_bytes = 0;
 	eapol_set_int(sm, EAPOL_idleWhile, sm->ClientTimeout);
 	eapol_set_bool(sm, EAPOL_eapSuccess, false);
 	eapol_set_bool(sm, EAPOL_eapFail, false);
@@ -582,6 +612,24 @@ static void eap_peer_erp_free_key(struct eap_erp_key *erp)
 }
 
 
+static void eap_peer_erp_notify(struct eap_sm *sm, struct eap_erp_key *erp,
+				bool removed)
+{
+	if (sm->eapol_cb->erp_key_update)
+		sm->eapol_cb->erp_key_update(sm->eapol_ctx, erp->keyname_nai,
+					     removed ? NULL : erp->rRK,
+					     removed ? 0 : erp->rRK_len,
+					     erp->next_seq);
+}
+
+
+static void eap_peer_erp_remove_key(struct eap_sm *sm, struct eap_erp_key *erp)
+{
+	eap_peer_erp_notify(sm, erp, true);
+	eap_peer_erp_free_key(erp);
+}
+
+
 static void eap_erp_remove_keys_realm(struct eap_sm *sm, const char *realm)
 {
 	struct eap_erp_key *erp;
@@ -589,11 +637,26 @@ static void eap_erp_remove_keys_realm(struct eap_sm *sm, const char *realm)
 	while ((erp = eap_erp_get_key(sm, realm)) != NULL) {
 		wpa_printf(MSG_DEBUG, "EAP: Delete old ERP key %s",
 			   erp->keyname_nai);
-		eap_peer_erp_free_key(erp);
+		eap_peer_erp_remove_key(sm, erp);
 	}
 }
 
 
+static int eap_peer_erp_derive_rik(struct eap_erp_key *erp)
+{
+	u8 ctx[3];
+
+	ctx[0] = EAP_ERP_CS_HMAC_SHA256_128;
+	WPA_PUT_BE16(&ctx[1], erp->rRK_len);
+	if (hmac_sha256_kdf(erp->rRK, erp->rRK_len,
+			    "Re-authentication Integrity Key@ietf.org",
+			    ctx, sizeof(ctx), erp->rIK, erp->rRK_len) < 0)
+		return -1;
+	erp->rIK_len = erp->rRK_len;
+	return 0;
+}
+
+
 int eap_peer_update_erp_next_seq_num(struct eap_sm *sm, u16 next_seq_num)
 {
 	struct eap_erp_key *erp;
@@ -618,9 +681,10 @@ int eap_peer_update_erp_next_seq_num(struct eap_sm *sm, u16 next_seq_num)
 		/* Sequence number has wrapped around, clear this ERP
 		 * info and do a full auth next time.
 		 */
-		eap_peer_erp_free_key(erp);
+		eap_peer_erp_remove_key(sm, erp);
 	} else {
 		erp->next_seq = (u32) next_seq_num;
+		eap_peer_erp_notify(sm, erp, false);
 	}
 
 	os_free(home_realm);
@@ -676,6 +740,52 @@ int eap_peer_get_erp_info(struct eap_sm *sm, struct eap_peer_config *config,
 	return 0;
 }
 
+
+/**
+ * eap_peer_erp_restore_key - Add a previously derived ERP key
+ * @sm: Pointer to EAP state machine allocated with eap_peer_sm_init()
+ * @keyname_nai: keyName-NAI of the key
+ * @rrk: rRK
+ * @rrk_len: Length of rRK in octets
+ * @next_seq: Next SEQ to use with the key
+ * Returns: 0 on success, -1 on failure
+ *
+ * This can be used to restore ERP keys from persistent storage. A key that is
+ * already available for the same realm is replaced.
+ */
+int eap_peer_erp_restore_key(struct eap_sm *sm, const char *keyname_nai,
+			     const u8 *rrk, size_t rrk_len, u32 next_seq)
+{
+	struct eap_erp_key *erp, *old;
+	const char *realm;
+	size_t nai_len = os_strlen(keyname_nai);
+
+	realm = os_strchr(keyname_nai, '@');
+	if (!realm || realm == keyname_nai || !realm[1] || nai_len > 253 ||
+	    rrk_len == 0 || rrk_len > ERP_MAX_KEY_LEN || next_seq >= 65536)
+		return -1;
+
+	erp = os_zalloc(sizeof(*erp) + nai_len + 1);
+	if (!erp)
+		return -1;
+	os_memcpy(erp->keyname_nai, keyname_nai, nai_len);
+	os_memcpy(erp->rRK, rrk, rrk_len);
+	erp->rRK_len = rrk_len;
+	erp->next_seq = next_seq;
+	if (eap_peer_erp_derive_rik(erp) < 0) {
+		bin_clear_free(erp, sizeof(*erp));
+		return -1;
+	}
+
+	while ((old = eap_erp_get_key(sm, realm + 1)) != NULL)
+		eap_peer_erp_free_key(old);
+	dl_list_add(&sm->erp_keys, &erp->list);
+	wpa_printf(MSG_DEBUG, "EAP: Restored ERP keys %s (SEQ=%u)",
+		   erp->keyname_nai, erp->next_seq);
+
+	return 0;
+}
+
 #endif /* CONFIG_ERP */
 
 
@@ -703,7 +813,7 @@ void eap_peer_erp_init(struct eap_sm *sm, u8 *ext_session_id,
 	u8 *session_id = NULL;
 	size_t session_id_len = 0;
 	u8 EMSKname[EAP_EMSK_NAME_LEN];
-	u8 len[2], ctx[3];
+	u8 len[2];
 	char *realm;
 	size_t realm_len, nai_buf_len;
 	struct eap_erp_key *erp = NULL;
@@ -783,19 +893,15 @@ void eap_peer_erp_init(struct eap_sm *sm, u8 *ext_session_id,
 	erp->rRK_len = emsk_len;
 	wpa_hexdump_key(MSG_DEBUG, "EAP: ERP rRK", erp->rRK, erp->rRK_len);
 
-	ctx[0] = EAP_ERP_CS_HMAC_SHA256_128;
-	WPA_PUT_BE16(&ctx[1], erp->rRK_len);
-	if (hmac_sha256_kdf(erp->rRK, erp->rRK_len,
-			    "Re-authentication Integrity Key@ietf.org",
-			    ctx, sizeof(ctx), erp->rIK, erp->rRK_len) < 0) {
+	if (eap_peer_erp_derive_rik(erp) < 0) {
 		wpa_printf(MSG_DEBUG, "EAP: Could not derive rIK for ERP");
 		goto fail;
 	}
-	erp->rIK_len = erp->rRK_len;
 	wpa_hexdump_key(MSG_DEBUG, "EAP: ERP rIK", erp->rIK, erp->rIK_len);
 
 	wpa_printf(MSG_DEBUG, "EAP: Stored ERP keys %s", erp->keyname_nai);
 	dl_list_add(&sm->erp_keys, &erp->list);
+	eap_peer_erp_notify(sm, erp, false);
 	erp = NULL;
 fail:
 	if (ext_emsk)
@@ -860,6 +966,8 @@ struct wpabuf * eap_peer_build_erp_reauth_start(struct eap_sm *sm, u8 eap_id)
 
 	sm->erp_seq = erp->next_seq;
 	erp->next_seq++;
+	/* A SEQ must not be reused even if the process is restarted */
+	eap_peer_erp_notify(sm, erp, false);
 
 	wpa_hexdump_buf(MSG_DEBUG, "ERP: EAP-Initiate/Re-auth", msg);
 
@@ -968,17 +1076,28 @@ SM_STATE(EAP, METHOD)
 SM_STATE(EAP, SEND_RESPONSE)
 {
 	SM_ENTRY(EAP, SEND_RESPONSE);
-	wpabuf_free(sm->lastRespData);
 	if (sm->eapRespData) {
-		if (wpabuf_len(sm->eapRespData) >= 20)
+		size_t len = wpabuf_len(sm->eapRespData);
+
+		if (len >= 20)
 			sm->num_rounds_short = 0;
 		if (sm->workaround)
 			os_memcpy(sm->last_sha1, sm->req_sha1, 20);
 		sm->lastId = sm->reqId;
-		sm->lastRespData = wpabuf_dup(sm->eapRespData);
+		eap_sm_count_alloc(sm, len);
+		if (sm->lastRespData && wpabuf_size(sm->lastRespData) >= len) {
+			/* Reuse the buffer for the retransmission copy */
+			wpabuf_reset(sm->lastRespData);
+			wpabuf_put_buf(sm->lastRespData, sm->eapRespData);
+		} else {
+			wpabuf_free(sm->lastRespData);
+			sm->lastRespData = wpabuf_dup(sm->eapRespData);
+			eap_sm_count_alloc(sm, len);
+		}
 		eapol_set_bool(sm, EAPOL_eapResp, true);
 	} else {
 		wpa_printf(MSG_DEBUG, "EAP: No eapRespData available");
+		wpabuf_free(sm->lastRespData);
 		sm->lastRespData = NULL;
 	}
 	eapol_set_bool(sm, EAPOL_eapReq, false);
@@ -1080,6 +1199,7 @@ SM_STATE(EAP, SUCCESS)
 
 	wpa_msg(sm->msg_ctx, MSG_INFO, WPA_EVENT_EAP_SUCCESS
 		"EAP authentication completed successfully");
+	eap_sm_session_done(sm);
 
 	if (!config || !sm->m) {
 		/*
@@ -1127,6 +1247,7 @@ SM_STATE(EAP, FAILURE)
 
 	wpa_msg(sm->msg_ctx, MSG_INFO, WPA_EVENT_EAP_FAILURE
 		"EAP authentication failed");
+	eap_sm_session_done(sm);
 
 	sm->prev_failure = 1;
 }
@@ -1994,7 +2115,7 @@ no_auth_tag:
 		sm->prev_failure = 1;
 		wpa_printf(MSG_DEBUG,
 			   "EAP: Drop ERP key to try full authentication on next attempt");
-		eap_peer_erp_free_key(erp);
+		eap_peer_erp_remove_key(sm, erp);
 		return;
 	}
 
@@ -2285,6 +2406,7 @@ struct eap_sm * eap_peer_sm_init(void *eapol_ctx,
 			   "context (2).");
 		/* Run without separate TLS context within TLS tunnel */
 	}
+	memstat_alloc(MEMSTAT_EAP, sizeof(*sm));
 
 	return sm;
 }
@@ -2309,6 +2431,7 @@ void eap_peer_sm_deinit(struct eap_sm *sm)
 	tls_deinit(sm->ssl_ctx);
 	eap_peer_erp_free_keys(sm);
 	os_free(sm->identity);
+	memstat_free(MEMSTAT_EAP, sizeof(*sm));
 	os_free(sm);
 }
 
@@ -2492,11 +2615,14 @@ int eap_sm_get_status(struct eap_sm *sm, char *buf, size_t buflen, int verbose)
 				  "reqMethod=%d\n"
 				  "methodState=%s\n"
 				  "decision=%s\n"
-				  "ClientTimeout=%d\n",
+				  "ClientTimeout=%d\n"
+				  "msgAllocs=%u\n"
+				  "msgAllocBytes=%zu\n",
 				  sm->reqMethod,
 				  eap_sm_method_state_txt(sm->methodState),
 				  eap_sm_decision_txt(sm->decision),
-				  sm->ClientTimeout);
+				  sm->ClientTimeout,
+				  sm->msg_allocs, sm->msg_alloc_bytes);
 		if (os_snprintf_error(buflen - len, ret))
 			return len;
 		len += ret;
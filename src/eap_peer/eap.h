@@ -314,6 +314,20 @@ struct eapol_callbacks {
 	 * Returns: size of the retrieved certificate or -1 on error
 	 */
 	ssize_t (*get_certificate)(void* ctx, const char* alias, uint8_t** value);
+
+	/**
+	 * erp_key_update - Notification of a new, updated, or removed ERP key
+	 * @ctx: eapol_ctx from eap_peer_sm_init() call
+	 * @keyname_nai: keyName-NAI of the key
+	 * @rrk: rRK or %NULL if the key was removed
+	 * @rrk_len: Length of rRK in octets
+	 * @next_seq: Next SEQ to use with the key
+	 *
+	 * This is called whenever an ERP key is derived or removed and
+	 * whenever its next SEQ changes.
+	 */
+	void (*erp_key_update)(void *ctx, const char *keyname_nai,
+			       const u8 *rrk, size_t rrk_len, u32 next_seq);
 };
 
 /**
@@ -410,6 +424,8 @@ int eap_peer_get_erp_info(struct eap_sm *sm, struct eap_peer_config *config,
 			  const u8 **realm, size_t *realm_len, u16 *erp_seq_num,
 			  const u8 **rrk, size_t *rrk_len);
 int eap_peer_update_erp_next_seq_num(struct eap_sm *sm, u16 seq_num);
+int eap_peer_erp_restore_key(struct eap_sm *sm, const char *keyname_nai,
+			     const u8 *rrk, size_t rrk_len, u32 next_seq);
 void eap_peer_erp_init(struct eap_sm *sm, u8 *ext_session_id,
 		       size_t ext_session_id_len, u8 *ext_emsk,
 		       size_t ext_emsk_len);
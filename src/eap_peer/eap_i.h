@@ -394,6 +394,10 @@ struct eap_sm {
 	/* Identity used in EAP-Response/Identity */
 	u8 *identity;
 	size_t identity_len;
+
+	/* Message buffer allocations during the current EAP session */
+	unsigned int msg_allocs;
+	size_t msg_alloc_bytes;
 };
 
 const u8 * eap_get_config_identity(struct eap_sm *sm, size_t *len);
@@ -412,5 +416,6 @@ const struct wpa_config_blob *
 eap_get_config_blob(struct eap_sm *sm, const char *name);
 void eap_notify_pending(struct eap_sm *sm);
 int eap_allowed_method(struct eap_sm *sm, int vendor, u32 method);
+void eap_sm_count_alloc(struct eap_sm *sm, size_t len);
 
 #endif /* EAP_I_H */
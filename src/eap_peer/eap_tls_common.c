@@ -360,6 +360,8 @@ void eap_peer_tls_ssl_deinit(struct eap_sm *sm, struct eap_ssl_data *data)
 {
 	tls_connection_deinit(data->ssl_ctx, data->conn);
 	eap_peer_tls_reset_input(data);
+	wpabuf_free(data->tls_in);
+	data->tls_in = NULL;
 	eap_peer_tls_reset_output(data);
 }
 
@@ -465,14 +467,40 @@ u8 * eap_peer_tls_derive_session_id(struct eap_sm *sm,
 }
 
 
+/**
+ * eap_peer_tls_reserve_input - Make room in the reassembly buffer
+ * @sm: Pointer to EAP state machine allocated with eap_peer_sm_init()
+ * @data: Data for TLS processing
+ * @len: Number of bytes to be added to the buffer
+ * Returns: 0 on success, -1 on failure
+ *
+ * The reassembly buffer is reused for all messages of the EAP session, so
+ * this allocates memory only when the buffer needs to grow.
+ */
+static int eap_peer_tls_reserve_input(struct eap_sm *sm,
+				      struct eap_ssl_data *data, size_t len)
+{
+	size_t size = data->tls_in ? wpabuf_size(data->tls_in) : 0;
+
+	if (data->tls_in && wpabuf_tailroom(data->tls_in) >= len)
+		return 0;
+	if (wpabuf_resize(&data->tls_in, len) < 0)
+		return -1;
+	eap_sm_count_alloc(sm, wpabuf_size(data->tls_in) - size);
+	return 0;
+}
+
+
 /**
  * eap_peer_tls_reassemble_fragment - Reassemble a received fragment
+ * @sm: Pointer to EAP state machine allocated with eap_peer_sm_init()
  * @data: Data for TLS processing
  * @in_data: Next incoming TLS segment
  * Returns: 0 on success, 1 if more data is needed for the full message, or
  * -1 on error
  */
-static int eap_peer_tls_reassemble_fragment(struct eap_ssl_data *data,
+static int eap_peer_tls_reassemble_fragment(struct eap_sm *sm,
+					    struct eap_ssl_data *data,
 					    const struct wpabuf *in_data)
 {
 	size_t tls_in_len, in_len;
@@ -510,7 +538,7 @@ static int eap_peer_tls_reassemble_fragment(struct eap_ssl_data *data,
 		return -1;
 	}
 
-	if (wpabuf_resize(&data->tls_in, in_len) < 0) {
+	if (eap_peer_tls_reserve_input(sm, data, in_len) < 0) {
 		wpa_printf(MSG_INFO, "SSL: Could not allocate memory for TLS "
 			   "data");
 		eap_peer_tls_reset_input(data);
@@ -532,6 +560,7 @@ static int eap_peer_tls_reassemble_fragment(struct eap_ssl_data *data,
 
 /**
  * eap_peer_tls_data_reassemble - Reassemble TLS data
+ * @sm: Pointer to EAP state machine allocated with eap_peer_sm_init()
  * @data: Data for TLS processing
  * @in_data: Next incoming TLS segment
  * @need_more_input: Variable for returning whether more input data is needed
@@ -543,14 +572,15 @@ static int eap_peer_tls_reassemble_fragment(struct eap_ssl_data *data,
  * data buffer since an internal pointer to it is maintained.
  */
 static const struct wpabuf * eap_peer_tls_data_reassemble(
-	struct eap_ssl_data *data, const struct wpabuf *in_data,
-	int *need_more_input)
+	struct eap_sm *sm, struct eap_ssl_data *data,
+	const struct wpabuf *in_data, int *need_more_input)
 {
 	*need_more_input = 0;
 
-	if (data->tls_in_left > wpabuf_len(in_data) || data->tls_in) {
+	if (data->tls_in_left > wpabuf_len(in_data) ||
+	    (data->tls_in && wpabuf_len(data->tls_in))) {
 		/* Message has fragments */
-		int res = eap_peer_tls_reassemble_fragment(data, in_data);
+		int res = eap_peer_tls_reassemble_fragment(sm, data, in_data);
 		if (res) {
 			if (res == 1)
 				*need_more_input = 1;
@@ -561,9 +591,9 @@ static const struct wpabuf * eap_peer_tls_data_reassemble(
 	} else {
 		/* No fragments in this message, so just make a copy of it. */
 		data->tls_in_left = 0;
-		data->tls_in = wpabuf_dup(in_data);
-		if (data->tls_in == NULL)
+		if (eap_peer_tls_reserve_input(sm, data, wpabuf_len(in_data)))
 			return NULL;
+		wpabuf_put_buf(data->tls_in, in_data);
 	}
 
 	return data->tls_in;
@@ -587,7 +617,8 @@ static int eap_tls_process_input(struct eap_sm *sm, struct eap_ssl_data *data,
 	int need_more_input;
 	struct wpabuf *appl_data;
 
-	msg = eap_peer_tls_data_reassemble(data, in_data, &need_more_input);
+	msg = eap_peer_tls_data_reassemble(sm, data, in_data,
+					   &need_more_input);
 	if (msg == NULL)
 		return need_more_input ? 1 : -1;
 
@@ -976,8 +1007,16 @@ const u8 * eap_peer_tls_process_init(struct eap_sm *sm,
 		if (data->tls_in_left == 0) {
 			data->tls_in_total = tls_msg_len;
 			data->tls_in_left = tls_msg_len;
-			wpabuf_free(data->tls_in);
-			data->tls_in = NULL;
+			if (data->tls_in)
+				wpabuf_reset(data->tls_in);
+			/*
+			 * Reserve room for the full message at once instead of
+			 * growing the buffer for each fragment. Longer messages
+			 * are rejected in eap_peer_tls_reassemble_fragment().
+			 */
+			if (tls_msg_len <= 65536)
+				eap_peer_tls_reserve_input(sm, data,
+							   tls_msg_len);
 		}
 		pos += 4;
 		left -= 4;
@@ -1005,14 +1044,14 @@ const u8 * eap_peer_tls_process_init(struct eap_sm *sm,
  * eap_peer_tls_reset_input - Reset input buffers
  * @data: Data for TLS processing
  *
- * This function frees any allocated memory for input buffers and resets input
- * state.
+ * This function resets input state. The reassembly buffer is kept for the next
+ * message of the EAP session and freed in eap_peer_tls_ssl_deinit().
  */
 void eap_peer_tls_reset_input(struct eap_ssl_data *data)
 {
 	data->tls_in_left = data->tls_in_total = 0;
-	wpabuf_free(data->tls_in);
-	data->tls_in = NULL;
+	if (data->tls_in)
+		wpabuf_reset(data->tls_in);
 }
 
 
@@ -1046,7 +1085,8 @@ int eap_peer_tls_decrypt(struct eap_sm *sm, struct eap_ssl_data *data,
 	const struct wpabuf *msg;
 	int need_more_input;
 
-	msg = eap_peer_tls_data_reassemble(data, in_data, &need_more_input);
+	msg = eap_peer_tls_data_reassemble(sm, data, in_data,
+					   &need_more_input);
 	if (msg == NULL)
 		return need_more_input ? 1 : -1;
 
@@ -35,6 +35,9 @@ struct eap_ssl_data {
 
 	/**
 	 * tls_in - Received TLS message buffer for re-assembly
+	 *
+	 * The buffer is reused for all received messages of the EAP session.
+	 * An empty buffer means that no message is being reassembled.
 	 */
 	struct wpabuf *tls_in;
 
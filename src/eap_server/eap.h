@@ -31,6 +31,8 @@ struct eap_user {
 	size_t password_len;
 	int password_hash; /* whether password is hashed with
 			    * nt_password_hash() */
+	int nt_hash_set; /* whether nt_hash is valid */
+	u8 nt_hash[16]; /* nt_password_hash() of a plaintext password */
 	u8 *salt;
 	size_t salt_len;
 	int phase2;
@@ -262,6 +264,7 @@ struct eap_config {
 	 */
 	int erp;
 	unsigned int tls_session_lifetime;
+	bool tls_session_tickets;
 	unsigned int tls_flags;
 
 	unsigned int max_auth_rounds;
@@ -276,6 +279,9 @@ struct eap_session_data {
 	const struct wpabuf *assoc_wps_ie;
 	const struct wpabuf *assoc_p2p_ie;
 	const u8 *peer_addr;
+	/* Maximum length of EAP packets on the path to the peer (e.g., from
+	 * the Framed-MTU attribute) or 0 if not known */
+	size_t mtu;
 #ifdef CONFIG_TESTING_OPTIONS
 	u32 tls_test_flags;
 #endif /* CONFIG_TESTING_OPTIONS */
@@ -295,6 +301,7 @@ const u8 * eap_get_identity(struct eap_sm *sm, size_t *len);
 const char * eap_get_serial_num(struct eap_sm *sm);
 const char * eap_get_method(struct eap_sm *sm);
 const char * eap_get_imsi(struct eap_sm *sm);
+unsigned int eap_get_num_rounds(struct eap_sm *sm);
 struct eap_eapol_interface * eap_get_interface(struct eap_sm *sm);
 void eap_server_clear_identity(struct eap_sm *sm);
 void eap_server_mschap_rx_callback(struct eap_sm *sm, const char *source,
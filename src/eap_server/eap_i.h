@@ -192,6 +192,7 @@ struct eap_sm {
 	bool start_reauth;
 
 	u8 peer_addr[ETH_ALEN];
+	size_t mtu; /* path MTU for EAP packets or 0 if not known */
 
 	bool initiate_reauth_start_sent;
 	bool try_initiate_reauth;
@@ -15,6 +15,7 @@
 #include "includes.h"
 
 #include "common.h"
+#include "memstat.h"
 #include "crypto/sha256.h"
 #include "eap_i.h"
 #include "state_machine.h"
@@ -1837,6 +1838,7 @@ void eap_user_free(struct eap_user *user)
 	user->password = NULL;
 	bin_clear_free(user->salt, user->salt_len);
 	user->salt = NULL;
+	forced_memzero(user->nt_hash, sizeof(user->nt_hash));
 	os_free(user);
 }
 
@@ -1870,11 +1872,13 @@ struct eap_sm * eap_server_sm_init(void *eapol_ctx,
 		sm->assoc_p2p_ie = wpabuf_dup(sess->assoc_p2p_ie);
 	if (sess->peer_addr)
 		os_memcpy(sm->peer_addr, sess->peer_addr, ETH_ALEN);
+	sm->mtu = sess->mtu;
 #ifdef CONFIG_TESTING_OPTIONS
 	sm->tls_test_flags = sess->tls_test_flags;
 #endif /* CONFIG_TESTING_OPTIONS */
 
 	wpa_printf(MSG_DEBUG, "EAP: Server state machine created");
+	memstat_alloc(MEMSTAT_EAP, sizeof(*sm));
 
 	return sm;
 }
@@ -1907,6 +1911,7 @@ void eap_server_sm_deinit(struct eap_sm *sm)
 	eap_user_free(sm->user);
 	wpabuf_free(sm->assoc_wps_ie);
 	wpabuf_free(sm->assoc_p2p_ie);
+	memstat_free(MEMSTAT_EAP, sizeof(*sm));
 	os_free(sm);
 }
 
@@ -2006,6 +2011,19 @@ const char * eap_get_imsi(struct eap_sm *sm)
 }
 
 
+/**
+ * eap_get_num_rounds - Get the number of EAP round trips
+ * @sm: Pointer to EAP state machine allocated with eap_server_sm_init()
+ * Returns: Number of EAP responses received in the current authentication
+ */
+unsigned int eap_get_num_rounds(struct eap_sm *sm)
+{
+	if (!sm)
+		return 0;
+	return sm->num_rounds;
+}
+
+
 void eap_erp_update_identity(struct eap_sm *sm, const u8 *eap, size_t len)
 {
 #ifdef CONFIG_ERP
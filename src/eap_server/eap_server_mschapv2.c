@@ -392,11 +392,13 @@ static void eap_mschapv2_process_response(struct eap_sm *sm,
 	wpa_hexdump_ascii(MSG_MSGDUMP, "EAP-MSCHAPV2: User name",
 			  username, username_len);
 
-	if (sm->user->password_hash) {
+	if (sm->user->password_hash || sm->user->nt_hash_set) {
 		res = generate_nt_response_pwhash(data->auth_challenge,
 						  peer_challenge,
 						  username, username_len,
-						  sm->user->password,
+						  sm->user->password_hash ?
+						  sm->user->password :
+						  sm->user->nt_hash,
 						  expected);
 	} else {
 		res = generate_nt_response(data->auth_challenge,
@@ -423,6 +425,8 @@ static void eap_mschapv2_process_response(struct eap_sm *sm,
 		 * not be saved. */
 		if (sm->user->password_hash) {
 			pw_hash = sm->user->password;
+		} else if (sm->user->nt_hash_set) {
+			pw_hash = sm->user->nt_hash;
 		} else {
 			if (nt_password_hash(sm->user->password,
 					     sm->user->password_len,
@@ -88,6 +88,18 @@ static void * eap_tls_init(struct eap_sm *sm)
 
 	data->phase2 = sm->init_phase2;
 
+	if (sm->cfg->tls_session_lifetime && sm->cfg->tls_session_tickets &&
+	    !data->phase2) {
+		struct wpabuf *buf;
+
+		/* Same success data as set in eap_tls_valid_session() */
+		buf = wpabuf_alloc(1);
+		if (buf) {
+			wpabuf_put_u8(buf, data->eap_type);
+			tls_connection_set_ticket_data(data->ssl.conn, buf);
+		}
+	}
+
 	return data;
 }
 
@@ -15,6 +15,10 @@
 #include "eap_tls_common.h"
 
 
+/* Smaller path MTU values are ignored for fragment sizing */
+#define EAP_TLS_MIN_PATH_MTU 256
+
+
 static void eap_server_tls_free_in_buf(struct eap_ssl_data *data);
 
 
@@ -71,7 +75,14 @@ int eap_server_tls_ssl_init(struct eap_sm *sm, struct eap_ssl_data *data,
 #endif /* CONFIG_TESTING_OPTIONS */
 #endif /* CONFIG_TLS_INTERNAL */
 
-	if (eap_type != EAP_TYPE_FAST)
+	/*
+	 * EAP-TLS success data is known once the handshake completes, so it
+	 * can be carried in a stateless session ticket. Other methods need the
+	 * local session cache to validate resumption.
+	 */
+	if (eap_type != EAP_TYPE_FAST &&
+	    (eap_type != EAP_TYPE_TLS || !sm->cfg->tls_session_tickets ||
+	     sm->init_phase2))
 		flags |= TLS_CONN_DISABLE_SESSION_TICKET;
 	os_memcpy(session_ctx, "hostapd", 7);
 	session_ctx[7] = (u8) eap_type;
@@ -87,6 +98,23 @@ int eap_server_tls_ssl_init(struct eap_sm *sm, struct eap_ssl_data *data,
 
 	data->tls_out_limit = sm->cfg->fragment_size > 0 ?
 		sm->cfg->fragment_size : 1398;
+	if (sm->mtu >= EAP_TLS_MIN_PATH_MTU && !data->phase2) {
+		size_t hdr_len, limit;
+
+		/* Fit each fragment in the path MTU. Without an explicitly
+		 * configured fragment_size, use larger fragments when the path
+		 * allows to reduce the number of round trips. */
+		hdr_len = (eap_type == EAP_UNAUTH_TLS_TYPE ||
+			   eap_type == EAP_WFA_UNAUTH_TLS_TYPE) ?
+			sizeof(struct eap_hdr) + 8 : sizeof(struct eap_hdr) + 1;
+		limit = sm->mtu - hdr_len;
+		if (sm->cfg->fragment_size <= 0 || limit < data->tls_out_limit)
+			data->tls_out_limit = limit;
+		wpa_printf(MSG_DEBUG,
+			   "SSL: Fragment size %u for path MTU %u",
+			   (unsigned int) data->tls_out_limit,
+			   (unsigned int) sm->mtu);
+	}
 	if (data->phase2) {
 		/* Limit the fragment size in the inner TLS authentication
 		 * since the outer authentication with EAP-PEAP does not yet
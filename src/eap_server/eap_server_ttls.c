@@ -669,7 +669,9 @@ static void eap_ttls_process_phase2_mschap(struct eap_sm *sm,
 
 	if ((sm->user->password_hash &&
 	     challenge_response(challenge, sm->user->password, nt_response)) ||
-	    (!sm->user->password_hash &&
+	    (!sm->user->password_hash && sm->user->nt_hash_set &&
+	     challenge_response(challenge, sm->user->nt_hash, nt_response)) ||
+	    (!sm->user->password_hash && !sm->user->nt_hash_set &&
 	     nt_challenge_response(challenge, sm->user->password,
 				   sm->user->password_len, nt_response))) {
 		eap_ttls_state(data, FAILURE);
@@ -769,10 +771,12 @@ static void eap_ttls_process_phase2_mschapv2(struct eap_sm *sm,
 	wpa_hexdump(MSG_MSGDUMP, "EAP-TTLS/MSCHAPV2: peer_challenge",
 		    peer_challenge, EAP_TTLS_MSCHAPV2_CHALLENGE_LEN);
 
-	if (sm->user->password_hash) {
+	if (sm->user->password_hash || sm->user->nt_hash_set) {
 		generate_nt_response_pwhash(auth_challenge, peer_challenge,
 					    username, username_len,
-					    sm->user->password,
+					    sm->user->password_hash ?
+					    sm->user->password :
+					    sm->user->nt_hash,
 					    nt_response);
 	} else {
 		generate_nt_response(auth_challenge, peer_challenge,
@@ -800,9 +804,10 @@ static void eap_ttls_process_phase2_mschapv2(struct eap_sm *sm,
 			   "NT-Response");
 		data->mschapv2_resp_ok = 1;
 
-		if (sm->user->password_hash) {
+		if (sm->user->password_hash || sm->user->nt_hash_set) {
 			generate_authenticator_response_pwhash(
-				sm->user->password,
+				sm->user->password_hash ?
+				sm->user->password : sm->user->nt_hash,
 				peer_challenge, auth_challenge,
 				username, username_len, nt_response,
 				data->mschapv2_auth_response);
@@ -28,17 +28,29 @@
 #include "eloop.h"
 
 struct eap_sim_pseudonym {
-	struct eap_sim_pseudonym *next;
+	struct dl_list list; /* least recently used last */
+	struct eap_sim_pseudonym *hnext_permanent;
+	struct eap_sim_pseudonym *hnext_pseudonym;
 	char *permanent; /* permanent username */
 	char *pseudonym; /* pseudonym username */
 };
 
+/* Number of hash buckets for pending queries (power of two) */
+#define EAP_SIM_DB_PENDING_HASH 64
+
+/* Number of hash buckets for pseudonyms and reauth_ids (power of two) */
+#define EAP_SIM_DB_ID_HASH 1024
+
+/* Time to keep a prefetched, not yet used authentication vector (seconds) */
+#define EAP_SIM_DB_PREFETCH_LIFETIME 300
+
 struct eap_sim_db_pending {
 	struct eap_sim_db_pending *next;
 	char imsi[20];
 	enum { PENDING, SUCCESS, FAILURE } state;
 	void *cb_session_ctx;
 	int aka;
+	int prefetch; /* requested ahead of need; counted in num_prefetch */
 	union {
 		struct {
 			u8 kc[EAP_SIM_MAX_CHAL][EAP_SIM_KC_LEN];
@@ -63,10 +75,19 @@ struct eap_sim_db_data {
 	char *local_sock;
 	void (*get_complete_cb)(void *ctx, void *session_ctx);
 	void *ctx;
-	struct eap_sim_pseudonym *pseudonyms;
-	struct eap_sim_reauth *reauths;
-	struct eap_sim_db_pending *pending;
+	struct dl_list pseudonyms;
+	struct eap_sim_pseudonym *pseudonym_permanent[EAP_SIM_DB_ID_HASH];
+	struct eap_sim_pseudonym *pseudonym_pseudonym[EAP_SIM_DB_ID_HASH];
+	unsigned int num_pseudonyms;
+	struct dl_list reauths;
+	struct eap_sim_reauth *reauth_permanent[EAP_SIM_DB_ID_HASH];
+	struct eap_sim_reauth *reauth_reauth_id[EAP_SIM_DB_ID_HASH];
+	unsigned int num_reauths;
+	unsigned int max_identities;
+	struct eap_sim_db_pending *pending[EAP_SIM_DB_PENDING_HASH];
 	unsigned int eap_sim_db_timeout;
+	unsigned int prefetch_max;
+	unsigned int num_prefetch;
 #ifdef CONFIG_SQLITE
 	sqlite3 *sqlite_db;
 	char db_tmp_identity[100];
@@ -161,6 +182,21 @@ static sqlite3 * db_open(const char *db_file)
 		return NULL;
 	}
 
+	/*
+	 * Pseudonyms and reauth_ids are looked up by the identity the peer
+	 * used. The database can be shared by multiple hostapd processes, so
+	 * wait for a while for the lock of another writer to be released.
+	 */
+	if (sqlite3_exec(db,
+			 "CREATE INDEX IF NOT EXISTS pseudonyms_pseudonym "
+			 "ON pseudonyms(pseudonym);"
+			 "CREATE INDEX IF NOT EXISTS reauth_reauth_id "
+			 "ON reauth(reauth_id);", NULL, NULL, NULL) !=
+	    SQLITE_OK)
+		wpa_printf(MSG_INFO, "EAP-SIM DB: Failed to add indexes: %s",
+			   sqlite3_errmsg(db));
+	sqlite3_busy_timeout(db, 1000);
+
 	return db;
 }
 
@@ -373,22 +409,38 @@ static void db_remove_reauth(struct eap_sim_db_data *data,
 #endif /* CONFIG_SQLITE */
 
 
+static unsigned int eap_sim_db_hash(const char *str)
+{
+	unsigned int hash = 0;
+
+	while (*str)
+		hash = hash * 31 + (u8) *str++;
+	return hash;
+}
+
+
+static struct eap_sim_db_pending **
+eap_sim_db_pending_bucket(struct eap_sim_db_data *data, const char *imsi,
+			  int aka)
+{
+	unsigned int hash = eap_sim_db_hash(imsi) + aka;
+
+	return &data->pending[hash & (EAP_SIM_DB_PENDING_HASH - 1)];
+}
+
+
 static struct eap_sim_db_pending *
 eap_sim_db_get_pending(struct eap_sim_db_data *data, const char *imsi, int aka)
 {
-	struct eap_sim_db_pending *entry, *prev = NULL;
+	struct eap_sim_db_pending **pp, *entry;
 
-	entry = data->pending;
-	while (entry) {
+	pp = eap_sim_db_pending_bucket(data, imsi, aka);
+	while ((entry = *pp) != NULL) {
 		if (entry->aka == aka && os_strcmp(entry->imsi, imsi) == 0) {
-			if (prev)
-				prev->next = entry->next;
-			else
-				data->pending = entry->next;
+			*pp = entry->next;
 			break;
 		}
-		prev = entry;
-		entry = entry->next;
+		pp = &entry->next;
 	}
 	return entry;
 }
@@ -397,8 +449,11 @@ eap_sim_db_get_pending(struct eap_sim_db_data *data, const char *imsi, int aka)
 static void eap_sim_db_add_pending(struct eap_sim_db_data *data,
 				   struct eap_sim_db_pending *entry)
 {
-	entry->next = data->pending;
-	data->pending = entry;
+	struct eap_sim_db_pending **pp;
+
+	pp = eap_sim_db_pending_bucket(data, entry->imsi, entry->aka);
+	entry->next = *pp;
+	*pp = entry;
 }
 
 
@@ -407,14 +462,18 @@ static void eap_sim_db_free_pending(struct eap_sim_db_data *data,
 {
 	eloop_cancel_timeout(eap_sim_db_query_timeout, data, entry);
 	eloop_cancel_timeout(eap_sim_db_del_timeout, data, entry);
-	os_free(entry);
+	if (entry->prefetch)
+		data->num_prefetch--;
+	bin_clear_free(entry, sizeof(*entry));
 }
 
 
 static void eap_sim_db_del_pending(struct eap_sim_db_data *data,
 				   struct eap_sim_db_pending *entry)
 {
-	struct eap_sim_db_pending **pp = &data->pending;
+	struct eap_sim_db_pending **pp;
+
+	pp = eap_sim_db_pending_bucket(data, entry->imsi, entry->aka);
 
 	while (*pp != NULL) {
 		if (*pp == entry) {
@@ -447,12 +506,42 @@ static void eap_sim_db_query_timeout(void *eloop_ctx, void *user_ctx)
 	 * before deleting the query.
 	 */
 	wpa_printf(MSG_DEBUG, "EAP-SIM DB: Query timeout for %p", entry);
+	if (!entry->cb_session_ctx) {
+		/* Prefetch query that nobody is waiting for */
+		eap_sim_db_del_pending(data, entry);
+		return;
+	}
 	entry->state = FAILURE;
 	data->get_complete_cb(data->ctx, entry->cb_session_ctx);
 	eloop_register_timeout(1, 0, eap_sim_db_del_timeout, data, entry);
 }
 
 
+static void eap_sim_db_complete(struct eap_sim_db_data *data,
+				struct eap_sim_db_pending *entry)
+{
+	if (!entry->cb_session_ctx) {
+		/*
+		 * Prefetched authentication data is stored for the next
+		 * authentication of the subscriber instead of the query
+		 * timeout.
+		 */
+		if (entry->state == FAILURE) {
+			eap_sim_db_free_pending(data, entry);
+			return;
+		}
+		eloop_cancel_timeout(eap_sim_db_query_timeout, data, entry);
+		eap_sim_db_add_pending(data, entry);
+		eloop_register_timeout(EAP_SIM_DB_PREFETCH_LIFETIME, 0,
+				       eap_sim_db_del_timeout, data, entry);
+		return;
+	}
+
+	eap_sim_db_add_pending(data, entry);
+	data->get_complete_cb(data->ctx, entry->cb_session_ctx);
+}
+
+
 static void eap_sim_db_sim_resp_auth(struct eap_sim_db_data *data,
 				     const char *imsi, char *buf)
 {
@@ -478,8 +567,7 @@ static void eap_sim_db_sim_resp_auth(struct eap_sim_db_data *data,
 		wpa_printf(MSG_DEBUG, "EAP-SIM DB: External server reported "
 			   "failure");
 		entry->state = FAILURE;
-		eap_sim_db_add_pending(data, entry);
-		data->get_complete_cb(data->ctx, entry->cb_session_ctx);
+		eap_sim_db_complete(data, entry);
 		return;
 	}
 
@@ -522,8 +610,7 @@ static void eap_sim_db_sim_resp_auth(struct eap_sim_db_data *data,
 	entry->state = SUCCESS;
 	wpa_printf(MSG_DEBUG, "EAP-SIM DB: Authentication data parsed "
 		   "successfully - callback");
-	eap_sim_db_add_pending(data, entry);
-	data->get_complete_cb(data->ctx, entry->cb_session_ctx);
+	eap_sim_db_complete(data, entry);
 	return;
 
 parse_fail:
@@ -556,8 +643,7 @@ static void eap_sim_db_aka_resp_auth(struct eap_sim_db_data *data,
 		wpa_printf(MSG_DEBUG, "EAP-SIM DB: External server reported "
 			   "failure");
 		entry->state = FAILURE;
-		eap_sim_db_add_pending(data, entry);
-		data->get_complete_cb(data->ctx, entry->cb_session_ctx);
+		eap_sim_db_complete(data, entry);
 		return;
 	}
 
@@ -613,8 +699,7 @@ static void eap_sim_db_aka_resp_auth(struct eap_sim_db_data *data,
 	entry->state = SUCCESS;
 	wpa_printf(MSG_DEBUG, "EAP-SIM DB: Authentication data parsed "
 		   "successfully - callback");
-	eap_sim_db_add_pending(data, entry);
-	data->get_complete_cb(data->ctx, entry->cb_session_ctx);
+	eap_sim_db_complete(data, entry);
 	return;
 
 parse_fail:
@@ -757,25 +842,37 @@ eap_sim_db_init(const char *config, unsigned int db_timeout,
 		void *ctx)
 {
 	struct eap_sim_db_data *data;
-	char *pos;
+	char *pos, *db;
 
 	data = os_zalloc(sizeof(*data));
 	if (data == NULL)
 		return NULL;
 
 	data->sock = -1;
+	dl_list_init(&data->pseudonyms);
+	dl_list_init(&data->reauths);
 	data->get_complete_cb = get_complete_cb;
 	data->ctx = ctx;
 	data->eap_sim_db_timeout = db_timeout;
 	data->fname = os_strdup(config);
 	if (data->fname == NULL)
 		goto fail;
-	pos = os_strstr(data->fname, " db=");
+	db = os_strstr(data->fname, " db=");
+	pos = os_strstr(data->fname, " prefetch=");
 	if (pos) {
 		*pos = '\0';
+		data->prefetch_max = atoi(pos + 10);
+	}
+	pos = os_strstr(data->fname, " max_identities=");
+	if (pos) {
+		*pos = '\0';
+		data->max_identities = atoi(pos + 16);
+	}
+	if (db) {
+		*db = '\0';
 #ifdef CONFIG_SQLITE
-		pos += 4;
-		data->sqlite_db = db_open(pos);
+		db += 4;
+		data->sqlite_db = db_open(db);
 		if (data->sqlite_db == NULL)
 			goto fail;
 #endif /* CONFIG_SQLITE */
@@ -825,6 +922,7 @@ void eap_sim_db_deinit(void *priv)
 	struct eap_sim_pseudonym *p, *prev;
 	struct eap_sim_reauth *r, *prevr;
 	struct eap_sim_db_pending *pending, *prev_pending;
+	unsigned int i;
 
 #ifdef CONFIG_SQLITE
 	if (data->sqlite_db) {
@@ -836,25 +934,21 @@ void eap_sim_db_deinit(void *priv)
 	eap_sim_db_close_socket(data);
 	os_free(data->fname);
 
-	p = data->pseudonyms;
-	while (p) {
-		prev = p;
-		p = p->next;
-		eap_sim_db_free_pseudonym(prev);
-	}
+	dl_list_for_each_safe(p, prev, &data->pseudonyms,
+			      struct eap_sim_pseudonym, list)
+		eap_sim_db_free_pseudonym(p);
 
-	r = data->reauths;
-	while (r) {
-		prevr = r;
-		r = r->next;
-		eap_sim_db_free_reauth(prevr);
-	}
+	dl_list_for_each_safe(r, prevr, &data->reauths,
+			      struct eap_sim_reauth, list)
+		eap_sim_db_free_reauth(r);
 
-	pending = data->pending;
-	while (pending) {
-		prev_pending = pending;
-		pending = pending->next;
-		eap_sim_db_free_pending(data, prev_pending);
+	for (i = 0; i < EAP_SIM_DB_PENDING_HASH; i++) {
+		pending = data->pending[i];
+		while (pending) {
+			prev_pending = pending;
+			pending = pending->next;
+			eap_sim_db_free_pending(data, prev_pending);
+		}
 	}
 
 	os_free(data);
@@ -899,6 +993,131 @@ static void eap_sim_db_expire_pending(struct eap_sim_db_data *data,
 }
 
 
+static int eap_sim_db_send_sim_req(struct eap_sim_db_data *data,
+				   const char *imsi, int max_chal)
+{
+	int len, ret;
+	char msg[40];
+	size_t imsi_len;
+
+	if (data->sock < 0) {
+		if (eap_sim_db_open_socket(data) < 0)
+			return -1;
+	}
+
+	imsi_len = os_strlen(imsi);
+	len = os_snprintf(msg, sizeof(msg), "SIM-REQ-AUTH ");
+	if (os_snprintf_error(sizeof(msg), len) ||
+	    len + imsi_len >= sizeof(msg))
+		return -1;
+	os_memcpy(msg + len, imsi, imsi_len);
+	len += imsi_len;
+	ret = os_snprintf(msg + len, sizeof(msg) - len, " %d", max_chal);
+	if (os_snprintf_error(sizeof(msg) - len, ret))
+		return -1;
+	len += ret;
+
+	wpa_printf(MSG_DEBUG, "EAP-SIM DB: requesting SIM authentication "
+		   "data for IMSI '%s'", imsi);
+	return eap_sim_db_send(data, msg, len);
+}
+
+
+static int eap_sim_db_send_aka_req(struct eap_sim_db_data *data,
+				   const char *imsi)
+{
+	int len;
+	char msg[40];
+	size_t imsi_len;
+
+	if (data->sock < 0) {
+		if (eap_sim_db_open_socket(data) < 0)
+			return -1;
+	}
+
+	imsi_len = os_strlen(imsi);
+	len = os_snprintf(msg, sizeof(msg), "AKA-REQ-AUTH ");
+	if (os_snprintf_error(sizeof(msg), len) ||
+	    len + imsi_len >= sizeof(msg))
+		return -1;
+	os_memcpy(msg + len, imsi, imsi_len);
+	len += imsi_len;
+
+	wpa_printf(MSG_DEBUG, "EAP-SIM DB: requesting AKA authentication "
+		    "data for IMSI '%s'", imsi);
+	return eap_sim_db_send(data, msg, len);
+}
+
+
+static struct eap_sim_db_pending *
+eap_sim_db_add_query(struct eap_sim_db_data *data, const char *imsi, int aka,
+		     void *cb_session_ctx)
+{
+	struct eap_sim_db_pending *entry;
+
+	entry = os_zalloc(sizeof(*entry));
+	if (entry == NULL)
+		return NULL;
+
+	entry->aka = aka;
+	os_strlcpy(entry->imsi, imsi, sizeof(entry->imsi));
+	entry->cb_session_ctx = cb_session_ctx;
+	entry->state = PENDING;
+	eap_sim_db_add_pending(data, entry);
+	eap_sim_db_expire_pending(data, entry);
+	wpa_printf(MSG_DEBUG, "EAP-SIM DB: Added query %p", entry);
+
+	return entry;
+}
+
+
+/*
+ * Request the authentication data for the next authentication of a subscriber
+ * while the current one is being used so that it will be available without
+ * a round trip to the HLR/AuC gateway. The number of subscribers with
+ * prefetched data is limited by the prefetch=<count> parameter.
+ */
+static void eap_sim_db_prefetch(struct eap_sim_db_data *data,
+				const char *imsi, int aka, int max_chal)
+{
+	struct eap_sim_db_pending *entry;
+
+	if (data->num_prefetch >= data->prefetch_max)
+		return;
+
+	entry = eap_sim_db_get_pending(data, imsi, aka);
+	if (entry) {
+		eap_sim_db_add_pending(data, entry);
+		return;
+	}
+
+	if ((aka ? eap_sim_db_send_aka_req(data, imsi) :
+	     eap_sim_db_send_sim_req(data, imsi, max_chal)) < 0)
+		return;
+
+	entry = eap_sim_db_add_query(data, imsi, aka, NULL);
+	if (entry) {
+		entry->prefetch = 1;
+		data->num_prefetch++;
+	}
+}
+
+
+/* Let a session wait for a prefetch query that is still in progress */
+static void eap_sim_db_claim_pending(struct eap_sim_db_data *data,
+				     struct eap_sim_db_pending *entry,
+				     void *cb_session_ctx)
+{
+	if (entry->cb_session_ctx)
+		return;
+	entry->cb_session_ctx = cb_session_ctx;
+	if (entry->prefetch) {
+		entry->prefetch = 0;
+		data->num_prefetch--;
+	}
+}
+
+
 /**
  * eap_sim_db_get_gsm_triplets - Get GSM triplets
  * @data: Private data pointer from eap_sim_db_init()
@@ -928,10 +1147,7 @@ int eap_sim_db_get_gsm_triplets(struct eap_sim_db_data *data,
 				void *cb_session_ctx)
 {
 	struct eap_sim_db_pending *entry;
-	int len, ret;
-	char msg[40];
 	const char *imsi;
-	size_t imsi_len;
 
 	if (username == NULL || username[0] != EAP_SIM_PERMANENT_PREFIX ||
 	    username[1] == '\0' || os_strlen(username) > sizeof(entry->imsi)) {
@@ -956,6 +1172,7 @@ int eap_sim_db_get_gsm_triplets(struct eap_sim_db_data *data,
 		if (entry->state == PENDING) {
 			wpa_printf(MSG_DEBUG, "EAP-SIM DB: Pending entry -> "
 				   "still pending");
+			eap_sim_db_claim_pending(data, entry, cb_session_ctx);
 			eap_sim_db_add_pending(data, entry);
 			return EAP_SIM_DB_PENDING;
 		}
@@ -970,41 +1187,13 @@ int eap_sim_db_get_gsm_triplets(struct eap_sim_db_data *data,
 			  num_chal * EAP_SIM_SRES_LEN);
 		os_memcpy(kc, entry->u.sim.kc, num_chal * EAP_SIM_KC_LEN);
 		eap_sim_db_free_pending(data, entry);
+		eap_sim_db_prefetch(data, imsi, 0, max_chal);
 		return num_chal;
 	}
 
-	if (data->sock < 0) {
-		if (eap_sim_db_open_socket(data) < 0)
-			return EAP_SIM_DB_FAILURE;
-	}
-
-	imsi_len = os_strlen(imsi);
-	len = os_snprintf(msg, sizeof(msg), "SIM-REQ-AUTH ");
-	if (os_snprintf_error(sizeof(msg), len) ||
-	    len + imsi_len >= sizeof(msg))
+	if (eap_sim_db_send_sim_req(data, imsi, max_chal) < 0 ||
+	    !eap_sim_db_add_query(data, imsi, 0, cb_session_ctx))
 		return EAP_SIM_DB_FAILURE;
-	os_memcpy(msg + len, imsi, imsi_len);
-	len += imsi_len;
-	ret = os_snprintf(msg + len, sizeof(msg) - len, " %d", max_chal);
-	if (os_snprintf_error(sizeof(msg) - len, ret))
-		return EAP_SIM_DB_FAILURE;
-	len += ret;
-
-	wpa_printf(MSG_DEBUG, "EAP-SIM DB: requesting SIM authentication "
-		   "data for IMSI '%s'", imsi);
-	if (eap_sim_db_send(data, msg, len) < 0)
-		return EAP_SIM_DB_FAILURE;
-
-	entry = os_zalloc(sizeof(*entry));
-	if (entry == NULL)
-		return EAP_SIM_DB_FAILURE;
-
-	os_strlcpy(entry->imsi, imsi, sizeof(entry->imsi));
-	entry->cb_session_ctx = cb_session_ctx;
-	entry->state = PENDING;
-	eap_sim_db_add_pending(data, entry);
-	eap_sim_db_expire_pending(data, entry);
-	wpa_printf(MSG_DEBUG, "EAP-SIM DB: Added query %p", entry);
 
 	return EAP_SIM_DB_PENDING;
 }
@@ -1095,6 +1284,126 @@ char * eap_sim_db_get_next_reauth_id(struct eap_sim_db_data *data,
 }
 
 
+/*
+ * The in-memory pseudonyms and reauth_ids are kept in hash tables indexed by
+ * both the permanent username and the temporary identity. They are also kept
+ * in a list ordered by the time of the last use so that the least recently
+ * used entries can be expired once there are more than max_identities of
+ * them.
+ */
+
+#define EAP_SIM_DB_ID_IDX(str) (eap_sim_db_hash(str) & (EAP_SIM_DB_ID_HASH - 1))
+
+static void eap_sim_db_hash_pseudonym(struct eap_sim_db_data *data,
+				      struct eap_sim_pseudonym *p)
+{
+	unsigned int idx;
+
+	idx = EAP_SIM_DB_ID_IDX(p->permanent);
+	p->hnext_permanent = data->pseudonym_permanent[idx];
+	data->pseudonym_permanent[idx] = p;
+
+	idx = EAP_SIM_DB_ID_IDX(p->pseudonym);
+	p->hnext_pseudonym = data->pseudonym_pseudonym[idx];
+	data->pseudonym_pseudonym[idx] = p;
+}
+
+
+static void eap_sim_db_unhash_pseudonym(struct eap_sim_db_data *data,
+					struct eap_sim_pseudonym *p)
+{
+	struct eap_sim_pseudonym **pp;
+
+	pp = &data->pseudonym_permanent[EAP_SIM_DB_ID_IDX(p->permanent)];
+	while (*pp && *pp != p)
+		pp = &(*pp)->hnext_permanent;
+	if (*pp)
+		*pp = p->hnext_permanent;
+
+	pp = &data->pseudonym_pseudonym[EAP_SIM_DB_ID_IDX(p->pseudonym)];
+	while (*pp && *pp != p)
+		pp = &(*pp)->hnext_pseudonym;
+	if (*pp)
+		*pp = p->hnext_pseudonym;
+}
+
+
+static void eap_sim_db_expire_pseudonyms(struct eap_sim_db_data *data)
+{
+	struct eap_sim_pseudonym *p;
+
+	while (data->max_identities &&
+	       data->num_pseudonyms > data->max_identities) {
+		p = dl_list_last(&data->pseudonyms, struct eap_sim_pseudonym,
+				 list);
+		wpa_printf(MSG_DEBUG, "EAP-SIM DB: Expire pseudonym '%s'",
+			   p->pseudonym);
+		eap_sim_db_unhash_pseudonym(data, p);
+		dl_list_del(&p->list);
+		data->num_pseudonyms--;
+		eap_sim_db_free_pseudonym(p);
+	}
+}
+
+
+static void eap_sim_db_hash_reauth(struct eap_sim_db_data *data,
+				   struct eap_sim_reauth *r)
+{
+	unsigned int idx;
+
+	idx = EAP_SIM_DB_ID_IDX(r->permanent);
+	r->hnext_permanent = data->reauth_permanent[idx];
+	data->reauth_permanent[idx] = r;
+
+	idx = EAP_SIM_DB_ID_IDX(r->reauth_id);
+	r->hnext_reauth_id = data->reauth_reauth_id[idx];
+	data->reauth_reauth_id[idx] = r;
+}
+
+
+static void eap_sim_db_unhash_reauth(struct eap_sim_db_data *data,
+				     struct eap_sim_reauth *r)
+{
+	struct eap_sim_reauth **pp;
+
+	pp = &data->reauth_permanent[EAP_SIM_DB_ID_IDX(r->permanent)];
+	while (*pp && *pp != r)
+		pp = &(*pp)->hnext_permanent;
+	if (*pp)
+		*pp = r->hnext_permanent;
+
+	pp = &data->reauth_reauth_id[EAP_SIM_DB_ID_IDX(r->reauth_id)];
+	while (*pp && *pp != r)
+		pp = &(*pp)->hnext_reauth_id;
+	if (*pp)
+		*pp = r->hnext_reauth_id;
+}
+
+
+static void eap_sim_db_del_reauth(struct eap_sim_db_data *data,
+				  struct eap_sim_reauth *r)
+{
+	eap_sim_db_unhash_reauth(data, r);
+	dl_list_del(&r->list);
+	data->num_reauths--;
+	eap_sim_db_free_reauth(r);
+}
+
+
+static void eap_sim_db_expire_reauths(struct eap_sim_db_data *data)
+{
+	struct eap_sim_reauth *r;
+
+	while (data->max_identities &&
+	       data->num_reauths > data->max_identities) {
+		r = dl_list_last(&data->reauths, struct eap_sim_reauth, list);
+		wpa_printf(MSG_DEBUG, "EAP-SIM DB: Expire reauth_id '%s'",
+			   r->reauth_id);
+		eap_sim_db_del_reauth(data, r);
+	}
+}
+
+
 /**
  * eap_sim_db_add_pseudonym - EAP-SIM DB: Add new pseudonym
  * @data: Private data pointer from eap_sim_db_init()
@@ -1119,15 +1428,20 @@ int eap_sim_db_add_pseudonym(struct eap_sim_db_data *data,
 	if (data->sqlite_db)
 		return db_add_pseudonym(data, permanent, pseudonym);
 #endif /* CONFIG_SQLITE */
-	for (p = data->pseudonyms; p; p = p->next) {
+	for (p = data->pseudonym_permanent[EAP_SIM_DB_ID_IDX(permanent)]; p;
+	     p = p->hnext_permanent) {
 		if (os_strcmp(permanent, p->permanent) == 0)
 			break;
 	}
 	if (p) {
 		wpa_printf(MSG_DEBUG, "EAP-SIM DB: Replacing previous "
 			   "pseudonym: %s", p->pseudonym);
+		eap_sim_db_unhash_pseudonym(data, p);
 		os_free(p->pseudonym);
 		p->pseudonym = pseudonym;
+		eap_sim_db_hash_pseudonym(data, p);
+		dl_list_del(&p->list);
+		dl_list_add(&data->pseudonyms, &p->list);
 		return 0;
 	}
 
@@ -1137,7 +1451,6 @@ int eap_sim_db_add_pseudonym(struct eap_sim_db_data *data,
 		return -1;
 	}
 
-	p->next = data->pseudonyms;
 	p->permanent = os_strdup(permanent);
 	if (p->permanent == NULL) {
 		os_free(p);
@@ -1145,7 +1458,10 @@ int eap_sim_db_add_pseudonym(struct eap_sim_db_data *data,
 		return -1;
 	}
 	p->pseudonym = pseudonym;
-	data->pseudonyms = p;
+	eap_sim_db_hash_pseudonym(data, p);
+	dl_list_add(&data->pseudonyms, &p->list);
+	data->num_pseudonyms++;
+	eap_sim_db_expire_pseudonyms(data);
 
 	wpa_printf(MSG_DEBUG, "EAP-SIM DB: Added new pseudonym entry");
 	return 0;
@@ -1159,7 +1475,8 @@ eap_sim_db_add_reauth_data(struct eap_sim_db_data *data,
 {
 	struct eap_sim_reauth *r;
 
-	for (r = data->reauths; r; r = r->next) {
+	for (r = data->reauth_permanent[EAP_SIM_DB_ID_IDX(permanent)]; r;
+	     r = r->hnext_permanent) {
 		if (os_strcmp(r->permanent, permanent) == 0)
 			break;
 	}
@@ -1167,8 +1484,12 @@ eap_sim_db_add_reauth_data(struct eap_sim_db_data *data,
 	if (r) {
 		wpa_printf(MSG_DEBUG, "EAP-SIM DB: Replacing previous "
 			   "reauth_id: %s", r->reauth_id);
+		eap_sim_db_unhash_reauth(data, r);
 		os_free(r->reauth_id);
 		r->reauth_id = reauth_id;
+		eap_sim_db_hash_reauth(data, r);
+		dl_list_del(&r->list);
+		dl_list_add(&data->reauths, &r->list);
 	} else {
 		r = os_zalloc(sizeof(*r));
 		if (r == NULL) {
@@ -1176,7 +1497,6 @@ eap_sim_db_add_reauth_data(struct eap_sim_db_data *data,
 			return NULL;
 		}
 
-		r->next = data->reauths;
 		r->permanent = os_strdup(permanent);
 		if (r->permanent == NULL) {
 			os_free(r);
@@ -1184,7 +1504,10 @@ eap_sim_db_add_reauth_data(struct eap_sim_db_data *data,
 			return NULL;
 		}
 		r->reauth_id = reauth_id;
-		data->reauths = r;
+		eap_sim_db_hash_reauth(data, r);
+		dl_list_add(&data->reauths, &r->list);
+		data->num_reauths++;
+		eap_sim_db_expire_reauths(data);
 		wpa_printf(MSG_DEBUG, "EAP-SIM DB: Added new reauth entry");
 	}
 
@@ -1295,11 +1618,13 @@ eap_sim_db_get_permanent(struct eap_sim_db_data *data, const char *pseudonym)
 		return db_get_pseudonym(data, pseudonym);
 #endif /* CONFIG_SQLITE */
 
-	p = data->pseudonyms;
-	while (p) {
-		if (os_strcmp(p->pseudonym, pseudonym) == 0)
+	for (p = data->pseudonym_pseudonym[EAP_SIM_DB_ID_IDX(pseudonym)]; p;
+	     p = p->hnext_pseudonym) {
+		if (os_strcmp(p->pseudonym, pseudonym) == 0) {
+			dl_list_del(&p->list);
+			dl_list_add(&data->pseudonyms, &p->list);
 			return p->permanent;
-		p = p->next;
+		}
 	}
 
 	return NULL;
@@ -1323,11 +1648,13 @@ eap_sim_db_get_reauth_entry(struct eap_sim_db_data *data,
 		return db_get_reauth(data, reauth_id);
 #endif /* CONFIG_SQLITE */
 
-	r = data->reauths;
-	while (r) {
-		if (os_strcmp(r->reauth_id, reauth_id) == 0)
+	for (r = data->reauth_reauth_id[EAP_SIM_DB_ID_IDX(reauth_id)]; r;
+	     r = r->hnext_reauth_id) {
+		if (os_strcmp(r->reauth_id, reauth_id) == 0) {
+			dl_list_del(&r->list);
+			dl_list_add(&data->reauths, &r->list);
 			break;
-		r = r->next;
+		}
 	}
 
 	return r;
@@ -1343,25 +1670,22 @@ eap_sim_db_get_reauth_entry(struct eap_sim_db_data *data,
 void eap_sim_db_remove_reauth(struct eap_sim_db_data *data,
 			      struct eap_sim_reauth *reauth)
 {
-	struct eap_sim_reauth *r, *prev = NULL;
+	struct eap_sim_reauth *r;
 #ifdef CONFIG_SQLITE
 	if (data->sqlite_db) {
 		db_remove_reauth(data, reauth);
 		return;
 	}
 #endif /* CONFIG_SQLITE */
-	r = data->reauths;
-	while (r) {
+	/*
+	 * The entry may have been expired since the session looked it up, so
+	 * only compare the pointer until it is found in the database.
+	 */
+	dl_list_for_each(r, &data->reauths, struct eap_sim_reauth, list) {
 		if (r == reauth) {
-			if (prev)
-				prev->next = r->next;
-			else
-				data->reauths = r->next;
-			eap_sim_db_free_reauth(r);
+			eap_sim_db_del_reauth(data, r);
 			return;
 		}
-		prev = r;
-		r = r->next;
 	}
 }
 
@@ -1395,10 +1719,7 @@ int eap_sim_db_get_aka_auth(struct eap_sim_db_data *data, const char *username,
 			    u8 *res, size_t *res_len, void *cb_session_ctx)
 {
 	struct eap_sim_db_pending *entry;
-	int len;
-	char msg[40];
 	const char *imsi;
-	size_t imsi_len;
 
 	if (username == NULL ||
 	    (username[0] != EAP_AKA_PERMANENT_PREFIX &&
@@ -1421,6 +1742,7 @@ int eap_sim_db_get_aka_auth(struct eap_sim_db_data *data, const char *username,
 		}
 
 		if (entry->state == PENDING) {
+			eap_sim_db_claim_pending(data, entry, cb_session_ctx);
 			eap_sim_db_add_pending(data, entry);
 			wpa_printf(MSG_DEBUG, "EAP-SIM DB: Pending");
 			return EAP_SIM_DB_PENDING;
@@ -1435,39 +1757,14 @@ int eap_sim_db_get_aka_auth(struct eap_sim_db_data *data, const char *username,
 		os_memcpy(res, entry->u.aka.res, EAP_AKA_RES_MAX_LEN);
 		*res_len = entry->u.aka.res_len;
 		eap_sim_db_free_pending(data, entry);
+		eap_sim_db_prefetch(data, imsi, 1, 0);
 		return 0;
 	}
 
-	if (data->sock < 0) {
-		if (eap_sim_db_open_socket(data) < 0)
-			return EAP_SIM_DB_FAILURE;
-	}
-
-	imsi_len = os_strlen(imsi);
-	len = os_snprintf(msg, sizeof(msg), "AKA-REQ-AUTH ");
-	if (os_snprintf_error(sizeof(msg), len) ||
-	    len + imsi_len >= sizeof(msg))
-		return EAP_SIM_DB_FAILURE;
-	os_memcpy(msg + len, imsi, imsi_len);
-	len += imsi_len;
-
-	wpa_printf(MSG_DEBUG, "EAP-SIM DB: requesting AKA authentication "
-		    "data for IMSI '%s'", imsi);
-	if (eap_sim_db_send(data, msg, len) < 0)
-		return EAP_SIM_DB_FAILURE;
-
-	entry = os_zalloc(sizeof(*entry));
-	if (entry == NULL)
+	if (eap_sim_db_send_aka_req(data, imsi) < 0 ||
+	    !eap_sim_db_add_query(data, imsi, 1, cb_session_ctx))
 		return EAP_SIM_DB_FAILURE;
 
-	entry->aka = 1;
-	os_strlcpy(entry->imsi, imsi, sizeof(entry->imsi));
-	entry->cb_session_ctx = cb_session_ctx;
-	entry->state = PENDING;
-	eap_sim_db_add_pending(data, entry);
-	eap_sim_db_expire_pending(data, entry);
-	wpa_printf(MSG_DEBUG, "EAP-SIM DB: Added query %p", entry);
-
 	return EAP_SIM_DB_PENDING;
 }
 
@@ -1490,6 +1787,7 @@ int eap_sim_db_resynchronize(struct eap_sim_db_data *data,
 			     const char *username,
 			     const u8 *auts, const u8 *_rand)
 {
+	struct eap_sim_db_pending *entry;
 	const char *imsi;
 	size_t imsi_len;
 
@@ -1505,6 +1803,15 @@ int eap_sim_db_resynchronize(struct eap_sim_db_data *data,
 	wpa_printf(MSG_DEBUG, "EAP-SIM DB: Get AKA auth for IMSI '%s'",
 		   imsi);
 
+	/* A prefetched AUTN is based on the SQN that is being resynchronized */
+	entry = eap_sim_db_get_pending(data, imsi, 1);
+	if (entry) {
+		if (entry->prefetch)
+			eap_sim_db_free_pending(data, entry);
+		else
+			eap_sim_db_add_pending(data, entry);
+	}
+
 	if (data->sock >= 0) {
 		char msg[100];
 		int len, ret;
@@ -127,6 +127,7 @@ int eapol_auth_dump_state(struct eapol_state_machine *sm, char *buf,
 	pos = buf;
 	end = pos + buflen;
 
+	eapol_port_timers_update(sm);
 	ret = os_snprintf(pos, end - pos, "aWhile=%d\nquietWhile=%d\n"
 			  "reAuthWhen=%d\n",
 			  sm->aWhile, sm->quietWhile, sm->reAuthWhen);
@@ -138,57 +138,95 @@ static void eapol_auth_tx_req(struct eapol_state_machine *sm)
 }
 
 
+static void eapol_port_timer_dec(struct eapol_state_machine *sm, int *timer,
+				 os_time_t ticks, const char *name)
+{
+	if (*timer <= 0)
+		return;
+	*timer = *timer > ticks ? *timer - ticks : 0;
+	if (*timer == 0)
+		wpa_printf(MSG_DEBUG, "IEEE 802.1X: " MACSTR " - %s --> 0",
+			   MAC2STR(sm->addr), name);
+}
+
+
 /**
- * eapol_port_timers_tick - Port Timers state machine
- * @eloop_ctx: struct eapol_state_machine *
- * @timeout_ctx: Not used
+ * eapol_port_timers_update - Port Timers state machine
+ * @sm: EAPOL state machine
  *
- * This statemachine is implemented as a function that will be called
- * once a second as a registered event loop timeout.
+ * The timers are decremented once a second as in the Port Timers state
+ * machine. Instead of a timeout every second, the elapsed seconds are applied
+ * whenever the state machines are run and a timeout is registered only for
+ * the time when the next timer reaches zero (see eapol_port_timers_arm()).
  */
+void eapol_port_timers_update(struct eapol_state_machine *sm)
+{
+	struct os_reltime now, age;
+
+	os_get_reltime(&now);
+	os_reltime_sub(&now, &sm->timers_base, &age);
+	if (age.sec <= 0)
+		return;
+	sm->timers_base.sec += age.sec;
+
+	eapol_port_timer_dec(sm, &sm->aWhile, age.sec, "aWhile");
+	eapol_port_timer_dec(sm, &sm->quietWhile, age.sec, "quietWhile");
+	eapol_port_timer_dec(sm, &sm->reAuthWhen, age.sec, "reAuthWhen");
+	eapol_port_timer_dec(sm, &sm->eap_if->retransWhile, age.sec,
+			     "(EAP) retransWhile");
+}
+
+
 static void eapol_port_timers_tick(void *eloop_ctx, void *timeout_ctx)
 {
-	struct eapol_state_machine *state = timeout_ctx;
-
-	if (state->aWhile > 0) {
-		state->aWhile--;
-		if (state->aWhile == 0) {
-			wpa_printf(MSG_DEBUG, "IEEE 802.1X: " MACSTR
-				   " - aWhile --> 0",
-				   MAC2STR(state->addr));
-		}
-	}
+	struct eapol_state_machine *sm = timeout_ctx;
 
-	if (state->quietWhile > 0) {
-		state->quietWhile--;
-		if (state->quietWhile == 0) {
-			wpa_printf(MSG_DEBUG, "IEEE 802.1X: " MACSTR
-				   " - quietWhile --> 0",
-				   MAC2STR(state->addr));
-		}
-	}
+	sm->timers_armed = false;
+	eapol_sm_step_run(sm);
+}
 
-	if (state->reAuthWhen > 0) {
-		state->reAuthWhen--;
-		if (state->reAuthWhen == 0) {
-			wpa_printf(MSG_DEBUG, "IEEE 802.1X: " MACSTR
-				   " - reAuthWhen --> 0",
-				   MAC2STR(state->addr));
-		}
-	}
 
-	if (state->eap_if->retransWhile > 0) {
-		state->eap_if->retransWhile--;
-		if (state->eap_if->retransWhile == 0) {
-			wpa_printf(MSG_DEBUG, "IEEE 802.1X: " MACSTR
-				   " - (EAP) retransWhile --> 0",
-				   MAC2STR(state->addr));
+static void eapol_port_timer_min(int timer, int *next)
+{
+	if (timer > 0 && (*next == 0 || timer < *next))
+		*next = timer;
+}
+
+
+static void eapol_port_timers_arm(struct eapol_state_machine *sm)
+{
+	struct os_reltime deadline, now, left;
+	int next = 0;
+
+	eapol_port_timer_min(sm->aWhile, &next);
+	eapol_port_timer_min(sm->quietWhile, &next);
+	eapol_port_timer_min(sm->reAuthWhen, &next);
+	eapol_port_timer_min(sm->eap_if->retransWhile, &next);
+
+	if (!next) {
+		if (sm->timers_armed) {
+			eloop_cancel_timeout(eapol_port_timers_tick, NULL, sm);
+			sm->timers_armed = false;
 		}
+		return;
 	}
 
-	eapol_sm_step_run(state);
+	deadline = sm->timers_base;
+	deadline.sec += next;
+	if (sm->timers_armed && deadline.sec == sm->timers_deadline.sec &&
+	    deadline.usec == sm->timers_deadline.usec)
+		return;
 
-	eloop_register_timeout(1, 0, eapol_port_timers_tick, eloop_ctx, state);
+	eloop_cancel_timeout(eapol_port_timers_tick, NULL, sm);
+	os_get_reltime(&now);
+	if (os_reltime_before(&now, &deadline))
+		os_reltime_sub(&deadline, &now, &left);
+	else
+		left.sec = left.usec = 0;
+	eloop_register_timeout(left.sec, left.usec, eapol_port_timers_tick,
+			       NULL, sm);
+	sm->timers_deadline = deadline;
+	sm->timers_armed = true;
 }
 
 
@@ -909,6 +947,7 @@ static void eapol_sm_step_run(struct eapol_state_machine *sm)
 	int max_steps = 100;
 
 	os_memcpy(addr, sm->addr, ETH_ALEN);
+	eapol_port_timers_update(sm);
 
 	/*
 	 * Allow EAPOL state machines to run as long as there are state
@@ -966,6 +1005,7 @@ restart:
 			if (sm->eap_if->aaaEapRespData == NULL) {
 				wpa_printf(MSG_DEBUG, "EAPOL: aaaEapResp set, "
 					   "but no aaaEapRespData available");
+				eapol_port_timers_arm(sm);
 				return;
 			}
 			sm->eapol->cb.aaa_send(
@@ -975,9 +1015,11 @@ restart:
 		}
 	}
 
-	if (eapol_sm_sta_entry_alive(eapol, addr))
+	if (eapol_sm_sta_entry_alive(eapol, addr)) {
+		eapol_port_timers_arm(sm);
 		sm->eapol->cb.eapol_event(sm->eapol->conf.ctx, sm->sta,
 					  EAPOL_AUTH_SM_CHANGE);
+	}
 }
 
 
@@ -1010,6 +1052,7 @@ void eapol_auth_step(struct eapol_state_machine *sm)
 static void eapol_auth_initialize(struct eapol_state_machine *sm)
 {
 	sm->initializing = true;
+	os_get_reltime(&sm->timers_base);
 	/* Initialize the state machines by asserting initialize and then
 	 * deasserting it after one step */
 	sm->initialize = true;
@@ -1018,9 +1061,8 @@ static void eapol_auth_initialize(struct eapol_state_machine *sm)
 	eapol_sm_step_run(sm);
 	sm->initializing = false;
 
-	/* Start one second tick for port timers state machine */
-	eloop_cancel_timeout(eapol_port_timers_tick, NULL, sm);
-	eloop_register_timeout(1, 0, eapol_port_timers_tick, NULL, sm);
+	/* Start the port timers state machine */
+	eapol_port_timers_arm(sm);
 }
 
 
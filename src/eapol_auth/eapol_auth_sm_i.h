@@ -41,6 +41,11 @@ struct eapol_state_machine {
 	int aWhile;
 	int quietWhile;
 	int reAuthWhen;
+	/* Start of the current one second period of the Port Timers state
+	 * machine and the time when it needs to run next, if armed */
+	struct os_reltime timers_base;
+	struct os_reltime timers_deadline;
+	bool timers_armed;
 
 	/* global variables */
 	bool authAbort;
@@ -177,4 +182,6 @@ struct eapol_state_machine {
 	bool stopped;
 };
 
+void eapol_port_timers_update(struct eapol_state_machine *sm);
+
 #endif /* EAPOL_AUTH_SM_I_H */
@@ -35,7 +35,14 @@ struct eapol_sm {
 	unsigned int heldWhile;
 	unsigned int startWhen;
 	unsigned int idleWhile; /* for EAP state machine */
-	int timer_tick_enabled;
+	/* Time when each running timer reaches zero */
+	struct os_reltime authWhile_end;
+	struct os_reltime heldWhile_end;
+	struct os_reltime startWhen_end;
+	struct os_reltime idleWhile_end;
+	/* Registered Port Timers timeout, if armed */
+	struct os_reltime timers_deadline;
+	bool timers_armed;
 
 	/* Global variables */
 	bool eapFail;
@@ -161,41 +168,100 @@ static void eapol_sm_set_port_authorized(struct eapol_sm *sm);
 static void eapol_sm_set_port_unauthorized(struct eapol_sm *sm);
 
 
-/* Port Timers state machine - implemented as a function that will be called
- * once a second as a registered event loop timeout */
-static void eapol_port_timers_tick(void *eloop_ctx, void *timeout_ctx)
+static void eapol_port_timers_tick(void *eloop_ctx, void *timeout_ctx);
+
+
+static void eapol_port_timer_min(unsigned int timer, struct os_reltime *end,
+				 struct os_reltime **next)
 {
-	struct eapol_sm *sm = timeout_ctx;
+	if (timer && (!*next || os_reltime_before(end, *next)))
+		*next = end;
+}
 
-	if (sm->authWhile > 0) {
-		sm->authWhile--;
-		if (sm->authWhile == 0)
-			wpa_printf(MSG_DEBUG, "EAPOL: authWhile --> 0");
-	}
-	if (sm->heldWhile > 0) {
-		sm->heldWhile--;
-		if (sm->heldWhile == 0)
-			wpa_printf(MSG_DEBUG, "EAPOL: heldWhile --> 0");
-	}
-	if (sm->startWhen > 0) {
-		sm->startWhen--;
-		if (sm->startWhen == 0)
-			wpa_printf(MSG_DEBUG, "EAPOL: startWhen --> 0");
-	}
-	if (sm->idleWhile > 0) {
-		sm->idleWhile--;
-		if (sm->idleWhile == 0)
-			wpa_printf(MSG_DEBUG, "EAPOL: idleWhile --> 0");
+
+/* Register a timeout for the time when the next running timer reaches zero */
+static void eapol_port_timers_arm(struct eapol_sm *sm)
+{
+	struct os_reltime *next = NULL;
+	struct os_reltime now, left;
+
+	eapol_port_timer_min(sm->authWhile, &sm->authWhile_end, &next);
+	eapol_port_timer_min(sm->heldWhile, &sm->heldWhile_end, &next);
+	eapol_port_timer_min(sm->startWhen, &sm->startWhen_end, &next);
+	eapol_port_timer_min(sm->idleWhile, &sm->idleWhile_end, &next);
+
+	if (!next) {
+		if (sm->timers_armed) {
+			wpa_printf(MSG_DEBUG, "EAPOL: disable timer tick");
+			eloop_cancel_timeout(eapol_port_timers_tick, NULL, sm);
+			sm->timers_armed = false;
+		}
+		return;
 	}
 
-	if (sm->authWhile | sm->heldWhile | sm->startWhen | sm->idleWhile) {
-		if (eloop_register_timeout(1, 0, eapol_port_timers_tick,
-					   eloop_ctx, sm) < 0)
-			sm->timer_tick_enabled = 0;
-	} else {
-		wpa_printf(MSG_DEBUG, "EAPOL: disable timer tick");
-		sm->timer_tick_enabled = 0;
+	if (sm->timers_armed && next->sec == sm->timers_deadline.sec &&
+	    next->usec == sm->timers_deadline.usec)
+		return;
+
+	eloop_cancel_timeout(eapol_port_timers_tick, NULL, sm);
+	os_get_reltime(&now);
+	if (os_reltime_before(&now, next))
+		os_reltime_sub(next, &now, &left);
+	else
+		left.sec = left.usec = 0;
+	sm->timers_armed = eloop_register_timeout(left.sec, left.usec,
+						  eapol_port_timers_tick,
+						  NULL, sm) == 0;
+	sm->timers_deadline = *next;
+}
+
+
+/* Start one of the Port Timers; the value is in seconds */
+static void eapol_port_timer_start(struct eapol_sm *sm, unsigned int *timer,
+				   struct os_reltime *end, unsigned int value)
+{
+	*timer = value;
+	if (!value)
+		return;
+	os_get_reltime(end);
+	end->sec += value;
+	eapol_port_timers_arm(sm);
+}
+
+#define EAPOL_TIMER_START(timer, value) \
+eapol_port_timer_start(sm, &sm->timer, &sm->timer ## _end, (value))
+
+
+static void eapol_port_timer_expire(unsigned int *timer,
+				    struct os_reltime *end,
+				    struct os_reltime *now, const char *name)
+{
+	if (*timer && !os_reltime_before(now, end)) {
+		*timer = 0;
+		wpa_printf(MSG_DEBUG, "EAPOL: %s --> 0", name);
 	}
+}
+
+
+/* Port Timers state machine - implemented as a function that will be called
+ * as a registered event loop timeout when the next timer reaches zero instead
+ * of decrementing the timers once a second */
+static void eapol_port_timers_tick(void *eloop_ctx, void *timeout_ctx)
+{
+	struct eapol_sm *sm = timeout_ctx;
+	struct os_reltime now;
+
+	sm->timers_armed = false;
+	os_get_reltime(&now);
+	eapol_port_timer_expire(&sm->authWhile, &sm->authWhile_end, &now,
+				"authWhile");
+	eapol_port_timer_expire(&sm->heldWhile, &sm->heldWhile_end, &now,
+				"heldWhile");
+	eapol_port_timer_expire(&sm->startWhen, &sm->startWhen_end, &now,
+				"startWhen");
+	eapol_port_timer_expire(&sm->idleWhile, &sm->idleWhile_end, &now,
+				"idleWhile");
+	eapol_port_timers_arm(sm);
 	eapol_sm_step(sm);
 }
 
@@ -209,17 +275,6 @@ static int eapol_sm_confirm_auth(struct eapol_sm *sm)
 }
 
 
-static void eapol_enable_timer_tick(struct eapol_sm *sm)
-{
-	if (sm->timer_tick_enabled)
-		return;
-	wpa_printf(MSG_DEBUG, "EAPOL: enable timer tick");
-	eloop_cancel_timeout(eapol_port_timers_tick, NULL, sm);
-	if (eloop_register_timeout(1, 0, eapol_port_timers_tick, NULL, sm) == 0)
-		sm->timer_tick_enabled = 1;
-}
-
-
 SM_STATE(SUPP_PAE, LOGOFF)
 {
 	SM_ENTRY(SUPP_PAE, LOGOFF);
@@ -266,7 +321,7 @@ SM_STATE(SUPP_PAE, CONNECTING)
 	sm->eapTriggerStart = false;
 
 	if (send_start) {
-		sm->startWhen = sm->startPeriod;
+		EAPOL_TIMER_START(startWhen, sm->startPeriod);
 		sm->startCount++;
 	} else {
 		/*
@@ -280,12 +335,11 @@ SM_STATE(SUPP_PAE, CONNECTING)
 			/* Reduce latency on starting WPS negotiation. */
 			wpa_printf(MSG_DEBUG,
 				   "EAPOL: Using shorter startWhen for WPS");
-			sm->startWhen = 1;
+			EAPOL_TIMER_START(startWhen, 1);
 		} else {
-			sm->startWhen = 2;
+			EAPOL_TIMER_START(startWhen, 2);
 		}
 	}
-	eapol_enable_timer_tick(sm);
 	sm->eapolEap = false;
 	if (send_start)
 		eapol_sm_txStart(sm);
@@ -308,8 +362,7 @@ SM_STATE(SUPP_PAE, AUTHENTICATING)
 SM_STATE(SUPP_PAE, HELD)
 {
 	SM_ENTRY(SUPP_PAE, HELD);
-	sm->heldWhile = sm->heldPeriod;
-	eapol_enable_timer_tick(sm);
+	EAPOL_TIMER_START(heldWhile, sm->heldPeriod);
 	eapol_sm_set_port_unauthorized(sm);
 	sm->cb_status = EAPOL_CB_FAILURE;
 }
@@ -581,8 +634,7 @@ SM_STATE(SUPP_BE, INITIALIZE)
 SM_STATE(SUPP_BE, RECEIVE)
 {
 	SM_ENTRY(SUPP_BE, RECEIVE);
-	sm->authWhile = sm->authPeriod;
-	eapol_enable_timer_tick(sm);
+	EAPOL_TIMER_START(authWhile, sm->authPeriod);
 	sm->eapolEap = false;
 	sm->eapNoResp = false;
 	sm->initial_req = false;
@@ -1726,8 +1778,7 @@ static void eapol_sm_abort_cached(struct eapol_sm *sm)
 
 	/* Make sure we do not start sending EAPOL-Start frames first, but
 	 * instead move to RESTART state to start EAPOL authentication. */
-	sm->startWhen = 3;
-	eapol_enable_timer_tick(sm);
+	EAPOL_TIMER_START(startWhen, 3);
 
 	if (sm->ctx->aborted_cached)
 		sm->ctx->aborted_cached(sm->ctx->ctx);
@@ -1962,9 +2013,7 @@ static void eapol_sm_set_int(void *ctx, enum eapol_int_var variable,
 		return;
 	switch (variable) {
 	case EAPOL_idleWhile:
-		sm->idleWhile = value;
-		if (sm->idleWhile > 0)
-			eapol_enable_timer_tick(sm);
+		EAPOL_TIMER_START(idleWhile, value);
 		break;
 	}
 }
@@ -2124,6 +2173,17 @@ eapol_sm_get_certificate(void *ctx, const char* alias, uint8_t** value)
 	return -1;
 }
 
+
+static void eapol_sm_erp_key_update(void *ctx, const char *keyname_nai,
+				    const u8 *rrk, size_t rrk_len, u32 next_seq)
+{
+	struct eapol_sm *sm = ctx;
+
+	if (sm->ctx->erp_key_update)
+		sm->ctx->erp_key_update(sm->ctx->ctx, keyname_nai, rrk, rrk_len,
+					next_seq);
+}
+
 static const struct eapol_callbacks eapol_cb =
 {
 	eapol_sm_get_config,
@@ -2148,7 +2208,8 @@ static const struct eapol_callbacks eapol_cb =
 	eapol_sm_set_anon_id,
 	eapol_sm_notify_eap_method_selected,
 	eapol_sm_notify_open_ssl_failure,
-	eapol_sm_get_certificate
+	eapol_sm_get_certificate,
+	eapol_sm_erp_key_update
 };
 
 
@@ -2214,9 +2275,6 @@ struct eapol_sm *eapol_sm_init(struct eapol_ctx *ctx)
 	sm->initialize = false;
 	eapol_sm_step(sm);
 
-	if (eloop_register_timeout(1, 0, eapol_port_timers_tick, NULL, sm) == 0)
-		sm->timer_tick_enabled = 1;
-
 	return sm;
 }
 
@@ -2314,6 +2372,20 @@ int eapol_sm_update_erp_next_seq_num(struct eapol_sm *sm, u16 next_seq_num)
 }
 
 
+int eapol_sm_erp_restore_key(struct eapol_sm *sm, const char *keyname_nai,
+			     const u8 *rrk, size_t rrk_len, u32 next_seq)
+{
+#ifdef CONFIG_ERP
+	if (!sm)
+		return -1;
+	return eap_peer_erp_restore_key(sm->eap, keyname_nai, rrk, rrk_len,
+					next_seq);
+#else /* CONFIG_ERP */
+	return -1;
+#endif /* CONFIG_ERP */
+}
+
+
 int eapol_sm_get_erp_info(struct eapol_sm *sm, struct eap_peer_config *config,
 			  const u8 **username, size_t *username_len,
 			  const u8 **realm, size_t *realm_len,
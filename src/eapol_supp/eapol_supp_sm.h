@@ -351,6 +351,17 @@ struct eapol_ctx {
 	 * Returns: size of the retrieved certificate or -1 on error
 	 */
 	ssize_t (*get_certificate_cb)(const char* alias, uint8_t** value);
+
+	/**
+	 * erp_key_update - Notification of a new, updated, or removed ERP key
+	 * @ctx: Callback context (ctx)
+	 * @keyname_nai: keyName-NAI of the key
+	 * @rrk: rRK or %NULL if the key was removed
+	 * @rrk_len: Length of rRK in octets
+	 * @next_seq: Next SEQ to use with the key
+	 */
+	void (*erp_key_update)(void *ctx, const char *keyname_nai,
+			       const u8 *rrk, size_t rrk_len, u32 next_seq);
 };
 
 
@@ -399,6 +410,8 @@ void eapol_sm_process_erp_finish(struct eapol_sm *sm, const u8 *buf,
 int eapol_sm_get_eap_proxy_imsi(void *ctx, int sim_num, char *imsi,
 				size_t *len);
 int eapol_sm_update_erp_next_seq_num(struct eapol_sm *sm, u16 next_seq_num);
+int eapol_sm_erp_restore_key(struct eapol_sm *sm, const char *keyname_nai,
+			     const u8 *rrk, size_t rrk_len, u32 next_seq);
 int eapol_sm_get_erp_info(struct eapol_sm *sm, struct eap_peer_config *config,
 			  const u8 **username, size_t *username_len,
 			  const u8 **realm, size_t *realm_len,
@@ -529,6 +542,13 @@ static inline int eapol_sm_update_erp_next_seq_num(struct eapol_sm *sm,
 {
 	return -1;
 }
+static inline int eapol_sm_erp_restore_key(struct eapol_sm *sm,
+					   const char *keyname_nai,
+					   const u8 *rrk, size_t rrk_len,
+					   u32 next_seq)
+{
+	return -1;
+}
 static inline int
 eapol_sm_get_erp_info(struct eapol_sm *sm, struct eap_peer_config *config,
 		      const u8 **username, size_t *username_len,
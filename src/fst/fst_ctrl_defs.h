@@ -56,6 +56,8 @@
 #define FST_CSG_PNAME_NEW_IFNAME "new_ifname" /* pval = ifname */
 #define FST_CSG_PNAME_LLT        "llt"        /* pval = numeric llt value */
 #define FST_CSG_PNAME_STATE      "state"      /* pval = FST_CS_PVAL_STATE_... */
+#define FST_CSG_PNAME_SETUP_USEC  "setup_usec"  /* pval = latest setup time */
+#define FST_CSG_PNAME_SWITCH_USEC "switch_usec" /* pval = latest switch time */
 #define FST_CMD_SESSION_SET      "session_set"
 #define FST_CSS_PNAME_OLD_PEER_ADDR  FST_CSG_PNAME_OLD_PEER_ADDR
 #define FST_CSS_PNAME_NEW_PEER_ADDR  FST_CSG_PNAME_NEW_PEER_ADDR
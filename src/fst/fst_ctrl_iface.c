@@ -173,6 +173,7 @@ static int session_get(const char *session_id, char *buf, size_t buflen)
 	struct fst_session *s;
 	struct fst_iface *new_iface, *old_iface;
 	const u8 *old_peer_addr, *new_peer_addr;
+	unsigned int setup_usec, switch_usec;
 	u32 id;
 
 	id = strtoul(session_id, NULL, 0);
@@ -187,6 +188,7 @@ static int session_get(const char *session_id, char *buf, size_t buflen)
 	new_peer_addr = fst_session_get_peer_addr(s, false);
 	new_iface = fst_session_get_iface(s, false);
 	old_iface = fst_session_get_iface(s, true);
+	fst_session_get_latency(s, &setup_usec, &switch_usec);
 
 	return os_snprintf(buf, buflen,
 			   FST_CSG_PNAME_OLD_PEER_ADDR "=" MACSTR "\n"
@@ -194,7 +196,9 @@ static int session_get(const char *session_id, char *buf, size_t buflen)
 			   FST_CSG_PNAME_NEW_IFNAME "=%s\n"
 			   FST_CSG_PNAME_OLD_IFNAME "=%s\n"
 			   FST_CSG_PNAME_LLT "=%u\n"
-			   FST_CSG_PNAME_STATE "=%s\n",
+			   FST_CSG_PNAME_STATE "=%s\n"
+			   FST_CSG_PNAME_SETUP_USEC "=%u\n"
+			   FST_CSG_PNAME_SWITCH_USEC "=%u\n",
 			   MAC2STR(old_peer_addr),
 			   MAC2STR(new_peer_addr),
 			   new_iface ? fst_iface_get_name(new_iface) :
@@ -202,7 +206,8 @@ static int session_get(const char *session_id, char *buf, size_t buflen)
 			   old_iface ? fst_iface_get_name(old_iface) :
 			   FST_CTRL_PVAL_NONE,
 			   fst_session_get_llt(s),
-			   fst_session_state_name(fst_session_get_state(s)));
+			   fst_session_state_name(fst_session_get_state(s)),
+			   setup_usec, switch_usec);
 }
 
 
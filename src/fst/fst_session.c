@@ -59,6 +59,8 @@ struct fst_session {
 		u8 pending_setup_req_dlgt;
 		u32 fsts_id; /* FSTS ID, see spec, 8.4.2.147
 			      * Session Transition element */
+		struct os_reltime setup_started;
+		struct os_reltime switch_started;
 	} data;
 	/* Session object internal fields which won't be zeroed on reset */
 	struct dl_list global_sessions_lentry;
@@ -67,9 +69,27 @@ struct fst_session {
 	struct fst_group *group;
 	enum fst_session_state state;
 	bool stt_armed;
+	struct fst_session *hnext; /* global_sessions_hash */
+	/* global_peer_hash entries for the old and new peer address while the
+	 * session is in progress */
+	struct fst_session_peer_entry {
+		struct fst_session_peer_entry *next;
+		struct fst_session *s;
+		u8 idx;
+		bool added;
+	} peer_entry[2];
+	/* Duration of the latest setup and switch of this session */
+	unsigned int setup_usec;
+	unsigned int switch_usec;
 };
 
+#define FST_SESSION_HASH_SIZE 16
+#define FST_SESSION_HASH(id) ((id) & (FST_SESSION_HASH_SIZE - 1))
+#define FST_SESSION_PEER_HASH(a) ((a)[5] & (FST_SESSION_HASH_SIZE - 1))
+
 static struct dl_list global_sessions_list;
+static struct fst_session *global_sessions_hash[FST_SESSION_HASH_SIZE];
+static struct fst_session_peer_entry *global_peer_hash[FST_SESSION_HASH_SIZE];
 static u32 global_session_id = 0;
 
 #define foreach_fst_session(s) \
@@ -102,6 +122,47 @@ void fst_session_global_deinit(void)
 }
 
 
+static void fst_session_peer_hash_add(struct fst_session *s)
+{
+	struct fst_session_peer_entry *e;
+	int i;
+
+	for (i = 0; i < 2; i++) {
+		const u8 *addr = i == 0 ? s->data.old_peer_addr :
+			s->data.new_peer_addr;
+
+		e = &s->peer_entry[i];
+		if (e->added || is_zero_ether_addr(addr) ||
+		    (i == 1 && ether_addr_equal(addr, s->data.old_peer_addr)))
+			continue;
+		e->s = s;
+		e->idx = FST_SESSION_PEER_HASH(addr);
+		e->next = global_peer_hash[e->idx];
+		global_peer_hash[e->idx] = e;
+		e->added = true;
+	}
+}
+
+
+static void fst_session_peer_hash_del(struct fst_session *s)
+{
+	struct fst_session_peer_entry **pos, *e;
+	int i;
+
+	for (i = 0; i < 2; i++) {
+		e = &s->peer_entry[i];
+		if (!e->added)
+			continue;
+		pos = &global_peer_hash[e->idx];
+		while (*pos && *pos != e)
+			pos = &(*pos)->next;
+		if (*pos)
+			*pos = e->next;
+		e->added = false;
+	}
+}
+
+
 static inline void fst_session_notify_ctrl(struct fst_session *s,
 					   enum fst_event_type event_type,
 					   union fst_event_extra *extra)
@@ -129,6 +190,11 @@ static void fst_session_set_state(struct fst_session *s,
 		fst_printf_session(s, MSG_INFO, "State: %s => %s",
 				   fst_session_state_name(s->state),
 				   fst_session_state_name(state));
+		/* Only sessions in progress are looked up by peer address */
+		if (s->state == FST_SESSION_STATE_INITIAL)
+			fst_session_peer_hash_add(s);
+		else if (state == FST_SESSION_STATE_INITIAL)
+			fst_session_peer_hash_del(s);
 		s->state = state;
 	}
 }
@@ -142,7 +208,8 @@ static u32 fst_find_free_session_id(void)
 	for (i = 0; i < (u32) -1; i++) {
 		bool in_use = false;
 
-		foreach_fst_session(s) {
+		for (s = global_sessions_hash[FST_SESSION_HASH(global_session_id)];
+		     s; s = s->hnext) {
 			if (s->id == global_session_id) {
 				fst_session_global_inc_id();
 				in_use = true;
@@ -160,6 +227,16 @@ static u32 fst_find_free_session_id(void)
 }
 
 
+static unsigned int fst_session_elapsed_usec(struct os_reltime *start)
+{
+	struct os_reltime now, diff;
+
+	os_get_reltime(&now);
+	os_reltime_sub(&now, start, &diff);
+	return diff.sec * 1000000 + diff.usec;
+}
+
+
 static void fst_session_timeout_handler(void *eloop_data, void *user_ctx)
 {
 	struct fst_session *s = user_ctx;
@@ -230,9 +307,12 @@ static int fst_session_is_switch_requested(struct fst_session *s)
 static struct fst_session *
 fst_find_session_in_progress(const u8 *peer_addr, struct fst_group *g)
 {
+	struct fst_session_peer_entry *e;
 	struct fst_session *s;
 
-	foreach_fst_session(s) {
+	for (e = global_peer_hash[FST_SESSION_PEER_HASH(peer_addr)]; e;
+	     e = e->next) {
+		s = e->s;
 		if (s->group == g &&
 		    (ether_addr_equal(s->data.old_peer_addr, peer_addr) ||
 		     ether_addr_equal(s->data.new_peer_addr, peer_addr)) &&
@@ -482,6 +562,7 @@ static void fst_session_handle_setup_request(struct fst_iface *iface,
 	fst_session_set_llt(s, FST_LLT_VAL_TO_MS(le_to_host32(req->llt)));
 	s->data.pending_setup_req_dlgt = req->dialog_token;
 	s->data.fsts_id = le_to_host32(req->stie.fsts_id);
+	os_get_reltime(&s->data.setup_started);
 
 	fst_session_stt_arm(s);
 
@@ -582,11 +663,12 @@ static void fst_session_handle_setup_response(struct fst_session *s,
 		return;
 	}
 
+	s->setup_usec = fst_session_elapsed_usec(&s->data.setup_started);
 	fst_printf_session(s, MSG_INFO,
-			   "%s: FST Setup established for %s (llt=%u)",
+			   "%s: FST Setup established for %s (llt=%u) in %u usec",
 			   fst_iface_get_name(s->data.old_iface),
 			   fst_iface_get_name(s->data.new_iface),
-			   s->data.llt_ms);
+			   s->data.llt_ms, s->setup_usec);
 
 	fst_session_notify_ctrl(s, EVENT_FST_ESTABLISHED, NULL);
 
@@ -738,6 +820,13 @@ fst_session_handle_ack_response(struct fst_session *s,
 		return;
 	}
 
+	s->switch_usec = fst_session_elapsed_usec(&s->data.switch_started);
+	fst_printf_session(s, MSG_INFO,
+			   "FST switch %s => %s completed in %u usec (setup %u usec)",
+			   fst_iface_get_name(s->data.old_iface),
+			   fst_iface_get_name(s->data.new_iface),
+			   s->switch_usec, s->setup_usec);
+
 	fst_session_set_state(s, FST_SESSION_STATE_TRANSITION_CONFIRMED, NULL);
 	fst_session_set_state(s, FST_SESSION_STATE_INITIAL, &evext);
 
@@ -771,6 +860,8 @@ struct fst_session * fst_session_create(struct fst_group *g)
 	fst_printf(MSG_INFO, "Session %u created", s->id);
 
 	dl_list_add_tail(&global_sessions_list, &s->global_sessions_lentry);
+	s->hnext = global_sessions_hash[FST_SESSION_HASH(s->id)];
+	global_sessions_hash[FST_SESSION_HASH(s->id)] = s;
 
 	foreach_fst_ctrl_call(on_session_added, s);
 
@@ -799,8 +890,13 @@ void fst_session_set_peer_addr(struct fst_session *s, const u8 *addr,
 			       bool is_old)
 {
 	u8 *a = is_old ? s->data.old_peer_addr : s->data.new_peer_addr;
+	bool hashed = s->peer_entry[0].added || s->peer_entry[1].added;
 
+	if (hashed)
+		fst_session_peer_hash_del(s);
 	os_memcpy(a, addr, ETH_ALEN);
+	if (hashed)
+		fst_session_peer_hash_add(s);
 }
 
 
@@ -904,6 +1000,7 @@ int fst_session_initiate_setup(struct fst_session *s)
 	if (!res) {
 		s->data.fsts_id = fsts_id;
 		s->data.pending_setup_req_dlgt = dialog_token;
+		os_get_reltime(&s->data.setup_started);
 		fst_printf_sframe(s, true, MSG_INFO, "FST Setup Request sent");
 		fst_session_set_state(s, FST_SESSION_STATE_SETUP_COMPLETION,
 				      NULL);
@@ -1003,6 +1100,8 @@ int fst_session_respond(struct fst_session *s, u8 status_code)
 	}
 
 	fst_printf_sframe(s, true, MSG_INFO, "FST Setup Response sent");
+	if (status_code == WLAN_STATUS_SUCCESS)
+		s->setup_usec = fst_session_elapsed_usec(&s->data.setup_started);
 
 	if (status_code != WLAN_STATUS_SUCCESS) {
 		union fst_session_state_switch_extra evext = {
@@ -1050,6 +1149,7 @@ int fst_session_initiate_switch(struct fst_session *s)
 	res = fst_session_send_action(s, false, &req, sizeof(req), NULL);
 	if (!res) {
 		fst_printf_sframe(s, false, MSG_INFO, "FST Ack Request sent");
+		os_get_reltime(&s->data.switch_started);
 		fst_session_set_state(s, FST_SESSION_STATE_TRANSITION_DONE,
 				      NULL);
 		fst_session_stt_arm(s);
@@ -1118,8 +1218,18 @@ void fst_session_reset(struct fst_session *s)
 
 void fst_session_delete(struct fst_session *s)
 {
+	struct fst_session **pos;
+
 	fst_printf(MSG_INFO, "Session %u deleted", s->id);
 	dl_list_del(&s->global_sessions_lentry);
+	for (pos = &global_sessions_hash[FST_SESSION_HASH(s->id)]; *pos;
+	     pos = &(*pos)->hnext) {
+		if (*pos == s) {
+			*pos = s->hnext;
+			break;
+		}
+	}
+	fst_session_peer_hash_del(s);
 	foreach_fst_ctrl_call(on_session_removed, s);
 	os_free(s);
 }
@@ -1161,11 +1271,19 @@ enum fst_session_state fst_session_get_state(struct fst_session *s)
 }
 
 
+void fst_session_get_latency(struct fst_session *s, unsigned int *setup_usec,
+			     unsigned int *switch_usec)
+{
+	*setup_usec = s->setup_usec;
+	*switch_usec = s->switch_usec;
+}
+
+
 struct fst_session * fst_session_get_by_id(u32 id)
 {
 	struct fst_session *s;
 
-	foreach_fst_session(s) {
+	for (s = global_sessions_hash[FST_SESSION_HASH(id)]; s; s = s->hnext) {
 		if (id == s->id)
 			return s;
 	}
@@ -44,6 +44,8 @@ const u8 * fst_session_get_peer_addr(struct fst_session *s, bool is_old);
 u32 fst_session_get_id(struct fst_session *s);
 u32 fst_session_get_llt(struct fst_session *s);
 enum fst_session_state fst_session_get_state(struct fst_session *s);
+void fst_session_get_latency(struct fst_session *s, unsigned int *setup_usec,
+			     unsigned int *switch_usec);
 
 struct fst_session *fst_session_get_by_id(u32 id);
 
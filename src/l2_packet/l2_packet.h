@@ -114,6 +114,24 @@ int l2_packet_get_own_addr(struct l2_packet_data *l2, u8 *addr);
 int l2_packet_send(struct l2_packet_data *l2, const u8 *dst_addr, u16 proto,
 		   const u8 *buf, size_t len);
 
+/**
+ * l2_packet_send_multi - Send copies of a frame to multiple destinations
+ * @l2: Pointer to internal l2_packet data from l2_packet_init()
+ * @dst_addrs: Destination addresses (num_dst * ETH_ALEN octets)
+ * @num_dst: Number of destination addresses
+ * @buf: Frame to be sent including the layer 2 header
+ * @len: Length of the buffer
+ * Returns: Number of frames sent or -1 if not supported
+ *
+ * This can be used only if l2_hdr was set to 1 in l2_packet_init() call. The
+ * destination address in the layer 2 header of @buf is replaced with each of
+ * @dst_addrs; @buf itself is not modified. l2_packet implementation will need
+ * to define the function, but it can return -1 in which case the caller can
+ * use l2_packet_send() for each destination instead.
+ */
+int l2_packet_send_multi(struct l2_packet_data *l2, const u8 *dst_addrs,
+			 size_t num_dst, const u8 *buf, size_t len);
+
 /**
  * l2_packet_get_ip_addr - Get the current IP address from the interface
  * @l2: Pointer to internal l2_packet data from l2_packet_init()
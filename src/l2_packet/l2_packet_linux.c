@@ -6,9 +6,18 @@
  * See README for more details.
  */
 
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE /* sendmmsg() */
+#endif /* _GNU_SOURCE */
 #include "includes.h"
 #include <sys/ioctl.h>
+#ifdef CONFIG_L2_PACKET_RX_RING
+#include <sys/mman.h>
+/* glibc netpacket/packet.h does not define the TPACKET_V3 ring structures */
+#include <linux/if_packet.h>
+#else /* CONFIG_L2_PACKET_RX_RING */
 #include <netpacket/packet.h>
+#endif /* CONFIG_L2_PACKET_RX_RING */
 #include <net/if.h>
 #include <linux/filter.h>
 
@@ -38,8 +47,23 @@ struct l2_packet_data {
 	u8 last_hash_prev[SHA1_MAC_LEN];
 	unsigned int num_rx_br;
 #endif /* CONFIG_NO_LINUX_PACKET_SOCKET_WAR */
+
+#ifdef CONFIG_L2_PACKET_RX_RING
+	u8 *ring; /* mmap'ed TPACKET_V3 receive ring or NULL if not used */
+	size_t ring_len;
+	unsigned int ring_block; /* next block to be processed */
+#endif /* CONFIG_L2_PACKET_RX_RING */
 };
 
+#ifdef CONFIG_L2_PACKET_RX_RING
+/* Receive ring dimensions: 8 x 64 kB blocks, each of which is handed over to
+ * user space when full or after the retire timeout. */
+#define L2_PACKET_RING_BLOCK_SIZE (1 << 16)
+#define L2_PACKET_RING_BLOCK_NR 8
+#define L2_PACKET_RING_FRAME_SIZE 2048
+#define L2_PACKET_RING_BLOCK_TIMEOUT_MS 10
+#endif /* CONFIG_L2_PACKET_RX_RING */
+
 /* Generated by 'sudo tcpdump -s 3000 -dd greater 278 and ip and udp and
  * src port bootps and dst port bootpc'
  */
@@ -145,6 +169,55 @@ int l2_packet_send(struct l2_packet_data *l2, const u8 *dst_addr, u16 proto,
 }
 
 
+#define L2_PACKET_SEND_BATCH 64
+
+int l2_packet_send_multi(struct l2_packet_data *l2, const u8 *dst_addrs,
+			 size_t num_dst, const u8 *buf, size_t len)
+{
+	struct mmsghdr msgs[L2_PACKET_SEND_BATCH];
+	struct iovec iov[L2_PACKET_SEND_BATCH][2];
+	size_t pos = 0, i, n;
+	int ret, sent = 0;
+
+	if (TEST_FAIL())
+		return -1;
+	if (!l2 || !l2->l2_hdr || len < ETH_ALEN)
+		return -1;
+
+	while (pos < num_dst) {
+		n = num_dst - pos;
+		if (n > L2_PACKET_SEND_BATCH)
+			n = L2_PACKET_SEND_BATCH;
+
+		/* Only the destination address differs between the frames */
+		os_memset(msgs, 0, n * sizeof(msgs[0]));
+		for (i = 0; i < n; i++) {
+			iov[i][0].iov_base = (void *) &dst_addrs[(pos + i) *
+								 ETH_ALEN];
+			iov[i][0].iov_len = ETH_ALEN;
+			iov[i][1].iov_base = (void *) (buf + ETH_ALEN);
+			iov[i][1].iov_len = len - ETH_ALEN;
+			msgs[i].msg_hdr.msg_iov = iov[i];
+			msgs[i].msg_hdr.msg_iovlen = 2;
+		}
+
+		ret = sendmmsg(l2->fd, msgs, n, 0);
+		if (ret <= 0) {
+			/* Skip the frame that could not be sent */
+			wpa_printf(MSG_DEBUG,
+				   "l2_packet_send_multi - sendmmsg: %s",
+				   strerror(errno));
+			pos++;
+			continue;
+		}
+		pos += ret;
+		sent += ret;
+	}
+
+	return sent;
+}
+
+
 static void l2_packet_receive(int sock, void *eloop_ctx, void *sock_ctx)
 {
 	struct l2_packet_data *l2 = eloop_ctx;
@@ -215,6 +288,98 @@ static void l2_packet_receive(int sock, void *eloop_ctx, void *sock_ctx)
 }
 
 
+#ifdef CONFIG_L2_PACKET_RX_RING
+
+static void l2_packet_receive_ring(int sock, void *eloop_ctx, void *sock_ctx)
+{
+	struct l2_packet_data *l2 = eloop_ctx;
+	struct tpacket_block_desc *pbd;
+	struct tpacket3_hdr *ppd;
+	const struct sockaddr_ll *ll;
+	unsigned int i, num;
+
+	/* Process all the blocks that the kernel has handed over, but leave
+	 * the rest to the next call to avoid starving other sockets. */
+	for (num = 0; num < L2_PACKET_RING_BLOCK_NR; num++) {
+		pbd = (struct tpacket_block_desc *)
+			(l2->ring + l2->ring_block * L2_PACKET_RING_BLOCK_SIZE);
+		if (!(__atomic_load_n(&pbd->hdr.bh1.block_status,
+				      __ATOMIC_ACQUIRE) & TP_STATUS_USER))
+			break;
+
+		ppd = (struct tpacket3_hdr *)
+			((u8 *) pbd + pbd->hdr.bh1.offset_to_first_pkt);
+		for (i = 0; i < pbd->hdr.bh1.num_pkts; i++) {
+			ll = (const struct sockaddr_ll *)
+				((u8 *) ppd +
+				 TPACKET_ALIGN(sizeof(struct tpacket3_hdr)));
+			l2->rx_callback(l2->rx_callback_ctx, ll->sll_addr,
+					(u8 *) ppd + (l2->l2_hdr ? ppd->tp_mac :
+						      ppd->tp_net),
+					ppd->tp_snaplen);
+			ppd = (struct tpacket3_hdr *)
+				((u8 *) ppd + ppd->tp_next_offset);
+		}
+
+		__atomic_store_n(&pbd->hdr.bh1.block_status, TP_STATUS_KERNEL,
+				 __ATOMIC_RELEASE);
+		l2->ring_block = (l2->ring_block + 1) % L2_PACKET_RING_BLOCK_NR;
+	}
+}
+
+
+static void l2_packet_init_ring(struct l2_packet_data *l2)
+{
+	struct tpacket_req3 req;
+	int ver = TPACKET_V3;
+	void *ring;
+
+	if (l2->ring || !l2->rx_callback)
+		return;
+
+	os_memset(&req, 0, sizeof(req));
+	req.tp_block_size = L2_PACKET_RING_BLOCK_SIZE;
+	req.tp_block_nr = L2_PACKET_RING_BLOCK_NR;
+	req.tp_frame_size = L2_PACKET_RING_FRAME_SIZE;
+	req.tp_frame_nr = L2_PACKET_RING_BLOCK_SIZE * L2_PACKET_RING_BLOCK_NR /
+		L2_PACKET_RING_FRAME_SIZE;
+	req.tp_retire_blk_tov = L2_PACKET_RING_BLOCK_TIMEOUT_MS;
+
+	if (setsockopt(l2->fd, SOL_PACKET, PACKET_VERSION, &ver,
+		       sizeof(ver)) < 0 ||
+	    setsockopt(l2->fd, SOL_PACKET, PACKET_RX_RING, &req,
+		       sizeof(req)) < 0) {
+		wpa_printf(MSG_DEBUG,
+			   "l2_packet_linux: Could not set up TPACKET_V3 RX ring on %s: %s",
+			   l2->ifname, strerror(errno));
+		return;
+	}
+
+	ring = mmap(NULL, req.tp_block_size * req.tp_block_nr,
+		    PROT_READ | PROT_WRITE, MAP_SHARED, l2->fd, 0);
+	if (ring == MAP_FAILED) {
+		wpa_printf(MSG_DEBUG, "l2_packet_linux: mmap[RX ring]: %s",
+			   strerror(errno));
+		/* Go back to receiving the frames through recvfrom() */
+		os_memset(&req, 0, sizeof(req));
+		setsockopt(l2->fd, SOL_PACKET, PACKET_RX_RING, &req,
+			   sizeof(req));
+		return;
+	}
+
+	l2->ring = ring;
+	l2->ring_len = req.tp_block_size * req.tp_block_nr;
+	l2->ring_block = 0;
+	eloop_unregister_read_sock(l2->fd);
+	eloop_register_read_sock(l2->fd, l2_packet_receive_ring, l2, NULL);
+	wpa_printf(MSG_DEBUG,
+		   "l2_packet_linux: Using TPACKET_V3 RX ring (%zu bytes) on %s",
+		   l2->ring_len, l2->ifname);
+}
+
+#endif /* CONFIG_L2_PACKET_RX_RING */
+
+
 #ifndef CONFIG_NO_LINUX_PACKET_SOCKET_WAR
 static void l2_packet_receive_br(int sock, void *eloop_ctx, void *sock_ctx)
 {
@@ -432,6 +597,11 @@ void l2_packet_deinit(struct l2_packet_data *l2)
 		close(l2->fd);
 	}
 
+#ifdef CONFIG_L2_PACKET_RX_RING
+	if (l2->ring)
+		munmap(l2->ring, l2->ring_len);
+#endif /* CONFIG_L2_PACKET_RX_RING */
+
 #ifndef CONFIG_NO_LINUX_PACKET_SOCKET_WAR
 	if (l2->fd_br_rx >= 0) {
 		eloop_unregister_read_sock(l2->fd_br_rx);
@@ -511,5 +681,12 @@ int l2_packet_set_packet_filter(struct l2_packet_data *l2,
 		return -1;
 	}
 
+#ifdef CONFIG_L2_PACKET_RX_RING
+	/* The snooping sockets see all the broadcast DHCP and ND traffic in
+	 * the bridge, so read it in batches from a shared memory ring. */
+	if (type == L2_PACKET_FILTER_DHCP || type == L2_PACKET_FILTER_NDISC)
+		l2_packet_init_ring(l2);
+#endif /* CONFIG_L2_PACKET_RX_RING */
+
 	return 0;
 }
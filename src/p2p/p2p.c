@@ -27,6 +27,7 @@
 
 
 static void p2p_state_timeout(void *eloop_ctx, void *timeout_ctx);
+static void p2p_find_timeout(void *eloop_ctx, void *timeout_ctx);
 static void p2p_device_free(struct p2p_data *p2p, struct p2p_device *dev);
 static void p2p_process_presence_req(struct p2p_data *p2p, const u8 *da,
 				     const u8 *sa, const u8 *data, size_t len,
@@ -263,6 +264,43 @@ void p2p_go_neg_failed(struct p2p_data *p2p, int status)
 }
 
 
+static bool p2p_fast_find_active(struct p2p_data *p2p)
+{
+	return p2p->find_type == P2P_FIND_FAST &&
+		(p2p->state == P2P_SEARCH || p2p->state == P2P_SD_DURING_FIND);
+}
+
+
+static void p2p_find_peer_found(struct p2p_data *p2p, struct p2p_device *dev)
+{
+	struct p2p_find_stats *stats = &p2p->find_stats;
+
+	if (!os_reltime_initialized(&stats->start) ||
+	    os_reltime_initialized(&stats->end))
+		return;
+
+	stats->peers++;
+	p2p->find_new_peers++;
+	if (!os_reltime_initialized(&stats->first_peer))
+		os_get_reltime(&stats->first_peer);
+
+	if (!p2p_fast_find_active(p2p) ||
+	    os_reltime_initialized(&stats->target))
+		return;
+	if (!(p2p->find_dev_id &&
+	      ether_addr_equal(dev->info.p2p_device_addr, p2p->find_dev_id)) &&
+	    !(p2p->p2ps_seek && dev->info.p2ps_instance))
+		return;
+
+	os_get_reltime(&stats->target);
+	p2p_dbg(p2p, "Fast find target " MACSTR " found - stop find",
+		MAC2STR(dev->info.p2p_device_addr));
+	/* This may be called while processing scan results, so stop later */
+	eloop_cancel_timeout(p2p_find_timeout, p2p, NULL);
+	eloop_register_timeout(0, 0, p2p_find_timeout, p2p, NULL);
+}
+
+
 static void p2p_listen_in_find(struct p2p_data *p2p, int dev_disc)
 {
 	unsigned int r, tu;
@@ -288,6 +326,20 @@ static void p2p_listen_in_find(struct p2p_data *p2p, int dev_disc)
 		r = 0;
 	tu = (r % ((p2p->max_disc_int - p2p->min_disc_int) + 1) +
 	      p2p->min_disc_int) * 100;
+	if (dev_disc && p2p_fast_find_active(p2p)) {
+		/*
+		 * Keep the Listen state short while new peers are being found
+		 * and allow it to grow by 100 TU for each search iteration
+		 * without any.
+		 */
+		if (p2p->find_new_peers)
+			p2p->find_fast_listen = p2p->min_disc_int;
+		else if (p2p->find_fast_listen < p2p->max_disc_int)
+			p2p->find_fast_listen++;
+		p2p->find_new_peers = 0;
+		if (tu > (unsigned int) p2p->find_fast_listen * 100)
+			tu = p2p->find_fast_listen * 100;
+	}
 	if (p2p->max_disc_tu >= 0 && tu > (unsigned int) p2p->max_disc_tu)
 		tu = p2p->max_disc_tu;
 	if (!dev_disc && tu < 100)
@@ -383,6 +435,17 @@ static void p2p_device_clear_reported(struct p2p_data *p2p)
 }
 
 
+static unsigned int p2p_addr_hash(const u8 *addr)
+{
+	unsigned int i, hash = 0;
+
+	for (i = 0; i < ETH_ALEN; i++)
+		hash = hash * 31 + addr[i];
+
+	return (hash ^ (hash >> 8)) & (P2P_DEVICE_HASH_SIZE - 1);
+}
+
+
 /**
  * p2p_get_device - Fetch a peer entry
  * @p2p: P2P module context from p2p_init()
@@ -392,7 +455,8 @@ static void p2p_device_clear_reported(struct p2p_data *p2p)
 struct p2p_device * p2p_get_device(struct p2p_data *p2p, const u8 *addr)
 {
 	struct p2p_device *dev;
-	dl_list_for_each(dev, &p2p->devices, struct p2p_device, list) {
+	dl_list_for_each(dev, &p2p->devices_hash_dev[p2p_addr_hash(addr)],
+			 struct p2p_device, hash_dev) {
 		if (ether_addr_equal(dev->info.p2p_device_addr, addr))
 			return dev;
 	}
@@ -410,7 +474,18 @@ struct p2p_device * p2p_get_device_interface(struct p2p_data *p2p,
 					     const u8 *addr)
 {
 	struct p2p_device *dev;
-	dl_list_for_each(dev, &p2p->devices, struct p2p_device, list) {
+
+	if (is_zero_ether_addr(addr)) {
+		/* Entries without an Interface Address are not hashed */
+		dl_list_for_each(dev, &p2p->devices, struct p2p_device, list) {
+			if (is_zero_ether_addr(dev->interface_addr))
+				return dev;
+		}
+		return NULL;
+	}
+
+	dl_list_for_each(dev, &p2p->devices_hash_iface[p2p_addr_hash(addr)],
+			 struct p2p_device, hash_iface) {
 		if (ether_addr_equal(dev->interface_addr, addr))
 			return dev;
 	}
@@ -418,6 +493,27 @@ struct p2p_device * p2p_get_device_interface(struct p2p_data *p2p,
 }
 
 
+/**
+ * p2p_device_set_interface_addr - Set the P2P Interface Address of a peer
+ * @p2p: P2P module context from p2p_init()
+ * @dev: Peer entry
+ * @addr: P2P Interface Address of the peer
+ */
+void p2p_device_set_interface_addr(struct p2p_data *p2p,
+				   struct p2p_device *dev, const u8 *addr)
+{
+	if (ether_addr_equal(dev->interface_addr, addr))
+		return;
+
+	dl_list_del(&dev->hash_iface);
+	dl_list_init(&dev->hash_iface);
+	os_memcpy(dev->interface_addr, addr, ETH_ALEN);
+	if (!is_zero_ether_addr(addr))
+		dl_list_add(&p2p->devices_hash_iface[p2p_addr_hash(addr)],
+			    &dev->hash_iface);
+}
+
+
 /**
  * p2p_create_device - Create a peer entry
  * @p2p: P2P module context from p2p_init()
@@ -455,6 +551,9 @@ static struct p2p_device * p2p_create_device(struct p2p_data *p2p,
 	if (dev == NULL)
 		return NULL;
 	dl_list_add(&p2p->devices, &dev->list);
+	dl_list_add(&p2p->devices_hash_dev[p2p_addr_hash(addr)],
+		    &dev->hash_dev);
+	dl_list_init(&dev->hash_iface);
 	os_memcpy(dev->info.p2p_device_addr, addr, ETH_ALEN);
 	dev->support_6ghz = false;
 
@@ -465,6 +564,8 @@ static struct p2p_device * p2p_create_device(struct p2p_data *p2p,
 static void p2p_copy_client_info(struct p2p_device *dev,
 				 struct p2p_client_info *cli)
 {
+	wpabuf_free(dev->last_ies);
+	dev->last_ies = NULL;
 	p2p_copy_filter_devname(dev->info.device_name,
 				sizeof(dev->info.device_name),
 				cli->dev_name, cli->dev_name_len);
@@ -547,10 +648,11 @@ static int p2p_add_group_clients(struct p2p_data *p2p, const u8 *go_dev_addr,
 					    dev->info.p2p_device_addr,
 					    &dev->info, 1);
 			dev->flags |= P2P_DEV_REPORTED | P2P_DEV_REPORTED_ONCE;
+			p2p_find_peer_found(p2p, dev);
 		}
 
-		os_memcpy(dev->interface_addr, cli->p2p_interface_addr,
-			  ETH_ALEN);
+		p2p_device_set_interface_addr(p2p, dev,
+					      cli->p2p_interface_addr);
 		os_memcpy(&dev->last_seen, rx_time, sizeof(struct os_reltime));
 		os_memcpy(dev->member_in_go_dev, go_dev_addr, ETH_ALEN);
 		os_memcpy(dev->member_in_go_iface, go_interface_addr,
@@ -565,6 +667,9 @@ static int p2p_add_group_clients(struct p2p_data *p2p, const u8 *go_dev_addr,
 static void p2p_copy_wps_info(struct p2p_data *p2p, struct p2p_device *dev,
 			      int probe_req, const struct p2p_message *msg)
 {
+	wpabuf_free(dev->last_ies);
+	dev->last_ies = NULL;
+
 	os_memcpy(dev->info.device_name, msg->device_name,
 		  sizeof(dev->info.device_name));
 
@@ -747,6 +852,7 @@ int p2p_add_device(struct p2p_data *p2p, const u8 *addr, int freq,
 	const u8 *p2p_dev_addr;
 	int wfd_changed;
 	int dev_name_changed;
+	bool ies_changed, new_peer;
 	int i;
 	struct os_reltime time_now;
 
@@ -814,7 +920,7 @@ int p2p_add_device(struct p2p_data *p2p, const u8 *addr, int freq,
 			P2P_DEV_LAST_SEEN_AS_GROUP_CLIENT);
 
 	if (!ether_addr_equal(addr, p2p_dev_addr))
-		os_memcpy(dev->interface_addr, addr, ETH_ALEN);
+		p2p_device_set_interface_addr(p2p, dev, addr);
 	if (msg.ssid &&
 	    msg.ssid[1] <= sizeof(dev->oper_ssid) &&
 	    (msg.ssid[1] != P2P_WILDCARD_SSID_LEN ||
@@ -860,20 +966,33 @@ int p2p_add_device(struct p2p_data *p2p, const u8 *addr, int freq,
 	dev_name_changed = os_strncmp(dev->info.device_name, msg.device_name,
 				      WPS_DEV_NAME_MAX_LEN) != 0;
 
-	p2p_copy_wps_info(p2p, dev, 0, &msg);
+	/*
+	 * Peers repeat the same IEs in every Beacon and Probe Response frame,
+	 * so the WPS and vendor information needs to be updated only if the
+	 * IEs differ from the ones it was last copied from.
+	 */
+	ies_changed = !dev->last_ies || wpabuf_len(dev->last_ies) != ies_len ||
+		os_memcmp(wpabuf_head(dev->last_ies), ies, ies_len) != 0;
 
-	for (i = 0; i < P2P_MAX_WPS_VENDOR_EXT; i++) {
-		wpabuf_free(dev->info.wps_vendor_ext[i]);
-		dev->info.wps_vendor_ext[i] = NULL;
-	}
+	if (ies_changed) {
+		p2p_copy_wps_info(p2p, dev, 0, &msg);
 
-	for (i = 0; i < P2P_MAX_WPS_VENDOR_EXT; i++) {
-		if (msg.wps_vendor_ext[i] == NULL)
-			break;
-		dev->info.wps_vendor_ext[i] = wpabuf_alloc_copy(
-			msg.wps_vendor_ext[i], msg.wps_vendor_ext_len[i]);
-		if (dev->info.wps_vendor_ext[i] == NULL)
-			break;
+		for (i = 0; i < P2P_MAX_WPS_VENDOR_EXT; i++) {
+			wpabuf_free(dev->info.wps_vendor_ext[i]);
+			dev->info.wps_vendor_ext[i] = NULL;
+		}
+
+		for (i = 0; i < P2P_MAX_WPS_VENDOR_EXT; i++) {
+			if (msg.wps_vendor_ext[i] == NULL)
+				break;
+			dev->info.wps_vendor_ext[i] = wpabuf_alloc_copy(
+				msg.wps_vendor_ext[i],
+				msg.wps_vendor_ext_len[i]);
+			if (dev->info.wps_vendor_ext[i] == NULL)
+				break;
+		}
+
+		dev->last_ies = wpabuf_alloc_copy(ies, ies_len);
 	}
 
 	wfd_changed = p2p_compare_wfd_info(dev, &msg);
@@ -894,7 +1013,8 @@ int p2p_add_device(struct p2p_data *p2p, const u8 *addr, int freq,
 
 	p2p_parse_free(&msg);
 
-	p2p_update_peer_vendor_elems(dev, ies, ies_len);
+	if (ies_changed)
+		p2p_update_peer_vendor_elems(dev, ies, ies_len);
 
 	if (dev->flags & P2P_DEV_REPORTED && !wfd_changed &&
 	    !dev_name_changed &&
@@ -910,7 +1030,7 @@ int p2p_add_device(struct p2p_data *p2p, const u8 *addr, int freq,
 		return 0;
 	}
 
-	if (dev->info.config_methods == 0 &&
+	if (dev->info.config_methods == 0 && !p2p_fast_find_active(p2p) &&
 	    (freq == 2412 || freq == 2437 || freq == 2462)) {
 		/*
 		 * If we have only seen a Beacon frame from a GO, we do not yet
@@ -931,6 +1051,7 @@ int p2p_add_device(struct p2p_data *p2p, const u8 *addr, int freq,
 		return 0;
 	}
 
+	new_peer = !(dev->flags & P2P_DEV_REPORTED);
 	p2p->cfg->dev_found(p2p->cfg->cb_ctx, addr, &dev->info,
 			    !(dev->flags & P2P_DEV_REPORTED_ONCE));
 	dev->flags |= P2P_DEV_REPORTED | P2P_DEV_REPORTED_ONCE;
@@ -938,6 +1059,9 @@ int p2p_add_device(struct p2p_data *p2p, const u8 *addr, int freq,
 	if (msg.adv_service_instance)
 		dev->flags |= P2P_DEV_P2PS_REPORTED;
 
+	if (new_peer)
+		p2p_find_peer_found(p2p, dev);
+
 	return 0;
 }
 
@@ -984,7 +1108,10 @@ static void p2p_device_free(struct p2p_data *p2p, struct p2p_device *dev)
 	wpabuf_free(dev->info.vendor_elems);
 	wpabuf_free(dev->go_neg_conf);
 	wpabuf_free(dev->info.p2ps_instance);
+	wpabuf_free(dev->last_ies);
 
+	dl_list_del(&dev->hash_dev);
+	dl_list_del(&dev->hash_iface);
 	os_free(dev);
 }
 
@@ -1065,7 +1192,8 @@ static void p2p_search(struct p2p_data *p2p)
 		p2p->find_pending_full = 0;
 	} else if ((p2p->find_type == P2P_FIND_PROGRESSIVE &&
 	    (freq = p2p_get_next_prog_freq(p2p)) > 0) ||
-	    (p2p->find_type == P2P_FIND_START_WITH_FULL &&
+	    ((p2p->find_type == P2P_FIND_START_WITH_FULL ||
+	      p2p->find_type == P2P_FIND_FAST) &&
 	     (freq = p2p->find_specified_freq) > 0)) {
 		type = P2P_SCAN_SOCIAL_PLUS_ONE;
 		p2p_dbg(p2p, "Starting search (+ freq %u)", freq);
@@ -1074,6 +1202,7 @@ static void p2p_search(struct p2p_data *p2p)
 		p2p_dbg(p2p, "Starting search");
 	}
 
+	p2p->find_stats.rounds++;
 	res = p2p->cfg->p2p_scan(p2p->cfg->cb_ctx, type, freq,
 				 p2p->num_req_dev_types, p2p->req_dev_types,
 				 p2p->find_dev_id, pw_id, p2p->include_6ghz);
@@ -1204,6 +1333,7 @@ int p2p_find(struct p2p_data *p2p, unsigned int timeout,
 {
 	int res;
 	struct os_reltime start;
+	struct p2p_device *dev;
 
 	p2p_dbg(p2p, "Starting find (type=%d)", type);
 	if (p2p->p2p_scan_running) {
@@ -1285,6 +1415,11 @@ int p2p_find(struct p2p_data *p2p, unsigned int timeout,
 	p2p_set_state(p2p, P2P_SEARCH);
 	p2p->search_delay = search_delay;
 	p2p->in_search_delay = 0;
+	p2p->find_fast_listen = p2p->min_disc_int;
+	p2p->find_new_peers = 0;
+	os_memset(&p2p->find_stats, 0, sizeof(p2p->find_stats));
+	p2p->find_stats.type = type;
+	os_get_reltime(&p2p->find_stats.start);
 	eloop_cancel_timeout(p2p_find_timeout, p2p, NULL);
 	p2p->last_p2p_find_timeout = timeout;
 	if (timeout)
@@ -1319,6 +1454,20 @@ int p2p_find(struct p2p_data *p2p, unsigned int timeout,
 					 p2p->req_dev_types, dev_id,
 					 DEV_PW_DEFAULT, p2p->include_6ghz);
 		break;
+	case P2P_FIND_FAST:
+		/* Start with the Listen channel of the peer, if known */
+		dev = dev_id ? p2p_get_device(p2p, dev_id) : NULL;
+		if (freq <= 0 && dev && dev->listen_freq > 0)
+			freq = dev->listen_freq;
+		if (freq > 0)
+			p2p_dbg(p2p, "Fast find starting on %d MHz", freq);
+		res = p2p->cfg->p2p_scan(p2p->cfg->cb_ctx,
+					 freq > 0 ? P2P_SCAN_SPECIFIC :
+					 P2P_SCAN_SOCIAL, freq > 0 ? freq : 0,
+					 p2p->num_req_dev_types,
+					 p2p->req_dev_types, dev_id,
+					 DEV_PW_DEFAULT, p2p->include_6ghz);
+		break;
 	default:
 		return -1;
 	}
@@ -1351,6 +1500,18 @@ void p2p_stop_find_for_freq(struct p2p_data *p2p, int freq)
 	if (p2p->state == P2P_SEARCH || p2p->state == P2P_SD_DURING_FIND)
 		p2p->cfg->find_stopped(p2p->cfg->cb_ctx);
 
+	if (os_reltime_initialized(&p2p->find_stats.start) &&
+	    !os_reltime_initialized(&p2p->find_stats.end)) {
+		struct os_reltime diff;
+
+		os_get_reltime(&p2p->find_stats.end);
+		os_reltime_sub(&p2p->find_stats.end, &p2p->find_stats.start,
+			       &diff);
+		p2p_dbg(p2p, "Find took %ld ms (rounds=%u peers=%u)",
+			(long) (diff.sec * 1000 + diff.usec / 1000),
+			p2p->find_stats.rounds, p2p->find_stats.peers);
+	}
+
 	p2p->p2ps_seek_count = 0;
 
 	p2p_set_state(p2p, P2P_IDLE);
@@ -1422,6 +1583,65 @@ void p2p_stop_find(struct p2p_data *p2p)
 }
 
 
+static int p2p_find_stats_phase(char *pos, char *end, const char *name,
+				struct os_reltime *start, struct os_reltime *t)
+{
+	struct os_reltime diff;
+	int ret;
+
+	if (!os_reltime_initialized(t))
+		return 0;
+	os_reltime_sub(t, start, &diff);
+	ret = os_snprintf(pos, end - pos, "%s_ms=%ld\n", name,
+			  (long) (diff.sec * 1000 + diff.usec / 1000));
+	if (os_snprintf_error(end - pos, ret))
+		return -1;
+	return ret;
+}
+
+
+int p2p_get_find_stats(struct p2p_data *p2p, char *buf, size_t buflen)
+{
+	struct p2p_find_stats *stats = &p2p->find_stats;
+	char *pos = buf, *end = buf + buflen;
+	int ret;
+
+	if (!os_reltime_initialized(&stats->start))
+		return 0;
+
+	ret = os_snprintf(pos, end - pos, "type=%d\nactive=%d\nrounds=%u\n"
+			  "peers=%u\n", stats->type,
+			  !os_reltime_initialized(&stats->end),
+			  stats->rounds, stats->peers);
+	if (os_snprintf_error(end - pos, ret))
+		return -1;
+	pos += ret;
+
+	ret = p2p_find_stats_phase(pos, end, "scan_results", &stats->start,
+				   &stats->first_scan_res);
+	if (ret < 0)
+		return -1;
+	pos += ret;
+	ret = p2p_find_stats_phase(pos, end, "first_peer", &stats->start,
+				   &stats->first_peer);
+	if (ret < 0)
+		return -1;
+	pos += ret;
+	ret = p2p_find_stats_phase(pos, end, "target", &stats->start,
+				   &stats->target);
+	if (ret < 0)
+		return -1;
+	pos += ret;
+	ret = p2p_find_stats_phase(pos, end, "total", &stats->start,
+				   &stats->end);
+	if (ret < 0)
+		return -1;
+	pos += ret;
+
+	return pos - buf;
+}
+
+
 static int p2p_prepare_channel_pref(struct p2p_data *p2p,
 				    unsigned int force_freq,
 				    unsigned int pref_freq, int go)
@@ -3085,8 +3305,10 @@ bool is_p2p_dfs_chan_enabled(struct p2p_data *p2p)
 
 void p2p_set_dev_addr(struct p2p_data *p2p, const u8 *addr)
 {
-	if (p2p && addr)
+	if (p2p && addr) {
 		os_memcpy(p2p->cfg->dev_addr, addr, ETH_ALEN);
+		p2p_build_cache_flush(p2p);
+	}
 }
 
 
@@ -3141,6 +3363,7 @@ static int p2p_pairing_info_init(struct p2p_data *p2p)
 struct p2p_data * p2p_init(const struct p2p_config *cfg)
 {
 	struct p2p_data *p2p;
+	unsigned int i;
 
 	if (cfg->max_peers < 1 ||
 	    cfg->passphrase_len < 8 || cfg->passphrase_len > 63)
@@ -3189,6 +3412,10 @@ struct p2p_data * p2p_init(const struct p2p_config *cfg)
 	p2p->dev_capab |= P2P_DEV_CAPAB_CLIENT_DISCOVERABILITY;
 
 	dl_list_init(&p2p->devices);
+	for (i = 0; i < P2P_DEVICE_HASH_SIZE; i++) {
+		dl_list_init(&p2p->devices_hash_dev[i]);
+		dl_list_init(&p2p->devices_hash_iface[i]);
+	}
 
 	p2p->go_timeout = 100;
 	p2p->client_timeout = 20;
@@ -3238,6 +3465,7 @@ void p2p_deinit(struct p2p_data *p2p)
 	p2ps_prov_free(p2p);
 	wpabuf_free(p2p->sd_resp);
 	p2p_remove_wps_vendor_extensions(p2p);
+	p2p_build_cache_flush(p2p);
 	os_free(p2p->no_go_freq.range);
 	p2p_service_flush_asp(p2p);
 	p2p_pairing_info_deinit(p2p);
@@ -3292,6 +3520,7 @@ int p2p_unauthorize(struct p2p_data *p2p, const u8 *addr)
 
 int p2p_set_dev_name(struct p2p_data *p2p, const char *dev_name)
 {
+	p2p_build_cache_flush(p2p);
 	os_free(p2p->cfg->dev_name);
 	if (dev_name) {
 		p2p->cfg->dev_name = os_strdup(dev_name);
@@ -3305,6 +3534,7 @@ int p2p_set_dev_name(struct p2p_data *p2p, const char *dev_name)
 
 int p2p_set_manufacturer(struct p2p_data *p2p, const char *manufacturer)
 {
+	p2p_build_cache_flush(p2p);
 	os_free(p2p->cfg->manufacturer);
 	p2p->cfg->manufacturer = NULL;
 	if (manufacturer) {
@@ -3319,6 +3549,7 @@ int p2p_set_manufacturer(struct p2p_data *p2p, const char *manufacturer)
 
 int p2p_set_model_name(struct p2p_data *p2p, const char *model_name)
 {
+	p2p_build_cache_flush(p2p);
 	os_free(p2p->cfg->model_name);
 	p2p->cfg->model_name = NULL;
 	if (model_name) {
@@ -3333,6 +3564,7 @@ int p2p_set_model_name(struct p2p_data *p2p, const char *model_name)
 
 int p2p_set_model_number(struct p2p_data *p2p, const char *model_number)
 {
+	p2p_build_cache_flush(p2p);
 	os_free(p2p->cfg->model_number);
 	p2p->cfg->model_number = NULL;
 	if (model_number) {
@@ -3347,6 +3579,7 @@ int p2p_set_model_number(struct p2p_data *p2p, const char *model_number)
 
 int p2p_set_serial_number(struct p2p_data *p2p, const char *serial_number)
 {
+	p2p_build_cache_flush(p2p);
 	os_free(p2p->cfg->serial_number);
 	p2p->cfg->serial_number = NULL;
 	if (serial_number) {
@@ -3362,18 +3595,21 @@ int p2p_set_serial_number(struct p2p_data *p2p, const char *serial_number)
 void p2p_set_config_methods(struct p2p_data *p2p, u16 config_methods)
 {
 	p2p->cfg->config_methods = config_methods;
+	p2p_build_cache_flush(p2p);
 }
 
 
 void p2p_set_uuid(struct p2p_data *p2p, const u8 *uuid)
 {
 	os_memcpy(p2p->cfg->uuid, uuid, 16);
+	p2p_build_cache_flush(p2p);
 }
 
 
 int p2p_set_pri_dev_type(struct p2p_data *p2p, const u8 *pri_dev_type)
 {
 	os_memcpy(p2p->cfg->pri_dev_type, pri_dev_type, 8);
+	p2p_build_cache_flush(p2p);
 	return 0;
 }
 
@@ -3385,6 +3621,7 @@ int p2p_set_sec_dev_types(struct p2p_data *p2p, const u8 dev_types[][8],
 		num_dev_types = P2P_SEC_DEVICE_TYPES;
 	p2p->cfg->num_sec_dev_types = num_dev_types;
 	os_memcpy(p2p->cfg->sec_dev_type, dev_types, num_dev_types * 8);
+	p2p_build_cache_flush(p2p);
 	return 0;
 }
 
@@ -3745,6 +3982,11 @@ void p2p_scan_res_handled(struct p2p_data *p2p, unsigned int delay)
 
 	eloop_cancel_timeout(p2p_scan_timeout, p2p, NULL);
 
+	if (p2p->state == P2P_SEARCH &&
+	    os_reltime_initialized(&p2p->find_stats.start) &&
+	    !os_reltime_initialized(&p2p->find_stats.first_scan_res))
+		os_get_reltime(&p2p->find_stats.first_scan_res);
+
 	if (p2p_run_after_scan(p2p))
 		return;
 	if (p2p->state == P2P_SEARCH)
@@ -6159,6 +6401,8 @@ void p2p_process_usd_elems(struct p2p_data *p2p, const u8 *ies, u16 ies_len,
 		dev->info.dev_capab |= msg.capability[0] &
 			~P2P_DEV_CAPAB_CLIENT_DISCOVERABILITY;
 		dev->info.group_capab = msg.capability[1];
+		wpabuf_free(dev->last_ies);
+		dev->last_ies = NULL;
 	}
 
 	if (msg.pcea_info && msg.pcea_info_len >= 2)
@@ -6169,7 +6413,7 @@ void p2p_process_usd_elems(struct p2p_data *p2p, const u8 *ies, u16 ies_len,
 			WPA_GET_LE16(msg.pbma_info);
 
 	if (!ether_addr_equal(peer_addr, p2p_dev_addr))
-		os_memcpy(dev->interface_addr, peer_addr, ETH_ALEN);
+		p2p_device_set_interface_addr(p2p, dev, peer_addr);
 
 	if (msg.dira && msg.dira_len)
 		p2p_validate_dira(p2p, dev, msg.dira, msg.dira_len);
@@ -1485,7 +1485,8 @@ int p2p_set_country(struct p2p_data *p2p, const char *country);
 enum p2p_discovery_type {
 	P2P_FIND_START_WITH_FULL,
 	P2P_FIND_ONLY_SOCIAL,
-	P2P_FIND_PROGRESSIVE
+	P2P_FIND_PROGRESSIVE,
+	P2P_FIND_FAST
 };
 
 /**
@@ -1507,6 +1508,12 @@ enum p2p_discovery_type {
  *	scan will be executed.
  * @include_6ghz: Include 6 GHz channels in P2P find
  * Returns: 0 on success, -1 on failure
+ *
+ * With type == P2P_FIND_FAST, only social channels are scanned, starting with
+ * the known Listen channel of the dev_id peer, if any. The Listen state between
+ * the search iterations is kept short while new peers are being found, peers
+ * are reported on the first received frame, and the operation is stopped once
+ * the dev_id peer or a peer advertising a sought service has been found.
  */
 int p2p_find(struct p2p_data *p2p, unsigned int timeout,
 	     enum p2p_discovery_type type,
@@ -1528,6 +1535,15 @@ void p2p_notify_scan_trigger_status(struct p2p_data *p2p, int status);
  */
 void p2p_stop_find(struct p2p_data *p2p);
 
+/**
+ * p2p_get_find_stats - Get latency metrics of the latest P2P find
+ * @p2p: P2P module context from p2p_init()
+ * @buf: Buffer for the text
+ * @buflen: Length of the buffer
+ * Returns: Number of octets written to the buffer or -1 on failure
+ */
+int p2p_get_find_stats(struct p2p_data *p2p, char *buf, size_t buflen);
+
 /**
  * p2p_stop_find_for_freq - Stop P2P Find for next oper on specific freq
  * @p2p: P2P module context from p2p_init()
@@ -202,8 +202,8 @@ void p2p_buf_add_status(struct wpabuf *buf, u8 status)
 }
 
 
-void p2p_buf_add_device_info(struct wpabuf *buf, struct p2p_data *p2p,
-			     struct p2p_device *peer)
+static void p2p_build_device_info(struct wpabuf *buf, struct p2p_data *p2p,
+				  struct p2p_device *peer)
 {
 	u8 *len;
 	u16 methods;
@@ -257,6 +257,33 @@ void p2p_buf_add_device_info(struct wpabuf *buf, struct p2p_data *p2p,
 
 	/* Update attribute length */
 	WPA_PUT_LE16(len, (u8 *) wpabuf_put(buf, 0) - len - 2);
+}
+
+
+void p2p_buf_add_device_info(struct wpabuf *buf, struct p2p_data *p2p,
+			     struct p2p_device *peer)
+{
+	size_t nlen;
+
+	if (peer && peer->wps_method != WPS_NOT_READY) {
+		p2p_build_device_info(buf, p2p, peer);
+		wpa_printf(MSG_DEBUG, "P2P: * Device Info");
+		return;
+	}
+
+	if (!p2p->dev_info_attr) {
+		nlen = p2p->cfg->dev_name ? os_strlen(p2p->cfg->dev_name) : 0;
+		p2p->dev_info_attr = wpabuf_alloc(
+			24 + WPS_DEV_TYPE_LEN * p2p->cfg->num_sec_dev_types +
+			nlen);
+		if (p2p->dev_info_attr)
+			p2p_build_device_info(p2p->dev_info_attr, p2p, NULL);
+	}
+
+	if (p2p->dev_info_attr)
+		wpabuf_put_buf(buf, p2p->dev_info_attr);
+	else
+		p2p_build_device_info(buf, p2p, NULL);
 	wpa_printf(MSG_DEBUG, "P2P: * Device Info");
 }
 
@@ -860,6 +887,77 @@ static int p2p_add_wps_string(struct wpabuf *buf, enum wps_attribute attr,
 }
 
 
+static size_t p2p_wps_string_len(const char *val)
+{
+	return 4 + (val && val[0] ? os_strlen(val) : 1);
+}
+
+
+static struct wpabuf * p2p_build_wps_dev_attrs(struct p2p_data *p2p)
+{
+	struct wpabuf *buf;
+
+	buf = wpabuf_alloc(5 + 4 + WPS_UUID_LEN +
+			   p2p_wps_string_len(p2p->cfg->manufacturer) +
+			   p2p_wps_string_len(p2p->cfg->model_name) +
+			   p2p_wps_string_len(p2p->cfg->model_number) +
+			   p2p_wps_string_len(p2p->cfg->serial_number) +
+			   4 + WPS_DEV_TYPE_LEN +
+			   p2p_wps_string_len(p2p->cfg->dev_name) + 6);
+	if (!buf)
+		return NULL;
+
+	wpabuf_put_be16(buf, ATTR_RESPONSE_TYPE);
+	wpabuf_put_be16(buf, 1);
+	wpabuf_put_u8(buf, WPS_RESP_ENROLLEE_INFO);
+
+	if (wps_build_uuid_e(buf, p2p->cfg->uuid) < 0 ||
+	    p2p_add_wps_string(buf, ATTR_MANUFACTURER,
+			       p2p->cfg->manufacturer) < 0 ||
+	    p2p_add_wps_string(buf, ATTR_MODEL_NAME,
+			       p2p->cfg->model_name) < 0 ||
+	    p2p_add_wps_string(buf, ATTR_MODEL_NUMBER,
+			       p2p->cfg->model_number) < 0 ||
+	    p2p_add_wps_string(buf, ATTR_SERIAL_NUMBER,
+			       p2p->cfg->serial_number) < 0)
+		goto fail;
+
+	wpabuf_put_be16(buf, ATTR_PRIMARY_DEV_TYPE);
+	wpabuf_put_be16(buf, WPS_DEV_TYPE_LEN);
+	wpabuf_put_data(buf, p2p->cfg->pri_dev_type, WPS_DEV_TYPE_LEN);
+
+	if (p2p_add_wps_string(buf, ATTR_DEV_NAME, p2p->cfg->dev_name) < 0 ||
+	    wpabuf_tailroom(buf) < 6)
+		goto fail;
+
+	wpabuf_put_be16(buf, ATTR_CONFIG_METHODS);
+	wpabuf_put_be16(buf, 2);
+	wpabuf_put_be16(buf, p2p->cfg->config_methods);
+
+	return buf;
+
+fail:
+	wpabuf_free(buf);
+	return NULL;
+}
+
+
+/**
+ * p2p_build_cache_flush - Clear the cached attributes
+ * @p2p: P2P module context from p2p_init()
+ *
+ * This needs to be called whenever the local device configuration used in the
+ * cached P2P Device Info or WPS attributes changes.
+ */
+void p2p_build_cache_flush(struct p2p_data *p2p)
+{
+	wpabuf_free(p2p->dev_info_attr);
+	p2p->dev_info_attr = NULL;
+	wpabuf_free(p2p->wps_dev_attrs);
+	p2p->wps_dev_attrs = NULL;
+}
+
+
 int p2p_build_wps_ie(struct p2p_data *p2p, struct wpabuf *buf, int pw_id,
 		     int all_attr)
 {
@@ -895,38 +993,12 @@ int p2p_build_wps_ie(struct p2p_data *p2p, struct wpabuf *buf, int pw_id,
 	}
 
 	if (all_attr) {
-		if (wpabuf_tailroom(buf) < 5)
+		if (!p2p->wps_dev_attrs)
+			p2p->wps_dev_attrs = p2p_build_wps_dev_attrs(p2p);
+		if (!p2p->wps_dev_attrs ||
+		    wpabuf_tailroom(buf) < wpabuf_len(p2p->wps_dev_attrs))
 			return -1;
-		wpabuf_put_be16(buf, ATTR_RESPONSE_TYPE);
-		wpabuf_put_be16(buf, 1);
-		wpabuf_put_u8(buf, WPS_RESP_ENROLLEE_INFO);
-
-		if (wps_build_uuid_e(buf, p2p->cfg->uuid) < 0 ||
-		    p2p_add_wps_string(buf, ATTR_MANUFACTURER,
-				       p2p->cfg->manufacturer) < 0 ||
-		    p2p_add_wps_string(buf, ATTR_MODEL_NAME,
-				       p2p->cfg->model_name) < 0 ||
-		    p2p_add_wps_string(buf, ATTR_MODEL_NUMBER,
-				       p2p->cfg->model_number) < 0 ||
-		    p2p_add_wps_string(buf, ATTR_SERIAL_NUMBER,
-				       p2p->cfg->serial_number) < 0)
-			return -1;
-
-		if (wpabuf_tailroom(buf) < 4 + WPS_DEV_TYPE_LEN)
-			return -1;
-		wpabuf_put_be16(buf, ATTR_PRIMARY_DEV_TYPE);
-		wpabuf_put_be16(buf, WPS_DEV_TYPE_LEN);
-		wpabuf_put_data(buf, p2p->cfg->pri_dev_type, WPS_DEV_TYPE_LEN);
-
-		if (p2p_add_wps_string(buf, ATTR_DEV_NAME, p2p->cfg->dev_name)
-		    < 0)
-			return -1;
-
-		if (wpabuf_tailroom(buf) < 6)
-			return -1;
-		wpabuf_put_be16(buf, ATTR_CONFIG_METHODS);
-		wpabuf_put_be16(buf, 2);
-		wpabuf_put_be16(buf, p2p->cfg->config_methods);
+		wpabuf_put_buf(buf, p2p->wps_dev_attrs);
 	}
 
 	if (wps_build_wfa_ext(buf, 0, NULL, 0, 0) < 0)
@@ -69,6 +69,9 @@ struct p2p_bootstrap_params {
  */
 struct p2p_device {
 	struct dl_list list;
+	/* List entries for struct p2p_data::devices_hash_dev/_iface[] */
+	struct dl_list hash_dev;
+	struct dl_list hash_iface;
 	struct os_reltime last_seen;
 	int listen_freq;
 	int oob_go_neg_freq;
@@ -125,6 +128,15 @@ struct p2p_device {
 	 */
 	u16 wps_prov_info;
 
+	/**
+	 * last_ies - IEs of the frame the WPS info was last copied from
+	 *
+	 * This is used to skip parsing the WPS and vendor information again
+	 * when a peer keeps sending the same IEs. It is cleared whenever the
+	 * information is updated from another source.
+	 */
+	struct wpabuf *last_ies;
+
 #define P2P_DEV_PROBE_REQ_ONLY BIT(0)
 #define P2P_DEV_REPORTED BIT(1)
 #define P2P_DEV_NOT_YET_READY BIT(2)
@@ -352,6 +364,16 @@ struct p2p_data {
 	 */
 	struct dl_list devices;
 
+	/**
+	 * devices_hash_dev - Peers hashed by P2P Device Address
+	 * devices_hash_iface - Peers hashed by P2P Interface Address
+	 *
+	 * Peers without a known P2P Interface Address are not in the latter.
+	 */
+#define P2P_DEVICE_HASH_SIZE 64
+	struct dl_list devices_hash_dev[P2P_DEVICE_HASH_SIZE];
+	struct dl_list devices_hash_iface[P2P_DEVICE_HASH_SIZE];
+
 	/**
 	 * go_neg_peer - Pointer to GO Negotiation peer
 	 */
@@ -552,6 +574,27 @@ struct p2p_data {
 
 	struct os_reltime find_start; /* time of last p2p_find start */
 
+	/* Listen duration in 100 TU units for P2P_FIND_FAST */
+	int find_fast_listen;
+	/* Number of peers found during the current search iteration */
+	unsigned int find_new_peers;
+
+	/**
+	 * find_stats - Latency metrics of the latest p2p_find operation
+	 *
+	 * The times are zero for the phases that were not reached.
+	 */
+	struct p2p_find_stats {
+		enum p2p_discovery_type type;
+		struct os_reltime start;
+		struct os_reltime first_scan_res; /* first search results */
+		struct os_reltime first_peer; /* first peer reported */
+		struct os_reltime target; /* P2P_FIND_FAST target found */
+		struct os_reltime end;
+		unsigned int rounds; /* search iterations */
+		unsigned int peers; /* peers reported */
+	} find_stats;
+
 	struct p2p_group **groups;
 	size_t num_groups;
 
@@ -582,6 +625,24 @@ struct p2p_data {
 	 */
 	struct wpabuf *wps_vendor_ext[P2P_MAX_WPS_VENDOR_EXT];
 
+	/**
+	 * dev_info_attr - Cached P2P Device Info attribute
+	 *
+	 * This is the attribute used when no WPS method has been selected
+	 * for the peer. It is built from the local device configuration on
+	 * first use and cleared with p2p_build_cache_flush() whenever that
+	 * configuration changes.
+	 */
+	struct wpabuf *dev_info_attr;
+
+	/**
+	 * wps_dev_attrs - Cached WPS device attributes
+	 *
+	 * Response Type through Config Methods attributes of the WPS IE in
+	 * Probe Response frames. Cleared with p2p_build_cache_flush().
+	 */
+	struct wpabuf *wps_dev_attrs;
+
 	/*
 	 * user_initiated_pd - Whether a PD request is user initiated or not.
 	 */
@@ -958,6 +1019,7 @@ void p2p_buf_add_pbma(struct wpabuf *buf, u16 bootstrap, const u8 *cookie,
 void p2p_buf_add_dira(struct wpabuf *buf, struct p2p_data *p2p);
 int p2p_build_wps_ie(struct p2p_data *p2p, struct wpabuf *buf, int pw_id,
 		     int all_attr);
+void p2p_build_cache_flush(struct p2p_data *p2p);
 void p2p_buf_add_pref_channel_list(struct wpabuf *buf,
 				   const struct weighted_pcl *pref_freq_list,
 				   unsigned int size);
@@ -1056,6 +1118,8 @@ void p2p_continue_find(struct p2p_data *p2p);
 struct p2p_device * p2p_add_dev_from_go_neg_req(struct p2p_data *p2p,
 						const u8 *addr,
 						struct p2p_message *msg);
+void p2p_device_set_interface_addr(struct p2p_data *p2p,
+				    struct p2p_device *dev, const u8 *addr);
 void p2p_update_peer_6ghz_capab(struct p2p_device *dev,
 				const struct p2p_message *msg);
 void p2p_add_dev_info(struct p2p_data *p2p, const u8 *addr,
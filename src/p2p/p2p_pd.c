@@ -1514,8 +1514,8 @@ out:
 		}
 
 		if (msg->intended_addr)
-			os_memcpy(dev->interface_addr, msg->intended_addr,
-				  ETH_ALEN);
+			p2p_device_set_interface_addr(p2p, dev,
+						      msg->intended_addr);
 	}
 }
 
@@ -1971,7 +1971,7 @@ static void p2p_process_prov_disc_resp(struct p2p_data *p2p,
 	/* Store the provisioning info */
 	dev->wps_prov_info = msg->wps_config_methods;
 	if (msg->intended_addr)
-		os_memcpy(dev->interface_addr, msg->intended_addr, ETH_ALEN);
+		p2p_device_set_interface_addr(p2p, dev, msg->intended_addr);
 
 out:
 	dev->req_config_methods = 0;
@@ -76,23 +76,55 @@ int p2p_freq_to_channel(unsigned int freq, u8 *op_class, u8 *channel)
 }
 
 
+/* Channel numbers of one operating class as a bitmap */
+#define P2P_CHAN_BITMAP_WORDS (256 / 32)
+
+static void p2p_reg_class_bitmap(const struct p2p_reg_class *cl, u32 *bitmap)
+{
+	size_t i;
+
+	os_memset(bitmap, 0, P2P_CHAN_BITMAP_WORDS * sizeof(u32));
+	for (i = 0; i < cl->channels; i++)
+		bitmap[cl->channel[i] / 32] |= BIT(cl->channel[i] % 32);
+}
+
+
+static bool p2p_chan_bitmap_get(const u32 *bitmap, u8 chan)
+{
+	return !!(bitmap[chan / 32] & BIT(chan % 32));
+}
+
+
 static void p2p_reg_class_intersect(const struct p2p_reg_class *a,
 				    const struct p2p_reg_class *b,
 				    struct p2p_reg_class *res)
 {
-	size_t i, j;
+	u32 b_chan[P2P_CHAN_BITMAP_WORDS];
+	size_t i;
 
 	res->reg_class = a->reg_class;
 
+	p2p_reg_class_bitmap(b, b_chan);
 	for (i = 0; i < a->channels; i++) {
-		for (j = 0; j < b->channels; j++) {
-			if (a->channel[i] != b->channel[j])
-				continue;
-			res->channel[res->channels] = a->channel[i];
-			res->channels++;
-			if (res->channels == P2P_MAX_REG_CLASS_CHANNELS)
-				return;
-		}
+		if (!p2p_chan_bitmap_get(b_chan, a->channel[i]))
+			continue;
+		res->channel[res->channels] = a->channel[i];
+		res->channels++;
+		if (res->channels == P2P_MAX_REG_CLASS_CHANNELS)
+			return;
+	}
+}
+
+
+/* Position + 1 of each operating class in the channel list */
+static void p2p_channels_index(const struct p2p_channels *chan, u8 *pos)
+{
+	size_t i;
+
+	os_memset(pos, 0, 256);
+	for (i = 0; i < chan->reg_classes; i++) {
+		if (!pos[chan->reg_class[i].reg_class])
+			pos[chan->reg_class[i].reg_class] = i + 1;
 	}
 }
 
@@ -112,24 +144,24 @@ void p2p_channels_intersect(const struct p2p_channels *a,
 			    const struct p2p_channels *b,
 			    struct p2p_channels *res)
 {
-	size_t i, j;
+	u8 b_pos[256];
+	size_t i;
 
 	os_memset(res, 0, sizeof(*res));
 
+	p2p_channels_index(b, b_pos);
 	for (i = 0; i < a->reg_classes; i++) {
 		const struct p2p_reg_class *a_reg = &a->reg_class[i];
-		for (j = 0; j < b->reg_classes; j++) {
-			const struct p2p_reg_class *b_reg = &b->reg_class[j];
-			if (a_reg->reg_class != b_reg->reg_class)
-				continue;
-			p2p_reg_class_intersect(
-				a_reg, b_reg,
-				&res->reg_class[res->reg_classes]);
-			if (res->reg_class[res->reg_classes].channels) {
-				res->reg_classes++;
-				if (res->reg_classes == P2P_MAX_REG_CLASSES)
-					return;
-			}
+		u8 j = b_pos[a_reg->reg_class];
+
+		if (!j)
+			continue;
+		p2p_reg_class_intersect(a_reg, &b->reg_class[j - 1],
+					&res->reg_class[res->reg_classes]);
+		if (res->reg_class[res->reg_classes].channels) {
+			res->reg_classes++;
+			if (res->reg_classes == P2P_MAX_REG_CLASSES)
+				return;
 		}
 	}
 }
@@ -138,18 +170,19 @@ void p2p_channels_intersect(const struct p2p_channels *a,
 static void p2p_op_class_union(struct p2p_reg_class *cl,
 			       const struct p2p_reg_class *b_cl)
 {
-	size_t i, j;
+	u32 cl_chan[P2P_CHAN_BITMAP_WORDS];
+	size_t i;
 
+	p2p_reg_class_bitmap(cl, cl_chan);
 	for (i = 0; i < b_cl->channels; i++) {
-		for (j = 0; j < cl->channels; j++) {
-			if (b_cl->channel[i] == cl->channel[j])
-				break;
-		}
-		if (j == cl->channels) {
-			if (cl->channels == P2P_MAX_REG_CLASS_CHANNELS)
-				return;
-			cl->channel[cl->channels++] = b_cl->channel[i];
-		}
+		u8 chan = b_cl->channel[i];
+
+		if (p2p_chan_bitmap_get(cl_chan, chan))
+			continue;
+		if (cl->channels == P2P_MAX_REG_CLASS_CHANNELS)
+			return;
+		cl->channel[cl->channels++] = chan;
+		cl_chan[chan / 32] |= BIT(chan % 32);
 	}
 }
 
@@ -162,33 +195,24 @@ static void p2p_op_class_union(struct p2p_reg_class *cl,
 void p2p_channels_union_inplace(struct p2p_channels *res,
 				const struct p2p_channels *b)
 {
+	u8 res_pos[256];
 	size_t i, j;
 
-	for (i = 0; i < res->reg_classes; i++) {
-		struct p2p_reg_class *cl = &res->reg_class[i];
-		for (j = 0; j < b->reg_classes; j++) {
-			const struct p2p_reg_class *b_cl = &b->reg_class[j];
-			if (cl->reg_class != b_cl->reg_class)
-				continue;
-			p2p_op_class_union(cl, b_cl);
-		}
-	}
-
+	p2p_channels_index(res, res_pos);
 	for (j = 0; j < b->reg_classes; j++) {
 		const struct p2p_reg_class *b_cl = &b->reg_class[j];
 
-		for (i = 0; i < res->reg_classes; i++) {
-			struct p2p_reg_class *cl = &res->reg_class[i];
-			if (cl->reg_class == b_cl->reg_class)
-				break;
+		i = res_pos[b_cl->reg_class];
+		if (i) {
+			p2p_op_class_union(&res->reg_class[i - 1], b_cl);
+			continue;
 		}
 
-		if (i == res->reg_classes) {
-			if (res->reg_classes == P2P_MAX_REG_CLASSES)
-				return;
-			os_memcpy(&res->reg_class[res->reg_classes++],
-				  b_cl, sizeof(struct p2p_reg_class));
-		}
+		if (res->reg_classes == P2P_MAX_REG_CLASSES)
+			continue;
+		os_memcpy(&res->reg_class[res->reg_classes++],
+			  b_cl, sizeof(struct p2p_reg_class));
+		res_pos[b_cl->reg_class] = res->reg_classes;
 	}
 }
 
@@ -73,6 +73,7 @@ static struct mka_alg mka_alg_tbl[] = {
 		.kek_trfm = ieee802_1x_kek_aes_cmac,
 		.ick_trfm = ieee802_1x_ick_aes_cmac,
 		.icv_hash = ieee802_1x_icv_aes_cmac,
+		.icv_hash_ctx = ieee802_1x_icv_aes_cmac_ctx,
 	},
 };
 #define MKA_ALG_TABLE_SIZE (ARRAY_SIZE(mka_alg_tbl))
@@ -327,17 +328,68 @@ ieee802_1x_kay_get_principal_participant(struct ieee802_1x_kay *kay)
 }
 
 
-static struct ieee802_1x_kay_peer * get_peer_mi(struct dl_list *peers,
-						const u8 *mi)
+static bool sci_equal(const struct ieee802_1x_mka_sci *a,
+		      const struct ieee802_1x_mka_sci *b)
+{
+	return os_memcmp(a, b, sizeof(struct ieee802_1x_mka_sci)) == 0;
+}
+
+
+static void peer_hash_add(struct ieee802_1x_mka_participant *participant,
+			  struct ieee802_1x_kay_peer *peer)
+{
+	struct ieee802_1x_kay_peer **bucket;
+
+	bucket = &participant->peer_hash[KAY_PEER_HASH(peer->mi)];
+	peer->hnext = *bucket;
+	*bucket = peer;
+
+	bucket = &participant->peer_sci_hash[KAY_PEER_SCI_HASH(&peer->sci)];
+	peer->hnext_sci = *bucket;
+	*bucket = peer;
+
+	if (peer->live)
+		participant->num_live_peers++;
+	else
+		participant->num_potential_peers++;
+}
+
+
+static void peer_hash_del(struct ieee802_1x_mka_participant *participant,
+			  struct ieee802_1x_kay_peer *peer)
+{
+	struct ieee802_1x_kay_peer **pos;
+
+	pos = &participant->peer_hash[KAY_PEER_HASH(peer->mi)];
+	while (*pos && *pos != peer)
+		pos = &(*pos)->hnext;
+	if (*pos)
+		*pos = peer->hnext;
+
+	pos = &participant->peer_sci_hash[KAY_PEER_SCI_HASH(&peer->sci)];
+	while (*pos && *pos != peer)
+		pos = &(*pos)->hnext_sci;
+	if (*pos)
+		*pos = peer->hnext_sci;
+
+	if (peer->live)
+		participant->num_live_peers--;
+	else
+		participant->num_potential_peers--;
+}
+
+
+/* The MI of a peer is unique over both the live and potential peer lists */
+static struct ieee802_1x_kay_peer *
+get_peer_mi(struct ieee802_1x_mka_participant *participant, const u8 *mi)
 {
 	struct ieee802_1x_kay_peer *peer;
 
-	dl_list_for_each(peer, peers, struct ieee802_1x_kay_peer, list) {
-		if (os_memcmp(peer->mi, mi, MI_LEN) == 0)
-			return peer;
-	}
+	peer = participant->peer_hash[KAY_PEER_HASH(mi)];
+	while (peer && os_memcmp(peer->mi, mi, MI_LEN) != 0)
+		peer = peer->hnext;
 
-	return NULL;
+	return peer;
 }
 
 
@@ -348,7 +400,9 @@ static struct ieee802_1x_kay_peer *
 ieee802_1x_kay_get_potential_peer(
 	struct ieee802_1x_mka_participant *participant, const u8 *mi)
 {
-	return get_peer_mi(&participant->potential_peers, mi);
+	struct ieee802_1x_kay_peer *peer = get_peer_mi(participant, mi);
+
+	return peer && !peer->live ? peer : NULL;
 }
 
 
@@ -359,7 +413,9 @@ static struct ieee802_1x_kay_peer *
 ieee802_1x_kay_get_live_peer(struct ieee802_1x_mka_participant *participant,
 			     const u8 *mi)
 {
-	return get_peer_mi(&participant->live_peers, mi);
+	struct ieee802_1x_kay_peer *peer = get_peer_mi(participant, mi);
+
+	return peer && peer->live ? peer : NULL;
 }
 
 
@@ -392,13 +448,7 @@ static struct ieee802_1x_kay_peer *
 ieee802_1x_kay_get_peer(struct ieee802_1x_mka_participant *participant,
 			const u8 *mi)
 {
-	struct ieee802_1x_kay_peer *peer;
-
-	peer = ieee802_1x_kay_get_live_peer(participant, mi);
-	if (peer)
-		return peer;
-
-	return ieee802_1x_kay_get_potential_peer(participant, mi);
+	return get_peer_mi(participant, mi);
 }
 
 
@@ -438,13 +488,6 @@ u64 mka_sci_u64(struct ieee802_1x_mka_sci *sci)
 }
 
 
-static bool sci_equal(const struct ieee802_1x_mka_sci *a,
-		      const struct ieee802_1x_mka_sci *b)
-{
-	return os_memcmp(a, b, sizeof(struct ieee802_1x_mka_sci)) == 0;
-}
-
-
 /**
  * ieee802_1x_kay_get_peer_sci
  */
@@ -452,21 +495,20 @@ static struct ieee802_1x_kay_peer *
 ieee802_1x_kay_get_peer_sci(struct ieee802_1x_mka_participant *participant,
 			    const struct ieee802_1x_mka_sci *sci)
 {
-	struct ieee802_1x_kay_peer *peer;
+	struct ieee802_1x_kay_peer *peer, *potential = NULL;
 
-	dl_list_for_each(peer, &participant->live_peers,
-			 struct ieee802_1x_kay_peer, list) {
-		if (sci_equal(&peer->sci, sci))
-			return peer;
-	}
-
-	dl_list_for_each(peer, &participant->potential_peers,
-			 struct ieee802_1x_kay_peer, list) {
-		if (sci_equal(&peer->sci, sci))
+	/* Prefer a live peer over a potential peer */
+	for (peer = participant->peer_sci_hash[KAY_PEER_SCI_HASH(sci)]; peer;
+	     peer = peer->hnext_sci) {
+		if (!sci_equal(&peer->sci, sci))
+			continue;
+		if (peer->live)
 			return peer;
+		if (!potential)
+			potential = peer;
 	}
 
-	return NULL;
+	return potential;
 }
 
 
@@ -644,6 +686,8 @@ ieee802_1x_kay_create_live_peer(struct ieee802_1x_mka_participant *participant,
 		return NULL;
 	}
 	dl_list_add(&participant->live_peers, &peer->list);
+	peer->live = true;
+	peer_hash_add(participant, peer);
 	dl_list_add(&participant->rxsc_list, &rxsc->list);
 
 	wpa_printf(MSG_DEBUG, "KaY: Live peer created");
@@ -667,6 +711,7 @@ ieee802_1x_kay_create_potential_peer(
 		return NULL;
 
 	dl_list_add(&participant->potential_peers, &peer->list);
+	peer_hash_add(participant, peer);
 
 	wpa_printf(MSG_DEBUG, "KaY: Potential peer created");
 	ieee802_1x_kay_dump_peer(peer);
@@ -694,6 +739,7 @@ ieee802_1x_kay_move_live_peer(struct ieee802_1x_mka_participant *participant,
 	if (!rxsc)
 		return NULL;
 
+	peer_hash_del(participant, peer);
 	os_memcpy(&peer->sci, &participant->current_peer_sci,
 		  sizeof(peer->sci));
 	peer->mn = mn;
@@ -711,6 +757,8 @@ ieee802_1x_kay_move_live_peer(struct ieee802_1x_mka_participant *participant,
 		return NULL;
 	}
 	dl_list_add_tail(&participant->live_peers, &peer->list);
+	peer->live = true;
+	peer_hash_add(participant, peer);
 
 	dl_list_add(&participant->rxsc_list, &rxsc->list);
 
@@ -943,11 +991,9 @@ ieee802_1x_mka_get_live_peer_length(
 	struct ieee802_1x_mka_participant *participant)
 {
 	int len = MKA_HDR_LEN;
-	struct ieee802_1x_kay_peer *peer;
 
-	dl_list_for_each(peer, &participant->live_peers,
-			 struct ieee802_1x_kay_peer, list)
-		len += sizeof(struct ieee802_1x_mka_peer_id);
+	len += participant->num_live_peers *
+		sizeof(struct ieee802_1x_mka_peer_id);
 
 	return MKA_ALIGN_LENGTH(len);
 }
@@ -1003,11 +1049,9 @@ ieee802_1x_mka_get_potential_peer_length(
 	struct ieee802_1x_mka_participant *participant)
 {
 	int len = MKA_HDR_LEN;
-	struct ieee802_1x_kay_peer *peer;
 
-	dl_list_for_each(peer, &participant->potential_peers,
-			 struct ieee802_1x_kay_peer, list)
-		len += sizeof(struct ieee802_1x_mka_peer_id);
+	len += participant->num_potential_peers *
+		sizeof(struct ieee802_1x_mka_peer_id);
 
 	return MKA_ALIGN_LENGTH(len);
 }
@@ -1882,6 +1926,23 @@ ieee802_1x_mka_icv_body_present(struct ieee802_1x_mka_participant *participant)
 }
 
 
+/**
+ * ieee802_1x_mka_calc_icv - Calculate the ICV of an MKPDU with the ICK
+ */
+static int
+ieee802_1x_mka_calc_icv(struct ieee802_1x_mka_participant *participant,
+			const u8 *msg, size_t msg_len, u8 *icv)
+{
+#ifdef CONFIG_AIDL_MACSEC_PSK_METHODS
+	return aidl_psk_icv_hash(participant->ick.key, participant->ick.len,
+				 msg, msg_len, icv);
+#else
+	return mka_alg_tbl[participant->kay->mka_algindex].icv_hash_ctx(
+		participant->ick_ctx, msg, msg_len, icv);
+#endif
+}
+
+
 /**
  * ieee802_1x_kay_get_icv_length
  */
@@ -1923,13 +1984,8 @@ ieee802_1x_mka_encode_icv_body(struct ieee802_1x_mka_participant *participant,
 		set_mka_param_body_len(body, length);
 	}
 
-#ifdef CONFIG_AIDL_MACSEC_PSK_METHODS
-	if (aidl_psk_icv_hash(
-#else
-	if (mka_alg_tbl[participant->kay->mka_algindex].icv_hash(
-#endif
-		    participant->ick.key, participant->ick.len,
-		    wpabuf_head(buf), wpabuf_len(buf), cmac)) {
+	if (ieee802_1x_mka_calc_icv(participant, wpabuf_head(buf),
+				    wpabuf_len(buf), cmac)) {
 		wpa_printf(MSG_ERROR, "KaY: failed to calculate ICV");
 		return -1;
 	}
@@ -2567,6 +2623,7 @@ ieee802_1x_participant_send_mkpdu(
 	wpa_hexdump_buf(MSG_MSGDUMP, "KaY: Outgoing MKPDU", buf);
 	l2_packet_send(kay->l2_mka, NULL, 0, wpabuf_head(buf), wpabuf_len(buf));
 	wpabuf_free(buf);
+	participant->mkpdu_tx++;
 
 	kay->active = true;
 	participant->active = true;
@@ -2638,6 +2695,7 @@ static void ieee802_1x_participant_timer(void *eloop_ctx, void *timeout_ctx)
 				}
 			}
 			key_server_removed |= peer->is_key_server;
+			peer_hash_del(participant, peer);
 			dl_list_del(&peer->list);
 			os_free(peer);
 			lp_changed = true;
@@ -2705,6 +2763,7 @@ static void ieee802_1x_participant_timer(void *eloop_ctx, void *timeout_ctx)
 		if (now.sec > peer->expire) {
 			wpa_printf(MSG_DEBUG, "KaY: Potential peer removed");
 			ieee802_1x_kay_dump_peer(peer);
+			peer_hash_del(participant, peer);
 			dl_list_del(&peer->list);
 			os_free(peer);
 		}
@@ -3239,13 +3298,9 @@ static int ieee802_1x_kay_mkpdu_validity_check(struct ieee802_1x_kay *kay,
 	 * packet body length.
 	 */
 	if (len < mka_alg_tbl[kay->mka_algindex].icv_len ||
-#ifdef CONFIG_AIDL_MACSEC_PSK_METHODS
-	    aidl_psk_icv_hash(
-#else
-	    mka_alg_tbl[kay->mka_algindex].icv_hash(
-#endif
-		    participant->ick.key, participant->ick.len,
-		    buf, len - mka_alg_tbl[kay->mka_algindex].icv_len, icv)) {
+	    ieee802_1x_mka_calc_icv(participant, buf,
+				    len - mka_alg_tbl[kay->mka_algindex].icv_len,
+				    icv)) {
 		wpa_printf(MSG_ERROR, "KaY: Failed to calculate ICV");
 		return -1;
 	}
@@ -3275,8 +3330,10 @@ static int ieee802_1x_kay_mkpdu_validity_check(struct ieee802_1x_kay *kay,
 /**
  * ieee802_1x_kay_decode_mkpdu -
  */
-static int ieee802_1x_kay_decode_mkpdu(struct ieee802_1x_kay *kay,
-				       const u8 *buf, size_t len)
+static int
+ieee802_1x_kay_decode_mkpdu(struct ieee802_1x_kay *kay, const u8 *buf,
+			    size_t len,
+			    struct ieee802_1x_mka_participant **rx_participant)
 {
 	struct ieee802_1x_mka_participant *participant;
 	struct ieee802_1x_mka_hdr *hdr;
@@ -3303,6 +3360,7 @@ static int ieee802_1x_kay_decode_mkpdu(struct ieee802_1x_kay *kay,
 	participant = ieee802_1x_mka_decode_basic_body(kay, pos, left_len);
 	if (!participant)
 		return -1;
+	*rx_participant = participant;
 
 	/* to skip basic parameter set */
 	hdr = (struct ieee802_1x_mka_hdr *) pos;
@@ -3482,6 +3540,9 @@ static void kay_l2_receive(void *ctx, const u8 *src_addr, const u8 *buf,
 	struct ieee802_1x_kay *kay = ctx;
 	struct ieee8023_hdr *eth_hdr;
 	struct ieee802_1x_hdr *eapol_hdr;
+	struct ieee802_1x_mka_participant *participant = NULL;
+	struct os_reltime start, end, diff;
+	u32 usec;
 	size_t calc_len;
 
 	/* IEEE Std 802.1X-2010, 11.4 (Validation of received EAPOL PDUs) */
@@ -3527,7 +3588,19 @@ static void kay_l2_receive(void *ctx, const u8 *src_addr, const u8 *buf,
 		return;
 	}
 
-	ieee802_1x_kay_decode_mkpdu(kay, buf, len);
+	os_get_reltime(&start);
+	ieee802_1x_kay_decode_mkpdu(kay, buf, len, &participant);
+	if (!participant)
+		return;
+
+	/* Processing time includes ICV validation of the MKPDU */
+	os_get_reltime(&end);
+	os_reltime_sub(&end, &start, &diff);
+	usec = diff.sec * 1000000 + diff.usec;
+	participant->mkpdu_rx++;
+	participant->mkpdu_rx_usec += usec;
+	if (usec > participant->mkpdu_rx_max_usec)
+		participant->mkpdu_rx_max_usec = usec;
 }
 
 
@@ -3870,6 +3943,13 @@ ieee802_1x_kay_create_mka(struct ieee802_1x_kay *kay,
 	}
 	wpa_hexdump_key(MSG_DEBUG, "KaY: Derived ICK",
 			participant->ick.key, participant->ick.len);
+
+	participant->ick_ctx = omac1_aes_init(participant->ick.key,
+					      participant->ick.len);
+	if (!participant->ick_ctx) {
+		wpa_printf(MSG_ERROR, "KaY: ICK initialization failed");
+		goto fail;
+	}
 #endif
 
 	dl_list_add(&kay->participant_list, &participant->list);
@@ -3961,6 +4041,7 @@ ieee802_1x_kay_delete_mka(struct ieee802_1x_kay *kay, struct mka_key_name *ckn)
 	os_memset(&participant->cak, 0, sizeof(participant->cak));
 	os_memset(&participant->kek, 0, sizeof(participant->kek));
 	os_memset(&participant->ick, 0, sizeof(participant->ick));
+	omac1_aes_deinit(participant->ick_ctx);
 	os_free(participant);
 }
 
@@ -4137,15 +4218,24 @@ int ieee802_1x_kay_get_status(struct ieee802_1x_kay *kay, char *buf,
 				  "live_peers=%u\n"
 				  "potential_peers=%u\n"
 				  "is_key_server=%s\n"
-				  "is_elected=%s\n",
+				  "is_elected=%s\n"
+				  "mkpdu_rx=%u\n"
+				  "mkpdu_tx=%u\n"
+				  "mkpdu_rx_avg_usec=%u\n"
+				  "mkpdu_rx_max_usec=%u\n",
 				  mi_txt(p->mi), p->mn,
 				  yes_no(p->active),
 				  yes_no(p->participant),
 				  yes_no(p->retain),
-				  dl_list_len(&p->live_peers),
-				  dl_list_len(&p->potential_peers),
+				  p->num_live_peers,
+				  p->num_potential_peers,
 				  yes_no(p->is_key_server),
-				  yes_no(p->is_elected));
+				  yes_no(p->is_elected),
+				  p->mkpdu_rx, p->mkpdu_tx,
+				  p->mkpdu_rx ?
+				  (unsigned int) (p->mkpdu_rx_usec / p->mkpdu_rx) :
+				  0,
+				  p->mkpdu_rx_max_usec);
 		if (os_snprintf_error(buflen, res))
 			return end - pos;
 		pos2 += res;
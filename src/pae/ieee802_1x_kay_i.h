@@ -13,6 +13,8 @@
 #include "common/defs.h"
 #include "common/ieee802_1x_defs.h"
 
+struct omac1_ctx;
+
 #define MKA_VERSION_ID              1
 
 /* IEEE Std 802.1X-2010, 11.11.1, Table 11-7 (MKPDU parameter sets) */
@@ -53,8 +55,18 @@ struct ieee802_1x_kay_peer {
 	bool sak_used;
 	int missing_sak_use_count;
 	struct dl_list list;
+	bool live;
+	/* Participant peer hash tables by MI and by SCI */
+	struct ieee802_1x_kay_peer *hnext;
+	struct ieee802_1x_kay_peer *hnext_sci;
 };
 
+#define KAY_PEER_HASH_SIZE 32
+#define KAY_PEER_HASH(mi) ((mi)[0] & (KAY_PEER_HASH_SIZE - 1))
+#define KAY_PEER_SCI_HASH(sci) \
+	(((sci)->addr[5] ^ ((const u8 *) &(sci)->port)[1]) & \
+	 (KAY_PEER_HASH_SIZE - 1))
+
 struct macsec_ciphersuite {
 	u64 id;
 	char name[32];
@@ -78,6 +90,8 @@ struct mka_alg {
 			u8 *ick, size_t ick_bytes);
 	int (*icv_hash)(const u8 *ick, size_t ick_bytes,
 			const u8 *msg, size_t msg_len, u8 *icv);
+	int (*icv_hash_ctx)(struct omac1_ctx *ick_ctx,
+			    const u8 *msg, size_t msg_len, u8 *icv);
 };
 
 #define DEFAULT_MKA_ALG_INDEX 0
@@ -105,8 +119,21 @@ struct ieee802_1x_mka_participant {
 	/* not defined in IEEE 802.1X */
 	struct dl_list list;
 
+	/* Live and potential peers hashed by MI and by SCI */
+	struct ieee802_1x_kay_peer *peer_hash[KAY_PEER_HASH_SIZE];
+	struct ieee802_1x_kay_peer *peer_sci_hash[KAY_PEER_HASH_SIZE];
+	unsigned int num_live_peers;
+	unsigned int num_potential_peers;
+
+	/* MKPDU processing statistics */
+	u32 mkpdu_rx;
+	u32 mkpdu_tx;
+	u64 mkpdu_rx_usec;
+	u32 mkpdu_rx_max_usec;
+
 	struct mka_key kek;
 	struct mka_key ick;
+	struct omac1_ctx *ick_ctx; /* ICK for ICV calculation */
 
 	struct ieee802_1x_mka_ki lki;
 	u8 lan;
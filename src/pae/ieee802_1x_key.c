@@ -196,6 +196,24 @@ int ieee802_1x_icv_aes_cmac(const u8 *ick, size_t ick_bytes, const u8 *msg,
 }
 
 
+/**
+ * ieee802_1x_icv_aes_cmac_ctx
+ *
+ * Same as ieee802_1x_icv_aes_cmac(), but with the ICK in a context from
+ * omac1_aes_init() to avoid the key setup for each MKPDU.
+ */
+int ieee802_1x_icv_aes_cmac_ctx(struct omac1_ctx *ick_ctx, const u8 *msg,
+				size_t msg_bytes, u8 *icv)
+{
+	if (omac1_aes_ctx_vector(ick_ctx, 1, &msg, &msg_bytes, icv)) {
+		wpa_printf(MSG_ERROR,
+			   "MKA: AES-CMAC failed for ICV calculation");
+		return -1;
+	}
+	return 0;
+}
+
+
 /**
  * ieee802_1x_sak_aes_cmac
  *
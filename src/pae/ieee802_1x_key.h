@@ -9,6 +9,8 @@
 #ifndef IEEE802_1X_KEY_H
 #define IEEE802_1X_KEY_H
 
+struct omac1_ctx;
+
 int ieee802_1x_cak_aes_cmac(const u8 *msk, size_t msk_bytes, const u8 *mac1,
 			    const u8 *mac2, u8 *cak, size_t cak_bytes);
 int ieee802_1x_ckn_aes_cmac(const u8 *msk, size_t msk_bytes, const u8 *mac1,
@@ -20,6 +22,8 @@ int ieee802_1x_ick_aes_cmac(const u8 *cak, size_t cak_bytes, const u8 *ckn,
 			    size_t ckn_bytes, u8 *ick, size_t ick_bytes);
 int ieee802_1x_icv_aes_cmac(const u8 *ick, size_t ick_bytes, const u8 *msg,
 			    size_t msg_bytes, u8 *icv);
+int ieee802_1x_icv_aes_cmac_ctx(struct omac1_ctx *ick_ctx, const u8 *msg,
+				size_t msg_bytes, u8 *icv);
 int ieee802_1x_sak_aes_cmac(const u8 *cak, size_t cak_bytes, const u8 *ctx,
 			    size_t ctx_bytes, u8 *sak, size_t sak_bytes);
 
@@ -124,6 +124,7 @@ struct pasn_data {
 	int *pasn_groups;
 	struct wpabuf *wrapped_data;
 	int use_anti_clogging;
+	bool comeback_sent; /* Frame 1 was answered with a comeback request */
 	const u8 *rsn_ie;
 	size_t rsn_ie_len;
 
@@ -477,6 +477,8 @@ static void handle_auth_pasn_comeback(struct pasn_data *pasn,
 			      wpabuf_len(buf), 0, pasn->freq, 0);
 	if (ret)
 		wpa_printf(MSG_INFO, "PASN: Failed to send comeback frame 2");
+	else
+		pasn->comeback_sent = true;
 
 	wpabuf_free(buf);
 }
@@ -12,6 +12,7 @@
 
 #include "common.h"
 #include "eloop.h"
+#include "list.h"
 #include "crypto/tls.h"
 #include "radius.h"
 #include "radius_client.h"
@@ -20,9 +21,20 @@
 
 /**
  * RADIUS_CLIENT_FIRST_WAIT - RADIUS client timeout for first retry in seconds
+ *
+ * This is used until round trip time measurements are available for the
+ * server.
  */
 #define RADIUS_CLIENT_FIRST_WAIT 3
 
+/**
+ * RADIUS_CLIENT_MIN_WAIT - RADIUS client minimum retry timeout in seconds
+ *
+ * Lower bound for the retransmission timeout computed from the measured
+ * round trip times.
+ */
+#define RADIUS_CLIENT_MIN_WAIT 1
+
 /**
  * RADIUS_CLIENT_MAX_WAIT - RADIUS client maximum retry timeout in seconds
  */
@@ -39,8 +51,9 @@
 /**
  * RADIUS_CLIENT_MAX_ENTRIES - RADIUS client maximum pending messages
  *
- * Maximum number of entries in retransmit list (oldest entries will be
- * removed, if this limit is exceeded).
+ * Default maximum number of entries in retransmit list (oldest entries will be
+ * removed, if this limit is exceeded). This can be changed with
+ * struct hostapd_radius_servers::max_pending.
  */
 #define RADIUS_CLIENT_MAX_ENTRIES 30
 
@@ -52,6 +65,34 @@
  */
 #define RADIUS_CLIENT_NUM_FAILOVER 4
 
+/**
+ * RADIUS_CLIENT_FAILOVER_RTO - RADIUS client failover point in timeouts
+ *
+ * When round trip time measurements are available for the RADIUS server, the
+ * server will be changed once a request has remained unanswered for this many
+ * retransmission timeouts even if RADIUS_CLIENT_NUM_FAILOVER attempts have not
+ * yet been made.
+ */
+#define RADIUS_CLIENT_FAILOVER_RTO 6
+
+/**
+ * RADIUS_CLIENT_LB_HOLDDOWN - Time in seconds to skip a non-responding server
+ *
+ * With authentication server load balancing, a server that has caused a
+ * failover is not selected for new requests for this long unless it responds
+ * to an earlier request.
+ */
+#define RADIUS_CLIENT_LB_HOLDDOWN 30
+
+/**
+ * RADIUS_CLIENT_LB_STATES - Number of tracked State attributes
+ *
+ * With authentication server load balancing, the State attributes from
+ * Access-Challenge messages are stored in a direct-mapped table of this size
+ * to send the next request of the EAP conversation to the same server.
+ */
+#define RADIUS_CLIENT_LB_STATES 256
+
 
 /**
  * struct radius_rx_handler - RADIUS client RX handler
@@ -110,7 +151,12 @@ struct radius_msg_list {
 	/**
 	 * next_try - Time for the next transmission attempt
 	 */
-	os_time_t next_try;
+	struct os_reltime next_try;
+
+	/**
+	 * server_first_try - Time of the first attempt for the current server
+	 */
+	struct os_reltime server_first_try;
 
 	/**
 	 * attempts - Number of transmission attempts for one server
@@ -123,9 +169,9 @@ struct radius_msg_list {
 	int accu_attempts;
 
 	/**
-	 * next_wait - Next retransmission wait time in seconds
+	 * next_wait - Next retransmission wait time in milliseconds
 	 */
-	int next_wait;
+	unsigned int next_wait;
 
 	/**
 	 * last_attempt - Time of the last transmission attempt
@@ -142,12 +188,62 @@ struct radius_msg_list {
 	 */
 	size_t shared_secret_len;
 
+	/**
+	 * sock_idx - Index of the authentication socket used for the message
+	 *
+	 * With authentication server load balancing, this is also the index of
+	 * the server in struct hostapd_radius_servers::auth_servers.
+	 */
+	unsigned int sock_idx;
+
 	/* TODO: server config with failover to backup server(s) */
 
 	/**
-	 * next - Next message in the list
+	 * list - Entry in struct radius_client_data::msgs
 	 */
-	struct radius_msg_list *next;
+	struct dl_list list;
+};
+
+
+/**
+ * struct radius_lb_server - Load balancing state for an authentication server
+ */
+struct radius_lb_server {
+	/**
+	 * current_weight - Current weight for smooth weighted round-robin
+	 */
+	int current_weight;
+
+	/**
+	 * pending - Number of pending requests sent to the server
+	 */
+	unsigned int pending;
+
+	/**
+	 * holddown - Time until which the server is not used for new requests
+	 */
+	struct os_reltime holddown;
+};
+
+
+/**
+ * struct radius_lb_state - State attribute of an ongoing EAP conversation
+ */
+struct radius_lb_state {
+	/**
+	 * state - Copy of the State attribute value or %NULL if not in use
+	 */
+	u8 *state;
+
+	/**
+	 * state_len - Length of state in octets
+	 */
+	size_t state_len;
+
+	/**
+	 * server - Index of the authentication server that issued the State
+	 */
+	unsigned int server;
 };
 
 
@@ -175,6 +271,49 @@ struct radius_client_data {
 	 */
 	int auth_sock;
 
+	/**
+	 * auth_pool - Additional RADIUS/UDP authentication sockets
+	 *
+	 * These are connected to the same server as auth_sock, but use
+	 * different local ports and thus separate identifier spaces.
+	 */
+	int auth_pool[RADIUS_CLIENT_MAX_AUTH_SOCKS - 1];
+
+	/**
+	 * num_auth_pool - Number of open sockets in auth_pool
+	 */
+	unsigned int num_auth_pool;
+
+	/**
+	 * max_auth_socks - Maximum number of authentication sockets to use
+	 */
+	unsigned int max_auth_socks;
+
+	/**
+	 * next_auth_sock - Authentication socket to try first for next request
+	 */
+	unsigned int next_auth_sock;
+
+	/**
+	 * lb_states - State attributes of ongoing EAP conversations
+	 *
+	 * This is allocated only when authentication server load balancing is
+	 * used and its presence indicates that auth_sock and auth_pool are
+	 * connected to the different servers in conf->auth_servers.
+	 */
+	struct radius_lb_state *lb_states;
+
+	/**
+	 * lb_servers - Load balancing state for each authentication server
+	 */
+	struct radius_lb_server lb_servers[RADIUS_CLIENT_MAX_AUTH_SOCKS];
+
+	/**
+	 * num_lb_servers - Number of authentication servers in use for load
+	 * balancing or 0 if the sockets have not been opened
+	 */
+	unsigned int num_lb_servers;
+
 	/**
 	 * auth_tls - Whether current authentication connection uses TLS
 	 */
@@ -221,15 +360,24 @@ struct radius_client_data {
 	size_t num_acct_handlers;
 
 	/**
-	 * msgs - Pending outgoing RADIUS messages
+	 * msgs - Pending outgoing RADIUS messages, newest first
 	 */
-	struct radius_msg_list *msgs;
+	struct dl_list msgs;
 
 	/**
 	 * num_msgs - Number of pending messages in the msgs list
 	 */
 	size_t num_msgs;
 
+	/**
+	 * pending - Pending messages indexed by socket and identifier
+	 *
+	 * Authentication messages sent over authentication socket i use the
+	 * entries [i * 256 + identifier] and accounting messages use the
+	 * block after the last authentication socket.
+	 */
+	struct radius_msg_list **pending;
+
 	/**
 	 * next_radius_identifier - Next RADIUS message identifier to use
 	 */
@@ -245,6 +393,17 @@ struct radius_client_data {
 	 */
 	void *interim_error_cb_ctx;
 
+	/**
+	 * acct_drop_cb - Callback for dropped accounting messages
+	 */
+	void (*acct_drop_cb)(struct radius_msg *msg, unsigned int queued,
+			     void *ctx);
+
+	/**
+	 * acct_drop_cb_ctx - acct_drop_cb() context data
+	 */
+	void *acct_drop_cb_ctx;
+
 #ifdef CONFIG_RADIUS_TLS
 	void *tls_ctx;
 	struct tls_connection *auth_tls_conn;
@@ -262,6 +421,7 @@ static int radius_client_init_acct(struct radius_client_data *radius);
 static int radius_client_init_auth(struct radius_client_data *radius);
 static void radius_client_auth_failover(struct radius_client_data *radius);
 static void radius_client_acct_failover(struct radius_client_data *radius);
+static void radius_client_update_timeout(struct radius_client_data *radius);
 
 
 static void radius_client_msg_free(struct radius_msg_list *req)
@@ -271,6 +431,337 @@ static void radius_client_msg_free(struct radius_msg_list *req)
 }
 
 
+static struct radius_msg_list **
+radius_client_pending_slot(struct radius_client_data *radius,
+			   RadiusType msg_type, unsigned int sock_idx, u8 id)
+{
+	if (msg_type == RADIUS_ACCT || msg_type == RADIUS_ACCT_INTERIM)
+		sock_idx = radius->max_auth_socks;
+	return &radius->pending[sock_idx * 256 + id];
+}
+
+
+/* Remove a message from the pending list without freeing it */
+static void radius_client_msg_unlink(struct radius_client_data *radius,
+				     struct radius_msg_list *entry)
+{
+	if (radius->lb_states && entry->msg_type == RADIUS_AUTH)
+		radius->lb_servers[entry->sock_idx].pending--;
+	struct radius_msg_list **slot;
+
+	slot = radius_client_pending_slot(
+		radius, entry->msg_type, entry->sock_idx,
+		radius_msg_get_hdr(entry->msg)->identifier);
+	if (*slot == entry)
+		*slot = NULL;
+	dl_list_del(&entry->list);
+	radius->num_msgs--;
+}
+
+
+static void radius_client_acct_dropped(struct radius_client_data *radius,
+				       struct radius_msg_list *entry)
+{
+	struct os_reltime now;
+
+	if (entry->msg_type != RADIUS_ACCT || !radius->acct_drop_cb)
+		return;
+
+	os_get_reltime(&now);
+	radius->acct_drop_cb(entry->msg, now.sec - entry->first_try,
+			     radius->acct_drop_cb_ctx);
+}
+
+
+/* Remove a message that did not receive a valid response */
+static void radius_client_msg_remove(struct radius_client_data *radius,
+				     struct radius_msg_list *entry)
+{
+	radius_client_msg_unlink(radius, entry);
+	radius_client_acct_dropped(radius, entry);
+	radius_client_msg_free(entry);
+}
+
+
+static int radius_client_auth_sock(struct radius_client_data *radius,
+				   unsigned int sock_idx)
+{
+	if (sock_idx == 0 || sock_idx > radius->num_auth_pool)
+		return radius->auth_sock;
+	return radius->auth_pool[sock_idx - 1];
+}
+
+
+/*
+ * Select the socket for a new request so that its identifier does not collide
+ * with another pending request. If all the sockets already have a pending
+ * request with the same identifier, the old request is removed.
+ */
+static unsigned int radius_client_claim_id(struct radius_client_data *radius,
+					   RadiusType msg_type, u8 id)
+{
+	struct radius_msg_list **slot;
+	unsigned int i, sock_idx, num = 1;
+
+	if (msg_type == RADIUS_AUTH && !radius->auth_tls)
+		num += radius->num_auth_pool;
+
+	for (i = 0; i < num; i++) {
+		sock_idx = (radius->next_auth_sock + i) % num;
+		slot = radius_client_pending_slot(radius, msg_type, sock_idx,
+						  id);
+		if (!*slot)
+			goto out;
+	}
+
+	sock_idx = radius->next_auth_sock % num;
+	slot = radius_client_pending_slot(radius, msg_type, sock_idx, id);
+	hostapd_logger(radius->ctx, (*slot)->addr, HOSTAPD_MODULE_RADIUS,
+		       HOSTAPD_LEVEL_DEBUG,
+		       "Removing pending RADIUS message, since its id (%d) is reused",
+		       id);
+	radius_client_msg_remove(radius, *slot);
+
+out:
+	if (num > 1)
+		radius->next_auth_sock = (sock_idx + 1) % num;
+	return sock_idx;
+}
+
+
+/* Assign a new identifier for a pending message on the same socket */
+static void radius_client_change_id(struct radius_client_data *radius,
+				    struct radius_msg_list *entry)
+{
+	struct radius_hdr *hdr = radius_msg_get_hdr(entry->msg);
+	struct radius_msg_list **slot;
+	int i;
+	u8 id;
+
+	slot = radius_client_pending_slot(radius, entry->msg_type,
+					  entry->sock_idx, hdr->identifier);
+	if (*slot == entry)
+		*slot = NULL;
+
+	for (i = 0; i < 256; i++) {
+		id = radius_client_get_id(radius);
+		slot = radius_client_pending_slot(radius, entry->msg_type,
+						  entry->sock_idx, id);
+		if (!*slot)
+			break;
+	}
+
+	if (*slot) {
+		hostapd_logger(radius->ctx, (*slot)->addr,
+			       HOSTAPD_MODULE_RADIUS, HOSTAPD_LEVEL_DEBUG,
+			       "Removing pending RADIUS message, since its id (%d) is reused",
+			       id);
+		radius_client_msg_remove(radius, *slot);
+	}
+
+	hdr->identifier = id;
+	*slot = entry;
+}
+
+
+static unsigned int radius_client_lb_state_hash(const u8 *state, size_t len)
+{
+	u32 hash = 2166136261U;
+
+	/* FNV-1a */
+	while (len--) {
+		hash ^= *state++;
+		hash *= 16777619U;
+	}
+
+	return hash % RADIUS_CLIENT_LB_STATES;
+}
+
+
+static struct radius_lb_state *
+radius_client_lb_get_state(struct radius_client_data *radius,
+			   struct radius_msg *msg)
+{
+	struct radius_lb_state *st;
+	u8 *state;
+	size_t len;
+
+	if (radius_msg_get_attr_ptr(msg, RADIUS_ATTR_STATE, &state, &len,
+				    NULL) < 0 || len == 0)
+		return NULL;
+
+	st = &radius->lb_states[radius_client_lb_state_hash(state, len)];
+	if (!st->state || st->state_len != len ||
+	    os_memcmp(st->state, state, len) != 0)
+		return NULL;
+	return st;
+}
+
+
+static void radius_client_lb_clear_state(struct radius_lb_state *st)
+{
+	os_free(st->state);
+	st->state = NULL;
+	st->state_len = 0;
+}
+
+
+static void radius_client_lb_flush_states(struct radius_client_data *radius)
+{
+	unsigned int i;
+
+	if (!radius->lb_states)
+		return;
+	for (i = 0; i < RADIUS_CLIENT_LB_STATES; i++)
+		radius_client_lb_clear_state(&radius->lb_states[i]);
+}
+
+
+/*
+ * Remember which server issued the State attribute of an Access-Challenge so
+ * that the next request of the EAP conversation is sent to it. The entry for
+ * the State used in the request is not needed anymore.
+ */
+static void radius_client_lb_track_state(struct radius_client_data *radius,
+					 struct radius_msg_list *req,
+					 struct radius_msg *msg)
+{
+	struct radius_lb_state *st;
+	u8 *state;
+	size_t len;
+
+	st = radius_client_lb_get_state(radius, req->msg);
+	if (st)
+		radius_client_lb_clear_state(st);
+
+	if (radius_msg_get_hdr(msg)->code != RADIUS_CODE_ACCESS_CHALLENGE ||
+	    radius_msg_get_attr_ptr(msg, RADIUS_ATTR_STATE, &state, &len,
+				    NULL) < 0 || len == 0)
+		return;
+
+	st = &radius->lb_states[radius_client_lb_state_hash(state, len)];
+	radius_client_lb_clear_state(st);
+	st->state = os_memdup(state, len);
+	if (!st->state)
+		return;
+	st->state_len = len;
+	st->server = req->sock_idx;
+}
+
+
+static bool radius_client_lb_usable(struct radius_client_data *radius,
+				    unsigned int idx, struct os_reltime *now,
+				    bool ignore_holddown)
+{
+	if (idx >= radius->num_lb_servers ||
+	    radius_client_auth_sock(radius, idx) < 0 ||
+	    !radius->conf->auth_servers[idx].shared_secret)
+		return false;
+	return ignore_holddown ||
+		!os_reltime_before(now, &radius->lb_servers[idx].holddown);
+}
+
+
+/*
+ * Select an authentication server for a new request based on the configured
+ * policy. Servers that already have a pending request with the identifier id
+ * (unless -1) are skipped. Returns -1 if no server other than exclude can be
+ * used.
+ */
+static int radius_client_lb_pick(struct radius_client_data *radius,
+				 int exclude, int id, struct os_reltime *now,
+				 bool ignore_holddown)
+{
+	struct hostapd_radius_servers *conf = radius->conf;
+	struct radius_lb_server *lb, *best_lb = NULL;
+	unsigned int i, idx, n = radius->num_lb_servers;
+	int best = -1, weight, best_weight = 0, total = 0;
+
+	for (i = 0; i < n; i++) {
+		idx = (radius->next_auth_sock + i) % n;
+		if ((int) idx == exclude ||
+		    !radius_client_lb_usable(radius, idx, now,
+					     ignore_holddown) ||
+		    (id >= 0 && *radius_client_pending_slot(radius, RADIUS_AUTH,
+							     idx, id)))
+			continue;
+
+		lb = &radius->lb_servers[idx];
+		weight = conf->auth_servers[idx].weight > 0 ?
+			conf->auth_servers[idx].weight : 1;
+		if (conf->auth_load_balance == RADIUS_AUTH_LB_ROUND_ROBIN) {
+			/* Smooth weighted round-robin */
+			lb->current_weight += weight;
+			total += weight;
+			if (!best_lb ||
+			    lb->current_weight > best_lb->current_weight) {
+				best = idx;
+				best_lb = lb;
+			}
+		} else if (!best_lb ||
+			   (u64) lb->pending * best_weight <
+			   (u64) best_lb->pending * weight) {
+			best = idx;
+			best_lb = lb;
+			best_weight = weight;
+		}
+	}
+
+	if (best_lb && conf->auth_load_balance == RADIUS_AUTH_LB_ROUND_ROBIN)
+		best_lb->current_weight -= total;
+	if (best >= 0)
+		radius->next_auth_sock = (best + 1) % n;
+	return best;
+}
+
+
+static int radius_client_lb_select(struct radius_client_data *radius,
+				   struct radius_msg *msg)
+{
+	struct radius_lb_state *st;
+	struct os_reltime now;
+	int idx;
+
+	if (radius->num_lb_servers == 0)
+		radius_client_init_auth(radius);
+
+	os_get_reltime(&now);
+	st = radius_client_lb_get_state(radius, msg);
+	if (st && radius_client_lb_usable(radius, st->server, &now, false))
+		return st->server;
+
+	/* Prefer a server without a pending request with the same identifier
+	 * since that request would need to be removed */
+	idx = radius_client_lb_pick(radius, -1,
+				    radius_msg_get_hdr(msg)->identifier, &now,
+				    false);
+	if (idx < 0)
+		idx = radius_client_lb_pick(radius, -1, -1, &now, false);
+	if (idx < 0)
+		idx = radius_client_lb_pick(radius, -1, -1, &now, true);
+	return idx;
+}
+
+
+/* Reserve the identifier of a new request on the socket of the selected
+ * authentication server */
+static void radius_client_lb_claim_id(struct radius_client_data *radius,
+				      unsigned int sock_idx, u8 id)
+{
+	struct radius_msg_list **slot;
+
+	slot = radius_client_pending_slot(radius, RADIUS_AUTH, sock_idx, id);
+	if (!*slot)
+		return;
+
+	hostapd_logger(radius->ctx, (*slot)->addr, HOSTAPD_MODULE_RADIUS,
+		       HOSTAPD_LEVEL_DEBUG,
+		       "Removing pending RADIUS message, since its id (%d) is reused",
+		       id);
+	radius_client_msg_remove(radius, *slot);
+}
+
+
 /**
  * radius_client_register - Register a RADIUS client RX handler
  * @radius: RADIUS client context from radius_client_init()
@@ -340,6 +831,30 @@ void radius_client_set_interim_error_cb(struct radius_client_data *radius,
 }
 
 
+/**
+ * radius_client_set_acct_drop_cb - Register handler for dropped accounting
+ * @radius: RADIUS client context from radius_client_init()
+ * @cb: Handler for dropped accounting messages or %NULL to unregister
+ * @ctx: Context pointer for handler callbacks
+ *
+ * The handler is called for each accounting message (RADIUS_ACCT) that is
+ * removed from the retransmit list without a valid response, e.g., after
+ * too many retransmissions, due to the retransmit list limits, or when the
+ * pending messages are flushed. @queued is the number of seconds since the
+ * message was first sent. The message is freed after the call returns. The
+ * handler must not send RADIUS messages directly since it can be called while
+ * the retransmit list is being processed.
+ */
+void radius_client_set_acct_drop_cb(struct radius_client_data *radius,
+				    void (*cb)(struct radius_msg *msg,
+					       unsigned int queued, void *ctx),
+				    void *ctx)
+{
+	radius->acct_drop_cb = cb;
+	radius->acct_drop_cb_ctx = ctx;
+}
+
+
 /*
  * Returns >0 if message queue was flushed (i.e., the message that triggered
  * the error is not available anymore)
@@ -371,11 +886,82 @@ static int radius_client_handle_send_error(struct radius_client_data *radius,
 }
 
 
+static struct hostapd_radius_server *
+radius_client_msg_server(struct radius_client_data *radius,
+			 RadiusType msg_type, unsigned int sock_idx)
+{
+	if (msg_type == RADIUS_ACCT || msg_type == RADIUS_ACCT_INTERIM)
+		return radius->conf->acct_server;
+	if (radius->lb_states)
+		return &radius->conf->auth_servers[sock_idx];
+	return radius->conf->auth_server;
+}
+
+
+/* Retransmission timeout in milliseconds (RFC 6298, Section 2) */
+static unsigned int radius_client_rto(struct hostapd_radius_server *serv)
+{
+	unsigned int rto;
+
+	if (!serv || !serv->srtt)
+		return RADIUS_CLIENT_FIRST_WAIT * 1000;
+
+	rto = serv->srtt + 4 * serv->rttvar;
+	if (rto < RADIUS_CLIENT_MIN_WAIT * 1000)
+		rto = RADIUS_CLIENT_MIN_WAIT * 1000;
+	if (rto > RADIUS_CLIENT_MAX_WAIT * 1000)
+		rto = RADIUS_CLIENT_MAX_WAIT * 1000;
+	return rto;
+}
+
+
+static void radius_client_update_rtt(struct hostapd_radius_server *serv,
+				     unsigned int rtt)
+{
+	unsigned int diff;
+
+	if (!serv->srtt) {
+		serv->srtt = rtt ? rtt : 1;
+		serv->rttvar = rtt / 2;
+		return;
+	}
+
+	diff = serv->srtt > rtt ? serv->srtt - rtt : rtt - serv->srtt;
+	serv->rttvar = (3 * serv->rttvar + diff) / 4;
+	serv->srtt = (7 * serv->srtt + rtt) / 8;
+	if (!serv->srtt)
+		serv->srtt = 1;
+}
+
+
+/*
+ * Schedule the next transmission attempt after wait milliseconds and double
+ * the wait time with a random factor (RFC 5080, Section 2.2.1) for the
+ * following one.
+ */
+static void radius_client_schedule(struct radius_msg_list *entry,
+				   struct os_reltime *now, unsigned int wait)
+{
+	unsigned int jitter = wait / 10;
+
+	entry->next_try = *now;
+	os_reltime_add_ms(&entry->next_try, wait);
+
+	wait *= 2;
+	if (jitter)
+		wait = wait - jitter + os_random() % (2 * jitter + 1);
+	if (wait > RADIUS_CLIENT_MAX_WAIT * 1000)
+		wait = RADIUS_CLIENT_MAX_WAIT * 1000;
+	entry->next_wait = wait;
+}
+
+
 static int radius_client_retransmit(struct radius_client_data *radius,
 				    struct radius_msg_list *entry,
-				    os_time_t now)
+				    struct os_reltime *now)
 {
 	struct hostapd_radius_servers *conf = radius->conf;
+	struct hostapd_radius_server *serv;
 	int s;
 	struct wpabuf *buf;
 	size_t prev_num_msgs;
@@ -417,20 +1003,23 @@ static int radius_client_retransmit(struct radius_client_data *radius,
 			conn = radius->auth_tls_conn;
 #endif /* CONFIG_RADIUS_TLS */
 		num_servers = conf->num_auth_servers;
-		if (radius->auth_sock < 0)
+		if (radius->auth_sock < 0 && !radius->lb_states)
 			radius_client_init_auth(radius);
-		if (radius->auth_sock < 0 && conf->num_auth_servers > 1) {
+		if (radius->auth_sock < 0 && !radius->lb_states &&
+		    conf->num_auth_servers > 1) {
 			prev_num_msgs = radius->num_msgs;
 			radius_client_auth_failover(radius);
 			if (prev_num_msgs != radius->num_msgs)
 				return 0;
 		}
-		s = radius->auth_sock;
+		s = radius_client_auth_sock(radius, entry->sock_idx);
+		serv = radius_client_msg_server(radius, entry->msg_type,
+						entry->sock_idx);
 		if (entry->attempts == 0)
-			conf->auth_server->requests++;
+			serv->requests++;
 		else {
-			conf->auth_server->timeouts++;
-			conf->auth_server->retransmissions++;
+			serv->timeouts++;
+			serv->retransmissions++;
 		}
 	}
 
@@ -465,18 +1054,16 @@ static int radius_client_retransmit(struct radius_client_data *radius,
 				    &acct_delay_time, &acct_delay_time_len,
 				    NULL) == 0 &&
 	    acct_delay_time_len == 4) {
-		struct radius_hdr *hdr;
 		u32 delay_time;
 
 		/*
 		 * Need to assign a new identifier since attribute contents
 		 * changes.
 		 */
-		hdr = radius_msg_get_hdr(entry->msg);
-		hdr->identifier = radius_client_get_id(radius);
+		radius_client_change_id(radius, entry);
 
 		/* Update Acct-Delay-Time to show wait time in queue */
-		delay_time = now - entry->first_try;
+		delay_time = now->sec - entry->first_try;
 		WPA_PUT_BE32(acct_delay_time, delay_time);
 
 		wpa_printf(MSG_DEBUG,
@@ -496,6 +1083,8 @@ static int radius_client_retransmit(struct radius_client_data *radius,
 		return 1;
 	}
 
+	if (entry->attempts == 0)
+		entry->server_first_try = *now;
 	entry->attempts++;
 	entry->accu_attempts++;
 	hostapd_logger(radius->ctx, entry->addr, HOSTAPD_MODULE_RADIUS,
@@ -536,45 +1125,124 @@ static int radius_client_retransmit(struct radius_client_data *radius,
 not_ready:
 #endif /* CONFIG_RADIUS_TLS */
 
-	entry->next_try = now + entry->next_wait;
-	entry->next_wait *= 2;
-	if (entry->next_wait > RADIUS_CLIENT_MAX_WAIT)
-		entry->next_wait = RADIUS_CLIENT_MAX_WAIT;
+	radius_client_schedule(entry, now, entry->next_wait);
 
 	return 0;
 }
 
 
+static bool radius_client_failover_needed(struct radius_client_data *radius,
+					  struct radius_msg_list *entry,
+					  struct os_reltime *now)
+{
+	struct hostapd_radius_server *serv;
+	struct os_reltime age;
+	int s;
+
+	if (entry->msg_type == RADIUS_AUTH)
+		s = radius_client_auth_sock(radius, entry->sock_idx);
+	else
+		s = radius->acct_sock;
+	if (entry->attempts >= RADIUS_CLIENT_NUM_FAILOVER ||
+	    (s < 0 && entry->attempts > 0))
+		return true;
+
+	/* Use the measured round trip times, if available, to detect
+	 * a server that does not respond more quickly */
+	serv = radius_client_msg_server(radius, entry->msg_type,
+					entry->sock_idx);
+	if (!serv || !serv->srtt || entry->attempts == 0)
+		return false;
+	os_reltime_sub(now, &entry->server_first_try, &age);
+	return (unsigned int) os_reltime_in_ms(&age) >=
+		RADIUS_CLIENT_FAILOVER_RTO * radius_client_rto(serv);
+}
+
+
+/*
+ * Move a pending authentication request from a server that does not respond
+ * to another one when load balancing. Returns false if the request could not
+ * be moved and needs to be removed.
+ */
+static bool radius_client_lb_failover(struct radius_client_data *radius,
+				      struct radius_msg_list *entry,
+				      struct os_reltime *now)
+{
+	struct hostapd_radius_server *oserv, *nserv;
+	struct radius_hdr *hdr = radius_msg_get_hdr(entry->msg);
+	struct radius_lb_server *lb = &radius->lb_servers[entry->sock_idx];
+	char abuf[50];
+	int idx;
+
+	oserv = &radius->conf->auth_servers[entry->sock_idx];
+	if (!os_reltime_before(now, &lb->holddown)) {
+		hostapd_logger(radius->ctx, NULL, HOSTAPD_MODULE_RADIUS,
+			       HOSTAPD_LEVEL_NOTICE,
+			       "No response from Authentication server %s:%d - skip it for %d seconds",
+			       hostapd_ip_txt(&oserv->addr, abuf, sizeof(abuf)),
+			       oserv->port, RADIUS_CLIENT_LB_HOLDDOWN);
+		lb->holddown = *now;
+		lb->holddown.sec += RADIUS_CLIENT_LB_HOLDDOWN;
+	}
+	oserv->timeouts++;
+
+	/* The identifier is kept since the RX handlers use it to find the
+	 * matching station, so the new server must not have a pending request
+	 * with the same identifier */
+	idx = radius_client_lb_pick(radius, entry->sock_idx, hdr->identifier,
+				    now, false);
+	if (idx < 0)
+		return true; /* no alternative; keep retrying the same server */
+
+	/* Messages protected with a different shared secret would need to be
+	 * rebuilt, so leave it to the EAP state machine to retry instead */
+	nserv = &radius->conf->auth_servers[idx];
+	if (nserv->shared_secret_len != oserv->shared_secret_len ||
+	    os_memcmp(nserv->shared_secret, oserv->shared_secret,
+		      nserv->shared_secret_len) != 0)
+		return false;
+
+	*radius_client_pending_slot(radius, RADIUS_AUTH, entry->sock_idx,
+				    hdr->identifier) = NULL;
+	radius->lb_servers[entry->sock_idx].pending--;
+	entry->sock_idx = idx;
+	radius->lb_servers[idx].pending++;
+	*radius_client_pending_slot(radius, RADIUS_AUTH, idx,
+				    hdr->identifier) = entry;
+
+	/* Send to the new server immediately */
+	entry->attempts = 0;
+	entry->next_try = *now;
+	entry->next_wait = radius_client_rto(nserv);
+	return true;
+}
+
+
 static void radius_client_timer(void *eloop_ctx, void *timeout_ctx)
 {
 	struct radius_client_data *radius = eloop_ctx;
 	struct os_reltime now;
-	os_time_t first;
-	struct radius_msg_list *entry, *prev, *tmp;
+	struct radius_msg_list *entry, *tmp;
 	int auth_failover = 0, acct_failover = 0;
 	size_t prev_num_msgs;
-	int s;
 
-	entry = radius->msgs;
-	if (!entry)
+	if (dl_list_empty(&radius->msgs))
 		return;
 
 	os_get_reltime(&now);
 
-	while (entry) {
-		if (now.sec >= entry->next_try) {
-			s = entry->msg_type == RADIUS_AUTH ? radius->auth_sock :
-				radius->acct_sock;
-			if (entry->attempts >= RADIUS_CLIENT_NUM_FAILOVER ||
-			    (s < 0 && entry->attempts > 0)) {
-				if (entry->msg_type == RADIUS_ACCT ||
-				    entry->msg_type == RADIUS_ACCT_INTERIM)
-					acct_failover++;
-				else
-					auth_failover++;
-			}
-		}
-		entry = entry->next;
+	dl_list_for_each_safe(entry, tmp, &radius->msgs, struct radius_msg_list,
+			      list) {
+		if (os_reltime_before(&now, &entry->next_try) ||
+		    !radius_client_failover_needed(radius, entry, &now))
+			continue;
+		if (entry->msg_type == RADIUS_ACCT ||
+		    entry->msg_type == RADIUS_ACCT_INTERIM)
+			acct_failover++;
+		else if (!radius->lb_states)
+			auth_failover++;
+		else if (!radius_client_lb_failover(radius, entry, &now))
+			radius_client_msg_remove(radius, entry);
 	}
 
 	if (auth_failover)
@@ -583,52 +1251,25 @@ static void radius_client_timer(void *eloop_ctx, void *timeout_ctx)
 	if (acct_failover)
 		radius_client_acct_failover(radius);
 
-	entry = radius->msgs;
-	first = 0;
-
-	prev = NULL;
-	while (entry) {
+restart:
+	dl_list_for_each_safe(entry, tmp, &radius->msgs, struct radius_msg_list,
+			      list) {
 		prev_num_msgs = radius->num_msgs;
-		if (now.sec >= entry->next_try &&
-		    radius_client_retransmit(radius, entry, now.sec)) {
-			if (prev)
-				prev->next = entry->next;
-			else
-				radius->msgs = entry->next;
-
-			tmp = entry;
-			entry = entry->next;
-			radius_client_msg_free(tmp);
-			radius->num_msgs--;
-			continue;
+		if (!os_reltime_before(&now, &entry->next_try) &&
+		    radius_client_retransmit(radius, entry, &now)) {
+			radius_client_msg_remove(radius, entry);
+			if (prev_num_msgs == radius->num_msgs + 1)
+				continue;
 		}
 
 		if (prev_num_msgs != radius->num_msgs) {
 			wpa_printf(MSG_DEBUG,
 				   "RADIUS: Message removed from queue - restart from beginning");
-			entry = radius->msgs;
-			prev = NULL;
-			continue;
+			goto restart;
 		}
-
-		if (first == 0 || entry->next_try < first)
-			first = entry->next_try;
-
-		prev = entry;
-		entry = entry->next;
 	}
 
-	if (radius->msgs) {
-		if (first < now.sec)
-			first = now.sec;
-		eloop_cancel_timeout(radius_client_timer, radius, NULL);
-		eloop_register_timeout(first - now.sec, 0,
-				       radius_client_timer, radius, NULL);
-		hostapd_logger(radius->ctx, NULL, HOSTAPD_MODULE_RADIUS,
-			       HOSTAPD_LEVEL_DEBUG, "Next RADIUS client "
-			       "retransmit in %ld seconds",
-			       (long int) (first - now.sec));
-	}
+	radius_client_update_timeout(radius);
 }
 
 
@@ -646,7 +1287,7 @@ static void radius_client_auth_failover(struct radius_client_data *radius)
 		       hostapd_ip_txt(&old->addr, abuf, sizeof(abuf)),
 		       old->port);
 
-	for (entry = radius->msgs; entry; entry = entry->next) {
+	dl_list_for_each(entry, &radius->msgs, struct radius_msg_list, list) {
 		if (entry->msg_type == RADIUS_AUTH)
 			old->timeouts++;
 	}
@@ -673,7 +1314,7 @@ static void radius_client_acct_failover(struct radius_client_data *radius)
 		       hostapd_ip_txt(&old->addr, abuf, sizeof(abuf)),
 		       old->port);
 
-	for (entry = radius->msgs; entry; entry = entry->next) {
+	dl_list_for_each(entry, &radius->msgs, struct radius_msg_list, list) {
 		if (entry->msg_type == RADIUS_ACCT ||
 		    entry->msg_type == RADIUS_ACCT_INTERIM)
 			old->timeouts++;
@@ -689,30 +1330,31 @@ static void radius_client_acct_failover(struct radius_client_data *radius)
 
 static void radius_client_update_timeout(struct radius_client_data *radius)
 {
-	struct os_reltime now;
-	os_time_t first;
+	struct os_reltime now, first, wait;
 	struct radius_msg_list *entry;
 
 	eloop_cancel_timeout(radius_client_timer, radius, NULL);
 
-	if (radius->msgs == NULL) {
+	if (dl_list_empty(&radius->msgs))
 		return;
-	}
 
-	first = 0;
-	for (entry = radius->msgs; entry; entry = entry->next) {
-		if (first == 0 || entry->next_try < first)
+	first.sec = first.usec = 0;
+	dl_list_for_each(entry, &radius->msgs, struct radius_msg_list, list) {
+		if (!os_reltime_initialized(&first) ||
+		    os_reltime_before(&entry->next_try, &first))
 			first = entry->next_try;
 	}
 
 	os_get_reltime(&now);
-	if (first < now.sec)
-		first = now.sec;
-	eloop_register_timeout(first - now.sec, 0, radius_client_timer, radius,
+	if (os_reltime_before(&first, &now))
+		first = now;
+	os_reltime_sub(&first, &now, &wait);
+	eloop_register_timeout(wait.sec, wait.usec, radius_client_timer, radius,
 			       NULL);
 	hostapd_logger(radius->ctx, NULL, HOSTAPD_MODULE_RADIUS,
 		       HOSTAPD_LEVEL_DEBUG, "Next RADIUS client retransmit in"
-		       " %ld seconds", (long int) (first - now.sec));
+		       " %ld.%03ld seconds", (long int) wait.sec,
+		       (long int) wait.usec / 1000);
 }
 
 
@@ -720,9 +1362,11 @@ static void radius_client_list_add(struct radius_client_data *radius,
 				   struct radius_msg *msg,
 				   RadiusType msg_type,
 				   const u8 *shared_secret,
-				   size_t shared_secret_len, const u8 *addr)
+				   size_t shared_secret_len, const u8 *addr,
+				   unsigned int sock_idx)
 {
-	struct radius_msg_list *entry, *prev;
+	struct radius_msg_list *entry, *oldest;
+	size_t max_pending;
 
 	if (eloop_terminated()) {
 		/* No point in adding entries to retransmit queue since event
@@ -742,33 +1386,36 @@ static void radius_client_list_add(struct radius_client_data *radius,
 		os_memcpy(entry->addr, addr, ETH_ALEN);
 	entry->msg = msg;
 	entry->msg_type = msg_type;
+	entry->sock_idx = sock_idx;
 	entry->shared_secret = shared_secret;
 	entry->shared_secret_len = shared_secret_len;
 	os_get_reltime(&entry->last_attempt);
 	entry->first_try = entry->last_attempt.sec;
-	entry->next_try = entry->first_try + RADIUS_CLIENT_FIRST_WAIT;
+	entry->server_first_try = entry->last_attempt;
 	entry->attempts = 1;
 	entry->accu_attempts = 1;
-	entry->next_wait = RADIUS_CLIENT_FIRST_WAIT * 2;
-	if (entry->next_wait > RADIUS_CLIENT_MAX_WAIT)
-		entry->next_wait = RADIUS_CLIENT_MAX_WAIT;
-	entry->next = radius->msgs;
-	radius->msgs = entry;
-	radius_client_update_timeout(radius);
-
-	if (radius->num_msgs >= RADIUS_CLIENT_MAX_ENTRIES) {
+	radius_client_schedule(entry, &entry->last_attempt,
+			       radius_client_rto(radius_client_msg_server(
+							 radius, msg_type,
+							 sock_idx)));
+
+	max_pending = radius->conf->max_pending > 0 ?
+		(size_t) radius->conf->max_pending : RADIUS_CLIENT_MAX_ENTRIES;
+	if (radius->num_msgs >= max_pending) {
 		wpa_printf(MSG_INFO, "RADIUS: Removing the oldest un-ACKed packet due to retransmit list limits");
-		prev = NULL;
-		while (entry->next) {
-			prev = entry;
-			entry = entry->next;
-		}
-		if (prev) {
-			prev->next = NULL;
-			radius_client_msg_free(entry);
-		}
-	} else
-		radius->num_msgs++;
+		oldest = dl_list_last(&radius->msgs, struct radius_msg_list,
+				      list);
+		if (oldest)
+			radius_client_msg_remove(radius, oldest);
+	}
+
+	dl_list_add(&radius->msgs, &entry->list);
+	radius->num_msgs++;
+	if (radius->lb_states && msg_type == RADIUS_AUTH)
+		radius->lb_servers[sock_idx].pending++;
+	*radius_client_pending_slot(radius, msg_type, sock_idx,
+				    radius_msg_get_hdr(msg)->identifier) = entry;
+	radius_client_update_timeout(radius);
 }
 
 
@@ -790,6 +1437,16 @@ static int radius_client_disable_pmtu_discovery(int s)
 
 static void radius_close_auth_socket(struct radius_client_data *radius)
 {
+	while (radius->num_auth_pool > 0) {
+		int s = radius->auth_pool[--radius->num_auth_pool];
+
+		if (s < 0)
+			continue;
+		eloop_unregister_read_sock(s);
+		close(s);
+	}
+	radius->num_lb_servers = 0;
+
 	if (radius->auth_sock >= 0) {
 #ifdef CONFIG_RADIUS_TLS
 		if (radius->conf->auth_server->tls)
@@ -848,10 +1505,12 @@ int radius_client_send(struct radius_client_data *radius,
 		       const u8 *addr)
 {
 	struct hostapd_radius_servers *conf = radius->conf;
+	struct hostapd_radius_server *serv;
 	const u8 *shared_secret;
 	size_t shared_secret_len;
 	char *name;
 	int s, res;
+	unsigned int sock_idx = 0;
 	struct wpabuf *buf;
 #ifdef CONFIG_RADIUS_TLS
 	struct wpabuf *out = NULL;
@@ -880,6 +1539,8 @@ int radius_client_send(struct radius_client_data *radius,
 		shared_secret_len = conf->acct_server->shared_secret_len;
 		radius_msg_finish_acct(msg, shared_secret, shared_secret_len);
 		name = "accounting";
+		radius_client_claim_id(radius, msg_type,
+				       radius_msg_get_hdr(msg)->identifier);
 		s = radius->acct_sock;
 		conf->acct_server->requests++;
 	} else {
@@ -887,23 +1548,42 @@ int radius_client_send(struct radius_client_data *radius,
 		if (radius->auth_tls)
 			conn = radius->auth_tls_conn;
 #endif /* CONFIG_RADIUS_TLS */
-		if (conf->auth_server && radius->auth_sock < 0)
-			radius_client_init_auth(radius);
+		serv = NULL;
+		if (radius->lb_states) {
+			int idx = radius_client_lb_select(radius, msg);
+
+			if (idx >= 0) {
+				sock_idx = idx;
+				serv = &conf->auth_servers[idx];
+			}
+		} else {
+			if (conf->auth_server && radius->auth_sock < 0)
+				radius_client_init_auth(radius);
+			serv = conf->auth_server;
+		}
 
-		if (conf->auth_server == NULL || radius->auth_sock < 0 ||
-		    conf->auth_server->shared_secret == NULL) {
+		if (!serv || radius_client_auth_sock(radius, sock_idx) < 0 ||
+		    !serv->shared_secret) {
 			hostapd_logger(radius->ctx, NULL,
 				       HOSTAPD_MODULE_RADIUS,
 				       HOSTAPD_LEVEL_INFO,
 				       "No authentication server configured");
 			return -1;
 		}
-		shared_secret = conf->auth_server->shared_secret;
-		shared_secret_len = conf->auth_server->shared_secret_len;
+		shared_secret = serv->shared_secret;
+		shared_secret_len = serv->shared_secret_len;
 		radius_msg_finish(msg, shared_secret, shared_secret_len);
 		name = "authentication";
-		s = radius->auth_sock;
-		conf->auth_server->requests++;
+		if (radius->lb_states)
+			radius_client_lb_claim_id(
+				radius, sock_idx,
+				radius_msg_get_hdr(msg)->identifier);
+		else
+			sock_idx = radius_client_claim_id(
+				radius, msg_type,
+				radius_msg_get_hdr(msg)->identifier);
+		s = radius_client_auth_sock(radius, sock_idx);
+		serv->requests++;
 	}
 
 	hostapd_logger(radius->ctx, NULL, HOSTAPD_MODULE_RADIUS,
@@ -949,7 +1629,7 @@ int radius_client_send(struct radius_client_data *radius,
 skip_send:
 #endif /* CONFIG_RADIUS_TLS */
 	radius_client_list_add(radius, msg, msg_type, shared_secret,
-			       shared_secret_len, addr);
+			       shared_secret_len, addr, sock_idx);
 
 	return 0;
 }
@@ -1036,38 +1716,30 @@ radius_client_process_tls_handshake(struct radius_client_data *radius,
 	wpabuf_free(out);
 
 	if (ready) {
-		struct radius_msg_list *entry, *prev, *tmp;
+		struct radius_msg_list *entry, *tmp;
 		struct os_reltime now;
+		size_t prev_num_msgs;
 
 		/* Send all pending message of matching type since the TLS
 		 * tunnel has now been established. */
 
 		os_get_reltime(&now);
 
-		entry = radius->msgs;
-		prev = NULL;
-		while (entry) {
-			if (entry->msg_type != msg_type) {
-				prev = entry;
-				entry = entry->next;
+		dl_list_for_each_safe(entry, tmp, &radius->msgs,
+				      struct radius_msg_list, list) {
+			if (entry->msg_type != msg_type)
 				continue;
-			}
-
-			if (radius_client_retransmit(radius, entry, now.sec)) {
-				if (prev)
-					prev->next = entry->next;
-				else
-					radius->msgs = entry->next;
 
-				tmp = entry;
-				entry = entry->next;
-				radius_client_msg_free(tmp);
-				radius->num_msgs--;
-				continue;
+			prev_num_msgs = radius->num_msgs;
+			if (radius_client_retransmit(radius, entry, &now)) {
+				radius_client_msg_remove(radius, entry);
+				prev_num_msgs--;
 			}
 
-			prev = entry;
-			entry = entry->next;
+			/* Stop if the queue was modified; the remaining
+			 * messages will be sent from the retransmit timer. */
+			if (prev_num_msgs != radius->num_msgs)
+				break;
 		}
 	}
 
@@ -1099,7 +1771,8 @@ static void radius_client_receive(int sock, void *eloop_ctx, void *sock_ctx)
 	struct radius_hdr *hdr;
 	struct radius_rx_handler *handlers;
 	size_t num_handlers, i;
-	struct radius_msg_list *req, *prev_req;
+	struct radius_msg_list *req;
+	unsigned int sock_idx = 0;
 	struct os_reltime now;
 	struct hostapd_radius_server *rconf;
 	int invalid_authenticator = 0;
@@ -1127,7 +1800,14 @@ static void radius_client_receive(int sock, void *eloop_ctx, void *sock_ctx)
 #endif /* CONFIG_RADIUS_TLS */
 		handlers = radius->auth_handlers;
 		num_handlers = radius->num_auth_handlers;
-		rconf = conf->auth_server;
+		while (sock_idx < radius->num_auth_pool &&
+		       radius->auth_pool[sock_idx] != sock)
+			sock_idx++;
+		if (sock_idx < radius->num_auth_pool)
+			sock_idx++;
+		else
+			sock_idx = 0;
+		rconf = radius_client_msg_server(radius, msg_type, sock_idx);
 	}
 
 	iov.iov_base = buf;
@@ -1224,21 +1904,10 @@ static void radius_client_receive(int sock, void *eloop_ctx, void *sock_ctx)
 		break;
 	}
 
-	prev_req = NULL;
-	req = radius->msgs;
-	while (req) {
-		/* TODO: also match by src addr:port of the packet when using
-		 * alternative RADIUS servers (?) */
-		if ((req->msg_type == msg_type ||
-		     (req->msg_type == RADIUS_ACCT_INTERIM &&
-		      msg_type == RADIUS_ACCT)) &&
-		    radius_msg_get_hdr(req->msg)->identifier ==
-		    hdr->identifier)
-			break;
-
-		prev_req = req;
-		req = req->next;
-	}
+	/* TODO: also match by src addr:port of the packet when using
+	 * alternative RADIUS servers (?) */
+	req = *radius_client_pending_slot(radius, msg_type, sock_idx,
+					  hdr->identifier);
 
 	if (req == NULL) {
 		hostapd_logger(radius->ctx, NULL, HOSTAPD_MODULE_RADIUS,
@@ -1259,12 +1928,26 @@ static void radius_client_receive(int sock, void *eloop_ctx, void *sock_ctx)
 		       roundtrip / 100, roundtrip % 100);
 	rconf->round_trip_time = roundtrip;
 
+	/* Karn's algorithm: a response to a retransmitted request cannot be
+	 * reliably matched with one of the transmissions */
+	if (req->accu_attempts == 1) {
+		struct os_reltime rtt;
+
+		os_reltime_sub(&now, &req->last_attempt, &rtt);
+		radius_client_update_rtt(rconf, os_reltime_in_ms(&rtt));
+	}
+
+	if (radius->lb_states && msg_type == RADIUS_AUTH) {
+		/* The server is responding again */
+		os_memset(&radius->lb_servers[sock_idx].holddown, 0,
+			  sizeof(struct os_reltime));
+		/* Before the handlers since they may already send the next
+		 * request of the EAP conversation */
+		radius_client_lb_track_state(radius, req, msg);
+	}
+
 	/* Remove ACKed RADIUS packet from retransmit list */
-	if (prev_req)
-		prev_req->next = req->next;
-	else
-		radius->msgs = req->next;
-	radius->num_msgs--;
+	radius_client_msg_unlink(radius, req);
 
 	for (i = 0; i < num_handlers; i++) {
 		RadiusRxResult res;
@@ -1297,6 +1980,7 @@ static void radius_client_receive(int sock, void *eloop_ctx, void *sock_ctx)
 		       msg_type, hdr->code, hdr->identifier,
 		       invalid_authenticator ? " [INVALID AUTHENTICATOR]" :
 		       "");
+	radius_client_acct_dropped(radius, req);
 	radius_client_msg_free(req);
 
  fail:
@@ -1421,41 +2105,15 @@ fail:
  * @radius: RADIUS client context from radius_client_init()
  * Returns: Allocated identifier
  *
- * This function is used to fetch a unique (among pending requests) identifier
- * for a new RADIUS message.
+ * This function is used to fetch an identifier for a new RADIUS message.
+ * radius_client_send() makes the identifier unique among pending requests by
+ * selecting a socket that does not have a pending request with the same
+ * identifier or, if there is no such socket, by removing the old request to
+ * avoid using a new reply from the RADIUS server with an old request.
  */
 u8 radius_client_get_id(struct radius_client_data *radius)
 {
-	struct radius_msg_list *entry, *prev, *_remove;
-	u8 id = radius->next_radius_identifier++;
-
-	/* remove entries with matching id from retransmit list to avoid
-	 * using new reply from the RADIUS server with an old request */
-	entry = radius->msgs;
-	prev = NULL;
-	while (entry) {
-		if (radius_msg_get_hdr(entry->msg)->identifier == id) {
-			hostapd_logger(radius->ctx, entry->addr,
-				       HOSTAPD_MODULE_RADIUS,
-				       HOSTAPD_LEVEL_DEBUG,
-				       "Removing pending RADIUS message, "
-				       "since its id (%d) is reused", id);
-			if (prev)
-				prev->next = entry->next;
-			else
-				radius->msgs = entry->next;
-			_remove = entry;
-		} else {
-			_remove = NULL;
-			prev = entry;
-		}
-		entry = entry->next;
-
-		if (_remove)
-			radius_client_msg_free(_remove);
-	}
-
-	return id;
+	return radius->next_radius_identifier++;
 }
 
 
@@ -1466,32 +2124,44 @@ u8 radius_client_get_id(struct radius_client_data *radius)
  */
 void radius_client_flush(struct radius_client_data *radius, int only_auth)
 {
-	struct radius_msg_list *entry, *prev, *tmp;
+	struct radius_msg_list *entry, *tmp;
 
 	if (!radius)
 		return;
 
-	prev = NULL;
-	entry = radius->msgs;
+	dl_list_for_each_safe(entry, tmp, &radius->msgs, struct radius_msg_list,
+			      list) {
+		if (!only_auth || entry->msg_type == RADIUS_AUTH)
+			radius_client_msg_remove(radius, entry);
+	}
 
-	while (entry) {
-		if (!only_auth || entry->msg_type == RADIUS_AUTH) {
-			if (prev)
-				prev->next = entry->next;
-			else
-				radius->msgs = entry->next;
+	if (dl_list_empty(&radius->msgs))
+		eloop_cancel_timeout(radius_client_timer, radius, NULL);
+}
 
-			tmp = entry;
-			entry = entry->next;
-			radius_client_msg_free(tmp);
-			radius->num_msgs--;
-		} else {
-			prev = entry;
-			entry = entry->next;
-		}
+
+/**
+ * radius_client_flush_acct - Flush pending RADIUS accounting messages
+ * @radius: RADIUS client context from radius_client_init()
+ *
+ * The removed messages are passed to the handler registered with
+ * radius_client_set_acct_drop_cb().
+ */
+void radius_client_flush_acct(struct radius_client_data *radius)
+{
+	struct radius_msg_list *entry, *tmp;
+
+	if (!radius)
+		return;
+
+	dl_list_for_each_safe(entry, tmp, &radius->msgs, struct radius_msg_list,
+			      list) {
+		if (entry->msg_type == RADIUS_ACCT ||
+		    entry->msg_type == RADIUS_ACCT_INTERIM)
+			radius_client_msg_remove(radius, entry);
 	}
 
-	if (radius->msgs == NULL)
+	if (dl_list_empty(&radius->msgs))
 		eloop_cancel_timeout(radius_client_timer, radius, NULL);
 }
 
@@ -1505,7 +2175,7 @@ static void radius_client_update_acct_msgs(struct radius_client_data *radius,
 	if (!radius)
 		return;
 
-	for (entry = radius->msgs; entry; entry = entry->next) {
+	dl_list_for_each(entry, &radius->msgs, struct radius_msg_list, list) {
 		if (entry->msg_type == RADIUS_ACCT) {
 			entry->shared_secret = shared_secret;
 			entry->shared_secret_len = shared_secret_len;
@@ -1516,82 +2186,25 @@ static void radius_client_update_acct_msgs(struct radius_client_data *radius,
 }
 
 
-static int
-radius_change_server(struct radius_client_data *radius,
-		     struct hostapd_radius_server *nserv,
-		     struct hostapd_radius_server *oserv,
-		     int auth)
+static int radius_client_open_socket(struct radius_client_data *radius,
+				     struct hostapd_radius_server *nserv,
+				     int auth)
 {
 	struct sockaddr_in serv, claddr;
 #ifdef CONFIG_IPV6
 	struct sockaddr_in6 serv6, claddr6;
+	char abuf[50];
 #endif /* CONFIG_IPV6 */
 	struct sockaddr *addr, *cl_addr;
 	socklen_t addrlen, claddrlen;
-	char abuf[50];
 	int sel_sock;
-	struct radius_msg_list *entry;
 	struct hostapd_radius_servers *conf = radius->conf;
 	int type = SOCK_DGRAM;
-	bool tls = nserv->tls;
 
-	if (tls) {
 #ifdef CONFIG_RADIUS_TLS
+	if (nserv->tls)
 		type = SOCK_STREAM;
-#else /* CONFIG_RADIUS_TLS */
-		wpa_printf(MSG_ERROR, "RADIUS: TLS not supported");
-		return -1;
 #endif /* CONFIG_RADIUS_TLS */
-	}
-
-	hostapd_logger(radius->ctx, NULL, HOSTAPD_MODULE_RADIUS,
-		       HOSTAPD_LEVEL_INFO,
-		       "%s server %s:%d",
-		       auth ? "Authentication" : "Accounting",
-		       hostapd_ip_txt(&nserv->addr, abuf, sizeof(abuf)),
-		       nserv->port);
-
-	if (oserv && oserv == nserv) {
-		/* Reconnect to same server, flush */
-		if (auth)
-			radius_client_flush(radius, 1);
-	}
-
-	if (oserv && oserv != nserv &&
-	    (nserv->shared_secret_len != oserv->shared_secret_len ||
-	     os_memcmp(nserv->shared_secret, oserv->shared_secret,
-		       nserv->shared_secret_len) != 0)) {
-		/* Pending RADIUS packets used different shared secret, so
-		 * they need to be modified. Update accounting message
-		 * authenticators here. Authentication messages are removed
-		 * since they would require more changes and the new RADIUS
-		 * server may not be prepared to receive them anyway due to
-		 * missing state information. Client will likely retry
-		 * authentication, so this should not be an issue. */
-		if (auth)
-			radius_client_flush(radius, 1);
-		else {
-			radius_client_update_acct_msgs(
-				radius, nserv->shared_secret,
-				nserv->shared_secret_len);
-		}
-	}
-
-	/* Reset retry counters */
-	for (entry = radius->msgs; oserv && entry; entry = entry->next) {
-		if ((auth && entry->msg_type != RADIUS_AUTH) ||
-		    (!auth && entry->msg_type != RADIUS_ACCT))
-			continue;
-		entry->next_try = entry->first_try + RADIUS_CLIENT_FIRST_WAIT;
-		entry->attempts = 0;
-		entry->next_wait = RADIUS_CLIENT_FIRST_WAIT * 2;
-	}
-
-	if (radius->msgs) {
-		eloop_cancel_timeout(radius_client_timer, radius, NULL);
-		eloop_register_timeout(RADIUS_CLIENT_FIRST_WAIT, 0,
-				       radius_client_timer, radius, NULL);
-	}
 
 	switch (nserv->addr.af) {
 	case AF_INET:
@@ -1629,7 +2242,7 @@ radius_change_server(struct radius_client_data *radius,
 	}
 
 #ifdef CONFIG_RADIUS_TLS
-	if (tls && fcntl(sel_sock, F_SETFL, O_NONBLOCK) != 0) {
+	if (nserv->tls && fcntl(sel_sock, F_SETFL, O_NONBLOCK) != 0) {
 		wpa_printf(MSG_DEBUG, "RADIUS: fnctl(O_NONBLOCK) failed: %s",
 			   strerror(errno));
 		close(sel_sock);
@@ -1729,9 +2342,145 @@ radius_change_server(struct radius_client_data *radius,
 	}
 #endif /* CONFIG_NATIVE_WINDOWS */
 
+	return sel_sock;
+}
+
+
+/* Open additional RADIUS/UDP sockets to the current authentication server */
+static void radius_client_open_auth_pool(struct radius_client_data *radius,
+					 struct hostapd_radius_server *nserv)
+{
+	int s;
+
+	while (radius->num_auth_pool + 1 < radius->max_auth_socks) {
+		s = radius_client_open_socket(radius, nserv, 1);
+		if (s < 0) {
+			wpa_printf(MSG_INFO,
+				   "RADIUS: Failed to open additional authentication socket (%u open)",
+				   radius->num_auth_pool + 1);
+			break;
+		}
+		eloop_register_read_sock(s, radius_client_receive, radius,
+					 (void *) RADIUS_AUTH);
+		radius->auth_pool[radius->num_auth_pool++] = s;
+	}
+}
+
+
+/* Open one RADIUS/UDP socket to each authentication server for load
+ * balancing; auth_sock is used for the first server and auth_pool for the
+ * others */
+static int radius_client_lb_open(struct radius_client_data *radius)
+{
+	struct hostapd_radius_servers *conf = radius->conf;
+	struct hostapd_radius_server *serv;
+	unsigned int i, n;
+	char abuf[50];
+	int s, opened = 0;
+
+	radius_close_auth_socket(radius);
+
+	n = conf->num_auth_servers;
+	if (n > RADIUS_CLIENT_MAX_AUTH_SOCKS)
+		n = RADIUS_CLIENT_MAX_AUTH_SOCKS;
+
+	for (i = 0; i < n; i++) {
+		serv = &conf->auth_servers[i];
+		hostapd_logger(radius->ctx, NULL, HOSTAPD_MODULE_RADIUS,
+			       HOSTAPD_LEVEL_INFO,
+			       "Authentication server %s:%d (load balancing)",
+			       hostapd_ip_txt(&serv->addr, abuf, sizeof(abuf)),
+			       serv->port);
+		s = radius_client_open_socket(radius, serv, 1);
+		if (s >= 0) {
+			eloop_register_read_sock(s, radius_client_receive,
+						 radius, (void *) RADIUS_AUTH);
+			opened++;
+		}
+		if (i == 0)
+			radius->auth_sock = s;
+		else
+			radius->auth_pool[radius->num_auth_pool++] = s;
+	}
+	radius->num_lb_servers = n;
+
+	return opened ? 0 : -1;
+}
+
+
+static int
+radius_change_server(struct radius_client_data *radius,
+		     struct hostapd_radius_server *nserv,
+		     struct hostapd_radius_server *oserv,
+		     int auth)
+{
+	char abuf[50];
+	int sel_sock;
+	struct radius_msg_list *entry;
+	struct os_reltime now;
+	bool tls = nserv->tls;
+
+#ifndef CONFIG_RADIUS_TLS
+	if (tls) {
+		wpa_printf(MSG_ERROR, "RADIUS: TLS not supported");
+		return -1;
+	}
+#endif /* CONFIG_RADIUS_TLS */
+
+	hostapd_logger(radius->ctx, NULL, HOSTAPD_MODULE_RADIUS,
+		       HOSTAPD_LEVEL_INFO,
+		       "%s server %s:%d",
+		       auth ? "Authentication" : "Accounting",
+		       hostapd_ip_txt(&nserv->addr, abuf, sizeof(abuf)),
+		       nserv->port);
+
+	if (oserv && oserv == nserv) {
+		/* Reconnect to same server, flush */
+		if (auth)
+			radius_client_flush(radius, 1);
+	}
+
+	if (oserv && oserv != nserv &&
+	    (nserv->shared_secret_len != oserv->shared_secret_len ||
+	     os_memcmp(nserv->shared_secret, oserv->shared_secret,
+		       nserv->shared_secret_len) != 0)) {
+		/* Pending RADIUS packets used different shared secret, so
+		 * they need to be modified. Update accounting message
+		 * authenticators here. Authentication messages are removed
+		 * since they would require more changes and the new RADIUS
+		 * server may not be prepared to receive them anyway due to
+		 * missing state information. Client will likely retry
+		 * authentication, so this should not be an issue. */
+		if (auth)
+			radius_client_flush(radius, 1);
+		else {
+			radius_client_update_acct_msgs(
+				radius, nserv->shared_secret,
+				nserv->shared_secret_len);
+		}
+	}
+
+	/* Reset retry counters */
+	os_get_reltime(&now);
+	dl_list_for_each(entry, &radius->msgs, struct radius_msg_list, list) {
+		if (!oserv || (auth && entry->msg_type != RADIUS_AUTH) ||
+		    (!auth && entry->msg_type != RADIUS_ACCT))
+			continue;
+		entry->attempts = 0;
+		radius_client_schedule(entry, &now, radius_client_rto(nserv));
+	}
+
+	radius_client_update_timeout(radius);
+
+	sel_sock = radius_client_open_socket(radius, nserv, auth);
+	if (sel_sock < 0)
+		return sel_sock;
+
 	if (auth) {
 		radius_close_auth_socket(radius);
 		radius->auth_sock = sel_sock;
+		if (!tls)
+			radius_client_open_auth_pool(radius, nserv);
 	} else {
 		radius_close_acct_socket(radius);
 		radius->acct_sock = sel_sock;
@@ -1801,6 +2550,8 @@ static void radius_retry_primary_timer(void *eloop_ctx, void *timeout_ctx)
 
 static int radius_client_init_auth(struct radius_client_data *radius)
 {
+	if (radius->lb_states)
+		return radius_client_lb_open(radius);
 	radius_close_auth_socket(radius);
 	return radius_change_server(radius, radius->conf->auth_server, NULL, 1);
 }
@@ -1844,6 +2595,45 @@ radius_client_init(void *ctx, struct hostapd_radius_servers *conf)
 	radius->ctx = ctx;
 	radius->conf = conf;
 	radius->auth_sock = radius->acct_sock = -1;
+	dl_list_init(&radius->msgs);
+
+	radius->max_auth_socks = 1;
+	if (conf->num_auth_socks > RADIUS_CLIENT_MAX_AUTH_SOCKS)
+		radius->max_auth_socks = RADIUS_CLIENT_MAX_AUTH_SOCKS;
+	else if (conf->num_auth_socks > 1)
+		radius->max_auth_socks = conf->num_auth_socks;
+
+	if (conf->auth_load_balance != RADIUS_AUTH_LB_FAILOVER &&
+	    conf->num_auth_servers > 1) {
+		int i;
+
+		for (i = 0; i < conf->num_auth_servers; i++) {
+			if (conf->auth_servers[i].tls)
+				break;
+		}
+		if (i < conf->num_auth_servers) {
+			wpa_printf(MSG_INFO,
+				   "RADIUS: Authentication server load balancing is not supported with RADIUS/TLS");
+		} else {
+			radius->lb_states = os_calloc(
+				RADIUS_CLIENT_LB_STATES,
+				sizeof(struct radius_lb_state));
+			if (!radius->lb_states) {
+				os_free(radius);
+				return NULL;
+			}
+			radius->max_auth_socks = RADIUS_CLIENT_MAX_AUTH_SOCKS;
+		}
+	}
+	/* One block of identifiers for each authentication socket and one for
+	 * the accounting socket */
+	radius->pending = os_calloc((radius->max_auth_socks + 1) * 256,
+				    sizeof(struct radius_msg_list *));
+	if (!radius->pending) {
+		os_free(radius->lb_states);
+		os_free(radius);
+		return NULL;
+	}
 
 	if (conf->auth_server && radius_client_init_auth(radius) == -1) {
 		radius_client_deinit(radius);
@@ -1895,6 +2685,9 @@ void radius_client_deinit(struct radius_client_data *radius)
 	eloop_cancel_timeout(radius_retry_primary_timer, radius, NULL);
 
 	radius_client_flush(radius, 0);
+	radius_client_lb_flush_states(radius);
+	os_free(radius->lb_states);
+	os_free(radius->pending);
 	os_free(radius->auth_handlers);
 	os_free(radius->acct_handlers);
 #ifdef CONFIG_RADIUS_TLS
@@ -1921,11 +2714,10 @@ void radius_client_deinit(struct radius_client_data *radius)
 void radius_client_flush_auth(struct radius_client_data *radius,
 			      const u8 *addr)
 {
-	struct radius_msg_list *entry, *prev, *tmp;
+	struct radius_msg_list *entry, *tmp;
 
-	prev = NULL;
-	entry = radius->msgs;
-	while (entry) {
+	dl_list_for_each_safe(entry, tmp, &radius->msgs, struct radius_msg_list,
+			      list) {
 		if (entry->msg_type == RADIUS_AUTH &&
 		    ether_addr_equal(entry->addr, addr)) {
 			hostapd_logger(radius->ctx, addr,
@@ -1933,21 +2725,8 @@ void radius_client_flush_auth(struct radius_client_data *radius,
 				       HOSTAPD_LEVEL_DEBUG,
 				       "Removing pending RADIUS authentication"
 				       " message for removed client");
-
-			if (prev)
-				prev->next = entry->next;
-			else
-				radius->msgs = entry->next;
-
-			tmp = entry;
-			entry = entry->next;
-			radius_client_msg_free(tmp);
-			radius->num_msgs--;
-			continue;
+			radius_client_msg_remove(radius, entry);
 		}
-
-		prev = entry;
-		entry = entry->next;
 	}
 }
 
@@ -1961,8 +2740,11 @@ static int radius_client_dump_auth_server(char *buf, size_t buflen,
 	char abuf[50];
 
 	if (cli) {
-		for (msg = cli->msgs; msg; msg = msg->next) {
-			if (msg->msg_type == RADIUS_AUTH)
+		dl_list_for_each(msg, &cli->msgs, struct radius_msg_list,
+				 list) {
+			if (msg->msg_type == RADIUS_AUTH &&
+			    radius_client_msg_server(cli, RADIUS_AUTH,
+						     msg->sock_idx) == serv)
 				pending++;
 		}
 	}
@@ -1972,6 +2754,9 @@ static int radius_client_dump_auth_server(char *buf, size_t buflen,
 			   "radiusAuthServerAddress=%s\n"
 			   "radiusAuthClientServerPortNumber=%d\n"
 			   "radiusAuthClientRoundTripTime=%d\n"
+			   "radiusAuthClientSmoothedRoundTripTime=%u\n"
+			   "radiusAuthClientRoundTripTimeVariation=%u\n"
+			   "radiusAuthClientRetransmitTimeout=%u\n"
 			   "radiusAuthClientAccessRequests=%u\n"
 			   "radiusAuthClientAccessRetransmissions=%u\n"
 			   "radiusAuthClientAccessAccepts=%u\n"
@@ -1987,6 +2772,9 @@ static int radius_client_dump_auth_server(char *buf, size_t buflen,
 			   hostapd_ip_txt(&serv->addr, abuf, sizeof(abuf)),
 			   serv->port,
 			   serv->round_trip_time,
+			   serv->srtt / 10,
+			   serv->rttvar / 10,
+			   radius_client_rto(serv) / 10,
 			   serv->requests,
 			   serv->retransmissions,
 			   serv->access_accepts,
@@ -2010,7 +2798,8 @@ static int radius_client_dump_acct_server(char *buf, size_t buflen,
 	char abuf[50];
 
 	if (cli) {
-		for (msg = cli->msgs; msg; msg = msg->next) {
+		dl_list_for_each(msg, &cli->msgs, struct radius_msg_list,
+				 list) {
 			if (msg->msg_type == RADIUS_ACCT ||
 			    msg->msg_type == RADIUS_ACCT_INTERIM)
 				pending++;
@@ -2022,6 +2811,9 @@ static int radius_client_dump_acct_server(char *buf, size_t buflen,
 			   "radiusAccServerAddress=%s\n"
 			   "radiusAccClientServerPortNumber=%d\n"
 			   "radiusAccClientRoundTripTime=%d\n"
+			   "radiusAccClientSmoothedRoundTripTime=%u\n"
+			   "radiusAccClientRoundTripTimeVariation=%u\n"
+			   "radiusAccClientRetransmitTimeout=%u\n"
 			   "radiusAccClientRequests=%u\n"
 			   "radiusAccClientRetransmissions=%u\n"
 			   "radiusAccClientResponses=%u\n"
@@ -2035,6 +2827,9 @@ static int radius_client_dump_acct_server(char *buf, size_t buflen,
 			   hostapd_ip_txt(&serv->addr, abuf, sizeof(abuf)),
 			   serv->port,
 			   serv->round_trip_time,
+			   serv->srtt / 10,
+			   serv->rttvar / 10,
+			   radius_client_rto(serv) / 10,
 			   serv->requests,
 			   serv->retransmissions,
 			   serv->responses,
@@ -2072,7 +2867,7 @@ int radius_client_get_mib(struct radius_client_data *radius, char *buf,
 			serv = &conf->auth_servers[i];
 			count += radius_client_dump_auth_server(
 				buf + count, buflen - count, serv,
-				serv == conf->auth_server ?
+				serv == conf->auth_server || radius->lb_states ?
 				radius : NULL);
 		}
 	}
@@ -2094,6 +2889,16 @@ int radius_client_get_mib(struct radius_client_data *radius, char *buf,
 void radius_client_reconfig(struct radius_client_data *radius,
 			    struct hostapd_radius_servers *conf)
 {
-	if (radius)
-		radius->conf = conf;
+	if (!radius)
+		return;
+
+	if (radius->lb_states) {
+		/* The sockets and pending requests refer to the servers by
+		 * their index in the old configuration */
+		radius_client_flush(radius, 1);
+		radius_close_auth_socket(radius);
+		radius_client_lb_flush_states(radius);
+		os_memset(radius->lb_servers, 0, sizeof(radius->lb_servers));
+	}
+	radius->conf = conf;
 }
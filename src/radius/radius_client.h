@@ -70,6 +70,15 @@ struct hostapd_radius_server {
 	 */
 	char *private_key_passwd;
 
+	/**
+	 * weight - Relative share of requests when load balancing
+	 *
+	 * This is used only for authentication servers with
+	 * RADIUS_AUTH_LB_ROUND_ROBIN and RADIUS_AUTH_LB_LEAST_PENDING. 0 is
+	 * handled as 1.
+	 */
+	int weight;
+
 	/* Dynamic (not from configuration file) MIB data */
 
 	/**
@@ -83,6 +92,19 @@ struct hostapd_radius_server {
 	 */
 	int round_trip_time;
 
+	/**
+	 * srtt - Smoothed round trip time in milliseconds
+	 *
+	 * This is 0 until the first response to a request that was not
+	 * retransmitted has been received.
+	 */
+	unsigned int srtt;
+
+	/**
+	 * rttvar - Round trip time variation in milliseconds
+	 */
+	unsigned int rttvar;
+
 	/**
 	 * requests - radiusAuthClientAccessRequests or radiusAccClientRequests
 	 */
@@ -139,6 +161,21 @@ struct hostapd_radius_server {
 	u32 packets_dropped;
 };
 
+/**
+ * enum radius_auth_load_balance - Authentication server selection policy
+ * @RADIUS_AUTH_LB_FAILOVER: Use the current server and move to the next one
+ *	in the list only when it stops responding
+ * @RADIUS_AUTH_LB_ROUND_ROBIN: Spread new requests over all responding
+ *	servers with weighted round-robin
+ * @RADIUS_AUTH_LB_LEAST_PENDING: Send new requests to the responding server
+ *	with the least pending requests relative to its weight
+ */
+enum radius_auth_load_balance {
+	RADIUS_AUTH_LB_FAILOVER = 0,
+	RADIUS_AUTH_LB_ROUND_ROBIN = 1,
+	RADIUS_AUTH_LB_LEAST_PENDING = 2,
+};
+
 /**
  * struct hostapd_radius_servers - RADIUS servers for RADIUS client
  */
@@ -204,9 +241,45 @@ struct hostapd_radius_servers {
 	 * force_client_dev - Bind the socket to a specified interface, if set
 	 */
 	char *force_client_dev;
+
+	/**
+	 * num_auth_socks - Number of RADIUS/UDP authentication sockets
+	 *
+	 * Authentication requests are spread over this many local ports, each
+	 * with its own 8-bit identifier space, to allow more than 256 requests
+	 * to be pending at the same time. 0 or 1 means a single socket is used
+	 * and the maximum is RADIUS_CLIENT_MAX_AUTH_SOCKS. This is not used
+	 * with RADIUS/TLS.
+	 */
+	int num_auth_socks;
+
+	/**
+	 * max_pending - Maximum number of pending RADIUS messages
+	 *
+	 * The oldest pending message is removed if this limit is reached. 0
+	 * means the default limit of the RADIUS client is used.
+	 */
+	int max_pending;
+
+	/**
+	 * auth_load_balance - Authentication server selection policy
+	 *
+	 * With load balancing, each authentication server (up to
+	 * RADIUS_CLIENT_MAX_AUTH_SOCKS) gets its own socket and requests
+	 * continuing an EAP conversation (State attribute) are sent to the
+	 * server that issued the State. num_auth_socks is not used in this
+	 * case and load balancing is not used with RADIUS/TLS.
+	 */
+	enum radius_auth_load_balance auth_load_balance;
 };
 
 
+/**
+ * RADIUS_CLIENT_MAX_AUTH_SOCKS - Maximum number of authentication sockets
+ */
+#define RADIUS_CLIENT_MAX_AUTH_SOCKS 16
+
+
 /**
  * RadiusType - RADIUS server type for RADIUS client
  */
@@ -274,11 +347,16 @@ int radius_client_register(struct radius_client_data *radius,
 void radius_client_set_interim_error_cb(struct radius_client_data *radius,
 					void (*cb)(const u8 *addr, void *ctx),
 					void *ctx);
+void radius_client_set_acct_drop_cb(struct radius_client_data *radius,
+				    void (*cb)(struct radius_msg *msg,
+					       unsigned int queued, void *ctx),
+				    void *ctx);
 int radius_client_send(struct radius_client_data *radius,
 		       struct radius_msg *msg,
 		       RadiusType msg_type, const u8 *addr);
 u8 radius_client_get_id(struct radius_client_data *radius);
 void radius_client_flush(struct radius_client_data *radius, int only_auth);
+void radius_client_flush_acct(struct radius_client_data *radius);
 struct radius_client_data *
 radius_client_init(void *ctx, struct hostapd_radius_servers *conf);
 void radius_client_deinit(struct radius_client_data *radius);
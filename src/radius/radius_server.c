@@ -8,6 +8,7 @@
 
 #include "includes.h"
 #include <net/if.h>
+#include <sys/wait.h>
 #ifdef CONFIG_SQLITE
 #include <sqlite3.h>
 #endif /* CONFIG_SQLITE */
@@ -35,6 +36,16 @@
  */
 #define RADIUS_MAX_SESSION 1000
 
+/**
+ * RADIUS_SESSION_HASH_SIZE - Number of buckets in the session hash table
+ */
+#define RADIUS_SESSION_HASH_SIZE 256
+
+/**
+ * RADIUS_SERVER_MAX_WORKERS - Maximum number of worker processes
+ */
+#define RADIUS_SERVER_MAX_WORKERS 64
+
 static const struct eapol_callbacks radius_server_eapol_cb;
 
 struct radius_client;
@@ -61,13 +72,25 @@ struct radius_server_counters {
 	u32 malformed_acct_requests;
 	u32 acct_bad_authenticators;
 	u32 unknown_acct_types;
+
+	u32 eap_sessions; /* EAP sessions completed with Accept/Reject */
+	u32 eap_rounds; /* EAP round trips in the completed sessions */
 };
 
+/*
+ * Largest EAP message that fits in an Access-Challenge with the RADIUS header,
+ * Message-Authenticator, State, and room for other attributes. Each
+ * EAP-Message attribute carries up to 253 octets of the EAP message.
+ */
+#define RADIUS_SERVER_MAX_EAP_LEN \
+	((RADIUS_MAX_MSG_LEN - 20 - 18 - 6 - 96) * 253 / 255)
+
 /**
  * struct radius_session - Internal RADIUS server data for a session
  */
 struct radius_session {
 	struct radius_session *next;
+	struct radius_session *hnext; /* next in radius_server_data::sess_hash */
 	struct radius_client *client;
 	struct radius_server_data *server;
 	unsigned int sess_id;
@@ -100,6 +123,8 @@ struct radius_session {
  */
 struct radius_client {
 	struct radius_client *next;
+	unsigned int index; /* position in the clients file */
+	int prefix_len;
 	struct in_addr addr;
 	struct in_addr mask;
 #ifdef CONFIG_IPV6
@@ -120,6 +145,32 @@ struct radius_client {
 	u8 pending_dac_disconnect_addr[ETH_ALEN];
 };
 
+/**
+ * struct radius_server_worker - Worker process for RADIUS authentication
+ */
+struct radius_server_worker {
+	pid_t pid;
+	int sock; /* main process end of the socket pair */
+};
+
+/**
+ * struct radius_server_fwd_hdr - Header for packets forwarded to a worker
+ *
+ * This is followed by the received RADIUS message.
+ */
+struct radius_server_fwd_hdr {
+	struct sockaddr_storage from;
+	socklen_t fromlen;
+};
+
+/**
+ * struct radius_client_node - Binary trie node for client address lookup
+ */
+struct radius_client_node {
+	struct radius_client_node *child[2];
+	struct radius_client *client; /* first client with this exact prefix */
+};
+
 /**
  * struct radius_server_data - Internal RADIUS server data
  */
@@ -139,6 +190,35 @@ struct radius_server_data {
 	 */
 	struct radius_client *clients;
 
+	/**
+	 * client_trie - Prefix trie of the client addresses
+	 *
+	 * This covers the address family selected with ipv6 and is used to
+	 * find the first matching entry in clients without walking the list.
+	 */
+	struct radius_client_node *client_trie;
+
+	/**
+	 * sess_hash - Active sessions hashed by session identifier
+	 */
+	struct radius_session *sess_hash[RADIUS_SESSION_HASH_SIZE];
+
+	/**
+	 * workers - Worker processes for authentication messages
+	 *
+	 * When workers are used, the main process only receives the messages
+	 * from auth_sock and forwards them to the worker that owns the
+	 * session. Session identifiers are assigned so that the worker index
+	 * is the session identifier modulo num_workers. This is %NULL in the
+	 * worker processes.
+	 */
+	struct radius_server_worker *workers;
+
+	/**
+	 * num_workers - Number of worker processes or 0 if not used
+	 */
+	int num_workers;
+
 	/**
 	 * next_sess_id - Next session identifier
 	 */
@@ -328,12 +408,97 @@ void srv_log(struct radius_session *sess, const char *fmt, ...)
 }
 
 
+static int radius_server_client_trie_add(struct radius_client_node **root,
+					 const u8 *key, int prefix_len,
+					 struct radius_client *client)
+{
+	struct radius_client_node **pos = root;
+	int i;
+
+	for (i = 0; ; i++) {
+		if (!*pos) {
+			*pos = os_zalloc(sizeof(**pos));
+			if (!*pos)
+				return -1;
+		}
+		if (i == prefix_len)
+			break;
+		pos = &(*pos)->child[(key[i / 8] >> (7 - i % 8)) & 1];
+	}
+
+	/* Keep the first entry from the clients file for duplicate prefixes */
+	if (!(*pos)->client)
+		(*pos)->client = client;
+	return 0;
+}
+
+
+static void radius_server_client_trie_free(struct radius_client_node *node)
+{
+	if (!node)
+		return;
+	radius_server_client_trie_free(node->child[0]);
+	radius_server_client_trie_free(node->child[1]);
+	os_free(node);
+}
+
+
+static int radius_server_client_trie_init(struct radius_server_data *data)
+{
+	struct radius_client *client;
+	const u8 *key;
+
+	for (client = data->clients; client; client = client->next) {
+#ifdef CONFIG_IPV6
+		if (data->ipv6)
+			key = client->addr6.s6_addr;
+		else
+#endif /* CONFIG_IPV6 */
+		key = (const u8 *) &client->addr.s_addr;
+		if (radius_server_client_trie_add(&data->client_trie, key,
+						  client->prefix_len,
+						  client) < 0)
+			return -1;
+	}
+
+	return 0;
+}
+
+
+/*
+ * Find the first client in the clients file order whose prefix matches the
+ * address, i.e., the same entry a linear walk of the list would have found.
+ */
+static struct radius_client *
+radius_server_client_trie_get(struct radius_client_node *node, const u8 *key,
+			      int bits)
+{
+	struct radius_client *best = NULL;
+	int i;
+
+	for (i = 0; node; i++) {
+		if (node->client && (!best || node->client->index < best->index))
+			best = node->client;
+		if (i == bits)
+			break;
+		node = node->child[(key[i / 8] >> (7 - i % 8)) & 1];
+	}
+
+	return best;
+}
+
+
 static struct radius_client *
 radius_server_get_client(struct radius_server_data *data, struct in_addr *addr,
 			 int ipv6)
 {
 	struct radius_client *client = data->clients;
 
+	if (data->client_trie && !ipv6 == !data->ipv6)
+		return radius_server_client_trie_get(data->client_trie,
+						     (const u8 *) addr,
+						     ipv6 ? 128 : 32);
+
 	while (client) {
 #ifdef CONFIG_IPV6
 		if (ipv6) {
@@ -368,15 +533,16 @@ radius_server_get_client(struct radius_server_data *data, struct in_addr *addr,
 
 
 static struct radius_session *
-radius_server_get_session(struct radius_client *client, unsigned int sess_id)
+radius_server_get_session(struct radius_server_data *data,
+			  struct radius_client *client, unsigned int sess_id)
 {
-	struct radius_session *sess = client->sessions;
+	struct radius_session *sess;
 
+	sess = data->sess_hash[sess_id % RADIUS_SESSION_HASH_SIZE];
 	while (sess) {
-		if (sess->sess_id == sess_id) {
+		if (sess->sess_id == sess_id && sess->client == client)
 			break;
-		}
-		sess = sess->next;
+		sess = sess->hnext;
 	}
 
 	return sess;
@@ -386,6 +552,16 @@ radius_server_get_session(struct radius_client *client, unsigned int sess_id)
 static void radius_server_session_free(struct radius_server_data *data,
 				       struct radius_session *sess)
 {
+	struct radius_session **pos;
+
+	for (pos = &data->sess_hash[sess->sess_id % RADIUS_SESSION_HASH_SIZE];
+	     *pos; pos = &(*pos)->hnext) {
+		if (*pos == sess) {
+			*pos = sess->hnext;
+			break;
+		}
+	}
+
 	eloop_cancel_timeout(radius_server_session_timeout, data, sess);
 	eloop_cancel_timeout(radius_server_session_remove_timeout, data, sess);
 	eap_server_sm_deinit(sess->eap);
@@ -463,9 +639,12 @@ radius_server_new_session(struct radius_server_data *data,
 
 	sess->server = data;
 	sess->client = client;
-	sess->sess_id = data->next_sess_id++;
+	sess->sess_id = data->next_sess_id;
+	data->next_sess_id += data->num_workers > 1 ? data->num_workers : 1;
 	sess->next = client->sessions;
 	client->sessions = sess;
+	sess->hnext = data->sess_hash[sess->sess_id % RADIUS_SESSION_HASH_SIZE];
+	data->sess_hash[sess->sess_id % RADIUS_SESSION_HASH_SIZE] = sess;
 	eloop_register_timeout(RADIUS_SESSION_TIMEOUT, 0,
 			       radius_server_session_timeout, data, sess);
 	data->num_sess++;
@@ -566,6 +745,7 @@ radius_server_get_new_session(struct radius_server_data *data,
 	struct radius_session *sess;
 	struct eap_session_data eap_sess;
 	struct eap_user *tmp;
+	u32 mtu;
 
 	RADIUS_DEBUG("Creating a new session");
 
@@ -642,6 +822,12 @@ radius_server_get_new_session(struct radius_server_data *data,
 	srv_log(sess, "New session created");
 
 	os_memset(&eap_sess, 0, sizeof(eap_sess));
+	if (radius_msg_get_attr_int32(msg, RADIUS_ATTR_FRAMED_MTU, &mtu) == 0) {
+		RADIUS_DEBUG("Framed-MTU: %u", mtu);
+		eap_sess.mtu = mtu;
+		if (eap_sess.mtu > RADIUS_SERVER_MAX_EAP_LEN)
+			eap_sess.mtu = RADIUS_SERVER_MAX_EAP_LEN;
+	}
 	radius_server_testing_options(sess, &eap_sess);
 	sess->eap = eap_server_sm_init(sess, &radius_server_eapol_cb,
 				       data->eap_cfg, &eap_sess);
@@ -1377,7 +1563,7 @@ static int radius_server_request(struct radius_server_data *data,
 		state_included = res >= 0;
 		if (res == sizeof(statebuf)) {
 			state = WPA_GET_BE32(statebuf);
-			sess = radius_server_get_session(client, state);
+			sess = radius_server_get_session(data, client, state);
 		} else {
 			sess = NULL;
 		}
@@ -1508,14 +1694,22 @@ send_reply:
 
 		switch (radius_msg_get_hdr(reply)->code) {
 		case RADIUS_CODE_ACCESS_ACCEPT:
-			srv_log(sess, "Sending Access-Accept");
+			srv_log(sess, "Sending Access-Accept (%u EAP rounds)",
+				eap_get_num_rounds(sess->eap));
 			data->counters.access_accepts++;
 			client->counters.access_accepts++;
+			data->counters.eap_sessions++;
+			data->counters.eap_rounds +=
+				eap_get_num_rounds(sess->eap);
 			break;
 		case RADIUS_CODE_ACCESS_REJECT:
-			srv_log(sess, "Sending Access-Reject");
+			srv_log(sess, "Sending Access-Reject (%u EAP rounds)",
+				eap_get_num_rounds(sess->eap));
 			data->counters.access_rejects++;
 			client->counters.access_rejects++;
+			data->counters.eap_sessions++;
+			data->counters.eap_rounds +=
+				eap_get_num_rounds(sess->eap);
 			break;
 		case RADIUS_CODE_ACCESS_CHALLENGE:
 			data->counters.access_challenges++;
@@ -1665,61 +1859,43 @@ static void radius_server_receive_coa_resp(struct radius_server_data *data,
 }
 
 
-static void radius_server_receive_auth(int sock, void *eloop_ctx,
-				       void *sock_ctx)
+/* Process a received authentication message; buf is freed */
+static void radius_server_handle_auth(struct radius_server_data *data,
+				      u8 *buf, int len,
+				      struct sockaddr_storage *from_ss,
+				      socklen_t fromlen)
 {
-	struct radius_server_data *data = eloop_ctx;
-	u8 *buf = NULL;
-	union {
-		struct sockaddr_storage ss;
-		struct sockaddr_in sin;
+	struct sockaddr_in *from = (struct sockaddr_in *) from_ss;
 #ifdef CONFIG_IPV6
-		struct sockaddr_in6 sin6;
+	struct sockaddr_in6 *from6 = (struct sockaddr_in6 *) from_ss;
 #endif /* CONFIG_IPV6 */
-	} from;
-	socklen_t fromlen;
-	int len;
 	struct radius_client *client = NULL;
 	struct radius_msg *msg = NULL;
 	char abuf[50];
 	int from_port = 0;
 
-	buf = os_malloc(RADIUS_MAX_MSG_LEN);
-	if (buf == NULL) {
-		goto fail;
-	}
-
-	fromlen = sizeof(from);
-	len = recvfrom(sock, buf, RADIUS_MAX_MSG_LEN, 0,
-		       (struct sockaddr *) &from.ss, &fromlen);
-	if (len < 0) {
-		wpa_printf(MSG_INFO, "recvfrom[radius_server]: %s",
-			   strerror(errno));
-		goto fail;
-	}
-
 #ifdef CONFIG_IPV6
 	if (data->ipv6) {
-		if (inet_ntop(AF_INET6, &from.sin6.sin6_addr, abuf,
+		if (inet_ntop(AF_INET6, &from6->sin6_addr, abuf,
 			      sizeof(abuf)) == NULL)
 			abuf[0] = '\0';
-		from_port = ntohs(from.sin6.sin6_port);
+		from_port = ntohs(from6->sin6_port);
 		RADIUS_DEBUG("Received %d bytes from %s:%d",
 			     len, abuf, from_port);
 
 		client = radius_server_get_client(data,
 						  (struct in_addr *)
-						  &from.sin6.sin6_addr, 1);
+						  &from6->sin6_addr, 1);
 	}
 #endif /* CONFIG_IPV6 */
 
 	if (!data->ipv6) {
-		os_strlcpy(abuf, inet_ntoa(from.sin.sin_addr), sizeof(abuf));
-		from_port = ntohs(from.sin.sin_port);
+		os_strlcpy(abuf, inet_ntoa(from->sin_addr), sizeof(abuf));
+		from_port = ntohs(from->sin_port);
 		RADIUS_DEBUG("Received %d bytes from %s:%d",
 			     len, abuf, from_port);
 
-		client = radius_server_get_client(data, &from.sin.sin_addr, 0);
+		client = radius_server_get_client(data, &from->sin_addr, 0);
 	}
 
 	RADIUS_DUMP("Received data", buf, len);
@@ -1784,7 +1960,7 @@ static void radius_server_receive_auth(int sock, void *eloop_ctx,
 		goto fail;
 	}
 
-	if (radius_server_request(data, msg, (struct sockaddr *) &from,
+	if (radius_server_request(data, msg, (struct sockaddr *) from_ss,
 				  fromlen, client, abuf, from_port, NULL) ==
 	    -2)
 		return; /* msg was stored with the session */
@@ -1795,6 +1971,262 @@ fail:
 }
 
 
+/*
+ * Select the worker for a received message: requests with a State attribute
+ * go to the worker that owns the session and new requests are spread based on
+ * the NAS address and the Calling-Station-Id. Returns -1 for messages that
+ * need to be processed in the main process.
+ */
+static int radius_server_select_worker(struct radius_server_data *data,
+				       const u8 *buf, int len,
+				       struct sockaddr_storage *from,
+				       socklen_t fromlen)
+{
+	struct radius_msg *msg;
+	u8 state[4], *pos;
+	size_t attr_len;
+	const u8 *addr = (const u8 *) from;
+	u32 hash = 2166136261U;
+	socklen_t i;
+	u8 code;
+
+	msg = radius_msg_parse(buf, len);
+	if (!msg)
+		return 0; /* let a worker update the counters */
+
+	code = radius_msg_get_hdr(msg)->code;
+	if (code == RADIUS_CODE_DISCONNECT_ACK ||
+	    code == RADIUS_CODE_DISCONNECT_NAK ||
+	    code == RADIUS_CODE_COA_ACK || code == RADIUS_CODE_COA_NAK) {
+		/* Responses to DAC requests from the main process */
+		radius_msg_free(msg);
+		return -1;
+	}
+
+	if (radius_msg_get_attr(msg, RADIUS_ATTR_STATE, state,
+				sizeof(state)) == sizeof(state)) {
+		radius_msg_free(msg);
+		return WPA_GET_BE32(state) % data->num_workers;
+	}
+
+	/* FNV-1a over the source address and Calling-Station-Id */
+	for (i = 0; i < fromlen; i++) {
+		hash ^= addr[i];
+		hash *= 16777619U;
+	}
+	if (radius_msg_get_attr_ptr(msg, RADIUS_ATTR_CALLING_STATION_ID, &pos,
+				    &attr_len, NULL) == 0) {
+		while (attr_len--) {
+			hash ^= *pos++;
+			hash *= 16777619U;
+		}
+	}
+	radius_msg_free(msg);
+
+	return hash % data->num_workers;
+}
+
+
+static void radius_server_forward(struct radius_server_data *data, int idx,
+				  u8 *buf, int len,
+				  struct sockaddr_storage *from,
+				  socklen_t fromlen)
+{
+	struct radius_server_fwd_hdr hdr;
+	struct iovec iov[2];
+	struct msghdr msghdr;
+
+	os_memset(&hdr, 0, sizeof(hdr));
+	os_memcpy(&hdr.from, from, fromlen);
+	hdr.fromlen = fromlen;
+	iov[0].iov_base = &hdr;
+	iov[0].iov_len = sizeof(hdr);
+	iov[1].iov_base = buf;
+	iov[1].iov_len = len;
+	os_memset(&msghdr, 0, sizeof(msghdr));
+	msghdr.msg_iov = iov;
+	msghdr.msg_iovlen = 2;
+
+	if (sendmsg(data->workers[idx].sock, &msghdr, MSG_DONTWAIT) < 0) {
+		RADIUS_DEBUG("Failed to forward message to worker %d: %s",
+			     idx, strerror(errno));
+		data->counters.packets_dropped++;
+	}
+}
+
+
+static void radius_server_receive_auth(int sock, void *eloop_ctx,
+				       void *sock_ctx)
+{
+	struct radius_server_data *data = eloop_ctx;
+	u8 *buf = NULL;
+	struct sockaddr_storage from;
+	socklen_t fromlen;
+	int len, idx;
+
+	buf = os_malloc(RADIUS_MAX_MSG_LEN);
+	if (buf == NULL)
+		return;
+
+	fromlen = sizeof(from);
+	len = recvfrom(sock, buf, RADIUS_MAX_MSG_LEN, 0,
+		       (struct sockaddr *) &from, &fromlen);
+	if (len < 0) {
+		wpa_printf(MSG_INFO, "recvfrom[radius_server]: %s",
+			   strerror(errno));
+		os_free(buf);
+		return;
+	}
+
+	if (data->workers) {
+		idx = radius_server_select_worker(data, buf, len, &from,
+						  fromlen);
+		if (idx >= 0) {
+			radius_server_forward(data, idx, buf, len, &from,
+					      fromlen);
+			os_free(buf);
+			return;
+		}
+	}
+
+	radius_server_handle_auth(data, buf, len, &from, fromlen);
+}
+
+
+static void radius_server_worker_receive(int sock, void *eloop_ctx,
+					 void *sock_ctx)
+{
+	struct radius_server_data *data = eloop_ctx;
+	struct radius_server_fwd_hdr hdr;
+	struct iovec iov[2];
+	struct msghdr msghdr;
+	u8 *buf;
+	int len;
+
+	buf = os_malloc(RADIUS_MAX_MSG_LEN);
+	if (!buf)
+		return;
+
+	iov[0].iov_base = &hdr;
+	iov[0].iov_len = sizeof(hdr);
+	iov[1].iov_base = buf;
+	iov[1].iov_len = RADIUS_MAX_MSG_LEN;
+	os_memset(&msghdr, 0, sizeof(msghdr));
+	msghdr.msg_iov = iov;
+	msghdr.msg_iovlen = 2;
+
+	len = recvmsg(sock, &msghdr, 0);
+	if (len <= 0) {
+		/* The main process has exited or stopped the worker */
+		os_free(buf);
+		eloop_terminate();
+		return;
+	}
+
+	len -= sizeof(hdr);
+	if (len < 0 || hdr.fromlen > sizeof(hdr.from)) {
+		os_free(buf);
+		return;
+	}
+
+	radius_server_handle_auth(data, buf, len, &hdr.from, hdr.fromlen);
+}
+
+
+static void radius_server_worker_terminate(int sig, void *signal_ctx)
+{
+	eloop_terminate();
+}
+
+
+static void radius_server_stop_workers(struct radius_server_data *data)
+{
+	int i;
+
+	if (!data->workers)
+		return;
+
+	for (i = 0; i < data->num_workers; i++) {
+		if (data->workers[i].sock >= 0)
+			close(data->workers[i].sock);
+		if (data->workers[i].pid > 0) {
+			kill(data->workers[i].pid, SIGTERM);
+			waitpid(data->workers[i].pid, NULL, 0);
+		}
+	}
+	os_free(data->workers);
+	data->workers = NULL;
+}
+
+
+/*
+ * Fork the worker processes. Each worker gets a copy of the server state,
+ * including its own TLS context, and runs a separate event loop for the
+ * sessions assigned to it. Responses are sent directly from the workers using
+ * the shared auth_sock.
+ */
+static int radius_server_start_workers(struct radius_server_data *data)
+{
+	int i, j, sv[2];
+	pid_t pid;
+
+	data->workers = os_calloc(data->num_workers, sizeof(*data->workers));
+	if (!data->workers)
+		return -1;
+	for (i = 0; i < data->num_workers; i++)
+		data->workers[i].sock = -1;
+
+	for (i = 0; i < data->num_workers; i++) {
+		if (socketpair(AF_UNIX, SOCK_SEQPACKET, 0, sv) < 0) {
+			wpa_printf(MSG_ERROR, "RADIUS SRV: socketpair: %s",
+				   strerror(errno));
+			return -1;
+		}
+
+		pid = fork();
+		if (pid < 0) {
+			wpa_printf(MSG_ERROR, "RADIUS SRV: fork: %s",
+				   strerror(errno));
+			close(sv[0]);
+			close(sv[1]);
+			return -1;
+		}
+
+		if (pid > 0) {
+			close(sv[1]);
+			data->workers[i].pid = pid;
+			data->workers[i].sock = sv[0];
+			continue;
+		}
+
+		/* Worker process */
+		close(sv[0]);
+		for (j = 0; j < i; j++)
+			close(data->workers[j].sock);
+		os_free(data->workers);
+		data->workers = NULL;
+		if (data->acct_sock >= 0)
+			close(data->acct_sock);
+		data->acct_sock = -1;
+
+		data->next_sess_id += i - data->next_sess_id % data->num_workers;
+
+		if (eloop_reset() < 0 ||
+		    eloop_register_read_sock(sv[1], radius_server_worker_receive,
+					     data, NULL) < 0)
+			_exit(1);
+		eloop_register_signal_terminate(radius_server_worker_terminate,
+						NULL);
+		RADIUS_DEBUG("Worker %d started (pid %d)", i, (int) getpid());
+		eloop_run();
+		/* Do not run any of the deinit code of the main process */
+		_exit(0);
+	}
+
+	return 0;
+}
+
+
 static void radius_server_receive_acct(int sock, void *eloop_ctx,
 				       void *sock_ctx)
 {
@@ -2144,6 +2576,7 @@ radius_server_read_clients(const char *client_file, int ipv6)
 			break;
 		}
 		entry->shared_secret_len = os_strlen(entry->shared_secret);
+		entry->prefix_len = mask;
 		if (!ipv6) {
 			entry->addr.s_addr = addr.s_addr;
 			val = 0;
@@ -2168,6 +2601,7 @@ radius_server_read_clients(const char *client_file, int ipv6)
 		if (tail == NULL) {
 			clients = tail = entry;
 		} else {
+			entry->index = tail->index + 1;
 			tail->next = entry;
 			tail = entry;
 		}
@@ -2272,6 +2706,8 @@ radius_server_init(struct radius_server_conf *conf)
 		wpa_printf(MSG_ERROR, "No RADIUS clients configured");
 		goto fail;
 	}
+	if (radius_server_client_trie_init(data) < 0)
+		goto fail;
 
 #ifdef CONFIG_IPV6
 	if (conf->ipv6)
@@ -2309,6 +2745,24 @@ radius_server_init(struct radius_server_conf *conf)
 		data->acct_sock = -1;
 	}
 
+	if (conf->num_workers > 1) {
+#ifdef CONFIG_SQLITE
+		if (data->db) {
+			RADIUS_ERROR("Worker processes cannot share the SQLite database");
+			goto fail;
+		}
+#endif /* CONFIG_SQLITE */
+		if (data->eap_cfg && data->eap_cfg->eap_sim_db_priv) {
+			RADIUS_ERROR("Worker processes cannot be used with EAP-SIM/AKA database");
+			goto fail;
+		}
+		data->num_workers = conf->num_workers;
+		if (data->num_workers > RADIUS_SERVER_MAX_WORKERS)
+			data->num_workers = RADIUS_SERVER_MAX_WORKERS;
+		if (radius_server_start_workers(data) < 0)
+			goto fail;
+	}
+
 	return data;
 fail:
 	radius_server_deinit(data);
@@ -2343,6 +2797,8 @@ void radius_server_deinit(struct radius_server_data *data)
 	if (data == NULL)
 		return;
 
+	radius_server_stop_workers(data);
+
 	if (data->auth_sock >= 0) {
 		eloop_unregister_read_sock(data->auth_sock);
 		close(data->auth_sock);
@@ -2354,6 +2810,7 @@ void radius_server_deinit(struct radius_server_data *data)
 	}
 
 	radius_server_free_clients(data, data->clients);
+	radius_server_client_trie_free(data->client_trie);
 
 	os_free(data->eap_req_id_text);
 #ifdef CONFIG_RADIUS_TEST
@@ -2389,6 +2846,9 @@ int radius_server_get_mib(struct radius_server_data *data, char *buf,
 	char *end, *pos;
 	struct os_reltime now;
 	struct radius_client *cli;
+#ifdef EAP_TLS_FUNCS
+	struct tls_session_cache_stats tls_stats;
+#endif /* EAP_TLS_FUNCS */
 
 	/* RFC 2619 - RADIUS Authentication Server MIB */
 
@@ -2430,7 +2890,9 @@ int radius_server_get_mib(struct radius_server_data *data, char *buf,
 			  "radiusAccServTotalResponses=%u\n"
 			  "radiusAccServTotalMalformedRequests=%u\n"
 			  "radiusAccServTotalBadAuthenticators=%u\n"
-			  "radiusAccServTotalUnknownTypes=%u\n",
+			  "radiusAccServTotalUnknownTypes=%u\n"
+			  "radiusAuthServTotalEapSessions=%u\n"
+			  "radiusAuthServTotalEapRounds=%u\n",
 			  data->counters.access_requests,
 			  data->counters.invalid_requests,
 			  data->counters.dup_access_requests,
@@ -2446,13 +2908,36 @@ int radius_server_get_mib(struct radius_server_data *data, char *buf,
 			  data->counters.acct_responses,
 			  data->counters.malformed_acct_requests,
 			  data->counters.acct_bad_authenticators,
-			  data->counters.unknown_acct_types);
+			  data->counters.unknown_acct_types,
+			  data->counters.eap_sessions,
+			  data->counters.eap_rounds);
 	if (os_snprintf_error(end - pos, ret)) {
 		*pos = '\0';
 		return pos - buf;
 	}
 	pos += ret;
 
+#ifdef EAP_TLS_FUNCS
+	if (data->eap_cfg && data->eap_cfg->ssl_ctx &&
+	    tls_get_session_cache_stats(data->eap_cfg->ssl_ctx, &tls_stats) ==
+	    0) {
+		ret = os_snprintf(pos, end - pos,
+				  "tlsSessionCacheEntries=%u\n"
+				  "tlsSessionCacheHits=%u\n"
+				  "tlsSessionCacheMisses=%u\n"
+				  "tlsSessionCacheTimeouts=%u\n"
+				  "tlsSessionCacheEvictions=%u\n",
+				  tls_stats.entries, tls_stats.hits,
+				  tls_stats.misses, tls_stats.timeouts,
+				  tls_stats.evictions);
+		if (os_snprintf_error(end - pos, ret)) {
+			*pos = '\0';
+			return pos - buf;
+		}
+		pos += ret;
+	}
+#endif /* EAP_TLS_FUNCS */
+
 	for (cli = data->clients, idx = 0; cli; cli = cli->next, idx++) {
 		char abuf[50], mbuf[50];
 #ifdef CONFIG_IPV6
@@ -103,6 +103,17 @@ struct radius_server_conf {
 	char *t_c_server_url;
 
 	struct eap_config *eap_cfg;
+
+	/**
+	 * num_workers - Number of worker processes for EAP processing
+	 *
+	 * If this is larger than one, the authentication sessions are
+	 * processed in separate worker processes so that a slow EAP exchange
+	 * (e.g., certificate validation) does not block the other sessions.
+	 * The main process receives the messages and forwards them to the
+	 * worker that owns the session.
+	 */
+	int num_workers;
 };
 
 
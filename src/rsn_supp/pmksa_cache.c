@@ -10,6 +10,7 @@
 
 #include "common.h"
 #include "eloop.h"
+#include "memstat.h"
 #include "eapol_supp/eapol_supp_sm.h"
 #include "wpa.h"
 #include "wpa_i.h"
@@ -54,6 +55,7 @@ static void pmksa_cache_free_entry(struct rsn_pmksa_cache *pmksa,
 				    entry->fils_cache_id_set ?
 				    entry->fils_cache_id : NULL);
 	pmksa->pmksa_count--;
+	memstat_free(MEMSTAT_PMKSA, sizeof(*entry));
 	if (pmksa->free_cb)
 		pmksa->free_cb(entry, pmksa->ctx, reason);
 	_pmksa_cache_free_entry(entry);
@@ -384,6 +386,7 @@ pmksa_cache_add_entry(struct rsn_pmksa_cache *pmksa,
 		prev->next = entry;
 	}
 	pmksa->pmksa_count++;
+	memstat_alloc(MEMSTAT_PMKSA, sizeof(*entry));
 	wpa_printf(MSG_DEBUG, "RSN: Added PMKSA cache entry for " MACSTR
 		   " spa=" MACSTR " network_ctx=%p akmp=0x%x",
 		   MAC2STR(entry->aa), MAC2STR(entry->spa),
@@ -465,7 +468,8 @@ void pmksa_cache_deinit(struct rsn_pmksa_cache *pmksa)
 	while (entry) {
 		prev = entry;
 		entry = entry->next;
-		os_free(prev);
+		memstat_free(MEMSTAT_PMKSA, sizeof(*prev));
+		_pmksa_cache_free_entry(prev);
 	}
 	pmksa_cache_set_expiration(pmksa);
 	os_free(pmksa);
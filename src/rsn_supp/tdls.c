@@ -44,6 +44,7 @@ unsigned int tdls_testing = 0;
 #define TPK_M1_TIMEOUT 5000 /* in milliseconds */
 #define TPK_M2_RETRY_COUNT 10
 #define TPK_M2_TIMEOUT 500 /* in milliseconds */
+#define TDLS_MONITOR_MAX_ATTEMPTS 3
 
 #define TDLS_MIC_LEN		16
 
@@ -95,6 +96,7 @@ static int wpa_tdls_send_teardown(struct wpa_sm *sm, const u8 *addr,
 
 struct wpa_tdls_peer {
 	struct wpa_tdls_peer *next;
+	struct wpa_tdls_peer *hnext; /* next entry in hash table list */
 	unsigned int reconfig_key:1;
 	int initiator; /* whether this end was initiator for TDLS setup */
 	u8 addr[ETH_ALEN]; /* other end MAC address */
@@ -163,9 +165,26 @@ struct wpa_tdls_peer {
 	int mld_link_id;
 	bool disc_resp_rcvd;
 	bool setup_req_rcvd;
+
+	/* Link quality monitor */
+	bool mon_polled;
+	u64 mon_bytes; /* octets to and from the peer at the last poll */
+	u64 mon_rate; /* octets per second */
 };
 
 
+static struct wpa_tdls_peer * wpa_tdls_get_peer(struct wpa_sm *sm,
+						const u8 *addr)
+{
+	struct wpa_tdls_peer *peer;
+
+	peer = sm->tdls_hash[TDLS_PEER_HASH(addr)];
+	while (peer && !ether_addr_equal(peer->addr, addr))
+		peer = peer->hnext;
+	return peer;
+}
+
+
 static const u8 * wpa_tdls_get_link_bssid(struct wpa_sm *sm, int link_id)
 {
 	if (link_id >= 0)
@@ -295,10 +314,7 @@ static int wpa_tdls_tpk_send(struct wpa_sm *sm, const u8 *dest, u8 action_code,
 	    action_code == WLAN_TDLS_DISCOVERY_RESPONSE)
 		return 0; /* No retries */
 
-	for (peer = sm->tdls; peer; peer = peer->next) {
-		if (ether_addr_equal(peer->addr, dest))
-			break;
-	}
+	peer = wpa_tdls_get_peer(sm, dest);
 
 	if (peer == NULL) {
 		wpa_printf(MSG_INFO, "TDLS: No matching entry found for "
@@ -687,11 +703,42 @@ static void wpa_tdls_tpk_timeout(void *eloop_ctx, void *timeout_ctx)
 }
 
 
+static void wpa_tdls_monitor_forget(struct wpa_sm *sm, const u8 *addr)
+{
+	unsigned int i;
+
+	for (i = 0; i < sm->tdls_num_monitor; i++) {
+		if (!ether_addr_equal(sm->tdls_monitor[i].addr, addr))
+			continue;
+		sm->tdls_num_monitor--;
+		os_memmove(&sm->tdls_monitor[i], &sm->tdls_monitor[i + 1],
+			   (sm->tdls_num_monitor - i) *
+			   sizeof(sm->tdls_monitor[0]));
+		return;
+	}
+}
+
+
+static void wpa_tdls_peer_hash_del(struct wpa_sm *sm,
+				   struct wpa_tdls_peer *peer)
+{
+	struct wpa_tdls_peer **pos;
+
+	pos = &sm->tdls_hash[TDLS_PEER_HASH(peer->addr)];
+	while (*pos && *pos != peer)
+		pos = &(*pos)->hnext;
+	if (*pos)
+		*pos = peer->hnext;
+}
+
+
 static void wpa_tdls_peer_remove_from_list(struct wpa_sm *sm,
 					   struct wpa_tdls_peer *peer)
 {
 	struct wpa_tdls_peer *cur, *prev;
 
+	wpa_tdls_peer_hash_del(sm, peer);
+
 	cur = sm->tdls;
 	prev = NULL;
 	while (cur && cur != peer) {
@@ -792,10 +839,7 @@ static int wpa_tdls_send_teardown(struct wpa_sm *sm, const u8 *addr,
 		return -1;
 
 	/* Find the node and free from the list */
-	for (peer = sm->tdls; peer; peer = peer->next) {
-		if (ether_addr_equal(peer->addr, addr))
-			break;
-	}
+	peer = wpa_tdls_get_peer(sm, addr);
 
 	if (peer == NULL) {
 		wpa_printf(MSG_INFO, "TDLS: No matching entry found for "
@@ -881,10 +925,10 @@ int wpa_tdls_teardown_link(struct wpa_sm *sm, const u8 *addr, u16 reason_code)
 	if (sm->tdls_disabled || !sm->tdls_supported)
 		return -1;
 
-	for (peer = sm->tdls; peer; peer = peer->next) {
-		if (ether_addr_equal(peer->addr, addr))
-			break;
-	}
+	/* Do not restore a link that was explicitly torn down */
+	wpa_tdls_monitor_forget(sm, addr);
+
+	peer = wpa_tdls_get_peer(sm, addr);
 
 	if (peer == NULL) {
 		wpa_printf(MSG_DEBUG, "TDLS: Could not find peer " MACSTR
@@ -914,10 +958,7 @@ void wpa_tdls_disable_unreachable_link(struct wpa_sm *sm, const u8 *addr)
 {
 	struct wpa_tdls_peer *peer;
 
-	for (peer = sm->tdls; peer; peer = peer->next) {
-		if (ether_addr_equal(peer->addr, addr))
-			break;
-	}
+	peer = wpa_tdls_get_peer(sm, addr);
 
 	if (!peer || !peer->tpk_success) {
 		wpa_printf(MSG_DEBUG, "TDLS: Peer " MACSTR
@@ -950,10 +991,7 @@ const char * wpa_tdls_get_link_status(struct wpa_sm *sm, const u8 *addr)
 	if (sm->tdls_disabled || !sm->tdls_supported)
 		return "disabled";
 
-	for (peer = sm->tdls; peer; peer = peer->next) {
-		if (ether_addr_equal(peer->addr, addr))
-			break;
-	}
+	peer = wpa_tdls_get_peer(sm, addr);
 
 	if (peer == NULL)
 		return "peer does not exist";
@@ -977,10 +1015,7 @@ static int wpa_tdls_recv_teardown(struct wpa_sm *sm, const u8 *src_addr,
 	int ielen;
 
 	/* Find the node and free from the list */
-	for (peer = sm->tdls; peer; peer = peer->next) {
-		if (ether_addr_equal(peer->addr, src_addr))
-			break;
-	}
+	peer = wpa_tdls_get_peer(sm, src_addr);
 
 	if (peer == NULL) {
 		wpa_printf(MSG_INFO, "TDLS: No matching entry found for "
@@ -1036,6 +1071,8 @@ static int wpa_tdls_recv_teardown(struct wpa_sm *sm, const u8 *src_addr,
 	}
 
 skip_ftie:
+	wpa_tdls_monitor_forget(sm, src_addr);
+
 	/*
 	 * Request the driver to disable the direct link and clear associated
 	 * keys.
@@ -1073,12 +1110,11 @@ wpa_tdls_add_peer(struct wpa_sm *sm, const u8 *addr, int *existing)
 
 	if (existing)
 		*existing = 0;
-	for (peer = sm->tdls; peer; peer = peer->next) {
-		if (ether_addr_equal(peer->addr, addr)) {
-			if (existing)
-				*existing = 1;
-			return peer; /* re-use existing entry */
-		}
+	peer = wpa_tdls_get_peer(sm, addr);
+	if (peer) {
+		if (existing)
+			*existing = 1;
+		return peer; /* re-use existing entry */
 	}
 
 	wpa_printf(MSG_INFO, "TDLS: Creating peer entry for " MACSTR,
@@ -1092,6 +1128,8 @@ wpa_tdls_add_peer(struct wpa_sm *sm, const u8 *addr, int *existing)
 	peer->mld_link_id = -1;
 	peer->next = sm->tdls;
 	sm->tdls = peer;
+	peer->hnext = sm->tdls_hash[TDLS_PEER_HASH(addr)];
+	sm->tdls_hash[TDLS_PEER_HASH(addr)] = peer;
 
 	return peer;
 }
@@ -2371,10 +2409,7 @@ static int wpa_tdls_process_tpk_m2(struct wpa_sm *sm, const u8 *src_addr,
 
 	wpa_printf(MSG_DEBUG, "TDLS: Received TDLS Setup Response / TPK M2 "
 		   "(Peer " MACSTR ")", MAC2STR(src_addr));
-	for (peer = sm->tdls; peer; peer = peer->next) {
-		if (ether_addr_equal(peer->addr, src_addr))
-			break;
-	}
+	peer = wpa_tdls_get_peer(sm, src_addr);
 	if (peer == NULL) {
 		wpa_printf(MSG_INFO, "TDLS: No matching peer found for "
 			   "TPK M2: " MACSTR, MAC2STR(src_addr));
@@ -2668,10 +2703,7 @@ static int wpa_tdls_process_tpk_m3(struct wpa_sm *sm, const u8 *src_addr,
 
 	wpa_printf(MSG_DEBUG, "TDLS: Received TDLS Setup Confirm / TPK M3 "
 		   "(Peer " MACSTR ")", MAC2STR(src_addr));
-	for (peer = sm->tdls; peer; peer = peer->next) {
-		if (ether_addr_equal(peer->addr, src_addr))
-			break;
-	}
+	peer = wpa_tdls_get_peer(sm, src_addr);
 	if (peer == NULL) {
 		wpa_printf(MSG_INFO, "TDLS: No matching peer found for "
 			   "TPK M3: " MACSTR, MAC2STR(src_addr));
@@ -2905,10 +2937,7 @@ void wpa_tdls_remove(struct wpa_sm *sm, const u8 *addr)
 	if (sm->tdls_disabled || !sm->tdls_supported)
 		return;
 
-	for (peer = sm->tdls; peer; peer = peer->next) {
-		if (ether_addr_equal(peer->addr, addr))
-			break;
-	}
+	peer = wpa_tdls_get_peer(sm, addr);
 
 	if (peer == NULL || !peer->tpk_success)
 		return;
@@ -2989,6 +3018,167 @@ static void wpa_supplicant_rx_tdls(void *ctx, const u8 *src_addr,
 }
 
 
+static void wpa_tdls_monitor_add(struct wpa_tdls_monitor_peer *list,
+				 unsigned int *num, unsigned int max,
+				 const u8 *addr, u64 rate,
+				 unsigned int attempts)
+{
+	unsigned int i;
+
+	/* Keep the list sorted by descending rate */
+	i = *num;
+	while (i > 0 && list[i - 1].rate < rate)
+		i--;
+	if (i >= max)
+		return;
+	if (*num == max)
+		(*num)--;
+	os_memmove(&list[i + 1], &list[i], (*num - i) * sizeof(*list));
+	os_memcpy(list[i].addr, addr, ETH_ALEN);
+	list[i].rate = rate;
+	list[i].attempts = attempts;
+	(*num)++;
+}
+
+
+static bool wpa_tdls_monitored(struct wpa_sm *sm, const u8 *addr)
+{
+	unsigned int i;
+
+	for (i = 0; i < sm->tdls_num_monitor; i++) {
+		if (ether_addr_equal(sm->tdls_monitor[i].addr, addr))
+			return true;
+	}
+
+	return false;
+}
+
+
+static void wpa_tdls_monitor_poll(struct wpa_sm *sm)
+{
+	struct wpa_tdls_monitor_peer list[TDLS_MONITOR_MAX_LINKS];
+	struct wpa_tdls_monitor_peer *mon;
+	struct wpa_tdls_peer *peer, *next;
+	struct hostap_sta_driver_data data;
+	unsigned int i, num = 0, links = 0;
+	u64 bytes;
+
+	/* Update the traffic rates of the direct links from the driver
+	 * statistics */
+	for (peer = sm->tdls; peer; peer = peer->next) {
+		if (!peer->tpk_success)
+			continue;
+		links++;
+		os_memset(&data, 0, sizeof(data));
+		if (wpa_sm_tdls_read_sta_data(sm, peer->addr, &data) < 0)
+			continue;
+		bytes = data.rx_bytes + data.tx_bytes;
+		if (peer->mon_polled && bytes >= peer->mon_bytes)
+			peer->mon_rate = (bytes - peer->mon_bytes) /
+				sm->tdls_monitor_interval;
+		else
+			peer->mon_rate = 0;
+		peer->mon_bytes = bytes;
+		peer->mon_polled = true;
+		wpa_printf(MSG_DEBUG, "TDLS: Monitor " MACSTR
+			   " rate=%llu signal=%d",
+			   MAC2STR(peer->addr),
+			   (unsigned long long) peer->mon_rate, data.signal);
+		if (peer->mon_rate)
+			wpa_tdls_monitor_add(list, &num,
+					     sm->tdls_monitor_links, peer->addr,
+					     peer->mon_rate, 0);
+	}
+
+	/* Peers with lost links compete with their last known rate until
+	 * the link has been restored or the attempts have run out */
+	for (i = 0; i < sm->tdls_num_monitor; i++) {
+		mon = &sm->tdls_monitor[i];
+		peer = wpa_tdls_get_peer(sm, mon->addr);
+		if ((peer && peer->tpk_success) ||
+		    mon->attempts >= TDLS_MONITOR_MAX_ATTEMPTS)
+			continue;
+		wpa_tdls_monitor_add(list, &num, sm->tdls_monitor_links,
+				     mon->addr, mon->rate, mon->attempts);
+	}
+
+	os_memcpy(sm->tdls_monitor, list, num * sizeof(list[0]));
+	sm->tdls_num_monitor = num;
+
+	/* Release the direct links with the lowest rates if there are more
+	 * links than the limit */
+	for (peer = sm->tdls; peer && links > sm->tdls_monitor_links;
+	     peer = next) {
+		next = peer->next;
+		if (!peer->tpk_success || wpa_tdls_monitored(sm, peer->addr))
+			continue;
+		wpa_printf(MSG_DEBUG, "TDLS: Monitor - tear down low traffic link with "
+			   MACSTR, MAC2STR(peer->addr));
+		links--;
+		wpa_tdls_do_teardown(sm, peer,
+				     WLAN_REASON_TDLS_TEARDOWN_UNSPECIFIED);
+	}
+
+	/* Restore the lost links of the peers with the highest rates */
+	for (i = 0; i < sm->tdls_num_monitor; i++) {
+		mon = &sm->tdls_monitor[i];
+		peer = wpa_tdls_get_peer(sm, mon->addr);
+		if (peer && peer->tpk_success) {
+			mon->attempts = 0;
+			continue;
+		}
+		if (peer && peer->tpk_in_progress)
+			continue;
+		mon->attempts++;
+		wpa_printf(MSG_DEBUG, "TDLS: Monitor - restore link with "
+			   MACSTR " (attempt %u)",
+			   MAC2STR(mon->addr), mon->attempts);
+		if (sm->mlo.valid_links)
+			wpa_tdls_send_discovery_request(sm, mon->addr);
+		wpa_tdls_start(sm, mon->addr);
+	}
+}
+
+
+static void wpa_tdls_monitor_timeout(void *eloop_ctx, void *timeout_ctx)
+{
+	struct wpa_sm *sm = eloop_ctx;
+
+	if (!sm->tdls_disabled && sm->tdls_supported &&
+	    sm->tdls_external_setup && sm->tdls_monitor_links)
+		wpa_tdls_monitor_poll(sm);
+
+	eloop_register_timeout(sm->tdls_monitor_interval, 0,
+			       wpa_tdls_monitor_timeout, sm, NULL);
+}
+
+
+/**
+ * wpa_tdls_set_monitor - Configure the TDLS link quality monitor
+ * @sm: Pointer to WPA state machine data from wpa_sm_init()
+ * @interval: Interval for polling the driver for peer statistics in seconds
+ *	or 0 to disable the monitor
+ * @links: Maximum number of direct links to maintain
+ *
+ * The monitor tracks the traffic rate of each direct link. Links of the peers
+ * with the highest rates are set up again if they are lost and the links with
+ * the lowest rates are torn down when there are more than @links of them.
+ */
+void wpa_tdls_set_monitor(struct wpa_sm *sm, unsigned int interval,
+			  unsigned int links)
+{
+	eloop_cancel_timeout(wpa_tdls_monitor_timeout, sm, NULL);
+	sm->tdls_monitor_interval = interval;
+	sm->tdls_monitor_links = links < TDLS_MONITOR_MAX_LINKS ?
+		links : TDLS_MONITOR_MAX_LINKS;
+	if (sm->tdls_num_monitor > sm->tdls_monitor_links)
+		sm->tdls_num_monitor = sm->tdls_monitor_links;
+	if (interval)
+		eloop_register_timeout(interval, 0, wpa_tdls_monitor_timeout,
+				       sm, NULL);
+}
+
+
 /**
  * wpa_tdls_init - Initialize driver interface parameters for TDLS
  * @wpa_s: Pointer to wpa_supplicant data
@@ -3095,6 +3285,9 @@ void wpa_tdls_deinit(struct wpa_sm *sm)
 	if (sm == NULL)
 		return;
 
+	eloop_cancel_timeout(wpa_tdls_monitor_timeout, sm, NULL);
+	sm->tdls_num_monitor = 0;
+
 	if (sm->l2_tdls)
 		l2_packet_deinit(sm->l2_tdls);
 	sm->l2_tdls = NULL;
@@ -3107,6 +3300,7 @@ void wpa_tdls_assoc(struct wpa_sm *sm)
 {
 	wpa_printf(MSG_DEBUG, "TDLS: Remove peers on association");
 	wpa_tdls_remove_peers(sm);
+	sm->tdls_num_monitor = 0;
 }
 
 
@@ -3114,6 +3308,7 @@ void wpa_tdls_disassoc(struct wpa_sm *sm)
 {
 	wpa_printf(MSG_DEBUG, "TDLS: Remove peers on disassociation");
 	wpa_tdls_remove_peers(sm);
+	sm->tdls_num_monitor = 0;
 }
 
 
@@ -3276,10 +3471,7 @@ int wpa_tdls_enable_chan_switch(struct wpa_sm *sm, const u8 *addr,
 		return -1;
 	}
 
-	for (peer = sm->tdls; peer; peer = peer->next) {
-		if (ether_addr_equal(peer->addr, addr))
-			break;
-	}
+	peer = wpa_tdls_get_peer(sm, addr);
 
 	if (peer == NULL || !peer->tpk_success) {
 		wpa_printf(MSG_ERROR, "TDLS: Peer " MACSTR
@@ -3310,10 +3502,7 @@ int wpa_tdls_disable_chan_switch(struct wpa_sm *sm, const u8 *addr)
 	if (sm->tdls_disabled || !sm->tdls_supported)
 		return -1;
 
-	for (peer = sm->tdls; peer; peer = peer->next) {
-		if (ether_addr_equal(peer->addr, addr))
-			break;
-	}
+	peer = wpa_tdls_get_peer(sm, addr);
 
 	if (!peer || !peer->chan_switch_enabled) {
 		wpa_printf(MSG_ERROR, "TDLS: Channel switching not enabled for "
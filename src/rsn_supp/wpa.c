@@ -4251,6 +4251,8 @@ static void wpa_sm_pmksa_free_cb(struct rsn_pmksa_cache_entry *entry,
 	wpa_dbg(sm->ctx->msg_ctx, MSG_DEBUG, "RSN: PMKSA cache entry free_cb: "
 		MACSTR " reason=%d", MAC2STR(entry->aa), reason);
 
+	wpa_sm_notify_pmksa_cache_entry_removed(sm, entry);
+
 	if (sm->cur_pmksa == entry) {
 		wpa_dbg(sm->ctx->msg_ctx, MSG_DEBUG,
 			"RSN: %s current PMKSA entry",
@@ -20,6 +20,7 @@ struct wpa_config_blob;
 struct hostapd_freq_params;
 struct wpa_channel_info;
 struct rsn_pmksa_cache_entry;
+struct hostap_sta_driver_data;
 enum frame_encryption;
 
 struct wpa_sm_ctx {
@@ -86,6 +87,8 @@ struct wpa_sm_ctx {
 		void *ctx, const u8 *addr, u8 oper_class,
 		const struct hostapd_freq_params *params);
 	int (*tdls_disable_channel_switch)(void *ctx, const u8 *addr);
+	int (*tdls_read_sta_data)(void *ctx, const u8 *addr,
+				  struct hostap_sta_driver_data *data);
 #endif /* CONFIG_TDLS */
 	void (*set_rekey_offload)(void *ctx, const u8 *kek, size_t kek_len,
 				  const u8 *kck, size_t kck_len,
@@ -104,6 +107,8 @@ struct wpa_sm_ctx {
 #endif /* CONFIG_PASN */
 	void (*notify_pmksa_cache_entry)(void *ctx,
 					 struct rsn_pmksa_cache_entry *entry);
+	void (*notify_pmksa_cache_entry_removed)(
+		void *ctx, struct rsn_pmksa_cache_entry *entry);
 	void (*ssid_verified)(void *ctx);
 };
 
@@ -539,6 +544,7 @@ int wpa_ft_validate_reassoc_resp(struct wpa_sm *sm, const u8 *ies,
 				 size_t ies_len, const u8 *src_addr);
 int wpa_ft_start_over_ds(struct wpa_sm *sm, const u8 *target_ap,
 			 const u8 *mdie, bool force);
+void wpa_ft_stop_over_ds(struct wpa_sm *sm);
 #if defined(CONFIG_DRIVER_NL80211_BRCM) || defined(CONFIG_DRIVER_NL80211_SYNA)
 int wpa_ft_is_ft_protocol(struct wpa_sm *sm);
 #endif /* CONFIG_DRIVER_NL80211_BRCM || CONFIG_DRIVER_NL80211_SYNA */
@@ -629,6 +635,8 @@ int wpa_tdls_init(struct wpa_sm *sm);
 void wpa_tdls_teardown_peers(struct wpa_sm *sm);
 void wpa_tdls_deinit(struct wpa_sm *sm);
 void wpa_tdls_enable(struct wpa_sm *sm, int enabled);
+void wpa_tdls_set_monitor(struct wpa_sm *sm, unsigned int interval,
+			  unsigned int links);
 void wpa_tdls_disable_unreachable_link(struct wpa_sm *sm, const u8 *addr);
 const char * wpa_tdls_get_link_status(struct wpa_sm *sm, const u8 *addr);
 int wpa_tdls_is_external_setup(struct wpa_sm *sm);
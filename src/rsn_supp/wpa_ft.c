@@ -1340,6 +1340,19 @@ int wpa_ft_start_over_ds(struct wpa_sm *sm, const u8 *target_ap,
 }
 
 
+/**
+ * wpa_ft_stop_over_ds - Stop waiting for an over-the-DS response
+ * @sm: Pointer to WPA state machine data from wpa_sm_init()
+ *
+ * This is used when the requester gives up on an over-the-DS exchange started
+ * with wpa_ft_start_over_ds() so that a late FT Action Response is dropped.
+ */
+void wpa_ft_stop_over_ds(struct wpa_sm *sm)
+{
+	sm->over_the_ds_in_progress = 0;
+}
+
+
 #ifdef CONFIG_PASN
 
 static struct pasn_ft_r1kh * wpa_ft_pasn_get_r1kh(struct wpa_sm *sm,
@@ -14,6 +14,18 @@
 struct wpa_tdls_peer;
 struct wpa_eapol_key;
 
+#define TDLS_PEER_HASH_SIZE 16
+#define TDLS_PEER_HASH(a) ((a)[5] & (TDLS_PEER_HASH_SIZE - 1))
+
+#define TDLS_MONITOR_MAX_LINKS 16
+
+/* Peer with a high traffic rate for which the TDLS link is maintained */
+struct wpa_tdls_monitor_peer {
+	u8 addr[ETH_ALEN];
+	u64 rate; /* octets per second over the last monitor interval */
+	unsigned int attempts; /* setup attempts since the link was lost */
+};
+
 struct pasn_ft_r1kh {
 	u8 bssid[ETH_ALEN];
 	u8 r1kh_id[FT_R1KH_ID_LEN];
@@ -127,6 +139,7 @@ struct wpa_sm {
 
 #ifdef CONFIG_TDLS
 	struct wpa_tdls_peer *tdls;
+	struct wpa_tdls_peer *tdls_hash[TDLS_PEER_HASH_SIZE];
 	int tdls_prohibited;
 	int tdls_chan_switch_prohibited;
 	int tdls_disabled;
@@ -142,6 +155,12 @@ struct wpa_sm {
 
 	/* The driver supports TDLS channel switching */
 	int tdls_chan_switch;
+
+	/* Link quality monitor; interval in seconds, 0 = disabled */
+	unsigned int tdls_monitor_interval;
+	unsigned int tdls_monitor_links;
+	struct wpa_tdls_monitor_peer tdls_monitor[TDLS_MONITOR_MAX_LINKS];
+	unsigned int tdls_num_monitor;
 #endif /* CONFIG_TDLS */
 
 #ifdef CONFIG_IEEE80211R
@@ -464,6 +483,15 @@ wpa_sm_tdls_disable_channel_switch(struct wpa_sm *sm, const u8 *addr)
 		return sm->ctx->tdls_disable_channel_switch(sm->ctx->ctx, addr);
 	return -1;
 }
+
+static inline int
+wpa_sm_tdls_read_sta_data(struct wpa_sm *sm, const u8 *addr,
+			  struct hostap_sta_driver_data *data)
+{
+	if (sm->ctx->tdls_read_sta_data)
+		return sm->ctx->tdls_read_sta_data(sm->ctx->ctx, addr, data);
+	return -1;
+}
 #endif /* CONFIG_TDLS */
 
 static inline int wpa_sm_key_mgmt_set_pmk(struct wpa_sm *sm,
@@ -525,6 +553,14 @@ wpa_sm_notify_pmksa_cache_entry(struct wpa_sm *sm,
 		sm->ctx->notify_pmksa_cache_entry(sm->ctx->ctx, entry);
 }
 
+static inline void
+wpa_sm_notify_pmksa_cache_entry_removed(struct wpa_sm *sm,
+					struct rsn_pmksa_cache_entry *entry)
+{
+	if (sm->ctx->notify_pmksa_cache_entry_removed)
+		sm->ctx->notify_pmksa_cache_entry_removed(sm->ctx->ctx, entry);
+}
+
 static inline void wpa_sm_ssid_verified(struct wpa_sm *sm)
 {
 	if (sm->ctx->ssid_verified)
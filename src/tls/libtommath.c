@@ -61,7 +61,9 @@
 
 #define  OPT_CAST(x)
 
-#ifdef __x86_64__
+#if defined(__x86_64__) || (defined(__LP64__) && defined(__SIZEOF_INT128__))
+/* 60-bit digits with a 128-bit word on 64-bit targets, e.g., x86-64 and
+ * AArch64, need less than half the digit operations of 28-bit digits */
 typedef unsigned long mp_digit;
 typedef unsigned long mp_word __attribute__((mode(TI)));
 
@@ -99,8 +101,12 @@ typedef u64 mp_word;
 
 typedef int           mp_err;
 
-/* define this to use lower memory usage routines (exptmods mostly) */
+/* define this to use lower memory usage routines (exptmods mostly); LTM_FAST
+ * uses the larger exptmod windows and default precision instead at the cost of
+ * about 6 kB of stack in exptmod */
+#ifndef LTM_FAST
 #define MP_LOW_MEM
+#endif /* LTM_FAST */
 
 /* default precision */
 #ifndef MP_PREC
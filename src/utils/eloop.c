@@ -11,7 +11,6 @@
 
 #include "common.h"
 #include "trace.h"
-#include "list.h"
 #include "eloop.h"
 
 #if defined(CONFIG_ELOOP_POLL) && defined(CONFIG_ELOOP_EPOLL)
@@ -22,8 +21,14 @@
 #error Do not define both of poll and kqueue
 #endif
 
+#if defined(CONFIG_ELOOP_IO_URING) && \
+	(defined(CONFIG_ELOOP_POLL) || defined(CONFIG_ELOOP_EPOLL) || \
+	 defined(CONFIG_ELOOP_KQUEUE))
+#error Do not define io_uring together with poll, epoll, or kqueue
+#endif
+
 #if !defined(CONFIG_ELOOP_POLL) && !defined(CONFIG_ELOOP_EPOLL) && \
-    !defined(CONFIG_ELOOP_KQUEUE)
+    !defined(CONFIG_ELOOP_KQUEUE) && !defined(CONFIG_ELOOP_IO_URING)
 #define CONFIG_ELOOP_SELECT
 #endif
 
@@ -39,19 +44,33 @@
 #include <sys/event.h>
 #endif /* CONFIG_ELOOP_KQUEUE */
 
+#ifdef CONFIG_ELOOP_IO_URING
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+
+#define ELOOP_URING_ENTRIES 256
+#endif /* CONFIG_ELOOP_IO_URING */
+
 struct eloop_sock {
 	int sock;
 	void *eloop_data;
 	void *user_data;
 	eloop_sock_handler handler;
+#ifdef CONFIG_ELOOP_IO_URING
+	unsigned int uring_gen; /* registration generation; 0 = unused */
+#endif /* CONFIG_ELOOP_IO_URING */
 	WPA_TRACE_REF(eloop);
 	WPA_TRACE_REF(user);
 	WPA_TRACE_INFO
 };
 
 struct eloop_timeout {
-	struct dl_list list;
 	struct os_reltime time;
+	unsigned int seq; /* registration order for equal expiration times */
+	size_t heap_idx; /* position in eloop->timeouts */
+	struct eloop_timeout *hash_next; /* (handler, ctx) hash chain */
 	void *eloop_data;
 	void *user_data;
 	eloop_timeout_handler handler;
@@ -67,6 +86,34 @@ struct eloop_signal {
 	int signaled;
 };
 
+enum eloop_stats_type {
+	ELOOP_STATS_SOCK,
+	ELOOP_STATS_TIMEOUT,
+};
+
+struct eloop_handler_stats {
+	void (*func)(void); /* handler function or %NULL for an unused slot */
+	enum eloop_stats_type type;
+	unsigned int count;
+	unsigned int max_usec;
+	u64 total_usec;
+};
+
+struct eloop_stats {
+	struct os_reltime start;
+	unsigned int slow_usec; /* log handlers running longer; 0 = disabled */
+	unsigned int slow_count;
+	/* Lateness of the timeouts compared to their expiration time */
+	unsigned int lag_count;
+	unsigned int lag_max_usec;
+	u64 lag_total_usec;
+	/* Open addressing hash table of the handlers indexed by the function
+	 * address */
+	struct eloop_handler_stats *handlers;
+	size_t handler_count;
+	size_t handler_size; /* power of two */
+};
+
 struct eloop_sock_table {
 	size_t count;
 	struct eloop_sock *table;
@@ -74,7 +121,15 @@ struct eloop_sock_table {
 	int changed;
 };
 
-struct eloop_data {
+#ifdef CONFIG_ELOOP_IO_URING
+struct eloop_uring_event {
+	int sock;
+	eloop_event_type type;
+	unsigned int gen;
+};
+#endif /* CONFIG_ELOOP_IO_URING */
+
+struct eloop_ctx {
 	int max_sock;
 
 	size_t count; /* sum of all table counts */
@@ -84,10 +139,11 @@ struct eloop_data {
 	struct pollfd *pollfds;
 	struct pollfd **pollfds_map;
 #endif /* CONFIG_ELOOP_POLL */
-#if defined(CONFIG_ELOOP_EPOLL) || defined(CONFIG_ELOOP_KQUEUE)
+#if defined(CONFIG_ELOOP_EPOLL) || defined(CONFIG_ELOOP_KQUEUE) || \
+	defined(CONFIG_ELOOP_IO_URING)
 	int max_fd;
 	struct eloop_sock *fd_table;
-#endif /* CONFIG_ELOOP_EPOLL || CONFIG_ELOOP_KQUEUE */
+#endif /* CONFIG_ELOOP_EPOLL || CONFIG_ELOOP_KQUEUE || CONFIG_ELOOP_IO_URING */
 #ifdef CONFIG_ELOOP_EPOLL
 	int epollfd;
 	size_t epoll_max_event_num;
@@ -98,11 +154,44 @@ struct eloop_data {
 	size_t kqueue_nevents;
 	struct kevent *kqueue_events;
 #endif /* CONFIG_ELOOP_KQUEUE */
+#ifdef CONFIG_ELOOP_IO_URING
+	int uring_fd;
+	void *uring_sq_ring;
+	size_t uring_sq_ring_len;
+	void *uring_cq_ring;
+	size_t uring_cq_ring_len;
+	struct io_uring_sqe *uring_sqes;
+	size_t uring_sqes_len;
+	unsigned int *uring_sq_tail;
+	unsigned int *uring_sq_head;
+	unsigned int uring_sq_mask;
+	unsigned int uring_sq_entries;
+	unsigned int *uring_sq_array;
+	unsigned int *uring_cq_head;
+	unsigned int *uring_cq_tail;
+	unsigned int uring_cq_mask;
+	struct io_uring_cqe *uring_cqes;
+	unsigned int uring_to_submit;
+	unsigned int uring_gen;
+	size_t uring_max_events;
+	struct eloop_uring_event *uring_events;
+#endif /* CONFIG_ELOOP_IO_URING */
 	struct eloop_sock_table readers;
 	struct eloop_sock_table writers;
 	struct eloop_sock_table exceptions;
 
-	struct dl_list timeout;
+	/*
+	 * Registered timeouts are kept in a binary min-heap ordered by
+	 * expiration time (and registration order for equal times) and are
+	 * also indexed by a hash of (handler, eloop_data, user_data) to allow
+	 * cancel and lookup operations without walking all timeouts.
+	 */
+	struct eloop_timeout **timeouts;
+	size_t timeout_count;
+	size_t timeout_alloc;
+	unsigned int timeout_seq;
+	struct eloop_timeout **timeout_hash;
+	size_t timeout_hash_size; /* power of two */
 
 	size_t signal_count;
 	struct eloop_signal *signals;
@@ -110,9 +199,11 @@ struct eloop_data {
 	int pending_terminate;
 
 	int terminate;
+
+	struct eloop_stats *stats; /* %NULL if statistics are not collected */
 };
 
-static struct eloop_data eloop;
+static struct eloop_ctx eloop_default;
 
 
 #ifdef WPA_TRACE
@@ -160,31 +251,194 @@ static void eloop_trace_sock_remove_ref(struct eloop_sock_table *table)
 #endif /* WPA_TRACE */
 
 
-int eloop_init(void)
+#ifdef CONFIG_ELOOP_IO_URING
+static int eloop_uring_init(struct eloop_ctx *eloop);
+static void eloop_uring_deinit(struct eloop_ctx *eloop);
+#endif /* CONFIG_ELOOP_IO_URING */
+
+
+static unsigned int eloop_usec_since(struct os_reltime *start,
+				     struct os_reltime *now)
+{
+	struct os_reltime diff;
+
+	if (os_reltime_before(now, start))
+		return 0;
+	os_reltime_sub(now, start, &diff);
+	if (diff.sec >= 4000)
+		return (unsigned int) -1;
+	return diff.sec * 1000000 + diff.usec;
+}
+
+
+static size_t eloop_stats_hash(void (*func)(void), enum eloop_stats_type type,
+			       size_t size)
+{
+	uintptr_t val = (uintptr_t) func ^ type;
+
+	/* Fibonacci hashing of the function address */
+	return (size_t) ((val * 0x9e3779b97f4a7c15ULL) >> 32) & (size - 1);
+}
+
+
+static struct eloop_handler_stats *
+eloop_stats_get_handler(struct eloop_stats *stats, void (*func)(void),
+			enum eloop_stats_type type)
+{
+	struct eloop_handler_stats *h;
+	size_t i;
+
+	if (stats->handler_count >= stats->handler_size / 2) {
+		struct eloop_handler_stats *n, *old = stats->handlers;
+		size_t j, size = stats->handler_size ? 2 * stats->handler_size :
+			64;
+
+		n = os_calloc(size, sizeof(*n));
+		if (!n)
+			return NULL;
+		for (j = 0; j < stats->handler_size; j++) {
+			if (!old[j].func)
+				continue;
+			i = eloop_stats_hash(old[j].func, old[j].type, size);
+			while (n[i].func)
+				i = (i + 1) & (size - 1);
+			n[i] = old[j];
+		}
+		os_free(old);
+		stats->handlers = n;
+		stats->handler_size = size;
+	}
+
+	i = eloop_stats_hash(func, type, stats->handler_size);
+	for (;;) {
+		h = &stats->handlers[i];
+		if (!h->func) {
+			h->func = func;
+			h->type = type;
+			stats->handler_count++;
+			return h;
+		}
+		if (h->func == func && h->type == type)
+			return h;
+		i = (i + 1) & (stats->handler_size - 1);
+	}
+}
+
+
+static void eloop_stats_record(struct eloop_ctx *eloop, void (*func)(void),
+			       enum eloop_stats_type type,
+			       struct os_reltime *start)
+{
+	struct eloop_stats *stats = eloop->stats;
+	struct eloop_handler_stats *h;
+	struct os_reltime now;
+	unsigned int usec;
+
+	if (!stats)
+		return; /* disabled by the handler */
+
+	os_get_reltime(&now);
+	usec = eloop_usec_since(start, &now);
+	h = eloop_stats_get_handler(stats, func, type);
+	if (h) {
+		h->count++;
+		h->total_usec += usec;
+		if (usec > h->max_usec)
+			h->max_usec = usec;
+	}
+
+	if (stats->slow_usec && usec >= stats->slow_usec) {
+		stats->slow_count++;
+		wpa_printf(MSG_INFO, "ELOOP: Slow %s handler %p: %u usec",
+			   type == ELOOP_STATS_SOCK ? "socket" : "timeout",
+			   func, usec);
+		wpa_trace_dump_funcname("eloop slow handler", func);
+	}
+}
+
+
+static void eloop_sock_call(struct eloop_ctx *eloop, struct eloop_sock *table)
+{
+	eloop_sock_handler handler = table->handler;
+	struct os_reltime start;
+
+	if (!eloop->stats) {
+		handler(table->sock, table->eloop_data, table->user_data);
+		return;
+	}
+
+	/* The handler may modify the socket table, so do not access the entry
+	 * after the call */
+	os_get_reltime(&start);
+	handler(table->sock, table->eloop_data, table->user_data);
+	eloop_stats_record(eloop, (void (*)(void)) handler, ELOOP_STATS_SOCK,
+			   &start);
+}
+
+
+static void eloop_timeout_call(struct eloop_ctx *eloop,
+			       eloop_timeout_handler handler,
+			       void *eloop_data, void *user_data,
+			       struct os_reltime *expire)
+{
+	struct eloop_stats *stats = eloop->stats;
+	struct os_reltime start;
+	unsigned int lag;
+
+	if (!stats) {
+		handler(eloop_data, user_data);
+		return;
+	}
+
+	os_get_reltime(&start);
+	lag = eloop_usec_since(expire, &start);
+	stats->lag_count++;
+	stats->lag_total_usec += lag;
+	if (lag > stats->lag_max_usec)
+		stats->lag_max_usec = lag;
+	handler(eloop_data, user_data);
+	eloop_stats_record(eloop, (void (*)(void)) handler,
+			   ELOOP_STATS_TIMEOUT, &start);
+}
+
+
+static int eloop_ctx_init(struct eloop_ctx *eloop)
 {
-	os_memset(&eloop, 0, sizeof(eloop));
-	dl_list_init(&eloop.timeout);
+	os_memset(eloop, 0, sizeof(*eloop));
 #ifdef CONFIG_ELOOP_EPOLL
-	eloop.epollfd = epoll_create1(0);
-	if (eloop.epollfd < 0) {
+	eloop->epollfd = epoll_create1(0);
+	if (eloop->epollfd < 0) {
 		wpa_printf(MSG_ERROR, "%s: epoll_create1 failed. %s",
 			   __func__, strerror(errno));
 		return -1;
 	}
 #endif /* CONFIG_ELOOP_EPOLL */
 #ifdef CONFIG_ELOOP_KQUEUE
-	eloop.kqueuefd = kqueue();
-	if (eloop.kqueuefd < 0) {
+	eloop->kqueuefd = kqueue();
+	if (eloop->kqueuefd < 0) {
 		wpa_printf(MSG_ERROR, "%s: kqueue failed: %s",
 			   __func__, strerror(errno));
 		return -1;
 	}
 #endif /* CONFIG_ELOOP_KQUEUE */
-#if defined(CONFIG_ELOOP_EPOLL) || defined(CONFIG_ELOOP_KQUEUE)
-	eloop.readers.type = EVENT_TYPE_READ;
-	eloop.writers.type = EVENT_TYPE_WRITE;
-	eloop.exceptions.type = EVENT_TYPE_EXCEPTION;
-#endif /* CONFIG_ELOOP_EPOLL || CONFIG_ELOOP_KQUEUE */
+#ifdef CONFIG_ELOOP_IO_URING
+	if (eloop_uring_init(eloop) < 0)
+		return -1;
+#endif /* CONFIG_ELOOP_IO_URING */
+#if defined(CONFIG_ELOOP_EPOLL) || defined(CONFIG_ELOOP_KQUEUE) || \
+	defined(CONFIG_ELOOP_IO_URING)
+	eloop->readers.type = EVENT_TYPE_READ;
+	eloop->writers.type = EVENT_TYPE_WRITE;
+	eloop->exceptions.type = EVENT_TYPE_EXCEPTION;
+#endif /* CONFIG_ELOOP_EPOLL || CONFIG_ELOOP_KQUEUE || CONFIG_ELOOP_IO_URING */
+	return 0;
+}
+
+
+int eloop_init(void)
+{
+	if (eloop_ctx_init(&eloop_default) < 0)
+		return -1;
 #ifdef WPA_TRACE
 	signal(SIGSEGV, eloop_sigsegv_handler);
 #endif /* WPA_TRACE */
@@ -192,8 +446,24 @@ int eloop_init(void)
 }
 
 
+struct eloop_ctx * eloop_ctx_new(void)
+{
+	struct eloop_ctx *eloop;
+
+	eloop = os_malloc(sizeof(*eloop));
+	if (!eloop)
+		return NULL;
+	if (eloop_ctx_init(eloop) < 0) {
+		os_free(eloop);
+		return NULL;
+	}
+	return eloop;
+}
+
+
 #ifdef CONFIG_ELOOP_EPOLL
-static int eloop_sock_queue(int sock, eloop_event_type type)
+static int eloop_sock_queue(struct eloop_ctx *eloop, int sock,
+			    eloop_event_type type)
 {
 	struct epoll_event ev;
 
@@ -215,7 +485,7 @@ static int eloop_sock_queue(int sock, eloop_event_type type)
 		break;
 	}
 	ev.data.fd = sock;
-	if (epoll_ctl(eloop.epollfd, EPOLL_CTL_ADD, sock, &ev) < 0) {
+	if (epoll_ctl(eloop->epollfd, EPOLL_CTL_ADD, sock, &ev) < 0) {
 		wpa_printf(MSG_ERROR, "%s: epoll_ctl(ADD) for fd=%d failed: %s",
 			   __func__, sock, strerror(errno));
 		return -1;
@@ -225,6 +495,327 @@ static int eloop_sock_queue(int sock, eloop_event_type type)
 #endif /* CONFIG_ELOOP_EPOLL */
 
 
+#ifdef CONFIG_ELOOP_IO_URING
+
+/*
+ * The io_uring backend uses one-shot IORING_OP_POLL_ADD requests that are
+ * re-armed after each dispatch to keep the level-triggered semantics that
+ * the socket handlers expect. New and re-armed requests are queued into the
+ * submission ring and submitted together with the wait for completions, so
+ * each loop iteration needs only a single io_uring_enter() call.
+ *
+ * The user_data of a request encodes the registration generation, the event
+ * type, and the socket. Completions from stale registrations (a socket that
+ * was unregistered and possibly replaced using the same fd) do not match the
+ * current generation and are ignored. user_data 0 is used for cancellation
+ * requests whose completions are always ignored.
+ */
+
+#define ELOOP_URING_DATA(gen, type, sock) \
+	(((__u64) (gen) << 32) | ((__u64) (type) << 30) | \
+	 ((__u64) (sock) & 0x3fffffff))
+#define ELOOP_URING_GEN(data) ((unsigned int) ((data) >> 32))
+#define ELOOP_URING_TYPE(data) \
+	((eloop_event_type) (((data) >> 30) & 0x3))
+#define ELOOP_URING_SOCK(data) ((int) ((data) & 0x3fffffff))
+
+static int eloop_uring_enter(struct eloop_ctx *eloop, unsigned int to_submit,
+			     unsigned int min_complete, unsigned int flags,
+			     void *arg, size_t argsz)
+{
+	return syscall(__NR_io_uring_enter, eloop->uring_fd, to_submit,
+		       min_complete, flags, arg, argsz);
+}
+
+
+static int eloop_uring_init(struct eloop_ctx *eloop)
+{
+	struct io_uring_params p;
+	int fd;
+
+	os_memset(&p, 0, sizeof(p));
+	eloop->uring_fd = -1;
+	fd = syscall(__NR_io_uring_setup, ELOOP_URING_ENTRIES, &p);
+	if (fd < 0) {
+		wpa_printf(MSG_ERROR, "%s: io_uring_setup failed: %s",
+			   __func__, strerror(errno));
+		return -1;
+	}
+	eloop->uring_fd = fd;
+
+	if (!(p.features & IORING_FEAT_EXT_ARG)) {
+		wpa_printf(MSG_ERROR,
+			   "%s: io_uring does not support IORING_FEAT_EXT_ARG",
+			   __func__);
+		goto fail;
+	}
+
+	eloop->uring_sq_ring_len = p.sq_off.array +
+		p.sq_entries * sizeof(unsigned int);
+	eloop->uring_cq_ring_len = p.cq_off.cqes +
+		p.cq_entries * sizeof(struct io_uring_cqe);
+	eloop->uring_sqes_len = p.sq_entries * sizeof(struct io_uring_sqe);
+
+	eloop->uring_sq_ring = mmap(NULL, eloop->uring_sq_ring_len,
+				   PROT_READ | PROT_WRITE,
+				   MAP_SHARED | MAP_POPULATE, fd,
+				   IORING_OFF_SQ_RING);
+	if (eloop->uring_sq_ring == MAP_FAILED) {
+		eloop->uring_sq_ring = NULL;
+		goto fail_mmap;
+	}
+	eloop->uring_cq_ring = mmap(NULL, eloop->uring_cq_ring_len,
+				   PROT_READ | PROT_WRITE,
+				   MAP_SHARED | MAP_POPULATE, fd,
+				   IORING_OFF_CQ_RING);
+	if (eloop->uring_cq_ring == MAP_FAILED) {
+		eloop->uring_cq_ring = NULL;
+		goto fail_mmap;
+	}
+	eloop->uring_sqes = mmap(NULL, eloop->uring_sqes_len,
+				PROT_READ | PROT_WRITE,
+				MAP_SHARED | MAP_POPULATE, fd,
+				IORING_OFF_SQES);
+	if (eloop->uring_sqes == MAP_FAILED) {
+		eloop->uring_sqes = NULL;
+		goto fail_mmap;
+	}
+
+	eloop->uring_sq_head = (unsigned int *)
+		((u8 *) eloop->uring_sq_ring + p.sq_off.head);
+	eloop->uring_sq_tail = (unsigned int *)
+		((u8 *) eloop->uring_sq_ring + p.sq_off.tail);
+	eloop->uring_sq_mask = *(unsigned int *)
+		((u8 *) eloop->uring_sq_ring + p.sq_off.ring_mask);
+	eloop->uring_sq_array = (unsigned int *)
+		((u8 *) eloop->uring_sq_ring + p.sq_off.array);
+	eloop->uring_sq_entries = p.sq_entries;
+	eloop->uring_cq_head = (unsigned int *)
+		((u8 *) eloop->uring_cq_ring + p.cq_off.head);
+	eloop->uring_cq_tail = (unsigned int *)
+		((u8 *) eloop->uring_cq_ring + p.cq_off.tail);
+	eloop->uring_cq_mask = *(unsigned int *)
+		((u8 *) eloop->uring_cq_ring + p.cq_off.ring_mask);
+	eloop->uring_cqes = (struct io_uring_cqe *)
+		((u8 *) eloop->uring_cq_ring + p.cq_off.cqes);
+
+	return 0;
+
+fail_mmap:
+	wpa_printf(MSG_ERROR, "%s: io_uring mmap failed: %s",
+		   __func__, strerror(errno));
+fail:
+	eloop_uring_deinit(eloop);
+	return -1;
+}
+
+
+static void eloop_uring_deinit(struct eloop_ctx *eloop)
+{
+	if (eloop->uring_sqes)
+		munmap(eloop->uring_sqes, eloop->uring_sqes_len);
+	if (eloop->uring_cq_ring)
+		munmap(eloop->uring_cq_ring, eloop->uring_cq_ring_len);
+	if (eloop->uring_sq_ring)
+		munmap(eloop->uring_sq_ring, eloop->uring_sq_ring_len);
+	eloop->uring_sqes = NULL;
+	eloop->uring_cq_ring = NULL;
+	eloop->uring_sq_ring = NULL;
+	if (eloop->uring_fd >= 0)
+		close(eloop->uring_fd);
+	eloop->uring_fd = -1;
+	os_free(eloop->uring_events);
+	eloop->uring_events = NULL;
+	eloop->uring_max_events = 0;
+}
+
+
+static int eloop_uring_submit(struct eloop_ctx *eloop)
+{
+	int res;
+
+	while (eloop->uring_to_submit) {
+		res = eloop_uring_enter(eloop, eloop->uring_to_submit, 0, 0,
+					NULL, 0);
+		if (res < 0) {
+			if (errno == EINTR)
+				continue;
+			wpa_printf(MSG_ERROR, "%s: io_uring_enter failed: %s",
+				   __func__, strerror(errno));
+			return -1;
+		}
+		eloop->uring_to_submit = *eloop->uring_sq_tail -
+			__atomic_load_n(eloop->uring_sq_head, __ATOMIC_ACQUIRE);
+	}
+
+	return 0;
+}
+
+
+static struct io_uring_sqe * eloop_uring_get_sqe(struct eloop_ctx *eloop)
+{
+	unsigned int head, tail, idx;
+	struct io_uring_sqe *sqe;
+
+	tail = *eloop->uring_sq_tail;
+	head = __atomic_load_n(eloop->uring_sq_head, __ATOMIC_ACQUIRE);
+	if (tail - head >= eloop->uring_sq_entries) {
+		/* Submission ring is full; flush it to the kernel first */
+		if (eloop_uring_submit(eloop) < 0)
+			return NULL;
+		head = __atomic_load_n(eloop->uring_sq_head, __ATOMIC_ACQUIRE);
+		if (tail - head >= eloop->uring_sq_entries)
+			return NULL;
+	}
+
+	idx = tail & eloop->uring_sq_mask;
+	sqe = &eloop->uring_sqes[idx];
+	os_memset(sqe, 0, sizeof(*sqe));
+	eloop->uring_sq_array[idx] = idx;
+	return sqe;
+}
+
+
+static void eloop_uring_commit_sqe(struct eloop_ctx *eloop)
+{
+	__atomic_store_n(eloop->uring_sq_tail, *eloop->uring_sq_tail + 1,
+			 __ATOMIC_RELEASE);
+	eloop->uring_to_submit++;
+}
+
+
+static int eloop_uring_poll_add(struct eloop_ctx *eloop, int sock,
+				eloop_event_type type, unsigned int gen)
+{
+	struct io_uring_sqe *sqe;
+
+	sqe = eloop_uring_get_sqe(eloop);
+	if (!sqe) {
+		wpa_printf(MSG_ERROR, "%s: no io_uring SQE for fd=%d",
+			   __func__, sock);
+		return -1;
+	}
+
+	sqe->opcode = IORING_OP_POLL_ADD;
+	sqe->fd = sock;
+	switch (type) {
+	case EVENT_TYPE_READ:
+		sqe->poll32_events = POLLIN;
+		break;
+	case EVENT_TYPE_WRITE:
+		sqe->poll32_events = POLLOUT;
+		break;
+	case EVENT_TYPE_EXCEPTION:
+		sqe->poll32_events = POLLERR | POLLHUP;
+		break;
+	}
+	sqe->user_data = ELOOP_URING_DATA(gen, type, sock);
+	eloop_uring_commit_sqe(eloop);
+	return 0;
+}
+
+
+static void eloop_uring_poll_remove(struct eloop_ctx *eloop, int sock,
+				    eloop_event_type type, unsigned int gen)
+{
+	struct io_uring_sqe *sqe;
+
+	sqe = eloop_uring_get_sqe(eloop);
+	if (!sqe)
+		return; /* stale completion will be ignored based on gen */
+
+	sqe->opcode = IORING_OP_POLL_REMOVE;
+	sqe->fd = -1;
+	sqe->addr = ELOOP_URING_DATA(gen, type, sock);
+	sqe->user_data = 0;
+	eloop_uring_commit_sqe(eloop);
+}
+
+
+static int eloop_uring_wait(struct eloop_ctx *eloop, struct os_reltime *tv)
+{
+	struct io_uring_getevents_arg arg;
+	struct __kernel_timespec ts;
+	unsigned int head, tail;
+	int res, nevents = 0;
+
+	os_memset(&arg, 0, sizeof(arg));
+	if (tv) {
+		ts.tv_sec = tv->sec;
+		ts.tv_nsec = tv->usec * 1000L;
+		arg.ts = (__u64) (uintptr_t) &ts;
+	}
+
+	res = eloop_uring_enter(eloop, eloop->uring_to_submit, 1,
+				IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG,
+				&arg, sizeof(arg));
+	if (res < 0 && errno != ETIME && errno != EINTR)
+		return -1;
+	eloop->uring_to_submit = *eloop->uring_sq_tail -
+		__atomic_load_n(eloop->uring_sq_head, __ATOMIC_ACQUIRE);
+
+	head = *eloop->uring_cq_head;
+	tail = __atomic_load_n(eloop->uring_cq_tail, __ATOMIC_ACQUIRE);
+	while (head != tail) {
+		struct io_uring_cqe *cqe;
+		struct eloop_uring_event *ev;
+		__u64 data;
+
+		cqe = &eloop->uring_cqes[head & eloop->uring_cq_mask];
+		data = cqe->user_data;
+		head++;
+
+		if (!ELOOP_URING_GEN(data))
+			continue; /* poll remove */
+		if (cqe->res < 0) {
+			if (cqe->res != -ECANCELED)
+				wpa_printf(MSG_DEBUG,
+					   "eloop: io_uring poll for fd=%d failed: %s",
+					   ELOOP_URING_SOCK(data),
+					   strerror(-cqe->res));
+			continue;
+		}
+
+		if ((size_t) nevents >= eloop->uring_max_events) {
+			size_t next;
+
+			next = eloop->uring_max_events ?
+				eloop->uring_max_events * 2 : 16;
+			ev = os_realloc_array(eloop->uring_events, next,
+					      sizeof(*ev));
+			if (!ev)
+				break;
+			eloop->uring_events = ev;
+			eloop->uring_max_events = next;
+		}
+		ev = &eloop->uring_events[nevents++];
+		ev->sock = ELOOP_URING_SOCK(data);
+		ev->type = ELOOP_URING_TYPE(data);
+		ev->gen = ELOOP_URING_GEN(data);
+	}
+	__atomic_store_n(eloop->uring_cq_head, head, __ATOMIC_RELEASE);
+
+	return nevents;
+}
+
+
+static void eloop_uring_rearm(struct eloop_ctx *eloop,
+			      struct eloop_uring_event *events, int nfds)
+{
+	struct eloop_sock *table;
+	int i;
+
+	for (i = 0; i < nfds; i++) {
+		table = &eloop->fd_table[events[i].sock];
+		if (table->handler && table->uring_gen == events[i].gen)
+			eloop_uring_poll_add(eloop, events[i].sock,
+					     events[i].type, events[i].gen);
+	}
+}
+
+#endif /* CONFIG_ELOOP_IO_URING */
+
+
 #ifdef CONFIG_ELOOP_KQUEUE
 
 static short event_type_kevent_filter(eloop_event_type type)
@@ -240,12 +831,13 @@ static short event_type_kevent_filter(eloop_event_type type)
 }
 
 
-static int eloop_sock_queue(int sock, eloop_event_type type)
+static int eloop_sock_queue(struct eloop_ctx *eloop, int sock,
+			    eloop_event_type type)
 {
 	struct kevent ke;
 
 	EV_SET(&ke, sock, event_type_kevent_filter(type), EV_ADD, 0, 0, 0);
-	if (kevent(eloop.kqueuefd, &ke, 1, NULL, 0, NULL) == -1) {
+	if (kevent(eloop->kqueuefd, &ke, 1, NULL, 0, NULL) == -1) {
 		wpa_printf(MSG_ERROR, "%s: kevent(ADD) for fd=%d failed: %s",
 			   __func__, sock, strerror(errno));
 		return -1;
@@ -256,9 +848,10 @@ static int eloop_sock_queue(int sock, eloop_event_type type)
 #endif /* CONFIG_ELOOP_KQUEUE */
 
 
-static int eloop_sock_table_add_sock(struct eloop_sock_table *table,
-                                     int sock, eloop_sock_handler handler,
-                                     void *eloop_data, void *user_data)
+static int eloop_sock_table_add_sock(struct eloop_ctx *eloop,
+				     struct eloop_sock_table *table, int sock,
+				     eloop_sock_handler handler,
+				     void *eloop_data, void *user_data)
 {
 #ifdef CONFIG_ELOOP_EPOLL
 	struct epoll_event *temp_events;
@@ -266,64 +859,66 @@ static int eloop_sock_table_add_sock(struct eloop_sock_table *table,
 #ifdef CONFIG_ELOOP_KQUEUE
 	struct kevent *temp_events;
 #endif /* CONFIG_ELOOP_EPOLL */
-#if defined(CONFIG_ELOOP_EPOLL) || defined(CONFIG_ELOOP_KQUEUE)
+#if defined(CONFIG_ELOOP_EPOLL) || defined(CONFIG_ELOOP_KQUEUE) || \
+	defined(CONFIG_ELOOP_IO_URING)
 	struct eloop_sock *temp_table;
 	size_t next;
-#endif /* CONFIG_ELOOP_EPOLL || CONFIG_ELOOP_KQUEUE */
+#endif /* CONFIG_ELOOP_EPOLL || CONFIG_ELOOP_KQUEUE || CONFIG_ELOOP_IO_URING */
 	struct eloop_sock *tmp;
 	int new_max_sock;
 
-	if (sock > eloop.max_sock)
+	if (sock > eloop->max_sock)
 		new_max_sock = sock;
 	else
-		new_max_sock = eloop.max_sock;
+		new_max_sock = eloop->max_sock;
 
 	if (table == NULL)
 		return -1;
 
 #ifdef CONFIG_ELOOP_POLL
-	if ((size_t) new_max_sock >= eloop.max_pollfd_map) {
+	if ((size_t) new_max_sock >= eloop->max_pollfd_map) {
 		struct pollfd **nmap;
-		nmap = os_realloc_array(eloop.pollfds_map, new_max_sock + 50,
+		nmap = os_realloc_array(eloop->pollfds_map, new_max_sock + 50,
 					sizeof(struct pollfd *));
 		if (nmap == NULL)
 			return -1;
 
-		eloop.max_pollfd_map = new_max_sock + 50;
-		eloop.pollfds_map = nmap;
+		eloop->max_pollfd_map = new_max_sock + 50;
+		eloop->pollfds_map = nmap;
 	}
 
-	if (eloop.count + 1 > eloop.max_poll_fds) {
+	if (eloop->count + 1 > eloop->max_poll_fds) {
 		struct pollfd *n;
-		size_t nmax = eloop.count + 1 + 50;
+		size_t nmax = eloop->count + 1 + 50;
 
-		n = os_realloc_array(eloop.pollfds, nmax,
+		n = os_realloc_array(eloop->pollfds, nmax,
 				     sizeof(struct pollfd));
 		if (n == NULL)
 			return -1;
 
-		eloop.max_poll_fds = nmax;
-		eloop.pollfds = n;
+		eloop->max_poll_fds = nmax;
+		eloop->pollfds = n;
 	}
 #endif /* CONFIG_ELOOP_POLL */
-#if defined(CONFIG_ELOOP_EPOLL) || defined(CONFIG_ELOOP_KQUEUE)
-	if (new_max_sock >= eloop.max_fd) {
+#if defined(CONFIG_ELOOP_EPOLL) || defined(CONFIG_ELOOP_KQUEUE) || \
+	defined(CONFIG_ELOOP_IO_URING)
+	if (new_max_sock >= eloop->max_fd) {
 		next = new_max_sock + 16;
-		temp_table = os_realloc_array(eloop.fd_table, next,
+		temp_table = os_realloc_array(eloop->fd_table, next,
 					      sizeof(struct eloop_sock));
 		if (temp_table == NULL)
 			return -1;
 
-		eloop.max_fd = next;
-		eloop.fd_table = temp_table;
+		eloop->max_fd = next;
+		eloop->fd_table = temp_table;
 	}
-#endif /* CONFIG_ELOOP_EPOLL || CONFIG_ELOOP_KQUEUE */
+#endif /* CONFIG_ELOOP_EPOLL || CONFIG_ELOOP_KQUEUE || CONFIG_ELOOP_IO_URING */
 
 #ifdef CONFIG_ELOOP_EPOLL
-	if (eloop.count + 1 > eloop.epoll_max_event_num) {
-		next = eloop.epoll_max_event_num == 0 ? 8 :
-			eloop.epoll_max_event_num * 2;
-		temp_events = os_realloc_array(eloop.epoll_events, next,
+	if (eloop->count + 1 > eloop->epoll_max_event_num) {
+		next = eloop->epoll_max_event_num == 0 ? 8 :
+			eloop->epoll_max_event_num * 2;
+		temp_events = os_realloc_array(eloop->epoll_events, next,
 					       sizeof(struct epoll_event));
 		if (temp_events == NULL) {
 			wpa_printf(MSG_ERROR, "%s: malloc for epoll failed: %s",
@@ -331,13 +926,14 @@ static int eloop_sock_table_add_sock(struct eloop_sock_table *table,
 			return -1;
 		}
 
-		eloop.epoll_max_event_num = next;
-		eloop.epoll_events = temp_events;
+		eloop->epoll_max_event_num = next;
+		eloop->epoll_events = temp_events;
 	}
 #endif /* CONFIG_ELOOP_EPOLL */
 #ifdef CONFIG_ELOOP_KQUEUE
-	if (eloop.count + 1 > eloop.kqueue_nevents) {
-		next = eloop.kqueue_nevents == 0 ? 8 : eloop.kqueue_nevents * 2;
+	if (eloop->count + 1 > eloop->kqueue_nevents) {
+		next = eloop->kqueue_nevents == 0 ? 8 :
+			eloop->kqueue_nevents * 2;
 		temp_events = os_malloc(next * sizeof(*temp_events));
 		if (!temp_events) {
 			wpa_printf(MSG_ERROR,
@@ -346,9 +942,9 @@ static int eloop_sock_table_add_sock(struct eloop_sock_table *table,
 			return -1;
 		}
 
-		os_free(eloop.kqueue_events);
-		eloop.kqueue_events = temp_events;
-		eloop.kqueue_nevents = next;
+		os_free(eloop->kqueue_events);
+		eloop->kqueue_events = temp_events;
+		eloop->kqueue_nevents = next;
 	}
 #endif /* CONFIG_ELOOP_KQUEUE */
 
@@ -367,23 +963,34 @@ static int eloop_sock_table_add_sock(struct eloop_sock_table *table,
 	wpa_trace_record(&tmp[table->count]);
 	table->count++;
 	table->table = tmp;
-	eloop.max_sock = new_max_sock;
-	eloop.count++;
+	eloop->max_sock = new_max_sock;
+	eloop->count++;
 	table->changed = 1;
 	eloop_trace_sock_add_ref(table);
 
 #if defined(CONFIG_ELOOP_EPOLL) || defined(CONFIG_ELOOP_KQUEUE)
-	if (eloop_sock_queue(sock, table->type) < 0)
+	if (eloop_sock_queue(eloop, sock, table->type) < 0)
 		return -1;
-	os_memcpy(&eloop.fd_table[sock], &table->table[table->count - 1],
+	os_memcpy(&eloop->fd_table[sock], &table->table[table->count - 1],
 		  sizeof(struct eloop_sock));
 #endif /* CONFIG_ELOOP_EPOLL || CONFIG_ELOOP_KQUEUE */
+#ifdef CONFIG_ELOOP_IO_URING
+	os_memcpy(&eloop->fd_table[sock], &table->table[table->count - 1],
+		  sizeof(struct eloop_sock));
+	if (++eloop->uring_gen == 0)
+		eloop->uring_gen++;
+	eloop->fd_table[sock].uring_gen = eloop->uring_gen;
+	if (eloop_uring_poll_add(eloop, sock, table->type,
+				 eloop->uring_gen) < 0)
+		return -1;
+#endif /* CONFIG_ELOOP_IO_URING */
 	return 0;
 }
 
 
-static void eloop_sock_table_remove_sock(struct eloop_sock_table *table,
-                                         int sock)
+static void eloop_sock_table_remove_sock(struct eloop_ctx *eloop,
+					 struct eloop_sock_table *table,
+					 int sock)
 {
 #ifdef CONFIG_ELOOP_KQUEUE
 	struct kevent ke;
@@ -406,27 +1013,33 @@ static void eloop_sock_table_remove_sock(struct eloop_sock_table *table,
 			   sizeof(struct eloop_sock));
 	}
 	table->count--;
-	eloop.count--;
+	eloop->count--;
 	table->changed = 1;
 	eloop_trace_sock_add_ref(table);
 #ifdef CONFIG_ELOOP_EPOLL
-	if (epoll_ctl(eloop.epollfd, EPOLL_CTL_DEL, sock, NULL) < 0) {
+	if (epoll_ctl(eloop->epollfd, EPOLL_CTL_DEL, sock, NULL) < 0) {
 		wpa_printf(MSG_ERROR, "%s: epoll_ctl(DEL) for fd=%d failed: %s",
 			   __func__, sock, strerror(errno));
 		return;
 	}
-	os_memset(&eloop.fd_table[sock], 0, sizeof(struct eloop_sock));
+	os_memset(&eloop->fd_table[sock], 0, sizeof(struct eloop_sock));
 #endif /* CONFIG_ELOOP_EPOLL */
 #ifdef CONFIG_ELOOP_KQUEUE
 	EV_SET(&ke, sock, event_type_kevent_filter(table->type), EV_DELETE, 0,
 	       0, 0);
-	if (kevent(eloop.kqueuefd, &ke, 1, NULL, 0, NULL) < 0) {
+	if (kevent(eloop->kqueuefd, &ke, 1, NULL, 0, NULL) < 0) {
 		wpa_printf(MSG_ERROR, "%s: kevent(DEL) for fd=%d failed: %s",
 			   __func__, sock, strerror(errno));
 		return;
 	}
-	os_memset(&eloop.fd_table[sock], 0, sizeof(struct eloop_sock));
+	os_memset(&eloop->fd_table[sock], 0, sizeof(struct eloop_sock));
 #endif /* CONFIG_ELOOP_KQUEUE */
+#ifdef CONFIG_ELOOP_IO_URING
+	if (eloop->fd_table[sock].uring_gen)
+		eloop_uring_poll_remove(eloop, sock, table->type,
+					eloop->fd_table[sock].uring_gen);
+	os_memset(&eloop->fd_table[sock], 0, sizeof(struct eloop_sock));
+#endif /* CONFIG_ELOOP_IO_URING */
 }
 
 
@@ -440,7 +1053,8 @@ static struct pollfd * find_pollfd(struct pollfd **pollfds_map, int fd, int mx)
 }
 
 
-static int eloop_sock_table_set_fds(struct eloop_sock_table *readers,
+static int eloop_sock_table_set_fds(struct eloop_ctx *eloop,
+				    struct eloop_sock_table *readers,
 				    struct eloop_sock_table *writers,
 				    struct eloop_sock_table *exceptions,
 				    struct pollfd *pollfds,
@@ -517,7 +1131,8 @@ static int eloop_sock_table_set_fds(struct eloop_sock_table *readers,
 }
 
 
-static int eloop_sock_table_dispatch_table(struct eloop_sock_table *table,
+static int eloop_sock_table_dispatch_table(struct eloop_ctx *eloop,
+					   struct eloop_sock_table *table,
 					   struct pollfd **pollfds_map,
 					   int max_pollfd_map,
 					   short int revents)
@@ -538,9 +1153,7 @@ static int eloop_sock_table_dispatch_table(struct eloop_sock_table *table,
 		if (!(pfd->revents & revents))
 			continue;
 
-		table->table[i].handler(table->table[i].sock,
-					table->table[i].eloop_data,
-					table->table[i].user_data);
+		eloop_sock_call(eloop, &table->table[i]);
 		if (table->changed)
 			return 1;
 	}
@@ -549,22 +1162,23 @@ static int eloop_sock_table_dispatch_table(struct eloop_sock_table *table,
 }
 
 
-static void eloop_sock_table_dispatch(struct eloop_sock_table *readers,
+static void eloop_sock_table_dispatch(struct eloop_ctx *eloop,
+				      struct eloop_sock_table *readers,
 				      struct eloop_sock_table *writers,
 				      struct eloop_sock_table *exceptions,
 				      struct pollfd **pollfds_map,
 				      int max_pollfd_map)
 {
-	if (eloop_sock_table_dispatch_table(readers, pollfds_map,
-					    max_pollfd_map, POLLIN | POLLERR |
-					    POLLHUP))
+	if (eloop_sock_table_dispatch_table(eloop, readers, pollfds_map,
+					    max_pollfd_map,
+					    POLLIN | POLLERR | POLLHUP))
 		return; /* pollfds may be invalid at this point */
 
-	if (eloop_sock_table_dispatch_table(writers, pollfds_map,
+	if (eloop_sock_table_dispatch_table(eloop, writers, pollfds_map,
 					    max_pollfd_map, POLLOUT))
 		return; /* pollfds may be invalid at this point */
 
-	eloop_sock_table_dispatch_table(exceptions, pollfds_map,
+	eloop_sock_table_dispatch_table(eloop, exceptions, pollfds_map,
 					max_pollfd_map, POLLERR | POLLHUP);
 }
 
@@ -572,7 +1186,8 @@ static void eloop_sock_table_dispatch(struct eloop_sock_table *readers,
 
 #ifdef CONFIG_ELOOP_SELECT
 
-static void eloop_sock_table_set_fds(struct eloop_sock_table *table,
+static void eloop_sock_table_set_fds(struct eloop_ctx *eloop,
+				     struct eloop_sock_table *table,
 				     fd_set *fds)
 {
 	size_t i;
@@ -589,7 +1204,8 @@ static void eloop_sock_table_set_fds(struct eloop_sock_table *table,
 }
 
 
-static void eloop_sock_table_dispatch(struct eloop_sock_table *table,
+static void eloop_sock_table_dispatch(struct eloop_ctx *eloop,
+				      struct eloop_sock_table *table,
 				      fd_set *fds)
 {
 	size_t i;
@@ -600,9 +1216,7 @@ static void eloop_sock_table_dispatch(struct eloop_sock_table *table,
 	table->changed = 0;
 	for (i = 0; i < table->count; i++) {
 		if (FD_ISSET(table->table[i].sock, fds)) {
-			table->table[i].handler(table->table[i].sock,
-						table->table[i].eloop_data,
-						table->table[i].user_data);
+			eloop_sock_call(eloop, &table->table[i]);
 			if (table->changed)
 				break;
 		}
@@ -613,55 +1227,87 @@ static void eloop_sock_table_dispatch(struct eloop_sock_table *table,
 
 
 #ifdef CONFIG_ELOOP_EPOLL
-static void eloop_sock_table_dispatch(struct epoll_event *events, int nfds)
+static void eloop_sock_table_dispatch(struct eloop_ctx *eloop,
+				      struct epoll_event *events, int nfds)
 {
 	struct eloop_sock *table;
 	int i;
 
 	for (i = 0; i < nfds; i++) {
-		table = &eloop.fd_table[events[i].data.fd];
+		table = &eloop->fd_table[events[i].data.fd];
 		if (table->handler == NULL)
 			continue;
-		table->handler(table->sock, table->eloop_data,
-			       table->user_data);
-		if (eloop.readers.changed ||
-		    eloop.writers.changed ||
-		    eloop.exceptions.changed)
+		eloop_sock_call(eloop, table);
+		if (eloop->readers.changed ||
+		    eloop->writers.changed ||
+		    eloop->exceptions.changed)
 			break;
 	}
 }
 #endif /* CONFIG_ELOOP_EPOLL */
 
 
+#ifdef CONFIG_ELOOP_IO_URING
+static void eloop_sock_table_dispatch(struct eloop_ctx *eloop,
+				      struct eloop_uring_event *events,
+				      int nfds)
+{
+	struct eloop_sock *table;
+	int i;
+
+	for (i = 0; i < nfds; i++) {
+		table = &eloop->fd_table[events[i].sock];
+		if (table->handler == NULL ||
+		    table->uring_gen != events[i].gen)
+			continue;
+		eloop_sock_call(eloop, table);
+		/* Re-arm the one-shot poll unless the handler unregistered
+		 * (or replaced) the socket */
+		eloop_uring_rearm(eloop, &events[i], 1);
+		if (eloop->readers.changed ||
+		    eloop->writers.changed ||
+		    eloop->exceptions.changed) {
+			/* Polls that were not dispatched need to be re-armed
+			 * as well */
+			eloop_uring_rearm(eloop, &events[i + 1], nfds - i - 1);
+			break;
+		}
+	}
+}
+#endif /* CONFIG_ELOOP_IO_URING */
+
+
 #ifdef CONFIG_ELOOP_KQUEUE
 
-static void eloop_sock_table_dispatch(struct kevent *events, int nfds)
+static void eloop_sock_table_dispatch(struct eloop_ctx *eloop,
+				      struct kevent *events, int nfds)
 {
 	struct eloop_sock *table;
 	int i;
 
 	for (i = 0; i < nfds; i++) {
-		table = &eloop.fd_table[events[i].ident];
+		table = &eloop->fd_table[events[i].ident];
 		if (table->handler == NULL)
 			continue;
-		table->handler(table->sock, table->eloop_data,
-			       table->user_data);
-		if (eloop.readers.changed ||
-		    eloop.writers.changed ||
-		    eloop.exceptions.changed)
+		eloop_sock_call(eloop, table);
+		if (eloop->readers.changed ||
+		    eloop->writers.changed ||
+		    eloop->exceptions.changed)
 			break;
 	}
 }
 
 
-static int eloop_sock_table_requeue(struct eloop_sock_table *table)
+static int eloop_sock_table_requeue(struct eloop_ctx *eloop,
+				    struct eloop_sock_table *table)
 {
 	size_t i;
 	int r;
 
 	r = 0;
 	for (i = 0; i < table->count && table->table; i++) {
-		if (eloop_sock_queue(table->table[i].sock, table->type) == -1)
+		if (eloop_sock_queue(eloop, table->table[i].sock,
+				     table->type) == -1)
 			r = -1;
 	}
 	return r;
@@ -673,21 +1319,22 @@ static int eloop_sock_table_requeue(struct eloop_sock_table *table)
 int eloop_sock_requeue(void)
 {
 	int r = 0;
-
 #ifdef CONFIG_ELOOP_KQUEUE
-	close(eloop.kqueuefd);
-	eloop.kqueuefd = kqueue();
-	if (eloop.kqueuefd < 0) {
+	struct eloop_ctx *eloop = &eloop_default;
+
+	close(eloop->kqueuefd);
+	eloop->kqueuefd = kqueue();
+	if (eloop->kqueuefd < 0) {
 		wpa_printf(MSG_ERROR, "%s: kqueue failed: %s",
 			   __func__, strerror(errno));
 		return -1;
 	}
 
-	if (eloop_sock_table_requeue(&eloop.readers) < 0)
+	if (eloop_sock_table_requeue(eloop, &eloop->readers) < 0)
 		r = -1;
-	if (eloop_sock_table_requeue(&eloop.writers) < 0)
+	if (eloop_sock_table_requeue(eloop, &eloop->writers) < 0)
 		r = -1;
-	if (eloop_sock_table_requeue(&eloop.exceptions) < 0)
+	if (eloop_sock_table_requeue(eloop, &eloop->exceptions) < 0)
 		r = -1;
 #endif /* CONFIG_ELOOP_KQUEUE */
 
@@ -721,59 +1368,263 @@ static void eloop_sock_table_destroy(struct eloop_sock_table *table)
 int eloop_register_read_sock(int sock, eloop_sock_handler handler,
 			     void *eloop_data, void *user_data)
 {
-	return eloop_register_sock(sock, EVENT_TYPE_READ, handler,
-				   eloop_data, user_data);
+	return eloop_ctx_register_sock(&eloop_default, sock, EVENT_TYPE_READ,
+				       handler, eloop_data, user_data);
 }
 
 
 void eloop_unregister_read_sock(int sock)
 {
-	eloop_unregister_sock(sock, EVENT_TYPE_READ);
+	eloop_ctx_unregister_sock(&eloop_default, sock, EVENT_TYPE_READ);
 }
 
 
-static struct eloop_sock_table *eloop_get_sock_table(eloop_event_type type)
+static struct eloop_sock_table *eloop_get_sock_table(struct eloop_ctx *eloop,
+						     eloop_event_type type)
 {
 	switch (type) {
 	case EVENT_TYPE_READ:
-		return &eloop.readers;
+		return &eloop->readers;
 	case EVENT_TYPE_WRITE:
-		return &eloop.writers;
+		return &eloop->writers;
 	case EVENT_TYPE_EXCEPTION:
-		return &eloop.exceptions;
+		return &eloop->exceptions;
 	}
 
 	return NULL;
 }
 
 
+int eloop_ctx_register_sock(struct eloop_ctx *eloop, int sock,
+			    eloop_event_type type, eloop_sock_handler handler,
+			    void *eloop_data, void *user_data)
+{
+	struct eloop_sock_table *table;
+
+	assert(sock >= 0);
+	table = eloop_get_sock_table(eloop, type);
+	return eloop_sock_table_add_sock(eloop, table, sock, handler,
+					 eloop_data, user_data);
+}
+
+
 int eloop_register_sock(int sock, eloop_event_type type,
 			eloop_sock_handler handler,
 			void *eloop_data, void *user_data)
+{
+	return eloop_ctx_register_sock(&eloop_default, sock, type, handler,
+				       eloop_data, user_data);
+}
+
+
+void eloop_ctx_unregister_sock(struct eloop_ctx *eloop, int sock,
+			       eloop_event_type type)
 {
 	struct eloop_sock_table *table;
 
-	assert(sock >= 0);
-	table = eloop_get_sock_table(type);
-	return eloop_sock_table_add_sock(table, sock, handler,
-					 eloop_data, user_data);
+	table = eloop_get_sock_table(eloop, type);
+	eloop_sock_table_remove_sock(eloop, table, sock);
 }
 
 
 void eloop_unregister_sock(int sock, eloop_event_type type)
 {
-	struct eloop_sock_table *table;
+	eloop_ctx_unregister_sock(&eloop_default, sock, type);
+}
+
+
+#define ELOOP_TIMEOUT_HASH_MIN_SIZE 64
 
-	table = eloop_get_sock_table(type);
-	eloop_sock_table_remove_sock(table, sock);
+static size_t eloop_timeout_hash(struct eloop_ctx *eloop,
+				 eloop_timeout_handler handler,
+				 void *eloop_data, void *user_data)
+{
+	uintptr_t val;
+
+	val = (uintptr_t) handler;
+	val = val * 31 + (uintptr_t) eloop_data;
+	val = val * 31 + (uintptr_t) user_data;
+	val ^= val >> 17;
+	val *= 0x9e3779b1;
+	val ^= val >> 15;
+
+	return val & (eloop->timeout_hash_size - 1);
 }
 
 
-int eloop_register_timeout(unsigned int secs, unsigned int usecs,
-			   eloop_timeout_handler handler,
-			   void *eloop_data, void *user_data)
+static int eloop_timeout_before(struct eloop_timeout *a,
+				struct eloop_timeout *b)
+{
+	if (os_reltime_before(&a->time, &b->time))
+		return 1;
+	if (os_reltime_before(&b->time, &a->time))
+		return 0;
+	/* Equal expiration time - maintain registration order */
+	return (int) (a->seq - b->seq) < 0;
+}
+
+
+static void eloop_timeout_heap_set(struct eloop_ctx *eloop, size_t idx,
+				   struct eloop_timeout *timeout)
+{
+	eloop->timeouts[idx] = timeout;
+	timeout->heap_idx = idx;
+}
+
+
+static void eloop_timeout_heap_up(struct eloop_ctx *eloop, size_t idx)
 {
-	struct eloop_timeout *timeout, *tmp;
+	struct eloop_timeout *timeout = eloop->timeouts[idx];
+
+	while (idx > 0) {
+		size_t parent = (idx - 1) / 2;
+
+		if (!eloop_timeout_before(timeout, eloop->timeouts[parent]))
+			break;
+		eloop_timeout_heap_set(eloop, idx, eloop->timeouts[parent]);
+		idx = parent;
+	}
+	eloop_timeout_heap_set(eloop, idx, timeout);
+}
+
+
+static void eloop_timeout_heap_down(struct eloop_ctx *eloop, size_t idx)
+{
+	struct eloop_timeout *timeout = eloop->timeouts[idx];
+
+	for (;;) {
+		size_t child = 2 * idx + 1;
+
+		if (child >= eloop->timeout_count)
+			break;
+		if (child + 1 < eloop->timeout_count &&
+		    eloop_timeout_before(eloop->timeouts[child + 1],
+					 eloop->timeouts[child]))
+			child++;
+		if (!eloop_timeout_before(eloop->timeouts[child], timeout))
+			break;
+		eloop_timeout_heap_set(eloop, idx, eloop->timeouts[child]);
+		idx = child;
+	}
+	eloop_timeout_heap_set(eloop, idx, timeout);
+}
+
+
+static void eloop_timeout_hash_add(struct eloop_ctx *eloop,
+				   struct eloop_timeout *timeout)
+{
+	size_t idx;
+
+	idx = eloop_timeout_hash(eloop, timeout->handler, timeout->eloop_data,
+				 timeout->user_data);
+	timeout->hash_next = eloop->timeout_hash[idx];
+	eloop->timeout_hash[idx] = timeout;
+}
+
+
+static void eloop_timeout_hash_del(struct eloop_ctx *eloop,
+				   struct eloop_timeout *timeout)
+{
+	struct eloop_timeout **pos;
+
+	pos = &eloop->timeout_hash[eloop_timeout_hash(eloop, timeout->handler,
+						      timeout->eloop_data,
+						      timeout->user_data)];
+	while (*pos) {
+		if (*pos == timeout) {
+			*pos = timeout->hash_next;
+			timeout->hash_next = NULL;
+			return;
+		}
+		pos = &(*pos)->hash_next;
+	}
+}
+
+
+static int eloop_timeout_hash_resize(struct eloop_ctx *eloop, size_t size)
+{
+	struct eloop_timeout **old = eloop->timeout_hash, **tmp;
+	size_t i, old_size = eloop->timeout_hash_size;
+
+	tmp = os_calloc(size, sizeof(*tmp));
+	if (!tmp)
+		return -1;
+	eloop->timeout_hash = tmp;
+	eloop->timeout_hash_size = size;
+	for (i = 0; i < old_size; i++) {
+		while (old[i]) {
+			struct eloop_timeout *timeout = old[i];
+
+			old[i] = timeout->hash_next;
+			eloop_timeout_hash_add(eloop, timeout);
+		}
+	}
+	os_free(old);
+
+	return 0;
+}
+
+
+static int eloop_timeout_reserve(struct eloop_ctx *eloop)
+{
+	if (eloop->timeout_count == eloop->timeout_alloc) {
+		struct eloop_timeout **tmp;
+		size_t alloc;
+
+		alloc = eloop->timeout_alloc ? 2 * eloop->timeout_alloc : 16;
+		tmp = os_realloc_array(eloop->timeouts, alloc, sizeof(*tmp));
+		if (!tmp)
+			return -1;
+		eloop->timeouts = tmp;
+		eloop->timeout_alloc = alloc;
+	}
+
+	if (!eloop->timeout_hash)
+		return eloop_timeout_hash_resize(eloop,
+						 ELOOP_TIMEOUT_HASH_MIN_SIZE);
+	if (eloop->timeout_count >= eloop->timeout_hash_size)
+		eloop_timeout_hash_resize(eloop, 2 * eloop->timeout_hash_size);
+
+	return 0;
+}
+
+
+static struct eloop_timeout * eloop_timeout_first(struct eloop_ctx *eloop)
+{
+	return eloop->timeout_count ? eloop->timeouts[0] : NULL;
+}
+
+
+/* Find the earliest timeout with exactly matching handler and context */
+static struct eloop_timeout *
+eloop_timeout_find(struct eloop_ctx *eloop, eloop_timeout_handler handler,
+		   void *eloop_data, void *user_data)
+{
+	struct eloop_timeout *tmp, *found = NULL;
+
+	if (!eloop->timeout_count)
+		return NULL;
+
+	tmp = eloop->timeout_hash[eloop_timeout_hash(eloop, handler, eloop_data,
+						     user_data)];
+	for (; tmp; tmp = tmp->hash_next) {
+		if (tmp->handler == handler &&
+		    tmp->eloop_data == eloop_data &&
+		    tmp->user_data == user_data &&
+		    (!found || eloop_timeout_before(tmp, found)))
+			found = tmp;
+	}
+
+	return found;
+}
+
+
+int eloop_ctx_register_timeout(struct eloop_ctx *eloop, unsigned int secs,
+			       unsigned int usecs,
+			       eloop_timeout_handler handler, void *eloop_data,
+			       void *user_data)
+{
+	struct eloop_timeout *timeout;
 	os_time_t now_sec;
 
 	timeout = os_zalloc(sizeof(*timeout));
@@ -794,21 +1645,21 @@ int eloop_register_timeout(unsigned int secs, unsigned int usecs,
 	}
 	if (timeout->time.sec < now_sec)
 		goto overflow;
+	if (eloop_timeout_reserve(eloop) < 0) {
+		os_free(timeout);
+		return -1;
+	}
 	timeout->eloop_data = eloop_data;
 	timeout->user_data = user_data;
 	timeout->handler = handler;
+	timeout->seq = eloop->timeout_seq++;
 	wpa_trace_add_ref(timeout, eloop, eloop_data);
 	wpa_trace_add_ref(timeout, user, user_data);
 	wpa_trace_record(timeout);
 
-	/* Maintain timeouts in order of increasing time */
-	dl_list_for_each(tmp, &eloop.timeout, struct eloop_timeout, list) {
-		if (os_reltime_before(&timeout->time, &tmp->time)) {
-			dl_list_add(tmp->list.prev, &timeout->list);
-			return 0;
-		}
-	}
-	dl_list_add_tail(&eloop.timeout, &timeout->list);
+	eloop_timeout_hash_add(eloop, timeout);
+	eloop_timeout_heap_set(eloop, eloop->timeout_count++, timeout);
+	eloop_timeout_heap_up(eloop, timeout->heap_idx);
 
 	return 0;
 
@@ -825,76 +1676,185 @@ overflow:
 }
 
 
-static void eloop_remove_timeout(struct eloop_timeout *timeout)
+int eloop_register_timeout(unsigned int secs, unsigned int usecs,
+			   eloop_timeout_handler handler,
+			   void *eloop_data, void *user_data)
+{
+	return eloop_ctx_register_timeout(&eloop_default, secs, usecs, handler,
+					  eloop_data, user_data);
+}
+
+
+static void eloop_free_timeout(struct eloop_timeout *timeout)
 {
-	dl_list_del(&timeout->list);
 	wpa_trace_remove_ref(timeout, eloop, timeout->eloop_data);
 	wpa_trace_remove_ref(timeout, user, timeout->user_data);
 	os_free(timeout);
 }
 
 
-int eloop_cancel_timeout(eloop_timeout_handler handler,
-			 void *eloop_data, void *user_data)
+static void eloop_remove_timeout(struct eloop_ctx *eloop,
+				 struct eloop_timeout *timeout)
+{
+	size_t idx = timeout->heap_idx;
+	struct eloop_timeout *last;
+
+	eloop_timeout_hash_del(eloop, timeout);
+	last = eloop->timeouts[--eloop->timeout_count];
+	if (last != timeout) {
+		eloop_timeout_heap_set(eloop, idx, last);
+		if (idx > 0 &&
+		    eloop_timeout_before(last, eloop->timeouts[(idx - 1) / 2]))
+			eloop_timeout_heap_up(eloop, idx);
+		else
+			eloop_timeout_heap_down(eloop, idx);
+	}
+	eloop_free_timeout(timeout);
+}
+
+
+static int eloop_timeout_match(struct eloop_timeout *timeout,
+			       eloop_timeout_handler handler,
+			       void *eloop_data, void *user_data)
 {
-	struct eloop_timeout *timeout, *prev;
+	return timeout->handler == handler &&
+		(timeout->eloop_data == eloop_data ||
+		 eloop_data == ELOOP_ALL_CTX) &&
+		(timeout->user_data == user_data ||
+		 user_data == ELOOP_ALL_CTX);
+}
+
+
+int eloop_ctx_cancel_timeout(struct eloop_ctx *eloop,
+			     eloop_timeout_handler handler, void *eloop_data,
+			     void *user_data)
+{
+	struct eloop_timeout *timeout, *next;
+	size_t i, count;
 	int removed = 0;
 
-	dl_list_for_each_safe(timeout, prev, &eloop.timeout,
-			      struct eloop_timeout, list) {
-		if (timeout->handler == handler &&
-		    (timeout->eloop_data == eloop_data ||
-		     eloop_data == ELOOP_ALL_CTX) &&
-		    (timeout->user_data == user_data ||
-		     user_data == ELOOP_ALL_CTX)) {
-			eloop_remove_timeout(timeout);
+	if (!eloop->timeout_count)
+		return 0;
+
+	if (eloop_data != ELOOP_ALL_CTX && user_data != ELOOP_ALL_CTX) {
+		timeout = eloop->timeout_hash[eloop_timeout_hash(eloop, handler,
+								 eloop_data,
+								 user_data)];
+		for (; timeout; timeout = next) {
+			next = timeout->hash_next;
+			if (eloop_timeout_match(timeout, handler, eloop_data,
+						user_data)) {
+				eloop_remove_timeout(eloop, timeout);
+				removed++;
+			}
+		}
+		return removed;
+	}
+
+	/*
+	 * Wildcard match cannot use the hash index. Drop all matching entries
+	 * from the heap array in a single pass and restore the heap property
+	 * afterwards.
+	 */
+	count = 0;
+	for (i = 0; i < eloop->timeout_count; i++) {
+		timeout = eloop->timeouts[i];
+		if (eloop_timeout_match(timeout, handler, eloop_data,
+					user_data)) {
+			eloop_timeout_hash_del(eloop, timeout);
+			eloop_free_timeout(timeout);
 			removed++;
+		} else {
+			eloop_timeout_heap_set(eloop, count++, timeout);
 		}
 	}
+	eloop->timeout_count = count;
+	if (removed) {
+		for (i = count / 2; i > 0; i--)
+			eloop_timeout_heap_down(eloop, i - 1);
+	}
 
 	return removed;
 }
 
 
-int eloop_cancel_timeout_one(eloop_timeout_handler handler,
-			     void *eloop_data, void *user_data,
-			     struct os_reltime *remaining)
+int eloop_cancel_timeout(eloop_timeout_handler handler,
+			 void *eloop_data, void *user_data)
 {
-	struct eloop_timeout *timeout, *prev;
-	int removed = 0;
+	return eloop_ctx_cancel_timeout(&eloop_default, handler, eloop_data,
+					user_data);
+}
+
+
+int eloop_ctx_cancel_timeout_one(struct eloop_ctx *eloop,
+				 eloop_timeout_handler handler,
+				 void *eloop_data, void *user_data,
+				 struct os_reltime *remaining)
+{
+	struct eloop_timeout *timeout;
 	struct os_reltime now;
 
 	os_get_reltime(&now);
 	remaining->sec = remaining->usec = 0;
 
-	dl_list_for_each_safe(timeout, prev, &eloop.timeout,
-			      struct eloop_timeout, list) {
-		if (timeout->handler == handler &&
-		    (timeout->eloop_data == eloop_data) &&
-		    (timeout->user_data == user_data)) {
-			removed = 1;
-			if (os_reltime_before(&now, &timeout->time))
-				os_reltime_sub(&timeout->time, &now, remaining);
-			eloop_remove_timeout(timeout);
-			break;
-		}
-	}
-	return removed;
+	timeout = eloop_timeout_find(eloop, handler, eloop_data, user_data);
+	if (!timeout)
+		return 0;
+	if (os_reltime_before(&now, &timeout->time))
+		os_reltime_sub(&timeout->time, &now, remaining);
+	eloop_remove_timeout(eloop, timeout);
+	return 1;
+}
+
+
+int eloop_cancel_timeout_one(eloop_timeout_handler handler,
+			     void *eloop_data, void *user_data,
+			     struct os_reltime *remaining)
+{
+	return eloop_ctx_cancel_timeout_one(&eloop_default, handler,
+					    eloop_data, user_data, remaining);
+}
+
+
+int eloop_ctx_is_timeout_registered(struct eloop_ctx *eloop,
+				    eloop_timeout_handler handler,
+				    void *eloop_data, void *user_data)
+{
+	return eloop_timeout_find(eloop, handler, eloop_data,
+				  user_data) != NULL;
 }
 
 
 int eloop_is_timeout_registered(eloop_timeout_handler handler,
 				void *eloop_data, void *user_data)
 {
+	return eloop_ctx_is_timeout_registered(&eloop_default, handler,
+					       eloop_data, user_data);
+}
+
+
+int eloop_ctx_deplete_timeout(struct eloop_ctx *eloop, unsigned int req_secs,
+			      unsigned int req_usecs,
+			      eloop_timeout_handler handler, void *eloop_data,
+			      void *user_data)
+{
+	struct os_reltime now, requested, remaining;
 	struct eloop_timeout *tmp;
 
-	dl_list_for_each(tmp, &eloop.timeout, struct eloop_timeout, list) {
-		if (tmp->handler == handler &&
-		    tmp->eloop_data == eloop_data &&
-		    tmp->user_data == user_data)
-			return 1;
-	}
+	tmp = eloop_timeout_find(eloop, handler, eloop_data, user_data);
+	if (!tmp)
+		return -1;
 
+	requested.sec = req_secs;
+	requested.usec = req_usecs;
+	os_get_reltime(&now);
+	os_reltime_sub(&tmp->time, &now, &remaining);
+	if (os_reltime_before(&requested, &remaining)) {
+		eloop_ctx_cancel_timeout(eloop, handler, eloop_data, user_data);
+		eloop_ctx_register_timeout(eloop, requested.sec, requested.usec,
+					   handler, eloop_data, user_data);
+		return 1;
+	}
 	return 0;
 }
 
@@ -902,32 +1862,35 @@ int eloop_is_timeout_registered(eloop_timeout_handler handler,
 int eloop_deplete_timeout(unsigned int req_secs, unsigned int req_usecs,
 			  eloop_timeout_handler handler, void *eloop_data,
 			  void *user_data)
+{
+	return eloop_ctx_deplete_timeout(&eloop_default, req_secs, req_usecs,
+					 handler, eloop_data, user_data);
+}
+
+
+int eloop_ctx_replenish_timeout(struct eloop_ctx *eloop, unsigned int req_secs,
+				unsigned int req_usecs,
+				eloop_timeout_handler handler, void *eloop_data,
+				void *user_data)
 {
 	struct os_reltime now, requested, remaining;
 	struct eloop_timeout *tmp;
 
-	dl_list_for_each(tmp, &eloop.timeout, struct eloop_timeout, list) {
-		if (tmp->handler == handler &&
-		    tmp->eloop_data == eloop_data &&
-		    tmp->user_data == user_data) {
-			requested.sec = req_secs;
-			requested.usec = req_usecs;
-			os_get_reltime(&now);
-			os_reltime_sub(&tmp->time, &now, &remaining);
-			if (os_reltime_before(&requested, &remaining)) {
-				eloop_cancel_timeout(handler, eloop_data,
-						     user_data);
-				eloop_register_timeout(requested.sec,
-						       requested.usec,
-						       handler, eloop_data,
-						       user_data);
-				return 1;
-			}
-			return 0;
-		}
-	}
+	tmp = eloop_timeout_find(eloop, handler, eloop_data, user_data);
+	if (!tmp)
+		return -1;
 
-	return -1;
+	requested.sec = req_secs;
+	requested.usec = req_usecs;
+	os_get_reltime(&now);
+	os_reltime_sub(&tmp->time, &now, &remaining);
+	if (os_reltime_before(&remaining, &requested)) {
+		eloop_ctx_cancel_timeout(eloop, handler, eloop_data, user_data);
+		eloop_ctx_register_timeout(eloop, requested.sec, requested.usec,
+					   handler, eloop_data, user_data);
+		return 1;
+	}
+	return 0;
 }
 
 
@@ -935,31 +1898,8 @@ int eloop_replenish_timeout(unsigned int req_secs, unsigned int req_usecs,
 			    eloop_timeout_handler handler, void *eloop_data,
 			    void *user_data)
 {
-	struct os_reltime now, requested, remaining;
-	struct eloop_timeout *tmp;
-
-	dl_list_for_each(tmp, &eloop.timeout, struct eloop_timeout, list) {
-		if (tmp->handler == handler &&
-		    tmp->eloop_data == eloop_data &&
-		    tmp->user_data == user_data) {
-			requested.sec = req_secs;
-			requested.usec = req_usecs;
-			os_get_reltime(&now);
-			os_reltime_sub(&tmp->time, &now, &remaining);
-			if (os_reltime_before(&remaining, &requested)) {
-				eloop_cancel_timeout(handler, eloop_data,
-						     user_data);
-				eloop_register_timeout(requested.sec,
-						       requested.usec,
-						       handler, eloop_data,
-						       user_data);
-				return 1;
-			}
-			return 0;
-		}
-	}
-
-	return -1;
+	return eloop_ctx_replenish_timeout(&eloop_default, req_secs, req_usecs,
+					   handler, eloop_data, user_data);
 }
 
 
@@ -978,48 +1918,50 @@ static void eloop_handle_alarm(int sig)
 
 static void eloop_handle_signal(int sig)
 {
+	struct eloop_ctx *eloop = &eloop_default;
 	size_t i;
 
 #ifndef CONFIG_NATIVE_WINDOWS
-	if ((sig == SIGINT || sig == SIGTERM) && !eloop.pending_terminate) {
+	if ((sig == SIGINT || sig == SIGTERM) && !eloop->pending_terminate) {
 		/* Use SIGALRM to break out from potential busy loops that
 		 * would not allow the program to be killed. */
-		eloop.pending_terminate = 1;
+		eloop->pending_terminate = 1;
 		signal(SIGALRM, eloop_handle_alarm);
 		alarm(2);
 	}
 #endif /* CONFIG_NATIVE_WINDOWS */
 
-	eloop.signaled++;
-	for (i = 0; i < eloop.signal_count; i++) {
-		if (eloop.signals[i].sig == sig) {
-			eloop.signals[i].signaled++;
+	eloop->signaled++;
+	for (i = 0; i < eloop->signal_count; i++) {
+		if (eloop->signals[i].sig == sig) {
+			eloop->signals[i].signaled++;
 			break;
 		}
 	}
 }
 
 
-static void eloop_process_pending_signals(void)
+static void eloop_process_pending_signals(struct eloop_ctx *eloop)
 {
 	size_t i;
 
-	if (eloop.signaled == 0)
+	/* Signals are delivered only through the default instance */
+	if (eloop != &eloop_default || eloop->signaled == 0)
 		return;
-	eloop.signaled = 0;
+	eloop->signaled = 0;
 
-	if (eloop.pending_terminate) {
+	if (eloop->pending_terminate) {
 #ifndef CONFIG_NATIVE_WINDOWS
 		alarm(0);
 #endif /* CONFIG_NATIVE_WINDOWS */
-		eloop.pending_terminate = 0;
+		eloop->pending_terminate = 0;
 	}
 
-	for (i = 0; i < eloop.signal_count; i++) {
-		if (eloop.signals[i].signaled) {
-			eloop.signals[i].signaled = 0;
-			eloop.signals[i].handler(eloop.signals[i].sig,
-						 eloop.signals[i].user_data);
+	for (i = 0; i < eloop->signal_count; i++) {
+		if (eloop->signals[i].signaled) {
+			eloop->signals[i].signaled = 0;
+			eloop->signals[i].handler(eloop->signals[i].sig,
+						 eloop->signals[i].user_data);
 		}
 	}
 }
@@ -1028,19 +1970,20 @@ static void eloop_process_pending_signals(void)
 int eloop_register_signal(int sig, eloop_signal_handler handler,
 			  void *user_data)
 {
+	struct eloop_ctx *eloop = &eloop_default;
 	struct eloop_signal *tmp;
 
-	tmp = os_realloc_array(eloop.signals, eloop.signal_count + 1,
+	tmp = os_realloc_array(eloop->signals, eloop->signal_count + 1,
 			       sizeof(struct eloop_signal));
 	if (tmp == NULL)
 		return -1;
 
-	tmp[eloop.signal_count].sig = sig;
-	tmp[eloop.signal_count].user_data = user_data;
-	tmp[eloop.signal_count].handler = handler;
-	tmp[eloop.signal_count].signaled = 0;
-	eloop.signal_count++;
-	eloop.signals = tmp;
+	tmp[eloop->signal_count].sig = sig;
+	tmp[eloop->signal_count].user_data = user_data;
+	tmp[eloop->signal_count].handler = handler;
+	tmp[eloop->signal_count].signaled = 0;
+	eloop->signal_count++;
+	eloop->signals = tmp;
 	signal(sig, eloop_handle_signal);
 
 	return 0;
@@ -1068,7 +2011,7 @@ int eloop_register_signal_reconfig(eloop_signal_handler handler,
 }
 
 
-void eloop_run(void)
+void eloop_ctx_run(struct eloop_ctx *eloop)
 {
 #ifdef CONFIG_ELOOP_POLL
 	int num_poll_fds;
@@ -1095,12 +2038,12 @@ void eloop_run(void)
 		goto out;
 #endif /* CONFIG_ELOOP_SELECT */
 
-	while (!eloop.terminate &&
-	       (!dl_list_empty(&eloop.timeout) || eloop.readers.count > 0 ||
-		eloop.writers.count > 0 || eloop.exceptions.count > 0)) {
+	while (!eloop->terminate &&
+	       (eloop->timeout_count > 0 || eloop->readers.count > 0 ||
+		eloop->writers.count > 0 || eloop->exceptions.count > 0)) {
 		struct eloop_timeout *timeout;
 
-		if (eloop.pending_terminate) {
+		if (eloop->pending_terminate) {
 			/*
 			 * This may happen in some corner cases where a signal
 			 * is received during a blocking operation. We need to
@@ -1108,13 +2051,12 @@ void eloop_run(void)
 			 * avoid hitting the SIGALRM limit if the blocking
 			 * operation took more than two seconds.
 			 */
-			eloop_process_pending_signals();
-			if (eloop.terminate)
+			eloop_process_pending_signals(eloop);
+			if (eloop->terminate)
 				break;
 		}
 
-		timeout = dl_list_first(&eloop.timeout, struct eloop_timeout,
-					list);
+		timeout = eloop_timeout_first(eloop);
 		if (timeout) {
 			os_get_reltime(&now);
 			if (os_reltime_before(&now, &timeout->time))
@@ -1136,36 +2078,40 @@ void eloop_run(void)
 
 #ifdef CONFIG_ELOOP_POLL
 		num_poll_fds = eloop_sock_table_set_fds(
-			&eloop.readers, &eloop.writers, &eloop.exceptions,
-			eloop.pollfds, eloop.pollfds_map,
-			eloop.max_pollfd_map);
-		res = poll(eloop.pollfds, num_poll_fds,
+			eloop, &eloop->readers, &eloop->writers,
+			&eloop->exceptions, eloop->pollfds, eloop->pollfds_map,
+			eloop->max_pollfd_map);
+		res = poll(eloop->pollfds, num_poll_fds,
 			   timeout ? timeout_ms : -1);
 #endif /* CONFIG_ELOOP_POLL */
 #ifdef CONFIG_ELOOP_SELECT
-		eloop_sock_table_set_fds(&eloop.readers, rfds);
-		eloop_sock_table_set_fds(&eloop.writers, wfds);
-		eloop_sock_table_set_fds(&eloop.exceptions, efds);
-		res = select(eloop.max_sock + 1, rfds, wfds, efds,
+		eloop_sock_table_set_fds(eloop, &eloop->readers, rfds);
+		eloop_sock_table_set_fds(eloop, &eloop->writers, wfds);
+		eloop_sock_table_set_fds(eloop, &eloop->exceptions, efds);
+		res = select(eloop->max_sock + 1, rfds, wfds, efds,
 			     timeout ? &_tv : NULL);
 #endif /* CONFIG_ELOOP_SELECT */
 #ifdef CONFIG_ELOOP_EPOLL
-		if (eloop.count == 0) {
+		if (eloop->count == 0) {
 			res = 0;
 		} else {
-			res = epoll_wait(eloop.epollfd, eloop.epoll_events,
-					 eloop.count, timeout_ms);
+			res = epoll_wait(eloop->epollfd, eloop->epoll_events,
+					 eloop->count, timeout_ms);
 		}
 #endif /* CONFIG_ELOOP_EPOLL */
 #ifdef CONFIG_ELOOP_KQUEUE
-		if (eloop.count == 0) {
+		if (eloop->count == 0) {
 			res = 0;
 		} else {
-			res = kevent(eloop.kqueuefd, NULL, 0,
-				     eloop.kqueue_events, eloop.kqueue_nevents,
+			res = kevent(eloop->kqueuefd, NULL, 0,
+				     eloop->kqueue_events,
+				     eloop->kqueue_nevents,
 				     timeout ? &ts : NULL);
 		}
 #endif /* CONFIG_ELOOP_KQUEUE */
+#ifdef CONFIG_ELOOP_IO_URING
+		res = eloop_uring_wait(eloop, timeout ? &tv : NULL);
+#endif /* CONFIG_ELOOP_IO_URING */
 		if (res < 0 && errno != EINTR && errno != 0) {
 			wpa_printf(MSG_ERROR, "eloop: %s: %s",
 #ifdef CONFIG_ELOOP_POLL
@@ -1180,40 +2126,56 @@ void eloop_run(void)
 #ifdef CONFIG_ELOOP_KQUEUE
 				   "kqueue"
 #endif /* CONFIG_ELOOP_EKQUEUE */
+#ifdef CONFIG_ELOOP_IO_URING
+				   "io_uring"
+#endif /* CONFIG_ELOOP_IO_URING */
 
 				   , strerror(errno));
 			goto out;
 		}
 
-		eloop.readers.changed = 0;
-		eloop.writers.changed = 0;
-		eloop.exceptions.changed = 0;
+		eloop->readers.changed = 0;
+		eloop->writers.changed = 0;
+		eloop->exceptions.changed = 0;
 
-		eloop_process_pending_signals();
+		eloop_process_pending_signals(eloop);
 
 
-		/* check if some registered timeouts have occurred */
-		timeout = dl_list_first(&eloop.timeout, struct eloop_timeout,
-					list);
+		/*
+		 * Check if some registered timeouts have occurred. All
+		 * timeouts that have expired by now are processed in this
+		 * iteration instead of one per iteration, so that a burst of
+		 * due timeouts (possibly from different interfaces) does not
+		 * need an extra wait call for each one of them. Timeouts
+		 * registered by the handlers are left for the next iteration.
+		 */
+		timeout = eloop_timeout_first(eloop);
 		if (timeout) {
+			unsigned int seq = eloop->timeout_seq;
+
 			os_get_reltime(&now);
-			if (!os_reltime_before(&now, &timeout->time)) {
+			while (timeout && !eloop->terminate &&
+			       !os_reltime_before(&now, &timeout->time) &&
+			       (int) (timeout->seq - seq) < 0) {
 				void *eloop_data = timeout->eloop_data;
 				void *user_data = timeout->user_data;
 				eloop_timeout_handler handler =
 					timeout->handler;
-				eloop_remove_timeout(timeout);
-				handler(eloop_data, user_data);
-			}
+				struct os_reltime expire = timeout->time;
 
+				eloop_remove_timeout(eloop, timeout);
+				eloop_timeout_call(eloop, handler, eloop_data,
+						   user_data, &expire);
+				timeout = eloop_timeout_first(eloop);
+			}
 		}
 
 		if (res <= 0)
 			continue;
 
-		if (eloop.readers.changed ||
-		    eloop.writers.changed ||
-		    eloop.exceptions.changed) {
+		if (eloop->readers.changed ||
+		    eloop->writers.changed ||
+		    eloop->exceptions.changed) {
 			 /*
 			  * Sockets may have been closed and reopened with the
 			  * same FD in the signal or timeout handlers, so we
@@ -1221,28 +2183,35 @@ void eloop_run(void)
 			  * whether any of the currently registered sockets have
 			  * events.
 			  */
+#ifdef CONFIG_ELOOP_IO_URING
+			eloop_uring_rearm(eloop, eloop->uring_events, res);
+#endif /* CONFIG_ELOOP_IO_URING */
 			continue;
 		}
 
 #ifdef CONFIG_ELOOP_POLL
-		eloop_sock_table_dispatch(&eloop.readers, &eloop.writers,
-					  &eloop.exceptions, eloop.pollfds_map,
-					  eloop.max_pollfd_map);
+		eloop_sock_table_dispatch(eloop, &eloop->readers,
+					  &eloop->writers, &eloop->exceptions,
+					  eloop->pollfds_map,
+					  eloop->max_pollfd_map);
 #endif /* CONFIG_ELOOP_POLL */
 #ifdef CONFIG_ELOOP_SELECT
-		eloop_sock_table_dispatch(&eloop.readers, rfds);
-		eloop_sock_table_dispatch(&eloop.writers, wfds);
-		eloop_sock_table_dispatch(&eloop.exceptions, efds);
+		eloop_sock_table_dispatch(eloop, &eloop->readers, rfds);
+		eloop_sock_table_dispatch(eloop, &eloop->writers, wfds);
+		eloop_sock_table_dispatch(eloop, &eloop->exceptions, efds);
 #endif /* CONFIG_ELOOP_SELECT */
 #ifdef CONFIG_ELOOP_EPOLL
-		eloop_sock_table_dispatch(eloop.epoll_events, res);
+		eloop_sock_table_dispatch(eloop, eloop->epoll_events, res);
 #endif /* CONFIG_ELOOP_EPOLL */
 #ifdef CONFIG_ELOOP_KQUEUE
-		eloop_sock_table_dispatch(eloop.kqueue_events, res);
+		eloop_sock_table_dispatch(eloop, eloop->kqueue_events, res);
 #endif /* CONFIG_ELOOP_KQUEUE */
+#ifdef CONFIG_ELOOP_IO_URING
+		eloop_sock_table_dispatch(eloop, eloop->uring_events, res);
+#endif /* CONFIG_ELOOP_IO_URING */
 	}
 
-	eloop.terminate = 0;
+	eloop->terminate = 0;
 out:
 #ifdef CONFIG_ELOOP_SELECT
 	os_free(rfds);
@@ -1253,20 +2222,31 @@ out:
 }
 
 
+void eloop_run(void)
+{
+	eloop_ctx_run(&eloop_default);
+}
+
+
+void eloop_ctx_terminate(struct eloop_ctx *eloop)
+{
+	eloop->terminate = 1;
+}
+
+
 void eloop_terminate(void)
 {
-	eloop.terminate = 1;
+	eloop_ctx_terminate(&eloop_default);
 }
 
 
-void eloop_destroy(void)
+static void eloop_ctx_deinit(struct eloop_ctx *eloop)
 {
-	struct eloop_timeout *timeout, *prev;
+	struct eloop_timeout *timeout;
 	struct os_reltime now;
 
 	os_get_reltime(&now);
-	dl_list_for_each_safe(timeout, prev, &eloop.timeout,
-			      struct eloop_timeout, list) {
+	while ((timeout = eloop_timeout_first(eloop))) {
 		int sec, usec;
 		sec = timeout->time.sec - now.sec;
 		usec = timeout->time.usec - now.usec;
@@ -1281,34 +2261,200 @@ void eloop_destroy(void)
 		wpa_trace_dump_funcname("eloop unregistered timeout handler",
 					timeout->handler);
 		wpa_trace_dump("eloop timeout", timeout);
-		eloop_remove_timeout(timeout);
+		eloop_remove_timeout(eloop, timeout);
 	}
-	eloop_sock_table_destroy(&eloop.readers);
-	eloop_sock_table_destroy(&eloop.writers);
-	eloop_sock_table_destroy(&eloop.exceptions);
-	os_free(eloop.signals);
+	os_free(eloop->timeouts);
+	eloop->timeouts = NULL;
+	eloop->timeout_alloc = 0;
+	os_free(eloop->timeout_hash);
+	eloop->timeout_hash = NULL;
+	eloop->timeout_hash_size = 0;
+	eloop_sock_table_destroy(&eloop->readers);
+	eloop_sock_table_destroy(&eloop->writers);
+	eloop_sock_table_destroy(&eloop->exceptions);
+	os_free(eloop->signals);
 
 #ifdef CONFIG_ELOOP_POLL
-	os_free(eloop.pollfds);
-	os_free(eloop.pollfds_map);
+	os_free(eloop->pollfds);
+	os_free(eloop->pollfds_map);
 #endif /* CONFIG_ELOOP_POLL */
-#if defined(CONFIG_ELOOP_EPOLL) || defined(CONFIG_ELOOP_KQUEUE)
-	os_free(eloop.fd_table);
-#endif /* CONFIG_ELOOP_EPOLL || CONFIG_ELOOP_KQUEUE */
+#if defined(CONFIG_ELOOP_EPOLL) || defined(CONFIG_ELOOP_KQUEUE) || \
+	defined(CONFIG_ELOOP_IO_URING)
+	os_free(eloop->fd_table);
+#endif /* CONFIG_ELOOP_EPOLL || CONFIG_ELOOP_KQUEUE || CONFIG_ELOOP_IO_URING */
 #ifdef CONFIG_ELOOP_EPOLL
-	os_free(eloop.epoll_events);
-	close(eloop.epollfd);
+	os_free(eloop->epoll_events);
+	close(eloop->epollfd);
 #endif /* CONFIG_ELOOP_EPOLL */
 #ifdef CONFIG_ELOOP_KQUEUE
-	os_free(eloop.kqueue_events);
-	close(eloop.kqueuefd);
+	os_free(eloop->kqueue_events);
+	close(eloop->kqueuefd);
 #endif /* CONFIG_ELOOP_KQUEUE */
+#ifdef CONFIG_ELOOP_IO_URING
+	eloop_uring_deinit(eloop);
+#endif /* CONFIG_ELOOP_IO_URING */
+	eloop_ctx_stats_disable(eloop);
+}
+
+
+void eloop_destroy(void)
+{
+	eloop_ctx_deinit(&eloop_default);
+}
+
+
+int eloop_reset(void)
+{
+	struct eloop_ctx *eloop = &eloop_default;
+	struct eloop_timeout *timeout;
+
+	while ((timeout = eloop_timeout_first(eloop)))
+		eloop_remove_timeout(eloop, timeout);
+	eloop_trace_sock_remove_ref(&eloop->readers);
+	eloop_trace_sock_remove_ref(&eloop->writers);
+	eloop_trace_sock_remove_ref(&eloop->exceptions);
+	eloop->readers.count = 0;
+	eloop->writers.count = 0;
+	eloop->exceptions.count = 0;
+	eloop_ctx_deinit(eloop);
+
+	return eloop_ctx_init(eloop);
+}
+
+
+void eloop_ctx_free(struct eloop_ctx *eloop)
+{
+	if (!eloop || eloop == &eloop_default)
+		return;
+	eloop_ctx_deinit(eloop);
+	os_free(eloop);
+}
+
+
+int eloop_ctx_terminated(struct eloop_ctx *eloop)
+{
+	return eloop->terminate || eloop->pending_terminate;
 }
 
 
 int eloop_terminated(void)
 {
-	return eloop.terminate || eloop.pending_terminate;
+	return eloop_ctx_terminated(&eloop_default);
+}
+
+
+int eloop_ctx_stats_enable(struct eloop_ctx *eloop, unsigned int slow_usec)
+{
+	eloop_ctx_stats_disable(eloop);
+	eloop->stats = os_zalloc(sizeof(*eloop->stats));
+	if (!eloop->stats)
+		return -1;
+	os_get_reltime(&eloop->stats->start);
+	eloop->stats->slow_usec = slow_usec;
+	return 0;
+}
+
+
+int eloop_stats_enable(unsigned int slow_usec)
+{
+	return eloop_ctx_stats_enable(&eloop_default, slow_usec);
+}
+
+
+void eloop_ctx_stats_disable(struct eloop_ctx *eloop)
+{
+	if (!eloop->stats)
+		return;
+	os_free(eloop->stats->handlers);
+	os_free(eloop->stats);
+	eloop->stats = NULL;
+}
+
+
+void eloop_stats_disable(void)
+{
+	eloop_ctx_stats_disable(&eloop_default);
+}
+
+
+static int eloop_stats_cmp(const void *a, const void *b)
+{
+	const struct eloop_handler_stats *ha = a, *hb = b;
+
+	if (ha->total_usec > hb->total_usec)
+		return -1;
+	if (ha->total_usec < hb->total_usec)
+		return 1;
+	return 0;
+}
+
+
+int eloop_ctx_stats_get(struct eloop_ctx *eloop, char *buf, size_t buflen)
+{
+	struct eloop_stats *stats = eloop->stats;
+	struct eloop_handler_stats *sorted;
+	struct os_reltime now;
+	char *pos = buf, *end = buf + buflen;
+	size_t i, j;
+	int ret;
+
+	if (!stats) {
+		ret = os_snprintf(buf, buflen, "enabled=0\n");
+		if (os_snprintf_error(buflen, ret))
+			return 0;
+		return ret;
+	}
+
+	os_get_reltime(&now);
+	ret = os_snprintf(pos, end - pos,
+			  "enabled=1\n"
+			  "duration_usec=%u\n"
+			  "slow_threshold_usec=%u\n"
+			  "slow_count=%u\n"
+			  "timeouts=%u\n"
+			  "lag_avg_usec=%llu\n"
+			  "lag_max_usec=%u\n",
+			  eloop_usec_since(&stats->start, &now),
+			  stats->slow_usec, stats->slow_count, stats->lag_count,
+			  stats->lag_count ?
+			  (unsigned long long) (stats->lag_total_usec /
+						stats->lag_count) : 0ULL,
+			  stats->lag_max_usec);
+	if (os_snprintf_error(end - pos, ret))
+		return 0;
+	pos += ret;
+
+	/* List the handlers with the largest cumulative run time first */
+	sorted = os_calloc(stats->handler_count, sizeof(*sorted));
+	if (!sorted)
+		return pos - buf;
+	for (i = 0, j = 0; i < stats->handler_size; i++) {
+		if (stats->handlers[i].func)
+			sorted[j++] = stats->handlers[i];
+	}
+	qsort(sorted, j, sizeof(*sorted), eloop_stats_cmp);
+
+	for (i = 0; i < j; i++) {
+		ret = os_snprintf(pos, end - pos,
+				  "%s handler=%p count=%u total_usec=%llu max_usec=%u\n",
+				  sorted[i].type == ELOOP_STATS_SOCK ?
+				  "sock" : "timeout",
+				  sorted[i].func, sorted[i].count,
+				  (unsigned long long) sorted[i].total_usec,
+				  sorted[i].max_usec);
+		if (os_snprintf_error(end - pos, ret))
+			break;
+		pos += ret;
+	}
+	os_free(sorted);
+
+	return pos - buf;
+}
+
+
+int eloop_stats_get(char *buf, size_t buflen)
+{
+	return eloop_ctx_stats_get(&eloop_default, buf, buflen);
 }
 
 
@@ -1326,7 +2472,8 @@ void eloop_wait_for_read_sock(int sock)
 
 	poll(&pfd, 1, -1);
 #endif /* CONFIG_ELOOP_POLL */
-#if defined(CONFIG_ELOOP_SELECT) || defined(CONFIG_ELOOP_EPOLL)
+#if defined(CONFIG_ELOOP_SELECT) || defined(CONFIG_ELOOP_EPOLL) || \
+	defined(CONFIG_ELOOP_IO_URING)
 	/*
 	 * We can use epoll() here. But epoll() requres 4 system calls.
 	 * epoll_create1(), epoll_ctl() for ADD, epoll_wait, and close() for
@@ -1340,7 +2487,7 @@ void eloop_wait_for_read_sock(int sock)
 	FD_ZERO(&rfds);
 	FD_SET(sock, &rfds);
 	select(sock + 1, &rfds, NULL, NULL, NULL);
-#endif /* defined(CONFIG_ELOOP_SELECT) || defined(CONFIG_ELOOP_EPOLL) */
+#endif /* CONFIG_ELOOP_SELECT || CONFIG_ELOOP_EPOLL || CONFIG_ELOOP_IO_URING */
 #ifdef CONFIG_ELOOP_KQUEUE
 	int kfd;
 	struct kevent ke1, ke2;
@@ -345,6 +345,17 @@ void eloop_terminate(void);
  */
 void eloop_destroy(void);
 
+/**
+ * eloop_reset - Drop all registrations from the event loop
+ * Returns: 0 on success, -1 on failure
+ *
+ * This is meant for a child process after fork() that runs its own event loop
+ * and must not handle the sockets, timeouts, and signals registered by the
+ * parent process. The registrations are dropped without unregistering them
+ * from the kernel objects that are shared with the parent process.
+ */
+int eloop_reset(void);
+
 /**
  * eloop_terminated - Check whether event loop has been terminated
  * Returns: 1 = event loop terminate, 0 = event loop still running
@@ -356,6 +367,34 @@ void eloop_destroy(void);
  */
 int eloop_terminated(void);
 
+/**
+ * eloop_stats_enable - Start collecting event loop handler statistics
+ * @slow_usec: Log handlers that run at least this long (usec); 0 = disabled
+ * Returns: 0 on success, -1 on failure
+ *
+ * The number of invocations and the cumulative and maximum run time are
+ * recorded for each socket and timeout handler function along with the
+ * lateness of the timeouts compared to their expiration time. Any earlier
+ * statistics are cleared.
+ */
+int eloop_stats_enable(unsigned int slow_usec);
+
+/**
+ * eloop_stats_disable - Stop collecting event loop handler statistics
+ */
+void eloop_stats_disable(void);
+
+/**
+ * eloop_stats_get - Write event loop handler statistics
+ * @buf: Buffer for the statistics
+ * @buflen: Length of the buffer
+ * Returns: Number of bytes written to the buffer
+ *
+ * The handlers are listed by function address in decreasing order of
+ * cumulative run time.
+ */
+int eloop_stats_get(char *buf, size_t buflen);
+
 /**
  * eloop_wait_for_read_sock - Wait for a single reader
  * @sock: File descriptor number for the socket
@@ -364,4 +403,65 @@ int eloop_terminated(void);
  */
 void eloop_wait_for_read_sock(int sock);
 
+
+/*
+ * Instance based interface
+ *
+ * The functions above operate on a default event loop instance that is set up
+ * with eloop_init(). Additional independent event loop instances can be
+ * created with eloop_ctx_new(), e.g., to run an event loop in a separate
+ * thread. Each instance must be used only from a single thread at a time and
+ * signals are delivered only through the default instance.
+ *
+ * The eloop_ctx_*() functions behave like the matching functions without the
+ * ctx prefix, but operate on the specified instance.
+ */
+struct eloop_ctx;
+
+/**
+ * eloop_ctx_new - Allocate a new event loop instance
+ * Returns: Pointer to the new instance or %NULL on failure
+ */
+struct eloop_ctx * eloop_ctx_new(void);
+
+/**
+ * eloop_ctx_free - Free an event loop instance
+ * @eloop: Event loop instance from eloop_ctx_new()
+ */
+void eloop_ctx_free(struct eloop_ctx *eloop);
+
+int eloop_ctx_register_sock(struct eloop_ctx *eloop, int sock,
+			    eloop_event_type type, eloop_sock_handler handler,
+			    void *eloop_data, void *user_data);
+void eloop_ctx_unregister_sock(struct eloop_ctx *eloop, int sock,
+			       eloop_event_type type);
+int eloop_ctx_register_timeout(struct eloop_ctx *eloop, unsigned int secs,
+			       unsigned int usecs,
+			       eloop_timeout_handler handler, void *eloop_data,
+			       void *user_data);
+int eloop_ctx_cancel_timeout(struct eloop_ctx *eloop,
+			     eloop_timeout_handler handler, void *eloop_data,
+			     void *user_data);
+int eloop_ctx_cancel_timeout_one(struct eloop_ctx *eloop,
+				 eloop_timeout_handler handler,
+				 void *eloop_data, void *user_data,
+				 struct os_reltime *remaining);
+int eloop_ctx_is_timeout_registered(struct eloop_ctx *eloop,
+				    eloop_timeout_handler handler,
+				    void *eloop_data, void *user_data);
+int eloop_ctx_deplete_timeout(struct eloop_ctx *eloop, unsigned int req_secs,
+			      unsigned int req_usecs,
+			      eloop_timeout_handler handler, void *eloop_data,
+			      void *user_data);
+int eloop_ctx_replenish_timeout(struct eloop_ctx *eloop, unsigned int req_secs,
+				unsigned int req_usecs,
+				eloop_timeout_handler handler, void *eloop_data,
+				void *user_data);
+void eloop_ctx_run(struct eloop_ctx *eloop);
+void eloop_ctx_terminate(struct eloop_ctx *eloop);
+int eloop_ctx_terminated(struct eloop_ctx *eloop);
+int eloop_ctx_stats_enable(struct eloop_ctx *eloop, unsigned int slow_usec);
+void eloop_ctx_stats_disable(struct eloop_ctx *eloop);
+int eloop_ctx_stats_get(struct eloop_ctx *eloop, char *buf, size_t buflen);
+
 #endif /* ELOOP_H */
@@ -672,6 +672,23 @@ int eloop_terminated(void)
 }
 
 
+int eloop_stats_enable(unsigned int slow_usec)
+{
+	return -1;
+}
+
+
+void eloop_stats_disable(void)
+{
+}
+
+
+int eloop_stats_get(char *buf, size_t buflen)
+{
+	return 0;
+}
+
+
 void eloop_wait_for_read_sock(int sock)
 {
 	WSAEVENT event;
@@ -13,8 +13,14 @@
 #endif /* __linux__ */
 
 #include "common.h"
+#include "eloop.h"
+#include "list.h"
 #include "ext_password_i.h"
 
+/* Time (in seconds) a fetched password is kept for repeated requests during
+ * the same connection attempt instead of querying the backend again */
+#define EXT_PASSWORD_CACHE_TIMEOUT 10
+
 
 static const struct ext_password_backend *backends[] = {
 #ifdef CONFIG_EXT_PASSWORD_TEST
@@ -26,12 +32,105 @@ static const struct ext_password_backend *backends[] = {
 	NULL
 };
 
+struct ext_password_cache {
+	struct dl_list list;
+	char *name;
+	struct wpabuf *pw;
+	struct os_reltime fetched;
+};
+
 struct ext_password_data {
 	const struct ext_password_backend *backend;
 	void *priv;
+	struct dl_list cache; /* struct ext_password_cache, oldest first */
+
+	/* Backend request statistics */
+	unsigned int fetches;
+	unsigned int failures;
+	unsigned int cache_hits;
+	unsigned long fetch_usec_total;
+	unsigned long fetch_usec_max;
 };
 
 
+static struct wpabuf * ext_password_dup(const struct wpabuf *pw)
+{
+	struct wpabuf *buf;
+
+	buf = ext_password_alloc(wpabuf_len(pw));
+	if (buf)
+		wpabuf_put_buf(buf, pw);
+	return buf;
+}
+
+
+static void ext_password_cache_free(struct ext_password_cache *entry)
+{
+	dl_list_del(&entry->list);
+	os_free(entry->name);
+	ext_password_free(entry->pw);
+	os_free(entry);
+}
+
+
+static void ext_password_cache_timeout(void *eloop_ctx, void *timeout_ctx)
+{
+	struct ext_password_data *data = eloop_ctx;
+	struct ext_password_cache *entry;
+	struct os_reltime now, age;
+
+	os_get_reltime(&now);
+	while ((entry = dl_list_first(&data->cache, struct ext_password_cache,
+				      list))) {
+		if (!os_reltime_expired(&now, &entry->fetched,
+					EXT_PASSWORD_CACHE_TIMEOUT)) {
+			os_reltime_sub(&now, &entry->fetched, &age);
+			eloop_register_timeout(
+				EXT_PASSWORD_CACHE_TIMEOUT - age.sec, 0,
+				ext_password_cache_timeout, data, NULL);
+			break;
+		}
+		ext_password_cache_free(entry);
+	}
+}
+
+
+static void ext_password_cache_flush(struct ext_password_data *data)
+{
+	struct ext_password_cache *entry, *tmp;
+
+	eloop_cancel_timeout(ext_password_cache_timeout, data, NULL);
+	dl_list_for_each_safe(entry, tmp, &data->cache,
+			      struct ext_password_cache, list)
+		ext_password_cache_free(entry);
+}
+
+
+static void ext_password_cache_add(struct ext_password_data *data,
+				   const char *name, const struct wpabuf *pw)
+{
+	struct ext_password_cache *entry;
+
+	entry = os_zalloc(sizeof(*entry));
+	if (!entry)
+		return;
+	entry->name = os_strdup(name);
+	entry->pw = ext_password_dup(pw);
+	if (!entry->name || !entry->pw) {
+		os_free(entry->name);
+		ext_password_free(entry->pw);
+		os_free(entry);
+		return;
+	}
+	os_get_reltime(&entry->fetched);
+	dl_list_add_tail(&data->cache, &entry->list);
+	if (!eloop_is_timeout_registered(ext_password_cache_timeout, data,
+					 NULL))
+		eloop_register_timeout(EXT_PASSWORD_CACHE_TIMEOUT, 0,
+				       ext_password_cache_timeout, data, NULL);
+}
+
+
 struct ext_password_data * ext_password_init(const char *backend,
 					     const char *params)
 {
@@ -41,6 +140,7 @@ struct ext_password_data * ext_password_init(const char *backend,
 	data = os_zalloc(sizeof(*data));
 	if (data == NULL)
 		return NULL;
+	dl_list_init(&data->cache);
 
 	for (i = 0; backends[i]; i++) {
 		if (os_strcmp(backends[i]->name, backend) == 0) {
@@ -66,6 +166,8 @@ struct ext_password_data * ext_password_init(const char *backend,
 
 void ext_password_deinit(struct ext_password_data *data)
 {
+	if (data)
+		ext_password_cache_flush(data);
 	if (data && data->backend && data->priv)
 		data->backend->deinit(data->priv);
 	os_free(data);
@@ -75,9 +177,45 @@ void ext_password_deinit(struct ext_password_data *data)
 struct wpabuf * ext_password_get(struct ext_password_data *data,
 				 const char *name)
 {
+	struct ext_password_cache *entry;
+	struct os_reltime start, end, diff;
+	struct wpabuf *pw;
+	unsigned long usec;
+
 	if (data == NULL)
 		return NULL;
-	return data->backend->get(data->priv, name);
+
+	/* The same password is typically requested multiple times during a
+	 * connection attempt (e.g., for each EAP method message that needs
+	 * it), so serve the repeated requests from memory. */
+	dl_list_for_each(entry, &data->cache, struct ext_password_cache, list) {
+		if (os_strcmp(entry->name, name) == 0) {
+			data->cache_hits++;
+			return ext_password_dup(entry->pw);
+		}
+	}
+
+	os_get_reltime(&start);
+	pw = data->backend->get(data->priv, name);
+	os_get_reltime(&end);
+
+	os_reltime_sub(&end, &start, &diff);
+	usec = diff.sec * 1000000 + diff.usec;
+	data->fetches++;
+	data->fetch_usec_total += usec;
+	if (usec > data->fetch_usec_max)
+		data->fetch_usec_max = usec;
+	if (!pw)
+		data->failures++;
+	wpa_printf(MSG_DEBUG,
+		   "EXT PW: Backend %s request took %lu usec (requests=%u failures=%u cache_hits=%u avg=%lu max=%lu usec)",
+		   data->backend->name, usec, data->fetches, data->failures,
+		   data->cache_hits, data->fetch_usec_total / data->fetches,
+		   data->fetch_usec_max);
+
+	if (pw)
+		ext_password_cache_add(data, name, pw);
+	return pw;
 }
 
 
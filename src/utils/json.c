@@ -61,43 +61,98 @@ void json_escape_string(char *txt, size_t maxlen, const char *data, size_t len)
 }
 
 
-static char * json_parse_string(const char **json_pos, const char *end)
+/*
+ * All tokens and decoded strings of a parsed tree are stored in a single
+ * allocation. The first token is the root of the tree, so json_free() of the
+ * root returns the whole arena. The space needed is calculated from the input
+ * data before parsing.
+ */
+struct json_arena {
+	struct json_token *tokens;
+	unsigned int num_tokens;
+	unsigned int max_tokens;
+	char *str_pos;
+	char *str_end;
+};
+
+
+static int json_arena_alloc(struct json_arena *arena, const char *data,
+			    size_t data_len)
+{
+	const char *pos, *end = data + data_len;
+	unsigned int tokens = 1;
+	size_t str_len = 0;
+	const char *start;
+	size_t len;
+
+	for (pos = data; pos < end; pos++) {
+		switch (*pos) {
+		case '[':
+		case '{':
+		case ',':
+			tokens++;
+			break;
+		case '\"':
+			start = ++pos;
+			for (;;) {
+				const char *esc;
+
+				pos = os_memchr(pos, '"', end - pos);
+				if (!pos) {
+					pos = end;
+					break;
+				}
+				/* Quote is escaped if preceded by an odd
+				 * number of backslashes */
+				for (esc = pos; esc > start && esc[-1] == '\\';
+				     esc--)
+					;
+				if (!((pos - esc) & 1))
+					break;
+				pos++;
+			}
+			/* Decoded string is never longer than the escaped
+			 * one */
+			str_len += pos - start + 1;
+			break;
+		}
+	}
+
+	if (tokens > JSON_MAX_TOKENS)
+		tokens = JSON_MAX_TOKENS;
+	len = tokens * sizeof(struct json_token) + str_len;
+	arena->tokens = os_zalloc(len);
+	if (!arena->tokens)
+		return -1;
+	arena->num_tokens = 0;
+	arena->max_tokens = tokens;
+	arena->str_pos = (char *) &arena->tokens[tokens];
+	arena->str_end = arena->str_pos + str_len;
+	return 0;
+}
+
+
+static char * json_parse_string(const char **json_pos, const char *end,
+				struct json_arena *arena)
 {
 	const char *pos = *json_pos;
-	char *str, *spos, *s_end;
-	size_t max_len, buf_len;
+	char *str, *spos;
 	u8 bin[2];
 
 	pos++; /* skip starting quote */
 
-	max_len = end - pos + 1;
-	buf_len = max_len > 10 ? 10 : max_len;
-	str = os_malloc(buf_len);
-	if (!str)
-		return NULL;
-	spos = str;
-	s_end = str + buf_len;
+	str = spos = arena->str_pos;
 
 	for (; pos < end; pos++) {
-		if (buf_len < max_len && s_end - spos < 3) {
-			char *tmp;
-			int idx;
-
-			idx = spos - str;
-			buf_len *= 2;
-			if (buf_len > max_len)
-				buf_len = max_len;
-			tmp = os_realloc(str, buf_len);
-			if (!tmp)
-				goto fail;
-			str = tmp;
-			spos = str + idx;
-			s_end = str + buf_len;
+		if (spos >= arena->str_end) {
+			wpa_printf(MSG_DEBUG, "JSON: String arena exhausted");
+			return NULL;
 		}
 
 		switch (*pos) {
 		case '\"': /* end string */
-			*spos = '\0';
+			*spos++ = '\0';
+			arena->str_pos = spos;
 			/* caller will move to the next position */
 			*json_pos = pos;
 			return str;
@@ -106,7 +161,7 @@ static char * json_parse_string(const char **json_pos, const char *end)
 			if (pos >= end) {
 				wpa_printf(MSG_DEBUG,
 					   "JSON: Truncated \\ escape");
-				goto fail;
+				return NULL;
 			}
 			switch (*pos) {
 			case '"':
@@ -129,10 +184,12 @@ static char * json_parse_string(const char **json_pos, const char *end)
 				    bin[1] == 0x00) {
 					wpa_printf(MSG_DEBUG,
 						   "JSON: Invalid \\u escape");
-					goto fail;
+					return NULL;
 				}
 				if (bin[0] == 0x00) {
 					*spos++ = bin[1];
+				} else if (arena->str_end - spos < 2) {
+					return NULL;
 				} else {
 					*spos++ = bin[0];
 					*spos++ = bin[1];
@@ -142,7 +199,7 @@ static char * json_parse_string(const char **json_pos, const char *end)
 			default:
 				wpa_printf(MSG_DEBUG,
 					   "JSON: Unknown escape '%c'", *pos);
-				goto fail;
+				return NULL;
 			}
 			break;
 		default:
@@ -151,8 +208,6 @@ static char * json_parse_string(const char **json_pos, const char *end)
 		}
 	}
 
-fail:
-	os_free(str);
 	return NULL;
 }
 
@@ -162,7 +217,7 @@ static int json_parse_number(const char **json_pos, const char *end,
 {
 	const char *pos = *json_pos;
 	size_t len;
-	char *str;
+	char str[20];
 
 	for (; pos < end; pos++) {
 		if (*pos != '-' && (*pos < '0' || *pos > '9')) {
@@ -175,14 +230,14 @@ static int json_parse_number(const char **json_pos, const char *end,
 	if (pos < *json_pos)
 		return -1;
 	len = pos - *json_pos + 1;
-	str = os_malloc(len + 1);
-	if (!str)
+	if (len >= sizeof(str)) {
+		wpa_printf(MSG_DEBUG, "JSON: Too long number");
 		return -1;
+	}
 	os_memcpy(str, *json_pos, len);
 	str[len] = '\0';
 
 	*ret_val = atoi(str);
-	os_free(str);
 	*json_pos = pos;
 	return 0;
 }
@@ -206,14 +261,13 @@ static int json_check_tree_state(struct json_token *token)
 }
 
 
-static struct json_token * json_alloc_token(unsigned int *tokens)
+static struct json_token * json_alloc_token(struct json_arena *arena)
 {
-	(*tokens)++;
-	if (*tokens > JSON_MAX_TOKENS) {
+	if (arena->num_tokens >= arena->max_tokens) {
 		wpa_printf(MSG_DEBUG, "JSON: Maximum token limit exceeded");
 		return NULL;
 	}
-	return os_zalloc(sizeof(struct json_token));
+	return &arena->tokens[arena->num_tokens++];
 }
 
 
@@ -224,7 +278,10 @@ struct json_token * json_parse(const char *data, size_t data_len)
 	char *str;
 	int num;
 	unsigned int depth = 0;
-	unsigned int tokens = 0;
+	struct json_arena arena;
+
+	if (json_arena_alloc(&arena, data, data_len) < 0)
+		return NULL;
 
 	pos = data;
 	end = data + data_len;
@@ -234,7 +291,7 @@ struct json_token * json_parse(const char *data, size_t data_len)
 		case '[': /* start array */
 		case '{': /* start object */
 			if (!curr_token) {
-				token = json_alloc_token(&tokens);
+				token = json_alloc_token(&arena);
 				if (!token)
 					goto fail;
 				if (!root)
@@ -259,7 +316,7 @@ struct json_token * json_parse(const char *data, size_t data_len)
 			}
 			token->type = *pos == '[' ? JSON_ARRAY : JSON_OBJECT;
 			token->state = JSON_STARTED;
-			token->child = json_alloc_token(&tokens);
+			token->child = json_alloc_token(&arena);
 			if (!token->child)
 				goto fail;
 			curr_token = token->child;
@@ -289,21 +346,18 @@ struct json_token * json_parse(const char *data, size_t data_len)
 			    !curr_token->child->sibling) {
 				/* Remove pending child token since the
 				 * array/object was empty. */
-				json_free(curr_token->child);
 				curr_token->child = NULL;
 			}
 			curr_token->state = JSON_COMPLETED;
 			break;
 		case '\"': /* string */
-			str = json_parse_string(&pos, end);
+			str = json_parse_string(&pos, end, &arena);
 			if (!str)
 				goto fail;
 			if (!curr_token) {
-				token = json_alloc_token(&tokens);
-				if (!token) {
-					os_free(str);
+				token = json_alloc_token(&arena);
+				if (!token)
 					goto fail;
-				}
 				token->type = JSON_STRING;
 				token->string = str;
 				token->state = JSON_COMPLETED;
@@ -332,7 +386,6 @@ struct json_token * json_parse(const char *data, size_t data_len)
 			} else {
 				wpa_printf(MSG_DEBUG,
 					   "JSON: Invalid state for a string");
-				os_free(str);
 				goto fail;
 			}
 			break;
@@ -350,7 +403,7 @@ struct json_token * json_parse(const char *data, size_t data_len)
 		case ',': /* member separator */
 			if (!curr_token)
 				goto fail;
-			curr_token->sibling = json_alloc_token(&tokens);
+			curr_token->sibling = json_alloc_token(&arena);
 			if (!curr_token->sibling)
 				goto fail;
 			curr_token->sibling->parent = curr_token->parent;
@@ -371,7 +424,7 @@ struct json_token * json_parse(const char *data, size_t data_len)
 				goto fail;
 			}
 			if (!curr_token) {
-				token = json_alloc_token(&tokens);
+				token = json_alloc_token(&arena);
 				if (!token)
 					goto fail;
 				curr_token = token;
@@ -423,7 +476,7 @@ struct json_token * json_parse(const char *data, size_t data_len)
 			if (json_parse_number(&pos, end, &num) < 0)
 				goto fail;
 			if (!curr_token) {
-				token = json_alloc_token(&tokens);
+				token = json_alloc_token(&arena);
 				if (!token)
 					goto fail;
 				token->type = JSON_NUMBER;
@@ -470,22 +523,25 @@ struct json_token * json_parse(const char *data, size_t data_len)
 		goto fail;
 	}
 
+	if (!root)
+		os_free(arena.tokens);
 	return root;
 fail:
 	wpa_printf(MSG_DEBUG, "JSON: Parsing failed");
-	json_free(root);
+	os_free(arena.tokens);
 	return NULL;
 }
 
 
+/**
+ * json_free - Free a parsed JSON tree
+ * @json: Root token returned by json_parse() or %NULL
+ *
+ * The tokens and strings of the tree are in the same allocation as the root
+ * token, so this must not be called for any other token of the tree.
+ */
 void json_free(struct json_token *json)
 {
-	if (!json)
-		return;
-	json_free(json->child);
-	json_free(json->sibling);
-	os_free(json->name);
-	os_free(json->string);
 	os_free(json);
 }
 
@@ -0,0 +1,110 @@
+/*
+ * Memory accounting per subsystem
+ *
+ * This software may be distributed under the terms of the BSD license.
+ * See README for more details.
+ */
+
+#include "includes.h"
+
+#include "common.h"
+#include "memstat.h"
+
+
+struct memstat_counter {
+	size_t live; /* bytes in live objects */
+	size_t peak; /* highest value of live */
+	unsigned int count; /* number of live objects */
+	unsigned long allocs; /* number of allocations */
+};
+
+static struct memstat_counter memstat[MEMSTAT_NUM_TAGS];
+
+static const char *memstat_name[MEMSTAT_NUM_TAGS] = {
+	[MEMSTAT_WPABUF] = "wpabuf",
+	[MEMSTAT_BSS] = "bss",
+	[MEMSTAT_STA_INFO] = "sta_info",
+	[MEMSTAT_PMKSA] = "pmksa",
+	[MEMSTAT_EAP] = "eap",
+};
+
+
+/**
+ * memstat_alloc - Account an allocated object
+ * @tag: Subsystem of the object
+ * @len: Size of the object in bytes
+ */
+void memstat_alloc(enum memstat_tag tag, size_t len)
+{
+	struct memstat_counter *c = &memstat[tag];
+
+	c->live += len;
+	if (c->live > c->peak)
+		c->peak = c->live;
+	c->count++;
+	c->allocs++;
+}
+
+
+/**
+ * memstat_free - Account a freed object
+ * @tag: Subsystem of the object
+ * @len: Size of the object in bytes as given to memstat_alloc()
+ */
+void memstat_free(enum memstat_tag tag, size_t len)
+{
+	struct memstat_counter *c = &memstat[tag];
+
+	c->live -= len;
+	c->count--;
+}
+
+
+/**
+ * memstat_resize - Account a change in the size of an object
+ * @tag: Subsystem of the object
+ * @old_len: Previous size of the object in bytes
+ * @new_len: New size of the object in bytes
+ */
+void memstat_resize(enum memstat_tag tag, size_t old_len, size_t new_len)
+{
+	struct memstat_counter *c = &memstat[tag];
+
+	c->live += new_len - old_len;
+	if (c->live > c->peak)
+		c->peak = c->live;
+}
+
+
+/**
+ * memstat_print - Print the memory accounting counters
+ * @buf: Buffer for the text
+ * @buflen: Length of the buffer
+ * Returns: Number of bytes written to buf
+ *
+ * Each subsystem is printed on its own line as
+ * "<name> live=<bytes> peak=<bytes> count=<objects> avg=<bytes per object>
+ * allocs=<allocations>". For sta_info, avg is the memory per STA entry
+ * including the optional per-STA structures that are accounted with it.
+ */
+int memstat_print(char *buf, size_t buflen)
+{
+	char *pos = buf, *end = buf + buflen;
+	int i, ret;
+
+	for (i = 0; i < MEMSTAT_NUM_TAGS; i++) {
+		ret = os_snprintf(pos, end - pos,
+				  "%s live=%zu peak=%zu count=%u avg=%zu "
+				  "allocs=%lu\n",
+				  memstat_name[i], memstat[i].live,
+				  memstat[i].peak, memstat[i].count,
+				  memstat[i].count ?
+				  memstat[i].live / memstat[i].count : 0,
+				  memstat[i].allocs);
+		if (os_snprintf_error(end - pos, ret))
+			break;
+		pos += ret;
+	}
+
+	return pos - buf;
+}
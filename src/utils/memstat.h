@@ -0,0 +1,52 @@
+/*
+ * Memory accounting per subsystem
+ *
+ * This software may be distributed under the terms of the BSD license.
+ * See README for more details.
+ */
+
+#ifndef MEMSTAT_H
+#define MEMSTAT_H
+
+/*
+ * With CONFIG_MEMSTAT, the main long-lived objects are accounted when they
+ * are allocated and freed. This gives the number of live objects and bytes
+ * and the high-water mark of the bytes for each subsystem. The counters are
+ * process wide and cover memory owned by the objects themselves, e.g., a BSS
+ * entry with its IEs, not everything allocated on their behalf.
+ */
+
+enum memstat_tag {
+	MEMSTAT_WPABUF,
+	MEMSTAT_BSS,
+	MEMSTAT_STA_INFO,
+	MEMSTAT_PMKSA,
+	MEMSTAT_EAP,
+	MEMSTAT_NUM_TAGS
+};
+
+#ifdef CONFIG_MEMSTAT
+
+void memstat_alloc(enum memstat_tag tag, size_t len);
+void memstat_free(enum memstat_tag tag, size_t len);
+void memstat_resize(enum memstat_tag tag, size_t old_len, size_t new_len);
+int memstat_print(char *buf, size_t buflen);
+
+#else /* CONFIG_MEMSTAT */
+
+static inline void memstat_alloc(enum memstat_tag tag, size_t len)
+{
+}
+
+static inline void memstat_free(enum memstat_tag tag, size_t len)
+{
+}
+
+static inline void memstat_resize(enum memstat_tag tag, size_t old_len,
+				  size_t new_len)
+{
+}
+
+#endif /* CONFIG_MEMSTAT */
+
+#endif /* MEMSTAT_H */
@@ -17,4 +17,18 @@ int wps_module_tests(void);
 int common_module_tests(void);
 int crypto_module_tests(void);
 
+/*
+ * Microbenchmark helpers for the module tests. Each benchmark runs for a short
+ * fixed time and the resulting rate is only logged.
+ */
+struct module_bench {
+	const char *name;
+	struct os_reltime start;
+	unsigned int count;
+};
+
+void module_bench_start(struct module_bench *b, const char *name);
+bool module_bench_continue(struct module_bench *b);
+void module_bench_report(struct module_bench *b);
+
 #endif /* MODULE_TESTS_H */
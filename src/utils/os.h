@@ -390,6 +390,15 @@ void * os_memset(void *s, int c, size_t n);
  */
 int os_memcmp(const void *s1, const void *s2, size_t n);
 
+/**
+ * os_memchr - Locate an octet in a memory area
+ * @s: Buffer
+ * @c: Octet to search for
+ * @n: Number of octets to search
+ * Returns: Pointer to the first matching octet or %NULL if not found
+ */
+void * os_memchr(const void *s, int c, size_t n);
+
 /**
  * os_strdup - Duplicate a string
  * @s: Source string
@@ -500,6 +509,8 @@ void * os_malloc(size_t size);
 void * os_realloc(void *ptr, size_t size);
 void os_free(void *ptr);
 char * os_strdup(const char *s);
+/* Number of os_malloc() calls since the program was started */
+unsigned long os_alloc_count(void);
 #else /* WPA_TRACE */
 #ifndef os_malloc
 #define os_malloc(s) malloc((s))
@@ -531,6 +542,9 @@ char * os_strdup(const char *s);
 #ifndef os_memcmp
 #define os_memcmp(s1, s2, n) memcmp((s1), (s2), (n))
 #endif
+#ifndef os_memchr
+#define os_memchr(s, c, n) memchr((s), (c), (n))
+#endif
 
 #ifndef os_strlen
 #define os_strlen(s) strlen(s)
@@ -664,6 +678,7 @@ int os_exec(const char *program, const char *arg, int wait_completion);
 #define memmove OS_DO_NOT_USE_memmove
 #define memset OS_DO_NOT_USE_memset
 #define memcmp OS_DO_NOT_USE_memcmp
+#define memchr OS_DO_NOT_USE_memchr
 #undef strdup
 #define strdup OS_DO_NOT_USE_strdup
 #define strlen OS_DO_NOT_USE_strlen
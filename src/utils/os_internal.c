@@ -335,6 +335,19 @@ int os_memcmp(const void *s1, const void *s2, size_t n)
 }
 
 
+void * os_memchr(const void *s, int c, size_t n)
+{
+	const unsigned char *p = s;
+
+	for (; n; n--, p++) {
+		if (*p == (unsigned char) c)
+			return (void *) p;
+	}
+
+	return NULL;
+}
+
+
 char * os_strdup(const char *s)
 {
 	char *res;
@@ -162,6 +162,12 @@ int os_memcmp(const void *s1, const void *s2, size_t n)
 }
 
 
+void * os_memchr(const void *s, int c, size_t n)
+{
+	return NULL;
+}
+
+
 char * os_strdup(const char *s)
 {
 	return NULL;
@@ -35,6 +35,7 @@
 #include "list.h"
 
 static struct dl_list alloc_list = DL_LIST_HEAD_INIT(alloc_list);
+static unsigned long alloc_count;
 
 #define ALLOC_MAGIC 0xa84ef1b2
 #define FREED_MAGIC 0x67fd487a
@@ -764,10 +765,17 @@ void * os_malloc(size_t size)
 	dl_list_add(&alloc_list, &a->list);
 	a->len = size;
 	wpa_trace_record(a);
+	alloc_count++;
 	return a + 1;
 }
 
 
+unsigned long os_alloc_count(void)
+{
+	return alloc_count;
+}
+
+
 void * os_realloc(void *ptr, size_t size)
 {
 	struct os_alloc_trace *a;
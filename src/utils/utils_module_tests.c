@@ -254,7 +254,7 @@ static int ext_password_tests(void)
 {
 	struct ext_password_data *data;
 	int ret = 0;
-	struct wpabuf *pw;
+	struct wpabuf *pw, *pw2;
 
 	wpa_printf(MSG_INFO, "ext_password tests");
 
@@ -272,6 +272,26 @@ static int ext_password_tests(void)
 
 	ext_password_deinit(data);
 
+	/* Repeated requests return separate copies of the same password */
+	data = ext_password_init("test", "foo=bar");
+	if (data == NULL)
+		return -1;
+	pw = ext_password_get(data, "foo");
+	pw2 = ext_password_get(data, "foo");
+	if (!pw || !pw2 || pw == pw2 || wpabuf_len(pw) != 3 ||
+	    os_memcmp(wpabuf_head(pw), "bar", 3) != 0)
+		ret = -1;
+	ext_password_free(pw);
+	if (!pw2 || wpabuf_len(pw2) != 3 ||
+	    os_memcmp(wpabuf_head(pw2), "bar", 3) != 0)
+		ret = -1;
+	ext_password_free(pw2);
+	pw = ext_password_get(data, "unknown");
+	if (pw)
+		ret = -1;
+	ext_password_free(pw);
+	ext_password_deinit(data);
+
 	pw = ext_password_get(NULL, "foo");
 	if (pw != NULL)
 		ret = -1;
@@ -557,6 +577,41 @@ static int wpabuf_tests(void)
 	if (buf != NULL)
 		errors++;
 
+	/* Reused buffers are cleared and data is kept over resizes */
+	buf = wpabuf_alloc(50);
+	if (buf) {
+		os_memset(wpabuf_put(buf, 50), 0xaa, 50);
+		wpabuf_free(buf);
+	}
+	buf = wpabuf_alloc(60);
+	if (buf) {
+		const u8 *pos;
+		size_t i;
+
+		pos = wpabuf_put(buf, 60);
+		for (i = 0; i < 60; i++) {
+			if (pos[i])
+				break;
+		}
+		if (i < 60 || wpabuf_size(buf) != 60)
+			errors++;
+		os_memset(wpabuf_mhead(buf), 0x55, 60);
+		if (wpabuf_resize(&buf, 100) < 0 ||
+		    wpabuf_size(buf) != 160 ||
+		    wpabuf_head_u8(buf)[59] != 0x55 ||
+		    wpabuf_tailroom(buf) != 100 ||
+		    *(u8 *) wpabuf_put(buf, 100) != 0)
+			errors++;
+		else if (wpabuf_resize(&buf, 5000) < 0 ||
+			 wpabuf_size(buf) != 5160 ||
+			 wpabuf_head_u8(buf)[0] != 0x55 ||
+			 wpabuf_head_u8(buf)[159] != 0)
+			errors++;
+		wpabuf_free(buf);
+	} else {
+		errors++;
+	}
+
 	if (errors) {
 		wpa_printf(MSG_ERROR, "%d wpabuf test(s) failed", errors);
 		return -1;
@@ -827,8 +882,203 @@ static void eloop_tests_run(void *eloop_data, void *user_ctx)
 }
 
 
+static void eloop_test_dummy_timeout(void *eloop_data, void *user_ctx)
+{
+	wpa_printf(MSG_ERROR, "%s: FAIL - should not have called this function",
+		   __func__);
+}
+
+
+static int eloop_timeout_tests(void)
+{
+	int i, errors = 0;
+	u8 ctx[100];
+	struct os_reltime remaining;
+
+	wpa_printf(MSG_INFO, "eloop timeout bookkeeping tests");
+
+	for (i = 0; i < (int) ARRAY_SIZE(ctx); i++)
+		eloop_register_timeout(1000 + i % 7, i, eloop_test_dummy_timeout,
+				       &ctx[i], &ctx[i % 3]);
+	for (i = 0; i < (int) ARRAY_SIZE(ctx); i++) {
+		if (!eloop_is_timeout_registered(eloop_test_dummy_timeout,
+						 &ctx[i], &ctx[i % 3])) {
+			wpa_printf(MSG_ERROR, "eloop timeout %d not found", i);
+			errors++;
+		}
+	}
+	if (eloop_is_timeout_registered(eloop_test_dummy_timeout, &ctx[1],
+					&ctx[0]))
+		errors++;
+
+	if (eloop_cancel_timeout(eloop_test_dummy_timeout, &ctx[0],
+				 &ctx[0]) != 1)
+		errors++;
+	if (eloop_cancel_timeout_one(eloop_test_dummy_timeout, &ctx[1],
+				     &ctx[1], &remaining) != 1 ||
+	    remaining.sec < 1000)
+		errors++;
+	if (eloop_deplete_timeout(1, 0, eloop_test_dummy_timeout, &ctx[2],
+				  &ctx[2]) != 1 ||
+	    eloop_deplete_timeout(2, 0, eloop_test_dummy_timeout, &ctx[2],
+				  &ctx[2]) != 0 ||
+	    eloop_replenish_timeout(2000, 0, eloop_test_dummy_timeout, &ctx[2],
+				    &ctx[2]) != 1 ||
+	    eloop_replenish_timeout(1, 0, eloop_test_dummy_timeout, &ctx[0],
+				    &ctx[0]) != -1)
+		errors++;
+
+	/* Wildcard cancel of all entries sharing user_data &ctx[1] */
+	if (eloop_cancel_timeout(eloop_test_dummy_timeout, ELOOP_ALL_CTX,
+				 &ctx[1]) != 32)
+		errors++;
+	for (i = 3; i < (int) ARRAY_SIZE(ctx); i++) {
+		if (eloop_is_timeout_registered(eloop_test_dummy_timeout,
+						&ctx[i], &ctx[i % 3]) !=
+		    (i % 3 != 1)) {
+			wpa_printf(MSG_ERROR, "eloop timeout %d state mismatch",
+				   i);
+			errors++;
+		}
+	}
+
+	if (eloop_cancel_timeout(eloop_test_dummy_timeout, ELOOP_ALL_CTX,
+				 ELOOP_ALL_CTX) != 66)
+		errors++;
+	if (eloop_is_timeout_registered(eloop_test_dummy_timeout, &ctx[2],
+					&ctx[2]))
+		errors++;
+
+	if (errors) {
+		wpa_printf(MSG_ERROR, "%d eloop timeout test(s) failed",
+			   errors);
+		return -1;
+	}
+
+	return 0;
+}
+
+
+static void eloop_test_ctx_terminate(void *eloop_data, void *user_ctx)
+{
+	struct eloop_ctx *eloop = eloop_data;
+	int *called = user_ctx;
+
+	(*called)++;
+	eloop_ctx_terminate(eloop);
+}
+
+
+static int eloop_ctx_tests(void)
+{
+	struct eloop_ctx *e1, *e2;
+	int called = 0, errors = 0;
+	u8 ctx;
+
+	wpa_printf(MSG_INFO, "eloop instance tests");
+
+	e1 = eloop_ctx_new();
+	e2 = eloop_ctx_new();
+	if (!e1 || !e2) {
+		eloop_ctx_free(e1);
+		eloop_ctx_free(e2);
+		return -1;
+	}
+
+	eloop_ctx_register_timeout(e1, 0, 0, eloop_test_ctx_terminate, e1,
+				   &called);
+	eloop_ctx_register_timeout(e2, 0, 0, eloop_test_dummy_timeout, &ctx,
+				   NULL);
+	if (eloop_is_timeout_registered(eloop_test_dummy_timeout, &ctx, NULL))
+		errors++;
+
+	eloop_ctx_run(e1);
+	if (called != 1 || eloop_ctx_terminated(e2))
+		errors++;
+	if (!eloop_ctx_is_timeout_registered(e2, eloop_test_dummy_timeout,
+					     &ctx, NULL) ||
+	    eloop_ctx_cancel_timeout(e2, eloop_test_dummy_timeout, &ctx,
+				     NULL) != 1)
+		errors++;
+
+	eloop_ctx_free(e1);
+	eloop_ctx_free(e2);
+
+	if (errors) {
+		wpa_printf(MSG_ERROR, "%d eloop instance test(s) failed",
+			   errors);
+		return -1;
+	}
+
+	return 0;
+}
+
+
+static int eloop_stats_tests(void)
+{
+	struct eloop_ctx *eloop;
+	int called = 0, errors = 0;
+	char buf[500];
+	int len;
+
+	wpa_printf(MSG_INFO, "eloop statistics tests");
+
+	eloop = eloop_ctx_new();
+	if (!eloop)
+		return -1;
+
+	len = eloop_ctx_stats_get(eloop, buf, sizeof(buf));
+	if (len <= 0 || os_strcmp(buf, "enabled=0\n") != 0)
+		errors++;
+
+	if (eloop_ctx_stats_enable(eloop, 0) < 0) {
+		eloop_ctx_free(eloop);
+		return -1;
+	}
+	eloop_ctx_register_timeout(eloop, 0, 0, eloop_test_dummy_timeout,
+				   eloop, NULL);
+	eloop_ctx_register_timeout(eloop, 0, 0, eloop_test_dummy_timeout,
+				   eloop, &called);
+	eloop_ctx_register_timeout(eloop, 0, 1, eloop_test_ctx_terminate,
+				   eloop, &called);
+	eloop_ctx_run(eloop);
+
+	len = eloop_ctx_stats_get(eloop, buf, sizeof(buf));
+	if (called != 1 || len <= 0 || len >= (int) sizeof(buf) ||
+	    !os_strstr(buf, "enabled=1\n") ||
+	    !os_strstr(buf, "\ntimeouts=3\n"))
+		errors++;
+	/* Both handlers are listed with their own invocation counts */
+	if (!os_strstr(buf, "timeout handler=") ||
+	    !os_strstr(buf, " count=2 ") || !os_strstr(buf, " count=1 "))
+		errors++;
+
+	eloop_ctx_stats_disable(eloop);
+	len = eloop_ctx_stats_get(eloop, buf, sizeof(buf));
+	if (len <= 0 || os_strcmp(buf, "enabled=0\n") != 0)
+		errors++;
+
+	eloop_ctx_free(eloop);
+
+	if (errors) {
+		wpa_printf(MSG_ERROR, "%d eloop statistics test(s) failed",
+			   errors);
+		return -1;
+	}
+
+	return 0;
+}
+
+
 static int eloop_tests(void)
 {
+	if (eloop_timeout_tests() < 0)
+		return -1;
+	if (eloop_ctx_tests() < 0)
+		return -1;
+	if (eloop_stats_tests() < 0)
+		return -1;
+
 	wpa_printf(MSG_INFO, "schedule eloop tests to be run");
 
 	/*
@@ -881,6 +1131,10 @@ static const struct json_test_data json_test_cases[] = {
 	{ "[1,2]", "[1:ARRAY:][2:NUMBER:][2:NUMBER:]" },
 	{ "[\"1\",\"2\"]", "[1:ARRAY:][2:STRING:][2:STRING:]" },
 	{ "[true,false]", "[1:ARRAY:][2:BOOLEAN:][2:BOOLEAN:]" },
+	{ "[\"a,[{\",\"\\\"}\\\\\"]", "[1:ARRAY:][2:STRING:][2:STRING:]" },
+	{ "{\"\\u0041,\":{\"\":[]}}", "[1:OBJECT:][2:OBJECT:A,][3:ARRAY:]" },
+	{ "\"abc", NULL },
+	{ "[\"abc\\", NULL },
 };
 #endif /* CONFIG_JSON */
 
@@ -916,6 +1170,26 @@ static int json_tests(void)
 			return -1;
 
 	}
+
+#ifdef WPA_TRACE
+	{
+		const char *conf =
+			"{\"wi-fi_tech\":\"infra\","
+			"\"discovery\":{\"ssid\":\"test\"},"
+			"\"cred\":{\"akm\":\"psk\","
+			"\"pass\":\"secret passphrase\"}}";
+		unsigned long allocs = os_alloc_count();
+
+		root = json_parse(conf, os_strlen(conf));
+		allocs = os_alloc_count() - allocs;
+		json_free(root);
+		if (!root || allocs != 1) {
+			wpa_printf(MSG_INFO, "JSON parse used %lu allocations",
+				   allocs);
+			return -1;
+		}
+	}
+#endif /* WPA_TRACE */
 #endif /* CONFIG_JSON */
 	return 0;
 }
@@ -1209,6 +1483,44 @@ static int const_time_tests(void)
 }
 
 
+/* Run time of each benchmark */
+#define MODULE_BENCH_DURATION_US 20000
+
+void module_bench_start(struct module_bench *b, const char *name)
+{
+	b->name = name;
+	b->count = 0;
+	os_get_reltime(&b->start);
+}
+
+
+bool module_bench_continue(struct module_bench *b)
+{
+	struct os_reltime now, diff;
+
+	if (b->count++ == 0)
+		return true;
+	os_get_reltime(&now);
+	os_reltime_sub(&now, &b->start, &diff);
+	return diff.sec * 1000000 + diff.usec < MODULE_BENCH_DURATION_US;
+}
+
+
+void module_bench_report(struct module_bench *b)
+{
+	struct os_reltime now, diff;
+	long usec;
+	unsigned int count = b->count - 1;
+
+	os_get_reltime(&now);
+	os_reltime_sub(&now, &b->start, &diff);
+	usec = diff.sec * 1000000 + diff.usec;
+	wpa_printf(MSG_INFO, "benchmark %s: %u ops in %ld us (%lu ops/s)",
+		   b->name, count, usec,
+		   usec > 0 ? (unsigned long) count * 1000000 / usec : 0);
+}
+
+
 int utils_module_tests(void)
 {
 	int ret = 0;
@@ -10,6 +10,16 @@
 
 #include "common.h"
 
+/* These are wrapped by macros in wpa_debug.h to check the debug level before
+ * evaluating the arguments. */
+#undef wpa_printf
+#undef wpa_hexdump
+#undef wpa_hexdump_key
+#undef wpa_hexdump_ascii
+#undef wpa_hexdump_ascii_key
+#undef wpa_hexdump_buf
+#undef wpa_hexdump_buf_key
+
 #ifdef CONFIG_DEBUG_SYSLOG
 #include <syslog.h>
 #endif /* CONFIG_DEBUG_SYSLOG */
@@ -26,11 +36,25 @@ static FILE *wpa_debug_tracing_file = NULL;
 #define WPAS_TRACE_PFX "wpas <%d>: "
 #endif /* CONFIG_DEBUG_LINUX_TRACING */
 
+#ifdef CONFIG_DEBUG_RING
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/stat.h>
+
+#ifndef WPA_DEBUG_RING_SIZE
+#define WPA_DEBUG_RING_SIZE (1024 * 1024)
+#endif /* WPA_DEBUG_RING_SIZE */
+#define WPA_DEBUG_RING_LINE 512
+#define WPA_DEBUG_RING_HEX 64
+#endif /* CONFIG_DEBUG_RING */
+
 
 int wpa_debug_level = MSG_INFO;
 int wpa_debug_show_keys = 0;
 int wpa_debug_timestamp = 0;
 int wpa_debug_syslog = 0;
+/* Number of outputs that record messages regardless of wpa_debug_level */
+int wpa_debug_all_levels = 0;
 #ifndef CONFIG_NO_STDOUT_DEBUG
 static FILE *out_file = NULL;
 #endif /* CONFIG_NO_STDOUT_DEBUG */
@@ -179,6 +203,7 @@ int wpa_debug_open_linux_tracing(void)
 		printf("failed to fdopen()\n");
 		return -1;
 	}
+	wpa_debug_all_levels++;
 
 	return 0;
 }
@@ -190,11 +215,107 @@ void wpa_debug_close_linux_tracing(void)
 		return;
 	fclose(wpa_debug_tracing_file);
 	wpa_debug_tracing_file = NULL;
+	wpa_debug_all_levels--;
 }
 
 #endif /* CONFIG_DEBUG_LINUX_TRACING */
 
 
+#ifdef CONFIG_DEBUG_RING
+
+static char *wpa_debug_ring = NULL;
+static size_t wpa_debug_ring_pos;
+static int wpa_debug_ring_wrapped;
+static char *wpa_debug_ring_path = NULL;
+
+
+static void wpa_debug_ring_add(const char *buf, size_t len)
+{
+	size_t left = WPA_DEBUG_RING_SIZE - wpa_debug_ring_pos;
+
+	if (len > left) {
+		os_memcpy(wpa_debug_ring + wpa_debug_ring_pos, buf, left);
+		buf += left;
+		len -= left;
+		wpa_debug_ring_pos = 0;
+		wpa_debug_ring_wrapped = 1;
+	}
+	os_memcpy(wpa_debug_ring + wpa_debug_ring_pos, buf, len);
+	wpa_debug_ring_pos += len;
+}
+
+
+static size_t wpa_debug_ring_prefix(char *buf, size_t buflen, int level)
+{
+	struct os_time tv;
+	int ret;
+
+	os_get_time(&tv);
+	ret = os_snprintf(buf, buflen, "%ld.%06u <%d>: ", (long) tv.sec,
+			  (unsigned int) tv.usec, level);
+	if (os_snprintf_error(buflen, ret))
+		return 0;
+	return ret;
+}
+
+
+static void wpa_debug_ring_vprintf(int level, const char *fmt, va_list ap)
+{
+	char buf[WPA_DEBUG_RING_LINE];
+	size_t len;
+	int ret;
+
+	len = wpa_debug_ring_prefix(buf, sizeof(buf), level);
+	ret = vsnprintf(buf + len, sizeof(buf) - len, fmt, ap);
+	if (ret < 0)
+		return;
+	len += ret;
+	if (len > sizeof(buf) - 1)
+		len = sizeof(buf) - 1;
+	buf[len++] = '\n';
+	wpa_debug_ring_add(buf, len);
+}
+
+
+static void wpa_debug_ring_hexdump(int level, const char *title,
+				   const char *type, const u8 *data,
+				   size_t len, int show)
+{
+	char buf[WPA_DEBUG_RING_LINE];
+	char *pos, *end;
+	size_t i;
+	int ret;
+
+	pos = buf;
+	end = buf + sizeof(buf) - 1;
+	pos += wpa_debug_ring_prefix(pos, end - pos, level);
+	ret = os_snprintf(pos, end - pos, "%s - %s(len=%lu):", title, type,
+			  (unsigned long) len);
+	if (os_snprintf_error(end - pos, ret))
+		return;
+	pos += ret;
+	if (!data) {
+		ret = os_snprintf(pos, end - pos, " [NULL]");
+	} else if (!show) {
+		ret = os_snprintf(pos, end - pos, " [REMOVED]");
+	} else {
+		for (i = 0; i < len && i < WPA_DEBUG_RING_HEX; i++) {
+			ret = os_snprintf(pos, end - pos, " %02x", data[i]);
+			if (os_snprintf_error(end - pos, ret))
+				break;
+			pos += ret;
+		}
+		ret = os_snprintf(pos, end - pos, "%s", i < len ? " ..." : "");
+	}
+	if (!os_snprintf_error(end - pos, ret))
+		pos += ret;
+	*pos++ = '\n';
+	wpa_debug_ring_add(buf, pos - buf);
+}
+
+#endif /* CONFIG_DEBUG_RING */
+
+
 /**
  * wpa_printf - conditional printf
  * @level: priority level (MSG_*) of the message
@@ -252,6 +373,14 @@ void wpa_printf(int level, const char *fmt, ...)
 		va_end(ap);
 	}
 #endif /* CONFIG_DEBUG_LINUX_TRACING */
+
+#ifdef CONFIG_DEBUG_RING
+	if (wpa_debug_ring && level >= MSG_MSGDUMP) {
+		va_start(ap, fmt);
+		wpa_debug_ring_vprintf(level, fmt, ap);
+		va_end(ap);
+	}
+#endif /* CONFIG_DEBUG_RING */
 }
 
 
@@ -278,6 +407,11 @@ static void _wpa_hexdump(int level, const char *title, const u8 *buf,
 	}
 #endif /* CONFIG_DEBUG_LINUX_TRACING */
 
+#ifdef CONFIG_DEBUG_RING
+	if (wpa_debug_ring && level >= MSG_MSGDUMP && !only_syslog)
+		wpa_debug_ring_hexdump(level, title, "hexdump", buf, len, show);
+#endif /* CONFIG_DEBUG_RING */
+
 	if (level < wpa_debug_level)
 		return;
 #ifdef CONFIG_ANDROID_LOG
@@ -420,6 +554,13 @@ static void _wpa_hexdump_ascii(int level, const char *title, const void *buf,
 	}
 #endif /* CONFIG_DEBUG_LINUX_TRACING */
 
+#if defined(CONFIG_DEBUG_RING) && !defined(CONFIG_ANDROID_LOG)
+	/* With Android logging, the message is recorded by _wpa_hexdump() */
+	if (wpa_debug_ring && level >= MSG_MSGDUMP)
+		wpa_debug_ring_hexdump(level, title, "hexdump_ascii", buf, len,
+				       show);
+#endif /* CONFIG_DEBUG_RING && !CONFIG_ANDROID_LOG */
+
 	if (level < wpa_debug_level)
 		return;
 #ifdef CONFIG_ANDROID_LOG
@@ -617,6 +758,105 @@ void wpa_debug_close_file(void)
 }
 
 
+#ifdef CONFIG_DEBUG_RING
+
+/**
+ * wpa_debug_ring_dump - Write the debug ring buffer into the dump file
+ * Returns: 0 on success, -1 on failure
+ *
+ * This uses only async-signal-safe functions so that it can be called from
+ * the crash signal handler.
+ */
+int wpa_debug_ring_dump(void)
+{
+	int fd, ret = 0;
+
+	if (!wpa_debug_ring || !wpa_debug_ring_path)
+		return -1;
+
+	fd = open(wpa_debug_ring_path, O_WRONLY | O_CREAT | O_TRUNC,
+		  S_IRUSR | S_IWUSR);
+	if (fd < 0)
+		return -1;
+	if (wpa_debug_ring_wrapped &&
+	    write(fd, wpa_debug_ring + wpa_debug_ring_pos,
+		  WPA_DEBUG_RING_SIZE - wpa_debug_ring_pos) < 0)
+		ret = -1;
+	if (write(fd, wpa_debug_ring, wpa_debug_ring_pos) < 0)
+		ret = -1;
+	close(fd);
+	return ret;
+}
+
+
+static void wpa_debug_ring_crash(int sig)
+{
+	wpa_debug_ring_dump();
+	signal(sig, SIG_DFL);
+	raise(sig);
+}
+
+
+static const int wpa_debug_ring_signals[] = {
+	SIGSEGV, SIGBUS, SIGFPE, SIGILL, SIGABRT
+};
+
+
+/**
+ * wpa_debug_ring_open - Start recording debug messages into a ring buffer
+ * @path: File to write the ring buffer into on crash or on request
+ * Returns: 0 on success, -1 on failure
+ *
+ * All debug messages regardless of debug verbosity (except MSG_EXCESSIVE)
+ * are recorded into a WPA_DEBUG_RING_SIZE byte in-memory buffer. Recording
+ * does not involve stdio or system calls, so it can be enabled on busy
+ * systems that run with a low debug verbosity.
+ */
+int wpa_debug_ring_open(const char *path)
+{
+	size_t i;
+
+	wpa_debug_ring_close();
+
+	wpa_debug_ring_path = os_strdup(path);
+	wpa_debug_ring = os_malloc(WPA_DEBUG_RING_SIZE);
+	if (!wpa_debug_ring_path || !wpa_debug_ring) {
+		os_free(wpa_debug_ring);
+		wpa_debug_ring = NULL;
+		os_free(wpa_debug_ring_path);
+		wpa_debug_ring_path = NULL;
+		return -1;
+	}
+	wpa_debug_ring_pos = 0;
+	wpa_debug_ring_wrapped = 0;
+
+	for (i = 0; i < ARRAY_SIZE(wpa_debug_ring_signals); i++)
+		signal(wpa_debug_ring_signals[i], wpa_debug_ring_crash);
+	wpa_debug_all_levels++;
+
+	return 0;
+}
+
+
+void wpa_debug_ring_close(void)
+{
+	size_t i;
+
+	if (!wpa_debug_ring)
+		return;
+
+	for (i = 0; i < ARRAY_SIZE(wpa_debug_ring_signals); i++)
+		signal(wpa_debug_ring_signals[i], SIG_DFL);
+	wpa_debug_all_levels--;
+	os_free(wpa_debug_ring);
+	wpa_debug_ring = NULL;
+	os_free(wpa_debug_ring_path);
+	wpa_debug_ring_path = NULL;
+}
+
+#endif /* CONFIG_DEBUG_RING */
+
+
 void wpa_debug_setup_stdout(void)
 {
 #ifndef _WIN32
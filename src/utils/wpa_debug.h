@@ -15,6 +15,7 @@ extern int wpa_debug_level;
 extern int wpa_debug_show_keys;
 extern int wpa_debug_timestamp;
 extern int wpa_debug_syslog;
+extern int wpa_debug_all_levels;
 
 /* Debugging function - conditional printf and hex dump. Driver wrappers can
  * use these for debugging purposes. */
@@ -23,6 +24,17 @@ enum {
 	MSG_EXCESSIVE, MSG_MSGDUMP, MSG_DEBUG, MSG_INFO, MSG_WARNING, MSG_ERROR
 };
 
+/*
+ * Debug messages below WPA_DEBUG_MIN_LEVEL are removed at build time. This can
+ * be set with CONFIG_DEBUG_MIN_LEVEL to, e.g., MSG_DEBUG to remove the
+ * MSG_EXCESSIVE and MSG_MSGDUMP messages from hot paths while keeping the rest
+ * of the debug output available.
+ */
+#ifndef WPA_DEBUG_MIN_LEVEL
+#define WPA_DEBUG_MIN_LEVEL MSG_EXCESSIVE
+#define WPA_DEBUG_ALL_LEVELS_BUILT
+#endif /* WPA_DEBUG_MIN_LEVEL */
+
 #ifdef CONFIG_NO_STDOUT_DEBUG
 
 #define wpa_debug_print_timestamp() do { } while (0)
@@ -43,6 +55,11 @@ static inline int wpa_debug_reopen_file(void)
 	return 0;
 }
 
+static inline int wpa_debug_enabled(int level)
+{
+	return 0;
+}
+
 #else /* CONFIG_NO_STDOUT_DEBUG */
 
 int wpa_debug_open_file(const char *path);
@@ -157,6 +174,52 @@ void wpa_hexdump_ascii_key(int level, const char *title, const void *buf,
  */
 #define wpa_dbg(args...) wpa_msg(args)
 
+/**
+ * wpa_debug_enabled - Check whether debug messages are recorded for a level
+ * @level: priority level (MSG_*) of the message
+ * Returns: 1 if a message at the given level would be written anywhere
+ *
+ * This can be used to skip preparing data that is used only for debug output.
+ * The hexdump functions do this check inline before evaluating their
+ * arguments.
+ */
+static inline int wpa_debug_enabled(int level)
+{
+	return level >= WPA_DEBUG_MIN_LEVEL &&
+		(level >= wpa_debug_level || wpa_debug_all_levels);
+}
+
+#define wpa_hexdump(level, title, buf, len)				\
+	(wpa_debug_enabled(level) ?					\
+	 wpa_hexdump(level, title, buf, len) : (void) 0)
+#define wpa_hexdump_key(level, title, buf, len)			\
+	(wpa_debug_enabled(level) ?					\
+	 wpa_hexdump_key(level, title, buf, len) : (void) 0)
+#define wpa_hexdump_ascii(level, title, buf, len)			\
+	(wpa_debug_enabled(level) ?					\
+	 wpa_hexdump_ascii(level, title, buf, len) : (void) 0)
+#define wpa_hexdump_ascii_key(level, title, buf, len)			\
+	(wpa_debug_enabled(level) ?					\
+	 wpa_hexdump_ascii_key(level, title, buf, len) : (void) 0)
+#define wpa_hexdump_buf(level, title, buf)				\
+	(wpa_debug_enabled(level) ?					\
+	 wpa_hexdump_buf(level, title, buf) : (void) 0)
+#define wpa_hexdump_buf_key(level, title, buf)				\
+	(wpa_debug_enabled(level) ?					\
+	 wpa_hexdump_buf_key(level, title, buf) : (void) 0)
+
+#ifndef WPA_DEBUG_ALL_LEVELS_BUILT
+#define wpa_printf(level, ...)						\
+	((level) >= WPA_DEBUG_MIN_LEVEL ?				\
+	 wpa_printf(level, __VA_ARGS__) : (void) 0)
+#undef wpa_dbg
+#define wpa_dbg(ctx, level, ...)					\
+	do {								\
+		if ((level) >= WPA_DEBUG_MIN_LEVEL)			\
+			wpa_msg(ctx, level, __VA_ARGS__);		\
+	} while (0)
+#endif /* WPA_DEBUG_ALL_LEVELS_BUILT */
+
 #endif /* CONFIG_NO_STDOUT_DEBUG */
 
 
@@ -351,6 +414,30 @@ static inline void wpa_debug_close_linux_tracing(void)
 
 #endif /* CONFIG_DEBUG_LINUX_TRACING */
 
+#if defined(CONFIG_DEBUG_RING) && !defined(CONFIG_NO_STDOUT_DEBUG)
+
+int wpa_debug_ring_open(const char *path);
+void wpa_debug_ring_close(void);
+int wpa_debug_ring_dump(void);
+
+#else /* CONFIG_DEBUG_RING && !CONFIG_NO_STDOUT_DEBUG */
+
+static inline int wpa_debug_ring_open(const char *path)
+{
+	return -1;
+}
+
+static inline void wpa_debug_ring_close(void)
+{
+}
+
+static inline int wpa_debug_ring_dump(void)
+{
+	return -1;
+}
+
+#endif /* CONFIG_DEBUG_RING && !CONFIG_NO_STDOUT_DEBUG */
+
 
 #ifdef EAPOL_TEST
 #define WPA_ASSERT(a)						       \
@@ -10,6 +10,7 @@
 
 #include "common.h"
 #include "trace.h"
+#include "memstat.h"
 #include "wpabuf.h"
 
 #ifdef WPA_TRACE
@@ -27,6 +28,117 @@ static struct wpabuf_trace * wpabuf_get_trace(const struct wpabuf *buf)
 #endif /* WPA_TRACE */
 
 
+#if defined(CONFIG_WPABUF_POOL) && !defined(WPA_TRACE)
+/*
+ * Buffers with small data areas are allocated from size classes and freed
+ * buffers are kept on per-class free lists for reuse. This is not used with
+ * WPA_TRACE so that each buffer remains a separately tracked allocation.
+ *
+ * The size class of a pooled buffer is stored in the flags with 0 meaning
+ * that the buffer is not from the pool. wpabuf_size() still reports the
+ * requested size, so callers do not see the difference.
+ */
+#define WPABUF_POOL_SHIFT 8
+#define WPABUF_POOL_MASK (0xf << WPABUF_POOL_SHIFT)
+#define WPABUF_POOL_MAX_FREE 32
+
+static const size_t wpabuf_pool_size[] = { 64, 128, 256, 512, 1024, 2048 };
+#define WPABUF_POOL_CLASSES ARRAY_SIZE(wpabuf_pool_size)
+
+static struct wpabuf *
+wpabuf_pool_free_list[WPABUF_POOL_CLASSES][WPABUF_POOL_MAX_FREE];
+static unsigned int wpabuf_pool_num_free[WPABUF_POOL_CLASSES];
+
+
+static int wpabuf_pool_class(size_t len)
+{
+	unsigned int i;
+
+	for (i = 0; i < WPABUF_POOL_CLASSES; i++) {
+		if (len <= wpabuf_pool_size[i])
+			return i + 1;
+	}
+	return 0;
+}
+
+
+static int wpabuf_pool_get_class(const struct wpabuf *buf)
+{
+	return (buf->flags & WPABUF_POOL_MASK) >> WPABUF_POOL_SHIFT;
+}
+
+
+static void wpabuf_pool_set_class(struct wpabuf *buf, int cls)
+{
+	buf->flags &= ~WPABUF_POOL_MASK;
+	buf->flags |= cls << WPABUF_POOL_SHIFT;
+}
+
+
+static struct wpabuf * wpabuf_pool_alloc(size_t len)
+{
+	int cls = wpabuf_pool_class(len);
+	struct wpabuf *buf;
+
+	if (!cls)
+		return NULL;
+	if (wpabuf_pool_num_free[cls - 1]) {
+		buf = wpabuf_pool_free_list[cls - 1]
+			[--wpabuf_pool_num_free[cls - 1]];
+	} else {
+		buf = os_malloc(sizeof(struct wpabuf) +
+				wpabuf_pool_size[cls - 1]);
+		if (!buf)
+			return NULL;
+	}
+	/* Match os_zalloc() for the requested part of the buffer */
+	os_memset(buf, 0, sizeof(struct wpabuf) + len);
+	wpabuf_pool_set_class(buf, cls);
+	return buf;
+}
+
+
+static int wpabuf_pool_free(struct wpabuf *buf)
+{
+	int cls = wpabuf_pool_get_class(buf);
+
+	if (!cls || wpabuf_pool_num_free[cls - 1] >= WPABUF_POOL_MAX_FREE)
+		return 0;
+	wpabuf_pool_free_list[cls - 1][wpabuf_pool_num_free[cls - 1]++] = buf;
+	return 1;
+}
+
+
+static int wpabuf_pool_resize(struct wpabuf **_buf, size_t len)
+{
+	struct wpabuf *buf = *_buf;
+	int cls = wpabuf_pool_get_class(buf);
+	int ncls;
+
+	if (!cls)
+		return 0;
+	if (len <= wpabuf_pool_size[cls - 1])
+		return 1;
+
+	/*
+	 * Grow to the next size class that fits instead of to the exact
+	 * length so that repeated small resizes do not reallocate each time.
+	 * Buffers that outgrow the largest class leave the pool and continue
+	 * as normal allocations.
+	 */
+	ncls = wpabuf_pool_class(len);
+	buf = os_realloc(buf, sizeof(struct wpabuf) +
+			 (ncls ? wpabuf_pool_size[ncls - 1] : len));
+	if (!buf)
+		return -1;
+	wpabuf_pool_set_class(buf, ncls);
+	buf->buf = (u8 *) (buf + 1);
+	*_buf = buf;
+	return 1;
+}
+#endif /* CONFIG_WPABUF_POOL && !WPA_TRACE */
+
+
 static void wpabuf_overflow(const struct wpabuf *buf, size_t len)
 {
 #ifdef WPA_TRACE
@@ -68,6 +180,20 @@ int wpabuf_resize(struct wpabuf **_buf, size_t add_len)
 
 	if (buf->used + add_len > buf->size) {
 		unsigned char *nbuf;
+#if defined(CONFIG_WPABUF_POOL) && !defined(WPA_TRACE)
+		int res = wpabuf_pool_resize(_buf, buf->used + add_len);
+
+		if (res < 0)
+			return -1;
+		if (res) {
+			buf = *_buf;
+			os_memset(buf->buf + buf->used, 0, add_len);
+			memstat_resize(MEMSTAT_WPABUF, buf->size,
+				       buf->used + add_len);
+			buf->size = buf->used + add_len;
+			return 0;
+		}
+#endif /* CONFIG_WPABUF_POOL && !WPA_TRACE */
 		if (buf->flags & WPABUF_FLAG_EXT_DATA) {
 			nbuf = os_realloc(buf->buf, buf->used + add_len);
 			if (nbuf == NULL)
@@ -98,6 +224,7 @@ int wpabuf_resize(struct wpabuf **_buf, size_t add_len)
 			buf->buf = (u8 *) (buf + 1);
 			*_buf = buf;
 		}
+		memstat_resize(MEMSTAT_WPABUF, buf->size, buf->used + add_len);
 		buf->size = buf->used + add_len;
 	}
 
@@ -121,13 +248,20 @@ struct wpabuf * wpabuf_alloc(size_t len)
 	trace->magic = WPABUF_MAGIC;
 	buf = (struct wpabuf *) (trace + 1);
 #else /* WPA_TRACE */
-	struct wpabuf *buf = os_zalloc(sizeof(struct wpabuf) + len);
+	struct wpabuf *buf = NULL;
+
+#ifdef CONFIG_WPABUF_POOL
+	buf = wpabuf_pool_alloc(len);
+#endif /* CONFIG_WPABUF_POOL */
+	if (!buf)
+		buf = os_zalloc(sizeof(struct wpabuf) + len);
 	if (buf == NULL)
 		return NULL;
 #endif /* WPA_TRACE */
 
 	buf->size = len;
 	buf->buf = (u8 *) (buf + 1);
+	memstat_alloc(MEMSTAT_WPABUF, sizeof(struct wpabuf) + len);
 	return buf;
 }
 
@@ -152,6 +286,7 @@ struct wpabuf * wpabuf_alloc_ext_data(u8 *data, size_t len)
 	buf->used = len;
 	buf->buf = data;
 	buf->flags |= WPABUF_FLAG_EXT_DATA;
+	memstat_alloc(MEMSTAT_WPABUF, sizeof(struct wpabuf) + len);
 
 	return buf;
 }
@@ -192,14 +327,20 @@ void wpabuf_free(struct wpabuf *buf)
 		wpa_trace_show("wpabuf_free magic mismatch");
 		abort();
 	}
+	memstat_free(MEMSTAT_WPABUF, sizeof(struct wpabuf) + buf->size);
 	if (buf->flags & WPABUF_FLAG_EXT_DATA)
 		os_free(buf->buf);
 	os_free(trace);
 #else /* WPA_TRACE */
 	if (buf == NULL)
 		return;
+	memstat_free(MEMSTAT_WPABUF, sizeof(struct wpabuf) + buf->size);
 	if (buf->flags & WPABUF_FLAG_EXT_DATA)
 		os_free(buf->buf);
+#ifdef CONFIG_WPABUF_POOL
+	else if (wpabuf_pool_free(buf))
+		return;
+#endif /* CONFIG_WPABUF_POOL */
 	os_free(buf);
 #endif /* WPA_TRACE */
 }
@@ -189,6 +189,11 @@ static inline void wpabuf_set(struct wpabuf *buf, const void *data, size_t len)
 	buf->size = buf->used = len;
 }
 
+static inline void wpabuf_reset(struct wpabuf *buf)
+{
+	buf->used = 0;
+}
+
 static inline void wpabuf_put_str(struct wpabuf *dst, const char *str)
 {
 	wpabuf_put_data(dst, str, os_strlen(str));
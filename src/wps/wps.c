@@ -38,7 +38,13 @@ u16 wps_force_encr_types = 0;
  */
 struct wps_data * wps_init(const struct wps_config *cfg)
 {
-	struct wps_data *data = os_zalloc(sizeof(*data));
+	struct wps_data *data;
+
+	if (cfg->registrar &&
+	    !wps_registrar_session_allowed(cfg->wps->registrar))
+		return NULL;
+
+	data = os_zalloc(sizeof(*data));
 	if (data == NULL)
 		return NULL;
 	data->wps = cfg->wps;
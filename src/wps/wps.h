@@ -412,6 +412,23 @@ struct wps_registrar_config {
 	 */
 	int force_per_enrollee_psk;
 
+	/**
+	 * dh_pool_size - Number of precomputed DH key pairs to maintain
+	 *
+	 * The pool is filled in the background from the event loop so that a
+	 * new registration protocol run does not need to wait for a DH key pair
+	 * to be generated. 0 = disabled (generate the keys on demand).
+	 */
+	unsigned int dh_pool_size;
+
+	/**
+	 * max_sessions_per_sec - Limit for new registration protocol runs
+	 *
+	 * New runs beyond this number within a second are rejected to protect
+	 * the event loop during a burst of Enrollees. 0 = unlimited.
+	 */
+	unsigned int max_sessions_per_sec;
+
 	/**
 	 * multi_ap_backhaul_ssid - SSID to supply to a Multi-AP backhaul
 	 * enrollee
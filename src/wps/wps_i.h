@@ -201,6 +201,9 @@ enum wps_process_res wps_enrollee_process_msg(struct wps_data *wps,
 					      const struct wpabuf *msg);
 
 /* wps_registrar.c */
+void * wps_registrar_get_dh_key(struct wps_registrar *reg,
+				struct wpabuf **priv, struct wpabuf **pub);
+int wps_registrar_session_allowed(struct wps_registrar *reg);
 struct wpabuf * wps_registrar_get_msg(struct wps_data *wps,
 				      enum wsc_op_code *op_code);
 enum wps_process_res wps_registrar_process_msg(struct wps_data *wps,
@@ -14,6 +14,7 @@
 #include "utils/uuid.h"
 #include "utils/list.h"
 #include "crypto/crypto.h"
+#include "crypto/dh_group5.h"
 #include "crypto/sha256.h"
 #include "crypto/random.h"
 #include "common/ieee802_11_defs.h"
@@ -139,6 +140,13 @@ struct wps_registrar_device {
 };
 
 
+struct wps_dh_key {
+	void *ctx;
+	struct wpabuf *priv;
+	struct wpabuf *pub;
+};
+
+
 struct wps_registrar {
 	struct wps_context *wps;
 
@@ -220,6 +228,16 @@ struct wps_registrar {
 	 * multi_ap_backhaul_network_key in octets
 	 */
 	size_t multi_ap_backhaul_network_key_len;
+
+	/* Precomputed DH key pairs for new registration protocol runs */
+	struct wps_dh_key *dh_pool;
+	unsigned int dh_pool_size;
+	unsigned int dh_pool_count;
+
+	/* Admission control for new registration protocol runs */
+	unsigned int max_sessions_per_sec;
+	unsigned int sessions;
+	struct os_reltime sessions_start;
 };
 
 
@@ -229,6 +247,7 @@ static void wps_registrar_set_selected_timeout(void *eloop_ctx,
 					       void *timeout_ctx);
 static void wps_registrar_remove_pin(struct wps_registrar *reg,
 				     struct wps_uuid_pin *pin);
+static void wps_registrar_dh_pool_refill(void *eloop_ctx, void *timeout_ctx);
 
 
 static void wps_registrar_add_authorized_mac(struct wps_registrar *reg,
@@ -714,6 +733,18 @@ wps_registrar_init(struct wps_context *wps,
 				cfg->multi_ap_backhaul_network_key_len;
 	}
 
+	reg->max_sessions_per_sec = cfg->max_sessions_per_sec;
+	if (cfg->dh_pool_size) {
+		reg->dh_pool = os_calloc(cfg->dh_pool_size,
+					 sizeof(struct wps_dh_key));
+		if (reg->dh_pool) {
+			reg->dh_pool_size = cfg->dh_pool_size;
+			eloop_register_timeout(0, 0,
+					       wps_registrar_dh_pool_refill,
+					       reg, NULL);
+		}
+	}
+
 	if (wps_set_ie(reg)) {
 		wps_registrar_deinit(reg);
 		return NULL;
@@ -749,7 +780,16 @@ void wps_registrar_deinit(struct wps_registrar *reg)
 		return;
 	eloop_cancel_timeout(wps_registrar_pbc_timeout, reg, NULL);
 	eloop_cancel_timeout(wps_registrar_set_selected_timeout, reg, NULL);
+	eloop_cancel_timeout(wps_registrar_dh_pool_refill, reg, NULL);
 	wps_registrar_flush(reg);
+	while (reg->dh_pool_count > 0) {
+		struct wps_dh_key *key = &reg->dh_pool[--reg->dh_pool_count];
+
+		dh5_free(key->ctx);
+		wpabuf_clear_free(key->priv);
+		wpabuf_free(key->pub);
+	}
+	os_free(reg->dh_pool);
 	wpabuf_clear_free(reg->extra_cred);
 	bin_clear_free(reg->multi_ap_backhaul_network_key,
 		       reg->multi_ap_backhaul_network_key_len);
@@ -757,6 +797,106 @@ void wps_registrar_deinit(struct wps_registrar *reg)
 }
 
 
+static void wps_registrar_dh_pool_refill(void *eloop_ctx, void *timeout_ctx)
+{
+	struct wps_registrar *reg = eloop_ctx;
+	struct wps_dh_key *key;
+	struct wpabuf *priv = NULL, *pub = NULL;
+	void *ctx;
+
+	if (reg->dh_pool_count >= reg->dh_pool_size)
+		return;
+
+	ctx = dh5_init(&priv, &pub);
+	pub = wpabuf_zeropad(pub, 192);
+	if (!ctx || !priv || !pub) {
+		wpa_printf(MSG_DEBUG,
+			   "WPS: Failed to generate DH key pair for the pool");
+		dh5_free(ctx);
+		wpabuf_clear_free(priv);
+		wpabuf_free(pub);
+		return;
+	}
+
+	key = &reg->dh_pool[reg->dh_pool_count++];
+	key->ctx = ctx;
+	key->priv = priv;
+	key->pub = pub;
+
+	/*
+	 * Generate one key pair per eloop iteration so that the modexp
+	 * operations do not delay processing of other events.
+	 */
+	if (reg->dh_pool_count < reg->dh_pool_size)
+		eloop_register_timeout(0, 0, wps_registrar_dh_pool_refill,
+				       reg, NULL);
+}
+
+
+/**
+ * wps_registrar_get_dh_key - Take a precomputed DH key pair from the pool
+ * @reg: Registrar data from wps_registrar_init()
+ * @priv: Buffer for returning the private key
+ * @pub: Buffer for returning the public key (zero padded to 192 octets)
+ * Returns: DH context for dh5_derive_shared() or %NULL if the pool is empty
+ *
+ * Each key pair is handed out only once. The pool is refilled in the
+ * background from the event loop.
+ */
+void * wps_registrar_get_dh_key(struct wps_registrar *reg,
+				struct wpabuf **priv, struct wpabuf **pub)
+{
+	struct wps_dh_key *key;
+
+	if (!reg || reg->dh_pool_count == 0)
+		return NULL;
+
+	key = &reg->dh_pool[--reg->dh_pool_count];
+	*priv = key->priv;
+	*pub = key->pub;
+	key->priv = NULL;
+	key->pub = NULL;
+
+	eloop_cancel_timeout(wps_registrar_dh_pool_refill, reg, NULL);
+	eloop_register_timeout(0, 0, wps_registrar_dh_pool_refill, reg, NULL);
+
+	return key->ctx;
+}
+
+
+/**
+ * wps_registrar_session_allowed - Check whether a new session can be started
+ * @reg: Registrar data from wps_registrar_init()
+ * Returns: 1 if a new registration protocol run is allowed, 0 if not
+ *
+ * This enforces the optional limit on new registration protocol runs per
+ * second so that a burst of Enrollees does not starve the event loop.
+ */
+int wps_registrar_session_allowed(struct wps_registrar *reg)
+{
+	struct os_reltime now;
+
+	if (!reg || !reg->max_sessions_per_sec)
+		return 1;
+
+	os_get_reltime(&now);
+	if (os_reltime_expired(&now, &reg->sessions_start, 1)) {
+		reg->sessions_start = now;
+		reg->sessions = 0;
+	}
+
+	if (reg->sessions >= reg->max_sessions_per_sec) {
+		wpa_printf(MSG_DEBUG,
+			   "WPS: Too many new registration protocol runs (limit %u/s) - reject",
+			   reg->max_sessions_per_sec);
+		return 0;
+	}
+
+	reg->sessions++;
+	return 1;
+}
+
+
 static void wps_registrar_invalidate_unused(struct wps_registrar *reg)
 {
 	struct wps_uuid_pin *pin;
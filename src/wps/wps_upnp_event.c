@@ -43,7 +43,8 @@
  * over TCP transaction which requires various states.. It may also need to be
  * retried at a different address (if more than one is available).
  *
- * TODO: As an optimization we could share data between subscribers.
+ * The event data is the same for all subscribers, so it is shared between
+ * their queued events instead of being copied for each of them.
  */
 struct wps_event_ {
 	struct dl_list list;
@@ -51,10 +52,50 @@ struct wps_event_ {
 	unsigned subscriber_sequence;   /* which event for this subscription*/
 	unsigned int retry;             /* which retry */
 	struct subscr_addr *addr;       /* address to connect to */
-	struct wpabuf *data;            /* event data to send */
+	struct upnp_event_data *data;   /* event data to send (shared) */
 	struct http_client *http_event;
 };
 
+struct upnp_event_data {
+	unsigned int refcount;
+	struct wpabuf *buf;
+};
+
+
+/**
+ * wps_upnp_event_data_new - Wrap event data for sharing between subscribers
+ * @buf: Event data (ownership is taken; freed also on failure)
+ * Returns: Event data with one reference or %NULL on failure
+ */
+struct upnp_event_data * wps_upnp_event_data_new(struct wpabuf *buf)
+{
+	struct upnp_event_data *data;
+
+	if (!buf)
+		return NULL;
+	data = os_zalloc(sizeof(*data));
+	if (!data) {
+		wpabuf_free(buf);
+		return NULL;
+	}
+	data->refcount = 1;
+	data->buf = buf;
+	return data;
+}
+
+
+/**
+ * wps_upnp_event_data_unref - Release a reference to event data
+ * @data: Event data from wps_upnp_event_data_new() or %NULL
+ */
+void wps_upnp_event_data_unref(struct upnp_event_data *data)
+{
+	if (!data || --data->refcount)
+		return;
+	wpabuf_free(data->buf);
+	os_free(data);
+}
+
 
 /* event_clean -- clean sockets etc. of event
  * Leaves data, retry count etc. alone.
@@ -75,7 +116,7 @@ static void event_delete(struct wps_event_ *e)
 {
 	wpa_printf(MSG_DEBUG, "WPS UPnP: Delete event %p", e);
 	event_clean(e);
-	wpabuf_free(e->data);
+	wps_upnp_event_data_unref(e->data);
 	os_free(e);
 }
 
@@ -148,7 +189,7 @@ static struct wpabuf * event_build_message(struct wps_event_ *e)
 	char *b;
 
 	buf = wpabuf_alloc(1000 + os_strlen(e->addr->path) +
-			   wpabuf_len(e->data));
+			   wpabuf_len(e->data->buf));
 	if (buf == NULL)
 		return NULL;
 	wpabuf_printf(buf, "NOTIFY %s HTTP/1.1\r\n", e->addr->path);
@@ -164,9 +205,9 @@ static struct wpabuf * event_build_message(struct wps_event_ *e)
 	wpabuf_put_str(buf, "\r\n");
 	wpabuf_printf(buf, "SEQ: %u\r\n", e->subscriber_sequence);
 	wpabuf_printf(buf, "CONTENT-LENGTH: %d\r\n",
-		      (int) wpabuf_len(e->data));
+		      (int) wpabuf_len(e->data->buf));
 	wpabuf_put_str(buf, "\r\n"); /* terminating empty line */
-	wpabuf_put_buf(buf, e->data);
+	wpabuf_put_buf(buf, e->data->buf);
 	return buf;
 }
 
@@ -367,11 +408,11 @@ void wps_upnp_event_send_stop_all(struct upnp_wps_device_sm *sm)
 /**
  * wps_upnp_event_add - Add a new event to a queue
  * @s: Subscription
- * @data: Event data (is copied; caller retains ownership)
+ * @data: Event data (a new reference is taken; caller retains its own)
  * @probereq: Whether this is a Probe Request event
  * Returns: 0 on success, -1 on error, 1 on max event queue limit reached
  */
-int wps_upnp_event_add(struct subscription *s, const struct wpabuf *data,
+int wps_upnp_event_add(struct subscription *s, struct upnp_event_data *data,
 		       int probereq)
 {
 	struct wps_event_ *e;
@@ -407,11 +448,8 @@ int wps_upnp_event_add(struct subscription *s, const struct wpabuf *data,
 		return -1;
 	dl_list_init(&e->list);
 	e->s = s;
-	e->data = wpabuf_dup(data);
-	if (e->data == NULL) {
-		os_free(e);
-		return -1;
-	}
+	e->data = data;
+	data->refcount++;
 	e->subscriber_sequence = s->next_subscriber_sequence++;
 	if (s->next_subscriber_sequence == 0)
 		s->next_subscriber_sequence++;
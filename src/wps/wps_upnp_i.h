@@ -178,7 +178,10 @@ int web_listener_start(struct upnp_wps_device_sm *sm);
 void web_listener_stop(struct upnp_wps_device_sm *sm);
 
 /* wps_upnp_event.c */
-int wps_upnp_event_add(struct subscription *s, const struct wpabuf *data,
+struct upnp_event_data;
+struct upnp_event_data * wps_upnp_event_data_new(struct wpabuf *buf);
+void wps_upnp_event_data_unref(struct upnp_event_data *data);
+int wps_upnp_event_add(struct subscription *s, struct upnp_event_data *data,
 		       int probereq);
 void wps_upnp_event_delete_all(struct subscription *s);
 void wps_upnp_event_send_all_later(struct upnp_wps_device_sm *sm);
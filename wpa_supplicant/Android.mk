@@ -195,10 +195,25 @@ ifdef CONFIG_ELOOP_POLL
 L_CFLAGS += -DCONFIG_ELOOP_POLL
 endif
 
+ifdef CONFIG_WPABUF_POOL
+L_CFLAGS += -DCONFIG_WPABUF_POOL
+endif
+
+ifdef CONFIG_MEMSTAT
+L_CFLAGS += -DCONFIG_MEMSTAT
+OBJS += src/utils/memstat.c
+OBJS_p += src/utils/memstat.c
+OBJS_priv += src/utils/memstat.c
+endif
+
 ifdef CONFIG_ELOOP_EPOLL
 L_CFLAGS += -DCONFIG_ELOOP_EPOLL
 endif
 
+ifdef CONFIG_ELOOP_IO_URING
+L_CFLAGS += -DCONFIG_ELOOP_IO_URING
+endif
+
 ifdef CONFIG_EAPOL_TEST
 L_CFLAGS += -Werror -DEAPOL_TEST
 endif
@@ -243,6 +258,10 @@ ifdef CONFIG_NO_CONFIG_BLOBS
 L_CFLAGS += -DCONFIG_NO_CONFIG_BLOBS
 endif
 
+ifdef CONFIG_CONFIG_JOURNAL
+L_CFLAGS += -DCONFIG_CONFIG_JOURNAL
+endif
+
 ifdef CONFIG_NO_SCAN_PROCESSING
 L_CFLAGS += -DCONFIG_NO_SCAN_PROCESSING
 endif
@@ -379,6 +398,21 @@ ifdef CONFIG_PMKSA_CACHE_EXTERNAL
 L_CFLAGS += -DCONFIG_PMKSA_CACHE_EXTERNAL
 endif
 
+ifdef CONFIG_PMKSA_STORE
+L_CFLAGS += -DCONFIG_PMKSA_STORE
+OBJS += pmksa_store.c
+NEED_AES_SIV=y
+endif
+
+ifdef CONFIG_STATUS_SHM
+L_CFLAGS += -DCONFIG_STATUS_SHM
+OBJS += wpas_status_shm.c
+OBJS += src/common/status_shm.c
+ifdef CONFIG_AP
+OBJS += src/ap/ap_status_shm.c
+endif
+endif
+
 ifndef CONFIG_NO_WPA
 OBJS += src/rsn_supp/wpa.c
 OBJS += src/rsn_supp/preauth.c
@@ -1396,6 +1430,7 @@ endif
 endif
 SHA1OBJS += src/crypto/sha1-prf.c
 ifdef CONFIG_INTERNAL_SHA1
+L_CFLAGS += -DCONFIG_INTERNAL_SHA1
 SHA1OBJS += src/crypto/sha1-internal.c
 ifdef NEED_FIPS186_2_PRF
 SHA1OBJS += src/crypto/fips_prf_internal.c
@@ -1675,6 +1710,14 @@ ifdef CONFIG_DEBUG_LINUX_TRACING
 L_CFLAGS += -DCONFIG_DEBUG_LINUX_TRACING
 endif
 
+ifdef CONFIG_DEBUG_RING
+L_CFLAGS += -DCONFIG_DEBUG_RING
+endif
+
+ifdef CONFIG_DEBUG_MIN_LEVEL
+L_CFLAGS += -DWPA_DEBUG_MIN_LEVEL=$(CONFIG_DEBUG_MIN_LEVEL)
+endif
+
 ifdef CONFIG_DEBUG_FILE
 L_CFLAGS += -DCONFIG_DEBUG_FILE
 endif
@@ -1769,6 +1812,7 @@ endif
 OBJS += src/drivers/driver_common.c
 
 OBJS += wpa_supplicant.c events.c bssid_ignore.c wpas_glue.c scan.c
+OBJS += connect_trace.c
 OBJS_t := $(OBJS) $(OBJS_l2) eapol_test.c
 OBJS_t += src/radius/radius_client.c
 OBJS_t += src/radius/radius.c
@@ -2113,6 +2157,7 @@ LOCAL_C_INCLUDES := $(INCLUDES)
 LOCAL_SRC_FILES := \
     aidl/aidl.cpp \
     aidl/aidl_manager.cpp \
+    aidl/callback_dispatcher.cpp \
     aidl/certificate_utils.cpp \
     aidl/iface_config_utils.cpp \
     aidl/p2p_iface.cpp \
@@ -10,8 +10,10 @@
 #include <functional>
 #include <iostream>
 #include <regex>
+#include <unordered_map>
 
 #include "aidl_manager.h"
+#include "callback_dispatcher.h"
 #include "misc_utils.h"
 #include <android/binder_process.h>
 #include <android/binder_manager.h>
@@ -53,20 +55,6 @@ constexpr bool isP2pIface(const struct wpa_supplicant *wpa_s)
 	return wpa_s->global->p2p_init_wpa_s == wpa_s;
 }
 
-/**
- * Creates a unique key for the network using the provided |ifname| and
- * |network_id| to be used in the internal map of |ISupplicantNetwork| objects.
- * This is of the form |ifname|_|network_id|. For ex: "wlan0_1".
- *
- * @param ifname Name of the corresponding interface.
- * @param network_id ID of the corresponding network.
- */
-const std::string getNetworkObjectMapKey(
-	const std::string &ifname, int network_id)
-{
-	return ifname + "_" + std::to_string(network_id);
-}
-
 /**
  * Add callback to the corresponding list after linking to death on the
  * corresponding aidl object reference.
@@ -122,6 +110,22 @@ int removeAidlObjectFromMap(
 	return 0;
 }
 
+template <class ObjectType>
+int removeNetworkObjectFromMap(
+	uint64_t network_key,
+	std::unordered_map<uint64_t, std::shared_ptr<ObjectType>> &object_map)
+{
+	// Return failure if we dont have an object for that |network_key|.
+	const auto &object_iter = object_map.find(network_key);
+	if (object_iter == object_map.end())
+		return 1;
+	// The object may not have been created yet.
+	if (object_iter->second)
+		object_iter->second->invalidate();
+	object_map.erase(object_iter);
+	return 0;
+}
+
 template <class CallbackType>
 int addIfaceCallbackAidlObjectToMap(
 	AIBinder_DeathRecipient* death_notifier,
@@ -145,21 +149,13 @@ int addIfaceCallbackAidlObjectToMap(
 template <class CallbackType>
 int addNetworkCallbackAidlObjectToMap(
 	AIBinder_DeathRecipient* death_notifier,
-	const std::string &ifname, int network_id,
+	uint64_t network_key,
 	const std::shared_ptr<CallbackType> &callback,
-	std::map<const std::string, std::vector<std::shared_ptr<CallbackType>>>
+	std::unordered_map<uint64_t, std::vector<std::shared_ptr<CallbackType>>>
 	&callbacks_map)
 {
-	if (ifname.empty() || network_id < 0)
-		return 1;
-
-	// Generate the key to be used to lookup the network.
-	const std::string network_key =
-		getNetworkObjectMapKey(ifname, network_id);
-	auto network_callback_map_iter = callbacks_map.find(network_key);
-	if (network_callback_map_iter == callbacks_map.end())
-		return 1;
-	auto &network_callback_list = network_callback_map_iter->second;
+	// The list is created when the first callback is registered.
+	auto &network_callback_list = callbacks_map[network_key];
 
 	// Register for death notification before we add it to our list.
 	return registerForDeathAndAddCallbackAidlObjectToList<CallbackType>(
@@ -194,13 +190,13 @@ int removeAllIfaceCallbackAidlObjectsFromMap(
 template <class CallbackType>
 int removeAllNetworkCallbackAidlObjectsFromMap(
 	AIBinder_DeathRecipient* death_notifier,
-	const std::string &network_key,
-	std::map<const std::string, std::vector<std::shared_ptr<CallbackType>>>
+	uint64_t network_key,
+	std::unordered_map<uint64_t, std::vector<std::shared_ptr<CallbackType>>>
 	&callbacks_map)
 {
 	auto network_callback_map_iter = callbacks_map.find(network_key);
 	if (network_callback_map_iter == callbacks_map.end())
-		return 1;
+		return 0;  // no callbacks were registered
 	const auto &network_callback_list = network_callback_map_iter->second;
 	for (const auto &callback : network_callback_list) {
 		binder_status_t status = AIBinder_linkToDeath(callback->asBinder().get(),
@@ -240,18 +236,11 @@ void removeIfaceCallbackAidlObjectFromMap(
 
 template <class CallbackType>
 void removeNetworkCallbackAidlObjectFromMap(
-	const std::string &ifname, int network_id,
+	uint64_t network_key,
 	const std::shared_ptr<CallbackType> &callback,
-	std::map<const std::string, std::vector<std::shared_ptr<CallbackType>>>
+	std::unordered_map<uint64_t, std::vector<std::shared_ptr<CallbackType>>>
 	&callbacks_map)
 {
-	if (ifname.empty() || network_id < 0)
-		return;
-
-	// Generate the key to be used to lookup the network.
-	const std::string network_key =
-		getNetworkObjectMapKey(ifname, network_id);
-
 	auto network_callback_map_iter = callbacks_map.find(network_key);
 	if (network_callback_map_iter == callbacks_map.end())
 		return;
@@ -264,12 +253,60 @@ void removeNetworkCallbackAidlObjectFromMap(
 		network_callback_list.end());
 }
 
+/**
+ * Get the network object registered with |network_key|. The object is created
+ * on the first lookup, so that networks that are never accessed through
+ * the aidl interface do not need a binder object.
+ */
+template <class ObjectType>
+std::shared_ptr<ObjectType> getOrCreateNetworkObject(
+	struct wpa_global *global, const std::string &ifname, int network_id,
+	uint64_t network_key,
+	std::unordered_map<uint64_t, std::shared_ptr<ObjectType>> &object_map)
+{
+	auto network_object_iter = object_map.find(network_key);
+	if (network_object_iter == object_map.end())
+		return nullptr;
+
+	if (!network_object_iter->second)
+		network_object_iter->second = ndk::SharedRefBase::make<ObjectType>(
+			global, ifname.c_str(), network_id);
+	return network_object_iter->second;
+}
+
+/**
+ * Queue the invocation of |method| on each callback in |callback_list| to the
+ * dispatch thread. The list is copied, so callbacks registered or removed after
+ * this call are not affected.
+ */
+template <class CallbackType>
+void postToEachCallback(
+	CallbackDispatcher &dispatcher, const char *name,
+	const std::string &coalesce_key,
+	const std::function<ndk::ScopedAStatus(std::shared_ptr<CallbackType>)> &method,
+	const std::vector<std::shared_ptr<CallbackType>> &callback_list)
+{
+	if (callback_list.empty())
+		return;
+
+	dispatcher.post(coalesce_key,
+		[name, method, callback_list](CallbackDispatcher &d) {
+			for (const auto &callback : callback_list) {
+				d.invoke(callback->asBinder().get(), name,
+					[&method, &callback] {
+						return method(callback).isOk();
+					});
+			}
+		});
+}
+
 template <class CallbackType>
 void callWithEachIfaceCallback(
+	CallbackDispatcher &dispatcher,
 	const std::string &ifname,
 	const std::function<ndk::ScopedAStatus(std::shared_ptr<CallbackType>)> &method,
 	const std::map<const std::string, std::vector<std::shared_ptr<CallbackType>>>
-	&callbacks_map)
+	&callbacks_map, const std::string &coalesce_key)
 {
 	if (ifname.empty())
 		return;
@@ -277,40 +314,23 @@ void callWithEachIfaceCallback(
 	auto iface_callback_map_iter = callbacks_map.find(ifname);
 	if (iface_callback_map_iter == callbacks_map.end())
 		return;
-	const auto &iface_callback_list = iface_callback_map_iter->second;
-	for (const auto &callback : iface_callback_list) {
-		if (!method(callback).isOk()) {
-			wpa_printf(
-				MSG_ERROR, "Failed to invoke AIDL iface callback");
-		}
-	}
+	postToEachCallback(dispatcher, "iface", coalesce_key, method,
+			   iface_callback_map_iter->second);
 }
 
 template <class CallbackType>
 void callWithEachNetworkCallback(
-	const std::string &ifname, int network_id,
+	CallbackDispatcher &dispatcher, uint64_t network_key,
 	const std::function<
 	ndk::ScopedAStatus(std::shared_ptr<CallbackType>)> &method,
-	const std::map<const std::string, std::vector<std::shared_ptr<CallbackType>>>
+	const std::unordered_map<uint64_t, std::vector<std::shared_ptr<CallbackType>>>
 	&callbacks_map)
 {
-	if (ifname.empty() || network_id < 0)
-		return;
-
-	// Generate the key to be used to lookup the network.
-	const std::string network_key =
-		getNetworkObjectMapKey(ifname, network_id);
 	auto network_callback_map_iter = callbacks_map.find(network_key);
 	if (network_callback_map_iter == callbacks_map.end())
 		return;
-	const auto &network_callback_list = network_callback_map_iter->second;
-	for (const auto &callback : network_callback_list) {
-		if (!method(callback).isOk()) {
-			wpa_printf(
-				MSG_ERROR,
-				"Failed to invoke AIDL network callback");
-		}
-	}
+	postToEachCallback(dispatcher, "network", "", method,
+			   network_callback_map_iter->second);
 }
 
 int parseGsmAuthNetworkRequest(
@@ -410,6 +430,27 @@ void AidlManager::destroyInstance()
 	instance_ = NULL;
 }
 
+/**
+ * Creates a unique key for the network using the provided |ifname| and
+ * |network_id| to be used in the internal maps of network objects. The upper
+ * 32 bits contain an index assigned to |ifname| and the lower 32 bits contain
+ * |network_id|.
+ *
+ * @param ifname Name of the corresponding interface.
+ * @param network_id ID of the corresponding network.
+ */
+uint64_t AidlManager::getNetworkKey(const std::string &ifname, int network_id)
+{
+	// Interface indexes are not reused, so the keys of any remaining
+	// networks of a removed interface cannot refer to a new interface.
+	auto iface_index_iter = iface_index_map_.find(ifname);
+	if (iface_index_iter == iface_index_map_.end())
+		iface_index_iter = iface_index_map_.emplace(
+			ifname, (uint32_t) iface_index_map_.size()).first;
+	return ((uint64_t) iface_index_iter->second << 32) |
+		(uint32_t) network_id;
+}
+
 /**
  * Check that the AIDL service is running at least the expected version.
  * Use to avoid the case where the AIDL interface version
@@ -557,6 +598,7 @@ int AidlManager::unregisterInterface(struct wpa_supplicant *wpa_s)
 	callWithEachSupplicantCallback(std::bind(
 		&ISupplicantCallback::onInterfaceRemoved, std::placeholders::_1,
 		misc_utils::charBufToString(wpa_s->ifname)));
+	callback_dispatcher_.logStats();
 	return 0;
 }
 
@@ -575,15 +617,12 @@ int AidlManager::registerNetwork(
 	if (!wpa_s || !ssid)
 		return 1;
 
-	// Generate the key to be used to lookup the network.
-	const std::string network_key =
-		getNetworkObjectMapKey(wpa_s->ifname, ssid->id);
+	// Generate the key to be used to lookup the network. The network
+	// object itself is created on the first lookup.
+	const uint64_t network_key = getNetworkKey(wpa_s->ifname, ssid->id);
 
 	if (isP2pIface(wpa_s)) {
-		if (addAidlObjectToMap<P2pNetwork>(
-			network_key,
-			ndk::SharedRefBase::make<P2pNetwork>(wpa_s->global, wpa_s->ifname, ssid->id),
-			p2p_network_object_map_)) {
+		if (!p2p_network_object_map_.emplace(network_key, nullptr).second) {
 			wpa_printf(
 				MSG_ERROR,
 				"Failed to register P2P network with AIDL "
@@ -592,10 +631,7 @@ int AidlManager::registerNetwork(
 			return 1;
 		}
 	} else {
-		if (addAidlObjectToMap<StaNetwork>(
-			network_key,
-			ndk::SharedRefBase::make<StaNetwork>(wpa_s->global, wpa_s->ifname, ssid->id),
-			sta_network_object_map_)) {
+		if (!sta_network_object_map_.emplace(network_key, nullptr).second) {
 			wpa_printf(
 				MSG_ERROR,
 				"Failed to register STA network with AIDL "
@@ -603,8 +639,6 @@ int AidlManager::registerNetwork(
 				ssid->id);
 			return 1;
 		}
-		sta_network_callbacks_map_[network_key] =
-			std::vector<std::shared_ptr<ISupplicantStaNetworkCallback>>();
 		// Invoke the |onNetworkAdded| method on all registered
 		// callbacks.
 		callWithEachStaIfaceCallback(
@@ -632,11 +666,10 @@ int AidlManager::unregisterNetwork(
 		return 1;
 
 	// Generate the key to be used to lookup the network.
-	const std::string network_key =
-		getNetworkObjectMapKey(wpa_s->ifname, ssid->id);
+	const uint64_t network_key = getNetworkKey(wpa_s->ifname, ssid->id);
 
 	if (isP2pIface(wpa_s)) {
-		if (removeAidlObjectFromMap(
+		if (removeNetworkObjectFromMap(
 			network_key, p2p_network_object_map_)) {
 			wpa_printf(
 				MSG_ERROR,
@@ -646,7 +679,7 @@ int AidlManager::unregisterNetwork(
 			return 1;
 		}
 	} else {
-		if (removeAidlObjectFromMap(
+		if (removeNetworkObjectFromMap(
 			network_key, sta_network_object_map_)) {
 			wpa_printf(
 				MSG_ERROR,
@@ -787,8 +820,14 @@ int AidlManager::notifyStateChange(struct wpa_supplicant *wpa_s)
 			&ISupplicantStaIfaceCallback::onSupplicantStateChanged,
 			std::placeholders::_1,
 			aidl_state_change_data);
+	// Consecutive notifications of the same state for the same network
+	// are redundant; only the latest one needs to be delivered.
+	const std::string ifname = misc_utils::charBufToString(wpa_s->ifname);
 	callWithEachStaIfaceCallback(
-		misc_utils::charBufToString(wpa_s->ifname), func);
+		ifname, func,
+		"state:" + ifname + ":" +
+		std::to_string(aidl_state_change_data.id) + ":" +
+		std::to_string(wpa_s->wpa_state));
 	return 0;
 }
 
@@ -808,8 +847,7 @@ int AidlManager::notifyNetworkRequest(
 	if (!wpa_s || !ssid)
 		return 1;
 
-	const std::string network_key =
-		getNetworkObjectMapKey(wpa_s->ifname, ssid->id);
+	const uint64_t network_key = getNetworkKey(wpa_s->ifname, ssid->id);
 	if (sta_network_object_map_.find(network_key) ==
 		sta_network_object_map_.end())
 		return 1;
@@ -2345,15 +2383,13 @@ int AidlManager::getP2pNetworkAidlObjectByIfnameAndNetworkId(
 	if (ifname.empty() || network_id < 0 || !network_object)
 		return 1;
 
-	// Generate the key to be used to lookup the network.
-	const std::string network_key =
-		getNetworkObjectMapKey(ifname, network_id);
-
-	auto network_object_iter = p2p_network_object_map_.find(network_key);
-	if (network_object_iter == p2p_network_object_map_.end())
+	std::shared_ptr<P2pNetwork> network = getOrCreateNetworkObject(
+		wpa_global_, ifname, network_id,
+		getNetworkKey(ifname, network_id), p2p_network_object_map_);
+	if (!network)
 		return 1;
 
-	*network_object = network_object_iter->second;
+	*network_object = network;
 	return 0;
 }
 
@@ -2374,15 +2410,13 @@ int AidlManager::getStaNetworkAidlObjectByIfnameAndNetworkId(
 	if (ifname.empty() || network_id < 0 || !network_object)
 		return 1;
 
-	// Generate the key to be used to lookup the network.
-	const std::string network_key =
-		getNetworkObjectMapKey(ifname, network_id);
-
-	auto network_object_iter = sta_network_object_map_.find(network_key);
-	if (network_object_iter == sta_network_object_map_.end())
+	std::shared_ptr<StaNetwork> network = getOrCreateNetworkObject(
+		wpa_global_, ifname, network_id,
+		getNetworkKey(ifname, network_id), sta_network_object_map_);
+	if (!network)
 		return 1;
 
-	*network_object = network_object_iter->second;
+	*network_object = network;
 	return 0;
 }
 
@@ -2414,6 +2448,7 @@ int AidlManager::registerNonStandardCertCallbackAidlObject(
 {
 	if (callback == nullptr) return 1;
 	non_standard_cert_callback_ = callback;
+	certificate_utils::flushCertificateCache();
 	return 0;
 }
 
@@ -2465,8 +2500,15 @@ int AidlManager::addStaNetworkCallbackAidlObject(
 	const std::string &ifname, int network_id,
 	const std::shared_ptr<ISupplicantStaNetworkCallback> &callback)
 {
+	if (ifname.empty() || network_id < 0)
+		return 1;
+
+	const uint64_t network_key = getNetworkKey(ifname, network_id);
+	if (sta_network_object_map_.find(network_key) ==
+		sta_network_object_map_.end())
+		return 1;
 	return addNetworkCallbackAidlObjectToMap(
-		death_notifier_, ifname, network_id, callback,
+		death_notifier_, network_key, callback,
 		sta_network_callbacks_map_);
 }
 
@@ -2565,8 +2607,12 @@ void AidlManager::removeStaNetworkCallbackAidlObject(
 	const std::string &ifname, int network_id,
 	const std::shared_ptr<ISupplicantStaNetworkCallback> &callback)
 {
+	if (ifname.empty() || network_id < 0)
+		return;
+
 	return removeNetworkCallbackAidlObjectFromMap(
-		ifname, network_id, callback, sta_network_callbacks_map_);
+		getNetworkKey(ifname, network_id), callback,
+		sta_network_callbacks_map_);
 }
 
 /**
@@ -2579,11 +2625,8 @@ void AidlManager::removeStaNetworkCallbackAidlObject(
 void AidlManager::callWithEachSupplicantCallback(
 	const std::function<ndk::ScopedAStatus(std::shared_ptr<ISupplicantCallback>)> &method)
 {
-	for (const auto &callback : supplicant_callbacks_) {
-		if (!method(callback).isOk()) {
-			wpa_printf(MSG_ERROR, "Failed to invoke AIDL callback");
-		}
-	}
+	postToEachCallback(callback_dispatcher_, "supplicant", "", method,
+			   supplicant_callbacks_);
 }
 
 /**
@@ -2600,7 +2643,8 @@ void AidlManager::callWithEachP2pIfaceCallback(
 	const std::function<ndk::ScopedAStatus(std::shared_ptr<ISupplicantP2pIfaceCallback>)>
 	&method)
 {
-	callWithEachIfaceCallback(ifname, method, p2p_iface_callbacks_map_);
+	callWithEachIfaceCallback(callback_dispatcher_, ifname, method,
+				  p2p_iface_callbacks_map_, "");
 }
 
 /**
@@ -2611,13 +2655,16 @@ void AidlManager::callWithEachP2pIfaceCallback(
  * @param ifname Name of the corresponding interface.
  * @param method Pointer to the required aidl method from
  * |ISupplicantIfaceCallback|.
+ * @param coalesce_key Key for replacing an identical event that has not been
+ * delivered yet, or empty to deliver every event.
  */
 void AidlManager::callWithEachStaIfaceCallback(
 	const std::string &ifname,
 	const std::function<ndk::ScopedAStatus(std::shared_ptr<ISupplicantStaIfaceCallback>)>
-	&method)
+	&method, const std::string &coalesce_key)
 {
-	callWithEachIfaceCallback(ifname, method, sta_iface_callbacks_map_);
+	callWithEachIfaceCallback(callback_dispatcher_, ifname, method,
+				  sta_iface_callbacks_map_, coalesce_key);
 }
 
 /**
@@ -2635,8 +2682,12 @@ void AidlManager::callWithEachStaNetworkCallback(
 	const std::function<
 	ndk::ScopedAStatus(std::shared_ptr<ISupplicantStaNetworkCallback>)> &method)
 {
+	if (ifname.empty() || network_id < 0)
+		return;
+
 	callWithEachNetworkCallback(
-		ifname, network_id, method, sta_network_callbacks_map_);
+		callback_dispatcher_, getNetworkKey(ifname, network_id), method,
+		sta_network_callbacks_map_);
 }
 
 void AidlManager::notifyQosPolicyReset(
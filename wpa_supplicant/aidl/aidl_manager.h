@@ -11,11 +11,13 @@
 
 #include <map>
 #include <string>
+#include <unordered_map>
 
 #include <aidl/android/hardware/wifi/supplicant/ISupplicantP2pIfaceCallback.h>
 #include <aidl/android/hardware/wifi/supplicant/ISupplicantStaIfaceCallback.h>
 #include <aidl/android/hardware/wifi/supplicant/ISupplicantStaNetworkCallback.h>
 
+#include "callback_dispatcher.h"
 #include "certificate_utils.h"
 #include "p2p_iface.h"
 #include "p2p_network.h"
@@ -211,6 +213,7 @@ private:
 
 	struct wpa_supplicant *getTargetP2pIfaceForGroup(
 		struct wpa_supplicant *wpa_s);
+	uint64_t getNetworkKey(const std::string &ifname, int network_id);
 	void removeSupplicantCallbackAidlObject(
 		const std::shared_ptr<ISupplicantCallback> &callback);
 	void removeP2pIfaceCallbackAidlObject(
@@ -233,7 +236,8 @@ private:
 	void callWithEachStaIfaceCallback(
 		const std::string &ifname,
 		const std::function<ndk::ScopedAStatus(
-		std::shared_ptr<ISupplicantStaIfaceCallback>)> &method);
+		std::shared_ptr<ISupplicantStaIfaceCallback>)> &method,
+		const std::string &coalesce_key = "");
 	void callWithEachStaNetworkCallback(
 		const std::string &ifname, int network_id,
 		const std::function<::ndk::ScopedAStatus(
@@ -241,6 +245,8 @@ private:
 
 	// Singleton instance of this class.
 	static AidlManager *instance_;
+	// Delivers the callbacks outside of the event loop thread.
+	CallbackDispatcher callback_dispatcher_;
 	// Death notifier.
 	AIBinder_DeathRecipient* death_notifier_;
 	// The main aidl service object.
@@ -255,15 +261,21 @@ private:
 	// |ifname|.
 	std::map<const std::string, std::shared_ptr<StaIface>>
 		sta_iface_object_map_;
+	// Index of each |ifname| used in the network keys.
+	std::map<const std::string, uint32_t> iface_index_map_;
 	// Map of all the P2P network specific aidl objects controlled by
-	// wpa_supplicant. This map is keyed in by the corresponding
-	// |ifname| & |network_id|.
-	std::map<const std::string, std::shared_ptr<P2pNetwork>>
+	// wpa_supplicant. This map is keyed in by getNetworkKey() of the
+	// corresponding |ifname| & |network_id|. The objects are created
+	// on first use, so the value is null for a network that has not been
+	// accessed yet.
+	std::unordered_map<uint64_t, std::shared_ptr<P2pNetwork>>
 		p2p_network_object_map_;
 	// Map of all the STA network specific aidl objects controlled by
-	// wpa_supplicant. This map is keyed in by the corresponding
-	// |ifname| & |network_id|.
-	std::map<const std::string, std::shared_ptr<StaNetwork>>
+	// wpa_supplicant. This map is keyed in by getNetworkKey() of the
+	// corresponding |ifname| & |network_id|. The objects are created
+	// on first use, so the value is null for a network that has not been
+	// accessed yet.
+	std::unordered_map<uint64_t, std::shared_ptr<StaNetwork>>
 		sta_network_object_map_;
 
 	// Callbacks registered for the main aidl service object.
@@ -284,9 +296,10 @@ private:
 		sta_iface_callbacks_map_;
 	// Map of all the callbacks registered for STA network specific
 	// aidl objects controlled by wpa_supplicant.  This map is keyed in by
-	// the corresponding |ifname| & |network_id|.
-	std::map<
-		const std::string,
+	// getNetworkKey() of the corresponding |ifname| & |network_id| and has
+	// entries only for the networks with registered callbacks.
+	std::unordered_map<
+		uint64_t,
 		std::vector<std::shared_ptr<ISupplicantStaNetworkCallback>>>
 		sta_network_callbacks_map_;
 	// NonStandardCertCallback registered by the client.
@@ -0,0 +1,160 @@
+/*
+ * WPA Supplicant - Asynchronous dispatch of Aidl callbacks
+ *
+ * This software may be distributed under the terms of the BSD license.
+ * See README for more details.
+ */
+
+#include "callback_dispatcher.h"
+
+extern "C"
+{
+#include "utils/includes.h"
+#include "utils/common.h"
+}
+
+namespace {
+// Maximum number of tasks waiting for the dispatch thread. The oldest task is
+// dropped if a client does not keep up.
+constexpr size_t kMaxQueuedTasks = 1024;
+// Callbacks taking longer than this are logged and counted as slow.
+constexpr std::chrono::milliseconds kSlowCallbackThreshold(500);
+}  // namespace
+
+namespace aidl {
+namespace android {
+namespace hardware {
+namespace wifi {
+namespace supplicant {
+
+CallbackDispatcher::CallbackDispatcher()
+	: thread_(&CallbackDispatcher::run, this)
+{
+}
+
+CallbackDispatcher::~CallbackDispatcher()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		stop_ = true;
+	}
+	cv_.notify_one();
+	// The remaining tasks are delivered before the thread exits.
+	thread_.join();
+	logStats();
+}
+
+void CallbackDispatcher::post(const std::string &coalesce_key, Task task)
+{
+	uint64_t dropped = 0;
+
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+
+		posted_++;
+		if (!coalesce_key.empty() && !queue_.empty() &&
+		    queue_.back().coalesce_key == coalesce_key) {
+			// Keep the queue position and time of the earlier event
+			// so that the reported latency covers the whole wait.
+			queue_.back().task = std::move(task);
+			coalesced_++;
+			return;
+		}
+		if (queue_.size() >= kMaxQueuedTasks) {
+			queue_.pop_front();
+			dropped = ++dropped_;
+		}
+		queue_.push_back({coalesce_key, std::move(task),
+				  std::chrono::steady_clock::now()});
+	}
+	cv_.notify_one();
+
+	if (dropped == 1 || (dropped && dropped % 100 == 0))
+		wpa_printf(MSG_INFO,
+			   "AIDL callback queue full - dropped %llu events",
+			   (unsigned long long) dropped);
+}
+
+void CallbackDispatcher::invoke(const void *client, const char *name,
+				const Invoker &invoker)
+{
+	const auto start = std::chrono::steady_clock::now();
+	const bool ok = invoker();
+	const auto end = std::chrono::steady_clock::now();
+	const auto call_time =
+		std::chrono::duration_cast<std::chrono::microseconds>(
+			end - start);
+	const auto latency =
+		std::chrono::duration_cast<std::chrono::microseconds>(
+			end - current_queued_);
+	const bool slow = call_time >= kSlowCallbackThreshold;
+
+	if (!ok)
+		wpa_printf(MSG_ERROR, "Failed to invoke AIDL %s callback",
+			   name);
+	if (slow)
+		wpa_printf(MSG_INFO,
+			   "AIDL %s callback to %p took %lld ms", name, client,
+			   (long long) (call_time.count() / 1000));
+
+	std::lock_guard<std::mutex> lock(mutex_);
+	ClientStats &stats = client_stats_[client];
+	stats.calls++;
+	if (!ok)
+		stats.failures++;
+	if (slow)
+		stats.slow++;
+	stats.total_latency += latency;
+	if (latency > stats.max_latency)
+		stats.max_latency = latency;
+}
+
+void CallbackDispatcher::logStats()
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+
+	wpa_printf(MSG_DEBUG,
+		   "AIDL callback queue: posted=%llu coalesced=%llu dropped=%llu queued=%zu",
+		   (unsigned long long) posted_,
+		   (unsigned long long) coalesced_,
+		   (unsigned long long) dropped_, queue_.size());
+	for (const auto &entry : client_stats_) {
+		const ClientStats &stats = entry.second;
+
+		wpa_printf(MSG_DEBUG,
+			   "AIDL client %p: calls=%llu failures=%llu slow=%llu avg_latency_us=%lld max_latency_us=%lld",
+			   entry.first, (unsigned long long) stats.calls,
+			   (unsigned long long) stats.failures,
+			   (unsigned long long) stats.slow,
+			   (long long) (stats.calls ?
+					stats.total_latency.count() /
+					(long long) stats.calls : 0),
+			   (long long) stats.max_latency.count());
+	}
+}
+
+void CallbackDispatcher::run()
+{
+	std::unique_lock<std::mutex> lock(mutex_);
+
+	for (;;) {
+		cv_.wait(lock, [this] { return stop_ || !queue_.empty(); });
+		if (queue_.empty())
+			break;
+
+		Entry entry = std::move(queue_.front());
+		queue_.pop_front();
+		current_queued_ = entry.queued;
+
+		// Do not hold the lock over the binder calls.
+		lock.unlock();
+		entry.task(*this);
+		lock.lock();
+	}
+}
+
+}  // namespace supplicant
+}  // namespace wifi
+}  // namespace hardware
+}  // namespace android
+}  // namespace aidl
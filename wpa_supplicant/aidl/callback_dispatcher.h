@@ -0,0 +1,103 @@
+/*
+ * WPA Supplicant - Asynchronous dispatch of Aidl callbacks
+ *
+ * This software may be distributed under the terms of the BSD license.
+ * See README for more details.
+ */
+
+#ifndef WPA_SUPPLICANT_AIDL_CALLBACK_DISPATCHER_H
+#define WPA_SUPPLICANT_AIDL_CALLBACK_DISPATCHER_H
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace aidl {
+namespace android {
+namespace hardware {
+namespace wifi {
+namespace supplicant {
+
+/**
+ * CallbackDispatcher delivers the outbound callbacks from a dedicated thread,
+ * so that a slow or unresponsive client does not block the event loop of
+ * wpa_supplicant. Callbacks are delivered in the order they were posted.
+ */
+class CallbackDispatcher
+{
+public:
+	// Invokes the callback of one client; returns false on failure.
+	using Invoker = std::function<bool()>;
+	// Invokes a callback on all the clients registered at post time.
+	using Task = std::function<void(CallbackDispatcher &)>;
+
+	CallbackDispatcher();
+	~CallbackDispatcher();
+	CallbackDispatcher(const CallbackDispatcher &) = delete;
+	CallbackDispatcher &operator=(const CallbackDispatcher &) = delete;
+
+	/**
+	 * Queue |task| for the dispatch thread.
+	 *
+	 * @param coalesce_key If not empty and the most recently queued task
+	 * that has not been started yet has the same key, that task is replaced
+	 * with |task| instead of queuing a redundant event.
+	 * @param task Task to run on the dispatch thread.
+	 */
+	void post(const std::string &coalesce_key, Task task);
+
+	/**
+	 * Invoke the callback of one client from a task and update the
+	 * statistics of that client.
+	 *
+	 * @param client Identifier of the client, e.g., the binder object.
+	 * @param name Kind of the callback for logging.
+	 * @param invoker Function that invokes the callback.
+	 */
+	void invoke(const void *client, const char *name,
+		    const Invoker &invoker);
+
+	// Write the per-client statistics to the debug log.
+	void logStats();
+
+private:
+	struct Entry {
+		std::string coalesce_key;
+		Task task;
+		std::chrono::steady_clock::time_point queued;
+	};
+
+	struct ClientStats {
+		uint64_t calls = 0;
+		uint64_t failures = 0;
+		uint64_t slow = 0;
+		std::chrono::microseconds total_latency{0};
+		std::chrono::microseconds max_latency{0};
+	};
+
+	void run();
+
+	std::mutex mutex_;
+	std::condition_variable cv_;
+	std::deque<Entry> queue_;
+	// Time at which the task currently being run was queued.
+	std::chrono::steady_clock::time_point current_queued_;
+	std::map<const void *, ClientStats> client_stats_;
+	uint64_t posted_ = 0;
+	uint64_t coalesced_ = 0;
+	uint64_t dropped_ = 0;
+	bool stop_ = false;
+	std::thread thread_;
+};
+
+}  // namespace supplicant
+}  // namespace wifi
+}  // namespace hardware
+}  // namespace android
+}  // namespace aidl
+#endif  // WPA_SUPPLICANT_AIDL_CALLBACK_DISPATCHER_H
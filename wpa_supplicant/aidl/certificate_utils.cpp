@@ -23,6 +23,82 @@ constexpr const char kKeystore2ServiceName[] = "android.system.keystore2.IKeysto
 
 const std::string keystore2_grant_id_prefix("ks2_keystore-engine_grant_id:");
 
+// Certificates are fetched again on every EAP connection attempt, e.g., after
+// each roam. Keep the most recently used ones in PEM format. The cache is
+// flushed when the network certificate configuration changes and when
+// Keystore 2 dies. Keystore 2 does not notify changes to the entries, so the
+// age of the entries is limited as well.
+constexpr const size_t kCertCacheMaxEntries = 8;
+constexpr const int64_t kCertCacheMaxAgeSec = 3600;
+
+struct CachedCert {
+	std::string alias;
+	std::vector<uint8_t> pem;
+	struct os_reltime fetched;
+};
+
+// Protects the cache and the Keystore 2 binder for the death notification
+std::mutex cert_cache_mutex;
+// Most recently used entry first
+std::list<CachedCert> cert_cache;
+::ndk::SpAIBinder keystore2_binder;
+AIBinder_DeathRecipient* keystore2_death_notifier = nullptr;
+
+void onKeystore2Death(void* /* cookie */) {
+	std::lock_guard<std::mutex> lock(cert_cache_mutex);
+	cert_cache.clear();
+	keystore2_binder = ::ndk::SpAIBinder();
+}
+
+std::optional<std::vector<uint8_t>> getCachedCert(const std::string& alias) {
+	std::lock_guard<std::mutex> lock(cert_cache_mutex);
+	struct os_reltime now;
+
+	os_get_reltime(&now);
+	for (auto it = cert_cache.begin(); it != cert_cache.end(); ++it) {
+		if (it->alias != alias)
+			continue;
+		if (os_reltime_expired(&now, &it->fetched, kCertCacheMaxAgeSec)) {
+			cert_cache.erase(it);
+			return std::nullopt;
+		}
+		cert_cache.splice(cert_cache.begin(), cert_cache, it);
+		return it->pem;
+	}
+	return std::nullopt;
+}
+
+void addCachedCert(const std::string& alias, const std::vector<uint8_t>& pem) {
+	std::lock_guard<std::mutex> lock(cert_cache_mutex);
+	CachedCert entry = {alias, pem, {}};
+
+	os_get_reltime(&entry.fetched);
+	cert_cache.remove_if([&alias](const CachedCert& c) { return c.alias == alias; });
+	if (cert_cache.size() >= kCertCacheMaxEntries)
+		cert_cache.pop_back();
+	cert_cache.push_front(std::move(entry));
+}
+
+// Returns the Keystore 2 service. The binder is kept so that the certificate
+// cache can be flushed if the service dies.
+std::shared_ptr<ks2::IKeystoreService> getKeystore2Service() {
+	std::lock_guard<std::mutex> lock(cert_cache_mutex);
+	if (keystore2_binder.get() == nullptr) {
+		::ndk::SpAIBinder binder(AServiceManager_checkService(kKeystore2ServiceName));
+		if (binder.get() == nullptr)
+			return nullptr;
+		if (keystore2_death_notifier == nullptr)
+			keystore2_death_notifier = AIBinder_DeathRecipient_new(onKeystore2Death);
+		if (AIBinder_linkToDeath(binder.get(), keystore2_death_notifier, nullptr) !=
+		    STATUS_OK) {
+			wpa_printf(MSG_WARNING, "Unable to link to Keystore 2 death notification.");
+			return ks2::IKeystoreService::fromBinder(binder);
+		}
+		keystore2_binder = binder;
+	}
+	return ks2::IKeystoreService::fromBinder(keystore2_binder);
+}
+
 ks2::KeyDescriptor mkKeyDescriptor(const std::string& alias) {
 	// If the key_id starts with the grant id prefix, we parse the following string as numeric
 	// grant id. We can then use the grant domain without alias to load the designated key.
@@ -89,8 +165,7 @@ std::optional<std::vector<uint8_t>> convertDerCertToPemOrPassthrough(
 }
 
 std::optional<std::vector<uint8_t>> getKeystore2Cert(const std::string& key) {
-	::ndk::SpAIBinder keystoreBinder(AServiceManager_checkService(kKeystore2ServiceName));
-	auto keystore2 = ks2::IKeystoreService::fromBinder(keystoreBinder);
+	auto keystore2 = getKeystore2Service();
 
 	if (!keystore2) {
 		wpa_printf(MSG_WARNING, "Unable to connect to Keystore 2.");
@@ -170,6 +245,11 @@ namespace certificate_utils {
 
 std::optional<std::vector<uint8_t>> getCertificate(const std::string& alias,
 		const std::shared_ptr<INonStandardCertCallback> &non_standard_callback) {
+	if (auto cached_cert = getCachedCert(alias)) {
+		wpa_printf(MSG_DEBUG, "Use cached certificate for %s", alias.c_str());
+		return cached_cert;
+	}
+
 	std::vector<uint8_t> cert;
 	if (auto ks2_cert = getKeystore2Cert(alias)) {
 		cert = std::move(*ks2_cert);
@@ -181,6 +261,7 @@ std::optional<std::vector<uint8_t>> getCertificate(const std::string& alias,
 	}
 
 	if (auto result_cert = convertDerCertToPemOrPassthrough(cert)) {
+		addCachedCert(alias, *result_cert);
 		return result_cert;
 	} else {
 		wpa_printf(MSG_ERROR, "Conversion to PEM failed.");
@@ -203,6 +284,11 @@ std::optional<std::vector<std::string>> listAliases(const std::string& prefix,
 	return aliases;
 }
 
+void flushCertificateCache() {
+	std::lock_guard<std::mutex> lock(cert_cache_mutex);
+	cert_cache.clear();
+}
+
 }  // namespace certificate_utils
 }  // namespace supplicant
 }  // namespace wifi
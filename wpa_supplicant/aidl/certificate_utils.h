@@ -17,6 +17,8 @@
 #include <openssl/bio.h>
 #include <openssl/pem.h>
 #include <openssl/x509.h>
+#include <list>
+#include <mutex>
 #include <vector>
 
 extern "C"
@@ -34,6 +36,7 @@ namespace certificate_utils {
 		const std::shared_ptr<INonStandardCertCallback> &non_standard_callback);
 	std::optional<std::vector<std::string>> listAliases(const std::string& prefix,
 		const std::shared_ptr<INonStandardCertCallback> &non_standard_callback);
+	void flushCertificateCache();
 }  // namespace certificate_utils
 }  // namespace supplicant
 }  // namespace wifi
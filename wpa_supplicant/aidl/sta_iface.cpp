@@ -2366,7 +2366,6 @@ StaIface::addQosPolicyRequestForScsInternal(const std::vector<QosPolicyScsData>&
 	num_qos_policies = qosPolicyData.size();
 	for (int i = 0; i < num_qos_policies; i++) {
 		struct scs_desc_elem *new_desc_elems;
-		struct active_scs_elem *active_scs_desc;
 		struct tclas_element *elem;
 		bool scsid_active = false;
 		QosPolicyScsRequestStatus status;
@@ -2375,13 +2374,8 @@ StaIface::addQosPolicyRequestForScsInternal(const std::vector<QosPolicyScsData>&
 		desc_elem.scs_id = qosPolicyData[i].policyId;
 		status.policyId = desc_elem.scs_id;
 		desc_elem.request_type = SCS_REQ_ADD;
-		dl_list_for_each(active_scs_desc, &wpa_s->active_scs_ids,
-				 struct active_scs_elem, list) {
-			if (desc_elem.scs_id == active_scs_desc->scs_id) {
-				scsid_active = true;
-				break;
-			}
-		}
+		if (wpas_scs_get_active(wpa_s, desc_elem.scs_id))
+			scsid_active = true;
 
 		if (scsid_active) {
 			wpa_printf(MSG_ERROR, "SCSID %d already active",
@@ -2466,7 +2460,6 @@ StaIface::removeQosPolicyForScsInternal(const std::vector<uint8_t>& scsPolicyIds
 	int count;
 	unsigned int num_scs_ids = 0;
 	std::vector<QosPolicyScsRequestStatus> reports;
-	struct active_scs_elem *scs_desc;
 
 	if (wpa_s->ongoing_scs_req) {
 		wpa_printf(MSG_ERROR, "AIDL: SCS Request already in queue");
@@ -2485,13 +2478,8 @@ StaIface::removeQosPolicyForScsInternal(const std::vector<uint8_t>& scsPolicyIds
 		desc_elem.scs_id = scsPolicyIds[i];
 		status.policyId = scsPolicyIds[i];
 		desc_elem.request_type = SCS_REQ_REMOVE;
-		dl_list_for_each(scs_desc, &wpa_s->active_scs_ids,
-				struct active_scs_elem, list) {
-			if (desc_elem.scs_id == scs_desc->scs_id) {
-				policy_id_exists = true;
-				break;
-			}
-		}
+		if (wpas_scs_get_active(wpa_s, desc_elem.scs_id))
+			policy_id_exists = true;
 		if (policy_id_exists == false) {
 			status.qosPolicyScsRequestStatusCode = QosPolicyScsRequestStatusCode::NOT_EXIST;
 			reports.push_back(status);
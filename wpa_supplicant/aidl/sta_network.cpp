@@ -1328,6 +1328,7 @@ ndk::ScopedAStatus StaNetwork::setEapCACertInternal(const std::string &path)
 		path.c_str(), &(wpa_ssid->eap.cert.ca_cert), "eap ca_cert")) {
 		return createStatus(SupplicantStatusCode::FAILURE_UNKNOWN);
 	}
+	certificate_utils::flushCertificateCache();
 	return ndk::ScopedAStatus::ok();
 }
 
@@ -1338,6 +1339,7 @@ ndk::ScopedAStatus StaNetwork::setEapCAPathInternal(const std::string &path)
 		path.c_str(), &(wpa_ssid->eap.cert.ca_path), "eap ca_path")) {
 		return createStatus(SupplicantStatusCode::FAILURE_UNKNOWN);
 	}
+	certificate_utils::flushCertificateCache();
 	return ndk::ScopedAStatus::ok();
 }
 
@@ -1349,6 +1351,7 @@ ndk::ScopedAStatus StaNetwork::setEapClientCertInternal(const std::string &path)
 		"eap client_cert")) {
 		return createStatus(SupplicantStatusCode::FAILURE_UNKNOWN);
 	}
+	certificate_utils::flushCertificateCache();
 	return ndk::ScopedAStatus::ok();
 }
 
@@ -19,8 +19,19 @@
 #include "scan.h"
 #include "bgscan.h"
 
+#define BGSCAN_LEARN_HASH_SIZE 64
+#define BGSCAN_LEARN_HASH(bssid) ((bssid)[5] & (BGSCAN_LEARN_HASH_SIZE - 1))
+
+/* Maximum number of learned frequencies to scan when the neighbors of the
+ * current BSS are known */
+#define BGSCAN_LEARN_MAX_FREQS 3
+
+/* Maximum number of matching BSSes processed from a scan */
+#define MAX_BSS 50
+
 struct bgscan_learn_bss {
 	struct dl_list list;
+	struct bgscan_learn_bss *hnext; /* next entry in hash table list */
 	u8 bssid[ETH_ALEN];
 	int freq;
 	u8 *neigh; /* num_neigh * ETH_ALEN buffer */
@@ -37,6 +48,7 @@ struct bgscan_learn_data {
 	struct os_reltime last_bgscan;
 	char *fname;
 	struct dl_list bss;
+	struct bgscan_learn_bss *bss_hash[BGSCAN_LEARN_HASH_SIZE];
 	int *supp_freqs;
 	int probe_idx;
 };
@@ -90,7 +102,8 @@ static struct bgscan_learn_bss * bgscan_learn_get_bss(
 {
 	struct bgscan_learn_bss *bss;
 
-	dl_list_for_each(bss, &data->bss, struct bgscan_learn_bss, list) {
+	for (bss = data->bss_hash[BGSCAN_LEARN_HASH(bssid)]; bss;
+	     bss = bss->hnext) {
 		if (ether_addr_equal(bss->bssid, bssid))
 			return bss;
 	}
@@ -98,6 +111,15 @@ static struct bgscan_learn_bss * bgscan_learn_get_bss(
 }
 
 
+static void bgscan_learn_add_bss(struct bgscan_learn_data *data,
+				 struct bgscan_learn_bss *bss)
+{
+	dl_list_add(&data->bss, &bss->list);
+	bss->hnext = data->bss_hash[BGSCAN_LEARN_HASH(bss->bssid)];
+	data->bss_hash[BGSCAN_LEARN_HASH(bss->bssid)] = bss;
+}
+
+
 static int bgscan_learn_load(struct bgscan_learn_data *data)
 {
 	FILE *f;
@@ -132,7 +154,11 @@ static int bgscan_learn_load(struct bgscan_learn_data *data)
 				continue;
 			}
 			bss->freq = atoi(buf + 4 + 18);
-			dl_list_add(&data->bss, &bss->list);
+			if (bgscan_learn_get_bss(data, bss->bssid)) {
+				bss_free(bss);
+				continue;
+			}
+			bgscan_learn_add_bss(data, bss);
 			wpa_printf(MSG_DEBUG, "bgscan learn: Loaded BSS "
 				   "entry: " MACSTR " freq=%d",
 				   MAC2STR(bss->bssid), bss->freq);
@@ -208,13 +234,71 @@ static int in_array(int *array, int val)
 }
 
 
+/*
+ * Predict the frequencies of the likely roaming candidates: the frequencies on
+ * which most neighbors of the current BSS have been seen, including the current
+ * frequency.
+ */
+static int * bgscan_learn_get_neighbor_freqs(struct bgscan_learn_data *data,
+					     size_t *count)
+{
+	struct bgscan_learn_bss *cur, *bss;
+	int freq_list[MAX_BSS + 1], hits[MAX_BSS + 1];
+	size_t i, j, best, num = 0;
+	int *freqs;
+
+	*count = 0;
+	cur = bgscan_learn_get_bss(data, data->wpa_s->bssid);
+	if (!cur || !cur->num_neigh)
+		return NULL;
+
+	freq_list[num] = cur->freq;
+	hits[num++] = 1;
+	for (i = 0; i < cur->num_neigh; i++) {
+		bss = bgscan_learn_get_bss(data, cur->neigh + i * ETH_ALEN);
+		if (!bss)
+			continue;
+		for (j = 0; j < num; j++) {
+			if (freq_list[j] == bss->freq)
+				break;
+		}
+		if (j == num) {
+			if (num == ARRAY_SIZE(freq_list))
+				continue;
+			freq_list[num] = bss->freq;
+			hits[num++] = 0;
+		}
+		hits[j]++;
+	}
+
+	freqs = os_calloc(BGSCAN_LEARN_MAX_FREQS + 1, sizeof(int));
+	if (!freqs)
+		return NULL;
+
+	/* Pick the frequencies with the most neighbors */
+	while (*count < BGSCAN_LEARN_MAX_FREQS && *count < num) {
+		best = 0;
+		for (i = 1; i < num; i++) {
+			if (hits[i] > hits[best])
+				best = i;
+		}
+		freqs[(*count)++] = freq_list[best];
+		hits[best] = -1;
+	}
+
+	return freqs;
+}
+
+
 static int * bgscan_learn_get_freqs(struct bgscan_learn_data *data,
 				    size_t *count)
 {
 	struct bgscan_learn_bss *bss;
 	int *freqs = NULL, *n;
 
-	*count = 0;
+	freqs = bgscan_learn_get_neighbor_freqs(data, count);
+	if (freqs)
+		return freqs;
 
 	dl_list_for_each(bss, &data->bss, struct bgscan_learn_bss, list) {
 		if (in_array(freqs, bss->freq))
@@ -289,8 +373,9 @@ static void bgscan_learn_timeout(void *eloop_ctx, void *timeout_ctx)
 		params.freqs = data->ssid->scan_freq;
 	else {
 		freqs = bgscan_learn_get_freqs(data, &count);
-		wpa_printf(MSG_DEBUG, "bgscan learn: BSSes in this ESS have "
-			   "been seen on %u channels", (unsigned int) count);
+		wpa_printf(MSG_DEBUG, "bgscan learn: Selected %u channels on "
+			   "which BSSes in this ESS have been seen",
+			   (unsigned int) count);
 		freqs = bgscan_learn_get_probe_freq(data, freqs, count);
 
 		msg[0] = '\0';
@@ -488,7 +573,6 @@ static int bgscan_learn_notify_scan(void *priv,
 {
 	struct bgscan_learn_data *data = priv;
 	size_t i, j;
-#define MAX_BSS 50
 	u8 bssid[MAX_BSS * ETH_ALEN];
 	size_t num_bssid = 0;
 
@@ -533,7 +617,7 @@ static int bgscan_learn_notify_scan(void *priv,
 				continue;
 			os_memcpy(bss->bssid, res->bssid, ETH_ALEN);
 			bss->freq = res->freq;
-			dl_list_add(&data->bss, &bss->list);
+			bgscan_learn_add_bss(data, bss);
 		}
 
 		for (j = 0; j < num_bssid; j++) {
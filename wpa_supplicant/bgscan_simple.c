@@ -79,6 +79,7 @@ static void bgscan_simple_timeout(void *eloop_ctx, void *timeout_ctx)
 	struct bgscan_simple_data *data = eloop_ctx;
 	struct wpa_supplicant *wpa_s = data->wpa_s;
 	struct wpa_driver_scan_params params;
+	int *freqs = NULL;
 
 	if (bgscan_simple_btm_query(wpa_s, data))
 		goto scan_ok;
@@ -88,6 +89,8 @@ static void bgscan_simple_timeout(void *eloop_ctx, void *timeout_ctx)
 	params.ssids[0].ssid = data->ssid->ssid;
 	params.ssids[0].ssid_len = data->ssid->ssid_len;
 	params.freqs = data->ssid->scan_freq;
+	if (!params.freqs)
+		params.freqs = freqs = wpas_roam_scan_freqs(wpa_s);
 
 	/* Add OWE transition mode SSID of the current network */
 	wpa_add_owe_scan_ssid(wpa_s, &params, data->ssid,
@@ -102,6 +105,7 @@ static void bgscan_simple_timeout(void *eloop_ctx, void *timeout_ctx)
 	wpa_printf(MSG_DEBUG, "bgscan simple: Request a background scan");
 	if (wpa_supplicant_trigger_scan(wpa_s, &params, true, false)) {
 		wpa_printf(MSG_DEBUG, "bgscan simple: Failed to trigger scan");
+		wpa_s->roam_scan_pending = ROAM_SCAN_NONE;
 		eloop_register_timeout(data->scan_interval, 0,
 				       bgscan_simple_timeout, data, NULL);
 	} else {
@@ -124,6 +128,7 @@ static void bgscan_simple_timeout(void *eloop_ctx, void *timeout_ctx)
 		}
 		os_get_reltime(&data->last_bgscan);
 	}
+	os_free(freqs);
 }
 
 
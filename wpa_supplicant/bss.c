@@ -10,6 +10,8 @@
 
 #include "utils/common.h"
 #include "utils/eloop.h"
+#include "utils/memstat.h"
+#include "utils/crc32.h"
 #include "common/ieee802_11_defs.h"
 #include "drivers/driver.h"
 #include "eap_peer/eap.h"
@@ -20,6 +22,195 @@
 #include "scan.h"
 #include "bssid_ignore.h"
 #include "bss.h"
+#include "interworking.h"
+
+/* Vendor types that are indexed for O(1) lookup in wpa_bss_get_vendor_ie() */
+static const u32 wpa_bss_indexed_vendor_types[] = {
+	WPA_IE_VENDOR_TYPE,
+	WMM_IE_VENDOR_TYPE,
+	WPS_IE_VENDOR_TYPE,
+	P2P_IE_VENDOR_TYPE,
+	WFD_IE_VENDOR_TYPE,
+	HS20_IE_VENDOR_TYPE,
+	OSEN_IE_VENDOR_TYPE,
+	MBO_IE_VENDOR_TYPE,
+	OWE_IE_VENDOR_TYPE,
+	RSNE_OVERRIDE_IE_VENDOR_TYPE,
+	RSNE_OVERRIDE_2_IE_VENDOR_TYPE,
+	RSNXE_OVERRIDE_IE_VENDOR_TYPE,
+	RSN_SELECTION_IE_VENDOR_TYPE,
+};
+
+
+static int wpa_bss_vendor_type_idx(u32 vendor_type)
+{
+	unsigned int i;
+
+	for (i = 0; i < ARRAY_SIZE(wpa_bss_indexed_vendor_types); i++) {
+		if (wpa_bss_indexed_vendor_types[i] == vendor_type)
+			return i;
+	}
+
+	return -1;
+}
+
+
+static unsigned int wpa_bss_bits_set(u32 val)
+{
+	val = val - ((val >> 1) & 0x55555555);
+	val = (val & 0x33333333) + ((val >> 2) & 0x33333333);
+	return (((val + (val >> 4)) & 0x0f0f0f0f) * 0x01010101) >> 24;
+}
+
+
+/* Number of bits set in the bitmap before the specified bit */
+static unsigned int wpa_bss_bit_rank(const u32 *bitmap, u8 bit)
+{
+	unsigned int i, rank = 0;
+
+	for (i = 0; i < bit / 32U; i++)
+		rank += wpa_bss_bits_set(bitmap[i]);
+	return rank + wpa_bss_bits_set(bitmap[bit / 32] & (BIT(bit % 32) - 1));
+}
+
+
+static unsigned int wpa_bss_bitmap_count(const u32 *bitmap)
+{
+	unsigned int i, count = 0;
+
+	for (i = 0; i < 256 / 32; i++)
+		count += wpa_bss_bits_set(bitmap[i]);
+	return count;
+}
+
+
+/* Set a bit in the bitmap and return whether it was already set */
+static bool wpa_bss_bit_test_set(u32 *bitmap, u8 bit)
+{
+	bool set = bitmap[bit / 32] & BIT(bit % 32);
+
+	bitmap[bit / 32] |= BIT(bit % 32);
+	return set;
+}
+
+
+/*
+ * Build the element index of the Probe Response (or Beacon, if no Probe
+ * Response was received) IEs of the BSS entry so that wpa_bss_get_ie() and
+ * related lookups do not need to walk through the IEs on every call. This
+ * needs to be called whenever the first IE field of the entry is modified.
+ */
+static void wpa_bss_index_ies(struct wpa_bss *bss)
+{
+	const u8 *ies = wpa_bss_ie_ptr(bss);
+	const struct element *elem;
+	unsigned int num_ids, num_ext, num, pos;
+	u16 *index;
+	int v;
+
+	os_free(bss->ie_index);
+	bss->ie_index = NULL;
+	os_memset(bss->ie_present, 0, sizeof(bss->ie_present));
+	os_memset(bss->ie_ext_present, 0, sizeof(bss->ie_ext_present));
+	bss->ie_vendor_present = 0;
+
+	/* Fall back to walking through the IEs if offsets do not fit */
+	if (bss->ie_len > 0xffff)
+		return;
+
+	for_each_element(elem, ies, bss->ie_len) {
+		wpa_bss_bit_test_set(bss->ie_present, elem->id);
+		if (elem->id == WLAN_EID_EXTENSION && elem->datalen > 0)
+			wpa_bss_bit_test_set(bss->ie_ext_present,
+					     elem->data[0]);
+		if (elem->id == WLAN_EID_VENDOR_SPECIFIC &&
+		    elem->datalen >= 4 &&
+		    (v = wpa_bss_vendor_type_idx(
+			    WPA_GET_BE32(elem->data))) >= 0)
+			bss->ie_vendor_present |= BIT(v);
+	}
+
+	num_ids = wpa_bss_bitmap_count(bss->ie_present);
+	num_ext = wpa_bss_bitmap_count(bss->ie_ext_present);
+	num = num_ids + num_ext + wpa_bss_bits_set(bss->ie_vendor_present);
+	index = os_malloc((num + 1) * sizeof(u16));
+	if (!index) {
+		os_memset(bss->ie_present, 0, sizeof(bss->ie_present));
+		os_memset(bss->ie_ext_present, 0, sizeof(bss->ie_ext_present));
+		bss->ie_vendor_present = 0;
+		return;
+	}
+	os_memset(index, 0xff, (num + 1) * sizeof(u16));
+
+	for_each_element(elem, ies, bss->ie_len) {
+		u16 off = (const u8 *) elem - ies;
+
+		pos = wpa_bss_bit_rank(bss->ie_present, elem->id);
+		if (index[pos] == 0xffff)
+			index[pos] = off;
+		if (elem->id == WLAN_EID_EXTENSION && elem->datalen > 0) {
+			pos = num_ids + wpa_bss_bit_rank(bss->ie_ext_present,
+							 elem->data[0]);
+			if (index[pos] == 0xffff)
+				index[pos] = off;
+		}
+		if (elem->id == WLAN_EID_VENDOR_SPECIFIC &&
+		    elem->datalen >= 4 &&
+		    (v = wpa_bss_vendor_type_idx(
+			    WPA_GET_BE32(elem->data))) >= 0) {
+			pos = num_ids + num_ext +
+				wpa_bss_bits_set(bss->ie_vendor_present &
+						 (BIT(v) - 1));
+			if (index[pos] == 0xffff)
+				index[pos] = off;
+		}
+	}
+
+	bss->ie_index = index;
+}
+
+
+#ifdef CONFIG_MBO
+static u16 wpa_bss_mbo_assoc_disallow_off(const struct wpa_bss *bss,
+					  const u8 *mbo)
+{
+	const u8 *attr;
+
+	if (!mbo)
+		return 0;
+	attr = mbo_attr_from_mbo_ie(mbo, MBO_ATTR_ID_ASSOC_DISALLOW);
+	if (!attr || attr[1] < 1)
+		return 0;
+	return attr - wpa_bss_ie_ptr(bss);
+}
+#endif /* CONFIG_MBO */
+
+
+/*
+ * Store the location of the MBO attributes used in candidate selection so
+ * that wpas_mbo_check_assoc_disallow() does not need to parse the MBO element
+ * on every call. This needs to be called whenever the IEs of the entry are
+ * modified.
+ */
+static void wpa_bss_parse_mbo(struct wpa_bss *bss)
+{
+#ifdef CONFIG_MBO
+	bss->mbo_parsed = false;
+	bss->mbo_assoc_disallow = 0;
+	bss->mbo_assoc_disallow_beacon = 0;
+
+	/* Fall back to parsing on each use if offsets do not fit */
+	if (bss->ie_len + bss->beacon_ie_len > 0xffff)
+		return;
+
+	bss->mbo_assoc_disallow = wpa_bss_mbo_assoc_disallow_off(
+		bss, wpa_bss_get_vendor_ie(bss, MBO_IE_VENDOR_TYPE));
+	bss->mbo_assoc_disallow_beacon = wpa_bss_mbo_assoc_disallow_off(
+		bss, wpa_bss_get_vendor_ie_beacon(bss, MBO_IE_VENDOR_TYPE));
+	bss->mbo_parsed = true;
+#endif /* CONFIG_MBO */
+}
+
 
 static void wpa_bss_set_hessid(struct wpa_bss *bss)
 {
@@ -136,8 +327,10 @@ int wpa_bss_anqp_unshare_alloc(struct wpa_bss *bss)
 /**
  * wpa_bss_anqp_free - Free an ANQP data structure
  * @anqp: ANQP data structure from wpa_bss_anqp_alloc() or wpa_bss_anqp_clone()
+ *
+ * The data is freed once the last user of a shared instance releases it.
  */
-static void wpa_bss_anqp_free(struct wpa_bss_anqp *anqp)
+void wpa_bss_anqp_free(struct wpa_bss_anqp *anqp)
 {
 #ifdef CONFIG_INTERWORKING
 	struct wpa_bss_anqp_elem *elem;
@@ -162,6 +355,7 @@ static void wpa_bss_anqp_free(struct wpa_bss_anqp *anqp)
 	wpabuf_free(anqp->anqp_3gpp);
 	wpabuf_free(anqp->domain_name);
 	wpabuf_free(anqp->fils_realm_info);
+	interworking_anqp_parsed_free(anqp->parsed);
 
 	while ((elem = dl_list_first(&anqp->anqp_elems,
 				     struct wpa_bss_anqp_elem, list))) {
@@ -205,6 +399,132 @@ wpa_bss_check_pending_connect(struct wpa_supplicant *wpa_s, struct wpa_bss *bss)
 }
 
 
+static unsigned int wpa_bss_hash_bssid(const u8 *bssid)
+{
+	unsigned int i, hash = 0;
+
+	for (i = 0; i < ETH_ALEN; i++)
+		hash = hash * 31 + bssid[i];
+
+	return (hash ^ (hash >> 8)) & (WPA_BSS_HASH_SIZE - 1);
+}
+
+
+static unsigned int wpa_bss_hash_ssid(const u8 *ssid, size_t ssid_len)
+{
+	unsigned int hash = 2166136261U;
+	size_t i;
+
+	/* FNV-1a */
+	for (i = 0; i < ssid_len; i++) {
+		hash ^= ssid[i];
+		hash *= 16777619;
+	}
+
+	return (hash ^ (hash >> 16)) & (WPA_BSS_HASH_SIZE - 1);
+}
+
+
+/* Add an entry to the end of the BSS list and the hash buckets */
+static void wpa_bss_list_add(struct wpa_supplicant *wpa_s,
+			     struct wpa_bss *bss)
+{
+	dl_list_add_tail(&wpa_s->bss, &bss->list);
+	dl_list_add_tail(&wpa_s->bss_hash_bssid[wpa_bss_hash_bssid(bss->bssid)],
+			 &bss->hash_bssid);
+	dl_list_add_tail(&wpa_s->bss_hash_ssid[wpa_bss_hash_ssid(bss->ssid,
+								 bss->ssid_len)],
+			 &bss->hash_ssid);
+}
+
+
+static void wpa_bss_list_del(struct wpa_bss *bss)
+{
+	dl_list_del(&bss->list);
+	dl_list_del(&bss->hash_bssid);
+	dl_list_del(&bss->hash_ssid);
+}
+
+
+static struct wpa_bss_ies * wpa_bss_ies_find(struct wpa_supplicant *wpa_s,
+					     const u8 *data, size_t len,
+					     u32 crc)
+{
+	struct wpa_bss_ies *ies;
+
+	dl_list_for_each(ies, &wpa_s->bss_ies_hash[crc &
+						   (WPA_BSS_HASH_SIZE - 1)],
+			 struct wpa_bss_ies, list) {
+		if (ies->crc == crc && ies->len == len &&
+		    os_memcmp(ies->data, data, len) == 0)
+			return ies;
+	}
+
+	return NULL;
+}
+
+
+static void wpa_bss_ies_unref(struct wpa_bss_ies *ies)
+{
+	if (!ies || --ies->refcnt)
+		return;
+	dl_list_del(&ies->list);
+	memstat_resize(MEMSTAT_BSS, sizeof(*ies) + ies->size, 0);
+	os_free(ies);
+}
+
+
+/*
+ * Set the IEs of a BSS entry from a scan result. A buffer with the same
+ * contents is shared if there is one. Otherwise, the current buffer of the
+ * entry is overwritten if no other entry uses it and it is large enough, or a
+ * new buffer is allocated. The previous IEs are kept on allocation failure.
+ */
+static int wpa_bss_set_ies(struct wpa_supplicant *wpa_s, struct wpa_bss *bss,
+			   const struct wpa_scan_res *res)
+{
+	const u8 *data = (const u8 *) (res + 1);
+	size_t len = res->ie_len + res->beacon_ie_len;
+	struct wpa_bss_ies *ies, *old = bss->ies;
+	u32 crc;
+
+	crc = ieee80211_crc32(data, len);
+	ies = wpa_bss_ies_find(wpa_s, data, len, crc);
+	if (ies) {
+		if (ies != old) {
+			ies->refcnt++;
+			wpa_bss_ies_unref(old);
+		}
+	} else if (old && old->refcnt == 1 && old->size >= len) {
+		ies = old;
+		dl_list_del(&ies->list);
+		os_memcpy(ies->data, data, len);
+		ies->len = len;
+		ies->crc = crc;
+		dl_list_add(&wpa_s->bss_ies_hash[crc & (WPA_BSS_HASH_SIZE - 1)],
+			    &ies->list);
+	} else {
+		ies = os_malloc(sizeof(*ies) + len);
+		if (!ies)
+			return -1;
+		memstat_resize(MEMSTAT_BSS, 0, sizeof(*ies) + len);
+		ies->crc = crc;
+		ies->refcnt = 1;
+		ies->len = len;
+		ies->size = len;
+		os_memcpy(ies->data, data, len);
+		dl_list_add(&wpa_s->bss_ies_hash[crc & (WPA_BSS_HASH_SIZE - 1)],
+			    &ies->list);
+		wpa_bss_ies_unref(old);
+	}
+
+	bss->ies = ies;
+	bss->ie_len = res->ie_len;
+	bss->beacon_ie_len = res->beacon_ie_len;
+	return 0;
+}
+
+
 static void wpa_bss_update_pending_connect(struct wpa_connect_work *cwork,
 					   struct wpa_bss *new_bss)
 {
@@ -238,7 +558,7 @@ void wpa_bss_remove(struct wpa_supplicant *wpa_s, struct wpa_bss *bss,
 	cwork = wpa_bss_check_pending_connect(wpa_s, bss);
 	if (cwork)
 		wpa_bss_update_pending_connect(cwork, NULL);
-	dl_list_del(&bss->list);
+	wpa_bss_list_del(bss);
 	dl_list_del(&bss->list_id);
 	wpa_s->num_bss--;
 	wpa_dbg(wpa_s, MSG_DEBUG, "BSS: Remove id %u BSSID " MACSTR
@@ -285,6 +605,9 @@ void wpa_bss_remove(struct wpa_supplicant *wpa_s, struct wpa_bss *bss,
 		}
 	}
 
+	memstat_free(MEMSTAT_BSS, sizeof(*bss));
+	wpa_bss_ies_unref(bss->ies);
+	os_free(bss->ie_index);
 	os_free(bss);
 }
 
@@ -304,8 +627,19 @@ struct wpa_bss * wpa_bss_get(struct wpa_supplicant *wpa_s, const u8 *bssid,
 
 	if (bssid && !wpa_supplicant_filter_bssid_match(wpa_s, bssid))
 		return NULL;
-	dl_list_for_each(bss, &wpa_s->bss, struct wpa_bss, list) {
-		if ((!bssid || ether_addr_equal(bss->bssid, bssid)) &&
+	if (!bssid) {
+		dl_list_for_each(bss, &wpa_s->bss_hash_ssid[
+					 wpa_bss_hash_ssid(ssid, ssid_len)],
+				 struct wpa_bss, hash_ssid) {
+			if (bss->ssid_len == ssid_len &&
+			    os_memcmp(bss->ssid, ssid, ssid_len) == 0)
+				return bss;
+		}
+		return NULL;
+	}
+	dl_list_for_each(bss, &wpa_s->bss_hash_bssid[wpa_bss_hash_bssid(bssid)],
+			 struct wpa_bss, hash_bssid) {
+		if (ether_addr_equal(bss->bssid, bssid) &&
 		    bss->ssid_len == ssid_len &&
 		    os_memcmp(bss->ssid, ssid, ssid_len) == 0)
 			return bss;
@@ -313,6 +647,39 @@ struct wpa_bss * wpa_bss_get(struct wpa_supplicant *wpa_s, const u8 *bssid,
 	return NULL;
 }
 
+
+static bool wpa_bss_connection_match(struct wpa_bss *bss, const u8 *ssid,
+				     size_t ssid_len)
+{
+#ifdef CONFIG_OWE
+	const u8 *owe, *owe_bssid, *owe_ssid;
+	size_t owe_ssid_len;
+#endif /* CONFIG_OWE */
+
+	if (bss->ssid_len == ssid_len &&
+	    os_memcmp(bss->ssid, ssid, ssid_len) == 0)
+		return true;
+
+#ifdef CONFIG_OWE
+	/* Check if OWE transition mode element is present and matches the
+	 * SSID */
+	owe = wpa_bss_get_vendor_ie(bss, OWE_IE_VENDOR_TYPE);
+	if (!owe)
+		return false;
+
+	if (wpas_get_owe_trans_network(owe, &owe_bssid, &owe_ssid,
+				       &owe_ssid_len))
+		return false;
+
+	if (owe_ssid_len == ssid_len &&
+	    os_memcmp(owe_ssid, ssid, ssid_len) == 0)
+		return true;
+#endif /* CONFIG_OWE */
+
+	return false;
+}
+
+
 /**
  * wpa_bss_get_connection - Fetch a BSS table entry based on BSSID and SSID.
  * @wpa_s: Pointer to wpa_supplicant data
@@ -330,36 +697,22 @@ struct wpa_bss * wpa_bss_get_connection(struct wpa_supplicant *wpa_s,
 					const u8 *ssid, size_t ssid_len)
 {
 	struct wpa_bss *bss;
-#ifdef CONFIG_OWE
-	const u8 *owe, *owe_bssid, *owe_ssid;
-	size_t owe_ssid_len;
-#endif /* CONFIG_OWE */
 
-	if (bssid && !wpa_supplicant_filter_bssid_match(wpa_s, bssid))
+	if (!bssid) {
+		dl_list_for_each(bss, &wpa_s->bss, struct wpa_bss, list) {
+			if (wpa_bss_connection_match(bss, ssid, ssid_len))
+				return bss;
+		}
 		return NULL;
-	dl_list_for_each(bss, &wpa_s->bss, struct wpa_bss, list) {
-		if (bssid && !ether_addr_equal(bss->bssid, bssid))
-			continue;
-
-		if (bss->ssid_len == ssid_len &&
-		    os_memcmp(bss->ssid, ssid, ssid_len) == 0)
-			return bss;
-
-#ifdef CONFIG_OWE
-		/* Check if OWE transition mode element is present and matches
-		 * the SSID */
-		owe = wpa_bss_get_vendor_ie(bss, OWE_IE_VENDOR_TYPE);
-		if (!owe)
-			continue;
-
-		if (wpas_get_owe_trans_network(owe, &owe_bssid, &owe_ssid,
-					       &owe_ssid_len))
-			continue;
+	}
 
-		if (owe_ssid_len == ssid_len &&
-		    os_memcmp(owe_ssid, ssid, ssid_len) == 0)
+	if (!wpa_supplicant_filter_bssid_match(wpa_s, bssid))
+		return NULL;
+	dl_list_for_each(bss, &wpa_s->bss_hash_bssid[wpa_bss_hash_bssid(bssid)],
+			 struct wpa_bss, hash_bssid) {
+		if (ether_addr_equal(bss->bssid, bssid) &&
+		    wpa_bss_connection_match(bss, ssid, ssid_len))
 			return bss;
-#endif /* CONFIG_OWE */
 	}
 	return NULL;
 }
@@ -572,17 +925,22 @@ static struct wpa_bss * wpa_bss_add(struct wpa_supplicant *wpa_s,
 	int ret = 0;
 	const u8 *mld_addr;
 
-	bss = os_zalloc(sizeof(*bss) + res->ie_len + res->beacon_ie_len);
+	bss = os_zalloc(sizeof(*bss));
 	if (bss == NULL)
 		return NULL;
+	if (wpa_bss_set_ies(wpa_s, bss, res) < 0) {
+		os_free(bss);
+		return NULL;
+	}
+	memstat_alloc(MEMSTAT_BSS, sizeof(*bss));
 	bss->id = wpa_s->bss_next_id++;
 	bss->last_update_idx = wpa_s->bss_update_idx;
 	wpa_bss_copy_res(bss, res, fetch_time);
+	bss->prev_level = bss->level;
 	os_memcpy(bss->ssid, ssid, ssid_len);
 	bss->ssid_len = ssid_len;
-	bss->ie_len = res->ie_len;
-	bss->beacon_ie_len = res->beacon_ie_len;
-	os_memcpy(bss->ies, res + 1, res->ie_len + res->beacon_ie_len);
+	wpa_bss_index_ies(bss);
+	wpa_bss_parse_mbo(bss);
 	wpa_bss_set_hessid(bss);
 
 	os_memset(bss->mld_addr, 0, ETH_ALEN);
@@ -601,7 +959,7 @@ static struct wpa_bss * wpa_bss_add(struct wpa_supplicant *wpa_s,
 		wpa_s->conf->bss_max_count = wpa_s->num_bss + 1;
 	}
 
-	dl_list_add_tail(&wpa_s->bss, &bss->list);
+	wpa_bss_list_add(wpa_s, bss);
 	dl_list_add_tail(&wpa_s->bss_id, &bss->list_id);
 	wpa_s->num_bss++;
 
@@ -806,9 +1164,10 @@ wpa_bss_update(struct wpa_supplicant *wpa_s, struct wpa_bss *bss,
 			   MAC2STR(bss->bssid), bss->freq, res->freq);
 	bss->scan_miss_count = 0;
 	bss->last_update_idx = wpa_s->bss_update_idx;
+	bss->prev_level = bss->level;
 	wpa_bss_copy_res(bss, res, fetch_time);
-	/* Move the entry to the end of the list */
-	dl_list_del(&bss->list);
+	/* Move the entry to the end of the list and hash buckets */
+	wpa_bss_list_del(bss);
 #ifdef CONFIG_P2P
 	if (wpa_bss_get_vendor_ie(bss, P2P_IE_VENDOR_TYPE) &&
 	    !wpa_scan_get_vendor_ie(res, P2P_IE_VENDOR_TYPE) &&
@@ -826,60 +1185,13 @@ wpa_bss_update(struct wpa_supplicant *wpa_s, struct wpa_bss *bss,
 			MAC2STR(bss->bssid));
 	} else
 #endif /* CONFIG_P2P */
-	if (bss->ie_len + bss->beacon_ie_len >=
-	    res->ie_len + res->beacon_ie_len) {
-		os_memcpy(bss->ies, res + 1, res->ie_len + res->beacon_ie_len);
-		bss->ie_len = res->ie_len;
-		bss->beacon_ie_len = res->beacon_ie_len;
-	} else {
-		struct wpa_bss *nbss;
-		struct dl_list *prev = bss->list_id.prev;
-		struct wpa_connect_work *cwork;
-		unsigned int i, j;
-		bool update_current_bss = wpa_s->current_bss == bss;
-		bool update_ml_probe_bss = wpa_s->ml_connect_probe_bss == bss;
-		int update_link_bss = -1;
-
-		for (j = 0; j < MAX_NUM_MLD_LINKS; j++) {
-			if (wpa_s->links[j].bss == bss) {
-				update_link_bss = j;
-				break;
-			}
-		}
-
-		cwork = wpa_bss_check_pending_connect(wpa_s, bss);
-
-		for (i = 0; i < wpa_s->last_scan_res_used; i++) {
-			if (wpa_s->last_scan_res[i] == bss)
-				break;
-		}
-
-		dl_list_del(&bss->list_id);
-		nbss = os_realloc(bss, sizeof(*bss) + res->ie_len +
-				  res->beacon_ie_len);
-		if (nbss) {
-			if (i != wpa_s->last_scan_res_used)
-				wpa_s->last_scan_res[i] = nbss;
-
-			if (update_current_bss)
-				wpa_s->current_bss = nbss;
-
-			if (update_ml_probe_bss)
-				wpa_s->ml_connect_probe_bss = nbss;
-
-			if (update_link_bss >= 0)
-				wpa_s->links[update_link_bss].bss = nbss;
-
-			if (cwork)
-				wpa_bss_update_pending_connect(cwork, nbss);
-
-			bss = nbss;
-			os_memcpy(bss->ies, res + 1,
-				  res->ie_len + res->beacon_ie_len);
-			bss->ie_len = res->ie_len;
-			bss->beacon_ie_len = res->beacon_ie_len;
-		}
-		dl_list_add(prev, &bss->list_id);
+	if (wpa_bss_set_ies(wpa_s, bss, res) == 0) {
+		/* The Beacon IEs following the Probe Response IEs are not
+		 * indexed, so the index needs to be updated only if the Probe
+		 * Response IEs changed. */
+		if (changes & WPA_BSS_IES_CHANGED_FLAG)
+			wpa_bss_index_ies(bss);
+		wpa_bss_parse_mbo(bss);
 	}
 	if (changes & WPA_BSS_IES_CHANGED_FLAG) {
 		const u8 *ml_ie, *mld_addr;
@@ -894,7 +1206,7 @@ wpa_bss_update(struct wpa_supplicant *wpa_s, struct wpa_bss *bss,
 				os_memcpy(bss->mld_addr, mld_addr, ETH_ALEN);
 		}
 	}
-	dl_list_add_tail(&wpa_s->bss, &bss->list);
+	wpa_bss_list_add(wpa_s, bss);
 
 	notify_bss_changes(wpa_s, changes, bss);
 
@@ -993,8 +1305,15 @@ void wpa_bss_update_scan_res(struct wpa_supplicant *wpa_s,
 	if (bss == NULL)
 		bss = wpa_bss_add(wpa_s, ssid + 2, ssid[1], res, fetch_time);
 	else {
+		/*
+		 * Only an entry that has already been updated during this
+		 * update round can be in last_scan_res, so avoid the search
+		 * in the common case.
+		 */
+		bool seen = bss->last_update_idx == wpa_s->bss_update_idx;
+
 		bss = wpa_bss_update(wpa_s, bss, res, fetch_time);
-		if (wpa_s->last_scan_res) {
+		if (seen && wpa_s->last_scan_res) {
 			unsigned int i;
 			for (i = 0; i < wpa_s->last_scan_res_used; i++) {
 				if (bss == wpa_s->last_scan_res[i]) {
@@ -1088,12 +1407,16 @@ void wpa_bss_update_end(struct wpa_supplicant *wpa_s, struct scan_info *info,
 		return; /* do not expire entries without new scan */
 
 	dl_list_for_each_safe(bss, n, &wpa_s->bss, struct wpa_bss, list) {
+		/* Entries updated in this round had their scan_miss_count
+		 * cleared and they were moved to the end of the list, so there
+		 * is nothing to check for the rest of the list. */
+		if (bss->last_update_idx == wpa_s->bss_update_idx)
+			break;
 		if (wpa_bss_in_use(wpa_s, bss))
 			continue;
 		if (!wpa_bss_included_in_scan(bss, info))
 			continue; /* expire only BSSes that were scanned */
-		if (bss->last_update_idx < wpa_s->bss_update_idx)
-			bss->scan_miss_count++;
+		bss->scan_miss_count++;
 		if (bss->scan_miss_count >=
 		    wpa_s->conf->bss_expiration_scan_count) {
 			wpa_bss_remove(wpa_s, bss, "no match in scan");
@@ -1157,8 +1480,15 @@ void wpa_bss_flush_by_age(struct wpa_supplicant *wpa_s, int age)
  */
 int wpa_bss_init(struct wpa_supplicant *wpa_s)
 {
+	unsigned int i;
+
 	dl_list_init(&wpa_s->bss);
 	dl_list_init(&wpa_s->bss_id);
+	for (i = 0; i < WPA_BSS_HASH_SIZE; i++) {
+		dl_list_init(&wpa_s->bss_hash_bssid[i]);
+		dl_list_init(&wpa_s->bss_hash_ssid[i]);
+		dl_list_init(&wpa_s->bss_ies_hash[i]);
+	}
 	return 0;
 }
 
@@ -1206,7 +1536,9 @@ struct wpa_bss * wpa_bss_get_bssid(struct wpa_supplicant *wpa_s,
 	struct wpa_bss *bss;
 	if (!wpa_supplicant_filter_bssid_match(wpa_s, bssid))
 		return NULL;
-	dl_list_for_each_reverse(bss, &wpa_s->bss, struct wpa_bss, list) {
+	dl_list_for_each_reverse(bss, &wpa_s->bss_hash_bssid[
+					 wpa_bss_hash_bssid(bssid)],
+				 struct wpa_bss, hash_bssid) {
 		if (ether_addr_equal(bss->bssid, bssid))
 			return bss;
 	}
@@ -1231,7 +1563,9 @@ struct wpa_bss * wpa_bss_get_bssid_latest(struct wpa_supplicant *wpa_s,
 	struct wpa_bss *bss, *found = NULL;
 	if (!wpa_supplicant_filter_bssid_match(wpa_s, bssid))
 		return NULL;
-	dl_list_for_each_reverse(bss, &wpa_s->bss, struct wpa_bss, list) {
+	dl_list_for_each_reverse(bss, &wpa_s->bss_hash_bssid[
+					 wpa_bss_hash_bssid(bssid)],
+				 struct wpa_bss, hash_bssid) {
 		if (!ether_addr_equal(bss->bssid, bssid))
 			continue;
 		if (found == NULL ||
@@ -1323,7 +1657,13 @@ struct wpa_bss * wpa_bss_get_id_range(struct wpa_supplicant *wpa_s,
  */
 const u8 * wpa_bss_get_ie(const struct wpa_bss *bss, u8 ie)
 {
-	return get_ie(wpa_bss_ie_ptr(bss), bss->ie_len, ie);
+	if (!bss->ie_index)
+		return get_ie(wpa_bss_ie_ptr(bss), bss->ie_len, ie);
+
+	if (!(bss->ie_present[ie / 32] & BIT(ie % 32)))
+		return NULL;
+	return wpa_bss_ie_ptr(bss) +
+		bss->ie_index[wpa_bss_bit_rank(bss->ie_present, ie)];
 }
 
 
@@ -1363,7 +1703,16 @@ const u8 * wpa_bss_get_ie_beacon(const struct wpa_bss *bss, u8 ie)
  */
 const u8 * wpa_bss_get_ie_ext(const struct wpa_bss *bss, u8 ext)
 {
-	return get_ie_ext(wpa_bss_ie_ptr(bss), bss->ie_len, ext);
+	unsigned int pos;
+
+	if (!bss->ie_index)
+		return get_ie_ext(wpa_bss_ie_ptr(bss), bss->ie_len, ext);
+
+	if (!(bss->ie_ext_present[ext / 32] & BIT(ext % 32)))
+		return NULL;
+	pos = wpa_bss_bitmap_count(bss->ie_present) +
+		wpa_bss_bit_rank(bss->ie_ext_present, ext);
+	return wpa_bss_ie_ptr(bss) + bss->ie_index[pos];
 }
 
 
@@ -1380,10 +1729,37 @@ const u8 * wpa_bss_get_vendor_ie(const struct wpa_bss *bss, u32 vendor_type)
 {
 	const u8 *ies;
 	const struct element *elem;
+	size_t len;
 
 	ies = wpa_bss_ie_ptr(bss);
+	len = bss->ie_len;
+
+	if (bss->ie_index) {
+		unsigned int pos;
+		int v;
+
+		v = wpa_bss_vendor_type_idx(vendor_type);
+		if (v >= 0) {
+			if (!(bss->ie_vendor_present & BIT(v)))
+				return NULL;
+			pos = wpa_bss_bitmap_count(bss->ie_present) +
+				wpa_bss_bitmap_count(bss->ie_ext_present) +
+				wpa_bss_bits_set(bss->ie_vendor_present &
+						 (BIT(v) - 1));
+			return ies + bss->ie_index[pos];
+		}
+
+		/* Start from the first vendor specific element */
+		if (!(bss->ie_present[WLAN_EID_VENDOR_SPECIFIC / 32] &
+		      BIT(WLAN_EID_VENDOR_SPECIFIC % 32)))
+			return NULL;
+		pos = bss->ie_index[wpa_bss_bit_rank(bss->ie_present,
+						     WLAN_EID_VENDOR_SPECIFIC)];
+		ies += pos;
+		len -= pos;
+	}
 
-	for_each_element_id(elem, WLAN_EID_VENDOR_SPECIFIC, ies, bss->ie_len) {
+	for_each_element_id(elem, WLAN_EID_VENDOR_SPECIFIC, ies, len) {
 		if (elem->datalen >= 4 &&
 		    vendor_type == WPA_GET_BE32(elem->data))
 			return &elem->id;
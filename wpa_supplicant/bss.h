@@ -40,6 +40,8 @@ struct wpa_bss_anqp_elem {
 /**
  * struct wpa_bss_anqp - ANQP data for a BSS entry (struct wpa_bss)
  */
+struct interworking_anqp_parsed;
+
 struct wpa_bss_anqp {
 	/** Number of BSS entries referring to this ANQP data instance */
 	unsigned int users;
@@ -54,6 +56,8 @@ struct wpa_bss_anqp {
 	struct wpabuf *domain_name;
 	struct wpabuf *fils_realm_info;
 	struct dl_list anqp_elems; /* list of struct wpa_bss_anqp_elem */
+	/* Parsed elements for credential matching; built on first use */
+	struct interworking_anqp_parsed *parsed;
 #endif /* CONFIG_INTERWORKING */
 #ifdef CONFIG_HS20
 	struct wpabuf *hs20_capability_list;
@@ -67,6 +71,28 @@ struct wpa_bss_anqp {
 #endif /* CONFIG_HS20 */
 };
 
+/**
+ * struct wpa_bss_ies - IEs of BSS table entries
+ *
+ * The IEs are stored separately from the BSS entries and entries with
+ * identical IEs share the same buffer. The buffers are kept in
+ * struct wpa_supplicant::bss_ies_hash[] by a CRC32 of the contents and freed
+ * when the last entry using them is updated or removed.
+ */
+struct wpa_bss_ies {
+	/** List entry for struct wpa_supplicant::bss_ies_hash[] */
+	struct dl_list list;
+	/** CRC32 of data */
+	u32 crc;
+	/** Number of BSS entries using this buffer */
+	unsigned int refcnt;
+	/** Length of data in octets */
+	size_t len;
+	/** Allocated length of data in octets */
+	size_t size;
+	u8 data[];
+};
+
 /**
  * struct wpa_bss - BSS table
  *
@@ -78,6 +104,10 @@ struct wpa_bss {
 	struct dl_list list;
 	/** List entry for struct wpa_supplicant::bss_id */
 	struct dl_list list_id;
+	/** List entry for struct wpa_supplicant::bss_hash_bssid[] */
+	struct dl_list hash_bssid;
+	/** List entry for struct wpa_supplicant::bss_hash_ssid[] */
+	struct dl_list hash_ssid;
 	/** Unique identifier for this BSS entry */
 	unsigned int id;
 	/** Number of counts without seeing this BSS */
@@ -108,6 +138,8 @@ struct wpa_bss {
 	int noise;
 	/** Signal level */
 	int level;
+	/** Signal level before the latest update */
+	int prev_level;
 	/** Timestamp of last Beacon/Probe Response frame */
 	u64 tsf;
 	/** Whether the Beacon frame data is known to be newer */
@@ -120,10 +152,32 @@ struct wpa_bss {
 	int snr;
 	/** ANQP data */
 	struct wpa_bss_anqp *anqp;
-	/** Length of the following IE field in octets (from Probe Response) */
+	/** Length of the IE field in octets (from Probe Response) */
 	size_t ie_len;
-	/** Length of the following Beacon IE field in octets */
+	/** Length of the Beacon IE field in octets */
 	size_t beacon_ie_len;
+	/** Bitmap of the element IDs present in the first IE field */
+	u32 ie_present[256 / 32];
+	/** Bitmap of the Element ID Extensions present in the first IE field */
+	u32 ie_ext_present[256 / 32];
+	/** Bitmap of the common vendor types present in the first IE field */
+	u16 ie_vendor_present;
+	/**
+	 * Offsets of the first instance of each present element ID, Element
+	 * ID Extension, and common vendor type, in this order and each in
+	 * increasing order of the bit in the matching bitmap; %NULL if the IEs
+	 * are not indexed
+	 */
+	u16 *ie_index;
+	/**
+	 * Offsets of the MBO Association Disallowed attribute from the start
+	 * of the IEs in the first IE field and in the Beacon IE field, or 0 if
+	 * not present; valid only if mbo_parsed is set
+	 */
+	u16 mbo_assoc_disallow;
+	u16 mbo_assoc_disallow_beacon;
+	/** Whether the MBO attribute offsets above are valid */
+	bool mbo_parsed;
 	/** MLD address of the AP */
 	u8 mld_addr[ETH_ALEN];
 	/** Link ID of this affiliated AP of the AP MLD */
@@ -139,14 +193,16 @@ struct wpa_bss {
 		bool disabled;
 	} mld_links[MAX_NUM_MLD_LINKS];
 
-	/* followed by ie_len octets of IEs */
-	/* followed by beacon_ie_len octets of IEs */
-	u8 ies[];
+	/**
+	 * ie_len octets of IEs followed by beacon_ie_len octets of IEs; this
+	 * may be shared with other BSS entries and must not be modified
+	 */
+	struct wpa_bss_ies *ies;
 };
 
 static inline const u8 * wpa_bss_ie_ptr(const struct wpa_bss *bss)
 {
-	return bss->ies;
+	return bss->ies->data;
 }
 
 void notify_bss_changes(struct wpa_supplicant *wpa_s, u32 changes,
@@ -191,6 +247,7 @@ int wpa_bss_get_max_rate(const struct wpa_bss *bss);
 int wpa_bss_get_bit_rates(const struct wpa_bss *bss, u8 **rates);
 struct wpa_bss_anqp * wpa_bss_anqp_alloc(void);
 int wpa_bss_anqp_unshare_alloc(struct wpa_bss *bss);
+void wpa_bss_anqp_free(struct wpa_bss_anqp *anqp);
 const u8 * wpa_bss_get_fils_cache_id(const struct wpa_bss *bss);
 int wpa_bss_ext_capab(const struct wpa_bss *bss, unsigned int capab);
 
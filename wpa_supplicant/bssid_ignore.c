@@ -12,6 +12,57 @@
 #include "wpa_supplicant_i.h"
 #include "bssid_ignore.h"
 
+/* Entries are purged an hour after their ignore timeout has expired */
+#define BSSID_IGNORE_PURGE_SECS 3600
+
+
+static unsigned int wpa_bssid_ignore_hash(const u8 *bssid)
+{
+	unsigned int i, hash = 0;
+
+	for (i = 0; i < ETH_ALEN; i++)
+		hash = hash * 31 + bssid[i];
+
+	return (hash ^ (hash >> 8)) & (WPA_BSSID_IGNORE_HASH_SIZE - 1);
+}
+
+
+/* Schedule the next purge check no later than the expiry of entry e */
+static void wpa_bssid_ignore_track_purge(struct wpa_supplicant *wpa_s,
+					 struct wpa_bssid_ignore *e)
+{
+	struct os_reltime purge = e->start;
+
+	purge.sec += e->timeout_secs + BSSID_IGNORE_PURGE_SECS;
+	if (!os_reltime_initialized(&wpa_s->bssid_ignore_next_purge) ||
+	    os_reltime_before(&purge, &wpa_s->bssid_ignore_next_purge))
+		wpa_s->bssid_ignore_next_purge = purge;
+}
+
+
+/* Remove entry e, which follows prev (or is the head) in the list */
+static void wpa_bssid_ignore_remove(struct wpa_supplicant *wpa_s,
+				    struct wpa_bssid_ignore *prev,
+				    struct wpa_bssid_ignore *e)
+{
+	struct wpa_bssid_ignore **h;
+
+	if (prev)
+		prev->next = e->next;
+	else
+		wpa_s->bssid_ignore = e->next;
+
+	h = &wpa_s->bssid_ignore_hash[wpa_bssid_ignore_hash(e->bssid)];
+	while (*h && *h != e)
+		h = &(*h)->hnext;
+	if (*h)
+		*h = e->hnext;
+
+	wpa_s->bssid_ignore_num--;
+	os_free(e);
+}
+
+
 /**
  * wpa_bssid_ignore_get - Get the ignore list entry for a BSSID
  * @wpa_s: Pointer to wpa_supplicant data
@@ -35,11 +86,14 @@ struct wpa_bssid_ignore * wpa_bssid_ignore_get(struct wpa_supplicant *wpa_s,
 
 	wpa_bssid_ignore_update(wpa_s);
 
-	e = wpa_s->bssid_ignore;
+	wpa_s->bssid_ignore_lookups++;
+	e = wpa_s->bssid_ignore_hash[wpa_bssid_ignore_hash(bssid)];
 	while (e) {
-		if (ether_addr_equal(e->bssid, bssid))
+		if (ether_addr_equal(e->bssid, bssid)) {
+			wpa_s->bssid_ignore_hits++;
 			return e;
-		e = e->next;
+		}
+		e = e->hnext;
 	}
 
 	return NULL;
@@ -100,6 +154,13 @@ int wpa_bssid_ignore_add(struct wpa_supplicant *wpa_s, const u8 *bssid)
 	e->start = now;
 	e->next = wpa_s->bssid_ignore;
 	wpa_s->bssid_ignore = e;
+	e->hnext = wpa_s->bssid_ignore_hash[wpa_bssid_ignore_hash(bssid)];
+	wpa_s->bssid_ignore_hash[wpa_bssid_ignore_hash(bssid)] = e;
+	wpa_bssid_ignore_track_purge(wpa_s, e);
+	wpa_s->bssid_ignore_added++;
+	wpa_s->bssid_ignore_num++;
+	if (wpa_s->bssid_ignore_num > wpa_s->bssid_ignore_peak)
+		wpa_s->bssid_ignore_peak = wpa_s->bssid_ignore_num;
 	wpa_msg(wpa_s, MSG_INFO, "Added BSSID " MACSTR
 		" into ignore list, ignoring for %d seconds",
 		MAC2STR(bssid), e->timeout_secs);
@@ -124,14 +185,9 @@ int wpa_bssid_ignore_del(struct wpa_supplicant *wpa_s, const u8 *bssid)
 	e = wpa_s->bssid_ignore;
 	while (e) {
 		if (ether_addr_equal(e->bssid, bssid)) {
-			if (prev == NULL) {
-				wpa_s->bssid_ignore = e->next;
-			} else {
-				prev->next = e->next;
-			}
 			wpa_msg(wpa_s, MSG_INFO, "Removed BSSID " MACSTR
 				" from ignore list", MAC2STR(bssid));
-			os_free(e);
+			wpa_bssid_ignore_remove(wpa_s, prev, e);
 			return 0;
 		}
 		prev = e;
@@ -172,6 +228,11 @@ void wpa_bssid_ignore_clear(struct wpa_supplicant *wpa_s)
 
 	e = wpa_s->bssid_ignore;
 	wpa_s->bssid_ignore = NULL;
+	os_memset(wpa_s->bssid_ignore_hash, 0,
+		  sizeof(wpa_s->bssid_ignore_hash));
+	wpa_s->bssid_ignore_num = 0;
+	os_memset(&wpa_s->bssid_ignore_next_purge, 0,
+		  sizeof(wpa_s->bssid_ignore_next_purge));
 	while (e) {
 		prev = e;
 		e = e->next;
@@ -195,27 +256,60 @@ void wpa_bssid_ignore_update(struct wpa_supplicant *wpa_s)
 	if (!wpa_s)
 		return;
 
-	e = wpa_s->bssid_ignore;
+	/*
+	 * The list only needs to be walked once the earliest purge time of
+	 * the entries has been reached.
+	 */
+	if (!os_reltime_initialized(&wpa_s->bssid_ignore_next_purge))
+		return;
 	os_get_reltime(&now);
+	if (os_reltime_before(&now, &wpa_s->bssid_ignore_next_purge))
+		return;
+	os_memset(&wpa_s->bssid_ignore_next_purge, 0,
+		  sizeof(wpa_s->bssid_ignore_next_purge));
+
+	e = wpa_s->bssid_ignore;
 	while (e) {
 		if (os_reltime_expired(&now, &e->start,
-				       e->timeout_secs + 3600)) {
+				       e->timeout_secs +
+				       BSSID_IGNORE_PURGE_SECS)) {
 			struct wpa_bssid_ignore *to_delete = e;
 
-			if (prev) {
-				prev->next = e->next;
-				e = prev->next;
-			} else {
-				wpa_s->bssid_ignore = e->next;
-				e = wpa_s->bssid_ignore;
-			}
+			e = e->next;
 			wpa_msg(wpa_s, MSG_INFO, "Removed BSSID " MACSTR
 				" from ignore list (expired)",
 				MAC2STR(to_delete->bssid));
-			os_free(to_delete);
+			wpa_bssid_ignore_remove(wpa_s, prev, to_delete);
+			wpa_s->bssid_ignore_expired++;
 		} else {
+			wpa_bssid_ignore_track_purge(wpa_s, e);
 			prev = e;
 			e = e->next;
 		}
 	}
 }
+
+
+/**
+ * wpa_bssid_ignore_stats - Write ignore list statistics
+ * @wpa_s: Pointer to wpa_supplicant data
+ * @buf: Buffer for the statistics
+ * @buflen: Length of the buffer
+ * Returns: Number of characters written
+ */
+int wpa_bssid_ignore_stats(struct wpa_supplicant *wpa_s, char *buf,
+			   size_t buflen)
+{
+	int ret;
+
+	ret = os_snprintf(buf, buflen,
+			  "entries=%u\npeak=%u\nlookups=%u\nhits=%u\n"
+			  "added=%u\nexpired=%u\n",
+			  wpa_s->bssid_ignore_num, wpa_s->bssid_ignore_peak,
+			  wpa_s->bssid_ignore_lookups, wpa_s->bssid_ignore_hits,
+			  wpa_s->bssid_ignore_added,
+			  wpa_s->bssid_ignore_expired);
+	if (os_snprintf_error(buflen, ret))
+		return 0;
+	return ret;
+}
@@ -11,6 +11,7 @@
 
 struct wpa_bssid_ignore {
 	struct wpa_bssid_ignore *next;
+	struct wpa_bssid_ignore *hnext; /* wpa_supplicant::bssid_ignore_hash */
 	u8 bssid[ETH_ALEN];
 	int count;
 	/* Time of the most recent trigger to ignore this BSSID. */
@@ -29,5 +30,7 @@ int wpa_bssid_ignore_del(struct wpa_supplicant *wpa_s, const u8 *bssid);
 int wpa_bssid_ignore_is_listed(struct wpa_supplicant *wpa_s, const u8 *bssid);
 void wpa_bssid_ignore_clear(struct wpa_supplicant *wpa_s);
 void wpa_bssid_ignore_update(struct wpa_supplicant *wpa_s);
+int wpa_bssid_ignore_stats(struct wpa_supplicant *wpa_s, char *buf,
+			   size_t buflen);
 
 #endif /* BSSID_IGNORE_H */
@@ -30,6 +30,99 @@
  * a generic parser for each network block variable. The table of configuration
  * variables is defined below in this file (ssid_fields[]).
  */
+/*
+ * Index of a configuration field table sorted by the field name for finding a
+ * field with a binary search. The table entries must start with the field
+ * name. The index is built on the first lookup. Fields with the same name
+ * are kept in table order, so the first matching field is the one found.
+ */
+struct config_field_index {
+	const void *table;
+	size_t entry_size;
+	size_t num;
+	u16 *order;
+	bool ready;
+};
+
+static const struct config_field_index *config_field_index_sorting;
+
+
+static const char * config_field_name(const struct config_field_index *index,
+				      size_t i)
+{
+	return *(char * const *) ((const u8 *) index->table +
+				  i * index->entry_size);
+}
+
+
+static int config_field_order_cmp(const void *a, const void *b)
+{
+	const struct config_field_index *index = config_field_index_sorting;
+	u16 ia = *((const u16 *) a);
+	u16 ib = *((const u16 *) b);
+	int res;
+
+	res = os_strcmp(config_field_name(index, ia),
+			config_field_name(index, ib));
+	if (res)
+		return res;
+	return ia - ib;
+}
+
+
+/* Compare a field name to the first len characters of var */
+static int config_field_name_cmp(const char *name, const char *var,
+				 size_t len)
+{
+	int res = os_strncmp(name, var, len);
+
+	if (res == 0 && name[len] != '\0')
+		return 1;
+	return res;
+}
+
+
+/**
+ * config_field_find - Find a configuration field by name
+ * @index: Index of the field table
+ * @var: Field name; only the first len characters are used
+ * @len: Length of the field name
+ * Returns: Index of the first matching table entry or -1 if not found
+ */
+static int config_field_find(struct config_field_index *index,
+			     const char *var, size_t len)
+{
+	size_t left = 0, right = index->num, mid;
+
+	if (!index->ready) {
+		for (mid = 0; mid < index->num; mid++)
+			index->order[mid] = mid;
+		config_field_index_sorting = index;
+		qsort(index->order, index->num, sizeof(index->order[0]),
+		      config_field_order_cmp);
+		config_field_index_sorting = NULL;
+		index->ready = true;
+	}
+
+	/* Find the first entry that is not before var */
+	while (left < right) {
+		mid = left + (right - left) / 2;
+		if (config_field_name_cmp(
+			    config_field_name(index, index->order[mid]),
+			    var, len) < 0)
+			left = mid + 1;
+		else
+			right = mid;
+	}
+
+	if (left < index->num &&
+	    config_field_name_cmp(config_field_name(index, index->order[left]),
+				  var, len) == 0)
+		return index->order[left];
+	return -1;
+}
+
+
 struct parse_data {
 	/* Configuration variable name */
 	char *name;
@@ -2778,6 +2871,21 @@ static const struct parse_data ssid_fields[] = {
 #define NUM_SSID_FIELDS ARRAY_SIZE(ssid_fields)
 
 
+static u16 ssid_field_order[NUM_SSID_FIELDS];
+static struct config_field_index ssid_field_index = {
+	ssid_fields, sizeof(ssid_fields[0]), NUM_SSID_FIELDS, ssid_field_order,
+	false
+};
+
+
+static const struct parse_data * ssid_field_lookup(const char *var)
+{
+	int i = config_field_find(&ssid_field_index, var, os_strlen(var));
+
+	return i < 0 ? NULL : &ssid_fields[i];
+}
+
+
 /**
  * wpa_config_add_prio_network - Add a network to priority lists
  * @config: Configuration data from wpa_config_read()
@@ -3080,6 +3188,7 @@ void wpa_config_free(struct wpa_config *config)
 	os_free(config->config_methods);
 	os_free(config->p2p_ssid_postfix);
 	os_free(config->pssid);
+	os_free(config->journal.nets);
 	os_free(config->p2p_pref_chan);
 	os_free(config->p2p_no_go_freq.range);
 	os_free(config->autoscan);
@@ -3089,6 +3198,9 @@ void wpa_config_free(struct wpa_config *config)
 	wpabuf_free(config->wps_nfc_dh_privkey);
 	wpabuf_free(config->wps_nfc_dev_pw);
 	os_free(config->ext_password_backend);
+	os_free(config->pmksa_store_file);
+	os_free(config->status_shm_dir);
+	wpabuf_clear_free(config->pmksa_store_key);
 	os_free(config->sae_groups);
 	wpabuf_free(config->ap_vendor_elements);
 	wpabuf_free(config->ap_assocresp_elements);
@@ -3330,17 +3442,14 @@ static bool removed_field(const char *field)
 int wpa_config_set(struct wpa_ssid *ssid, const char *var, const char *value,
 		   int line)
 {
-	size_t i;
+	const struct parse_data *field;
 	int ret = 0;
 
 	if (ssid == NULL || var == NULL || value == NULL)
 		return -1;
 
-	for (i = 0; i < NUM_SSID_FIELDS; i++) {
-		const struct parse_data *field = &ssid_fields[i];
-		if (os_strcmp(var, field->name) != 0)
-			continue;
-
+	field = ssid_field_lookup(var);
+	if (field) {
 		ret = field->parser(field, ssid, line, value);
 		if (ret < 0) {
 			if (line) {
@@ -3358,9 +3467,7 @@ int wpa_config_set(struct wpa_ssid *ssid, const char *var, const char *value,
 			ssid->pt = NULL;
 		}
 #endif /* CONFIG_SAE */
-		break;
-	}
-	if (i == NUM_SSID_FIELDS) {
+	} else {
 		if (removed_field(var)) {
 			wpa_printf(MSG_INFO,
 				   "Line %d: Ignore removed configuration field '%s'",
@@ -3480,29 +3587,26 @@ err:
  */
 char * wpa_config_get(struct wpa_ssid *ssid, const char *var)
 {
-	size_t i;
+	const struct parse_data *field;
+	char *ret;
 
 	if (ssid == NULL || var == NULL)
 		return NULL;
 
-	for (i = 0; i < NUM_SSID_FIELDS; i++) {
-		const struct parse_data *field = &ssid_fields[i];
-		if (os_strcmp(var, field->name) == 0) {
-			char *ret = field->writer(field, ssid);
-
-			if (ret && has_newline(ret)) {
-				wpa_printf(MSG_ERROR,
-					   "Found newline in value for %s; not returning it",
-					   var);
-				os_free(ret);
-				ret = NULL;
-			}
+	field = ssid_field_lookup(var);
+	if (!field)
+		return NULL;
 
-			return ret;
-		}
+	ret = field->writer(field, ssid);
+	if (ret && has_newline(ret)) {
+		wpa_printf(MSG_ERROR,
+			   "Found newline in value for %s; not returning it",
+			   var);
+		os_free(ret);
+		ret = NULL;
 	}
 
-	return NULL;
+	return ret;
 }
 
 
@@ -3524,32 +3628,30 @@ char * wpa_config_get(struct wpa_ssid *ssid, const char *var)
  */
 char * wpa_config_get_no_key(struct wpa_ssid *ssid, const char *var)
 {
-	size_t i;
+	const struct parse_data *field;
+	char *res;
 
 	if (ssid == NULL || var == NULL)
 		return NULL;
 
-	for (i = 0; i < NUM_SSID_FIELDS; i++) {
-		const struct parse_data *field = &ssid_fields[i];
-		if (os_strcmp(var, field->name) == 0) {
-			char *res = field->writer(field, ssid);
-			if (field->key_data) {
-				if (res && res[0]) {
-					wpa_printf(MSG_DEBUG, "Do not allow "
-						   "key_data field to be "
-						   "exposed");
-					str_clear_free(res);
-					return os_strdup("*");
-				}
+	field = ssid_field_lookup(var);
+	if (!field)
+		return NULL;
 
-				os_free(res);
-				return NULL;
-			}
-			return res;
+	res = field->writer(field, ssid);
+	if (field->key_data) {
+		if (res && res[0]) {
+			wpa_printf(MSG_DEBUG, "Do not allow "
+				   "key_data field to be "
+				   "exposed");
+			str_clear_free(res);
+			return os_strdup("*");
 		}
-	}
 
-	return NULL;
+		os_free(res);
+		return NULL;
+	}
+	return res;
 }
 #endif /* NO_CONFIG_WRITE */
 
@@ -4681,6 +4783,7 @@ struct wpa_config * wpa_config_alloc_empty(const char *ctrl_interface,
 	config->p2p_optimize_listen_chan = DEFAULT_P2P_OPTIMIZE_LISTEN_CHAN;
 	config->p2p_go_ctwindow = DEFAULT_P2P_GO_CTWINDOW;
 	config->bss_max_count = DEFAULT_BSS_MAX_COUNT;
+	config->anqp_cache_size = DEFAULT_ANQP_CACHE_SIZE;
 	config->bss_expiration_age = DEFAULT_BSS_EXPIRATION_AGE;
 	config->bss_expiration_scan_count = DEFAULT_BSS_EXPIRATION_SCAN_COUNT;
 	config->max_num_sta = DEFAULT_MAX_NUM_STA;
@@ -4688,6 +4791,7 @@ struct wpa_config * wpa_config_alloc_empty(const char *ctrl_interface,
 	config->access_network_type = DEFAULT_ACCESS_NETWORK_TYPE;
 	config->scan_cur_freq = DEFAULT_SCAN_CUR_FREQ;
 	config->scan_res_valid_for_connect = DEFAULT_SCAN_RES_VALID_FOR_CONNECT;
+	config->tdls_monitor_links = DEFAULT_TDLS_MONITOR_LINKS;
 	config->wmm_ac_params[0] = ac_be;
 	config->wmm_ac_params[1] = ac_bk;
 	config->wmm_ac_params[2] = ac_vi;
@@ -4716,6 +4820,7 @@ struct wpa_config * wpa_config_alloc_empty(const char *ctrl_interface,
 	if (driver_param)
 		config->driver_param = os_strdup(driver_param);
 	config->gas_rand_addr_lifetime = DEFAULT_RAND_ADDR_LIFETIME;
+	config->gas_max_parallel = DEFAULT_GAS_MAX_PARALLEL;
 
 #ifdef CONFIG_TESTING_OPTIONS
 	config->mld_connect_band_pref = DEFAULT_MLD_CONNECT_BAND_PREF;
@@ -5414,6 +5519,7 @@ static const struct global_parse_data global_fields[] = {
 	{ FUNC_NO_VAR(no_ctrl_interface), 0 },
 	{ STR(ctrl_interface_group), 0 } /* deprecated */,
 #endif /* CONFIG_CTRL_IFACE */
+	{ INT_RANGE(dbus_lazy_bss, 0, 1), 0 },
 #ifdef CONFIG_MACSEC
 	{ INT_RANGE(eapol_version, 1, 3), 0 },
 #else /* CONFIG_MACSEC */
@@ -5427,6 +5533,7 @@ static const struct global_parse_data global_fields[] = {
 	{ INT(mesh_max_inactivity), 0 },
 	{ INT_RANGE(mesh_fwding, 0, 1), 0 },
 	{ INT(dot11RSNASAERetransPeriod), 0 },
+	{ INT_RANGE(mesh_auth_rate, 0, 1000), 0 },
 #endif /* CONFIG_MESH */
 	{ INT(disable_scan_offload), 0 },
 	{ INT(fast_reauth), 0 },
@@ -5449,6 +5556,8 @@ static const struct global_parse_data global_fields[] = {
 	{ INT(dot11RSNAConfigSATimeout), 0 },
 #ifndef CONFIG_NO_CONFIG_WRITE
 	{ INT(update_config), 0 },
+	{ INT_RANGE(config_journal, 0, 100000), 0 },
+	{ INT_RANGE(config_cache, 0, 1), 0 },
 #endif /* CONFIG_NO_CONFIG_WRITE */
 #ifndef CONFIG_NO_LOAD_DYNAMIC_EAP
 	{ FUNC_NO_VAR(load_dynamic_eap), 0 },
@@ -5545,26 +5654,40 @@ static const struct global_parse_data global_fields[] = {
 	{ BIN(wps_nfc_dh_privkey), CFG_CHANGED_NFC_PASSWORD_TOKEN },
 	{ BIN(wps_nfc_dev_pw), CFG_CHANGED_NFC_PASSWORD_TOKEN },
 	{ STR(ext_password_backend), CFG_CHANGED_EXT_PW_BACKEND },
+	{ STR(pmksa_store_file), 0 },
+	{ BIN(pmksa_store_key), 0 },
+	{ STR(status_shm_dir), 0 },
+	{ INT_RANGE(status_shm_interval, 0, 3600), 0 },
+	{ INT_RANGE(signal_poll_cache_ms, 0, 10000), 0 },
 	{ INT(p2p_go_max_inactivity), 0 },
 	{ INT_RANGE(auto_interworking, 0, 1), 0 },
+	{ INT_RANGE(anqp_cache_ttl, 0, 86400), 0 },
+	{ INT_RANGE(anqp_cache_size, 1, 1000), 0 },
 	{ INT(okc), 0 },
 	{ INT(pmf), 0 },
 	{ INT_RANGE(sae_check_mfp, 0, 1), 0 },
 	{ FUNC(sae_groups), 0 },
 	{ INT_RANGE(sae_pwe, 0, 3), 0 },
 	{ INT_RANGE(sae_pmkid_in_assoc, 0, 1), 0 },
+	{ INT_RANGE(sae_precompute_commit, 0, MAX_SAE_PRECOMPUTE_COMMIT), 0 },
 	{ INT(dtim_period), 0 },
 	{ INT(beacon_int), 0 },
 	{ FUNC(ap_assocresp_elements), 0 },
 	{ FUNC(ap_vendor_elements), 0 },
 	{ INT_RANGE(ignore_old_scan_res, 0, 1), 0 },
+	{ INT_RANGE(scan_res_filter_freqs, 0, 1), 0 },
 	{ FUNC(freq_list), 0 },
 	{ FUNC(initial_freq_list), 0},
 	{ INT(scan_cur_freq), 0 },
+	{ INT_RANGE(roam_scan_max_freqs, 0, 32), 0 },
 	{ INT(scan_res_valid_for_connect), 0},
+	{ INT_RANGE(scan_res_stale_budget, 0, 3600), 0 },
+	{ INT_RANGE(scan_merge, 0, 1), 0 },
 	{ INT(sched_scan_interval), 0 },
 	{ INT(sched_scan_start_delay), 0 },
 	{ INT(tdls_external_control), 0},
+	{ INT_RANGE(tdls_monitor_interval, 0, 3600), CFG_CHANGED_TDLS_MONITOR },
+	{ INT_RANGE(tdls_monitor_links, 0, 16), CFG_CHANGED_TDLS_MONITOR },
 	{ STR(osu_dir), 0 },
 	{ STR(wowlan_triggers), CFG_CHANGED_WOWLAN_TRIGGERS },
 	{ INT(p2p_search_delay), 0},
@@ -5597,6 +5720,7 @@ static const struct global_parse_data global_fields[] = {
 	{ INT_RANGE(twt_requester, 0, 1), 0 },
 	{ INT(gas_rand_addr_lifetime), 0 },
 	{ INT_RANGE(gas_rand_mac_addr, 0, 2), 0 },
+	{ INT_RANGE(gas_max_parallel, 1, 16), 0 },
 #ifdef CONFIG_DPP
 	{ INT_RANGE(dpp_config_processing, 0, 2), 0 },
 	{ STR(dpp_name), 0 },
@@ -5641,6 +5765,12 @@ static const struct global_parse_data global_fields[] = {
 #undef IPV4
 #define NUM_GLOBAL_FIELDS ARRAY_SIZE(global_fields)
 
+static u16 global_field_order[NUM_GLOBAL_FIELDS];
+static struct config_field_index global_field_index = {
+	global_fields, sizeof(global_fields[0]), NUM_GLOBAL_FIELDS,
+	global_field_order, false
+};
+
 
 int wpa_config_dump_values(struct wpa_config *config, char *buf, size_t buflen)
 {
@@ -5669,20 +5799,16 @@ int wpa_config_dump_values(struct wpa_config *config, char *buf, size_t buflen)
 int wpa_config_get_value(const char *name, struct wpa_config *config,
 			 char *buf, size_t buflen)
 {
-	size_t i;
-
-	for (i = 0; i < NUM_GLOBAL_FIELDS; i++) {
-		const struct global_parse_data *field = &global_fields[i];
-
-		if (os_strcmp(name, field->name) != 0)
-			continue;
-		if (!field->get)
-			break;
-		return field->get(name, config, (long) field->param1,
-				  buf, buflen, 0);
-	}
+	const struct global_parse_data *field;
+	int i;
 
-	return -1;
+	i = config_field_find(&global_field_index, name, os_strlen(name));
+	if (i < 0)
+		return -1;
+	field = &global_fields[i];
+	if (!field->get)
+		return -1;
+	return field->get(name, config, (long) field->param1, buf, buflen, 0);
 }
 
 
@@ -5718,30 +5844,29 @@ const char * wpa_config_get_global_field_name(unsigned int i, int *no_var)
  */
 int wpa_config_process_global(struct wpa_config *config, char *pos, int line)
 {
-	size_t i;
+	const char *eq;
+	int i = -1;
 	int ret = 0;
 
-	for (i = 0; i < NUM_GLOBAL_FIELDS; i++) {
+	eq = os_strchr(pos, '=');
+	if (eq)
+		i = config_field_find(&global_field_index, pos, eq - pos);
+	if (i >= 0) {
 		const struct global_parse_data *field = &global_fields[i];
-		size_t flen = os_strlen(field->name);
-		if (os_strncmp(pos, field->name, flen) != 0 ||
-		    pos[flen] != '=')
-			continue;
 
-		ret = field->parser(field, config, line, pos + flen + 1);
+		ret = field->parser(field, config, line, eq + 1);
 		if (ret < 0) {
 			wpa_printf(MSG_ERROR, "Line %d: failed to "
 				   "parse '%s'.", line, pos);
 			ret = -1;
 		}
-		if (ret == 1)
-			break;
-		if (field->changed_flag == CFG_CHANGED_NFC_PASSWORD_TOKEN)
-			config->wps_nfc_pw_from_config = 1;
-		config->changed_parameters |= field->changed_flag;
-		break;
-	}
-	if (i == NUM_GLOBAL_FIELDS) {
+		if (ret != 1) {
+			if (field->changed_flag ==
+			    CFG_CHANGED_NFC_PASSWORD_TOKEN)
+				config->wps_nfc_pw_from_config = 1;
+			config->changed_parameters |= field->changed_flag;
+		}
+	} else {
 #ifdef CONFIG_AP
 		if (os_strncmp(pos, "tx_queue_", 9) == 0) {
 			char *tmp = os_strchr(pos, '=');
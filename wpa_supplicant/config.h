@@ -32,6 +32,8 @@
 #define DEFAULT_BSS_MAX_COUNT 200
 #define DEFAULT_BSS_EXPIRATION_AGE 180
 #define DEFAULT_BSS_EXPIRATION_SCAN_COUNT 2
+#define DEFAULT_ANQP_CACHE_SIZE 32
+#define DEFAULT_GAS_MAX_PARALLEL 1
 #define DEFAULT_MAX_NUM_STA 128
 #define DEFAULT_AP_ISOLATE 0
 #define DEFAULT_ACCESS_NETWORK_TYPE 15
@@ -48,6 +50,8 @@
 #define DEFAULT_EXTENDED_KEY_ID 0
 #define DEFAULT_BTM_OFFLOAD 0
 #define DEFAULT_SCAN_RES_VALID_FOR_CONNECT 5
+#define MAX_SAE_PRECOMPUTE_COMMIT 8
+#define DEFAULT_TDLS_MONITOR_LINKS 4
 #define DEFAULT_MLD_CONNECT_BAND_PREF MLD_CONNECT_BAND_PREF_AUTO
 
 #include "config_ssid.h"
@@ -495,6 +499,7 @@ struct wpa_dev_ik {
 #define CFG_CHANGED_BGSCAN BIT(20)
 #define CFG_CHANGED_FT_PREPEND_PMKID BIT(21)
 #define CFG_CHANGED_DISABLE_BTM_NOTIFY BIT(22)
+#define CFG_CHANGED_TDLS_MONITOR BIT(23)
 
 /**
  * struct wpa_config - wpa_supplicant configuration data
@@ -504,6 +509,26 @@ struct wpa_dev_ik {
  * more than one network interface is being controlled, one instance is used
  * for each.
  */
+/**
+ * struct wpa_config_journal - Configuration journal state
+ * @nets: Networks in the order they are stored in the configuration file and
+ *	the hash of their serialized network block
+ * @num_nets: Number of entries in nets
+ * @other_hash: Hash of the stored configuration other than network blocks
+ * @records: Number of records in the journal file
+ * @valid: Whether this state matches the stored configuration
+ */
+struct wpa_config_journal {
+	struct wpa_config_journal_net {
+		struct wpa_ssid *ssid;
+		u8 hash[32];
+	} *nets;
+	size_t num_nets;
+	u8 other_hash[32];
+	unsigned int records;
+	bool valid;
+};
+
 struct wpa_config {
 	/**
 	 * ssid - Head of the global network list
@@ -662,6 +687,18 @@ struct wpa_config {
 	 */
 	char *ctrl_interface_group;
 
+	/**
+	 * dbus_lazy_bss - Register D-Bus BSS objects on demand
+	 *
+	 * By default, a D-Bus object is registered for each BSS when it is
+	 * added to the BSS table. When this is set to 1, the object is
+	 * registered only when it is accessed for the first time or when the
+	 * GetBSSs method is called. This avoids the per-BSS registration and
+	 * BSSAdded/BSSRemoved signals in environments with many BSSs when the
+	 * client uses the GetScanResults method instead.
+	 */
+	int dbus_lazy_bss;
+
 	/**
 	 * fast_reauth - EAP fast re-authentication (session resumption)
 	 *
@@ -789,6 +826,36 @@ struct wpa_config {
 	 */
 	int update_config;
 
+	/**
+	 * config_journal - Maximum number of pending configuration journal
+	 * records
+	 *
+	 * If this is non-zero and wpa_supplicant was built with
+	 * CONFIG_CONFIG_JOURNAL=y, changes to network blocks are appended to a
+	 * journal file (configuration file name with ".journal" suffix)
+	 * instead of rewriting the full configuration file. The journal is
+	 * merged into the configuration file once this many records have
+	 * been written or when something else than a network block changes.
+	 */
+	int config_journal;
+
+	/**
+	 * config_cache - Whether to cache the PSKs derived from passphrases
+	 *
+	 * If this is non-zero, the PSKs derived from the network passphrases
+	 * are stored in a binary cache file (configuration file name with
+	 * ".keys" suffix) when the configuration is read, so that the PBKDF2
+	 * derivation can be skipped the next time the configuration is read.
+	 * This needs to be set before the network blocks in the configuration
+	 * file and requires update_config=1 for the cache file to be written.
+	 */
+	int config_cache;
+
+	/**
+	 * journal - State of the configuration journal
+	 */
+	struct wpa_config_journal journal;
+
 	/**
 	 * blobs - Configuration blobs
 	 */
@@ -1078,6 +1145,17 @@ struct wpa_config {
 	 */
 	int scan_cur_freq;
 
+	/**
+	 * roam_scan_max_freqs - Maximum number of channels in roaming scans
+	 *
+	 * If nonzero, scans while connected are limited to this many channels
+	 * ranked from BSS transition candidates, the latest neighbor report,
+	 * and recently seen BSSs of the current ESS. A full scan is used when
+	 * no candidate channels are known and after a few partial scans that
+	 * did not result in a roam.
+	 */
+	int roam_scan_max_freqs;
+
 	/**
 	 * scan_res_valid_for_connect - Seconds scans are valid for association
 	 *
@@ -1087,6 +1165,28 @@ struct wpa_config {
 	 */
 	int scan_res_valid_for_connect;
 
+	/**
+	 * scan_res_stale_budget - Seconds cached BSS entries may be used
+	 *
+	 * If nonzero, scan results older than scan_res_valid_for_connect can
+	 * still be used for association without a new scan when the selected
+	 * BSS was seen within this budget. The budget is shortened for weak
+	 * signals and for the 5 GHz and 6 GHz bands, and the cached entry is
+	 * not used if its signal level dropped in the latest update.
+	 */
+	int scan_res_stale_budget;
+
+	/**
+	 * scan_merge - Merge pending scan requests of interfaces on a radio
+	 *
+	 * 0 = Each interface runs its own scans (default)
+	 * 1 = When a scan is started, pending scan requests from the other
+	 * interfaces on the same radio with compatible parameters are
+	 * combined into it and those interfaces process the results as their
+	 * own scan results
+	 */
+	int scan_merge;
+
 	/**
 	 * changed_parameters - Bitmap of changed parameters since last update
 	 */
@@ -1214,6 +1314,54 @@ struct wpa_config {
 	 */
 	char *ext_password_backend;
 
+	/**
+	 * pmksa_store_file - File for storing PMKSA cache entries persistently
+	 *
+	 * When set (and wpa_supplicant is built with CONFIG_PMKSA_STORE=y),
+	 * PMKSA cache entries are written to this file when they are added or
+	 * removed and restored from it when the interface is initialized.
+	 * ERP keys are stored in the same file. Each interface needs its own
+	 * file.
+	 */
+	char *pmksa_store_file;
+
+	/**
+	 * pmksa_store_key - 256-bit key for protecting pmksa_store_file
+	 *
+	 * The stored entries are encrypted and authenticated with AES-SIV
+	 * using this key. pmksa_store_file is not used without a key.
+	 */
+	struct wpabuf *pmksa_store_key;
+
+	/**
+	 * status_shm_dir - Directory for shared memory status pages
+	 *
+	 * When set (and wpa_supplicant is built with CONFIG_STATUS_SHM=y), the
+	 * status of each interface is published in a memory mapped file with
+	 * the interface name in this directory.
+	 */
+	char *status_shm_dir;
+
+	/**
+	 * status_shm_interval - Driver poll interval for status pages
+	 *
+	 * Interval in seconds for refreshing the signal strength and packet
+	 * counters on the status page while connected or 0 to update the page
+	 * only on events.
+	 */
+	int status_shm_interval;
+
+	/**
+	 * signal_poll_cache_ms - Lifetime of cached signal poll results
+	 *
+	 * Signal poll results from the driver are reused for this many
+	 * milliseconds, so that requests from multiple users (control
+	 * interface, D-Bus, AIDL, bgscan) at about the same time result in a
+	 * single driver query. Signal change events from the driver refresh
+	 * the cached values. 0 = disabled (default).
+	 */
+	int signal_poll_cache_ms;
+
 	/*
 	 * p2p_go_max_inactivity - Timeout in seconds to detect STA inactivity
 	 *
@@ -1237,6 +1385,21 @@ struct wpa_config {
 	 */
 	int auto_interworking;
 
+	/**
+	 * anqp_cache_ttl - Lifetime of cached ANQP responses in seconds
+	 *
+	 * ANQP responses are cached globally for all interfaces and used for
+	 * all BSSs that advertise the same HESSID (or BSSID if no HESSID is
+	 * advertised), ANQP Domain ID, and ANQP related elements instead of
+	 * sending a new ANQP query. 0 = disable the cache (default).
+	 */
+	int anqp_cache_ttl;
+
+	/**
+	 * anqp_cache_size - Maximum number of cached ANQP responses
+	 */
+	int anqp_cache_size;
+
 	/**
 	 * p2p_go_ht40 - Default mode for HT40 enable when operating as GO.
 	 *
@@ -1374,6 +1537,17 @@ struct wpa_config {
 	 */
 	int sae_pmkid_in_assoc;
 
+	/**
+	 * sae_precompute_commit - Number of BSSs for speculative SAE commits
+	 *
+	 * When new scan results are processed, the PWE and the SAE commit
+	 * for up to this many of the highest ranked H2E capable BSSs are
+	 * derived in the background so that a following authentication
+	 * attempt can send the commit without deriving it first. 0 (default)
+	 * disables this.
+	 */
+	int sae_precompute_commit;
+
 	/**
 	 * dtim_period - Default DTIM period in Beacon intervals
 	 *
@@ -1421,6 +1595,18 @@ struct wpa_config {
 	 */
 	int ignore_old_scan_res;
 
+	/**
+	 * scan_res_filter_freqs - Fetch only results on scanned frequencies
+	 *
+	 * When a scan is limited to a set of frequencies, request the driver
+	 * to return only the BSSes on those frequencies when the results are
+	 * fetched. BSS table entries on other frequencies are left unchanged
+	 * and are not considered for network selection based on that scan.
+	 * This reduces processing of the short partial scans used for
+	 * background scanning and roaming.
+	 */
+	int scan_res_filter_freqs;
+
 	/**
 	 * sched_scan_interval -  schedule scan interval
 	 */
@@ -1445,6 +1631,24 @@ struct wpa_config {
 	 */
 	int tdls_external_control;
 
+	/**
+	 * tdls_monitor_interval - TDLS link quality monitor interval
+	 *
+	 * Interval in seconds for polling the driver for the traffic of the
+	 * TDLS peers. 0 (default) disables the monitor. The monitor is used
+	 * only with drivers that use external TDLS link setup.
+	 */
+	unsigned int tdls_monitor_interval;
+
+	/**
+	 * tdls_monitor_links - Maximum number of monitored TDLS links
+	 *
+	 * The links of this many peers with the highest traffic rates are
+	 * set up again if they are lost and other links are torn down when
+	 * there are more links than this.
+	 */
+	unsigned int tdls_monitor_links;
+
 	u8 ip_addr_go[4];
 	u8 ip_addr_mask[4];
 	u8 ip_addr_start[4];
@@ -1564,6 +1768,16 @@ struct wpa_config {
 	 */
 	int dot11RSNASAERetransPeriod;
 
+	/**
+	 * mesh_auth_rate - Maximum number of mesh peer authentications per second
+	 *
+	 * This limits how many SAE authentications with new mesh peer
+	 * candidates are started per second. Candidates exceeding the limit
+	 * are started later with the strongest received signal first.
+	 * By default: 0 = no limit
+	 */
+	unsigned int mesh_auth_rate;
+
 	/**
 	 * passive_scan - Whether to force passive scan for network connection
 	 *
@@ -1712,6 +1926,16 @@ struct wpa_config {
 	 */
 	enum wpas_mac_addr_style gas_rand_mac_addr;
 
+	/**
+	 * gas_max_parallel - Maximum number of parallel GAS queries
+	 *
+	 * Queued GAS queries to the same channel are sent within the same
+	 * off-channel operation without waiting for the earlier responses when
+	 * this is larger than 1. This is also the maximum number of ANQP
+	 * queries an Interworking ANQP fetch has outstanding at a time.
+	 */
+	int gas_max_parallel;
+
 	/**
 	 * dpp_config_processing - How to process DPP configuration
 	 *
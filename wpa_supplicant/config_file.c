@@ -24,9 +24,290 @@
 #include "eap_peer/eap_methods.h"
 #include "eap_peer/eap.h"
 #include "utils/config.h"
+#include "crypto/crypto.h"
+#include "crypto/sha256.h"
 
+#ifdef CONFIG_NO_CONFIG_WRITE
+/* The journal is maintained by the configuration write functionality */
+#undef CONFIG_CONFIG_JOURNAL
+#endif /* CONFIG_NO_CONFIG_WRITE */
+
+
+#ifndef CONFIG_NO_PBKDF2
+
+/*
+ * Binary cache of the PSKs derived from passphrases. The PBKDF2 derivation
+ * dominates the time needed to load a configuration with many passphrase
+ * protected networks, so the derived PSKs are stored in a separate file
+ * (configuration file name with ".keys" suffix) when the config_cache
+ * parameter is set. The contents of the cache are as sensitive as the
+ * configuration file itself.
+ *
+ * File format: "WPAK", version (1 octet), 3 reserved octets, number of
+ * entries (32-bit big endian), entries sorted by key, SHA-256 checksum of all
+ * the preceding octets. Each entry consists of the key that is the SHA-256
+ * hash of the SSID length, the SSID, and the passphrase followed by the PSK.
+ * The cache is only an optimization, so any invalid file is ignored and the
+ * PSKs are derived from the passphrases as usual.
+ */
+#define KEY_CACHE_MAGIC "WPAK"
+#define KEY_CACHE_VERSION 1
+#define KEY_CACHE_HDR_LEN 12
+#define KEY_CACHE_ENTRY_LEN (2 * SHA256_MAC_LEN)
+
+struct wpa_config_key_cache {
+	const char *name;
+	struct wpa_config *config;
+	char *data;
+	const u8 *entries;
+	size_t num_entries;
+	bool loaded;
+	unsigned int hits;
+	unsigned int misses;
+};
+
+
+static char * wpa_config_key_cache_name(const char *name)
+{
+	size_t len = os_strlen(name) + 6;
+	char *cname;
+
+	cname = os_malloc(len);
+	if (cname)
+		os_snprintf(cname, len, "%s.keys", name);
+	return cname;
+}
+
+
+static void wpa_config_key_cache_load(struct wpa_config_key_cache *cache)
+{
+	char *cname;
+	const u8 *pos;
+	u8 hash[SHA256_MAC_LEN];
+	size_t len, num;
+
+	cache->loaded = true;
+	cname = wpa_config_key_cache_name(cache->name);
+	if (!cname)
+		return;
+	cache->data = os_readfile(cname, &len);
+	os_free(cname);
+	if (!cache->data)
+		return;
+
+	pos = (const u8 *) cache->data;
+	if (len < KEY_CACHE_HDR_LEN + SHA256_MAC_LEN ||
+	    os_memcmp(pos, KEY_CACHE_MAGIC, 4) != 0 ||
+	    pos[4] != KEY_CACHE_VERSION)
+		goto invalid;
+	num = WPA_GET_BE32(pos + 8);
+	if (num > (len - KEY_CACHE_HDR_LEN - SHA256_MAC_LEN) /
+	    KEY_CACHE_ENTRY_LEN ||
+	    len != KEY_CACHE_HDR_LEN + num * KEY_CACHE_ENTRY_LEN +
+	    SHA256_MAC_LEN)
+		goto invalid;
+	len -= SHA256_MAC_LEN;
+	if (sha256_vector(1, &pos, &len, hash) < 0 ||
+	    os_memcmp_const(hash, pos + len, SHA256_MAC_LEN) != 0)
+		goto invalid;
+
+	cache->entries = pos + KEY_CACHE_HDR_LEN;
+	cache->num_entries = num;
+	return;
+
+invalid:
+	wpa_printf(MSG_INFO, "Ignored invalid key cache for '%s'",
+		   cache->name);
+	os_free(cache->data);
+	cache->data = NULL;
+}
+
+
+static int wpa_config_key_cache_key(struct wpa_ssid *ssid, u8 *key)
+{
+	const u8 *addr[3];
+	size_t len[3];
+	u8 ssid_len = ssid->ssid_len;
+
+	addr[0] = &ssid_len;
+	len[0] = 1;
+	addr[1] = ssid->ssid;
+	len[1] = ssid->ssid_len;
+	addr[2] = (const u8 *) ssid->passphrase;
+	len[2] = os_strlen(ssid->passphrase);
+	return sha256_vector(3, addr, len, key);
+}
+
+
+static int wpa_config_key_cache_cmp(const void *a, const void *b)
+{
+	return os_memcmp(a, b, SHA256_MAC_LEN);
+}
+
+
+/* Set the PSK of the network from the passphrase */
+static void wpa_config_key_cache_psk(struct wpa_config_key_cache *cache,
+				     struct wpa_ssid *ssid)
+{
+	u8 key[SHA256_MAC_LEN];
+	const u8 *entry;
+
+	if (!cache || !cache->config->config_cache ||
+	    wpa_config_key_cache_key(ssid, key) < 0) {
+		wpa_config_update_psk(ssid);
+		return;
+	}
+
+	if (!cache->loaded)
+		wpa_config_key_cache_load(cache);
+	entry = cache->entries ?
+		bsearch(key, cache->entries, cache->num_entries,
+			KEY_CACHE_ENTRY_LEN, wpa_config_key_cache_cmp) : NULL;
+	forced_memzero(key, sizeof(key));
+	if (!entry) {
+		cache->misses++;
+		wpa_config_update_psk(ssid);
+		return;
+	}
+
+	cache->hits++;
+	os_memcpy(ssid->psk, entry + SHA256_MAC_LEN, PMK_LEN);
+	ssid->psk_set = 1;
+}
+
+
+static void wpa_config_key_cache_deinit(struct wpa_config_key_cache *cache)
+{
+	if (cache->data)
+		bin_clear_free(cache->data,
+			       KEY_CACHE_HDR_LEN +
+			       cache->num_entries * KEY_CACHE_ENTRY_LEN +
+			       SHA256_MAC_LEN);
+	cache->data = NULL;
+}
+
+
+#ifndef CONFIG_NO_CONFIG_WRITE
+
+static int wpa_config_key_cache_write_file(const char *cname, const u8 *buf,
+					   size_t len)
+{
+	size_t tmp_len = os_strlen(cname) + 5;
+	char *tmp_name;
+	FILE *f;
+	int ret = -1;
+
+	tmp_name = os_malloc(tmp_len);
+	if (!tmp_name)
+		return -1;
+	os_snprintf(tmp_name, tmp_len, "%s.tmp", cname);
+
+	f = fopen(tmp_name, "wb");
+	if (!f)
+		goto out;
+#ifdef ANDROID
+	fchmod(fileno(f), S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP);
+#endif /* ANDROID */
+	if (fwrite(buf, len, 1, f) == 1 && fflush(f) == 0 &&
+	    os_fdatasync(f) == 0)
+		ret = 0;
+	if (fclose(f) != 0)
+		ret = -1;
+	if (ret == 0 && rename(tmp_name, cname) != 0)
+		ret = -1;
+	if (ret)
+		unlink(tmp_name);
+out:
+	os_free(tmp_name);
+	return ret;
+}
+
+
+/* Replace the cache with the PSKs of the current networks if needed */
+static void wpa_config_key_cache_update(struct wpa_config_key_cache *cache)
+{
+	struct wpa_config *config = cache->config;
+	struct wpa_ssid *ssid;
+	size_t num = 0, len;
+	u8 *buf, *pos;
+	const u8 *addr[1];
+	char *cname;
+
+	if (!config->update_config)
+		return;
+
+	cname = wpa_config_key_cache_name(cache->name);
+	if (!cname)
+		return;
+
+	if (!config->config_cache) {
+		/* Do not leave the keys behind once the cache is disabled */
+		if (unlink(cname) == 0)
+			wpa_printf(MSG_DEBUG, "Removed key cache '%s'", cname);
+		goto out;
+	}
+
+	if (!cache->misses && cache->hits == cache->num_entries)
+		goto out;
+
+	for (ssid = config->ssid; ssid; ssid = ssid->next) {
+		if (ssid->passphrase && ssid->psk_set)
+			num++;
+	}
+
+	len = KEY_CACHE_HDR_LEN + num * KEY_CACHE_ENTRY_LEN + SHA256_MAC_LEN;
+	buf = os_zalloc(len);
+	if (!buf)
+		goto out;
+	os_memcpy(buf, KEY_CACHE_MAGIC, 4);
+	buf[4] = KEY_CACHE_VERSION;
+	WPA_PUT_BE32(buf + 8, num);
+
+	pos = buf + KEY_CACHE_HDR_LEN;
+	for (ssid = config->ssid; ssid; ssid = ssid->next) {
+		if (!ssid->passphrase || !ssid->psk_set)
+			continue;
+		if (wpa_config_key_cache_key(ssid, pos) < 0)
+			goto fail;
+		os_memcpy(pos + SHA256_MAC_LEN, ssid->psk, PMK_LEN);
+		pos += KEY_CACHE_ENTRY_LEN;
+	}
+	qsort(buf + KEY_CACHE_HDR_LEN, num, KEY_CACHE_ENTRY_LEN,
+	      wpa_config_key_cache_cmp);
+
+	addr[0] = buf;
+	len -= SHA256_MAC_LEN;
+	if (sha256_vector(1, addr, &len, pos) < 0)
+		goto fail;
+	len += SHA256_MAC_LEN;
+
+	wpa_printf(MSG_DEBUG, "Writing key cache '%s' (%zu entries)",
+		   cname, num);
+	if (wpa_config_key_cache_write_file(cname, buf, len) < 0)
+		wpa_printf(MSG_INFO, "Failed to write key cache '%s'", cname);
+fail:
+	bin_clear_free(buf, len);
+out:
+	os_free(cname);
+}
+
+#endif /* CONFIG_NO_CONFIG_WRITE */
+
+#else /* CONFIG_NO_PBKDF2 */
+
+struct wpa_config_key_cache;
+
+static void wpa_config_key_cache_psk(struct wpa_config_key_cache *cache,
+				     struct wpa_ssid *ssid)
+{
+	wpa_config_update_psk(ssid);
+}
 
-static int wpa_config_validate_network(struct wpa_ssid *ssid, int line)
+#endif /* CONFIG_NO_PBKDF2 */
+
+
+static int wpa_config_validate_network(struct wpa_ssid *ssid, int line,
+				       struct wpa_config_key_cache *cache)
 {
 	int errors = 0;
 
@@ -36,7 +317,7 @@ static int wpa_config_validate_network(struct wpa_ssid *ssid, int line)
 				   "passphrase configured.", line);
 			errors++;
 		}
-		wpa_config_update_psk(ssid);
+		wpa_config_key_cache_psk(cache, ssid);
 	}
 
 	if (ssid->disabled == 2)
@@ -82,7 +363,9 @@ static int wpa_config_validate_network(struct wpa_ssid *ssid, int line)
 }
 
 
-static struct wpa_ssid * wpa_config_read_network(FILE *f, int *line, int id)
+static struct wpa_ssid *
+wpa_config_read_network(FILE *f, int *line, int id,
+			struct wpa_config_key_cache *cache)
 {
 	struct wpa_ssid *ssid;
 	int errors = 0, end = 0;
@@ -146,7 +429,7 @@ static struct wpa_ssid * wpa_config_read_network(FILE *f, int *line, int id)
 		errors++;
 	}
 
-	errors += wpa_config_validate_network(ssid, *line);
+	errors += wpa_config_validate_network(ssid, *line, cache);
 
 	if (errors) {
 		wpa_config_free_ssid(ssid);
@@ -355,6 +638,196 @@ static struct wpa_dev_ik * wpa_config_read_identity(FILE *f, int *line, int id)
 }
 
 
+#ifdef CONFIG_CONFIG_JOURNAL
+
+static void wpa_config_journal_init(struct wpa_config *config, int records);
+
+
+static char * wpa_config_journal_name(const char *name)
+{
+	size_t len = os_strlen(name) + 9;
+	char *jname;
+
+	jname = os_malloc(len);
+	if (jname)
+		os_snprintf(jname, len, "%s.journal", name);
+	return jname;
+}
+
+
+struct wpa_config_journal_op {
+	enum { JOURNAL_REMOVE, JOURNAL_UPDATE, JOURNAL_ADD } type;
+	unsigned int idx;
+	struct wpa_ssid *ssid;
+};
+
+
+static struct wpa_ssid ** wpa_config_journal_nth(struct wpa_ssid **pos,
+						 unsigned int idx)
+{
+	while (*pos && idx--)
+		pos = &(*pos)->next;
+	return *pos ? pos : NULL;
+}
+
+
+static int wpa_config_journal_apply(struct wpa_config *config,
+				    struct wpa_config_journal_op *op)
+{
+	struct wpa_ssid **pos, *old;
+
+	if (op->type == JOURNAL_ADD) {
+		for (pos = &config->ssid; *pos; pos = &(*pos)->next)
+			;
+		*pos = op->ssid;
+		op->ssid = NULL;
+		return 0;
+	}
+
+	pos = wpa_config_journal_nth(&config->ssid, op->idx);
+	if (!pos)
+		return -1;
+	old = *pos;
+	if (op->type == JOURNAL_UPDATE) {
+		op->ssid->id = old->id;
+		op->ssid->next = old->next;
+		*pos = op->ssid;
+		op->ssid = NULL;
+	} else {
+		*pos = old->next;
+	}
+	wpa_config_free_ssid(old);
+	return 0;
+}
+
+
+static void wpa_config_journal_free_ops(struct wpa_config_journal_op *ops,
+					size_t num)
+{
+	size_t i;
+
+	for (i = 0; i < num; i++) {
+		if (ops[i].ssid)
+			wpa_config_free_ssid(ops[i].ssid);
+	}
+	os_free(ops);
+}
+
+
+static int wpa_config_journal_read_op(FILE *f, int *line, char *pos,
+				      struct wpa_config_journal_op *op, int *id,
+				      struct wpa_config_key_cache *cache)
+{
+	char buf[512], *end;
+	unsigned long idx;
+
+	os_memset(op, 0, sizeof(*op));
+	op->type = JOURNAL_ADD;
+
+	if (os_strncmp(pos, "remove=", 7) == 0 ||
+	    os_strncmp(pos, "update=", 7) == 0) {
+		op->type = pos[0] == 'r' ? JOURNAL_REMOVE : JOURNAL_UPDATE;
+		idx = strtoul(pos + 7, &end, 10);
+		if (end == pos + 7 || *end || (unsigned int) idx != idx)
+			return -1;
+		op->idx = idx;
+		if (op->type == JOURNAL_REMOVE)
+			return 0;
+		if (!wpa_config_get_line(buf, sizeof(buf), f, line, &pos))
+			return -1;
+	}
+
+	if (os_strcmp(pos, "network={") != 0)
+		return -1;
+	op->ssid = wpa_config_read_network(f, line,
+					   op->type == JOURNAL_ADD ? (*id)++ : 0,
+					   cache);
+	return op->ssid ? 0 : -1;
+}
+
+
+/**
+ * wpa_config_journal_read - Replay the configuration journal
+ * @name: Name of the configuration file
+ * @config: Configuration data with the networks from the configuration file
+ * @id: Next free network id
+ * @cache: Key cache for the networks
+ * Returns: Number of replayed journal records or -1 if the journal could not
+ * be replayed completely
+ *
+ * Each write appends a batch of records terminated with a "commit" line, so a
+ * batch that was not completely written is ignored. "remove=<index>" and
+ * "update=<index>" followed by a network block refer to the position of the
+ * network in the configuration; a network block without a preceding record
+ * adds a network to the end of the list.
+ */
+static int wpa_config_journal_read(const char *name, struct wpa_config *config,
+				   int *id, struct wpa_config_key_cache *cache)
+{
+	char buf[512], *pos, *jname;
+	struct wpa_config_journal_op *ops = NULL, *n;
+	size_t num_ops = 0, i;
+	int records = 0, line = 0;
+	FILE *f;
+
+	jname = wpa_config_journal_name(name);
+	if (!jname)
+		return 0;
+	f = fopen(jname, "r");
+	if (!f) {
+		os_free(jname);
+		return 0;
+	}
+
+	wpa_printf(MSG_DEBUG, "Reading configuration journal '%s'", jname);
+
+	while (wpa_config_get_line(buf, sizeof(buf), f, &line, &pos)) {
+		if (os_strcmp(pos, "commit") == 0) {
+			for (i = 0; i < num_ops; i++) {
+				if (wpa_config_journal_apply(config,
+							     &ops[i]) < 0) {
+					wpa_printf(MSG_ERROR,
+						   "Line %d: invalid network index %u in configuration journal",
+						   line, ops[i].idx);
+					records = -1;
+					goto out;
+				}
+			}
+			records += num_ops;
+			wpa_config_journal_free_ops(ops, num_ops);
+			ops = NULL;
+			num_ops = 0;
+			continue;
+		}
+
+		n = os_realloc_array(ops, num_ops + 1, sizeof(*ops));
+		if (!n ||
+		    wpa_config_journal_read_op(f, &line, pos, &n[num_ops],
+					       id, cache) < 0) {
+			ops = n ? n : ops;
+			records = -1;
+			break;
+		}
+		ops = n;
+		num_ops++;
+	}
+
+	if (records < 0 || num_ops) {
+		wpa_printf(MSG_INFO,
+			   "Line %d: ignored incomplete configuration journal record",
+			   line);
+		records = -1;
+	}
+out:
+	wpa_config_journal_free_ops(ops, num_ops);
+	fclose(f);
+	os_free(jname);
+	return records;
+}
+
+#endif /* CONFIG_CONFIG_JOURNAL */
+
+
 struct wpa_config * wpa_config_read(const char *name, struct wpa_config *cfgp,
 				    bool ro)
 {
@@ -368,6 +841,10 @@ struct wpa_config * wpa_config_read(const char *name, struct wpa_config *cfgp,
 	static int id = 0;
 	static int cred_id = 0;
 	static int identity_id = 0;
+	struct wpa_config_key_cache *key_cache = NULL;
+#ifndef CONFIG_NO_PBKDF2
+	struct wpa_config_key_cache kc;
+#endif /* CONFIG_NO_PBKDF2 */
 
 	if (name == NULL)
 		return NULL;
@@ -400,9 +877,19 @@ struct wpa_config * wpa_config_read(const char *name, struct wpa_config *cfgp,
 		return NULL;
 	}
 
+#ifndef CONFIG_NO_PBKDF2
+	if (!ro) {
+		os_memset(&kc, 0, sizeof(kc));
+		kc.name = name;
+		kc.config = config;
+		key_cache = &kc;
+	}
+#endif /* CONFIG_NO_PBKDF2 */
+
 	while (wpa_config_get_line(buf, sizeof(buf), f, &line, &pos)) {
 		if (os_strcmp(pos, "network={") == 0) {
-			ssid = wpa_config_read_network(f, &line, id++);
+			ssid = wpa_config_read_network(f, &line, id++,
+						       key_cache);
 			if (ssid == NULL) {
 				wpa_printf(MSG_ERROR, "Line %d: failed to "
 					   "parse network block.", line);
@@ -474,9 +961,34 @@ struct wpa_config * wpa_config_read(const char *name, struct wpa_config *cfgp,
 	fclose(f);
 
 	config->ssid = head;
-	wpa_config_debug_dump_networks(config);
 	config->cred = cred_head;
 	config->identity = identity_head;
+#ifdef CONFIG_CONFIG_JOURNAL
+	if (!cfgp && !ro) {
+		int records;
+
+		records = wpa_config_journal_read(name, config, &id,
+						  key_cache);
+		if (records && wpa_config_update_prio_list(config) < 0)
+			errors++;
+		wpa_config_journal_init(config, records);
+	}
+#endif /* CONFIG_CONFIG_JOURNAL */
+	wpa_config_debug_dump_networks(config);
+
+#ifndef CONFIG_NO_PBKDF2
+	if (key_cache) {
+#ifndef CONFIG_NO_CONFIG_WRITE
+		if (!errors)
+			wpa_config_key_cache_update(key_cache);
+#endif /* CONFIG_NO_CONFIG_WRITE */
+		if (key_cache->hits || key_cache->misses)
+			wpa_printf(MSG_DEBUG,
+				   "Key cache: %u hit(s), %u miss(es)",
+				   key_cache->hits, key_cache->misses);
+		wpa_config_key_cache_deinit(key_cache);
+	}
+#endif /* CONFIG_NO_PBKDF2 */
 
 #ifndef WPA_IGNORE_CONFIG_ERRORS
 	if (errors) {
@@ -1202,6 +1714,8 @@ static void wpa_config_write_global(FILE *f, struct wpa_config *config)
 		fprintf(f, "ctrl_interface_group=%s\n",
 			config->ctrl_interface_group);
 #endif /* CONFIG_CTRL_IFACE */
+	if (config->dbus_lazy_bss)
+		fprintf(f, "dbus_lazy_bss=%d\n", config->dbus_lazy_bss);
 	if (config->eapol_version != DEFAULT_EAPOL_VERSION)
 		fprintf(f, "eapol_version=%d\n", config->eapol_version);
 	if (config->ap_scan != DEFAULT_AP_SCAN)
@@ -1245,6 +1759,10 @@ static void wpa_config_write_global(FILE *f, struct wpa_config *config)
 			config->dot11RSNAConfigSATimeout);
 	if (config->update_config)
 		fprintf(f, "update_config=%d\n", config->update_config);
+	if (config->config_journal)
+		fprintf(f, "config_journal=%d\n", config->config_journal);
+	if (config->config_cache)
+		fprintf(f, "config_cache=%d\n", config->config_cache);
 #ifdef CONFIG_WPS
 	if (!is_nil_uuid(config->uuid)) {
 		char buf[40];
@@ -1483,12 +2001,27 @@ static void wpa_config_write_global(FILE *f, struct wpa_config *config)
 	if (config->ext_password_backend)
 		fprintf(f, "ext_password_backend=%s\n",
 			config->ext_password_backend);
+	if (config->pmksa_store_file)
+		fprintf(f, "pmksa_store_file=%s\n", config->pmksa_store_file);
+	write_global_bin(f, "pmksa_store_key", config->pmksa_store_key);
+	if (config->status_shm_dir)
+		fprintf(f, "status_shm_dir=%s\n", config->status_shm_dir);
+	if (config->status_shm_interval)
+		fprintf(f, "status_shm_interval=%d\n",
+			config->status_shm_interval);
+	if (config->signal_poll_cache_ms)
+		fprintf(f, "signal_poll_cache_ms=%d\n",
+			config->signal_poll_cache_ms);
 	if (config->p2p_go_max_inactivity != DEFAULT_P2P_GO_MAX_INACTIVITY)
 		fprintf(f, "p2p_go_max_inactivity=%d\n",
 			config->p2p_go_max_inactivity);
 	if (config->auto_interworking)
 		fprintf(f, "auto_interworking=%d\n",
 			config->auto_interworking);
+	if (config->anqp_cache_ttl)
+		fprintf(f, "anqp_cache_ttl=%d\n", config->anqp_cache_ttl);
+	if (config->anqp_cache_size != DEFAULT_ANQP_CACHE_SIZE)
+		fprintf(f, "anqp_cache_size=%d\n", config->anqp_cache_size);
 	if (config->okc)
 		fprintf(f, "okc=%d\n", config->okc);
 	if (config->pmf)
@@ -1518,6 +2051,10 @@ static void wpa_config_write_global(FILE *f, struct wpa_config *config)
 		fprintf(f, "sae_pmkid_in_assoc=%d\n",
 			config->sae_pmkid_in_assoc);
 
+	if (config->sae_precompute_commit)
+		fprintf(f, "sae_precompute_commit=%d\n",
+			config->sae_precompute_commit);
+
 	if (config->ap_vendor_elements) {
 		int i, len = wpabuf_len(config->ap_vendor_elements);
 		const u8 *p = wpabuf_head_u8(config->ap_vendor_elements);
@@ -1545,6 +2082,10 @@ static void wpa_config_write_global(FILE *f, struct wpa_config *config)
 		fprintf(f, "ignore_old_scan_res=%d\n",
 			config->ignore_old_scan_res);
 
+	if (config->scan_res_filter_freqs)
+		fprintf(f, "scan_res_filter_freqs=%d\n",
+			config->scan_res_filter_freqs);
+
 	if (config->freq_list && config->freq_list[0]) {
 		int i;
 		fprintf(f, "freq_list=");
@@ -1565,11 +2106,19 @@ static void wpa_config_write_global(FILE *f, struct wpa_config *config)
 	}
 	if (config->scan_cur_freq != DEFAULT_SCAN_CUR_FREQ)
 		fprintf(f, "scan_cur_freq=%d\n", config->scan_cur_freq);
+	if (config->roam_scan_max_freqs)
+		fprintf(f, "roam_scan_max_freqs=%d\n",
+			config->roam_scan_max_freqs);
 
 	if (config->scan_res_valid_for_connect !=
 	    DEFAULT_SCAN_RES_VALID_FOR_CONNECT)
 		fprintf(f, "scan_res_valid_for_connect=%d\n",
 			config->scan_res_valid_for_connect);
+	if (config->scan_res_stale_budget)
+		fprintf(f, "scan_res_stale_budget=%d\n",
+			config->scan_res_stale_budget);
+	if (config->scan_merge)
+		fprintf(f, "scan_merge=%d\n", config->scan_merge);
 
 	if (config->sched_scan_interval)
 		fprintf(f, "sched_scan_interval=%u\n",
@@ -1585,6 +2134,12 @@ static void wpa_config_write_global(FILE *f, struct wpa_config *config)
 	if (config->tdls_external_control)
 		fprintf(f, "tdls_external_control=%d\n",
 			config->tdls_external_control);
+	if (config->tdls_monitor_interval)
+		fprintf(f, "tdls_monitor_interval=%u\n",
+			config->tdls_monitor_interval);
+	if (config->tdls_monitor_links != DEFAULT_TDLS_MONITOR_LINKS)
+		fprintf(f, "tdls_monitor_links=%u\n",
+			config->tdls_monitor_links);
 
 	if (config->wowlan_triggers)
 		fprintf(f, "wowlan_triggers=%s\n",
@@ -1634,6 +2189,9 @@ static void wpa_config_write_global(FILE *f, struct wpa_config *config)
 		fprintf(f, "dot11RSNASAERetransPeriod=%d\n",
 			config->dot11RSNASAERetransPeriod);
 
+	if (config->mesh_auth_rate)
+		fprintf(f, "mesh_auth_rate=%u\n", config->mesh_auth_rate);
+
 	if (config->passive_scan)
 		fprintf(f, "passive_scan=%d\n", config->passive_scan);
 
@@ -1690,6 +2248,8 @@ static void wpa_config_write_global(FILE *f, struct wpa_config *config)
 			config->gas_rand_addr_lifetime);
 	if (config->gas_rand_mac_addr)
 		fprintf(f, "gas_rand_mac_addr=%d\n", config->gas_rand_mac_addr);
+	if (config->gas_max_parallel != DEFAULT_GAS_MAX_PARALLEL)
+		fprintf(f, "gas_max_parallel=%d\n", config->gas_max_parallel);
 	if (config->dpp_config_processing)
 		fprintf(f, "dpp_config_processing=%d\n",
 			config->dpp_config_processing);
@@ -1763,6 +2323,309 @@ static void wpa_config_write_identity(FILE *f, struct wpa_dev_ik *dev_ik)
 		write_global_bin(f, "\tpmkid", dev_ik->pmkid);
 }
 
+static bool wpa_config_network_saved(struct wpa_ssid *ssid)
+{
+	if (ssid->key_mgmt == WPA_KEY_MGMT_WPS || ssid->temporary ||
+	    ssid->ro)
+		return false; /* do not save temporary networks */
+	if (wpa_key_mgmt_wpa_psk_no_sae(ssid->key_mgmt) &&
+	    !ssid->psk_set && !ssid->passphrase)
+		return false; /* do not save invalid network */
+	if (wpa_key_mgmt_sae(ssid->key_mgmt) &&
+	    !ssid->passphrase && !ssid->sae_password &&
+	    !ssid->pmk_valid)
+		return false; /* do not save invalid network */
+	return true;
+}
+
+
+#ifdef CONFIG_CONFIG_JOURNAL
+
+static void wpa_config_journal_write_other(FILE *f, void *ctx)
+{
+	struct wpa_config *config = ctx;
+	struct wpa_cred *cred;
+	struct wpa_dev_ik *dev_ik;
+#ifndef CONFIG_NO_CONFIG_BLOBS
+	struct wpa_config_blob *blob;
+#endif /* CONFIG_NO_CONFIG_BLOBS */
+
+	wpa_config_write_global(f, config);
+	for (cred = config->cred; cred; cred = cred->next) {
+		if (cred->temporary)
+			continue;
+		fprintf(f, "\ncred={\n");
+		wpa_config_write_cred(f, cred);
+		fprintf(f, "}\n");
+	}
+	for (dev_ik = config->identity; dev_ik; dev_ik = dev_ik->next) {
+		fprintf(f, "\nidentity={\n");
+		wpa_config_write_identity(f, dev_ik);
+		fprintf(f, "}\n");
+	}
+#ifndef CONFIG_NO_CONFIG_BLOBS
+	for (blob = config->blobs; blob; blob = blob->next)
+		wpa_config_write_blob(f, blob);
+#endif /* CONFIG_NO_CONFIG_BLOBS */
+}
+
+
+static void wpa_config_journal_write_network(FILE *f, void *ctx)
+{
+	wpa_config_write_network(f, ctx);
+}
+
+
+/* Hash the configuration data that write() would store in the file */
+static int wpa_config_journal_hash(void (*write)(FILE *f, void *ctx),
+				   void *ctx, u8 *hash)
+{
+	size_t size = 4096, len;
+	const u8 *addr[1];
+	char *buf;
+	FILE *f;
+	long pos;
+	int ret;
+
+	for (;;) {
+		buf = os_malloc(size);
+		if (!buf)
+			return -1;
+		f = fmemopen(buf, size, "w");
+		if (!f) {
+			os_free(buf);
+			return -1;
+		}
+		write(f, ctx);
+		pos = ftell(f);
+		fclose(f);
+		if (pos >= 0 && (size_t) pos < size - 1)
+			break;
+		bin_clear_free(buf, size);
+		if (pos < 0 || size >= 16 * 1024 * 1024)
+			return -1;
+		size *= 2;
+	}
+
+	addr[0] = (const u8 *) buf;
+	len = pos;
+	ret = sha256_vector(1, addr, &len, hash);
+	bin_clear_free(buf, size);
+	return ret;
+}
+
+
+static int wpa_config_journal_nets(struct wpa_config *config,
+				   struct wpa_config_journal_net **nets,
+				   size_t *num_nets)
+{
+	struct wpa_ssid *ssid;
+	size_t num = 0;
+
+	for (ssid = config->ssid; ssid; ssid = ssid->next) {
+		if (wpa_config_network_saved(ssid))
+			num++;
+	}
+
+	*nets = os_calloc(num ? num : 1, sizeof(**nets));
+	if (!*nets)
+		return -1;
+	*num_nets = num;
+
+	num = 0;
+	for (ssid = config->ssid; ssid; ssid = ssid->next) {
+		if (!wpa_config_network_saved(ssid))
+			continue;
+		(*nets)[num].ssid = ssid;
+		if (wpa_config_journal_hash(wpa_config_journal_write_network,
+					    ssid, (*nets)[num].hash) < 0) {
+			os_free(*nets);
+			*nets = NULL;
+			return -1;
+		}
+		num++;
+	}
+
+	return 0;
+}
+
+
+/*
+ * Record the stored state of the configuration as the base for the following
+ * journal writes. A negative records value marks the stored configuration as
+ * not matching the journal, e.g., because the journal could not be replayed,
+ * so that the next write rewrites the configuration file.
+ */
+static void wpa_config_journal_init(struct wpa_config *config, int records)
+{
+	struct wpa_config_journal *journal = &config->journal;
+	struct wpa_ssid *ssid;
+
+	os_free(journal->nets);
+	os_memset(journal, 0, sizeof(*journal));
+
+	if (!config->config_journal || records < 0)
+		return;
+
+	/*
+	 * Networks that are not saved would remain in the configuration file
+	 * and break the network indexes used in the journal.
+	 */
+	for (ssid = config->ssid; ssid; ssid = ssid->next) {
+		if (!ssid->ro && !wpa_config_network_saved(ssid))
+			return;
+	}
+
+	if (wpa_config_journal_hash(wpa_config_journal_write_other, config,
+				    journal->other_hash) < 0 ||
+	    wpa_config_journal_nets(config, &journal->nets,
+				    &journal->num_nets) < 0)
+		return;
+	journal->records = records;
+	journal->valid = true;
+}
+
+
+/*
+ * Write the journal records that convert the stored networks into nets. If f
+ * is NULL, the records are only counted.
+ */
+static unsigned int
+wpa_config_journal_diff(FILE *f, struct wpa_config_journal *journal,
+			struct wpa_config_journal_net *nets, size_t num_nets)
+{
+	size_t i, j = 0;
+	unsigned int idx = 0, records = 0;
+
+	for (i = 0; i < journal->num_nets; i++) {
+		if (j < num_nets && nets[j].ssid == journal->nets[i].ssid) {
+			if (os_memcmp(nets[j].hash, journal->nets[i].hash,
+				      sizeof(nets[j].hash)) != 0) {
+				records++;
+				if (f) {
+					fprintf(f, "update=%u\nnetwork={\n",
+						idx);
+					wpa_config_write_network(f,
+								 nets[j].ssid);
+					fprintf(f, "}\n");
+				}
+			}
+			idx++;
+			j++;
+		} else {
+			/* The indexes of the following networks shift */
+			records++;
+			if (f)
+				fprintf(f, "remove=%u\n", idx);
+		}
+	}
+
+	for (; j < num_nets; j++) {
+		records++;
+		if (f) {
+			fprintf(f, "network={\n");
+			wpa_config_write_network(f, nets[j].ssid);
+			fprintf(f, "}\n");
+		}
+	}
+
+	return records;
+}
+
+
+/**
+ * wpa_config_journal_write - Store network changes in the journal
+ * @name: Name of the configuration file
+ * @config: Configuration data
+ * Returns: 0 if the changes were stored, -1 if the configuration file needs
+ * to be rewritten
+ */
+static int wpa_config_journal_write(const char *name,
+				    struct wpa_config *config)
+{
+	struct wpa_config_journal *journal = &config->journal;
+	struct wpa_config_journal_net *nets;
+	size_t num_nets;
+	u8 hash[32];
+	unsigned int records;
+	char *jname;
+	FILE *f;
+	int ret = -1;
+
+	if (!config->config_journal || !journal->valid ||
+	    wpa_config_journal_hash(wpa_config_journal_write_other, config,
+				    hash) < 0 ||
+	    os_memcmp(hash, journal->other_hash, sizeof(hash)) != 0 ||
+	    wpa_config_journal_nets(config, &nets, &num_nets) < 0)
+		return -1;
+
+	records = wpa_config_journal_diff(NULL, journal, nets, num_nets);
+	if (records == 0) {
+		wpa_printf(MSG_DEBUG,
+			   "No changes to configuration file '%s'", name);
+		os_free(nets);
+		return 0;
+	}
+	if (journal->records + records > (unsigned int) config->config_journal) {
+		wpa_printf(MSG_DEBUG,
+			   "Configuration journal full - rewrite '%s'", name);
+		goto out;
+	}
+
+	jname = wpa_config_journal_name(name);
+	if (!jname)
+		goto out;
+	f = fopen(jname, "a");
+	if (!f) {
+		wpa_printf(MSG_DEBUG, "Failed to open '%s' for writing",
+			   jname);
+		os_free(jname);
+		goto out;
+	}
+#ifdef ANDROID
+	fchmod(fileno(f), S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP);
+#endif /* ANDROID */
+
+	wpa_config_journal_diff(f, journal, nets, num_nets);
+	fprintf(f, "commit\n");
+	if (fflush(f) == 0 && !ferror(f) && os_fdatasync(f) == 0)
+		ret = 0;
+	if (fclose(f) != 0)
+		ret = -1;
+
+	wpa_printf(MSG_DEBUG,
+		   "Configuration journal '%s': %u record(s) written %ssuccessfully",
+		   jname, records, ret ? "un" : "");
+	os_free(jname);
+	if (ret == 0) {
+		os_free(journal->nets);
+		journal->nets = nets;
+		journal->num_nets = num_nets;
+		journal->records += records;
+		return 0;
+	}
+out:
+	os_free(nets);
+	return -1;
+}
+
+
+/* Remove the journal that is merged into a rewritten configuration file */
+static void wpa_config_journal_remove(const char *name)
+{
+	char *jname;
+
+	jname = wpa_config_journal_name(name);
+	if (!jname)
+		return;
+	if (unlink(jname) < 0 && errno != ENOENT)
+		wpa_printf(MSG_INFO, "Failed to remove '%s': %s",
+			   jname, strerror(errno));
+	os_free(jname);
+}
+
+#endif /* CONFIG_CONFIG_JOURNAL */
+
 #endif /* CONFIG_NO_CONFIG_WRITE */
 
 
@@ -1786,6 +2649,11 @@ int wpa_config_write(const char *name, struct wpa_config *config)
 		return -1;
 	}
 
+#ifdef CONFIG_CONFIG_JOURNAL
+	if (wpa_config_journal_write(name, config) == 0)
+		return 0;
+#endif /* CONFIG_CONFIG_JOURNAL */
+
 	tmp_len = os_strlen(name) + 5; /* allow space for .tmp suffix */
 	tmp_name = os_malloc(tmp_len);
 	if (tmp_name) {
@@ -1813,16 +2681,8 @@ int wpa_config_write(const char *name, struct wpa_config *config)
 	}
 
 	for (ssid = config->ssid; ssid; ssid = ssid->next) {
-		if (ssid->key_mgmt == WPA_KEY_MGMT_WPS || ssid->temporary ||
-		    ssid->ro)
-			continue; /* do not save temporary networks */
-		if (wpa_key_mgmt_wpa_psk_no_sae(ssid->key_mgmt) &&
-		    !ssid->psk_set && !ssid->passphrase)
-			continue; /* do not save invalid network */
-		if (wpa_key_mgmt_sae(ssid->key_mgmt) &&
-		    !ssid->passphrase && !ssid->sae_password &&
-		    !ssid->pmk_valid)
-			continue; /* do not save invalid network */
+		if (!wpa_config_network_saved(ssid))
+			continue;
 		fprintf(f, "\nnetwork={\n");
 		wpa_config_write_network(f, ssid);
 		fprintf(f, "}\n");
@@ -1846,6 +2706,14 @@ int wpa_config_write(const char *name, struct wpa_config *config)
 
 	fclose(f);
 
+#ifdef CONFIG_CONFIG_JOURNAL
+	/*
+	 * The new configuration file includes the journaled changes, so the
+	 * journal must not be replayed on top of it.
+	 */
+	wpa_config_journal_remove(orig_name);
+#endif /* CONFIG_CONFIG_JOURNAL */
+
 	if (tmp_name) {
 		int chmod_ret = 0;
 
@@ -1859,6 +2727,10 @@ int wpa_config_write(const char *name, struct wpa_config *config)
 		os_free(tmp_name);
 	}
 
+#ifdef CONFIG_CONFIG_JOURNAL
+	wpa_config_journal_init(config, ret ? -1 : 0);
+#endif /* CONFIG_CONFIG_JOURNAL */
+
 	wpa_printf(MSG_DEBUG, "Configuration file '%s' written %ssuccessfully",
 		   orig_name, ret ? "un" : "");
 	return ret;
@@ -0,0 +1,228 @@
+/*
+ * wpa_supplicant - Connection latency trace
+ *
+ * This software may be distributed under the terms of the BSD license.
+ * See README for more details.
+ */
+
+#include "includes.h"
+
+#include "common.h"
+#include "wpa_supplicant_i.h"
+#include "connect_trace.h"
+
+
+static const char * const connect_phase_names[WPAS_CONNECT_NUM_PHASES] = {
+	"scan_request",
+	"scan_start",
+	"scan_results",
+	"bss_update",
+	"select",
+	"work_start",
+	"auth",
+	"assoc",
+	"4way",
+	"completed",
+};
+
+
+static unsigned int connect_trace_bucket(const struct os_reltime *diff)
+{
+	unsigned int bucket = 0;
+	os_time_t ms;
+
+	ms = diff->sec * 1000 + diff->usec / 1000;
+	while (ms > 0 && bucket < WPAS_CONNECT_HIST_BUCKETS - 1) {
+		ms >>= 1;
+		bucket++;
+	}
+
+	return bucket;
+}
+
+
+static void connect_trace_done(struct wpa_supplicant *wpa_s)
+{
+	struct wpas_connect_trace *t = &wpa_s->connect_trace;
+	struct os_reltime diff;
+	char buf[300], *pos, *end;
+	int p, prev = -1, first = -1, ret;
+
+	pos = buf;
+	end = buf + sizeof(buf);
+	*pos = '\0';
+
+	for (p = 0; p < WPAS_CONNECT_NUM_PHASES; p++) {
+		if (!(t->seen & BIT(p)))
+			continue;
+		if (prev < 0) {
+			prev = first = p;
+			continue;
+		}
+		os_reltime_sub(&t->ts[p], &t->ts[prev], &diff);
+		t->hist[p][connect_trace_bucket(&diff)]++;
+		ret = os_snprintf(pos, end - pos, " %s=%ld",
+				  connect_phase_names[p],
+				  (long) (diff.sec * 1000000 + diff.usec));
+		if (!os_snprintf_error(end - pos, ret))
+			pos += ret;
+		prev = p;
+	}
+
+	t->completed++;
+	t->last_seen = t->seen;
+	os_memcpy(t->last_ts, t->ts, sizeof(t->last_ts));
+	t->active = false;
+
+	if (first < 0 || prev == first)
+		return;
+	os_reltime_sub(&t->ts[prev], &t->ts[first], &diff);
+	wpa_msg(wpa_s, MSG_INFO, WPA_EVENT_CONNECT_TRACE "start=%s total=%ld%s",
+		connect_phase_names[first],
+		(long) (diff.sec * 1000000 + diff.usec), buf);
+}
+
+
+/**
+ * wpas_connect_trace - Record a phase of a connection attempt
+ * @wpa_s: Pointer to wpa_supplicant data
+ * @phase: The phase that was reached
+ *
+ * A new attempt is started when a scan is requested or a network is selected
+ * without a preceding scan. Only the first instance of each phase is recorded
+ * for an attempt. Once the connection is completed, the phase durations are
+ * added to the histograms.
+ */
+void wpas_connect_trace(struct wpa_supplicant *wpa_s,
+			enum wpas_connect_phase phase)
+{
+	struct wpas_connect_trace *t = &wpa_s->connect_trace;
+	bool selected = t->active && (t->seen & BIT(WPAS_CONNECT_SELECT));
+
+	if (phase == WPAS_CONNECT_SCAN_REQUEST) {
+		/* Do not let a scan during a connection attempt restart it */
+		if (selected)
+			return;
+		t->active = true;
+		t->seen = 0;
+	} else if (phase == WPAS_CONNECT_SELECT) {
+		if (!t->active || selected)
+			t->seen = 0;
+		t->active = true;
+		t->attempts++;
+	} else if (!t->active || (t->seen & BIT(phase)) ||
+		   selected != (phase > WPAS_CONNECT_SELECT)) {
+		return;
+	}
+
+	os_get_reltime(&t->ts[phase]);
+	t->seen |= BIT(phase);
+
+	if (phase == WPAS_CONNECT_COMPLETED)
+		connect_trace_done(wpa_s);
+}
+
+
+/**
+ * wpas_connect_trace_abort - Stop tracing a failed connection attempt
+ * @wpa_s: Pointer to wpa_supplicant data
+ */
+void wpas_connect_trace_abort(struct wpa_supplicant *wpa_s)
+{
+	struct wpas_connect_trace *t = &wpa_s->connect_trace;
+
+	if (t->active && (t->seen & BIT(WPAS_CONNECT_SELECT)))
+		t->active = false;
+}
+
+
+static int connect_trace_last(struct wpas_connect_trace *t, char *buf,
+			      size_t buflen)
+{
+	char *pos = buf, *end = buf + buflen;
+	struct os_reltime diff;
+	int p, prev = -1, ret;
+
+	ret = os_snprintf(pos, end - pos, "attempts=%u\ncompleted=%u\n",
+			  t->attempts, t->completed);
+	if (os_snprintf_error(end - pos, ret))
+		return -1;
+	pos += ret;
+
+	for (p = 0; p < WPAS_CONNECT_NUM_PHASES; p++) {
+		if (!(t->last_seen & BIT(p)))
+			continue;
+		if (prev >= 0) {
+			os_reltime_sub(&t->last_ts[p], &t->last_ts[prev],
+				       &diff);
+			ret = os_snprintf(pos, end - pos, "%s_us=%ld\n",
+					  connect_phase_names[p],
+					  (long) (diff.sec * 1000000 +
+						  diff.usec));
+			if (os_snprintf_error(end - pos, ret))
+				return -1;
+			pos += ret;
+		}
+		prev = p;
+	}
+
+	return pos - buf;
+}
+
+
+static int connect_trace_histogram(struct wpas_connect_trace *t, char *buf,
+				   size_t buflen)
+{
+	char *pos = buf, *end = buf + buflen;
+	int p, i, ret;
+
+	for (p = WPAS_CONNECT_SCAN_START; p < WPAS_CONNECT_NUM_PHASES; p++) {
+		ret = os_snprintf(pos, end - pos, "%s=", connect_phase_names[p]);
+		if (os_snprintf_error(end - pos, ret))
+			return -1;
+		pos += ret;
+
+		for (i = 0; i < WPAS_CONNECT_HIST_BUCKETS; i++) {
+			ret = os_snprintf(pos, end - pos, "%s%u",
+					  i ? "," : "", t->hist[p][i]);
+			if (os_snprintf_error(end - pos, ret))
+				return -1;
+			pos += ret;
+		}
+
+		ret = os_snprintf(pos, end - pos, "\n");
+		if (os_snprintf_error(end - pos, ret))
+			return -1;
+		pos += ret;
+	}
+
+	return pos - buf;
+}
+
+
+/**
+ * wpas_connect_trace_ctrl - Process CONNECT_TRACE control interface command
+ * @wpa_s: Pointer to wpa_supplicant data
+ * @cmd: Command parameters ("", "HISTOGRAM", or "RESET")
+ * @buf: Buffer for the response
+ * @buflen: Length of the response buffer
+ * Returns: Length of the response or -1 on failure
+ */
+int wpas_connect_trace_ctrl(struct wpa_supplicant *wpa_s, const char *cmd,
+			    char *buf, size_t buflen)
+{
+	struct wpas_connect_trace *t = &wpa_s->connect_trace;
+
+	if (*cmd == '\0')
+		return connect_trace_last(t, buf, buflen);
+
+	if (os_strcasecmp(cmd, "HISTOGRAM") == 0)
+		return connect_trace_histogram(t, buf, buflen);
+
+	if (os_strcasecmp(cmd, "RESET") == 0) {
+		os_memset(t, 0, sizeof(*t));
+		return os_snprintf(buf, buflen, "OK\n");
+	}
+
+	return -1;
+}
@@ -0,0 +1,54 @@
+/*
+ * wpa_supplicant - Connection latency trace
+ *
+ * This software may be distributed under the terms of the BSD license.
+ * See README for more details.
+ */
+
+#ifndef CONNECT_TRACE_H
+#define CONNECT_TRACE_H
+
+/*
+ * Phases of a connection attempt in the order they are normally reached. The
+ * time spent in a phase is the time from the previous phase that was recorded
+ * for the attempt.
+ */
+enum wpas_connect_phase {
+	WPAS_CONNECT_SCAN_REQUEST, /* scan radio work queued */
+	WPAS_CONNECT_SCAN_START, /* scan radio work started */
+	WPAS_CONNECT_SCAN_RESULTS, /* scan results event received */
+	WPAS_CONNECT_BSS_UPDATE, /* BSS table updated from the scan results */
+	WPAS_CONNECT_SELECT, /* network/BSS selected for connection */
+	WPAS_CONNECT_WORK_START, /* connect radio work started */
+	WPAS_CONNECT_AUTH, /* SME authentication completed */
+	WPAS_CONNECT_ASSOC, /* association completed */
+	WPAS_CONNECT_4WAY, /* 4-way handshake started */
+	WPAS_CONNECT_COMPLETED, /* connection completed */
+	WPAS_CONNECT_NUM_PHASES
+};
+
+/* Histogram buckets: < 1 ms, < 2 ms, < 4 ms, ..., >= 2^(N-2) ms */
+#define WPAS_CONNECT_HIST_BUCKETS 16
+
+struct wpas_connect_trace {
+	/* Current connection attempt */
+	bool active;
+	u32 seen; /* bitmap of recorded phases */
+	struct os_reltime ts[WPAS_CONNECT_NUM_PHASES];
+
+	/* Latest completed connection attempt */
+	u32 last_seen;
+	struct os_reltime last_ts[WPAS_CONNECT_NUM_PHASES];
+
+	unsigned int attempts;
+	unsigned int completed;
+	unsigned int hist[WPAS_CONNECT_NUM_PHASES][WPAS_CONNECT_HIST_BUCKETS];
+};
+
+void wpas_connect_trace(struct wpa_supplicant *wpa_s,
+			enum wpas_connect_phase phase);
+void wpas_connect_trace_abort(struct wpa_supplicant *wpa_s);
+int wpas_connect_trace_ctrl(struct wpa_supplicant *wpa_s, const char *cmd,
+			    char *buf, size_t buflen);
+
+#endif /* CONNECT_TRACE_H */
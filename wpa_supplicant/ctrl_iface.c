@@ -13,6 +13,7 @@
 
 #include "utils/common.h"
 #include "utils/eloop.h"
+#include "utils/memstat.h"
 #include "utils/uuid.h"
 #include "utils/module_tests.h"
 #include "common/version.h"
@@ -59,6 +60,7 @@
 #include "mesh.h"
 #include "dpp_supplicant.h"
 #include "sme.h"
+#include "pmksa_store.h"
 #include "nan_usd.h"
 
 #ifdef __NetBSD__
@@ -2536,6 +2538,64 @@ static int wpa_supplicant_ctrl_iface_status(struct wpa_supplicant *wpa_s,
 		pos += ret;
 	}
 
+	if (verbose && wpa_s->conf->roam_scan_max_freqs) {
+		static const char * const type_str[ROAM_SCAN_TYPES] = {
+			NULL, "partial", "full"
+		};
+		int type;
+
+		for (type = ROAM_SCAN_PARTIAL; type < ROAM_SCAN_TYPES; type++) {
+			unsigned int num = wpa_s->roam_scans[type];
+
+			ret = os_snprintf(pos, end - pos,
+					  "roam_scans_%s=%u\n"
+					  "roam_scan_%s_avg_ms=%llu\n",
+					  type_str[type], num, type_str[type],
+					  num ? (unsigned long long)
+					  (wpa_s->roam_scan_time_us[type] /
+					   num / 1000) : 0ULL);
+			if (os_snprintf_error(end - pos, ret))
+				return pos - buf;
+			pos += ret;
+		}
+	}
+
+	if (verbose && (wpa_s->scan_6ghz_stages[0] ||
+			wpa_s->scan_6ghz_stages[1])) {
+		static const char * const type_str[2] = { "psc", "rnr" };
+		int type;
+
+		for (type = 0; type < 2; type++) {
+			unsigned int num = wpa_s->scan_6ghz_stages[type];
+
+			ret = os_snprintf(pos, end - pos,
+					  "scan_6ghz_%s=%u\n"
+					  "scan_6ghz_%s_found=%u\n"
+					  "scan_6ghz_%s_avg_ms=%llu\n",
+					  type_str[type], num,
+					  type_str[type],
+					  wpa_s->scan_6ghz_found[type],
+					  type_str[type],
+					  num ? (unsigned long long)
+					  (wpa_s->scan_6ghz_time_us[type] /
+					   num / 1000) : 0ULL);
+			if (os_snprintf_error(end - pos, ret))
+				return pos - buf;
+			pos += ret;
+		}
+	}
+
+	if (verbose) {
+		ret = os_snprintf(pos, end - pos,
+				  "fast_assoc_scans_skipped=%u\n"
+				  "fast_assoc_cached=%u\n",
+				  wpa_s->fast_assoc_scans_skipped,
+				  wpa_s->fast_assoc_cached);
+		if (os_snprintf_error(end - pos, ret))
+			return pos - buf;
+		pos += ret;
+	}
+
 	res = rsn_preauth_get_status(wpa_s->wpa, pos, end - pos, verbose);
 	if (res >= 0)
 		pos += res;
@@ -2688,6 +2748,9 @@ static int wpa_supplicant_ctrl_iface_bssid_ignore(struct wpa_supplicant *wpa_s,
 		return 3;
 	}
 
+	if (os_strcmp(cmd, "stats") == 0)
+		return wpa_bssid_ignore_stats(wpa_s, buf, buflen);
+
 	wpa_printf(MSG_DEBUG, "CTRL_IFACE: BSSID_IGNORE bssid='%s'", cmd);
 	if (hwaddr_aton(cmd, bssid)) {
 		wpa_printf(MSG_DEBUG, "CTRL_IFACE: invalid BSSID '%s'", cmd);
@@ -3675,6 +3738,7 @@ static int wpa_supplicant_ctrl_iface_update_network(
 	    os_strcmp(name, "scan_freq") != 0 &&
 	    os_strcmp(name, "priority") != 0) {
 		wpa_sm_pmksa_cache_flush(wpa_s->wpa, ssid);
+		sme_sae_precomp_flush(wpa_s);
 
 		if (wpa_s->current_ssid == ssid ||
 		    wpa_s->current_ssid == NULL) {
@@ -3791,6 +3855,136 @@ static int wpa_supplicant_ctrl_iface_get_network(
 }
 
 
+static int wpa_supplicant_ctrl_iface_set_network_multi(
+	struct wpa_supplicant *wpa_s, char *cmd, char *buf, size_t buflen)
+{
+	int id, ret, prev_bssid_set, prev_disabled;
+	struct wpa_ssid *ssid;
+	char *line, *next, *name, *value, *pos, *end;
+	u8 prev_bssid[ETH_ALEN];
+
+	/*
+	 * cmd: "<network id|new> <variable name> <value>
+	 *       [\n<variable name> <value>]..."
+	 */
+	line = os_strchr(cmd, ' ');
+	if (!line)
+		return -1;
+	*line++ = '\0';
+
+	if (os_strcmp(cmd, "new") == 0) {
+		ssid = wpa_supplicant_add_network(wpa_s);
+		if (!ssid)
+			return -1;
+	} else {
+		id = atoi(cmd);
+		ssid = wpa_config_get_network(wpa_s->conf, id);
+		if (!ssid) {
+			wpa_printf(MSG_DEBUG,
+				   "CTRL_IFACE: Could not find network id=%d",
+				   id);
+			return -1;
+		}
+	}
+	wpa_printf(MSG_DEBUG, "CTRL_IFACE: SET_NETWORK_MULTI id=%d", ssid->id);
+
+	pos = buf;
+	end = buf + buflen;
+	ret = os_snprintf(pos, end - pos, "%d\n", ssid->id);
+	if (os_snprintf_error(end - pos, ret))
+		return -1;
+	pos += ret;
+
+	prev_bssid_set = ssid->bssid_set;
+	prev_disabled = ssid->disabled;
+	os_memcpy(prev_bssid, ssid->bssid, ETH_ALEN);
+
+	for (; line; line = next) {
+		next = os_strchr(line, '\n');
+		if (next)
+			*next++ = '\0';
+		if (*line == '\0')
+			continue;
+
+		name = line;
+		value = os_strchr(name, ' ');
+		if (value) {
+			*value++ = '\0';
+			wpa_printf(MSG_DEBUG, "CTRL_IFACE: SET_NETWORK_MULTI name='%s'",
+				   name);
+			wpa_hexdump_ascii_key(MSG_DEBUG, "CTRL_IFACE: value",
+					      (u8 *) value, os_strlen(value));
+			ret = wpa_supplicant_ctrl_iface_update_network(
+				wpa_s, ssid, name, value);
+		} else {
+			ret = -1;
+		}
+
+		ret = os_snprintf(pos, end - pos, "%s %s\n", name,
+				  ret == 0 ? "OK" : "FAIL");
+		if (os_snprintf_error(end - pos, ret))
+			return -1;
+		pos += ret;
+	}
+
+	if (ssid->bssid_set != prev_bssid_set ||
+	    !ether_addr_equal(ssid->bssid, prev_bssid))
+		wpas_notify_network_bssid_set_changed(wpa_s, ssid);
+
+	if (prev_disabled != ssid->disabled &&
+	    (prev_disabled == 2 || ssid->disabled == 2))
+		wpas_notify_network_type_changed(wpa_s, ssid);
+
+	return pos - buf;
+}
+
+
+static int wpa_supplicant_ctrl_iface_get_network_multi(
+	struct wpa_supplicant *wpa_s, char *cmd, char *buf, size_t buflen)
+{
+	int id, ret;
+	struct wpa_ssid *ssid;
+	char *name, *next, *value, *pos, *end;
+
+	/* cmd: "<network id> <variable name>[ <variable name>]..." */
+	name = os_strchr(cmd, ' ');
+	if (!name)
+		return -1;
+	*name++ = '\0';
+
+	id = atoi(cmd);
+	ssid = wpa_config_get_network(wpa_s->conf, id);
+	if (!ssid) {
+		wpa_printf(MSG_EXCESSIVE, "CTRL_IFACE: Could not find network "
+			   "id=%d", id);
+		return -1;
+	}
+
+	pos = buf;
+	end = buf + buflen;
+	for (; name; name = next) {
+		next = os_strchr(name, ' ');
+		if (next)
+			*next++ = '\0';
+		if (*name == '\0')
+			continue;
+
+		value = wpa_config_get_no_key(ssid, name);
+		if (value)
+			ret = os_snprintf(pos, end - pos, "%s=%s\n", name,
+					  value);
+		else
+			ret = os_snprintf(pos, end - pos, "%s FAIL\n", name);
+		os_free(value);
+		if (os_snprintf_error(end - pos, ret))
+			return -1;
+		pos += ret;
+	}
+
+	return pos - buf;
+}
+
+
 static int wpa_supplicant_ctrl_iface_dup_network(
 	struct wpa_supplicant *wpa_s, char *cmd,
 	struct wpa_supplicant *dst_wpa_s)
@@ -6090,6 +6284,8 @@ static int p2p_ctrl_find(struct wpa_supplicant *wpa_s, char *cmd)
 		type = P2P_FIND_ONLY_SOCIAL;
 	else if (os_strstr(cmd, "type=progressive"))
 		type = P2P_FIND_PROGRESSIVE;
+	else if (os_strstr(cmd, "type=fast"))
+		type = P2P_FIND_FAST;
 
 	pos = os_strstr(cmd, "dev_id=");
 	if (pos) {
@@ -8986,6 +9182,7 @@ static void wpa_supplicant_ctrl_iface_flush(struct wpa_supplicant *wpa_s)
 	hs20_cancel_fetch_osu(wpa_s);
 	hs20_del_icon(wpa_s, NULL, NULL);
 #endif /* CONFIG_HS20 */
+	interworking_anqp_cache_flush(wpa_s->global);
 #endif /* CONFIG_INTERWORKING */
 
 	wpa_s->ext_mgmt_frame_handling = 0;
@@ -9094,6 +9291,7 @@ static void wpa_supplicant_ctrl_iface_flush(struct wpa_supplicant *wpa_s)
 		wpas_restore_permanent_mac_addr(wpa_s);
 
 	wpa_s->conf->ignore_old_scan_res = 0;
+	wpa_s->conf->scan_res_filter_freqs = 0;
 
 #ifdef CONFIG_NAN_USD
 	wpas_nan_usd_flush(wpa_s);
@@ -9263,6 +9461,8 @@ static int wpas_ctrl_radio_work(struct wpa_supplicant *wpa_s, char *cmd,
 {
 	if (os_strcmp(cmd, "show") == 0)
 		return wpas_ctrl_radio_work_show(wpa_s, buf, buflen);
+	if (os_strcmp(cmd, "stats") == 0)
+		return radio_work_stats(wpa_s->radio, buf, buflen);
 	if (os_strncmp(cmd, "add ", 4) == 0)
 		return wpas_ctrl_radio_work_add(wpa_s, cmd + 4, buf, buflen);
 	if (os_strncmp(cmd, "done ", 5) == 0)
@@ -10549,6 +10749,29 @@ static int wpas_ctrl_iface_send_twt_teardown(struct wpa_supplicant *wpa_s,
 	return wpas_twt_send_teardown(wpa_s, flags);
 }
 
+
+static int wpas_ctrl_iface_twt_flow_add(struct wpa_supplicant *wpa_s,
+					char *cmd)
+{
+	unsigned int id, interval, duration;
+
+	/* <id> <wake interval usec> <wake duration usec> */
+	if (sscanf(cmd, "%u %u %u", &id, &interval, &duration) != 3 ||
+	    id > 255)
+		return -1;
+
+	return wpas_twt_flow_add(wpa_s, id, interval, duration);
+}
+
+
+static int wpas_ctrl_iface_twt_flow_remove(struct wpa_supplicant *wpa_s,
+					   char *cmd)
+{
+	if (os_strcmp(cmd, "all") == 0)
+		return wpas_twt_flow_remove(wpa_s, -1);
+	return wpas_twt_flow_remove(wpa_s, atoi(cmd) & 0xff);
+}
+
 #endif /* CONFIG_TESTING_OPTIONS */
 
 
@@ -10841,6 +11064,7 @@ static int wpas_ctrl_iface_send_neighbor_rep(struct wpa_supplicant *wpa_s,
 static int wpas_ctrl_iface_erp_flush(struct wpa_supplicant *wpa_s)
 {
 	eapol_sm_erp_flush(wpa_s->eapol);
+	pmksa_store_erp_flush(wpa_s);
 	return 0;
 }
 
@@ -11200,6 +11424,7 @@ int wpas_ctrl_cmd_debug_level(const char *cmd)
 	if (os_strcmp(cmd, "PING") == 0 ||
 	    os_strncmp(cmd, "BSS ", 4) == 0 ||
 	    os_strncmp(cmd, "GET_NETWORK ", 12) == 0 ||
+	    os_strncmp(cmd, "GET_NETWORK_MULTI ", 18) == 0 ||
 	    os_strncmp(cmd, "STATUS", 6) == 0 ||
 	    os_strncmp(cmd, "STA ", 4) == 0 ||
 	    os_strncmp(cmd, "STA-", 4) == 0)
@@ -11750,7 +11975,6 @@ static int wpas_ctrl_iface_configure_scs(struct wpa_supplicant *wpa_s,
 
 	while (pos1) {
 		struct scs_desc_elem *n1;
-		struct active_scs_elem *active_scs_desc;
 		char *next_scs_desc, *pos2;
 		unsigned int num_tclas_elem = 0;
 		bool scsid_active = false, tclas_present = false;
@@ -11774,13 +11998,8 @@ static int wpas_ctrl_iface_configure_scs(struct wpa_supplicant *wpa_s,
 			pos1[next_scs_desc - pos1 - 1] = '\0';
 		}
 
-		dl_list_for_each(active_scs_desc, &wpa_s->active_scs_ids,
-				 struct active_scs_elem, list) {
-			if (desc_elem.scs_id == active_scs_desc->scs_id) {
-				scsid_active = true;
-				break;
-			}
-		}
+		if (wpas_scs_get_active(wpa_s, desc_elem.scs_id))
+			scsid_active = true;
 
 		if (os_strstr(pos1, "add ")) {
 			desc_elem.request_type = SCS_REQ_ADD;
@@ -12662,15 +12881,429 @@ fail:
 #endif /* CONFIG_NAN_USD */
 
 
+/* Per-command latency histogram buckets: <10us, <100us, <1ms, <10ms, <100ms,
+ * >=100ms */
+#define WPAS_CTRL_STATS_BUCKETS 6
+#define WPAS_CTRL_STATS_NAME_LEN 32
+/* Number of hash table slots (power of two); at most 3/4 of these are used
+ * for distinct command names and anything beyond that is counted as other */
+#define WPAS_CTRL_STATS_SIZE 256
+
+struct wpas_ctrl_cmd_stats {
+	char name[WPAS_CTRL_STATS_NAME_LEN];
+	unsigned int count;
+	unsigned int fail;
+	unsigned int max_usec;
+	u64 total_usec;
+	unsigned int hist[WPAS_CTRL_STATS_BUCKETS];
+};
+
+struct wpas_ctrl_stats {
+	struct wpas_ctrl_cmd_stats cmd[WPAS_CTRL_STATS_SIZE];
+	unsigned int num_cmds;
+	unsigned int other;
+};
+
+
+void wpas_ctrl_stats_free(struct wpas_ctrl_stats *stats)
+{
+	os_free(stats);
+}
+
+
+/* Copy the command name (the part before any arguments) so that nothing that
+ * could contain key material ends up in the statistics */
+static void wpas_ctrl_cmd_name(const char *buf, char *name)
+{
+	size_t i;
+
+	for (i = 0; i < WPAS_CTRL_STATS_NAME_LEN - 1; i++) {
+		if (buf[i] == '\0' || buf[i] == ' ' || buf[i] == ':' ||
+		    buf[i] == '=')
+			break;
+		name[i] = buf[i];
+	}
+	name[i] = '\0';
+}
+
+
+static struct wpas_ctrl_cmd_stats *
+wpas_ctrl_stats_get(struct wpas_ctrl_stats *stats, const char *name, int add)
+{
+	unsigned int hash = 2166136261U;
+	const char *pos;
+	struct wpas_ctrl_cmd_stats *cmd;
+
+	for (pos = name; *pos; pos++) {
+		hash ^= (u8) *pos;
+		hash *= 16777619;
+	}
+
+	for (;;) {
+		cmd = &stats->cmd[hash & (WPAS_CTRL_STATS_SIZE - 1)];
+		if (cmd->name[0] == '\0')
+			break;
+		if (os_strcmp(cmd->name, name) == 0)
+			return cmd;
+		hash++;
+	}
+
+	if (!add || stats->num_cmds >= WPAS_CTRL_STATS_SIZE * 3 / 4)
+		return NULL;
+	os_strlcpy(cmd->name, name, sizeof(cmd->name));
+	stats->num_cmds++;
+	return cmd;
+}
+
+
+static void wpas_ctrl_stats_record(struct wpas_ctrl_stats **stats_ptr,
+				   const char *name, struct os_reltime *start,
+				   int failed)
+{
+	struct wpas_ctrl_stats *stats = *stats_ptr;
+	struct wpas_ctrl_cmd_stats *cmd;
+	struct os_reltime now, diff;
+	unsigned int usec, limit;
+	int i;
+
+	if (!name[0])
+		return;
+
+	if (!stats) {
+		stats = os_zalloc(sizeof(*stats));
+		if (!stats)
+			return;
+		*stats_ptr = stats;
+	}
+
+	cmd = wpas_ctrl_stats_get(stats, name, 1);
+	if (!cmd) {
+		stats->other++;
+		return;
+	}
+
+	os_get_reltime(&now);
+	os_reltime_sub(&now, start, &diff);
+	if (diff.sec < 0)
+		usec = 0;
+	else if (diff.sec >= 4000)
+		usec = 4000000000U;
+	else
+		usec = diff.sec * 1000000 + diff.usec;
+
+	cmd->count++;
+	if (failed)
+		cmd->fail++;
+	cmd->total_usec += usec;
+	if (usec > cmd->max_usec)
+		cmd->max_usec = usec;
+	for (i = 0, limit = 10; i < WPAS_CTRL_STATS_BUCKETS - 1;
+	     i++, limit *= 10) {
+		if (usec < limit)
+			break;
+	}
+	cmd->hist[i]++;
+}
+
+
+static int wpas_ctrl_stats_cmd_print(const struct wpas_ctrl_cmd_stats *cmd,
+				     char *buf, size_t buflen)
+{
+	int ret;
+
+	ret = os_snprintf(buf, buflen,
+			  "%s count=%u fail=%u avg_usec=%u max_usec=%u hist=%u,%u,%u,%u,%u,%u\n",
+			  cmd->name, cmd->count, cmd->fail,
+			  cmd->count ?
+			  (unsigned int) (cmd->total_usec / cmd->count) : 0,
+			  cmd->max_usec, cmd->hist[0], cmd->hist[1],
+			  cmd->hist[2], cmd->hist[3], cmd->hist[4],
+			  cmd->hist[5]);
+	if (os_snprintf_error(buflen, ret))
+		return -1;
+	return ret;
+}
+
+
+static int wpas_ctrl_stats_print(struct wpas_ctrl_stats *stats,
+				 const char *name, char *buf, size_t buflen)
+{
+	struct wpas_ctrl_cmd_stats *cmd;
+	char *pos = buf, *end = buf + buflen;
+	int i, ret;
+
+	if (name && *name) {
+		cmd = stats ? wpas_ctrl_stats_get(stats, name, 0) : NULL;
+		if (!cmd)
+			return -1;
+		return wpas_ctrl_stats_cmd_print(cmd, buf, buflen);
+	}
+
+	if (!stats)
+		return 0;
+
+	for (i = 0; i < WPAS_CTRL_STATS_SIZE; i++) {
+		cmd = &stats->cmd[i];
+		if (cmd->name[0] == '\0')
+			continue;
+		ret = wpas_ctrl_stats_cmd_print(cmd, pos, end - pos);
+		if (ret < 0)
+			return pos - buf;
+		pos += ret;
+	}
+
+	if (stats->other) {
+		ret = os_snprintf(pos, end - pos, "other count=%u\n",
+				  stats->other);
+		if (!os_snprintf_error(end - pos, ret))
+			pos += ret;
+	}
+
+	return pos - buf;
+}
+
+
+/* Flags for struct wpas_ctrl_cmd::flags */
+#define WPAS_CTRL_NO_PARAMS BIT(0) /* "NAME" */
+#define WPAS_CTRL_PARAMS BIT(1) /* "NAME <params>" */
+
+/*
+ * Frequently used commands that are dispatched with a binary search over the
+ * command name before falling back to the full if/else chain. The handlers
+ * behave exactly like the matching entries in the chain. This table must be
+ * kept sorted by name.
+ */
+struct wpas_ctrl_cmd {
+	const char *name;
+	unsigned int flags;
+	/* ctx is struct wpa_supplicant or struct wpa_global */
+	int (*handler)(void *ctx, char *params, char *reply,
+		       size_t reply_size);
+};
+
+
+static int wpas_ctrl_cmd_cmp(const void *key, const void *elem)
+{
+	const char *name = key;
+	const struct wpas_ctrl_cmd *cmd = elem;
+
+	return os_strcmp(name, cmd->name);
+}
+
+
+static int wpas_ctrl_cmd_ping(void *ctx, char *params, char *reply,
+			      size_t reply_size)
+{
+	os_memcpy(reply, "PONG\n", 5);
+	return 5;
+}
+
+
+static int wpas_ctrl_cmd_bss(void *ctx, char *params, char *reply,
+			     size_t reply_size)
+{
+	return wpa_supplicant_ctrl_iface_bss(ctx, params, reply, reply_size);
+}
+
+
+static int wpas_ctrl_cmd_ctrl_stats(void *ctx, char *params, char *reply,
+				    size_t reply_size)
+{
+	struct wpa_supplicant *wpa_s = ctx;
+
+	return wpas_ctrl_stats_print(wpa_s->ctrl_stats, params, reply,
+				     reply_size);
+}
+
+
+static int wpas_ctrl_cmd_ctrl_stats_flush(void *ctx, char *params,
+					  char *reply, size_t reply_size)
+{
+	struct wpa_supplicant *wpa_s = ctx;
+
+	wpas_ctrl_stats_free(wpa_s->ctrl_stats);
+	wpa_s->ctrl_stats = NULL;
+	os_memcpy(reply, "OK\n", 3);
+	return 3;
+}
+
+
+static int wpas_ctrl_cmd_eloop_stats(void *ctx, char *params, char *reply,
+				     size_t reply_size)
+{
+	if (!params)
+		return eloop_stats_get(reply, reply_size);
+
+	/* START [<slow handler threshold in msec>] or STOP */
+	if (os_strncmp(params, "START", 5) == 0 &&
+	    (params[5] == '\0' || params[5] == ' ')) {
+		if (eloop_stats_enable(atoi(params + 5) * 1000) < 0)
+			return -1;
+	} else if (os_strcmp(params, "STOP") == 0) {
+		eloop_stats_disable();
+	} else {
+		return -1;
+	}
+	os_memcpy(reply, "OK\n", 3);
+	return 3;
+}
+
+
+static int wpas_ctrl_cmd_get_network(void *ctx, char *params, char *reply,
+				     size_t reply_size)
+{
+	return wpa_supplicant_ctrl_iface_get_network(ctx, params, reply,
+						     reply_size);
+}
+
+
+static int wpas_ctrl_cmd_ifname(void *ctx, char *params, char *reply,
+				size_t reply_size)
+{
+	struct wpa_supplicant *wpa_s = ctx;
+	int len = os_strlen(wpa_s->ifname);
+
+	os_memcpy(reply, wpa_s->ifname, len);
+	return len;
+}
+
+
+static int wpas_ctrl_cmd_list_networks(void *ctx, char *params, char *reply,
+				       size_t reply_size)
+{
+	return wpa_supplicant_ctrl_iface_list_networks(ctx, params, reply,
+						       reply_size);
+}
+
+
+static int wpas_ctrl_cmd_mlo_signal_poll(void *ctx, char *params,
+					 char *reply, size_t reply_size)
+{
+	return wpas_ctrl_iface_mlo_signal_poll(ctx, reply, reply_size);
+}
+
+
+static int wpas_ctrl_cmd_mlo_status(void *ctx, char *params, char *reply,
+				    size_t reply_size)
+{
+	return wpas_ctrl_iface_mlo_status(ctx, reply, reply_size);
+}
+
+
+static int wpas_ctrl_cmd_pktcnt_poll(void *ctx, char *params, char *reply,
+				     size_t reply_size)
+{
+	return wpa_supplicant_pktcnt_poll(ctx, reply, reply_size);
+}
+
+
+static int wpas_ctrl_cmd_scan_results(void *ctx, char *params, char *reply,
+				      size_t reply_size)
+{
+	return wpa_supplicant_ctrl_iface_scan_results(ctx, reply, reply_size);
+}
+
+
+static int wpas_ctrl_cmd_signal_poll(void *ctx, char *params, char *reply,
+				     size_t reply_size)
+{
+	return wpa_supplicant_signal_poll(ctx, reply, reply_size);
+}
+
+
+static int wpas_ctrl_cmd_status(void *ctx, char *params, char *reply,
+				size_t reply_size)
+{
+	return wpa_supplicant_ctrl_iface_status(ctx, "", reply, reply_size);
+}
+
+
+static int wpas_ctrl_cmd_status_verbose(void *ctx, char *params, char *reply,
+					size_t reply_size)
+{
+	return wpa_supplicant_ctrl_iface_status(ctx, "-VERBOSE", reply,
+						reply_size);
+}
+
+
+static const struct wpas_ctrl_cmd wpas_ctrl_cmds[] = {
+	{ "BSS", WPAS_CTRL_PARAMS, wpas_ctrl_cmd_bss },
+	{ "CTRL_STATS", WPAS_CTRL_NO_PARAMS | WPAS_CTRL_PARAMS,
+	  wpas_ctrl_cmd_ctrl_stats },
+	{ "CTRL_STATS_FLUSH", WPAS_CTRL_NO_PARAMS,
+	  wpas_ctrl_cmd_ctrl_stats_flush },
+	{ "ELOOP_STATS", WPAS_CTRL_NO_PARAMS | WPAS_CTRL_PARAMS,
+	  wpas_ctrl_cmd_eloop_stats },
+	{ "GET_NETWORK", WPAS_CTRL_PARAMS, wpas_ctrl_cmd_get_network },
+	{ "IFNAME", WPAS_CTRL_NO_PARAMS, wpas_ctrl_cmd_ifname },
+	{ "LIST_NETWORKS", WPAS_CTRL_NO_PARAMS | WPAS_CTRL_PARAMS,
+	  wpas_ctrl_cmd_list_networks },
+	{ "MLO_SIGNAL_POLL", WPAS_CTRL_NO_PARAMS,
+	  wpas_ctrl_cmd_mlo_signal_poll },
+	{ "MLO_STATUS", WPAS_CTRL_NO_PARAMS, wpas_ctrl_cmd_mlo_status },
+	{ "PING", WPAS_CTRL_NO_PARAMS, wpas_ctrl_cmd_ping },
+	{ "PKTCNT_POLL", WPAS_CTRL_NO_PARAMS | WPAS_CTRL_PARAMS,
+	  wpas_ctrl_cmd_pktcnt_poll },
+	{ "SCAN_RESULTS", WPAS_CTRL_NO_PARAMS, wpas_ctrl_cmd_scan_results },
+	{ "SIGNAL_POLL", WPAS_CTRL_NO_PARAMS | WPAS_CTRL_PARAMS,
+	  wpas_ctrl_cmd_signal_poll },
+	{ "STATUS", WPAS_CTRL_NO_PARAMS, wpas_ctrl_cmd_status },
+	{ "STATUS-VERBOSE", WPAS_CTRL_NO_PARAMS,
+	  wpas_ctrl_cmd_status_verbose },
+};
+
+
+/*
+ * Find a command table entry for buf. Returns the entry and sets *params to
+ * point to the arguments (NULL for the no-parameter form) or returns NULL if
+ * the command needs to be handled by the if/else chain.
+ */
+static const struct wpas_ctrl_cmd *
+wpas_ctrl_cmd_lookup(const struct wpas_ctrl_cmd *table, size_t num,
+		     const char *buf, char **params)
+{
+	char name[WPAS_CTRL_STATS_NAME_LEN];
+	const char *pos;
+	const struct wpas_ctrl_cmd *cmd;
+	size_t len;
+
+	pos = os_strchr(buf, ' ');
+	len = pos ? (size_t) (pos - buf) : os_strlen(buf);
+	if (len == 0 || len >= sizeof(name))
+		return NULL;
+	os_memcpy(name, buf, len);
+	name[len] = '\0';
+
+	cmd = bsearch(name, table, num, sizeof(*table), wpas_ctrl_cmd_cmp);
+	if (!cmd)
+		return NULL;
+
+	if (!pos && (cmd->flags & WPAS_CTRL_NO_PARAMS)) {
+		*params = NULL;
+		return cmd;
+	}
+	if (pos && (cmd->flags & WPAS_CTRL_PARAMS)) {
+		*params = (char *) pos + 1;
+		return cmd;
+	}
+	return NULL;
+}
+
+
 char * wpa_supplicant_ctrl_iface_process(struct wpa_supplicant *wpa_s,
 					 char *buf, size_t *resp_len)
 {
 	char *reply;
 	const int reply_size = 4096;
 	int reply_len;
+	const struct wpas_ctrl_cmd *cmd;
+	char *params;
+	char name[WPAS_CTRL_STATS_NAME_LEN];
+	struct os_reltime start;
 
 	if (os_strncmp(buf, WPA_CTRL_RSP, os_strlen(WPA_CTRL_RSP)) == 0 ||
 	    os_strncmp(buf, "SET_NETWORK ", 12) == 0 ||
+	    os_strncmp(buf, "SET_NETWORK_MULTI ", 18) == 0 ||
 	    os_strncmp(buf, "PMKSA_ADD ", 10) == 0 ||
 	    os_strncmp(buf, "MESH_PMKSA_ADD ", 15) == 0) {
 		if (wpa_debug_show_keys)
@@ -12682,7 +13315,7 @@ char * wpa_supplicant_ctrl_iface_process(struct wpa_supplicant *wpa_s,
 				os_strncmp(buf, WPA_CTRL_RSP,
 					   os_strlen(WPA_CTRL_RSP)) == 0 ?
 				WPA_CTRL_RSP :
-				(os_strncmp(buf, "SET_NETWORK ", 12) == 0 ?
+				(os_strncmp(buf, "SET_NETWORK", 11) == 0 ?
 				 "SET_NETWORK" : "key-add"));
 	} else if (os_strncmp(buf, "WPS_NFC_TAG_READ", 16) == 0 ||
 		   os_strncmp(buf, "NFC_REPORT_HANDOVER", 19) == 0) {
@@ -12702,7 +13335,14 @@ char * wpa_supplicant_ctrl_iface_process(struct wpa_supplicant *wpa_s,
 	os_memcpy(reply, "OK\n", 3);
 	reply_len = 3;
 
-	if (os_strcmp(buf, "PING") == 0) {
+	wpas_ctrl_cmd_name(buf, name);
+	os_get_reltime(&start);
+
+	cmd = wpas_ctrl_cmd_lookup(wpas_ctrl_cmds, ARRAY_SIZE(wpas_ctrl_cmds),
+				   buf, &params);
+	if (cmd) {
+		reply_len = cmd->handler(wpa_s, params, reply, reply_size);
+	} else if (os_strcmp(buf, "PING") == 0) {
 		os_memcpy(reply, "PONG\n", 5);
 		reply_len = 5;
 	} else if (os_strcmp(buf, "IFNAME") == 0) {
@@ -12711,6 +13351,9 @@ char * wpa_supplicant_ctrl_iface_process(struct wpa_supplicant *wpa_s,
 	} else if (os_strncmp(buf, "RELOG", 5) == 0) {
 		if (wpa_debug_reopen_file() < 0)
 			reply_len = -1;
+	} else if (os_strcmp(buf, "LOG_RING_DUMP") == 0) {
+		if (wpa_debug_ring_dump() < 0)
+			reply_len = -1;
 	} else if (os_strncmp(buf, "NOTE ", 5) == 0) {
 		wpa_printf(MSG_INFO, "NOTE: %s", buf + 5);
 	} else if (os_strcmp(buf, "MIB") == 0) {
@@ -12730,6 +13373,10 @@ char * wpa_supplicant_ctrl_iface_process(struct wpa_supplicant *wpa_s,
 			wpa_s, buf + 6, reply, reply_size);
 	} else if (os_strcmp(buf, "PMKSA") == 0) {
 		reply_len = wpas_ctrl_iface_pmksa(wpa_s, reply, reply_size);
+#ifdef CONFIG_MEMSTAT
+	} else if (os_strcmp(buf, "MEMSTAT") == 0) {
+		reply_len = memstat_print(reply, reply_size);
+#endif /* CONFIG_MEMSTAT */
 	} else if (os_strcmp(buf, "PMKSA_FLUSH") == 0) {
 		wpas_ctrl_iface_pmksa_flush(wpa_s);
 #ifdef CONFIG_PMKSA_CACHE_EXTERNAL
@@ -12929,6 +13576,12 @@ char * wpa_supplicant_ctrl_iface_process(struct wpa_supplicant *wpa_s,
 			reply_len = -1;
 	} else if (os_strcmp(buf, "P2P_STOP_FIND") == 0) {
 		wpas_p2p_stop_find(wpa_s);
+	} else if (os_strcmp(buf, "P2P_FIND_STATS") == 0) {
+		if (wpa_s->global->p2p_disabled || !wpa_s->global->p2p)
+			reply_len = -1;
+		else
+			reply_len = p2p_get_find_stats(wpa_s->global->p2p,
+						       reply, reply_size);
 	} else if (os_strncmp(buf, "P2P_ASP_PROVISION ", 18) == 0) {
 		if (p2p_ctrl_asp_provision(wpa_s, buf + 18))
 			reply_len = -1;
@@ -13055,6 +13708,9 @@ char * wpa_supplicant_ctrl_iface_process(struct wpa_supplicant *wpa_s,
 			reply_len = -1;
 	} else if (os_strcmp(buf, "STOP_FETCH_ANQP") == 0) {
 		interworking_stop_fetch_anqp(wpa_s);
+	} else if (os_strcmp(buf, "ANQP_FETCH_STATS") == 0) {
+		reply_len = interworking_anqp_fetch_stats(wpa_s, reply,
+							  reply_size);
 	} else if (os_strcmp(buf, "INTERWORKING_SELECT") == 0) {
 		if (ctrl_interworking_select(wpa_s, NULL) < 0)
 			reply_len = -1;
@@ -13182,6 +13838,12 @@ char * wpa_supplicant_ctrl_iface_process(struct wpa_supplicant *wpa_s,
 	} else if (os_strncmp(buf, "GET_NETWORK ", 12) == 0) {
 		reply_len = wpa_supplicant_ctrl_iface_get_network(
 			wpa_s, buf + 12, reply, reply_size);
+	} else if (os_strncmp(buf, "SET_NETWORK_MULTI ", 18) == 0) {
+		reply_len = wpa_supplicant_ctrl_iface_set_network_multi(
+			wpa_s, buf + 18, reply, reply_size);
+	} else if (os_strncmp(buf, "GET_NETWORK_MULTI ", 18) == 0) {
+		reply_len = wpa_supplicant_ctrl_iface_get_network_multi(
+			wpa_s, buf + 18, reply, reply_size);
 	} else if (os_strncmp(buf, "DUP_NETWORK ", 12) == 0) {
 		if (wpa_supplicant_ctrl_iface_dup_network(wpa_s, buf + 12,
 							  wpa_s))
@@ -13365,6 +14027,12 @@ char * wpa_supplicant_ctrl_iface_process(struct wpa_supplicant *wpa_s,
 	} else if (os_strncmp(buf, "PKTCNT_POLL", 11) == 0) {
 		reply_len = wpa_supplicant_pktcnt_poll(wpa_s, reply,
 						       reply_size);
+	} else if (os_strcmp(buf, "CONNECT_TRACE") == 0) {
+		reply_len = wpas_connect_trace_ctrl(wpa_s, "", reply,
+						    reply_size);
+	} else if (os_strncmp(buf, "CONNECT_TRACE ", 14) == 0) {
+		reply_len = wpas_connect_trace_ctrl(wpa_s, buf + 14, reply,
+						    reply_size);
 #ifdef CONFIG_AUTOSCAN
 	} else if (os_strncmp(buf, "AUTOSCAN ", 9) == 0) {
 		if (wpa_supplicant_ctrl_iface_autoscan(wpa_s, buf + 9))
@@ -13488,6 +14156,17 @@ char * wpa_supplicant_ctrl_iface_process(struct wpa_supplicant *wpa_s,
 	} else if (os_strcmp(buf, "TWT_TEARDOWN") == 0) {
 		if (wpas_ctrl_iface_send_twt_teardown(wpa_s, ""))
 			reply_len = -1;
+	} else if (os_strncmp(buf, "TWT_FLOW_ADD ", 13) == 0) {
+		if (wpas_ctrl_iface_twt_flow_add(wpa_s, buf + 13))
+			reply_len = -1;
+	} else if (os_strncmp(buf, "TWT_FLOW_REMOVE ", 16) == 0) {
+		if (wpas_ctrl_iface_twt_flow_remove(wpa_s, buf + 16))
+			reply_len = -1;
+	} else if (os_strncmp(buf, "TWT_FLOW_TRAFFIC ", 17) == 0) {
+		if (wpas_twt_flow_set_traffic(wpa_s, atoi(buf + 17)))
+			reply_len = -1;
+	} else if (os_strcmp(buf, "TWT_FLOW_STATUS") == 0) {
+		reply_len = wpas_twt_flow_status(wpa_s, reply, reply_size);
 	} else if (os_strncmp(buf, "ML_PROBE_REQ ", 13) == 0) {
 		if (wpas_ctrl_ml_probe(wpa_s, buf + 13))
 			reply_len = -1;
@@ -13657,6 +14336,9 @@ char * wpa_supplicant_ctrl_iface_process(struct wpa_supplicant *wpa_s,
 			reply_len = -1;
 	} else if (os_strcmp(buf, "DPP_CONTROLLER_STOP") == 0) {
 		dpp_controller_stop(wpa_s->dpp);
+	} else if (os_strcmp(buf, "DPP_CONTROLLER_STATS") == 0) {
+		reply_len = dpp_controller_get_stats(wpa_s->dpp, reply,
+						     reply_size);
 	} else if (os_strncmp(buf, "DPP_CHIRP ", 10) == 0) {
 		if (wpas_dpp_chirp(wpa_s, buf + 9) < 0)
 			reply_len = -1;
@@ -13699,6 +14381,8 @@ char * wpa_supplicant_ctrl_iface_process(struct wpa_supplicant *wpa_s,
 			reply_len = -1;
 	} else if (os_strcmp(buf, "NAN_FLUSH") == 0) {
 		wpas_nan_usd_flush(wpa_s);
+	} else if (os_strcmp(buf, "NAN_STATS") == 0) {
+		reply_len = wpas_nan_usd_stats(wpa_s, reply, reply_size);
 #endif /* CONFIG_NAN_USD */
 	} else if (os_strncmp(buf, "MSCS ", 5) == 0) {
 		if (wpas_ctrl_iface_configure_mscs(wpa_s, buf + 5))
@@ -13711,6 +14395,8 @@ char * wpa_supplicant_ctrl_iface_process(struct wpa_supplicant *wpa_s,
 		wpas_pasn_auth_stop(wpa_s);
 	} else if (os_strcmp(buf, "PTKSA_CACHE_LIST") == 0) {
 		reply_len = ptksa_cache_list(wpa_s->ptksa, reply, reply_size);
+	} else if (os_strcmp(buf, "PTKSA_CACHE_STATS") == 0) {
+		reply_len = ptksa_cache_stats(wpa_s->ptksa, reply, reply_size);
 	} else if (os_strncmp(buf, "PASN_DEAUTH ", 12) == 0) {
 		if (wpas_ctrl_iface_pasn_deauthenticate(wpa_s, buf + 12) < 0)
 			reply_len = -1;
@@ -13753,6 +14439,9 @@ char * wpa_supplicant_ctrl_iface_process(struct wpa_supplicant *wpa_s,
 		reply_len = 16;
 	}
 
+	wpas_ctrl_stats_record(&wpa_s->ctrl_stats, name, &start,
+			       reply_len < 0);
+
 	if (reply_len < 0) {
 		os_memcpy(reply, "FAIL\n", 5);
 		reply_len = 5;
@@ -14027,11 +14716,7 @@ static char * wpas_global_ctrl_iface_ifname(struct wpa_global *global,
 {
 	struct wpa_supplicant *wpa_s;
 
-	for (wpa_s = global->ifaces; wpa_s; wpa_s = wpa_s->next) {
-		if (os_strcmp(ifname, wpa_s->ifname) == 0)
-			break;
-	}
-
+	wpa_s = wpa_supplicant_get_iface(global, ifname);
 	if (wpa_s == NULL) {
 		char *resp = os_strdup("FAIL-NO-IFNAME-MATCH\n");
 		if (resp)
@@ -14053,6 +14738,7 @@ static char * wpas_global_ctrl_iface_redir_p2p(struct wpa_global *global,
 		"LIST_NETWORKS",
 		"P2P_FIND",
 		"P2P_STOP_FIND",
+		"P2P_FIND_STATS",
 		"P2P_LISTEN",
 		"P2P_GROUP_ADD",
 		"P2P_GET_PASSPHRASE",
@@ -14359,6 +15045,57 @@ static int wpas_global_ctrl_iface_fst_detach(struct wpa_global *global,
 #endif /* CONFIG_FST */
 
 
+static int wpas_global_ctrl_cmd_ctrl_stats(void *ctx, char *params,
+					   char *reply, size_t reply_size)
+{
+	struct wpa_global *global = ctx;
+
+	return wpas_ctrl_stats_print(global->ctrl_stats, params, reply,
+				     reply_size);
+}
+
+
+static int wpas_global_ctrl_cmd_ctrl_stats_flush(void *ctx, char *params,
+						 char *reply,
+						 size_t reply_size)
+{
+	struct wpa_global *global = ctx;
+
+	wpas_ctrl_stats_free(global->ctrl_stats);
+	global->ctrl_stats = NULL;
+	os_memcpy(reply, "OK\n", 3);
+	return 3;
+}
+
+
+static int wpas_global_ctrl_cmd_interface_list(void *ctx, char *params,
+					       char *reply,
+					       size_t reply_size)
+{
+	return wpa_supplicant_global_iface_list(ctx, reply, reply_size);
+}
+
+
+static int wpas_global_ctrl_cmd_status(void *ctx, char *params, char *reply,
+				       size_t reply_size)
+{
+	return wpas_global_ctrl_iface_status(ctx, reply, reply_size);
+}
+
+
+/* Sorted by name; see wpas_ctrl_cmds[] */
+static const struct wpas_ctrl_cmd wpas_global_ctrl_cmds[] = {
+	{ "CTRL_STATS", WPAS_CTRL_NO_PARAMS | WPAS_CTRL_PARAMS,
+	  wpas_global_ctrl_cmd_ctrl_stats },
+	{ "CTRL_STATS_FLUSH", WPAS_CTRL_NO_PARAMS,
+	  wpas_global_ctrl_cmd_ctrl_stats_flush },
+	{ "INTERFACE_LIST", WPAS_CTRL_NO_PARAMS,
+	  wpas_global_ctrl_cmd_interface_list },
+	{ "PING", WPAS_CTRL_NO_PARAMS, wpas_ctrl_cmd_ping },
+	{ "STATUS", WPAS_CTRL_NO_PARAMS, wpas_global_ctrl_cmd_status },
+};
+
+
 char * wpa_supplicant_global_ctrl_iface_process(struct wpa_global *global,
 						char *buf, size_t *resp_len)
 {
@@ -14366,6 +15103,10 @@ char * wpa_supplicant_global_ctrl_iface_process(struct wpa_global *global,
 	const int reply_size = 2048;
 	int reply_len;
 	int level = MSG_DEBUG;
+	const struct wpas_ctrl_cmd *cmd;
+	char *params;
+	char name[WPAS_CTRL_STATS_NAME_LEN];
+	struct os_reltime start;
 
 	if (os_strncmp(buf, "IFNAME=", 7) == 0) {
 		char *pos = os_strchr(buf + 7, ' ');
@@ -14395,7 +15136,15 @@ char * wpa_supplicant_global_ctrl_iface_process(struct wpa_global *global,
 	os_memcpy(reply, "OK\n", 3);
 	reply_len = 3;
 
-	if (os_strcmp(buf, "PING") == 0) {
+	wpas_ctrl_cmd_name(buf, name);
+	os_get_reltime(&start);
+
+	cmd = wpas_ctrl_cmd_lookup(wpas_global_ctrl_cmds,
+				   ARRAY_SIZE(wpas_global_ctrl_cmds),
+				   buf, &params);
+	if (cmd) {
+		reply_len = cmd->handler(global, params, reply, reply_size);
+	} else if (os_strcmp(buf, "PING") == 0) {
 		os_memcpy(reply, "PONG\n", 5);
 		reply_len = 5;
 	} else if (os_strncmp(buf, "INTERFACE_ADD ", 14) == 0) {
@@ -14461,11 +15210,17 @@ char * wpa_supplicant_global_ctrl_iface_process(struct wpa_global *global,
 	} else if (os_strncmp(buf, "RELOG", 5) == 0) {
 		if (wpa_debug_reopen_file() < 0)
 			reply_len = -1;
+	} else if (os_strcmp(buf, "LOG_RING_DUMP") == 0) {
+		if (wpa_debug_ring_dump() < 0)
+			reply_len = -1;
 	} else {
 		os_memcpy(reply, "UNKNOWN COMMAND\n", 16);
 		reply_len = 16;
 	}
 
+	wpas_ctrl_stats_record(&global->ctrl_stats, name, &start,
+			       reply_len < 0);
+
 	if (reply_len < 0) {
 		os_memcpy(reply, "FAIL\n", 5);
 		reply_len = 5;
@@ -9,6 +9,8 @@
 #ifndef CTRL_IFACE_H
 #define CTRL_IFACE_H
 
+struct wpas_ctrl_stats;
+
 #ifdef CONFIG_CTRL_IFACE
 
 #ifndef CTRL_IFACE_MAX_LEN
@@ -128,6 +130,8 @@ int wpa_supplicant_ctrl_iface_get_capability(
 
 int wpas_ctrl_cmd_debug_level(const char *cmd);
 
+void wpas_ctrl_stats_free(struct wpas_ctrl_stats *stats);
+
 #else /* CONFIG_CTRL_IFACE */
 
 static inline struct ctrl_iface_priv *
@@ -168,6 +172,10 @@ static inline void wpas_ctrl_radio_work_flush(struct wpa_supplicant *wpa_s)
 {
 }
 
+static inline void wpas_ctrl_stats_free(struct wpas_ctrl_stats *stats)
+{
+}
+
 #endif /* CONFIG_CTRL_IFACE */
 
 #endif /* CTRL_IFACE_H */
@@ -6,6 +6,9 @@
  * See README for more details.
  */
 
+#ifdef __linux__
+#define _GNU_SOURCE /* sendmmsg() */
+#endif /* __linux__ */
 #include "includes.h"
 #include <sys/un.h>
 #include <sys/stat.h>
@@ -24,6 +27,7 @@
 #include "utils/eloop.h"
 #include "utils/list.h"
 #include "common/ctrl_iface_common.h"
+#include "common/wpa_ctrl.h"
 #include "eapol_supp/eapol_supp_sm.h"
 #include "config.h"
 #include "wpa_supplicant_i.h"
@@ -36,8 +40,6 @@ struct ctrl_iface_priv {
 	int sock;
 	struct dl_list ctrl_dst;
 	int android_control_socket;
-	struct dl_list msg_queue;
-	unsigned int throttle_count;
 };
 
 
@@ -46,18 +48,22 @@ struct ctrl_iface_global_priv {
 	int sock;
 	struct dl_list ctrl_dst;
 	int android_control_socket;
-	struct dl_list msg_queue;
-	unsigned int throttle_count;
 };
 
-struct ctrl_iface_msg {
-	struct dl_list list;
-	struct wpa_supplicant *wpa_s;
-	int level;
-	enum wpa_msg_type type;
-	const char *txt;
-	size_t len;
-};
+/*
+ * Event messages that cannot be sent immediately are queued separately for
+ * each monitor, so that a monitor that does not keep up does not delay or
+ * drop the messages of the other ones. The oldest message is dropped once a
+ * monitor has CTRL_IFACE_MONITOR_QUEUE_LEN messages pending and the number of
+ * dropped messages is reported to that monitor with an event before the next
+ * queued message. Queued messages are sent in batches of up to
+ * CTRL_IFACE_MONITOR_BATCH messages from eloop.
+ */
+#define CTRL_IFACE_MONITOR_QUEUE_LEN 1000
+#define CTRL_IFACE_MONITOR_BATCH 32
+
+/* Maximum length of a "TAG=<tag> " command prefix including nul */
+#define CTRL_IFACE_TAG_MAX_LEN 32
 
 
 static void wpa_supplicant_ctrl_iface_send(struct wpa_supplicant *wpa_s,
@@ -101,9 +107,10 @@ static void wpas_ctrl_sock_debug(const char *title, int sock, const char *buf,
 
 static int wpa_supplicant_ctrl_iface_attach(struct dl_list *ctrl_dst,
 					    struct sockaddr_storage *from,
-					    socklen_t fromlen, int global)
+					    socklen_t fromlen, int global,
+					    const char *input)
 {
-	return ctrl_iface_attach(ctrl_dst, from, fromlen, NULL);
+	return ctrl_iface_attach(ctrl_dst, from, fromlen, input);
 }
 
 
@@ -126,6 +133,47 @@ static int wpa_supplicant_ctrl_iface_level(struct ctrl_iface_priv *priv,
 }
 
 
+/*
+ * A command can be prefixed with "TAG=<tag> " to allow a client to have
+ * multiple commands outstanding. The same prefix is added to the reply.
+ */
+static char * wpas_ctrl_iface_tag(char *buf, char *tag)
+{
+	char *end;
+
+	tag[0] = '\0';
+	if (!str_starts(buf, "TAG="))
+		return buf;
+	end = os_strchr(buf, ' ');
+	if (!end || end - buf + 2 > CTRL_IFACE_TAG_MAX_LEN)
+		return NULL;
+	os_memcpy(tag, buf, end - buf + 1);
+	tag[end - buf + 1] = '\0';
+	return end + 1;
+}
+
+
+static int wpas_ctrl_iface_reply(int sock, const char *tag,
+				 const char *reply, size_t reply_len,
+				 struct sockaddr_storage *from,
+				 socklen_t fromlen)
+{
+	struct msghdr msg;
+	struct iovec io[2];
+
+	io[0].iov_base = (char *) tag;
+	io[0].iov_len = os_strlen(tag);
+	io[1].iov_base = (char *) reply;
+	io[1].iov_len = reply_len;
+	os_memset(&msg, 0, sizeof(msg));
+	msg.msg_name = from;
+	msg.msg_namelen = fromlen;
+	msg.msg_iov = io;
+	msg.msg_iovlen = 2;
+	return sendmsg(sock, &msg, 0);
+}
+
+
 static void wpa_supplicant_ctrl_iface_receive(int sock, void *eloop_ctx,
 					      void *sock_ctx)
 {
@@ -138,6 +186,7 @@ static void wpa_supplicant_ctrl_iface_receive(int sock, void *eloop_ctx,
 	char *reply = NULL, *reply_buf = NULL;
 	size_t reply_len = 0;
 	int new_attached = 0;
+	char tag[CTRL_IFACE_TAG_MAX_LEN], *cmd;
 
 	buf = os_malloc(CTRL_IFACE_MAX_LEN + 1);
 	if (!buf)
@@ -156,32 +205,37 @@ static void wpa_supplicant_ctrl_iface_receive(int sock, void *eloop_ctx,
 		return;
 	}
 	buf[res] = '\0';
+	cmd = wpas_ctrl_iface_tag(buf, tag);
 
-	if (os_strcmp(buf, "ATTACH") == 0) {
+	if (!cmd) {
+		reply_len = 1;
+	} else if (os_strcmp(cmd, "ATTACH") == 0 ||
+		   os_strncmp(cmd, "ATTACH ", 7) == 0) {
 		if (wpa_supplicant_ctrl_iface_attach(&priv->ctrl_dst, &from,
-						     fromlen, 0))
+						     fromlen, 0,
+						     cmd[6] ? cmd + 7 : NULL))
 			reply_len = 1;
 		else {
 			new_attached = 1;
 			reply_len = 2;
 		}
-	} else if (os_strcmp(buf, "DETACH") == 0) {
+	} else if (os_strcmp(cmd, "DETACH") == 0) {
 		if (wpa_supplicant_ctrl_iface_detach(&priv->ctrl_dst, &from,
 						     fromlen))
 			reply_len = 1;
 		else
 			reply_len = 2;
-	} else if (os_strncmp(buf, "LEVEL ", 6) == 0) {
+	} else if (os_strncmp(cmd, "LEVEL ", 6) == 0) {
 		if (wpa_supplicant_ctrl_iface_level(priv, &from, fromlen,
-						    buf + 6))
+						    cmd + 6))
 			reply_len = 1;
 		else
 			reply_len = 2;
 	} else {
-		sockaddr_print(wpas_ctrl_cmd_debug_level(buf),
+		sockaddr_print(wpas_ctrl_cmd_debug_level(cmd),
 			       "Control interface recv command from:",
 			       &from, fromlen);
-		reply_buf = wpa_supplicant_ctrl_iface_process(wpa_s, buf,
+		reply_buf = wpa_supplicant_ctrl_iface_process(wpa_s, cmd,
 							      &reply_len);
 		reply = reply_buf;
 
@@ -204,8 +258,8 @@ static void wpa_supplicant_ctrl_iface_receive(int sock, void *eloop_ctx,
 	if (reply) {
 		wpas_ctrl_sock_debug("ctrl_sock-sendto", sock, reply,
 				     reply_len);
-		if (sendto(sock, reply, reply_len, 0, (struct sockaddr *) &from,
-			   fromlen) < 0) {
+		if (wpas_ctrl_iface_reply(sock, tag, reply, reply_len, &from,
+					  fromlen) < 0) {
 			int _errno = errno;
 			wpa_dbg(wpa_s, MSG_DEBUG,
 				"ctrl_iface sendto failed: %d - %s",
@@ -311,117 +365,194 @@ static int wpas_ctrl_iface_throttle(int sock)
 }
 
 
-static void wpas_ctrl_msg_send_pending_global(struct wpa_global *global)
+static void wpas_ctrl_dst_queue(struct wpa_ctrl_dst *dst,
+				const struct iovec *io, int iovcnt)
 {
-	struct ctrl_iface_global_priv *gpriv;
-	struct ctrl_iface_msg *msg;
-
-	gpriv = global->ctrl_iface;
-	while (gpriv && !dl_list_empty(&gpriv->msg_queue) &&
-	       !wpas_ctrl_iface_throttle(gpriv->sock)) {
-		msg = dl_list_first(&gpriv->msg_queue, struct ctrl_iface_msg,
-				    list);
-		if (!msg)
-			break;
-		dl_list_del(&msg->list);
-		wpa_supplicant_ctrl_iface_send(
-			msg->wpa_s,
-			msg->type != WPA_MSG_PER_INTERFACE ?
-			NULL : msg->wpa_s->ifname,
-			gpriv->sock, &gpriv->ctrl_dst, msg->level,
-			msg->txt, msg->len, NULL, gpriv);
-		os_free(msg);
+	struct wpa_ctrl_msg *msg;
+	size_t len = 0;
+	u8 *pos;
+	int i;
+
+	if (dst->num_pending >= CTRL_IFACE_MONITOR_QUEUE_LEN) {
+		msg = dl_list_first(&dst->pending, struct wpa_ctrl_msg, list);
+		if (msg) {
+			dl_list_del(&msg->list);
+			os_free(msg);
+			dst->num_pending--;
+		}
+		dst->dropped++;
+	}
+
+	for (i = 0; i < iovcnt; i++)
+		len += io[i].iov_len;
+	msg = os_malloc(sizeof(*msg) + len);
+	if (!msg) {
+		dst->dropped++;
+		return;
+	}
+	msg->len = len;
+	pos = (u8 *) (msg + 1);
+	for (i = 0; i < iovcnt; i++) {
+		os_memcpy(pos, io[i].iov_base, io[i].iov_len);
+		pos += io[i].iov_len;
 	}
+	dl_list_add_tail(&dst->pending, &msg->list);
+	dst->num_pending++;
 }
 
 
-static void wpas_ctrl_msg_send_pending_iface(struct wpa_supplicant *wpa_s)
+static int wpas_ctrl_dst_sendmmsg(int sock, struct wpa_ctrl_dst *dst,
+				  struct iovec *io, unsigned int num)
 {
-	struct ctrl_iface_priv *priv;
-	struct ctrl_iface_msg *msg;
+#ifdef __linux__
+	struct mmsghdr vec[CTRL_IFACE_MONITOR_BATCH];
+	unsigned int i;
+
+	os_memset(vec, 0, num * sizeof(vec[0]));
+	for (i = 0; i < num; i++) {
+		vec[i].msg_hdr.msg_name = &dst->addr;
+		vec[i].msg_hdr.msg_namelen = dst->addrlen;
+		vec[i].msg_hdr.msg_iov = &io[i];
+		vec[i].msg_hdr.msg_iovlen = 1;
+	}
+	return sendmmsg(sock, vec, num, MSG_DONTWAIT);
+#else /* __linux__ */
+	struct msghdr msg;
+	unsigned int i;
 
-	priv = wpa_s->ctrl_iface;
-	while (priv && !dl_list_empty(&priv->msg_queue) &&
-	       !wpas_ctrl_iface_throttle(priv->sock)) {
-		msg = dl_list_first(&priv->msg_queue, struct ctrl_iface_msg,
-				    list);
-		if (!msg)
-			break;
-		dl_list_del(&msg->list);
-		wpa_supplicant_ctrl_iface_send(wpa_s, NULL, priv->sock,
-					       &priv->ctrl_dst, msg->level,
-					       msg->txt, msg->len, priv, NULL);
-		os_free(msg);
+	os_memset(&msg, 0, sizeof(msg));
+	msg.msg_name = &dst->addr;
+	msg.msg_namelen = dst->addrlen;
+	msg.msg_iovlen = 1;
+	for (i = 0; i < num; i++) {
+		msg.msg_iov = &io[i];
+		if (sendmsg(sock, &msg, MSG_DONTWAIT) < 0)
+			return i ? (int) i : -1;
 	}
+	return num;
+#endif /* __linux__ */
 }
 
 
-static void wpas_ctrl_msg_queue_timeout(void *eloop_ctx, void *timeout_ctx)
+/* Returns 1 if messages are left pending, 0 if not, -1 if detached */
+static int wpas_ctrl_dst_send_pending(int sock, struct dl_list *ctrl_dst,
+				      struct wpa_ctrl_dst *dst)
 {
-	struct wpa_supplicant *wpa_s = eloop_ctx;
-	struct ctrl_iface_priv *priv;
-	struct ctrl_iface_global_priv *gpriv;
-	int sock = -1, gsock = -1;
+	struct iovec io[CTRL_IFACE_MONITOR_BATCH];
+	struct wpa_ctrl_msg *msg;
+	char dropped[100];
+	unsigned int num;
+	int res, report;
+
+	while (dst->num_pending || dst->dropped) {
+		if (wpas_ctrl_iface_throttle(sock))
+			return 1;
+
+		num = 0;
+		report = dst->dropped > 0;
+		if (report) {
+			res = os_snprintf(dropped, sizeof(dropped),
+					  "<%d>" WPA_EVENT_MONITOR_DROPPED
+					  "count=%u", MSG_WARNING,
+					  dst->dropped);
+			if (os_snprintf_error(sizeof(dropped), res))
+				return -1;
+			io[num].iov_base = dropped;
+			io[num].iov_len = res;
+			num++;
+		}
+		dl_list_for_each(msg, &dst->pending, struct wpa_ctrl_msg,
+				 list) {
+			if (num == CTRL_IFACE_MONITOR_BATCH)
+				break;
+			io[num].iov_base = msg + 1;
+			io[num].iov_len = msg->len;
+			num++;
+		}
 
-	wpas_ctrl_msg_send_pending_global(wpa_s->global);
-	wpas_ctrl_msg_send_pending_iface(wpa_s);
+		res = wpas_ctrl_dst_sendmmsg(sock, dst, io, num);
+		if (res < 0) {
+			int _errno = errno;
 
-	priv = wpa_s->ctrl_iface;
-	if (priv && !dl_list_empty(&priv->msg_queue))
-		sock = priv->sock;
+			if (_errno == EAGAIN || _errno == ENOBUFS)
+				return 1;
+			dst->errors++;
+			if (dst->errors > 10 || _errno == ENOENT ||
+			    _errno == EPERM) {
+				sockaddr_print(MSG_INFO, "CTRL_IFACE: Detach monitor that cannot receive messages:",
+					       &dst->addr, dst->addrlen);
+				wpa_supplicant_ctrl_iface_detach(ctrl_dst,
+								 &dst->addr,
+								 dst->addrlen);
+				return -1;
+			}
+			/* Drop the message that could not be sent */
+			res = 1;
+		} else {
+			dst->errors = 0;
+		}
 
-	gpriv = wpa_s->global->ctrl_iface;
-	if (gpriv && !dl_list_empty(&gpriv->msg_queue))
-		gsock = gpriv->sock;
-
-	if (sock > -1 || gsock > -1) {
-		/* Continue pending message transmission from a timeout */
-		wpa_printf(MSG_MSGDUMP,
-			   "CTRL: Had to throttle pending event message transmission for (sock %d gsock %d)",
-			   sock, gsock);
-		eloop_register_timeout(0, 20000, wpas_ctrl_msg_queue_timeout,
-				       wpa_s, NULL);
+		if (report && res > 0) {
+			dst->dropped = 0;
+			res--;
+			num--;
+		}
+		while (res-- > 0) {
+			msg = dl_list_first(&dst->pending, struct wpa_ctrl_msg,
+					    list);
+			if (!msg)
+				break;
+			dl_list_del(&msg->list);
+			os_free(msg);
+			dst->num_pending--;
+			num--;
+		}
+		if (num)
+			return 1;
 	}
+
+	return 0;
 }
 
 
-static void wpas_ctrl_msg_queue(struct dl_list *queue,
-				struct wpa_supplicant *wpa_s, int level,
-				enum wpa_msg_type type,
-				const char *txt, size_t len)
+static int wpas_ctrl_iface_send_pending(int sock, struct dl_list *ctrl_dst)
 {
-	struct ctrl_iface_msg *msg;
+	struct wpa_ctrl_dst *dst, *next;
+	int more = 0;
 
-	msg = os_zalloc(sizeof(*msg) + len);
-	if (!msg)
-		return;
+	if (sock < 0)
+		return 0;
 
-	msg->wpa_s = wpa_s;
-	msg->level = level;
-	msg->type = type;
-	os_memcpy(msg + 1, txt, len);
-	msg->txt = (const char *) (msg + 1);
-	msg->len = len;
-	dl_list_add_tail(queue, &msg->list);
-	eloop_cancel_timeout(wpas_ctrl_msg_queue_timeout, wpa_s, NULL);
-	eloop_register_timeout(0, 0, wpas_ctrl_msg_queue_timeout, wpa_s, NULL);
+	dl_list_for_each_safe(dst, next, ctrl_dst, struct wpa_ctrl_dst, list) {
+		if (wpas_ctrl_dst_send_pending(sock, ctrl_dst, dst) > 0)
+			more = 1;
+	}
+
+	return more;
 }
 
 
-static void wpas_ctrl_msg_queue_limit(unsigned int throttle_count,
-				      struct dl_list *queue)
+static void wpas_ctrl_iface_pending_timeout(void *eloop_ctx,
+					    void *timeout_ctx)
 {
-	struct ctrl_iface_msg *msg;
+	struct ctrl_iface_priv *priv = eloop_ctx;
 
-	if (throttle_count < 2000)
-		return;
+	if (wpas_ctrl_iface_send_pending(priv->sock, &priv->ctrl_dst))
+		eloop_register_timeout(0, 20000,
+				       wpas_ctrl_iface_pending_timeout,
+				       priv, NULL);
+}
 
-	msg = dl_list_first(queue, struct ctrl_iface_msg, list);
-	if (msg) {
-		wpa_printf(MSG_DEBUG, "CTRL: Dropped oldest pending message");
-		dl_list_del(&msg->list);
-		os_free(msg);
-	}
+
+static void wpas_ctrl_iface_global_pending_timeout(void *eloop_ctx,
+						   void *timeout_ctx)
+{
+	struct ctrl_iface_global_priv *gpriv = eloop_ctx;
+
+	if (wpas_ctrl_iface_send_pending(gpriv->sock, &gpriv->ctrl_dst))
+		eloop_register_timeout(0, 20000,
+				       wpas_ctrl_iface_global_pending_timeout,
+				       gpriv, NULL);
 }
 
 
@@ -438,63 +569,19 @@ static void wpa_supplicant_ctrl_iface_msg_cb(void *ctx, int level,
 
 	gpriv = wpa_s->global->ctrl_iface;
 
-	if (type != WPA_MSG_NO_GLOBAL && gpriv &&
-	    !dl_list_empty(&gpriv->ctrl_dst)) {
-		if (!dl_list_empty(&gpriv->msg_queue) ||
-		    wpas_ctrl_iface_throttle(gpriv->sock)) {
-			if (gpriv->throttle_count == 0) {
-				wpa_printf(MSG_MSGDUMP,
-					   "CTRL: Had to throttle global event message for sock %d",
-					   gpriv->sock);
-			}
-			gpriv->throttle_count++;
-			wpas_ctrl_msg_queue_limit(gpriv->throttle_count,
-						  &gpriv->msg_queue);
-			wpas_ctrl_msg_queue(&gpriv->msg_queue, wpa_s, level,
-					    type, txt, len);
-		} else {
-			if (gpriv->throttle_count) {
-				wpa_printf(MSG_MSGDUMP,
-					   "CTRL: Had to throttle %u global event message(s) for sock %d",
-					   gpriv->throttle_count, gpriv->sock);
-			}
-			gpriv->throttle_count = 0;
-			wpa_supplicant_ctrl_iface_send(
-				wpa_s,
-				type != WPA_MSG_PER_INTERFACE ?
-				NULL : wpa_s->ifname,
-				gpriv->sock, &gpriv->ctrl_dst, level,
-				txt, len, NULL, gpriv);
-		}
-	}
+	if (type != WPA_MSG_NO_GLOBAL && gpriv)
+		wpa_supplicant_ctrl_iface_send(
+			wpa_s,
+			type != WPA_MSG_PER_INTERFACE ? NULL : wpa_s->ifname,
+			gpriv->sock, &gpriv->ctrl_dst, level, txt, len, NULL,
+			gpriv);
 
 	priv = wpa_s->ctrl_iface;
 
-	if (type != WPA_MSG_ONLY_GLOBAL && priv) {
-		if (!dl_list_empty(&priv->msg_queue) ||
-		    wpas_ctrl_iface_throttle(priv->sock)) {
-			if (priv->throttle_count == 0) {
-				wpa_printf(MSG_MSGDUMP,
-					   "CTRL: Had to throttle event message for sock %d",
-					   priv->sock);
-			}
-			priv->throttle_count++;
-			wpas_ctrl_msg_queue_limit(priv->throttle_count,
-						  &priv->msg_queue);
-			wpas_ctrl_msg_queue(&priv->msg_queue, wpa_s, level,
-					    type, txt, len);
-		} else {
-			if (priv->throttle_count) {
-				wpa_printf(MSG_MSGDUMP,
-					   "CTRL: Had to throttle %u event message(s) for sock %d",
-					   priv->throttle_count, priv->sock);
-			}
-			priv->throttle_count = 0;
-			wpa_supplicant_ctrl_iface_send(wpa_s, NULL, priv->sock,
-						       &priv->ctrl_dst, level,
-						       txt, len, priv, NULL);
-		}
-	}
+	if (type != WPA_MSG_ONLY_GLOBAL && priv)
+		wpa_supplicant_ctrl_iface_send(wpa_s, NULL, priv->sock,
+					       &priv->ctrl_dst, level,
+					       txt, len, priv, NULL);
 }
 
 
@@ -712,7 +799,6 @@ wpa_supplicant_ctrl_iface_init(struct wpa_supplicant *wpa_s)
 	if (priv == NULL)
 		return NULL;
 	dl_list_init(&priv->ctrl_dst);
-	dl_list_init(&priv->msg_queue);
 	priv->wpa_s = wpa_s;
 	priv->sock = -1;
 
@@ -803,49 +889,15 @@ static int wpas_ctrl_iface_reinit(struct wpa_supplicant *wpa_s,
 }
 
 
-static void
-wpas_global_ctrl_iface_flush_queued_msg(struct wpa_global *global,
-					struct wpa_supplicant *wpa_s)
-{
-	struct ctrl_iface_global_priv *gpriv;
-	struct ctrl_iface_msg *msg, *prev_msg;
-	unsigned int count = 0;
-
-	if (!global || !global->ctrl_iface)
-		return;
-
-	gpriv = global->ctrl_iface;
-	dl_list_for_each_safe(msg, prev_msg, &gpriv->msg_queue,
-			      struct ctrl_iface_msg, list) {
-		if (msg->wpa_s == wpa_s) {
-			count++;
-			dl_list_del(&msg->list);
-			os_free(msg);
-		}
-	}
-
-	if (count) {
-		wpa_printf(MSG_DEBUG,
-			   "CTRL: Dropped %u pending message(s) for interface that is being removed",
-			count);
-	}
-}
-
-
 void wpa_supplicant_ctrl_iface_deinit(struct wpa_supplicant *wpa_s,
 				      struct ctrl_iface_priv *priv)
 {
 	struct wpa_ctrl_dst *dst, *prev;
-	struct ctrl_iface_msg *msg, *prev_msg;
-	struct ctrl_iface_global_priv *gpriv;
 
 	if (!priv) {
 		/* Control interface has not yet been initialized, so there is
-		 * nothing to deinitialize here. However, there might be a
-		 * pending message for this interface, so get rid of any such
-		 * entry before completing interface removal. */
-		wpas_global_ctrl_iface_flush_queued_msg(wpa_s->global, wpa_s);
-		eloop_cancel_timeout(wpas_ctrl_msg_queue_timeout, wpa_s, NULL);
+		 * nothing to deinitialize here. Messages queued for the global
+		 * control interface monitors do not refer to the interface. */
 		return;
 	}
 
@@ -903,25 +955,9 @@ free_dst:
 	dl_list_for_each_safe(dst, prev, &priv->ctrl_dst, struct wpa_ctrl_dst,
 			      list) {
 		dl_list_del(&dst->list);
-		os_free(dst);
-	}
-	dl_list_for_each_safe(msg, prev_msg, &priv->msg_queue,
-			      struct ctrl_iface_msg, list) {
-		dl_list_del(&msg->list);
-		os_free(msg);
-	}
-	gpriv = priv->wpa_s->global->ctrl_iface;
-	if (gpriv) {
-		dl_list_for_each_safe(msg, prev_msg, &gpriv->msg_queue,
-				      struct ctrl_iface_msg, list) {
-			if (msg->wpa_s == priv->wpa_s) {
-				dl_list_del(&msg->list);
-				os_free(msg);
-			}
-		}
+		ctrl_iface_free_dst(dst);
 	}
-	wpas_global_ctrl_iface_flush_queued_msg(wpa_s->global, wpa_s);
-	eloop_cancel_timeout(wpas_ctrl_msg_queue_timeout, priv->wpa_s, NULL);
+	eloop_cancel_timeout(wpas_ctrl_iface_pending_timeout, priv, NULL);
 	os_free(priv);
 }
 
@@ -947,7 +983,7 @@ static void wpa_supplicant_ctrl_iface_send(struct wpa_supplicant *wpa_s,
 {
 	struct wpa_ctrl_dst *dst, *next;
 	char levelstr[10];
-	int idx, res;
+	int idx, res, throttle = -1, queued = 0;
 	struct msghdr msg;
 	struct iovec io[5];
 
@@ -983,9 +1019,21 @@ static void wpa_supplicant_ctrl_iface_send(struct wpa_supplicant *wpa_s,
 		int _errno;
 		char txt[200];
 
-		if (level < dst->debug_level)
+		if (level < dst->debug_level ||
+		    !ctrl_iface_event_wanted(dst, buf, len))
 			continue;
 
+		/* Keep the order of the messages to a monitor that is not
+		 * keeping up and leave room in the socket send buffer for
+		 * command responses */
+		if (!dst->num_pending && throttle < 0)
+			throttle = wpas_ctrl_iface_throttle(sock);
+		if (dst->num_pending || throttle > 0) {
+			wpas_ctrl_dst_queue(dst, io, idx);
+			queued = 1;
+			continue;
+		}
+
 		msg.msg_name = (void *) &dst->addr;
 		msg.msg_namelen = dst->addrlen;
 		wpas_ctrl_sock_debug("ctrl_sock-sendmsg", sock, buf, len);
@@ -1001,16 +1049,11 @@ static void wpa_supplicant_ctrl_iface_send(struct wpa_supplicant *wpa_s,
 		os_snprintf(txt, sizeof(txt), "CTRL_IFACE monitor: %d (%s) for",
 			    _errno, strerror(_errno));
 		sockaddr_print(MSG_DEBUG, txt, &dst->addr, dst->addrlen);
-		dst->errors++;
-
-		if (dst->errors > 10 || _errno == ENOENT || _errno == EPERM) {
-			sockaddr_print(MSG_INFO, "CTRL_IFACE: Detach monitor that cannot receive messages:",
-				       &dst->addr, dst->addrlen);
-			wpa_supplicant_ctrl_iface_detach(ctrl_dst, &dst->addr,
-							 dst->addrlen);
-		}
 
 		if (_errno == ENOBUFS || _errno == EAGAIN) {
+			wpas_ctrl_dst_queue(dst, io, idx);
+			queued = 1;
+
 			/*
 			 * The socket send buffer could be full. This may happen
 			 * if client programs are not receiving their pending
@@ -1030,8 +1073,29 @@ static void wpa_supplicant_ctrl_iface_send(struct wpa_supplicant *wpa_s,
 					"Failed to reinitialize ctrl_iface socket");
 				break;
 			}
+			continue;
+		}
+
+		dst->errors++;
+		if (dst->errors > 10 || _errno == ENOENT || _errno == EPERM) {
+			sockaddr_print(MSG_INFO, "CTRL_IFACE: Detach monitor that cannot receive messages:",
+				       &dst->addr, dst->addrlen);
+			wpa_supplicant_ctrl_iface_detach(ctrl_dst, &dst->addr,
+							 dst->addrlen);
 		}
 	}
+
+	if (!queued)
+		return;
+	if (priv && !eloop_is_timeout_registered(
+		    wpas_ctrl_iface_pending_timeout, priv, NULL))
+		eloop_register_timeout(0, 0, wpas_ctrl_iface_pending_timeout,
+				       priv, NULL);
+	else if (gp && !eloop_is_timeout_registered(
+			 wpas_ctrl_iface_global_pending_timeout, gp, NULL))
+		eloop_register_timeout(0, 0,
+				       wpas_ctrl_iface_global_pending_timeout,
+				       gp, NULL);
 }
 
 
@@ -1063,7 +1127,7 @@ void wpa_supplicant_ctrl_iface_wait(struct ctrl_iface_priv *priv)
 			/* handle ATTACH signal of first monitor interface */
 			if (!wpa_supplicant_ctrl_iface_attach(&priv->ctrl_dst,
 							      &from, fromlen,
-							      0)) {
+							      0, NULL)) {
 				if (sendto(priv->sock, "OK\n", 3, 0,
 					   (struct sockaddr *) &from, fromlen) <
 				    0) {
@@ -1106,6 +1170,7 @@ static void wpa_supplicant_global_ctrl_iface_receive(int sock, void *eloop_ctx,
 	socklen_t fromlen = sizeof(from);
 	char *reply = NULL, *reply_buf = NULL;
 	size_t reply_len;
+	char tag[CTRL_IFACE_TAG_MAX_LEN], *cmd;
 
 	buf = os_malloc(CTRL_IFACE_MAX_LEN + 1);
 	if (!buf)
@@ -1124,14 +1189,19 @@ static void wpa_supplicant_global_ctrl_iface_receive(int sock, void *eloop_ctx,
 		return;
 	}
 	buf[res] = '\0';
+	cmd = wpas_ctrl_iface_tag(buf, tag);
 
-	if (os_strcmp(buf, "ATTACH") == 0) {
+	if (!cmd) {
+		reply_len = 1;
+	} else if (os_strcmp(cmd, "ATTACH") == 0 ||
+		   os_strncmp(cmd, "ATTACH ", 7) == 0) {
 		if (wpa_supplicant_ctrl_iface_attach(&priv->ctrl_dst, &from,
-						     fromlen, 1))
+						     fromlen, 1,
+						     cmd[6] ? cmd + 7 : NULL))
 			reply_len = 1;
 		else
 			reply_len = 2;
-	} else if (os_strcmp(buf, "DETACH") == 0) {
+	} else if (os_strcmp(cmd, "DETACH") == 0) {
 		if (wpa_supplicant_ctrl_iface_detach(&priv->ctrl_dst, &from,
 						     fromlen))
 			reply_len = 1;
@@ -1139,7 +1209,7 @@ static void wpa_supplicant_global_ctrl_iface_receive(int sock, void *eloop_ctx,
 			reply_len = 2;
 	} else {
 		reply_buf = wpa_supplicant_global_ctrl_iface_process(
-			global, buf, &reply_len);
+			global, cmd, &reply_len);
 		reply = reply_buf;
 
 		/*
@@ -1161,8 +1231,8 @@ static void wpa_supplicant_global_ctrl_iface_receive(int sock, void *eloop_ctx,
 	if (reply) {
 		wpas_ctrl_sock_debug("global_ctrl_sock-sendto",
 				     sock, reply, reply_len);
-		if (sendto(sock, reply, reply_len, 0, (struct sockaddr *) &from,
-			   fromlen) < 0) {
+		if (wpas_ctrl_iface_reply(sock, tag, reply, reply_len, &from,
+					  fromlen) < 0) {
 			wpa_printf(MSG_DEBUG, "ctrl_iface sendto failed: %s",
 				strerror(errno));
 		}
@@ -1362,7 +1432,6 @@ wpa_supplicant_global_ctrl_iface_init(struct wpa_global *global)
 	if (priv == NULL)
 		return NULL;
 	dl_list_init(&priv->ctrl_dst);
-	dl_list_init(&priv->msg_queue);
 	priv->global = global;
 	priv->sock = -1;
 
@@ -1412,7 +1481,6 @@ void
 wpa_supplicant_global_ctrl_iface_deinit(struct ctrl_iface_global_priv *priv)
 {
 	struct wpa_ctrl_dst *dst, *prev;
-	struct ctrl_iface_msg *msg, *prev_msg;
 
 	if (priv->sock >= 0) {
 		eloop_unregister_read_sock(priv->sock);
@@ -1423,12 +1491,9 @@ wpa_supplicant_global_ctrl_iface_deinit(struct ctrl_iface_global_priv *priv)
 	dl_list_for_each_safe(dst, prev, &priv->ctrl_dst, struct wpa_ctrl_dst,
 			      list) {
 		dl_list_del(&dst->list);
-		os_free(dst);
-	}
-	dl_list_for_each_safe(msg, prev_msg, &priv->msg_queue,
-			      struct ctrl_iface_msg, list) {
-		dl_list_del(&msg->list);
-		os_free(msg);
+		ctrl_iface_free_dst(dst);
 	}
+	eloop_cancel_timeout(wpas_ctrl_iface_global_pending_timeout, priv,
+			     NULL);
 	os_free(priv);
 }
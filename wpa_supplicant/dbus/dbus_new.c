@@ -205,6 +205,13 @@ void wpas_dbus_signal_scan_done(struct wpa_supplicant *wpa_s, int success)
 	if (iface == NULL || !wpa_s->dbus_new_path)
 		return;
 
+	/*
+	 * Send the coalesced BSS property changes from the scan results before
+	 * ScanDone so that the BSS objects are up to date when the clients
+	 * process ScanDone.
+	 */
+	wpa_dbus_flush_all_changed_properties(iface->con);
+
 	msg = dbus_message_new_signal(wpa_s->dbus_new_path,
 				      WPAS_DBUS_NEW_IFACE_INTERFACE,
 				      "ScanDone");
@@ -2598,6 +2605,10 @@ void wpas_dbus_bss_signal_prop_changed(struct wpa_supplicant *wpa_s,
 		    "%s/" WPAS_DBUS_NEW_BSSIDS_PART "/%u",
 		    wpa_s->dbus_new_path, id);
 
+	if (wpa_s->conf->dbus_lazy_bss &&
+	    !wpa_dbus_object_registered(wpa_s->global->dbus, path))
+		return; /* no client has accessed the object */
+
 	wpa_dbus_mark_property_changed(wpa_s->global->dbus, path,
 				       WPAS_DBUS_NEW_IFACE_BSS, prop);
 }
@@ -3173,6 +3184,12 @@ int wpas_dbus_unregister_bss(struct wpa_supplicant *wpa_s,
 		    "%s/" WPAS_DBUS_NEW_BSSIDS_PART "/%u",
 		    wpa_s->dbus_new_path, id);
 
+	if (!wpa_dbus_object_registered(ctrl_iface, bss_obj_path)) {
+		/* Object was never exported with dbus_lazy_bss=1 */
+		wpas_dbus_signal_prop_changed(wpa_s, WPAS_DBUS_PROP_BSSS);
+		return 0;
+	}
+
 	wpa_printf(MSG_DEBUG, "dbus: Unregister BSS object '%s'",
 		   bss_obj_path);
 	if (wpa_dbus_unregister_object_per_iface(ctrl_iface, bss_obj_path)) {
@@ -3188,34 +3205,12 @@ int wpas_dbus_unregister_bss(struct wpa_supplicant *wpa_s,
 }
 
 
-/**
- * wpas_dbus_register_bss - Register a scanned BSS with dbus
- * @wpa_s: wpa_supplicant interface structure
- * @bssid: scanned network bssid
- * @id: unique BSS identifier
- * Returns: 0 on success, -1 on failure
- *
- * Registers BSS representing object with dbus
- */
-int wpas_dbus_register_bss(struct wpa_supplicant *wpa_s,
-			   u8 bssid[ETH_ALEN], unsigned int id)
+static int wpas_dbus_register_bss_object(struct wpa_supplicant *wpa_s,
+					 unsigned int id, const char *path)
 {
-	struct wpas_dbus_priv *ctrl_iface;
 	struct wpa_dbus_object_desc *obj_desc;
-	char bss_obj_path[WPAS_DBUS_OBJECT_PATH_MAX];
 	struct bss_handler_args *arg;
 
-	/* Do nothing if the control interface is not turned on */
-	if (wpa_s == NULL || wpa_s->global == NULL || !wpa_s->dbus_new_path)
-		return 0;
-	ctrl_iface = wpa_s->global->dbus;
-	if (ctrl_iface == NULL)
-		return 0;
-
-	os_snprintf(bss_obj_path, WPAS_DBUS_OBJECT_PATH_MAX,
-		    "%s/" WPAS_DBUS_NEW_BSSIDS_PART "/%u",
-		    wpa_s->dbus_new_path, id);
-
 	obj_desc = os_zalloc(sizeof(struct wpa_dbus_object_desc));
 	if (!obj_desc) {
 		wpa_printf(MSG_ERROR,
@@ -3236,19 +3231,14 @@ int wpas_dbus_register_bss(struct wpa_supplicant *wpa_s,
 			   wpas_dbus_bss_properties,
 			   wpas_dbus_bss_signals);
 
-	wpa_printf(MSG_DEBUG, "dbus: Register BSS object '%s'",
-		   bss_obj_path);
-	if (wpa_dbus_register_object_per_iface(ctrl_iface, bss_obj_path,
+	wpa_printf(MSG_DEBUG, "dbus: Register BSS object '%s'", path);
+	if (wpa_dbus_register_object_per_iface(wpa_s->global->dbus, path,
 					       wpa_s->ifname, obj_desc)) {
 		wpa_printf(MSG_ERROR,
-			   "Cannot register BSSID dbus object %s.",
-			   bss_obj_path);
+			   "Cannot register BSSID dbus object %s.", path);
 		goto err;
 	}
 
-	wpas_dbus_signal_bss_added(wpa_s, bss_obj_path);
-	wpas_dbus_signal_prop_changed(wpa_s, WPAS_DBUS_PROP_BSSS);
-
 	return 0;
 
 err:
@@ -3257,6 +3247,118 @@ err:
 }
 
 
+/**
+ * wpas_dbus_register_bss - Register a scanned BSS with dbus
+ * @wpa_s: wpa_supplicant interface structure
+ * @bssid: scanned network bssid
+ * @id: unique BSS identifier
+ * Returns: 0 on success, -1 on failure
+ *
+ * Registers BSS representing object with dbus. With dbus_lazy_bss=1, the
+ * object is registered only once it is accessed or requested with GetBSSs.
+ */
+int wpas_dbus_register_bss(struct wpa_supplicant *wpa_s,
+			   u8 bssid[ETH_ALEN], unsigned int id)
+{
+	char bss_obj_path[WPAS_DBUS_OBJECT_PATH_MAX];
+
+	/* Do nothing if the control interface is not turned on */
+	if (wpa_s == NULL || wpa_s->global == NULL || !wpa_s->dbus_new_path ||
+	    !wpa_s->global->dbus)
+		return 0;
+
+	if (wpa_s->conf->dbus_lazy_bss) {
+		wpas_dbus_signal_prop_changed(wpa_s, WPAS_DBUS_PROP_BSSS);
+		return 0;
+	}
+
+	os_snprintf(bss_obj_path, WPAS_DBUS_OBJECT_PATH_MAX,
+		    "%s/" WPAS_DBUS_NEW_BSSIDS_PART "/%u",
+		    wpa_s->dbus_new_path, id);
+
+	if (wpas_dbus_register_bss_object(wpa_s, id, bss_obj_path))
+		return -1;
+
+	wpas_dbus_signal_bss_added(wpa_s, bss_obj_path);
+	wpas_dbus_signal_prop_changed(wpa_s, WPAS_DBUS_PROP_BSSS);
+
+	return 0;
+}
+
+
+/**
+ * wpas_dbus_export_bss - Make sure a BSS object is registered
+ * @wpa_s: wpa_supplicant interface structure
+ * @id: unique BSS identifier
+ * Returns: 0 on success, -1 on failure
+ *
+ * Registers the BSS object if that was postponed with dbus_lazy_bss=1.
+ */
+int wpas_dbus_export_bss(struct wpa_supplicant *wpa_s, unsigned int id)
+{
+	char bss_obj_path[WPAS_DBUS_OBJECT_PATH_MAX];
+
+	if (!wpa_s->dbus_new_path || !wpa_s->global->dbus)
+		return -1;
+
+	os_snprintf(bss_obj_path, WPAS_DBUS_OBJECT_PATH_MAX,
+		    "%s/" WPAS_DBUS_NEW_BSSIDS_PART "/%u",
+		    wpa_s->dbus_new_path, id);
+	if (wpa_dbus_object_registered(wpa_s->global->dbus, bss_obj_path))
+		return 0;
+
+	return wpas_dbus_register_bss_object(wpa_s, id, bss_obj_path);
+}
+
+
+/* Register the object of a BSS on the first access with dbus_lazy_bss=1 */
+static int wpas_dbus_create_bss(void *ctx, const char *path)
+{
+	struct wpa_supplicant *wpa_s = ctx;
+	char bss_obj_path[WPAS_DBUS_OBJECT_PATH_MAX];
+	const char *pos;
+	unsigned long id;
+	char *end;
+	size_t len;
+
+	if (!wpa_s->dbus_new_path)
+		return -1;
+	len = os_snprintf(bss_obj_path, WPAS_DBUS_OBJECT_PATH_MAX,
+			  "%s/" WPAS_DBUS_NEW_BSSIDS_PART "/",
+			  wpa_s->dbus_new_path);
+	if (os_strncmp(path, bss_obj_path, len) != 0)
+		return -1;
+	pos = path + len;
+	id = strtoul(pos, &end, 10);
+	if (end == pos || *end || (*pos == '0' && end != pos + 1) ||
+	    !wpa_bss_get_id(wpa_s, id))
+		return -1;
+
+	return wpas_dbus_export_bss(wpa_s, id);
+}
+
+
+/**
+ * wpas_dbus_bss_put_properties - Put all BSS properties into a dictionary
+ * @dict_iter: DBus message iter of the dictionary
+ * @wpa_s: wpa_supplicant interface structure
+ * @id: unique BSS identifier
+ * @error: Location to store error on failure
+ * Returns: TRUE on success, FALSE on failure
+ */
+dbus_bool_t wpas_dbus_bss_put_properties(DBusMessageIter *dict_iter,
+					 struct wpa_supplicant *wpa_s,
+					 unsigned int id, DBusError *error)
+{
+	struct bss_handler_args arg;
+
+	arg.wpa_s = wpa_s;
+	arg.id = id;
+	return wpa_dbus_put_properties(dict_iter, wpas_dbus_bss_properties,
+				       WPAS_DBUS_NEW_IFACE_BSS, &arg, error);
+}
+
+
 static const struct wpa_dbus_property_desc wpas_dbus_sta_properties[] = {
 	{ "Address", WPAS_DBUS_NEW_IFACE_STA, "ay",
 	  wpas_dbus_getter_sta_address,
@@ -3724,6 +3826,20 @@ static const struct wpa_dbus_method_desc wpas_dbus_interface_methods[] = {
 		  END_ARGS
 	  }
 	},
+	{ "GetBSSs", WPAS_DBUS_NEW_IFACE_INTERFACE,
+	  (WPADBusMethodHandler) wpas_dbus_handler_get_bsss,
+	  {
+		  { "paths", "ao", ARG_OUT },
+		  END_ARGS
+	  }
+	},
+	{ "GetScanResults", WPAS_DBUS_NEW_IFACE_INTERFACE,
+	  (WPADBusMethodHandler) wpas_dbus_handler_get_scan_results,
+	  {
+		  { "bsss", "aa{sv}", ARG_OUT },
+		  END_ARGS
+	  }
+	},
 #ifdef CONFIG_AP
 	{ "SubscribeProbeReq", WPAS_DBUS_NEW_IFACE_INTERFACE,
 	  (WPADBusMethodHandler) wpas_dbus_handler_subscribe_preq,
@@ -4589,6 +4705,7 @@ int wpas_dbus_register_interface(struct wpa_supplicant *wpa_s)
 {
 	struct wpa_dbus_object_desc *obj_desc = NULL;
 	struct wpas_dbus_priv *ctrl_iface = wpa_s->global->dbus;
+	char bss_path[WPAS_DBUS_OBJECT_PATH_MAX];
 	int next;
 
 	/* Do nothing if the control interface is not turned on */
@@ -4622,6 +4739,14 @@ int wpas_dbus_register_interface(struct wpa_supplicant *wpa_s)
 					       wpa_s->ifname, obj_desc))
 		goto err;
 
+	os_snprintf(bss_path, WPAS_DBUS_OBJECT_PATH_MAX,
+		    "%s/" WPAS_DBUS_NEW_BSSIDS_PART, wpa_s->dbus_new_path);
+	if (wpa_dbus_register_fallback_per_iface(ctrl_iface, bss_path,
+						 wpas_dbus_create_bss, wpa_s))
+		wpa_printf(MSG_INFO,
+			   "dbus: BSS objects are not created on demand for %s",
+			   wpa_s->ifname);
+
 	wpas_dbus_signal_interface_added(wpa_s);
 
 	return 0;
@@ -4642,6 +4767,7 @@ err:
 int wpas_dbus_unregister_interface(struct wpa_supplicant *wpa_s)
 {
 	struct wpas_dbus_priv *ctrl_iface;
+	char bss_path[WPAS_DBUS_OBJECT_PATH_MAX];
 
 	/* Do nothing if the control interface is not turned on */
 	if (wpa_s == NULL || wpa_s->global == NULL)
@@ -4661,6 +4787,10 @@ int wpas_dbus_unregister_interface(struct wpa_supplicant *wpa_s)
 	}
 #endif /* CONFIG_AP */
 
+	os_snprintf(bss_path, WPAS_DBUS_OBJECT_PATH_MAX,
+		    "%s/" WPAS_DBUS_NEW_BSSIDS_PART, wpa_s->dbus_new_path);
+	wpa_dbus_unregister_fallback_per_iface(ctrl_iface, bss_path);
+
 	if (wpa_dbus_unregister_object_per_iface(ctrl_iface,
 						 wpa_s->dbus_new_path))
 		return -1;
@@ -17,12 +17,12 @@
 #include "rsn_supp/wpa.h"
 #include "ap/hostapd.h"
 #include "ap/sta_info.h"
-#include "ap/ap_drv_ops.h"
 #include "../config.h"
 #include "../wpa_supplicant_i.h"
 #include "../driver_i.h"
 #include "../notify.h"
 #include "../bss.h"
+#include "../sme.h"
 #include "../scan.h"
 #include "../autoscan.h"
 #include "../ap.h"
@@ -298,8 +298,10 @@ dbus_bool_t set_network_properties(struct wpa_supplicant *wpa_s,
 #endif /* CONFIG_BGSCAN */
 
 		if (os_strcmp(entry.key, "bssid") != 0 &&
-		    os_strcmp(entry.key, "priority") != 0)
+		    os_strcmp(entry.key, "priority") != 0) {
 			wpa_sm_pmksa_cache_flush(wpa_s->wpa, ssid);
+			sme_sae_precomp_flush(wpa_s);
+		}
 
 		if (wpa_s->current_ssid == ssid ||
 		    wpa_s->current_ssid == NULL) {
@@ -2735,6 +2737,120 @@ DBusMessage * wpas_dbus_handler_flush_bss(DBusMessage *message,
 }
 
 
+/*
+ * wpas_dbus_handler_get_bsss - Register and return all BSS objects
+ * @message: Pointer to incoming dbus message
+ * @wpa_s: wpa_supplicant structure for a network interface
+ * Returns: A dbus message containing the object paths of all BSSs
+ *
+ * Handler function for "GetBSSs" method call of network interface. With
+ * dbus_lazy_bss=1, the BSS objects are registered only when requested with
+ * this method or when a BSS object is accessed for the first time.
+ */
+DBusMessage * wpas_dbus_handler_get_bsss(DBusMessage *message,
+					 struct wpa_supplicant *wpa_s)
+{
+	DBusMessage *reply;
+	DBusMessageIter iter, array_iter;
+	char path[WPAS_DBUS_OBJECT_PATH_MAX], *pos = path;
+	struct wpa_bss *bss;
+
+	reply = dbus_message_new_method_return(message);
+	if (!reply)
+		return wpas_dbus_error_no_memory(message);
+
+	dbus_message_iter_init_append(reply, &iter);
+	if (!dbus_message_iter_open_container(&iter, DBUS_TYPE_ARRAY,
+					      DBUS_TYPE_OBJECT_PATH_AS_STRING,
+					      &array_iter))
+		goto nomem;
+
+	dl_list_for_each(bss, &wpa_s->bss_id, struct wpa_bss, list_id) {
+		if (wpas_dbus_export_bss(wpa_s, bss->id) < 0)
+			continue;
+		os_snprintf(path, WPAS_DBUS_OBJECT_PATH_MAX,
+			    "%s/" WPAS_DBUS_NEW_BSSIDS_PART "/%u",
+			    wpa_s->dbus_new_path, bss->id);
+		if (!dbus_message_iter_append_basic(&array_iter,
+						    DBUS_TYPE_OBJECT_PATH,
+						    &pos))
+			goto nomem;
+	}
+
+	if (!dbus_message_iter_close_container(&iter, &array_iter))
+		goto nomem;
+
+	return reply;
+
+nomem:
+	dbus_message_unref(reply);
+	return wpas_dbus_error_no_memory(message);
+}
+
+
+/*
+ * wpas_dbus_handler_get_scan_results - Return all BSSs in one message
+ * @message: Pointer to incoming dbus message
+ * @wpa_s: wpa_supplicant structure for a network interface
+ * Returns: A dbus message containing the properties of all BSSs
+ *
+ * Handler function for "GetScanResults" method call of network interface.
+ * Each entry contains the object path of the BSS as "Path" and the properties
+ * of the BSS object. The BSS objects themselves are not registered, so this
+ * can be used without exporting the objects with dbus_lazy_bss=1.
+ */
+DBusMessage * wpas_dbus_handler_get_scan_results(DBusMessage *message,
+						 struct wpa_supplicant *wpa_s)
+{
+	DBusMessage *reply;
+	DBusMessageIter iter, array_iter, dict_iter;
+	char path[WPAS_DBUS_OBJECT_PATH_MAX];
+	struct wpa_bss *bss;
+	DBusError error;
+
+	reply = dbus_message_new_method_return(message);
+	if (!reply)
+		return wpas_dbus_error_no_memory(message);
+
+	dbus_message_iter_init_append(reply, &iter);
+	if (!dbus_message_iter_open_container(&iter, DBUS_TYPE_ARRAY, "a{sv}",
+					      &array_iter))
+		goto nomem;
+
+	dbus_error_init(&error);
+	dl_list_for_each(bss, &wpa_s->bss_id, struct wpa_bss, list_id) {
+		os_snprintf(path, WPAS_DBUS_OBJECT_PATH_MAX,
+			    "%s/" WPAS_DBUS_NEW_BSSIDS_PART "/%u",
+			    wpa_s->dbus_new_path, bss->id);
+		if (!wpa_dbus_dict_open_write(&array_iter, &dict_iter) ||
+		    !wpa_dbus_dict_append_object_path(&dict_iter, "Path",
+						      path) ||
+		    !wpas_dbus_bss_put_properties(&dict_iter, wpa_s, bss->id,
+						  &error) ||
+		    !wpa_dbus_dict_close_write(&array_iter, &dict_iter)) {
+			dbus_message_unref(reply);
+			if (dbus_error_is_set(&error)) {
+				reply = wpas_dbus_reply_new_from_error(
+					message, &error, DBUS_ERROR_FAILED,
+					"Failed to read BSS properties");
+				dbus_error_free(&error);
+				return reply;
+			}
+			return wpas_dbus_error_no_memory(message);
+		}
+	}
+
+	if (!dbus_message_iter_close_container(&iter, &array_iter))
+		goto nomem;
+
+	return reply;
+
+nomem:
+	dbus_message_unref(reply);
+	return wpas_dbus_error_no_memory(message);
+}
+
+
 #ifdef CONFIG_AUTOSCAN
 /**
  * wpas_dbus_handler_autoscan - Set autoscan parameters for the interface
@@ -5056,7 +5172,8 @@ dbus_bool_t wpas_dbus_getter_sta_rx_packets(
 	if (!sta)
 		return FALSE;
 
-	if (hostapd_drv_read_sta_data(hapd, &data, sta->addr) < 0)
+	if (ap_sta_read_drv_data(hapd, sta, &data, AP_STA_DRV_DATA_ANY_AGE,
+				 NULL) < 0)
 		return FALSE;
 
 	return wpas_dbus_simple_property_getter(iter, DBUS_TYPE_UINT64,
@@ -5095,7 +5212,8 @@ dbus_bool_t wpas_dbus_getter_sta_tx_packets(
 	if (!sta)
 		return FALSE;
 
-	if (hostapd_drv_read_sta_data(hapd, &data, sta->addr) < 0)
+	if (ap_sta_read_drv_data(hapd, sta, &data, AP_STA_DRV_DATA_ANY_AGE,
+				 NULL) < 0)
 		return FALSE;
 
 	return wpas_dbus_simple_property_getter(iter, DBUS_TYPE_UINT64,
@@ -5134,7 +5252,8 @@ dbus_bool_t wpas_dbus_getter_sta_tx_bytes(
 	if (!sta)
 		return FALSE;
 
-	if (hostapd_drv_read_sta_data(hapd, &data, sta->addr) < 0)
+	if (ap_sta_read_drv_data(hapd, sta, &data, AP_STA_DRV_DATA_ANY_AGE,
+				 NULL) < 0)
 		return FALSE;
 
 	return wpas_dbus_simple_property_getter(iter, DBUS_TYPE_UINT64,
@@ -5173,7 +5292,8 @@ dbus_bool_t wpas_dbus_getter_sta_rx_bytes(
 	if (!sta)
 		return FALSE;
 
-	if (hostapd_drv_read_sta_data(hapd, &data, sta->addr) < 0)
+	if (ap_sta_read_drv_data(hapd, sta, &data, AP_STA_DRV_DATA_ANY_AGE,
+				 NULL) < 0)
 		return FALSE;
 
 	return wpas_dbus_simple_property_getter(iter, DBUS_TYPE_UINT64,
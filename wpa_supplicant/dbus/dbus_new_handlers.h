@@ -27,6 +27,11 @@ struct sta_handler_args {
 	const u8 *sta;
 };
 
+int wpas_dbus_export_bss(struct wpa_supplicant *wpa_s, unsigned int id);
+dbus_bool_t wpas_dbus_bss_put_properties(DBusMessageIter *dict_iter,
+					 struct wpa_supplicant *wpa_s,
+					 unsigned int id, DBusError *error);
+
 dbus_bool_t wpas_dbus_simple_property_getter(DBusMessageIter *iter,
 					     const int type,
 					     const void *val,
@@ -135,6 +140,12 @@ DBusMessage * wpas_dbus_handler_set_pkcs11_engine_and_module_path(
 DBusMessage * wpas_dbus_handler_flush_bss(DBusMessage *message,
 					  struct wpa_supplicant *wpa_s);
 
+DBusMessage * wpas_dbus_handler_get_bsss(DBusMessage *message,
+					 struct wpa_supplicant *wpa_s);
+
+DBusMessage * wpas_dbus_handler_get_scan_results(DBusMessage *message,
+						 struct wpa_supplicant *wpa_s);
+
 DBusMessage * wpas_dbus_handler_autoscan(DBusMessage *message,
 					 struct wpa_supplicant *wpa_s);
 
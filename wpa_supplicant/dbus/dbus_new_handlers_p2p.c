@@ -158,6 +158,8 @@ DBusMessage * wpas_dbus_handler_p2p_find(DBusMessage *message,
 				type = P2P_FIND_ONLY_SOCIAL;
 			else if (os_strcmp(entry.str_value, "progressive") == 0)
 				type = P2P_FIND_PROGRESSIVE;
+			else if (os_strcmp(entry.str_value, "fast") == 0)
+				type = P2P_FIND_FAST;
 			else
 				goto error_clear;
 		} else if (os_strcmp(entry.key, "freq") == 0 &&
@@ -20,6 +20,16 @@
 #include "dbus_dict_helpers.h"
 
 
+/*
+ * Objects with properties marked as changed. The PropertiesChanged signals for
+ * all of them are sent from a single timeout, so the changes done within one
+ * eloop iteration, e.g., for all BSSs while processing scan results, result in
+ * one signal per object.
+ */
+static struct dl_list prop_changed_objects =
+	DL_LIST_HEAD_INIT(prop_changed_objects);
+
+
 static dbus_bool_t fill_dict_with_properties(
 	DBusMessageIter *dict_iter,
 	const struct wpa_dbus_property_desc *props,
@@ -444,6 +454,8 @@ void free_dbus_object_desc(struct wpa_dbus_object_desc *obj_dsc)
 	if (obj_dsc->user_data_free_func)
 		obj_dsc->user_data_free_func(obj_dsc->user_data);
 
+	if (obj_dsc->prop_changed)
+		dl_list_del(&obj_dsc->prop_changed_list);
 	os_free(obj_dsc->path);
 	os_free(obj_dsc->prop_changed_flags);
 	os_free(obj_dsc);
@@ -567,7 +579,160 @@ int wpa_dbus_register_object_per_iface(struct wpas_dbus_priv *ctrl_iface,
 }
 
 
-static void flush_object_timeout_handler(void *eloop_ctx, void *timeout_ctx);
+struct wpa_dbus_fallback {
+	WPADBusObjectCreateFunction create;
+	void *ctx;
+};
+
+
+static DBusHandlerResult fallback_message_handler(DBusConnection *connection,
+						  DBusMessage *message,
+						  void *user_data)
+{
+	struct wpa_dbus_fallback *fallback = user_data;
+	struct wpa_dbus_object_desc *obj_desc = NULL;
+	const char *path;
+
+	path = dbus_message_get_path(message);
+	if (!path || fallback->create(fallback->ctx, path) < 0)
+		return DBUS_HANDLER_RESULT_NOT_YET_HANDLED;
+
+	dbus_connection_get_object_path_data(connection, path,
+					     (void **) &obj_desc);
+	if (!obj_desc)
+		return DBUS_HANDLER_RESULT_NOT_YET_HANDLED;
+
+	return message_handler(connection, message, obj_desc);
+}
+
+
+static void free_fallback_cb(DBusConnection *connection, void *user_data)
+{
+	os_free(user_data);
+}
+
+
+/**
+ * wpa_dbus_register_fallback_per_iface - Register on-demand object creation
+ * @ctrl_iface: pointer to dbus private data
+ * @path: DBus path below which the objects are created
+ * @create: Function for registering the object for a path below @path;
+ *	returns 0 if the object was registered or -1 if there is no such object
+ * @ctx: Context data for @create
+ * Returns: 0 on success, -1 on failure
+ *
+ * Messages to paths below @path that do not have a registered object are
+ * passed to the object registered by @create on first access.
+ */
+int wpa_dbus_register_fallback_per_iface(struct wpas_dbus_priv *ctrl_iface,
+					 const char *path,
+					 WPADBusObjectCreateFunction create,
+					 void *ctx)
+{
+	struct wpa_dbus_fallback *fallback;
+	DBusObjectPathVTable vtable = {
+		&free_fallback_cb, &fallback_message_handler,
+		NULL, NULL, NULL, NULL
+	};
+
+	/* Do nothing if the control interface is not turned on */
+	if (ctrl_iface == NULL)
+		return 0;
+
+	fallback = os_zalloc(sizeof(*fallback));
+	if (!fallback)
+		return -1;
+	fallback->create = create;
+	fallback->ctx = ctx;
+
+	if (!dbus_connection_register_fallback(ctrl_iface->con, path, &vtable,
+					       fallback)) {
+		wpa_printf(MSG_ERROR,
+			   "dbus: Could not set up fallback handler for %s",
+			   path);
+		os_free(fallback);
+		return -1;
+	}
+
+	return 0;
+}
+
+
+/**
+ * wpa_dbus_unregister_fallback_per_iface - Unregister on-demand object creation
+ * @ctrl_iface: pointer to dbus private data
+ * @path: DBus path used with wpa_dbus_register_fallback_per_iface()
+ */
+void wpa_dbus_unregister_fallback_per_iface(struct wpas_dbus_priv *ctrl_iface,
+					    const char *path)
+{
+	void *fallback = NULL;
+
+	if (ctrl_iface == NULL)
+		return;
+
+	dbus_connection_get_object_path_data(ctrl_iface->con, path, &fallback);
+	if (fallback)
+		dbus_connection_unregister_object_path(ctrl_iface->con, path);
+}
+
+
+/**
+ * wpa_dbus_object_registered - Check whether an object is registered
+ * @ctrl_iface: pointer to dbus private data
+ * @path: DBus path to the object
+ * Returns: 1 if an object is registered for @path, 0 if not
+ */
+int wpa_dbus_object_registered(struct wpas_dbus_priv *ctrl_iface,
+			       const char *path)
+{
+	void *obj_desc = NULL;
+
+	if (ctrl_iface == NULL)
+		return 0;
+
+	dbus_connection_get_object_path_data(ctrl_iface->con, path, &obj_desc);
+	return obj_desc != NULL;
+}
+
+
+/**
+ * wpa_dbus_put_properties - Put properties of an object into a dictionary
+ * @dict_iter: DBus message iter of the dictionary
+ * @props: Property descriptions of the object
+ * @interface: Interface of the properties
+ * @user_data: Object specific data for the property getters
+ * @error: Location to store error on failure
+ * Returns: TRUE on success, FALSE on failure
+ *
+ * This can be used for objects that do not need to be registered, e.g., for
+ * returning the properties of many objects in one message.
+ */
+dbus_bool_t wpa_dbus_put_properties(DBusMessageIter *dict_iter,
+				    const struct wpa_dbus_property_desc *props,
+				    const char *interface, void *user_data,
+				    DBusError *error)
+{
+	return fill_dict_with_properties(dict_iter, props, interface,
+					 user_data, error);
+}
+
+
+static void flush_changed_properties_timeout(void *eloop_ctx,
+					    void *timeout_ctx);
+
+
+static void clear_object_changed(DBusConnection *con,
+				 struct wpa_dbus_object_desc *obj_desc)
+{
+	if (!obj_desc->prop_changed)
+		return;
+	dl_list_del(&obj_desc->prop_changed_list);
+	obj_desc->prop_changed = false;
+	if (dl_list_empty(&prop_changed_objects))
+		eloop_cancel_timeout(flush_changed_properties_timeout, con,
+				     NULL);
+}
 
 
 /**
@@ -592,7 +757,7 @@ int wpa_dbus_unregister_object_per_iface(
 		return 0;
 	}
 
-	eloop_cancel_timeout(flush_object_timeout_handler, con, obj_desc);
+	clear_object_changed(con, obj_desc);
 
 	if (!dbus_connection_unregister_object_path(con, path))
 		return -1;
@@ -752,38 +917,35 @@ static void send_prop_changed_signal(
 }
 
 
-static void flush_object_timeout_handler(void *eloop_ctx, void *timeout_ctx)
+static void flush_object_desc(DBusConnection *con,
+			      struct wpa_dbus_object_desc *obj_desc)
 {
-	DBusConnection *con = eloop_ctx;
-	struct wpa_dbus_object_desc *obj_desc = timeout_ctx;
+	const struct wpa_dbus_property_desc *dsc;
+	int i;
 
-	wpa_printf(MSG_MSGDUMP,
-		   "dbus: %s: Timeout - sending changed properties of object %s",
-		   __func__, obj_desc->path);
-	wpa_dbus_flush_object_changed_properties(con, obj_desc->path);
+	if (!obj_desc->prop_changed)
+		return;
+	clear_object_changed(con, obj_desc);
+
+	for (dsc = obj_desc->properties, i = 0; dsc && dsc->dbus_property;
+	     dsc++, i++) {
+		if (obj_desc->prop_changed_flags == NULL ||
+		    !obj_desc->prop_changed_flags[i])
+			continue;
+		send_prop_changed_signal(con, obj_desc->path,
+					 dsc->dbus_interface, obj_desc);
+	}
 }
 
 
-static void recursive_flush_changed_properties(DBusConnection *con,
-					       const char *path)
+static void flush_changed_properties_timeout(void *eloop_ctx,
+					    void *timeout_ctx)
 {
-	char **objects = NULL;
-	char subobj_path[WPAS_DBUS_OBJECT_PATH_MAX];
-	int i;
-
-	wpa_dbus_flush_object_changed_properties(con, path);
-
-	if (!dbus_connection_list_registered(con, path, &objects))
-		goto out;
-
-	for (i = 0; objects[i]; i++) {
-		os_snprintf(subobj_path, WPAS_DBUS_OBJECT_PATH_MAX,
-			    "%s/%s", path, objects[i]);
-		recursive_flush_changed_properties(con, subobj_path);
-	}
+	DBusConnection *con = eloop_ctx;
 
-out:
-	dbus_free_string_array(objects);
+	wpa_printf(MSG_MSGDUMP,
+		   "dbus: %s: Timeout - sending changed properties", __func__);
+	wpa_dbus_flush_all_changed_properties(con);
 }
 
 
@@ -791,12 +953,17 @@ out:
  * wpa_dbus_flush_all_changed_properties - Send all PropertiesChanged signals
  * @con: DBus connection
  *
- * Traverses through all registered objects and sends PropertiesChanged for
- * each properties.
+ * Sends PropertiesChanged for each object that has properties marked as
+ * changed.
  */
 void wpa_dbus_flush_all_changed_properties(DBusConnection *con)
 {
-	recursive_flush_changed_properties(con, WPAS_DBUS_NEW_PATH);
+	struct wpa_dbus_object_desc *obj_desc;
+
+	while ((obj_desc = dl_list_first(&prop_changed_objects,
+					 struct wpa_dbus_object_desc,
+					 prop_changed_list)))
+		flush_object_desc(con, obj_desc);
 }
 
 
@@ -821,22 +988,11 @@ void wpa_dbus_flush_object_changed_properties(DBusConnection *con,
 					      const char *path)
 {
 	struct wpa_dbus_object_desc *obj_desc = NULL;
-	const struct wpa_dbus_property_desc *dsc;
-	int i;
 
 	dbus_connection_get_object_path_data(con, path, (void **) &obj_desc);
 	if (!obj_desc)
 		return;
-	eloop_cancel_timeout(flush_object_timeout_handler, con, obj_desc);
-
-	for (dsc = obj_desc->properties, i = 0; dsc && dsc->dbus_property;
-	     dsc++, i++) {
-		if (obj_desc->prop_changed_flags == NULL ||
-		    !obj_desc->prop_changed_flags[i])
-			continue;
-		send_prop_changed_signal(con, path, dsc->dbus_interface,
-					 obj_desc);
-	}
+	flush_object_desc(con, obj_desc);
 }
 
 
@@ -891,12 +1047,14 @@ void wpa_dbus_mark_property_changed(struct wpas_dbus_priv *iface,
 		return;
 	}
 
-	if (!eloop_is_timeout_registered(flush_object_timeout_handler,
-					 iface->con, obj_desc)) {
+	if (obj_desc->prop_changed)
+		return;
+	if (dl_list_empty(&prop_changed_objects))
 		eloop_register_timeout(0, WPA_DBUS_SEND_PROP_CHANGED_TIMEOUT,
-				       flush_object_timeout_handler,
-				       iface->con, obj_desc);
-	}
+				       flush_changed_properties_timeout,
+				       iface->con, NULL);
+	dl_list_add_tail(&prop_changed_objects, &obj_desc->prop_changed_list);
+	obj_desc->prop_changed = true;
 }
 
 
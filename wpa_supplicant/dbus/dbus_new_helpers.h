@@ -11,12 +11,14 @@
 #define WPA_DBUS_CTRL_H
 
 #include <dbus/dbus.h>
+#include "utils/list.h"
 
 struct wpa_signal_info;
 
 typedef DBusMessage * (*WPADBusMethodHandler)(DBusMessage *message,
 					      void *user_data);
 typedef void (*WPADBusArgumentFreeFunction)(void *handler_arg);
+typedef int (*WPADBusObjectCreateFunction)(void *ctx, const char *path);
 
 struct wpa_dbus_property_desc;
 typedef dbus_bool_t (*WPADBusPropertyAccessor)(
@@ -37,6 +39,9 @@ struct wpa_dbus_object_desc {
 
 	/* property changed flags */
 	u8 *prop_changed_flags;
+	/* entry in the list of objects with changed properties */
+	struct dl_list prop_changed_list;
+	bool prop_changed;
 
 	/* argument for method handlers and properties
 	 * getter and setter functions */
@@ -127,6 +132,22 @@ int wpa_dbus_unregister_object_per_iface(
 	struct wpas_dbus_priv *ctrl_iface,
 	const char *path);
 
+int wpa_dbus_register_fallback_per_iface(struct wpas_dbus_priv *ctrl_iface,
+					 const char *path,
+					 WPADBusObjectCreateFunction create,
+					 void *ctx);
+
+void wpa_dbus_unregister_fallback_per_iface(struct wpas_dbus_priv *ctrl_iface,
+					    const char *path);
+
+int wpa_dbus_object_registered(struct wpas_dbus_priv *ctrl_iface,
+			       const char *path);
+
+dbus_bool_t wpa_dbus_put_properties(DBusMessageIter *dict_iter,
+				    const struct wpa_dbus_property_desc *props,
+				    const char *interface, void *user_data,
+				    DBusError *error);
+
 dbus_bool_t wpa_dbus_get_object_properties(struct wpas_dbus_priv *iface,
 					   const char *path,
 					   const char *interface,
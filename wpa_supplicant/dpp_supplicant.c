@@ -5067,6 +5067,10 @@ int wpas_dpp_controller_start(struct wpa_supplicant *wpa_s, const char *cmd)
 		}
 
 		config.qr_mutual = os_strstr(cmd, " qr=mutual") != NULL;
+
+		pos = os_strstr(cmd, " max_conn=");
+		if (pos)
+			config.max_conn = atoi(pos + 10);
 	}
 	config.configurator_params = wpa_s->dpp_configurator_params;
 	return dpp_controller_start(wpa_s->dpp, &config);
@@ -539,6 +539,16 @@ static inline int wpa_drv_pktcnt_poll(struct wpa_supplicant *wpa_s,
 	return -1;
 }
 
+static inline int wpa_drv_read_sta_data(struct wpa_supplicant *wpa_s,
+					struct hostap_sta_driver_data *sta,
+					const u8 *addr)
+{
+	if (wpa_s->driver->read_sta_data)
+		return wpa_s->driver->read_sta_data(wpa_s->drv_priv, sta,
+						    addr);
+	return -1;
+}
+
 static inline int wpa_drv_set_ap_wps_ie(struct wpa_supplicant *wpa_s,
 					const struct wpabuf *beacon,
 					const struct wpabuf *proberesp,
@@ -53,6 +53,7 @@
 #include "wmm_ac.h"
 #include "nan_usd.h"
 #include "dpp_supplicant.h"
+#include "wpas_status_shm.h"
 #include "rsn_supp/wpa_i.h"
 
 
@@ -1630,10 +1631,91 @@ skip_assoc_disallow:
 }
 
 
-struct wpa_ssid * wpa_scan_res_match(struct wpa_supplicant *wpa_s,
-				     int i, struct wpa_bss *bss,
-				     struct wpa_ssid *group,
-				     int only_first_ssid, int debug_print)
+static bool wpa_ssid_allows_non_wpa(struct wpa_ssid *ssid)
+{
+	return !!(ssid->key_mgmt & (WPA_KEY_MGMT_NONE | WPA_KEY_MGMT_WPS |
+				    WPA_KEY_MGMT_OWE |
+				    WPA_KEY_MGMT_IEEE8021X_NO_WPA));
+}
+
+
+static bool wpa_bss_no_wpa(const struct wpa_bss *bss)
+{
+	return !wpa_bss_get_ie(bss, WLAN_EID_RSN) &&
+		!wpa_bss_get_vendor_ie(bss, WPA_IE_VENDOR_TYPE) &&
+		!wpa_bss_get_vendor_ie(bss, RSNE_OVERRIDE_IE_VENDOR_TYPE) &&
+		!wpa_bss_get_vendor_ie(bss, RSNE_OVERRIDE_2_IE_VENDOR_TYPE) &&
+		!wpa_bss_get_vendor_ie(bss, OSEN_IE_VENDOR_TYPE);
+}
+
+
+/*
+ * Precomputed filter for the networks of a priority group. A network with a
+ * fixed SSID can match only BSSes with the same SSID, so a bitmap of SSID
+ * hashes allows a BSS that cannot match any network in the group to be
+ * skipped before the detailed per-network checks. Similarly, a BSS without
+ * any WPA/RSN/OSEN element can be skipped if all networks in the group
+ * require one.
+ */
+struct wpa_ssid_matcher {
+	bool wildcard; /* the group has a network without a fixed SSID */
+	bool non_wpa; /* the group has a network that allows non-WPA APs */
+	u32 ssid_hash[1024 / 32];
+};
+
+
+static unsigned int wpa_ssid_matcher_hash(const u8 *ssid, size_t ssid_len)
+{
+	u32 hash = 2166136261U;
+	size_t i;
+
+	/* FNV-1a */
+	for (i = 0; i < ssid_len; i++) {
+		hash ^= ssid[i];
+		hash *= 16777619U;
+	}
+
+	return hash % 1024;
+}
+
+
+static void wpa_ssid_matcher_init(struct wpa_ssid_matcher *matcher,
+				  struct wpa_ssid *group, int only_first_ssid)
+{
+	struct wpa_ssid *ssid;
+	unsigned int hash;
+
+	os_memset(matcher, 0, sizeof(*matcher));
+	for (ssid = group; ssid; ssid = only_first_ssid ? NULL : ssid->pnext) {
+		if (wpa_ssid_allows_non_wpa(ssid))
+			matcher->non_wpa = true;
+		if (ssid->ssid_len == 0) {
+			matcher->wildcard = true;
+			continue;
+		}
+		hash = wpa_ssid_matcher_hash(ssid->ssid, ssid->ssid_len);
+		matcher->ssid_hash[hash / 32] |= BIT(hash % 32);
+	}
+}
+
+
+static bool wpa_ssid_matcher_may_match(const struct wpa_ssid_matcher *matcher,
+				       const u8 *ssid, size_t ssid_len)
+{
+	unsigned int hash;
+
+	if (matcher->wildcard)
+		return true;
+	hash = wpa_ssid_matcher_hash(ssid, ssid_len);
+	return !!(matcher->ssid_hash[hash / 32] & BIT(hash % 32));
+}
+
+
+static struct wpa_ssid *
+wpa_scan_res_match_group(struct wpa_supplicant *wpa_s, int i,
+			 struct wpa_bss *bss, struct wpa_ssid *group,
+			 int only_first_ssid, int debug_print,
+			 const struct wpa_ssid_matcher *matcher)
 {
 	u8 wpa_ie_len, rsn_ie_len;
 	const u8 *ie;
@@ -1642,6 +1724,7 @@ struct wpa_ssid * wpa_scan_res_match(struct wpa_supplicant *wpa_s,
 	const u8 *match_ssid;
 	size_t match_ssid_len;
 	int bssid_ignore_count;
+	bool no_wpa = false;
 
 	ie = wpa_bss_get_vendor_ie(bss, WPA_IE_VENDOR_TYPE);
 	wpa_ie_len = ie ? ie[1] : 0;
@@ -1701,6 +1784,23 @@ struct wpa_ssid * wpa_scan_res_match(struct wpa_supplicant *wpa_s,
 		return NULL;
 	}
 
+	if (matcher &&
+	    !wpa_ssid_matcher_may_match(matcher, match_ssid, match_ssid_len)) {
+		if (debug_print)
+			wpa_dbg(wpa_s, MSG_DEBUG, "   skip - SSID mismatch");
+		return NULL;
+	}
+
+	if (matcher) {
+		no_wpa = wpa_bss_no_wpa(bss);
+		if (no_wpa && !matcher->non_wpa) {
+			if (debug_print)
+				wpa_dbg(wpa_s, MSG_DEBUG,
+					"   skip - non-WPA network not allowed");
+			return NULL;
+		}
+	}
+
 	if (disallowed_bssid(wpa_s, bss->bssid)) {
 		if (debug_print)
 			wpa_dbg(wpa_s, MSG_DEBUG, "   skip - BSSID disallowed");
@@ -1726,6 +1826,24 @@ struct wpa_ssid * wpa_scan_res_match(struct wpa_supplicant *wpa_s,
 	}
 
 	for (ssid = group; ssid; ssid = only_first_ssid ? NULL : ssid->pnext) {
+		/* A network with a fixed SSID requires an exact SSID match, so
+		 * do not bother with the more expensive checks. */
+		if (matcher && ssid->ssid_len &&
+		    (ssid->ssid_len != match_ssid_len ||
+		     os_memcmp(ssid->ssid, match_ssid, match_ssid_len) != 0)) {
+			if (debug_print)
+				wpa_dbg(wpa_s, MSG_DEBUG,
+					"   skip - SSID mismatch");
+			continue;
+		}
+
+		if (no_wpa && !wpa_ssid_allows_non_wpa(ssid)) {
+			if (debug_print)
+				wpa_dbg(wpa_s, MSG_DEBUG,
+					"   skip - non-WPA network not allowed");
+			continue;
+		}
+
 		if (wpa_scan_res_ok(wpa_s, ssid, match_ssid, match_ssid_len,
 				    bss, bssid_ignore_count, debug_print))
 			return ssid;
@@ -1736,6 +1854,16 @@ struct wpa_ssid * wpa_scan_res_match(struct wpa_supplicant *wpa_s,
 }
 
 
+struct wpa_ssid * wpa_scan_res_match(struct wpa_supplicant *wpa_s,
+				     int i, struct wpa_bss *bss,
+				     struct wpa_ssid *group,
+				     int only_first_ssid, int debug_print)
+{
+	return wpa_scan_res_match_group(wpa_s, i, bss, group, only_first_ssid,
+					debug_print, NULL);
+}
+
+
 static struct wpa_bss *
 wpa_supplicant_select_bss(struct wpa_supplicant *wpa_s,
 			  struct wpa_ssid *group,
@@ -1743,6 +1871,9 @@ wpa_supplicant_select_bss(struct wpa_supplicant *wpa_s,
 			  int only_first_ssid)
 {
 	unsigned int i;
+	struct wpa_ssid_matcher matcher;
+
+	wpa_ssid_matcher_init(&matcher, group, only_first_ssid);
 
 	if (wpa_s->current_ssid) {
 		struct wpa_ssid *ssid;
@@ -1752,8 +1883,9 @@ wpa_supplicant_select_bss(struct wpa_supplicant *wpa_s,
 		for (i = 0; i < wpa_s->last_scan_res_used; i++) {
 			struct wpa_bss *bss = wpa_s->last_scan_res[i];
 
-			ssid = wpa_scan_res_match(wpa_s, i, bss, group,
-						  only_first_ssid, 0);
+			ssid = wpa_scan_res_match_group(wpa_s, i, bss, group,
+							only_first_ssid, 0,
+							&matcher);
 			if (ssid != wpa_s->current_ssid)
 				continue;
 			wpa_dbg(wpa_s, MSG_DEBUG, "%u: " MACSTR
@@ -1774,8 +1906,9 @@ wpa_supplicant_select_bss(struct wpa_supplicant *wpa_s,
 		struct wpa_bss *bss = wpa_s->last_scan_res[i];
 
 		wpa_s->owe_transition_select = 1;
-		*selected_ssid = wpa_scan_res_match(wpa_s, i, bss, group,
-						    only_first_ssid, 1);
+		*selected_ssid = wpa_scan_res_match_group(wpa_s, i, bss, group,
+							  only_first_ssid, 1,
+							  &matcher);
 		wpa_s->owe_transition_select = 0;
 		if (!*selected_ssid)
 			continue;
@@ -2402,11 +2535,150 @@ static int wpa_supplicant_need_to_roam(struct wpa_supplicant *wpa_s,
 }
 
 
+/*
+ * Bloom filter for the short SSIDs of the networks of interest. A short SSID is
+ * a CRC32, so two slices of it can be used directly as the hash values. This
+ * allows the neighbor entries of all the other networks in the area to be
+ * rejected without going through the list of configured networks.
+ */
+#define SHORT_SSID_FILTER_BITS 1024
+
+static void short_ssid_filter_add(u32 *filter, u32 short_ssid)
+{
+	unsigned int h1 = short_ssid % SHORT_SSID_FILTER_BITS;
+	unsigned int h2 = (short_ssid >> 16) % SHORT_SSID_FILTER_BITS;
+
+	filter[h1 / 32] |= BIT(h1 % 32);
+	filter[h2 / 32] |= BIT(h2 % 32);
+}
+
+
+static bool short_ssid_filter_may_match(const u32 *filter, u32 short_ssid)
+{
+	unsigned int h1 = short_ssid % SHORT_SSID_FILTER_BITS;
+	unsigned int h2 = (short_ssid >> 16) % SHORT_SSID_FILTER_BITS;
+
+	return (filter[h1 / 32] & BIT(h1 % 32)) &&
+		(filter[h2 / 32] & BIT(h2 % 32));
+}
+
+
+static void wpas_rnr_6ghz_ap_info(const struct ieee80211_neighbor_ap_info *info,
+				  const u32 *short_ssids, size_t num_short_ssids,
+				  const u32 *filter, int **freqs)
+{
+	const u8 *pos = info->data;
+	u8 count, i;
+	size_t j;
+	int freq;
+
+	freq = ieee80211_chan_to_freq(NULL, info->op_class, info->channel);
+	if (freq <= 0 || !is_6ghz_freq(freq) ||
+	    info->tbtt_info_len < 11)
+		return; /* short SSID not included */
+
+	count = RNR_TBTT_INFO_COUNT_VAL(info->tbtt_info_hdr) + 1;
+	for (i = 0; i < count; i++, pos += info->tbtt_info_len) {
+		/* Skip TBTT offset and BSSID */
+		u32 short_ssid = WPA_GET_LE32(pos + 1 + ETH_ALEN);
+
+		if (!short_ssid_filter_may_match(filter, short_ssid))
+			continue;
+		for (j = 0; j < num_short_ssids; j++) {
+			if (short_ssid == short_ssids[j]) {
+				int_array_add_unique(freqs, freq);
+				return;
+			}
+		}
+	}
+}
+
+
+/*
+ * Collect the 6 GHz channels on which the Reduced Neighbor Report elements of
+ * the BSSs in the BSS table advertise a short SSID of the current network or,
+ * if not connected, of any enabled network.
+ */
+static int * wpas_rnr_6ghz_freqs(struct wpa_supplicant *wpa_s)
+{
+	struct wpa_ssid *ssid;
+	struct wpa_bss *bss;
+	u32 *short_ssids;
+	u32 filter[SHORT_SSID_FILTER_BITS / 32];
+	size_t num = 0, max = 0, i;
+	int *freqs = NULL;
+
+	for (ssid = wpa_s->conf->ssid; ssid; ssid = ssid->next)
+		max++;
+	short_ssids = os_calloc(max ? max : 1, sizeof(u32));
+	if (!short_ssids)
+		return NULL;
+
+	if (wpa_s->current_ssid) {
+		ssid = wpa_s->current_ssid;
+		short_ssids[num++] = ieee80211_crc32(ssid->ssid,
+						     ssid->ssid_len);
+	} else {
+		for (ssid = wpa_s->conf->ssid; ssid; ssid = ssid->next) {
+			if (wpas_network_disabled(wpa_s, ssid) ||
+			    !ssid->ssid_len)
+				continue;
+			short_ssids[num++] = ieee80211_crc32(ssid->ssid,
+							     ssid->ssid_len);
+		}
+	}
+
+	os_memset(filter, 0, sizeof(filter));
+	for (i = 0; i < num; i++)
+		short_ssid_filter_add(filter, short_ssids[i]);
+
+	dl_list_for_each(bss, &wpa_s->bss, struct wpa_bss, list) {
+		const struct element *elem;
+
+		if (!num)
+			break;
+		if (is_6ghz_freq(bss->freq))
+			continue;
+
+		for_each_element_id(elem, WLAN_EID_REDUCED_NEIGHBOR_REPORT,
+				    wpa_bss_ie_ptr(bss),
+				    bss->ie_len ? bss->ie_len :
+				    bss->beacon_ie_len) {
+			const struct ieee80211_neighbor_ap_info *info;
+			const u8 *pos = elem->data;
+			size_t len = elem->datalen;
+
+			/* RNR IE may contain more than one Neighbor AP Info */
+			while (sizeof(*info) <= len) {
+				size_t info_len = sizeof(*info);
+
+				info = (const struct ieee80211_neighbor_ap_info *)
+					pos;
+				info_len += (RNR_TBTT_INFO_COUNT_VAL(
+						     info->tbtt_info_hdr) + 1) *
+					info->tbtt_info_len;
+				if (info_len > len)
+					break;
+
+				wpas_rnr_6ghz_ap_info(info, short_ssids, num,
+						      filter, &freqs);
+				pos += info_len;
+				len -= info_len;
+			}
+		}
+	}
+
+	os_free(short_ssids);
+	return freqs;
+}
+
+
 static int wpas_trigger_6ghz_scan(struct wpa_supplicant *wpa_s,
 				  union wpa_event_data *data)
 {
 	struct wpa_driver_scan_params params;
 	unsigned int j;
+	bool targeted = false;
 
 	wpa_dbg(wpa_s, MSG_INFO, "Triggering 6GHz-only scan");
 	os_memset(&params, 0, sizeof(params));
@@ -2414,10 +2686,31 @@ static int wpas_trigger_6ghz_scan(struct wpa_supplicant *wpa_s,
 	for (j = 0; j < data->scan_info.num_ssids; j++)
 		params.ssids[j] = data->scan_info.ssids[j];
 	params.num_ssids = data->scan_info.num_ssids;
-	wpa_add_scan_freqs_list(wpa_s, HOSTAPD_MODE_IEEE80211A, &params,
-				true, false, false);
+	if (params.non_coloc_6ghz) {
+		wpa_add_scan_freqs_list(wpa_s, HOSTAPD_MODE_IEEE80211A,
+					&params, true, false, false);
+	} else {
+		/*
+		 * Limit the scan to the channels advertised in RNR elements
+		 * for the networks of interest and fall back to the PSC
+		 * channels if the neighbor reports did not list any.
+		 */
+		params.freqs = wpas_rnr_6ghz_freqs(wpa_s);
+		if (params.freqs) {
+			targeted = true;
+			wpa_dbg(wpa_s, MSG_DEBUG,
+				"6 GHz scan on %zu channel(s) reported in RNR",
+				int_array_len(params.freqs));
+		} else {
+			wpa_add_scan_freqs_list(wpa_s, HOSTAPD_MODE_IEEE80211A,
+						&params, true, true, false);
+		}
+	}
+	/* Discovery time is counted from the preceding scan */
+	wpa_s->scan_6ghz_start = wpa_s->scan_trigger_time;
 	if (!wpa_supplicant_trigger_scan(wpa_s, &params, true, true)) {
 		wpa_s->scan_in_progress_6ghz = true;
+		wpa_s->scan_6ghz_targeted = targeted;
 		wpas_notify_scan_in_progress_6ghz(wpa_s);
 		os_free(params.freqs);
 		return 1;
@@ -2428,6 +2721,31 @@ static int wpas_trigger_6ghz_scan(struct wpa_supplicant *wpa_s,
 }
 
 
+static void wpas_6ghz_scan_done(struct wpa_supplicant *wpa_s,
+				struct wpa_scan_results *scan_res)
+{
+	struct os_reltime now, diff;
+	unsigned int found = 0, type;
+	size_t i;
+
+	for (i = 0; scan_res && i < scan_res->num; i++) {
+		if (is_6ghz_freq(scan_res->res[i]->freq))
+			found++;
+	}
+
+	os_get_reltime(&now);
+	os_reltime_sub(&now, &wpa_s->scan_6ghz_start, &diff);
+	type = wpa_s->scan_6ghz_targeted;
+	wpa_s->scan_6ghz_stages[type]++;
+	wpa_s->scan_6ghz_found[type] += found;
+	wpa_s->scan_6ghz_time_us[type] += diff.sec * 1000000 + diff.usec;
+	wpa_dbg(wpa_s, MSG_DEBUG,
+		"6 GHz discovery (%s): %u BSS(s) in %ld ms",
+		type ? "RNR" : "PSC", found,
+		(long) (diff.sec * 1000 + diff.usec / 1000));
+}
+
+
 static bool wpas_short_ssid_match(struct wpa_supplicant *wpa_s,
 				  struct wpa_scan_results *scan_res)
 {
@@ -2508,11 +2826,15 @@ static int _wpa_supplicant_event_scan_results(struct wpa_supplicant *wpa_s,
 
 	wpa_supplicant_notify_scanning(wpa_s, 0);
 
+	wpas_connect_trace(wpa_s, WPAS_CONNECT_SCAN_RESULTS);
 	scan_res = wpa_supplicant_get_scan_results(wpa_s,
 						   data ? &data->scan_info :
 						   NULL, 1, NULL);
+	if (scan_res)
+		wpas_connect_trace(wpa_s, WPAS_CONNECT_BSS_UPDATE);
 
 	if (wpa_s->scan_in_progress_6ghz) {
+		wpas_6ghz_scan_done(wpa_s, scan_res);
 		wpa_s->scan_in_progress_6ghz = false;
 		wpas_notify_scan_in_progress_6ghz(wpa_s);
 	}
@@ -2678,6 +3000,8 @@ static int _wpa_supplicant_event_scan_results(struct wpa_supplicant *wpa_s,
 	if (short_ssid_match_found && wpas_trigger_6ghz_scan(wpa_s, data) > 0)
 		return 1;
 
+	sme_sae_precompute(wpa_s);
+
 	return wpas_select_network_from_last_scan(wpa_s, 1, own_request,
 						  trigger_6ghz_scan, data);
 
@@ -2876,7 +3200,8 @@ static int wpas_select_network_from_last_scan(struct wpa_supplicant *wpa_s,
 static int wpa_supplicant_event_scan_results(struct wpa_supplicant *wpa_s,
 					     union wpa_event_data *data)
 {
-	struct wpa_supplicant *ifs;
+	struct wpa_supplicant *ifs, *tmp;
+	bool stop;
 	int res;
 
 	res = _wpa_supplicant_event_scan_results(wpa_s, data, 1, 0);
@@ -2888,36 +3213,102 @@ static int wpa_supplicant_event_scan_results(struct wpa_supplicant *wpa_s,
 		return 1;
 	}
 
-	if (res < 0) {
-		/*
-		 * If no scan results could be fetched, then no need to
-		 * notify those interfaces that did not actually request
-		 * this scan. Similarly, if scan results started a new operation on this
-		 * interface, do not notify other interfaces to avoid concurrent
-		 * operations during a connection attempt.
-		 */
-		return 0;
-	}
+	/*
+	 * If no scan results could be fetched, then no need to
+	 * notify those interfaces that did not actually request
+	 * this scan. Similarly, if scan results started a new operation on this
+	 * interface, do not notify other interfaces to avoid concurrent
+	 * operations during a connection attempt. Interfaces whose scan
+	 * request was merged into this scan are always notified.
+	 */
+	stop = res < 0;
 
 	/*
 	 * Check other interfaces to see if they share the same radio. If
 	 * so, they get updated with this same scan info.
 	 */
-	dl_list_for_each(ifs, &wpa_s->radio->ifaces, struct wpa_supplicant,
-			 radio_list) {
-		if (ifs != wpa_s) {
+	dl_list_for_each_safe(ifs, tmp, &wpa_s->radio->ifaces,
+			      struct wpa_supplicant, radio_list) {
+		bool merged;
+
+		if (ifs == wpa_s)
+			continue;
+		merged = ifs->scan_merged;
+		ifs->scan_merged = false;
+		if (stop && !merged)
+			continue;
+
+		if (merged)
+			wpa_printf(MSG_DEBUG,
+				   "%s: Scan results for merged scan request",
+				   ifs->ifname);
+		else
 			wpa_printf(MSG_DEBUG, "%s: Updating scan results from "
 				   "sibling", ifs->ifname);
-			res = _wpa_supplicant_event_scan_results(ifs, data, 0,
-								 res > 0);
-			if (res < 0)
-				return 0;
-		}
+		res = _wpa_supplicant_event_scan_results(ifs, data, merged,
+							 !merged && res > 0);
+		if (res < 0)
+			stop = true;
 	}
 
 	return 0;
 }
 
+
+
+/*
+ * Check whether the cached BSS entry that would be selected for connection is
+ * fresh enough to be used without a new scan when the scan results themselves
+ * are older than scan_res_valid_for_connect.
+ */
+static bool wpas_cached_bss_fresh(struct wpa_supplicant *wpa_s,
+				  struct os_reltime *now)
+{
+	struct wpa_ssid *ssid = NULL, *next_ssid = wpa_s->next_ssid;
+	struct wpa_bss *bss;
+	struct os_reltime age;
+	os_time_t age_ms, budget_ms;
+
+	bss = wpa_supplicant_pick_network(wpa_s, &ssid);
+	/* Leave next_ssid for the actual network selection */
+	wpa_s->next_ssid = next_ssid;
+	if (!bss)
+		return false;
+
+	budget_ms = wpa_s->conf->scan_res_stale_budget * 1000;
+	if (bss->level < -75)
+		budget_ms /= 2;
+	if (is_6ghz_freq(bss->freq))
+		budget_ms /= 2;
+	else if (bss->freq > 4000)
+		budget_ms = budget_ms * 3 / 4;
+
+	os_reltime_sub(now, &bss->last_update, &age);
+	age_ms = age.sec * 1000 + age.usec / 1000;
+
+	if (age_ms > budget_ms) {
+		wpa_printf(MSG_DEBUG,
+			   "Fast associate: Cached entry for " MACSTR
+			   " too old (%ld ms > %ld ms)",
+			   MAC2STR(bss->bssid), (long) age_ms, (long) budget_ms);
+		return false;
+	}
+
+	if (bss->level - bss->prev_level <= -10) {
+		wpa_printf(MSG_DEBUG,
+			   "Fast associate: Signal of " MACSTR
+			   " dropping (%d -> %d dBm)",
+			   MAC2STR(bss->bssid), bss->prev_level, bss->level);
+		return false;
+	}
+
+	wpa_printf(MSG_DEBUG,
+		   "Fast associate: Use cached entry for " MACSTR
+		   " (age %ld ms, level %d dBm)",
+		   MAC2STR(bss->bssid), (long) age_ms, bss->level);
+	return true;
+}
+
 #endif /* CONFIG_NO_SCAN_PROCESSING */
 
 
@@ -2927,6 +3318,8 @@ int wpa_supplicant_fast_associate(struct wpa_supplicant *wpa_s)
 	return -1;
 #else /* CONFIG_NO_SCAN_PROCESSING */
 	struct os_reltime now;
+	bool cached = false;
+	int res;
 
 	wpa_s->ignore_post_flush_scan_res = 0;
 
@@ -2934,16 +3327,29 @@ int wpa_supplicant_fast_associate(struct wpa_supplicant *wpa_s)
 		return -1;
 
 	os_get_reltime(&now);
-	if (os_reltime_expired(&now, &wpa_s->last_scan,
-			       wpa_s->conf->scan_res_valid_for_connect)) {
-		wpa_printf(MSG_DEBUG, "Fast associate: Old scan results");
-		return -1;
-	} else if (wpa_s->crossed_6ghz_dom) {
+	if (wpa_s->crossed_6ghz_dom) {
 		wpa_printf(MSG_DEBUG, "Fast associate: Crossed 6 GHz domain");
 		return -1;
+	} else if (os_reltime_expired(&now, &wpa_s->last_scan,
+				      wpa_s->conf->scan_res_valid_for_connect)) {
+		if (!wpa_s->conf->scan_res_stale_budget ||
+		    os_reltime_expired(&now, &wpa_s->last_scan,
+				       wpa_s->conf->scan_res_stale_budget) ||
+		    !wpas_cached_bss_fresh(wpa_s, &now)) {
+			wpa_printf(MSG_DEBUG,
+				   "Fast associate: Old scan results");
+			return -1;
+		}
+		cached = true;
 	}
 
-	return wpas_select_network_from_last_scan(wpa_s, 0, 1, false, NULL);
+	res = wpas_select_network_from_last_scan(wpa_s, 0, 1, false, NULL);
+	if (res == 1) {
+		wpa_s->fast_assoc_scans_skipped++;
+		if (cached)
+			wpa_s->fast_assoc_cached++;
+	}
+	return res;
 #endif /* CONFIG_NO_SCAN_PROCESSING */
 }
 
@@ -4369,6 +4775,7 @@ static void wpa_supplicant_event_assoc(struct wpa_supplicant *wpa_s,
 	}
 #endif /* CONFIG_AP */
 
+	wpas_connect_trace(wpa_s, WPAS_CONNECT_ASSOC);
 	eloop_cancel_timeout(wpas_network_reenabled, wpa_s, NULL);
 	wpa_s->own_reconnect_req = 0;
 
@@ -4703,6 +5110,10 @@ static void wpa_supplicant_event_assoc(struct wpa_supplicant *wpa_s,
 
 		if (wpa_s->reassoc_same_bss)
 			wmm_ac_restore_tspecs(wpa_s);
+		else
+			wmm_ac_readmit_tspecs(wpa_s,
+					      data->assoc_info.resp_ies,
+					      data->assoc_info.resp_ies_len);
 	}
 #endif /* CONFIG_NO_WMM_AC */
 
@@ -5590,6 +6001,13 @@ static void wpas_event_rx_mgmt_action(struct wpa_supplicant *wpa_s,
 	}
 #endif /* CONFIG_IEEE80211R */
 
+#ifdef CONFIG_TESTING_OPTIONS
+	if (category == WLAN_ACTION_S1G) {
+		wpas_twt_rx_action(wpa_s, mgmt->sa, payload, plen);
+		return;
+	}
+#endif /* CONFIG_TESTING_OPTIONS */
+
 #ifdef CONFIG_SME
 	if (category == WLAN_ACTION_SA_QUERY) {
 		sme_sa_query_rx(wpa_s, mgmt->da, mgmt->sa, payload, plen);
@@ -6437,6 +6855,7 @@ void wpa_supplicant_event(void *ctx, enum wpa_event_type event,
 			wpa_s->wps_scan_done = true;
 			wpa_dbg(wpa_s, MSG_DEBUG, "Scan completed in %ld.%06ld seconds",
 				diff.sec, diff.usec);
+			wpas_roam_scan_completed(wpa_s, &diff);
 		}
 		if (wpa_supplicant_event_scan_results(wpa_s, data))
 			break; /* interface may have been removed */
@@ -6628,6 +7047,7 @@ void wpa_supplicant_event(void *ctx, enum wpa_event_type event,
 		if (event == EVENT_LINK_CH_SWITCH_STARTED)
 			break;
 
+		wpa_s->signal_cache_valid = false;
 		wpa_s->links[data->ch_switch.link_id].freq =
 			data->ch_switch.freq;
 		if (wpa_s->links[data->ch_switch.link_id].bss &&
@@ -6660,6 +7080,7 @@ void wpa_supplicant_event(void *ctx, enum wpa_event_type event,
 		if (event == EVENT_CH_SWITCH_STARTED)
 			break;
 
+		wpa_s->signal_cache_valid = false;
 		if (wpa_s->assoc_freq && data->ch_switch.freq &&
 			    (int) wpa_s->assoc_freq != data->ch_switch.freq) {
 			wpas_notify_frequency_changed(wpa_s, data->ch_switch.freq);
@@ -6928,7 +7349,9 @@ void wpa_supplicant_event(void *ctx, enum wpa_event_type event,
 			data->signal_change.data.current_tx_rate);
 		os_memcpy(&wpa_s->last_signal_info, data,
 			  sizeof(struct wpa_signal_info));
+		wpas_signal_cache_update(wpa_s, &data->signal_change);
 		wpas_notify_signal_change(wpa_s);
+		wpas_status_shm_signal(wpa_s, &data->signal_change);
 		break;
 	case EVENT_INTERFACE_MAC_CHANGED:
 		wpa_supplicant_update_mac_addr(wpa_s);
@@ -7145,7 +7568,8 @@ void wpa_supplicant_event(void *ctx, enum wpa_event_type event,
 			break;
 		wpa_mesh_notify_peer(wpa_s, data->mesh_peer.peer,
 				     data->mesh_peer.ies,
-				     data->mesh_peer.ie_len);
+				     data->mesh_peer.ie_len,
+				     data->mesh_peer.ssi_signal);
 #endif /* CONFIG_MESH */
 		break;
 	case EVENT_SURVEY:
@@ -46,6 +46,7 @@ struct gas_query_pending {
 	unsigned int retry:1;
 	unsigned int wildcard_bssid:1;
 	unsigned int maintain_addr:1;
+	unsigned int active:1; /* started within gas->work */
 	int freq;
 	u16 status_code;
 	struct wpabuf *req;
@@ -67,7 +68,9 @@ struct gas_query {
 	struct wpa_supplicant *wpa_s;
 	struct dl_list pending; /* struct gas_query_pending */
 	struct gas_query_pending *current;
+	struct gas_query_pending *tx_wait; /* waiting for TX status */
 	struct wpa_radio_work *work;
+	unsigned int num_active; /* queries started within work */
 	struct os_reltime last_mac_addr_rand;
 	int last_rand_sa_type;
 	u8 rand_addr[ETH_ALEN];
@@ -80,6 +83,8 @@ static void gas_query_rx_comeback_timeout(void *eloop_data, void *user_ctx);
 static void gas_query_tx_initial_req(struct gas_query *gas,
 				     struct gas_query_pending *query);
 static int gas_query_new_dialog_token(struct gas_query *gas, const u8 *dst);
+static void gas_query_start_next(struct gas_query *gas);
+static void gas_query_start_next_cb(void *eloop_data, void *user_ctx);
 
 
 static int ms_from_time(struct os_reltime *last)
@@ -135,6 +140,39 @@ static const char * gas_result_txt(enum gas_query_result result)
 }
 
 
+static struct gas_query_pending *
+gas_query_first_active(struct gas_query *gas)
+{
+	struct gas_query_pending *q;
+
+	dl_list_for_each(q, &gas->pending, struct gas_query_pending, list) {
+		if (q->active)
+			return q;
+	}
+
+	return NULL;
+}
+
+
+/* Stop the off-channel operation unless other queries are still using it */
+static void gas_query_offchannel_done(struct gas_query *gas,
+				      struct gas_query_pending *query)
+{
+	struct gas_query_pending *q;
+
+	if (!query->offchannel_tx_started)
+		return;
+	query->offchannel_tx_started = 0;
+
+	dl_list_for_each(q, &gas->pending, struct gas_query_pending, list) {
+		if (q->offchannel_tx_started)
+			return;
+	}
+
+	offchannel_send_action_done(gas->wpa_s);
+}
+
+
 static void gas_query_free(struct gas_query_pending *query, int del_list)
 {
 	struct gas_query *gas = query->gas;
@@ -142,9 +180,19 @@ static void gas_query_free(struct gas_query_pending *query, int del_list)
 	if (del_list)
 		dl_list_del(&query->list);
 
-	if (gas->work && gas->work->ctx == query) {
-		radio_work_done(gas->work);
-		gas->work = NULL;
+	if (gas->tx_wait == query)
+		gas->tx_wait = NULL;
+
+	if (query->active) {
+		query->active = 0;
+		gas->num_active--;
+		if (gas->work && gas->num_active == 0) {
+			radio_work_done(gas->work);
+			gas->work = NULL;
+		} else if (gas->work && gas->work->ctx == query) {
+			/* Other queries continue within the same radio work */
+			gas->work->ctx = gas_query_first_active(gas);
+		}
 	}
 
 	eloop_cancel_timeout(gas_query_tx_comeback_timeout, gas, query);
@@ -168,12 +216,14 @@ static void gas_query_done(struct gas_query *gas,
 		query->status_code, gas_result_txt(result));
 	if (gas->current == query)
 		gas->current = NULL;
-	if (query->offchannel_tx_started)
-		offchannel_send_action_done(gas->wpa_s);
+	gas_query_offchannel_done(gas, query);
 	dl_list_del(&query->list);
 	query->cb(query->ctx, query->addr, query->dialog_token, result,
 		  query->adv_proto, query->resp, query->status_code);
 	gas_query_free(query, 0);
+	if (gas->work)
+		eloop_register_timeout(0, 0, gas_query_start_next_cb, gas,
+				       NULL);
 }
 
 
@@ -191,6 +241,7 @@ void gas_query_deinit(struct gas_query *gas)
 	dl_list_for_each_safe(query, next, &gas->pending,
 			      struct gas_query_pending, list)
 		gas_query_done(gas, query, GAS_QUERY_DELETED_AT_DEINIT);
+	eloop_cancel_timeout(gas_query_start_next_cb, gas, NULL);
 
 	os_free(gas);
 }
@@ -237,15 +288,14 @@ static void gas_query_tx_status(struct wpa_supplicant *wpa_s,
 	struct gas_query *gas = wpa_s->gas;
 	int dur;
 
-	if (gas->current == NULL) {
+	query = gas->tx_wait ? gas->tx_wait : gas->current;
+	if (query == NULL) {
 		wpa_printf(MSG_DEBUG, "GAS: Unexpected TX status: freq=%u dst="
 			   MACSTR " result=%d - no query in progress",
 			   freq, MAC2STR(dst), result);
 		return;
 	}
 
-	query = gas->current;
-
 	dur = ms_from_time(&query->last_oper);
 	wpa_printf(MSG_DEBUG, "GAS: TX status: freq=%u dst=" MACSTR
 		   " result=%d query=%p dialog_token=%u dur=%d ms",
@@ -255,6 +305,8 @@ static void gas_query_tx_status(struct wpa_supplicant *wpa_s,
 		return;
 	}
 	os_get_reltime(&query->last_oper);
+	if (gas->tx_wait == query)
+		gas->tx_wait = NULL;
 
 	if (result == OFFCHANNEL_SEND_ACTION_SUCCESS ||
 	    result == OFFCHANNEL_SEND_ACTION_NO_ACK) {
@@ -279,6 +331,8 @@ static void gas_query_tx_status(struct wpa_supplicant *wpa_s,
 		eloop_cancel_timeout(gas_query_timeout, gas, query);
 		eloop_register_timeout(0, 0, gas_query_timeout, gas, query);
 	}
+
+	gas_query_start_next(gas);
 }
 
 
@@ -317,8 +371,10 @@ static int gas_query_tx(struct gas_query *gas, struct gas_query_pending *query,
 				     wpabuf_len(req), wait_time,
 				     gas_query_tx_status, 0);
 
-	if (res == 0)
+	if (res == 0) {
 		query->offchannel_tx_started = 1;
+		gas->tx_wait = query;
+	}
 	return res;
 }
 
@@ -329,6 +385,14 @@ static void gas_query_tx_comeback_req(struct gas_query *gas,
 	struct wpabuf *req;
 	unsigned int wait_time;
 
+	if (gas->tx_wait && gas->tx_wait != query) {
+		/* Wait for the TX status of the frame to another peer */
+		eloop_cancel_timeout(gas_query_tx_comeback_timeout, gas, query);
+		eloop_register_timeout(0, 10000, gas_query_tx_comeback_timeout,
+				       gas, query);
+		return;
+	}
+
 	req = gas_build_comeback_req(query->dialog_token);
 	if (req == NULL) {
 		gas_query_done(gas, query, GAS_QUERY_INTERNAL_ERROR);
@@ -357,8 +421,14 @@ static void gas_query_rx_comeback_timeout(void *eloop_data, void *user_ctx)
 	wpa_printf(MSG_DEBUG,
 		   "GAS: No response to comeback request received (retry=%u)",
 		   query->retry);
-	if (gas->current != query || query->retry)
+	if (!query->active || query->retry)
+		return;
+	if (gas->tx_wait && gas->tx_wait != query) {
+		/* Wait for the TX status of the frame to another peer */
+		eloop_register_timeout(0, 10000, gas_query_rx_comeback_timeout,
+				       gas, query);
 		return;
+	}
 	dialog_token = gas_query_new_dialog_token(gas, query->addr);
 	if (dialog_token < 0)
 		return;
@@ -394,10 +464,8 @@ static void gas_query_tx_comeback_req_delay(struct gas_query *gas,
 {
 	unsigned int secs, usecs;
 
-	if (comeback_delay > 1 && query->offchannel_tx_started) {
-		offchannel_send_action_done(gas->wpa_s);
-		query->offchannel_tx_started = 0;
-	}
+	if (comeback_delay > 1)
+		gas_query_offchannel_done(gas, query);
 
 	secs = (comeback_delay * 1024) / 1000000;
 	usecs = comeback_delay * 1024 - secs * 1000000;
@@ -692,8 +760,15 @@ static void gas_query_start_cb(struct wpa_radio_work *work, int deinit)
 
 	if (deinit) {
 		if (work->started) {
+			struct gas_query_pending *q, *n;
+
 			gas->work = NULL;
-			gas_query_done(gas, query, GAS_QUERY_DELETED_AT_DEINIT);
+			dl_list_for_each_safe(q, n, &gas->pending,
+					      struct gas_query_pending, list) {
+				if (q->active)
+					gas_query_done(gas, q,
+						       GAS_QUERY_DELETED_AT_DEINIT);
+			}
 			return;
 		}
 
@@ -713,10 +788,58 @@ static void gas_query_start_cb(struct wpa_radio_work *work, int deinit)
 	}
 
 	gas->work = work;
+	query->active = 1;
+	gas->num_active++;
 	gas_query_tx_initial_req(gas, query);
 }
 
 
+/*
+ * Start the next queued query to the same channel within the ongoing radio
+ * work once the previous frame has been transmitted so that multiple queries
+ * can be in progress during the same off-channel operation.
+ */
+static void gas_query_start_next(struct gas_query *gas)
+{
+	struct wpa_supplicant *wpa_s = gas->wpa_s;
+	struct gas_query_pending *first, *q;
+
+	if (!gas->work || gas->tx_wait ||
+	    gas->num_active >= (unsigned int) wpa_s->conf->gas_max_parallel)
+		return;
+	first = gas->work->ctx;
+	if (!first)
+		return;
+
+	/* The pending list has the most recently added query first */
+	dl_list_for_each_reverse(q, &gas->pending, struct gas_query_pending,
+				 list) {
+		if (q->active || q->freq != first->freq)
+			continue;
+		if (!q->maintain_addr && !wpa_s->conf->gas_rand_mac_addr)
+			os_memcpy(q->sa, wpa_s->own_addr, ETH_ALEN);
+		if (!ether_addr_equal(q->sa, first->sa))
+			continue;
+
+		wpa_printf(MSG_DEBUG,
+			   "GAS: Start query to " MACSTR
+			   " (dialog token %u) within the ongoing radio work (%u active)",
+			   MAC2STR(q->addr), q->dialog_token, gas->num_active);
+		radio_remove_pending_work(wpa_s, q);
+		q->active = 1;
+		gas->num_active++;
+		gas_query_tx_initial_req(gas, q);
+		return;
+	}
+}
+
+
+static void gas_query_start_next_cb(void *eloop_data, void *user_ctx)
+{
+	gas_query_start_next(eloop_data);
+}
+
+
 static void gas_query_tx_initial_req(struct gas_query *gas,
 				     struct gas_query_pending *query)
 {
@@ -896,7 +1019,7 @@ int gas_query_stop(struct gas_query *gas, u8 dialog_token)
 
 	dl_list_for_each(query, &gas->pending, struct gas_query_pending, list) {
 		if (query->dialog_token == dialog_token) {
-			if (!gas->work) {
+			if (!query->active) {
 				/* The pending radio work has not yet been
 				 * started, but the pending entry has a
 				 * reference to the soon to be freed query.
@@ -15,6 +15,7 @@
 #include "common/wpa_ctrl.h"
 #include "utils/pcsc_funcs.h"
 #include "utils/eloop.h"
+#include "crypto/sha256.h"
 #include "drivers/driver.h"
 #include "eap_common/eap_defs.h"
 #include "eap_peer/eap.h"
@@ -46,6 +47,8 @@
 #endif
 
 static void interworking_next_anqp_fetch(struct wpa_supplicant *wpa_s);
+static void interworking_anqp_cache_add(struct wpa_supplicant *wpa_s,
+					struct wpa_bss *bss);
 static struct wpa_cred * interworking_credentials_available_realm(
 	struct wpa_supplicant *wpa_s, struct wpa_bss *bss, int ignore_bw,
 	int *excluded);
@@ -133,8 +136,14 @@ static void interworking_anqp_resp_cb(void *ctx, const u8 *dst,
 	wpa_printf(MSG_DEBUG, "ANQP: Response callback dst=" MACSTR
 		   " dialog_token=%u result=%d status_code=%u",
 		   MAC2STR(dst), dialog_token, result, status_code);
+	if (wpa_s->interworking_anqp_pending)
+		wpa_s->interworking_anqp_pending--;
 	anqp_resp_cb(wpa_s, dst, dialog_token, result, adv_proto, resp,
 		     status_code);
+	if (result == GAS_QUERY_SUCCESS)
+		interworking_anqp_cache_add(wpa_s,
+					    wpa_bss_get_bssid_latest(wpa_s,
+								     dst));
 	interworking_next_anqp_fetch(wpa_s);
 }
 
@@ -244,21 +253,15 @@ static void interworking_continue_anqp(void *eloop_ctx, void *sock_ctx)
 }
 
 
-static int interworking_anqp_send_req(struct wpa_supplicant *wpa_s,
-				      struct wpa_bss *bss)
+static struct wpabuf * interworking_anqp_build_query(
+	struct wpa_supplicant *wpa_s, struct wpa_bss *bss)
 {
 	struct wpabuf *buf;
-	int ret = 0;
-	int res;
 	u16 info_ids[8];
 	size_t num_info_ids = 0;
 	struct wpabuf *extra = NULL;
 	int all = wpa_s->fetch_all_anqp;
 
-	wpa_msg(wpa_s, MSG_DEBUG, "Interworking: ANQP Query Request to " MACSTR,
-		MAC2STR(bss->bssid));
-	wpa_s->interworking_gas_bss = bss;
-
 	info_ids[num_info_ids++] = ANQP_CAPABILITY_LIST;
 	if (all) {
 		info_ids[num_info_ids++] = ANQP_VENUE_NAME;
@@ -271,10 +274,8 @@ static int interworking_anqp_send_req(struct wpa_supplicant *wpa_s,
 		info_ids[num_info_ids++] = ANQP_IP_ADDR_TYPE_AVAILABILITY;
 	if (all || cred_with_nai_realm(wpa_s))
 		info_ids[num_info_ids++] = ANQP_NAI_REALM;
-	if (all || cred_with_3gpp(wpa_s)) {
+	if (all || cred_with_3gpp(wpa_s))
 		info_ids[num_info_ids++] = ANQP_3GPP_CELLULAR_NETWORK;
-		wpa_supplicant_scard_init(wpa_s, NULL);
-	}
 	if (all || cred_with_domain(wpa_s))
 		info_ids[num_info_ids++] = ANQP_DOMAIN_NAME;
 	wpa_hexdump(MSG_DEBUG, "Interworking: ANQP Query info",
@@ -286,7 +287,7 @@ static int interworking_anqp_send_req(struct wpa_supplicant *wpa_s,
 
 		extra = wpabuf_alloc(100);
 		if (!extra)
-			return -1;
+			return NULL;
 
 		len_pos = gas_anqp_add_element(extra, ANQP_VENDOR_SPECIFIC);
 		wpabuf_put_be24(extra, OUI_WFA);
@@ -313,6 +314,26 @@ static int interworking_anqp_send_req(struct wpa_supplicant *wpa_s,
 
 	buf = anqp_build_req(info_ids, num_info_ids, extra);
 	wpabuf_free(extra);
+
+	return buf;
+}
+
+
+static int interworking_anqp_send_req(struct wpa_supplicant *wpa_s,
+				      struct wpa_bss *bss)
+{
+	struct wpabuf *buf;
+	int ret = 0;
+	int res;
+
+	wpa_msg(wpa_s, MSG_DEBUG, "Interworking: ANQP Query Request to " MACSTR,
+		MAC2STR(bss->bssid));
+	wpa_s->interworking_gas_bss = bss;
+
+	if (wpa_s->fetch_all_anqp || cred_with_3gpp(wpa_s))
+		wpa_supplicant_scard_init(wpa_s, NULL);
+
+	buf = interworking_anqp_build_query(wpa_s, bss);
 	if (buf == NULL)
 		return -1;
 
@@ -324,9 +345,13 @@ static int interworking_anqp_send_req(struct wpa_supplicant *wpa_s,
 		ret = -1;
 		eloop_register_timeout(0, 0, interworking_continue_anqp, wpa_s,
 				       NULL);
-	} else
+	} else {
 		wpa_msg(wpa_s, MSG_DEBUG,
 			"ANQP: Query started with dialog token %u", res);
+		wpa_s->interworking_anqp_pending++;
+		wpa_s->interworking_anqp_freq = bss->freq;
+		wpa_s->anqp_fetch_stats.queries++;
+	}
 
 	return ret;
 }
@@ -604,6 +629,309 @@ static int nai_realm_match(struct nai_realm *realm, const char *home_realm)
 }
 
 
+/*
+ * Parsed form of the ANQP elements that are used for matching credentials.
+ * This is built on first use and stored with the ANQP data, so each element is
+ * parsed once and then shared by all BSS entries that share the ANQP data,
+ * instead of being parsed again for every credential and selection round. The
+ * realm names, OIs, and PLMN IDs are sorted for lookup with binary search.
+ */
+struct interworking_realm_name {
+	char *name;
+	u16 realm; /* index to the parsed NAI Realm list */
+};
+
+struct interworking_oi {
+	u8 len;
+	u8 oi[MAX_ROAMING_CONS_OI_LEN];
+};
+
+struct interworking_anqp_parsed {
+	struct nai_realm *realm;
+	u16 realm_count;
+	/* Realm names split on ';', sorted case insensitively */
+	struct interworking_realm_name *names;
+	size_t num_names;
+	/* ANQP Roaming Consortium OIs that fit in a credential */
+	struct interworking_oi *ois;
+	size_t num_ois;
+	/* 3GPP PLMN IDs, 3 octets each */
+	u8 *plmn;
+	size_t num_plmn;
+};
+
+
+void interworking_anqp_parsed_free(struct interworking_anqp_parsed *parsed)
+{
+	size_t i;
+
+	if (!parsed)
+		return;
+	nai_realm_free(parsed->realm, parsed->realm_count);
+	for (i = 0; i < parsed->num_names; i++)
+		os_free(parsed->names[i].name);
+	os_free(parsed->names);
+	os_free(parsed->ois);
+	os_free(parsed->plmn);
+	os_free(parsed);
+}
+
+
+static int realm_name_cmp(const void *a, const void *b)
+{
+	const struct interworking_realm_name *n1 = a, *n2 = b;
+	int res;
+
+	res = os_strcasecmp(n1->name, n2->name);
+	if (res)
+		return res;
+	return (int) n1->realm - (int) n2->realm;
+}
+
+
+static int interworking_parse_realm_names(struct interworking_anqp_parsed *p)
+{
+	const char *pos, *end;
+	size_t num = 0;
+	char *name;
+	u16 i;
+
+	for (i = 0; i < p->realm_count; i++) {
+		num++;
+		for (pos = p->realm[i].realm; pos && *pos; pos++) {
+			if (*pos == ';')
+				num++;
+		}
+	}
+	if (num == 0)
+		return 0;
+
+	p->names = os_calloc(num, sizeof(*p->names));
+	if (!p->names)
+		return -1;
+
+	/* Same split as in nai_realm_match() */
+	for (i = 0; i < p->realm_count; i++) {
+		pos = p->realm[i].realm;
+		if (!pos)
+			continue;
+		do {
+			end = os_strchr(pos, ';');
+			name = end ? dup_binstr(pos, end - pos) : os_strdup(pos);
+			if (!name)
+				return -1;
+			p->names[p->num_names].name = name;
+			p->names[p->num_names].realm = i;
+			p->num_names++;
+			if (!end)
+				break;
+			pos = end + 1;
+		} while (*pos);
+	}
+
+	qsort(p->names, p->num_names, sizeof(p->names[0]), realm_name_cmp);
+	return 0;
+}
+
+
+static size_t realm_name_lower_bound(const struct interworking_anqp_parsed *p,
+				     const char *name)
+{
+	size_t low = 0, high = p->num_names, mid;
+
+	while (low < high) {
+		mid = low + (high - low) / 2;
+		if (os_strcasecmp(p->names[mid].name, name) < 0)
+			low = mid + 1;
+		else
+			high = mid;
+	}
+
+	return low;
+}
+
+
+static int oi_cmp(const void *a, const void *b)
+{
+	const struct interworking_oi *o1 = a, *o2 = b;
+
+	if (o1->len != o2->len)
+		return (int) o1->len - (int) o2->len;
+	return os_memcmp(o1->oi, o2->oi, o1->len);
+}
+
+
+static int interworking_parse_ois(struct interworking_anqp_parsed *p,
+				  const struct wpabuf *anqp)
+{
+	const u8 *pos, *end;
+	size_t num = 0;
+	u8 len;
+
+	if (!anqp)
+		return 0;
+
+	pos = wpabuf_head(anqp);
+	end = pos + wpabuf_len(anqp);
+	p->ois = os_calloc(wpabuf_len(anqp), sizeof(*p->ois));
+	if (!p->ois)
+		return wpabuf_len(anqp) ? -1 : 0;
+
+	/* Set of <OI Length, OI> duples */
+	while (pos < end) {
+		len = *pos++;
+		if (len > end - pos)
+			break;
+		if (len <= MAX_ROAMING_CONS_OI_LEN) {
+			p->ois[num].len = len;
+			os_memcpy(p->ois[num].oi, pos, len);
+			num++;
+		}
+		pos += len;
+	}
+
+	p->num_ois = num;
+	qsort(p->ois, num, sizeof(p->ois[0]), oi_cmp);
+	return 0;
+}
+
+
+#ifdef INTERWORKING_3GPP
+
+static int plmn_cmp(const void *a, const void *b)
+{
+	return os_memcmp(a, b, 3);
+}
+
+
+static int interworking_parse_plmn(struct interworking_anqp_parsed *p,
+				   const struct wpabuf *anqp)
+{
+	const u8 *pos, *end;
+	u8 udhl;
+
+	/* See Annex A of 3GPP TS 24.234 v8.1.0 for description */
+	if (anqp == NULL)
+		return 0;
+	pos = wpabuf_head_u8(anqp);
+	end = pos + wpabuf_len(anqp);
+	if (end - pos < 2)
+		return 0;
+	if (*pos != 0) {
+		wpa_printf(MSG_DEBUG, "Unsupported GUD version 0x%x", *pos);
+		return 0;
+	}
+	pos++;
+	udhl = *pos++;
+	if (udhl > end - pos) {
+		wpa_printf(MSG_DEBUG, "Invalid UDHL");
+		return 0;
+	}
+	end = pos + udhl;
+
+	p->plmn = os_malloc(udhl);
+	if (!p->plmn)
+		return udhl ? -1 : 0;
+
+	while (end - pos >= 2) {
+		u8 iei, len;
+		const u8 *l_end;
+		iei = *pos++;
+		len = *pos++ & 0x7f;
+		if (len > end - pos)
+			break;
+		l_end = pos + len;
+
+		if (iei == 0 && len > 0) {
+			/* PLMN List */
+			u8 num, i;
+			wpa_hexdump(MSG_DEBUG, "Interworking: PLMN List information element",
+				    pos, len);
+			num = *pos++;
+			for (i = 0; i < num; i++) {
+				if (l_end - pos < 3)
+					break;
+				os_memcpy(&p->plmn[p->num_plmn * 3], pos, 3);
+				p->num_plmn++;
+				pos += 3;
+			}
+		} else {
+			wpa_hexdump(MSG_DEBUG, "Interworking: Unrecognized 3GPP information element",
+				    pos, len);
+		}
+
+		pos = l_end;
+	}
+
+	qsort(p->plmn, p->num_plmn, 3, plmn_cmp);
+	return 0;
+}
+
+static int plmn_list_contains(const struct interworking_anqp_parsed *p,
+			      const u8 *plmn)
+{
+	size_t low = 0, high = p->num_plmn, mid;
+	int res;
+
+	while (low < high) {
+		mid = low + (high - low) / 2;
+		res = os_memcmp(&p->plmn[mid * 3], plmn, 3);
+		if (res == 0)
+			return 1;
+		if (res < 0)
+			low = mid + 1;
+		else
+			high = mid;
+	}
+
+	return 0;
+}
+
+#endif /* INTERWORKING_3GPP */
+
+
+static struct interworking_anqp_parsed *
+interworking_anqp_get_parsed(struct wpa_bss *bss)
+{
+	struct wpa_bss_anqp *anqp = bss->anqp;
+	struct interworking_anqp_parsed *p;
+
+	if (!anqp)
+		return NULL;
+	if (anqp->parsed)
+		return anqp->parsed;
+
+	p = os_zalloc(sizeof(*p));
+	if (!p)
+		return NULL;
+
+	p->realm = nai_realm_parse(anqp->nai_realm, &p->realm_count);
+	if (!p->realm)
+		p->realm_count = 0;
+	if (interworking_parse_realm_names(p) < 0 ||
+	    interworking_parse_ois(p, anqp->roaming_consortium) < 0)
+		goto fail;
+#ifdef INTERWORKING_3GPP
+	if (interworking_parse_plmn(p, anqp->anqp_3gpp) < 0)
+		goto fail;
+#endif /* INTERWORKING_3GPP */
+
+	anqp->parsed = p;
+	return p;
+
+fail:
+	interworking_anqp_parsed_free(p);
+	return NULL;
+}
+
+
+static void interworking_anqp_parsed_reset(struct wpa_bss_anqp *anqp)
+{
+	interworking_anqp_parsed_free(anqp->parsed);
+	anqp->parsed = NULL;
+}
+
+
 static int nai_realm_cred_username(struct wpa_supplicant *wpa_s,
 				   struct nai_realm_eap *eap)
 {
@@ -735,11 +1063,10 @@ static struct nai_realm_eap * nai_realm_find_eap(struct wpa_supplicant *wpa_s,
 
 #ifdef INTERWORKING_3GPP
 
-static int plmn_id_match(struct wpabuf *anqp, const char *imsi, int mnc_len)
+static int plmn_id_match(const struct interworking_anqp_parsed *parsed,
+			 const char *imsi, int mnc_len)
 {
 	u8 plmn[3], plmn2[3];
-	const u8 *pos, *end;
-	u8 udhl;
 
 	/*
 	 * See Annex A of 3GPP TS 24.234 v8.1.0 for description. The network
@@ -761,60 +1088,15 @@ static int plmn_id_match(struct wpabuf *anqp, const char *imsi, int mnc_len)
 	plmn2[1] = (imsi[2] - '0') | 0xf0;
 	plmn2[2] = (imsi[3] - '0') | ((imsi[4] - '0') << 4);
 
-	if (anqp == NULL)
-		return 0;
-	pos = wpabuf_head_u8(anqp);
-	end = pos + wpabuf_len(anqp);
-	if (end - pos < 2)
-		return 0;
-	if (*pos != 0) {
-		wpa_printf(MSG_DEBUG, "Unsupported GUD version 0x%x", *pos);
-		return 0;
-	}
-	pos++;
-	udhl = *pos++;
-	if (udhl > end - pos) {
-		wpa_printf(MSG_DEBUG, "Invalid UDHL");
+	if (parsed == NULL)
 		return 0;
-	}
-	end = pos + udhl;
 
 	wpa_printf(MSG_DEBUG, "Interworking: Matching against MCC/MNC alternatives: %02x:%02x:%02x or %02x:%02x:%02x (IMSI %s, MNC length %d)",
 		   plmn[0], plmn[1], plmn[2], plmn2[0], plmn2[1], plmn2[2],
 		   imsi, mnc_len);
 
-	while (end - pos >= 2) {
-		u8 iei, len;
-		const u8 *l_end;
-		iei = *pos++;
-		len = *pos++ & 0x7f;
-		if (len > end - pos)
-			break;
-		l_end = pos + len;
-
-		if (iei == 0 && len > 0) {
-			/* PLMN List */
-			u8 num, i;
-			wpa_hexdump(MSG_DEBUG, "Interworking: PLMN List information element",
-				    pos, len);
-			num = *pos++;
-			for (i = 0; i < num; i++) {
-				if (l_end - pos < 3)
-					break;
-				if (os_memcmp(pos, plmn, 3) == 0 ||
-				    os_memcmp(pos, plmn2, 3) == 0)
-					return 1; /* Found matching PLMN */
-				pos += 3;
-			}
-		} else {
-			wpa_hexdump(MSG_DEBUG, "Interworking: Unrecognized 3GPP information element",
-				    pos, len);
-		}
-
-		pos = l_end;
-	}
-
-	return 0;
+	return plmn_list_contains(parsed, plmn) ||
+		plmn_list_contains(parsed, plmn2);
 }
 
 
@@ -1144,33 +1426,37 @@ static int oi_element_match(const u8 *ie, const u8 *oi, size_t oi_len)
 }
 
 
-static int oi_anqp_match(const struct wpabuf *anqp, const u8 *oi,
-			 size_t oi_len)
+static int oi_anqp_match(const struct interworking_anqp_parsed *parsed,
+			 const u8 *oi, size_t oi_len)
 {
-	const u8 *pos, *end;
-	u8 len;
+	struct interworking_oi key;
+	size_t low, high, mid;
+	int res;
 
-	if (anqp == NULL)
+	if (parsed == NULL || oi_len > MAX_ROAMING_CONS_OI_LEN)
 		return 0;
 
-	pos = wpabuf_head(anqp);
-	end = pos + wpabuf_len(anqp);
-
-	/* Set of <OI Length, OI> duples */
-	while (pos < end) {
-		len = *pos++;
-		if (len > end - pos)
-			break;
-		if (len == oi_len && os_memcmp(pos, oi, oi_len) == 0)
+	key.len = oi_len;
+	os_memcpy(key.oi, oi, oi_len);
+	low = 0;
+	high = parsed->num_ois;
+	while (low < high) {
+		mid = low + (high - low) / 2;
+		res = oi_cmp(&parsed->ois[mid], &key);
+		if (res == 0)
 			return 1;
-		pos += len;
+		if (res < 0)
+			low = mid + 1;
+		else
+			high = mid;
 	}
 
 	return 0;
 }
 
 
-static int oi_match(const u8 *ie, const struct wpabuf *anqp,
+static int oi_match(const u8 *ie,
+		    const struct interworking_anqp_parsed *anqp,
 		    const u8 *oi, size_t oi_len)
 {
 	return oi_element_match(ie, oi, oi_len) ||
@@ -1178,7 +1464,8 @@ static int oi_match(const u8 *ie, const struct wpabuf *anqp,
 }
 
 
-static int cred_home_ois_match(const u8 *ie, const struct wpabuf *anqp,
+static int cred_home_ois_match(const u8 *ie,
+			       const struct interworking_anqp_parsed *anqp,
 			       const struct wpa_cred *cred) {
 	unsigned int i;
 
@@ -1193,9 +1480,9 @@ static int cred_home_ois_match(const u8 *ie, const struct wpabuf *anqp,
 }
 
 
-static int cred_roaming_consortiums_match(const u8 *ie,
-					  const struct wpabuf *anqp,
-					  const struct wpa_cred *cred)
+static int cred_roaming_consortiums_match(
+	const u8 *ie, const struct interworking_anqp_parsed *anqp,
+	const struct wpa_cred *cred)
 {
 	unsigned int i;
 
@@ -1211,6 +1498,7 @@ static int cred_roaming_consortiums_match(const u8 *ie,
 
 static int cred_no_required_oi_match(struct wpa_cred *cred, struct wpa_bss *bss)
 {
+	const struct interworking_anqp_parsed *anqp;
 	const u8 *ie;
 	unsigned int i;
 
@@ -1225,10 +1513,9 @@ static int cred_no_required_oi_match(struct wpa_cred *cred, struct wpa_bss *bss)
 
 	/* According to Passpoint specification, there must be a match for
 	 * each required home OI provided. */
+	anqp = interworking_anqp_get_parsed(bss);
 	for (i = 0; i < cred->num_required_home_ois; i++) {
-		if (!oi_match(ie, bss->anqp ?
-			      bss->anqp->roaming_consortium : NULL,
-			      cred->required_home_ois[i],
+		if (!oi_match(ie, anqp, cred->required_home_ois[i],
 			      cred->required_home_ois_len[i]))
 			return 1;
 	}
@@ -1419,18 +1706,19 @@ static struct wpa_cred * interworking_credentials_available_roaming_consortium(
 {
 	struct wpa_cred *cred, *selected = NULL;
 	const u8 *ie;
-	const struct wpabuf *anqp;
+	const struct interworking_anqp_parsed *anqp;
 	int is_excluded = 0;
 
 	ie = wpa_bss_get_ie(bss, WLAN_EID_ROAMING_CONSORTIUM);
-	anqp = bss->anqp ? bss->anqp->roaming_consortium : NULL;
 
-	if (!ie && !anqp)
+	if (!ie && (!bss->anqp || !bss->anqp->roaming_consortium))
 		return NULL;
 
 	if (wpa_s->conf->cred == NULL)
 		return NULL;
 
+	anqp = interworking_anqp_get_parsed(bss);
+
 	for (cred = wpa_s->conf->cred; cred; cred = cred->next) {
 		if (cred->num_home_ois == 0 &&
 		    cred->num_required_home_ois == 0 &&
@@ -1630,7 +1918,7 @@ static int interworking_connect_roaming_consortium(
 {
 	struct wpa_ssid *ssid;
 	const u8 *ie;
-	const struct wpabuf *anqp;
+	const struct interworking_anqp_parsed *anqp;
 	unsigned int i;
 
 	wpa_msg(wpa_s, MSG_DEBUG, "Interworking: Connect with " MACSTR
@@ -1663,7 +1951,7 @@ static int interworking_connect_roaming_consortium(
 
 #ifdef CONFIG_HS20
 	ie = wpa_bss_get_ie(bss, WLAN_EID_ROAMING_CONSORTIUM);
-	anqp = bss->anqp ? bss->anqp->roaming_consortium : NULL;
+	anqp = interworking_anqp_get_parsed(bss);
 	for (i = 0; (ie || anqp) && i < cred->num_roaming_consortiums; i++) {
 		if (!oi_match(ie, anqp, cred->roaming_consortiums[i],
 			      cred->roaming_consortiums_len[i]))
@@ -2000,6 +2288,7 @@ static struct wpa_cred * interworking_credentials_available_3gpp(
 	struct wpa_cred *selected = NULL;
 #ifdef INTERWORKING_3GPP
 	struct wpa_cred *cred;
+	const struct interworking_anqp_parsed *parsed;
 	int ret;
 	int is_excluded = 0;
 
@@ -2030,6 +2319,8 @@ static struct wpa_cred * interworking_credentials_available_3gpp(
 	}
 #endif /* CONFIG_EAP_PROXY */
 
+	parsed = interworking_anqp_get_parsed(bss);
+
 	for (cred = wpa_s->conf->cred; cred; cred = cred->next) {
 		char *sep;
 		const char *imsi;
@@ -2079,7 +2370,7 @@ static struct wpa_cred * interworking_credentials_available_3gpp(
 		wpa_msg(wpa_s, MSG_DEBUG,
 			"Interworking: Parsing 3GPP info from " MACSTR,
 			MAC2STR(bss->bssid));
-		ret = plmn_id_match(bss->anqp->anqp_3gpp, imsi, mnc_len);
+		ret = plmn_id_match(parsed, imsi, mnc_len);
 		wpa_msg(wpa_s, MSG_DEBUG, "PLMN match %sfound",
 			ret ? "" : "not ");
 		if (ret) {
@@ -2123,8 +2414,10 @@ static struct wpa_cred * interworking_credentials_available_realm(
 	int *excluded)
 {
 	struct wpa_cred *cred, *selected = NULL;
+	struct interworking_anqp_parsed *parsed;
 	struct nai_realm *realm;
-	u16 count, i;
+	size_t j;
+	int i, prev;
 	int is_excluded = 0;
 
 	if (bss->anqp == NULL || bss->anqp->nai_realm == NULL)
@@ -2135,21 +2428,33 @@ static struct wpa_cred * interworking_credentials_available_realm(
 
 	wpa_msg(wpa_s, MSG_DEBUG, "Interworking: Parsing NAI Realm list from "
 		MACSTR, MAC2STR(bss->bssid));
-	realm = nai_realm_parse(bss->anqp->nai_realm, &count);
-	if (realm == NULL) {
+	parsed = interworking_anqp_get_parsed(bss);
+	if (parsed == NULL || parsed->realm == NULL) {
 		wpa_msg(wpa_s, MSG_DEBUG,
 			"Interworking: Could not parse NAI Realm list from "
 			MACSTR, MAC2STR(bss->bssid));
 		return NULL;
 	}
+	realm = parsed->realm;
 
 	for (cred = wpa_s->conf->cred; cred; cred = cred->next) {
 		if (cred->realm == NULL)
 			continue;
 
-		for (i = 0; i < count; i++) {
-			if (!nai_realm_match(&realm[i], cred->realm))
+		/*
+		 * Visit the NAI Realm entries with a name matching the
+		 * credential in the order they appear in the list.
+		 */
+		prev = -1;
+		for (j = realm_name_lower_bound(parsed, cred->realm);
+		     j < parsed->num_names &&
+			     os_strcasecmp(parsed->names[j].name,
+					   cred->realm) == 0;
+		     j++) {
+			i = parsed->names[j].realm;
+			if (i == prev)
 				continue;
+			prev = i;
 			if (nai_realm_find_eap(wpa_s, cred, &realm[i])) {
 				if (cred_no_required_oi_match(cred, bss))
 					continue;
@@ -2185,8 +2490,6 @@ static struct wpa_cred * interworking_credentials_available_realm(
 		}
 	}
 
-	nai_realm_free(realm, count);
-
 	if (excluded)
 		*excluded = is_excluded;
 
@@ -2692,6 +2995,312 @@ interworking_match_anqp_info(struct wpa_supplicant *wpa_s, struct wpa_bss *bss)
 }
 
 
+/*
+ * Global cache of ANQP responses. All BSSs of a homogeneous ESS that advertise
+ * the same ANQP Domain ID have identical ANQP information, so the response from
+ * one of them can be used for the others and for later fetches on any
+ * interface until the entry expires.
+ */
+struct interworking_anqp_cache_key {
+	u8 hessid[ETH_ALEN]; /* HESSID or BSSID if no HESSID is advertised */
+	int domain_id; /* ANQP Domain ID or -1 if not advertised */
+	u8 hash[SHA256_MAC_LEN]; /* ANQP related elements and the query */
+};
+
+struct interworking_anqp_cache_entry {
+	struct dl_list list;
+	struct interworking_anqp_cache_key key;
+	struct os_reltime fetched;
+	struct wpa_bss_anqp *anqp;
+};
+
+
+static int interworking_anqp_cache_key(struct wpa_supplicant *wpa_s,
+				       struct wpa_bss *bss,
+				       struct interworking_anqp_cache_key *key)
+{
+	const u8 *addr[5], *ie, *pos, *end;
+	size_t len[5], num = 0;
+	struct wpabuf *query;
+	int ret;
+
+	if (!is_zero_ether_addr(bss->hessid))
+		os_memcpy(key->hessid, bss->hessid, ETH_ALEN);
+	else
+		os_memcpy(key->hessid, bss->bssid, ETH_ALEN);
+
+	key->domain_id = -1;
+	ie = wpa_bss_get_vendor_ie(bss, HS20_IE_VENDOR_TYPE);
+	if (ie && ie[1] >= 5) {
+		pos = ie + 7;
+		end = ie + 2 + ie[1];
+		if (ie[6] & HS20_PPS_MO_ID_PRESENT)
+			pos += 2;
+		if ((ie[6] & HS20_ANQP_DOMAIN_ID_PRESENT) && end - pos >= 2)
+			key->domain_id = WPA_GET_LE16(pos);
+	}
+
+	addr[num] = bss->ssid;
+	len[num++] = bss->ssid_len;
+	if (ie) {
+		addr[num] = ie;
+		len[num++] = 2 + ie[1];
+	}
+	ie = wpa_bss_get_ie(bss, WLAN_EID_INTERWORKING);
+	if (ie) {
+		addr[num] = ie;
+		len[num++] = 2 + ie[1];
+	}
+	ie = wpa_bss_get_ie(bss, WLAN_EID_ROAMING_CONSORTIUM);
+	if (ie) {
+		addr[num] = ie;
+		len[num++] = 2 + ie[1];
+	}
+
+	query = interworking_anqp_build_query(wpa_s, bss);
+	if (!query)
+		return -1;
+	addr[num] = wpabuf_head(query);
+	len[num++] = wpabuf_len(query);
+	ret = sha256_vector(num, addr, len, key->hash);
+	wpabuf_free(query);
+
+	return ret;
+}
+
+
+static void interworking_anqp_cache_free(
+	struct interworking_anqp_cache_entry *entry)
+{
+	dl_list_del(&entry->list);
+	wpa_bss_anqp_free(entry->anqp);
+	os_free(entry);
+}
+
+
+/**
+ * interworking_anqp_cache_flush - Remove all cached ANQP responses
+ * @global: Pointer to global data from wpa_supplicant_init()
+ */
+void interworking_anqp_cache_flush(struct wpa_global *global)
+{
+	struct interworking_anqp_cache_entry *entry, *n;
+
+	dl_list_for_each_safe(entry, n, &global->anqp_cache,
+			      struct interworking_anqp_cache_entry, list)
+		interworking_anqp_cache_free(entry);
+}
+
+
+static void interworking_anqp_cache_expire(struct wpa_supplicant *wpa_s)
+{
+	struct interworking_anqp_cache_entry *entry, *n;
+	struct os_reltime now;
+
+	os_get_reltime(&now);
+	dl_list_for_each_safe(entry, n, &wpa_s->global->anqp_cache,
+			      struct interworking_anqp_cache_entry, list) {
+		if (os_reltime_expired(&now, &entry->fetched,
+				       wpa_s->conf->anqp_cache_ttl))
+			interworking_anqp_cache_free(entry);
+	}
+}
+
+
+static struct interworking_anqp_cache_entry *
+interworking_anqp_cache_find(struct wpa_supplicant *wpa_s,
+			     const struct interworking_anqp_cache_key *key)
+{
+	struct interworking_anqp_cache_entry *entry;
+
+	dl_list_for_each(entry, &wpa_s->global->anqp_cache,
+			 struct interworking_anqp_cache_entry, list) {
+		if (ether_addr_equal(entry->key.hessid, key->hessid) &&
+		    entry->key.domain_id == key->domain_id)
+			return entry;
+	}
+
+	return NULL;
+}
+
+
+static int interworking_anqp_cache_get(struct wpa_supplicant *wpa_s,
+				       struct wpa_bss *bss)
+{
+	struct interworking_anqp_cache_key key;
+	struct interworking_anqp_cache_entry *entry;
+
+	if (!wpa_s->conf->anqp_cache_ttl)
+		return 0;
+
+	interworking_anqp_cache_expire(wpa_s);
+	if (interworking_anqp_cache_key(wpa_s, bss, &key) < 0)
+		return 0;
+	entry = interworking_anqp_cache_find(wpa_s, &key);
+	if (!entry ||
+	    os_memcmp(entry->key.hash, key.hash, SHA256_MAC_LEN) != 0) {
+		/* Do not update a cached response with the new one */
+		wpa_bss_anqp_unshare_alloc(bss);
+		return 0;
+	}
+
+	if (bss->anqp != entry->anqp) {
+		wpa_bss_anqp_free(bss->anqp);
+		entry->anqp->users++;
+		bss->anqp = entry->anqp;
+	}
+	dl_list_del(&entry->list);
+	dl_list_add(&wpa_s->global->anqp_cache, &entry->list);
+
+	wpa_msg(wpa_s, MSG_DEBUG,
+		"Interworking: Use cached ANQP data for " MACSTR
+		" (HESSID " MACSTR ")",
+		MAC2STR(bss->bssid), MAC2STR(key.hessid));
+	return 1;
+}
+
+
+static void interworking_anqp_cache_add(struct wpa_supplicant *wpa_s,
+					struct wpa_bss *bss)
+{
+	struct interworking_anqp_cache_key key;
+	struct interworking_anqp_cache_entry *entry;
+	unsigned int count;
+
+	if (!wpa_s->conf->anqp_cache_ttl || !bss || !bss->anqp ||
+	    (!bss->anqp->capability_list &&
+	     !bss->anqp->roaming_consortium &&
+	     !bss->anqp->nai_realm &&
+	     !bss->anqp->anqp_3gpp &&
+	     !bss->anqp->domain_name))
+		return;
+
+	if (interworking_anqp_cache_key(wpa_s, bss, &key) < 0)
+		return;
+
+	entry = interworking_anqp_cache_find(wpa_s, &key);
+	if (entry) {
+		dl_list_del(&entry->list);
+		wpa_bss_anqp_free(entry->anqp);
+	} else {
+		entry = os_zalloc(sizeof(*entry));
+		if (!entry)
+			return;
+	}
+	os_memcpy(&entry->key, &key, sizeof(key));
+	os_get_reltime(&entry->fetched);
+	bss->anqp->users++;
+	entry->anqp = bss->anqp;
+	dl_list_add(&wpa_s->global->anqp_cache, &entry->list);
+
+	count = dl_list_len(&wpa_s->global->anqp_cache);
+	while (count-- > (unsigned int) wpa_s->conf->anqp_cache_size) {
+		entry = dl_list_last(&wpa_s->global->anqp_cache,
+				     struct interworking_anqp_cache_entry,
+				     list);
+		interworking_anqp_cache_free(entry);
+	}
+}
+
+
+/*
+ * Find the next BSS to which an ANQP query needs to be sent; optionally only
+ * on the specified channel.
+ */
+static struct wpa_bss * interworking_next_anqp_bss(struct wpa_supplicant *wpa_s,
+						   int freq)
+{
+	struct wpa_bss *bss;
+
+	dl_list_for_each(bss, &wpa_s->bss, struct wpa_bss, list) {
+		if (!(bss->caps & IEEE80211_CAP_ESS))
+			continue;
+		if (!wpa_bss_ext_capab(bss, WLAN_EXT_CAPAB_INTERWORKING))
+			continue; /* AP does not support Interworking */
+		if (disallowed_bssid(wpa_s, bss->bssid) ||
+		    disallowed_ssid(wpa_s, bss->ssid, bss->ssid_len))
+			continue; /* Disallowed BSS */
+		if (bss->flags & WPA_BSS_ANQP_FETCH_TRIED)
+			continue;
+		if (freq && bss->freq != freq)
+			continue;
+
+		if (bss->anqp == NULL) {
+			bss->anqp = interworking_match_anqp_info(wpa_s, bss);
+			if (bss->anqp) {
+				/* Shared data already fetched */
+				continue;
+			}
+			bss->anqp = wpa_bss_anqp_alloc();
+			if (bss->anqp == NULL)
+				return NULL;
+		}
+		if (interworking_anqp_cache_get(wpa_s, bss)) {
+			bss->flags |= WPA_BSS_ANQP_FETCH_TRIED;
+			wpa_s->anqp_fetch_stats.cached++;
+			continue;
+		}
+		return bss;
+	}
+
+	return NULL;
+}
+
+
+static void interworking_anqp_fetch_done(struct wpa_supplicant *wpa_s)
+{
+	struct os_reltime now, diff;
+	unsigned int ms;
+
+	os_get_reltime(&now);
+	os_reltime_sub(&now, &wpa_s->anqp_fetch_stats.start, &diff);
+	ms = diff.sec * 1000 + diff.usec / 1000;
+
+	wpa_s->anqp_fetch_stats.rounds++;
+	wpa_s->anqp_fetch_stats.last_ms = ms;
+	wpa_s->anqp_fetch_stats.total_ms += ms;
+	if (ms > wpa_s->anqp_fetch_stats.max_ms)
+		wpa_s->anqp_fetch_stats.max_ms = ms;
+	wpa_s->anqp_fetch_stats.last_queries = wpa_s->anqp_fetch_stats.queries;
+	wpa_s->anqp_fetch_stats.last_cached = wpa_s->anqp_fetch_stats.cached;
+
+	wpa_printf(MSG_DEBUG,
+		   "Interworking: ANQP fetch took %u ms (queries=%u cached=%u)",
+		   ms, wpa_s->anqp_fetch_stats.queries,
+		   wpa_s->anqp_fetch_stats.cached);
+}
+
+
+/**
+ * interworking_anqp_fetch_stats - Write ANQP fetch statistics
+ * @wpa_s: Pointer to wpa_supplicant data
+ * @buf: Buffer for the statistics
+ * @buflen: Length of the buffer
+ * Returns: Number of characters written
+ */
+int interworking_anqp_fetch_stats(struct wpa_supplicant *wpa_s, char *buf,
+				  size_t buflen)
+{
+	int ret;
+
+	ret = os_snprintf(buf, buflen,
+			  "rounds=%u\nlast_ms=%u\nmax_ms=%u\navg_ms=%llu\n"
+			  "last_queries=%u\nlast_cached=%u\n",
+			  wpa_s->anqp_fetch_stats.rounds,
+			  wpa_s->anqp_fetch_stats.last_ms,
+			  wpa_s->anqp_fetch_stats.max_ms,
+			  wpa_s->anqp_fetch_stats.rounds ?
+			  (unsigned long long)
+			  (wpa_s->anqp_fetch_stats.total_ms /
+			   wpa_s->anqp_fetch_stats.rounds) : 0ULL,
+			  wpa_s->anqp_fetch_stats.last_queries,
+			  wpa_s->anqp_fetch_stats.last_cached);
+	if (os_snprintf_error(buflen, ret))
+		return 0;
+	return ret;
+}
+
+
 static void interworking_next_anqp_fetch(struct wpa_supplicant *wpa_s)
 {
 	struct wpa_bss *bss;
@@ -2715,38 +3324,32 @@ static void interworking_next_anqp_fetch(struct wpa_supplicant *wpa_s)
 	}
 #endif /* CONFIG_HS20 */
 
-	dl_list_for_each(bss, &wpa_s->bss, struct wpa_bss, list) {
-		if (!(bss->caps & IEEE80211_CAP_ESS))
-			continue;
-		if (!wpa_bss_ext_capab(bss, WLAN_EXT_CAPAB_INTERWORKING))
-			continue; /* AP does not support Interworking */
-		if (disallowed_bssid(wpa_s, bss->bssid) ||
-		    disallowed_ssid(wpa_s, bss->ssid, bss->ssid_len))
-			continue; /* Disallowed BSS */
-
-		if (!(bss->flags & WPA_BSS_ANQP_FETCH_TRIED)) {
-			if (bss->anqp == NULL) {
-				bss->anqp = interworking_match_anqp_info(wpa_s,
-									 bss);
-				if (bss->anqp) {
-					/* Shared data already fetched */
-					continue;
-				}
-				bss->anqp = wpa_bss_anqp_alloc();
-				if (bss->anqp == NULL)
-					break;
-			}
-			found++;
-			bss->flags |= WPA_BSS_ANQP_FETCH_TRIED;
-			wpa_msg(wpa_s, MSG_INFO, "Starting ANQP fetch for "
-				MACSTR " (HESSID " MACSTR ")",
-				MAC2STR(bss->bssid), MAC2STR(bss->hessid));
-			interworking_anqp_send_req(wpa_s, bss);
+	/*
+	 * Keep up to gas_max_parallel queries outstanding. Prefer BSSs on the
+	 * channel of the ongoing queries so that the GAS queries can be sent
+	 * within the same off-channel operation.
+	 */
+	while (wpa_s->interworking_anqp_pending <
+	       (unsigned int) wpa_s->conf->gas_max_parallel) {
+		bss = NULL;
+		if (wpa_s->interworking_anqp_pending)
+			bss = interworking_next_anqp_bss(
+				wpa_s, wpa_s->interworking_anqp_freq);
+		if (!bss)
+			bss = interworking_next_anqp_bss(wpa_s, 0);
+		if (!bss)
 			break;
-		}
+
+		found++;
+		bss->flags |= WPA_BSS_ANQP_FETCH_TRIED;
+		wpa_msg(wpa_s, MSG_INFO, "Starting ANQP fetch for "
+			MACSTR " (HESSID " MACSTR ")",
+			MAC2STR(bss->bssid), MAC2STR(bss->hessid));
+		if (interworking_anqp_send_req(wpa_s, bss) < 0)
+			break; /* continue from interworking_continue_anqp() */
 	}
 
-	if (found == 0) {
+	if (found == 0 && wpa_s->interworking_anqp_pending == 0) {
 #ifdef CONFIG_HS20
 		if (wpa_s->fetch_osu_info) {
 			if (wpa_s->num_prov_found == 0 &&
@@ -2761,6 +3364,7 @@ static void interworking_next_anqp_fetch(struct wpa_supplicant *wpa_s)
 			return;
 		}
 #endif /* CONFIG_HS20 */
+		interworking_anqp_fetch_done(wpa_s);
 		wpa_msg(wpa_s, MSG_INFO, "ANQP fetch completed");
 		wpa_s->fetch_anqp_in_progress = 0;
 		if (wpa_s->network_select)
@@ -2777,6 +3381,9 @@ void interworking_start_fetch_anqp(struct wpa_supplicant *wpa_s)
 		bss->flags &= ~WPA_BSS_ANQP_FETCH_TRIED;
 
 	wpa_s->fetch_anqp_in_progress = 1;
+	os_get_reltime(&wpa_s->anqp_fetch_stats.start);
+	wpa_s->anqp_fetch_stats.queries = 0;
+	wpa_s->anqp_fetch_stats.cached = 0;
 
 	/*
 	 * Start actual ANQP operation from eloop call to make sure the loop
@@ -3004,6 +3611,7 @@ static void interworking_parse_rx_anqp_resp(struct wpa_supplicant *wpa_s,
 		if (anqp) {
 			wpabuf_free(anqp->roaming_consortium);
 			anqp->roaming_consortium = wpabuf_alloc_copy(pos, slen);
+			interworking_anqp_parsed_reset(anqp);
 		}
 		break;
 	case ANQP_IP_ADDR_TYPE_AVAILABILITY:
@@ -3025,6 +3633,7 @@ static void interworking_parse_rx_anqp_resp(struct wpa_supplicant *wpa_s,
 		if (anqp) {
 			wpabuf_free(anqp->nai_realm);
 			anqp->nai_realm = wpabuf_alloc_copy(pos, slen);
+			interworking_anqp_parsed_reset(anqp);
 		}
 		break;
 	case ANQP_3GPP_CELLULAR_NETWORK:
@@ -3035,6 +3644,7 @@ static void interworking_parse_rx_anqp_resp(struct wpa_supplicant *wpa_s,
 		if (anqp) {
 			wpabuf_free(anqp->anqp_3gpp);
 			anqp->anqp_3gpp = wpabuf_alloc_copy(pos, slen);
+			interworking_anqp_parsed_reset(anqp);
 		}
 		break;
 	case ANQP_DOMAIN_NAME:
@@ -10,6 +10,7 @@
 #define INTERWORKING_H
 
 enum gas_query_result;
+struct interworking_anqp_parsed;
 
 int anqp_send_req(struct wpa_supplicant *wpa_s, const u8 *dst, int freq,
 		  u16 info_ids[], size_t num_ids, u32 subtypes,
@@ -28,6 +29,10 @@ int interworking_select(struct wpa_supplicant *wpa_s, int auto_select,
 int interworking_connect(struct wpa_supplicant *wpa_s, struct wpa_bss *bss,
 			 int only_add);
 void interworking_start_fetch_anqp(struct wpa_supplicant *wpa_s);
+void interworking_anqp_cache_flush(struct wpa_global *global);
+void interworking_anqp_parsed_free(struct interworking_anqp_parsed *parsed);
+int interworking_anqp_fetch_stats(struct wpa_supplicant *wpa_s, char *buf,
+				  size_t buflen);
 int interworking_home_sp_cred(struct wpa_supplicant *wpa_s,
 			      struct wpa_cred *cred,
 			      struct wpabuf *domain_names);
@@ -41,6 +41,9 @@ static void usage(void)
 #ifdef CONFIG_DEBUG_FILE
 	       " [-f<debug file>]"
 #endif /* CONFIG_DEBUG_FILE */
+#ifdef CONFIG_DEBUG_RING
+	       " [-F<debug ring file>]"
+#endif /* CONFIG_DEBUG_RING */
 	       " \\\n"
 	       "        [-o<override driver>] [-O<override ctrl>] \\\n"
 	       "        [-N -i<ifname> -c<conf> [-C<ctrl>] "
@@ -72,6 +75,11 @@ static void usage(void)
 #ifdef CONFIG_DEBUG_FILE
 	       "  -f = log output to debug file instead of stdout\n"
 #endif /* CONFIG_DEBUG_FILE */
+#ifdef CONFIG_DEBUG_RING
+	       "  -F = record debug messages into an in-memory ring buffer that\n"
+	       "       is written to the given file on crash or on LOG_RING_DUMP\n"
+	       "       (records messages regardless of debug verbosity)\n"
+#endif /* CONFIG_DEBUG_RING */
 	       "  -g = global ctrl_interface\n"
 	       "  -G = global ctrl_interface group\n"
 	       "  -h = show this help text\n"
@@ -205,7 +213,7 @@ int main(int argc, char *argv[])
 
 	for (;;) {
 		c = getopt(argc, argv,
-			   "b:Bc:C:D:de:f:g:G:hi:I:KLMm:No:O:p:P:qsS:TtuvW");
+			   "b:Bc:C:D:de:f:F:g:G:hi:I:KLMm:No:O:p:P:qsS:TtuvW");
 		if (c < 0)
 			break;
 		switch (c) {
@@ -242,6 +250,11 @@ int main(int argc, char *argv[])
 			params.wpa_debug_file_path = optarg;
 			break;
 #endif /* CONFIG_DEBUG_FILE */
+#ifdef CONFIG_DEBUG_RING
+		case 'F':
+			params.wpa_debug_ring_path = optarg;
+			break;
+#endif /* CONFIG_DEBUG_RING */
 		case 'g':
 			params.ctrl_interface = optarg;
 			break;
@@ -90,6 +90,13 @@ static const u8 * wpas_mbo_get_bss_attr(struct wpa_bss *bss,
 const u8 * wpas_mbo_check_assoc_disallow(struct wpa_bss *bss)
 {
 	const u8 *assoc_disallow;
+	u16 off;
+
+	if (bss->mbo_parsed) {
+		off = bss->beacon_newer ? bss->mbo_assoc_disallow_beacon :
+			bss->mbo_assoc_disallow;
+		return off ? wpa_bss_ie_ptr(bss) + off : NULL;
+	}
 
 	assoc_disallow = wpas_mbo_get_bss_attr(bss, MBO_ATTR_ID_ASSOC_DISALLOW,
 					       bss->beacon_newer);
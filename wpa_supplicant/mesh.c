@@ -580,7 +580,7 @@ out_free:
 
 
 void wpa_mesh_notify_peer(struct wpa_supplicant *wpa_s, const u8 *addr,
-			  const u8 *ies, size_t ie_len)
+			  const u8 *ies, size_t ie_len, int ssi_signal)
 {
 	struct ieee802_11_elems elems;
 
@@ -592,7 +592,7 @@ void wpa_mesh_notify_peer(struct wpa_supplicant *wpa_s, const u8 *addr,
 			MAC2STR(addr));
 		return;
 	}
-	wpa_mesh_new_mesh_peer(wpa_s, addr, &elems);
+	wpa_mesh_new_mesh_peer(wpa_s, addr, &elems, ssi_signal);
 }
 
 
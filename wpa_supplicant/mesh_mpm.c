@@ -19,6 +19,7 @@
 #include "ap/beacon.h"
 #include "ap/wpa_auth.h"
 #include "wpa_supplicant_i.h"
+#include "config.h"
 #include "driver_i.h"
 #include "mesh_mpm.h"
 #include "mesh_rsn.h"
@@ -33,6 +34,7 @@ struct mesh_peer_mgmt_ie {
 };
 
 static void plink_timer(void *eloop_ctx, void *user_data);
+static void mesh_mpm_auth_sched(void *eloop_ctx, void *user_data);
 
 
 enum plink_event {
@@ -670,6 +672,7 @@ void mesh_mpm_deinit(struct wpa_supplicant *wpa_s, struct hostapd_iface *ifmsh)
 	hapd->num_plinks = 0;
 	hostapd_free_stas(hapd);
 	eloop_cancel_timeout(peer_add_timer, wpa_s, NULL);
+	eloop_cancel_timeout(mesh_mpm_auth_sched, wpa_s, NULL);
 }
 
 
@@ -840,8 +843,108 @@ static struct sta_info * mesh_mpm_add_peer(struct wpa_supplicant *wpa_s,
 }
 
 
+/* Check whether SAE may be started with one more peer within mesh_auth_rate
+ * and if not, return the time until the current one second window ends */
+static bool mesh_mpm_auth_allowed(struct wpa_supplicant *wpa_s,
+				  struct os_reltime *wait)
+{
+	struct os_reltime now, age;
+
+	if (!wpa_s->conf->mesh_auth_rate)
+		return true;
+
+	os_get_reltime(&now);
+	os_reltime_sub(&now, &wpa_s->mesh_auth_window, &age);
+	if (!os_reltime_initialized(&wpa_s->mesh_auth_window) ||
+	    age.sec >= 1 || age.sec < 0) {
+		wpa_s->mesh_auth_window = now;
+		wpa_s->mesh_auth_started = 0;
+		age.sec = age.usec = 0;
+	}
+
+	if (wpa_s->mesh_auth_started < wpa_s->conf->mesh_auth_rate) {
+		wpa_s->mesh_auth_started++;
+		return true;
+	}
+
+	wait->sec = 0;
+	wait->usec = 1000000 - age.usec;
+	return false;
+}
+
+
+/* Start SAE with the pending peers in the order of the strongest signal until
+ * the rate limit is hit again */
+static void mesh_mpm_auth_sched(void *eloop_ctx, void *user_data)
+{
+	struct wpa_supplicant *wpa_s = eloop_ctx;
+	struct hostapd_data *hapd;
+	struct sta_info *sta, *best;
+	struct os_reltime wait;
+
+	if (!wpa_s->ifmsh)
+		return;
+	hapd = wpa_s->ifmsh->bss[0];
+
+	for (;;) {
+		best = NULL;
+		for (sta = hapd->sta_list; sta; sta = sta->next) {
+			if (!sta->mesh_auth_pending)
+				continue;
+			if (sta->sae && sta->sae->state > SAE_NOTHING) {
+				/* The peer started authentication */
+				sta->mesh_auth_pending = 0;
+				continue;
+			}
+			/* Unknown signal strength (0) is tried last */
+			if (!best || (sta->mesh_ssi_signal &&
+				      (!best->mesh_ssi_signal ||
+				       sta->mesh_ssi_signal >
+				       best->mesh_ssi_signal)))
+				best = sta;
+		}
+		if (!best)
+			return;
+
+		if (!mesh_mpm_auth_allowed(wpa_s, &wait)) {
+			eloop_register_timeout(wait.sec, wait.usec,
+					       mesh_mpm_auth_sched, wpa_s, NULL);
+			return;
+		}
+
+		best->mesh_auth_pending = 0;
+		wpa_msg(wpa_s, MSG_DEBUG,
+			"mesh: Start delayed authentication with " MACSTR
+			" (signal %d dBm)",
+			MAC2STR(best->addr), best->mesh_ssi_signal);
+		mesh_rsn_auth_sae_sta(wpa_s, best);
+	}
+}
+
+
+static void mesh_mpm_start_auth(struct wpa_supplicant *wpa_s,
+				struct sta_info *sta)
+{
+	struct os_reltime wait;
+
+	if (!eloop_is_timeout_registered(mesh_mpm_auth_sched, wpa_s, NULL) &&
+	    mesh_mpm_auth_allowed(wpa_s, &wait)) {
+		mesh_rsn_auth_sae_sta(wpa_s, sta);
+		return;
+	}
+
+	wpa_msg(wpa_s, MSG_DEBUG,
+		"mesh: Delay authentication with " MACSTR
+		" due to mesh_auth_rate", MAC2STR(sta->addr));
+	sta->mesh_auth_pending = 1;
+	if (!eloop_is_timeout_registered(mesh_mpm_auth_sched, wpa_s, NULL))
+		eloop_register_timeout(wait.sec, wait.usec,
+				       mesh_mpm_auth_sched, wpa_s, NULL);
+}
+
+
 void wpa_mesh_new_mesh_peer(struct wpa_supplicant *wpa_s, const u8 *addr,
-			    struct ieee802_11_elems *elems)
+			    struct ieee802_11_elems *elems, int ssi_signal)
 {
 	struct mesh_conf *conf = wpa_s->ifmsh->mconf;
 	struct hostapd_data *data = wpa_s->ifmsh->bss[0];
@@ -851,6 +954,7 @@ void wpa_mesh_new_mesh_peer(struct wpa_supplicant *wpa_s, const u8 *addr,
 	sta = mesh_mpm_add_peer(wpa_s, addr, elems);
 	if (!sta)
 		return;
+	sta->mesh_ssi_signal = ssi_signal;
 
 	if (ssid && ssid->no_auto_peer &&
 	    (is_zero_ether_addr(data->mesh_required_peer) ||
@@ -888,7 +992,7 @@ void wpa_mesh_new_mesh_peer(struct wpa_supplicant *wpa_s, const u8 *addr,
 		    sta->plink_state > PLINK_ESTAB)
 			mesh_mpm_plink_open(wpa_s, sta, PLINK_OPN_SNT);
 	} else {
-		mesh_rsn_auth_sae_sta(wpa_s, sta);
+		mesh_mpm_start_auth(wpa_s, sta);
 	}
 }
 
@@ -11,7 +11,7 @@
 
 /* notify MPM of new mesh peer to be inserted in MPM and driver */
 void wpa_mesh_new_mesh_peer(struct wpa_supplicant *wpa_s, const u8 *addr,
-			    struct ieee802_11_elems *elems);
+			    struct ieee802_11_elems *elems, int ssi_signal);
 void mesh_mpm_deinit(struct wpa_supplicant *wpa_s, struct hostapd_iface *ifmsh);
 void mesh_mpm_auth_peer(struct wpa_supplicant *wpa_s, const u8 *addr);
 void mesh_mpm_free_sta(struct hostapd_data *hapd, struct sta_info *sta);
@@ -355,6 +355,14 @@ void wpas_nan_usd_flush(struct wpa_supplicant *wpa_s)
 }
 
 
+int wpas_nan_usd_stats(struct wpa_supplicant *wpa_s, char *buf, size_t buflen)
+{
+	if (!wpa_s->nan_de)
+		return -1;
+	return nan_de_stats(wpa_s->nan_de, buf, buflen);
+}
+
+
 int wpas_nan_usd_publish(struct wpa_supplicant *wpa_s, const char *service_name,
 			 enum nan_service_protocol_type srv_proto_type,
 			 const struct wpabuf *ssi,
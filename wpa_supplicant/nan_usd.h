@@ -19,6 +19,7 @@ void wpas_nan_usd_rx_sdf(struct wpa_supplicant *wpa_s, const u8 *src,
 			 const u8 *a3,
 			 unsigned int freq, const u8 *buf, size_t len);
 void wpas_nan_usd_flush(struct wpa_supplicant *wpa_s);
+int wpas_nan_usd_stats(struct wpa_supplicant *wpa_s, char *buf, size_t buflen);
 int wpas_nan_usd_publish(struct wpa_supplicant *wpa_s, const char *service_name,
 			 enum nan_service_protocol_type srv_proto_type,
 			 const struct wpabuf *ssi,
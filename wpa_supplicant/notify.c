@@ -512,6 +512,7 @@ void wpas_notify_network_removed(struct wpa_supplicant *wpa_s,
 	if (wpa_s->sme.ext_auth_wpa_ssid == ssid)
 		wpa_s->sme.ext_auth_wpa_ssid = NULL;
 #endif /* CONFIG_SME && CONFIG_SAE */
+	sme_sae_precomp_flush(wpa_s);
 	if (wpa_s->wpa) {
 		if ((wpa_key_mgmt_sae(ssid->key_mgmt) &&
 		     (wpa_s->drv_flags2 & WPA_DRIVER_FLAGS2_SAE_OFFLOAD_STA)) ||
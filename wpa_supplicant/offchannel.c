@@ -17,6 +17,31 @@
 #include "offchannel.h"
 
 
+/* Maximum number of frames waiting for the pending Action frame TX */
+#define OFFCHANNEL_TX_QUEUE_MAX 8
+/* Time in seconds after which a pending frame that has not completed is
+ * dropped to serve the queue */
+#define OFFCHANNEL_TX_QUEUE_WAIT 1
+
+typedef void (*offchannel_tx_cb)(struct wpa_supplicant *wpa_s,
+				 unsigned int freq, const u8 *dst,
+				 const u8 *src, const u8 *bssid,
+				 const u8 *data, size_t data_len,
+				 enum offchannel_send_action_result result);
+
+/* Action frame of another user waiting for pending_action_tx to complete */
+struct offchannel_tx {
+	struct dl_list list;
+	unsigned int freq;
+	u8 dst[ETH_ALEN];
+	u8 src[ETH_ALEN];
+	u8 bssid[ETH_ALEN];
+	struct wpabuf *buf;
+	unsigned int wait_time;
+	offchannel_tx_cb tx_cb;
+	int no_cck;
+};
+
 
 static struct wpa_supplicant *
 wpas_get_tx_interface(struct wpa_supplicant *wpa_s, const u8 *src)
@@ -165,6 +190,212 @@ static void wpas_send_action_cb(void *eloop_ctx, void *timeout_ctx)
 }
 
 
+static void offchannel_queue_cb(void *eloop_ctx, void *timeout_ctx);
+static void offchannel_queue_timeout(void *eloop_ctx, void *timeout_ctx);
+
+
+static u32 offchannel_frame_vendor_type(const u8 *buf, size_t len)
+{
+	if (len >= 6 && buf[0] == WLAN_ACTION_PUBLIC &&
+	    buf[1] == WLAN_PA_VENDOR_SPECIFIC)
+		return WPA_GET_BE32(&buf[2]);
+	if (len >= 5 && buf[0] == WLAN_ACTION_VENDOR_SPECIFIC)
+		return WPA_GET_BE32(&buf[1]);
+	return 0;
+}
+
+
+/*
+ * A new frame from the same user replaces the earlier one. Some users have
+ * more than one TX status callback, so frames of the same vendor protocol
+ * (e.g., P2P or DPP) are considered to be from the same user as well.
+ */
+static bool offchannel_same_user(offchannel_tx_cb a_cb, const u8 *a,
+				 size_t a_len, offchannel_tx_cb b_cb,
+				 const u8 *b, size_t b_len)
+{
+	u32 type;
+
+	if (a_cb == b_cb)
+		return true;
+	type = offchannel_frame_vendor_type(a, a_len);
+	return type && type == offchannel_frame_vendor_type(b, b_len);
+}
+
+
+static void offchannel_queue_schedule(struct wpa_supplicant *wpa_s)
+{
+	if (dl_list_empty(&wpa_s->pending_action_queue))
+		return;
+	eloop_cancel_timeout(offchannel_queue_cb, wpa_s, NULL);
+	eloop_register_timeout(0, 0, offchannel_queue_cb, wpa_s, NULL);
+}
+
+
+static int offchannel_queue_action(struct wpa_supplicant *wpa_s,
+				   unsigned int freq, const u8 *dst,
+				   const u8 *src, const u8 *bssid,
+				   const u8 *buf, size_t len,
+				   unsigned int wait_time,
+				   offchannel_tx_cb tx_cb, int no_cck)
+{
+	struct offchannel_tx *tx, *found = NULL;
+	struct wpabuf *frame;
+
+	dl_list_for_each(tx, &wpa_s->pending_action_queue,
+			 struct offchannel_tx, list) {
+		if (offchannel_same_user(tx->tx_cb, wpabuf_head(tx->buf),
+					 wpabuf_len(tx->buf), tx_cb, buf, len)) {
+			found = tx;
+			break;
+		}
+	}
+
+	if (!found && dl_list_len(&wpa_s->pending_action_queue) >=
+	    OFFCHANNEL_TX_QUEUE_MAX) {
+		wpa_printf(MSG_DEBUG,
+			   "Off-channel: Action frame TX queue full - drop frame to "
+			   MACSTR, MAC2STR(dst));
+		return -1;
+	}
+
+	frame = wpabuf_alloc_copy(buf, len);
+	if (!frame)
+		return -1;
+
+	if (found) {
+		/* Only the latest frame of a user is kept, like for the
+		 * pending frame */
+		wpa_printf(MSG_DEBUG,
+			   "Off-channel: Replace queued Action frame TX to "
+			   MACSTR, MAC2STR(found->dst));
+		wpabuf_free(found->buf);
+		tx = found;
+	} else {
+		tx = os_zalloc(sizeof(*tx));
+		if (!tx) {
+			wpabuf_free(frame);
+			return -1;
+		}
+		if (dl_list_empty(&wpa_s->pending_action_queue))
+			eloop_register_timeout(OFFCHANNEL_TX_QUEUE_WAIT, 0,
+					       offchannel_queue_timeout,
+					       wpa_s, NULL);
+		dl_list_add_tail(&wpa_s->pending_action_queue, &tx->list);
+	}
+
+	tx->freq = freq;
+	os_memcpy(tx->dst, dst, ETH_ALEN);
+	os_memcpy(tx->src, src, ETH_ALEN);
+	os_memcpy(tx->bssid, bssid, ETH_ALEN);
+	tx->buf = frame;
+	tx->wait_time = wait_time;
+	tx->tx_cb = tx_cb;
+	tx->no_cck = no_cck;
+
+	wpa_printf(MSG_DEBUG,
+		   "Off-channel: Queued Action frame TX to " MACSTR
+		   " freq=%u until pending_action_tx=%p completes (queue=%u)",
+		   MAC2STR(dst), freq, wpa_s->pending_action_tx,
+		   dl_list_len(&wpa_s->pending_action_queue));
+
+	return 0;
+}
+
+
+static bool offchannel_queue_has_freq(struct wpa_supplicant *wpa_s,
+				      unsigned int freq)
+{
+	struct offchannel_tx *tx;
+
+	dl_list_for_each(tx, &wpa_s->pending_action_queue,
+			 struct offchannel_tx, list) {
+		if (freq && tx->freq == freq)
+			return true;
+	}
+
+	return false;
+}
+
+
+static struct offchannel_tx * offchannel_queue_pick(struct wpa_supplicant *wpa_s)
+{
+	struct offchannel_tx *tx;
+	unsigned int freq;
+
+	/* Prefer a frame for the channel that the driver is on or is going
+	 * to so that the users share the remain-on-channel period; otherwise,
+	 * send in the order of the requests */
+	freq = wpa_s->off_channel_freq ? wpa_s->off_channel_freq :
+		wpa_s->roc_waiting_drv_freq;
+	dl_list_for_each(tx, &wpa_s->pending_action_queue,
+			 struct offchannel_tx, list) {
+		if (freq && tx->freq == freq)
+			return tx;
+	}
+
+	return dl_list_first(&wpa_s->pending_action_queue,
+			     struct offchannel_tx, list);
+}
+
+
+static void offchannel_queue_cb(void *eloop_ctx, void *timeout_ctx)
+{
+	struct wpa_supplicant *wpa_s = eloop_ctx;
+	struct offchannel_tx *tx;
+
+	if (wpa_s->pending_action_tx)
+		return; /* Continue once the pending frame completes */
+
+	tx = offchannel_queue_pick(wpa_s);
+	if (!tx)
+		return;
+	dl_list_del(&tx->list);
+
+	eloop_cancel_timeout(offchannel_queue_timeout, wpa_s, NULL);
+	if (!dl_list_empty(&wpa_s->pending_action_queue))
+		eloop_register_timeout(OFFCHANNEL_TX_QUEUE_WAIT, 0,
+				       offchannel_queue_timeout, wpa_s, NULL);
+
+	wpa_printf(MSG_DEBUG,
+		   "Off-channel: Send queued Action frame to " MACSTR
+		   " freq=%u", MAC2STR(tx->dst), tx->freq);
+	if (offchannel_send_action(wpa_s, tx->freq, tx->dst, tx->src,
+				   tx->bssid, wpabuf_head(tx->buf),
+				   wpabuf_len(tx->buf), tx->wait_time,
+				   tx->tx_cb, tx->no_cck) < 0) {
+		/* The user was told that the frame was accepted, so report
+		 * the failure through the TX status callback */
+		offchannel_clear_pending_action_tx(wpa_s);
+		if (tx->tx_cb)
+			tx->tx_cb(wpa_s, tx->freq, tx->dst, tx->src, tx->bssid,
+				  wpabuf_head(tx->buf), wpabuf_len(tx->buf),
+				  OFFCHANNEL_SEND_ACTION_FAILED);
+		offchannel_queue_schedule(wpa_s);
+	}
+
+	wpabuf_free(tx->buf);
+	os_free(tx);
+}
+
+
+static void offchannel_queue_timeout(void *eloop_ctx, void *timeout_ctx)
+{
+	struct wpa_supplicant *wpa_s = eloop_ctx;
+
+	if (!wpa_s->pending_action_tx)
+		return;
+
+	/* A pending frame may never complete, e.g., if the driver could not
+	 * start remain-on-channel. Drop it like a new request would have done
+	 * without the queue. */
+	wpa_printf(MSG_DEBUG,
+		   "Off-channel: Pending Action frame TX did not complete - drop it for the queued frames");
+	offchannel_clear_pending_action_tx(wpa_s);
+	offchannel_queue_cb(wpa_s, NULL);
+}
+
+
 /**
  * offchannel_send_action_tx_status - TX status callback
  * @wpa_s: Pointer to wpa_supplicant data
@@ -225,6 +456,8 @@ void offchannel_send_action_tx_status(
 			data, data_len, result);
 	}
 
+	offchannel_queue_schedule(wpa_s);
+
 #ifdef CONFIG_P2P
 	if (wpa_s->global->p2p_long_listen > 0) {
 		/* Continue the listen */
@@ -272,6 +505,15 @@ int offchannel_send_action(struct wpa_supplicant *wpa_s, unsigned int freq,
 		   freq, MAC2STR(dst), MAC2STR(src), MAC2STR(bssid),
 		   (int) len);
 
+	if (wpa_s->pending_action_tx &&
+	    !offchannel_same_user(wpa_s->pending_action_tx_status_cb,
+				  wpabuf_head(wpa_s->pending_action_tx),
+				  wpabuf_len(wpa_s->pending_action_tx),
+				  tx_cb, buf, len))
+		return offchannel_queue_action(wpa_s, freq, dst, src, bssid,
+					       buf, len, wait_time, tx_cb,
+					       no_cck);
+
 	wpa_s->pending_action_tx_status_cb = tx_cb;
 
 	if (wpa_s->pending_action_tx) {
@@ -402,12 +644,16 @@ void offchannel_send_action_done(struct wpa_supplicant *wpa_s)
 	if (wpa_s->drv_flags & WPA_DRIVER_FLAGS_OFFCHANNEL_TX &&
 	    (wpa_s->action_tx_wait_time || wpa_s->action_tx_wait_time_used))
 		wpa_drv_send_action_cancel_wait(wpa_s);
+	else if (offchannel_queue_has_freq(wpa_s, wpa_s->off_channel_freq))
+		wpa_printf(MSG_DEBUG,
+			   "Off-channel: Use remain-on-channel for a queued Action frame");
 	else if (wpa_s->off_channel_freq || wpa_s->roc_waiting_drv_freq) {
 		wpa_drv_cancel_remain_on_channel(wpa_s);
 		wpa_s->off_channel_freq = 0;
 		wpa_s->roc_waiting_drv_freq = 0;
 	}
 	wpa_s->action_tx_wait_time_used = 0;
+	offchannel_queue_schedule(wpa_s);
 }
 
 
@@ -471,6 +717,7 @@ void offchannel_clear_pending_action_tx(struct wpa_supplicant *wpa_s)
 		   wpa_s->pending_action_tx);
 	wpabuf_free(wpa_s->pending_action_tx);
 	wpa_s->pending_action_tx = NULL;
+	offchannel_queue_schedule(wpa_s);
 }
 
 
@@ -483,6 +730,16 @@ void offchannel_clear_pending_action_tx(struct wpa_supplicant *wpa_s)
  */
 void offchannel_deinit(struct wpa_supplicant *wpa_s)
 {
+	struct offchannel_tx *tx, *tmp;
+
+	dl_list_for_each_safe(tx, tmp, &wpa_s->pending_action_queue,
+			      struct offchannel_tx, list) {
+		dl_list_del(&tx->list);
+		wpabuf_free(tx->buf);
+		os_free(tx);
+	}
 	offchannel_clear_pending_action_tx(wpa_s);
 	eloop_cancel_timeout(wpas_send_action_cb, wpa_s, NULL);
+	eloop_cancel_timeout(offchannel_queue_cb, wpa_s, NULL);
+	eloop_cancel_timeout(offchannel_queue_timeout, wpa_s, NULL);
 }
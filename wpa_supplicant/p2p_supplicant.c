@@ -2553,6 +2553,7 @@ do {                                    \
 	d->max_num_sta = s->max_num_sta;
 	d->pbc_in_m1 = s->pbc_in_m1;
 	d->ignore_old_scan_res = s->ignore_old_scan_res;
+	d->scan_res_filter_freqs = s->scan_res_filter_freqs;
 	d->beacon_int = s->beacon_int;
 	d->dtim_period = s->dtim_period;
 	d->p2p_go_ctwindow = s->p2p_go_ctwindow;
@@ -4509,6 +4510,69 @@ static int wpas_p2p_setup_channels(struct wpa_supplicant *wpa_s,
 }
 
 
+struct wpas_p2p_chan_cache {
+	struct p2p_channels chan;
+	struct p2p_channels cli_chan;
+
+	/* Parameters that the channel lists were built with */
+	bool disable_6ghz;
+	bool dfs_chan_enable;
+	int add_cli_chan;
+};
+
+
+static void wpas_p2p_flush_chan_cache(struct wpa_global *global)
+{
+	struct wpa_supplicant *ifs;
+
+	for (ifs = global->ifaces; ifs; ifs = ifs->next) {
+		os_free(ifs->p2p_chan_cache);
+		ifs->p2p_chan_cache = NULL;
+	}
+}
+
+
+/*
+ * Verifying every channel of every operating class against the driver's
+ * channel list is expensive and the result depends only on the channel list,
+ * the disallowed frequencies, and the configuration, so reuse the previous
+ * result until one of those may have changed.
+ */
+static int wpas_p2p_setup_channels_cached(struct wpa_supplicant *wpa_s,
+					  struct p2p_channels *chan,
+					  struct p2p_channels *cli_chan,
+					  bool p2p_disable_6ghz)
+{
+	struct wpas_p2p_chan_cache *cache = wpa_s->p2p_chan_cache;
+	bool dfs = is_p2p_dfs_chan_enabled(wpa_s->global->p2p);
+
+	if (cache && cache->disable_6ghz == p2p_disable_6ghz &&
+	    cache->dfs_chan_enable == dfs &&
+	    cache->add_cli_chan == wpa_s->conf->p2p_add_cli_chan) {
+		os_memcpy(chan, &cache->chan, sizeof(*chan));
+		os_memcpy(cli_chan, &cache->cli_chan, sizeof(*cli_chan));
+		return 0;
+	}
+
+	if (wpas_p2p_setup_channels(wpa_s, chan, cli_chan, p2p_disable_6ghz))
+		return -1;
+
+	if (!cache) {
+		cache = os_zalloc(sizeof(*cache));
+		if (!cache)
+			return 0;
+		wpa_s->p2p_chan_cache = cache;
+	}
+	os_memcpy(&cache->chan, chan, sizeof(*chan));
+	os_memcpy(&cache->cli_chan, cli_chan, sizeof(*cli_chan));
+	cache->disable_6ghz = p2p_disable_6ghz;
+	cache->dfs_chan_enable = dfs;
+	cache->add_cli_chan = wpa_s->conf->p2p_add_cli_chan;
+
+	return 0;
+}
+
+
 int wpas_p2p_get_sec_channel_offset_40mhz(struct wpa_supplicant *wpa_s,
 					  struct hostapd_hw_modes *mode,
 					  u8 channel)
@@ -5847,6 +5911,8 @@ void wpas_p2p_deinit(struct wpa_supplicant *wpa_s)
 
 	os_free(wpa_s->go_params);
 	wpa_s->go_params = NULL;
+	os_free(wpa_s->p2p_chan_cache);
+	wpa_s->p2p_chan_cache = NULL;
 	eloop_cancel_timeout(wpas_p2p_psk_failure_removal, wpa_s, NULL);
 	eloop_cancel_timeout(wpas_p2p_group_formation_timeout, wpa_s, NULL);
 	eloop_cancel_timeout(wpas_p2p_join_scan, wpa_s, NULL);
@@ -7136,10 +7202,7 @@ int wpas_p2p_group_remove(struct wpa_supplicant *wpa_s, const char *ifname)
 		return 0;
 	}
 
-	for (wpa_s = global->ifaces; wpa_s; wpa_s = wpa_s->next) {
-		if (os_strcmp(wpa_s->ifname, ifname) == 0)
-			break;
-	}
+	wpa_s = wpa_supplicant_get_iface(global, ifname);
 
 	return wpas_p2p_disconnect_safely(wpa_s, calling_wpa_s);
 }
@@ -8773,10 +8836,7 @@ int wpas_p2p_invite_group(struct wpa_supplicant *wpa_s, const char *ifname,
 	wpa_s->p2p_go_max_oper_chwidth = 0;
 	wpa_s->p2p_go_edmg = 0;
 
-	for (wpa_s = global->ifaces; wpa_s; wpa_s = wpa_s->next) {
-		if (os_strcmp(wpa_s->ifname, ifname) == 0)
-			break;
-	}
+	wpa_s = wpa_supplicant_get_iface(global, ifname);
 	if (wpa_s == NULL) {
 		wpa_printf(MSG_DEBUG, "P2P: Interface '%s' not found", ifname);
 		return -1;
@@ -9402,10 +9462,17 @@ void wpas_p2p_update_channel_list(struct wpa_supplicant *wpa_s,
 
 	num = get_shared_radio_freqs_data(wpa_s, freqs, num, false);
 
+	/* Only the driver channel list and the disallowed frequencies affect
+	 * the allowed channels; state changes and channel switches do not */
+	if (trig != WPAS_P2P_CHANNEL_UPDATE_STATE_CHANGE &&
+	    trig != WPAS_P2P_CHANNEL_UPDATE_CS)
+		wpas_p2p_flush_chan_cache(wpa_s->global);
+
 	os_memset(&chan, 0, sizeof(chan));
 	os_memset(&cli_chan, 0, sizeof(cli_chan));
-	if (wpas_p2p_setup_channels(wpa_s, &chan, &cli_chan,
-				    is_p2p_6ghz_disabled(wpa_s->global->p2p))) {
+	if (wpas_p2p_setup_channels_cached(
+		    wpa_s, &chan, &cli_chan,
+		    is_p2p_6ghz_disabled(wpa_s->global->p2p))) {
 		wpa_printf(MSG_ERROR, "P2P: Failed to update supported "
 			   "channel list");
 		return;
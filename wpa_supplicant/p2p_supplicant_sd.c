@@ -145,16 +145,75 @@ static int p2p_sd_dns_uncompress(char *buf, size_t buf_len, const u8 *msg,
 }
 
 
+static unsigned int wpas_p2p_srv_hash(unsigned int hash, const u8 *data,
+				      size_t len)
+{
+	while (len--)
+		hash = hash * 31 + *data++;
+	return hash;
+}
+
+
+/*
+ * Services are indexed by the uncompressed DNS name and the DNS Type and
+ * Version of the query, so that all the services matching a query are in the
+ * same hash bucket. Queries that cannot be uncompressed are indexed by their
+ * binary value.
+ */
+static unsigned int wpas_p2p_srv_bonjour_hash(const u8 *query, size_t len,
+					      const char *name)
+{
+	unsigned int hash = 0;
+
+	if (name) {
+		hash = wpas_p2p_srv_hash(hash, (const u8 *) name,
+					 os_strlen(name));
+		hash = wpas_p2p_srv_hash(hash, query + len - 3, 3);
+	} else {
+		hash = wpas_p2p_srv_hash(hash, query, len);
+	}
+
+	return (hash ^ (hash >> 8)) & (P2P_SRV_HASH_SIZE - 1);
+}
+
+
+static unsigned int wpas_p2p_srv_upnp_hash(u8 version, const char *service)
+{
+	unsigned int hash;
+
+	hash = wpas_p2p_srv_hash(version, (const u8 *) service,
+				 os_strlen(service));
+	return (hash ^ (hash >> 8)) & (P2P_SRV_HASH_SIZE - 1);
+}
+
+
+static const char * wpas_p2p_srv_bonjour_name(const u8 *query, size_t len,
+					      char *buf, size_t buflen)
+{
+	if (len < 3)
+		return NULL; /* Too short to include DNS Type and Version */
+	if (p2p_sd_dns_uncompress(buf, buflen, query, len - 3, 0))
+		return NULL;
+	return buf;
+}
+
+
 static struct p2p_srv_bonjour *
 wpas_p2p_service_get_bonjour(struct wpa_supplicant *wpa_s,
 			     const struct wpabuf *query)
 {
 	struct p2p_srv_bonjour *bsrv;
+	const char *name;
+	char buf[256];
+	unsigned int hash;
 	size_t len;
 
 	len = wpabuf_len(query);
-	dl_list_for_each(bsrv, &wpa_s->global->p2p_srv_bonjour,
-			 struct p2p_srv_bonjour, list) {
+	name = wpas_p2p_srv_bonjour_name(wpabuf_head(query), len, buf,
+					 sizeof(buf));
+	hash = wpas_p2p_srv_bonjour_hash(wpabuf_head(query), len, name);
+	dl_list_for_each(bsrv, &wpa_s->global->p2p_srv_bonjour_hash[hash],
+			 struct p2p_srv_bonjour, hash) {
 		if (len == wpabuf_len(bsrv->query) &&
 		    os_memcmp(wpabuf_head(query), wpabuf_head(bsrv->query),
 			      len) == 0)
@@ -169,9 +228,11 @@ wpas_p2p_service_get_upnp(struct wpa_supplicant *wpa_s, u8 version,
 			  const char *service)
 {
 	struct p2p_srv_upnp *usrv;
+	unsigned int hash;
 
-	dl_list_for_each(usrv, &wpa_s->global->p2p_srv_upnp,
-			 struct p2p_srv_upnp, list) {
+	hash = wpas_p2p_srv_upnp_hash(version, service);
+	dl_list_for_each(usrv, &wpa_s->global->p2p_srv_upnp_hash[hash],
+			 struct p2p_srv_upnp, hash) {
 		if (version == usrv->version &&
 		    os_strcmp(service, usrv->service) == 0)
 			return usrv;
@@ -180,6 +241,18 @@ wpas_p2p_service_get_upnp(struct wpa_supplicant *wpa_s, u8 version,
 }
 
 
+static void wpas_sd_add_tlv(struct wpabuf *resp, const struct wpabuf *tlv,
+			    u8 srv_trans_id)
+{
+	u8 *pos;
+
+	pos = wpabuf_put(resp, wpabuf_len(tlv));
+	os_memcpy(pos, wpabuf_head(tlv), wpabuf_len(tlv));
+	/* Service Transaction ID */
+	pos[3] = srv_trans_id;
+}
+
+
 static void wpas_sd_add_empty(struct wpabuf *resp, u8 srv_proto,
 			      u8 srv_trans_id, u8 status)
 {
@@ -226,7 +299,6 @@ static void wpas_sd_all_bonjour(struct wpa_supplicant *wpa_s,
 				struct wpabuf *resp, u8 srv_trans_id)
 {
 	struct p2p_srv_bonjour *bsrv;
-	u8 *len_pos;
 
 	wpa_printf(MSG_DEBUG, "P2P: SD Request for all Bonjour services");
 
@@ -237,32 +309,19 @@ static void wpas_sd_all_bonjour(struct wpa_supplicant *wpa_s,
 
 	dl_list_for_each(bsrv, &wpa_s->global->p2p_srv_bonjour,
 			 struct p2p_srv_bonjour, list) {
-		if (wpabuf_tailroom(resp) <
-		    5 + wpabuf_len(bsrv->query) + wpabuf_len(bsrv->resp))
+		if (wpabuf_tailroom(resp) < wpabuf_len(bsrv->tlv))
 			return;
-		/* Length (to be filled) */
-		len_pos = wpabuf_put(resp, 2);
-		wpabuf_put_u8(resp, P2P_SERV_BONJOUR);
-		wpabuf_put_u8(resp, srv_trans_id);
-		/* Status Code */
-		wpabuf_put_u8(resp, P2P_SD_SUCCESS);
 		wpa_hexdump_ascii(MSG_DEBUG, "P2P: Matching Bonjour service",
 				  wpabuf_head(bsrv->resp),
 				  wpabuf_len(bsrv->resp));
-		/* Response Data */
-		wpabuf_put_buf(resp, bsrv->query); /* Key */
-		wpabuf_put_buf(resp, bsrv->resp); /* Value */
-		WPA_PUT_LE16(len_pos, (u8 *) wpabuf_put(resp, 0) - len_pos -
-			     2);
+		wpas_sd_add_tlv(resp, bsrv->tlv, srv_trans_id);
 	}
 }
 
 
 static int match_bonjour_query(struct p2p_srv_bonjour *bsrv, const u8 *query,
-			       size_t query_len)
+			       size_t query_len, const char *name)
 {
-	char str_rx[256], str_srv[256];
-
 	if (query_len < 3 || wpabuf_len(bsrv->query) < 3)
 		return 0; /* Too short to include DNS Type and Version */
 	if (os_memcmp(query + query_len - 3,
@@ -273,15 +332,12 @@ static int match_bonjour_query(struct p2p_srv_bonjour *bsrv, const u8 *query,
 	    os_memcmp(query, wpabuf_head(bsrv->query), query_len - 3) == 0)
 		return 1; /* Binary match */
 
-	if (p2p_sd_dns_uncompress(str_rx, sizeof(str_rx), query, query_len - 3,
-				  0))
+	if (!name)
 		return 0; /* Failed to uncompress query */
-	if (p2p_sd_dns_uncompress(str_srv, sizeof(str_srv),
-				  wpabuf_head(bsrv->query),
-				  wpabuf_len(bsrv->query) - 3, 0))
+	if (!bsrv->name)
 		return 0; /* Failed to uncompress service */
 
-	return os_strcmp(str_rx, str_srv) == 0;
+	return os_strcmp(name, bsrv->name) == 0;
 }
 
 
@@ -290,6 +346,9 @@ static void wpas_sd_req_bonjour(struct wpa_supplicant *wpa_s,
 				const u8 *query, size_t query_len)
 {
 	struct p2p_srv_bonjour *bsrv;
+	const char *name;
+	char buf[256];
+	unsigned int hash;
 	u8 *len_pos;
 	int matches = 0;
 
@@ -307,9 +366,14 @@ static void wpas_sd_req_bonjour(struct wpa_supplicant *wpa_s,
 		return;
 	}
 
-	dl_list_for_each(bsrv, &wpa_s->global->p2p_srv_bonjour,
-			 struct p2p_srv_bonjour, list) {
-		if (!match_bonjour_query(bsrv, query, query_len))
+	if (query_len < 3)
+		goto not_found;
+
+	name = wpas_p2p_srv_bonjour_name(query, query_len, buf, sizeof(buf));
+	hash = wpas_p2p_srv_bonjour_hash(query, query_len, name);
+	dl_list_for_each(bsrv, &wpa_s->global->p2p_srv_bonjour_hash[hash],
+			 struct p2p_srv_bonjour, hash) {
+		if (!match_bonjour_query(bsrv, query, query_len, name))
 			continue;
 
 		if (wpabuf_tailroom(resp) <
@@ -318,6 +382,16 @@ static void wpas_sd_req_bonjour(struct wpa_supplicant *wpa_s,
 
 		matches++;
 
+		wpa_hexdump_ascii(MSG_DEBUG, "P2P: Matching Bonjour service",
+				  wpabuf_head(bsrv->resp),
+				  wpabuf_len(bsrv->resp));
+
+		if (query_len == wpabuf_len(bsrv->query) &&
+		    os_memcmp(query, wpabuf_head(bsrv->query), query_len) == 0) {
+			wpas_sd_add_tlv(resp, bsrv->tlv, srv_trans_id);
+			continue;
+		}
+
 		/* Length (to be filled) */
 		len_pos = wpabuf_put(resp, 2);
 		wpabuf_put_u8(resp, P2P_SERV_BONJOUR);
@@ -325,9 +399,6 @@ static void wpas_sd_req_bonjour(struct wpa_supplicant *wpa_s,
 
 		/* Status Code */
 		wpabuf_put_u8(resp, P2P_SD_SUCCESS);
-		wpa_hexdump_ascii(MSG_DEBUG, "P2P: Matching Bonjour service",
-				  wpabuf_head(bsrv->resp),
-				  wpabuf_len(bsrv->resp));
 
 		/* Response Data */
 		wpabuf_put_data(resp, query, query_len); /* Key */
@@ -336,6 +407,7 @@ static void wpas_sd_req_bonjour(struct wpa_supplicant *wpa_s,
 		WPA_PUT_LE16(len_pos, (u8 *) wpabuf_put(resp, 0) - len_pos - 2);
 	}
 
+not_found:
 	if (matches == 0) {
 		wpa_printf(MSG_DEBUG, "P2P: Requested Bonjour service not "
 			   "available");
@@ -360,7 +432,6 @@ static void wpas_sd_all_upnp(struct wpa_supplicant *wpa_s,
 			     struct wpabuf *resp, u8 srv_trans_id)
 {
 	struct p2p_srv_upnp *usrv;
-	u8 *len_pos;
 
 	wpa_printf(MSG_DEBUG, "P2P: SD Request for all UPnP services");
 
@@ -371,23 +442,11 @@ static void wpas_sd_all_upnp(struct wpa_supplicant *wpa_s,
 
 	dl_list_for_each(usrv, &wpa_s->global->p2p_srv_upnp,
 			 struct p2p_srv_upnp, list) {
-		if (wpabuf_tailroom(resp) < 5 + 1 + os_strlen(usrv->service))
+		if (wpabuf_tailroom(resp) < wpabuf_len(usrv->tlv))
 			return;
-
-		/* Length (to be filled) */
-		len_pos = wpabuf_put(resp, 2);
-		wpabuf_put_u8(resp, P2P_SERV_UPNP);
-		wpabuf_put_u8(resp, srv_trans_id);
-
-		/* Status Code */
-		wpabuf_put_u8(resp, P2P_SD_SUCCESS);
-		/* Response Data */
-		wpabuf_put_u8(resp, usrv->version);
 		wpa_printf(MSG_DEBUG, "P2P: Matching UPnP Service: %s",
 			   usrv->service);
-		wpabuf_put_str(resp, usrv->service);
-		WPA_PUT_LE16(len_pos, (u8 *) wpabuf_put(resp, 0) - len_pos -
-			     2);
+		wpas_sd_add_tlv(resp, usrv->tlv, srv_trans_id);
 	}
 }
 
@@ -1136,8 +1195,11 @@ void wpas_p2p_sd_service_update(struct wpa_supplicant *wpa_s)
 static void wpas_p2p_srv_bonjour_free(struct p2p_srv_bonjour *bsrv)
 {
 	dl_list_del(&bsrv->list);
+	dl_list_del(&bsrv->hash);
 	wpabuf_free(bsrv->query);
 	wpabuf_free(bsrv->resp);
+	os_free(bsrv->name);
+	wpabuf_free(bsrv->tlv);
 	os_free(bsrv);
 }
 
@@ -1145,11 +1207,32 @@ static void wpas_p2p_srv_bonjour_free(struct p2p_srv_bonjour *bsrv)
 static void wpas_p2p_srv_upnp_free(struct p2p_srv_upnp *usrv)
 {
 	dl_list_del(&usrv->list);
+	dl_list_del(&usrv->hash);
 	os_free(usrv->service);
+	wpabuf_free(usrv->tlv);
 	os_free(usrv);
 }
 
 
+static struct wpabuf * wpas_p2p_srv_tlv(u8 srv_proto, const u8 *data1,
+					size_t len1, const u8 *data2,
+					size_t len2)
+{
+	struct wpabuf *tlv;
+
+	tlv = wpabuf_alloc(5 + len1 + len2);
+	if (!tlv)
+		return NULL;
+	wpabuf_put_le16(tlv, 3 + len1 + len2);
+	wpabuf_put_u8(tlv, srv_proto);
+	wpabuf_put_u8(tlv, 0); /* Service Transaction ID */
+	wpabuf_put_u8(tlv, P2P_SD_SUCCESS);
+	wpabuf_put_data(tlv, data1, len1);
+	wpabuf_put_data(tlv, data2, len2);
+	return tlv;
+}
+
+
 void wpas_p2p_service_flush(struct wpa_supplicant *wpa_s)
 {
 	struct p2p_srv_bonjour *bsrv, *bn;
@@ -1218,6 +1301,9 @@ int wpas_p2p_service_add_bonjour(struct wpa_supplicant *wpa_s,
 				 struct wpabuf *query, struct wpabuf *resp)
 {
 	struct p2p_srv_bonjour *bsrv;
+	const char *name;
+	char buf[256];
+	unsigned int hash;
 
 	bsrv = os_zalloc(sizeof(*bsrv));
 	if (bsrv == NULL)
@@ -1228,11 +1314,30 @@ int wpas_p2p_service_add_bonjour(struct wpa_supplicant *wpa_s,
 	bsrv->resp = wpabuf_dup(resp);
 	if (!bsrv->resp)
 		goto error_query;
+	name = wpas_p2p_srv_bonjour_name(wpabuf_head(query),
+					 wpabuf_len(query), buf, sizeof(buf));
+	if (name) {
+		bsrv->name = os_strdup(name);
+		if (!bsrv->name)
+			goto error_resp;
+	}
+	bsrv->tlv = wpas_p2p_srv_tlv(P2P_SERV_BONJOUR, wpabuf_head(query),
+				     wpabuf_len(query), wpabuf_head(resp),
+				     wpabuf_len(resp));
+	if (!bsrv->tlv)
+		goto error_name;
+	hash = wpas_p2p_srv_bonjour_hash(wpabuf_head(query), wpabuf_len(query),
+					 name);
 	dl_list_add(&wpa_s->global->p2p_srv_bonjour, &bsrv->list);
+	dl_list_add(&wpa_s->global->p2p_srv_bonjour_hash[hash], &bsrv->hash);
 
 	wpas_p2p_sd_service_update(wpa_s);
 	return 0;
 
+error_name:
+	os_free(bsrv->name);
+error_resp:
+	wpabuf_free(bsrv->resp);
 error_query:
 	wpabuf_free(bsrv->query);
 error_bsrv:
@@ -1259,6 +1364,7 @@ int wpas_p2p_service_add_upnp(struct wpa_supplicant *wpa_s, u8 version,
 			      const char *service)
 {
 	struct p2p_srv_upnp *usrv;
+	unsigned int hash;
 
 	if (wpas_p2p_service_get_upnp(wpa_s, version, service))
 		return 0; /* Already listed */
@@ -1271,7 +1377,16 @@ int wpas_p2p_service_add_upnp(struct wpa_supplicant *wpa_s, u8 version,
 		os_free(usrv);
 		return -1;
 	}
+	usrv->tlv = wpas_p2p_srv_tlv(P2P_SERV_UPNP, &version, 1,
+				     (const u8 *) service, os_strlen(service));
+	if (!usrv->tlv) {
+		os_free(usrv->service);
+		os_free(usrv);
+		return -1;
+	}
+	hash = wpas_p2p_srv_upnp_hash(version, service);
 	dl_list_add(&wpa_s->global->p2p_srv_upnp, &usrv->list);
+	dl_list_add(&wpa_s->global->p2p_srv_upnp_hash[hash], &usrv->hash);
 
 	wpas_p2p_sd_service_update(wpa_s);
 	return 0;
@@ -0,0 +1,769 @@
+/*
+ * wpa_supplicant - Persistent PMKSA cache and ERP keys
+ *
+ * This software may be distributed under the terms of the BSD license.
+ * See README for more details.
+ */
+
+#include "includes.h"
+
+#include "common.h"
+#include "utils/eloop.h"
+#include "utils/list.h"
+#include "crypto/aes.h"
+#include "crypto/aes_siv.h"
+#include "eap_common/eap_defs.h"
+#include "eapol_supp/eapol_supp_sm.h"
+#include "rsn_supp/wpa.h"
+#include "rsn_supp/pmksa_cache.h"
+#include "config.h"
+#include "wpa_supplicant_i.h"
+#include "pmksa_store.h"
+
+/*
+ * The store file is a log of records, each one consisting of a 16-bit little
+ * endian length followed by the AES-SIV protected record. New records are
+ * appended when PMKSA cache entries are added or removed and when ERP keys are
+ * derived, used, or removed. The file is rewritten with only the current
+ * entries when it is loaded and when the log has grown to be considerably
+ * longer than the number of entries.
+ *
+ * Record (plaintext):
+ * type (PMKSA_STORE_ADD/PMKSA_STORE_DEL), AA, SPA, PMKID
+ * PMKSA_STORE_ADD continues with:
+ * akmp (le32), expiration (le64, wall clock), reauth_time (le64, wall clock),
+ * flags, FILS Cache Identifier (2), PMK length, PMK, KCK length, KCK,
+ * SSID length, SSID
+ *
+ * ERP key record (plaintext):
+ * type (PMKSA_STORE_ERP/PMKSA_STORE_ERP_DEL)
+ * PMKSA_STORE_ERP continues with:
+ * next SEQ (le32), rRK length, rRK
+ * and both types end with the keyName-NAI (the remainder of the record)
+ */
+
+#define PMKSA_STORE_ADD 1
+#define PMKSA_STORE_DEL 2
+#define PMKSA_STORE_ERP 3
+#define PMKSA_STORE_ERP_DEL 4
+
+#define PMKSA_STORE_FLAG_FILS_CACHE_ID BIT(0)
+#define PMKSA_STORE_FLAG_DPP_PFS BIT(1)
+#define PMKSA_STORE_FLAG_OPPORTUNISTIC BIT(2)
+#define PMKSA_STORE_FLAG_EXTERNAL BIT(3)
+
+#define PMKSA_STORE_MAX_LEN 384
+#define PMKSA_STORE_MAX_NAI_LEN 253
+#define PMKSA_STORE_COMPACT_MIN 64
+
+static const u8 pmksa_store_aad[] = "wpa_supplicant PMKSA store";
+
+struct pmksa_store_entry {
+	struct dl_list list;
+	struct rsn_pmksa_cache_entry *pmksa;
+	u8 ssid[SSID_MAX_LEN];
+	size_t ssid_len;
+};
+
+struct pmksa_store_erp {
+	struct dl_list list;
+	u32 next_seq;
+	size_t rrk_len;
+	u8 rrk[ERP_MAX_KEY_LEN];
+	char keyname_nai[];
+};
+
+struct pmksa_store {
+	char *file;
+	u8 key[32];
+
+	/* Current ERP keys; the EAP state machine has its own copies */
+	struct dl_list erp; /* struct pmksa_store_erp */
+	unsigned int num_erp;
+
+	/* Entries that have not yet been added to the PMKSA cache because no
+	 * matching network has been configured */
+	struct dl_list pending; /* struct pmksa_store_entry */
+	unsigned int num_pending;
+
+	unsigned int records; /* number of records in the file */
+	bool restoring;
+};
+
+
+static void pmksa_store_compact_timeout(void *eloop_ctx, void *timeout_ctx);
+
+
+static void pmksa_store_entry_free(struct pmksa_store *store,
+				   struct pmksa_store_entry *p)
+{
+	dl_list_del(&p->list);
+	store->num_pending--;
+	bin_clear_free(p->pmksa, sizeof(*p->pmksa));
+	os_free(p);
+}
+
+
+static void pmksa_store_erp_free(struct pmksa_store *store,
+				 struct pmksa_store_erp *e)
+{
+	dl_list_del(&e->list);
+	store->num_erp--;
+	bin_clear_free(e, sizeof(*e) + os_strlen(e->keyname_nai) + 1);
+}
+
+
+/* Replace or remove (rrk == NULL) the ERP key with the keyName-NAI */
+static int pmksa_store_erp_set(struct pmksa_store *store,
+			       const char *keyname_nai, const u8 *rrk,
+			       size_t rrk_len, u32 next_seq)
+{
+	struct pmksa_store_erp *e, *n;
+	size_t nai_len = os_strlen(keyname_nai);
+
+	if (nai_len == 0 || nai_len > PMKSA_STORE_MAX_NAI_LEN ||
+	    rrk_len > ERP_MAX_KEY_LEN)
+		return -1;
+
+	dl_list_for_each_safe(e, n, &store->erp, struct pmksa_store_erp, list) {
+		if (os_strcmp(e->keyname_nai, keyname_nai) == 0)
+			pmksa_store_erp_free(store, e);
+	}
+	if (!rrk)
+		return 0;
+
+	e = os_zalloc(sizeof(*e) + nai_len + 1);
+	if (!e)
+		return -1;
+	e->next_seq = next_seq;
+	os_memcpy(e->rrk, rrk, rrk_len);
+	e->rrk_len = rrk_len;
+	os_memcpy(e->keyname_nai, keyname_nai, nai_len);
+	dl_list_add_tail(&store->erp, &e->list);
+	store->num_erp++;
+	return 0;
+}
+
+
+static struct wpabuf * pmksa_store_build_erp(const char *keyname_nai,
+					     const u8 *rrk, size_t rrk_len,
+					     u32 next_seq)
+{
+	struct wpabuf *buf;
+
+	buf = wpabuf_alloc(PMKSA_STORE_MAX_LEN);
+	if (!buf)
+		return NULL;
+
+	if (rrk) {
+		wpabuf_put_u8(buf, PMKSA_STORE_ERP);
+		wpabuf_put_le32(buf, next_seq);
+		wpabuf_put_u8(buf, rrk_len);
+		wpabuf_put_data(buf, rrk, rrk_len);
+	} else {
+		wpabuf_put_u8(buf, PMKSA_STORE_ERP_DEL);
+	}
+	wpabuf_put_str(buf, keyname_nai);
+
+	return buf;
+}
+
+
+static struct wpabuf *
+pmksa_store_build_add(struct rsn_pmksa_cache_entry *entry,
+		      const u8 *ssid, size_t ssid_len)
+{
+	struct wpabuf *buf;
+	struct os_reltime now;
+	struct os_time wall;
+	u8 flags = 0;
+
+	if (entry->pmk_len > PMK_LEN_MAX || entry->kck_len > WPA_KCK_MAX_LEN ||
+	    ssid_len > SSID_MAX_LEN)
+		return NULL;
+
+	buf = wpabuf_alloc(PMKSA_STORE_MAX_LEN);
+	if (!buf)
+		return NULL;
+
+	os_get_reltime(&now);
+	os_get_time(&wall);
+
+	if (entry->fils_cache_id_set)
+		flags |= PMKSA_STORE_FLAG_FILS_CACHE_ID;
+	if (entry->dpp_pfs)
+		flags |= PMKSA_STORE_FLAG_DPP_PFS;
+	if (entry->opportunistic)
+		flags |= PMKSA_STORE_FLAG_OPPORTUNISTIC;
+	if (entry->external)
+		flags |= PMKSA_STORE_FLAG_EXTERNAL;
+
+	wpabuf_put_u8(buf, PMKSA_STORE_ADD);
+	wpabuf_put_data(buf, entry->aa, ETH_ALEN);
+	wpabuf_put_data(buf, entry->spa, ETH_ALEN);
+	wpabuf_put_data(buf, entry->pmkid, PMKID_LEN);
+	wpabuf_put_le32(buf, entry->akmp);
+	wpabuf_put_le64(buf, entry->expiration - now.sec + wall.sec);
+	wpabuf_put_le64(buf, entry->reauth_time - now.sec + wall.sec);
+	wpabuf_put_u8(buf, flags);
+	wpabuf_put_data(buf, entry->fils_cache_id, 2);
+	wpabuf_put_u8(buf, entry->pmk_len);
+	wpabuf_put_data(buf, entry->pmk, entry->pmk_len);
+	wpabuf_put_u8(buf, entry->kck_len);
+	wpabuf_put_data(buf, entry->kck, entry->kck_len);
+	wpabuf_put_u8(buf, ssid_len);
+	if (ssid_len)
+		wpabuf_put_data(buf, ssid, ssid_len);
+
+	return buf;
+}
+
+
+static int pmksa_store_append(struct pmksa_store *store, FILE *f,
+			      const struct wpabuf *plain)
+{
+	const u8 *addr[1];
+	size_t len[1];
+	u8 hdr[2], *out;
+	size_t out_len = wpabuf_len(plain) + AES_BLOCK_SIZE;
+	int ret = -1;
+
+	out = os_malloc(out_len);
+	if (!out)
+		return -1;
+
+	addr[0] = pmksa_store_aad;
+	len[0] = sizeof(pmksa_store_aad) - 1;
+	WPA_PUT_LE16(hdr, out_len);
+	if (aes_siv_encrypt(store->key, sizeof(store->key), wpabuf_head(plain),
+			    wpabuf_len(plain), 1, addr, len, out) == 0 &&
+	    fwrite(hdr, sizeof(hdr), 1, f) == 1 &&
+	    fwrite(out, out_len, 1, f) == 1)
+		ret = 0;
+
+	bin_clear_free(out, out_len);
+	return ret;
+}
+
+
+static unsigned int pmksa_store_count(struct wpa_supplicant *wpa_s)
+{
+	struct rsn_pmksa_cache_entry *entry;
+	unsigned int count = wpa_s->pmksa_store->num_pending +
+		wpa_s->pmksa_store->num_erp;
+
+	for (entry = wpa_sm_pmksa_cache_head(wpa_s->wpa); entry;
+	     entry = entry->next)
+		count++;
+
+	return count;
+}
+
+
+static void pmksa_store_write(struct wpa_supplicant *wpa_s,
+			      const struct wpabuf *plain)
+{
+	struct pmksa_store *store = wpa_s->pmksa_store;
+	FILE *f;
+
+	f = fopen(store->file, "ab");
+	if (!f || pmksa_store_append(store, f, plain) < 0)
+		wpa_printf(MSG_INFO, "PMKSA store: Failed to write to %s",
+			   store->file);
+	if (f)
+		fclose(f);
+
+	store->records++;
+	if (store->records > 2 * pmksa_store_count(wpa_s) +
+	    PMKSA_STORE_COMPACT_MIN &&
+	    !eloop_is_timeout_registered(pmksa_store_compact_timeout, wpa_s,
+					 NULL))
+		eloop_register_timeout(0, 0, pmksa_store_compact_timeout,
+				       wpa_s, NULL);
+}
+
+
+static int pmksa_store_compact(struct wpa_supplicant *wpa_s)
+{
+	struct pmksa_store *store = wpa_s->pmksa_store;
+	struct rsn_pmksa_cache_entry *entry;
+	struct pmksa_store_entry *p;
+	struct pmksa_store_erp *e;
+	struct wpabuf *plain;
+	unsigned int records = 0;
+	char *tmp;
+	size_t tmp_len;
+	FILE *f;
+	int ret = 0;
+
+	tmp_len = os_strlen(store->file) + 5;
+	tmp = os_malloc(tmp_len);
+	if (!tmp)
+		return -1;
+	os_snprintf(tmp, tmp_len, "%s.tmp", store->file);
+
+	f = fopen(tmp, "wb");
+	if (!f) {
+		wpa_printf(MSG_INFO, "PMKSA store: Failed to open %s: %s",
+			   tmp, strerror(errno));
+		os_free(tmp);
+		return -1;
+	}
+
+	for (entry = wpa_sm_pmksa_cache_head(wpa_s->wpa); entry;
+	     entry = entry->next) {
+		struct wpa_ssid *ssid = entry->network_ctx;
+
+		if (!ssid)
+			continue;
+		plain = pmksa_store_build_add(entry, ssid->ssid,
+					      ssid->ssid_len);
+		if (!plain || pmksa_store_append(store, f, plain) < 0)
+			ret = -1;
+		wpabuf_clear_free(plain);
+		records++;
+	}
+
+	dl_list_for_each(p, &store->pending, struct pmksa_store_entry, list) {
+		plain = pmksa_store_build_add(p->pmksa, p->ssid, p->ssid_len);
+		if (!plain || pmksa_store_append(store, f, plain) < 0)
+			ret = -1;
+		wpabuf_clear_free(plain);
+		records++;
+	}
+
+	dl_list_for_each(e, &store->erp, struct pmksa_store_erp, list) {
+		plain = pmksa_store_build_erp(e->keyname_nai, e->rrk,
+					      e->rrk_len, e->next_seq);
+		if (!plain || pmksa_store_append(store, f, plain) < 0)
+			ret = -1;
+		wpabuf_clear_free(plain);
+		records++;
+	}
+
+	if (fclose(f) != 0)
+		ret = -1;
+	if (ret == 0 && rename(tmp, store->file) < 0)
+		ret = -1;
+	if (ret < 0) {
+		wpa_printf(MSG_INFO, "PMKSA store: Failed to rewrite %s",
+			   store->file);
+		unlink(tmp);
+	} else {
+		wpa_printf(MSG_DEBUG, "PMKSA store: Wrote %u entries to %s",
+			   records, store->file);
+		store->records = records;
+	}
+	os_free(tmp);
+
+	return ret;
+}
+
+
+static void pmksa_store_compact_timeout(void *eloop_ctx, void *timeout_ctx)
+{
+	struct wpa_supplicant *wpa_s = eloop_ctx;
+
+	if (wpa_s->pmksa_store)
+		pmksa_store_compact(wpa_s);
+}
+
+
+static void pmksa_store_pending_del(struct pmksa_store *store, const u8 *aa,
+				    const u8 *spa, const u8 *pmkid)
+{
+	struct pmksa_store_entry *p, *n;
+
+	dl_list_for_each_safe(p, n, &store->pending, struct pmksa_store_entry,
+			      list) {
+		if (ether_addr_equal(p->pmksa->aa, aa) &&
+		    ether_addr_equal(p->pmksa->spa, spa) &&
+		    os_memcmp(p->pmksa->pmkid, pmkid, PMKID_LEN) == 0)
+			pmksa_store_entry_free(store, p);
+	}
+}
+
+
+static void pmksa_store_apply_erp(struct pmksa_store *store, const u8 *pos,
+				  size_t len)
+{
+	const u8 *end = pos + len;
+	const u8 *rrk = NULL;
+	size_t rrk_len = 0, nai_len;
+	u32 next_seq = 0;
+	char nai[PMKSA_STORE_MAX_NAI_LEN + 1];
+
+	if (*pos++ == PMKSA_STORE_ERP) {
+		if (end - pos < 4 + 1)
+			return;
+		next_seq = WPA_GET_LE32(pos);
+		pos += 4;
+		rrk_len = *pos++;
+		if (rrk_len == 0 || rrk_len > ERP_MAX_KEY_LEN ||
+		    (size_t) (end - pos) < rrk_len)
+			return;
+		rrk = pos;
+		pos += rrk_len;
+	}
+
+	nai_len = end - pos;
+	if (nai_len == 0 || nai_len > PMKSA_STORE_MAX_NAI_LEN)
+		return;
+	os_memcpy(nai, pos, nai_len);
+	nai[nai_len] = '\0';
+	pmksa_store_erp_set(store, nai, rrk, rrk_len, next_seq);
+}
+
+
+static void pmksa_store_apply(struct pmksa_store *store, const u8 *pos,
+			      size_t len, const struct os_reltime *now,
+			      const struct os_time *wall)
+{
+	const u8 *end = pos + len;
+	const u8 *aa, *spa, *pmkid;
+	struct rsn_pmksa_cache_entry *entry;
+	struct pmksa_store_entry *p;
+	u8 type, flags;
+	os_time_t expiration, reauth_time;
+	size_t pmk_len, kck_len, ssid_len;
+
+	if (len >= 1 &&
+	    (pos[0] == PMKSA_STORE_ERP || pos[0] == PMKSA_STORE_ERP_DEL)) {
+		pmksa_store_apply_erp(store, pos, len);
+		return;
+	}
+
+	if (len < 1 + 2 * ETH_ALEN + PMKID_LEN)
+		return;
+	type = *pos++;
+	aa = pos;
+	pos += ETH_ALEN;
+	spa = pos;
+	pos += ETH_ALEN;
+	pmkid = pos;
+	pos += PMKID_LEN;
+
+	/* Both ADD and DEL replace an earlier record for the same PMKSA */
+	pmksa_store_pending_del(store, aa, spa, pmkid);
+	if (type != PMKSA_STORE_ADD)
+		return;
+
+	if (end - pos < 4 + 8 + 8 + 1 + 2 + 1)
+		return;
+	entry = os_zalloc(sizeof(*entry));
+	if (!entry)
+		return;
+	os_memcpy(entry->aa, aa, ETH_ALEN);
+	os_memcpy(entry->spa, spa, ETH_ALEN);
+	os_memcpy(entry->pmkid, pmkid, PMKID_LEN);
+	entry->akmp = WPA_GET_LE32(pos);
+	pos += 4;
+	expiration = WPA_GET_LE64(pos);
+	pos += 8;
+	reauth_time = WPA_GET_LE64(pos);
+	pos += 8;
+	flags = *pos++;
+	os_memcpy(entry->fils_cache_id, pos, 2);
+	pos += 2;
+	entry->fils_cache_id_set = !!(flags & PMKSA_STORE_FLAG_FILS_CACHE_ID);
+	entry->dpp_pfs = !!(flags & PMKSA_STORE_FLAG_DPP_PFS);
+	entry->opportunistic = !!(flags & PMKSA_STORE_FLAG_OPPORTUNISTIC);
+	entry->external = !!(flags & PMKSA_STORE_FLAG_EXTERNAL);
+
+	pmk_len = *pos++;
+	if (pmk_len == 0 || pmk_len > PMK_LEN_MAX ||
+	    (size_t) (end - pos) < pmk_len + 1)
+		goto fail;
+	os_memcpy(entry->pmk, pos, pmk_len);
+	entry->pmk_len = pmk_len;
+	pos += pmk_len;
+
+	kck_len = *pos++;
+	if (kck_len > WPA_KCK_MAX_LEN || (size_t) (end - pos) < kck_len + 1)
+		goto fail;
+	os_memcpy(entry->kck, pos, kck_len);
+	entry->kck_len = kck_len;
+	pos += kck_len;
+
+	ssid_len = *pos++;
+	if (ssid_len > SSID_MAX_LEN || (size_t) (end - pos) < ssid_len)
+		goto fail;
+
+	if (expiration <= wall->sec)
+		goto fail; /* expired */
+	entry->expiration = expiration - wall->sec + now->sec;
+	entry->reauth_time = reauth_time - wall->sec + now->sec;
+
+	p = os_zalloc(sizeof(*p));
+	if (!p)
+		goto fail;
+	p->pmksa = entry;
+	os_memcpy(p->ssid, pos, ssid_len);
+	p->ssid_len = ssid_len;
+	dl_list_add_tail(&store->pending, &p->list);
+	store->num_pending++;
+	return;
+
+fail:
+	bin_clear_free(entry, sizeof(*entry));
+}
+
+
+static void pmksa_store_load(struct pmksa_store *store)
+{
+	char *data;
+	size_t len, pos = 0, rec_len;
+	const u8 *addr[1];
+	size_t alen[1];
+	u8 plain[PMKSA_STORE_MAX_LEN];
+	struct os_reltime now;
+	struct os_time wall;
+
+	data = os_readfile(store->file, &len);
+	if (!data)
+		return;
+
+	os_get_reltime(&now);
+	os_get_time(&wall);
+	addr[0] = pmksa_store_aad;
+	alen[0] = sizeof(pmksa_store_aad) - 1;
+
+	while (len - pos >= 2) {
+		rec_len = WPA_GET_LE16((u8 *) &data[pos]);
+		pos += 2;
+		if (rec_len <= AES_BLOCK_SIZE ||
+		    rec_len > sizeof(plain) + AES_BLOCK_SIZE ||
+		    rec_len > len - pos) {
+			wpa_printf(MSG_INFO,
+				   "PMKSA store: Invalid record in %s",
+				   store->file);
+			break;
+		}
+		store->records++;
+		if (aes_siv_decrypt(store->key, sizeof(store->key),
+				    (u8 *) &data[pos], rec_len, 1, addr, alen,
+				    plain) < 0)
+			wpa_printf(MSG_INFO,
+				   "PMKSA store: Failed to decrypt record");
+		else
+			pmksa_store_apply(store, plain,
+					  rec_len - AES_BLOCK_SIZE, &now,
+					  &wall);
+		pos += rec_len;
+	}
+
+	forced_memzero(plain, sizeof(plain));
+	bin_clear_free(data, len);
+
+	wpa_printf(MSG_DEBUG,
+		   "PMKSA store: Loaded %u entries and %u ERP keys from %s",
+		   store->num_pending, store->num_erp, store->file);
+}
+
+
+static void pmksa_store_restore_erp(struct wpa_supplicant *wpa_s)
+{
+	struct pmksa_store *store = wpa_s->pmksa_store;
+	struct pmksa_store_erp *e, *n;
+
+	dl_list_for_each_safe(e, n, &store->erp, struct pmksa_store_erp, list) {
+		/* This fails, e.g., without CONFIG_ERP or once all SEQ values
+		 * have been used */
+		if (eapol_sm_erp_restore_key(wpa_s->eapol, e->keyname_nai,
+					     e->rrk, e->rrk_len,
+					     e->next_seq) < 0)
+			pmksa_store_erp_free(store, e);
+	}
+}
+
+
+/**
+ * pmksa_store_restore - Add stored entries to the PMKSA cache
+ * @wpa_s: Pointer to wpa_supplicant data
+ * @ssid: Network to restore entries for or %NULL for all configured networks
+ *
+ * This is called when the store is loaded and before a connection attempt so
+ * that entries for networks that were added after the interface was
+ * initialized (e.g., over the control interface) are restored, too.
+ */
+void pmksa_store_restore(struct wpa_supplicant *wpa_s, struct wpa_ssid *ssid)
+{
+	struct pmksa_store *store = wpa_s->pmksa_store;
+	struct pmksa_store_entry *p, *n;
+	struct wpa_ssid *s;
+	struct os_reltime now;
+
+	if (!store || dl_list_empty(&store->pending))
+		return;
+
+	os_get_reltime(&now);
+	store->restoring = true;
+	dl_list_for_each_safe(p, n, &store->pending, struct pmksa_store_entry,
+			      list) {
+		if (p->pmksa->expiration <= now.sec) {
+			pmksa_store_entry_free(store, p);
+			continue;
+		}
+
+		for (s = ssid ? ssid : wpa_s->conf->ssid; s;
+		     s = ssid ? NULL : s->next) {
+			if (s->ssid_len == p->ssid_len &&
+			    os_memcmp(s->ssid, p->ssid, p->ssid_len) == 0 &&
+			    (s->key_mgmt & p->pmksa->akmp))
+				break;
+		}
+		if (!s)
+			continue;
+
+		wpa_printf(MSG_DEBUG,
+			   "PMKSA store: Restore PMKSA cache entry for " MACSTR
+			   " (network id %d)", MAC2STR(p->pmksa->aa), s->id);
+		p->pmksa->network_ctx = s;
+		wpa_sm_pmksa_cache_add_entry(wpa_s->wpa, p->pmksa);
+		p->pmksa = NULL;
+		dl_list_del(&p->list);
+		store->num_pending--;
+		os_free(p);
+	}
+	store->restoring = false;
+}
+
+
+void pmksa_store_entry_added(struct wpa_supplicant *wpa_s,
+			     struct rsn_pmksa_cache_entry *entry)
+{
+	struct pmksa_store *store = wpa_s->pmksa_store;
+	struct wpa_ssid *ssid = entry->network_ctx;
+	struct wpabuf *plain;
+
+	/* Restored entries are already in the file */
+	if (!store || store->restoring || !ssid)
+		return;
+
+	plain = pmksa_store_build_add(entry, ssid->ssid, ssid->ssid_len);
+	if (plain)
+		pmksa_store_write(wpa_s, plain);
+	wpabuf_clear_free(plain);
+}
+
+
+/**
+ * pmksa_store_erp_update - Store a new, updated, or removed ERP key
+ * @wpa_s: Pointer to wpa_supplicant data
+ * @keyname_nai: keyName-NAI of the key
+ * @rrk: rRK or %NULL if the key was removed
+ * @rrk_len: Length of rRK in octets
+ * @next_seq: Next SEQ to use with the key
+ */
+void pmksa_store_erp_update(struct wpa_supplicant *wpa_s,
+			    const char *keyname_nai, const u8 *rrk,
+			    size_t rrk_len, u32 next_seq)
+{
+	struct pmksa_store *store = wpa_s->pmksa_store;
+	struct wpabuf *plain;
+
+	if (!store ||
+	    pmksa_store_erp_set(store, keyname_nai, rrk, rrk_len,
+				next_seq) < 0)
+		return;
+
+	plain = pmksa_store_build_erp(keyname_nai, rrk, rrk_len, next_seq);
+	if (plain)
+		pmksa_store_write(wpa_s, plain);
+	wpabuf_clear_free(plain);
+}
+
+
+/**
+ * pmksa_store_erp_flush - Remove all stored ERP keys
+ * @wpa_s: Pointer to wpa_supplicant data
+ */
+void pmksa_store_erp_flush(struct wpa_supplicant *wpa_s)
+{
+	struct pmksa_store *store = wpa_s->pmksa_store;
+	struct pmksa_store_erp *e, *n;
+
+	if (!store || dl_list_empty(&store->erp))
+		return;
+
+	dl_list_for_each_safe(e, n, &store->erp, struct pmksa_store_erp, list)
+		pmksa_store_erp_free(store, e);
+	pmksa_store_compact(wpa_s);
+}
+
+
+void pmksa_store_entry_removed(struct wpa_supplicant *wpa_s,
+			       struct rsn_pmksa_cache_entry *entry)
+{
+	struct wpabuf *plain;
+
+	if (!wpa_s->pmksa_store || !entry->network_ctx)
+		return;
+
+	plain = wpabuf_alloc(1 + 2 * ETH_ALEN + PMKID_LEN);
+	if (!plain)
+		return;
+	wpabuf_put_u8(plain, PMKSA_STORE_DEL);
+	wpabuf_put_data(plain, entry->aa, ETH_ALEN);
+	wpabuf_put_data(plain, entry->spa, ETH_ALEN);
+	wpabuf_put_data(plain, entry->pmkid, PMKID_LEN);
+	pmksa_store_write(wpa_s, plain);
+	wpabuf_free(plain);
+}
+
+
+int pmksa_store_init(struct wpa_supplicant *wpa_s)
+{
+	struct pmksa_store *store;
+	const struct wpabuf *key = wpa_s->conf->pmksa_store_key;
+
+	if (!wpa_s->conf->pmksa_store_file)
+		return 0;
+
+	if (!key || wpabuf_len(key) != sizeof(store->key)) {
+		wpa_printf(MSG_ERROR,
+			   "PMKSA store: pmksa_store_key needs to be a 256-bit key");
+		return -1;
+	}
+
+	store = os_zalloc(sizeof(*store));
+	if (!store)
+		return -1;
+	store->file = os_strdup(wpa_s->conf->pmksa_store_file);
+	if (!store->file) {
+		os_free(store);
+		return -1;
+	}
+	os_memcpy(store->key, wpabuf_head(key), sizeof(store->key));
+	dl_list_init(&store->pending);
+	dl_list_init(&store->erp);
+	wpa_s->pmksa_store = store;
+
+	pmksa_store_load(store);
+	pmksa_store_restore(wpa_s, NULL);
+	pmksa_store_restore_erp(wpa_s);
+	pmksa_store_compact(wpa_s);
+
+	return 0;
+}
+
+
+void pmksa_store_deinit(struct wpa_supplicant *wpa_s)
+{
+	struct pmksa_store *store = wpa_s->pmksa_store;
+	struct pmksa_store_entry *p, *n;
+	struct pmksa_store_erp *e, *n2;
+
+	if (!store)
+		return;
+
+	eloop_cancel_timeout(pmksa_store_compact_timeout, wpa_s, NULL);
+	dl_list_for_each_safe(p, n, &store->pending, struct pmksa_store_entry,
+			      list)
+		pmksa_store_entry_free(store, p);
+	dl_list_for_each_safe(e, n2, &store->erp, struct pmksa_store_erp, list)
+		pmksa_store_erp_free(store, e);
+	os_free(store->file);
+	bin_clear_free(store, sizeof(*store));
+	wpa_s->pmksa_store = NULL;
+}
@@ -0,0 +1,67 @@
+/*
+ * wpa_supplicant - Persistent PMKSA cache and ERP keys
+ *
+ * This software may be distributed under the terms of the BSD license.
+ * See README for more details.
+ */
+
+#ifndef PMKSA_STORE_H
+#define PMKSA_STORE_H
+
+struct rsn_pmksa_cache_entry;
+
+#ifdef CONFIG_PMKSA_STORE
+
+int pmksa_store_init(struct wpa_supplicant *wpa_s);
+void pmksa_store_deinit(struct wpa_supplicant *wpa_s);
+void pmksa_store_restore(struct wpa_supplicant *wpa_s, struct wpa_ssid *ssid);
+void pmksa_store_entry_added(struct wpa_supplicant *wpa_s,
+			     struct rsn_pmksa_cache_entry *entry);
+void pmksa_store_entry_removed(struct wpa_supplicant *wpa_s,
+			       struct rsn_pmksa_cache_entry *entry);
+void pmksa_store_erp_update(struct wpa_supplicant *wpa_s,
+			    const char *keyname_nai, const u8 *rrk,
+			    size_t rrk_len, u32 next_seq);
+void pmksa_store_erp_flush(struct wpa_supplicant *wpa_s);
+
+#else /* CONFIG_PMKSA_STORE */
+
+static inline int pmksa_store_init(struct wpa_supplicant *wpa_s)
+{
+	return 0;
+}
+
+static inline void pmksa_store_deinit(struct wpa_supplicant *wpa_s)
+{
+}
+
+static inline void pmksa_store_restore(struct wpa_supplicant *wpa_s,
+				       struct wpa_ssid *ssid)
+{
+}
+
+static inline void pmksa_store_entry_added(struct wpa_supplicant *wpa_s,
+					   struct rsn_pmksa_cache_entry *entry)
+{
+}
+
+static inline void
+pmksa_store_entry_removed(struct wpa_supplicant *wpa_s,
+			  struct rsn_pmksa_cache_entry *entry)
+{
+}
+
+static inline void pmksa_store_erp_update(struct wpa_supplicant *wpa_s,
+					  const char *keyname_nai,
+					  const u8 *rrk, size_t rrk_len,
+					  u32 next_seq)
+{
+}
+
+static inline void pmksa_store_erp_flush(struct wpa_supplicant *wpa_s)
+{
+}
+
+#endif /* CONFIG_PMKSA_STORE */
+
+#endif /* PMKSA_STORE_H */
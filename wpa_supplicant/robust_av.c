@@ -472,6 +472,51 @@ static struct wpabuf * allocate_scs_buf(struct scs_desc_elem *desc_elem,
 }
 
 
+/**
+ * wpas_scs_get_active - Get an active or requested SCS descriptor
+ * @wpa_s: Pointer to wpa_supplicant data
+ * @scs_id: SCSID
+ * Returns: Pointer to the SCS descriptor or %NULL if not found
+ */
+struct active_scs_elem * wpas_scs_get_active(struct wpa_supplicant *wpa_s,
+					     u8 scs_id)
+{
+	struct active_scs_elem *scs_desc;
+
+	scs_desc = wpa_s->active_scs_hash[ACTIVE_SCS_HASH(scs_id)];
+	while (scs_desc && scs_desc->scs_id != scs_id)
+		scs_desc = scs_desc->hnext;
+	return scs_desc;
+}
+
+
+static void scs_active_add(struct wpa_supplicant *wpa_s,
+			   struct active_scs_elem *scs_desc)
+{
+	struct active_scs_elem **head;
+
+	head = &wpa_s->active_scs_hash[ACTIVE_SCS_HASH(scs_desc->scs_id)];
+	scs_desc->hnext = *head;
+	*head = scs_desc;
+	dl_list_add(&wpa_s->active_scs_ids, &scs_desc->list);
+}
+
+
+static void scs_active_del(struct wpa_supplicant *wpa_s,
+			   struct active_scs_elem *scs_desc)
+{
+	struct active_scs_elem **pos;
+
+	pos = &wpa_s->active_scs_hash[ACTIVE_SCS_HASH(scs_desc->scs_id)];
+	while (*pos && *pos != scs_desc)
+		pos = &(*pos)->hnext;
+	if (*pos)
+		*pos = scs_desc->hnext;
+	dl_list_del(&scs_desc->list);
+	os_free(scs_desc);
+}
+
+
 static void scs_request_timer(void *eloop_ctx, void *timeout_ctx)
 {
 	struct wpa_supplicant *wpa_s = eloop_ctx;
@@ -486,7 +531,7 @@ static void scs_request_timer(void *eloop_ctx, void *timeout_ctx)
 		u8 bssid[ETH_ALEN] = { 0 };
 		const u8 *src;
 
-		if (scs_desc->status == SCS_DESC_SUCCESS)
+		if (!scs_desc->pending)
 			continue;
 
 		if (wpa_s->current_bss)
@@ -498,10 +543,14 @@ static void scs_request_timer(void *eloop_ctx, void *timeout_ctx)
 			" SCSID=%u status_code=timedout", MAC2STR(src),
 			scs_desc->scs_id);
 
-		dl_list_del(&scs_desc->list);
+		/* A descriptor that was set up before remains active */
+		scs_desc->pending = false;
+		if (scs_desc->status == SCS_DESC_SUCCESS)
+			continue;
+
 		wpa_printf(MSG_INFO, "%s: SCSID %d removed after timeout",
 			   __func__, scs_desc->scs_id);
-		os_free(scs_desc);
+		scs_active_del(wpa_s, scs_desc);
 	}
 
 	eloop_cancel_timeout(scs_request_timer, wpa_s, NULL);
@@ -518,6 +567,7 @@ int wpas_send_scs_req(struct wpa_supplicant *wpa_s)
 	int ret = -1;
 	unsigned int i;
 	bool allow_scs_traffic_desc = false;
+	struct os_reltime now;
 
 	if (wpa_s->wpa_state != WPA_COMPLETED || !wpa_s->current_ssid)
 		return -1;
@@ -582,20 +632,27 @@ int wpas_send_scs_req(struct wpa_supplicant *wpa_s)
 		goto end;
 	}
 
+	os_get_reltime(&now);
 	desc_elem = wpa_s->scs_robust_av_req.scs_desc_elems;
 	for (i = 0; i < wpa_s->scs_robust_av_req.num_scs_desc;
 	     i++, desc_elem++) {
 		struct active_scs_elem *active_scs_elem;
 
-		if (desc_elem->request_type != SCS_REQ_ADD)
+		active_scs_elem = wpas_scs_get_active(wpa_s, desc_elem->scs_id);
+		if (desc_elem->request_type == SCS_REQ_ADD && !active_scs_elem) {
+			active_scs_elem = os_zalloc(sizeof(*active_scs_elem));
+			if (!active_scs_elem)
+				break;
+			active_scs_elem->scs_id = desc_elem->scs_id;
+			active_scs_elem->status = SCS_DESC_SENT;
+			scs_active_add(wpa_s, active_scs_elem);
+		}
+		if (!active_scs_elem)
 			continue;
 
-		active_scs_elem = os_malloc(sizeof(struct active_scs_elem));
-		if (!active_scs_elem)
-			break;
-		active_scs_elem->scs_id = desc_elem->scs_id;
-		active_scs_elem->status = SCS_DESC_SENT;
-		dl_list_add(&wpa_s->active_scs_ids, &active_scs_elem->list);
+		active_scs_elem->pending = true;
+		active_scs_elem->pending_type = desc_elem->request_type;
+		active_scs_elem->sent = now;
 	}
 
 	/*
@@ -843,6 +900,7 @@ void wpas_handle_robust_av_scs_recv_action(struct wpa_supplicant *wpa_s,
 	unsigned int i, count, num_active_scs, j = 0;
 	struct active_scs_elem *scs_desc, *prev;
 	int *scs_resp[2];
+	struct os_reltime now, age;
 
 	if (len < 2)
 		return;
@@ -881,53 +939,56 @@ void wpas_handle_robust_av_scs_recv_action(struct wpa_supplicant *wpa_s,
 		return;
 	}
 
-	scs_resp[0] = (int *) os_zalloc(num_active_scs);
+	scs_resp[0] = (int *) os_calloc(num_active_scs, sizeof(int));
 	if (!scs_resp[0]) {
 		wpa_printf(MSG_ERROR, "Failed to allocate memory for scs_resp");
 		return;
 	}
 
-	scs_resp[1] = (int *) os_zalloc(num_active_scs);
+	scs_resp[1] = (int *) os_calloc(num_active_scs, sizeof(int));
 	if (!scs_resp[1]) {
 		os_free(scs_resp[0]);
 		wpa_printf(MSG_ERROR, "Failed to allocate memory for scs_resp");
 		return;
 	}
 
+	os_get_reltime(&now);
 	for (i = 0; i < count; i++) {
 		u8 id;
 		u16 status;
-		bool scs_desc_found = false;
 
 		id = *buf++;
 		status = WPA_GET_LE16(buf);
 		buf += 2;
 		len -= 3;
 
-		dl_list_for_each(scs_desc, &wpa_s->active_scs_ids,
-				 struct active_scs_elem, list) {
-			if (id == scs_desc->scs_id) {
-				scs_desc_found = true;
-				break;
-			}
-		}
-
-		if (!scs_desc_found) {
+		scs_desc = wpas_scs_get_active(wpa_s, id);
+		if (!scs_desc || !scs_desc->pending) {
 			wpa_printf(MSG_INFO, "SCS: SCS ID invalid %u", id);
 			continue;
 		}
 
-		if (status != WLAN_STATUS_SUCCESS) {
-			dl_list_del(&scs_desc->list);
-			os_free(scs_desc);
-		} else if (status == WLAN_STATUS_SUCCESS) {
-			scs_desc->status = SCS_DESC_SUCCESS;
-		}
+		os_reltime_sub(&now, &scs_desc->sent, &age);
+		scs_desc->setup_usec = age.sec * 1000000 + age.usec;
+		scs_desc->pending = false;
+		wpa_printf(MSG_DEBUG,
+			   "SCS: Response for SCSID %u (request type %d) after %u usec",
+			   id, scs_desc->pending_type, scs_desc->setup_usec);
 
 		wpa_msg(wpa_s, MSG_INFO, WPA_EVENT_SCS_RESULT "bssid=" MACSTR
-			" SCSID=%u status_code=%u", MAC2STR(src), id, status);
+			" SCSID=%u status_code=%u setup_usec=%u", MAC2STR(src),
+			id, status, scs_desc->setup_usec);
 		scs_resp[0][j] = id;
 		scs_resp[1][j++] = status;
+
+		if (status == WLAN_STATUS_SUCCESS &&
+		    scs_desc->pending_type == SCS_REQ_REMOVE)
+			scs_active_del(wpa_s, scs_desc);
+		else if (status == WLAN_STATUS_SUCCESS)
+			scs_desc->status = SCS_DESC_SUCCESS;
+		else if (scs_desc->status != SCS_DESC_SUCCESS)
+			scs_active_del(wpa_s, scs_desc);
+		/* A rejected change or removal leaves the descriptor active */
 	}
 
 	eloop_cancel_timeout(scs_request_timer, wpa_s, NULL);
@@ -935,7 +996,7 @@ void wpas_handle_robust_av_scs_recv_action(struct wpa_supplicant *wpa_s,
 
 	dl_list_for_each_safe(scs_desc, prev, &wpa_s->active_scs_ids,
 			      struct active_scs_elem, list) {
-		if (scs_desc->status != SCS_DESC_SUCCESS) {
+		if (scs_desc->pending) {
 			wpa_msg(wpa_s, MSG_INFO,
 				WPA_EVENT_SCS_RESULT "bssid=" MACSTR
 				" SCSID=%u status_code=response_not_received",
@@ -944,8 +1005,9 @@ void wpas_handle_robust_av_scs_recv_action(struct wpa_supplicant *wpa_s,
 				scs_resp[0][j] = scs_desc->scs_id;
 				scs_resp[1][j++] = -1; /* TIMEOUT indicator for AIDL */
 			}
-			dl_list_del(&scs_desc->list);
-			os_free(scs_desc);
+			scs_desc->pending = false;
+			if (scs_desc->status != SCS_DESC_SUCCESS)
+				scs_active_del(wpa_s, scs_desc);
 		}
 	}
 	wpas_notify_qos_policy_scs_response(wpa_s, j, scs_resp);
@@ -959,10 +1021,8 @@ static void wpas_clear_active_scs_ids(struct wpa_supplicant *wpa_s)
 	struct active_scs_elem *scs_elem;
 
 	while ((scs_elem = dl_list_first(&wpa_s->active_scs_ids,
-					 struct active_scs_elem, list))) {
-		dl_list_del(&scs_elem->list);
-		os_free(scs_elem);
-	}
+					 struct active_scs_elem, list)))
+		scs_active_del(wpa_s, scs_elem);
 }
 
 
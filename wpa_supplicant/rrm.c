@@ -49,10 +49,33 @@ void wpas_rrm_reset(struct wpa_supplicant *wpa_s)
 	if (wpa_s->rrm.notify_neighbor_rep)
 		wpas_rrm_neighbor_rep_timeout_handler(&wpa_s->rrm, NULL);
 	wpa_s->rrm.next_neighbor_rep_token = 1;
+	os_free(wpa_s->rrm.neighbor_freqs);
+	wpa_s->rrm.neighbor_freqs = NULL;
 	wpas_clear_beacon_rep_data(wpa_s);
 }
 
 
+static void wpas_rrm_store_neighbor_freqs(struct wpa_supplicant *wpa_s,
+					  const u8 *pos, size_t len)
+{
+	const struct element *elem;
+	int freq;
+
+	os_free(wpa_s->rrm.neighbor_freqs);
+	wpa_s->rrm.neighbor_freqs = NULL;
+
+	for_each_element_id(elem, WLAN_EID_NEIGHBOR_REPORT, pos, len) {
+		/* BSSID, BSSID Information, Operating Class, Channel */
+		if (elem->datalen < ETH_ALEN + 4 + 2)
+			continue;
+		freq = ieee80211_chan_to_freq(NULL, elem->data[ETH_ALEN + 4],
+					      elem->data[ETH_ALEN + 5]);
+		if (freq > 0)
+			int_array_add_unique(&wpa_s->rrm.neighbor_freqs, freq);
+	}
+}
+
+
 /*
  * wpas_rrm_process_neighbor_rep - Handle incoming neighbor report
  * @wpa_s: Pointer to wpa_supplicant
@@ -78,6 +101,8 @@ void wpas_rrm_process_neighbor_rep(struct wpa_supplicant *wpa_s,
 	eloop_cancel_timeout(wpas_rrm_neighbor_rep_timeout_handler, &wpa_s->rrm,
 			     NULL);
 
+	wpas_rrm_store_neighbor_freqs(wpa_s, report + 1, report_len - 1);
+
 	if (!wpa_s->rrm.notify_neighbor_rep) {
 		wpa_msg(wpa_s, MSG_INFO, "RRM: Unexpected neighbor report");
 		return;
@@ -864,6 +889,30 @@ static int wpas_beacon_rep_add_frame_body(struct bitfield *eids,
 }
 
 
+/* Maximum length of a Measurement Report element */
+#define BEACON_REP_ELEM_MAX_LEN (2 + 255)
+
+
+/*
+ * Make room for len more octets in the report buffer. The buffer grows by at
+ * least its current size and starts at the size of one Action frame, so that
+ * a report covering a large number of BSSs is not reallocated for every
+ * element.
+ */
+static int wpas_beacon_rep_reserve(struct wpabuf **buf, size_t len)
+{
+	size_t add;
+
+	if (*buf && wpabuf_tailroom(*buf) >= len)
+		return 0;
+
+	add = *buf ? wpabuf_size(*buf) : IEEE80211_MAX_MMPDU_SIZE;
+	if (add < len)
+		add = len;
+	return wpabuf_resize(buf, add);
+}
+
+
 static int wpas_add_beacon_rep_elem(struct beacon_rep_data *data,
 				    struct wpa_bss *bss,
 				    struct wpabuf **wpa_buf,
@@ -871,27 +920,32 @@ static int wpas_add_beacon_rep_elem(struct beacon_rep_data *data,
 				    const u8 **ie, size_t *ie_len, u8 idx)
 {
 	int ret;
-	u8 *buf, *pos;
+	u8 *elem, *buf, *pos;
 	u32 subelems_len = REPORTED_FRAME_BODY_SUBELEM_LEN +
 		(data->last_indication ?
 		 BEACON_REPORT_LAST_INDICATION_SUBELEM_LEN : 0);
+	size_t hdr_len = sizeof(struct rrm_measurement_report_element);
 
-	/* Maximum element length: Beacon Report element + Reported Frame Body
-	 * subelement + all IEs of the reported Beacon frame + Reported Frame
-	 * Body Fragment ID subelement */
-	buf = os_malloc(sizeof(*rep) + 14 + *ie_len + subelems_len);
-	if (!buf)
+	/*
+	 * The frame body subelement is limited so that the element fits in
+	 * the maximum element length, so the element can be assembled in
+	 * place at the end of the report buffer.
+	 */
+	if (wpas_beacon_rep_reserve(wpa_buf, BEACON_REP_ELEM_MAX_LEN) < 0)
 		return -1;
 
+	elem = wpabuf_mhead_u8(*wpa_buf) + wpabuf_len(*wpa_buf);
+	buf = elem + hdr_len;
 	os_memcpy(buf, rep, sizeof(*rep));
 
 	ret = wpas_beacon_rep_add_frame_body(data->eids, data->ext_eids,
 					     data->report_detail,
 					     bss, buf + sizeof(*rep),
-					     14 + *ie_len, ie, ie_len,
-					     idx == 0);
+					     BEACON_REP_ELEM_MAX_LEN - hdr_len -
+					     sizeof(*rep) - subelems_len,
+					     ie, ie_len, idx == 0);
 	if (ret < 0)
-		goto out;
+		return ret;
 
 	pos = buf + ret + sizeof(*rep);
 	pos[0] = WLAN_BEACON_REPORT_SUBELEM_FRAME_BODY_FRAGMENT_ID;
@@ -921,13 +975,14 @@ static int wpas_add_beacon_rep_elem(struct beacon_rep_data *data,
 		pos[2] = 0;
 	}
 
-	ret = wpas_rrm_report_elem(wpa_buf, data->token,
-				   MEASUREMENT_REPORT_MODE_ACCEPT,
-				   MEASURE_TYPE_BEACON, buf,
-				   ret + sizeof(*rep) + subelems_len);
-out:
-	os_free(buf);
-	return ret;
+	elem[0] = WLAN_EID_MEASURE_REPORT;
+	elem[1] = 3 + ret + sizeof(*rep) + subelems_len;
+	elem[2] = data->token;
+	elem[3] = MEASUREMENT_REPORT_MODE_ACCEPT;
+	elem[4] = MEASURE_TYPE_BEACON;
+	wpabuf_put(*wpa_buf, 2 + elem[1]);
+
+	return 0;
 }
 
 
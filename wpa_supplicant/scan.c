@@ -23,6 +23,7 @@
 #include "bss.h"
 #include "scan.h"
 #include "mesh.h"
+#include "wnm_sta.h"
 
 static struct wpabuf * wpa_supplicant_extra_ies(struct wpa_supplicant *wpa_s);
 
@@ -181,6 +182,153 @@ static void wpa_supplicant_assoc_try(struct wpa_supplicant *wpa_s,
 }
 
 
+static bool wpas_scan_params_mergeable(struct wpa_supplicant *wpa_s,
+				       const struct wpa_driver_scan_params *a,
+				       struct wpa_supplicant *other,
+				       const struct wpa_driver_scan_params *b)
+{
+	size_t i, j, num_ssids = a->num_ssids;
+
+	if (a->bssid || b->bssid || a->filter_ssids || b->filter_ssids ||
+	    a->duration || b->duration || a->mac_addr || b->mac_addr ||
+	    a->p2p_probe != b->p2p_probe || a->oce_scan != b->oce_scan ||
+	    a->min_probe_req_content || b->min_probe_req_content ||
+	    a->link_id != b->link_id)
+		return false;
+
+	/* The Probe Request frames are sent from the triggering interface */
+	if ((wpa_s->mac_addr_rand_enable & MAC_ADDR_RAND_SCAN) !=
+	    (other->mac_addr_rand_enable & MAC_ADDR_RAND_SCAN))
+		return false;
+
+	if (a->extra_ies_len != b->extra_ies_len ||
+	    (a->extra_ies_len &&
+	     os_memcmp(a->extra_ies, b->extra_ies, a->extra_ies_len) != 0))
+		return false;
+
+	for (i = 0; i < b->num_ssids; i++) {
+		for (j = 0; j < a->num_ssids; j++) {
+			if (a->ssids[j].ssid_len == b->ssids[i].ssid_len &&
+			    os_memcmp(a->ssids[j].ssid, b->ssids[i].ssid,
+				      a->ssids[j].ssid_len) == 0)
+				break;
+		}
+		if (j == a->num_ssids)
+			num_ssids++;
+	}
+
+	return num_ssids <= (size_t) wpa_s->max_scan_ssids &&
+		num_ssids <= WPAS_MAX_SCAN_SSIDS;
+}
+
+
+static void wpas_merge_scan_params(struct wpa_driver_scan_params *dst,
+				   const struct wpa_driver_scan_params *src)
+{
+	size_t i, j;
+
+	for (i = 0; i < src->num_ssids; i++) {
+		for (j = 0; j < dst->num_ssids; j++) {
+			if (dst->ssids[j].ssid_len == src->ssids[i].ssid_len &&
+			    os_memcmp(dst->ssids[j].ssid, src->ssids[i].ssid,
+				      dst->ssids[j].ssid_len) == 0)
+				break;
+		}
+		if (j < dst->num_ssids)
+			continue;
+		if (src->ssids[i].ssid_len) {
+			u8 *ssid = os_memdup(src->ssids[i].ssid,
+					     src->ssids[i].ssid_len);
+
+			if (!ssid)
+				continue;
+			dst->ssids[dst->num_ssids].ssid = ssid;
+		} else {
+			dst->ssids[dst->num_ssids].ssid = NULL;
+		}
+		dst->ssids[dst->num_ssids].ssid_len = src->ssids[i].ssid_len;
+		dst->num_ssids++;
+	}
+
+	/* A request without a frequency list covers all channels */
+	if (!dst->freqs || !src->freqs) {
+		os_free(dst->freqs);
+		dst->freqs = NULL;
+	} else {
+		int_array_concat(&dst->freqs, src->freqs);
+		int_array_sort_unique(dst->freqs);
+	}
+
+	dst->only_new_results |= src->only_new_results;
+	dst->low_priority &= src->low_priority;
+	dst->non_coloc_6ghz |= src->non_coloc_6ghz;
+	dst->p2p_include_6ghz |= src->p2p_include_6ghz;
+}
+
+
+/*
+ * Combine the scan requests that other interfaces on the same radio have
+ * queued as pending radio works with the scan that is about to be started.
+ * The merged interfaces receive the results as their own scan results.
+ */
+static void wpas_merge_pending_scans(struct wpa_supplicant *wpa_s,
+				     struct wpa_driver_scan_params *params)
+{
+	struct wpa_radio_work *work, *tmp;
+
+	if (!wpa_s->conf->scan_merge)
+		return;
+
+	dl_list_for_each_safe(work, tmp, &wpa_s->radio->work,
+			      struct wpa_radio_work, list) {
+		struct wpa_supplicant *other = work->wpa_s;
+		struct wpa_driver_scan_params *other_params = work->ctx;
+
+		if (work->started || other == wpa_s ||
+		    os_strcmp(work->type, "scan") != 0 || !other_params ||
+		    !wpas_scan_params_mergeable(wpa_s, params, other,
+						other_params))
+			continue;
+
+		wpa_dbg(other, MSG_DEBUG,
+			"Merge pending scan into the scan on %s",
+			wpa_s->ifname);
+		wpas_merge_scan_params(params, other_params);
+		wpa_scan_free_params(other_params);
+		work->ctx = NULL;
+		radio_work_done(work);
+
+		other->scan_merged = true;
+		os_get_reltime(&other->scan_trigger_time);
+		other->scan_runs++;
+		other->normal_scans++;
+		wpa_supplicant_notify_scanning(other, 1);
+		wpa_s->radio->merged_scans++;
+	}
+}
+
+
+/**
+ * wpas_abort_merged_scans - Reschedule scans merged into a failed scan
+ * @wpa_s: Pointer to wpa_supplicant data for the interface that ran the scan
+ */
+void wpas_abort_merged_scans(struct wpa_supplicant *wpa_s)
+{
+	struct wpa_supplicant *ifs;
+
+	dl_list_for_each(ifs, &wpa_s->radio->ifaces, struct wpa_supplicant,
+			 radio_list) {
+		if (!ifs->scan_merged)
+			continue;
+		ifs->scan_merged = false;
+		wpa_supplicant_notify_scanning(ifs, 0);
+		/* Restore scan_req since we will try to scan again */
+		ifs->scan_req = ifs->last_scan_req;
+		wpa_supplicant_req_scan(ifs, 1, 0);
+	}
+}
+
+
 static void wpas_trigger_scan_cb(struct wpa_radio_work *work, int deinit)
 {
 	struct wpa_supplicant *wpa_s = work->wpa_s;
@@ -195,9 +343,12 @@ static void wpas_trigger_scan_cb(struct wpa_radio_work *work, int deinit)
 		wpa_supplicant_notify_scanning(wpa_s, 0);
 		wpas_notify_scan_done(wpa_s, 0);
 		wpa_s->scan_work = NULL;
+		wpas_abort_merged_scans(wpa_s);
 		return;
 	}
 
+	wpas_merge_pending_scans(wpa_s, params);
+
 	if ((wpa_s->mac_addr_rand_enable & MAC_ADDR_RAND_SCAN) &&
 	    wpa_s->wpa_state <= WPA_SCANNING)
 		wpa_setup_mac_addr_rand_params(params, wpa_s->mac_addr_scan);
@@ -208,9 +359,11 @@ static void wpas_trigger_scan_cb(struct wpa_radio_work *work, int deinit)
 		wpa_scan_free_params(params);
 		wpa_msg(wpa_s, MSG_INFO, WPA_EVENT_SCAN_FAILED "ret=-1");
 		radio_work_done(work);
+		wpas_abort_merged_scans(wpa_s);
 		return;
 	}
 
+	wpas_connect_trace(wpa_s, WPAS_CONNECT_SCAN_START);
 	wpa_supplicant_notify_scanning(wpa_s, 1);
 
 	if (wpa_s->clear_driver_scan_cache) {
@@ -218,6 +371,8 @@ static void wpas_trigger_scan_cb(struct wpa_radio_work *work, int deinit)
 			   "Request driver to clear scan cache due to local BSS flush");
 		params->only_new_results = 1;
 	}
+	if (wpa_s->conf->scan_res_filter_freqs && params->freqs)
+		params->filter_freqs = 1;
 	ret = wpa_drv_scan(wpa_s, params);
 	/*
 	 * Store the obtained vendor scan cookie (if any) in wpa_s context.
@@ -251,6 +406,7 @@ static void wpas_trigger_scan_cb(struct wpa_radio_work *work, int deinit)
 		wpa_msg(wpa_s, MSG_INFO, WPA_EVENT_SCAN_FAILED "ret=%d%s",
 			ret, retry ? " retry=1" : "");
 		radio_work_done(work);
+		wpas_abort_merged_scans(wpa_s);
 
 		if (retry) {
 			/* Restore scan_req since we will try to scan again */
@@ -337,6 +493,7 @@ int wpa_supplicant_trigger_scan(struct wpa_supplicant *wpa_s,
 	}
 
 	wpa_s->wps_scan_done = false;
+	wpas_connect_trace(wpa_s, WPAS_CONNECT_SCAN_REQUEST);
 
 	return 0;
 }
@@ -431,6 +588,171 @@ wpa_supplicant_build_filter_ssids(struct wpa_config *conf, size_t *num_ssids)
 }
 
 
+#define ROAM_SCAN_MAX_PARTIAL 3
+#define ROAM_SCAN_CACHE_AGE 120
+#define ROAM_SCAN_MAX_CAND 64
+
+struct roam_scan_cand {
+	int freq;
+	int score;
+};
+
+
+static void roam_scan_add(struct roam_scan_cand *cand, size_t *num, int freq,
+			  int score)
+{
+	size_t i;
+
+	if (freq <= 0)
+		return;
+
+	for (i = 0; i < *num; i++) {
+		if (cand[i].freq == freq) {
+			cand[i].score += score;
+			return;
+		}
+	}
+
+	if (*num == ROAM_SCAN_MAX_CAND)
+		return;
+	cand[*num].freq = freq;
+	cand[*num].score = score;
+	(*num)++;
+}
+
+
+static int roam_scan_cand_cmp(const void *a, const void *b)
+{
+	const struct roam_scan_cand *ca = a, *cb = b;
+
+	return cb->score - ca->score;
+}
+
+
+/**
+ * wpas_roam_scan_freqs - Select channels for a roaming scan
+ * @wpa_s: Pointer to wpa_supplicant data
+ * Returns: Allocated zero terminated frequency list or %NULL for a full scan
+ *
+ * While connected, the channels of the BSS transition candidates, the latest
+ * neighbor report, and the recently seen BSSs of the current ESS are ranked and
+ * up to roam_scan_max_freqs of them are returned. A full scan is requested
+ * after ROAM_SCAN_MAX_PARTIAL partial scans that did not result in a roam.
+ */
+int * wpas_roam_scan_freqs(struct wpa_supplicant *wpa_s)
+{
+	struct roam_scan_cand cand[ROAM_SCAN_MAX_CAND];
+	struct wpa_bss *cur = wpa_s->current_bss, *bss;
+	struct os_reltime now;
+	size_t i, num = 0, max = wpa_s->conf->roam_scan_max_freqs;
+	int *freqs;
+	char msg[200], *pos, *end;
+
+	if (!max || wpa_s->wpa_state != WPA_COMPLETED || !cur)
+		return NULL;
+
+	if (!ether_addr_equal(wpa_s->roam_scan_bssid, wpa_s->bssid)) {
+		os_memcpy(wpa_s->roam_scan_bssid, wpa_s->bssid, ETH_ALEN);
+		wpa_s->roam_scan_partial_count = 0;
+	}
+
+	if (wpa_s->roam_scan_partial_count >= ROAM_SCAN_MAX_PARTIAL) {
+		wpa_dbg(wpa_s, MSG_DEBUG,
+			"Roam scan: Full scan after %u partial scans",
+			wpa_s->roam_scan_partial_count);
+		goto full;
+	}
+
+	roam_scan_add(cand, &num, cur->freq, 100);
+
+#ifdef CONFIG_WNM
+	for (i = 0; i < wpa_s->wnm_num_neighbor_report; i++) {
+		struct neighbor_report *nei;
+
+		nei = &wpa_s->wnm_neighbor_report_elements[i];
+		roam_scan_add(cand, &num, nei->freq,
+			      300 + (nei->preference_present ?
+				     nei->preference : 0));
+	}
+#endif /* CONFIG_WNM */
+
+	for (i = 0; wpa_s->rrm.neighbor_freqs &&
+		     wpa_s->rrm.neighbor_freqs[i]; i++)
+		roam_scan_add(cand, &num, wpa_s->rrm.neighbor_freqs[i], 200);
+
+	/* Recent scan results, including the ones from bgscan, of the same
+	 * ESS */
+	os_get_reltime(&now);
+	dl_list_for_each(bss, &wpa_s->bss, struct wpa_bss, list) {
+		if (bss == cur || bss->ssid_len != cur->ssid_len ||
+		    os_memcmp(bss->ssid, cur->ssid, cur->ssid_len) != 0 ||
+		    os_reltime_expired(&now, &bss->last_update,
+				       ROAM_SCAN_CACHE_AGE))
+			continue;
+		roam_scan_add(cand, &num, bss->freq, 50);
+	}
+
+	if (num < 2) {
+		wpa_dbg(wpa_s, MSG_DEBUG,
+			"Roam scan: No known candidate channels");
+		goto full;
+	}
+
+	qsort(cand, num, sizeof(cand[0]), roam_scan_cand_cmp);
+	if (num > max)
+		num = max;
+
+	freqs = os_calloc(num + 1, sizeof(int));
+	if (!freqs)
+		goto full;
+
+	pos = msg;
+	end = msg + sizeof(msg);
+	*pos = '\0';
+	for (i = 0; i < num; i++) {
+		int ret;
+
+		freqs[i] = cand[i].freq;
+		ret = os_snprintf(pos, end - pos, " %d", cand[i].freq);
+		if (!os_snprintf_error(end - pos, ret))
+			pos += ret;
+	}
+	wpa_dbg(wpa_s, MSG_DEBUG, "Roam scan: Scan ranked channels:%s", msg);
+
+	wpa_s->roam_scan_partial_count++;
+	wpa_s->roam_scan_pending = ROAM_SCAN_PARTIAL;
+	return freqs;
+
+full:
+	wpa_s->roam_scan_partial_count = 0;
+	wpa_s->roam_scan_pending = ROAM_SCAN_FULL;
+	return NULL;
+}
+
+
+/**
+ * wpas_roam_scan_completed - Update roaming scan statistics
+ * @wpa_s: Pointer to wpa_supplicant data
+ * @duration: Duration of the completed scan
+ */
+void wpas_roam_scan_completed(struct wpa_supplicant *wpa_s,
+			      const struct os_reltime *duration)
+{
+	int type = wpa_s->roam_scan_pending;
+
+	if (type == ROAM_SCAN_NONE)
+		return;
+
+	wpa_s->roam_scan_pending = ROAM_SCAN_NONE;
+	wpa_s->roam_scans[type]++;
+	wpa_s->roam_scan_time_us[type] += duration->sec * 1000000ULL +
+		duration->usec;
+	wpa_dbg(wpa_s, MSG_DEBUG, "Roam scan: %s scan took %ld.%06ld seconds",
+		type == ROAM_SCAN_PARTIAL ? "Partial" : "Full",
+		duration->sec, duration->usec);
+}
+
+
 static void wpa_supplicant_optimize_freqs(
 	struct wpa_supplicant *wpa_s, struct wpa_driver_scan_params *params)
 {
@@ -1395,6 +1717,10 @@ ssid_list_set:
 	} else
 		os_free(wpa_s->next_scan_freqs);
 	wpa_s->next_scan_freqs = NULL;
+
+	if (params.freqs == NULL && wpa_s->last_scan_req != MANUAL_SCAN_REQ &&
+	    !wpa_s->conf->freq_list)
+		params.freqs = wpas_roam_scan_freqs(wpa_s);
 	wpa_setband_scan_freqs(wpa_s, &params);
 
 	/* See if user specified frequencies. If so, scan only those. */
@@ -1548,6 +1874,7 @@ scan:
 
 	if (ret) {
 		wpa_msg(wpa_s, MSG_WARNING, "Failed to initiate AP scan");
+		wpa_s->roam_scan_pending = ROAM_SCAN_NONE;
 		if (wpa_s->scan_prev_wpa_state != wpa_s->wpa_state)
 			wpa_supplicant_set_state(wpa_s,
 						 wpa_s->scan_prev_wpa_state);
@@ -2609,7 +2936,7 @@ static void filter_scan_res(struct wpa_supplicant *wpa_s,
 						      res->res[i]->bssid)) {
 			res->res[j++] = res->res[i];
 		} else {
-			os_free(res->res[i]);
+			wpa_scan_res_free(res, res->res[i]);
 			res->res[i] = NULL;
 		}
 	}
@@ -3340,6 +3667,7 @@ wpa_scan_clone_params(const struct wpa_driver_scan_params *src)
 	params->filter_rssi = src->filter_rssi;
 	params->p2p_probe = src->p2p_probe;
 	params->only_new_results = src->only_new_results;
+	params->filter_freqs = src->filter_freqs;
 	params->low_priority = src->low_priority;
 	params->duration = src->duration;
 	params->duration_mandatory = src->duration_mandatory;
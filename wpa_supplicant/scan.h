@@ -107,5 +107,9 @@ int wpas_adjust_snr_by_chanwidth(const u8 *ies, size_t ies_len,
 void wpa_add_owe_scan_ssid(struct wpa_supplicant *wpa_s,
 			   struct wpa_driver_scan_params *params,
 			   const struct wpa_ssid *ssid, size_t max_ssids);
+int * wpas_roam_scan_freqs(struct wpa_supplicant *wpa_s);
+void wpas_roam_scan_completed(struct wpa_supplicant *wpa_s,
+			      const struct os_reltime *duration);
+void wpas_abort_merged_scans(struct wpa_supplicant *wpa_s);
 
 #endif /* SCAN_H */
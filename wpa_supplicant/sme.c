@@ -87,6 +87,146 @@ static int sme_set_sae_group(struct wpa_supplicant *wpa_s, bool external)
 }
 
 
+static u8 sme_sae_rsnxe_capa(struct wpa_supplicant *wpa_s,
+			     struct wpa_bss *bss, struct wpa_ssid *ssid)
+{
+	const u8 *rsnxe;
+
+	rsnxe = wpa_bss_get_rsnxe(wpa_s, bss, ssid, false);
+	if (rsnxe && rsnxe[0] == WLAN_EID_VENDOR_SPECIFIC &&
+	    rsnxe[1] >= 1 + 4)
+		return rsnxe[2 + 4];
+	if (rsnxe && rsnxe[1] >= 1)
+		return rsnxe[2];
+	return 0;
+}
+
+
+struct sme_sae_precomp {
+	u8 addr[ETH_ALEN];
+	u8 own_addr[ETH_ALEN];
+	const struct wpa_ssid *ssid;
+	const struct sae_pt *pt;
+	struct sae_data sae;
+};
+
+
+static void sme_sae_precomp_expire(void *eloop_ctx, void *timeout_ctx)
+{
+	struct wpa_supplicant *wpa_s = eloop_ctx;
+
+	wpa_dbg(wpa_s, MSG_DEBUG, "SME: Precomputed SAE commits expired");
+	sme_sae_precomp_flush(wpa_s);
+}
+
+
+/* Returns the network that would be used with the BSS if the commit for it
+ * is certain to use H2E, otherwise %NULL */
+static struct wpa_ssid * sme_sae_precomp_ssid(struct wpa_supplicant *wpa_s,
+					       size_t i, struct wpa_bss *bss)
+{
+	struct wpa_ssid *ssid = NULL;
+	enum sae_pwe sae_pwe = wpa_s->conf->sae_pwe;
+	size_t prio;
+
+	if (bss == wpa_s->current_bss || !is_zero_ether_addr(bss->mld_addr))
+		return NULL;
+	if (sae_pwe == SAE_PWE_FORCE_HUNT_AND_PECK ||
+	    (sae_pwe != SAE_PWE_HASH_TO_ELEMENT && sae_pwe != SAE_PWE_BOTH &&
+	     !is_6ghz_freq(bss->freq)))
+		return NULL;
+
+	for (prio = 0; !ssid && prio < wpa_s->conf->num_prio; prio++)
+		ssid = wpa_scan_res_match(wpa_s, i, bss,
+					  wpa_s->conf->pssid[prio], 0, 0);
+	if (!ssid || !wpa_key_mgmt_sae(ssid->key_mgmt) ||
+	    !(sme_sae_rsnxe_capa(wpa_s, bss, ssid) &
+	      BIT(WLAN_RSNX_CAPAB_SAE_H2E)))
+		return NULL;
+
+	return ssid;
+}
+
+
+static void sme_sae_precomp_timeout(void *eloop_ctx, void *timeout_ctx)
+{
+	struct wpa_supplicant *wpa_s = eloop_ctx;
+	int *groups = wpa_s->conf->sae_groups;
+	int group = groups && groups[0] > 0 ? groups[0] : 19;
+	struct sme_sae_precomp *p;
+	struct wpa_ssid *ssid;
+	struct wpa_bss *bss;
+	size_t i;
+
+	while (wpa_s->sme.sae_precomp_num < wpa_s->sme.sae_precomp_max &&
+	       wpa_s->sme.sae_precomp_next < wpa_s->last_scan_res_used) {
+		i = wpa_s->sme.sae_precomp_next++;
+		bss = wpa_s->last_scan_res[i];
+		ssid = sme_sae_precomp_ssid(wpa_s, i, bss);
+		if (!ssid)
+			continue;
+		if (!ssid->pt)
+			wpa_s_setup_sae_pt(wpa_s->conf, ssid, true);
+		if (!ssid->pt)
+			continue;
+
+		p = &wpa_s->sme.sae_precomp[wpa_s->sme.sae_precomp_num];
+		if (sae_set_group(&p->sae, group) < 0 ||
+		    sae_prepare_commit_pt(&p->sae, ssid->pt, wpa_s->own_addr,
+					  bss->bssid, NULL, NULL) < 0) {
+			sae_clear_data(&p->sae);
+			continue;
+		}
+		os_memcpy(p->addr, bss->bssid, ETH_ALEN);
+		os_memcpy(p->own_addr, wpa_s->own_addr, ETH_ALEN);
+		p->ssid = ssid;
+		p->pt = ssid->pt;
+		wpa_s->sme.sae_precomp_num++;
+		wpa_dbg(wpa_s, MSG_DEBUG,
+			"SME: Precomputed SAE commit for " MACSTR
+			" (group %d)", MAC2STR(bss->bssid), group);
+
+		/* Derive one commit at a time to not delay other events */
+		eloop_register_timeout(0, 0, sme_sae_precomp_timeout,
+				       wpa_s, NULL);
+		return;
+	}
+}
+
+
+static bool sme_sae_precomp_take(struct wpa_supplicant *wpa_s,
+				 struct wpa_ssid *ssid, const u8 *addr)
+{
+	struct sme_sae_precomp *p;
+	unsigned int i;
+	int akmp;
+
+	if (wpa_s->sme.sae_rejected_groups)
+		return false;
+
+	for (i = 0; i < wpa_s->sme.sae_precomp_num; i++) {
+		p = &wpa_s->sme.sae_precomp[i];
+		if (!p->sae.tmp || p->ssid != ssid || p->pt != ssid->pt ||
+		    p->sae.group != wpa_s->sme.sae.group ||
+		    !ether_addr_equal(p->addr, addr) ||
+		    !ether_addr_equal(p->own_addr, wpa_s->own_addr))
+			continue;
+
+		/* Move the derived state over the freshly selected group */
+		akmp = wpa_s->sme.sae.akmp;
+		sae_clear_data(&wpa_s->sme.sae);
+		wpa_s->sme.sae = p->sae;
+		os_memset(&p->sae, 0, sizeof(p->sae));
+		wpa_s->sme.sae.akmp = akmp;
+		wpa_dbg(wpa_s, MSG_DEBUG,
+			"SAE: Use precomputed commit for " MACSTR,
+			MAC2STR(addr));
+		return true;
+	}
+
+	return false;
+}
+
 static struct wpabuf * sme_auth_build_sae_commit(struct wpa_supplicant *wpa_s,
 						 struct wpa_ssid *ssid,
 						 const u8 *bssid,
@@ -187,16 +327,8 @@ static struct wpabuf * sme_auth_build_sae_commit(struct wpa_supplicant *wpa_s,
 		wpa_supplicant_update_scan_results(wpa_s, bssid);
 		bss = wpa_bss_get_bssid_latest(wpa_s, bssid);
 	}
-	if (bss) {
-		const u8 *rsnxe;
-
-		rsnxe = wpa_bss_get_rsnxe(wpa_s, bss, ssid, false);
-		if (rsnxe && rsnxe[0] == WLAN_EID_VENDOR_SPECIFIC &&
-		    rsnxe[1] >= 1 + 4)
-			rsnxe_capa = rsnxe[2 + 4];
-		else if (rsnxe && rsnxe[1] >= 1)
-			rsnxe_capa = rsnxe[2];
-	}
+	if (bss)
+		rsnxe_capa = sme_sae_rsnxe_capa(wpa_s, bss, ssid);
 
 	if (ssid->sae_password_id &&
 	    wpa_s->conf->sae_pwe != SAE_PWE_FORCE_HUNT_AND_PECK)
@@ -242,7 +374,7 @@ static struct wpabuf * sme_auth_build_sae_commit(struct wpa_supplicant *wpa_s,
 
 	if (use_pt && !ssid->pt)
 		wpa_s_setup_sae_pt(wpa_s->conf, ssid, true);
-	if (use_pt &&
+	if (use_pt && !sme_sae_precomp_take(wpa_s, ssid, addr) &&
 	    sae_prepare_commit_pt(&wpa_s->sme.sae, ssid->pt,
 				  wpa_s->own_addr, addr,
 				  wpa_s->sme.sae_rejected_groups, NULL) < 0)
@@ -1246,6 +1378,7 @@ static void sme_auth_start_cb(struct wpa_radio_work *work, int deinit)
 	}
 
 	wpa_s->connect_work = work;
+	wpas_connect_trace(wpa_s, WPAS_CONNECT_WORK_START);
 
 	if (cwork->bss_removed ||
 	    !wpas_valid_bss_ssid(wpa_s, cwork->bss, cwork->ssid) ||
@@ -2146,15 +2279,28 @@ void sme_event_auth(struct wpa_supplicant *wpa_s, union wpa_event_data *data)
 	if (data->auth.auth_type == WLAN_AUTH_FT) {
 		const u8 *ric_ies = NULL;
 		size_t ric_ies_len = 0;
+		struct wpabuf *ric = NULL;
+		int res;
 
 		if (wpa_s->ric_ies) {
 			ric_ies = wpabuf_head(wpa_s->ric_ies);
 			ric_ies_len = wpabuf_len(wpa_s->ric_ies);
 		}
-		if (wpa_ft_process_response(wpa_s->wpa, data->auth.ies,
-					    data->auth.ies_len, 0,
-					    data->auth.peer,
-					    ric_ies, ric_ies_len) < 0) {
+#ifndef CONFIG_NO_WMM_AC
+		/* Request the traffic streams saved from the previous AP */
+		if (!ric_ies)
+			ric = wmm_ac_build_ric(wpa_s);
+		if (ric) {
+			ric_ies = wpabuf_head(ric);
+			ric_ies_len = wpabuf_len(ric);
+		}
+#endif /* CONFIG_NO_WMM_AC */
+		res = wpa_ft_process_response(wpa_s->wpa, data->auth.ies,
+					      data->auth.ies_len, 0,
+					      data->auth.peer,
+					      ric_ies, ric_ies_len);
+		wpabuf_free(ric);
+		if (res < 0) {
 			wpa_dbg(wpa_s, MSG_DEBUG,
 				"SME: FT Authentication response processing failed");
 			wpa_msg(wpa_s, MSG_INFO, WPA_EVENT_DISCONNECTED "bssid="
@@ -2270,6 +2416,8 @@ void sme_associate(struct wpa_supplicant *wpa_s, enum wpas_mode mode,
 
 	os_memset(&params, 0, sizeof(params));
 
+	wpas_connect_trace(wpa_s, WPAS_CONNECT_AUTH);
+
 	/* Save auth type, in case we need to retry after comeback timer. */
 	wpa_s->sme.assoc_auth_type = auth_type;
 
@@ -3077,6 +3225,63 @@ void sme_clear_on_disassoc(struct wpa_supplicant *wpa_s)
 }
 
 
+/**
+ * sme_sae_precomp_flush - Discard speculatively derived SAE commits
+ * @wpa_s: Pointer to wpa_supplicant data
+ */
+void sme_sae_precomp_flush(struct wpa_supplicant *wpa_s)
+{
+#ifdef CONFIG_SAE
+	unsigned int i;
+
+	eloop_cancel_timeout(sme_sae_precomp_timeout, wpa_s, NULL);
+	eloop_cancel_timeout(sme_sae_precomp_expire, wpa_s, NULL);
+	if (!wpa_s->sme.sae_precomp)
+		return;
+
+	/* sae_clear_data() clears the ephemeral secrets and PWE */
+	for (i = 0; i < wpa_s->sme.sae_precomp_num; i++)
+		sae_clear_data(&wpa_s->sme.sae_precomp[i].sae);
+	os_free(wpa_s->sme.sae_precomp);
+	wpa_s->sme.sae_precomp = NULL;
+	wpa_s->sme.sae_precomp_num = 0;
+	wpa_s->sme.sae_precomp_max = 0;
+	wpa_s->sme.sae_precomp_next = 0;
+#endif /* CONFIG_SAE */
+}
+
+
+/**
+ * sme_sae_precompute - Start deriving SAE commits for connection candidates
+ * @wpa_s: Pointer to wpa_supplicant data
+ *
+ * This is called when new scan results are available. Any previously derived
+ * commits are discarded.
+ */
+void sme_sae_precompute(struct wpa_supplicant *wpa_s)
+{
+	sme_sae_precomp_flush(wpa_s);
+
+#ifdef CONFIG_SAE
+	if (wpa_s->conf->sae_precompute_commit <= 0 ||
+	    !(wpa_s->drv_flags & WPA_DRIVER_FLAGS_SME) ||
+	    (wpa_s->drv_flags2 & WPA_DRIVER_FLAGS2_SAE_OFFLOAD_STA) ||
+	    !wpa_s->last_scan_res_used)
+		return;
+
+	wpa_s->sme.sae_precomp = os_calloc(wpa_s->conf->sae_precompute_commit,
+					   sizeof(struct sme_sae_precomp));
+	if (!wpa_s->sme.sae_precomp)
+		return;
+	wpa_s->sme.sae_precomp_max = wpa_s->conf->sae_precompute_commit;
+
+	eloop_register_timeout(0, 0, sme_sae_precomp_timeout, wpa_s, NULL);
+	eloop_register_timeout(wpa_s->conf->scan_res_valid_for_connect, 0,
+			       sme_sae_precomp_expire, wpa_s, NULL);
+#endif /* CONFIG_SAE */
+}
+
+
 void sme_deinit(struct wpa_supplicant *wpa_s)
 {
 	sme_clear_on_disassoc(wpa_s);
@@ -3084,6 +3289,7 @@ void sme_deinit(struct wpa_supplicant *wpa_s)
 	os_free(wpa_s->sme.sae_rejected_groups);
 	wpa_s->sme.sae_rejected_groups = NULL;
 #endif /* CONFIG_SAE */
+	sme_sae_precomp_flush(wpa_s);
 
 	eloop_cancel_timeout(sme_assoc_timer, wpa_s, NULL);
 	eloop_cancel_timeout(sme_auth_timer, wpa_s, NULL);
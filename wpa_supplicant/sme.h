@@ -35,6 +35,8 @@ void sme_sa_query_rx(struct wpa_supplicant *wpa_s, const u8 *da, const u8 *sa,
 void sme_state_changed(struct wpa_supplicant *wpa_s);
 void sme_clear_on_disassoc(struct wpa_supplicant *wpa_s);
 void sme_deinit(struct wpa_supplicant *wpa_s);
+void sme_sae_precompute(struct wpa_supplicant *wpa_s);
+void sme_sae_precomp_flush(struct wpa_supplicant *wpa_s);
 
 int sme_proc_obss_scan(struct wpa_supplicant *wpa_s);
 void sme_sched_obss_scan(struct wpa_supplicant *wpa_s, int enable);
@@ -106,6 +108,14 @@ static inline void sme_deinit(struct wpa_supplicant *wpa_s)
 {
 }
 
+static inline void sme_sae_precompute(struct wpa_supplicant *wpa_s)
+{
+}
+
+static inline void sme_sae_precomp_flush(struct wpa_supplicant *wpa_s)
+{
+}
+
 static inline int sme_proc_obss_scan(struct wpa_supplicant *wpa_s)
 {
 	return 0;
@@ -9,6 +9,7 @@
 #include "includes.h"
 
 #include "utils/common.h"
+#include "utils/eloop.h"
 #include "wpa_supplicant_i.h"
 #include "driver_i.h"
 
@@ -139,4 +140,703 @@ int wpas_twt_send_teardown(struct wpa_supplicant *wpa_s, u8 flags)
 	return ret;
 }
 
+
+
+/*
+ * TWT manager
+ *
+ * Flows with a required wake interval and wake duration are coalesced into
+ * individual TWT agreements (at most eight, one for each TWT Flow Identifier)
+ * with the current AP. A flow is added to an agreement with the same wake
+ * interval, or if no TWT Flow Identifier is available, to an agreement whose
+ * wake interval divides the wake interval of the flow. The agreements are
+ * (re)negotiated when the flows change, after (re)association, and after a
+ * teardown by the AP. They are torn down while the traffic exceeds a
+ * configured packet rate.
+ */
+
+#define TWT_MGR_MAX_FLOWS 32
+#define TWT_MGR_MAX_AGREEMENTS 8
+#define TWT_MGR_MAX_DURATION (255 * 256) /* Nominal Minimum TWT Wake Duration */
+#define TWT_MGR_POLL_SEC 1
+#define TWT_MGR_MAX_ATTEMPTS 3
+
+/* TWT Setup Command field values */
+#define TWT_SETUP_CMD_REQUEST 0
+#define TWT_SETUP_CMD_ACCEPT 4
+#define TWT_SETUP_CMD_ALTERNATE 5
+#define TWT_SETUP_CMD_DICTATE 6
+
+enum twt_agreement_state {
+	TWT_AGREEMENT_NONE,
+	TWT_AGREEMENT_REQUESTED,
+	TWT_AGREEMENT_ACTIVE,
+	TWT_AGREEMENT_REJECTED,
+};
+
+struct twt_flow {
+	bool in_use;
+	u8 id;
+	u32 interval_usec;
+	u32 duration_usec;
+	int agreement; /* -1 if the flow could not be scheduled */
+};
+
+struct twt_agreement {
+	enum twt_agreement_state state;
+	/* Wake interval and duration for the coalesced flows */
+	u32 interval_usec;
+	u32 duration_usec;
+	unsigned int num_flows;
+	/* Pending request */
+	u8 dtok;
+	unsigned int attempts;
+	bool alternate; /* the parameters suggested by the AP were requested */
+	u32 req_interval_usec;
+	u32 req_duration_usec;
+	/* Parameters accepted by the AP */
+	u32 acc_interval_usec;
+	u32 acc_duration_usec;
+};
+
+struct wpas_twt_mgr {
+	struct twt_flow flow[TWT_MGR_MAX_FLOWS];
+	struct twt_agreement agr[TWT_MGR_MAX_AGREEMENTS];
+	u8 bssid[ETH_ALEN]; /* AP of the agreements */
+	u8 dtok;
+	unsigned int traffic_pps; /* 0 = do not suspend based on traffic */
+	bool suspended;
+	unsigned int suspend_count;
+	bool pkts_valid;
+	unsigned long last_pkts;
+	bool active;
+	struct os_reltime active_start;
+	u64 active_usec;
+};
+
+
+static const char * twt_agreement_state_txt(enum twt_agreement_state state)
+{
+	switch (state) {
+	case TWT_AGREEMENT_NONE:
+		return "NONE";
+	case TWT_AGREEMENT_REQUESTED:
+		return "REQUESTED";
+	case TWT_AGREEMENT_ACTIVE:
+		return "ACTIVE";
+	case TWT_AGREEMENT_REJECTED:
+		return "REJECTED";
+	}
+	return "?";
+}
+
+
+static void twt_mgr_update_active(struct wpas_twt_mgr *mgr)
+{
+	struct os_reltime now, diff;
+	bool active = false;
+	int i;
+
+	for (i = 0; i < TWT_MGR_MAX_AGREEMENTS; i++) {
+		if (mgr->agr[i].state == TWT_AGREEMENT_ACTIVE)
+			active = true;
+	}
+
+	if (active == mgr->active)
+		return;
+	os_get_reltime(&now);
+	if (active) {
+		mgr->active_start = now;
+	} else {
+		os_reltime_sub(&now, &mgr->active_start, &diff);
+		mgr->active_usec += diff.sec * 1000000ULL + diff.usec;
+	}
+	mgr->active = active;
+}
+
+
+static int twt_mgr_place_flow(struct wpas_twt_mgr *mgr, struct twt_flow *f)
+{
+	int i, free_idx = -1, divisor = -1;
+	struct twt_agreement *a;
+
+	for (i = 0; i < TWT_MGR_MAX_AGREEMENTS; i++) {
+		a = &mgr->agr[i];
+		if (!a->num_flows) {
+			if (free_idx < 0)
+				free_idx = i;
+			continue;
+		}
+		if (a->duration_usec + f->duration_usec >
+		    MIN(a->interval_usec, TWT_MGR_MAX_DURATION))
+			continue;
+		if (a->interval_usec == f->interval_usec)
+			return i;
+		if (f->interval_usec % a->interval_usec == 0 &&
+		    (divisor < 0 ||
+		     a->interval_usec > mgr->agr[divisor].interval_usec))
+			divisor = i;
+	}
+
+	return free_idx >= 0 ? free_idx : divisor;
+}
+
+
+static void twt_mgr_plan(struct wpas_twt_mgr *mgr)
+{
+	u8 order[TWT_MGR_MAX_FLOWS];
+	unsigned int i, j, n = 0;
+	struct twt_flow *f;
+	struct twt_agreement *a;
+	int idx;
+
+	for (i = 0; i < TWT_MGR_MAX_AGREEMENTS; i++) {
+		mgr->agr[i].interval_usec = 0;
+		mgr->agr[i].duration_usec = 0;
+		mgr->agr[i].num_flows = 0;
+	}
+
+	/* Place the flows with the shortest wake interval first so that the
+	 * agreements they create can serve the flows with longer intervals */
+	for (i = 0; i < TWT_MGR_MAX_FLOWS; i++) {
+		if (!mgr->flow[i].in_use)
+			continue;
+		for (j = n; j > 0 && mgr->flow[order[j - 1]].interval_usec >
+			     mgr->flow[i].interval_usec; j--)
+			order[j] = order[j - 1];
+		order[j] = i;
+		n++;
+	}
+
+	for (i = 0; i < n; i++) {
+		f = &mgr->flow[order[i]];
+		idx = twt_mgr_place_flow(mgr, f);
+		f->agreement = idx;
+		if (idx < 0) {
+			wpa_printf(MSG_DEBUG,
+				   "TWT: No agreement available for flow %u",
+				   f->id);
+			continue;
+		}
+		a = &mgr->agr[idx];
+		if (!a->num_flows)
+			a->interval_usec = f->interval_usec;
+		a->duration_usec += f->duration_usec;
+		a->num_flows++;
+	}
+}
+
+
+static int twt_mgr_request(struct wpa_supplicant *wpa_s, int idx,
+			   u32 interval_usec, u32 duration_usec)
+{
+	struct wpas_twt_mgr *mgr = wpa_s->twt_mgr;
+	struct twt_agreement *a = &mgr->agr[idx];
+	int exponent = 0;
+	u8 min_twt;
+
+	/* Wake interval = mantissa * 2^exponent usec */
+	while ((interval_usec >> exponent) > 0xffff)
+		exponent++;
+	min_twt = MIN((duration_usec + 255) / 256, 255);
+
+	mgr->dtok++;
+	if (!mgr->dtok)
+		mgr->dtok++;
+	if (wpas_twt_send_setup(wpa_s, mgr->dtok, exponent,
+				interval_usec >> exponent, min_twt,
+				TWT_SETUP_CMD_REQUEST, 0, true, false, true,
+				true, idx, false, 0, 0) < 0)
+		return -1;
+
+	a->state = TWT_AGREEMENT_REQUESTED;
+	a->dtok = mgr->dtok;
+	a->attempts++;
+	a->req_interval_usec = interval_usec;
+	a->req_duration_usec = duration_usec;
+	return 0;
+}
+
+
+static void twt_mgr_teardown(struct wpa_supplicant *wpa_s, int idx)
+{
+	struct twt_agreement *a = &wpa_s->twt_mgr->agr[idx];
+
+	if (a->state == TWT_AGREEMENT_REQUESTED ||
+	    a->state == TWT_AGREEMENT_ACTIVE) {
+		/* TWT Flow field: TWT Flow Identifier of an individual TWT */
+		if (wpas_twt_send_teardown(wpa_s, idx & 0x07) < 0)
+			wpa_printf(MSG_DEBUG,
+				   "TWT: Failed to tear down agreement %d",
+				   idx);
+	}
+	a->state = TWT_AGREEMENT_NONE;
+	a->attempts = 0;
+	a->alternate = false;
+}
+
+
+static void twt_mgr_apply(struct wpa_supplicant *wpa_s)
+{
+	struct wpas_twt_mgr *mgr = wpa_s->twt_mgr;
+	struct twt_agreement *a;
+	int i;
+
+	if (wpa_s->wpa_state != WPA_COMPLETED)
+		return;
+
+	for (i = 0; i < TWT_MGR_MAX_AGREEMENTS; i++) {
+		a = &mgr->agr[i];
+		if (!a->num_flows || mgr->suspended) {
+			if (a->state != TWT_AGREEMENT_NONE)
+				twt_mgr_teardown(wpa_s, i);
+			continue;
+		}
+
+		if (a->state != TWT_AGREEMENT_NONE && !a->alternate &&
+		    a->req_interval_usec == a->interval_usec &&
+		    a->req_duration_usec == a->duration_usec)
+			continue; /* no changes to the requested parameters */
+
+		a->attempts = 0;
+		a->alternate = false;
+		if (twt_mgr_request(wpa_s, i, a->interval_usec,
+				    a->duration_usec) < 0)
+			a->state = TWT_AGREEMENT_NONE;
+	}
+
+	twt_mgr_update_active(mgr);
+}
+
+
+static unsigned int twt_mgr_num_flows(struct wpas_twt_mgr *mgr)
+{
+	unsigned int i, num = 0;
+
+	for (i = 0; i < TWT_MGR_MAX_FLOWS; i++) {
+		if (mgr->flow[i].in_use)
+			num++;
+	}
+	return num;
+}
+
+
+static void twt_mgr_timeout(void *eloop_ctx, void *timeout_ctx)
+{
+	struct wpa_supplicant *wpa_s = eloop_ctx;
+	struct wpas_twt_mgr *mgr = wpa_s->twt_mgr;
+	struct hostap_sta_driver_data data;
+	struct twt_agreement *a;
+	unsigned long pkts, rate;
+	int i;
+
+	if (wpa_s->wpa_state != WPA_COMPLETED || !twt_mgr_num_flows(mgr))
+		return;
+
+	if (mgr->traffic_pps &&
+	    wpa_drv_pktcnt_poll(wpa_s, &data) == 0) {
+		pkts = data.rx_packets + data.tx_packets;
+		rate = (pkts - mgr->last_pkts) / TWT_MGR_POLL_SEC;
+		if (!mgr->pkts_valid) {
+			mgr->pkts_valid = true;
+		} else if (!mgr->suspended && rate > mgr->traffic_pps) {
+			wpa_printf(MSG_DEBUG,
+				   "TWT: Suspend agreements due to traffic (%lu packets/s)",
+				   rate);
+			mgr->suspended = true;
+			mgr->suspend_count++;
+			twt_mgr_apply(wpa_s);
+		} else if (mgr->suspended && rate <= mgr->traffic_pps / 2) {
+			wpa_printf(MSG_DEBUG,
+				   "TWT: Resume agreements (%lu packets/s)",
+				   rate);
+			mgr->suspended = false;
+			twt_mgr_apply(wpa_s);
+		}
+		mgr->last_pkts = pkts;
+	}
+
+	/* Retry requests that were not answered */
+	for (i = 0; i < TWT_MGR_MAX_AGREEMENTS && !mgr->suspended; i++) {
+		a = &mgr->agr[i];
+		if (a->state != TWT_AGREEMENT_REQUESTED)
+			continue;
+		if (a->attempts >= TWT_MGR_MAX_ATTEMPTS) {
+			wpa_printf(MSG_DEBUG,
+				   "TWT: No response for agreement %d", i);
+			a->state = TWT_AGREEMENT_REJECTED;
+		} else if (twt_mgr_request(wpa_s, i, a->req_interval_usec,
+					   a->req_duration_usec) < 0) {
+			a->state = TWT_AGREEMENT_NONE;
+		}
+	}
+
+	/* Renegotiate agreements that the AP tore down */
+	twt_mgr_apply(wpa_s);
+
+	eloop_register_timeout(TWT_MGR_POLL_SEC, 0, twt_mgr_timeout, wpa_s,
+			       NULL);
+}
+
+
+static void twt_mgr_update(struct wpa_supplicant *wpa_s)
+{
+	twt_mgr_plan(wpa_s->twt_mgr);
+	twt_mgr_apply(wpa_s);
+	if (wpa_s->wpa_state == WPA_COMPLETED &&
+	    !eloop_is_timeout_registered(twt_mgr_timeout, wpa_s, NULL))
+		eloop_register_timeout(TWT_MGR_POLL_SEC, 0, twt_mgr_timeout,
+				       wpa_s, NULL);
+}
+
+
+static struct wpas_twt_mgr * twt_mgr_get(struct wpa_supplicant *wpa_s)
+{
+	if (!wpa_s->twt_mgr)
+		wpa_s->twt_mgr = os_zalloc(sizeof(*wpa_s->twt_mgr));
+	return wpa_s->twt_mgr;
+}
+
+
+/**
+ * wpas_twt_flow_add - Add or update a flow for the TWT manager
+ * @wpa_s: Pointer to wpa_supplicant
+ * @id: Flow identifier
+ * @interval_usec: Wake interval required by the flow
+ * @duration_usec: Wake duration required by the flow in each interval
+ * Returns: 0 on success, -1 on failure
+ */
+int wpas_twt_flow_add(struct wpa_supplicant *wpa_s, u8 id, u32 interval_usec,
+		      u32 duration_usec)
+{
+	struct wpas_twt_mgr *mgr;
+	struct twt_flow *f = NULL;
+	int i;
+
+	if (!interval_usec || !duration_usec ||
+	    duration_usec > MIN(interval_usec, TWT_MGR_MAX_DURATION))
+		return -1;
+
+	mgr = twt_mgr_get(wpa_s);
+	if (!mgr)
+		return -1;
+
+	for (i = 0; i < TWT_MGR_MAX_FLOWS; i++) {
+		if (mgr->flow[i].in_use && mgr->flow[i].id == id) {
+			f = &mgr->flow[i];
+			break;
+		}
+		if (!mgr->flow[i].in_use && !f)
+			f = &mgr->flow[i];
+	}
+	if (!f)
+		return -1;
+
+	f->in_use = true;
+	f->id = id;
+	f->interval_usec = interval_usec;
+	f->duration_usec = duration_usec;
+	twt_mgr_update(wpa_s);
+	return 0;
+}
+
+
+/**
+ * wpas_twt_flow_remove - Remove a flow from the TWT manager
+ * @wpa_s: Pointer to wpa_supplicant
+ * @id: Flow identifier or -1 to remove all flows
+ * Returns: 0 on success, -1 if the flow was not found
+ */
+int wpas_twt_flow_remove(struct wpa_supplicant *wpa_s, int id)
+{
+	struct wpas_twt_mgr *mgr = wpa_s->twt_mgr;
+	bool found = false;
+	int i;
+
+	if (!mgr)
+		return -1;
+
+	for (i = 0; i < TWT_MGR_MAX_FLOWS; i++) {
+		if (mgr->flow[i].in_use && (id < 0 || mgr->flow[i].id == id)) {
+			mgr->flow[i].in_use = false;
+			found = true;
+		}
+	}
+	if (!found)
+		return -1;
+
+	twt_mgr_update(wpa_s);
+	return 0;
+}
+
+
+/**
+ * wpas_twt_flow_set_traffic - Set the packet rate for suspending agreements
+ * @wpa_s: Pointer to wpa_supplicant
+ * @pps: Packets per second (RX + TX) above which the TWT agreements are torn
+ *	down; they are set up again once the rate drops to half of this. 0
+ *	disables this.
+ * Returns: 0 on success, -1 on failure
+ */
+int wpas_twt_flow_set_traffic(struct wpa_supplicant *wpa_s, unsigned int pps)
+{
+	struct wpas_twt_mgr *mgr = twt_mgr_get(wpa_s);
+
+	if (!mgr)
+		return -1;
+	mgr->traffic_pps = pps;
+	mgr->pkts_valid = false;
+	if (!pps && mgr->suspended) {
+		mgr->suspended = false;
+		twt_mgr_apply(wpa_s);
+	}
+	return 0;
+}
+
+
+/**
+ * wpas_twt_flow_status - Get the state of the TWT manager
+ * @wpa_s: Pointer to wpa_supplicant
+ * @buf: Buffer for the status text
+ * @buflen: Length of the buffer
+ * Returns: Number of octets written to the buffer
+ *
+ * The duty cycle is the fraction of time the active agreements schedule
+ * service periods for; the power save fraction is the rest of the time when
+ * at least one agreement is active.
+ */
+int wpas_twt_flow_status(struct wpa_supplicant *wpa_s, char *buf,
+			 size_t buflen)
+{
+	struct wpas_twt_mgr *mgr = wpa_s->twt_mgr;
+	char *pos = buf, *end = buf + buflen;
+	struct os_reltime now, diff;
+	unsigned int duty = 0;
+	u64 active_usec;
+	int i, ret;
+
+	if (!mgr)
+		return 0;
+
+	for (i = 0; i < TWT_MGR_MAX_AGREEMENTS; i++) {
+		struct twt_agreement *a = &mgr->agr[i];
+
+		if (a->state == TWT_AGREEMENT_ACTIVE && a->acc_interval_usec)
+			duty += (u64) a->acc_duration_usec * 1000 /
+				a->acc_interval_usec;
+	}
+	duty = MIN(duty, 1000);
+
+	active_usec = mgr->active_usec;
+	if (mgr->active) {
+		os_get_reltime(&now);
+		os_reltime_sub(&now, &mgr->active_start, &diff);
+		active_usec += diff.sec * 1000000ULL + diff.usec;
+	}
+
+	ret = os_snprintf(pos, end - pos,
+			  "traffic_pps=%u\n"
+			  "suspended=%d\n"
+			  "suspend_count=%u\n"
+			  "active_sec=%llu\n"
+			  "duty_cycle_permille=%u\n"
+			  "power_save_permille=%u\n",
+			  mgr->traffic_pps, mgr->suspended, mgr->suspend_count,
+			  (unsigned long long) (active_usec / 1000000),
+			  duty, mgr->active ? 1000 - duty : 0);
+	if (os_snprintf_error(end - pos, ret))
+		return pos - buf;
+	pos += ret;
+
+	for (i = 0; i < TWT_MGR_MAX_AGREEMENTS; i++) {
+		struct twt_agreement *a = &mgr->agr[i];
+
+		if (!a->num_flows && a->state == TWT_AGREEMENT_NONE)
+			continue;
+		ret = os_snprintf(pos, end - pos,
+				  "agreement=%d state=%s flows=%u interval=%u duration=%u accepted_interval=%u accepted_duration=%u\n",
+				  i, twt_agreement_state_txt(a->state),
+				  a->num_flows, a->interval_usec,
+				  a->duration_usec, a->acc_interval_usec,
+				  a->acc_duration_usec);
+		if (os_snprintf_error(end - pos, ret))
+			return pos - buf;
+		pos += ret;
+	}
+
+	for (i = 0; i < TWT_MGR_MAX_FLOWS; i++) {
+		struct twt_flow *f = &mgr->flow[i];
+
+		if (!f->in_use)
+			continue;
+		ret = os_snprintf(pos, end - pos,
+				  "flow=%u interval=%u duration=%u agreement=%d\n",
+				  f->id, f->interval_usec, f->duration_usec,
+				  f->agreement);
+		if (os_snprintf_error(end - pos, ret))
+			return pos - buf;
+		pos += ret;
+	}
+
+	return pos - buf;
+}
+
+
+static void twt_mgr_reset_agreements(struct wpas_twt_mgr *mgr)
+{
+	int i;
+
+	for (i = 0; i < TWT_MGR_MAX_AGREEMENTS; i++) {
+		mgr->agr[i].state = TWT_AGREEMENT_NONE;
+		mgr->agr[i].attempts = 0;
+		mgr->agr[i].alternate = false;
+	}
+	twt_mgr_update_active(mgr);
+	mgr->pkts_valid = false;
+	mgr->suspended = false;
+}
+
+
+/**
+ * wpas_twt_mgr_connected - Set up the TWT agreements after connection
+ * @wpa_s: Pointer to wpa_supplicant
+ */
+void wpas_twt_mgr_connected(struct wpa_supplicant *wpa_s)
+{
+	struct wpas_twt_mgr *mgr = wpa_s->twt_mgr;
+
+	if (!mgr || !twt_mgr_num_flows(mgr))
+		return;
+
+	/* Completing a rekeying does not change the agreements */
+	if (!ether_addr_equal(mgr->bssid, wpa_s->bssid)) {
+		twt_mgr_reset_agreements(mgr);
+		os_memcpy(mgr->bssid, wpa_s->bssid, ETH_ALEN);
+	}
+	twt_mgr_update(wpa_s);
+}
+
+
+/**
+ * wpas_twt_mgr_disconnected - Forget the TWT agreements on disconnection
+ * @wpa_s: Pointer to wpa_supplicant
+ */
+void wpas_twt_mgr_disconnected(struct wpa_supplicant *wpa_s)
+{
+	struct wpas_twt_mgr *mgr = wpa_s->twt_mgr;
+
+	if (!mgr)
+		return;
+
+	eloop_cancel_timeout(twt_mgr_timeout, wpa_s, NULL);
+	twt_mgr_reset_agreements(mgr);
+	os_memset(mgr->bssid, 0, ETH_ALEN);
+}
+
+
+void wpas_twt_mgr_deinit(struct wpa_supplicant *wpa_s)
+{
+	eloop_cancel_timeout(twt_mgr_timeout, wpa_s, NULL);
+	os_free(wpa_s->twt_mgr);
+	wpa_s->twt_mgr = NULL;
+}
+
+
+static void twt_mgr_rx_setup(struct wpa_supplicant *wpa_s, const u8 *data,
+			     size_t len)
+{
+	struct wpas_twt_mgr *mgr = wpa_s->twt_mgr;
+	struct twt_agreement *a;
+	u16 req_type;
+	u8 setup_cmd, flow_id, exponent;
+	u32 interval_usec, duration_usec;
+	u64 interval;
+
+	/* Dialog Token, TWT element: Element ID, Length, Control, Request Type,
+	 * Target Wake Time, Nominal Minimum TWT Wake Duration, TWT Wake
+	 * Interval Mantissa, TWT Channel */
+	if (len < 1 + 17 || data[1] != WLAN_EID_TWT || data[2] < 15)
+		return;
+
+	req_type = WPA_GET_LE16(&data[4]);
+	setup_cmd = (req_type >> 1) & 0x7;
+	flow_id = (req_type >> 7) & 0x7;
+	exponent = (req_type >> 10) & 0x1f;
+	duration_usec = data[14] * 256;
+	interval = (u64) WPA_GET_LE16(&data[15]) << exponent;
+	interval_usec = MIN(interval, 0xffffffff);
+
+	a = &mgr->agr[flow_id];
+	if (a->state != TWT_AGREEMENT_REQUESTED || a->dtok != data[0]) {
+		wpa_printf(MSG_DEBUG,
+			   "TWT: Ignore unexpected TWT Setup frame for flow %u (dtok %u)",
+			   flow_id, data[0]);
+		return;
+	}
+
+	wpa_printf(MSG_DEBUG,
+		   "TWT: Setup command %u for agreement %u (interval %u usec, duration %u usec)",
+		   setup_cmd, flow_id, interval_usec, duration_usec);
+
+	switch (setup_cmd) {
+	case TWT_SETUP_CMD_ACCEPT:
+	case TWT_SETUP_CMD_DICTATE:
+		a->state = TWT_AGREEMENT_ACTIVE;
+		a->acc_interval_usec = interval_usec;
+		a->acc_duration_usec = duration_usec;
+		a->attempts = 0;
+		break;
+	case TWT_SETUP_CMD_ALTERNATE:
+		if (!a->alternate && interval_usec && duration_usec) {
+			/* Request the parameters suggested by the AP once */
+			a->alternate = true;
+			a->attempts = 0;
+			if (twt_mgr_request(wpa_s, flow_id, interval_usec,
+					    duration_usec) == 0)
+				break;
+		}
+		/* fall through */
+	default:
+		a->state = TWT_AGREEMENT_REJECTED;
+		break;
+	}
+
+	twt_mgr_update_active(mgr);
+}
+
+
+/**
+ * wpas_twt_rx_action - Process a received S1G Action frame for TWT
+ * @wpa_s: Pointer to wpa_supplicant
+ * @sa: Source address of the frame
+ * @data: Action field and the following fields
+ * @len: Length of data in octets
+ */
+void wpas_twt_rx_action(struct wpa_supplicant *wpa_s, const u8 *sa,
+			const u8 *data, size_t len)
+{
+	struct wpas_twt_mgr *mgr = wpa_s->twt_mgr;
+	int i;
+
+	if (!mgr || len < 2 || !ether_addr_equal(sa, wpa_s->bssid))
+		return;
+
+	if (data[0] == S1G_ACT_TWT_SETUP) {
+		twt_mgr_rx_setup(wpa_s, data + 1, len - 1);
+	} else if (data[0] == S1G_ACT_TWT_TEARDOWN) {
+		/* TWT Flow field: bit 7 = Teardown All TWT */
+		for (i = 0; i < TWT_MGR_MAX_AGREEMENTS; i++) {
+			if (!(data[1] & BIT(7)) && i != (data[1] & 0x07))
+				continue;
+			wpa_printf(MSG_DEBUG,
+				   "TWT: AP tore down agreement %d", i);
+			mgr->agr[i].state = TWT_AGREEMENT_NONE;
+			mgr->agr[i].attempts = 0;
+			mgr->agr[i].alternate = false;
+		}
+		/* Renegotiated on the next poll */
+		twt_mgr_update_active(mgr);
+	}
+}
+
 #endif /* CONFIG_TESTING_OPTIONS */
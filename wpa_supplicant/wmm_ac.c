@@ -13,6 +13,7 @@
 #include "utils/list.h"
 #include "utils/eloop.h"
 #include "common/ieee802_11_common.h"
+#include "common/wpa_common.h"
 #include "wpa_supplicant_i.h"
 #include "bss.h"
 #include "driver_i.h"
@@ -139,9 +140,10 @@ static void wmm_ac_del_ts_idx(struct wpa_supplicant *wpa_s, u8 ac,
 }
 
 
-static void wmm_ac_del_req(struct wpa_supplicant *wpa_s, int failed)
+static void wmm_ac_del_req(struct wpa_supplicant *wpa_s,
+			   struct wmm_ac_addts_request *req, int failed)
 {
-	struct wmm_ac_addts_request *req = wpa_s->addts_request;
+	struct wmm_ac_addts_request **pos;
 
 	if (!req)
 		return;
@@ -151,22 +153,58 @@ static void wmm_ac_del_req(struct wpa_supplicant *wpa_s, int failed)
 			"tsid=%u", wmm_ac_get_tsid(&req->tspec));
 
 	eloop_cancel_timeout(wmm_ac_addts_req_timeout, wpa_s, req);
-	wpa_s->addts_request = NULL;
+	for (pos = &wpa_s->addts_request; *pos; pos = &(*pos)->next) {
+		if (*pos == req) {
+			*pos = req->next;
+			break;
+		}
+	}
 	os_free(req);
 }
 
 
+static void wmm_ac_readmit_restored(struct wmm_ac_readmit *readmit)
+{
+	struct os_reltime age;
+
+	readmit->restored++;
+	os_reltime_age(&readmit->start, &age);
+	readmit->last_ms = age.sec * 1000 + age.usec / 1000;
+}
+
+
+static void wmm_ac_readmit_done(struct wpa_supplicant *wpa_s, bool restored)
+{
+	struct wmm_ac_readmit *readmit = &wpa_s->wmm_ac_readmit;
+
+	if (restored)
+		wmm_ac_readmit_restored(readmit);
+
+	if (readmit->pending && --readmit->pending)
+		return;
+
+	readmit->active = false;
+	wpa_printf(MSG_DEBUG,
+		   "WMM AC: Re-admitted %u/%u TSPECs (%u in RIC) %u ms after the start of the roam",
+		   readmit->restored, readmit->total, readmit->ric,
+		   readmit->last_ms);
+}
+
+
 static void wmm_ac_addts_req_timeout(void *eloop_ctx, void *timeout_ctx)
 {
 	struct wpa_supplicant *wpa_s = eloop_ctx;
 	struct wmm_ac_addts_request *addts_req = timeout_ctx;
+	bool readmit = addts_req->readmit;
 
 	wpa_printf(MSG_DEBUG,
 		   "Timeout getting ADDTS response (tsid=%d up=%d)",
 		   wmm_ac_get_tsid(&addts_req->tspec),
 		   wmm_ac_get_user_priority(&addts_req->tspec));
 
-	wmm_ac_del_req(wpa_s, 1);
+	wmm_ac_del_req(wpa_s, addts_req, 1);
+	if (readmit)
+		wmm_ac_readmit_done(wpa_s, false);
 }
 
 
@@ -517,8 +555,11 @@ static void wmm_ac_deinit(struct wpa_supplicant *wpa_s)
 	for (i = 0; i < WMM_AC_NUM; i++)
 		wmm_ac_del_ts(wpa_s, i, TS_DIR_IDX_ALL);
 
-	/* delete pending add_ts request */
-	wmm_ac_del_req(wpa_s, 1);
+	/* delete pending add_ts requests */
+	while (wpa_s->addts_request)
+		wmm_ac_del_req(wpa_s, wpa_s->addts_request, 1);
+	wpa_s->wmm_ac_readmit.pending = 0;
+	wpa_s->wmm_ac_readmit.active = false;
 
 	os_free(wpa_s->wmm_ac_assoc_info);
 	wpa_s->wmm_ac_assoc_info = NULL;
@@ -660,9 +701,10 @@ static void wmm_ac_handle_addts_resp(struct wpa_supplicant *wpa_s, const u8 *sa,
 		const u8 resp_dialog_token, const u8 status_code,
 		const struct wmm_tspec_element *tspec)
 {
-	struct wmm_ac_addts_request *req = wpa_s->addts_request;
+	struct wmm_ac_addts_request *req;
 	u8 ac, tsid, up, dir;
 	int replace_tspecs;
+	bool readmit;
 
 	tsid = wmm_ac_get_tsid(tspec);
 	dir = wmm_ac_get_direction(tspec);
@@ -670,7 +712,11 @@ static void wmm_ac_handle_addts_resp(struct wpa_supplicant *wpa_s, const u8 *sa,
 	ac = up_to_ac[up];
 
 	/* make sure we have a matching addts request */
-	if (!req || req->dialog_token != resp_dialog_token) {
+	for (req = wpa_s->addts_request; req; req = req->next) {
+		if (req->dialog_token == resp_dialog_token)
+			break;
+	}
+	if (!req) {
 		wpa_printf(MSG_DEBUG,
 			   "WMM AC: no req with dialog=%u, ignoring frame",
 			   resp_dialog_token);
@@ -688,7 +734,8 @@ static void wmm_ac_handle_addts_resp(struct wpa_supplicant *wpa_s, const u8 *sa,
 	}
 
 	/* delete pending request */
-	wmm_ac_del_req(wpa_s, 0);
+	readmit = req->readmit;
+	wmm_ac_del_req(wpa_s, req, 0);
 
 	wpa_printf(MSG_DEBUG,
 		   "ADDTS response status=%d tsid=%u up=%u direction=%u",
@@ -718,6 +765,8 @@ static void wmm_ac_handle_addts_resp(struct wpa_supplicant *wpa_s, const u8 *sa,
 	if (wmm_ac_add_ts(wpa_s, sa, tspec))
 		goto err_delts;
 
+	if (readmit)
+		wmm_ac_readmit_done(wpa_s, true);
 	return;
 
 err_delts:
@@ -726,6 +775,8 @@ err_delts:
 err_msg:
 	wpa_msg(wpa_s, MSG_INFO, WMM_AC_EVENT_TSPEC_REQ_FAILED "tsid=%u",
 		tsid);
+	if (readmit)
+		wmm_ac_readmit_done(wpa_s, false);
 }
 
 
@@ -900,6 +951,17 @@ int wpas_wmm_ac_status(struct wpa_supplicant *wpa_s, char *buf, size_t buflen)
 		}
 	}
 
+	if (wpa_s->wmm_ac_readmit.total) {
+		struct wmm_ac_readmit *readmit = &wpa_s->wmm_ac_readmit;
+
+		pos += wpa_scnprintf(buf + pos, buflen - pos,
+				     "Re-admission after roaming: %u/%u traffic streams (%u in RIC)%s, last after %u ms\n",
+				     readmit->restored, readmit->total,
+				     readmit->ric,
+				     readmit->active ? " in progress" : "",
+				     readmit->last_ms);
+	}
+
 	return pos;
 }
 
@@ -954,6 +1016,8 @@ void wmm_ac_save_tspecs(struct wpa_supplicant *wpa_s)
 		}
 	}
 
+	os_get_reltime(&wpa_s->wmm_ac_readmit.start);
+
 	wpa_printf(MSG_DEBUG, "WMM AC: Successfully saved %d TSPECs",
 		   wpa_s->last_tspecs_count);
 }
@@ -985,3 +1049,218 @@ int wmm_ac_restore_tspecs(struct wpa_supplicant *wpa_s)
 
 	return 0;
 }
+
+
+static bool wmm_ac_same_ts(const struct wmm_tspec_element *a,
+			   const struct wmm_tspec_element *b)
+{
+	return wmm_ac_get_tsid(a) == wmm_ac_get_tsid(b) &&
+		wmm_ac_get_direction(a) == wmm_ac_get_direction(b) &&
+		wmm_ac_get_user_priority(a) == wmm_ac_get_user_priority(b);
+}
+
+
+static void wmm_ac_del_saved_tspec(struct wpa_supplicant *wpa_s,
+				   unsigned int i)
+{
+	os_memmove(&wpa_s->last_tspecs[i], &wpa_s->last_tspecs[i + 1],
+		   (wpa_s->last_tspecs_count - i - 1) *
+		   sizeof(*wpa_s->last_tspecs));
+	wpa_s->last_tspecs_count--;
+}
+
+
+/**
+ * wmm_ac_build_ric - Build the RIC for an FT reassociation
+ * @wpa_s: Pointer to wpa_supplicant data
+ * Returns: RDE and TSPEC elements for the saved traffic streams or %NULL if
+ * there are no saved traffic streams
+ *
+ * The caller is responsible for freeing the returned buffer.
+ */
+struct wpabuf * wmm_ac_build_ric(struct wpa_supplicant *wpa_s)
+{
+	struct wpabuf *buf;
+	struct rsn_rdie *rdie;
+	struct wmm_tspec_element tspec;
+	unsigned int i;
+
+	if (!wpa_s->last_tspecs_count)
+		return NULL;
+
+	buf = wpabuf_alloc(wpa_s->last_tspecs_count *
+			   (2 + sizeof(*rdie) + sizeof(tspec)));
+	if (!buf)
+		return NULL;
+
+	for (i = 0; i < wpa_s->last_tspecs_count; i++) {
+		wpabuf_put_u8(buf, WLAN_EID_RIC_DATA);
+		wpabuf_put_u8(buf, sizeof(*rdie));
+		rdie = wpabuf_put(buf, sizeof(*rdie));
+		rdie->id = i + 1;
+		rdie->descr_count = 1;
+		rdie->status_code = host_to_le16(WLAN_STATUS_SUCCESS);
+
+		tspec = wpa_s->last_tspecs[i];
+		tspec.medium_time = 0; /* set by the AP */
+		wpabuf_put_data(buf, &tspec, sizeof(tspec));
+	}
+
+	wpa_printf(MSG_DEBUG, "WMM AC: Request %u TSPECs in RIC",
+		   wpa_s->last_tspecs_count);
+	return buf;
+}
+
+
+static void wmm_ac_process_ric_resp(struct wpa_supplicant *wpa_s,
+				    const u8 *ies, size_t ies_len)
+{
+	const struct element *elem;
+	const struct rsn_rdie *rdie = NULL;
+	const struct wmm_tspec_element *tspec;
+	unsigned int i;
+
+	for_each_element(elem, ies, ies_len) {
+		if (elem->id == WLAN_EID_RIC_DATA &&
+		    elem->datalen >= sizeof(*rdie)) {
+			rdie = (const struct rsn_rdie *) elem->data;
+			continue;
+		}
+
+		/* Resource descriptor following an RDE */
+		if (!rdie || elem->id != WLAN_EID_VENDOR_SPECIFIC ||
+		    elem->datalen != sizeof(*tspec) - 2 ||
+		    WPA_GET_BE24(elem->data) != OUI_MICROSOFT ||
+		    elem->data[3] != WMM_OUI_TYPE ||
+		    elem->data[4] != WMM_OUI_SUBTYPE_TSPEC_ELEMENT)
+			continue;
+		tspec = (const struct wmm_tspec_element *) elem;
+		if (le_to_host16(rdie->status_code) != WLAN_STATUS_SUCCESS) {
+			wpa_printf(MSG_DEBUG,
+				   "WMM AC: TSID %u not admitted in RIC (status %u)",
+				   wmm_ac_get_tsid(tspec),
+				   le_to_host16(rdie->status_code));
+			rdie = NULL;
+			continue;
+		}
+		rdie = NULL;
+
+		for (i = 0; i < wpa_s->last_tspecs_count; i++) {
+			if (wmm_ac_same_ts(&wpa_s->last_tspecs[i], tspec))
+				break;
+		}
+		if (i == wpa_s->last_tspecs_count ||
+		    wmm_ac_add_ts(wpa_s, wpa_s->bssid, tspec) < 0)
+			continue;
+
+		wmm_ac_del_saved_tspec(wpa_s, i);
+		wpa_s->wmm_ac_readmit.ric++;
+		wmm_ac_readmit_restored(&wpa_s->wmm_ac_readmit);
+	}
+}
+
+
+/**
+ * wmm_ac_readmit_tspecs - Re-admit the saved traffic streams after roaming
+ * @wpa_s: Pointer to wpa_supplicant data
+ * @ies: IEs from the (Re)Association Response frame
+ * @ies_len: Length of ies in octets
+ *
+ * The traffic streams admitted in the RIC are added immediately. ADDTS
+ * requests for the others are sent from wmm_ac_notify_completed().
+ */
+void wmm_ac_readmit_tspecs(struct wpa_supplicant *wpa_s, const u8 *ies,
+			   size_t ies_len)
+{
+	struct wmm_ac_readmit *readmit = &wpa_s->wmm_ac_readmit;
+
+	if (!wpa_s->wmm_ac_assoc_info || !wpa_s->last_tspecs_count)
+		return;
+
+	readmit->active = true;
+	readmit->total = wpa_s->last_tspecs_count;
+	/* Held until the ADDTS requests have been sent */
+	readmit->pending = 1;
+	readmit->restored = 0;
+	readmit->ric = 0;
+	readmit->last_ms = 0;
+
+	wmm_ac_process_ric_resp(wpa_s, ies, ies_len);
+
+	if (wpa_s->wpa_state == WPA_COMPLETED)
+		wmm_ac_notify_completed(wpa_s);
+}
+
+
+static int wmm_ac_send_readmit_req(struct wpa_supplicant *wpa_s,
+				   const struct wmm_tspec_element *tspec)
+{
+	struct wmm_ac_addts_request *req;
+	u8 up = wmm_ac_get_user_priority(tspec);
+	u8 ac = up_to_ac[up];
+	u8 uapsd = wpa_s->wmm_ac_assoc_info->ac_params[ac].uapsd;
+
+	if (!wpa_s->wmm_ac_assoc_info->ac_params[ac].acm) {
+		wpa_printf(MSG_DEBUG,
+			   "WMM AC: AC %d is not ACM - TSID %u not needed",
+			   ac, wmm_ac_get_tsid(tspec));
+		return -1;
+	}
+
+	if (wmm_ac_get_direction(tspec) != WMM_AC_DIR_DOWNLINK &&
+	    !wpa_s->wmm_ac_supported)
+		return -1;
+
+	req = os_zalloc(sizeof(*req));
+	if (!req)
+		return -1;
+
+	/* The dialog token cannot be zero */
+	if (++wpa_s->wmm_ac_last_dialog_token == 0)
+		wpa_s->wmm_ac_last_dialog_token++;
+	req->dialog_token = wpa_s->wmm_ac_last_dialog_token;
+	os_memcpy(req->address, wpa_s->bssid, ETH_ALEN);
+	req->tspec = *tspec;
+	req->tspec.ts_info[1] &= ~BIT(2);
+	req->tspec.ts_info[1] |= uapsd << 2;
+	req->tspec.medium_time = 0;
+	req->readmit = true;
+
+	if (wmm_ac_send_addts_request(wpa_s, req)) {
+		os_free(req);
+		return -1;
+	}
+
+	req->next = wpa_s->addts_request;
+	wpa_s->addts_request = req;
+	eloop_register_timeout(1, 0, wmm_ac_addts_req_timeout, wpa_s, req);
+	return 0;
+}
+
+
+/**
+ * wmm_ac_notify_completed - Notify WMM AC of a completed connection
+ * @wpa_s: Pointer to wpa_supplicant data
+ *
+ * This sends the ADDTS requests for the traffic streams that were saved when
+ * roaming and were not admitted in the RIC. All requests are sent without
+ * waiting for the responses to the previous ones.
+ */
+void wmm_ac_notify_completed(struct wpa_supplicant *wpa_s)
+{
+	struct wmm_ac_readmit *readmit = &wpa_s->wmm_ac_readmit;
+	unsigned int i;
+
+	if (!wpa_s->wmm_ac_assoc_info || !readmit->active ||
+	    !wpa_s->last_tspecs)
+		return;
+
+	for (i = 0; i < wpa_s->last_tspecs_count; i++) {
+		if (wmm_ac_send_readmit_req(wpa_s, &wpa_s->last_tspecs[i]) == 0)
+			readmit->pending++;
+	}
+	wmm_ac_clear_saved_tspecs(wpa_s);
+
+	/* Drop the reference that was held until the requests were sent */
+	wmm_ac_readmit_done(wpa_s, false);
+}
@@ -87,6 +87,9 @@ enum ts_dir_idx {
  * relevant traffic stream information will be stored as a wmm_ac_ts struct.
  */
 struct wmm_ac_addts_request {
+	/* next - Next pending ADDTS request */
+	struct wmm_ac_addts_request *next;
+
 	/*
 	 * dialog token - Used to link the received ADDTS response with this
 	 * saved ADDTS request when ADDTS response is being handled
@@ -106,6 +109,41 @@ struct wmm_ac_addts_request {
 	 * and act accordingly in ADDTS response handling
 	 */
 	struct wmm_tspec_element tspec;
+
+	/*
+	 * readmit - Whether this request re-admits a traffic stream that was
+	 * set up with the previous AP before roaming
+	 */
+	bool readmit;
+};
+
+
+/**
+ * struct wmm_ac_readmit - Re-admission of traffic streams after roaming
+ *
+ * The traffic streams saved when roaming within the ESS are requested from
+ * the new AP in the RIC of an FT reassociation, if possible, and otherwise
+ * with ADDTS requests that are all sent once the connection is completed.
+ */
+struct wmm_ac_readmit {
+	/* active - Whether the saved traffic streams are being re-admitted */
+	bool active;
+
+	/* start - Time when the roam started */
+	struct os_reltime start;
+
+	/* pending - Number of ADDTS requests waiting for a response */
+	unsigned int pending;
+
+	/* total - Number of traffic streams to re-admit */
+	unsigned int total;
+
+	/* restored - Number of re-admitted traffic streams (ric = in RIC) */
+	unsigned int restored;
+	unsigned int ric;
+
+	/* last_ms - Time from the start of the roam to the last re-admission */
+	unsigned int last_ms;
 };
 
 
@@ -172,5 +210,9 @@ int wpas_wmm_ac_status(struct wpa_supplicant *wpa_s, char *buf, size_t buflen);
 void wmm_ac_save_tspecs(struct wpa_supplicant *wpa_s);
 void wmm_ac_clear_saved_tspecs(struct wpa_supplicant *wpa_s);
 int wmm_ac_restore_tspecs(struct wpa_supplicant *wpa_s);
+struct wpabuf * wmm_ac_build_ric(struct wpa_supplicant *wpa_s);
+void wmm_ac_readmit_tspecs(struct wpa_supplicant *wpa_s, const u8 *ies,
+			   size_t ies_len);
+void wmm_ac_notify_completed(struct wpa_supplicant *wpa_s);
 
 #endif /* WMM_AC_H */
@@ -9,6 +9,7 @@
 #include "utils/includes.h"
 
 #include "utils/common.h"
+#include "utils/eloop.h"
 #include "common/ieee802_11_defs.h"
 #include "common/ieee802_11_common.h"
 #include "common/wpa_ctrl.h"
@@ -27,6 +28,10 @@
 #define MAX_TFS_IE_LEN  1024
 #define WNM_MAX_NEIGHBOR_REPORT 10
 
+#if defined(CONFIG_IEEE80211R) && defined(CONFIG_SME)
+static void wnm_ft_ds_timeout(void *eloop_ctx, void *timeout_ctx);
+#endif /* CONFIG_IEEE80211R && CONFIG_SME */
+
 
 /* get the TFS IE from driver */
 static int ieee80211_11_get_tfs_ie(struct wpa_supplicant *wpa_s, u8 *buf,
@@ -441,6 +446,10 @@ void wnm_btm_reset(struct wpa_supplicant *wpa_s)
 	wpa_s->wnm_mbo_trans_reason_present = 0;
 	wpa_s->wnm_mbo_transition_reason = 0;
 #endif /* CONFIG_MBO */
+
+#if defined(CONFIG_IEEE80211R) && defined(CONFIG_SME)
+	eloop_cancel_timeout(wnm_ft_ds_timeout, wpa_s, NULL);
+#endif /* CONFIG_IEEE80211R && CONFIG_SME */
 }
 
 
@@ -1102,6 +1111,76 @@ static int wnm_send_bss_transition_mgmt_resp(
 }
 
 
+#if defined(CONFIG_IEEE80211R) && defined(CONFIG_SME)
+
+/* Time to wait for the FT Action Response before reassociating normally */
+#define WNM_FT_DS_TIMEOUT_US 500000
+
+static void wnm_ft_ds_timeout(void *eloop_ctx, void *timeout_ctx)
+{
+	struct wpa_supplicant *wpa_s = eloop_ctx;
+	struct wpa_bss *bss;
+
+	if (wpa_s->wpa_state != WPA_COMPLETED || !wpa_s->current_ssid ||
+	    ether_addr_equal(wpa_s->bssid, wpa_s->wnm_ft_ds_target))
+		return;
+
+	bss = wpa_bss_get_bssid(wpa_s, wpa_s->wnm_ft_ds_target);
+	if (!bss)
+		return;
+
+	wpa_printf(MSG_DEBUG,
+		   "WNM: No FT over-the-DS response from " MACSTR
+		   " - reassociate without it", MAC2STR(bss->bssid));
+	wpa_ft_stop_over_ds(wpa_s->wpa);
+	wpa_s->reassociate = 1;
+	wpa_supplicant_connect(wpa_s, bss, wpa_s->current_ssid);
+}
+
+
+/*
+ * Use FT over-the-DS for the transition if the current AP advertises support
+ * for it and the target is in the same mobility domain. This avoids the
+ * Authentication frame exchange with the target AP and the time spent away
+ * from the current channel before the reassociation.
+ */
+static bool wnm_bss_tm_ft_over_ds(struct wpa_supplicant *wpa_s,
+				  struct wpa_bss *bss, struct wpa_ssid *ssid)
+{
+	const u8 *cur_mdie, *mdie;
+
+	if (!(wpa_s->drv_flags & WPA_DRIVER_FLAGS_SME) ||
+	    !wpa_s->current_bss || ssid != wpa_s->current_ssid ||
+	    wpa_s->wpa_state != WPA_COMPLETED || !wpa_s->sme.ft_used ||
+	    !wpa_key_mgmt_ft(wpa_s->key_mgmt) ||
+	    radio_work_pending(wpa_s, "sme-connect"))
+		return false;
+
+	cur_mdie = wpa_bss_get_ie(wpa_s->current_bss,
+				  WLAN_EID_MOBILITY_DOMAIN);
+	mdie = wpa_bss_get_ie(bss, WLAN_EID_MOBILITY_DOMAIN);
+	if (!cur_mdie || cur_mdie[1] < sizeof(struct rsn_mdie) ||
+	    !(cur_mdie[2 + MOBILITY_DOMAIN_ID_LEN] &
+	      RSN_FT_CAPAB_FT_OVER_DS) ||
+	    !mdie || mdie[1] < sizeof(struct rsn_mdie) ||
+	    os_memcmp(cur_mdie + 2, mdie + 2, MOBILITY_DOMAIN_ID_LEN) != 0)
+		return false;
+
+	if (wpa_ft_start_over_ds(wpa_s->wpa, bss->bssid, mdie, false) < 0)
+		return false;
+
+	wpa_printf(MSG_DEBUG, "WNM: Started FT over-the-DS to " MACSTR,
+		   MAC2STR(bss->bssid));
+	os_memcpy(wpa_s->wnm_ft_ds_target, bss->bssid, ETH_ALEN);
+	eloop_cancel_timeout(wnm_ft_ds_timeout, wpa_s, NULL);
+	eloop_register_timeout(0, WNM_FT_DS_TIMEOUT_US, wnm_ft_ds_timeout,
+			       wpa_s, NULL);
+	return true;
+}
+
+#endif /* CONFIG_IEEE80211R && CONFIG_SME */
+
+
 static void wnm_bss_tm_connect(struct wpa_supplicant *wpa_s,
 			       struct wpa_bss *bss, struct wpa_ssid *ssid,
 			       int after_new_scan)
@@ -1137,6 +1216,11 @@ static void wnm_bss_tm_connect(struct wpa_supplicant *wpa_s,
 		return;
 	}
 
+#if defined(CONFIG_IEEE80211R) && defined(CONFIG_SME)
+	if (wnm_bss_tm_ft_over_ds(wpa_s, bss, ssid))
+		return;
+#endif /* CONFIG_IEEE80211R && CONFIG_SME */
+
 	already_connecting = radio_work_pending(wpa_s, "sme-connect");
 	wpa_s->reassociate = 1;
 	wpa_printf(MSG_DEBUG, "WNM: Issuing connect");
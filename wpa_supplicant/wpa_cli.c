@@ -317,6 +317,13 @@ static int wpa_cli_cmd_relog(struct wpa_ctrl *ctrl, int argc, char *argv[])
 }
 
 
+static int wpa_cli_cmd_log_ring_dump(struct wpa_ctrl *ctrl, int argc,
+				     char *argv[])
+{
+	return wpa_ctrl_command(ctrl, "LOG_RING_DUMP");
+}
+
+
 static int wpa_cli_cmd_note(struct wpa_ctrl *ctrl, int argc, char *argv[])
 {
 	return wpa_cli_cmd(ctrl, "NOTE", 1, argc, argv);
@@ -335,6 +342,12 @@ static int wpa_cli_cmd_pmksa(struct wpa_ctrl *ctrl, int argc, char *argv[])
 }
 
 
+static int wpa_cli_cmd_memstat(struct wpa_ctrl *ctrl, int argc, char *argv[])
+{
+	return wpa_ctrl_command(ctrl, "MEMSTAT");
+}
+
+
 static int wpa_cli_cmd_pmksa_flush(struct wpa_ctrl *ctrl, int argc,
 				   char *argv[])
 {
@@ -505,9 +518,11 @@ static char ** wpa_cli_complete_set(const char *str, int pos)
 		"p2p_go_max_inactivity", "auto_interworking", "okc", "pmf",
 		"sae_check_mfp", "sae_groups", "dtim_period", "beacon_int",
 		"ap_vendor_elements", "ignore_old_scan_res", "freq_list",
-		"scan_cur_freq", "scan_res_valid_for_connect",
+		"scan_res_filter_freqs", "scan_cur_freq", "scan_res_valid_for_connect",
+		"scan_res_stale_budget", "scan_merge", "roam_scan_max_freqs",
 		"sched_scan_interval",
-		"tdls_external_control", "osu_dir", "wowlan_triggers",
+		"tdls_external_control", "tdls_monitor_interval",
+		"tdls_monitor_links", "osu_dir", "wowlan_triggers",
 		"p2p_search_delay", "mac_addr", "rand_addr_lifetime",
 		"preassoc_mac_addr", "key_mgmt_offload", "passive_scan",
 		"reassoc_same_bss_optim", "wps_priority",
@@ -611,10 +626,12 @@ static char ** wpa_cli_complete_get(const char *str, int pos)
 		"p2p_go_max_inactivity", "auto_interworking", "okc", "pmf",
 		"sae_check_mfp",
 		"dtim_period", "beacon_int", "ignore_old_scan_res",
-		"scan_cur_freq", "scan_res_valid_for_connect",
+		"scan_res_filter_freqs", "scan_cur_freq", "scan_res_valid_for_connect",
+		"scan_res_stale_budget", "scan_merge", "roam_scan_max_freqs",
 		"sched_scan_interval",
 		"sched_scan_start_delay",
-		"tdls_external_control", "osu_dir", "wowlan_triggers",
+		"tdls_external_control", "tdls_monitor_interval",
+		"tdls_monitor_links", "osu_dir", "wowlan_triggers",
 		"p2p_search_delay", "mac_addr", "rand_addr_lifetime",
 		"preassoc_mac_addr", "key_mgmt_offload", "passive_scan",
 		"reassoc_same_bss_optim", "extended_key_id"
@@ -2179,7 +2196,7 @@ static char ** wpa_cli_complete_p2p_find(const char *str, int pos)
 	char **res = NULL;
 	int arg = get_cmd_arg_num(str, pos);
 
-	res = os_calloc(6, sizeof(char *));
+	res = os_calloc(7, sizeof(char *));
 	if (res == NULL)
 		return NULL;
 	res[0] = os_strdup("type=social");
@@ -2196,8 +2213,11 @@ static char ** wpa_cli_complete_p2p_find(const char *str, int pos)
 	res[3] = os_strdup("dev_id=");
 	if (res[3] == NULL)
 		return res;
+	res[4] = os_strdup("type=fast");
+	if (res[4] == NULL)
+		return res;
 	if (arg == 1)
-		res[4] = os_strdup("[timeout]");
+		res[5] = os_strdup("[timeout]");
 
 	return res;
 }
@@ -2210,6 +2230,13 @@ static int wpa_cli_cmd_p2p_stop_find(struct wpa_ctrl *ctrl, int argc,
 }
 
 
+static int wpa_cli_cmd_p2p_find_stats(struct wpa_ctrl *ctrl, int argc,
+				      char *argv[])
+{
+	return wpa_ctrl_command(ctrl, "P2P_FIND_STATS");
+}
+
+
 static int wpa_cli_cmd_p2p_asp_provision(struct wpa_ctrl *ctrl, int argc,
 					 char *argv[])
 {
@@ -2709,6 +2736,13 @@ static int wpa_cli_cmd_stop_fetch_anqp(struct wpa_ctrl *ctrl, int argc,
 }
 
 
+static int wpa_cli_cmd_anqp_fetch_stats(struct wpa_ctrl *ctrl, int argc,
+					char *argv[])
+{
+	return wpa_ctrl_command(ctrl, "ANQP_FETCH_STATS");
+}
+
+
 static int wpa_cli_cmd_interworking_select(struct wpa_ctrl *ctrl, int argc,
 					   char *argv[])
 {
@@ -2893,6 +2927,22 @@ static int wpa_cli_cmd_signal_poll(struct wpa_ctrl *ctrl, int argc,
 }
 
 
+static int wpa_cli_cmd_ctrl_stats(struct wpa_ctrl *ctrl, int argc,
+				  char *argv[])
+{
+	if (argc > 0 && os_strcmp(argv[0], "flush") == 0)
+		return wpa_ctrl_command(ctrl, "CTRL_STATS_FLUSH");
+	return wpa_cli_cmd(ctrl, "CTRL_STATS", 0, argc, argv);
+}
+
+
+static int wpa_cli_cmd_eloop_stats(struct wpa_ctrl *ctrl, int argc,
+				   char *argv[])
+{
+	return wpa_cli_cmd(ctrl, "ELOOP_STATS", 0, argc, argv);
+}
+
+
 static int wpa_cli_cmd_signal_monitor(struct wpa_ctrl *ctrl, int argc,
 				   char *argv[])
 {
@@ -2907,6 +2957,13 @@ static int wpa_cli_cmd_pktcnt_poll(struct wpa_ctrl *ctrl, int argc,
 }
 
 
+static int wpa_cli_cmd_connect_trace(struct wpa_ctrl *ctrl, int argc,
+				     char *argv[])
+{
+	return wpa_cli_cmd(ctrl, "CONNECT_TRACE", 0, argc, argv);
+}
+
+
 static int wpa_cli_cmd_reauthenticate(struct wpa_ctrl *ctrl, int argc,
 				      char *argv[])
 {
@@ -3180,6 +3237,13 @@ static int wpa_cli_cmd_dpp_controller_stop(struct wpa_ctrl *ctrl, int argc,
 }
 
 
+static int wpa_cli_cmd_dpp_controller_stats(struct wpa_ctrl *ctrl, int argc,
+					    char *argv[])
+{
+	return wpa_ctrl_command(ctrl, "DPP_CONTROLLER_STATS");
+}
+
+
 static int wpa_cli_cmd_dpp_chirp(struct wpa_ctrl *ctrl, int argc,
 				 char *argv[])
 {
@@ -3361,6 +3425,9 @@ static const struct wpa_cli_cmd wpa_cli_commands[] = {
 	{ "relog", wpa_cli_cmd_relog, NULL,
 	  cli_cmd_flag_none,
 	  "= re-open log-file (allow rolling logs)" },
+	{ "log_ring_dump", wpa_cli_cmd_log_ring_dump, NULL,
+	  cli_cmd_flag_none,
+	  "= write debug ring buffer into the file specified with -F" },
 	{ "note", wpa_cli_cmd_note, NULL,
 	  cli_cmd_flag_none,
 	  "<text> = add a note to wpa_supplicant debug log" },
@@ -3410,6 +3477,9 @@ static const struct wpa_cli_cmd wpa_cli_commands[] = {
 	{ "pmksa_flush", wpa_cli_cmd_pmksa_flush, NULL,
 	  cli_cmd_flag_none,
 	  "= flush PMKSA cache entries" },
+	{ "memstat", wpa_cli_cmd_memstat, NULL,
+	  cli_cmd_flag_none,
+	  "= show memory accounting per subsystem" },
 #ifdef CONFIG_PMKSA_CACHE_EXTERNAL
 	{ "pmksa_get", wpa_cli_cmd_pmksa_get, NULL,
 	  cli_cmd_flag_none,
@@ -3728,6 +3798,9 @@ static const struct wpa_cli_cmd wpa_cli_commands[] = {
 	  "[timeout] [type=*] = find P2P Devices for up-to timeout seconds" },
 	{ "p2p_stop_find", wpa_cli_cmd_p2p_stop_find, NULL, cli_cmd_flag_none,
 	  "= stop P2P Devices search" },
+	{ "p2p_find_stats", wpa_cli_cmd_p2p_find_stats, NULL,
+	  cli_cmd_flag_none,
+	  "= show latency metrics of the latest P2P Devices search" },
 	{ "p2p_asp_provision", wpa_cli_cmd_p2p_asp_provision, NULL,
 	  cli_cmd_flag_none,
 	  "<addr> adv_id=<adv_id> conncap=<conncap> [info=<infodata>] = provision with a P2P ASP Device" },
@@ -3842,6 +3915,9 @@ static const struct wpa_cli_cmd wpa_cli_commands[] = {
 	{ "stop_fetch_anqp", wpa_cli_cmd_stop_fetch_anqp, NULL,
 	  cli_cmd_flag_none,
 	  "= stop fetch_anqp operation" },
+	{ "anqp_fetch_stats", wpa_cli_cmd_anqp_fetch_stats, NULL,
+	  cli_cmd_flag_none,
+	  "= show ANQP fetch duration statistics" },
 	{ "interworking_select", wpa_cli_cmd_interworking_select, NULL,
 	  cli_cmd_flag_none,
 	  "[auto] = perform Interworking network selection" },
@@ -3917,12 +3993,21 @@ static const struct wpa_cli_cmd wpa_cli_commands[] = {
 	{ "signal_poll", wpa_cli_cmd_signal_poll, NULL,
 	  cli_cmd_flag_none,
 	  "= get signal parameters" },
+	{ "ctrl_stats", wpa_cli_cmd_ctrl_stats, NULL,
+	  cli_cmd_flag_none,
+	  "[flush|<command>] = show or clear control interface command statistics" },
+	{ "eloop_stats", wpa_cli_cmd_eloop_stats, NULL,
+	  cli_cmd_flag_none,
+	  "[START [<slow msec>]|STOP] = show or control event loop handler statistics" },
 	{ "signal_monitor", wpa_cli_cmd_signal_monitor, NULL,
 	  cli_cmd_flag_none,
 	  "= set signal monitor parameters" },
 	{ "pktcnt_poll", wpa_cli_cmd_pktcnt_poll, NULL,
 	  cli_cmd_flag_none,
 	  "= get TX/RX packet counters" },
+	{ "connect_trace", wpa_cli_cmd_connect_trace, NULL,
+	  cli_cmd_flag_none,
+	  "[HISTOGRAM|RESET] = get connection phase latencies" },
 	{ "reauthenticate", wpa_cli_cmd_reauthenticate, NULL,
 	  cli_cmd_flag_none,
 	  "= trigger IEEE 802.1X/EAPOL reauthentication" },
@@ -3955,7 +4040,7 @@ static const struct wpa_cli_cmd wpa_cli_commands[] = {
 	  "<command> = driver private commands" },
 #endif /* ANDROID */
 	{ "radio_work", wpa_cli_cmd_radio_work, NULL, cli_cmd_flag_none,
-	  "= radio_work <show/add/done>" },
+	  "= radio_work <show/stats/add/done>" },
 	{ "vendor", wpa_cli_cmd_vendor, NULL, cli_cmd_flag_none,
 	  "<vendor id> <command id> [<hex formatted command argument>] = Send vendor command"
 	},
@@ -4033,10 +4118,13 @@ static const struct wpa_cli_cmd wpa_cli_commands[] = {
 #ifdef CONFIG_DPP2
 	{ "dpp_controller_start", wpa_cli_cmd_dpp_controller_start, NULL,
 	  cli_cmd_flag_none,
-	  "[tcp_port=<port>] [role=..] = start DPP controller" },
+	  "[tcp_port=<port>] [role=..] [max_conn=<num>] = start DPP controller" },
 	{ "dpp_controller_stop", wpa_cli_cmd_dpp_controller_stop, NULL,
 	  cli_cmd_flag_none,
 	  "= stop DPP controller" },
+	{ "dpp_controller_stats", wpa_cli_cmd_dpp_controller_stats, NULL,
+	  cli_cmd_flag_none,
+	  "= show DPP controller connection and throughput statistics" },
 	{ "dpp_chirp", wpa_cli_cmd_dpp_chirp, NULL,
 	  cli_cmd_flag_none,
 	  "own=<BI ID> iter=<count> = start DPP chirp" },
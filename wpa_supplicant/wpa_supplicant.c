@@ -61,11 +61,14 @@
 #include "scan.h"
 #include "offchannel.h"
 #include "hs20_supplicant.h"
+#include "interworking.h"
 #include "wnm_sta.h"
 #include "wpas_kay.h"
 #include "mesh.h"
 #include "dpp_supplicant.h"
 #include "nan_usd.h"
+#include "pmksa_store.h"
+#include "wpas_status_shm.h"
 #ifdef CONFIG_MESH
 #include "ap/ap_config.h"
 #include "ap/hostapd.h"
@@ -479,6 +482,7 @@ static void remove_bss_tmp_disallowed_entry(struct wpa_supplicant *wpa_s,
 {
 	eloop_cancel_timeout(wpa_bss_tmp_disallow_timeout, wpa_s, bss);
 	dl_list_del(&bss->list);
+	dl_list_del(&bss->hash);
 	os_free(bss);
 }
 
@@ -563,6 +567,7 @@ static void wpa_supplicant_cleanup(struct wpa_supplicant *wpa_s)
 	wpabuf_free(wpa_s->rsnxe_override_eapol);
 	wpa_s->rsnxe_override_eapol = NULL;
 	wpas_clear_driver_signal_override(wpa_s);
+	wpas_twt_mgr_deinit(wpa_s);
 #endif /* CONFIG_TESTING_OPTIONS */
 
 	if (wpa_s->conf != NULL) {
@@ -729,6 +734,8 @@ static void wpa_supplicant_cleanup(struct wpa_supplicant *wpa_s)
 	wpa_s->lci = NULL;
 #ifndef CONFIG_NO_RRM
 	wpas_clear_beacon_rep_data(wpa_s);
+	os_free(wpa_s->rrm.neighbor_freqs);
+	wpa_s->rrm.neighbor_freqs = NULL;
 #endif /* CONFIG_NO_RRM */
 
 #ifdef CONFIG_PMKSA_CACHE_EXTERNAL
@@ -1072,6 +1079,14 @@ void wpa_supplicant_set_state(struct wpa_supplicant *wpa_s,
 		wpa_s->normal_scans = 0;
 	}
 
+	if (state == WPA_4WAY_HANDSHAKE)
+		wpas_connect_trace(wpa_s, WPAS_CONNECT_4WAY);
+	else if (state == WPA_COMPLETED)
+		wpas_connect_trace(wpa_s, WPAS_CONNECT_COMPLETED);
+	else if (state == WPA_DISCONNECTED &&
+		 old_state >= WPA_AUTHENTICATING && old_state < WPA_COMPLETED)
+		wpas_connect_trace_abort(wpa_s);
+
 #ifdef CONFIG_P2P
 	/*
 	 * P2PS client has to reply to Probe Request frames received on the
@@ -1182,10 +1197,21 @@ void wpa_supplicant_set_state(struct wpa_supplicant *wpa_s,
 #ifndef CONFIG_NO_WMM_AC
 	if (old_state >= WPA_ASSOCIATED && wpa_s->wpa_state < WPA_ASSOCIATED)
 		wmm_ac_notify_disassoc(wpa_s);
+	else if (state == WPA_COMPLETED && old_state != WPA_COMPLETED)
+		wmm_ac_notify_completed(wpa_s);
 #endif /* CONFIG_NO_WMM_AC */
 
+#ifdef CONFIG_TESTING_OPTIONS
+	if (state == WPA_COMPLETED && old_state != WPA_COMPLETED)
+		wpas_twt_mgr_connected(wpa_s);
+	else if (old_state >= WPA_ASSOCIATED && state < WPA_ASSOCIATED)
+		wpas_twt_mgr_disconnected(wpa_s);
+#endif /* CONFIG_TESTING_OPTIONS */
+
 	if (wpa_s->wpa_state != old_state) {
+		wpa_s->signal_cache_valid = false;
 		wpas_notify_state_changed(wpa_s, wpa_s->wpa_state, old_state);
+		wpas_status_shm_update(wpa_s);
 
 		/*
 		 * Notify the P2P Device interface about a state change in one
@@ -1333,6 +1359,9 @@ int wpa_supplicant_reload_configuration(struct wpa_supplicant *wpa_s)
 	}
 	eapol_sm_notify_config(wpa_s->eapol, NULL, NULL);
 	wpa_sm_set_config(wpa_s->wpa, NULL);
+	/* Keep the stored entries; they are restored for the new networks */
+	pmksa_store_deinit(wpa_s);
+	wpas_status_shm_deinit(wpa_s);
 	wpa_sm_pmksa_cache_flush(wpa_s->wpa, NULL);
 	wpa_sm_set_fast_reauth(wpa_s->wpa, wpa_s->conf->fast_reauth);
 	rsn_preauth_deinit(wpa_s->wpa);
@@ -1346,6 +1375,8 @@ int wpa_supplicant_reload_configuration(struct wpa_supplicant *wpa_s)
 	if (reconf_ctrl)
 		wpa_s->ctrl_iface = wpa_supplicant_ctrl_iface_init(wpa_s);
 
+	pmksa_store_init(wpa_s);
+	wpas_status_shm_init(wpa_s);
 	wpa_supplicant_update_config(wpa_s);
 
 	wpa_supplicant_clear_status(wpa_s);
@@ -2675,6 +2706,9 @@ void wpa_supplicant_associate(struct wpa_supplicant *wpa_s,
 	wpa_s->own_disconnect_req = 0;
 	wpa_s->own_reconnect_req = 0;
 
+	wpas_connect_trace(wpa_s, WPAS_CONNECT_SELECT);
+	pmksa_store_restore(wpa_s, ssid);
+
 	/*
 	 * If we are starting a new connection, any previously pending EAPOL
 	 * RX cannot be valid anymore.
@@ -2713,6 +2747,10 @@ void wpa_supplicant_associate(struct wpa_supplicant *wpa_s,
 			clear_rejected = false;
 		} else if (wpa_s->current_bss && wpa_s->current_bss != bss) {
 			os_get_reltime(&wpa_s->roam_start);
+#ifndef CONFIG_NO_WMM_AC
+			/* Re-admitted by the new AP */
+			wmm_ac_save_tspecs(wpa_s);
+#endif /* CONFIG_NO_WMM_AC */
 		}
 	}
 
@@ -4309,6 +4347,7 @@ static void wpas_start_assoc_cb(struct wpa_radio_work *work, int deinit)
 	}
 
 	wpa_s->connect_work = work;
+	wpas_connect_trace(wpa_s, WPAS_CONNECT_WORK_START);
 
 	if (cwork->bss_removed || !wpas_valid_bss_ssid(wpa_s, bss, ssid) ||
 	    wpas_network_disabled(wpa_s, ssid)) {
@@ -6155,6 +6194,7 @@ static struct wpa_supplicant *
 wpa_supplicant_alloc(struct wpa_supplicant *parent)
 {
 	struct wpa_supplicant *wpa_s;
+	unsigned int i;
 
 	wpa_s = os_zalloc(sizeof(*wpa_s));
 	if (wpa_s == NULL)
@@ -6168,7 +6208,10 @@ wpa_supplicant_alloc(struct wpa_supplicant *parent)
 	wpa_s->setband_mask = WPA_SETBAND_AUTO;
 
 	dl_list_init(&wpa_s->bss_tmp_disallowed);
+	for (i = 0; i < WPA_BSS_TMP_DISALLOWED_HASH_SIZE; i++)
+		dl_list_init(&wpa_s->bss_tmp_disallowed_hash[i]);
 	dl_list_init(&wpa_s->fils_hlp_req);
+	dl_list_init(&wpa_s->pending_action_queue);
 #ifdef CONFIG_TESTING_OPTIONS
 	dl_list_init(&wpa_s->drv_signal_override);
 	wpa_s->test_assoc_comeback_type = -1;
@@ -6863,6 +6906,104 @@ static struct wpa_radio * radio_add_interface(struct wpa_supplicant *wpa_s,
 }
 
 
+/* Radio work scheduling priorities */
+enum radio_work_prio {
+	RADIO_WORK_PRIO_LOW,
+	RADIO_WORK_PRIO_NORMAL,
+	RADIO_WORK_PRIO_HIGH,
+	RADIO_WORK_PRIO_NEXT, /* radio_add_work() called with next=1 */
+};
+
+/* Started work of this class can be stopped to free the radio */
+#define RADIO_WORK_PREEMPTIBLE BIT(0)
+/* Work of this class preempts started preemptible work */
+#define RADIO_WORK_PREEMPTS BIT(1)
+
+/*
+ * Pending works are started in priority order and in FIFO order within the
+ * same priority. A work that has been waiting for longer than its deadline is
+ * raised to RADIO_WORK_PRIO_HIGH so that the lower priority classes do not get
+ * starved. The last entry is used for all other types, e.g., external works.
+ * The table must not have more than RADIO_WORK_MAX_CLASSES entries.
+ */
+static const struct radio_work_class {
+	const char *type;
+	enum radio_work_prio prio;
+	unsigned int deadline_ms; /* 0 = no deadline */
+	unsigned int flags;
+} radio_work_classes[] = {
+	{ "connect", RADIO_WORK_PRIO_HIGH, 0, RADIO_WORK_PREEMPTS },
+	{ "sme-connect", RADIO_WORK_PRIO_HIGH, 0, RADIO_WORK_PREEMPTS },
+	{ "pasn-start-auth", RADIO_WORK_PRIO_HIGH, 0, 0 },
+	{ "p2p-pasn-start-auth", RADIO_WORK_PRIO_HIGH, 0, 0 },
+	{ "p2p-send-action", RADIO_WORK_PRIO_HIGH, 0, 0 },
+	{ "scan", RADIO_WORK_PRIO_NORMAL, 5000, 0 },
+	{ "p2p-scan", RADIO_WORK_PRIO_NORMAL, 5000, 0 },
+	{ "nan-usd-tx", RADIO_WORK_PRIO_NORMAL, 1000, 0 },
+	{ "gas-query", RADIO_WORK_PRIO_LOW, 2000, RADIO_WORK_PREEMPTIBLE },
+	{ "p2p-listen", RADIO_WORK_PRIO_LOW, 2000, RADIO_WORK_PREEMPTIBLE },
+	{ "dpp-listen", RADIO_WORK_PRIO_LOW, 2000, 0 },
+	{ "nan-usd-listen", RADIO_WORK_PRIO_LOW, 2000, 0 },
+	{ "other", RADIO_WORK_PRIO_NORMAL, 0, 0 },
+};
+
+#define RADIO_WORK_NUM_CLASSES ARRAY_SIZE(radio_work_classes)
+
+
+static unsigned int radio_work_get_class(const char *type)
+{
+	unsigned int i;
+
+	for (i = 0; i < RADIO_WORK_NUM_CLASSES - 1; i++) {
+		if (os_strcmp(type, radio_work_classes[i].type) == 0)
+			return i;
+	}
+
+	return RADIO_WORK_NUM_CLASSES - 1;
+}
+
+
+static enum radio_work_prio radio_work_prio(struct wpa_radio_work *work,
+					    struct os_reltime *now)
+{
+	const struct radio_work_class *cls = &radio_work_classes[work->cls];
+	struct os_reltime age;
+
+	if (work->next)
+		return RADIO_WORK_PRIO_NEXT;
+	if (now && cls->deadline_ms && cls->prio < RADIO_WORK_PRIO_HIGH) {
+		os_reltime_sub(now, &work->time, &age);
+		if (os_reltime_in_ms(&age) >= (int) cls->deadline_ms)
+			return RADIO_WORK_PRIO_HIGH;
+	}
+
+	return cls->prio;
+}
+
+
+static void radio_work_enqueue(struct wpa_radio *radio,
+			       struct wpa_radio_work *work)
+{
+	struct wpa_radio_work *tmp;
+	enum radio_work_prio prio;
+
+	if (work->next) {
+		dl_list_add(&radio->work, &work->list);
+		return;
+	}
+
+	/* Insert ahead of the first pending work with lower priority */
+	prio = radio_work_prio(work, NULL);
+	dl_list_for_each(tmp, &radio->work, struct wpa_radio_work, list) {
+		if (!tmp->started && radio_work_prio(tmp, NULL) < prio) {
+			dl_list_add_tail(&tmp->list, &work->list);
+			return;
+		}
+	}
+	dl_list_add_tail(&radio->work, &work->list);
+}
+
+
 static void radio_work_free(struct wpa_radio_work *work)
 {
 	if (work->wpa_s->scan_work == work) {
@@ -6908,39 +7049,98 @@ static int radio_work_is_scan(struct wpa_radio_work *work)
 }
 
 
+static bool radio_work_blocked_by_ext_scan(struct wpa_radio *radio,
+					   struct wpa_radio_work *work)
+{
+	return os_strcmp(work->type, "scan") == 0 &&
+		external_scan_running(radio) &&
+		(((struct wpa_driver_scan_params *) work->ctx)->only_new_results ||
+		 work->wpa_s->clear_driver_scan_cache);
+}
+
+
+/*
+ * Select the pending work with the highest priority. The queue is kept in
+ * priority order, so this differs from the first pending work only when a
+ * work has passed its deadline.
+ */
+static struct wpa_radio_work * radio_work_select(struct wpa_radio *radio,
+						 bool check_ext_scan)
+{
+	struct wpa_radio_work *tmp, *best = NULL;
+	enum radio_work_prio prio, best_prio = RADIO_WORK_PRIO_LOW;
+	struct os_reltime now;
+
+	os_get_reltime(&now);
+	dl_list_for_each(tmp, &radio->work, struct wpa_radio_work, list) {
+		if (tmp->started ||
+		    (check_ext_scan &&
+		     radio_work_blocked_by_ext_scan(radio, tmp)))
+			continue;
+		prio = radio_work_prio(tmp, &now);
+		if (!best || prio > best_prio) {
+			best = tmp;
+			best_prio = prio;
+		}
+	}
+
+	if (best && !best->next && best_prio > radio_work_classes[best->cls].prio)
+		wpa_dbg(best->wpa_s, MSG_DEBUG,
+			"Radio work '%s'@%p passed its deadline",
+			best->type, best);
+
+	return best;
+}
+
+
+/*
+ * Whether the radio can serve works on different bands at the same time, e.g.,
+ * a DBS or MLO capable device that can scan on one band while associating on
+ * another one.
+ */
+static bool radio_work_multi_band(struct wpa_supplicant *wpa_s)
+{
+	return wpa_s->num_multichan_concurrent > 1 ||
+		(wpa_s->drv_flags2 & WPA_DRIVER_FLAGS2_MLO);
+}
+
+
+/* Bands used by a work; unknown bands are treated as the whole radio. */
+static unsigned int radio_work_resources(struct wpa_radio_work *work)
+{
+	return work->bands ? work->bands : ~0U;
+}
+
+
 static struct wpa_radio_work * radio_work_get_next_work(struct wpa_radio *radio)
 {
 	struct wpa_radio_work *active_work = NULL;
 	struct wpa_radio_work *tmp;
+	unsigned int busy = 0, reserved = 0;
+	bool connect_active = false;
 
-	/* Get the active work to know the type and band. */
+	/* Get the active works to know the types and bands in use. */
 	dl_list_for_each(tmp, &radio->work, struct wpa_radio_work, list) {
-		if (tmp->started) {
+		if (!tmp->started)
+			continue;
+		if (!active_work)
 			active_work = tmp;
-			break;
-		}
+		busy |= radio_work_resources(tmp);
+		if (radio_work_is_connect(tmp))
+			connect_active = true;
 	}
 
 	if (!active_work) {
 		/* No active work, start one */
 		radio->num_active_works = 0;
-		dl_list_for_each(tmp, &radio->work, struct wpa_radio_work,
-				 list) {
-			if (os_strcmp(tmp->type, "scan") == 0 &&
-			    external_scan_running(radio) &&
-			    (((struct wpa_driver_scan_params *)
-			      tmp->ctx)->only_new_results ||
-			     tmp->wpa_s->clear_driver_scan_cache))
-				continue;
-			return tmp;
-		}
-		return NULL;
+		return radio_work_select(radio, true);
 	}
 
-	if (radio_work_is_connect(active_work)) {
+	if (connect_active && !radio_work_multi_band(active_work->wpa_s)) {
 		/*
 		 * If the active work is either connect or sme-connect,
-		 * do not parallelize them with other radio works.
+		 * do not parallelize them with other radio works unless the
+		 * radio can operate on multiple bands at the same time.
 		 */
 		wpa_dbg(active_work->wpa_s, MSG_DEBUG,
 			"Do not parallelize radio work with %s",
@@ -6952,12 +7152,23 @@ static struct wpa_radio_work * radio_work_get_next_work(struct wpa_radio *radio)
 		if (tmp->started)
 			continue;
 
-		/*
-		 * If connect or sme-connect are enqueued, parallelize only
-		 * those operations ahead of them in the queue.
-		 */
-		if (radio_work_is_connect(tmp))
-			break;
+		if (radio_work_is_connect(tmp)) {
+			/*
+			 * If connect or sme-connect are enqueued, parallelize
+			 * only those operations ahead of them in the queue. On
+			 * a multi-band radio, the bands of the connect work are
+			 * reserved for it and work on other bands may still be
+			 * started.
+			 */
+			if (!radio_work_multi_band(tmp->wpa_s))
+				break;
+			if (radio_work_resources(tmp) & busy) {
+				reserved |= radio_work_resources(tmp);
+				continue;
+			}
+		} else if (connect_active && !radio_work_multi_band(tmp->wpa_s)) {
+			continue;
+		}
 
 		/* Serialize parallel scan and p2p_scan operations on the same
 		 * interface since the driver_nl80211 mechanism for tracking
@@ -6970,30 +7181,36 @@ static struct wpa_radio_work * radio_work_get_next_work(struct wpa_radio *radio)
 				tmp->type, active_work->type);
 			continue;
 		}
+
+		/* Do not delay a pending connection on its bands */
+		if (radio_work_resources(tmp) & reserved)
+			continue;
+
 		/*
-		 * Check that the radio works are distinct and
-		 * on different bands.
+		 * A connection needs exclusive use of its bands. Other radio
+		 * works need to be distinct and on different bands.
 		 */
-		if (os_strcmp(active_work->type, tmp->type) != 0 &&
-		    (active_work->bands != tmp->bands)) {
-			/*
-			 * If a scan has to be scheduled through nl80211 scan
-			 * interface and if an external scan is already running,
-			 * do not schedule the scan since it is likely to get
-			 * rejected by kernel.
-			 */
-			if (os_strcmp(tmp->type, "scan") == 0 &&
-			    external_scan_running(radio) &&
-			    (((struct wpa_driver_scan_params *)
-			      tmp->ctx)->only_new_results ||
-			     tmp->wpa_s->clear_driver_scan_cache))
+		if (connect_active || radio_work_is_connect(tmp)) {
+			if (radio_work_resources(tmp) & busy)
 				continue;
-
-			wpa_dbg(active_work->wpa_s, MSG_DEBUG,
-				"active_work:%s new_work:%s",
-				active_work->type, tmp->type);
-			return tmp;
+		} else if (os_strcmp(active_work->type, tmp->type) == 0 ||
+			   active_work->bands == tmp->bands) {
+			continue;
 		}
+
+		/*
+		 * If a scan has to be scheduled through nl80211 scan
+		 * interface and if an external scan is already running,
+		 * do not schedule the scan since it is likely to get
+		 * rejected by kernel.
+		 */
+		if (radio_work_blocked_by_ext_scan(radio, tmp))
+			continue;
+
+		wpa_dbg(active_work->wpa_s, MSG_DEBUG,
+			"active_work:%s new_work:%s (bands 0x%x, in use 0x%x)",
+			active_work->type, tmp->type, tmp->bands, busy);
+		return tmp;
 	}
 
 	/* Did not find a radio work to schedule in parallel. */
@@ -7007,6 +7224,7 @@ static void radio_start_next_work(void *eloop_ctx, void *timeout_ctx)
 	struct wpa_radio_work *work;
 	struct os_reltime now, diff;
 	struct wpa_supplicant *wpa_s;
+	struct wpa_radio_work_stats *stats;
 
 	work = dl_list_first(&radio->work, struct wpa_radio_work, list);
 	if (work == NULL) {
@@ -7026,6 +7244,13 @@ static void radio_start_next_work(void *eloop_ctx, void *timeout_ctx)
 			wpa_printf(MSG_DEBUG, "Delay radio work start until externally triggered scan completes");
 			return;
 		}
+
+		work = radio_work_select(radio, false);
+		if (!work)
+			return;
+		/* Keep the started work at the head of the queue */
+		dl_list_del(&work->list);
+		dl_list_add(&radio->work, &work->list);
 	} else {
 		work = NULL;
 		if (radio->num_active_works < MAX_ACTIVE_WORKS) {
@@ -7042,6 +7267,16 @@ static void radio_start_next_work(void *eloop_ctx, void *timeout_ctx)
 	wpa_dbg(wpa_s, MSG_DEBUG,
 		"Starting radio work '%s'@%p after %ld.%06ld second wait",
 		work->type, work, diff.sec, diff.usec);
+	stats = &radio->stats[work->cls];
+	stats->started++;
+	stats->total_wait.sec += diff.sec;
+	stats->total_wait.usec += diff.usec;
+	while (stats->total_wait.usec >= 1000000) {
+		stats->total_wait.sec++;
+		stats->total_wait.usec -= 1000000;
+	}
+	if (os_reltime_before(&stats->max_wait, &diff))
+		stats->max_wait = diff;
 	work->started = 1;
 	work->time = now;
 	radio->num_active_works++;
@@ -7107,6 +7342,58 @@ void radio_remove_pending_work(struct wpa_supplicant *wpa_s, void *ctx)
 }
 
 
+static struct wpa_radio_work *
+radio_work_find_preemptible(struct wpa_radio *radio)
+{
+	struct wpa_radio_work *work;
+
+	dl_list_for_each(work, &radio->work, struct wpa_radio_work, list) {
+		if (work->started &&
+		    (radio_work_classes[work->cls].flags &
+		     RADIO_WORK_PREEMPTIBLE))
+			return work;
+	}
+
+	return NULL;
+}
+
+
+static void radio_preempt_works(void *eloop_ctx, void *timeout_ctx)
+{
+	struct wpa_radio *radio = eloop_ctx;
+	struct wpa_radio_work *work, *pending = NULL;
+	struct wpa_supplicant *wpa_s;
+	const char *type;
+
+	dl_list_for_each(work, &radio->work, struct wpa_radio_work, list) {
+		if (!work->started &&
+		    (radio_work_classes[work->cls].flags &
+		     RADIO_WORK_PREEMPTS)) {
+			pending = work;
+			break;
+		}
+	}
+	if (!pending)
+		return;
+
+	/*
+	 * The deinit callback may remove or add other works, so look for the
+	 * next preemptible work from the beginning of the queue each time.
+	 */
+	wpa_s = pending->wpa_s;
+	type = pending->type;
+	while ((work = radio_work_find_preemptible(radio))) {
+		wpa_dbg(wpa_s, MSG_DEBUG, "Preempt radio work '%s'@%p for '%s'",
+			work->type, work, type);
+		radio->stats[work->cls].preempted++;
+		work->cb(work, 1);
+		radio_work_free(work);
+	}
+
+	radio_work_check_next(wpa_s);
+}
+
+
 static void radio_remove_interface(struct wpa_supplicant *wpa_s)
 {
 	struct wpa_radio *radio = wpa_s->radio;
@@ -7128,6 +7415,7 @@ static void radio_remove_interface(struct wpa_supplicant *wpa_s)
 
 	wpa_printf(MSG_DEBUG, "Remove radio %s", radio->name);
 	eloop_cancel_timeout(radio_start_next_work, radio, NULL);
+	eloop_cancel_timeout(radio_preempt_works, radio, NULL);
 	os_free(radio);
 }
 
@@ -7192,6 +7480,8 @@ int radio_add_work(struct wpa_supplicant *wpa_s, unsigned int freq,
 	work->wpa_s = wpa_s;
 	work->cb = cb;
 	work->ctx = ctx;
+	work->next = !!next;
+	work->cls = radio_work_get_class(type);
 
 	if (freq)
 		work->bands = wpas_freq_to_band(freq);
@@ -7203,11 +7493,28 @@ int radio_add_work(struct wpa_supplicant *wpa_s, unsigned int freq,
 	else
 		work->bands = wpas_get_bands(wpa_s, NULL);
 
+	if (radio_work_is_connect(work)) {
+		struct wpa_connect_work *cwork = ctx;
+		struct wpa_bss *bss = cwork->bss;
+		int i;
+
+		/* An MLO connection uses the bands of all the links */
+		if (bss && bss->valid_links) {
+			for_each_link(bss->valid_links, i)
+				work->bands |=
+					wpas_freq_to_band(bss->mld_links[i].freq);
+		}
+	}
+
 	was_empty = dl_list_empty(&wpa_s->radio->work);
-	if (next)
-		dl_list_add(&wpa_s->radio->work, &work->list);
-	else
-		dl_list_add_tail(&wpa_s->radio->work, &work->list);
+	radio_work_enqueue(radio, work);
+	if ((radio_work_classes[work->cls].flags & RADIO_WORK_PREEMPTS) &&
+	    radio_work_find_preemptible(radio)) {
+		/* Preempt from eloop to avoid calling the deinit callback of
+		 * the started work from within the caller's context. */
+		eloop_cancel_timeout(radio_preempt_works, radio, NULL);
+		eloop_register_timeout(0, 0, radio_preempt_works, radio, NULL);
+	}
 	if (was_empty) {
 		wpa_dbg(wpa_s, MSG_DEBUG, "First radio work item in the queue - schedule start immediately");
 		radio_work_check_next(wpa_s);
@@ -7247,6 +7554,50 @@ void radio_work_done(struct wpa_radio_work *work)
 }
 
 
+/**
+ * radio_work_stats - Write radio work queue time statistics
+ * @radio: Pointer to radio data
+ * @buf: Buffer for the statistics
+ * @buflen: Length of the buffer
+ * Returns: Number of characters written
+ */
+int radio_work_stats(struct wpa_radio *radio, char *buf, size_t buflen)
+{
+	char *pos = buf, *end = buf + buflen;
+	struct wpa_radio_work_stats *stats;
+	unsigned int i;
+	long avg;
+	int ret;
+
+	for (i = 0; i < RADIO_WORK_NUM_CLASSES; i++) {
+		stats = &radio->stats[i];
+		if (!stats->started && !stats->preempted)
+			continue;
+		avg = stats->started ?
+			(stats->total_wait.sec * 1000000 +
+			 stats->total_wait.usec) / stats->started : 0;
+		ret = os_snprintf(pos, end - pos,
+				  "%s started=%u preempted=%u avg_wait_us=%ld max_wait_us=%ld\n",
+				  radio_work_classes[i].type, stats->started,
+				  stats->preempted, avg,
+				  (long) (stats->max_wait.sec * 1000000 +
+					  stats->max_wait.usec));
+		if (os_snprintf_error(end - pos, ret))
+			break;
+		pos += ret;
+	}
+
+	if (radio->merged_scans) {
+		ret = os_snprintf(pos, end - pos, "merged_scans=%u\n",
+				  radio->merged_scans);
+		if (!os_snprintf_error(end - pos, ret))
+			pos += ret;
+	}
+
+	return pos - buf;
+}
+
+
 struct wpa_radio_work *
 radio_work_pending(struct wpa_supplicant *wpa_s, const char *type)
 {
@@ -7600,6 +7951,8 @@ static int wpa_supplicant_init_iface(struct wpa_supplicant *wpa_s,
 #ifdef CONFIG_TDLS
 	if (!iface->p2p_mgmt && wpa_tdls_init(wpa_s->wpa))
 		return -1;
+	wpa_tdls_set_monitor(wpa_s->wpa, wpa_s->conf->tdls_monitor_interval,
+			     wpa_s->conf->tdls_monitor_links);
 #endif /* CONFIG_TDLS */
 
 	if (wpa_s->conf->country[0] && wpa_s->conf->country[1] &&
@@ -7725,6 +8078,12 @@ static int wpa_supplicant_init_iface(struct wpa_supplicant *wpa_s,
 	if (wpas_init_ext_pw(wpa_s) < 0)
 		return -1;
 
+	if (pmksa_store_init(wpa_s) < 0)
+		return -1;
+
+	if (wpas_status_shm_init(wpa_s) < 0)
+		return -1;
+
 #ifndef CONFIG_NO_RRM
 	wpas_rrm_reset(wpa_s);
 #endif /* CONFIG_NO_RRM */
@@ -7761,6 +8120,9 @@ static void wpa_supplicant_deinit_iface(struct wpa_supplicant *wpa_s,
 	struct wpa_global *global = wpa_s->global;
 	struct wpa_supplicant *iface, *prev;
 
+	pmksa_store_deinit(wpa_s);
+	wpas_status_shm_deinit(wpa_s);
+
 	if (wpa_s == wpa_s->parent || (wpa_s == wpa_s->p2pdev && wpa_s->p2p_mgmt))
 		wpas_p2p_group_remove(wpa_s, "*");
 
@@ -7827,6 +8189,8 @@ static void wpa_supplicant_deinit_iface(struct wpa_supplicant *wpa_s,
 
 	wpa_supplicant_ctrl_iface_deinit(wpa_s, wpa_s->ctrl_iface);
 	wpa_s->ctrl_iface = NULL;
+	wpas_ctrl_stats_free(wpa_s->ctrl_stats);
+	wpa_s->ctrl_stats = NULL;
 
 #ifdef CONFIG_MESH
 	if (wpa_s->ifmsh) {
@@ -7917,6 +8281,16 @@ static int wpa_supplicant_match_existing(struct wpa_global *global)
 #endif /* CONFIG_MATCH_IFACE */
 
 
+static unsigned int wpas_iface_hash(const char *ifname)
+{
+	unsigned int hash = 0;
+
+	while (*ifname)
+		hash = hash * 31 + (u8) *ifname++;
+	return hash % WPA_IFACE_HASH_SIZE;
+}
+
+
 /**
  * wpa_supplicant_add_iface - Add a new network interface
  * @global: Pointer to global data from wpa_supplicant_init()
@@ -7988,6 +8362,8 @@ struct wpa_supplicant * wpa_supplicant_add_iface(struct wpa_global *global,
 
 	wpa_s->next = global->ifaces;
 	global->ifaces = wpa_s;
+	dl_list_add(&global->iface_hash[wpas_iface_hash(wpa_s->ifname)],
+		    &wpa_s->iface_hash);
 
 	wpa_dbg(wpa_s, MSG_DEBUG, "Added interface %s", wpa_s->ifname);
 	wpa_supplicant_set_state(wpa_s, WPA_DISCONNECTED);
@@ -8041,6 +8417,7 @@ int wpa_supplicant_remove_iface(struct wpa_global *global,
 			return -1;
 		prev->next = wpa_s->next;
 	}
+	dl_list_del(&wpa_s->iface_hash);
 
 	wpa_dbg(wpa_s, MSG_DEBUG, "Removing interface %s", wpa_s->ifname);
 
@@ -8105,7 +8482,8 @@ struct wpa_supplicant * wpa_supplicant_get_iface(struct wpa_global *global,
 {
 	struct wpa_supplicant *wpa_s;
 
-	for (wpa_s = global->ifaces; wpa_s; wpa_s = wpa_s->next) {
+	dl_list_for_each(wpa_s, &global->iface_hash[wpas_iface_hash(ifname)],
+			 struct wpa_supplicant, iface_hash) {
 		if (os_strcmp(wpa_s->ifname, ifname) == 0)
 			return wpa_s;
 	}
@@ -8193,6 +8571,11 @@ struct wpa_global * wpa_supplicant_init(struct wpa_params *params)
 			return NULL;
 		}
 	}
+	if (params->wpa_debug_ring_path &&
+	    wpa_debug_ring_open(params->wpa_debug_ring_path) < 0) {
+		wpa_printf(MSG_ERROR, "Failed to enable debug ring buffer");
+		return NULL;
+	}
 
 	ret = eap_register_methods();
 	if (ret) {
@@ -8208,6 +8591,15 @@ struct wpa_global * wpa_supplicant_init(struct wpa_params *params)
 		return NULL;
 	dl_list_init(&global->p2p_srv_bonjour);
 	dl_list_init(&global->p2p_srv_upnp);
+	for (i = 0; i < P2P_SRV_HASH_SIZE; i++) {
+		dl_list_init(&global->p2p_srv_bonjour_hash[i]);
+		dl_list_init(&global->p2p_srv_upnp_hash[i]);
+	}
+	for (i = 0; i < WPA_IFACE_HASH_SIZE; i++)
+		dl_list_init(&global->iface_hash[i]);
+#ifdef CONFIG_INTERWORKING
+	dl_list_init(&global->anqp_cache);
+#endif /* CONFIG_INTERWORKING */
 	global->params.daemonize = params->daemonize;
 	global->params.wait_for_monitor = params->wait_for_monitor;
 	global->params.dbus_ctrl_interface = params->dbus_ctrl_interface;
@@ -8422,9 +8814,13 @@ void wpa_supplicant_deinit(struct wpa_global *global)
 
 	while (global->ifaces)
 		wpa_supplicant_remove_iface(global, global->ifaces, 1);
+#ifdef CONFIG_INTERWORKING
+	interworking_anqp_cache_flush(global);
+#endif /* CONFIG_INTERWORKING */
 
 	if (global->ctrl_iface)
 		wpa_supplicant_global_ctrl_iface_deinit(global->ctrl_iface);
+	wpas_ctrl_stats_free(global->ctrl_stats);
 
 	wpas_notify_supplicant_deinitialized(global);
 
@@ -8470,6 +8866,7 @@ void wpa_supplicant_deinit(struct wpa_global *global)
 	wpa_debug_close_syslog();
 	wpa_debug_close_file();
 	wpa_debug_close_linux_tracing();
+	wpa_debug_ring_close();
 }
 
 
@@ -8510,6 +8907,13 @@ void wpa_supplicant_update_config(struct wpa_supplicant *wpa_s)
 		wpa_sm_set_param(wpa_s->wpa, WPA_PARAM_FT_PREPEND_PMKID,
 				 wpa_s->conf->ft_prepend_pmkid);
 
+#ifdef CONFIG_TDLS
+	if (wpa_s->conf->changed_parameters & CFG_CHANGED_TDLS_MONITOR)
+		wpa_tdls_set_monitor(wpa_s->wpa,
+				     wpa_s->conf->tdls_monitor_interval,
+				     wpa_s->conf->tdls_monitor_links);
+#endif /* CONFIG_TDLS */
+
 #ifdef CONFIG_BGSCAN
 	/*
 	 * We default to global bgscan parameters only when per-network bgscan
@@ -9495,14 +9899,25 @@ struct hostapd_hw_modes * get_mode_with_freq(struct hostapd_hw_modes *modes,
 }
 
 
+static unsigned int wpas_bss_tmp_disallowed_hash(const u8 *bssid)
+{
+	/* The last octets differ the most between BSSs of the same ESS */
+	return (bssid[4] ^ bssid[5]) & (WPA_BSS_TMP_DISALLOWED_HASH_SIZE - 1);
+}
+
+
 static struct
 wpa_bss_tmp_disallowed * wpas_get_disallowed_bss(struct wpa_supplicant *wpa_s,
 						 const u8 *bssid)
 {
 	struct wpa_bss_tmp_disallowed *bss;
 
-	dl_list_for_each(bss, &wpa_s->bss_tmp_disallowed,
-			 struct wpa_bss_tmp_disallowed, list) {
+	if (dl_list_empty(&wpa_s->bss_tmp_disallowed))
+		return NULL;
+
+	dl_list_for_each(bss, &wpa_s->bss_tmp_disallowed_hash[
+				 wpas_bss_tmp_disallowed_hash(bssid)],
+			 struct wpa_bss_tmp_disallowed, hash) {
 		if (ether_addr_equal(bssid, bss->bssid))
 			return bss;
 	}
@@ -9570,6 +9985,8 @@ void wpa_bss_tmp_disallow(struct wpa_supplicant *wpa_s, const u8 *bssid,
 
 	os_memcpy(bss->bssid, bssid, ETH_ALEN);
 	dl_list_add(&wpa_s->bss_tmp_disallowed, &bss->list);
+	dl_list_add(&wpa_s->bss_tmp_disallowed_hash[
+			    wpas_bss_tmp_disallowed_hash(bssid)], &bss->hash);
 	wpa_set_driver_tmp_disallow_list(wpa_s);
 
 finish:
@@ -9582,15 +9999,9 @@ finish:
 int wpa_is_bss_tmp_disallowed(struct wpa_supplicant *wpa_s,
 			      struct wpa_bss *bss)
 {
-	struct wpa_bss_tmp_disallowed *disallowed = NULL, *tmp, *prev;
+	struct wpa_bss_tmp_disallowed *disallowed;
 
-	dl_list_for_each_safe(tmp, prev, &wpa_s->bss_tmp_disallowed,
-			 struct wpa_bss_tmp_disallowed, list) {
-		if (ether_addr_equal(bss->bssid, tmp->bssid)) {
-			disallowed = tmp;
-			break;
-		}
-	}
+	disallowed = wpas_get_disallowed_bss(wpa_s, bss->bssid);
 	if (!disallowed)
 		return 0;
 
@@ -9668,6 +10079,49 @@ int wpas_disable_mac_addr_randomization(struct wpa_supplicant *wpa_s,
 }
 
 
+static bool wpas_signal_cache_get(struct wpa_supplicant *wpa_s,
+				  struct wpa_signal_info *si)
+{
+	struct os_reltime age;
+
+	if (!wpa_s->signal_cache_valid ||
+	    !ether_addr_equal(wpa_s->signal_cache_bssid, wpa_s->bssid))
+		return false;
+
+	os_reltime_age(&wpa_s->signal_cache_time, &age);
+	if (age.sec < 0 ||
+	    os_reltime_in_ms(&age) >= wpa_s->conf->signal_poll_cache_ms) {
+		wpa_s->signal_cache_valid = false;
+		return false;
+	}
+
+	os_memcpy(si, &wpa_s->signal_cache, sizeof(*si));
+	return true;
+}
+
+
+/**
+ * wpas_signal_cache_update - Refresh the signal poll cache from an event
+ * @wpa_s: Pointer to wpa_supplicant data
+ * @si: Signal information from a signal change event
+ *
+ * Signal change events include the same per-station values that a signal poll
+ * would return, but not the channel information, so only a cache entry that is
+ * still valid is refreshed.
+ */
+void wpas_signal_cache_update(struct wpa_supplicant *wpa_s,
+			      const struct wpa_signal_info *si)
+{
+	if (!wpa_s->signal_cache_valid ||
+	    !ether_addr_equal(wpa_s->signal_cache_bssid, wpa_s->bssid))
+		return;
+
+	wpa_s->signal_cache.data = si->data;
+	wpa_s->signal_cache.current_noise = si->current_noise;
+	os_get_reltime(&wpa_s->signal_cache_time);
+}
+
+
 int wpa_drv_signal_poll(struct wpa_supplicant *wpa_s,
 			struct wpa_signal_info *si)
 {
@@ -9676,7 +10130,19 @@ int wpa_drv_signal_poll(struct wpa_supplicant *wpa_s,
 	if (!wpa_s->driver->signal_poll)
 		return -1;
 
-	res = wpa_s->driver->signal_poll(wpa_s->drv_priv, si);
+	if (wpa_s->conf->signal_poll_cache_ms > 0 &&
+	    wpas_signal_cache_get(wpa_s, si)) {
+		res = 0;
+	} else {
+		res = wpa_s->driver->signal_poll(wpa_s->drv_priv, si);
+		if (res == 0 && wpa_s->conf->signal_poll_cache_ms > 0) {
+			os_memcpy(&wpa_s->signal_cache, si, sizeof(*si));
+			os_get_reltime(&wpa_s->signal_cache_time);
+			os_memcpy(wpa_s->signal_cache_bssid, wpa_s->bssid,
+				  ETH_ALEN);
+			wpa_s->signal_cache_valid = true;
+		}
+	}
 
 #ifdef CONFIG_TESTING_OPTIONS
 	if (res == 0) {
@@ -26,6 +26,7 @@
 #include "wps/wps_defs.h"
 #include "config_ssid.h"
 #include "wmm_ac.h"
+#include "connect_trace.h"
 #include <netinet/in.h>
 #include <netinet/in6.h>
 #include "pasn/pasn_common.h"
@@ -219,6 +220,11 @@ struct wpa_params {
 	 */
 	int wpa_debug_tracing;
 
+	/**
+	 * wpa_debug_ring_path - Debug ring buffer dump file or %NULL
+	 */
+	const char *wpa_debug_ring_path;
+
 	/**
 	 * override_driver - Optional driver parameter override
 	 *
@@ -280,16 +286,27 @@ struct wpa_params {
 
 struct p2p_srv_bonjour {
 	struct dl_list list;
+	struct dl_list hash; /* wpa_global::p2p_srv_bonjour_hash[] */
 	struct wpabuf *query;
 	struct wpabuf *resp;
+	/* Uncompressed DNS name of the query or %NULL if not valid */
+	char *name;
+	/* Prebuilt Service Response TLV (Service Transaction ID 0) */
+	struct wpabuf *tlv;
 };
 
 struct p2p_srv_upnp {
 	struct dl_list list;
+	struct dl_list hash; /* wpa_global::p2p_srv_upnp_hash[] */
 	u8 version;
 	char *service;
+	/* Prebuilt Service Response TLV (Service Transaction ID 0) */
+	struct wpabuf *tlv;
 };
 
+#define P2P_SRV_HASH_SIZE 64
+#define WPA_IFACE_HASH_SIZE 32
+
 /**
  * struct wpa_global - Internal, global data for all %wpa_supplicant interfaces
  *
@@ -298,8 +315,10 @@ struct p2p_srv_upnp {
  */
 struct wpa_global {
 	struct wpa_supplicant *ifaces;
+	struct dl_list iface_hash[WPA_IFACE_HASH_SIZE]; /* by ifname */
 	struct wpa_params params;
 	struct ctrl_iface_global_priv *ctrl_iface;
+	struct wpas_ctrl_stats *ctrl_stats; /* per-command statistics */
 	struct wpas_dbus_priv *dbus;
 	struct wpas_aidl_priv *aidl;
 	struct wpas_vendor_aidl_priv *vendor_aidl;
@@ -314,6 +333,8 @@ struct wpa_global {
 	struct os_reltime p2p_go_wait_client;
 	struct dl_list p2p_srv_bonjour; /* struct p2p_srv_bonjour */
 	struct dl_list p2p_srv_upnp; /* struct p2p_srv_upnp */
+	struct dl_list p2p_srv_bonjour_hash[P2P_SRV_HASH_SIZE];
+	struct dl_list p2p_srv_upnp_hash[P2P_SRV_HASH_SIZE];
 	int p2p_disabled;
 	int cross_connection;
 	int p2p_long_listen; /* remaining time in long Listen state in ms */
@@ -338,9 +359,27 @@ struct wpa_global {
 #endif /* CONFIG_WIFI_DISPLAY */
 
 	struct psk_list_entry *add_psk; /* From group formation */
+
+#ifdef CONFIG_INTERWORKING
+	/* struct interworking_anqp_cache_entry; most recently used first */
+	struct dl_list anqp_cache;
+#endif /* CONFIG_INTERWORKING */
 };
 
 
+/* Maximum number of radio work classes with separate queue time statistics */
+#define RADIO_WORK_MAX_CLASSES 16
+
+/**
+ * struct wpa_radio_work_stats - Queue time statistics for a radio work class
+ */
+struct wpa_radio_work_stats {
+	unsigned int started; /* number of works started */
+	unsigned int preempted; /* number of started works preempted */
+	struct os_reltime total_wait; /* total time spent queued */
+	struct os_reltime max_wait; /* longest time spent queued */
+};
+
 /**
  * struct wpa_radio - Internal data for per-radio information
  *
@@ -356,6 +395,8 @@ struct wpa_radio {
 	unsigned int num_active_works;
 	struct dl_list ifaces; /* struct wpa_supplicant::radio_list entries */
 	struct dl_list work; /* struct wpa_radio_work::list entries */
+	struct wpa_radio_work_stats stats[RADIO_WORK_MAX_CLASSES];
+	unsigned int merged_scans; /* scan requests merged (scan_merge) */
 };
 
 /**
@@ -382,8 +423,10 @@ struct wpa_radio_work {
 	void (*cb)(struct wpa_radio_work *work, int deinit);
 	void *ctx;
 	unsigned int started:1;
+	unsigned int next:1; /* forced as the next work to be executed */
 	struct os_reltime time;
 	unsigned int bands;
+	unsigned int cls; /* index to the radio work class table */
 };
 
 int radio_add_work(struct wpa_supplicant *wpa_s, unsigned int freq,
@@ -391,6 +434,7 @@ int radio_add_work(struct wpa_supplicant *wpa_s, unsigned int freq,
 		   void (*cb)(struct wpa_radio_work *work, int deinit),
 		   void *ctx);
 void radio_work_done(struct wpa_radio_work *work);
+int radio_work_stats(struct wpa_radio *radio, char *buf, size_t buflen);
 void radio_remove_works(struct wpa_supplicant *wpa_s,
 			const char *type, int remove_all);
 void radio_remove_pending_work(struct wpa_supplicant *wpa_s, void *ctx);
@@ -475,6 +519,9 @@ struct rrm_data {
 	/* next_neighbor_rep_token - Next request's dialog token */
 	u8 next_neighbor_rep_token;
 
+	/* neighbor_freqs - Channels of the latest neighbor report */
+	int *neighbor_freqs;
+
 	/* token - Dialog token of the current radio measurement */
 	u8 token;
 
@@ -498,6 +545,8 @@ struct icon_entry {
 
 struct wpa_bss_tmp_disallowed {
 	struct dl_list list;
+	/* List entry for struct wpa_supplicant::bss_tmp_disallowed_hash[] */
+	struct dl_list hash;
 	u8 bssid[ETH_ALEN];
 	int rssi_threshold;
 };
@@ -676,10 +725,20 @@ enum scs_response_status {
 
 struct active_scs_elem {
 	struct dl_list list;
+	struct active_scs_elem *hnext;
 	u8 scs_id;
 	enum scs_response_status status;
+	/* Request sent and waiting for a response */
+	bool pending;
+	enum scs_request_type pending_type;
+	struct os_reltime sent;
+	/* Time from the request to the response for the latest request */
+	unsigned int setup_usec;
 };
 
+#define ACTIVE_SCS_HASH_SIZE 16
+#define ACTIVE_SCS_HASH(id) ((id) & (ACTIVE_SCS_HASH_SIZE - 1))
+
 struct dscp_policy_data {
 	u8 policy_id;
 	u8 req_type;
@@ -718,10 +777,12 @@ struct wpa_supplicant {
 	struct wpa_supplicant *parent;
 	struct wpa_supplicant *p2pdev;
 	struct wpa_supplicant *next;
+	struct dl_list iface_hash; /* wpa_global::iface_hash[] */
 	struct l2_packet_data *l2;
 	struct l2_packet_data *l2_br;
 	struct os_reltime roam_start;
 	struct os_reltime roam_time;
+	struct wpas_connect_trace connect_trace;
 	struct os_reltime session_start;
 	struct os_reltime session_length;
 	unsigned char own_addr[ETH_ALEN];
@@ -827,6 +888,15 @@ struct wpa_supplicant {
 	void (*scan_res_fail_handler)(struct wpa_supplicant *wpa_s);
 	struct dl_list bss; /* struct wpa_bss::list */
 	struct dl_list bss_id; /* struct wpa_bss::list_id */
+	/*
+	 * BSSID and SSID indexes of the BSS table. Each bucket keeps its
+	 * entries in the same relative order as struct wpa_supplicant::bss.
+	 */
+#define WPA_BSS_HASH_SIZE 256
+	struct dl_list bss_hash_bssid[WPA_BSS_HASH_SIZE]; /* hash_bssid */
+	struct dl_list bss_hash_ssid[WPA_BSS_HASH_SIZE]; /* hash_ssid */
+	/* Shared IE buffers of the BSS table by CRC32 */
+	struct dl_list bss_ies_hash[WPA_BSS_HASH_SIZE]; /* struct wpa_bss_ies */
 	size_t num_bss;
 	unsigned int bss_update_idx;
 	unsigned int bss_next_id;
@@ -850,6 +920,7 @@ struct wpa_supplicant {
 	struct eapol_sm *eapol;
 
 	struct ctrl_iface_priv *ctrl_iface;
+	struct wpas_ctrl_stats *ctrl_stats; /* per-command statistics */
 
 	enum wpa_states wpa_state;
 	struct wpa_radio_work *scan_work;
@@ -874,6 +945,16 @@ struct wpa_supplicant {
 				    * known not to be configured with a key */
 
 	struct wpa_bssid_ignore *bssid_ignore;
+#define WPA_BSSID_IGNORE_HASH_SIZE 64
+	struct wpa_bssid_ignore *bssid_ignore_hash[WPA_BSSID_IGNORE_HASH_SIZE];
+	/* Earliest time at which an ignore list entry might need purging */
+	struct os_reltime bssid_ignore_next_purge;
+	unsigned int bssid_ignore_num;
+	unsigned int bssid_ignore_peak;
+	unsigned int bssid_ignore_lookups;
+	unsigned int bssid_ignore_hits;
+	unsigned int bssid_ignore_added;
+	unsigned int bssid_ignore_expired;
 
 	/* Number of connection failures since last successful connection */
 	unsigned int consecutive_conn_failures;
@@ -914,6 +995,19 @@ struct wpa_supplicant {
 	struct os_reltime scan_min_time;
 	int scan_runs; /* number of scan runs since WPS was started */
 	int *next_scan_freqs;
+	/* Roaming scans while connected (roam_scan_max_freqs) */
+	u8 roam_scan_bssid[ETH_ALEN]; /* BSS of the latest roaming scan */
+	unsigned int roam_scan_partial_count; /* partial scans on this BSS */
+#define ROAM_SCAN_NONE 0
+#define ROAM_SCAN_PARTIAL 1
+#define ROAM_SCAN_FULL 2
+#define ROAM_SCAN_TYPES 3
+	int roam_scan_pending; /* ROAM_SCAN_* type of the scan in progress */
+	unsigned int roam_scans[ROAM_SCAN_TYPES];
+	u64 roam_scan_time_us[ROAM_SCAN_TYPES];
+	/* Connections started from earlier scan results (fast associate) */
+	unsigned int fast_assoc_scans_skipped;
+	unsigned int fast_assoc_cached; /* within scan_res_stale_budget */
 	int *select_network_scan_freqs;
 	int *manual_scan_freqs;
 	int *manual_sched_scan_freqs;
@@ -1073,6 +1167,12 @@ struct wpa_supplicant {
 		u8 ext_auth_ap_mld_addr[ETH_ALEN];
 		bool ext_ml_auth;
 		int *sae_rejected_groups;
+		/* Speculatively derived commits (sae_precompute_commit) */
+		struct sme_sae_precomp *sae_precomp;
+		unsigned int sae_precomp_num; /* number of entries in use */
+		unsigned int sae_precomp_max; /* number of allocated entries */
+		/* next index in last_scan_res to consider as a candidate */
+		size_t sae_precomp_next;
 #endif /* CONFIG_SAE */
 		u16 assoc_auth_type;
 	} sme;
@@ -1095,6 +1195,9 @@ struct wpa_supplicant {
 	unsigned int mesh_he_enabled:1;
 	unsigned int mesh_eht_enabled:1;
 	struct wpa_driver_mesh_join_params *mesh_params;
+	/* Rate limit for starting SAE with new peers (mesh_auth_rate) */
+	struct os_reltime mesh_auth_window;
+	unsigned int mesh_auth_started;
 #ifdef CONFIG_PMKSA_CACHE_EXTERNAL
 	/* struct external_pmksa_cache::list */
 	struct dl_list mesh_external_pmksa_cache;
@@ -1119,6 +1222,9 @@ struct wpa_supplicant {
 	unsigned int roc_waiting_drv_freq;
 	int action_tx_wait_time;
 	int action_tx_wait_time_used;
+	/* Frames of other users waiting for pending_action_tx to complete;
+	 * struct offchannel_tx::list */
+	struct dl_list pending_action_queue;
 
 	int p2p_mgmt;
 
@@ -1236,6 +1342,9 @@ struct wpa_supplicant {
 	unsigned int p2p_go_max_oper_chwidth;
 	unsigned int p2p_go_vht_center_freq2;
 	int p2p_lo_started;
+
+	/* Result of the last wpas_p2p_setup_channels() call or %NULL */
+	struct wpas_p2p_chan_cache *p2p_chan_cache;
 #endif /* CONFIG_P2P */
 
 	struct wpa_ssid *bgscan_ssid;
@@ -1285,6 +1394,19 @@ struct wpa_supplicant {
 	struct os_reltime osu_icon_fetch_start;
 	unsigned int num_osu_scans;
 	unsigned int num_prov_found;
+	unsigned int interworking_anqp_pending; /* outstanding ANQP queries */
+	int interworking_anqp_freq; /* channel of the latest ANQP query */
+	struct {
+		struct os_reltime start;
+		unsigned int queries; /* queries sent in the ongoing fetch */
+		unsigned int cached; /* cached responses used in it */
+		unsigned int rounds; /* completed fetches */
+		unsigned int last_ms;
+		unsigned int max_ms;
+		u64 total_ms;
+		unsigned int last_queries;
+		unsigned int last_cached;
+	} anqp_fetch_stats;
 #endif /* CONFIG_INTERWORKING */
 	unsigned int drv_capa_known;
 
@@ -1318,6 +1440,14 @@ struct wpa_supplicant {
 
 	struct ext_password_data *ext_pw;
 
+#ifdef CONFIG_PMKSA_STORE
+	struct pmksa_store *pmksa_store;
+#endif /* CONFIG_PMKSA_STORE */
+
+#ifdef CONFIG_STATUS_SHM
+	struct status_shm *status_shm;
+#endif /* CONFIG_STATUS_SHM */
+
 	struct wpabuf *last_gas_resp, *prev_gas_resp;
 	u8 last_gas_addr[ETH_ALEN], prev_gas_addr[ETH_ALEN];
 	u8 last_gas_dialog_token, prev_gas_dialog_token;
@@ -1359,6 +1489,7 @@ struct wpa_supplicant {
 	struct neighbor_report *wnm_neighbor_report_elements;
 	struct os_reltime wnm_cand_valid_until;
 	struct wpa_bss *wnm_target_bss;
+	u8 wnm_ft_ds_target[ETH_ALEN];
 	enum bss_trans_mgmt_status_code bss_tm_status;
 	bool bss_trans_mgmt_in_progress;
 	u8 coloc_intf_dialog_token;
@@ -1420,6 +1551,7 @@ struct wpa_supplicant {
 	unsigned int oci_freq_override_wnm_sleep;
 	unsigned int disable_eapol_g2_tx;
 	int test_assoc_comeback_type;
+	struct wpas_twt_mgr *twt_mgr;
 #endif /* CONFIG_TESTING_OPTIONS */
 
 	struct wmm_ac_assoc_data *wmm_ac_assoc_info;
@@ -1428,6 +1560,7 @@ struct wpa_supplicant {
 	u8 wmm_ac_last_dialog_token;
 	struct wmm_tspec_element *last_tspecs;
 	u8 last_tspecs_count;
+	struct wmm_ac_readmit wmm_ac_readmit;
 
 	struct rrm_data rrm;
 	struct beacon_rep_data beacon_rep_data;
@@ -1463,6 +1596,8 @@ struct wpa_supplicant {
 	 * the bss_temp_disallowed list for other purposes as well.
 	 */
 	struct dl_list bss_tmp_disallowed;
+#define WPA_BSS_TMP_DISALLOWED_HASH_SIZE 16
+	struct dl_list bss_tmp_disallowed_hash[WPA_BSS_TMP_DISALLOWED_HASH_SIZE];
 
 	/*
 	 * Content of a measurement report element with type 8 (LCI),
@@ -1616,6 +1751,7 @@ struct wpa_supplicant {
 	struct scs_robust_av_data scs_robust_av_req;
 	u8 scs_dialog_token;
 	struct dl_list active_scs_ids;
+	struct active_scs_elem *active_scs_hash[ACTIVE_SCS_HASH_SIZE];
 	bool ongoing_scs_req;
 	u8 dscp_req_dialog_token;
 	u8 dscp_query_dialog_token;
@@ -1632,6 +1768,13 @@ struct wpa_supplicant {
 	bool supp_pbc_active; /* Set for interface when PBC is triggered */
 	bool wps_overlap;
 	bool scan_in_progress_6ghz; /* Set upon a 6 GHz scan being triggered */
+	bool scan_merged; /* pending scan merged into a sibling's scan */
+	/* 6 GHz-only scan stage; statistics indexed by scan_6ghz_targeted */
+	bool scan_6ghz_targeted; /* channels from RNR instead of PSC */
+	struct os_reltime scan_6ghz_start;
+	unsigned int scan_6ghz_stages[2];
+	unsigned int scan_6ghz_found[2];
+	u64 scan_6ghz_time_us[2];
 
 #ifdef CONFIG_PASN
 	struct pasn_data pasn;
@@ -1651,6 +1794,12 @@ struct wpa_supplicant {
 
 	struct wpa_signal_info last_signal_info;
 
+	/* Cached wpa_drv_signal_poll() result (signal_poll_cache_ms) */
+	struct wpa_signal_info signal_cache;
+	struct os_reltime signal_cache_time;
+	u8 signal_cache_bssid[ETH_ALEN];
+	bool signal_cache_valid;
+
 	struct wpa_ssid *ml_connect_probe_ssid;
 	struct wpa_bss *ml_connect_probe_bss;
 
@@ -1810,6 +1959,17 @@ int wpas_twt_send_setup(struct wpa_supplicant *wpa_s, u8 dtok, int exponent,
 			bool flow_type, u8 flow_id, bool protection,
 			u8 twt_channel, u8 control);
 int wpas_twt_send_teardown(struct wpa_supplicant *wpa_s, u8 flags);
+int wpas_twt_flow_add(struct wpa_supplicant *wpa_s, u8 id, u32 interval_usec,
+		      u32 duration_usec);
+int wpas_twt_flow_remove(struct wpa_supplicant *wpa_s, int id);
+int wpas_twt_flow_set_traffic(struct wpa_supplicant *wpa_s, unsigned int pps);
+int wpas_twt_flow_status(struct wpa_supplicant *wpa_s, char *buf,
+			 size_t buflen);
+void wpas_twt_mgr_connected(struct wpa_supplicant *wpa_s);
+void wpas_twt_mgr_disconnected(struct wpa_supplicant *wpa_s);
+void wpas_twt_mgr_deinit(struct wpa_supplicant *wpa_s);
+void wpas_twt_rx_action(struct wpa_supplicant *wpa_s, const u8 *sa,
+			const u8 *data, size_t len);
 
 void wpas_rrm_reset(struct wpa_supplicant *wpa_s);
 void wpas_rrm_process_neighbor_rep(struct wpa_supplicant *wpa_s,
@@ -1879,6 +2039,8 @@ int wpas_enable_mac_addr_randomization(struct wpa_supplicant *wpa_s,
 				       const u8 *mask);
 int wpas_disable_mac_addr_randomization(struct wpa_supplicant *wpa_s,
 					unsigned int type);
+void wpas_signal_cache_update(struct wpa_supplicant *wpa_s,
+			      const struct wpa_signal_info *si);
 
 /**
  * wpa_supplicant_ctrl_iface_ctrl_rsp_handle - Handle a control response
@@ -2050,6 +2212,8 @@ void wpas_handle_robust_av_scs_recv_action(struct wpa_supplicant *wpa_s,
 					   const u8 *src, const u8 *buf,
 					   size_t len);
 void wpas_scs_deinit(struct wpa_supplicant *wpa_s);
+struct active_scs_elem * wpas_scs_get_active(struct wpa_supplicant *wpa_s,
+					     u8 scs_id);
 void wpas_handle_qos_mgmt_recv_action(struct wpa_supplicant *wpa_s,
 				      const u8 *src,
 				      const u8 *buf, size_t len);
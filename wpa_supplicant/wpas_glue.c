@@ -29,6 +29,7 @@
 #include "scan.h"
 #include "notify.h"
 #include "wpas_kay.h"
+#include "pmksa_store.h"
 
 
 #ifndef CONFIG_NO_CONFIG_BLOBS
@@ -905,6 +906,15 @@ static int wpa_supplicant_tdls_disable_channel_switch(void *ctx, const u8 *addr)
 	return wpa_drv_tdls_disable_channel_switch(wpa_s, addr);
 }
 
+
+static int wpa_supplicant_tdls_read_sta_data(
+	void *ctx, const u8 *addr, struct hostap_sta_driver_data *data)
+{
+	struct wpa_supplicant *wpa_s = ctx;
+
+	return wpa_drv_read_sta_data(wpa_s, data, addr);
+}
+
 #endif /* CONFIG_TDLS */
 
 #endif /* CONFIG_NO_WPA */
@@ -1201,6 +1211,16 @@ static void wpa_supplicant_set_anon_id(void *ctx, const u8 *id, size_t len)
 	}
 }
 
+
+static void wpa_supplicant_erp_key_update(void *ctx, const char *keyname_nai,
+					  const u8 *rrk, size_t rrk_len,
+					  u32 next_seq)
+{
+	struct wpa_supplicant *wpa_s = ctx;
+
+	pmksa_store_erp_update(wpa_s, keyname_nai, rrk, rrk_len, next_seq);
+}
+
 static void wpa_supplicant_eap_method_selected_cb(void *ctx,
 						const char* reason_string)
 {
@@ -1286,6 +1306,7 @@ int wpa_supplicant_init_eapol(struct wpa_supplicant *wpa_s)
 	ctx->eap_error_cb = wpa_supplicant_eap_error_cb;
 	ctx->confirm_auth_cb = wpa_supplicant_eap_auth_start_cb;
 	ctx->set_anon_id = wpa_supplicant_set_anon_id;
+	ctx->erp_key_update = wpa_supplicant_erp_key_update;
 	ctx->eap_method_selected_cb = wpa_supplicant_eap_method_selected_cb;
 	ctx->open_ssl_failure_cb = wpa_supplicant_open_ssl_failure_cb;
 	ctx->get_certificate_cb = wpa_supplicant_get_certificate_cb;
@@ -1498,6 +1519,17 @@ wpa_supplicant_notify_pmksa_cache_entry(void *_wpa_s,
 	struct wpa_supplicant *wpa_s = _wpa_s;
 
 	wpas_notify_pmk_cache_added(wpa_s, entry);
+	pmksa_store_entry_added(wpa_s, entry);
+}
+
+
+static void
+wpa_supplicant_notify_pmksa_cache_entry_removed(
+	void *_wpa_s, struct rsn_pmksa_cache_entry *entry)
+{
+	struct wpa_supplicant *wpa_s = _wpa_s;
+
+	pmksa_store_entry_removed(wpa_s, entry);
 }
 
 
@@ -1565,6 +1597,7 @@ int wpa_supplicant_init_wpa(struct wpa_supplicant *wpa_s)
 		wpa_supplicant_tdls_enable_channel_switch;
 	ctx->tdls_disable_channel_switch =
 		wpa_supplicant_tdls_disable_channel_switch;
+	ctx->tdls_read_sta_data = wpa_supplicant_tdls_read_sta_data;
 #endif /* CONFIG_TDLS */
 	ctx->set_rekey_offload = wpa_supplicant_set_rekey_offload;
 	ctx->key_mgmt_set_pmk = wpa_supplicant_key_mgmt_set_pmk;
@@ -1576,6 +1609,8 @@ int wpa_supplicant_init_wpa(struct wpa_supplicant *wpa_s)
 	ctx->set_ltf_keyseed = wpa_supplicant_set_ltf_keyseed;
 #endif /* CONFIG_PASN */
 	ctx->notify_pmksa_cache_entry = wpa_supplicant_notify_pmksa_cache_entry;
+	ctx->notify_pmksa_cache_entry_removed =
+		wpa_supplicant_notify_pmksa_cache_entry_removed;
 	ctx->ssid_verified = wpa_supplicant_ssid_verified;
 
 	wpa_s->wpa = wpa_sm_init(ctx);
@@ -10,15 +10,20 @@
 
 #include "utils/common.h"
 #include "utils/module_tests.h"
+#include "drivers/driver.h"
 #include "wpa_supplicant_i.h"
+#include "config.h"
 #include "bssid_ignore.h"
+#include "bss.h"
+#include "offchannel.h"
 
 
 static int wpas_bssid_ignore_module_tests(void)
 {
 	struct wpa_supplicant wpa_s;
 	struct wpa_global global;
-	int ret = -1;
+	u8 addr[ETH_ALEN];
+	int i, ret = -1;
 
 	os_memset(&wpa_s, 0, sizeof(wpa_s));
 	os_memset(&global, 0, sizeof(global));
@@ -79,6 +84,30 @@ static int wpas_bssid_ignore_module_tests(void)
 	if (!wpa_bssid_ignore_is_listed(&wpa_s, (u8 *) "111111"))
 		goto fail;
 
+	/* Enough entries to share hash buckets */
+	os_memcpy(addr, "\x02\x00\x00\x00\x00\x00", ETH_ALEN);
+	for (i = 0; i < 300; i++) {
+		addr[4] = i >> 8;
+		addr[5] = i & 0xff;
+		if (wpa_bssid_ignore_add(&wpa_s, addr) != 1)
+			goto fail;
+	}
+	for (i = 0; i < 300; i += 2) {
+		addr[4] = i >> 8;
+		addr[5] = i & 0xff;
+		if (wpa_bssid_ignore_del(&wpa_s, addr) < 0)
+			goto fail;
+	}
+	for (i = 0; i < 300; i++) {
+		addr[4] = i >> 8;
+		addr[5] = i & 0xff;
+		if ((wpa_bssid_ignore_get(&wpa_s, addr) == NULL) != !(i & 1))
+			goto fail;
+	}
+	if (wpa_s.bssid_ignore_num != 150 + 4 ||
+	    !wpa_bssid_ignore_is_listed(&wpa_s, (u8 *) "222222"))
+		goto fail;
+
 	ret = 0;
 fail:
 	wpa_bssid_ignore_clear(&wpa_s);
@@ -90,6 +119,557 @@ fail:
 }
 
 
+static int wpas_scan_res_arena_module_tests(void)
+{
+	struct wpa_scan_results *res;
+	struct wpa_scan_res *r, *ext;
+	size_t i;
+	int ret = -1;
+
+	res = os_zalloc(sizeof(*res));
+	if (!res)
+		return -1;
+
+	/* Enough entries to spill over into multiple arena blocks, including
+	 * one that is larger than the default block size */
+	for (i = 0; i < 300; i++) {
+		size_t ie_len = i == 150 ? 70000 : 3 + i % 200;
+
+		r = wpa_scan_res_alloc(res, ie_len);
+		if (!r || ((uintptr_t) r & 7))
+			goto fail;
+		if (r->ie_len || r->freq)
+			goto fail;
+		r->ie_len = ie_len;
+		r->freq = 2412 + i;
+		os_memset(r + 1, i & 0xff, ie_len);
+		if (res->num % 32 == 0) {
+			struct wpa_scan_res **tmp;
+
+			tmp = os_realloc_array(res->res, res->num + 32,
+					       sizeof(*tmp));
+			if (!tmp)
+				goto fail;
+			res->res = tmp;
+		}
+		res->res[res->num++] = r;
+	}
+
+	for (i = 0; i < res->num; i++) {
+		r = res->res[i];
+		if (r->freq != (int) (2412 + i) ||
+		    ((u8 *) (r + 1))[r->ie_len - 1] != (i & 0xff))
+			goto fail;
+	}
+
+	/* Entries from os_malloc() can be mixed with arena entries */
+	ext = os_zalloc(sizeof(*ext));
+	if (!ext)
+		goto fail;
+	res->res[0] = ext;
+	wpa_scan_res_free(res, res->res[1]);
+	res->res[1] = res->res[--res->num];
+
+	ret = 0;
+fail:
+	wpa_scan_results_free(res);
+
+	if (ret)
+		wpa_printf(MSG_ERROR, "scan result arena module test failure");
+
+	return ret;
+}
+
+
+static int wpas_config_field_module_tests(void)
+{
+	struct wpa_config *config;
+	struct wpa_ssid *ssid;
+	char buf[20], *val;
+	int ret = -1;
+
+	config = wpa_config_alloc_empty(NULL, NULL);
+	if (!config)
+		return -1;
+	ssid = wpa_config_add_network(config);
+	if (!ssid)
+		goto fail;
+
+	if (wpa_config_set(ssid, "ssid", "\"test\"", 0) < 0 ||
+	    wpa_config_set(ssid, "priority", "5", 0) < 0 ||
+	    wpa_config_set(ssid, "zzz_unknown", "1", 0) == 0 ||
+	    wpa_config_set(ssid, "ssi", "1", 0) == 0 ||
+	    wpa_config_set(ssid, "ssidx", "1", 0) == 0 ||
+	    ssid->priority != 5 || ssid->ssid_len != 4)
+		goto fail;
+
+	val = wpa_config_get(ssid, "ssid");
+	if (!val || os_strcmp(val, "\"test\"") != 0) {
+		os_free(val);
+		goto fail;
+	}
+	os_free(val);
+
+	os_strlcpy(buf, "ap_scan=2", sizeof(buf));
+	if (wpa_config_process_global(config, buf, 0) < 0 ||
+	    config->ap_scan != 2)
+		goto fail;
+	os_strlcpy(buf, "ap_sca=1", sizeof(buf));
+	if (wpa_config_process_global(config, buf, -1) == 0)
+		goto fail;
+	os_strlcpy(buf, "ap_scan", sizeof(buf));
+	if (wpa_config_process_global(config, buf, -1) == 0)
+		goto fail;
+
+	ret = 0;
+fail:
+	wpa_config_free(config);
+
+	if (ret)
+		wpa_printf(MSG_ERROR, "config field module test failure");
+
+	return ret;
+}
+
+
+static int wpas_bss_tmp_disallow_module_tests(void)
+{
+	struct wpa_supplicant wpa_s;
+	struct wpa_driver_ops ops;
+	struct wpa_bss bss;
+	unsigned int i;
+	int ret = -1;
+
+	wpa_printf(MSG_INFO, "bss_tmp_disallow module tests");
+
+	os_memset(&wpa_s, 0, sizeof(wpa_s));
+	os_memset(&ops, 0, sizeof(ops));
+	os_memset(&bss, 0, sizeof(bss));
+	wpa_s.driver = &ops;
+	dl_list_init(&wpa_s.bss_tmp_disallowed);
+	for (i = 0; i < WPA_BSS_TMP_DISALLOWED_HASH_SIZE; i++)
+		dl_list_init(&wpa_s.bss_tmp_disallowed_hash[i]);
+
+	/* Add entries that share a hash bucket */
+	for (i = 0; i < 2 * WPA_BSS_TMP_DISALLOWED_HASH_SIZE; i++) {
+		u8 bssid[ETH_ALEN] = { 2, 0, 0, 0, i, i };
+
+		wpa_bss_tmp_disallow(&wpa_s, bssid, 10, i == 1 ? -60 : 0);
+	}
+	if (dl_list_len(&wpa_s.bss_tmp_disallowed) !=
+	    2 * WPA_BSS_TMP_DISALLOWED_HASH_SIZE)
+		goto fail;
+
+	bss.bssid[0] = 2;
+	bss.bssid[4] = 3;
+	bss.bssid[5] = 3;
+	bss.level = -50;
+	if (!wpa_is_bss_tmp_disallowed(&wpa_s, &bss))
+		goto fail;
+
+	/* Signal above the RSSI threshold removes the entry */
+	bss.bssid[4] = 1;
+	bss.bssid[5] = 1;
+	bss.level = -70;
+	if (!wpa_is_bss_tmp_disallowed(&wpa_s, &bss))
+		goto fail;
+	bss.level = -50;
+	if (wpa_is_bss_tmp_disallowed(&wpa_s, &bss) ||
+	    dl_list_len(&wpa_s.bss_tmp_disallowed) !=
+	    2 * WPA_BSS_TMP_DISALLOWED_HASH_SIZE - 1)
+		goto fail;
+
+	bss.bssid[4] = 1;
+	bss.bssid[5] = 0;
+	if (wpa_is_bss_tmp_disallowed(&wpa_s, &bss))
+		goto fail;
+
+	ret = 0;
+fail:
+	free_bss_tmp_disallowed(&wpa_s);
+	if (ret)
+		wpa_printf(MSG_ERROR, "bss_tmp_disallow module test failure");
+
+	return ret;
+}
+
+
+/* Saved networks for the scan result benchmark; only the last one matches a
+ * BSS so that the selection needs to go through all of them */
+#define SCAN_BENCH_NETWORKS 20
+#define SCAN_BENCH_ROUNDS 3
+
+struct scan_bench_phase {
+	const char *name;
+	u64 usec;
+	unsigned long allocs;
+};
+
+static void scan_bench_phase_start(struct os_reltime *start,
+				   unsigned long *allocs)
+{
+#ifdef WPA_TRACE
+	*allocs = os_alloc_count();
+#else /* WPA_TRACE */
+	*allocs = 0;
+#endif /* WPA_TRACE */
+	os_get_reltime(start);
+}
+
+
+static void scan_bench_phase_end(struct scan_bench_phase *phase,
+				 struct os_reltime *start,
+				 unsigned long allocs)
+{
+	struct os_reltime now, diff;
+
+	os_get_reltime(&now);
+	os_reltime_sub(&now, start, &diff);
+	phase->usec += diff.sec * 1000000 + diff.usec;
+#ifdef WPA_TRACE
+	phase->allocs += os_alloc_count() - allocs;
+#endif /* WPA_TRACE */
+}
+
+
+static struct wpa_scan_results * scan_bench_results(unsigned int num)
+{
+	static const u8 ies[] = {
+		WLAN_EID_SUPP_RATES, 8, 0x82, 0x84, 0x8b, 0x96, 0x0c, 0x12,
+		0x18, 0x24,
+		WLAN_EID_DS_PARAMS, 1, 6,
+		WLAN_EID_RSN, 20, 0x01, 0x00, 0x00, 0x0f, 0xac, 0x04, 0x01,
+		0x00, 0x00, 0x0f, 0xac, 0x04, 0x01, 0x00, 0x00, 0x0f, 0xac,
+		0x02, 0x00, 0x00,
+		WLAN_EID_HT_CAP, 26, 0xef, 0x01, 0x1b, 0xff, 0xff, 0x00, 0x00,
+		0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+		0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+		WLAN_EID_HT_OPERATION, 22, 6, 0x05, 0x00, 0x00, 0x00, 0x00,
+		0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+		0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+		WLAN_EID_EXT_CAPAB, 8, 0x04, 0x00, 0x08, 0x00, 0x00, 0x00,
+		0x00, 0x40,
+		WLAN_EID_VENDOR_SPECIFIC, 24, 0x00, 0x50, 0xf2, 0x02, 0x01,
+		0x01, 0x80, 0x00, 0x03, 0xa4, 0x00, 0x00, 0x27, 0xa4, 0x00,
+		0x00, 0x42, 0x43, 0x5e, 0x00, 0x62, 0x32, 0x2f, 0x00,
+	};
+	struct wpa_scan_results *res;
+	struct wpa_scan_res *r;
+	unsigned int i;
+	char ssid[20];
+	u8 *pos;
+
+	res = os_zalloc(sizeof(*res));
+	if (!res)
+		return NULL;
+	res->res = os_calloc(num, sizeof(*res->res));
+	if (!res->res) {
+		os_free(res);
+		return NULL;
+	}
+	os_get_reltime(&res->fetch_time);
+
+	for (i = 0; i < num; i++) {
+		/* Groups of ten BSSes share an SSID */
+		r = wpa_scan_res_alloc(res, 2 + 12 + sizeof(ies));
+		if (!r) {
+			wpa_scan_results_free(res);
+			return NULL;
+		}
+		r->ie_len = 2 + 12 + sizeof(ies);
+		r->bssid[0] = 0x02;
+		WPA_PUT_BE32(&r->bssid[2], i + 1);
+		r->freq = i % 3 == 0 ? 2437 : 5180 + 20 * (i % 8);
+		r->level = -40 - i % 50;
+		r->noise = -95;
+		r->beacon_int = 100;
+		r->caps = WLAN_CAPABILITY_ESS | WLAN_CAPABILITY_PRIVACY;
+		r->flags = WPA_SCAN_LEVEL_DBM | WPA_SCAN_NOISE_INVALID;
+		pos = (u8 *) (r + 1);
+		*pos++ = WLAN_EID_SSID;
+		*pos++ = 12;
+		os_snprintf(ssid, sizeof(ssid), "bench-%06u",
+			    i == num - 1 ? 999999 : i / 10);
+		os_memcpy(pos, ssid, 12);
+		pos += 12;
+		os_memcpy(pos, ies, sizeof(ies));
+		res->res[res->num++] = r;
+	}
+
+	return res;
+}
+
+
+static int wpas_scan_bench(unsigned int num)
+{
+	struct wpa_supplicant wpa_s;
+	struct wpa_global global;
+	struct wpa_driver_ops ops;
+	struct wpa_radio radio;
+	struct wpa_scan_results *res;
+	struct wpa_ssid *ssid, *selected_ssid;
+	struct wpa_bss *selected;
+	struct scan_bench_phase add[3], update[3];
+	struct scan_bench_phase *phase;
+	struct os_reltime start;
+	unsigned long allocs;
+	unsigned int i, round;
+	char name[30];
+	int ret = -1;
+
+	os_memset(&wpa_s, 0, sizeof(wpa_s));
+	os_memset(&global, 0, sizeof(global));
+	os_memset(&ops, 0, sizeof(ops));
+	os_memset(&radio, 0, sizeof(radio));
+	os_memset(add, 0, sizeof(add));
+	os_memset(update, 0, sizeof(update));
+	wpa_s.global = &global;
+	wpa_s.driver = &ops;
+	dl_list_init(&radio.work);
+	wpa_s.radio = &radio;
+	wpa_s.drv_enc = WPA_DRIVER_CAPA_ENC_CCMP;
+	wpa_s.conf = wpa_config_alloc_empty(NULL, NULL);
+	res = scan_bench_results(num);
+	if (!wpa_s.conf || !res)
+		goto fail;
+	wpa_s.conf->bss_max_count = num;
+	wpa_bss_init(&wpa_s);
+	dl_list_init(&wpa_s.bss_tmp_disallowed);
+	for (i = 0; i < WPA_BSS_TMP_DISALLOWED_HASH_SIZE; i++)
+		dl_list_init(&wpa_s.bss_tmp_disallowed_hash[i]);
+
+	for (i = 0; i < SCAN_BENCH_NETWORKS; i++) {
+		ssid = wpa_config_add_network(wpa_s.conf);
+		if (!ssid)
+			goto fail;
+		wpa_config_set_network_defaults(ssid);
+		os_snprintf(name, sizeof(name), "\"bench-%06u\"",
+			    i == SCAN_BENCH_NETWORKS - 1 ? 999999 :
+			    900000 + i);
+		if (wpa_config_set(ssid, "ssid", name, 0) < 0 ||
+		    wpa_config_set(ssid, "key_mgmt", "WPA-PSK", 0) < 0 ||
+		    wpa_config_set(ssid, "psk",
+				   "0123456789abcdef0123456789abcdef"
+				   "0123456789abcdef0123456789abcdef", 0) < 0)
+			goto fail;
+		ssid->disabled = 0;
+	}
+	wpa_config_update_prio_list(wpa_s.conf);
+
+	for (round = 0; round < SCAN_BENCH_ROUNDS; round++) {
+		phase = round ? update : add;
+
+		phase[0].name = "update_scan_res";
+		scan_bench_phase_start(&start, &allocs);
+		wpa_bss_update_start(&wpa_s);
+		for (i = 0; i < res->num; i++)
+			wpa_bss_update_scan_res(&wpa_s, res->res[i],
+						&res->fetch_time);
+		scan_bench_phase_end(&phase[0], &start, allocs);
+
+		phase[1].name = "update_end";
+		scan_bench_phase_start(&start, &allocs);
+		wpa_bss_update_end(&wpa_s, NULL, 1);
+		scan_bench_phase_end(&phase[1], &start, allocs);
+
+		phase[2].name = "pick_network";
+		scan_bench_phase_start(&start, &allocs);
+		selected_ssid = NULL;
+		selected = wpa_supplicant_pick_network(&wpa_s, &selected_ssid);
+		scan_bench_phase_end(&phase[2], &start, allocs);
+
+		if (wpa_s.num_bss != num || !selected || !selected_ssid ||
+		    selected_ssid->id != SCAN_BENCH_NETWORKS - 1 ||
+		    WPA_GET_BE32(&selected->bssid[2]) != num) {
+			wpa_printf(MSG_ERROR,
+				   "scan result benchmark: unexpected result (num_bss=%u selected=%p)",
+				   (unsigned int) wpa_s.num_bss, selected);
+			goto fail;
+		}
+	}
+
+	/* Entries missing from bss_expiration_scan_count scans expire */
+	for (round = 0; round < wpa_s.conf->bss_expiration_scan_count;
+	     round++) {
+		wpa_bss_update_start(&wpa_s);
+		for (i = 0; i < res->num / 2; i++)
+			wpa_bss_update_scan_res(&wpa_s, res->res[i],
+						&res->fetch_time);
+		wpa_bss_update_end(&wpa_s, NULL, 1);
+	}
+	if (wpa_s.num_bss != num / 2 ||
+	    !wpa_bss_get_bssid(&wpa_s, res->res[0]->bssid) ||
+	    !wpa_bss_get_bssid(&wpa_s, res->res[num / 2 - 1]->bssid) ||
+	    wpa_bss_get_bssid(&wpa_s, res->res[num / 2]->bssid)) {
+		wpa_printf(MSG_ERROR,
+			   "scan result benchmark: unexpected expiration (num_bss=%u)",
+			   (unsigned int) wpa_s.num_bss);
+		goto fail;
+	}
+
+	for (i = 0; i < 3; i++) {
+		wpa_printf(MSG_INFO,
+			   "benchmark scan results %u BSSes %s: add %llu us, update %llu us"
+#ifdef WPA_TRACE
+			   " (allocs add %lu, update %lu)"
+#endif /* WPA_TRACE */
+			   , num, add[i].name,
+			   (unsigned long long) add[i].usec,
+			   (unsigned long long) update[i].usec /
+			   (SCAN_BENCH_ROUNDS - 1)
+#ifdef WPA_TRACE
+			   , add[i].allocs,
+			   update[i].allocs / (SCAN_BENCH_ROUNDS - 1)
+#endif /* WPA_TRACE */
+			);
+	}
+
+	ret = 0;
+fail:
+	wpa_bss_deinit(&wpa_s);
+	os_free(wpa_s.last_scan_res);
+	free_bss_tmp_disallowed(&wpa_s);
+	wpa_config_free(wpa_s.conf);
+	wpa_scan_results_free(res);
+	return ret;
+}
+
+
+static int wpas_scan_benchmarks(void)
+{
+	static const unsigned int sizes[] = { 100, 500, 2000 };
+	unsigned int i;
+
+	wpa_printf(MSG_INFO, "scan result benchmarks");
+
+	for (i = 0; i < ARRAY_SIZE(sizes); i++) {
+		if (wpas_scan_bench(sizes[i]) < 0)
+			return -1;
+	}
+
+	return 0;
+}
+
+
+#ifdef CONFIG_OFFCHANNEL
+
+static unsigned int offchannel_test_tx;
+
+
+static int offchannel_test_send_action(void *priv, unsigned int freq,
+				       unsigned int wait, const u8 *dst,
+				       const u8 *src, const u8 *bssid,
+				       const u8 *data, size_t data_len,
+				       int no_cck)
+{
+	offchannel_test_tx++;
+	return 0;
+}
+
+
+static void offchannel_test_status_a(struct wpa_supplicant *wpa_s,
+				     unsigned int freq, const u8 *dst,
+				     const u8 *src, const u8 *bssid,
+				     const u8 *data, size_t data_len,
+				     enum offchannel_send_action_result result)
+{
+}
+
+
+static void offchannel_test_status_b(struct wpa_supplicant *wpa_s,
+				     unsigned int freq, const u8 *dst,
+				     const u8 *src, const u8 *bssid,
+				     const u8 *data, size_t data_len,
+				     enum offchannel_send_action_result result)
+{
+}
+
+
+static void offchannel_test_status_c(struct wpa_supplicant *wpa_s,
+				     unsigned int freq, const u8 *dst,
+				     const u8 *src, const u8 *bssid,
+				     const u8 *data, size_t data_len,
+				     enum offchannel_send_action_result result)
+{
+}
+
+
+static void offchannel_test_status_d(struct wpa_supplicant *wpa_s,
+				     unsigned int freq, const u8 *dst,
+				     const u8 *src, const u8 *bssid,
+				     const u8 *data, size_t data_len,
+				     enum offchannel_send_action_result result)
+{
+}
+
+
+static int wpas_offchannel_module_tests(void)
+{
+	struct wpa_supplicant wpa_s;
+	struct wpa_global global;
+	struct wpa_driver_ops ops;
+	const u8 addr[ETH_ALEN] = { 0x02, 0x00, 0x00, 0x00, 0x00, 0x01 };
+	const u8 peer[ETH_ALEN] = { 0x02, 0x00, 0x00, 0x00, 0x00, 0x02 };
+	const u8 p2p[] = { WLAN_ACTION_PUBLIC, WLAN_PA_VENDOR_SPECIFIC,
+			   0x50, 0x6f, 0x9a, 0x09, 0x00 };
+	const u8 dpp[] = { WLAN_ACTION_PUBLIC, WLAN_PA_VENDOR_SPECIFIC,
+			   0x50, 0x6f, 0x9a, 0x1a, 0x01 };
+	const u8 gas[] = { WLAN_ACTION_PUBLIC, WLAN_PA_GAS_INITIAL_REQ, 0x01 };
+	int ret = -1;
+
+	wpa_printf(MSG_INFO, "offchannel module tests");
+
+	os_memset(&wpa_s, 0, sizeof(wpa_s));
+	os_memset(&global, 0, sizeof(global));
+	os_memset(&ops, 0, sizeof(ops));
+	ops.send_action = offchannel_test_send_action;
+	wpa_s.global = &global;
+	wpa_s.driver = &ops;
+	wpa_s.drv_flags = WPA_DRIVER_FLAGS_OFFCHANNEL_TX;
+	os_memcpy(wpa_s.own_addr, addr, ETH_ALEN);
+	dl_list_init(&wpa_s.pending_action_queue);
+	offchannel_test_tx = 0;
+
+	/* Frames of other users wait for the pending frame; a later frame of
+	 * the same user, or of the same vendor protocol, replaces the earlier
+	 * one */
+	if (offchannel_send_action(&wpa_s, 2412, peer, addr, peer, p2p,
+				   sizeof(p2p), 0, offchannel_test_status_a,
+				   0) < 0 ||
+	    offchannel_send_action(&wpa_s, 2437, peer, addr, peer, gas,
+				   sizeof(gas), 0, offchannel_test_status_b,
+				   0) < 0 ||
+	    offchannel_send_action(&wpa_s, 2437, peer, addr, peer, gas,
+				   sizeof(gas), 0, offchannel_test_status_b,
+				   0) < 0 ||
+	    offchannel_test_tx != 1 ||
+	    dl_list_len(&wpa_s.pending_action_queue) != 1 ||
+	    offchannel_send_action(&wpa_s, 2412, peer, addr, peer, dpp,
+				   sizeof(dpp), 0, offchannel_test_status_c,
+				   0) < 0 ||
+	    offchannel_send_action(&wpa_s, 2412, peer, addr, peer, dpp,
+				   sizeof(dpp), 0, offchannel_test_status_d,
+				   0) < 0 ||
+	    dl_list_len(&wpa_s.pending_action_queue) != 2 ||
+	    offchannel_send_action(&wpa_s, 2412, peer, addr, peer, p2p,
+				   sizeof(p2p), 0, offchannel_test_status_a,
+				   0) < 0 ||
+	    offchannel_test_tx != 2 ||
+	    dl_list_len(&wpa_s.pending_action_queue) != 2)
+		goto fail;
+
+	ret = 0;
+fail:
+	offchannel_deinit(&wpa_s);
+	if (ret)
+		wpa_printf(MSG_ERROR, "offchannel module test failure");
+
+	return ret;
+}
+
+#endif /* CONFIG_OFFCHANNEL */
+
+
 int wpas_module_tests(void)
 {
 	int ret = 0;
@@ -99,6 +679,23 @@ int wpas_module_tests(void)
 	if (wpas_bssid_ignore_module_tests() < 0)
 		ret = -1;
 
+	if (wpas_scan_res_arena_module_tests() < 0)
+		ret = -1;
+
+	if (wpas_config_field_module_tests() < 0)
+		ret = -1;
+
+	if (wpas_bss_tmp_disallow_module_tests() < 0)
+		ret = -1;
+
+	if (wpas_scan_benchmarks() < 0)
+		ret = -1;
+
+#ifdef CONFIG_OFFCHANNEL
+	if (wpas_offchannel_module_tests() < 0)
+		ret = -1;
+#endif /* CONFIG_OFFCHANNEL */
+
 #ifdef CONFIG_WPS
 	if (wps_module_tests() < 0)
 		ret = -1;
@@ -0,0 +1,146 @@
+/*
+ * wpa_supplicant - Shared memory status page
+ *
+ * This software may be distributed under the terms of the BSD license.
+ * See README for more details.
+ */
+
+#include "includes.h"
+
+#include "common.h"
+#include "utils/eloop.h"
+#include "common/status_shm.h"
+#include "drivers/driver.h"
+#include "config.h"
+#include "wpa_supplicant_i.h"
+#include "driver_i.h"
+#include "wpas_status_shm.h"
+
+
+static u64 wpas_status_shm_now(void)
+{
+	struct os_reltime now;
+
+	os_get_reltime(&now);
+	return (u64) now.sec * 1000 + now.usec / 1000;
+}
+
+
+static void wpas_status_shm_set_signal(struct status_shm_sta *sta,
+				       const struct wpa_signal_info *si)
+{
+	sta->rssi = si->data.signal;
+	sta->avg_rssi = si->data.avg_signal;
+	sta->noise = si->current_noise;
+	sta->link_speed = si->data.current_tx_rate / 1000;
+}
+
+
+static void wpas_status_shm_timeout(void *eloop_ctx, void *timeout_ctx)
+{
+	struct wpa_supplicant *wpa_s = eloop_ctx;
+	struct wpa_signal_info si;
+	struct hostap_sta_driver_data cnt;
+	struct status_shm_sta *sta;
+	bool signal, pktcnt;
+
+	if (wpa_s->wpa_state == WPA_COMPLETED) {
+		/* Poll the driver before starting the update so that readers
+		 * do not need to wait for the driver */
+		signal = wpa_drv_signal_poll(wpa_s, &si) == 0;
+		pktcnt = wpa_drv_pktcnt_poll(wpa_s, &cnt) == 0;
+		if (signal || pktcnt) {
+			sta = status_shm_write_begin(wpa_s->status_shm);
+			if (signal)
+				wpas_status_shm_set_signal(sta, &si);
+			if (pktcnt) {
+				sta->tx_packets = cnt.tx_packets;
+				sta->tx_retry_failed = cnt.tx_retry_failed;
+				sta->rx_packets = cnt.rx_packets;
+			}
+			sta->updated_ms = wpas_status_shm_now();
+			status_shm_write_end(wpa_s->status_shm);
+		}
+	}
+
+	eloop_register_timeout(wpa_s->conf->status_shm_interval, 0,
+			       wpas_status_shm_timeout, wpa_s, NULL);
+}
+
+
+int wpas_status_shm_init(struct wpa_supplicant *wpa_s)
+{
+	if (!wpa_s->conf->status_shm_dir)
+		return 0;
+
+	wpa_s->status_shm = status_shm_open(wpa_s->conf->status_shm_dir,
+					    wpa_s->ifname, STATUS_SHM_TYPE_STA,
+					    sizeof(struct status_shm_sta));
+	if (!wpa_s->status_shm)
+		return -1;
+	wpas_status_shm_update(wpa_s);
+
+	if (wpa_s->conf->status_shm_interval)
+		eloop_register_timeout(wpa_s->conf->status_shm_interval, 0,
+				       wpas_status_shm_timeout, wpa_s, NULL);
+	return 0;
+}
+
+
+void wpas_status_shm_deinit(struct wpa_supplicant *wpa_s)
+{
+	eloop_cancel_timeout(wpas_status_shm_timeout, wpa_s, NULL);
+	status_shm_close(wpa_s->status_shm);
+	wpa_s->status_shm = NULL;
+}
+
+
+/**
+ * wpas_status_shm_update - Update the connection state on the status page
+ * @wpa_s: Pointer to wpa_supplicant data
+ */
+void wpas_status_shm_update(struct wpa_supplicant *wpa_s)
+{
+	struct status_shm_sta *sta;
+	struct wpa_ssid *ssid = wpa_s->current_ssid;
+
+	if (!wpa_s->status_shm)
+		return;
+
+	sta = status_shm_write_begin(wpa_s->status_shm);
+	sta->state = wpa_s->wpa_state;
+	if (wpa_s->wpa_state >= WPA_ASSOCIATED) {
+		sta->freq = wpa_s->assoc_freq;
+		os_memcpy(sta->bssid, wpa_s->bssid, ETH_ALEN);
+		if (ssid && ssid->ssid_len <= sizeof(sta->ssid)) {
+			sta->ssid_len = ssid->ssid_len;
+			os_memcpy(sta->ssid, ssid->ssid, ssid->ssid_len);
+		}
+	} else if (sta->freq || sta->ssid_len) {
+		/* Do not leave the values of the previous connection */
+		os_memset(sta, 0, sizeof(*sta));
+		sta->state = wpa_s->wpa_state;
+	}
+	sta->updated_ms = wpas_status_shm_now();
+	status_shm_write_end(wpa_s->status_shm);
+}
+
+
+/**
+ * wpas_status_shm_signal - Update the signal strength on the status page
+ * @wpa_s: Pointer to wpa_supplicant data
+ * @si: Signal information, e.g., from a signal change event
+ */
+void wpas_status_shm_signal(struct wpa_supplicant *wpa_s,
+			    const struct wpa_signal_info *si)
+{
+	struct status_shm_sta *sta;
+
+	if (!wpa_s->status_shm)
+		return;
+
+	sta = status_shm_write_begin(wpa_s->status_shm);
+	wpas_status_shm_set_signal(sta, si);
+	sta->updated_ms = wpas_status_shm_now();
+	status_shm_write_end(wpa_s->status_shm);
+}
@@ -0,0 +1,43 @@
+/*
+ * wpa_supplicant - Shared memory status page
+ *
+ * This software may be distributed under the terms of the BSD license.
+ * See README for more details.
+ */
+
+#ifndef WPAS_STATUS_SHM_H
+#define WPAS_STATUS_SHM_H
+
+struct wpa_signal_info;
+
+#ifdef CONFIG_STATUS_SHM
+
+int wpas_status_shm_init(struct wpa_supplicant *wpa_s);
+void wpas_status_shm_deinit(struct wpa_supplicant *wpa_s);
+void wpas_status_shm_update(struct wpa_supplicant *wpa_s);
+void wpas_status_shm_signal(struct wpa_supplicant *wpa_s,
+			    const struct wpa_signal_info *si);
+
+#else /* CONFIG_STATUS_SHM */
+
+static inline int wpas_status_shm_init(struct wpa_supplicant *wpa_s)
+{
+	return 0;
+}
+
+static inline void wpas_status_shm_deinit(struct wpa_supplicant *wpa_s)
+{
+}
+
+static inline void wpas_status_shm_update(struct wpa_supplicant *wpa_s)
+{
+}
+
+static inline void wpas_status_shm_signal(struct wpa_supplicant *wpa_s,
+					  const struct wpa_signal_info *si)
+{
+}
+
+#endif /* CONFIG_STATUS_SHM */
+
+#endif /* WPAS_STATUS_SHM_H */